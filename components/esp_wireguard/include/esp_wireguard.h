@@ -70,6 +70,29 @@ typedef struct {
                                              Default is zero. */
 } wireguard_config_t;
 
+/**
+ * @brief Transport data counters of the interface.
+ *
+ * Byte counts are WireGuard payload bytes and wrap at 4 GiB. Cycle sums are
+ * CPU cycles spent per packet in the driver: for received packets
+ * authentication and in-place decryption, for sent packets buffer setup,
+ * copy and encryption.
+ */
+typedef struct {
+    uint32_t rx_packets;        /**< authenticated transport data messages, keepalives included */
+    uint32_t rx_bytes;          /**< their encrypted payload bytes */
+    uint32_t rx_cycles;         /**< cycles summed over rx_packets */
+    uint32_t rx_cycles_max;     /**< worst single packet */
+    uint32_t tx_packets;        /**< sealed transport data messages handed to UDP */
+    uint32_t tx_bytes;          /**< their message bytes */
+    uint32_t tx_cycles;         /**< cycles summed over tx_packets */
+    uint32_t tx_cycles_max;     /**< worst single packet */
+    uint32_t tx_pool_hits;      /**< packets built in a per-peer buffer (CONFIG_WIREGUARD_TX_POOL_SLOTS) */
+    uint32_t tx_pool_misses;    /**< packets that needed a pbuf from the lwIP heap */
+    uint32_t timer_wakeups;     /**< driver timer runs (re-armed for the nearest deadline) */
+    uint32_t keepalives;        /**< keepalives sent because nothing else went out */
+} wireguard_stats_t;
+
 typedef struct {
     wireguard_config_t* config;        /**< a pointer to wireguard config */
     struct netif*       netif;         /**< a pointer to configured netif */
@@ -126,6 +149,17 @@ esp_err_t esp_wireguard_set_default(wireguard_ctx_t *ctx);
  */
 esp_err_t esp_wireguardif_peer_is_up(wireguard_ctx_t *ctx);
 
+/**
+ * @brief Get the transport data counters.
+ *
+ * @param       ctx Context of WireGuard.
+ * @param[out]  stats Counters since the interface was created.
+ * @return
+ *      - ESP_OK on success.
+ *      - ESP_ERR_INVALID_ARG: no interface, or stats is NULL.
+ */
+esp_err_t esp_wireguard_get_stats(wireguard_ctx_t *ctx, wireguard_stats_t *stats);
+
 /**
  * @brief Disconnect from the peer
  *
@@ -10,12 +10,23 @@ extern "C" {
 #include <stdbool.h>
 
 // BLAKE2S IMPLEMENTATION
+#if defined(CONFIG_WIREGUARD_BLAKE2S_IMPLEMENTATION_XTENSA)
+#include "crypto/xtensa/blake2s_xtensa.h"
+#define wireguard_blake2s_ctx blake2s_xtensa_ctx
+#define wireguard_blake2s_init(ctx,outlen,key,keylen) blake2s_xtensa_init(ctx,outlen,key,keylen)
+#define wireguard_blake2s_update(ctx,in,inlen) blake2s_xtensa_update(ctx,in,inlen)
+#define wireguard_blake2s_final(ctx,out) blake2s_xtensa_final(ctx,out)
+#define wireguard_blake2s(out,outlen,key,keylen,in,inlen) blake2s_xtensa(out,outlen,key,keylen,in,inlen)
+// Kdf1/2/3 with the HMAC pad state of tau0 computed once (wireguard.c has the generic version)
+#define wireguard_hkdf(tau1,tau2,tau3,chaining_key,data,data_len) blake2s_xtensa_hkdf(tau1,tau2,tau3,chaining_key,data,data_len)
+#else
 #include "crypto/refc/blake2s.h"
 #define wireguard_blake2s_ctx blake2s_ctx
 #define wireguard_blake2s_init(ctx,outlen,key,keylen) blake2s_init(ctx,outlen,key,keylen)
 #define wireguard_blake2s_update(ctx,in,inlen) blake2s_update(ctx,in,inlen)
 #define wireguard_blake2s_final(ctx,out) blake2s_final(ctx,out)
 #define wireguard_blake2s(out,outlen,key,keylen,in,inlen) blake2s(out,outlen,key,keylen,in,inlen)
+#endif
 
 // X25519 IMPLEMENTATION
 #if defined(CONFIG_WIREGUARD_x25519_IMPLEMENTATION_DEFAULT)
@@ -28,15 +39,28 @@ extern "C" {
 #define wireguard_x25519(a,b,c)	crypto_scalarmult(a,b,c)
 #endif
 
+#if defined(CONFIG_WIREGUARD_x25519_IMPLEMENTATION_XTENSA)
+#include "crypto/xtensa/x25519_xtensa.h"
+#define wireguard_x25519(a,b,c)	x25519_xtensa(a,b,c)
+#endif
+
 //#include "crypto/cortex/scalarmult.h"
 //#define wireguard_x25519(a,b,c)	crypto_scalarmult_curve25519(a,b,c)
 
 // CHACHA20POLY1305 IMPLEMENTATION
+#if defined(CONFIG_WIREGUARD_CHACHA20POLY1305_IMPLEMENTATION_XTENSA)
+#include "crypto/xtensa/chacha20poly1305_xtensa.h"
+#define wireguard_aead_encrypt(dst,src,srclen,ad,adlen,nonce,key) chacha20poly1305_xtensa_encrypt(dst,src,srclen,ad,adlen,nonce,key)
+#define wireguard_aead_decrypt(dst,src,srclen,ad,adlen,nonce,key) chacha20poly1305_xtensa_decrypt(dst,src,srclen,ad,adlen,nonce,key)
+#define wireguard_xaead_encrypt(dst,src,srclen,ad,adlen,nonce,key) xchacha20poly1305_xtensa_encrypt(dst,src,srclen,ad,adlen,nonce,key)
+#define wireguard_xaead_decrypt(dst,src,srclen,ad,adlen,nonce,key) xchacha20poly1305_xtensa_decrypt(dst,src,srclen,ad,adlen,nonce,key)
+#else
 #include "crypto/refc/chacha20poly1305.h"
 #define wireguard_aead_encrypt(dst,src,srclen,ad,adlen,nonce,key) chacha20poly1305_encrypt(dst,src,srclen,ad,adlen,nonce,key)
 #define wireguard_aead_decrypt(dst,src,srclen,ad,adlen,nonce,key) chacha20poly1305_decrypt(dst,src,srclen,ad,adlen,nonce,key)
 #define wireguard_xaead_encrypt(dst,src,srclen,ad,adlen,nonce,key) xchacha20poly1305_encrypt(dst,src,srclen,ad,adlen,nonce,key)
 #define wireguard_xaead_decrypt(dst,src,srclen,ad,adlen,nonce,key) xchacha20poly1305_decrypt(dst,src,srclen,ad,adlen,nonce,key)
+#endif
 
 
 // Endian / unaligned helper macros
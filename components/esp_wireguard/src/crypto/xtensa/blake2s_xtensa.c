@@ -0,0 +1,308 @@
+// BLAKE2s tuned for the ESP32-S3 (Xtensa LX7)
+// BLAKE2s as described in RFC7693 - https://tools.ietf.org/html/rfc7693
+// HMAC as in RFC2104, HKDF as used by the WireGuard handshake (Kdf1/2/3)
+//
+// Same results as crypto/refc/blake2s.c and the HMAC/Kdf code in
+// wireguard.c. See blake2s_xtensa.h.
+#include "blake2s_xtensa.h"
+
+#include <string.h>
+#include <stdbool.h>
+#include "../../crypto.h"
+
+#if defined(__GNUC__)
+	#define XT_INLINE static inline __attribute__((always_inline))
+#else
+	#define XT_INLINE static inline
+#endif
+
+// Little-endian word at p; one l32i when p is known to be word aligned
+XT_INLINE uint32_t load32(const uint8_t *p, bool aligned) {
+	uint32_t v;
+	if (aligned) {
+		memcpy(&v, __builtin_assume_aligned(p, 4), sizeof(v));
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+		v = __builtin_bswap32(v);
+#endif
+	} else {
+		v = U8TO32_LITTLE(p);
+	}
+	return v;
+}
+
+static const uint32_t blake2s_iv[8] = {
+	0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+	0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+// ============================================================================
+// Compression
+// ============================================================================
+
+#define ROTR32(x, y) (((x) >> (y)) | ((x) << (32 - (y))))
+
+#define G(a, b, c, d, x, y)              \
+	a += b + (x); d = ROTR32(d ^ a, 16); \
+	c += d;       b = ROTR32(b ^ c, 12); \
+	a += b + (y); d = ROTR32(d ^ a, 8);  \
+	c += d;       b = ROTR32(b ^ c, 7)
+
+// One round, the message words in the order of one sigma row
+#define ROUND(s0, s1, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11, s12, s13, s14, s15) \
+	G(v0, v4, v8,  v12, m[s0],  m[s1]);  \
+	G(v1, v5, v9,  v13, m[s2],  m[s3]);  \
+	G(v2, v6, v10, v14, m[s4],  m[s5]);  \
+	G(v3, v7, v11, v15, m[s6],  m[s7]);  \
+	G(v0, v5, v10, v15, m[s8],  m[s9]);  \
+	G(v1, v6, v11, v12, m[s10], m[s11]); \
+	G(v2, v7, v8,  v13, m[s12], m[s13]); \
+	G(v3, v4, v9,  v14, m[s14], m[s15])
+
+XT_INLINE void compress_impl(uint32_t h[8], const uint8_t *block, const uint32_t t[2], bool last, bool aligned) {
+	uint32_t m[16];
+	for (int i = 0; i < 16; i++) {
+		m[i] = load32(block + 4 * i, aligned);
+	}
+
+	uint32_t v0 = h[0], v1 = h[1], v2 = h[2], v3 = h[3];
+	uint32_t v4 = h[4], v5 = h[5], v6 = h[6], v7 = h[7];
+	uint32_t v8 = blake2s_iv[0], v9 = blake2s_iv[1], v10 = blake2s_iv[2], v11 = blake2s_iv[3];
+	uint32_t v12 = blake2s_iv[4] ^ t[0];
+	uint32_t v13 = blake2s_iv[5] ^ t[1];
+	uint32_t v14 = last ? ~blake2s_iv[6] : blake2s_iv[6];
+	uint32_t v15 = blake2s_iv[7];
+
+	ROUND( 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15);
+	ROUND(14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3);
+	ROUND(11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4);
+	ROUND( 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8);
+	ROUND( 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13);
+	ROUND( 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9);
+	ROUND(12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11);
+	ROUND(13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10);
+	ROUND( 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5);
+	ROUND(10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0);
+
+	h[0] ^= v0 ^ v8;  h[1] ^= v1 ^ v9;
+	h[2] ^= v2 ^ v10; h[3] ^= v3 ^ v11;
+	h[4] ^= v4 ^ v12; h[5] ^= v5 ^ v13;
+	h[6] ^= v6 ^ v14; h[7] ^= v7 ^ v15;
+
+	crypto_zero(m, sizeof(m));
+}
+
+static void compress(uint32_t h[8], const uint8_t *block, const uint32_t t[2], bool last) {
+	if ((((uintptr_t)block) & 3) == 0) {
+		compress_impl(h, block, t, last, true);
+	} else {
+		compress_impl(h, block, t, last, false);
+	}
+}
+
+XT_INLINE void count_block(uint32_t t[2], uint32_t bytes) {
+	t[0] += bytes;
+	if (t[0] < bytes) {
+		t[1]++;
+	}
+}
+
+// ============================================================================
+// Hash
+// ============================================================================
+
+int blake2s_xtensa_init(blake2s_xtensa_ctx *ctx, size_t outlen, const void *key, size_t keylen) {
+	if (outlen == 0 || outlen > BLAKE2S_XTENSA_HASH_SIZE || keylen > 32) {
+		return -1;
+	}
+	memcpy(ctx->h, blake2s_iv, sizeof(ctx->h));
+	ctx->h[0] ^= 0x01010000U ^ ((uint32_t)keylen << 8) ^ (uint32_t)outlen;
+	ctx->t[0] = 0;
+	ctx->t[1] = 0;
+	ctx->outlen = outlen;
+
+	// The key is a block of its own, compressed once more input follows
+	memset(ctx->b, 0, sizeof(ctx->b));
+	if (keylen > 0) {
+		memcpy(ctx->b, key, keylen);
+		ctx->c = BLAKE2S_XTENSA_BLOCK_SIZE;
+	} else {
+		ctx->c = 0;
+	}
+	return 0;
+}
+
+void blake2s_xtensa_update(blake2s_xtensa_ctx *ctx, const void *in, size_t inlen) {
+	const uint8_t *p = (const uint8_t *)in;
+
+	// The last block is always held back: final() compresses it with the flag
+	if (ctx->c > 0 && inlen > BLAKE2S_XTENSA_BLOCK_SIZE - ctx->c) {
+		size_t fill = BLAKE2S_XTENSA_BLOCK_SIZE - ctx->c;
+		memcpy(ctx->b + ctx->c, p, fill);
+		p += fill;
+		inlen -= fill;
+		count_block(ctx->t, BLAKE2S_XTENSA_BLOCK_SIZE);
+		compress(ctx->h, ctx->b, ctx->t, false);
+		ctx->c = 0;
+	}
+	while (inlen > BLAKE2S_XTENSA_BLOCK_SIZE) {
+		count_block(ctx->t, BLAKE2S_XTENSA_BLOCK_SIZE);
+		compress(ctx->h, p, ctx->t, false);
+		p += BLAKE2S_XTENSA_BLOCK_SIZE;
+		inlen -= BLAKE2S_XTENSA_BLOCK_SIZE;
+	}
+	if (inlen > 0) {
+		memcpy(ctx->b + ctx->c, p, inlen);
+		ctx->c += inlen;
+	}
+}
+
+void blake2s_xtensa_final(blake2s_xtensa_ctx *ctx, void *out) {
+	count_block(ctx->t, (uint32_t)ctx->c);
+	memset(ctx->b + ctx->c, 0, BLAKE2S_XTENSA_BLOCK_SIZE - ctx->c);
+	compress(ctx->h, ctx->b, ctx->t, true);
+
+	uint8_t *o = (uint8_t *)out;
+	size_t i = 0;
+	for (; i + 4 <= ctx->outlen; i += 4) {
+		U32TO8_LITTLE(o + i, ctx->h[i >> 2]);
+	}
+	for (; i < ctx->outlen; i++) {
+		o[i] = (uint8_t)(ctx->h[i >> 2] >> (8 * (i & 3)));
+	}
+}
+
+int blake2s_xtensa(void *out, size_t outlen, const void *key, size_t keylen, const void *in, size_t inlen) {
+	blake2s_xtensa_ctx ctx;
+	if (blake2s_xtensa_init(&ctx, outlen, key, keylen)) {
+		return -1;
+	}
+	blake2s_xtensa_update(&ctx, in, inlen);
+	blake2s_xtensa_final(&ctx, out);
+	crypto_zero(&ctx, sizeof(ctx));
+	return 0;
+}
+
+// ============================================================================
+// HMAC and HKDF
+// ============================================================================
+
+// Unkeyed BLAKE2s-256 state after one full block (a pad), more input to follow
+static void absorb_pad(uint32_t h[8], const uint8_t pad[BLAKE2S_XTENSA_BLOCK_SIZE]) {
+	const uint32_t t[2] = { BLAKE2S_XTENSA_BLOCK_SIZE, 0 };
+	memcpy(h, blake2s_iv, 8 * sizeof(uint32_t));
+	h[0] ^= 0x01010000U ^ BLAKE2S_XTENSA_HASH_SIZE;
+	compress(h, pad, t, false);
+}
+
+void blake2s_xtensa_hmac_setkey(blake2s_xtensa_hmac_key *hk, const uint8_t *key, size_t key_len) {
+	uint32_t pad_words[BLAKE2S_XTENSA_BLOCK_SIZE / 4];
+	uint8_t *pad = (uint8_t *)pad_words;
+	uint8_t tk[BLAKE2S_XTENSA_HASH_SIZE];
+
+	// Keys longer than a block are replaced by their hash
+	if (key_len > BLAKE2S_XTENSA_BLOCK_SIZE) {
+		blake2s_xtensa(tk, sizeof(tk), NULL, 0, key, key_len);
+		key = tk;
+		key_len = sizeof(tk);
+	}
+
+	memset(pad, 0, BLAKE2S_XTENSA_BLOCK_SIZE);
+	memcpy(pad, key, key_len);
+	for (int i = 0; i < BLAKE2S_XTENSA_BLOCK_SIZE; i++) {
+		pad[i] ^= 0x36;
+	}
+	absorb_pad(hk->inner, pad);
+	for (int i = 0; i < BLAKE2S_XTENSA_BLOCK_SIZE; i++) {
+		pad[i] ^= 0x36 ^ 0x5c;
+	}
+	absorb_pad(hk->outer, pad);
+
+	crypto_zero(pad_words, sizeof(pad_words));
+	crypto_zero(tk, sizeof(tk));
+}
+
+// Continue a hash whose first block (a pad) is already in h
+static void hash_after_pad(const uint32_t h[8], uint8_t out[BLAKE2S_XTENSA_HASH_SIZE], const uint8_t *in, size_t inlen) {
+	blake2s_xtensa_ctx ctx;
+	memcpy(ctx.h, h, sizeof(ctx.h));
+	ctx.t[0] = BLAKE2S_XTENSA_BLOCK_SIZE;
+	ctx.t[1] = 0;
+	ctx.c = 0;
+	ctx.outlen = BLAKE2S_XTENSA_HASH_SIZE;
+	blake2s_xtensa_update(&ctx, in, inlen);
+	blake2s_xtensa_final(&ctx, out);
+	crypto_zero(&ctx, sizeof(ctx));
+}
+
+void blake2s_xtensa_hmac(const blake2s_xtensa_hmac_key *hk, uint8_t out[BLAKE2S_XTENSA_HASH_SIZE], const uint8_t *text, size_t text_len) {
+	uint8_t digest[BLAKE2S_XTENSA_HASH_SIZE];
+
+	hash_after_pad(hk->inner, digest, text, text_len);
+	hash_after_pad(hk->outer, out, digest, sizeof(digest));
+	crypto_zero(digest, sizeof(digest));
+}
+
+// HMAC with a key used once: no pad state worth keeping, and text may be
+// empty (the inner pad is then the last block and takes the final flag)
+static void hmac_once(uint8_t out[BLAKE2S_XTENSA_HASH_SIZE], const uint8_t *key, size_t key_len, const uint8_t *text, size_t text_len) {
+	uint32_t pad_words[BLAKE2S_XTENSA_BLOCK_SIZE / 4];
+	uint8_t *pad = (uint8_t *)pad_words;
+	uint8_t digest[BLAKE2S_XTENSA_HASH_SIZE];
+	blake2s_xtensa_ctx ctx;
+
+	// Kdf keys are chaining keys: never longer than a block
+	memset(pad, 0, BLAKE2S_XTENSA_BLOCK_SIZE);
+	memcpy(pad, key, key_len);
+	for (int i = 0; i < BLAKE2S_XTENSA_BLOCK_SIZE; i++) {
+		pad[i] ^= 0x36;
+	}
+	blake2s_xtensa_init(&ctx, BLAKE2S_XTENSA_HASH_SIZE, NULL, 0);
+	blake2s_xtensa_update(&ctx, pad, BLAKE2S_XTENSA_BLOCK_SIZE);
+	blake2s_xtensa_update(&ctx, text, text_len);
+	blake2s_xtensa_final(&ctx, digest);
+
+	uint32_t outer[8];
+	for (int i = 0; i < BLAKE2S_XTENSA_BLOCK_SIZE; i++) {
+		pad[i] ^= 0x36 ^ 0x5c;
+	}
+	absorb_pad(outer, pad);
+	hash_after_pad(outer, out, digest, sizeof(digest));
+
+	crypto_zero(pad_words, sizeof(pad_words));
+	crypto_zero(digest, sizeof(digest));
+	crypto_zero(outer, sizeof(outer));
+	crypto_zero(&ctx, sizeof(ctx));
+}
+
+void blake2s_xtensa_hkdf(uint8_t *tau1, uint8_t *tau2, uint8_t *tau3, const uint8_t *chaining_key, const uint8_t *data, size_t data_len) {
+	uint8_t tau0[BLAKE2S_XTENSA_HASH_SIZE];
+	uint8_t output[BLAKE2S_XTENSA_HASH_SIZE + 1];
+	blake2s_xtensa_hmac_key hk;
+
+	// tau0 := Hmac(chaining_key, data), then its pads once for every output
+	hmac_once(tau0, chaining_key, BLAKE2S_XTENSA_HASH_SIZE, data, data_len);
+	blake2s_xtensa_hmac_setkey(&hk, tau0, sizeof(tau0));
+
+	// tau1 := Hmac(tau0, 0x1)
+	output[0] = 1;
+	blake2s_xtensa_hmac(&hk, output, output, 1);
+	memcpy(tau1, output, BLAKE2S_XTENSA_HASH_SIZE);
+
+	// tau2 := Hmac(tau0, tau1 || 0x2)
+	if (tau2 != NULL) {
+		output[BLAKE2S_XTENSA_HASH_SIZE] = 2;
+		blake2s_xtensa_hmac(&hk, output, output, BLAKE2S_XTENSA_HASH_SIZE + 1);
+		memcpy(tau2, output, BLAKE2S_XTENSA_HASH_SIZE);
+
+		// tau3 := Hmac(tau0, tau2 || 0x3)
+		if (tau3 != NULL) {
+			output[BLAKE2S_XTENSA_HASH_SIZE] = 3;
+			blake2s_xtensa_hmac(&hk, output, output, BLAKE2S_XTENSA_HASH_SIZE + 1);
+			memcpy(tau3, output, BLAKE2S_XTENSA_HASH_SIZE);
+		}
+	}
+
+	crypto_zero(tau0, sizeof(tau0));
+	crypto_zero(output, sizeof(output));
+	crypto_zero(&hk, sizeof(hk));
+}
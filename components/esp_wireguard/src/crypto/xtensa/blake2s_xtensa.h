@@ -0,0 +1,61 @@
+// BLAKE2s, HMAC and HKDF tuned for the ESP32-S3 (Xtensa LX7), same results as crypto/refc
+//
+// Drop-in for crypto/refc/blake2s.h selected through crypto.h
+// (CONFIG_WIREGUARD_BLAKE2S_IMPLEMENTATION_XTENSA). Plain C so the host tests
+// run it against the reference implementation:
+// - The compression function is fully unrolled: the message schedule is
+//   constant indices instead of a sigma table lookup per word, and the
+//   sixteen working words stay in locals
+// - Whole blocks are compressed straight from the input (word loads when it
+//   is aligned) instead of being copied byte by byte into the context
+// - HMAC keeps the state after the padded key block (inner and outer), so
+//   HKDF pays for the key blocks of tau0 once for all its outputs instead of
+//   once per output: Kdf2 and Kdf3 take 10 and 12 compressions instead of
+//   12 and 16
+#ifndef _BLAKE2S_XTENSA_H_
+#define _BLAKE2S_XTENSA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BLAKE2S_XTENSA_BLOCK_SIZE 64
+#define BLAKE2S_XTENSA_HASH_SIZE 32
+
+typedef struct {
+	uint32_t h[8];              // chained state
+	uint32_t t[2];              // bytes compressed so far
+	uint8_t b[BLAKE2S_XTENSA_BLOCK_SIZE]; // partial block, always held back for final
+	size_t c;                   // bytes in b[]
+	size_t outlen;              // digest size
+} blake2s_xtensa_ctx;
+
+// Same contract as blake2s_init() etc. (1 <= outlen <= 32, keylen <= 32)
+int blake2s_xtensa_init(blake2s_xtensa_ctx *ctx, size_t outlen, const void *key, size_t keylen);
+void blake2s_xtensa_update(blake2s_xtensa_ctx *ctx, const void *in, size_t inlen);
+void blake2s_xtensa_final(blake2s_xtensa_ctx *ctx, void *out);
+int blake2s_xtensa(void *out, size_t outlen, const void *key, size_t keylen, const void *in, size_t inlen);
+
+// HMAC-BLAKE2s-256 key, with the inner and outer pad blocks already compressed
+typedef struct {
+	uint32_t inner[8];
+	uint32_t outer[8];
+} blake2s_xtensa_hmac_key;
+
+void blake2s_xtensa_hmac_setkey(blake2s_xtensa_hmac_key *hk, const uint8_t *key, size_t key_len);
+// text_len must not be 0: the cached inner state assumes more input follows the pad
+void blake2s_xtensa_hmac(const blake2s_xtensa_hmac_key *hk, uint8_t out[BLAKE2S_XTENSA_HASH_SIZE], const uint8_t *text, size_t text_len);
+
+// WireGuard Kdf1/2/3 (HKDF with HMAC-BLAKE2s): tau1..tau3 from the chaining
+// key and input. tau2/tau3 may be NULL for fewer outputs (tau3 needs tau2);
+// any of them may be the chaining key itself
+void blake2s_xtensa_hkdf(uint8_t *tau1, uint8_t *tau2, uint8_t *tau3, const uint8_t *chaining_key, const uint8_t *data, size_t data_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLAKE2S_XTENSA_H_ */
@@ -0,0 +1,391 @@
+// ChaCha20-Poly1305 tuned for the ESP32-S3 (Xtensa LX7)
+// AEAD_CHACHA20_POLY1305 as described in https://tools.ietf.org/html/rfc7539
+// Poly1305 follows poly1305-donna-32 (https://github.com/floodyberry/poly1305-donna - public domain or MIT)
+//
+// Same results as crypto/refc, organised for a 32-bit in-order core with no
+// unaligned loads: word-wide I/O when the buffers allow it (lwIP pbuf
+// payloads are word aligned), the ChaCha20 state in locals, and one pass
+// over the data when encrypting. See chacha20poly1305_xtensa.h.
+#include "chacha20poly1305_xtensa.h"
+#include "../refc/chacha20.h"
+
+#include <string.h>
+#include <stdint.h>
+#include "../../crypto.h"
+
+#define POLY1305_BLOCK_SIZE		16
+#define POLY1305_MAC_SIZE		16
+
+// 1 << 128 in the top limb
+#define POLY1305_HIBIT			(1U << 24)
+
+#if defined(__GNUC__)
+	#define XT_INLINE static inline __attribute__((always_inline))
+#else
+	#define XT_INLINE static inline
+#endif
+
+// Little-endian word at p; one l32i when p is known to be word aligned
+XT_INLINE uint32_t load32(const uint8_t *p, bool aligned) {
+	uint32_t v;
+	if (aligned) {
+		memcpy(&v, __builtin_assume_aligned(p, 4), sizeof(v));
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+		v = __builtin_bswap32(v);
+#endif
+	} else {
+		v = U8TO32_LITTLE(p);
+	}
+	return v;
+}
+
+XT_INLINE void store32(uint8_t *p, uint32_t v, bool aligned) {
+	if (aligned) {
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+		v = __builtin_bswap32(v);
+#endif
+		memcpy(__builtin_assume_aligned(p, 4), &v, sizeof(v));
+	} else {
+		U32TO8_LITTLE(p, v);
+	}
+}
+
+// ============================================================================
+// ChaCha20
+// ============================================================================
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d)       \
+    a += b;  d ^= a;  d = ROTL32(d, 16);  \
+    c += d;  b ^= c;  b = ROTL32(b, 12);  \
+    a += b;  d ^= a;  d = ROTL32(d,  8);  \
+    c += d;  b ^= c;  b = ROTL32(b,  7)
+
+// Same state layout as refc chacha20_init(): counter in word 12, WireGuard nonce in 14-15
+static void chacha20_setup(uint32_t state[16], const uint8_t *key, uint64_t nonce) {
+	state[0] = 0x61707865;
+	state[1] = 0x3320646e;
+	state[2] = 0x79622d32;
+	state[3] = 0x6b206574;
+	for (int i = 0; i < 8; i++) {
+		state[4 + i] = U8TO32_LITTLE(key + 4 * i);
+	}
+	state[12] = 0;
+	state[13] = 0;
+	state[14] = (uint32_t)nonce;
+	state[15] = (uint32_t)(nonce >> 32);
+}
+
+// One keystream block as 16 words, then advance the block counter
+static void chacha20_block(uint32_t state[16], uint32_t ks[16]) {
+	uint32_t x0 = state[0], x1 = state[1], x2 = state[2], x3 = state[3];
+	uint32_t x4 = state[4], x5 = state[5], x6 = state[6], x7 = state[7];
+	uint32_t x8 = state[8], x9 = state[9], x10 = state[10], x11 = state[11];
+	uint32_t x12 = state[12], x13 = state[13], x14 = state[14], x15 = state[15];
+
+	for (int i = 0; i < 10; i++) {
+		QUARTERROUND(x0, x4, x8, x12);
+		QUARTERROUND(x1, x5, x9, x13);
+		QUARTERROUND(x2, x6, x10, x14);
+		QUARTERROUND(x3, x7, x11, x15);
+		QUARTERROUND(x0, x5, x10, x15);
+		QUARTERROUND(x1, x6, x11, x12);
+		QUARTERROUND(x2, x7, x8, x13);
+		QUARTERROUND(x3, x4, x9, x14);
+	}
+
+	ks[0] = x0 + state[0];    ks[1] = x1 + state[1];
+	ks[2] = x2 + state[2];    ks[3] = x3 + state[3];
+	ks[4] = x4 + state[4];    ks[5] = x5 + state[5];
+	ks[6] = x6 + state[6];    ks[7] = x7 + state[7];
+	ks[8] = x8 + state[8];    ks[9] = x9 + state[9];
+	ks[10] = x10 + state[10]; ks[11] = x11 + state[11];
+	ks[12] = x12 + state[12]; ks[13] = x13 + state[13];
+	ks[14] = x14 + state[14]; ks[15] = x15 + state[15];
+
+	state[12]++;
+}
+
+XT_INLINE void chacha20_xor_words(uint8_t *out, const uint8_t *in, const uint32_t ks[16], bool aligned) {
+	for (int i = 0; i < 16; i++) {
+		store32(out + 4 * i, load32(in + 4 * i, aligned) ^ ks[i], aligned);
+	}
+}
+
+// out = in ^ keystream; in-place is fine
+static void chacha20_xor(uint32_t state[16], uint8_t *out, const uint8_t *in, size_t len) {
+	uint32_t ks[16];
+	bool aligned = ((((uintptr_t)out) | ((uintptr_t)in)) & 3) == 0;
+
+	while (len >= CHACHA20_BLOCK_SIZE) {
+		chacha20_block(state, ks);
+		if (aligned) {
+			chacha20_xor_words(out, in, ks, true);
+		} else {
+			chacha20_xor_words(out, in, ks, false);
+		}
+		out += CHACHA20_BLOCK_SIZE;
+		in += CHACHA20_BLOCK_SIZE;
+		len -= CHACHA20_BLOCK_SIZE;
+	}
+	if (len) {
+		chacha20_block(state, ks);
+		for (size_t i = 0; i < len; i++) {
+			out[i] = in[i] ^ (uint8_t)(ks[i >> 2] >> (8 * (i & 3)));
+		}
+	}
+	crypto_zero(ks, sizeof(ks));
+}
+
+// ============================================================================
+// Poly1305
+// ============================================================================
+
+typedef struct {
+	uint32_t r[5];
+	uint32_t s[4];      // r[1..4] * 5
+	uint32_t h[5];
+	uint32_t pad[4];
+} poly1305_xt_t;
+
+// Key as the first 8 keystream words of ChaCha20 block 0 (RFC7539 2.6)
+static void poly1305_setup(poly1305_xt_t *st, const uint32_t key[8]) {
+	uint32_t t0 = key[0], t1 = key[1], t2 = key[2], t3 = key[3];
+
+	// r &= 0xffffffc0ffffffc0ffffffc0fffffff
+	st->r[0] = (t0) & 0x3ffffff;
+	st->r[1] = ((t0 >> 26) | (t1 << 6)) & 0x3ffff03;
+	st->r[2] = ((t1 >> 20) | (t2 << 12)) & 0x3ffc0ff;
+	st->r[3] = ((t2 >> 14) | (t3 << 18)) & 0x3f03fff;
+	st->r[4] = (t3 >> 8) & 0x00fffff;
+	for (int i = 0; i < 4; i++) {
+		st->s[i] = st->r[i + 1] * 5;
+		st->pad[i] = key[4 + i];
+	}
+	memset(st->h, 0, sizeof(st->h));
+}
+
+// h = (h + m) * r for each 16-byte block of m
+XT_INLINE void poly1305_blocks_impl(poly1305_xt_t *st, const uint8_t *m, size_t blocks, bool aligned) {
+	const uint32_t r0 = st->r[0], r1 = st->r[1], r2 = st->r[2], r3 = st->r[3], r4 = st->r[4];
+	const uint32_t s1 = st->s[0], s2 = st->s[1], s3 = st->s[2], s4 = st->s[3];
+	uint32_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2], h3 = st->h[3], h4 = st->h[4];
+	uint64_t d0, d1, d2, d3, d4;
+	uint32_t c;
+
+	while (blocks--) {
+		uint32_t t0 = load32(m + 0, aligned);
+		uint32_t t1 = load32(m + 4, aligned);
+		uint32_t t2 = load32(m + 8, aligned);
+		uint32_t t3 = load32(m + 12, aligned);
+
+		// h += m[i]
+		h0 += (t0) & 0x3ffffff;
+		h1 += ((t0 >> 26) | (t1 << 6)) & 0x3ffffff;
+		h2 += ((t1 >> 20) | (t2 << 12)) & 0x3ffffff;
+		h3 += ((t2 >> 14) | (t3 << 18)) & 0x3ffffff;
+		h4 += (t3 >> 8) | POLY1305_HIBIT;
+
+		// h *= r
+		d0 = ((uint64_t)h0 * r0) + ((uint64_t)h1 * s4) + ((uint64_t)h2 * s3) + ((uint64_t)h3 * s2) + ((uint64_t)h4 * s1);
+		d1 = ((uint64_t)h0 * r1) + ((uint64_t)h1 * r0) + ((uint64_t)h2 * s4) + ((uint64_t)h3 * s3) + ((uint64_t)h4 * s2);
+		d2 = ((uint64_t)h0 * r2) + ((uint64_t)h1 * r1) + ((uint64_t)h2 * r0) + ((uint64_t)h3 * s4) + ((uint64_t)h4 * s3);
+		d3 = ((uint64_t)h0 * r3) + ((uint64_t)h1 * r2) + ((uint64_t)h2 * r1) + ((uint64_t)h3 * r0) + ((uint64_t)h4 * s4);
+		d4 = ((uint64_t)h0 * r4) + ((uint64_t)h1 * r3) + ((uint64_t)h2 * r2) + ((uint64_t)h3 * r1) + ((uint64_t)h4 * r0);
+
+		// (partial) h %= p
+		              c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & 0x3ffffff;
+		d1 += c;      c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & 0x3ffffff;
+		d2 += c;      c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & 0x3ffffff;
+		d3 += c;      c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & 0x3ffffff;
+		d4 += c;      c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & 0x3ffffff;
+		h0 += c * 5;  c =           (h0 >> 26); h0 =           h0 & 0x3ffffff;
+		h1 += c;
+
+		m += POLY1305_BLOCK_SIZE;
+	}
+
+	st->h[0] = h0;
+	st->h[1] = h1;
+	st->h[2] = h2;
+	st->h[3] = h3;
+	st->h[4] = h4;
+}
+
+static void poly1305_blocks(poly1305_xt_t *st, const uint8_t *m, size_t blocks) {
+	if ((((uintptr_t)m) & 3) == 0) {
+		poly1305_blocks_impl(st, m, blocks, true);
+	} else {
+		poly1305_blocks_impl(st, m, blocks, false);
+	}
+}
+
+// m followed by zero padding to a multiple of 16 (AEAD padding1/padding2)
+static void poly1305_padded(poly1305_xt_t *st, const uint8_t *m, size_t len) {
+	size_t full = len / POLY1305_BLOCK_SIZE;
+	size_t rest = len % POLY1305_BLOCK_SIZE;
+	uint32_t block[POLY1305_BLOCK_SIZE / 4];
+
+	if (full) {
+		poly1305_blocks(st, m, full);
+	}
+	if (rest) {
+		memset(block, 0, sizeof(block));
+		memcpy(block, m + full * POLY1305_BLOCK_SIZE, rest);
+		poly1305_blocks(st, (const uint8_t *)block, 1);
+	}
+}
+
+// 64-bit little-endian lengths of the AAD and the ciphertext, as one block
+static void poly1305_lengths(poly1305_xt_t *st, size_t ad_len, size_t ct_len) {
+	uint8_t block[POLY1305_BLOCK_SIZE];
+
+	U64TO8_LITTLE(block, (uint64_t)ad_len);
+	U64TO8_LITTLE(block + 8, (uint64_t)ct_len);
+	poly1305_blocks(st, block, 1);
+}
+
+static void poly1305_finish(poly1305_xt_t *st, uint8_t mac[POLY1305_MAC_SIZE]) {
+	uint32_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2], h3 = st->h[3], h4 = st->h[4];
+	uint32_t g0, g1, g2, g3, g4, c, mask;
+	uint64_t f;
+
+	// fully carry h
+	             c = h1 >> 26; h1 = h1 & 0x3ffffff;
+	h2 +=     c; c = h2 >> 26; h2 = h2 & 0x3ffffff;
+	h3 +=     c; c = h3 >> 26; h3 = h3 & 0x3ffffff;
+	h4 +=     c; c = h4 >> 26; h4 = h4 & 0x3ffffff;
+	h0 += c * 5; c = h0 >> 26; h0 = h0 & 0x3ffffff;
+	h1 +=     c;
+
+	// compute h + -p
+	g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+	g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+	g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+	g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+	g4 = h4 + c - (1U << 26);
+
+	// select h if h < p, or h + -p if h >= p
+	mask = (g4 >> 31) - 1;
+	g0 &= mask;
+	g1 &= mask;
+	g2 &= mask;
+	g3 &= mask;
+	g4 &= mask;
+	mask = ~mask;
+	h0 = (h0 & mask) | g0;
+	h1 = (h1 & mask) | g1;
+	h2 = (h2 & mask) | g2;
+	h3 = (h3 & mask) | g3;
+	h4 = (h4 & mask) | g4;
+
+	// h = h % (2^128)
+	h0 = ((h0      ) | (h1 << 26));
+	h1 = ((h1 >>  6) | (h2 << 20));
+	h2 = ((h2 >> 12) | (h3 << 14));
+	h3 = ((h3 >> 18) | (h4 <<  8));
+
+	// mac = (h + pad) % (2^128)
+	f = (uint64_t)h0 + st->pad[0]            ; h0 = (uint32_t)f;
+	f = (uint64_t)h1 + st->pad[1] + (f >> 32); h1 = (uint32_t)f;
+	f = (uint64_t)h2 + st->pad[2] + (f >> 32); h2 = (uint32_t)f;
+	f = (uint64_t)h3 + st->pad[3] + (f >> 32); h3 = (uint32_t)f;
+
+	U32TO8_LITTLE(mac +  0, h0);
+	U32TO8_LITTLE(mac +  4, h1);
+	U32TO8_LITTLE(mac +  8, h2);
+	U32TO8_LITTLE(mac + 12, h3);
+
+	crypto_zero(st, sizeof(*st));
+}
+
+// ============================================================================
+// AEAD
+// ============================================================================
+
+// 2.6.  Generating the Poly1305 Key Using ChaCha20 (block 0); leaves the counter at 1
+static void aead_setup(uint32_t state[16], poly1305_xt_t *poly, const uint8_t *key, uint64_t nonce) {
+	uint32_t ks[16];
+
+	chacha20_setup(state, key, nonce);
+	chacha20_block(state, ks);
+	poly1305_setup(poly, ks);
+	crypto_zero(ks, sizeof(ks));
+}
+
+// 2.8.  AEAD Construction (Encryption)
+void chacha20poly1305_xtensa_encrypt(uint8_t *dst, const uint8_t *src, size_t src_len, const uint8_t *ad, size_t ad_len, uint64_t nonce, const uint8_t *key) {
+	uint32_t state[16];
+	poly1305_xt_t poly;
+
+	aead_setup(state, &poly, key, nonce);
+	poly1305_padded(&poly, ad, ad_len);
+
+	// Authenticate each ciphertext chunk right after producing it
+	size_t done = 0;
+	while (src_len - done >= CHACHA20_BLOCK_SIZE) {
+		chacha20_xor(state, dst + done, src + done, CHACHA20_BLOCK_SIZE);
+		poly1305_blocks(&poly, dst + done, CHACHA20_BLOCK_SIZE / POLY1305_BLOCK_SIZE);
+		done += CHACHA20_BLOCK_SIZE;
+	}
+	if (src_len > done) {
+		chacha20_xor(state, dst + done, src + done, src_len - done);
+		poly1305_padded(&poly, dst + done, src_len - done);
+	}
+
+	poly1305_lengths(&poly, ad_len, src_len);
+	poly1305_finish(&poly, dst + src_len);
+
+	// Make sure we leave nothing sensitive on the stack
+	crypto_zero(state, sizeof(state));
+}
+
+// 2.8.  AEAD Construction (Decryption)
+bool chacha20poly1305_xtensa_decrypt(uint8_t *dst, const uint8_t *src, size_t src_len, const uint8_t *ad, size_t ad_len, uint64_t nonce, const uint8_t *key) {
+	uint32_t state[16];
+	poly1305_xt_t poly;
+	uint8_t mac[POLY1305_MAC_SIZE];
+	bool result = false;
+
+	if (src_len < POLY1305_MAC_SIZE) {
+		return false;
+	}
+	size_t dst_len = src_len - POLY1305_MAC_SIZE;
+
+	// The tag covers the ciphertext: check it before writing any plaintext
+	aead_setup(state, &poly, key, nonce);
+	poly1305_padded(&poly, ad, ad_len);
+	poly1305_padded(&poly, src, dst_len);
+	poly1305_lengths(&poly, ad_len, dst_len);
+	poly1305_finish(&poly, mac);
+
+	if (crypto_equal(mac, src + dst_len, POLY1305_MAC_SIZE)) {
+		chacha20_xor(state, dst, src, dst_len);
+		result = true;
+	}
+
+	crypto_zero(state, sizeof(state));
+	return result;
+}
+
+// AEAD_XChaCha20_Poly1305: HChaCha20 subkey from the first 16 nonce bytes, then the above
+void xchacha20poly1305_xtensa_encrypt(uint8_t *dst, const uint8_t *src, size_t src_len, const uint8_t *ad, size_t ad_len, const uint8_t *nonce, const uint8_t *key) {
+	uint8_t subkey[CHACHA20_KEY_SIZE];
+
+	hchacha20(subkey, nonce, key);
+	chacha20poly1305_xtensa_encrypt(dst, src, src_len, ad, ad_len, U8TO64_LITTLE(nonce + 16), subkey);
+
+	crypto_zero(subkey, sizeof(subkey));
+}
+
+bool xchacha20poly1305_xtensa_decrypt(uint8_t *dst, const uint8_t *src, size_t src_len, const uint8_t *ad, size_t ad_len, const uint8_t *nonce, const uint8_t *key) {
+	uint8_t subkey[CHACHA20_KEY_SIZE];
+	bool result;
+
+	hchacha20(subkey, nonce, key);
+	result = chacha20poly1305_xtensa_decrypt(dst, src, src_len, ad, ad_len, U8TO64_LITTLE(nonce + 16), subkey);
+
+	crypto_zero(subkey, sizeof(subkey));
+	return result;
+}
@@ -0,0 +1,39 @@
+// ChaCha20-Poly1305 tuned for the ESP32-S3 (Xtensa LX7), same interface as crypto/refc
+//
+// Drop-in for crypto/refc/chacha20poly1305.h selected through crypto.h
+// (CONFIG_WIREGUARD_CHACHA20POLY1305_IMPLEMENTATION_XTENSA). Plain C so the
+// host tests run it against the reference implementation:
+// - ChaCha20 keeps the state in registers and XORs whole words, 64 bytes
+//   per block, instead of serializing each keystream block to bytes
+// - Poly1305 (26-bit limbs, 32x32->64 products as on refc) reads blocks as
+//   words and absorbs the AEAD padding without copying it
+// - Encryption is a single pass: each 64-byte ciphertext chunk is
+//   authenticated right after it is written, while it is still in cache
+// - Decryption still authenticates before writing any plaintext
+//
+// The S3 PIE vector unit has no wrapping 32-bit add or 32-bit rotate, which
+// ChaCha20 is built from, so it is not used here.
+#ifndef _CHACHA20POLY1305_XTENSA_H_
+#define _CHACHA20POLY1305_XTENSA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// AEAD_CHACHA20_POLY1305 with the WireGuard nonce (32 zero bits, 64-bit little-endian counter)
+void chacha20poly1305_xtensa_encrypt(uint8_t *dst, const uint8_t *src, size_t src_len, const uint8_t *ad, size_t ad_len, uint64_t nonce, const uint8_t *key);
+bool chacha20poly1305_xtensa_decrypt(uint8_t *dst, const uint8_t *src, size_t src_len, const uint8_t *ad, size_t ad_len, uint64_t nonce, const uint8_t *key);
+
+// AEAD_XChaCha20_Poly1305 (24-byte nonce)
+void xchacha20poly1305_xtensa_encrypt(uint8_t *dst, const uint8_t *src, size_t src_len, const uint8_t *ad, size_t ad_len, const uint8_t *nonce, const uint8_t *key);
+bool xchacha20poly1305_xtensa_decrypt(uint8_t *dst, const uint8_t *src, size_t src_len, const uint8_t *ad, size_t ad_len, const uint8_t *nonce, const uint8_t *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHACHA20POLY1305_XTENSA_H_ */
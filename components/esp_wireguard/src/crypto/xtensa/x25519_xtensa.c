@@ -0,0 +1,442 @@
+// X25519 (RFC 7748) tuned for the ESP32-S3 (Xtensa LX7)
+// Field arithmetic in radix 2^25.5 (ten signed limbs, alternately 26 and 25
+// bits) as in the public domain ref10 code by Bernstein, Duif, Lange, Schwabe
+// and Yang: every product is a single 32x32->64 MULL/MULSH pair, and the
+// reduction by 19 is folded into the operands before multiplying.
+//
+// Constant time: the ladder swaps with masks and the inversion is a fixed
+// power chain; nothing branches or indexes on secret data. See x25519_xtensa.h.
+#include "x25519_xtensa.h"
+
+#include <string.h>
+#include <stdint.h>
+#include "../../crypto.h"
+
+#if defined(__GNUC__)
+	#define XT_INLINE static inline __attribute__((always_inline))
+#else
+	#define XT_INLINE static inline
+#endif
+
+// h = h0 + h1 * 2^26 + h2 * 2^51 + ... + h9 * 2^230
+typedef int32_t fe[10];
+
+// ============================================================================
+// Field arithmetic mod 2^255 - 19
+// ============================================================================
+
+// Limb widths: 26 bits for even limbs, 25 for odd ones
+#define FE_BITS(i) (((i) & 1) ? 25 : 26)
+
+static void fe_0(fe h) {
+	memset(h, 0, sizeof(fe));
+}
+
+static void fe_1(fe h) {
+	fe_0(h);
+	h[0] = 1;
+}
+
+XT_INLINE void fe_add(fe h, const fe f, const fe g) {
+	for (int i = 0; i < 10; i++) {
+		h[i] = f[i] + g[i];
+	}
+}
+
+XT_INLINE void fe_sub(fe h, const fe f, const fe g) {
+	for (int i = 0; i < 10; i++) {
+		h[i] = f[i] - g[i];
+	}
+}
+
+// Swap f and g if b == 1, without branching on b
+XT_INLINE void fe_cswap(fe f, fe g, uint32_t b) {
+	int32_t mask = -(int32_t)b;
+	for (int i = 0; i < 10; i++) {
+		int32_t x = (f[i] ^ g[i]) & mask;
+		f[i] ^= x;
+		g[i] ^= x;
+	}
+}
+
+// Round each 64-bit column back to 26/25 bits, carrying 2^255 around as 19
+XT_INLINE void fe_carry(fe h, int64_t c[10]) {
+	int64_t carry;
+#define FE_CARRY(i, j) \
+	carry = (c[i] + ((int64_t)1 << (FE_BITS(i) - 1))) >> FE_BITS(i); \
+	c[j] += carry; \
+	c[i] -= carry * ((int64_t)1 << FE_BITS(i));
+	FE_CARRY(0, 1)
+	FE_CARRY(4, 5)
+	FE_CARRY(1, 2)
+	FE_CARRY(5, 6)
+	FE_CARRY(2, 3)
+	FE_CARRY(6, 7)
+	FE_CARRY(3, 4)
+	FE_CARRY(7, 8)
+	FE_CARRY(4, 5)
+	FE_CARRY(8, 9)
+	carry = (c[9] + ((int64_t)1 << 24)) >> 25;
+	c[0] += carry * 19;
+	c[9] -= carry * ((int64_t)1 << 25);
+	FE_CARRY(0, 1)
+#undef FE_CARRY
+	for (int i = 0; i < 10; i++) {
+		h[i] = (int32_t)c[i];
+	}
+}
+
+// h = f * g
+static void fe_mul(fe h, const fe f, const fe g) {
+	int32_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+	int32_t f5 = f[5], f6 = f[6], f7 = f[7], f8 = f[8], f9 = f[9];
+	int32_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+	int32_t g5 = g[5], g6 = g[6], g7 = g[7], g8 = g[8], g9 = g[9];
+	int32_t g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4, g5_19 = 19 * g5;
+	int32_t g6_19 = 19 * g6, g7_19 = 19 * g7, g8_19 = 19 * g8, g9_19 = 19 * g9;
+	int32_t f1_2 = 2 * f1, f3_2 = 2 * f3, f5_2 = 2 * f5, f7_2 = 2 * f7, f9_2 = 2 * f9;
+
+	int64_t h0 = (int64_t)f0 * g0
+		+ (int64_t)f1_2 * g9_19
+		+ (int64_t)f2 * g8_19
+		+ (int64_t)f3_2 * g7_19
+		+ (int64_t)f4 * g6_19
+		+ (int64_t)f5_2 * g5_19
+		+ (int64_t)f6 * g4_19
+		+ (int64_t)f7_2 * g3_19
+		+ (int64_t)f8 * g2_19
+		+ (int64_t)f9_2 * g1_19;
+	int64_t h1 = (int64_t)f0 * g1
+		+ (int64_t)f1 * g0
+		+ (int64_t)f2 * g9_19
+		+ (int64_t)f3 * g8_19
+		+ (int64_t)f4 * g7_19
+		+ (int64_t)f5 * g6_19
+		+ (int64_t)f6 * g5_19
+		+ (int64_t)f7 * g4_19
+		+ (int64_t)f8 * g3_19
+		+ (int64_t)f9 * g2_19;
+	int64_t h2 = (int64_t)f0 * g2
+		+ (int64_t)f1_2 * g1
+		+ (int64_t)f2 * g0
+		+ (int64_t)f3_2 * g9_19
+		+ (int64_t)f4 * g8_19
+		+ (int64_t)f5_2 * g7_19
+		+ (int64_t)f6 * g6_19
+		+ (int64_t)f7_2 * g5_19
+		+ (int64_t)f8 * g4_19
+		+ (int64_t)f9_2 * g3_19;
+	int64_t h3 = (int64_t)f0 * g3
+		+ (int64_t)f1 * g2
+		+ (int64_t)f2 * g1
+		+ (int64_t)f3 * g0
+		+ (int64_t)f4 * g9_19
+		+ (int64_t)f5 * g8_19
+		+ (int64_t)f6 * g7_19
+		+ (int64_t)f7 * g6_19
+		+ (int64_t)f8 * g5_19
+		+ (int64_t)f9 * g4_19;
+	int64_t h4 = (int64_t)f0 * g4
+		+ (int64_t)f1_2 * g3
+		+ (int64_t)f2 * g2
+		+ (int64_t)f3_2 * g1
+		+ (int64_t)f4 * g0
+		+ (int64_t)f5_2 * g9_19
+		+ (int64_t)f6 * g8_19
+		+ (int64_t)f7_2 * g7_19
+		+ (int64_t)f8 * g6_19
+		+ (int64_t)f9_2 * g5_19;
+	int64_t h5 = (int64_t)f0 * g5
+		+ (int64_t)f1 * g4
+		+ (int64_t)f2 * g3
+		+ (int64_t)f3 * g2
+		+ (int64_t)f4 * g1
+		+ (int64_t)f5 * g0
+		+ (int64_t)f6 * g9_19
+		+ (int64_t)f7 * g8_19
+		+ (int64_t)f8 * g7_19
+		+ (int64_t)f9 * g6_19;
+	int64_t h6 = (int64_t)f0 * g6
+		+ (int64_t)f1_2 * g5
+		+ (int64_t)f2 * g4
+		+ (int64_t)f3_2 * g3
+		+ (int64_t)f4 * g2
+		+ (int64_t)f5_2 * g1
+		+ (int64_t)f6 * g0
+		+ (int64_t)f7_2 * g9_19
+		+ (int64_t)f8 * g8_19
+		+ (int64_t)f9_2 * g7_19;
+	int64_t h7 = (int64_t)f0 * g7
+		+ (int64_t)f1 * g6
+		+ (int64_t)f2 * g5
+		+ (int64_t)f3 * g4
+		+ (int64_t)f4 * g3
+		+ (int64_t)f5 * g2
+		+ (int64_t)f6 * g1
+		+ (int64_t)f7 * g0
+		+ (int64_t)f8 * g9_19
+		+ (int64_t)f9 * g8_19;
+	int64_t h8 = (int64_t)f0 * g8
+		+ (int64_t)f1_2 * g7
+		+ (int64_t)f2 * g6
+		+ (int64_t)f3_2 * g5
+		+ (int64_t)f4 * g4
+		+ (int64_t)f5_2 * g3
+		+ (int64_t)f6 * g2
+		+ (int64_t)f7_2 * g1
+		+ (int64_t)f8 * g0
+		+ (int64_t)f9_2 * g9_19;
+	int64_t h9 = (int64_t)f0 * g9
+		+ (int64_t)f1 * g8
+		+ (int64_t)f2 * g7
+		+ (int64_t)f3 * g6
+		+ (int64_t)f4 * g5
+		+ (int64_t)f5 * g4
+		+ (int64_t)f6 * g3
+		+ (int64_t)f7 * g2
+		+ (int64_t)f8 * g1
+		+ (int64_t)f9 * g0;
+
+	int64_t c[10] = { h0, h1, h2, h3, h4, h5, h6, h7, h8, h9 };
+	fe_carry(h, c);
+}
+
+// h = f * f
+static void fe_sq(fe h, const fe f) {
+	int32_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+	int32_t f5 = f[5], f6 = f[6], f7 = f[7], f8 = f[8], f9 = f[9];
+	int32_t f0_2 = 2 * f0, f1_2 = 2 * f1, f2_2 = 2 * f2, f3_2 = 2 * f3, f4_2 = 2 * f4;
+	int32_t f5_2 = 2 * f5, f6_2 = 2 * f6, f7_2 = 2 * f7, f8_2 = 2 * f8, f9_2 = 2 * f9;
+	int32_t f5_19 = 19 * f5, f6_19 = 19 * f6, f7_19 = 19 * f7, f8_19 = 19 * f8, f9_19 = 19 * f9;
+	int32_t f7_38 = 38 * f7, f9_38 = 38 * f9;
+
+	int64_t h0 = (int64_t)f0 * f0
+		+ (int64_t)f1_2 * f9_38
+		+ (int64_t)f2_2 * f8_19
+		+ (int64_t)f3_2 * f7_38
+		+ (int64_t)f4_2 * f6_19
+		+ (int64_t)f5_2 * f5_19;
+	int64_t h1 = (int64_t)f0_2 * f1
+		+ (int64_t)f2_2 * f9_19
+		+ (int64_t)f3_2 * f8_19
+		+ (int64_t)f4_2 * f7_19
+		+ (int64_t)f5_2 * f6_19;
+	int64_t h2 = (int64_t)f0_2 * f2
+		+ (int64_t)f1_2 * f1
+		+ (int64_t)f3_2 * f9_38
+		+ (int64_t)f4_2 * f8_19
+		+ (int64_t)f5_2 * f7_38
+		+ (int64_t)f6 * f6_19;
+	int64_t h3 = (int64_t)f0_2 * f3
+		+ (int64_t)f1_2 * f2
+		+ (int64_t)f4_2 * f9_19
+		+ (int64_t)f5_2 * f8_19
+		+ (int64_t)f6_2 * f7_19;
+	int64_t h4 = (int64_t)f0_2 * f4
+		+ (int64_t)f1_2 * f3_2
+		+ (int64_t)f2 * f2
+		+ (int64_t)f5_2 * f9_38
+		+ (int64_t)f6_2 * f8_19
+		+ (int64_t)f7_2 * f7_19;
+	int64_t h5 = (int64_t)f0_2 * f5
+		+ (int64_t)f1_2 * f4
+		+ (int64_t)f2_2 * f3
+		+ (int64_t)f6_2 * f9_19
+		+ (int64_t)f7_2 * f8_19;
+	int64_t h6 = (int64_t)f0_2 * f6
+		+ (int64_t)f1_2 * f5_2
+		+ (int64_t)f2_2 * f4
+		+ (int64_t)f3_2 * f3
+		+ (int64_t)f7_2 * f9_38
+		+ (int64_t)f8 * f8_19;
+	int64_t h7 = (int64_t)f0_2 * f7
+		+ (int64_t)f1_2 * f6
+		+ (int64_t)f2_2 * f5
+		+ (int64_t)f3_2 * f4
+		+ (int64_t)f8_2 * f9_19;
+	int64_t h8 = (int64_t)f0_2 * f8
+		+ (int64_t)f1_2 * f7_2
+		+ (int64_t)f2_2 * f6
+		+ (int64_t)f3_2 * f5_2
+		+ (int64_t)f4 * f4
+		+ (int64_t)f9_2 * f9_19;
+	int64_t h9 = (int64_t)f0_2 * f9
+		+ (int64_t)f1_2 * f8
+		+ (int64_t)f2_2 * f7
+		+ (int64_t)f3_2 * f6
+		+ (int64_t)f4_2 * f5;
+
+	int64_t c[10] = { h0, h1, h2, h3, h4, h5, h6, h7, h8, h9 };
+	fe_carry(h, c);
+}
+
+// h = f^(2^n)
+static void fe_sqn(fe h, const fe f, int n) {
+	fe_sq(h, f);
+	while (--n > 0) {
+		fe_sq(h, h);
+	}
+}
+
+// h = f * 121666, i.e. (A + 2) / 4 for Curve25519
+static void fe_mul121666(fe h, const fe f) {
+	int64_t c[10];
+	for (int i = 0; i < 10; i++) {
+		c[i] = (int64_t)f[i] * 121666;
+	}
+	fe_carry(h, c);
+}
+
+// h = z^(p - 2) = 1 / z, the usual 254 squarings and 11 multiplications
+static void fe_invert(fe h, const fe z) {
+	fe t0, t1, t2, t3;
+
+	fe_sq(t0, z);            // 2
+	fe_sqn(t1, t0, 2);       // 8
+	fe_mul(t1, z, t1);       // 9
+	fe_mul(t0, t0, t1);      // 11
+	fe_sq(t2, t0);           // 22
+	fe_mul(t1, t1, t2);      // 2^5 - 1
+	fe_sqn(t2, t1, 5);
+	fe_mul(t1, t2, t1);      // 2^10 - 1
+	fe_sqn(t2, t1, 10);
+	fe_mul(t2, t2, t1);      // 2^20 - 1
+	fe_sqn(t3, t2, 20);
+	fe_mul(t2, t3, t2);      // 2^40 - 1
+	fe_sqn(t2, t2, 10);
+	fe_mul(t1, t2, t1);      // 2^50 - 1
+	fe_sqn(t2, t1, 50);
+	fe_mul(t2, t2, t1);      // 2^100 - 1
+	fe_sqn(t3, t2, 100);
+	fe_mul(t2, t3, t2);      // 2^200 - 1
+	fe_sqn(t2, t2, 50);
+	fe_mul(t1, t2, t1);      // 2^250 - 1
+	fe_sqn(t1, t1, 5);       // 2^255 - 2^5
+	fe_mul(h, t1, t0);       // 2^255 - 21
+
+	crypto_zero(t0, sizeof(t0));
+	crypto_zero(t1, sizeof(t1));
+	crypto_zero(t2, sizeof(t2));
+	crypto_zero(t3, sizeof(t3));
+}
+
+// Little-endian 255-bit number; the top bit is ignored (RFC 7748 section 5)
+static void fe_frombytes(fe h, const uint8_t *s) {
+	unsigned pos = 0;
+	for (int i = 0; i < 10; i++) {
+		uint64_t v = 0;
+		for (unsigned b = 0; b < 5 && pos / 8 + b < 32; b++) {
+			v |= (uint64_t)s[pos / 8 + b] << (8 * b);
+		}
+		h[i] = (int32_t)((v >> (pos % 8)) & ((1U << FE_BITS(i)) - 1));
+		pos += FE_BITS(i);
+	}
+}
+
+// Fully reduced little-endian encoding
+static void fe_tobytes(uint8_t *s, const fe f) {
+	int32_t h[10];
+	int32_t q;
+
+	// q = floor(f / p), 0 or 1 for a carried f
+	q = (19 * f[9] + (1 << 24)) >> 25;
+	for (int i = 0; i < 10; i++) {
+		q = (f[i] + q) >> FE_BITS(i);
+	}
+
+	// f - q * p (mod 2^255), each limb in [0, 2^bits)
+	memcpy(h, f, sizeof(h));
+	h[0] += 19 * q;
+	for (int i = 0; i < 9; i++) {
+		int32_t carry = h[i] >> FE_BITS(i);
+		h[i + 1] += carry;
+		h[i] -= carry * (1 << FE_BITS(i));
+	}
+	h[9] &= (1 << 25) - 1;
+
+	uint64_t acc = 0;
+	unsigned bits = 0;
+	size_t n = 0;
+	for (int i = 0; i < 10; i++) {
+		acc |= (uint64_t)(uint32_t)h[i] << bits;
+		bits += FE_BITS(i);
+		while (bits >= 8) {
+			s[n++] = (uint8_t)acc;
+			acc >>= 8;
+			bits -= 8;
+		}
+	}
+	s[n] = (uint8_t)acc;    // bits 248..254
+	crypto_zero(h, sizeof(h));
+}
+
+// ============================================================================
+// Montgomery ladder
+// ============================================================================
+
+int x25519_xtensa(uint8_t out[X25519_XTENSA_BYTES], const uint8_t scalar[X25519_XTENSA_BYTES], const uint8_t point[X25519_XTENSA_BYTES]) {
+	uint8_t e[X25519_XTENSA_BYTES];
+	fe x1, x2, z2, x3, z3, tmp0, tmp1;
+	uint32_t swap = 0;
+
+	memcpy(e, scalar, sizeof(e));
+	e[0] &= 248;
+	e[31] &= 127;
+	e[31] |= 64;
+
+	fe_frombytes(x1, point);
+	fe_1(x2);
+	fe_0(z2);
+	memcpy(x3, x1, sizeof(fe));
+	fe_1(z3);
+
+	for (int pos = 254; pos >= 0; pos--) {
+		uint32_t b = (uint32_t)(e[pos / 8] >> (pos & 7)) & 1;
+		swap ^= b;
+		fe_cswap(x2, x3, swap);
+		fe_cswap(z2, z3, swap);
+		swap = b;
+
+		// RFC 7748 section 5 ladder step, ordered so every sum or
+		// difference feeds straight into a multiplication
+		fe_sub(tmp0, x3, z3);        // D
+		fe_sub(tmp1, x2, z2);        // B
+		fe_add(x2, x2, z2);          // A
+		fe_add(z2, x3, z3);          // C
+		fe_mul(z3, tmp0, x2);        // DA
+		fe_mul(z2, z2, tmp1);        // CB
+		fe_sq(tmp0, tmp1);           // BB
+		fe_sq(tmp1, x2);             // AA
+		fe_add(x3, z3, z2);          // DA + CB
+		fe_sub(z2, z3, z2);          // DA - CB
+		fe_mul(x2, tmp1, tmp0);      // x2 = AA * BB
+		fe_sub(tmp1, tmp1, tmp0);    // E = AA - BB
+		fe_sq(z2, z2);
+		fe_mul121666(z3, tmp1);
+		fe_sq(x3, x3);               // x3 = (DA + CB)^2
+		fe_add(tmp0, tmp0, z3);      // BB + 121666 * E
+		fe_mul(z3, x1, z2);          // z3 = x1 * (DA - CB)^2
+		fe_mul(z2, tmp1, tmp0);      // z2 = E * (AA + 121665 * E)
+	}
+	fe_cswap(x2, x3, swap);
+	fe_cswap(z2, z3, swap);
+
+	fe_invert(z2, z2);
+	fe_mul(x2, x2, z2);
+	fe_tobytes(out, x2);
+
+	// All-zero output means a low-order point (RFC 7748 section 6.1)
+	uint8_t acc = 0;
+	for (size_t i = 0; i < X25519_XTENSA_BYTES; i++) {
+		acc |= out[i];
+	}
+
+	crypto_zero(e, sizeof(e));
+	crypto_zero(x2, sizeof(x2));
+	crypto_zero(z2, sizeof(z2));
+	crypto_zero(x3, sizeof(x3));
+	crypto_zero(z3, sizeof(z3));
+	crypto_zero(tmp0, sizeof(tmp0));
+	crypto_zero(tmp1, sizeof(tmp1));
+	return (int)((((uint32_t)acc) - 1) >> 8) & 1;
+}
@@ -325,6 +325,36 @@ fail:
     return err;
 }
 
+esp_err_t esp_wireguard_get_stats(wireguard_ctx_t *ctx, wireguard_stats_t *stats)
+{
+    esp_err_t err;
+    struct wireguardif_stats s;
+
+    if (!ctx || !ctx->netif || !stats) {
+        err = ESP_ERR_INVALID_ARG;
+        goto fail;
+    }
+    if (wireguardif_get_stats(ctx->netif, &s) != ERR_OK) {
+        err = ESP_ERR_INVALID_ARG;
+        goto fail;
+    }
+    stats->rx_packets = s.rx_packets;
+    stats->rx_bytes = s.rx_bytes;
+    stats->rx_cycles = s.rx_cycles;
+    stats->rx_cycles_max = s.rx_cycles_max;
+    stats->tx_packets = s.tx_packets;
+    stats->tx_bytes = s.tx_bytes;
+    stats->tx_cycles = s.tx_cycles;
+    stats->tx_cycles_max = s.tx_cycles_max;
+    stats->tx_pool_hits = s.tx_pool_hits;
+    stats->tx_pool_misses = s.tx_pool_misses;
+    stats->timer_wakeups = s.timer_wakeups;
+    stats->keepalives = s.keepalives;
+    err = ESP_OK;
+fail:
+    return err;
+}
+
 esp_err_t esp_wireguardif_peer_is_up(wireguard_ctx_t *ctx)
 {
     esp_err_t err;
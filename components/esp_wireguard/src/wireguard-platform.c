@@ -8,6 +8,7 @@
 #include <esp_random.h>
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_cpu.h>
 
 #include "crypto.h"
 
@@ -31,16 +32,37 @@ uint32_t wireguard_sys_now() {
 	return sys_now();
 }
 
+uint32_t wireguard_cycles() {
+	return (uint32_t)esp_cpu_get_cycle_count();
+}
+
 void wireguard_tai64n_now(uint8_t *output) {
 	// See https://cr.yp.to/libtai/tai64.html
 	// 64 bit seconds from 1970 = 8 bytes
 	// 32 bit nano seconds from current second
 
+	// The peer drops an initiation that is not newer than the last one it
+	// accepted, so never go back: the clock may start from a restored
+	// estimate and be stepped back by NTP later. Handshakes are built in
+	// the lwIP thread only.
+	static uint64_t last_seconds;
+	static uint32_t last_nanos;
+
 	struct timeval tv;
 	gettimeofday(&tv, NULL);
 
 	uint64_t seconds = 0x400000000000000aULL + tv.tv_sec;
 	uint32_t nanos = tv.tv_usec * 1000;
+	if (seconds < last_seconds || (seconds == last_seconds && nanos <= last_nanos)) {
+		seconds = last_seconds;
+		nanos = last_nanos + 1;
+		if (nanos >= 1000000000U) {
+			seconds++;
+			nanos = 0;
+		}
+	}
+	last_seconds = seconds;
+	last_nanos = nanos;
 	U64TO8_BIG(output + 0, seconds);
 	U32TO8_BIG(output + 8, nanos);
 }
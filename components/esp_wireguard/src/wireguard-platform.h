@@ -59,6 +59,9 @@ esp_err_t wireguard_platform_init();
 // The number of milliseconds since system boot - for LwIP systems this could be sys_now()
 uint32_t wireguard_sys_now();
 
+// Free-running CPU cycle counter, used for the data path statistics
+uint32_t wireguard_cycles();
+
 // Fill the supplied buffer with random data - random data is used for generating new session keys periodically
 void wireguard_random_bytes(void *bytes, size_t size);
 
@@ -193,11 +193,11 @@ static void wireguard_mac(uint8_t *dst, const void *message, size_t len, const u
 }
 
 static void wireguard_mac_key(uint8_t *key, const uint8_t *public_key, const uint8_t *label, size_t label_len) {
-	blake2s_ctx ctx;
-	blake2s_init(&ctx, WIREGUARD_SESSION_KEY_LEN, NULL, 0);
-	blake2s_update(&ctx, label, label_len);
-	blake2s_update(&ctx, public_key, WIREGUARD_PUBLIC_KEY_LEN);
-	blake2s_final(&ctx, key);
+	wireguard_blake2s_ctx ctx;
+	wireguard_blake2s_init(&ctx, WIREGUARD_SESSION_KEY_LEN, NULL, 0);
+	wireguard_blake2s_update(&ctx, label, label_len);
+	wireguard_blake2s_update(&ctx, public_key, WIREGUARD_PUBLIC_KEY_LEN);
+	wireguard_blake2s_final(&ctx, key);
 }
 
 static void wireguard_mix_hash(uint8_t *hash, const uint8_t *src, size_t src_len) {
@@ -208,6 +208,19 @@ static void wireguard_mix_hash(uint8_t *hash, const uint8_t *src, size_t src_len
 	wireguard_blake2s_final(&ctx, hash);
 }
 
+#if defined(wireguard_hkdf)
+static void wireguard_kdf1(uint8_t *tau1, const uint8_t *chaining_key, const uint8_t *data, size_t data_len) {
+	wireguard_hkdf(tau1, NULL, NULL, chaining_key, data, data_len);
+}
+
+static void wireguard_kdf2(uint8_t *tau1, uint8_t *tau2, const uint8_t *chaining_key, const uint8_t *data, size_t data_len) {
+	wireguard_hkdf(tau1, tau2, NULL, chaining_key, data, data_len);
+}
+
+static void wireguard_kdf3(uint8_t *tau1, uint8_t *tau2, uint8_t *tau3, const uint8_t *chaining_key, const uint8_t *data, size_t data_len) {
+	wireguard_hkdf(tau1, tau2, tau3, chaining_key, data, data_len);
+}
+#else
 static void wireguard_hmac(uint8_t *digest, const uint8_t *key, size_t key_len, const uint8_t *text, size_t text_len) {
 	// Adapted from appendix example in RFC2104 to use BLAKE2S instead of MD5 - https://tools.ietf.org/html/rfc2104
 	wireguard_blake2s_ctx ctx;
@@ -317,6 +330,7 @@ static void wireguard_kdf3(uint8_t *tau1, uint8_t *tau2, uint8_t *tau3, const ui
 	crypto_zero(tau0, sizeof(tau0));
 	crypto_zero(output, sizeof(output));
 }
+#endif
 
 bool wireguard_check_replay(struct wireguard_keypair *keypair, uint64_t seq) {
 	// Implementation of packet replay window - as per RFC2401
@@ -951,7 +965,7 @@ void wireguard_create_cookie_reply(struct wireguard_device *device, struct messa
 
 bool wireguard_peer_init(struct wireguard_device *device, struct wireguard_peer *peer, const uint8_t *public_key, const uint8_t *preshared_key) {
 	// Clear out structure
-	memset(peer, 0, sizeof(struct wireguard_peer));
+	memset(peer, 0, WIREGUARD_PEER_CLEAR_LEN);
 
 	if (device->valid) {
 		// Copy across the public key into our peer structure
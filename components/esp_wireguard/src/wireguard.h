@@ -41,6 +41,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // Note: these are only required for definitions in device/peer for netif, udp_pcb, ip_addr_t and u16_t
 #include "lwip/netif.h"
@@ -50,6 +51,16 @@ extern "C" {
 
 // Platform-specific functions that need to be implemented per-platform
 #include "wireguard-platform.h"
+// struct wireguardif_stats
+#include "wireguardif.h"
+
+// Per-peer transmit buffers (see Kconfig), lwIP custom pbufs
+#if defined(CONFIG_WIREGUARD_TX_POOL_SLOTS) && (CONFIG_WIREGUARD_TX_POOL_SLOTS > 0) && LWIP_SUPPORT_CUSTOM_PBUF
+#define WIREGUARD_TX_POOL_SLOTS CONFIG_WIREGUARD_TX_POOL_SLOTS
+#define WIREGUARD_TX_POOL_PAYLOAD CONFIG_WIREGUARD_TX_POOL_PAYLOAD
+#else
+#define WIREGUARD_TX_POOL_SLOTS 0
+#endif
 
 // tai64n contains 64-bit seconds and 32-bit nano offset (12 bytes)
 #define WIREGUARD_TAI64N_LEN		(12)
@@ -115,6 +126,16 @@ struct wireguard_allowed_ip {
 	ip_addr_t mask;
 };
 
+#if WIREGUARD_TX_POOL_SLOTS > 0
+// One transmit buffer: lwIP owns it from pbuf_alloced_custom() until the last
+// pbuf_free(), which calls back to clear busy (from whichever task that is)
+struct wireguard_tx_slot {
+	struct pbuf_custom pc; // Must be first
+	volatile bool busy;
+	uint8_t mem[PBUF_TRANSPORT + MEM_ALIGNMENT + WIREGUARD_TX_POOL_PAYLOAD] __attribute__((aligned(4)));
+};
+#endif
+
 struct wireguard_peer {
 	bool valid; // Is this peer initialised?
 	bool active; // Should we be actively trying to connect?
@@ -170,8 +191,20 @@ struct wireguard_peer {
 
 	// We set this flag on RX/TX of packets if we think that we should initiate a new handshake
 	bool send_handshake;
+
+#if WIREGUARD_TX_POOL_SLOTS > 0
+	// Last member: lwIP may still hold a slot when the peer is cleared
+	struct wireguard_tx_slot tx_pool[WIREGUARD_TX_POOL_SLOTS];
+#endif
 };
 
+// Bytes of struct wireguard_peer that may be cleared (everything but tx_pool)
+#if WIREGUARD_TX_POOL_SLOTS > 0
+#define WIREGUARD_PEER_CLEAR_LEN offsetof(struct wireguard_peer, tx_pool)
+#else
+#define WIREGUARD_PEER_CLEAR_LEN sizeof(struct wireguard_peer)
+#endif
+
 struct wireguard_device {
 	// Maybe have a "Device private" member to abstract these?
 	struct netif *netif;
@@ -193,6 +226,9 @@ struct wireguard_device {
  	struct wireguard_peer peers[WIREGUARD_MAX_PEERS];
 
 	bool valid;
+
+	// Transport data counters
+	struct wireguardif_stats stats;
 };
 
 #define MESSAGE_INVALID					0
@@ -42,6 +42,7 @@
 #include <lwip/mem.h>
 #include <lwip/sys.h>
 #include <lwip/timeouts.h>
+#include <lwip/tcpip.h>
 #include <sys/socket.h>
 #include <esp_log.h>
 #include <esp_err.h>
@@ -55,10 +56,42 @@
 #include "wireguard.h"
 #include "crypto.h"
 
-#define WIREGUARDIF_TIMER_MSECS 400
+// The device timer is one-shot, re-armed for the nearest peer deadline
+// (keepalive, rekey, keypair expiry) instead of polling every 400ms. MAX
+// bounds how late a deadline that appears between wakeups can be handled;
+// MIN keeps a failing handshake allocation from spinning.
+#define WIREGUARDIF_TIMER_MIN_MSECS 100
+#define WIREGUARDIF_TIMER_MAX_MSECS (KEEPALIVE_TIMEOUT * 1000)
+// A keepalive due this soon goes out with the current wakeup
+#define WIREGUARDIF_KEEPALIVE_SLACK_MSECS 1000
 
 #define TAG "wireguardif"
 
+static void wireguardif_tmr(void *arg);
+
+// Re-arm the device timer (lwIP thread only)
+static void wireguardif_tmr_arm(struct wireguard_device *device, uint32_t msecs) {
+	sys_untimeout(wireguardif_tmr, device);
+	sys_timeout(msecs, wireguardif_tmr, device);
+}
+
+// Run the device timer now, queued from any task. Takes the netif, which
+// outlives the device: a kick that lands after shutdown is dropped.
+static void wireguardif_tmr_kick(void *arg) {
+	struct netif *netif = (struct netif *)arg;
+	struct wireguard_device *device = (struct wireguard_device *)netif->state;
+	if (device && device->udp_pcb) {
+		wireguardif_tmr_arm(device, 0);
+	}
+}
+
+// Milliseconds until created_millis + valid_seconds, 0 once expired
+static uint32_t wireguardif_due_in(uint32_t created_millis, uint32_t valid_seconds) {
+	uint32_t diff = wireguard_sys_now() - created_millis;
+	uint32_t valid = valid_seconds * 1000;
+	return (diff >= valid) ? 0 : (valid - diff);
+}
+
 static void update_peer_addr(struct wireguard_peer *peer, const ip_addr_t *addr, u16_t port) {
 	peer->ip = *addr;
 	peer->port = port;
@@ -98,6 +131,49 @@ static err_t wireguardif_device_output(struct wireguard_device *device, struct p
 	return udp_sendto_if(device->udp_pcb, q, ipaddr, port, device->underlying_netif);
 }
 
+#if WIREGUARD_TX_POOL_SLOTS > 0
+// Last reference dropped (lwIP thread or the WiFi driver): the slot is free again
+static void wireguardif_tx_slot_free(struct pbuf *p) {
+	struct wireguard_tx_slot *slot = (struct wireguard_tx_slot *)p;
+	__atomic_store_n(&slot->busy, false, __ATOMIC_RELEASE);
+}
+#endif
+
+// A PBUF_TRANSPORT pbuf of len bytes in one piece: a free per-peer slot when the
+// message fits, else the lwIP heap
+static struct pbuf *wireguardif_tx_alloc(struct wireguard_device *device, struct wireguard_peer *peer, u16_t len) {
+#if WIREGUARD_TX_POOL_SLOTS > 0
+	if (len <= WIREGUARD_TX_POOL_PAYLOAD) {
+		for (int x = 0; x < WIREGUARD_TX_POOL_SLOTS; x++) {
+			struct wireguard_tx_slot *slot = &peer->tx_pool[x];
+			// Only this thread sets busy, so no compare-and-swap is needed
+			if (!__atomic_load_n(&slot->busy, __ATOMIC_ACQUIRE)) {
+				slot->pc.custom_free_function = wireguardif_tx_slot_free;
+				struct pbuf *p = pbuf_alloced_custom(PBUF_TRANSPORT, len, PBUF_RAM, &slot->pc, slot->mem, sizeof(slot->mem));
+				if (p) {
+					slot->busy = true;
+					device->stats.tx_pool_hits++;
+					return p;
+				}
+				break;
+			}
+		}
+	}
+	device->stats.tx_pool_misses++;
+#else
+	(void)device;
+	(void)peer;
+#endif
+	return pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+}
+
+static void wireguardif_stats_add(uint32_t *total, uint32_t *max, uint32_t cycles) {
+	*total += cycles;
+	if (cycles > *max) {
+		*max = cycles;
+	}
+}
+
 static err_t wireguardif_output_to_peer(struct netif *netif, struct pbuf *q, const ip_addr_t *ipaddr, struct wireguard_peer *peer) {
 	// The LWIP IP layer wants to send an IP packet out over the interface - we need to encrypt and send it to the peer
 	struct message_transport_data *hdr;
@@ -108,6 +184,8 @@ static err_t wireguardif_output_to_peer(struct netif *netif, struct pbuf *q, con
 	size_t header_len = 16;
 	uint8_t *dst;
 	uint32_t now;
+	uint32_t start = wireguard_cycles();
+	struct wireguard_device *device = (struct wireguard_device *)netif->state;
 	struct wireguard_keypair *keypair = &peer->curr_keypair;
 
 	// Note: We may not be able to use the current keypair if we haven't received data, may need to resort to using previous keypair
@@ -134,15 +212,15 @@ static err_t wireguardif_output_to_peer(struct netif *netif, struct pbuf *q, con
 
 			// The buffer needs to be allocated from "transport" pool to leave room for LwIP generated IP headers
 			// The IP packet consists of 16 byte header (struct message_transport_data), data padded upto 16 byte boundary + encrypted auth tag (16 bytes)
-			pbuf = pbuf_alloc(PBUF_TRANSPORT, header_len + padded_len + WIREGUARD_AUTHTAG_LEN, PBUF_RAM);
+			pbuf = wireguardif_tx_alloc(device, peer, (u16_t)(header_len + padded_len + WIREGUARD_AUTHTAG_LEN));
 			if (pbuf) {
-				// Note: allocating pbuf from RAM above guarantees that the pbuf is in one section and not chained
+				// Note: both pool slots and pbufs allocated from RAM are in one section and not chained
 				// - i.e payload points to the contiguous memory region
-				memset(pbuf->payload, 0, pbuf->tot_len);
-
+				// Every byte is written below: header, payload, zero padding, then the tag
 				hdr = (struct message_transport_data *)pbuf->payload;
 
 				hdr->type = MESSAGE_TRANSPORT_DATA;
+				memset(hdr->reserved, 0, sizeof(hdr->reserved));
 				hdr->receiver = keypair->remote_index;
 				// Alignment required... pbuf_alloc has probably aligned data, but want to be sure
 				U64TO8_LITTLE(hdr->counter, keypair->sending_counter);
@@ -157,10 +235,16 @@ static err_t wireguardif_output_to_peer(struct netif *netif, struct pbuf *q, con
 					// Copy pbuf to memory - handles case where pbuf is chained
 					pbuf_copy_partial(q, dst, unpadded_len, 0);
 				}
+				memset(dst + unpadded_len, 0, padded_len - unpadded_len);
 
 				// Then encrypt
 				wireguard_encrypt_packet(dst, dst, padded_len, keypair);
 
+				uint32_t cycles = wireguard_cycles() - start;
+				device->stats.tx_packets++;
+				device->stats.tx_bytes += pbuf->tot_len;
+				wireguardif_stats_add(&device->stats.tx_cycles, &device->stats.tx_cycles_max, cycles);
+
 				result = wireguardif_peer_output(netif, pbuf, peer);
 
 				if (result == ERR_OK) {
@@ -172,10 +256,15 @@ static err_t wireguardif_output_to_peer(struct netif *netif, struct pbuf *q, con
 				pbuf_free(pbuf);
 
 				// Check to see if we should rekey
-				if (keypair->sending_counter >= REKEY_AFTER_MESSAGES) {
-					peer->send_handshake = true;
-				} else if (keypair->initiator && wireguard_expired(keypair->keypair_millis, REKEY_AFTER_TIME)) {
-					peer->send_handshake = true;
+				if (!peer->send_handshake) {
+					if (keypair->sending_counter >= REKEY_AFTER_MESSAGES) {
+						peer->send_handshake = true;
+					} else if (keypair->initiator && wireguard_expired(keypair->keypair_millis, REKEY_AFTER_TIME)) {
+						peer->send_handshake = true;
+					}
+					if (peer->send_handshake) {
+						wireguardif_tmr_arm(device, 0);
+					}
 				}
 
 			} else {
@@ -264,17 +353,23 @@ static bool peer_add_ip(struct wireguard_peer *peer, ip_addr_t ip, ip_addr_t mas
 	return result;
 }
 
-static void wireguardif_process_data_message(struct wireguard_device *device, struct wireguard_peer *peer, struct message_transport_data *data_hdr, size_t data_len, const ip_addr_t *addr, u16_t port) {
+// Decrypts in place inside the received pbuf p (the message is in its first
+// segment, as wireguardif_network_rx() assumes) and hands the same pbuf to
+// ip_input(). Returns true if p was passed on, false if the caller still owns it
+static bool wireguardif_process_data_message(struct wireguard_device *device, struct wireguard_peer *peer, struct pbuf *p, size_t data_len, const ip_addr_t *addr, u16_t port) {
+	struct message_transport_data *data_hdr = (struct message_transport_data *)p->payload;
 	struct wireguard_keypair *keypair;
 	uint64_t nonce;
 	uint8_t *src;
 	size_t src_len;
-	struct pbuf *pbuf;
+	struct pbuf *pbuf = NULL;
 	struct ip_hdr *iphdr;
 	ip_addr_t dest;
 	bool dest_ok = false;
+	bool consumed = false;
 	int x;
 	uint32_t now;
+	uint32_t start = wireguard_cycles();
 	uint16_t header_len = 0xFFFF;
 	uint32_t idx = data_hdr->receiver;
 
@@ -292,12 +387,18 @@ static void wireguardif_process_data_message(struct wireguard_device *device, st
 			src = &data_hdr->enc_packet[0];
 			src_len = data_len;
 
-			// We don't know the unpadded size until we have decrypted the packet and validated/inspected the IP header
-			pbuf = pbuf_alloc(PBUF_TRANSPORT, src_len - WIREGUARD_AUTHTAG_LEN, PBUF_RAM);
-			if (pbuf) {
-				// Decrypt the packet
-				memset(pbuf->payload, 0, pbuf->tot_len);
-				if (wireguard_decrypt_packet(pbuf->payload, src, src_len, nonce, keypair)) {
+			if (src_len >= WIREGUARD_AUTHTAG_LEN) {
+				// Decrypt the packet where it is; nothing is written unless it authenticates
+				if (wireguard_decrypt_packet(src, src, src_len, nonce, keypair)) {
+					// We don't know the unpadded size until we have validated/inspected the IP header:
+					// drop the message header and the tag, ip_input() trims the padding
+					pbuf = p;
+					pbuf_remove_header(pbuf, sizeof(struct message_transport_data));
+					pbuf_realloc(pbuf, (u16_t)(src_len - WIREGUARD_AUTHTAG_LEN));
+
+					device->stats.rx_packets++;
+					device->stats.rx_bytes += (uint32_t)src_len;
+					wireguardif_stats_add(&device->stats.rx_cycles, &device->stats.rx_cycles_max, wireguard_cycles() - start);
 
 					// 3. Since the packet has authenticated correctly, the source IP of the outer UDP/IP packet is used to update the endpoint for peer TrMv...WXX0.
 					// Update the peer location
@@ -311,8 +412,9 @@ static void wireguardif_process_data_message(struct wireguard_device *device, st
 					keypair_update(peer, keypair);
 
 					// Check to see if we should rekey
-					if (keypair->initiator && wireguard_expired(keypair->keypair_millis, REJECT_AFTER_TIME - peer->keepalive_interval - REKEY_TIMEOUT)) {
+					if (!peer->send_handshake && keypair->initiator && wireguard_expired(keypair->keypair_millis, REJECT_AFTER_TIME - peer->keepalive_interval - REKEY_TIMEOUT)) {
 						peer->send_handshake = true;
+						wireguardif_tmr_arm(device, 0);
 					}
 
 					// Make sure that link is reported as up
@@ -354,7 +456,7 @@ static void wireguardif_process_data_message(struct wireguard_device *device, st
 									// Send packet to be process by LWIP
 									ip_input(pbuf, device->netif);
 									// pbuf is owned by IP layer now
-									pbuf = NULL;
+									consumed = true;
 								}
 							} else {
 								// IP header is corrupt or lied about packet size
@@ -366,10 +468,6 @@ static void wireguardif_process_data_message(struct wireguard_device *device, st
 						// This was a keep-alive packet
 					}
 				}
-
-				if (pbuf) {
-					pbuf_free(pbuf);
-				}
 			}
 
 
@@ -383,6 +481,7 @@ static void wireguardif_process_data_message(struct wireguard_device *device, st
 	} else {
 		// Could not locate valid keypair for remote index
 	}
+	return consumed;
 }
 
 static struct pbuf *wireguardif_initiate_handshake(struct wireguard_device *device, struct wireguard_peer *peer, struct message_handshake_initiation *msg, err_t *error) {
@@ -612,7 +711,10 @@ void wireguardif_network_rx(void *arg, struct udp_pcb *pcb, struct pbuf *p, cons
 			peer = peer_lookup_by_receiver(device, msg_data->receiver);
 			if (peer) {
 				// header is 16 bytes long so take that off the length
-				wireguardif_process_data_message(device, peer, msg_data, len - 16, addr, port);
+				if (wireguardif_process_data_message(device, peer, p, len - 16, addr, port)) {
+					// Decrypted in place and passed up to the IP layer
+					p = NULL;
+				}
 			}
 			break;
 
@@ -621,7 +723,9 @@ void wireguardif_network_rx(void *arg, struct udp_pcb *pcb, struct pbuf *p, cons
 			break;
 	}
 	// Release data!
-	pbuf_free(p);
+	if (p) {
+		pbuf_free(p);
+	}
 }
 
 static err_t wireguard_start_handshake(struct netif *netif, struct wireguard_peer *peer) {
@@ -681,6 +785,10 @@ err_t wireguardif_connect(struct netif *netif, u8_t peer_index) {
 			peer->active = true;
 			peer->ip = peer->connect_ip;
 			peer->port = peer->connect_port;
+			// Start the handshake now rather than at the next deadline
+			if (tcpip_callback(wireguardif_tmr_kick, netif) != ERR_OK) {
+				ESP_LOGW(TAG, "wireguardif_connect: timer kick failed, handshake at next wakeup");
+			}
 			result = ERR_OK;
 		} else {
 			result = ERR_ARG;
@@ -723,11 +831,21 @@ err_t wireguardif_peer_is_up(struct netif *netif, u8_t peer_index, ip_addr_t *cu
 	return result;
 }
 
+err_t wireguardif_get_stats(struct netif *netif, struct wireguardif_stats *stats) {
+	err_t result = ERR_ARG;
+	if (netif && netif->state && stats) {
+		struct wireguard_device *device = (struct wireguard_device *)netif->state;
+		*stats = device->stats;
+		result = ERR_OK;
+	}
+	return result;
+}
+
 err_t wireguardif_remove_peer(struct netif *netif, u8_t peer_index) {
 	struct wireguard_peer *peer;
 	err_t result = wireguardif_lookup_peer(netif, peer_index, &peer);
 	if (result == ERR_OK) {
-		crypto_zero(peer, sizeof(struct wireguard_peer));
+		crypto_zero(peer, WIREGUARD_PEER_CLEAR_LEN);
 		peer->valid = false;
 		result = ERR_OK;
 	}
@@ -823,7 +941,10 @@ static bool should_send_keepalive(struct wireguard_peer *peer) {
 	bool result = false;
 	if (peer->keepalive_interval > 0) {
 		if ((peer->curr_keypair.valid) || (peer->prev_keypair.valid)) {
-			if (wireguard_expired(peer->last_tx, peer->keepalive_interval)) {
+			// Any other packet (e.g. CWNet ping replies) moves last_tx and
+			// stands in for the keepalive; one due within the slack goes
+			// now rather than costing its own wakeup
+			if (wireguardif_due_in(peer->last_tx, peer->keepalive_interval) <= WIREGUARDIF_KEEPALIVE_SLACK_MSECS) {
 				result = true;
 			}
 		}
@@ -831,6 +952,37 @@ static bool should_send_keepalive(struct wireguard_peer *peer) {
 	return result;
 }
 
+// Milliseconds until the next timed event of a peer, at most next. Mirrors
+// the should_*() checks above.
+static uint32_t peer_next_event(struct wireguard_peer *peer, uint32_t next) {
+	uint32_t due;
+	if (peer->curr_keypair.valid) {
+		due = wireguardif_due_in(peer->curr_keypair.keypair_millis, REJECT_AFTER_TIME);
+		next = LWIP_MIN(next, due);
+	}
+	if ((peer->keepalive_interval > 0) && ((peer->curr_keypair.valid) || (peer->prev_keypair.valid))) {
+		due = wireguardif_due_in(peer->last_tx, peer->keepalive_interval);
+		next = LWIP_MIN(next, due);
+	}
+
+	bool initiate = false;
+	due = 0;
+	if (peer->send_handshake || (!peer->curr_keypair.valid && peer->active)) {
+		initiate = true;
+	} else if (peer->curr_keypair.valid && !peer->curr_keypair.initiator) {
+		initiate = true;
+		due = wireguardif_due_in(peer->curr_keypair.keypair_millis, REJECT_AFTER_TIME - peer->keepalive_interval);
+	}
+	if (initiate) {
+		// Rate limited to one initiation per REKEY_TIMEOUT
+		if (peer->last_initiation_tx != 0) {
+			due = LWIP_MAX(due, wireguardif_due_in(peer->last_initiation_tx, REKEY_TIMEOUT));
+		}
+		next = LWIP_MIN(next, due);
+	}
+	return next;
+}
+
 static bool should_destroy_current_keypair(struct wireguard_peer *peer) {
 	bool result = false;
 	if (peer->curr_keypair.valid &&
@@ -854,8 +1006,9 @@ static void wireguardif_tmr(void *arg) {
 	struct wireguard_device *device = (struct wireguard_device *)arg;
 	struct wireguard_peer *peer;
 	int x;
-	// Reschedule this timer
-	sys_timeout(WIREGUARDIF_TIMER_MSECS, wireguardif_tmr, device);
+	uint32_t next = WIREGUARDIF_TIMER_MAX_MSECS;
+
+	device->stats.timer_wakeups++;
 
 	// Check periodic things
 	bool link_up = false;
@@ -880,6 +1033,7 @@ static void wireguardif_tmr(void *arg) {
 			}
 			if (should_send_keepalive(peer)) {
 				wireguardif_send_keepalive(device, peer);
+				device->stats.keepalives++;
 			}
 			if (should_send_initiation(peer)) {
 				wireguard_start_handshake(device->netif, peer);
@@ -888,6 +1042,7 @@ static void wireguardif_tmr(void *arg) {
 			if ((peer->curr_keypair.valid) || (peer->prev_keypair.valid)) {
 				link_up = true;
 			}
+			next = peer_next_event(peer, next);
 		}
 	}
 
@@ -895,6 +1050,10 @@ static void wireguardif_tmr(void *arg) {
 		// Clear the IF-UP flag on netif
 		netif_set_link_down(device->netif);
 	}
+
+	// Re-arm for the nearest deadline (this also drops a kick armed by a
+	// packet sent above, whose deadline is already in next)
+	wireguardif_tmr_arm(device, LWIP_MAX(next, WIREGUARDIF_TIMER_MIN_MSECS));
 }
 
 
@@ -985,8 +1144,8 @@ err_t wireguardif_init(struct netif *netif) {
 
 							udp_recv(udp, wireguardif_network_rx, device);
 
-							// Start a periodic timer for this wireguard device
-							sys_timeout(WIREGUARDIF_TIMER_MSECS, wireguardif_tmr, device);
+							// Start the timer for this wireguard device; it re-arms itself
+							sys_timeout(WIREGUARDIF_TIMER_MAX_MSECS, wireguardif_tmr, device);
 
 							result = ERR_OK;
 						} else {
@@ -1051,6 +1210,20 @@ void wireguardif_fini(struct netif *netif) {
 
 	struct wireguard_device *device = (struct wireguard_device *)netif->state;
 
+#if WIREGUARD_TX_POOL_SLOTS > 0
+	// A packet still queued in lwIP (e.g. waiting for ARP) would call back into
+	// freed memory: keep the device allocated in that rare case
+	for (int x = 0; x < WIREGUARD_MAX_PEERS; x++) {
+		for (int y = 0; y < WIREGUARD_TX_POOL_SLOTS; y++) {
+			if (__atomic_load_n(&device->peers[x].tx_pool[y].busy, __ATOMIC_ACQUIRE)) {
+				ESP_LOGW(TAG, "transmit buffer still in use, device context not freed");
+				netif->state = NULL;
+				return;
+			}
+		}
+	}
+#endif
+
 	// remove device context.
 	free(device);
 	netif->state = NULL;
@@ -75,6 +75,24 @@ struct wireguardif_peer {
 
 #define WIREGUARDIF_INVALID_INDEX (0xFF)
 
+// Transport data counters of one interface. Written by the lwIP thread only;
+// 32-bit fields so another task can read them without tearing. Byte counts
+// are WireGuard payload bytes and wrap at 4 GiB
+struct wireguardif_stats {
+	uint32_t rx_packets;		// Authenticated transport data messages (keepalives included)
+	uint32_t rx_bytes;
+	uint32_t rx_cycles;			// Sum over rx_packets: authenticate, decrypt, filter
+	uint32_t rx_cycles_max;
+	uint32_t tx_packets;		// Sealed transport data messages handed to UDP
+	uint32_t tx_bytes;
+	uint32_t tx_cycles;			// Sum over tx_packets: buffer, copy, encrypt
+	uint32_t tx_cycles_max;
+	uint32_t tx_pool_hits;		// Packets built in a per-peer pool buffer
+	uint32_t tx_pool_misses;	// Packets that needed a pbuf from the lwIP heap
+	uint32_t timer_wakeups;		// Device timer runs (one-shot, nearest deadline)
+	uint32_t keepalives;		// Keepalives the timer had to send
+};
+
 /* static struct netif wg_netif_struct = {0};
  * struct wireguard_interface wg;
  * wg.private_key = "abcdefxxx..xxxxx=";
@@ -137,6 +155,9 @@ void wireguardif_fini(struct netif *netif);
 // Is the given peer "up"? A peer is up if it has a valid session key it can communicate with
 err_t wireguardif_peer_is_up(struct netif *netif, u8_t peer_index, ip_addr_t *current_ip, u16_t *current_port);
 
+// Copy the data path counters of the interface
+err_t wireguardif_get_stats(struct netif *netif, struct wireguardif_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
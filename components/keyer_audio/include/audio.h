@@ -10,5 +10,9 @@
 #include "audio_buffer.h"
 #include "ptt.h"
 #include "audio_source.h"
+#include "audio_playout.h"
+#include "audio_rate.h"
+#include "fade_env.h"
+#include "audio_mixer.h"
 
 #endif /* KEYER_AUDIO_H */
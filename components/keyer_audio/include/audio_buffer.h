@@ -4,6 +4,12 @@
  *
  * Single Producer, Single Consumer ring buffer using atomic indices.
  * Power of 2 size for efficient modulo.
+ *
+ * Producers and consumers work in blocks (RT tick blocks, DMA buffers,
+ * network frames): audio_buffer_write()/audio_buffer_read() copy a block
+ * with one index acquire/release pair, and the acquire/commit span calls
+ * hand out the ring storage itself (two spans across the wrap) so a
+ * block can be rendered or consumed in place without a copy.
  */
 
 #ifndef KEYER_AUDIO_BUFFER_H
@@ -59,6 +65,94 @@ void audio_buffer_push(audio_ring_buffer_t *buf, int16_t sample);
  */
 bool audio_buffer_pop(audio_ring_buffer_t *buf, int16_t *out);
 
+/**
+ * @brief Write a block of samples (producer side)
+ *
+ * Non-blocking and never overwrites: writes as many samples as fit and
+ * returns that count. Unlike audio_buffer_push() it never overwrites
+ * unread samples, so it is safe against a consumer running in an ISR.
+ *
+ * @param buf Buffer
+ * @param samples Samples to write
+ * @param count Number of samples
+ * @return Number of samples written (< count means the ring was full)
+ */
+size_t audio_buffer_write(audio_ring_buffer_t *buf, const int16_t *samples, size_t count);
+
+/**
+ * @brief Read a block of samples (consumer side)
+ *
+ * Non-blocking. Reads up to count samples.
+ *
+ * @param buf Buffer
+ * @param out Output buffer
+ * @param count Maximum samples to read
+ * @return Number of samples read (< count means the ring ran dry)
+ */
+size_t audio_buffer_read(audio_ring_buffer_t *buf, int16_t *out, size_t count);
+
+/**
+ * @brief Get free space as up to two contiguous spans (producer side)
+ *
+ * Nothing becomes visible to the consumer until audio_buffer_write_commit().
+ * Like audio_buffer_write(), never hands out unread samples.
+ *
+ * @param buf Buffer
+ * @param a First span
+ * @param na Length of first span
+ * @param b Second span after wrap
+ * @param nb Length of second span
+ * @param max Maximum number of samples to return
+ * @return Total samples available to write (0 if full)
+ */
+size_t audio_buffer_write_acquire(audio_ring_buffer_t *buf,
+                                  int16_t **a, size_t *na,
+                                  int16_t **b, size_t *nb,
+                                  size_t max);
+
+/**
+ * @brief Publish n samples written into audio_buffer_write_acquire() spans
+ *
+ * @param buf Buffer
+ * @param n Samples written (at most the acquired total)
+ */
+void audio_buffer_write_commit(audio_ring_buffer_t *buf, size_t n);
+
+/**
+ * @brief Get pending samples as up to two contiguous spans (consumer side)
+ *
+ * The spans stay valid until audio_buffer_read_commit().
+ *
+ * @param buf Buffer
+ * @param a First span
+ * @param na Length of first span
+ * @param b Second span after wrap
+ * @param nb Length of second span
+ * @param max Maximum number of samples to return
+ * @return Total samples available (0 if empty)
+ */
+size_t audio_buffer_read_acquire(audio_ring_buffer_t *buf,
+                                 const int16_t **a, size_t *na,
+                                 const int16_t **b, size_t *nb,
+                                 size_t max);
+
+/**
+ * @brief Consume n samples returned by audio_buffer_read_acquire()
+ *
+ * @param buf Buffer
+ * @param n Samples consumed (at most the acquired total)
+ */
+void audio_buffer_read_commit(audio_ring_buffer_t *buf, size_t n);
+
+/**
+ * @brief Drop samples without reading them (consumer side)
+ *
+ * @param buf Buffer
+ * @param count Maximum samples to drop
+ * @return Number of samples dropped
+ */
+size_t audio_buffer_discard(audio_ring_buffer_t *buf, size_t count);
+
 /**
  * @brief Get number of samples available
  *
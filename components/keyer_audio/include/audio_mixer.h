@@ -0,0 +1,82 @@
+/**
+ * @file audio_mixer.h
+ * @brief Fixed-point block mixer for the codec output
+ *
+ * Sums the block of every source (sidetone, streamed rig audio) in Q15,
+ * each under its own gain, and saturates once into the codec block.
+ * Gains never step: a new target is reached by a linear ramp of
+ * ramp_samples from full scale, so volume changes and ducking don't
+ * click.
+ *
+ * Cost is bounded by one multiply-add per sample and source, whatever is
+ * playing; a silent source (NULL block) only advances its gain ramp.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: No allocation, no locks; owned by the RT task
+ * - RULE 3.1.4: Constant time per block
+ */
+
+#ifndef KEYER_AUDIO_MIXER_H
+#define KEYER_AUDIO_MIXER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Mixer inputs (a new source, e.g. USB audio in, adds an entry)
+ */
+typedef enum {
+    AUDIO_MIX_SIDETONE = 0,     /**< Local or remote sidetone */
+    AUDIO_MIX_RIG,              /**< Streamed rig audio (audio_playout) */
+    AUDIO_MIX_COUNT
+} audio_mix_source_t;
+
+/**
+ * @brief Mixer state
+ */
+typedef struct {
+    uint16_t gain_q15[AUDIO_MIX_COUNT];     /**< Applied gain */
+    uint16_t target_q15[AUDIO_MIX_COUNT];   /**< Requested gain */
+    uint16_t slew;                          /**< Gain change per sample */
+} audio_mixer_t;
+
+/**
+ * @brief Initialize a mixer, every gain 0
+ *
+ * @param m Mixer
+ * @param ramp_samples Samples for a full-scale gain change (>= 1)
+ */
+void audio_mixer_init(audio_mixer_t *m, uint32_t ramp_samples);
+
+/**
+ * @brief Request a source gain (reached by a ramp)
+ *
+ * @param m Mixer
+ * @param src Source
+ * @param gain_q15 Gain, SIDETONE_GAIN_UNITY = 1.0
+ */
+void audio_mixer_set_gain(audio_mixer_t *m, audio_mix_source_t src, uint16_t gain_q15);
+
+/**
+ * @brief Mix one block
+ *
+ * out[i] = sat16(sum over sources of src[s][i] * gain[s]), gains ramping
+ * per sample toward their targets.
+ *
+ * @param m Mixer
+ * @param out Output block (n samples, overwritten)
+ * @param src Block per source, AUDIO_MIX_COUNT entries; NULL = silent
+ * @param n Samples
+ */
+void audio_mixer_render(audio_mixer_t *m, int16_t *out,
+                        const int16_t *const src[AUDIO_MIX_COUNT], size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_AUDIO_MIXER_H */
@@ -0,0 +1,108 @@
+/**
+ * @file audio_playout.h
+ * @brief Fixed-latency playout of streamed audio from an SPSC ring
+ *
+ * A network task writes decoded blocks into an audio_ring_buffer_t and
+ * the RT task mixes them into its sidetone block every tick.
+ *
+ * Latency is fixed by priming: playout starts only once target samples
+ * are buffered, and after an underrun it waits for the same level again.
+ * If the sender's clock runs fast and the level creeps above max_level,
+ * the excess is dropped back to target in one step, so the delay cannot
+ * drift. The ring level seen at each mix is the measured latency.
+ *
+ * The ring may run slower than the block it is mixed into by a whole
+ * factor (8 kHz rig audio into a 16/48 kHz codec): each ring sample is
+ * then spread over factor output samples by linear interpolation.
+ *
+ * Consumer side only: all calls belong to the task that reads the ring.
+ */
+
+#ifndef KEYER_AUDIO_PLAYOUT_H
+#define KEYER_AUDIO_PLAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "audio_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Gain change per ring sample (Q15): unity in 32 samples, 4ms at 8kHz */
+#define AUDIO_PLAYOUT_GAIN_SLEW 1024U
+
+/**
+ * @brief Playout state
+ */
+typedef struct {
+    audio_ring_buffer_t *ring;  /**< Source ring (consumer side) */
+    size_t target;              /**< Samples buffered before playout starts */
+    size_t max_level;           /**< Above this, trim back to target */
+    bool playing;               /**< Primed and draining */
+    uint16_t gain_q15;          /**< Applied gain, slews toward the requested one */
+
+    /* Upsampling (factor 1 = ring at the block rate) */
+    uint8_t up_factor;          /**< Output samples per ring sample */
+    uint8_t up_phase;           /**< Position between up_prev and up_cur */
+    int16_t up_prev;            /**< Previous ring sample */
+    int16_t up_cur;             /**< Current ring sample */
+
+    /* Statistics (written by the consumer, read anywhere) */
+    uint32_t underruns;         /**< Times the ring ran dry while playing */
+    uint32_t trimmed;           /**< Samples dropped to hold the latency */
+    uint32_t level;             /**< Ring level after the last mix */
+} audio_playout_t;
+
+/**
+ * @brief Initialize playout
+ *
+ * @param p Playout state
+ * @param ring Source ring
+ * @param target Samples to buffer before starting (the fixed latency)
+ * @param max_level Level that triggers a trim (must be > target)
+ */
+void audio_playout_init(audio_playout_t *p, audio_ring_buffer_t *ring,
+                        size_t target, size_t max_level);
+
+/**
+ * @brief Set the output samples per ring sample (1 at init)
+ *
+ * @param p Playout state
+ * @param factor Block rate / ring rate (e.g. 6 for 48 kHz over 8 kHz)
+ */
+void audio_playout_set_upsample(audio_playout_t *p, uint8_t factor);
+
+/**
+ * @brief Mix streamed samples into a block
+ *
+ * Adds ring samples scaled by gain_q15 to out[0..n), saturating at the
+ * int16 range. Nothing is added while priming. An underrun stops
+ * playout for re-priming and fades the gain from zero when it restarts.
+ *
+ * @param p Playout state
+ * @param out Block to mix into (e.g. rendered sidetone)
+ * @param n Samples in out (block rate)
+ * @param gain_q15 Requested gain (SIDETONE_GAIN_UNITY = 1.0)
+ * @return Samples of out mixed (0 while priming)
+ */
+size_t audio_playout_mix(audio_playout_t *p, int16_t *out, size_t n, uint16_t gain_q15);
+
+/**
+ * @brief Measured playout latency
+ *
+ * @param p Playout state
+ * @param sample_rate_hz Sample rate of the ring
+ * @return Buffered audio at the last mix in milliseconds
+ */
+static inline uint32_t audio_playout_latency_ms(const audio_playout_t *p,
+                                                uint32_t sample_rate_hz) {
+    return (sample_rate_hz > 0) ? (uint32_t)((p->level * 1000ULL) / sample_rate_hz) : 0U;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_AUDIO_PLAYOUT_H */
@@ -0,0 +1,83 @@
+/**
+ * @file audio_rate.h
+ * @brief Codec sample rate and conversion to the 8 kHz audio streams
+ *
+ * The codec (sidetone, I2S, ES8311) runs at audio.sample_rate: 8, 16 or
+ * 48 kHz. Everything that carries audio elsewhere stays at
+ * AUDIO_STREAM_RATE_HZ: CWNet rig audio, USB audio, the off-air decoder.
+ * Rates are integer multiples of it, so conversion is by a whole factor:
+ * rig audio is interpolated up in audio_playout (audio_playout_set_upsample),
+ * codec blocks are averaged down here.
+ */
+
+#ifndef KEYER_AUDIO_RATE_H
+#define KEYER_AUDIO_RATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Rate of rig, USB and decoder audio */
+#define AUDIO_STREAM_RATE_HZ 8000U
+
+/** Highest codec rate (sizes per-tick buffers) */
+#define AUDIO_RATE_MAX_HZ 48000U
+
+/**
+ * @brief Codec rate for an audio.sample_rate value
+ *
+ * @param index 0 = 8 kHz, 1 = 16 kHz, 2 = 48 kHz; anything else 8 kHz
+ * @return Rate in Hz
+ */
+uint32_t audio_rate_from_index(unsigned index);
+
+/**
+ * @brief Codec samples per stream sample
+ */
+static inline uint32_t audio_rate_factor(uint32_t rate_hz) {
+    uint32_t f = rate_hz / AUDIO_STREAM_RATE_HZ;
+    return (f > 0) ? f : 1U;
+}
+
+/**
+ * @brief Decimator state (codec rate → stream rate)
+ *
+ * Averages each run of factor samples into one: a boxcar low-pass that
+ * puts its first null on the stream rate, enough for a sidetone and a
+ * receiver's audio passband. Runs continue across calls.
+ */
+typedef struct {
+    uint32_t factor;        /**< Input samples per output sample */
+    uint32_t phase;         /**< Samples summed so far */
+    int32_t acc;            /**< Their sum */
+} audio_decimator_t;
+
+/**
+ * @brief Initialize a decimator
+ *
+ * @param d Decimator
+ * @param factor Input samples per output sample (1 = copy)
+ */
+void audio_decimator_init(audio_decimator_t *d, uint32_t factor);
+
+/**
+ * @brief Decimate a block
+ *
+ * out may alias in (in-place decimation).
+ *
+ * @param d Decimator
+ * @param in Input samples
+ * @param n Number of input samples
+ * @param out Output (room for n / factor + 1 samples)
+ * @return Output samples written
+ */
+size_t audio_decimate(audio_decimator_t *d, const int16_t *in, size_t n, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_AUDIO_RATE_H */
@@ -2,7 +2,8 @@
  * @file audio_source.h
  * @brief Audio source selector (sidetone vs remote)
  *
- * Manages switching between local sidetone and remote audio.
+ * Decides what the sidetone generator keys (local or remote keying) and
+ * the rig audio gain under it; the two are summed by audio_mixer.h.
  */
 
 #ifndef KEYER_AUDIO_SOURCE_H
@@ -77,6 +78,21 @@ static inline audio_source_t audio_source_get(const audio_source_selector_t *sel
     return sel->current;
 }
 
+/**
+ * @brief Rig audio gain under the current source
+ *
+ * Rig audio plays at gain_q15 while no tone is sounding and at duck_pct
+ * percent of it while sidetone or remote tone is: 0 switches to the tone,
+ * 100 mixes both at full level.
+ *
+ * @param sel Selector (after audio_source_update())
+ * @param gain_q15 Rig audio gain with nothing else playing
+ * @param duck_pct Share of gain_q15 kept under a tone (0-100)
+ * @return Rig audio gain for audio_mixer_set_gain()
+ */
+uint16_t audio_source_rig_gain(const audio_source_selector_t *sel, uint16_t gain_q15,
+                               uint8_t duck_pct);
+
 #ifdef __cplusplus
 }
 #endif
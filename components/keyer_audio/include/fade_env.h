@@ -0,0 +1,75 @@
+/**
+ * @file fade_env.h
+ * @brief Precomputed keying envelope (fade ramp) tables
+ *
+ * The ramp that turns a tone on and off sets its keying bandwidth: a
+ * linear ramp has a slope discontinuity at both ends and splatters,
+ * raised-cosine and Blackman-Harris ramps are smooth and keep the
+ * spectrum within a few times the keying speed.
+ *
+ * A table is built once (init or config change)
+ * and read once per ramp sample by the generator: table[k] is the rising
+ * envelope k samples into the ramp, table[len - k] the falling one. One
+ * table can be shared by several generators (sidetone, keyed audio to the
+ * rig) as long as they use the same ramp length.
+ */
+
+#ifndef KEYER_FADE_ENV_H
+#define KEYER_FADE_ENV_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest ramp in samples (10ms at 48 kHz) */
+#define FADE_ENV_MAX_LEN 480U
+
+/** Full envelope (Q15, matches the sustain level) */
+#define FADE_ENV_FULL 32767
+
+/**
+ * @brief Ramp shape (audio.fade_shape)
+ */
+typedef enum {
+    FADE_SHAPE_LINEAR = 0,          /**< k / len */
+    FADE_SHAPE_RAISED_COSINE,       /**< (1 - cos(pi k / len)) / 2 */
+    FADE_SHAPE_BLACKMAN_HARRIS,     /**< Rising half of a 4-term Blackman-Harris window */
+} fade_shape_t;
+
+/**
+ * @brief Envelope table
+ */
+typedef struct {
+    uint16_t len;                           /**< Ramp length in samples */
+    fade_shape_t shape;                     /**< Shape it was built with */
+    int16_t table[FADE_ENV_MAX_LEN + 1];    /**< table[0] = 0 ... table[len] = FADE_ENV_FULL */
+} fade_env_t;
+
+/**
+ * @brief Build a table (integer only, O(len))
+ *
+ * @param env Table to fill
+ * @param shape Ramp shape
+ * @param len Ramp length in samples, clamped to [1, FADE_ENV_MAX_LEN]
+ */
+void fade_env_build(fade_env_t *env, fade_shape_t shape, uint16_t len);
+
+/**
+ * @brief Envelope k samples into a rising ramp (k <= len)
+ */
+static inline int32_t fade_env_at(const fade_env_t *env, uint32_t k) {
+    return env->table[k];
+}
+
+/**
+ * @brief Get shape name ("linear", "raised_cosine", "blackman_harris")
+ */
+const char *fade_shape_str(fade_shape_t shape);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_FADE_ENV_H */
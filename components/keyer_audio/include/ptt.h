@@ -3,6 +3,9 @@
  * @brief PTT (Push-To-Talk) controller with tail timeout
  *
  * Activates PTT on first key-down, deactivates after silence timeout.
+ *
+ * Keying known ahead of time (text schedules) can raise PTT a lead time
+ * before its first element instead, with ptt_lead().
  */
 
 #ifndef KEYER_PTT_H
@@ -36,6 +39,7 @@ typedef struct {
     ptt_state_t state;       /**< Current PTT state */
     uint64_t tail_us;        /**< Tail timeout in microseconds */
     uint64_t last_audio_us;  /**< Timestamp of last audio activity */
+    uint64_t on_since_us;    /**< When PTT last turned on */
     bool audio_active;       /**< Audio currently active */
     ptt_pa_callback_t pa_callback;  /**< Optional PA control callback */
 } ptt_controller_t;
@@ -58,6 +62,22 @@ void ptt_init(ptt_controller_t *ptt, uint32_t tail_ms);
  */
 void ptt_audio_sample(ptt_controller_t *ptt, uint64_t timestamp_us);
 
+/**
+ * @brief Raise PTT ahead of keying that is known in advance
+ *
+ * Nothing happens until the keying is lead_us away; from then PTT is on
+ * (and held, as by ptt_audio_sample()). The keying must wait while this
+ * returns false, i.e. until PTT has been on for the lead.
+ *
+ * @param ptt Controller
+ * @param timestamp_us Current timestamp in microseconds
+ * @param until_us Time until the first key-down (UINT32_MAX = none)
+ * @param lead_us Time PTT must be on before it
+ * @return true if the keying may go ahead on this tick
+ */
+bool ptt_lead(ptt_controller_t *ptt, uint64_t timestamp_us,
+              uint32_t until_us, uint32_t lead_us);
+
 /**
  * @brief Tick PTT controller
  *
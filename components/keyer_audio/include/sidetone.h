@@ -2,8 +2,16 @@
  * @file sidetone.h
  * @brief Sidetone generator with phase accumulator and fade envelope
  *
- * Uses 256-entry sine lookup table for efficient tone generation.
- * Implements digital fade envelope to eliminate key clicks.
+ * 32-bit phase accumulator over a 256-entry sine lookup table, linearly
+ * interpolated, at any sample rate (8, 16, 48 kHz: audio.sample_rate).
+ * Implements digital fade envelope to eliminate key clicks: a linear
+ * ramp by default, or any shape from a precomputed fade_env_t table
+ * (sidetone_set_envelope).
+ *
+ * sidetone_render() produces whole blocks: the block is split at fade
+ * state boundaries and each run (silence, ramp, sustain) is a tight loop
+ * with no per-sample state switch or division. Output is sample-exact
+ * with repeated sidetone_next_sample() calls scaled by the same gain.
  */
 
 #ifndef KEYER_SIDETONE_H
@@ -11,6 +19,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "fade_env.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +36,40 @@ extern "C" {
 /** Pre-computed 256-entry sine LUT (signed 16-bit, full scale) */
 extern const int16_t SINE_LUT[SINE_LUT_SIZE];
 
+/**
+ * @brief Sine at a 32-bit phase (2^32 = one turn), full scale
+ *
+ * The top 8 phase bits pick the LUT entry, the next 16 interpolate
+ * linearly to the following one.
+ */
+static inline int32_t sidetone_sine(uint32_t phase) {
+    uint32_t idx = phase >> 24;
+    int32_t a = SINE_LUT[idx];
+    int32_t b = SINE_LUT[(idx + 1U) & (SINE_LUT_SIZE - 1U)];
+    int32_t frac = (int32_t)((phase >> 8) & 0xFFFFU);
+    return a + (((b - a) * frac) >> 16);
+}
+
+/* ============================================================================
+ * Output Gain
+ * ============================================================================ */
+
+/** Q15 gain of 1.0 (output equals the unscaled generator sample) */
+#define SIDETONE_GAIN_UNITY 32768U
+
+/**
+ * @brief Convert a volume percentage (0-100) to Q15 gain
+ *
+ * @param pct Volume in percent, values above 100 are clamped
+ * @return Q15 gain for sidetone_render()
+ */
+static inline uint16_t sidetone_gain_from_pct(uint8_t pct) {
+    if (pct > 100) {
+        pct = 100;
+    }
+    return (uint16_t)(((uint32_t)pct * SIDETONE_GAIN_UNITY) / 100U);
+}
+
 /* ============================================================================
  * Fade Envelope
  * ============================================================================ */
@@ -47,7 +91,7 @@ typedef enum {
 /**
  * @brief Sidetone generator
  *
- * Uses phase accumulator with 256-entry sine LUT.
+ * Uses phase accumulator with interpolated 256-entry sine LUT.
  * Digital fade envelope eliminates key clicks.
  */
 typedef struct {
@@ -57,6 +101,7 @@ typedef struct {
     uint16_t fade_pos;     /**< Current position in fade ramp */
     uint16_t fade_len;     /**< Fade ramp length in samples */
     uint32_t sample_rate;  /**< Sample rate in Hz */
+    const fade_env_t *env; /**< Ramp table, NULL = linear computed ramp */
 } sidetone_gen_t;
 
 /**
@@ -64,12 +109,23 @@ typedef struct {
  *
  * @param gen Generator to initialize
  * @param freq_hz Tone frequency in Hz
- * @param sample_rate Sample rate in Hz (typically 8000)
+ * @param sample_rate Sample rate in Hz (8000, 16000 or 48000)
  * @param fade_samples Fade ramp length in samples
  */
 void sidetone_init(sidetone_gen_t *gen, uint32_t freq_hz, uint32_t sample_rate,
                    uint16_t fade_samples);
 
+/**
+ * @brief Shape the fade ramp with a precomputed table
+ *
+ * The ramp length becomes env->len. The table must outlive the generator
+ * and may be shared with other generators.
+ *
+ * @param gen Generator
+ * @param env Envelope table, NULL for the linear computed ramp
+ */
+void sidetone_set_envelope(sidetone_gen_t *gen, const fade_env_t *env);
+
 /**
  * @brief Generate next audio sample
  *
@@ -79,6 +135,36 @@ void sidetone_init(sidetone_gen_t *gen, uint32_t freq_hz, uint32_t sample_rate,
  */
 int16_t sidetone_next_sample(sidetone_gen_t *gen, bool key_down);
 
+/**
+ * @brief Render a block of mono samples
+ *
+ * Equivalent to n calls of sidetone_next_sample() with the result scaled
+ * by gain_q15 / 32768, but processed in runs split at fade boundaries.
+ *
+ * @param gen Generator
+ * @param out Output buffer (n samples)
+ * @param n Number of samples
+ * @param key_down true if key is pressed (constant for the block)
+ * @param gain_q15 Output gain, SIDETONE_GAIN_UNITY = 1.0
+ */
+void sidetone_render(sidetone_gen_t *gen, int16_t *out, size_t n,
+                     bool key_down, uint16_t gain_q15);
+
+/**
+ * @brief Render a block as interleaved stereo (L = R)
+ *
+ * Same as sidetone_render() but writes each sample to both channels,
+ * so a stereo I2S/codec path needs no separate duplication pass.
+ *
+ * @param gen Generator
+ * @param out Output buffer (2 * n_frames samples)
+ * @param n_frames Number of stereo frames
+ * @param key_down true if key is pressed (constant for the block)
+ * @param gain_q15 Output gain, SIDETONE_GAIN_UNITY = 1.0
+ */
+void sidetone_render_stereo(sidetone_gen_t *gen, int16_t *out, size_t n_frames,
+                            bool key_down, uint16_t gain_q15);
+
 /**
  * @brief Set tone frequency
  *
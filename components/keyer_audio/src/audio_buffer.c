@@ -56,6 +56,122 @@ bool audio_buffer_pop(audio_ring_buffer_t *buf, int16_t *out) {
     return true;
 }
 
+/** Split n slots starting at index into the run up to the wrap and the rest */
+static inline void split(const audio_ring_buffer_t *buf, size_t index, size_t n,
+                         size_t *first, size_t *second) {
+    size_t slot = index & buf->mask;
+    size_t to_end = buf->capacity - slot;
+    *first = (n < to_end) ? n : to_end;
+    *second = n - *first;
+}
+
+size_t audio_buffer_write(audio_ring_buffer_t *buf, const int16_t *samples, size_t count) {
+    assert(buf != NULL);
+    assert(samples != NULL || count == 0);
+
+    int16_t *a;
+    int16_t *b;
+    size_t na;
+    size_t nb;
+    size_t n = audio_buffer_write_acquire(buf, &a, &na, &b, &nb, count);
+
+    for (size_t i = 0; i < na; i++) {
+        a[i] = samples[i];
+    }
+    for (size_t i = 0; i < nb; i++) {
+        b[i] = samples[na + i];
+    }
+
+    audio_buffer_write_commit(buf, n);
+    return n;
+}
+
+size_t audio_buffer_read(audio_ring_buffer_t *buf, int16_t *out, size_t count) {
+    assert(buf != NULL);
+    assert(out != NULL || count == 0);
+
+    const int16_t *a;
+    const int16_t *b;
+    size_t na;
+    size_t nb;
+    size_t n = audio_buffer_read_acquire(buf, &a, &na, &b, &nb, count);
+
+    for (size_t i = 0; i < na; i++) {
+        out[i] = a[i];
+    }
+    for (size_t i = 0; i < nb; i++) {
+        out[na + i] = b[i];
+    }
+
+    audio_buffer_read_commit(buf, n);
+    return n;
+}
+
+size_t audio_buffer_write_acquire(audio_ring_buffer_t *buf,
+                                  int16_t **a, size_t *na,
+                                  int16_t **b, size_t *nb,
+                                  size_t max) {
+    assert(buf != NULL);
+    assert(a != NULL && na != NULL && b != NULL && nb != NULL);
+
+    size_t write = atomic_load_explicit(&buf->write_idx, memory_order_relaxed);
+    size_t read = atomic_load_explicit(&buf->read_idx, memory_order_acquire);
+
+    size_t space = buf->capacity - (write - read);
+    size_t n = (max < space) ? max : space;
+
+    split(buf, write, n, na, nb);
+    *a = &buf->buffer[write & buf->mask];
+    *b = buf->buffer;
+    return n;
+}
+
+void audio_buffer_write_commit(audio_ring_buffer_t *buf, size_t n) {
+    assert(buf != NULL);
+
+    size_t write = atomic_load_explicit(&buf->write_idx, memory_order_relaxed);
+    atomic_store_explicit(&buf->write_idx, write + n, memory_order_release);
+}
+
+size_t audio_buffer_read_acquire(audio_ring_buffer_t *buf,
+                                 const int16_t **a, size_t *na,
+                                 const int16_t **b, size_t *nb,
+                                 size_t max) {
+    assert(buf != NULL);
+    assert(a != NULL && na != NULL && b != NULL && nb != NULL);
+
+    size_t read = atomic_load_explicit(&buf->read_idx, memory_order_relaxed);
+    size_t write = atomic_load_explicit(&buf->write_idx, memory_order_acquire);
+
+    size_t avail = write - read;
+    size_t n = (max < avail) ? max : avail;
+
+    split(buf, read, n, na, nb);
+    *a = &buf->buffer[read & buf->mask];
+    *b = buf->buffer;
+    return n;
+}
+
+void audio_buffer_read_commit(audio_ring_buffer_t *buf, size_t n) {
+    assert(buf != NULL);
+
+    size_t read = atomic_load_explicit(&buf->read_idx, memory_order_relaxed);
+    atomic_store_explicit(&buf->read_idx, read + n, memory_order_release);
+}
+
+size_t audio_buffer_discard(audio_ring_buffer_t *buf, size_t count) {
+    assert(buf != NULL);
+
+    size_t read = atomic_load_explicit(&buf->read_idx, memory_order_relaxed);
+    size_t write = atomic_load_explicit(&buf->write_idx, memory_order_acquire);
+
+    size_t avail = write - read;
+    size_t n = (count < avail) ? count : avail;
+
+    atomic_store_explicit(&buf->read_idx, read + n, memory_order_release);
+    return n;
+}
+
 size_t audio_buffer_len(const audio_ring_buffer_t *buf) {
     assert(buf != NULL);
 
@@ -0,0 +1,149 @@
+/**
+ * @file audio_playout.c
+ * @brief Fixed-latency playout of streamed audio
+ */
+
+#include "audio_playout.h"
+#include <assert.h>
+
+/* Upsampling: ring samples copied out per read (stack buffer) */
+#define PLAYOUT_CHUNK 32
+
+void audio_playout_init(audio_playout_t *p, audio_ring_buffer_t *ring,
+                        size_t target, size_t max_level) {
+    assert(p != NULL);
+    assert(ring != NULL);
+    assert(max_level > target);
+
+    p->ring = ring;
+    p->target = target;
+    p->max_level = max_level;
+    p->playing = false;
+    p->gain_q15 = 0;
+    p->up_factor = 1;
+    p->up_phase = 0;
+    p->up_prev = 0;
+    p->up_cur = 0;
+    p->underruns = 0;
+    p->trimmed = 0;
+    p->level = 0;
+}
+
+static inline int16_t sat16(int32_t v) {
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+void audio_playout_set_upsample(audio_playout_t *p, uint8_t factor) {
+    assert(p != NULL);
+
+    p->up_factor = (factor > 0) ? factor : 1U;
+    p->up_phase = 0;
+}
+
+/* Slew the gain so volume and ducking changes do not click */
+static inline void slew_gain(audio_playout_t *p, uint16_t gain_q15) {
+    if (p->gain_q15 < gain_q15) {
+        uint32_t g = (uint32_t)p->gain_q15 + AUDIO_PLAYOUT_GAIN_SLEW;
+        p->gain_q15 = (uint16_t)((g < gain_q15) ? g : gain_q15);
+    } else if (p->gain_q15 > gain_q15) {
+        p->gain_q15 = ((uint32_t)(p->gain_q15 - gain_q15) > AUDIO_PLAYOUT_GAIN_SLEW)
+                          ? (uint16_t)(p->gain_q15 - AUDIO_PLAYOUT_GAIN_SLEW)
+                          : gain_q15;
+    }
+}
+
+/* Ran dry: wait for a full target again, fade back in */
+static inline void underrun(audio_playout_t *p) {
+    p->playing = false;
+    p->gain_q15 = 0;
+    p->underruns++;
+}
+
+/*
+ * factor > 1: output k of each run is up_prev + (up_cur - up_prev) * k /
+ * factor, so the ring plays one sample late and a new one is read exactly
+ * when up_phase wraps (never ahead of the block: the rest stays in the ring)
+ */
+static size_t mix_upsampled(audio_playout_t *p, int16_t *out, size_t n, uint16_t gain_q15) {
+    const uint32_t f = p->up_factor;
+    int16_t chunk[PLAYOUT_CHUNK];
+    size_t have = 0;
+    size_t used = 0;
+    size_t done = 0;
+
+    while (done < n) {
+        if (p->up_phase == 0) {
+            if (used == have) {
+                size_t want = (n - done + f - 1U) / f;
+                if (want > PLAYOUT_CHUNK) {
+                    want = PLAYOUT_CHUNK;
+                }
+                have = audio_buffer_read(p->ring, chunk, want);
+                used = 0;
+                if (have == 0) {
+                    underrun(p);
+                    break;
+                }
+            }
+            p->up_prev = p->up_cur;
+            p->up_cur = chunk[used++];
+            slew_gain(p, gain_q15);
+        }
+        int32_t d = (int32_t)p->up_cur - (int32_t)p->up_prev;
+        int32_t v = (int32_t)p->up_prev + (d * (int32_t)p->up_phase) / (int32_t)f;
+        int32_t s = (v * (int32_t)p->gain_q15) >> 15;
+        out[done] = sat16((int32_t)out[done] + s);
+        done++;
+        p->up_phase = (uint8_t)((p->up_phase + 1U == f) ? 0U : p->up_phase + 1U);
+    }
+    return done;
+}
+
+size_t audio_playout_mix(audio_playout_t *p, int16_t *out, size_t n, uint16_t gain_q15) {
+    assert(p != NULL);
+    assert(out != NULL || n == 0);
+
+    size_t level = audio_buffer_len(p->ring);
+    if (!p->playing) {
+        if (level < p->target) {
+            p->level = (uint32_t)level;
+            return 0;
+        }
+        p->playing = true;
+    } else if (level > p->max_level) {
+        p->trimmed += (uint32_t)audio_buffer_discard(p->ring, level - p->target);
+    }
+
+    size_t done = 0;
+    if (p->up_factor > 1) {
+        done = mix_upsampled(p, out, n, gain_q15);
+        p->level = (uint32_t)audio_buffer_len(p->ring);
+        return done;
+    }
+
+    /* Mixed straight from the ring storage, released in one commit */
+    const int16_t *span[2];
+    size_t len[2];
+    done = audio_buffer_read_acquire(p->ring, &span[0], &len[0], &span[1], &len[1], n);
+    for (size_t k = 0, o = 0; k < 2; k++) {
+        for (size_t i = 0; i < len[k]; i++, o++) {
+            slew_gain(p, gain_q15);
+            int32_t s = ((int32_t)span[k][i] * (int32_t)p->gain_q15) >> 15;
+            out[o] = sat16((int32_t)out[o] + s);
+        }
+    }
+    audio_buffer_read_commit(p->ring, done);
+
+    if (done < n) {
+        underrun(p);
+    }
+
+    p->level = (uint32_t)audio_buffer_len(p->ring);
+    return done;
+}
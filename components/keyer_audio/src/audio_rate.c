@@ -0,0 +1,37 @@
+/**
+ * @file audio_rate.c
+ * @brief Codec sample rate selection and decimation to 8 kHz
+ */
+
+#include "audio_rate.h"
+#include <assert.h>
+
+uint32_t audio_rate_from_index(unsigned index) {
+    static const uint32_t rates[] = { 8000U, 16000U, 48000U };
+    return (index < sizeof(rates) / sizeof(rates[0])) ? rates[index] : AUDIO_STREAM_RATE_HZ;
+}
+
+void audio_decimator_init(audio_decimator_t *d, uint32_t factor) {
+    assert(d != NULL);
+
+    d->factor = (factor > 0) ? factor : 1U;
+    d->phase = 0;
+    d->acc = 0;
+}
+
+size_t audio_decimate(audio_decimator_t *d, const int16_t *in, size_t n, int16_t *out) {
+    assert(d != NULL);
+    assert((in != NULL && out != NULL) || n == 0);
+
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        /* Read before a possible aliased write: m <= i always */
+        d->acc += in[i];
+        if (++d->phase == d->factor) {
+            out[m++] = (int16_t)(d->acc / (int32_t)d->factor);
+            d->phase = 0;
+            d->acc = 0;
+        }
+    }
+    return m;
+}
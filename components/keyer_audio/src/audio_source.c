@@ -4,6 +4,7 @@
  */
 
 #include "audio_source.h"
+#include <stddef.h>
 #include <assert.h>
 
 void audio_source_init(audio_source_selector_t *sel) {
@@ -38,3 +39,16 @@ audio_source_t audio_source_update(audio_source_selector_t *sel) {
 
     return sel->current;
 }
+
+uint16_t audio_source_rig_gain(const audio_source_selector_t *sel, uint16_t gain_q15,
+                               uint8_t duck_pct) {
+    assert(sel != NULL);
+
+    if (sel->current == AUDIO_SOURCE_NONE) {
+        return gain_q15;
+    }
+    if (duck_pct > 100) {
+        duck_pct = 100;
+    }
+    return (uint16_t)(((uint32_t)gain_q15 * duck_pct) / 100U);
+}
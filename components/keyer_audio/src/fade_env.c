@@ -0,0 +1,79 @@
+/**
+ * @file fade_env.c
+ * @brief Keying envelope table generation
+ *
+ * Integer only (cosines from the sine LUT), so a table can be rebuilt from
+ * the RT task as well as at start-up.
+ */
+
+#include "fade_env.h"
+#include "sidetone.h"
+#include <assert.h>
+#include <stddef.h>
+
+/*
+ * 4-term Blackman-Harris (a0..a3 = 0.35875, 0.48829, 0.14128, 0.01168),
+ * offset and scaled so the ramp runs exactly from 0 to 1:
+ *   env(x) = B0 - B1 cos(pi x) + B2 cos(2 pi x) - B3 cos(3 pi x)
+ * in Q15; B0 + B1 + B2 + B3 = 1 and B0 - B1 + B2 - B3 = 0.
+ */
+#define BH_B0 11754
+#define BH_B1 16001
+#define BH_B2 4630
+#define BH_B3 383
+
+/** cos(pi * m * k / len), full scale */
+static int32_t cos_pi(uint32_t m, uint32_t k, uint32_t len) {
+    uint32_t phase = (uint32_t)((((uint64_t)m * k) << 31) / len);
+    return sidetone_sine(phase + 0x40000000U);
+}
+
+static int32_t shape_at(fade_shape_t shape, uint32_t k, uint32_t len) {
+    switch (shape) {
+        case FADE_SHAPE_RAISED_COSINE:
+            return (FADE_ENV_FULL - cos_pi(1, k, len)) / 2;
+        case FADE_SHAPE_BLACKMAN_HARRIS:
+            return (BH_B0 * FADE_ENV_FULL - BH_B1 * cos_pi(1, k, len) +
+                    BH_B2 * cos_pi(2, k, len) - BH_B3 * cos_pi(3, k, len)) >> 15;
+        case FADE_SHAPE_LINEAR:
+        default:
+            /* Same division as the computed ramp, so it matches sample for sample */
+            return ((int32_t)k * FADE_ENV_FULL) / (int32_t)len;
+    }
+}
+
+void fade_env_build(fade_env_t *env, fade_shape_t shape, uint16_t len) {
+    assert(env != NULL);
+
+    if (len < 1U) {
+        len = 1U;
+    }
+    if (len > FADE_ENV_MAX_LEN) {
+        len = (uint16_t)FADE_ENV_MAX_LEN;
+    }
+    env->len = len;
+    env->shape = shape;
+
+    /* LUT interpolation error is a few LSB: keep the ramp monotonic */
+    int32_t prev = 0;
+    for (uint32_t k = 0; k <= len; k++) {
+        int32_t v = shape_at(shape, k, len);
+        if (v < prev) {
+            v = prev;
+        }
+        if (v > FADE_ENV_FULL) {
+            v = FADE_ENV_FULL;
+        }
+        env->table[k] = (int16_t)v;
+        prev = v;
+    }
+}
+
+const char *fade_shape_str(fade_shape_t shape) {
+    switch (shape) {
+        case FADE_SHAPE_LINEAR:          return "linear";
+        case FADE_SHAPE_RAISED_COSINE:   return "raised_cosine";
+        case FADE_SHAPE_BLACKMAN_HARRIS: return "blackman_harris";
+        default:                         return "?";
+    }
+}
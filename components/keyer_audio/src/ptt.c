@@ -13,6 +13,7 @@ void ptt_init(ptt_controller_t *ptt, uint32_t tail_ms) {
     ptt->state = PTT_OFF;
     ptt->tail_us = (uint64_t)tail_ms * 1000;
     ptt->last_audio_us = 0;
+    ptt->on_since_us = 0;
     ptt->audio_active = false;
     ptt->pa_callback = NULL;
 }
@@ -26,12 +27,24 @@ void ptt_audio_sample(ptt_controller_t *ptt, uint64_t timestamp_us) {
     /* Turn on PTT immediately on audio */
     if (ptt->state == PTT_OFF) {
         ptt->state = PTT_ON;
+        ptt->on_since_us = timestamp_us;
         if (ptt->pa_callback != NULL) {
             ptt->pa_callback(true);
         }
     }
 }
 
+bool ptt_lead(ptt_controller_t *ptt, uint64_t timestamp_us,
+              uint32_t until_us, uint32_t lead_us) {
+    assert(ptt != NULL);
+
+    if (until_us > lead_us) {
+        return true;  /* Further away than the lead: nothing to raise yet */
+    }
+    ptt_audio_sample(ptt, timestamp_us);
+    return timestamp_us - ptt->on_since_us + until_us >= lead_us;
+}
+
 void ptt_tick(ptt_controller_t *ptt, uint64_t timestamp_us) {
     assert(ptt != NULL);
 
@@ -2,18 +2,26 @@
  * @file sidetone.c
  * @brief Sidetone generator implementation
  *
- * Phase accumulator with 256-entry sine LUT.
- * Digital fade envelope eliminates key clicks.
+ * 32-bit phase accumulator (DDS) with a 256-entry sine LUT read with
+ * linear interpolation: the top 8 phase bits pick the entry, the next 16
+ * weight the step to the following one. Truncating to the entry alone
+ * puts phase-noise spurs around -48 dBc at pitches that do not divide the
+ * sample rate evenly; interpolated they sit near the 16-bit noise floor.
+ * Digital fade envelope eliminates key clicks. With a fade_env_t table the
+ * ramp costs one table read per sample; without one it is linear.
+ *
+ * Block renderer:
+ * Steady runs (silence, fade ramp, sustain) are rendered in tight loops.
+ * A table ramp is indexed directly; the linear ramp pos * 32767 / len is
+ * stepped incrementally as quotient + remainder, so it stays exactly equal
+ * to the per-sample division without dividing per sample. State transition samples go
+ * through sidetone_next_sample() so both paths share one state machine.
  */
 
 #include "sidetone.h"
 #include <assert.h>
 #include <stddef.h>
 
-/* Phase accumulator uses upper 8 bits for LUT index */
-#define PHASE_SHIFT 24
-#define PHASE_MASK  0xFF000000U
-
 void sidetone_init(sidetone_gen_t *gen, uint32_t freq_hz, uint32_t sample_rate,
                    uint16_t fade_samples) {
     assert(gen != NULL);
@@ -25,11 +33,24 @@ void sidetone_init(sidetone_gen_t *gen, uint32_t freq_hz, uint32_t sample_rate,
     gen->fade_state = FADE_SILENT;
     gen->fade_pos = 0;
     gen->fade_len = fade_samples;
+    gen->env = NULL;
 
     /* Calculate phase increment: (freq * 2^32) / sample_rate */
     gen->phase_inc = (uint32_t)(((uint64_t)freq_hz << 32) / sample_rate);
 }
 
+void sidetone_set_envelope(sidetone_gen_t *gen, const fade_env_t *env) {
+    assert(gen != NULL);
+
+    gen->env = env;
+    if (env != NULL) {
+        gen->fade_len = env->len;
+        if (gen->fade_pos > gen->fade_len) {
+            gen->fade_pos = gen->fade_len;
+        }
+    }
+}
+
 void sidetone_set_frequency(sidetone_gen_t *gen, uint32_t freq_hz) {
     assert(gen != NULL);
 
@@ -96,8 +117,7 @@ int16_t sidetone_next_sample(sidetone_gen_t *gen, bool key_down) {
     }
 
     /* Get sine sample from LUT */
-    uint8_t lut_idx = (uint8_t)(gen->phase >> PHASE_SHIFT);
-    int32_t raw_sample = SINE_LUT[lut_idx];
+    int32_t raw_sample = sidetone_sine(gen->phase);
 
     /* Advance phase */
     gen->phase += gen->phase_inc;
@@ -106,13 +126,17 @@ int16_t sidetone_next_sample(sidetone_gen_t *gen, bool key_down) {
     int32_t envelope;
     switch (gen->fade_state) {
         case FADE_IN:
-            /* Linear ramp up */
-            envelope = ((int32_t)gen->fade_pos * 32767) / gen->fade_len;
+            /* Ramp up */
+            envelope = (gen->env != NULL)
+                       ? fade_env_at(gen->env, gen->fade_pos)
+                       : ((int32_t)gen->fade_pos * 32767) / gen->fade_len;
             break;
 
         case FADE_OUT:
-            /* Linear ramp down */
-            envelope = ((int32_t)(gen->fade_len - gen->fade_pos) * 32767) / gen->fade_len;
+            /* Ramp down */
+            envelope = (gen->env != NULL)
+                       ? fade_env_at(gen->env, (uint32_t)(gen->fade_len - gen->fade_pos))
+                       : ((int32_t)(gen->fade_len - gen->fade_pos) * 32767) / gen->fade_len;
             break;
 
         case FADE_SUSTAIN:
@@ -130,3 +154,148 @@ int16_t sidetone_next_sample(sidetone_gen_t *gen, bool key_down) {
 
     return (int16_t)sample;
 }
+
+/* ============================================================================
+ * Block Renderer
+ * ============================================================================ */
+
+/** Scale generator sample by Q15 gain */
+static inline int16_t apply_gain(int32_t sample, uint32_t gain_q15) {
+    return (int16_t)((sample * (int32_t)gain_q15) >> 15);
+}
+
+/** Store one sample to 1 or 2 interleaved channels */
+static inline void store(int16_t *out, size_t i, size_t channels, int16_t v) {
+    out[i * channels] = v;
+    if (channels == 2) {
+        out[i * channels + 1] = v;
+    }
+}
+
+/**
+ * @brief Fade ramp run (FADE_IN with key down or FADE_OUT with key up)
+ *
+ * Renders m samples, pos advancing by one each; envelope rises for FADE_IN
+ * (k = pos) and falls for FADE_OUT (k = len - pos).
+ */
+static void render_ramp_table(sidetone_gen_t *gen, int16_t *out, size_t m, size_t channels,
+                              uint32_t gain_q15, bool rising) {
+    const int16_t *table = gen->env->table;
+    const uint32_t len = gen->fade_len;
+    uint32_t pos = gen->fade_pos;
+
+    uint32_t phase = gen->phase;
+    const uint32_t inc = gen->phase_inc;
+
+    for (size_t i = 0; i < m; i++) {
+        pos++;
+        int32_t k = table[rising ? pos : len - pos];
+        int32_t raw = sidetone_sine(phase);
+        phase += inc;
+        store(out, i, channels, apply_gain((raw * k) >> 15, gain_q15));
+    }
+
+    gen->phase = phase;
+    gen->fade_pos = (uint16_t)pos;
+}
+
+static void render_ramp(sidetone_gen_t *gen, int16_t *out, size_t m, size_t channels,
+                        uint32_t gain_q15, bool rising) {
+    if (gen->env != NULL) {
+        render_ramp_table(gen, out, m, channels, gain_q15, rising);
+        return;
+    }
+
+    const int32_t len = (int32_t)gen->fade_len;
+    const int32_t q_step = 32767 / len;
+    const int32_t r_step = 32767 % len;
+
+    int32_t k = rising ? (int32_t)gen->fade_pos : (len - (int32_t)gen->fade_pos);
+    int32_t q = (k * 32767) / len;
+    int32_t r = (k * 32767) % len;
+
+    uint32_t phase = gen->phase;
+    const uint32_t inc = gen->phase_inc;
+
+    for (size_t i = 0; i < m; i++) {
+        if (rising) {
+            q += q_step;
+            r += r_step;
+            if (r >= len) { q++; r -= len; }
+        } else {
+            q -= q_step;
+            r -= r_step;
+            if (r < 0) { q--; r += len; }
+        }
+        int32_t raw = sidetone_sine(phase);
+        phase += inc;
+        store(out, i, channels, apply_gain((raw * q) >> 15, gain_q15));
+    }
+
+    gen->phase = phase;
+    gen->fade_pos = (uint16_t)(gen->fade_pos + m);
+}
+
+/** Sustain run: full envelope */
+static void render_sustain(sidetone_gen_t *gen, int16_t *out, size_t m, size_t channels,
+                           uint32_t gain_q15) {
+    uint32_t phase = gen->phase;
+    const uint32_t inc = gen->phase_inc;
+
+    for (size_t i = 0; i < m; i++) {
+        int32_t raw = sidetone_sine(phase);
+        phase += inc;
+        store(out, i, channels, apply_gain((raw * 32767) >> 15, gain_q15));
+    }
+
+    gen->phase = phase;
+}
+
+static void render(sidetone_gen_t *gen, int16_t *out, size_t n, size_t channels,
+                   bool key_down, uint16_t gain) {
+    assert(gen != NULL);
+    assert(out != NULL || n == 0);
+
+    const uint32_t gain_q15 = gain;
+    size_t done = 0;
+
+    while (done < n) {
+        int16_t *dst = &out[done * channels];
+        size_t left = n - done;
+        size_t ramp_left = (gen->fade_pos < gen->fade_len)
+                           ? (size_t)(gen->fade_len - gen->fade_pos) : 0;
+
+        if (gen->fade_state == FADE_SILENT && !key_down) {
+            for (size_t i = 0; i < left * channels; i++) {
+                dst[i] = 0;
+            }
+            return;
+        }
+        if (gen->fade_state == FADE_SUSTAIN && key_down) {
+            render_sustain(gen, dst, left, channels, gain_q15);
+            return;
+        }
+        if (ramp_left > 0 &&
+            ((gen->fade_state == FADE_IN && key_down) ||
+             (gen->fade_state == FADE_OUT && !key_down))) {
+            size_t m = (left < ramp_left) ? left : ramp_left;
+            render_ramp(gen, dst, m, channels, gain_q15, gen->fade_state == FADE_IN);
+            done += m;
+            continue;
+        }
+
+        /* State transition sample: reuse the per-sample state machine */
+        store(dst, 0, channels, apply_gain(sidetone_next_sample(gen, key_down), gain_q15));
+        done++;
+    }
+}
+
+void sidetone_render(sidetone_gen_t *gen, int16_t *out, size_t n,
+                     bool key_down, uint16_t gain_q15) {
+    render(gen, out, n, 1, key_down, gain_q15);
+}
+
+void sidetone_render_stereo(sidetone_gen_t *gen, int16_t *out, size_t n_frames,
+                            bool key_down, uint16_t gain_q15) {
+    render(gen, out, n_frames, 2, key_down, gain_q15);
+}
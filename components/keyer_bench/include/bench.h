@@ -0,0 +1,126 @@
+/**
+ * @file bench.h
+ * @brief On-target microbenchmarks of the hot kernels
+ *
+ * The target counterpart of test_host/bench/bench_host.c: the same
+ * kernels (stream push and consumers, iambic_tick, sidetone, CWNet frame
+ * parsing, WireGuard crypto, LED frames) timed with the CPU cycle counter
+ * on the real chip, so boards, clock settings, PSRAM placement and
+ * firmware versions can be compared ("bench" on the console, GET
+ * /api/bench).
+ *
+ * Each kernel runs BENCH_REPS times and reports the fastest run. The
+ * caller's task does the work, preempted by whatever runs above it, with
+ * the RT task busy on Core 0 as in normal use: the figures are what the
+ * firmware actually gets, not a quiet-machine best.
+ *
+ * Components that cannot be reached from here (keyer_webui's JSON writer
+ * sits above this component) add their kernels with bench_register().
+ *
+ * Output JSON (schema as bench_host, plus the board and build profile,
+ * see profiles/README.md):
+ *   {"schema":1,"target":"esp32s3","cpu_mhz":240,"version":"...","idf":"...","psram":true,
+ *    "opt":"Os","hot_opt":"O2","lto":false,"rt_iram":true,
+ *    "kernels":[{"name":"...","ops":N,"cycles_per_op":12.34,"ns_per_op":51.42},...]}
+ */
+
+#ifndef KEYER_BENCH_H
+#define KEYER_BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Runs per kernel, fastest kept */
+#define BENCH_REPS 3
+
+/** Results one run can return */
+#define BENCH_MAX_RESULTS 40
+
+/** Kernel groups bench_register() accepts */
+#define BENCH_MAX_GROUPS 4
+
+/** Kernel return value: not available on this board (e.g. no PSRAM) */
+#define BENCH_SKIPPED UINT32_MAX
+
+/**
+ * @brief Kernel: run ops operations, return the cycles they took
+ *
+ * Setup (buffers, filling a ring) stays outside the timed part; time it
+ * with bench_cycles().
+ */
+typedef uint32_t (*bench_fn_t)(uint32_t ops, uint32_t arg);
+
+/**
+ * @brief Kernel descriptor (static)
+ */
+typedef struct {
+    const char *name;
+    bench_fn_t fn;
+    uint32_t ops;        /**< Operations per run */
+    uint32_t arg;        /**< Passed to fn */
+} bench_kernel_t;
+
+/**
+ * @brief One measured kernel
+ */
+typedef struct {
+    const char *name;
+    uint32_t ops;
+    uint32_t cycles;     /**< Fastest run */
+} bench_result_t;
+
+/**
+ * @brief CPU cycle counter (wraps every 2^32 cycles, ~17 s at 240 MHz)
+ */
+uint32_t bench_cycles(void);
+
+/**
+ * @brief Add a group of kernels (static table, kept by pointer)
+ *
+ * @return false if BENCH_MAX_GROUPS are already registered
+ */
+bool bench_register(const bench_kernel_t *kernels, size_t count);
+
+/**
+ * @brief Run kernels
+ *
+ * @param filter Name prefix ("wg_", "stream") or NULL for all
+ * @param out Results, in table order, skipped kernels left out
+ * @param cap Entries in out
+ * @return Results written, -1 if a run is already in progress
+ */
+int bench_run(const char *filter, bench_result_t *out, size_t cap);
+
+/**
+ * @brief Format results as JSON (see the file comment)
+ *
+ * @return Length written, 0 if it did not fit
+ */
+size_t bench_format_json(const bench_result_t *res, size_t n, char *buf, size_t cap);
+
+/**
+ * @brief Current CPU clock
+ */
+uint32_t bench_cpu_mhz(void);
+
+/**
+ * @brief Cycles and nanoseconds per operation, in hundredths
+ *
+ * @param r Result
+ * @param mhz bench_cpu_mhz()
+ * @param cycles_x100 Cycles per operation x 100
+ * @param ns_x100 Nanoseconds per operation x 100
+ */
+void bench_per_op(const bench_result_t *r, uint32_t mhz, uint64_t *cycles_x100,
+                  uint64_t *ns_x100);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_BENCH_H */
@@ -0,0 +1,186 @@
+/**
+ * @file bench.c
+ * @brief Benchmark driver: kernel groups, best-of runs, JSON
+ */
+
+#include "bench.h"
+#include "bench_kernels.h"
+#include "esp_app_desc.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    const bench_kernel_t *kernels;
+    size_t count;
+} bench_group_t;
+
+/* Group 0 is the built-in table; later ones come from bench_register() */
+static bench_group_t s_groups[1 + BENCH_MAX_GROUPS];
+static atomic_size_t s_group_count;
+
+/* The kernels share static buffers: one run at a time */
+static atomic_bool s_running;
+
+uint32_t bench_cycles(void) {
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+bool bench_register(const bench_kernel_t *kernels, size_t count) {
+    size_t n = atomic_load_explicit(&s_group_count, memory_order_relaxed);
+    if (n == 0) {
+        n = 1;  /* Slot 0 stays for the built-ins */
+    }
+    for (size_t i = 1; i < n; i++) {
+        if (s_groups[i].kernels == kernels) {
+            return true;
+        }
+    }
+    if (n >= sizeof(s_groups) / sizeof(s_groups[0])) {
+        return false;
+    }
+    s_groups[n].kernels = kernels;
+    s_groups[n].count = count;
+    atomic_store_explicit(&s_group_count, n + 1U, memory_order_release);
+    return true;
+}
+
+static uint32_t best_of(const bench_kernel_t *k) {
+    uint32_t best = BENCH_SKIPPED;
+    for (int r = 0; r < BENCH_REPS; r++) {
+        uint32_t cycles = k->fn(k->ops, k->arg);
+        if (cycles == BENCH_SKIPPED) {
+            return BENCH_SKIPPED;
+        }
+        if (cycles < best) {
+            best = cycles;
+        }
+        /* Let the idle task in (task watchdog) between runs */
+        vTaskDelay(1);
+    }
+    return best;
+}
+
+int bench_run(const char *filter, bench_result_t *out, size_t cap) {
+    if (atomic_exchange_explicit(&s_running, true, memory_order_acquire)) {
+        return -1;
+    }
+
+    s_groups[0].kernels = g_bench_builtin;
+    s_groups[0].count = g_bench_builtin_count;
+    size_t groups = atomic_load_explicit(&s_group_count, memory_order_acquire);
+    if (groups == 0) {
+        groups = 1;
+    }
+
+    size_t flen = (filter != NULL) ? strlen(filter) : 0;
+    size_t n = 0;
+    for (size_t g = 0; g < groups; g++) {
+        for (size_t i = 0; i < s_groups[g].count && n < cap; i++) {
+            const bench_kernel_t *k = &s_groups[g].kernels[i];
+            if (flen > 0 && strncmp(k->name, filter, flen) != 0) {
+                continue;
+            }
+            uint32_t cycles = best_of(k);
+            if (cycles == BENCH_SKIPPED) {
+                continue;
+            }
+            out[n].name = k->name;
+            out[n].ops = k->ops;
+            out[n].cycles = cycles;
+            n++;
+        }
+    }
+
+    atomic_store_explicit(&s_running, false, memory_order_release);
+    return (int)n;
+}
+
+uint32_t bench_cpu_mhz(void) {
+    return esp_rom_get_cpu_ticks_per_us();
+}
+
+void bench_per_op(const bench_result_t *r, uint32_t mhz, uint64_t *cycles_x100,
+                  uint64_t *ns_x100) {
+    uint64_t ops = r->ops ? r->ops : 1U;
+    *cycles_x100 = ((uint64_t)r->cycles * 100U) / ops;
+    *ns_x100 = ((uint64_t)r->cycles * 100000U) / ((uint64_t)(mhz ? mhz : 1U) * ops);
+}
+
+/* Build profile of this image (main/Kconfig.projbuild), for scripts/bench_report.py */
+#if defined(CONFIG_COMPILER_OPTIMIZATION_SIZE)
+#define BENCH_OPT "Os"
+#elif defined(CONFIG_COMPILER_OPTIMIZATION_PERF)
+#define BENCH_OPT "O2"
+#elif defined(CONFIG_COMPILER_OPTIMIZATION_NONE)
+#define BENCH_OPT "O0"
+#else
+#define BENCH_OPT "Og"
+#endif
+
+#if defined(CONFIG_KEYER_HOT_OPT_O2)
+#define BENCH_HOT_OPT "O2"
+#elif defined(CONFIG_KEYER_HOT_OPT_O3)
+#define BENCH_HOT_OPT "O3"
+#else
+#define BENCH_HOT_OPT BENCH_OPT
+#endif
+
+#if defined(CONFIG_KEYER_LTO)
+#define BENCH_LTO "true"
+#else
+#define BENCH_LTO "false"
+#endif
+
+#if defined(CONFIG_KEYER_RT_IRAM)
+#define BENCH_RT_IRAM "true"
+#else
+#define BENCH_RT_IRAM "false"
+#endif
+
+size_t bench_format_json(const bench_result_t *res, size_t n, char *buf, size_t cap) {
+    uint32_t mhz = bench_cpu_mhz();
+    const esp_app_desc_t *app = esp_app_get_description();
+    size_t psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+
+    int len = snprintf(buf, cap,
+                       "{\"schema\":1,\"target\":\"" CONFIG_IDF_TARGET "\",\"cpu_mhz\":%lu,"
+                       "\"version\":\"%s\",\"idf\":\"%s\","
+                       "\"psram\":%s,\"opt\":\"" BENCH_OPT "\",\"hot_opt\":\"" BENCH_HOT_OPT "\","
+                       "\"lto\":" BENCH_LTO ",\"rt_iram\":" BENCH_RT_IRAM ",\"kernels\":[",
+                       (unsigned long)mhz, app->version, esp_get_idf_version(),
+                       psram > 0 ? "true" : "false");
+    if (len < 0 || (size_t)len >= cap) {
+        return 0;
+    }
+    size_t pos = (size_t)len;
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t c;
+        uint64_t ns;
+        bench_per_op(&res[i], mhz, &c, &ns);
+        len = snprintf(&buf[pos], cap - pos,
+                       "%s{\"name\":\"%s\",\"ops\":%lu,\"cycles_per_op\":%llu.%02u,"
+                       "\"ns_per_op\":%llu.%02u}",
+                       i ? "," : "", res[i].name, (unsigned long)res[i].ops,
+                       (unsigned long long)(c / 100U), (unsigned)(c % 100U),
+                       (unsigned long long)(ns / 100U), (unsigned)(ns % 100U));
+        if (len < 0 || (size_t)len >= cap - pos) {
+            return 0;
+        }
+        pos += (size_t)len;
+    }
+
+    if (cap - pos < 3) {
+        return 0;
+    }
+    memcpy(&buf[pos], "]}", 3);
+    return pos + 2U;
+}
@@ -0,0 +1,518 @@
+/**
+ * @file bench_kernels.c
+ * @brief Built-in kernels, after test_host/bench/bench_host.c
+ *
+ * Same workloads as the host benchmarks so the two can be read side by
+ * side; stream kernels run once on internal SRAM and once on PSRAM, the
+ * WireGuard ones on the reference C and the Xtensa backends.
+ */
+
+#include "bench_kernels.h"
+#include "stream.h"
+#include "consumer.h"
+#include "fault.h"
+#include "iambic.h"
+#include "sidetone.h"
+#include "cwnet_frame.h"
+#include "led_anim.h"
+#include "crypto/refc/blake2s.h"
+#include "crypto/refc/chacha20poly1305.h"
+#include "crypto/refc/x25519.h"
+#include "crypto/xtensa/blake2s_xtensa.h"
+#include "crypto/xtensa/chacha20poly1305_xtensa.h"
+#include "crypto/xtensa/x25519_xtensa.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <string.h>
+
+/* Large enough not to sit in the data cache when in PSRAM */
+#define BENCH_RING_CAP   8192U
+
+#define BENCH_SRAM       (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define BENCH_PSRAM      (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+
+/* Sink so the compiler cannot drop kernel results */
+static volatile uint32_t s_sink;
+
+/* ============================================================================
+ * Stream (ring on SRAM or PSRAM, arg = heap caps)
+ * ============================================================================ */
+
+static stream_slot_t *ring_alloc(uint32_t caps) {
+    return heap_caps_malloc(BENCH_RING_CAP * sizeof(stream_slot_t), caps);
+}
+
+/* Fill the whole ring with changing samples (untimed) */
+static void ring_fill(keying_stream_t *stream, stream_slot_t *ring) {
+    stream_init(stream, ring, BENCH_RING_CAP);
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    for (uint32_t i = 0; i < BENCH_RING_CAP; i++) {
+        sample.local_key = (uint8_t)(i & 1U);
+        stream_push_raw(stream, sample);
+    }
+}
+
+static uint32_t k_stream_push(uint32_t ops, uint32_t caps) {
+    stream_slot_t *ring = ring_alloc(caps);
+    if (ring == NULL) {
+        return BENCH_SKIPPED;
+    }
+    keying_stream_t stream;
+    stream_init(&stream, ring, BENCH_RING_CAP);
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    uint32_t acc = 0;
+
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        sample.local_key = (uint8_t)(i & 1U);
+        acc += stream_push(&stream, sample) ? 1U : 0U;
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    heap_caps_free(ring);
+    s_sink = acc;
+    return cycles;
+}
+
+static uint32_t k_consumer_span(uint32_t ops, uint32_t caps) {
+    stream_slot_t *ring = ring_alloc(caps);
+    if (ring == NULL) {
+        return BENCH_SKIPPED;
+    }
+    keying_stream_t stream;
+    stream_consumer_t consumer;
+    uint32_t acc = 0;
+    uint32_t cycles = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_RING_CAP) {
+        ring_fill(&stream, ring);
+        consumer_init_at(&consumer, &stream, 0);
+
+        uint32_t t0 = bench_cycles();
+        const stream_slot_t *a;
+        const stream_slot_t *b;
+        size_t na;
+        size_t nb;
+        while (consumer_next_span(&consumer, &a, &na, &b, &nb, BENCH_RING_CAP) > 0) {
+            for (size_t i = 0; i < na; i++) {
+                acc += a[i].sample.local_key;
+            }
+            for (size_t i = 0; i < nb; i++) {
+                acc += b[i].sample.local_key;
+            }
+            consumer_commit(&consumer, na + nb);
+        }
+        cycles += bench_cycles() - t0;
+    }
+
+    heap_caps_free(ring);
+    s_sink = acc;
+    return cycles;
+}
+
+/* ============================================================================
+ * Cross-core stream (pushes here, a reader polls on the other core;
+ * arg = heap caps of keying_stream_t itself: in PSRAM its fields go
+ * through the data cache, where a line shared with the reader shows)
+ * ============================================================================ */
+
+typedef struct {
+    keying_stream_t *stream;
+    atomic_bool stop;
+    atomic_bool done;
+    uint32_t read;
+} xcore_ctx_t;
+
+static void xcore_reader(void *arg) {
+    xcore_ctx_t *ctx = arg;
+    stream_consumer_t consumer;
+    stream_sample_t out;
+    consumer_init(&consumer, ctx->stream);
+
+    while (!atomic_load_explicit(&ctx->stop, memory_order_acquire)) {
+        while (consumer_next(&consumer, &out)) {
+            ctx->read++;
+        }
+    }
+    atomic_store_explicit(&ctx->done, true, memory_order_release);
+    vTaskDelete(NULL);
+}
+
+static uint32_t k_stream_xcore(uint32_t ops, uint32_t caps) {
+    keying_stream_t *stream = heap_caps_aligned_alloc(STREAM_CACHE_LINE, sizeof(*stream), caps);
+    stream_slot_t *ring = ring_alloc(BENCH_SRAM);
+    if (stream == NULL || ring == NULL) {
+        heap_caps_free(stream);
+        heap_caps_free(ring);
+        return BENCH_SKIPPED;
+    }
+    stream_init(stream, ring, BENCH_RING_CAP);
+
+    xcore_ctx_t ctx = { .stream = stream, .read = 0 };
+    atomic_init(&ctx.stop, false);
+    atomic_init(&ctx.done, false);
+    BaseType_t other = (BaseType_t)(xPortGetCoreID() ^ 1);
+    if (xTaskCreatePinnedToCore(xcore_reader, "bench_rd", 3072, &ctx,
+                                tskIDLE_PRIORITY + 1, NULL, other) != pdPASS) {
+        heap_caps_free(stream);
+        heap_caps_free(ring);
+        return BENCH_SKIPPED;
+    }
+    vTaskDelay(1);  /* Let the reader start polling */
+
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    uint32_t acc = 0;
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        sample.local_key = (uint8_t)(i & 1U);
+        acc += stream_push(stream, sample) ? 1U : 0U;
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    atomic_store_explicit(&ctx.stop, true, memory_order_release);
+    while (!atomic_load_explicit(&ctx.done, memory_order_acquire)) {
+        vTaskDelay(1);
+    }
+    heap_caps_free(stream);
+    heap_caps_free(ring);
+    s_sink = acc + ctx.read;
+    return cycles;
+}
+
+static uint32_t k_hard_rt_tick(uint32_t ops, uint32_t caps) {
+    stream_slot_t *ring = ring_alloc(caps);
+    if (ring == NULL) {
+        return BENCH_SKIPPED;
+    }
+    keying_stream_t stream;
+    hard_rt_consumer_t consumer;
+    fault_state_t fault;
+    stream_sample_t out;
+    uint32_t acc = 0;
+    uint32_t cycles = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_RING_CAP) {
+        ring_fill(&stream, ring);
+        fault_init(&fault);
+        hard_rt_consumer_init(&consumer, &stream, &fault, BENCH_RING_CAP);
+        consumer.read_idx = 0;
+
+        uint32_t t0 = bench_cycles();
+        while (hard_rt_consumer_tick(&consumer, &out) == HARD_RT_OK) {
+            acc += out.local_key;
+        }
+        cycles += bench_cycles() - t0;
+    }
+
+    heap_caps_free(ring);
+    s_sink = acc;
+    return cycles;
+}
+
+/* ============================================================================
+ * Keyer kernels
+ * ============================================================================ */
+
+/* Deterministic paddle pattern: squeezes, single paddles and idle gaps */
+static gpio_state_t paddle_pattern(uint32_t tick) {
+    switch ((tick / 700U) % 6U) {
+        case 0:  return GPIO_BOTH;
+        case 1:  return gpio_from_paddles(true, false);
+        case 2:  return GPIO_IDLE;
+        case 3:  return gpio_from_paddles(false, true);
+        case 4:  return GPIO_BOTH;
+        default: return GPIO_IDLE;
+    }
+}
+
+static uint32_t k_iambic_tick(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+    static iambic_processor_t proc;
+    iambic_init(&proc, &config);
+    uint32_t acc = 0;
+
+    /* 100us ticks, starting clear of the release debounce at t=0 */
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        stream_sample_t s = iambic_tick(&proc, 100000 + (int64_t)i * 100, paddle_pattern(i));
+        acc += s.local_key;
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    s_sink = acc;
+    return cycles;
+}
+
+/* One render call of arg samples at 8 kHz (8 = one RT tick) */
+static uint32_t k_sidetone_render(uint32_t ops, uint32_t arg) {
+    static int16_t block[256];
+    sidetone_gen_t gen;
+    sidetone_init(&gen, 600, 8000, 40);
+    size_t n = (arg < 256U) ? arg : 256U;
+
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        sidetone_render(&gen, block, n, ((i / 64U) & 1U) != 0, SIDETONE_GAIN_UNITY);
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    s_sink = (uint16_t)block[n - 1U];
+    return cycles;
+}
+
+/* Mixed frame stream: no-payload, short payload and long payload frames */
+static size_t build_frames(uint8_t *buf, size_t cap, uint32_t *frames) {
+    size_t len = 0;
+    *frames = 0;
+    while (len + 80 <= cap) {
+        buf[len++] = 0x01;                      /* No payload */
+        buf[len++] = 0x40 | 0x03;               /* Short payload, 4 bytes */
+        buf[len++] = 4;
+        for (int i = 0; i < 4; i++) buf[len++] = (uint8_t)i;
+        buf[len++] = 0x80 | 0x05;               /* Long payload, 64 bytes (LE) */
+        buf[len++] = 64;
+        buf[len++] = 0;
+        for (int i = 0; i < 64; i++) buf[len++] = (uint8_t)i;
+        *frames += 3;
+    }
+    return len;
+}
+
+/* ops frames, rounded up to whole buffers */
+static uint32_t k_cwnet_parse(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    static uint8_t buf[2048];
+    uint32_t frames_per_buf;
+    size_t len = build_frames(buf, sizeof(buf), &frames_per_buf);
+
+    cwnet_frame_parser_t parser;
+    cwnet_frame_parser_init(&parser);
+    uint32_t acc = 0;
+    uint32_t parsed = 0;
+
+    uint32_t t0 = bench_cycles();
+    while (parsed < ops) {
+        size_t off = 0;
+        while (off < len) {
+            cwnet_parse_result_t r = cwnet_frame_parse(&parser, buf + off, len - off);
+            if (r.status != CWNET_PARSE_OK || r.bytes_consumed == 0) {
+                break;
+            }
+            off += r.bytes_consumed;
+            acc += r.payload_len;
+            parsed++;
+        }
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    s_sink = acc;
+    return (uint32_t)(((uint64_t)cycles * ops) / parsed);
+}
+
+/* One frame of 16 LEDs, breathing (a table lookup per LED) */
+static uint32_t k_led_render(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    static led_anim_t anim;
+    uint8_t frame[LED_ANIM_MAX_LEDS * 3U];
+    led_anim_init(&anim, 50, 10);
+    uint32_t acc = 0;
+
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        led_anim_render(&anim, LED_STATE_BOOT, (int64_t)i * 20000, false, false,
+                        frame, LED_ANIM_MAX_LEDS);
+        acc += frame[0];
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    s_sink = acc;
+    return cycles;
+}
+
+/* ============================================================================
+ * WireGuard crypto
+ * ============================================================================ */
+
+/* One data packet: a CWNet frame in the tunnel is small, a full one the MTU */
+#define BENCH_WG_SMALL  64U
+#define BENCH_WG_MTU    1420U
+#define BENCH_WG_TAG    16U
+static uint8_t s_wg_packet[BENCH_WG_MTU + BENCH_WG_TAG];
+static uint8_t s_wg_plain[BENCH_WG_MTU];
+static const uint8_t s_wg_key[32] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+typedef enum {
+    WG_REFC_SEAL, WG_XTENSA_SEAL, WG_REFC_OPEN, WG_XTENSA_OPEN,
+} bench_wg_op_t;
+
+static uint32_t run_wg_aead(uint32_t ops, bench_wg_op_t op, size_t len) {
+    uint32_t acc = 0;
+
+    /* Open needs a valid packet: seal one first, open it out of place */
+    chacha20poly1305_encrypt(s_wg_packet, s_wg_plain, len, NULL, 0, 1, s_wg_key);
+
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        switch (op) {
+            case WG_REFC_SEAL:
+                chacha20poly1305_encrypt(s_wg_packet, s_wg_packet, len, NULL, 0, i, s_wg_key);
+                break;
+            case WG_XTENSA_SEAL:
+                chacha20poly1305_xtensa_encrypt(s_wg_packet, s_wg_packet, len, NULL, 0, i, s_wg_key);
+                break;
+            case WG_REFC_OPEN:
+                acc += chacha20poly1305_decrypt(s_wg_plain, s_wg_packet, len + BENCH_WG_TAG,
+                                                NULL, 0, 1, s_wg_key) ? 1U : 0U;
+                break;
+            case WG_XTENSA_OPEN:
+                acc += chacha20poly1305_xtensa_decrypt(s_wg_plain, s_wg_packet, len + BENCH_WG_TAG,
+                                                       NULL, 0, 1, s_wg_key) ? 1U : 0U;
+                break;
+        }
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    s_sink = acc + s_wg_plain[0];
+    return cycles;
+}
+
+static uint32_t k_wg_mtu(uint32_t ops, uint32_t arg)   { return run_wg_aead(ops, (bench_wg_op_t)arg, BENCH_WG_MTU); }
+static uint32_t k_wg_small(uint32_t ops, uint32_t arg) { return run_wg_aead(ops, (bench_wg_op_t)arg, BENCH_WG_SMALL); }
+
+/* BLAKE2s-256 of one 64-byte block (the handshake hashes and MACs), and
+ * Kdf3 of a 32-byte input (each handshake message runs several) */
+typedef enum {
+    HASH_BLAKE2S_REFC, HASH_BLAKE2S_XTENSA, HASH_KDF3_REFC, HASH_KDF3_XTENSA,
+} bench_hash_op_t;
+
+/* Kdf3 as wireguard.c computes it on the reference hash: one HMAC for
+ * tau0, then one per output, each paying for both pad blocks */
+static void ref_hmac(uint8_t digest[32], const uint8_t key[32], const uint8_t *text, size_t text_len) {
+    uint8_t pad[64];
+    blake2s_ctx ctx;
+
+    memset(pad, 0x36, sizeof(pad));
+    for (int i = 0; i < 32; i++) pad[i] ^= key[i];
+    blake2s_init(&ctx, 32, NULL, 0);
+    blake2s_update(&ctx, pad, sizeof(pad));
+    blake2s_update(&ctx, text, text_len);
+    blake2s_final(&ctx, digest);
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (int i = 0; i < 32; i++) pad[i] ^= key[i];
+    blake2s_init(&ctx, 32, NULL, 0);
+    blake2s_update(&ctx, pad, sizeof(pad));
+    blake2s_update(&ctx, digest, 32);
+    blake2s_final(&ctx, digest);
+}
+
+static void ref_kdf3(uint8_t t1[32], uint8_t t2[32], uint8_t t3[32], const uint8_t ck[32],
+                     const uint8_t *data, size_t data_len) {
+    uint8_t tau0[32];
+    uint8_t buf[33];
+
+    ref_hmac(tau0, ck, data, data_len);
+    buf[0] = 1;
+    ref_hmac(t1, tau0, buf, 1);
+    memcpy(buf, t1, 32);
+    buf[32] = 2;
+    ref_hmac(t2, tau0, buf, 33);
+    memcpy(buf, t2, 32);
+    buf[32] = 3;
+    ref_hmac(t3, tau0, buf, 33);
+}
+
+static uint32_t k_wg_hash(uint32_t ops, uint32_t op) {
+    uint8_t ck[32] = { 0 };
+    uint8_t t2[32];
+    uint8_t t3[32];
+
+    /* Chain the results so no call can be skipped */
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        ck[1] = (uint8_t)i;
+        switch ((bench_hash_op_t)op) {
+            case HASH_BLAKE2S_REFC:
+                memcpy(s_wg_plain, ck, sizeof(ck));
+                blake2s(ck, sizeof(ck), NULL, 0, s_wg_plain, 64);
+                break;
+            case HASH_BLAKE2S_XTENSA:
+                memcpy(s_wg_plain, ck, sizeof(ck));
+                blake2s_xtensa(ck, sizeof(ck), NULL, 0, s_wg_plain, 64);
+                break;
+            case HASH_KDF3_REFC:
+                ref_kdf3(ck, t2, t3, ck, s_wg_key, sizeof(s_wg_key));
+                break;
+            case HASH_KDF3_XTENSA:
+                blake2s_xtensa_hkdf(ck, t2, t3, ck, s_wg_key, sizeof(s_wg_key));
+                break;
+        }
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    s_sink = ck[0];
+    return cycles;
+}
+
+typedef enum {
+    X25519_REFC, X25519_XTENSA,
+} bench_x25519_impl_t;
+
+/* One scalar multiplication; a handshake does four */
+static uint32_t k_x25519(uint32_t ops, uint32_t impl) {
+    uint8_t k[32];
+    uint8_t u[32] = { 9 };
+    for (size_t i = 0; i < sizeof(k); i++) {
+        k[i] = (uint8_t)(i * 37U + 11U);
+    }
+
+    /* Chain the results so no call can be skipped */
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        if (impl == X25519_REFC) {
+            (void)x25519(u, k, u, 1);
+        } else {
+            (void)x25519_xtensa(u, k, u);
+        }
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    s_sink = u[0];
+    return cycles;
+}
+
+/* ============================================================================
+ * Table (about a second in all at 240 MHz)
+ * ============================================================================ */
+
+const bench_kernel_t g_bench_builtin[] = {
+    { "stream_push_sram",          k_stream_push,     65536, BENCH_SRAM },
+    { "stream_push_psram",         k_stream_push,     65536, BENCH_PSRAM },
+    { "consumer_span_sram",        k_consumer_span,   65536, BENCH_SRAM },
+    { "consumer_span_psram",       k_consumer_span,   65536, BENCH_PSRAM },
+    { "stream_xcore_sram",         k_stream_xcore,    65536, BENCH_SRAM },
+    { "stream_xcore_psram",        k_stream_xcore,    65536, BENCH_PSRAM },
+    { "hard_rt_tick_sram",         k_hard_rt_tick,    65536, BENCH_SRAM },
+    { "hard_rt_tick_psram",        k_hard_rt_tick,    65536, BENCH_PSRAM },
+    { "iambic_tick",               k_iambic_tick,     65536, 0 },
+    { "sidetone_render_8",         k_sidetone_render, 8192,  8 },
+    { "sidetone_render_256",       k_sidetone_render, 1024,  256 },
+    { "cwnet_frame_parse",         k_cwnet_parse,     16384, 0 },
+    { "led_anim_render_16",        k_led_render,      8192,  0 },
+    { "wg_seal_1420_refc",         k_wg_mtu,          64,    WG_REFC_SEAL },
+    { "wg_seal_1420_xtensa",       k_wg_mtu,          64,    WG_XTENSA_SEAL },
+    { "wg_open_1420_refc",         k_wg_mtu,          64,    WG_REFC_OPEN },
+    { "wg_open_1420_xtensa",       k_wg_mtu,          64,    WG_XTENSA_OPEN },
+    { "wg_seal_64_xtensa",         k_wg_small,        512,   WG_XTENSA_SEAL },
+    { "wg_blake2s_64_refc",        k_wg_hash,         1024,  HASH_BLAKE2S_REFC },
+    { "wg_blake2s_64_xtensa",      k_wg_hash,         1024,  HASH_BLAKE2S_XTENSA },
+    { "wg_kdf3_refc",              k_wg_hash,         64,    HASH_KDF3_REFC },
+    { "wg_kdf3_xtensa",            k_wg_hash,         64,    HASH_KDF3_XTENSA },
+    { "wg_x25519_refc",            k_x25519,          2,     X25519_REFC },
+    { "wg_x25519_xtensa",          k_x25519,          4,     X25519_XTENSA },
+};
+
+const size_t g_bench_builtin_count = sizeof(g_bench_builtin) / sizeof(g_bench_builtin[0]);
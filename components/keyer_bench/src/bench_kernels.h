@@ -0,0 +1,14 @@
+/**
+ * @file bench_kernels.h
+ * @brief Built-in kernel table (bench_kernels.c)
+ */
+
+#ifndef KEYER_BENCH_KERNELS_H
+#define KEYER_BENCH_KERNELS_H
+
+#include "bench.h"
+
+extern const bench_kernel_t g_bench_builtin[];
+extern const size_t g_bench_builtin_count;
+
+#endif /* KEYER_BENCH_KERNELS_H */
@@ -3,7 +3,8 @@
  * @brief Serial console interface
  *
  * Interactive command interface with history and tab completion.
- * Uses USB Serial JTAG for input/output.
+ * USB CDC0 is the local terminal; remote terminals open sessions of
+ * their own (console_session_t).
  */
 
 #ifndef KEYER_CONSOLE_H
@@ -111,73 +112,210 @@ console_error_t console_execute(const console_parsed_cmd_t *cmd);
 const console_cmd_t *console_find_command(const char *name);
 
 /* ============================================================================
- * Console main interface
+ * History
  * ============================================================================ */
 
 /**
- * @brief Initialize console
+ * @brief Command history ring (one per session)
  */
-void console_init(void);
+typedef struct {
+    char entries[CONSOLE_HISTORY_SIZE][CONSOLE_LINE_MAX];
+    size_t count;       /**< Entries held (0 to CONSOLE_HISTORY_SIZE) */
+    size_t write;       /**< Where the next entry goes */
+    size_t nav;         /**< Entry shown while navigating */
+    bool navigating;    /**< Arrow keys are walking the ring */
+    size_t nav_count;   /**< Entries returned during this navigation */
+} console_history_t;
 
 /**
- * @brief Console task (runs on Core 1)
- * @param arg Unused
+ * @brief Initialize command history
+ * @param h History
  */
-void console_task(void *arg);
+void console_history_init(console_history_t *h);
 
 /**
- * @brief Process single character input
- * @param c Input character
- * @return true if command was executed
+ * @brief Add command to history (skips duplicates of last entry)
+ * @param h History
+ * @param line Command line to add
  */
-bool console_process_char(char c);
+void console_history_push(console_history_t *h, const char *line);
 
 /**
- * @brief Push character to console (from USB callback)
+ * @brief Navigate to older entry (arrow up)
+ * @param h History
+ * @return Pointer to history entry or NULL if at oldest
+ */
+const char *console_history_prev(console_history_t *h);
+
+/**
+ * @brief Navigate to newer entry (arrow down)
+ * @param h History
+ * @return Pointer to history entry or NULL if at newest
+ */
+const char *console_history_next(console_history_t *h);
+
+/**
+ * @brief Reset navigation state
+ * @param h History
+ */
+void console_history_reset_nav(console_history_t *h);
+
+/* ============================================================================
+ * Sessions
+ * ============================================================================ */
+
+/**
+ * @brief Session output sink
  *
- * Same as console_process_char but without echo (echo handled by USB).
+ * Must not block for long: remote sinks queue into a bounded buffer and
+ * drop what the peer does not take.
+ */
+typedef void (*console_write_fn)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Send what the sink holds (end of an input burst, prompt)
+ */
+typedef void (*console_flush_fn)(void *ctx);
+
+/**
+ * @brief One terminal on the console
+ *
+ * USB CDC0 is the built-in session; remote terminals (console_tcp.h,
+ * the WebSocket "console" message) each own one. Every session has its
+ * own line, escape state and history; commands and completion print to
+ * the session whose input is being handled.
+ */
+typedef struct {
+    char line[CONSOLE_LINE_MAX];
+    size_t pos;
+    char saved[CONSOLE_LINE_MAX];   /**< Line typed before history navigation */
+    size_t saved_pos;
+    uint8_t escape;                 /**< ANSI escape state */
+    bool echo;                      /**< Echo input here (USB echoes on its own) */
+    console_history_t history;
+    console_write_fn write;         /**< NULL once closed */
+    console_flush_fn flush;
+    void *ctx;
+    uint32_t id;                    /**< Unique per init, 0 once closed */
+} console_session_t;
+
+/**
+ * @brief Initialize a session
+ *
+ * @param s Session
+ * @param write Output sink
+ * @param flush Sink flush (NULL: none)
+ * @param ctx Passed to write and flush
+ * @param echo Echo input characters (console_session_input)
+ */
+void console_session_init(console_session_t *s, console_write_fn write, console_flush_fn flush,
+                          void *ctx, bool echo);
+
+/**
+ * @brief Detach a session from its terminal (connection gone)
+ *
+ * Later output for it, e.g. from a watch it started, is discarded.
+ *
+ * @param s Session
+ */
+void console_session_close(console_session_t *s);
+
+/**
+ * @brief Session whose input is being handled
  *
+ * A command that starts background output keeps this and its id.
+ *
+ * @return Session (USB outside any input)
+ */
+console_session_t *console_session_current(void);
+
+/**
+ * @brief Write to a session from outside its input, then flush
+ *
+ * @param s Session
+ * @param id Its id when the writer took it
+ * @param data Bytes
+ * @param len Byte count
+ * @return false if the session was closed or reused since
+ */
+bool console_session_write(console_session_t *s, uint32_t id, const char *data, size_t len);
+
+/**
+ * @brief Feed one character, without echo
+ *
+ * Sessions take turns: commands are not reentrant, so a command running
+ * for one session holds off the others.
+ *
+ * @param s Session
  * @param c Input character
- * @return true if command was executed
+ * @return true if the line was executed or cancelled (reprint the prompt)
  */
-bool console_push_char(char c);
+bool console_session_push(console_session_t *s, char c);
 
 /**
- * @brief Print the console prompt
+ * @brief Feed received bytes: echo (if set), edit, execute, prompt
+ *
+ * @param s Session
+ * @param data Bytes
+ * @param len Byte count
  */
-void console_print_prompt(void);
+void console_session_input(console_session_t *s, const char *data, size_t len);
+
+/**
+ * @brief Print the prompt on a session
+ * @param s Session
+ */
+void console_session_prompt(console_session_t *s);
+
+/**
+ * @brief Write to the session being served (USB outside any input)
+ *
+ * @param data Bytes
+ * @param len Byte count
+ */
+void console_write(const char *data, size_t len);
+
+/**
+ * @brief printf to the session being served
+ */
+void console_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 
 /* ============================================================================
- * History
+ * Console main interface
  * ============================================================================ */
 
 /**
- * @brief Initialize command history
+ * @brief Initialize console
  */
-void console_history_init(void);
+void console_init(void);
 
 /**
- * @brief Add command to history (skips duplicates of last entry)
- * @param line Command line to add
+ * @brief Console task (runs on Core 1)
+ * @param arg Unused
  */
-void console_history_push(const char *line);
+void console_task(void *arg);
 
 /**
- * @brief Navigate to older entry (arrow up)
- * @return Pointer to history entry or NULL if at oldest
+ * @brief Process single character input
+ * @param c Input character
+ * @return true if command was executed
  */
-const char *console_history_prev(void);
+bool console_process_char(char c);
 
 /**
- * @brief Navigate to newer entry (arrow down)
- * @return Pointer to history entry or NULL if at newest
+ * @brief Push character to console (from USB callback)
+ *
+ * Same as console_process_char but without echo (echo handled by USB).
+ *
+ * @param c Input character
+ * @return true if command was executed
  */
-const char *console_history_next(void);
+bool console_push_char(char c);
 
 /**
- * @brief Reset navigation state
+ * @brief Print the console prompt
  */
-void console_history_reset_nav(void);
+void console_print_prompt(void);
 
 /* ============================================================================
  * Tab completion
@@ -0,0 +1,59 @@
+/**
+ * @file console_tcp.h
+ * @brief Command console over telnet
+ *
+ * With system.console_tcp_port set, console_tcp_task listens on that
+ * port and gives every connection a console session of its own (line
+ * editor, history, completion), fed through the telnet filter
+ * (telnet.h). The same commands as on USB run under the console lock,
+ * so one session at a time; Ctrl+D closes the connection.
+ *
+ * With system.console_tcp_vpn_only set, a connection is accepted only
+ * when it arrived on the WireGuard tunnel address while the tunnel is up.
+ * The console can change every setting and has no login: keep it there.
+ *
+ * Output is coalesced like CDC0 (cdc_batch.h) and sent without blocking:
+ * what a slow client leaves in its send buffer is dropped and counted.
+ * The task runs at the lowest priority on Core 1.
+ */
+
+#ifndef KEYER_CONSOLE_TCP_H
+#define KEYER_CONSOLE_TCP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Concurrent telnet connections */
+#define CONSOLE_TCP_MAX_SESSIONS 2
+
+/**
+ * @brief Listener snapshot (console)
+ */
+typedef struct {
+    uint16_t port;          /**< Listen port (0 = off) */
+    size_t sessions;        /**< Connections open now */
+    uint32_t accepted;      /**< Connections accepted since boot */
+    uint32_t refused;       /**< Turned away (full, or not on the VPN) */
+    uint32_t bytes;         /**< Output bytes sent, open sessions */
+    uint32_t dropped;       /**< Output bytes the clients did not take, open sessions */
+} console_tcp_info_t;
+
+/**
+ * @brief Telnet console task (deletes itself unless system.console_tcp_port is set)
+ */
+void console_tcp_task(void *arg);
+
+/**
+ * @brief Listener snapshot (best-effort from other tasks)
+ */
+void console_tcp_get_info(console_tcp_info_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_CONSOLE_TCP_H */
@@ -0,0 +1,60 @@
+/**
+ * @file console_watch.h
+ * @brief "stats watch": live counters on the terminal that asked
+ *
+ * A low-priority sampler task on Core 1 reads the selected counter groups
+ * every interval into a ring (stats_watch.h) and once a second writes one
+ * compact line to the session that started it, with deltas since the
+ * previous line and the min/max the samples between saw. Sampling is a
+ * few snapshot reads; nothing on the RT path changes.
+ *
+ * One watch at a time: starting one replaces the previous (on whichever
+ * terminal). It stops on "stats watch off" or when its terminal closes.
+ * A WebSocket terminal only gets output while answering its own input,
+ * so watch lines reach USB and telnet terminals.
+ */
+
+#ifndef KEYER_CONSOLE_WATCH_H
+#define KEYER_CONSOLE_WATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Sampling interval limits (a line holds at most STATS_WATCH_RING samples) */
+#define CONSOLE_WATCH_MIN_MS 50U
+#define CONSOLE_WATCH_MAX_MS 60000U
+
+/** Line period (or every sample when the interval is longer) */
+#define CONSOLE_WATCH_LINE_MS 1000U
+
+/**
+ * @brief Start watching on the session running the current command
+ *
+ * @param interval_ms Sampling interval (CONSOLE_WATCH_MIN_MS..MAX_MS)
+ * @param groups STATS_WATCH_* bits
+ * @return false if the sampler task could not be created
+ */
+bool console_watch_start(uint32_t interval_ms, unsigned groups);
+
+/**
+ * @brief Stop the watch (no-op if none)
+ */
+void console_watch_stop(void);
+
+/**
+ * @brief Current watch
+ *
+ * @param interval_ms Sampling interval, 0 if none
+ * @param groups STATS_WATCH_* bits
+ */
+void console_watch_get(uint32_t *interval_ms, unsigned *groups);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_CONSOLE_WATCH_H */
@@ -0,0 +1,54 @@
+/**
+ * @file syslog_sink.h
+ * @brief Remote syslog over UDP (system.syslog_host)
+ *
+ * With system.syslog_host set, syslog_sink_task drains the RT and BG log
+ * streams with cursors of its own and sends them as datagrams
+ * (log_syslog.h): RFC 5424 text, one record each, or BINARY, as many
+ * log_wire frames as fit. A collector address inside the WireGuard
+ * tunnel's allowed IPs is reached through the tunnel; anywhere else the
+ * datagrams go out in clear.
+ *
+ * system.syslog_rate bounds the datagrams per second. What waits past it
+ * stays in the ring; what the ring overwrites meanwhile is counted and
+ * reported to the collector (a warning, or a DROPPED frame). Nothing is
+ * allocated: socket, buffers and cursors are static. The task runs at the
+ * lowest priority on Core 1.
+ */
+
+#ifndef KEYER_SYSLOG_SINK_H
+#define KEYER_SYSLOG_SINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sink snapshot (console)
+ */
+typedef struct {
+    bool resolved;          /**< Collector address known */
+    uint32_t sent;          /**< Datagrams sent */
+    uint32_t records;       /**< Log records in them */
+    uint32_t dropped;       /**< Records the ring overwrote before they went out */
+    uint32_t errors;        /**< sendto() failures */
+} syslog_sink_stats_t;
+
+/**
+ * @brief Syslog task (deletes itself unless system.syslog_host is set)
+ */
+void syslog_sink_task(void *arg);
+
+/**
+ * @brief Sink snapshot (best-effort from other tasks)
+ */
+void syslog_sink_get_stats(syslog_sink_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_SYSLOG_SINK_H */
@@ -0,0 +1,58 @@
+/**
+ * @file telnet.h
+ * @brief Minimal telnet input filter for the TCP console
+ *
+ * The server asks for character mode (it echoes, no go-ahead), so
+ * keystrokes arrive one by one and history and completion work as on
+ * USB. What the client sends back is stripped here: option negotiation
+ * (IAC WILL/WONT/DO/DONT x), subnegotiation (IAC SB ... IAC SE) and the
+ * other two-byte commands. A line end is CR LF, CR NUL or a bare LF;
+ * each reaches the console as one CR, so a line runs once. Plain
+ * netcat works as well (it sees the six negotiation bytes once).
+ *
+ * Output needs no filter: the console only prints ASCII and CR LF.
+ */
+
+#ifndef KEYER_TELNET_H
+#define KEYER_TELNET_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** IAC WILL ECHO, IAC WILL SUPPRESS-GO-AHEAD */
+#define TELNET_CHAR_MODE_LEN 6U
+extern const uint8_t TELNET_CHAR_MODE[TELNET_CHAR_MODE_LEN];
+
+/**
+ * @brief Receive state (one per connection)
+ */
+typedef struct {
+    uint8_t state;
+} telnet_rx_t;
+
+/**
+ * @brief Reset for a new connection
+ */
+void telnet_rx_init(telnet_rx_t *t);
+
+/**
+ * @brief Strip telnet commands in place
+ *
+ * Sequences may be split across calls.
+ *
+ * @param t Receive state
+ * @param data Received bytes (rewritten with the console input)
+ * @param len Byte count
+ * @return Console input bytes left at the start of data
+ */
+size_t telnet_rx_filter(telnet_rx_t *t, uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TELNET_H */
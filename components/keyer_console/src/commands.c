@@ -9,21 +9,42 @@
 #include "config.h"
 #include "config_console.h"
 #include "config_nvs.h"
+#include "config_persist.h"
 #include "rt_log.h"
 #include "hal_gpio.h"
+#include "hal_tick.h"
+#include "hal_audio.h"
+#include "rt_prof.h"
+#include "key_latency.h"
+#include "rt_idle.h"
+#include "radio_focus.h"
+#include "tx_sched.h"
+#include "flight_rec.h"
+#include "boot_timeline.h"
+#include "service.h"
+#include "task_stats.h"
+#include "mem_budget.h"
+#include "fault.h"
 #include "decoder.h"
 #include "text_keyer.h"
 #include "text_memory.h"
+#include "text_macro.h"
+#include "config_profile.h"
+#include "iambic_preset.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <string.h>
+#include <time.h>
 
 #ifdef ESP_PLATFORM
 #include "driver/gpio.h"
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "esp_heap_caps.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "nvs.h"
@@ -31,14 +52,45 @@
 #include "usb_console.h"
 #include "usb_log.h"
 #include "usb_uf2.h"
+#include "usb_winkeyer.h"
+#include "usb_audio.h"
+#include "usb_paddle.h"
+#include "winkeyer_tcp.h"
+#include "console_tcp.h"
+#include "syslog_sink.h"
+#include "logger_feed_udp.h"
+#include "console_watch.h"
+#include "stats_watch.h"
+#include "load_shed.h"
 #include "usb_cdc.h"
 #include "tusb_cdc_acm.h"
 #include "wifi.h"
 #include "vpn.h"
-/* Use USB console printf for command output (skip for IDE analyzers) */
+#include "cwnet_socket.h"
+#include "espnow_link.h"
+#include "audio_playout.h"
+#include "stream.h"
+#include "stream_index.h"
+#include "stream_export.h"
+#include "key_stats.h"
+#include "recorder.h"
+#include "audio_rx.h"
+#include "bench.h"
+
+/* Off-air decoder pipeline (main/audio_rx_task.c) */
+extern audio_rx_t g_audio_rx;
+/* Rig audio playout state (main/rt_task.c) */
+extern audio_playout_t g_rig_playout;
+/* Keying stream (main/main.c) */
+extern keying_stream_t g_keying_stream;
+/* Stream time index (main/bg_task.c) */
+extern stream_index_t g_stream_index;
+/* Command output goes to the session that typed it (skip for IDE analyzers) */
 #if !defined(__INTELLISENSE__) && !defined(__clang_analyzer__) && !defined(__clangd__)
-#define printf usb_console_printf
+#define printf console_printf
 #endif
+#else
+#define EXT_RAM_BSS_ATTR
 #endif
 
 /* ============================================================================
@@ -100,7 +152,7 @@ static console_error_t cmd_help(const console_parsed_cmd_t *cmd) {
             for (size_t i = 0; i < CONSOLE_PARAM_COUNT; i++) {
                 if (strcmp(CONSOLE_PARAMS[i].family, f->name) == 0) {
                     char buf[32];
-                    config_get_param_str(CONSOLE_PARAMS[i].full_path, buf, sizeof(buf));
+                    config_format_param(&CONSOLE_PARAMS[i], buf, sizeof(buf));
                     printf("  %s = %s\r\n", CONSOLE_PARAMS[i].full_path, buf);
                 }
             }
@@ -156,7 +208,7 @@ static console_error_t cmd_version(const console_parsed_cmd_t *cmd) {
 }
 
 /**
- * @brief stats [tasks|heap|stream|rt] - System statistics
+ * @brief stats [tasks|heap|stream|audio|cwnet|espnow|usb|log|rt|boot|svc|keying] - System statistics
  */
 static console_error_t cmd_stats(const console_parsed_cmd_t *cmd) {
 #ifdef ESP_PLATFORM
@@ -176,6 +228,22 @@ static console_error_t cmd_stats(const console_parsed_cmd_t *cmd) {
                (unsigned long)heap_free, (unsigned long)heap_min);
         printf("stream: ok\r\n");
 
+        hal_audio_stats_t as;
+        hal_audio_get_stats(&as);
+        printf("audio: %s (underrun %lu, overrun %lu)\r\n",
+               hal_audio_output_mode_str(as.mode),
+               (unsigned long)as.underrun_samples, (unsigned long)as.overrun_samples);
+
+        cwnet_socket_state_t cw_state = cwnet_socket_get_state();
+        if (cw_state != CWNET_SOCK_DISABLED) {
+            cwnet_latency_snapshot_t ls;
+            cwnet_socket_get_edge_latency(&ls);
+            printf("cwnet: %s (send p50 %luus, p99 %luus)\r\n",
+                   cwnet_socket_state_str(cw_state),
+                   (unsigned long)cwnet_latency_percentile_us(&ls, 50),
+                   (unsigned long)cwnet_latency_percentile_us(&ls, 99));
+        }
+
         /* WiFi status */
         wifi_state_t wifi_state = wifi_get_state();
         const char *state_str;
@@ -196,11 +264,46 @@ static console_error_t cmd_stats(const console_parsed_cmd_t *cmd) {
                 printf("ip: %s\r\n", ip_buf);
             }
         }
+        if (wifi_state == WIFI_STATE_CONNECTED) {
+            wifi_ps_status_t ps;
+            wifi_get_power_save(&ps);
+            printf("power save: %s (%s, %lu switches, jitter awake %ldms, saving %ldms)\r\n",
+                   ps.saving ? "modem" : "off",
+                   wifi_ps_policy_str((wifi_ps_policy_t)CONFIG_GET_POWER_SAVE()),
+                   (unsigned long)ps.switches,
+                   (long)ps.jitter_awake_ms, (long)ps.jitter_saving_ms);
+        }
     } else if (strcmp(cmd->args[0], "heap") == 0) {
         uint32_t heap_free = esp_get_free_heap_size();
         uint32_t heap_min = esp_get_minimum_free_heap_size();
         printf("heap free:    %lu bytes\r\n", (unsigned long)heap_free);
         printf("heap minimum: %lu bytes\r\n", (unsigned long)heap_min);
+
+        printf("\r\n%-9s %8s %8s %8s %8s %8s\r\n",
+               "heap", "total", "free", "largest", "min", "min/1m");
+        for (int c = 0; c < MEM_CAP_COUNT; c++) {
+            mem_cap_sample_t ms;
+            mem_budget_get(&g_mem_budget, (mem_cap_t)c, &ms);
+            if (ms.total == 0) {
+                continue;
+            }
+            printf("%-9s %8lu %8lu %8lu %8lu %8lu\r\n", mem_cap_str((mem_cap_t)c),
+                   (unsigned long)ms.total, (unsigned long)ms.free,
+                   (unsigned long)ms.largest, (unsigned long)ms.min_free,
+                   (unsigned long)mem_budget_window_low(&g_mem_budget, (mem_cap_t)c));
+        }
+
+        /* Internal RAM is the one that runs out: its last hour, oldest first */
+        static uint32_t lows[MEM_BUDGET_HISTORY];
+        size_t n = mem_budget_history(&g_mem_budget, MEM_CAP_INTERNAL, lows,
+                                      MEM_BUDGET_HISTORY);
+        if (n > 0) {
+            printf("\r\ninternal low water per minute (KB, oldest first):\r\n");
+            for (size_t i = 0; i < n; i++) {
+                printf("%4lu%s", (unsigned long)(lows[i] / 1024U),
+                       (i % 15U == 14U || i + 1U == n) ? "\r\n" : " ");
+            }
+        }
     } else if (strcmp(cmd->args[0], "tasks") == 0) {
         /* Get number of tasks */
         UBaseType_t num_tasks = uxTaskGetNumberOfTasks();
@@ -213,8 +316,20 @@ static console_error_t cmd_stats(const console_parsed_cmd_t *cmd) {
         uint32_t total_runtime;
         UBaseType_t actual = uxTaskGetSystemState(tasks, num_tasks, &total_runtime);
 
+        /* CPU shares over the last second, from the task history */
+        static task_stats_task_t known[TASK_STATS_MAX_TASKS];
+        static task_stats_sample_t last;
+        size_t n_known = task_stats_tasks(&g_task_stats, known, TASK_STATS_MAX_TASKS);
+        uint32_t head = task_stats_head(&g_task_stats);
+        bool have_cpu = head > 0 && task_stats_read(&g_task_stats, head - 1U, &last, 1) == 1;
+
         printf("=== Tasks (%u) ===\r\n", (unsigned)actual);
-        printf("%-16s %4s %6s %4s %4s\r\n", "NAME", "CORE", "STACK", "PRIO", "STATE");
+        if (have_cpu) {
+            printf("idle: core0 %u.%u%%, core1 %u.%u%% (last second)\r\n",
+                   last.idle_pm[0] / 10U, last.idle_pm[0] % 10U,
+                   last.idle_pm[1] / 10U, last.idle_pm[1] % 10U);
+        }
+        printf("%-16s %4s %6s %4s %4s %6s\r\n", "NAME", "CORE", "STACK", "PRIO", "STATE", "CPU%");
 
         for (UBaseType_t i = 0; i < actual; i++) {
             const char *state;
@@ -230,19 +345,457 @@ static console_error_t cmd_stats(const console_parsed_cmd_t *cmd) {
             int core = xTaskGetCoreID(tasks[i].xHandle);
             const char *core_str = (core == 0) ? "0" : (core == 1) ? "1" : "*";
 
-            printf("%-16s %4s %6u %4u %4s\r\n",
+            char cpu[8] = "-";
+            for (size_t k = 0; have_cpu && k < n_known; k++) {
+                if (known[k].id == (uint32_t)tasks[i].xTaskNumber &&
+                    last.cpu_pm[k] != TASK_STATS_ABSENT) {
+                    snprintf(cpu, sizeof(cpu), "%u.%u", last.cpu_pm[k] / 10U,
+                             last.cpu_pm[k] % 10U);
+                    break;
+                }
+            }
+
+            printf("%-16s %4s %6u %4u %4s %6s\r\n",
                    tasks[i].pcTaskName,
                    core_str,
                    (unsigned)tasks[i].usStackHighWaterMark,
                    (unsigned)tasks[i].uxCurrentPriority,
-                   state);
+                   state, cpu);
         }
 
         free(tasks);
     } else if (strcmp(cmd->args[0], "stream") == 0) {
-        printf("stream: ok\r\n");
+        const stream_archive_t *ar = g_keying_stream.archive;
+        size_t write = stream_write_position(&g_keying_stream);
+        printf("hot:      %u samples (internal)\r\n", (unsigned)stream_capacity(&g_keying_stream));
+        printf("write:    %u (abs %llu)\r\n", (unsigned)write,
+               (unsigned long long)stream_write_position_abs(&g_keying_stream));
+        printf("oldest:   %u\r\n", (unsigned)stream_oldest_position(&g_keying_stream));
+        if (ar != NULL) {
+            printf("archive:  %u samples (PSRAM, %s)\r\n", (unsigned)ar->capacity,
+                   (ar->words != NULL) ? "compact" : "full");
+            printf("pending:  %u\r\n",
+                   (unsigned)(write - atomic_load_explicit(&ar->head, memory_order_relaxed)));
+            printf("spilled:  %u\r\n",
+                   atomic_load_explicit(&ar->spilled, memory_order_relaxed));
+            printf("gaps:     %u\r\n",
+                   atomic_load_explicit(&ar->gaps, memory_order_relaxed));
+        } else {
+            printf("archive:  off\r\n");
+        }
+        printf("index:    %u checkpoints\r\n", (unsigned)stream_index_count(&g_stream_index));
+
+        static stream_consumer_info_t cons[STREAM_REGISTRY_MAX];
+        size_t n = stream_registry_snapshot(&g_keying_stream, cons, STREAM_REGISTRY_MAX);
+        if (n > 0) {
+            printf("\r\n%-8s %10s %6s %7s %8s %7s  LAG HISTOGRAM (0 1 2 4 8 ...)\r\n",
+                   "CONSUMER", "READ", "LAG", "MAX_LAG", "DROPPED", "OVERRUN");
+            for (size_t i = 0; i < n; i++) {
+                printf("%-8s %10u %6u %7lu %8lu %7lu ", cons[i].name,
+                       (unsigned)cons[i].read_idx, (unsigned)cons[i].lag,
+                       (unsigned long)cons[i].max_lag, (unsigned long)cons[i].dropped,
+                       (unsigned long)cons[i].overruns);
+                /* Trailing empty bins add nothing */
+                size_t last = 0;
+                for (size_t b = 0; b < STREAM_LAG_HIST_BINS; b++) {
+                    if (cons[i].hist[b] != 0) {
+                        last = b;
+                    }
+                }
+                for (size_t b = 0; b <= last; b++) {
+                    printf(" %lu", (unsigned long)cons[i].hist[b]);
+                }
+                printf("\r\n");
+            }
+        }
+    } else if (strcmp(cmd->args[0], "audio") == 0) {
+        hal_audio_stats_t as;
+        hal_audio_get_stats(&as);
+        printf("output:   %s\r\n", hal_audio_output_mode_str(as.mode));
+        printf("ring:     %lu/%u samples\r\n",
+               (unsigned long)as.ring_level, (unsigned)HAL_AUDIO_RING_SAMPLES);
+        printf("underrun: %lu samples\r\n", (unsigned long)as.underrun_samples);
+        printf("overrun:  %lu samples\r\n", (unsigned long)as.overrun_samples);
+        printf("dma cb:   %lu\r\n", (unsigned long)as.dma_callbacks);
+        printf("rig:      %s, %lums buffered, %lu underruns, %lu trimmed\r\n",
+               g_rig_playout.playing ? "playing" : "priming",
+               (unsigned long)audio_playout_latency_ms(&g_rig_playout,
+                                                       CWNET_AUDIO_RATE_KHZ * 1000U),
+               (unsigned long)g_rig_playout.underruns,
+               (unsigned long)g_rig_playout.trimmed);
+        if (usb_audio_is_enabled()) {
+            usb_audio_stats_t us;
+            usb_audio_get_stats(&us);
+            printf("usb:      %s, %lu samples queued, %lu packets, %lu underruns%s, %ddB\r\n",
+                   us.streaming ? "streaming" : "idle", (unsigned long)us.level,
+                   (unsigned long)us.packets, (unsigned long)us.underruns,
+                   us.muted ? ", muted" : "", (int)us.volume_db);
+        }
+    } else if (strcmp(cmd->args[0], "nvs") == 0) {
+        config_persist_stats_t ps;
+        config_persist_get_stats(&ps);
+        printf("state:   %s%s\r\n", ps.pending ? "save queued" : "idle",
+               ps.dirty ? ", unsaved changes" : "");
+        printf("commits: %lu (%lu forced while keying), %lu failed\r\n",
+               (unsigned long)ps.saves, (unsigned long)ps.deferred_max,
+               (unsigned long)ps.failures);
+        printf("keys:    %lu written, %lu last commit\r\n",
+               (unsigned long)ps.keys_written, (unsigned long)ps.last_keys);
+        printf("commit:  last %luus, max %luus\r\n",
+               (unsigned long)ps.last_commit_us, (unsigned long)ps.max_commit_us);
+    } else if (strcmp(cmd->args[0], "cwnet") == 0) {
+        cwnet_latency_snapshot_t ls;
+        cwnet_socket_get_edge_latency(&ls);
+        printf("state:   %s\r\n", cwnet_socket_state_str(cwnet_socket_get_state()));
+        size_t sessions = cwnet_socket_session_count();
+        bool failover = false;
+        for (size_t i = 0; sessions > 1 && i < sessions; i++) {
+            cwnet_session_info_t si;
+            if (!cwnet_socket_get_session(i, &si)) {
+                continue;
+            }
+            failover = failover || si.standby;
+            printf("server:  %s:%u prio %u %s%s, rtt %ldms, %lu edges, %lu rx ignored%s\r\n",
+                   si.host, (unsigned)si.port, (unsigned)si.priority,
+                   cwnet_socket_state_str(si.state), si.udp ? " +udp" : "",
+                   (long)si.latency_ms, (unsigned long)si.edge_latency.count,
+                   (unsigned long)si.rx_ignored,
+                   si.standby ? " (standby)" : si.rx_owner ? " (heard)" : "");
+        }
+        if (failover) {
+            printf("failover: %lu takeovers\r\n", (unsigned long)cwnet_socket_get_failovers());
+        }
+        printf("edges:   %lu sent\r\n", (unsigned long)ls.count);
+        if (ls.count > 0) {
+            printf("latency: p50 %luus, p99 %luus, min %luus, max %luus (edge -> send)\r\n",
+                   (unsigned long)cwnet_latency_percentile_us(&ls, 50),
+                   (unsigned long)cwnet_latency_percentile_us(&ls, 99),
+                   (unsigned long)ls.min_us, (unsigned long)ls.max_us);
+            printf("hist:   ");
+            for (int b = 0; b < CWNET_LATENCY_HIST_BINS; b++) {
+                if (ls.hist[b] > 0) {
+                    printf(" <%lu:%lu", 1UL << b, (unsigned long)ls.hist[b]);
+                }
+            }
+            printf("\r\n");
+        }
+        cwnet_sync_stats_t sync;
+        cwnet_socket_get_sync_stats(&sync);
+        printf("clock:   offset %lldms, drift %ldppm, residual %ldms, %lu samples, %lu steps\r\n",
+               (long long)sync.offset_ms, (long)sync.drift_ppm, (long)sync.residual_ms,
+               (unsigned long)sync.samples, (unsigned long)sync.resets);
+        printf("rtt:     last %ldms, min %ldms, jitter %ldms\r\n",
+               (long)sync.rtt_ms, (long)sync.rtt_min_ms, (long)sync.rtt_jitter_ms);
+        printf("rx:      margin %ldms (floor %ums), delay %ldms, %lu late\r\n",
+               (long)cwnet_socket_get_rx_margin_ms(), (unsigned)CONFIG_GET_PLAYOUT_MS(),
+               (long)cwnet_socket_get_rx_delay_ms(),
+               (unsigned long)cwnet_socket_get_rx_late());
+        const char *peer_name;
+        int32_t peer_rtt;
+        if (cwnet_socket_get_peer(&peer_name, &peer_rtt)) {
+            printf("peer:    %s, rtt %ldms\r\n", peer_name, (long)peer_rtt);
+        }
+        cwnet_audio_dec_t ad;
+        uint32_t audio_overflow;
+        cwnet_socket_get_audio_stats(&ad, &audio_overflow);
+        if (ad.blocks > 0 || ad.rejected > 0) {
+            printf("audio:   %lu blocks, %lu lost, %lu rejected, %lu overflow\r\n",
+                   (unsigned long)ad.blocks, (unsigned long)ad.lost,
+                   (unsigned long)ad.rejected, (unsigned long)audio_overflow);
+        }
+    } else if (strcmp(cmd->args[0], "espnow") == 0) {
+        espnow_link_stats_t es;
+        espnow_link_get_stats(&es);
+        printf("state:   %s\r\n", es.running ? "running" : "off");
+        printf("tx:      %lu frames, %lu errors\r\n",
+               (unsigned long)es.tx_frames, (unsigned long)es.tx_errors);
+        printf("rx:      %lu frames, %lu repaired, %lu lost, %lu dropped, %lu late\r\n",
+               (unsigned long)es.rx_frames, (unsigned long)es.rx_repaired,
+               (unsigned long)es.rx_lost, (unsigned long)es.rx_dropped,
+               (unsigned long)es.rx_late);
+    } else if (strcmp(cmd->args[0], "usb") == 0) {
+        static const char *const hid_modes[] = { "off", "paddles", "key" };
+        usb_paddle_stats_t ps;
+        usb_paddle_get_stats(&ps);
+        usb_console_stats_t cs;
+        usb_console_get_stats(&cs);
+        printf("console: %lu bytes in %lu packets, %lu dropped\r\n", (unsigned long)cs.bytes,
+               (unsigned long)cs.packets, (unsigned long)cs.dropped);
+        printf("cdc1:    %s\r\n", usb_cdc_port1_enabled() ? "on" : "replaced");
+        printf("audio:   %s\r\n", usb_audio_is_enabled() ? "on" : "off");
+        printf("midi:    %s, %lu events, %lu dropped\r\n", ps.midi ? "on" : "off",
+               (unsigned long)ps.midi_events, (unsigned long)ps.midi_dropped);
+        printf("hid:     %s, %lu reports\r\n",
+               ps.hid_mode <= USB_HID_MODE_KEY ? hid_modes[ps.hid_mode] : "?",
+               (unsigned long)ps.hid_reports);
+        printf("edges:   %lu lost\r\n", (unsigned long)ps.edges_lost);
+    } else if (strcmp(cmd->args[0], "console") == 0) {
+        console_tcp_info_t ti;
+        console_tcp_get_info(&ti);
+        if (ti.port == 0) {
+            printf("telnet:  off (set system.console_tcp_port, reboot)\r\n");
+        } else {
+            printf("telnet:  port %u, %u/%d sessions, %lu accepted, %lu refused\r\n",
+                   (unsigned)ti.port, (unsigned)ti.sessions, CONSOLE_TCP_MAX_SESSIONS,
+                   (unsigned long)ti.accepted, (unsigned long)ti.refused);
+            printf("output:  %lu bytes, %lu dropped\r\n",
+                   (unsigned long)ti.bytes, (unsigned long)ti.dropped);
+        }
+    } else if (strcmp(cmd->args[0], "syslog") == 0) {
+        if (CONFIG_GET_SYSLOG_HOST()[0] == '\0') {
+            printf("syslog:  off (set system.syslog_host, reboot)\r\n");
+        } else {
+            syslog_sink_stats_t ss;
+            syslog_sink_get_stats(&ss);
+            printf("syslog:  %s%s\r\n", CONFIG_GET_SYSLOG_HOST(),
+                   ss.resolved ? "" : " (waiting for the address)");
+            printf("sent:    %lu datagrams, %lu records\r\n",
+                   (unsigned long)ss.sent, (unsigned long)ss.records);
+            printf("lost:    %lu records dropped, %lu send errors\r\n",
+                   (unsigned long)ss.dropped, (unsigned long)ss.errors);
+        }
+    } else if (strcmp(cmd->args[0], "feed") == 0) {
+        if (CONFIG_GET_LOGGER_FEED()[0] == '\0') {
+            printf("feed:    off (set system.logger_feed)\r\n");
+        } else {
+            logger_feed_stats_t fs;
+            logger_feed_get_stats(&fs);
+            printf("feed:    %s%s\r\n", CONFIG_GET_LOGGER_FEED(),
+                   fs.active ? "" : " (waiting for WiFi or a valid address)");
+            printf("sent:    %lu datagrams, %lu events\r\n",
+                   (unsigned long)fs.sent, (unsigned long)fs.events);
+            printf("lost:    %lu events dropped, %lu send errors\r\n",
+                   (unsigned long)fs.dropped, (unsigned long)fs.errors);
+        }
+    } else if (strcmp(cmd->args[0], "watch") == 0) {
+        if (cmd->argc < 2) {
+            uint32_t interval_ms;
+            unsigned groups;
+            console_watch_get(&interval_ms, &groups);
+            if (interval_ms == 0) {
+                printf("watch:   off\r\n");
+                return CONSOLE_OK;
+            }
+            printf("watch:   every %lums:", (unsigned long)interval_ms);
+            for (int g = 0; g < STATS_WATCH_GROUP_COUNT; g++) {
+                if ((groups & (1U << g)) != 0U) {
+                    printf(" %s", stats_watch_group_str((stats_watch_group_t)g));
+                }
+            }
+            printf("\r\n");
+            return CONSOLE_OK;
+        }
+        if (strcmp(cmd->args[1], "off") == 0) {
+            console_watch_stop();
+            return CONSOLE_OK;
+        }
+        char *end = NULL;
+        unsigned long interval_ms = strtoul(cmd->args[1], &end, 10);
+        if (end == cmd->args[1] || *end != '\0' ||
+            interval_ms < CONSOLE_WATCH_MIN_MS || interval_ms > CONSOLE_WATCH_MAX_MS) {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        unsigned groups = STATS_WATCH_ALL;
+        if (cmd->argc > 2 && !stats_watch_parse_groups(cmd->args[2], &groups)) {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        if (!console_watch_start((uint32_t)interval_ms, groups)) {
+            printf("watch:   no memory for the sampler task\r\n");
+            return CONSOLE_OK;
+        }
+        printf("(stats watch off to stop)\r\n");
+    } else if (strcmp(cmd->args[0], "log") == 0) {
+        uart_logger_stats_t ls;
+        uart_logger_get_stats(&ls);
+        printf("uart:    %lu baud\r\n", (unsigned long)ls.baud);
+        printf("written: %lu entries, %lu bytes in %lu batches\r\n",
+               (unsigned long)ls.entries, (unsigned long)ls.bytes, (unsigned long)ls.batches);
+        printf("lost:    %lu dropped, %lu stalls\r\n",
+               (unsigned long)ls.dropped, (unsigned long)ls.stalls);
+        printf("ring:    RT %lu/%d bytes, BG %lu/%d bytes\r\n",
+               (unsigned long)log_stream_bytes(&g_rt_log_stream), LOG_RING_BYTES,
+               (unsigned long)log_stream_bytes(&g_bg_log_stream), LOG_RING_BYTES);
     } else if (strcmp(cmd->args[0], "rt") == 0) {
-        printf("rt: ok\r\n");
+        if (cmd->argc > 1 && strcmp(cmd->args[1], "reset") == 0) {
+            hal_tick_reset_stats();
+            rt_prof_reset(&g_rt_prof);
+            printf("rt stats reset\r\n");
+            return CONSOLE_OK;
+        }
+        if (cmd->argc > 1 && strcmp(cmd->args[1], "hist") == 0) {
+            /* Non-empty log2 bins per stage: "<2^k>:<count>" */
+            for (int st = 0; st < RT_PROF_STAGE_COUNT; st++) {
+                rt_prof_snapshot_t ps;
+                rt_prof_get(&g_rt_prof, (rt_prof_stage_t)st, &ps);
+                printf("%-9s", rt_prof_stage_str((rt_prof_stage_t)st));
+                for (int b = 0; b < RT_PROF_HIST_BINS; b++) {
+                    if (ps.hist[b] > 0) {
+                        printf(" <%lu:%lu", 1UL << b, (unsigned long)ps.hist[b]);
+                    }
+                }
+                printf("\r\n");
+            }
+            return CONSOLE_OK;
+        }
+        hal_tick_stats_t ts;
+        hal_tick_get_stats(&ts);
+        printf("pacing:  %s, period %luus\r\n",
+               hal_tick_mode_str(ts.mode), (unsigned long)ts.period_us);
+        printf("wakes:   %lu\r\n", (unsigned long)ts.wakes);
+        printf("jitter:  min %ldus, max %ldus, mean |%lu|us\r\n",
+               (long)ts.jitter_min_us, (long)ts.jitter_max_us,
+               (unsigned long)ts.jitter_mean_us);
+        printf("missed:  %lu ticks, %lu timeouts\r\n",
+               (unsigned long)ts.missed_ticks, (unsigned long)ts.timeouts);
+        rt_idle_stats_t is;
+        rt_idle_get(&g_rt_idle, &is);
+        if (is.threshold_ticks > 0) {
+            printf("sleep:   %lu wakes (%lu by paddle), %llus total, last %lums\r\n",
+                   (unsigned long)is.sleeps, (unsigned long)is.paddle_wakes,
+                   (unsigned long long)(is.slept_us / 1000000U),
+                   (unsigned long)is.last_sleep_ms);
+            printf("wake:    last %luus, max %luus\r\n",
+                   (unsigned long)is.wake_latency_us, (unsigned long)is.wake_latency_max_us);
+        } else {
+            printf("sleep:   off\r\n");
+        }
+        tx_sched_stats_t xs;
+        tx_sched_get(&g_tx_sched, &xs);
+        if (xs.lead_us > 0) {
+            printf("tx:      timed, lead %luus, %lu edges, %lu late (max %luus)\r\n",
+                   (unsigned long)xs.lead_us, (unsigned long)xs.edges,
+                   (unsigned long)xs.late, (unsigned long)xs.late_max_us);
+        } else {
+            printf("tx:      on tick\r\n");
+        }
+        remote_tx_stats_t rs;
+        remote_tx_get(&g_remote_tx, &rs);
+        printf("remote:  %s, %lu events, lead min %ldus, %lu late (max %luus), "
+               "%lu overflow, %lu watchdog (%lums)\r\n",
+               CONFIG_GET_REMOTE_TX() ? "keys tx" : "monitor",
+               (unsigned long)rs.events,
+               (rs.lead_min_ticks == UINT32_MAX) ? -1L
+                   : (long)((uint64_t)rs.lead_min_ticks * ts.period_us),
+               (unsigned long)rs.late,
+               (unsigned long)((uint64_t)rs.late_max_ticks * ts.period_us),
+               (unsigned long)rs.overflow, (unsigned long)rs.watchdog,
+               (unsigned long)(((uint64_t)rs.watchdog_ticks * ts.period_us) / 1000U));
+#ifdef CONFIG_KEYER_RT_PROFILE
+        uint32_t cyc_per_us = esp_rom_get_cpu_ticks_per_us();
+        if (cyc_per_us == 0) cyc_per_us = 1;
+        printf("%-9s %10s %8s %8s %8s %8s\r\n",
+               "STAGE", "COUNT", "MIN", "MEAN", "MAX", "MAX_US");
+        for (int st = 0; st < RT_PROF_STAGE_COUNT; st++) {
+            rt_prof_snapshot_t ps;
+            rt_prof_get(&g_rt_prof, (rt_prof_stage_t)st, &ps);
+            printf("%-9s %10lu %8lu %8lu %8lu %8lu\r\n",
+                   rt_prof_stage_str((rt_prof_stage_t)st),
+                   (unsigned long)ps.count, (unsigned long)ps.min_cycles,
+                   (unsigned long)ps.mean_cycles, (unsigned long)ps.max_cycles,
+                   (unsigned long)(ps.max_cycles / cyc_per_us));
+        }
+#else
+        printf("profile: disabled (CONFIG_KEYER_RT_PROFILE)\r\n");
+#endif
+    } else if (strcmp(cmd->args[0], "boot") == 0) {
+        static boot_phase_t phases[BOOT_TIMELINE_MAX];
+        size_t n = boot_timeline_snapshot(&g_boot_timeline, phases, BOOT_TIMELINE_MAX);
+        printf("%-13s %4s %10s %10s %9s %9s\r\n", "PHASE", "CORE", "START_US", "DUR_US",
+               "INT_B", "PSRAM_B");
+        for (size_t i = 0; i < n; i++) {
+            if (phases[i].end_us == 0) {
+                printf("%-13s %4u %10lld %10s %9s %9s\r\n", phases[i].name,
+                       (unsigned)phases[i].core, (long long)phases[i].start_us, "running",
+                       "-", "-");
+            } else {
+                printf("%-13s %4u %10lld %10lld %9ld %9ld\r\n", phases[i].name,
+                       (unsigned)phases[i].core, (long long)phases[i].start_us,
+                       (long long)(phases[i].end_us - phases[i].start_us),
+                       (long)phases[i].internal_used, (long)phases[i].psram_used);
+            }
+        }
+        int32_t boot_int = 0;
+        int32_t boot_psram = 0;
+        boot_timeline_heap_used(&g_boot_timeline, &boot_int, &boot_psram);
+        printf("boot heap: internal %ld B, psram %ld B\r\n", (long)boot_int, (long)boot_psram);
+    } else if (strcmp(cmd->args[0], "keying") == 0) {
+        static const char *const names[] = { "key", "dit", "dah", "remote" };
+        for (uint8_t ch = 0; ch < KEY_STATS_CHANNELS; ch++) {
+            key_stats_view_t v[KEY_STATS_WINDOWS];
+            key_stats_get(&g_key_stats, ch, v);
+            if (ch != KEY_EDGE_CH_KEY && v[KEY_STATS_60S].duty_pm == 0) {
+                continue;
+            }
+            printf("%-9s %9s %9s %9s\r\n", names[ch], "1s", "10s", "60s");
+            printf("  wpm    ");
+            for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+                printf(" %7u.%u", v[w].wpm_x10 / 10U, v[w].wpm_x10 % 10U);
+            }
+            printf("\r\n  weight ");
+            for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+                printf(" %6u.%u%%", v[w].weight_pm / 10U, v[w].weight_pm % 10U);
+            }
+            printf("\r\n  dah/dit");
+            for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+                printf(" %6u.%02u", v[w].dah_ratio_x100 / 100U, v[w].dah_ratio_x100 % 100U);
+            }
+            printf("\r\n  chargap");
+            for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+                printf(" %6u.%02u", v[w].char_gap_x100 / 100U, v[w].char_gap_x100 % 100U);
+            }
+            printf("\r\n  wordgap");
+            for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+                printf(" %6u.%02u", v[w].word_gap_x100 / 100U, v[w].word_gap_x100 % 100U);
+            }
+            printf("\r\n  duty   ");
+            for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+                printf(" %6u.%u%%", v[w].duty_pm / 10U, v[w].duty_pm % 10U);
+            }
+            printf("\r\n  marks  ");
+            for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+                printf(" %9u", (unsigned)v[w].marks);
+            }
+            printf("\r\n");
+        }
+    } else if (strcmp(cmd->args[0], "shed") == 0) {
+        char why[24];
+        unsigned level = load_shed_level(&g_load_shed);
+        printf("load shedding: %s, %u of %u steps shed",
+               CONFIG_GET_LOAD_SHED() ? "on" : "off", level, (unsigned)LOAD_SHED_STEPS);
+        if (level > 0U) {
+            printf(" (%s)", load_shed_why_str(atomic_load_explicit(&g_load_shed.why,
+                                                                   memory_order_relaxed),
+                                              why, sizeof(why)));
+        }
+        printf("\r\nlimits: %u missed ticks/s, lag %u samples\r\n",
+               (unsigned)CONFIG_GET_SHED_MISSES(), (unsigned)CONFIG_GET_SHED_LAG());
+        printf("%-10s %-6s %8s %8s\r\n", "STEP", "STATE", "SHED", "RESTORED");
+        for (int st = 0; st < LOAD_SHED_STEPS; st++) {
+            printf("%-10s %-6s %8lu %8lu\r\n", load_shed_step_str((load_shed_step_t)st),
+                   load_shed_active(&g_load_shed, (load_shed_step_t)st) ? "shed" : "run",
+                   (unsigned long)atomic_load_explicit(&g_load_shed.sheds[st],
+                                                       memory_order_relaxed),
+                   (unsigned long)atomic_load_explicit(&g_load_shed.restores[st],
+                                                       memory_order_relaxed));
+        }
+    } else if (strcmp(cmd->args[0], "svc") == 0) {
+        service_info_t svcs[SERVICE_MAX];
+        size_t n = service_snapshot(&g_services, svcs, SERVICE_MAX);
+        printf("%-12s %4s %8s %6s %10s %10s %8s %8s\r\n", "SERVICE", "PRIO", "PERIOD",
+               "SLEEP", "RUNS", "BUSY_MS", "MAX_US", "OVERRUN");
+        for (size_t i = 0; i < n; i++) {
+            char period[16];
+            if (svcs[i].min_period_ms != 0) {
+                snprintf(period, sizeof(period), "%lu-%lu", (unsigned long)svcs[i].min_period_ms,
+                         (unsigned long)svcs[i].period_ms);
+            } else {
+                snprintf(period, sizeof(period), "%lu", (unsigned long)svcs[i].period_ms);
+            }
+            printf("%-12s %4u %8s %4lums %10lu %10lu %8lu %8lu\r\n", svcs[i].name,
+                   (unsigned)svcs[i].priority, period, (unsigned long)svcs[i].delay_ms,
+                   (unsigned long)svcs[i].runs, (unsigned long)svcs[i].busy_ms,
+                   (unsigned long)svcs[i].max_us, (unsigned long)svcs[i].overruns);
+        }
     } else {
         return CONSOLE_ERR_INVALID_VALUE;
     }
@@ -261,6 +814,7 @@ static console_error_t cmd_reboot(const console_parsed_cmd_t *cmd) {
         return CONSOLE_ERR_REQUIRES_CONFIRM;
     }
 #ifdef ESP_PLATFORM
+    config_persist_flush();  /* A just-issued save must not be lost */
     printf("Rebooting...\r\n");
     vTaskDelay(pdMS_TO_TICKS(100));
     esp_restart();
@@ -271,16 +825,20 @@ static console_error_t cmd_reboot(const console_parsed_cmd_t *cmd) {
 }
 
 /**
- * @brief save - Persist configuration to NVS
+ * @brief save - Persist changed parameters to NVS
+ *
+ * Queued to the persistence worker, which writes once the keyer is
+ * idle so the flash cache stall never lands mid-element.
  */
 static console_error_t cmd_save(const console_parsed_cmd_t *cmd) {
     (void)cmd;
 #ifdef ESP_PLATFORM
-    int ret = config_save_to_nvs();
-    if (ret < 0) {
-        return CONSOLE_ERR_NVS_ERROR;
+    if (!config_any_dirty()) {
+        printf("Nothing to save\r\n");
+        return CONSOLE_OK;
     }
-    printf("Saved %d parameters to NVS\r\n", ret);
+    config_persist_request();
+    printf("Save queued (written when the keyer is idle)\r\n");
 #else
     printf("NVS not available on host\r\n");
 #endif
@@ -291,7 +849,7 @@ static console_error_t cmd_save(const console_parsed_cmd_t *cmd) {
 static void show_param_visitor(const param_descriptor_t *p, void *ctx) {
     (void)ctx;
     char buf[32];
-    config_get_param_str(p->full_path, buf, sizeof(buf));
+    config_format_param(p, buf, sizeof(buf));
     printf("%s=%s\r\n", p->full_path, buf);
 }
 
@@ -338,6 +896,59 @@ static const char *strip_quotes(const char *s, char *buf, size_t buflen) {
     return s;
 }
 
+/**
+ * @brief Check for the multi-parameter form: every arg is key=value
+ */
+static bool set_is_batch(const console_parsed_cmd_t *cmd) {
+    if (cmd->argc < 2) {
+        return false;
+    }
+    for (int i = 0; i < cmd->argc; i++) {
+        const char *eq = strchr(cmd->args[i], '=');
+        if (eq == NULL || eq == cmd->args[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief set a=1 b=2 ... - Apply all under one generation bump
+ */
+static console_error_t cmd_set_batch(const console_parsed_cmd_t *cmd) {
+    static char path_bufs[CONSOLE_MAX_ARGS][64];
+    static char value_bufs[CONSOLE_MAX_ARGS][128];
+    const char *paths[CONSOLE_MAX_ARGS];
+    const char *values[CONSOLE_MAX_ARGS];
+    size_t count = 0;
+
+    for (int i = 0; i < cmd->argc; i++) {
+        const char *eq = strchr(cmd->args[i], '=');
+        size_t path_len = (size_t)(eq - cmd->args[i]);
+        if (path_len >= sizeof(path_bufs[0])) path_len = sizeof(path_bufs[0]) - 1;
+        memcpy(path_bufs[count], cmd->args[i], path_len);
+        path_bufs[count][path_len] = '\0';
+        paths[count] = path_bufs[count];
+        values[count] = strip_quotes(eq + 1, value_bufs[count], sizeof(value_bufs[count]));
+        count++;
+    }
+
+    size_t bad = 0;
+    int ret = config_set_params_batch(paths, values, count, &bad);
+    if (ret != 0) {
+        printf("%s: rejected, nothing applied\r\n", paths[bad]);
+        return (ret == -1) ? CONSOLE_ERR_UNKNOWN_CMD : CONSOLE_ERR_INVALID_VALUE;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        char buf[128];
+        if (config_get_param_str(paths[i], buf, sizeof(buf)) == 0) {
+            printf("%s=%s\r\n", paths[i], buf);
+        }
+    }
+    return CONSOLE_OK;
+}
+
 /**
  * @brief set <path> <value> - Set parameter by path
  *
@@ -347,12 +958,17 @@ static const char *strip_quotes(const char *s, char *buf, size_t buflen) {
  *   set wifi.ssid=MyNetwork
  *   set wifi.ssid = "My Network"
  *   set wpm 25  (legacy, still works)
+ *   set wpm=25 weight=55  (up to 3, applied together)
  */
 static console_error_t cmd_set(const console_parsed_cmd_t *cmd) {
     if (cmd->argc < 1) {
         return CONSOLE_ERR_MISSING_ARG;
     }
 
+    if (set_is_batch(cmd)) {
+        return cmd_set_batch(cmd);
+    }
+
     static char path_buf[64];
     static char value_buf[128];
     const char *path = NULL;
@@ -386,20 +1002,9 @@ static console_error_t cmd_set(const console_parsed_cmd_t *cmd) {
         return CONSOLE_ERR_MISSING_ARG;
     }
 
-    /* Try full path first (config_find_param handles both path and name) */
+    /* Full path, alias path or bare name (config_find_param) */
     int ret = config_set_param_str(path, value);
 
-    /* If not found and no dot, try legacy name lookup */
-    if (ret == -1 && strchr(path, '.') == NULL) {
-        /* Search all params for matching name */
-        for (size_t i = 0; i < CONSOLE_PARAM_COUNT; i++) {
-            if (strcmp(CONSOLE_PARAMS[i].name, path) == 0) {
-                ret = config_set_param_str(CONSOLE_PARAMS[i].full_path, value);
-                break;
-            }
-        }
-    }
-
     switch (ret) {
         case 0:
             /* Show confirmation with new value */
@@ -558,9 +1163,9 @@ static console_error_t cmd_debug(const console_parsed_cmd_t *cmd) {
 #ifdef ESP_PLATFORM
     if (cmd->argc == 0) {
         /* Show brief RT log status */
-        uint32_t rt_dropped = log_stream_dropped(&g_rt_log_stream);
-        printf("RT Log: %lu dropped (use 'debug info' for details)\r\n",
-               (unsigned long)rt_dropped);
+        uint32_t rt_count = log_stream_count(&g_rt_log_stream);
+        printf("RT Log: %lu entries (use 'debug info' for details)\r\n",
+               (unsigned long)rt_count);
         return CONSOLE_OK;
     }
 
@@ -569,14 +1174,14 @@ static console_error_t cmd_debug(const console_parsed_cmd_t *cmd) {
     /* debug info - show RT log buffer status */
     if (strcmp(arg1, "info") == 0) {
         uint32_t rt_count = log_stream_count(&g_rt_log_stream);
-        uint32_t rt_dropped = log_stream_dropped(&g_rt_log_stream);
+        uint32_t rt_bytes = log_stream_bytes(&g_rt_log_stream);
         uint32_t bg_count = log_stream_count(&g_bg_log_stream);
-        uint32_t bg_dropped = log_stream_dropped(&g_bg_log_stream);
+        uint32_t bg_bytes = log_stream_bytes(&g_bg_log_stream);
 
-        printf("RT Log:  %lu/%d entries, %lu dropped\r\n",
-               (unsigned long)rt_count, LOG_BUFFER_SIZE, (unsigned long)rt_dropped);
-        printf("BG Log:  %lu/%d entries, %lu dropped\r\n",
-               (unsigned long)bg_count, LOG_BUFFER_SIZE, (unsigned long)bg_dropped);
+        printf("RT Log:  %lu entries, %lu/%d bytes\r\n",
+               (unsigned long)rt_count, (unsigned long)rt_bytes, LOG_RING_BYTES);
+        printf("BG Log:  %lu entries, %lu/%d bytes\r\n",
+               (unsigned long)bg_count, (unsigned long)bg_bytes, LOG_RING_BYTES);
         printf("Diag:    %s\r\n",
                atomic_load_explicit(&g_rt_diag_enabled, memory_order_relaxed) ? "ON" : "OFF");
         return CONSOLE_OK;
@@ -648,6 +1253,62 @@ static console_error_t cmd_diag(const console_parsed_cmd_t *cmd) {
     return CONSOLE_OK;
 }
 
+/**
+ * @brief latency [on|loopback|off|hist|reset] - Paddle-to-output latency
+ */
+static console_error_t cmd_latency(const console_parsed_cmd_t *cmd) {
+    if (cmd->argc > 0) {
+        const char *arg = cmd->args[0];
+        if (strcmp(arg, "on") == 0) {
+            key_latency_set_mode(&g_key_latency, KEY_LATENCY_ON);
+        } else if (strcmp(arg, "loopback") == 0) {
+            key_latency_set_mode(&g_key_latency, KEY_LATENCY_LOOPBACK);
+#ifdef ESP_PLATFORM
+            if (!hal_audio_input_available()) {
+                printf("No codec input: set audio.rx_decode true, save, reboot\r\n");
+            }
+#endif
+        } else if (strcmp(arg, "off") == 0) {
+            key_latency_set_mode(&g_key_latency, KEY_LATENCY_OFF);
+        } else if (strcmp(arg, "reset") == 0) {
+            key_latency_reset(&g_key_latency);
+            printf("latency reset\r\n");
+            return CONSOLE_OK;
+        } else if (strcmp(arg, "hist") == 0) {
+            /* Non-empty bins per path: "<upper_us>:<count>" */
+            for (int p = 0; p < KEY_LATENCY_PATH_COUNT; p++) {
+                key_latency_snapshot_t ls;
+                key_latency_get(&g_key_latency, (key_latency_path_t)p, &ls);
+                printf("%-9s", key_latency_path_str((key_latency_path_t)p));
+                for (uint32_t b = 0; b < KEY_LATENCY_HIST_BINS; b++) {
+                    if (ls.hist[b] > 0) {
+                        printf(" <%lu:%lu", (unsigned long)key_latency_bin_upper_us(b) + 1UL,
+                               (unsigned long)ls.hist[b]);
+                    }
+                }
+                printf("\r\n");
+            }
+            return CONSOLE_OK;
+        } else {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+    }
+
+    printf("mode:    %s, %lu missed\r\n", key_latency_mode_str(key_latency_get_mode(&g_key_latency)),
+           (unsigned long)atomic_load_explicit(&g_key_latency.missed, memory_order_relaxed));
+    printf("%-9s %8s %8s %8s %8s %8s\r\n", "PATH", "COUNT", "MIN_US", "P50_US", "P99_US",
+           "MAX_US");
+    for (int p = 0; p < KEY_LATENCY_PATH_COUNT; p++) {
+        key_latency_snapshot_t ls;
+        key_latency_get(&g_key_latency, (key_latency_path_t)p, &ls);
+        printf("%-9s %8lu %8lu %8lu %8lu %8lu\r\n", key_latency_path_str((key_latency_path_t)p),
+               (unsigned long)ls.count, (unsigned long)ls.min_us,
+               (unsigned long)key_latency_percentile_us(&ls, 50),
+               (unsigned long)key_latency_percentile_us(&ls, 99), (unsigned long)ls.max_us);
+    }
+    return CONSOLE_OK;
+}
+
 /**
  * @brief gpio - Read raw GPIO state for debugging
  */
@@ -924,6 +1585,51 @@ static console_error_t cmd_decoder(const console_parsed_cmd_t *cmd) {
         return CONSOLE_OK;
     }
 
+    /* decoder mode [ema|cluster] */
+    if (strcmp(arg, "mode") == 0) {
+        if (cmd->argc >= 2) {
+            if (strcmp(cmd->args[1], "ema") == 0) {
+                decoder_set_timing_mode(TIMING_MODE_EMA);
+            } else if (strcmp(cmd->args[1], "cluster") == 0) {
+                decoder_set_timing_mode(TIMING_MODE_CLUSTER);
+            } else {
+                return CONSOLE_ERR_INVALID_VALUE;
+            }
+        }
+        printf("Timing: %s\r\n", timing_mode_str(decoder_get_timing()->mode));
+        return CONSOLE_OK;
+    }
+
+#ifdef ESP_PLATFORM
+    /* decoder rx - off-air decoder (receiver audio) */
+    if (strcmp(arg, "rx") == 0) {
+        if (!CONFIG_GET_RX_DECODE() || !hal_audio_input_available()) {
+            printf("RX decode: off (audio.rx_decode, needs codec input)\r\n");
+            return CONSOLE_OK;
+        }
+        decoder_t *rx = audio_rx_decoder(&g_audio_rx);
+        const tone_detector_stats_t *ds = &g_audio_rx.detector.stats;
+        const audio_rx_stats_t *as = &g_audio_rx.stats;
+        char text[65];
+        decoder_inst_get_text(rx, text, sizeof(text));
+        printf("RX: %s, WPM: %lu, tone: %u Hz (%u-%u Hz, %u bins)\r\n",
+               tone_detector_key_down(&g_audio_rx.detector) ? "MARK" : "space",
+               (unsigned long)decoder_inst_get_wpm(rx), (unsigned)ds->tone_hz,
+               (unsigned)g_audio_rx.detector.config.low_hz,
+               (unsigned)g_audio_rx.detector.config.high_hz,
+               (unsigned)g_audio_rx.detector.bins);
+        printf("Level: noise %.1f dBFS, signal %.1f dBFS, %lu edges\r\n",
+               (double)(10.0f * log10f(ds->noise_power + 1e-12f)),
+               (double)(10.0f * log10f(ds->signal_power + 1e-12f)),
+               (unsigned long)ds->edges);
+        printf("CPU: %lu us avg, %lu us max per %lu us budget, %lu over\r\n",
+               (unsigned long)as->block_us_avg, (unsigned long)as->block_us_max,
+               (unsigned long)as->budget_us, (unsigned long)as->over_budget);
+        printf("Text: \"%s\"\r\n", text);
+        return CONSOLE_OK;
+    }
+#endif
+
     /* decoder clear */
     if (strcmp(arg, "clear") == 0) {
         decoder_reset();
@@ -964,11 +1670,11 @@ static console_error_t cmd_decoder(const console_parsed_cmd_t *cmd) {
         uint32_t wpm = decoder_get_wpm();
         float ratio = timing_classifier_get_ratio(tc);
 
-        printf("WPM: %lu (dit: %lldms, dah: %lldms, ratio: %.2f)\r\n",
+        printf("WPM: %lu (dit: %lldms, dah: %lldms, ratio: %.2f, %s)\r\n",
                (unsigned long)wpm,
                (long long)(tc->dit_avg_us / 1000),
                (long long)(tc->dah_avg_us / 1000),
-               (double)ratio);
+               (double)ratio, timing_mode_str(tc->mode));
         printf("Samples: dit=%lu, dah=%lu\r\n",
                (unsigned long)tc->dit_count,
                (unsigned long)tc->dah_count);
@@ -976,6 +1682,10 @@ static console_error_t cmd_decoder(const console_parsed_cmd_t *cmd) {
                (unsigned long)stats.chars_decoded,
                (unsigned long)stats.words_decoded,
                (unsigned long)stats.errors);
+        printf("Edges: %lu processed, %lu dropped, %lu events tagged\r\n",
+               (unsigned long)stats.edges_processed,
+               (unsigned long)stats.edges_dropped,
+               (unsigned long)stats.tagged_events);
         printf("Buffer: %u/%u chars\r\n",
                (unsigned)decoder_get_buffer_count(),
                (unsigned)decoder_get_buffer_capacity());
@@ -1011,11 +1721,13 @@ static console_error_t cmd_send(const console_parsed_cmd_t *cmd) {
     }
 
     if (text_keyer_send(text) != 0) {
-        printf("Error: already sending or invalid text\r\n");
+        printf("Error: type-ahead full or invalid text\r\n");
         return CONSOLE_ERR_INVALID_VALUE;
     }
 
-    printf("Sending: %s\r\n", text);
+    text_keyer_buffer_t buffer;
+    text_keyer_get_buffer(&buffer);
+    printf("Sending: %s (%u queued)\r\n", text, (unsigned)buffer.queued);
     return CONSOLE_OK;
 }
 
@@ -1037,8 +1749,8 @@ static console_error_t cmd_memory_send(const console_parsed_cmd_t *cmd) {
         return CONSOLE_ERR_INVALID_VALUE;
     }
 
-    if (text_keyer_send(mem.text) != 0) {
-        printf("Error: already sending\r\n");
+    if (text_keyer_send_memory(slot) != 0) {
+        printf("Error: type-ahead full\r\n");
         return CONSOLE_ERR_INVALID_VALUE;
     }
 
@@ -1144,6 +1856,248 @@ static console_error_t cmd_mem(const console_parsed_cmd_t *cmd) {
     return CONSOLE_OK;
 }
 
+/**
+ * @brief macro [call|rst <value>|serial <n>] - Contest macro fields
+ */
+static console_error_t cmd_macro(const console_parsed_cmd_t *cmd) {
+    if (cmd->argc == 0) {
+        text_macro_values_t v;
+        text_macro_get_values(&v);
+        printf("{SERIAL}: %03lu\r\n", (unsigned long)v.serial);
+        printf("{CALL}:   %s\r\n", v.call[0] != '\0' ? v.call : "(empty)");
+        printf("{MYCALL}: %s\r\n", CONFIG_GET_CALLSIGN());
+        printf("{RST}:    %s\r\n", v.rst);
+        return CONSOLE_OK;
+    }
+
+    if (strcmp(cmd->args[0], "serial") == 0) {
+        if (cmd->argc < 2 || cmd->args[1] == NULL) {
+            return CONSOLE_ERR_MISSING_ARG;
+        }
+        char *end;
+        unsigned long serial = strtoul(cmd->args[1], &end, 10);
+        if (*end != '\0' || serial > 99999UL) {
+            printf("Error: serial must be 0-99999\r\n");
+            return CONSOLE_ERR_OUT_OF_RANGE;
+        }
+        text_macro_set_serial((uint32_t)serial);
+        printf("Serial set to %03lu\r\n", serial);
+        return CONSOLE_OK;
+    }
+
+    text_macro_field_t field;
+    if (strcmp(cmd->args[0], "call") == 0) {
+        field = TEXT_MACRO_CALL;
+    } else if (strcmp(cmd->args[0], "rst") == 0) {
+        field = TEXT_MACRO_RST;
+    } else {
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+
+    /* No value clears the field */
+    const char *value = (cmd->argc > 1) ? cmd->args[1] : NULL;
+    text_macro_set_field(field, value);
+    text_macro_values_t v;
+    text_macro_get_values(&v);
+    printf("{%s} set to '%s'\r\n", text_macro_field_name(field),
+           field == TEXT_MACRO_CALL ? v.call : v.rst);
+    return CONSOLE_OK;
+}
+
+/**
+ * @brief wk - WinKeyer host ports status (USB and TCP)
+ */
+static console_error_t cmd_wk(const console_parsed_cmd_t *cmd) {
+    (void)cmd;
+    const winkeyer_t *wk = usb_winkeyer_engine();
+    if (wk == NULL) {
+        printf("WinKeyer USB: off (set winkeyer.wk_usb true, reboot)\r\n");
+    } else {
+        printf("WinKeyer USB: CDC%d, host %s\r\n", CDC_ITF_WINKEYER,
+               winkeyer_host_open(wk) ? "open" : "closed");
+        printf("  commands=%lu text=%lu status=%lu pot=%lu\r\n",
+               (unsigned long)wk->stats.commands, (unsigned long)wk->stats.text_bytes,
+               (unsigned long)wk->stats.status_sent, (unsigned long)wk->stats.pot_sent);
+    }
+
+    winkeyer_tcp_info_t tcp;
+    winkeyer_tcp_get_info(&tcp);
+    if (tcp.port == 0) {
+        printf("WinKeyer TCP: off (set winkeyer.wk_tcp_port, reboot)\r\n");
+        return CONSOLE_OK;
+    }
+    printf("WinKeyer TCP: port %u, %u/%d sessions (%u host open)\r\n",
+           (unsigned)tcp.port, (unsigned)tcp.sessions, WINKEYER_TCP_MAX_SESSIONS,
+           (unsigned)tcp.host_open);
+    printf("  accepted=%lu refused=%lu commands=%lu text=%lu\r\n",
+           (unsigned long)tcp.accepted, (unsigned long)tcp.refused,
+           (unsigned long)tcp.stats.commands, (unsigned long)tcp.stats.text_bytes);
+    return CONSOLE_OK;
+}
+
+static const char *const k_preset_memory[] = { "none", "dot", "dah", "both" };
+
+static void preset_print(uint32_t index) {
+    const iambic_preset_t *p = iambic_preset_get(index);
+    bool used = iambic_preset_in_use() && iambic_preset_active_index() == index;
+    printf("P%lu%s %-12s %3lu WPM, mode %c, memory %s, latch %s, window %u-%u%%\r\n",
+           (unsigned long)index + 1UL, used ? "*" : " ",
+           p->name[0] != '\0' ? p->name : "(unnamed)",
+           (unsigned long)iambic_preset_get_wpm(p),
+           iambic_preset_get_mode(p) == IAMBIC_MODE_B ? 'B' : 'A',
+           k_preset_memory[iambic_preset_get_memory_mode(p)],
+           iambic_preset_get_squeeze_mode(p) == SQUEEZE_MODE_LATCH_ON ? "on" : "off",
+           (unsigned)iambic_preset_get_mem_start(p), (unsigned)iambic_preset_get_mem_end(p));
+}
+
+/**
+ * @brief Apply "preset <n> <field> <value>" to a preset
+ */
+static console_error_t preset_edit(uint32_t index, const char *field, const char *value) {
+    iambic_preset_t *p = iambic_preset_get_mut(index);
+
+    if (strcmp(field, "name") == 0) {
+        (void)iambic_preset_set_name(index, value);
+        return CONSOLE_OK;
+    }
+    if (strcmp(field, "mode") == 0) {
+        if (strcmp(value, "A") != 0 && strcmp(value, "B") != 0) {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        iambic_preset_set_mode(p, value[0] == 'B' ? IAMBIC_MODE_B : IAMBIC_MODE_A);
+        return CONSOLE_OK;
+    }
+    if (strcmp(field, "memory") == 0) {
+        for (size_t i = 0; i < sizeof(k_preset_memory) / sizeof(k_preset_memory[0]); i++) {
+            if (strcmp(value, k_preset_memory[i]) == 0) {
+                iambic_preset_set_memory_mode(p, (memory_mode_t)i);
+                return CONSOLE_OK;
+            }
+        }
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+    if (strcmp(field, "latch") == 0) {
+        if (strcmp(value, "on") != 0 && strcmp(value, "off") != 0) {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        iambic_preset_set_squeeze_mode(p, strcmp(value, "on") == 0 ? SQUEEZE_MODE_LATCH_ON
+                                                                   : SQUEEZE_MODE_LATCH_OFF);
+        return CONSOLE_OK;
+    }
+
+    char *end = NULL;
+    unsigned long v = strtoul(value, &end, 10);
+    if (end == value || *end != '\0') {
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+    if (strcmp(field, "wpm") == 0) {
+        if (v < 5UL || v > 100UL) {
+            return CONSOLE_ERR_OUT_OF_RANGE;
+        }
+        iambic_preset_set_wpm(p, (uint32_t)v);
+        return CONSOLE_OK;
+    }
+    if (strcmp(field, "start") == 0 || strcmp(field, "end") == 0) {
+        if (v > 100UL) {
+            return CONSOLE_ERR_OUT_OF_RANGE;
+        }
+        if (field[0] == 's') {
+            iambic_preset_set_mem_start(p, (uint8_t)v);
+        } else {
+            iambic_preset_set_mem_end(p, (uint8_t)v);
+        }
+        return CONSOLE_OK;
+    }
+    return CONSOLE_ERR_INVALID_VALUE;
+}
+
+/**
+ * @brief preset [off|<n> [<field> <value>]] - Iambic presets
+ *
+ * Selecting goes through keyer.preset, like the web UI, so it persists
+ * with the other parameters; edits save the presets blob at once.
+ */
+static console_error_t cmd_preset(const console_parsed_cmd_t *cmd) {
+    if (cmd->argc == 0) {
+        for (uint32_t i = 0; i < IAMBIC_PRESET_COUNT; i++) {
+            preset_print(i);
+        }
+        if (!iambic_preset_in_use()) {
+            printf("None in use: keyer.* parameters\r\n");
+        }
+        return CONSOLE_OK;
+    }
+
+    if (strcmp(cmd->args[0], "off") == 0) {
+        return config_set_param_str("keyer.preset", "0") == 0 ? CONSOLE_OK
+                                                               : CONSOLE_ERR_INVALID_VALUE;
+    }
+
+    char *end = NULL;
+    unsigned long n = strtoul(cmd->args[0], &end, 10);
+    if (end == cmd->args[0] || *end != '\0') {
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+    if (n < 1UL || n > IAMBIC_PRESET_COUNT) {
+        return CONSOLE_ERR_OUT_OF_RANGE;
+    }
+    uint32_t index = (uint32_t)n - 1U;
+
+    if (cmd->argc == 1) {
+        if (config_set_param_str("keyer.preset", cmd->args[0]) != 0) {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        printf("P%lu selected (from the next element)\r\n", n);
+        return CONSOLE_OK;
+    }
+    if (cmd->argc < 3 || cmd->args[2] == NULL) {
+        return CONSOLE_ERR_MISSING_ARG;
+    }
+
+    console_error_t err = preset_edit(index, cmd->args[1], cmd->args[2]);
+    if (err != CONSOLE_OK) {
+        return err;
+    }
+    preset_print(index);
+    if (!iambic_preset_save()) {
+        printf("Presets not saved\r\n");
+        return CONSOLE_ERR_NVS_ERROR;
+    }
+    return CONSOLE_OK;
+}
+
+/**
+ * @brief radio [1|2] - SO2R focus
+ */
+static console_error_t cmd_radio(const console_parsed_cmd_t *cmd) {
+    if (cmd->argc >= 1) {
+        char *end = NULL;
+        unsigned long radio = strtoul(cmd->args[0], &end, 10);
+        if (end == cmd->args[0] || *end != '\0') {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        if (radio < 1UL || radio > RADIO_FOCUS_MAX) {
+            return CONSOLE_ERR_OUT_OF_RANGE;
+        }
+        if (config_set_param_str("keyer.radio", cmd->args[0]) != 0) {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+    }
+
+    radio_focus_stats_t st;
+    radio_focus_get(&g_radio_focus, &st);
+    printf("Radio %u", (unsigned)st.active + 1U);
+    if (!st.available) {
+        printf(" (radio %u has no TX output: set hardware.gpio_tx2, reboot)",
+               (unsigned)st.requested + 1U);
+    } else if (st.requested != st.active) {
+        printf(" (radio %u when idle)", (unsigned)st.requested + 1U);
+    }
+    printf(", %u outputs, switches=%lu\r\n", (unsigned)st.count,
+           (unsigned long)st.switches);
+    return CONSOLE_OK;
+}
+
 /**
  * @brief vpn - WireGuard VPN control
  */
@@ -1195,6 +2149,7 @@ static console_error_t cmd_vpn(const console_parsed_cmd_t *cmd) {
         /* Detailed status */
         vpn_state_t state = vpn_get_state();
         printf("State: %s\r\n", vpn_state_str(state));
+        printf("Clock: %s\r\n", vpn_clock_source_str(vpn_get_clock_source()));
         printf("Config:\r\n");
         printf("  Enabled:   %s\r\n",
                atomic_load_explicit(&g_config.vpn.enabled, memory_order_relaxed) ? "yes" : "no");
@@ -1210,6 +2165,15 @@ static console_error_t cmd_vpn(const console_parsed_cmd_t *cmd) {
             if (vpn_get_stats(&stats)) {
                 printf("Stats:\r\n");
                 printf("  Handshakes: %u\r\n", (unsigned)stats.handshakes);
+                printf("  TX: %u pkts, %llu bytes, %u cyc/pkt (max %u), %u heap allocs\r\n",
+                       (unsigned)stats.tx_packets, (unsigned long long)stats.tx_bytes,
+                       (unsigned)stats.tx_cycles_avg, (unsigned)stats.tx_cycles_max,
+                       (unsigned)stats.tx_pool_misses);
+                printf("  RX: %u pkts, %llu bytes, %u cyc/pkt (max %u)\r\n",
+                       (unsigned)stats.rx_packets, (unsigned long long)stats.rx_bytes,
+                       (unsigned)stats.rx_cycles_avg, (unsigned)stats.rx_cycles_max);
+                printf("  Timer: %u wakeups, %u keepalives\r\n",
+                       (unsigned)stats.timer_wakeups, (unsigned)stats.keepalives);
             }
         }
         return CONSOLE_OK;
@@ -1219,6 +2183,306 @@ static console_error_t cmd_vpn(const console_parsed_cmd_t *cmd) {
     return CONSOLE_ERR_INVALID_VALUE;
 }
 
+/**
+ * @brief export - Dump keying history as a hex-encoded .cwk recording
+ *
+ * Same bytes as /api/stream/export, 32 per line between "cwk begin" and
+ * "cwk end" markers; tools/cwk/cwk_convert.py reads the captured text.
+ */
+static console_error_t cmd_export(const console_parsed_cmd_t *cmd) {
+#ifdef ESP_PLATFORM
+    uint64_t window_ticks = 0;
+    if (cmd->argc > 0) {
+        char *end = NULL;
+        unsigned long seconds = strtoul(cmd->args[0], &end, 10);
+        if (end == cmd->args[0] || *end != '\0') {
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        uint32_t tick_us = stream_tick_period_us(&g_keying_stream);
+        window_ticks = (uint64_t)seconds * 1000000ULL / (tick_us ? tick_us : 1000U);
+    }
+
+    stream_export_t exp;
+    stream_export_begin(&exp, &g_keying_stream, window_ticks, (uint64_t)esp_timer_get_time());
+    printf("cwk begin %u bytes\r\n", (unsigned)stream_export_size(&exp));
+
+    uint8_t chunk[32];
+    size_t n;
+    while ((n = stream_export_read(&exp, chunk, sizeof(chunk))) > 0) {
+        char line[2 * sizeof(chunk) + 3];
+        for (size_t i = 0; i < n; i++) {
+            snprintf(&line[2 * i], 3, "%02x", chunk[i]);
+        }
+        printf("%s\r\n", line);
+    }
+    printf("cwk end%s\r\n", exp.lost ? " (truncated: history overwritten)" : "");
+    return CONSOLE_OK;
+#else
+    (void)cmd;
+    printf("export not available on host\r\n");
+    return CONSOLE_OK;
+#endif
+}
+
+/**
+ * @brief rec [list|new] - Flash keying recorder (recorder.h)
+ */
+static console_error_t cmd_rec(const console_parsed_cmd_t *cmd) {
+#ifdef ESP_PLATFORM
+    if (cmd->argc > 0 && strcmp(cmd->args[0], "new") == 0) {
+        recorder_new_session();
+        printf("New session on the next pass\r\n");
+        return CONSOLE_OK;
+    }
+
+    if (cmd->argc > 0 && strcmp(cmd->args[0], "list") == 0) {
+        static stream_rec_session_t sessions[STREAM_REC_MAX_SESSIONS];
+        size_t n = recorder_get_sessions(sessions, STREAM_REC_MAX_SESSIONS);
+        if (n == 0) {
+            printf("No sessions\r\n");
+            return CONSOLE_OK;
+        }
+        printf("  id  chunks  duration  start\r\n");
+        for (size_t i = 0; i < n; i++) {
+            const stream_rec_session_t *s = &sessions[i];
+            uint64_t secs = (s->end_tick - s->first_tick) * s->tick_us / 1000000ULL;
+            printf("%4lu  %6lu  %5lu:%02lu  ", (unsigned long)s->id,
+                   (unsigned long)s->chunks, (unsigned long)(secs / 60),
+                   (unsigned long)(secs % 60));
+            if (s->unix_us > 0) {
+                time_t t = (time_t)(s->unix_us / 1000000);
+                struct tm tm;
+                char when[24];
+                gmtime_r(&t, &tm);
+                strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%SZ", &tm);
+                printf("%s\r\n", when);
+            } else {
+                printf("(no clock)\r\n");
+            }
+        }
+        return CONSOLE_OK;
+    }
+
+    if (cmd->argc > 0) {
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+
+    recorder_stats_t st;
+    recorder_get_stats(&st);
+    if (!st.mounted) {
+        printf("Recorder: no partition\r\n");
+        return CONSOLE_OK;
+    }
+    printf("Recorder: %s, session %lu, %lu sessions\r\n",
+           st.recording ? "recording" : "off", (unsigned long)st.session,
+           (unsigned long)st.sessions);
+    printf("  flash:  %lu/%lu chunks used, %lu erased ahead\r\n",
+           (unsigned long)st.used, (unsigned long)st.chunks,
+           (unsigned long)st.erased_ahead);
+    printf("  queue:  %lu/%lu, written=%lu dropped=%lu resyncs=%lu\r\n",
+           (unsigned long)st.queued, (unsigned long)st.queue_size,
+           (unsigned long)st.chunks_written, (unsigned long)st.chunks_dropped,
+           (unsigned long)st.resyncs);
+    printf("  write:  slice %lu B, max %lu us (bound %lu, over %lu)\r\n",
+           (unsigned long)st.slice_bytes, (unsigned long)st.write_max_us,
+           (unsigned long)st.bound_us, (unsigned long)st.write_over);
+    printf("  erase:  %lu, max %lu us, errors=%lu\r\n",
+           (unsigned long)st.erases, (unsigned long)st.erase_max_us,
+           (unsigned long)st.errors);
+    return CONSOLE_OK;
+#else
+    (void)cmd;
+    printf("rec not available on host\r\n");
+    return CONSOLE_OK;
+#endif
+}
+
+/**
+ * @brief bench [prefix] - On-target microbenchmarks (bench.h)
+ *
+ * Prints the table, then the same results as one JSON line to paste
+ * next to bench_host output or another board's.
+ */
+static console_error_t cmd_bench(const console_parsed_cmd_t *cmd) {
+#ifdef ESP_PLATFORM
+    static bench_result_t results[BENCH_MAX_RESULTS];
+    static char json[4096];
+    const char *filter = (cmd->argc > 0) ? cmd->args[0] : NULL;
+
+    printf("Running benchmarks...\r\n");
+    int n = bench_run(filter, results, BENCH_MAX_RESULTS);
+    if (n < 0) {
+        printf("Benchmark already running\r\n");
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+    if (n == 0) {
+        printf("No kernel matches '%s'\r\n", filter ? filter : "");
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+    uint32_t mhz = bench_cpu_mhz();
+    printf("%-28s %8s %12s %12s\r\n", "KERNEL", "OPS", "CYCLES/OP", "NS/OP");
+    for (int i = 0; i < n; i++) {
+        uint64_t c;
+        uint64_t ns;
+        bench_per_op(&results[i], mhz, &c, &ns);
+        printf("%-28s %8lu %9llu.%02u %9llu.%02u\r\n", results[i].name,
+               (unsigned long)results[i].ops,
+               (unsigned long long)(c / 100U), (unsigned)(c % 100U),
+               (unsigned long long)(ns / 100U), (unsigned)(ns % 100U));
+    }
+    printf("CPU %lu MHz, best of %d\r\n", (unsigned long)mhz, BENCH_REPS);
+
+    /* printf goes out in 256-byte pieces: the JSON line in slices */
+    size_t len = bench_format_json(results, (size_t)n, json, sizeof(json));
+    for (size_t off = 0; off < len; off += 200U) {
+        printf("%.200s", &json[off]);
+    }
+    printf("\r\n");
+    return CONSOLE_OK;
+#else
+    (void)cmd;
+    printf("bench not available on host\r\n");
+    return CONSOLE_OK;
+#endif
+}
+
+/* Bytes per "profile load" line: the whole line fits CONSOLE_LINE_MAX */
+#define PROFILE_LINE_BYTES 24
+
+/* Profile being pasted back with "profile load" lines */
+static EXT_RAM_BSS_ATTR uint8_t s_profile[CONFIG_PROFILE_MAX_SIZE];
+static size_t s_profile_len;
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief profile save | profile load begin|<hex>|end
+ *
+ * "save" prints the settings profile (config_profile.h) as the very
+ * "profile load" lines that restore it, so a captured log can be pasted
+ * into this keyer or another one as it is.
+ */
+static console_error_t cmd_profile(const console_parsed_cmd_t *cmd) {
+    if (cmd->argc == 0) {
+        return CONSOLE_ERR_MISSING_ARG;
+    }
+
+    if (strcmp(cmd->args[0], "save") == 0) {
+        size_t len = config_profile_export(s_profile, sizeof(s_profile));
+        s_profile_len = 0;
+        if (len == 0) {
+            printf("Profile too large\r\n");
+            return CONSOLE_ERR_OUT_OF_RANGE;
+        }
+        printf("profile load begin\r\n");
+        for (size_t off = 0; off < len; off += PROFILE_LINE_BYTES) {
+            size_t n = (len - off < PROFILE_LINE_BYTES) ? len - off : PROFILE_LINE_BYTES;
+            char line[2 * PROFILE_LINE_BYTES + 1];
+            for (size_t i = 0; i < n; i++) {
+                snprintf(&line[2 * i], 3, "%02x", s_profile[off + i]);
+            }
+            printf("profile load %s\r\n", line);
+        }
+        printf("profile load end\r\n");
+        return CONSOLE_OK;
+    }
+
+    if (strcmp(cmd->args[0], "load") != 0) {
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+    if (cmd->argc < 2 || cmd->args[1] == NULL) {
+        return CONSOLE_ERR_MISSING_ARG;
+    }
+    const char *arg = cmd->args[1];
+
+    if (strcmp(arg, "begin") == 0) {
+        s_profile_len = 0;
+        return CONSOLE_OK;
+    }
+
+    if (strcmp(arg, "end") == 0) {
+        config_profile_result_t res;
+        int err = config_profile_import(s_profile, s_profile_len, &res);
+        s_profile_len = 0;
+        if (err != 0 && err != CONFIG_PROFILE_ERR_SAVE) {
+            printf("Profile rejected: %s%s%s\r\n", config_profile_strerror(err),
+                   res.bad_key ? " " : "", res.bad_key ? res.bad_key : "");
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        printf("Profile applied: %u parameters, %u unknown, %u memories\r\n",
+               res.applied, res.skipped, res.memories);
+        if (err != 0) {
+            printf("%s\r\n", config_profile_strerror(err));
+            return CONSOLE_ERR_NVS_ERROR;
+        }
+        return CONSOLE_OK;
+    }
+
+    /* A line of hex, appended to what was pasted since "begin" */
+    size_t digits = strlen(arg);
+    if (digits % 2U != 0 || s_profile_len + digits / 2U > sizeof(s_profile)) {
+        s_profile_len = 0;
+        return CONSOLE_ERR_INVALID_VALUE;
+    }
+    for (size_t i = 0; i < digits; i += 2U) {
+        int hi = hex_nibble(arg[i]);
+        int lo = hex_nibble(arg[i + 1U]);
+        if (hi < 0 || lo < 0) {
+            s_profile_len = 0;
+            return CONSOLE_ERR_INVALID_VALUE;
+        }
+        s_profile[s_profile_len++] = (uint8_t)((hi << 4) | lo);
+    }
+    return CONSOLE_OK;
+}
+
+/**
+ * @brief fdr - Dump the flight recorder (faults, key edges, stage peaks)
+ *
+ * Oldest first, across the boots since power-on. Times are seconds since
+ * the boot an event belongs to.
+ */
+static console_error_t cmd_fdr(const console_parsed_cmd_t *cmd) {
+    (void)cmd;
+    static flight_rec_event_t events[FLIGHT_REC_MAX_EVENTS];
+    size_t n = flight_rec_snapshot(&g_flight_rec, events, FLIGHT_REC_MAX_EVENTS);
+    printf("flight recorder: boot %lu, %u events\r\n",
+           (unsigned long)g_flight_rec.boot_count, (unsigned)n);
+
+    for (size_t i = 0; i < n; i++) {
+        const flight_rec_event_t *ev = &events[i];
+        printf("#%-5u %6lld.%06lld %-5s ", (unsigned)ev->boot,
+               (long long)(ev->time_us / 1000000), (long long)(ev->time_us % 1000000),
+               flight_rec_type_str(ev->type));
+        switch (ev->type) {
+            case FLIGHT_EV_BOOT:
+                printf("reset=%s\r\n", flight_rec_reset_str(ev->code));
+                break;
+            case FLIGHT_EV_FAULT:
+                printf("%s data=%lu\r\n", fault_code_str((fault_code_t)ev->code),
+                       (unsigned long)ev->value);
+                break;
+            case FLIGHT_EV_EDGE:
+                printf("%s after %luus\r\n", ev->code ? "down" : "up",
+                       (unsigned long)ev->value);
+                break;
+            case FLIGHT_EV_STAGE:
+                printf("%s max=%lu cycles\r\n", rt_prof_stage_str((rt_prof_stage_t)ev->code),
+                       (unsigned long)ev->value);
+                break;
+            default:
+                printf("code=%u value=%lu\r\n", (unsigned)ev->code, (unsigned long)ev->value);
+                break;
+        }
+    }
+    return CONSOLE_OK;
+}
+
 /* ============================================================================
  * Command registry
  * ============================================================================ */
@@ -1233,10 +2497,27 @@ static const char USAGE_LOG[] =
 
 static const char USAGE_STATS[] =
     "  stats               Overview (uptime, heap, stream)\r\n"
-    "  stats heap          Heap memory details\r\n"
-    "  stats tasks         Task list by core\r\n"
-    "  stats stream        Stream buffer status\r\n"
-    "  stats rt            RT task statistics";
+    "  stats heap          Heap per capability, low water per minute\r\n"
+    "  stats tasks         Task list by core, CPU% and idle% (last second)\r\n"
+    "  stats stream        Stream buffer status, consumer lag\r\n"
+    "  stats audio         Audio output path, ring underrun/overrun\r\n"
+    "  stats cwnet         CWNet edge-to-send latency histogram (us)\r\n"
+    "  stats nvs           Config persistence commits and timing\r\n"
+    "  stats espnow        ESP-NOW link frames, repairs and losses\r\n"
+    "  stats usb           USB functions, console output, MIDI/HID\r\n"
+    "  stats console       Telnet console sessions and output drops\r\n"
+    "  stats syslog        Remote syslog datagrams, drops and errors\r\n"
+    "  stats feed          Logger feed datagrams, drops and errors\r\n"
+    "  stats watch <ms> [groups]  Live lines: rt,lag,cwnet,vpn,heap (all)\r\n"
+    "  stats watch off     Stop the live lines\r\n"
+    "  stats log           UART log baud, throughput and drops\r\n"
+    "  stats rt            RT loop pacing, wake jitter, stage cycles\r\n"
+    "  stats rt hist       Stage cycle log2 histograms\r\n"
+    "  stats rt reset      Reset RT statistics\r\n"
+    "  stats boot          Boot phases: time, core, heap taken\r\n"
+    "  stats svc           Core 1 services: passes, busy time, overruns\r\n"
+    "  stats shed          Load shedding: steps shed, sheds and restores\r\n"
+    "  stats keying        Sent speed, weight, spacing, duty (1s/10s/60s)";
 
 static const char USAGE_SHOW[] =
     "  show                  All parameters\r\n"
@@ -1258,7 +2539,8 @@ static const char USAGE_SET[] =
     "Examples:\r\n"
     "  set keyer.wpm 25\r\n"
     "  set audio.sidetone_freq_hz 700\r\n"
-    "  set wpm 25              (legacy shorthand)";
+    "  set wpm 25              (legacy shorthand)\r\n"
+    "  set wpm=25 weight=55    (several at once, all or nothing)";
 
 static const char USAGE_DEBUG[] =
     "  debug               Show RT log status\r\n"
@@ -1271,11 +2553,21 @@ static const char USAGE_DIAG[] =
     "  diag on             Enable RT diagnostic logging\r\n"
     "  diag off            Disable RT diagnostic logging";
 
+static const char USAGE_LATENCY[] =
+    "  latency             Mode and per-path min/p50/p99/max (us)\r\n"
+    "  latency on          Time presses from idle: edge -> TX, sidetone to I2S\r\n"
+    "  latency loopback    Also sidetone back from the codec ADC (wire out->in)\r\n"
+    "  latency off         Stop measuring\r\n"
+    "  latency hist        Histogram bins per path\r\n"
+    "  latency reset       Clear the histograms";
+
 static const char USAGE_DECODER[] =
     "  decoder             Show status and last decoded text\r\n"
     "  decoder on|off      Enable/disable decoder\r\n"
     "  decoder text        Show buffer with timestamps\r\n"
     "  decoder stats       Show timing statistics\r\n"
+    "  decoder mode [ema|cluster]  Show/select timing classifier\r\n"
+    "  decoder rx          Off-air decoder (receiver audio) status\r\n"
     "  decoder clear       Clear buffer and reset timing";
 
 static const char USAGE_SEND[] =
@@ -1293,7 +2585,56 @@ static const char USAGE_MEM[] =
     "  mem <slot>          Show slot (1-8)\r\n"
     "  mem <slot> <text>   Save text to slot\r\n"
     "  mem <slot> clear    Clear slot\r\n"
-    "  mem <slot> label X  Set slot label";
+    "  mem <slot> label X  Set slot label\r\n"
+    "  Text can hold {SERIAL} {CALL} {MYCALL} {RST}";
+
+static const char USAGE_MACRO[] =
+    "  macro               Show field values\r\n"
+    "  macro call [X]      Set (or clear) {CALL}\r\n"
+    "  macro rst [X]       Set {RST} (default 599)\r\n"
+    "  macro serial <n>    Set {SERIAL}, advances after each send";
+
+static const char USAGE_EXPORT[] =
+    "  export              Dump all keying history (.cwk, hex)\r\n"
+    "  export <seconds>    Dump the last N seconds\r\n"
+    "\r\n"
+    "Convert with: tools/cwk/cwk_convert.py capture.txt --csv|--vcd";
+
+static const char USAGE_REC[] =
+    "  rec                 Recorder status\r\n"
+    "  rec list            Sessions on flash\r\n"
+    "  rec new             Close this session, start another\r\n"
+    "\r\n"
+    "Enable with: set system.recorder on\r\n"
+    "Download: GET /api/stream/export?session=N";
+
+static const char USAGE_BENCH[] =
+    "  bench               Run every kernel (about a second)\r\n"
+    "  bench <prefix>      Only kernels named prefix* (wg_, stream_, ...)\r\n"
+    "\r\n"
+    "Table, then one JSON line (schema as test_host bench_host)";
+
+static const char USAGE_PROFILE[] =
+    "  profile save        Print parameters and memories as load lines\r\n"
+    "  profile load begin  Start a paste (then the hex lines)\r\n"
+    "  profile load end    Check and apply what was pasted\r\n"
+    "\r\n"
+    "All or nothing: one config change, saved when the keyer is idle";
+
+static const char USAGE_PRESET[] =
+    "  preset              List presets (* = in use)\r\n"
+    "  preset <1-10>       Use a preset (set keyer.preset <n>)\r\n"
+    "  preset off          Back to the keyer.* parameters\r\n"
+    "  preset <n> <field> <value>  Edit and save a preset\r\n"
+    "\r\n"
+    "Fields: wpm 5-100, mode A|B, memory none|dot|dah|both,\r\n"
+    "  latch on|off, start|end 0-100 (memory window %), name";
+
+static const char USAGE_RADIO[] =
+    "  radio               Show the radio in focus\r\n"
+    "  radio 1|2           Key radio 1 or 2 (taken between characters)\r\n"
+    "\r\n"
+    "Same as: set keyer.radio <n>; radio 2 needs hardware.gpio_tx2";
 
 static const char USAGE_VPN[] =
     "  vpn                 Show VPN status\r\n"
@@ -1322,6 +2663,7 @@ static const console_cmd_t s_commands[] = {
     { "flash",         "Enter bootloader mode",        NULL,        cmd_uf2 },
     { "factory-reset", "Erase NVS and reboot",         NULL,        cmd_factory_reset },
     { "diag",          "RT diagnostic logging",        USAGE_DIAG,  cmd_diag },
+    { "latency",       "Paddle-to-output latency",     USAGE_LATENCY, cmd_latency },
     { "decoder",       "CW decoder control",           USAGE_DECODER, cmd_decoder },
     { "test",          "Diagnostic tests",             NULL,        cmd_test },
     { "gpio",          "Read raw GPIO state",          NULL,        cmd_gpio },
@@ -1338,11 +2680,41 @@ static const console_cmd_t s_commands[] = {
     { "pause",         "Pause CW transmission",        NULL,        cmd_pause },
     { "resume",        "Resume CW transmission",       NULL,        cmd_resume },
     { "mem",           "Memory slot management",       USAGE_MEM,   cmd_mem },
+    { "macro",         "Contest macro fields",         USAGE_MACRO, cmd_macro },
     { "vpn",           "WireGuard VPN control",        USAGE_VPN,   cmd_vpn },
+    { "wk",            "WinKeyer host ports status",    NULL,        cmd_wk },
+    { "preset",        "Iambic presets",               USAGE_PRESET, cmd_preset },
+    { "radio",         "SO2R radio focus",             USAGE_RADIO, cmd_radio },
+    { "export",        "Export keying history",        USAGE_EXPORT, cmd_export },
+    { "rec",           "Flash keying recorder",        USAGE_REC,    cmd_rec },
+    { "profile",       "Settings profile save/load",   USAGE_PROFILE, cmd_profile },
+    { "bench",         "Run microbenchmarks",          USAGE_BENCH, cmd_bench },
+    { "fdr",           "Dump fault flight recorder",   NULL,        cmd_fdr },
 };
 
 #define NUM_COMMANDS (sizeof(s_commands) / sizeof(s_commands[0]))
 
+/*
+ * Name index over s_commands[]: open addressing with config_name_hash(),
+ * a power of two at least twice the table so probes stay short. Slots
+ * hold index + 1 (0 = empty). Built on first use by the console task.
+ */
+#define CMD_INDEX_SIZE 128U
+_Static_assert(NUM_COMMANDS * 2U <= CMD_INDEX_SIZE, "grow CMD_INDEX_SIZE");
+static uint8_t s_cmd_index[CMD_INDEX_SIZE];
+static bool s_cmd_index_built;
+
+static void cmd_index_build(void) {
+    for (size_t i = 0; i < NUM_COMMANDS; i++) {
+        uint32_t slot = config_name_hash(s_commands[i].name, 0) & (CMD_INDEX_SIZE - 1U);
+        while (s_cmd_index[slot] != 0) {
+            slot = (slot + 1U) & (CMD_INDEX_SIZE - 1U);
+        }
+        s_cmd_index[slot] = (uint8_t)(i + 1U);
+    }
+    s_cmd_index_built = true;
+}
+
 const console_cmd_t *console_get_commands(size_t *count) {
     if (count != NULL) {
         *count = NUM_COMMANDS;
@@ -1354,10 +2726,16 @@ const console_cmd_t *console_find_command(const char *name) {
     if (name == NULL || *name == '\0') {
         return NULL;
     }
-    for (size_t i = 0; i < NUM_COMMANDS; i++) {
-        if (strcmp(s_commands[i].name, name) == 0) {
-            return &s_commands[i];
+    if (!s_cmd_index_built) {
+        cmd_index_build();
+    }
+    uint32_t slot = config_name_hash(name, 0) & (CMD_INDEX_SIZE - 1U);
+    while (s_cmd_index[slot] != 0) {
+        const console_cmd_t *c = &s_commands[s_cmd_index[slot] - 1U];
+        if (strcmp(c->name, name) == 0) {
+            return c;
         }
+        slot = (slot + 1U) & (CMD_INDEX_SIZE - 1U);
     }
     return NULL;
 }
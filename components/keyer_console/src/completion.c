@@ -13,10 +13,9 @@
 #include <stddef.h>
 
 #ifdef ESP_PLATFORM
-#include "usb_console.h"
-/* Use USB console printf for console output (skip for IDE analyzers) */
+/* Match lists go to the session being served (skip for IDE analyzers) */
 #if !defined(__INTELLISENSE__) && !defined(__clang_analyzer__) && !defined(__clangd__)
-#define printf usb_console_printf
+#define printf console_printf
 #endif
 #endif
 
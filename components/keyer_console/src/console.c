@@ -3,32 +3,28 @@
  * @brief Serial console implementation
  *
  * Interactive command interface with history and tab completion.
- * Uses USB Serial JTAG for input/output.
+ *
+ * Every terminal is a session with its own line editor and history.
+ * Input from any of them runs under one lock, and while it runs
+ * console_printf (the printf of the console sources) writes to that
+ * session; outside any input it writes to USB CDC0.
  */
 
 #include "console.h"
 #include "config.h"
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <string.h>
 
 #ifdef ESP_PLATFORM
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "driver/usb_serial_jtag.h"
 #include "usb_console.h"
-/* Use USB console printf for console output (skip for IDE analyzers) */
-#if !defined(__INTELLISENSE__) && !defined(__clang_analyzer__) && !defined(__clangd__)
-#define printf usb_console_printf
-#endif
 #endif
 
-static char s_line_buf[CONSOLE_LINE_MAX];
-static size_t s_line_pos = 0;
-
-/** Saved line buffer for history navigation */
-static char s_saved_line[CONSOLE_LINE_MAX];
-static size_t s_saved_pos = 0;
-
 /** Escape sequence state machine */
 typedef enum {
     ESC_NONE,
@@ -36,16 +32,143 @@ typedef enum {
     ESC_BRACKET_RECEIVED,
 } escape_state_t;
 
-static escape_state_t s_escape_state = ESC_NONE;
+/** USB CDC0 (echoes on its own, before the line editor sees a byte) */
+static console_session_t s_usb;
+
+/** Session whose input is being handled; output goes there */
+static console_session_t *s_current = &s_usb;
+
+/** Next session id (0 is never handed out) */
+static atomic_uint s_next_id = 1;
+
+#ifdef ESP_PLATFORM
+/* Commands are not reentrant: one session at a time */
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_lock = NULL;
+
+static void session_enter(console_session_t *s) {
+    if (s_lock != NULL) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+    }
+    s_current = s;
+}
+
+static void session_leave(void) {
+    s_current = &s_usb;
+    if (s_lock != NULL) {
+        xSemaphoreGive(s_lock);
+    }
+}
+
+static void usb_write(void *ctx, const char *data, size_t len) {
+    (void)ctx;
+    usb_console_write(data, len);
+}
+
+static void usb_flush(void *ctx) {
+    (void)ctx;
+    usb_console_flush();
+}
+#else
+static void session_enter(console_session_t *s) {
+    s_current = s;
+}
+
+static void session_leave(void) {
+    s_current = &s_usb;
+}
+
+static void usb_write(void *ctx, const char *data, size_t len) {
+    (void)ctx;
+    fwrite(data, 1, len, stdout);
+}
+
+static void usb_flush(void *ctx) {
+    (void)ctx;
+    fflush(stdout);
+}
+#endif
+
+/** Flush the serving session's sink */
+static void session_flush(void) {
+    console_session_t *s = s_current;
+    if (s->write != NULL && s->flush != NULL) {
+        s->flush(s->ctx);
+    }
+}
+
+void console_write(const char *data, size_t len) {
+    console_session_t *s = s_current;
+    if (len > 0 && s->write != NULL) {
+        s->write(s->ctx, data, len);
+    }
+}
+
+void console_printf(const char *fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (len > 0) {
+        console_write(buf, ((size_t)len < sizeof(buf)) ? (size_t)len : sizeof(buf) - 1);
+    }
+}
+
+/* Use the serving session for console output (skip for IDE analyzers) */
+#if !defined(__INTELLISENSE__) && !defined(__clang_analyzer__) && !defined(__clangd__)
+#define printf console_printf
+#endif
+
+void console_session_init(console_session_t *s, console_write_fn write, console_flush_fn flush,
+                          void *ctx, bool echo) {
+    memset(s, 0, sizeof(*s));
+    s->escape = ESC_NONE;
+    s->echo = echo;
+    s->write = write;
+    s->flush = flush;
+    s->ctx = ctx;
+    console_history_init(&s->history);
+    uint32_t id;
+    do {
+        id = atomic_fetch_add_explicit(&s_next_id, 1U, memory_order_relaxed);
+    } while (id == 0U);
+    s->id = id;
+}
+
+void console_session_close(console_session_t *s) {
+    session_enter(s);
+    s->write = NULL;
+    s->id = 0;
+    session_leave();
+}
+
+console_session_t *console_session_current(void) {
+    return s_current;
+}
+
+bool console_session_write(console_session_t *s, uint32_t id, const char *data, size_t len) {
+    session_enter(s);
+    bool open = (s->id == id && id != 0U && s->write != NULL);
+    if (open) {
+        console_write(data, len);
+        session_flush();
+    }
+    session_leave();
+    return open;
+}
 
 void console_init(void) {
-    s_line_pos = 0;
-    memset(s_line_buf, 0, sizeof(s_line_buf));
-    s_escape_state = ESC_NONE;
-    console_history_init();
+#ifdef ESP_PLATFORM
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    }
+#endif
+    console_session_init(&s_usb, usb_write, usb_flush, NULL, false);
 }
 
-void console_print_prompt(void) {
+static void print_prompt(void) {
     const char *callsign = g_config.system.callsign;
     if (callsign[0] != '\0') {
         printf("%s> ", callsign);
@@ -55,102 +178,118 @@ void console_print_prompt(void) {
     fflush(stdout);
 }
 
-bool console_push_char(char c) {
+void console_session_prompt(console_session_t *s) {
+    session_enter(s);
+    print_prompt();
+    session_flush();
+    session_leave();
+}
+
+void console_print_prompt(void) {
+    console_session_prompt(&s_usb);
+}
+
+/**
+ * @brief Line editor step for the serving session (s_current)
+ */
+static bool session_char(console_session_t *s, char c) {
     /* Handle escape sequences for arrow keys */
-    if (s_escape_state == ESC_BRACKET_RECEIVED) {
-        s_escape_state = ESC_NONE;
+    if (s->escape == ESC_BRACKET_RECEIVED) {
+        s->escape = ESC_NONE;
 
         if (c == 'A') {
             /* Arrow up - previous history entry */
-            const char *hist = console_history_prev();
+            const char *hist = console_history_prev(&s->history);
             if (hist != NULL) {
                 /* Save current line on first navigation */
-                if (s_saved_pos == 0 && s_line_pos > 0) {
-                    memcpy(s_saved_line, s_line_buf, s_line_pos);
-                    s_saved_pos = s_line_pos;
+                if (s->saved_pos == 0 && s->pos > 0) {
+                    memcpy(s->saved, s->line, s->pos);
+                    s->saved_pos = s->pos;
                 }
 
                 /* Replace line with history entry */
-                strncpy(s_line_buf, hist, CONSOLE_LINE_MAX - 1);
-                s_line_buf[CONSOLE_LINE_MAX - 1] = '\0';
-                s_line_pos = strlen(s_line_buf);
+                strncpy(s->line, hist, CONSOLE_LINE_MAX - 1);
+                s->line[CONSOLE_LINE_MAX - 1] = '\0';
+                s->pos = strlen(s->line);
 
                 /* Clear and redraw line */
                 const char *call1 = g_config.system.callsign;
-                printf("\r%s> %s\033[K", call1[0] ? call1 : "", s_line_buf);
+                printf("\r%s> %s\033[K", call1[0] ? call1 : "", s->line);
                 fflush(stdout);
             }
             return false;
         } else if (c == 'B') {
             /* Arrow down - next history entry */
-            const char *hist = console_history_next();
+            const char *hist = console_history_next(&s->history);
             if (hist != NULL) {
                 /* Replace line with history entry */
-                strncpy(s_line_buf, hist, CONSOLE_LINE_MAX - 1);
-                s_line_buf[CONSOLE_LINE_MAX - 1] = '\0';
-                s_line_pos = strlen(s_line_buf);
+                strncpy(s->line, hist, CONSOLE_LINE_MAX - 1);
+                s->line[CONSOLE_LINE_MAX - 1] = '\0';
+                s->pos = strlen(s->line);
             } else {
                 /* Restore saved line */
-                if (s_saved_pos > 0) {
-                    memcpy(s_line_buf, s_saved_line, s_saved_pos);
-                    s_line_pos = s_saved_pos;
-                    s_saved_pos = 0;
+                if (s->saved_pos > 0) {
+                    memcpy(s->line, s->saved, s->saved_pos);
+                    s->pos = s->saved_pos;
+                    s->saved_pos = 0;
                 } else {
-                    s_line_pos = 0;
+                    s->pos = 0;
                 }
             }
 
             /* Clear and redraw line */
             const char *call2 = g_config.system.callsign;
-            printf("\r%s> %s\033[K", call2[0] ? call2 : "", s_line_buf);
+            s->line[s->pos] = '\0';
+            printf("\r%s> %s\033[K", call2[0] ? call2 : "", s->line);
             fflush(stdout);
             return false;
         }
         return false;
     }
 
-    if (s_escape_state == ESC_RECEIVED) {
+    if (s->escape == ESC_RECEIVED) {
         if (c == '[') {
-            s_escape_state = ESC_BRACKET_RECEIVED;
+            s->escape = ESC_BRACKET_RECEIVED;
         } else {
-            s_escape_state = ESC_NONE;
+            s->escape = ESC_NONE;
         }
         return false;
     }
 
     if (c == 0x1B) {
         /* ESC character - start escape sequence */
-        s_escape_state = ESC_RECEIVED;
+        s->escape = ESC_RECEIVED;
         return false;
     }
 
     /* Handle Tab completion */
     if (c == 0x09) {
         /* Tab character - try to complete */
-        if (console_complete(s_line_buf, &s_line_pos, CONSOLE_LINE_MAX)) {
+        s->line[s->pos] = '\0';
+        if (console_complete(s->line, &s->pos, CONSOLE_LINE_MAX)) {
             /* Completion succeeded - redraw line */
             const char *call3 = g_config.system.callsign;
-            printf("\r%s> %s", call3[0] ? call3 : "", s_line_buf);
+            printf("\r%s> %s", call3[0] ? call3 : "", s->line);
             fflush(stdout);
         }
         return false;
     }
 
     /* Reset history navigation and completion state on any normal input */
-    console_history_reset_nav();
+    console_history_reset_nav(&s->history);
     console_complete_reset();
 
     if (c == '\r' || c == '\n') {
         printf("\r\n");
-        if (s_line_pos > 0) {
-            s_line_buf[s_line_pos] = '\0';
+        if (s->pos > 0) {
+            s->line[s->pos] = '\0';
 
             /* Add to history */
-            console_history_push(s_line_buf);
+            console_history_push(&s->history, s->line);
 
             /* Parse and execute command */
             console_parsed_cmd_t cmd;
-            console_parse_line(s_line_buf, &cmd);
+            console_parse_line(s->line, &cmd);
 
             console_error_t err = console_execute(&cmd);
             if (err != CONSOLE_OK) {
@@ -159,33 +298,72 @@ bool console_push_char(char c) {
                        console_error_message(err));
             }
         }
-        s_line_pos = 0;
-        s_saved_pos = 0;
+        s->pos = 0;
+        s->saved_pos = 0;
         return true;  /* Always reprint prompt after Enter */
     } else if (c == '\b' || c == 0x7F) {
         /* Backspace */
-        if (s_line_pos > 0) {
-            s_line_pos--;
+        if (s->pos > 0) {
+            s->pos--;
         }
     } else if (c == 0x03) {
         /* Ctrl+C - cancel current line */
-        s_line_pos = 0;
-        s_saved_pos = 0;
+        s->pos = 0;
+        s->saved_pos = 0;
         return true;
     } else if (c == 0x15) {
         /* Ctrl+U - clear line */
-        s_line_pos = 0;
-        s_saved_pos = 0;
+        s->pos = 0;
+        s->saved_pos = 0;
     } else if (c >= 0x20 && c <= 0x7E) {
         /* Printable character */
-        if (s_line_pos < CONSOLE_LINE_MAX - 1) {
-            s_line_buf[s_line_pos++] = c;
+        if (s->pos < CONSOLE_LINE_MAX - 1) {
+            s->line[s->pos++] = c;
         }
     }
 
     return false;
 }
 
+bool console_session_push(console_session_t *s, char c) {
+    session_enter(s);
+    bool done = session_char(s, c);
+    session_leave();
+    return done;
+}
+
+/**
+ * @brief Echo one input character the way usb_console does
+ */
+static void echo_char(char c) {
+    if (c >= 0x20 && c <= 0x7E) {
+        console_write(&c, 1);
+    } else if (c == '\b' || c == 0x7F) {
+        console_write("\b \b", 3);
+    } else if (c == 0x03) {
+        console_write("^C\r\n", 4);
+    }
+    /* Enter: the line editor prints CR LF */
+}
+
+void console_session_input(console_session_t *s, const char *data, size_t len) {
+    session_enter(s);
+    for (size_t i = 0; i < len; i++) {
+        if (s->echo) {
+            echo_char(data[i]);
+        }
+        if (session_char(s, data[i])) {
+            print_prompt();
+        }
+    }
+    session_flush();
+    session_leave();
+}
+
+bool console_push_char(char c) {
+    return console_session_push(&s_usb, c);
+}
+
 bool console_process_char(char c) {
     /* Echo character (for non-USB usage) */
     if (c >= 0x20 && c <= 0x7E) {
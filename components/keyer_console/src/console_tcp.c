@@ -0,0 +1,269 @@
+/**
+ * @file console_tcp.c
+ * @brief Command console over telnet
+ */
+
+#include "console_tcp.h"
+#include "console.h"
+#include "telnet.h"
+#include "cdc_batch.h"
+#include "vpn.h"
+#include "config.h"
+#include "rt_log.h"
+
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+/** select() timeout */
+#define CONSOLE_TCP_POLL_MS 100
+
+/** Listener retry after a failed open */
+#define CONSOLE_TCP_RETRY_MS 1000
+
+/** Ctrl+D: end the session */
+#define CONSOLE_TCP_EOT 0x04
+
+typedef struct {
+    int sock;
+    bool broken;                /**< Peer gone or Ctrl+D: close at the end of the pass */
+    telnet_rx_t rx;
+    cdc_batch_t out;
+    console_session_t console;
+} tcp_session_t;
+
+static struct {
+    uint16_t port;
+    bool vpn_only;
+    int listen_sock;
+    tcp_session_t sessions[CONSOLE_TCP_MAX_SESSIONS];
+    uint32_t accepted;
+    uint32_t refused;
+} s_tcp = { .listen_sock = -1 };
+
+static const char BANNER[] = "\r\nCW Keyer Console\r\nType 'help' for available commands\r\n";
+
+static bool set_nonblocking(int sock) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0) {
+        return false;
+    }
+    return fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/** cdc_batch port: what the send buffer does not take is dropped */
+static size_t port_write(void *ctx, const uint8_t *data, size_t len) {
+    tcp_session_t *s = (tcp_session_t *)ctx;
+    if (s->broken) {
+        return 0;
+    }
+    ssize_t n = send(s->sock, data, len, MSG_DONTWAIT);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            s->broken = true;
+        }
+        return 0;
+    }
+    return (size_t)n;
+}
+
+/** TCP_NODELAY: a pushed packet is on its way already */
+static void port_flush(void *ctx) {
+    (void)ctx;
+}
+
+/** Console session sink */
+static void session_write(void *ctx, const char *data, size_t len) {
+    tcp_session_t *s = (tcp_session_t *)ctx;
+    cdc_batch_put(&s->out, data, len, esp_timer_get_time());
+}
+
+static void session_flush(void *ctx) {
+    tcp_session_t *s = (tcp_session_t *)ctx;
+    cdc_batch_flush(&s->out);
+}
+
+static bool open_listener(void) {
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(s_tcp.port),
+        .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int reuse = 1;
+    if (sock >= 0) {
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+    if (sock < 0 || !set_nonblocking(sock) ||
+        bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(sock, CONSOLE_TCP_MAX_SESSIONS) < 0) {
+        RT_ERROR(&g_bg_log_stream, esp_timer_get_time(),
+                 "Console TCP: listen on %u failed: %d", s_tcp.port, errno);
+        if (sock >= 0) {
+            close(sock);
+        }
+        return false;
+    }
+
+    s_tcp.listen_sock = sock;
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "Console TCP: listening on %u%s",
+            s_tcp.port, s_tcp.vpn_only ? " (VPN only)" : "");
+    return true;
+}
+
+/** The connection came in on the WireGuard tunnel address */
+static bool on_vpn(int sock) {
+    if (!vpn_is_connected()) {
+        return false;
+    }
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    if (getsockname(sock, (struct sockaddr *)&local, &len) < 0) {
+        return false;
+    }
+    struct in_addr tunnel;
+    return inet_aton(vpn_get_address(), &tunnel) != 0 &&
+           local.sin_addr.s_addr == tunnel.s_addr;
+}
+
+static tcp_session_t *free_session(void) {
+    for (size_t i = 0; i < CONSOLE_TCP_MAX_SESSIONS; i++) {
+        if (s_tcp.sessions[i].sock < 0) {
+            return &s_tcp.sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static void accept_sessions(void) {
+    int sock;
+    while ((sock = accept(s_tcp.listen_sock, NULL, NULL)) >= 0) {
+        tcp_session_t *s = free_session();
+        if (s == NULL || !set_nonblocking(sock) || (s_tcp.vpn_only && !on_vpn(sock))) {
+            close(sock);
+            s_tcp.refused++;
+            continue;
+        }
+
+        int nodelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        s->broken = false;
+        s->sock = sock;
+        telnet_rx_init(&s->rx);
+        cdc_batch_init(&s->out, port_write, port_flush, s);
+        console_session_init(&s->console, session_write, session_flush, s, true);
+        s_tcp.accepted++;
+        RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "Console TCP: client connected");
+
+        int64_t now_us = esp_timer_get_time();
+        cdc_batch_put(&s->out, TELNET_CHAR_MODE, TELNET_CHAR_MODE_LEN, now_us);
+        cdc_batch_put(&s->out, BANNER, sizeof(BANNER) - 1, now_us);
+        console_session_prompt(&s->console);
+    }
+}
+
+static void close_session(tcp_session_t *s) {
+    console_session_close(&s->console);
+    close(s->sock);
+    s->sock = -1;
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(),
+            "Console TCP: client disconnected (%lu bytes, %lu dropped)",
+            (unsigned long)s->out.bytes, (unsigned long)s->out.dropped);
+}
+
+/** Feed what arrived; false once the peer closed or the socket failed */
+static bool receive(tcp_session_t *s) {
+    uint8_t buf[64];
+    ssize_t n;
+    while ((n = recv(s->sock, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        size_t len = telnet_rx_filter(&s->rx, buf, (size_t)n);
+        const uint8_t *eot = memchr(buf, CONSOLE_TCP_EOT, len);
+        if (eot != NULL) {
+            len = (size_t)(eot - buf);
+            s->broken = true;
+        }
+        console_session_input(&s->console, (const char *)buf, len);
+        if (s->broken) {
+            return true;
+        }
+    }
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+static void wait_for_io(void) {
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    int maxfd = s_tcp.listen_sock;
+    FD_SET(s_tcp.listen_sock, &rfds);
+    for (size_t i = 0; i < CONSOLE_TCP_MAX_SESSIONS; i++) {
+        int fd = s_tcp.sessions[i].sock;
+        if (fd >= 0) {
+            FD_SET(fd, &rfds);
+            if (fd > maxfd) {
+                maxfd = fd;
+            }
+        }
+    }
+    struct timeval tv = {0, CONSOLE_TCP_POLL_MS * 1000};
+    (void)select(maxfd + 1, &rfds, NULL, NULL, &tv);
+}
+
+void console_tcp_task(void *arg) {
+    (void)arg;
+
+    s_tcp.port = CONFIG_GET_CONSOLE_TCP_PORT();
+    s_tcp.vpn_only = CONFIG_GET_CONSOLE_TCP_VPN_ONLY();
+    for (size_t i = 0; i < CONSOLE_TCP_MAX_SESSIONS; i++) {
+        s_tcp.sessions[i].sock = -1;
+    }
+    if (s_tcp.port == 0) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    while (!open_listener()) {
+        vTaskDelay(pdMS_TO_TICKS(CONSOLE_TCP_RETRY_MS));
+    }
+
+    for (;;) {
+        wait_for_io();
+        accept_sessions();
+
+        for (size_t i = 0; i < CONSOLE_TCP_MAX_SESSIONS; i++) {
+            tcp_session_t *s = &s_tcp.sessions[i];
+            if (s->sock < 0) {
+                continue;
+            }
+            if (!receive(s) || s->broken) {
+                close_session(s);
+            }
+        }
+    }
+}
+
+void console_tcp_get_info(console_tcp_info_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->port = s_tcp.port;
+    out->accepted = s_tcp.accepted;
+    out->refused = s_tcp.refused;
+    for (size_t i = 0; i < CONSOLE_TCP_MAX_SESSIONS; i++) {
+        const tcp_session_t *s = &s_tcp.sessions[i];
+        if (s->sock < 0) {
+            continue;
+        }
+        out->sessions++;
+        out->bytes += s->out.bytes;
+        out->dropped += s->out.dropped;
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * @file console_watch.c
+ * @brief "stats watch" sampler task
+ */
+
+#include "console_watch.h"
+#include "console.h"
+#include "stats_watch.h"
+#include "rt_prof.h"
+#include "hal_tick.h"
+#include "stream.h"
+#include "stream_registry.h"
+#include "cwnet_socket.h"
+#include "vpn.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_rom_sys.h"
+
+/* Keying stream (main/main.c) */
+extern keying_stream_t g_keying_stream;
+
+#define CONSOLE_WATCH_STACK 3072
+#define CONSOLE_WATCH_PRIO (tskIDLE_PRIORITY + 1)
+
+/* Set by the command (under the console lock), read by the task after a
+ * notification */
+static struct {
+    TaskHandle_t task;
+    atomic_uint interval_ms;        /**< 0 = stopped */
+    atomic_uint groups;
+    console_session_t *session;
+    uint32_t session_id;
+} s_watch;
+
+/* Sampler task only */
+static stats_watch_t s_stats;
+static stream_consumer_info_t s_cons[STREAM_REGISTRY_MAX];
+static uint32_t s_rt_hist[RT_PROF_HIST_BINS];
+static uint32_t s_cw_hist[CWNET_LATENCY_HIST_BINS];
+static char s_line[192];
+
+static void take_sample(unsigned groups, stats_watch_sample_t *s) {
+    memset(s, 0, sizeof(*s));
+    s->time_us = esp_timer_get_time();
+
+    if ((groups & (1U << STATS_WATCH_RT)) != 0U) {
+#ifdef CONFIG_KEYER_RT_PROFILE
+        rt_prof_snapshot_t ps;
+        rt_prof_get(&g_rt_prof, RT_PROF_STAGE_TOTAL, &ps);
+        uint32_t cyc_per_us = esp_rom_get_cpu_ticks_per_us();
+        if (cyc_per_us == 0) {
+            cyc_per_us = 1;
+        }
+        s->rt_peak_us = stats_watch_hist_peak(ps.hist, s_rt_hist, RT_PROF_HIST_BINS) /
+                        cyc_per_us;
+#endif
+        hal_tick_stats_t ts;
+        hal_tick_get_stats(&ts);
+        s->rt_missed = ts.missed_ticks;
+    }
+    if ((groups & (1U << STATS_WATCH_LAG)) != 0U) {
+        size_t n = stream_registry_snapshot(&g_keying_stream, s_cons, STREAM_REGISTRY_MAX);
+        for (size_t i = 0; i < n; i++) {
+            if (s_cons[i].lag > s->lag) {
+                s->lag = (uint32_t)s_cons[i].lag;
+            }
+            s->lag_dropped += s_cons[i].dropped;
+        }
+    }
+    if ((groups & (1U << STATS_WATCH_CWNET)) != 0U) {
+        cwnet_latency_snapshot_t ls;
+        cwnet_socket_get_edge_latency(&ls);
+        s->cwnet_edges = ls.count;
+        s->cwnet_peak_us = stats_watch_hist_peak(ls.hist, s_cw_hist, CWNET_LATENCY_HIST_BINS);
+    }
+    if ((groups & (1U << STATS_WATCH_VPN)) != 0U) {
+        vpn_stats_t vs;
+        if (vpn_get_stats(&vs)) {
+            s->vpn_tx = vs.tx_packets;
+            s->vpn_rx = vs.rx_packets;
+        }
+    }
+    if ((groups & (1U << STATS_WATCH_HEAP)) != 0U) {
+        s->heap_free = esp_get_free_heap_size();
+    }
+}
+
+static void watch_task(void *arg) {
+    (void)arg;
+    unsigned groups = 0;
+    console_session_t *session = NULL;
+    uint32_t session_id = 0;
+    int64_t line_us = 0;
+    stats_watch_sample_t sample;
+
+    for (;;) {
+        uint32_t interval_ms = atomic_load_explicit(&s_watch.interval_ms, memory_order_acquire);
+        TickType_t wait = (interval_ms != 0U) ? pdMS_TO_TICKS(interval_ms) : portMAX_DELAY;
+        if (ulTaskNotifyTake(pdTRUE, wait) > 0) {
+            /* Started, restarted or stopped: prime a fresh watch */
+            groups = atomic_load_explicit(&s_watch.groups, memory_order_acquire);
+            session = s_watch.session;
+            session_id = s_watch.session_id;
+            stats_watch_init(&s_stats, groups);
+            take_sample(groups, &sample);
+            stats_watch_push(&s_stats, &sample);
+            line_us = sample.time_us;
+            continue;
+        }
+        if (interval_ms == 0U) {
+            continue;
+        }
+
+        take_sample(groups, &sample);
+        stats_watch_push(&s_stats, &sample);
+        /* Half an interval of slack keeps the line period from slipping */
+        int64_t due_us = (int64_t)CONSOLE_WATCH_LINE_MS * 1000 - (int64_t)interval_ms * 500;
+        if (sample.time_us - line_us < due_us) {
+            continue;
+        }
+        line_us = sample.time_us;
+        size_t len = stats_watch_line(&s_stats, s_line, sizeof(s_line));
+        if (!console_session_write(session, session_id, s_line, len)) {
+            /* The terminal went away */
+            atomic_store_explicit(&s_watch.interval_ms, 0U, memory_order_release);
+        }
+    }
+}
+
+bool console_watch_start(uint32_t interval_ms, unsigned groups) {
+    if (s_watch.task == NULL &&
+        xTaskCreatePinnedToCore(watch_task, "stats_watch", CONSOLE_WATCH_STACK, NULL,
+                                CONSOLE_WATCH_PRIO, &s_watch.task, 1) != pdPASS) {
+        s_watch.task = NULL;
+        return false;
+    }
+    console_session_t *session = console_session_current();
+    s_watch.session = session;
+    s_watch.session_id = session->id;
+    atomic_store_explicit(&s_watch.groups, groups, memory_order_relaxed);
+    atomic_store_explicit(&s_watch.interval_ms, interval_ms, memory_order_release);
+    xTaskNotifyGive(s_watch.task);
+    return true;
+}
+
+void console_watch_stop(void) {
+    atomic_store_explicit(&s_watch.interval_ms, 0U, memory_order_release);
+    if (s_watch.task != NULL) {
+        xTaskNotifyGive(s_watch.task);
+    }
+}
+
+void console_watch_get(uint32_t *interval_ms, unsigned *groups) {
+    *interval_ms = atomic_load_explicit(&s_watch.interval_ms, memory_order_acquire);
+    *groups = atomic_load_explicit(&s_watch.groups, memory_order_relaxed);
+}
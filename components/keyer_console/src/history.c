@@ -2,111 +2,89 @@
  * @file history.c
  * @brief Command history implementation
  *
- * Static ring buffer for command history with arrow key navigation.
+ * Static ring buffer for command history with arrow key navigation,
+ * one per console session.
  */
 
 #include "console.h"
 #include <string.h>
 
-/** Ring buffer for history entries */
-static char s_history[CONSOLE_HISTORY_SIZE][CONSOLE_LINE_MAX];
-
-/** Number of entries in history (0 to CONSOLE_HISTORY_SIZE) */
-static size_t s_history_count = 0;
-
-/** Write position (where next entry will be written) */
-static size_t s_history_write = 0;
-
-/** Navigation position (current position when navigating) */
-static size_t s_history_nav = 0;
-
-/** Whether we're currently navigating through history */
-static bool s_navigating = false;
-
-/** Number of entries returned during current navigation */
-static size_t s_nav_count = 0;
-
-void console_history_init(void) {
-    s_history_count = 0;
-    s_history_write = 0;
-    s_history_nav = 0;
-    s_navigating = false;
-    s_nav_count = 0;
-    memset(s_history, 0, sizeof(s_history));
+void console_history_init(console_history_t *h) {
+    memset(h, 0, sizeof(*h));
 }
 
-void console_history_push(const char *line) {
+void console_history_push(console_history_t *h, const char *line) {
     if (line == NULL || line[0] == '\0') {
         return;
     }
 
     /* Don't add duplicates of the last entry */
-    if (s_history_count > 0) {
-        size_t last = (s_history_write + CONSOLE_HISTORY_SIZE - 1) % CONSOLE_HISTORY_SIZE;
-        if (strcmp(s_history[last], line) == 0) {
+    if (h->count > 0) {
+        size_t last = (h->write + CONSOLE_HISTORY_SIZE - 1) % CONSOLE_HISTORY_SIZE;
+        if (strcmp(h->entries[last], line) == 0) {
             return;
         }
     }
 
     /* Copy line to history buffer */
-    strncpy(s_history[s_history_write], line, CONSOLE_LINE_MAX - 1);
-    s_history[s_history_write][CONSOLE_LINE_MAX - 1] = '\0';
+    strncpy(h->entries[h->write], line, CONSOLE_LINE_MAX - 1);
+    h->entries[h->write][CONSOLE_LINE_MAX - 1] = '\0';
 
     /* Advance write pointer */
-    s_history_write = (s_history_write + 1) % CONSOLE_HISTORY_SIZE;
-    if (s_history_count < CONSOLE_HISTORY_SIZE) {
-        s_history_count++;
+    h->write = (h->write + 1) % CONSOLE_HISTORY_SIZE;
+    if (h->count < CONSOLE_HISTORY_SIZE) {
+        h->count++;
     }
 
     /* Reset navigation state */
-    s_navigating = false;
-    s_nav_count = 0;
+    h->navigating = false;
+    h->nav_count = 0;
 }
 
-const char *console_history_prev(void) {
-    if (s_history_count == 0) {
+const char *console_history_prev(console_history_t *h) {
+    if (h->count == 0) {
         return NULL;
     }
 
-    if (!s_navigating) {
+    if (!h->navigating) {
         /* Start navigating from the position after the most recent entry */
-        /* (s_history_write points to where the NEXT entry will go) */
-        s_history_nav = s_history_write;
-        s_navigating = true;
-        s_nav_count = 0;
+        /* (write points to where the NEXT entry will go) */
+        h->nav = h->write;
+        h->navigating = true;
+        h->nav_count = 0;
     }
 
     /* Check if we've already returned all available entries */
-    if (s_nav_count >= s_history_count) {
+    if (h->nav_count >= h->count) {
         return NULL;
     }
 
     /* Move to previous entry */
-    s_history_nav = (s_history_nav + CONSOLE_HISTORY_SIZE - 1) % CONSOLE_HISTORY_SIZE;
-    s_nav_count++;
+    h->nav = (h->nav + CONSOLE_HISTORY_SIZE - 1) % CONSOLE_HISTORY_SIZE;
+    h->nav_count++;
 
-    return s_history[s_history_nav];
+    return h->entries[h->nav];
 }
 
-const char *console_history_next(void) {
-    if (!s_navigating || s_history_count == 0 || s_nav_count == 0) {
+const char *console_history_next(console_history_t *h) {
+    if (!h->navigating || h->count == 0 || h->nav_count == 0) {
         return NULL;
     }
 
     /* Move to next (more recent) entry */
-    s_history_nav = (s_history_nav + 1) % CONSOLE_HISTORY_SIZE;
-    s_nav_count--;
+    h->nav = (h->nav + 1) % CONSOLE_HISTORY_SIZE;
+    h->nav_count--;
 
-    if (s_nav_count == 0) {
+    if (h->nav_count == 0) {
         /* Navigated past newest entry, return to current input */
-        s_navigating = false;
+        h->navigating = false;
         return NULL;
     }
 
-    return s_history[s_history_nav];
+    return h->entries[h->nav];
 }
 
-void console_history_reset_nav(void) {
-    s_navigating = false;
-    s_nav_count = 0;
+void console_history_reset_nav(console_history_t *h) {
+    h->navigating = false;
+    h->nav_count = 0;
 }
@@ -0,0 +1,308 @@
+/**
+ * @file syslog_sink.c
+ * @brief Remote syslog over UDP (system.syslog_host)
+ *
+ * A record is read only when the sink can act on it: one that does not
+ * fit the datagram, or finds the bucket empty, is held and goes first
+ * next time. Everything behind it waits in the ring.
+ */
+
+#include "syslog_sink.h"
+#include "log_syslog.h"
+#include "log_tags.h"
+#include "rt_log.h"
+#include "metrics.h"
+#include "wifi.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+/** Pass period */
+#define SYSLOG_POLL_MS 50
+
+/** Address lookup retry */
+#define SYSLOG_RESOLVE_RETRY_MS 10000
+
+/** Any wall clock before this was never set (2020-09-13) */
+#define SYSLOG_MIN_UNIX_S 1600000000LL
+
+/** The drained streams: MSGID, LOG_TAGS ID and this sink's cursor */
+typedef struct {
+    log_stream_t *stream;
+    const char *tag;
+    uint8_t tag_id;
+    log_reader_t reader;
+} syslog_source_t;
+
+static syslog_source_t s_sources[] = {
+    { .stream = &g_rt_log_stream, .tag = "RT" },
+    { .stream = &g_bg_log_stream, .tag = "BG" },
+};
+
+#define SOURCE_COUNT (sizeof(s_sources) / sizeof(s_sources[0]))
+
+static struct {
+    int sock;
+    struct sockaddr_in addr;
+    atomic_bool resolved;
+    log_syslog_rate_t rate;
+    uint32_t seq;                 /**< RFC 5424 sequenceId */
+    bool held;                    /**< A record was read and not yet sent */
+    log_entry_t held_entry;
+    size_t held_source;
+    atomic_uint sent;
+    atomic_uint records;
+    atomic_uint dropped;
+    atomic_uint errors;
+} s_sys = { .sock = -1 };
+
+static log_syslog_batch_t s_batch;
+static char s_text[LOG_SYSLOG_DATAGRAM_MAX];
+
+static const metric_desc_t k_syslog_metrics[] = {
+    { "keyer_syslog_sent_total", "Syslog datagrams sent", METRIC_COUNTER,
+      NULL, &s_sys.sent },
+    { "keyer_syslog_dropped_total", "Log records overwritten before syslog sent them",
+      METRIC_COUNTER, NULL, &s_sys.dropped },
+    { "keyer_syslog_errors_total", "Syslog datagrams the stack refused", METRIC_COUNTER,
+      NULL, &s_sys.errors },
+};
+
+static uint8_t tag_id(const char *tag) {
+    for (size_t i = 0; i < LOG_TAGS_COUNT; i++) {
+        if (strcmp(LOG_TAGS[i], tag) == 0) {
+            return (uint8_t)i;
+        }
+    }
+    return 0xFF;
+}
+
+/** system.syslog_host: "host[:port]", a dotted address or a name */
+static bool resolve(const char *spec) {
+    char host[64];
+    strncpy(host, spec, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+
+    unsigned long port = LOG_SYSLOG_PORT;
+    char *colon = strrchr(host, ':');
+    if (colon != NULL) {
+        *colon = '\0';
+        port = strtoul(colon + 1, NULL, 10);
+        if (port == 0 || port > 65535UL) {
+            port = LOG_SYSLOG_PORT;
+        }
+    }
+
+    memset(&s_sys.addr, 0, sizeof(s_sys.addr));
+    s_sys.addr.sin_family = AF_INET;
+    s_sys.addr.sin_port = htons((uint16_t)port);
+    if (inet_aton(host, &s_sys.addr.sin_addr) != 0) {
+        return true;
+    }
+
+    const struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0 || res == NULL) {
+        return false;
+    }
+    s_sys.addr.sin_addr = ((const struct sockaddr_in *)res->ai_addr)->sin_addr;
+    freeaddrinfo(res);
+    return true;
+}
+
+static void send_datagram(const void *data, size_t len, uint32_t records) {
+    ssize_t n = sendto(s_sys.sock, data, len, MSG_DONTWAIT,
+                       (const struct sockaddr *)&s_sys.addr, sizeof(s_sys.addr));
+    if (n < 0) {
+        atomic_fetch_add_explicit(&s_sys.errors, 1U, memory_order_relaxed);
+        return;
+    }
+    atomic_fetch_add_explicit(&s_sys.sent, 1U, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_sys.records, records, memory_order_relaxed);
+}
+
+/** Wall clock minus uptime, 0 while the clock is unset */
+static int64_t wall_offset_us(int64_t now_us) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if ((int64_t)tv.tv_sec < SYSLOG_MIN_UNIX_S) {
+        return 0;
+    }
+    return (int64_t)tv.tv_sec * 1000000 + (int64_t)tv.tv_usec - now_us;
+}
+
+/** The held record, else the next one, RT first */
+static bool next_record(log_entry_t *out, size_t *source) {
+    if (s_sys.held) {
+        s_sys.held = false;
+        *out = s_sys.held_entry;
+        *source = s_sys.held_source;
+        return true;
+    }
+    for (size_t s = 0; s < SOURCE_COUNT; s++) {
+        if (log_reader_next(&s_sources[s].reader, out)) {
+            *source = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void hold(const log_entry_t *entry, size_t source) {
+    s_sys.held = true;
+    s_sys.held_entry = *entry;
+    s_sys.held_source = source;
+}
+
+/** Records a stream lost since it was last reported */
+static uint32_t take_dropped(syslog_source_t *src) {
+    uint32_t lost = log_reader_dropped(&src->reader);
+    if (lost != 0) {
+        log_reader_reset_dropped(&src->reader);
+        atomic_fetch_add_explicit(&s_sys.dropped, lost, memory_order_relaxed);
+    }
+    return lost;
+}
+
+static void drain_rfc5424(int64_t now_us, uint32_t per_s, const char *host) {
+    int64_t wall_us = wall_offset_us(now_us);
+    log_entry_t entry;
+    size_t source;
+
+    /* A loss goes out as a text record of its own, ahead of what follows it */
+    for (size_t s = 0; s < SOURCE_COUNT && !s_sys.held; s++) {
+        uint32_t lost = take_dropped(&s_sources[s]);
+        if (lost != 0) {
+            log_entry_t note = {
+                .timestamp_us = now_us,
+                .fmt = NULL,
+                .level = LOG_LEVEL_WARN,
+            };
+            int n = snprintf((char *)note.args, sizeof(note.args),
+                             "syslog: %lu records dropped", (unsigned long)lost);
+            note.len = (uint8_t)((n > 0) ? n : 0);
+            hold(&note, s);
+        }
+    }
+
+    while (next_record(&entry, &source)) {
+        if (!log_syslog_rate_take(&s_sys.rate, now_us, per_s)) {
+            hold(&entry, source);
+            return;
+        }
+        s_sys.seq = (s_sys.seq >= INT32_MAX) ? 1U : s_sys.seq + 1U;
+        size_t len = log_syslog_rfc5424(&entry, host, s_sources[source].tag, s_sys.seq,
+                                        wall_us, s_text, sizeof(s_text));
+        send_datagram(s_text, len, 1);
+    }
+}
+
+static void drain_binary(int64_t now_us, uint32_t per_s) {
+    log_entry_t entry;
+    size_t source;
+
+    for (;;) {
+        uint32_t lost[SOURCE_COUNT];
+        bool work = s_sys.held;
+        for (size_t s = 0; s < SOURCE_COUNT; s++) {
+            lost[s] = log_reader_dropped(&s_sources[s].reader);
+            work = work || lost[s] != 0 || log_reader_pending(&s_sources[s].reader) != 0;
+        }
+        if (!work || !log_syslog_rate_take(&s_sys.rate, now_us, per_s)) {
+            return;
+        }
+
+        log_syslog_batch_begin(&s_batch);
+        bool report = false;
+        for (size_t s = 0; s < SOURCE_COUNT; s++) {
+            if (lost[s] != 0) {
+                (void)take_dropped(&s_sources[s]);
+                report = log_syslog_batch_dropped(&s_batch, s_sources[s].tag_id, lost[s]);
+            }
+        }
+        bool full = false;
+        while (next_record(&entry, &source)) {
+            if (!log_syslog_batch_add(&s_batch, &entry, s_sources[source].tag_id)) {
+                full = true;
+                if (s_batch.records != 0) {
+                    hold(&entry, source);
+                }
+                break;
+            }
+        }
+        if (s_batch.records != 0 || report) {   /* Pending counts filtered records too */
+            send_datagram(s_batch.buf, s_batch.len, s_batch.records);
+        }
+        if (!full) {
+            return;
+        }
+    }
+}
+
+void syslog_sink_task(void *arg) {
+    (void)arg;
+
+    const char *spec = CONFIG_GET_SYSLOG_HOST();
+    if (spec[0] == '\0') {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    /* Attach now: what is logged while the link comes up is kept for it */
+    for (size_t s = 0; s < SOURCE_COUNT; s++) {
+        s_sources[s].tag_id = tag_id(s_sources[s].tag);
+        log_reader_init(&s_sources[s].reader, s_sources[s].stream, LOG_LEVEL_INFO);
+    }
+
+    while (!wifi_is_connected() || !resolve(spec)) {
+        vTaskDelay(pdMS_TO_TICKS(SYSLOG_RESOLVE_RETRY_MS));
+    }
+    while ((s_sys.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+        vTaskDelay(pdMS_TO_TICKS(SYSLOG_RESOLVE_RETRY_MS));
+    }
+    atomic_store_explicit(&s_sys.resolved, true, memory_order_relaxed);
+    metrics_register_all(&g_metrics, k_syslog_metrics,
+                         sizeof(k_syslog_metrics) / sizeof(k_syslog_metrics[0]));
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "Syslog: forwarding to %s:%u",
+            inet_ntoa(s_sys.addr.sin_addr), (unsigned)ntohs(s_sys.addr.sin_port));
+
+    log_syslog_rate_init(&s_sys.rate, esp_timer_get_time(), CONFIG_GET_SYSLOG_RATE());
+
+    for (;;) {
+        int64_t now_us = esp_timer_get_time();
+        uint32_t per_s = CONFIG_GET_SYSLOG_RATE();
+        log_level_t level = (log_level_t)CONFIG_GET_SYSLOG_LEVEL();
+        for (size_t s = 0; s < SOURCE_COUNT; s++) {
+            log_reader_set_level(&s_sources[s].reader, level);
+        }
+
+        if (CONFIG_GET_SYSLOG_FORMAT() == LOG_SYSLOG_BINARY) {
+            drain_binary(now_us, per_s);
+        } else {
+            drain_rfc5424(now_us, per_s, CONFIG_GET_CALLSIGN());
+        }
+        vTaskDelay(pdMS_TO_TICKS(SYSLOG_POLL_MS));
+    }
+}
+
+void syslog_sink_get_stats(syslog_sink_stats_t *out) {
+    out->resolved = atomic_load_explicit(&s_sys.resolved, memory_order_relaxed);
+    out->sent = atomic_load_explicit(&s_sys.sent, memory_order_relaxed);
+    out->records = atomic_load_explicit(&s_sys.records, memory_order_relaxed);
+    out->dropped = atomic_load_explicit(&s_sys.dropped, memory_order_relaxed);
+    out->errors = atomic_load_explicit(&s_sys.errors, memory_order_relaxed);
+}
@@ -0,0 +1,84 @@
+/**
+ * @file telnet.c
+ * @brief Minimal telnet input filter for the TCP console
+ */
+
+#include "telnet.h"
+
+#define IAC  255U
+#define WILL 251U   /* WILL, WONT, DO, DONT: 251-254 */
+#define SB   250U
+#define SE   240U
+
+#define OPT_ECHO 1U
+#define OPT_SGA  3U
+
+typedef enum {
+    RX_DATA = 0,
+    RX_CR,          /**< Last byte was CR: drop a following LF or NUL */
+    RX_IAC,
+    RX_OPTION,      /**< WILL/WONT/DO/DONT: one option byte follows */
+    RX_SB,
+    RX_SB_IAC,
+} rx_state_t;
+
+const uint8_t TELNET_CHAR_MODE[TELNET_CHAR_MODE_LEN] = {
+    IAC, WILL, OPT_ECHO,
+    IAC, WILL, OPT_SGA,
+};
+
+void telnet_rx_init(telnet_rx_t *t) {
+    t->state = RX_DATA;
+}
+
+size_t telnet_rx_filter(telnet_rx_t *t, uint8_t *data, size_t len) {
+    size_t out = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = data[i];
+        switch ((rx_state_t)t->state) {
+            case RX_CR:
+                t->state = RX_DATA;
+                if (b == '\n' || b == '\0') {
+                    break;
+                }
+                /* fall through */
+            case RX_DATA:
+                if (b == IAC) {
+                    t->state = RX_IAC;
+                } else if (b == '\r' || b == '\n') {
+                    data[out++] = '\r';
+                    t->state = (b == '\r') ? RX_CR : RX_DATA;
+                } else {
+                    data[out++] = b;
+                }
+                break;
+            case RX_IAC:
+                if (b == IAC) {
+                    data[out++] = b;
+                    t->state = RX_DATA;
+                } else if (b >= WILL) {
+                    t->state = RX_OPTION;
+                } else if (b == SB) {
+                    t->state = RX_SB;
+                } else {
+                    t->state = RX_DATA;
+                }
+                break;
+            case RX_OPTION:
+                t->state = RX_DATA;
+                break;
+            case RX_SB:
+                if (b == IAC) {
+                    t->state = RX_SB_IAC;
+                }
+                break;
+            case RX_SB_IAC:
+                t->state = (b == SE) ? RX_DATA : RX_SB;
+                break;
+            default:
+                t->state = RX_DATA;
+                break;
+        }
+    }
+    return out;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file boot_timeline.h
+ * @brief Boot-phase timeline (start and duration of each init step)
+ *
+ * Boot brings the RT keying path up first and then initializes audio,
+ * networking and the UI concurrently in init tasks. Each step records a
+ * phase here so the timeline can be read back (console "stats boot")
+ * while some phases are still running.
+ *
+ * Phases also record how much heap they took (free space at the start
+ * minus at the end). Init tasks overlap, so a phase's figure includes
+ * what the phases running beside it allocated. Tasks and RTOS objects
+ * that live for the whole uptime are static, so this is the heap boot
+ * really needs: driver, WiFi, lwIP and HTTP server allocations.
+ *
+ * Any task may record: a phase claims its slot with one fetch_add and
+ * publishes it with a release store, so writers never wait on each other.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: No locks; slots are claimed atomically
+ * - RULE 3.1.4: Recording never blocks; a full timeline drops the phase
+ */
+
+#ifndef KEYER_BOOT_TIMELINE_H
+#define KEYER_BOOT_TIMELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Phases kept */
+#define BOOT_TIMELINE_MAX 24U
+
+/**
+ * @brief Free heap at one point
+ */
+typedef struct {
+    uint32_t internal;    /**< MALLOC_CAP_INTERNAL */
+    uint32_t psram;       /**< MALLOC_CAP_SPIRAM */
+} boot_heap_t;
+
+/**
+ * @brief One boot phase
+ */
+typedef struct {
+    const char *name;     /**< Static string */
+    int64_t start_us;     /**< esp_timer time the phase began */
+    int64_t end_us;       /**< Time it ended, 0 while running */
+    uint8_t core;         /**< Core it ran on */
+    boot_heap_t heap_start; /**< Free heap when it began */
+    int32_t internal_used;  /**< Internal heap taken (negative: freed), 0 while running */
+    int32_t psram_used;     /**< PSRAM heap taken */
+} boot_phase_t;
+
+/**
+ * @brief Recorded slot (internal)
+ */
+typedef struct {
+    boot_phase_t phase;
+    atomic_uint state;    /**< 0 = claimed, 1 = running, 2 = done */
+} boot_timeline_slot_t;
+
+/**
+ * @brief The timeline
+ */
+typedef struct {
+    atomic_uint count;                              /**< Slots claimed (may exceed MAX) */
+    boot_timeline_slot_t slots[BOOT_TIMELINE_MAX];
+    boot_heap_t heap_start;                         /**< Free heap at init */
+    atomic_uint heap_last_internal;                 /**< Free heap when the last phase ended */
+    atomic_uint heap_last_psram;
+} boot_timeline_t;
+
+/** Global timeline (main.c) */
+extern boot_timeline_t g_boot_timeline;
+
+/**
+ * @brief Clear the timeline (once, before any task records)
+ *
+ * @param tl Timeline
+ * @param heap Free heap now (NULL: heap not tracked)
+ */
+void boot_timeline_init(boot_timeline_t *tl, const boot_heap_t *heap);
+
+/**
+ * @brief Start a phase
+ *
+ * @param tl Timeline
+ * @param name Phase name (static string)
+ * @param core Core the caller runs on
+ * @param now_us Current time
+ * @param heap Free heap now (NULL: heap not tracked)
+ * @return Phase ID for boot_phase_end(), -1 if the timeline is full
+ */
+int boot_phase_begin(boot_timeline_t *tl, const char *name, uint8_t core, int64_t now_us,
+                     const boot_heap_t *heap);
+
+/**
+ * @brief End a phase (by the task that started it)
+ *
+ * @param tl Timeline
+ * @param id boot_phase_begin() result (-1 is ignored)
+ * @param now_us Current time
+ * @param heap Free heap now (NULL: heap not tracked)
+ */
+void boot_phase_end(boot_timeline_t *tl, int id, int64_t now_us, const boot_heap_t *heap);
+
+/**
+ * @brief Copy the phases in the order they began (any task)
+ *
+ * Running phases come back with end_us = 0; claimed slots whose phase is
+ * not published yet are skipped.
+ *
+ * @param tl Timeline
+ * @param out Destination
+ * @param max Capacity of out (BOOT_TIMELINE_MAX for everything)
+ * @return Phases written
+ */
+size_t boot_timeline_snapshot(const boot_timeline_t *tl, boot_phase_t *out, size_t max);
+
+/**
+ * @brief Heap boot took: free at init minus free when the last phase ended
+ *
+ * @param tl Timeline
+ * @param internal_used Internal heap taken
+ * @param psram_used PSRAM heap taken
+ */
+void boot_timeline_heap_used(const boot_timeline_t *tl, int32_t *internal_used,
+                             int32_t *psram_used);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_BOOT_TIMELINE_H */
@@ -2,9 +2,10 @@
  * @file consumer.h
  * @brief Hard RT and Best-Effort consumer implementations
  *
- * Two consumer types:
+ * Three consumer types:
  * - HardRtConsumer: MUST keep up, FAULTs on lag exceed
  * - BestEffortConsumer: Skips samples if behind, never FAULTs
+ * - TimedConsumer: BestEffort plus an absolute tick cursor
  *
  * ARCHITECTURE.md compliance:
  * - RULE 4.2.1: Hard RT consumers FAULT on deadline miss
@@ -19,6 +20,7 @@
 #include <stdbool.h>
 #include "stream.h"
 #include "fault.h"
+#include "remote_tx.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,11 +30,28 @@ extern "C" {
  * Hard RT Consumer
  * ============================================================================ */
 
+/**
+ * @brief Hard RT fault recovery policy
+ *
+ * While a fault is active the consumer stays silent. After clean_ticks
+ * ticks with no new fault it clears the fault and resyncs to the head.
+ * latch_after faults within latch_window ticks latch it instead: silent
+ * until something else calls fault_clear().
+ *
+ * All zero (the default) latches on the first fault.
+ */
+typedef struct {
+    uint32_t clean_ticks;   /**< Fault-free ticks before recovering (0 = never) */
+    uint32_t latch_after;   /**< Faults within latch_window that latch (0 = never) */
+    uint32_t latch_window;  /**< Window for counting repeated faults (ticks) */
+} hard_rt_recovery_t;
+
 /**
  * @brief Hard real-time consumer
  *
  * MUST keep up with producer. If lag exceeds max_lag, triggers FAULT
  * and stops processing (silence is better than corrupt CW timing).
+ * The recovery policy decides when processing resumes.
  *
  * Used for: Audio/TX output on Core 0.
  */
@@ -41,15 +60,30 @@ typedef struct {
     fault_state_t *fault;           /**< Fault state (shared with RT loop) */
     size_t read_idx;                /**< Current read position */
     size_t max_lag;                 /**< Maximum allowed lag before FAULT */
+    uint8_t remote_key;             /**< Latest REMOTE lane key level (monitor only) */
+    remote_tx_t *remote;            /**< REMOTE events are queued here too, NULL if unset */
+    hard_rt_recovery_t recovery;    /**< Recovery policy */
+    uint32_t ticks;                 /**< Ticks seen (recovery timebase) */
+    uint32_t seen_faults;           /**< fault_get_count() last accounted for */
+    uint32_t clean;                 /**< Fault-free ticks while silenced */
+    uint32_t window_start;          /**< Tick the latch window opened */
+    uint32_t window_faults;         /**< Faults in the current latch window */
+    uint32_t recoveries;            /**< Faults cleared by the policy */
+    bool latched;                   /**< Silent until fault_clear() */
+    stream_consumer_entry_t *entry; /**< Telemetry slot, NULL if unregistered */
 } hard_rt_consumer_t;
 
+/** Non-LOCAL slots a hard RT tick may step over before giving up the tick */
+#define HARD_RT_MAX_FOREIGN_PER_TICK 8
+
 /**
  * @brief Hard RT consumer tick result
  */
 typedef enum {
     HARD_RT_OK,       /**< Sample read successfully */
     HARD_RT_NO_DATA,  /**< No new data available (caught up) */
-    HARD_RT_FAULT,    /**< Fault triggered (lag exceeded) */
+    HARD_RT_FAULT,    /**< Fault triggered (lag exceeded) or still active */
+    HARD_RT_RECOVERED,/**< Fault cleared and resynced this tick (no sample) */
 } hard_rt_result_t;
 
 /**
@@ -65,12 +99,48 @@ void hard_rt_consumer_init(hard_rt_consumer_t *consumer,
                            fault_state_t *fault,
                            size_t max_lag);
 
+/**
+ * @brief Set the fault recovery policy
+ *
+ * @param consumer Consumer handle
+ * @param recovery Policy (copied)
+ */
+void hard_rt_consumer_set_recovery(hard_rt_consumer_t *consumer,
+                                   const hard_rt_recovery_t *recovery);
+
+/**
+ * @brief Publish lag telemetry under a name (stream_registry.h)
+ *
+ * Optional; a no-op if the stream has no registry or it is full.
+ *
+ * @param consumer Consumer handle
+ * @param name Consumer name (must outlive the stream)
+ */
+void hard_rt_consumer_register(hard_rt_consumer_t *consumer, const char *name);
+
+/**
+ * @brief Queue REMOTE lane events for tick-exact playout
+ *
+ * @param consumer Consumer handle
+ * @param remote Playout state (RT task ticks it), NULL to stop
+ */
+void hard_rt_consumer_set_remote(hard_rt_consumer_t *consumer, remote_tx_t *remote);
+
 /**
  * @brief Tick hard RT consumer
  *
- * Attempts to read next sample. If lag exceeds max_lag, sets FAULT
+ * Attempts to read next LOCAL sample. If lag exceeds max_lag, sets FAULT
  * and returns HARD_RT_FAULT.
  *
+ * While the fault is active, returns HARD_RT_FAULT and discards what the
+ * producer pushes, until the recovery policy clears it (HARD_RT_RECOVERED).
+ * A fault cleared elsewhere (fault_clear()) also ends a latch.
+ *
+ * Slots of other lanes are stepped over (up to HARD_RT_MAX_FOREIGN_PER_TICK
+ * per call) and never returned, so they can not key the transmitter. REMOTE
+ * events update remote_key for the sidetone monitor, and are queued for
+ * tick-exact playout if hard_rt_consumer_set_remote() was called.
+ *
  * @param consumer Consumer handle
  * @param out Output sample (valid if HARD_RT_OK returned)
  * @return Result code
@@ -95,6 +165,16 @@ void hard_rt_consumer_resync(hard_rt_consumer_t *consumer);
  */
 size_t hard_rt_consumer_lag(const hard_rt_consumer_t *consumer);
 
+/**
+ * @brief Check if the fault is latched (no automatic recovery)
+ *
+ * @param consumer Consumer handle
+ * @return true if latched
+ */
+static inline bool hard_rt_consumer_latched(const hard_rt_consumer_t *consumer) {
+    return consumer->latched;
+}
+
 /* ============================================================================
  * Best Effort Consumer
  * ============================================================================ */
@@ -104,15 +184,32 @@ size_t hard_rt_consumer_lag(const hard_rt_consumer_t *consumer);
  *
  * Skips samples if behind producer. Never FAULTs - just tracks dropped count.
  *
+ * Past skip_threshold, sample reads (best_effort_consumer_tick()) catch up
+ * instead of jumping while the backlog is still in the ring: they scan it
+ * up to BEST_EFFORT_CATCH_UP_SCAN slots per call and return only the
+ * samples that change state (edges, config/TX/RX flags, REMOTE events),
+ * with the LOCAL ticks in between folded into silence markers. Tick counts
+ * and key levels stay exact; the skipped samples are counted in condensed,
+ * not dropped. Only a real overrun still drops.
+ *
  * Used for: Remote forwarder, decoder, diagnostics on Core 1.
  */
 typedef struct {
     const keying_stream_t *stream;  /**< Stream being consumed */
     size_t read_idx;                /**< Current read position */
     size_t dropped;                 /**< Counter of skipped samples */
-    size_t skip_threshold;          /**< Lag threshold for auto-skip */
+    size_t overwritten;             /**< Reads lost to a producer lap (torn) */
+    size_t skip_threshold;          /**< Lag threshold for catch-up/auto-skip */
+    size_t condensed;               /**< Samples folded into silence while catching up */
+    size_t catch_up_end;            /**< Catch up until read_idx reaches this */
+    uint32_t catch_up_ticks;        /**< LOCAL ticks folded, not yet returned */
+    bool catching_up;               /**< Catch-up mode active */
+    stream_consumer_entry_t *entry; /**< Telemetry slot, NULL if unregistered */
 } best_effort_consumer_t;
 
+/** Slots one catch-up read scans at most */
+#define BEST_EFFORT_CATCH_UP_SCAN 64U
+
 /**
  * @brief Initialize best-effort consumer
  *
@@ -124,11 +221,24 @@ void best_effort_consumer_init(best_effort_consumer_t *consumer,
                                const keying_stream_t *stream,
                                size_t skip_threshold);
 
+/**
+ * @brief Publish lag telemetry under a name (stream_registry.h)
+ *
+ * Optional; a no-op if the stream has no registry or it is full. Timed
+ * consumers register their base.
+ *
+ * @param consumer Consumer handle
+ * @param name Consumer name (must outlive the stream)
+ */
+void best_effort_consumer_register(best_effort_consumer_t *consumer, const char *name);
+
 /**
  * @brief Tick best-effort consumer
  *
- * Reads next sample. If lag exceeds skip_threshold, skips to near-latest
- * and increments dropped counter.
+ * Reads next sample. If lag exceeds skip_threshold, catches up to
+ * near-latest keeping every edge (see best_effort_consumer_t); if the
+ * producer overran the read position, skips there and increments the
+ * dropped counter.
  *
  * @param consumer Consumer handle
  * @param out Output sample (valid if true returned)
@@ -137,6 +247,40 @@ void best_effort_consumer_init(best_effort_consumer_t *consumer,
 bool best_effort_consumer_tick(best_effort_consumer_t *consumer,
                                stream_sample_t *out);
 
+/**
+ * @brief Get pending samples as up to two contiguous ring spans
+ *
+ * Applies the same overrun handling as best_effort_consumer_tick(), then
+ * returns committed slots without copying (see stream_read_span()). Past
+ * skip_threshold a span reader still skips to near-latest: it reads the
+ * backlog in bulk, so a threshold there means it wants the recent samples
+ * only. Finish with best_effort_consumer_commit().
+ *
+ * @param consumer Consumer handle
+ * @param a First span
+ * @param na Length of first span
+ * @param b Second span after wrap
+ * @param nb Length of second span
+ * @param max Maximum number of slots to return
+ * @return Total slots available (0 if caught up)
+ */
+size_t best_effort_consumer_next_span(best_effort_consumer_t *consumer,
+                                      const stream_slot_t **a, size_t *na,
+                                      const stream_slot_t **b, size_t *nb,
+                                      size_t max);
+
+/**
+ * @brief Consume n slots returned by best_effort_consumer_next_span()
+ *
+ * If the producer overwrote the span while it was processed, counts one
+ * overwritten read, drops the rest of the backlog and resyncs.
+ *
+ * @param consumer Consumer handle
+ * @param n Slots consumed
+ * @return true if the span was intact
+ */
+bool best_effort_consumer_commit(best_effort_consumer_t *consumer, size_t n);
+
 /**
  * @brief Get dropped sample count
  *
@@ -148,12 +292,36 @@ static inline size_t best_effort_consumer_dropped(const best_effort_consumer_t *
 }
 
 /**
- * @brief Reset dropped counter
+ * @brief Get count of reads the producer overwrote
+ *
+ * Each one also counts the samples skipped to resync in dropped.
+ *
+ * @param consumer Consumer handle
+ * @return Number of reads detected as overwritten
+ */
+static inline size_t best_effort_consumer_overwritten(const best_effort_consumer_t *consumer) {
+    return consumer->overwritten;
+}
+
+/**
+ * @brief Get count of samples folded into silence while catching up
+ *
+ * @param consumer Consumer handle
+ * @return Samples passed over without losing an edge
+ */
+static inline size_t best_effort_consumer_condensed(const best_effort_consumer_t *consumer) {
+    return consumer->condensed;
+}
+
+/**
+ * @brief Reset dropped, overwritten and condensed counters
  *
  * @param consumer Consumer handle
  */
 static inline void best_effort_consumer_reset_dropped(best_effort_consumer_t *consumer) {
     consumer->dropped = 0;
+    consumer->overwritten = 0;
+    consumer->condensed = 0;
 }
 
 /**
@@ -164,6 +332,119 @@ static inline void best_effort_consumer_reset_dropped(best_effort_consumer_t *co
  */
 size_t best_effort_consumer_lag(const best_effort_consumer_t *consumer);
 
+/* ============================================================================
+ * Timed Consumer
+ * ============================================================================ */
+
+/**
+ * @brief Best-effort consumer that knows the absolute tick of every sample
+ *
+ * Sums LOCAL silence markers and samples into a tick cursor, so each
+ * sample gets the tick (and time, via the stream epoch) at which it was
+ * produced, however late Core 1 drains the stream. Samples of other lanes
+ * get the current LOCAL tick.
+ *
+ * Starts at the stream tick anchor. After any skip or overwritten span it
+ * re-anchors; if the anchor is itself out of reach the cursor takes the
+ * anchor tick and keeps the read position (counted in resyncs).
+ *
+ * Used for: decoder, WebUI timeline, CWNet forwarding.
+ */
+typedef struct {
+    best_effort_consumer_t base;    /**< Read position, skip/drop handling */
+    uint64_t tick;                  /**< Absolute LOCAL tick of next sample */
+    size_t   seen_dropped;          /**< base.dropped at last sync */
+    size_t   resyncs;               /**< Re-anchors after a skip */
+} timed_consumer_t;
+
+/**
+ * @brief Initialize timed consumer at the stream tick anchor
+ *
+ * @param consumer Consumer to initialize
+ * @param stream Stream to consume from
+ * @param skip_threshold Lag threshold for auto-skip (0 = never skip)
+ */
+void timed_consumer_init(timed_consumer_t *consumer,
+                         const keying_stream_t *stream,
+                         size_t skip_threshold);
+
+/**
+ * @brief Initialize timed consumer just after the key state checkpoint
+ *
+ * Like timed_consumer_init(), but also returns the paddle/key levels in
+ * effect at the start position (stream_read_key_state()), so edge
+ * trackers begin with the right state instead of assuming idle.
+ *
+ * @param consumer Consumer to initialize
+ * @param stream Stream to consume from
+ * @param skip_threshold Lag threshold for auto-skip (0 = never skip)
+ * @param state Key state at the start position
+ */
+void timed_consumer_init_with_state(timed_consumer_t *consumer,
+                                    const keying_stream_t *stream,
+                                    size_t skip_threshold,
+                                    stream_key_state_t *state);
+
+/**
+ * @brief Read next sample with its absolute tick
+ *
+ * @param consumer Consumer handle
+ * @param out Output sample (valid if true returned)
+ * @param tick Absolute LOCAL tick at which the sample starts
+ * @return true if sample available, false if caught up
+ */
+bool timed_consumer_next(timed_consumer_t *consumer, stream_sample_t *out,
+                         uint64_t *tick);
+
+/**
+ * @brief Get pending samples as up to two contiguous ring spans
+ *
+ * Call timed_consumer_step() on each sample in order, then
+ * timed_consumer_commit().
+ *
+ * @return Total slots available (0 if caught up)
+ */
+size_t timed_consumer_next_span(timed_consumer_t *consumer,
+                                const stream_slot_t **a, size_t *na,
+                                const stream_slot_t **b, size_t *nb,
+                                size_t max);
+
+/**
+ * @brief Advance the tick cursor over one sample
+ *
+ * @param consumer Consumer handle
+ * @param sample Next sample in stream order
+ * @return Absolute LOCAL tick at which the sample starts
+ */
+static inline uint64_t timed_consumer_step(timed_consumer_t *consumer,
+                                           const stream_sample_t *sample) {
+    uint64_t tick = consumer->tick;
+    if (sample_lane(sample) == STREAM_LANE_LOCAL) {
+        consumer->tick += sample_is_silence(sample) ? sample_silence_ticks(sample) : 1U;
+    }
+    return tick;
+}
+
+/**
+ * @brief Consume n slots returned by timed_consumer_next_span()
+ *
+ * @return true if the span was intact
+ */
+bool timed_consumer_commit(timed_consumer_t *consumer, size_t n);
+
+/**
+ * @brief Convert an absolute tick to time (esp_timer base)
+ *
+ * @param consumer Consumer handle
+ * @param tick Absolute LOCAL tick
+ * @return epoch_us + tick * tick_period_us
+ */
+static inline int64_t timed_consumer_time_us(const timed_consumer_t *consumer,
+                                             uint64_t tick) {
+    const keying_stream_t *stream = consumer->base.stream;
+    return stream_epoch_us(stream) + (int64_t)tick * (int64_t)stream_tick_period_us(stream);
+}
+
 #ifdef __cplusplus
 }
 #endif
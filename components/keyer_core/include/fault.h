@@ -15,6 +15,7 @@
 #define KEYER_FAULT_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <stdatomic.h>
 
@@ -139,6 +140,97 @@ void fault_clear(fault_state_t *fault);
  */
 const char *fault_code_str(fault_code_t code);
 
+/* ============================================================================
+ * Fault Timeline
+ * ============================================================================ */
+
+/** Events kept in the fault log (MUST be power of 2) */
+#define FAULT_LOG_SIZE 16U
+
+/**
+ * @brief What happened to the fault
+ */
+typedef enum {
+    FAULT_EV_RAISED = 0,     /**< Fault set (code, data = lag) */
+    FAULT_EV_RECOVERED = 1,  /**< Cleared by the recovery policy */
+    FAULT_EV_LATCHED = 2,    /**< Repeated faults: no more automatic recovery */
+} fault_event_kind_t;
+
+/**
+ * @brief One fault log event
+ */
+typedef struct {
+    int64_t time_us;   /**< When it happened */
+    uint32_t data;     /**< Fault data (lag) */
+    uint8_t code;      /**< fault_code_t */
+    uint8_t kind;      /**< fault_event_kind_t */
+} fault_event_t;
+
+/**
+ * @brief Ring of recent fault events
+ *
+ * Single writer (the RT loop), readers on any core. Overwrites the oldest.
+ */
+typedef struct {
+    fault_event_t events[FAULT_LOG_SIZE];
+    atomic_uint head;    /**< Events ever recorded */
+} fault_log_t;
+
+/**
+ * @brief Initialize fault log
+ *
+ * @param log Fault log
+ */
+void fault_log_init(fault_log_t *log);
+
+/**
+ * @brief Record an event (single writer, never blocks)
+ *
+ * @param log Fault log
+ * @param now_us Timestamp
+ * @param kind What happened
+ * @param code Fault code
+ * @param data Fault data
+ */
+void fault_log_record(fault_log_t *log, int64_t now_us, fault_event_kind_t kind,
+                      fault_code_t code, uint32_t data);
+
+/**
+ * @brief Copy the newest events, oldest first
+ *
+ * Events the writer overwrote during the copy are left out.
+ *
+ * @param log Fault log
+ * @param out Destination
+ * @param max Capacity of out
+ * @return Events written
+ */
+size_t fault_log_snapshot(const fault_log_t *log, fault_event_t *out, size_t max);
+
+/**
+ * @brief Copy the events recorded since a reader's position, oldest first
+ *
+ * For a reader that follows the log (the telemetry publisher): *next is the
+ * number of events it has handled and moves past those copied. Events
+ * overwritten before the reader got to them are skipped; the caller sees
+ * them as *next advancing by more than the count returned.
+ *
+ * @param log Fault log
+ * @param next Reader position (0 = from the first event ever recorded)
+ * @param out Destination
+ * @param max Capacity of out
+ * @return Events written
+ */
+size_t fault_log_read(const fault_log_t *log, unsigned *next, fault_event_t *out, size_t max);
+
+/**
+ * @brief Get fault event kind as string ("raised", ...)
+ *
+ * @param kind Event kind
+ * @return Event name
+ */
+const char *fault_event_str(fault_event_kind_t kind);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,143 @@
+/**
+ * @file flight_rec.h
+ * @brief Fault and crash flight recorder (survives soft resets)
+ *
+ * A small binary ring of recent faults, key edges and worst RT stage
+ * timings, meant to live in RTC slow memory (RTC_NOINIT_ATTR, defined in
+ * main) so it is still there after a panic, watchdog or software reset.
+ * Only a power cycle clears it. At boot flight_rec_boot() keeps a valid
+ * record and appends a BOOT event with the reset reason, so the events
+ * leading up to a crash read back after it.
+ *
+ * Two lanes, one writer each, so recording is a few plain stores, a fence
+ * and an index bump; no atomic read-modify-write on RTC memory:
+ * - RT lane: rt_task on Core 0 (faults, key edges)
+ * - BG lane: Core 1 (boot, stage timing peaks)
+ * Readers merge the lanes by (boot, time) in flight_rec_snapshot().
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Single writer per lane, no locks
+ * - RULE 3.1.4: Recording never blocks; readers may race the writer and
+ *   discard what it overwrote while they copied
+ */
+
+#ifndef KEYER_FLIGHT_REC_H
+#define KEYER_FLIGHT_REC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "rt_prof.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLIGHT_REC_MAGIC    0x46524543U   /* "FREC" */
+#define FLIGHT_REC_VERSION  1U
+
+/** Events per lane (MUST be powers of 2) */
+#define FLIGHT_REC_RT_EVENTS 128U
+#define FLIGHT_REC_BG_EVENTS 32U
+
+/** Largest snapshot */
+#define FLIGHT_REC_MAX_EVENTS (FLIGHT_REC_RT_EVENTS + FLIGHT_REC_BG_EVENTS)
+
+/**
+ * @brief Event types
+ */
+typedef enum {
+    FLIGHT_EV_BOOT = 1,    /**< code: reset reason, value: boot number */
+    FLIGHT_EV_FAULT = 2,   /**< code: fault_code_t, value: fault data (lag) */
+    FLIGHT_EV_EDGE = 3,    /**< code: key level, value: us since the previous edge */
+    FLIGHT_EV_STAGE = 4,   /**< code: rt_prof_stage_t, value: new worst cycles */
+} flight_rec_type_t;
+
+/**
+ * @brief One recorded event (16 bytes)
+ */
+typedef struct {
+    int64_t time_us;   /**< esp_timer time within its boot */
+    uint32_t value;    /**< Type-specific, see flight_rec_type_t */
+    uint16_t boot;     /**< Boot the event belongs to (low 16 bits) */
+    uint8_t type;      /**< flight_rec_type_t */
+    uint8_t code;      /**< Type-specific */
+} flight_rec_event_t;
+
+/**
+ * @brief The recorder (placed in RTC slow memory on target)
+ */
+typedef struct {
+    uint32_t magic;                             /**< FLIGHT_REC_MAGIC if valid */
+    uint32_t version;                           /**< FLIGHT_REC_VERSION */
+    uint32_t size;                              /**< sizeof(flight_rec_t) */
+    uint32_t boot_count;                        /**< Boots since power-on */
+    uint32_t stage_max[RT_PROF_STAGE_COUNT];    /**< Worst cycles recorded this boot */
+    volatile uint32_t rt_idx;                   /**< Next RT lane event (monotonic) */
+    volatile uint32_t bg_idx;                   /**< Next BG lane event (monotonic) */
+    flight_rec_event_t rt_events[FLIGHT_REC_RT_EVENTS];  /**< Core 0 lane */
+    flight_rec_event_t bg_events[FLIGHT_REC_BG_EVENTS];  /**< Core 1 lane */
+} flight_rec_t;
+
+/** Global recorder (main.c, RTC_NOINIT_ATTR) */
+extern flight_rec_t g_flight_rec;
+
+/**
+ * @brief Validate after reset; wipe if not valid, then log the boot
+ *
+ * Call once, before any task records.
+ *
+ * @param rec Recorder
+ * @param reset_reason esp_reset_reason() value
+ * @param now_us Current time
+ * @return true if the previous contents survived
+ */
+bool flight_rec_boot(flight_rec_t *rec, uint8_t reset_reason, int64_t now_us);
+
+/**
+ * @brief Record on the RT lane (Core 0 only)
+ */
+void flight_rec_rt(flight_rec_t *rec, int64_t now_us, flight_rec_type_t type,
+                   uint8_t code, uint32_t value);
+
+/**
+ * @brief Record on the BG lane (Core 1 only)
+ */
+void flight_rec_bg(flight_rec_t *rec, int64_t now_us, flight_rec_type_t type,
+                   uint8_t code, uint32_t value);
+
+/**
+ * @brief Record a STAGE event if max_cycles beats this boot's worst (Core 1)
+ *
+ * @return true if recorded
+ */
+bool flight_rec_note_stage(flight_rec_t *rec, int64_t now_us, rt_prof_stage_t stage,
+                           uint32_t max_cycles);
+
+/**
+ * @brief Copy events oldest first, both lanes merged (any core)
+ *
+ * @param rec Recorder
+ * @param out Destination
+ * @param max Capacity of out (FLIGHT_REC_MAX_EVENTS for everything)
+ * @return Events written
+ */
+size_t flight_rec_snapshot(const flight_rec_t *rec, flight_rec_event_t *out, size_t max);
+
+/**
+ * @brief Get event type name ("boot", "fault", ...)
+ */
+const char *flight_rec_type_str(uint8_t type);
+
+/**
+ * @brief Get reset reason name of a BOOT event code ("PANIC", "SW", ...)
+ *
+ * @param reason esp_reset_reason_t value
+ */
+const char *flight_rec_reset_str(uint8_t reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_FLIGHT_REC_H */
@@ -0,0 +1,213 @@
+/**
+ * @file key_edge.h
+ * @brief Edge-extraction stage: keying stream → SPMC ring of key edges
+ *
+ * One stage walks the sample stream once and turns the edge flags that
+ * the producer already computed (FLAG_LOCAL_EDGE / FLAG_GPIO_EDGE) into
+ * compact key_edge_t events stamped with their absolute stream tick.
+ * Timeline, CWNet forwarding and other edge consumers each attach a
+ * key_edge_reader_t instead of re-scanning every sample themselves.
+ * REMOTE lane key events are published too, stamped with their play tick;
+ * those may be ahead of later LOCAL edges, so readers that need a
+ * monotonic timeline skip KEY_EDGE_CH_REMOTE.
+ *
+ * Single producer: the thread that calls key_edge_stage_run() (bg task).
+ * Multiple consumers: each reader has its own read index. A reader that
+ * falls more than a ring behind loses the oldest edges and counts them.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block (slow readers drop, never stall)
+ */
+
+#ifndef KEYER_KEY_EDGE_H
+#define KEYER_KEY_EDGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "sample.h"
+#include "stream.h"
+#include "consumer.h"
+#include "stream_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Ring capacity in edges (MUST be power of 2) */
+#define KEY_EDGE_RING_CAPACITY 256
+
+/**
+ * @brief Signal an edge belongs to
+ */
+typedef enum {
+    KEY_EDGE_CH_KEY = 0,   /**< Keyer output (local_key) */
+    KEY_EDGE_CH_DIT = 1,   /**< DIT paddle contact */
+    KEY_EDGE_CH_DAH = 2,   /**< DAH paddle contact */
+    KEY_EDGE_CH_REMOTE = 3, /**< Remote RX key (REMOTE lane play tick) */
+    KEY_EDGE_CH_COUNT = 4
+} key_edge_channel_t;
+
+/**
+ * @brief One level change on one channel
+ */
+typedef struct {
+    uint64_t tick;     /**< Absolute LOCAL stream tick of the change */
+    uint8_t  channel;  /**< key_edge_channel_t */
+    uint8_t  level;    /**< New level: 1 = down/pressed, 0 = up/released */
+    uint8_t  tag;      /**< KEY key-down edges: keyer tag (KEY_TAG_*), else 0 */
+} key_edge_t;
+
+/**
+ * @brief SPMC ring of key edges
+ */
+typedef struct {
+    key_edge_t buffer[KEY_EDGE_RING_CAPACITY]; /**< Edge storage */
+    atomic_size_t write_idx;                   /**< Next index to write (monotonic) */
+    atomic_uint_least32_t head_tick32;         /**< Low 32 bits of the stage tick after its last run */
+    const keying_stream_t *stream;             /**< Source stream (tick → time) */
+} key_edge_ring_t;
+
+/**
+ * @brief Extraction stage: owns a timed stream consumer feeding the ring
+ */
+typedef struct {
+    timed_consumer_t source;   /**< Stream position and tick cursor */
+    key_edge_ring_t *ring;     /**< Ring written to */
+    gpio_state_t prev_gpio;    /**< Paddle state after the last GPIO edge */
+    uint8_t key_level;         /**< Keyer output after the last key edge */
+    uint8_t remote_level;      /**< Remote key after the last REMOTE edge */
+    stream_index_t *index;     /**< Time index fed with checkpoints, NULL if none */
+} key_edge_stage_t;
+
+/**
+ * @brief Reader handle (one per subscriber)
+ */
+typedef struct {
+    const key_edge_ring_t *ring; /**< Ring read from */
+    size_t read_idx;             /**< Next index to read */
+    size_t dropped;              /**< Edges lost to ring overwrite */
+} key_edge_reader_t;
+
+/**
+ * @brief Initialize an empty ring
+ *
+ * @param ring Ring to initialize
+ * @param stream Stream the edges come from
+ */
+void key_edge_ring_init(key_edge_ring_t *ring, const keying_stream_t *stream);
+
+/**
+ * @brief Publish an edge from a producer other than the stage
+ *
+ * For rings fed from another source (the tone detector on receiver
+ * audio). Still single producer: never on a ring a stage also feeds.
+ * Edges published this way are untagged.
+ *
+ * @param ring Ring to publish into
+ * @param tick Absolute LOCAL tick of the change
+ * @param channel Signal that changed
+ * @param level New level
+ */
+void key_edge_ring_push(key_edge_ring_t *ring, uint64_t tick, key_edge_channel_t channel,
+                        uint8_t level);
+
+/**
+ * @brief Publish how far the producer has looked (see key_edge_head_tick)
+ *
+ * @param ring Ring the producer feeds
+ * @param tick Every edge before this tick is in the ring
+ */
+void key_edge_ring_set_head(key_edge_ring_t *ring, uint64_t tick);
+
+/**
+ * @brief Initialize the extraction stage at the key state checkpoint
+ *
+ * Starts with the paddle/key levels in effect at the stream head, so the
+ * first edges it publishes are real changes.
+ *
+ * @param stage Stage to initialize
+ * @param stream Stream to extract from
+ * @param ring Ring to publish edges into
+ */
+void key_edge_stage_init(key_edge_stage_t *stage, const keying_stream_t *stream,
+                         key_edge_ring_t *ring);
+
+/**
+ * @brief Also maintain a time index while extracting
+ *
+ * @param stage Stage handle
+ * @param index Index to feed (its single producer from now on)
+ */
+void key_edge_stage_attach_index(key_edge_stage_t *stage, stream_index_t *index);
+
+/**
+ * @brief Drain pending stream samples into the ring
+ *
+ * @param stage Stage handle (single producer)
+ * @return Number of edges published
+ */
+size_t key_edge_stage_run(key_edge_stage_t *stage);
+
+/**
+ * @brief Current level of every channel at the stage position
+ *
+ * For subscribers that join late (a new timeline client): send these as
+ * edges first, then read the ring from key_edge_reader_init().
+ *
+ * @param stage Stage handle (call from the stage thread)
+ * @param out One edge per channel, stamped with the stage's current tick
+ */
+void key_edge_stage_levels(const key_edge_stage_t *stage, key_edge_t out[KEY_EDGE_CH_COUNT]);
+
+/**
+ * @brief Initialize a reader at the current ring position
+ *
+ * @param reader Reader to initialize
+ * @param ring Ring to read
+ */
+void key_edge_reader_init(key_edge_reader_t *reader, const key_edge_ring_t *ring);
+
+/**
+ * @brief Read the next edge
+ *
+ * @param reader Reader handle
+ * @param out Edge (valid if true returned)
+ * @return true if an edge was read, false if caught up
+ */
+bool key_edge_reader_next(key_edge_reader_t *reader, key_edge_t *out);
+
+/**
+ * @brief Stream tick the stage had reached at its last run
+ *
+ * Every LOCAL edge before this tick is already in the ring, so a reader
+ * that has caught up knows the key held its level until here.
+ *
+ * @param ring Ring to query
+ * @param ref_tick Any absolute tick within +/-2^31 ticks (e.g. the last edge)
+ * @return Absolute LOCAL tick
+ */
+static inline uint64_t key_edge_head_tick(const key_edge_ring_t *ring, uint64_t ref_tick) {
+    uint32_t tick32 = atomic_load_explicit(&ring->head_tick32, memory_order_acquire);
+    return sample_resolve_tick(ref_tick, tick32);
+}
+
+/**
+ * @brief Convert an edge tick to time (esp_timer base)
+ *
+ * @param ring Ring the edge came from
+ * @param tick Absolute LOCAL tick
+ * @return epoch_us + tick * tick_period_us
+ */
+static inline int64_t key_edge_time_us(const key_edge_ring_t *ring, uint64_t tick) {
+    return stream_epoch_us(ring->stream) +
+           (int64_t)tick * (int64_t)stream_tick_period_us(ring->stream);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_KEY_EDGE_H */
@@ -0,0 +1,240 @@
+/**
+ * @file key_latency.h
+ * @brief End-to-end paddle-to-output latency measurement
+ *
+ * Measurement mode (off by default, console `latency on`): a paddle press
+ * seen from idle is followed through the keyer and timed against the
+ * esp_timer timestamp the GPIO ISR gave its edge:
+ *
+ *   tx        edge → hal_gpio_set_tx(true)
+ *   audio     edge → first non-silent sidetone sample handed to I2S
+ *   loopback  edge → first sample above KEY_LATENCY_LOOP_THRESHOLD read
+ *             back from the codec ADC (`latency loopback`, output wired or
+ *             held to the input, audio.rx_decode on: the acoustic sidetone
+ *             latency, I2S DMA and codec included)
+ *
+ * Only presses made with the key up and the sidetone silent are measured;
+ * presses during an element (memory) say nothing about latency. A press
+ * that produces no output within KEY_LATENCY_TIMEOUT_US (fault, text
+ * keyer sending) counts as missed. Polled presses carry no ISR time and
+ * are not measured.
+ *
+ * Histograms have four bins per octave of microseconds, so percentiles
+ * are within 25% of the true value (1us steps below 8us).
+ *
+ * Writers: RT task (tx, audio, arming), audio RX task (loopback). Each
+ * histogram has a single writer; resets are applied by that writer.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Relaxed atomics, no locks, nothing allocated
+ * - RULE 3.1.4: Recording never blocks; a few compares per tick when on
+ */
+
+#ifndef KEYER_KEY_LATENCY_H
+#define KEYER_KEY_LATENCY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Histogram bins (last bin holds everything >= 114688 us) */
+#define KEY_LATENCY_HIST_BINS 64
+
+/** Armed press without output after this long counts as missed */
+#define KEY_LATENCY_TIMEOUT_US 250000
+
+/** Loopback: |sample| that counts as tone (about -24 dBFS) */
+#define KEY_LATENCY_LOOP_THRESHOLD 2048
+
+/**
+ * @brief Measurement mode
+ */
+typedef enum {
+    KEY_LATENCY_OFF = 0,        /**< Nothing recorded */
+    KEY_LATENCY_ON,             /**< tx and audio */
+    KEY_LATENCY_LOOPBACK,       /**< tx, audio and codec ADC loopback */
+} key_latency_mode_t;
+
+/**
+ * @brief Measured paths
+ */
+typedef enum {
+    KEY_LATENCY_PATH_TX = 0,    /**< Edge → TX output */
+    KEY_LATENCY_PATH_AUDIO,     /**< Edge → sidetone handed to I2S */
+    KEY_LATENCY_PATH_LOOPBACK,  /**< Edge → sidetone read back from the ADC */
+    KEY_LATENCY_PATH_COUNT
+} key_latency_path_t;
+
+/**
+ * @brief Accumulators for one path (single writer)
+ */
+typedef struct {
+    atomic_uint count;                          /**< Presses recorded */
+    atomic_uint min_us;                         /**< Smallest latency */
+    atomic_uint max_us;                         /**< Largest latency */
+    atomic_uint hist[KEY_LATENCY_HIST_BINS];    /**< Quarter-octave histogram */
+    atomic_bool reset_requested;                /**< Set by readers, applied by writer */
+} key_latency_hist_t;
+
+/**
+ * @brief Latency probe
+ */
+typedef struct {
+    key_latency_hist_t path[KEY_LATENCY_PATH_COUNT];
+    atomic_uint mode;                           /**< key_latency_mode_t */
+    atomic_uint missed;                         /**< Armed presses that timed out */
+
+    /* RT task only */
+    int64_t edge_us;                            /**< ISR time of the armed press */
+    bool tx_pending;                            /**< Waiting for TX on */
+    bool audio_pending;                         /**< Waiting for a sounding sample */
+    bool tx_on;                                 /**< Last TX output state */
+    bool audio_quiet;                           /**< Last block was all silence */
+
+    /* Loopback handoff (RT task arms, audio RX task completes) */
+    atomic_uint loop_edge_us;                   /**< Low 32 bits of edge_us */
+    atomic_bool loop_armed;
+} key_latency_t;
+
+/**
+ * @brief Snapshot of one path
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t hist[KEY_LATENCY_HIST_BINS];
+} key_latency_snapshot_t;
+
+/** Global probe (RT task and audio RX task write, console and web UI read) */
+extern key_latency_t g_key_latency;
+
+/**
+ * @brief Clear everything, mode off
+ */
+void key_latency_init(key_latency_t *lat);
+
+/**
+ * @brief Select the mode (any task; pending measurements finish or time out)
+ */
+void key_latency_set_mode(key_latency_t *lat, key_latency_mode_t mode);
+
+/**
+ * @brief Current mode
+ */
+key_latency_mode_t key_latency_get_mode(const key_latency_t *lat);
+
+/**
+ * @brief A paddle press is queued (RT task)
+ *
+ * Arms a measurement if the mode is on, none is pending and the outputs
+ * are idle.
+ *
+ * @param lat Probe
+ * @param edge_us ISR timestamp of the press
+ */
+void key_latency_edge(key_latency_t *lat, int64_t edge_us);
+
+/**
+ * @brief TX output written (RT task, every tick)
+ *
+ * Also expires a measurement with no output after KEY_LATENCY_TIMEOUT_US.
+ *
+ * @param lat Probe
+ * @param tx_on State just written to hal_gpio_set_tx()
+ * @param now_us Time of the write
+ */
+void key_latency_tx(key_latency_t *lat, bool tx_on, int64_t now_us);
+
+/**
+ * @brief Audio block handed to I2S (RT task)
+ *
+ * @param lat Probe
+ * @param samples Block
+ * @param count Samples in block
+ * @param now_us Time of the hal_audio_write() call
+ */
+void key_latency_audio(key_latency_t *lat, const int16_t *samples, size_t count,
+                       int64_t now_us);
+
+/**
+ * @brief Audio read back from the codec ADC (audio RX task)
+ *
+ * The last sample is taken as captured at end_us, the others one sample
+ * period apart before it.
+ *
+ * @param lat Probe
+ * @param samples Block
+ * @param count Samples in block
+ * @param end_us Time the read returned
+ * @param sample_rate_hz Input sample rate
+ */
+void key_latency_loopback(key_latency_t *lat, const int16_t *samples, size_t count,
+                          int64_t end_us, uint32_t sample_rate_hz);
+
+/**
+ * @brief Request a reset (any task, applied by each path's writer)
+ */
+void key_latency_reset(key_latency_t *lat);
+
+/**
+ * @brief Snapshot one path (any task)
+ */
+void key_latency_get(key_latency_t *lat, key_latency_path_t path,
+                     key_latency_snapshot_t *out);
+
+/**
+ * @brief Latency percentile from a snapshot
+ *
+ * Returns the upper edge of the bin holding the pct-th percentile,
+ * clamped to [min_us, max_us].
+ *
+ * @param snap Snapshot
+ * @param pct Percentile, 0-100
+ * @return Latency in us, 0 if nothing was recorded
+ */
+uint32_t key_latency_percentile_us(const key_latency_snapshot_t *snap, uint32_t pct);
+
+/**
+ * @brief Largest latency a bin holds
+ */
+uint32_t key_latency_bin_upper_us(uint32_t bin);
+
+/**
+ * @brief Get path name ("tx", "audio", "loopback")
+ */
+const char *key_latency_path_str(key_latency_path_t path);
+
+/**
+ * @brief Get mode name ("off", "on", "loopback")
+ */
+const char *key_latency_mode_str(key_latency_mode_t mode);
+
+/**
+ * @brief Histogram bin for a latency
+ *
+ * 0-3us have a bin each; above, each octave [2^k, 2^(k+1)) is split into
+ * four equal bins.
+ */
+static inline uint32_t key_latency_bin(uint32_t us) {
+    if (us < 4U) {
+        return us;
+    }
+    uint32_t octave = 0;
+    for (uint32_t v = us; v > 1U; v >>= 1) {
+        octave++;
+    }
+    uint32_t bin = 4U * (octave - 1U) + ((us >> (octave - 2U)) & 3U);
+    return (bin < KEY_LATENCY_HIST_BINS) ? bin : KEY_LATENCY_HIST_BINS - 1U;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_KEY_LATENCY_H */
@@ -0,0 +1,194 @@
+/**
+ * @file key_stats.h
+ * @brief Sliding-window keying statistics (speed, weight, spacing, duty)
+ *
+ * A subscriber of the key edge ring that keeps, per channel, what was
+ * sent over the last 1 s, 10 s and 60 s: marks classified as dits and
+ * dahs, spaces as element, character and word gaps, and the time spent
+ * down. From those come the sent speed, the weight, the dah/dit ratio,
+ * the character and word gap lengths in units and the key-down duty
+ * (amplifier thermal budget), without the edge history.
+ *
+ * Each window is a ring of KEY_STATS_SLOTS slots plus their running sum:
+ * an edge adds to the open slot and the sum, and a slot that falls out
+ * of the window is subtracted once and reused. Every edge and every
+ * advance costs O(1) per window, however long the window. A window covers
+ * between KEY_STATS_SLOTS - 1 and KEY_STATS_SLOTS slots of time.
+ *
+ * Marks tagged by the iambic FSM (KEY_TAG_*) are taken as exact. Others
+ * (straight key, text keyer, remote) are split around a running unit
+ * estimate: under 2 units a dit, else a dah; spaces under 2 units are
+ * element gaps, under 5 character gaps, up to KEY_STATS_PAUSE_UNITS word
+ * gaps, and longer ones are pauses that count only toward the duty.
+ *
+ * Single producer (the decoder service, which runs the edge stage).
+ * Readers take one channel's figures at a time from a seqlock published
+ * by key_stats_advance(); the producer never waits for them.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#ifndef KEYER_KEY_STATS_H
+#define KEYER_KEY_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "key_edge.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Channels summarised: every key_edge_channel_t */
+#define KEY_STATS_CHANNELS KEY_EDGE_CH_COUNT
+
+/** Windows: 1 s, 10 s, 60 s */
+#define KEY_STATS_WINDOWS 3
+
+/** Slots per window */
+#define KEY_STATS_SLOTS 10
+
+/** Marks and spaces shorter than this are contact bounce, not elements */
+#define KEY_STATS_MIN_US 5000
+
+/** Spaces longer than this many units are pauses, not word gaps */
+#define KEY_STATS_PAUSE_UNITS 14
+
+/**
+ * @brief Window index
+ */
+typedef enum {
+    KEY_STATS_1S = 0,
+    KEY_STATS_10S = 1,
+    KEY_STATS_60S = 2,
+} key_stats_window_id_t;
+
+/**
+ * @brief Element kinds counted
+ */
+typedef enum {
+    KEY_STATS_DIT = 0,
+    KEY_STATS_DAH,
+    KEY_STATS_GAP_ELEMENT,
+    KEY_STATS_GAP_CHAR,
+    KEY_STATS_GAP_WORD,
+    KEY_STATS_KINDS
+} key_stats_kind_t;
+
+/**
+ * @brief Totals of one slot, or of a whole window
+ */
+typedef struct {
+    uint32_t down_us;                  /**< Time spent down */
+    uint32_t sum_us[KEY_STATS_KINDS];  /**< Duration of each kind */
+    uint16_t count[KEY_STATS_KINDS];   /**< Elements of each kind */
+} key_stats_acc_t;
+
+/**
+ * @brief One sliding window of one channel (producer)
+ */
+typedef struct {
+    key_stats_acc_t slot[KEY_STATS_SLOTS];
+    key_stats_acc_t sum;    /**< All slots */
+    uint32_t open;          /**< Slot number being filled (time / slot width) */
+} key_stats_window_t;
+
+/**
+ * @brief One channel (producer)
+ */
+typedef struct {
+    key_stats_window_t win[KEY_STATS_WINDOWS];
+    int64_t start_us;       /**< First time seen */
+    int64_t now_us;         /**< Time accounted up to */
+    int64_t since_us;       /**< Last level change, -1 before the first */
+    uint32_t unit_us;       /**< Running unit estimate, 0 = none yet */
+    uint8_t level;          /**< Current level */
+    uint8_t tag;            /**< Keyer tag of the current or last mark */
+    bool started;           /**< start_us is valid */
+} key_stats_channel_t;
+
+/**
+ * @brief Figures of one channel over one window
+ *
+ * Ratios are 0 while the window holds none of the elements they need.
+ */
+typedef struct {
+    uint32_t span_us;         /**< Time the window covers now (up to its length) */
+    uint16_t duty_pm;         /**< Key-down time, per mille of span_us */
+    uint16_t wpm_x10;         /**< Sent speed (PARIS), tenths of WPM */
+    uint16_t weight_pm;       /**< Dit / (dit + element gap), per mille (500 = even) */
+    uint16_t dah_ratio_x100;  /**< Mean dah / mean dit, hundredths (300 = standard) */
+    uint16_t char_gap_x100;   /**< Mean character gap in units, hundredths (300) */
+    uint16_t word_gap_x100;   /**< Mean word gap in units, hundredths (700) */
+    uint16_t marks;           /**< Dits and dahs */
+    uint16_t chars;           /**< Character and word gaps (characters ended) */
+    uint16_t words;           /**< Word gaps */
+} key_stats_view_t;
+
+/**
+ * @brief The statistics
+ */
+typedef struct {
+    key_stats_channel_t ch[KEY_STATS_CHANNELS];   /**< Producer state */
+    atomic_uint seq;                              /**< View seqlock, odd while writing */
+    key_stats_view_t view[KEY_STATS_CHANNELS][KEY_STATS_WINDOWS]; /**< Published figures */
+    int64_t view_us;                              /**< Time the views are for */
+} key_stats_t;
+
+/** Keying statistics (main/bg_task.c, PSRAM), fed by the decoder service */
+extern key_stats_t g_key_stats;
+
+/**
+ * @brief Reset every channel
+ */
+void key_stats_init(key_stats_t *ks);
+
+/**
+ * @brief Length of a window
+ */
+uint32_t key_stats_window_us(key_stats_window_id_t window);
+
+/**
+ * @brief Feed one edge (producer only, in time order per channel)
+ *
+ * Times before the channel's last one count as that time.
+ *
+ * @param ks Statistics
+ * @param time_us Edge time (esp_timer base)
+ * @param channel key_edge_channel_t (others ignored)
+ * @param level New level (1 = down)
+ * @param tag Keyer tag of a key-down edge (KEY_TAG_*), else 0
+ */
+void key_stats_edge(key_stats_t *ks, int64_t time_us, uint8_t channel, uint8_t level,
+                    uint8_t tag);
+
+/**
+ * @brief Account for time passing with no edge and publish the figures
+ *
+ * A channel already past now_us (REMOTE edges carry their play time)
+ * keeps its own time.
+ *
+ * @param ks Statistics
+ * @param now_us Time (esp_timer base) every edge before which was fed
+ */
+void key_stats_advance(key_stats_t *ks, int64_t now_us);
+
+/**
+ * @brief Published figures of one channel (any thread)
+ *
+ * @param ks Statistics
+ * @param channel key_edge_channel_t
+ * @param out One view per window
+ * @return Time the figures are for, 0 before the first advance
+ */
+int64_t key_stats_get(const key_stats_t *ks, uint8_t channel,
+                      key_stats_view_t out[KEY_STATS_WINDOWS]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_KEY_STATS_H */
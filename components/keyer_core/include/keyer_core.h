@@ -2,7 +2,8 @@
  * @file keyer_core.h
  * @brief Main include file for keyer_core component
  *
- * Includes all core types: stream, sample, consumer, fault.
+ * Includes all core types: stream, sample, consumer, key edges, fault, paddle edges,
+ * RT profiling, key latency probe, flight recorder, boot timeline.
  */
 
 #ifndef KEYER_CORE_H
@@ -10,7 +11,25 @@
 
 #include "sample.h"
 #include "stream.h"
+#include "stream_handoff.h"
 #include "consumer.h"
+#include "key_edge.h"
 #include "fault.h"
+#include "paddle_edge.h"
+#include "paddle_capture.h"
+#include "rt_prof.h"
+#include "key_latency.h"
+#include "rt_idle.h"
+#include "radio_focus.h"
+#include "tx_sched.h"
+#include "remote_tx.h"
+#include "flight_rec.h"
+#include "boot_timeline.h"
+#include "service.h"
+#include "task_stats.h"
+#include "metrics.h"
+#include "ota_update.h"
+#include "ota_delta.h"
+#include "timeline_pyramid.h"
 
 #endif /* KEYER_CORE_H */
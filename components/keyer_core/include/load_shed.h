@@ -0,0 +1,192 @@
+/**
+ * @file load_shed.h
+ * @brief Overload supervisor: sheds optional Core 1 work in a fixed order
+ *
+ * Keying never waits for Core 1, but what Core 1 does still costs: a
+ * WebUI burst, a VPN rekey or an LED animation delays the best-effort
+ * consumers (CWNet latency climbs with their lag), and flash writes turn
+ * the cache off on both cores, which stalls the RT loop itself.
+ *
+ * The housekeeping service (main/bg_task.c) feeds the supervisor every
+ * LOAD_SHED_PERIOD_MS with the RT tick counters (hal_tick: missed ticks,
+ * waits that timed out, plus RT faults) and the worst stream consumer
+ * lag. An evaluation is overloaded when the misses per second exceed
+ * system.shed_misses, any stall or fault happened, or the lag exceeds
+ * system.shed_lag samples.
+ *
+ * After LOAD_SHED_HOT_EVALS overloaded evaluations in a row one step is
+ * shed, and another at most every LOAD_SHED_STEP_MS while it lasts:
+ *
+ *   1. led       LED animations paused (RMT writes)
+ *   2. timeline  WebUI timeline pushed every LOAD_SHED_TIMELINE_MS
+ *   3. decoder   CW decoder suspended (catches up from the key edge
+ *                ring; edges the ring lapped meanwhile count as dropped)
+ *   4. nvs       NVS commits deferred as if keying (config_persist.h)
+ *
+ * Steps come back in reverse order, one per LOAD_SHED_RESTORE_MS without
+ * overload. Turning system.load_shed off restores one step per
+ * evaluation. Every shed and restore is counted per step (metrics, console
+ * "stats shed") and logged.
+ *
+ * Single writer (housekeeping); the level and the counters are atomics
+ * any task may read.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#ifndef KEYER_LOAD_SHED_H
+#define KEYER_LOAD_SHED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Evaluation period (the caller's) */
+#define LOAD_SHED_PERIOD_MS     250
+
+/** Overloaded evaluations in a row before a step is shed */
+#define LOAD_SHED_HOT_EVALS     2U
+
+/** Further steps are shed at most this often */
+#define LOAD_SHED_STEP_MS       1000
+
+/** A step is restored after this long without overload */
+#define LOAD_SHED_RESTORE_MS    10000
+
+/** Timeline push period while LOAD_SHED_TIMELINE is shed */
+#define LOAD_SHED_TIMELINE_MS   200
+
+/**
+ * @brief Optional work, in shedding order
+ */
+typedef enum {
+    LOAD_SHED_LED = 0,      /**< LED animations */
+    LOAD_SHED_TIMELINE,     /**< WebUI timeline pushes (throttled) */
+    LOAD_SHED_DECODER,      /**< CW decoder */
+    LOAD_SHED_NVS,          /**< NVS commits */
+    LOAD_SHED_STEPS
+} load_shed_step_t;
+
+/** Overload reasons (bit mask) */
+#define LOAD_SHED_WHY_MISSED    0x01U   /**< RT ticks missed over the limit */
+#define LOAD_SHED_WHY_STALL     0x02U   /**< Tick wait timed out or RT fault */
+#define LOAD_SHED_WHY_LAG       0x04U   /**< Consumer lag over the limit */
+
+/**
+ * @brief Counters the supervisor watches
+ *
+ * Running counters may be reset under it: a counter that went backwards
+ * counts as no change.
+ */
+typedef struct {
+    uint32_t missed_ticks;  /**< RT ticks missed (running) */
+    uint32_t stalls;        /**< Tick waits timed out + RT faults (running) */
+    uint32_t lag;           /**< Worst best-effort consumer lag now, samples */
+} load_shed_input_t;
+
+/**
+ * @brief Thresholds (system.load_shed, system.shed_misses, system.shed_lag)
+ */
+typedef struct {
+    bool enabled;
+    uint32_t max_missed_per_s;  /**< Missed ticks per second tolerated */
+    uint32_t max_lag;           /**< Consumer lag tolerated, samples */
+} load_shed_limits_t;
+
+/**
+ * @brief What an evaluation changed
+ */
+typedef enum {
+    LOAD_SHED_NONE = 0,
+    LOAD_SHED_SHED,         /**< step was shed */
+    LOAD_SHED_RESTORE,      /**< step was restored */
+} load_shed_action_t;
+
+typedef struct {
+    load_shed_action_t action;
+    load_shed_step_t step;  /**< Step shed or restored */
+    unsigned why;           /**< LOAD_SHED_WHY_* of this evaluation */
+} load_shed_event_t;
+
+/**
+ * @brief Supervisor state
+ */
+typedef struct {
+    load_shed_input_t prev;     /**< Input of the last evaluation */
+    int64_t prev_us;
+    int64_t change_us;          /**< Last shed or restore */
+    int64_t hot_us;             /**< Last overloaded evaluation */
+    uint32_t hot;               /**< Overloaded evaluations in a row */
+    bool have_prev;
+    atomic_uint level;                      /**< Steps shed (0 = all running) */
+    atomic_uint why;                        /**< Reasons of the last shed */
+    atomic_uint sheds[LOAD_SHED_STEPS];     /**< Times each step was shed */
+    atomic_uint restores[LOAD_SHED_STEPS];  /**< Times each step was restored */
+} load_shed_t;
+
+/** Supervisor instance (main/bg_task.c) */
+extern load_shed_t g_load_shed;
+
+/**
+ * @brief Start with everything running
+ */
+void load_shed_init(load_shed_t *ls);
+
+/**
+ * @brief Evaluate one period (writer only)
+ *
+ * The first call only takes the counters as a base.
+ *
+ * @param ls Supervisor
+ * @param now_us Time of the reading
+ * @param in Counters now
+ * @param limits Thresholds
+ * @return The step shed or restored, if any (at most one per call)
+ */
+load_shed_event_t load_shed_update(load_shed_t *ls, int64_t now_us,
+                                   const load_shed_input_t *in,
+                                   const load_shed_limits_t *limits);
+
+/**
+ * @brief Steps shed now (any task)
+ */
+static inline unsigned load_shed_level(const load_shed_t *ls) {
+    return atomic_load_explicit(&ls->level, memory_order_relaxed);
+}
+
+/**
+ * @brief Whether a step is shed now (any task)
+ */
+static inline bool load_shed_active(const load_shed_t *ls, load_shed_step_t step) {
+    return load_shed_level(ls) > (unsigned)step;
+}
+
+/**
+ * @brief Sheds and restores over all steps (any task)
+ */
+void load_shed_totals(const load_shed_t *ls, uint32_t *sheds, uint32_t *restores);
+
+/**
+ * @brief Step name ("led", "timeline", "decoder", "nvs")
+ */
+const char *load_shed_step_str(load_shed_step_t step);
+
+/**
+ * @brief Reasons as text ("missed+lag", "none")
+ *
+ * @return buf
+ */
+const char *load_shed_why_str(unsigned why, char *buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_LOAD_SHED_H */
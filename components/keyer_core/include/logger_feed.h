@@ -0,0 +1,155 @@
+/**
+ * @file logger_feed.h
+ * @brief Logger feed datagrams: decoded text and TX/RX state over UDP
+ *
+ * What the feed sender (keyer_telemetry/logger_feed_udp.c) broadcasts to
+ * logging programs on the LAN (system.logger_feed), kept free of sockets
+ * so the host tests can check it. One datagram per LOGGER_FEED_BATCH_MS
+ * with something to say, or per LOGGER_FEED_HEARTBEAT_MS without; plain
+ * ASCII, one line each, at most LOGGER_FEED_DATAGRAM_MAX bytes:
+ *
+ *   CWKF 1 <callsign> <seq> wpm=<keyer> dec=<decoded> tx=<0|1> rx=<0|1>
+ *   T <ms> <0|1>     TX (local key) started / stopped
+ *   R <ms> <0|1>     RX (remote key) started / stopped
+ *   C <ms> <char>    decoded character
+ *   W <ms> <word>    word completed, stamped with its first character
+ *   D <n>            events lost before this datagram
+ *
+ * <seq> counts datagrams, so a logger sees the ones it missed. <ms> is
+ * Unix time in milliseconds once the clock is set, else uptime. TX and RX
+ * follow the PTT: on at the first key-down, off once the key has been up
+ * for the hold time (timing.ptt_tail_ms), stamped at that last key-up.
+ *
+ * Nothing here blocks or allocates.
+ */
+
+#ifndef KEYER_LOGGER_FEED_H
+#define KEYER_LOGGER_FEED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default UDP port (system.logger_feed "addr[:port]") */
+#define LOGGER_FEED_PORT 12070
+
+/** Datagram size: below any LAN MTU, so never fragmented */
+#define LOGGER_FEED_DATAGRAM_MAX 1200
+
+/** Events are collected this long per datagram (the sender's period) */
+#define LOGGER_FEED_BATCH_MS 50
+
+/** A datagram at least this often, with or without events */
+#define LOGGER_FEED_HEARTBEAT_MS 1000
+
+/** Longest word sent whole; longer ones are cut */
+#define LOGGER_FEED_WORD_MAX 32
+
+/**
+ * @brief Header values (the state when the datagram is built)
+ */
+typedef struct {
+    const char *callsign;
+    uint32_t seq;             /**< Datagram number */
+    uint32_t keyer_wpm;       /**< Keyer speed setting */
+    uint32_t rx_wpm;          /**< Decoder speed estimate, 0 = none yet */
+    bool tx;                  /**< TX active */
+    bool rx;                  /**< RX active */
+} logger_feed_header_t;
+
+/**
+ * @brief One datagram being built
+ */
+typedef struct {
+    char buf[LOGGER_FEED_DATAGRAM_MAX];
+    size_t len;
+    uint32_t events;          /**< Event lines added */
+} logger_feed_batch_t;
+
+/**
+ * @brief Word assembler: characters since the last space
+ */
+typedef struct {
+    char word[LOGGER_FEED_WORD_MAX + 1];
+    size_t len;
+    int64_t first_ms;         /**< Time of the first character */
+} logger_feed_words_t;
+
+/**
+ * @brief TX or RX activity from one key's edges
+ */
+typedef struct {
+    bool on;                  /**< Active (as last reported) */
+    bool down;                /**< Key down now */
+    int64_t up_us;            /**< Last key-up */
+} logger_feed_activity_t;
+
+/**
+ * @brief Start a datagram with its header line
+ */
+void logger_feed_batch_begin(logger_feed_batch_t *b, const logger_feed_header_t *hdr);
+
+/**
+ * @brief Add a TX ('T') or RX ('R') start/stop
+ *
+ * @return false if the datagram is full (nothing added)
+ */
+bool logger_feed_batch_state(logger_feed_batch_t *b, char kind, int64_t ms, bool on);
+
+/**
+ * @brief Add a decoded character
+ *
+ * A space completes the word the assembler holds (a 'W' line, nothing if
+ * it is empty); anything else goes out as a 'C' line and joins the word.
+ * Unprintable characters are sent as '?'.
+ *
+ * @return false if the datagram is full (nothing added, assembler unchanged)
+ */
+bool logger_feed_batch_text(logger_feed_batch_t *b, logger_feed_words_t *w,
+                            int64_t ms, char c);
+
+/**
+ * @brief Add a loss report
+ *
+ * @return false if the datagram is full
+ */
+bool logger_feed_batch_dropped(logger_feed_batch_t *b, uint32_t lost);
+
+/**
+ * @brief Start with no word pending
+ */
+void logger_feed_words_init(logger_feed_words_t *w);
+
+/**
+ * @brief Start inactive, key up
+ */
+void logger_feed_activity_init(logger_feed_activity_t *a);
+
+/**
+ * @brief Feed one key edge
+ *
+ * @return true if this key-down started activity
+ */
+bool logger_feed_activity_edge(logger_feed_activity_t *a, int64_t time_us, bool down);
+
+/**
+ * @brief Check for the end of activity
+ *
+ * @param a Activity
+ * @param now_us Time every edge before has been fed
+ * @param hold_us Key-up time that ends it
+ * @param stop_us Last key-up (valid if true returned)
+ * @return true if activity stopped
+ */
+bool logger_feed_activity_poll(logger_feed_activity_t *a, int64_t now_us, int64_t hold_us,
+                               int64_t *stop_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_LOGGER_FEED_H */
@@ -0,0 +1,135 @@
+/**
+ * @file mem_budget.h
+ * @brief Heap budget per memory capability, with a low-water history
+ *
+ * Once a second the collector (main/bg_task.c, housekeeping service) reads
+ * heap_caps_get_info() for internal RAM, DMA-capable RAM and PSRAM and
+ * records free space, largest free block and the boot low-water mark.
+ * Free space is also folded into one-minute windows: the lowest free
+ * value of each window goes into a ring of the last MEM_BUDGET_HISTORY
+ * minutes, so a dip while the web UI, VPN and USB start together shows
+ * even though free space has recovered since.
+ *
+ * Static buffers are accounted at build time instead: idf.py mem-report
+ * (scripts/mem_report.py) lists .bss/.data per component and memory.
+ *
+ * Placement policy: buffers rt_task touches stay in internal RAM
+ * (RT_BUFFER_ATTR in main/main.c, CONFIG_KEYER_RT_IRAM); large buffers
+ * used only by Core 1 tasks go to PSRAM with EXT_RAM_BSS_ATTR, and
+ * runtime allocations that are not DMA or RT use MALLOC_CAP_SPIRAM.
+ *
+ * Single writer, lock-free readers (console "stats heap"): fields are
+ * relaxed atomics and a reader may see a sample half updated, which is
+ * harmless for figures read once a second.
+ *
+ * Pure logic, no heap_caps calls: the collector converts multi_heap_info_t.
+ */
+
+#ifndef KEYER_MEM_BUDGET_H
+#define KEYER_MEM_BUDGET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Low-water windows kept (one per MEM_BUDGET_WINDOW_S) */
+#define MEM_BUDGET_HISTORY 60U
+
+/** Window length, seconds */
+#define MEM_BUDGET_WINDOW_S 60U
+
+/**
+ * @brief Memory capabilities tracked
+ */
+typedef enum {
+    MEM_CAP_INTERNAL = 0,   /**< Internal DRAM (MALLOC_CAP_INTERNAL) */
+    MEM_CAP_DMA,            /**< DMA-capable (MALLOC_CAP_DMA) */
+    MEM_CAP_PSRAM,          /**< External PSRAM (MALLOC_CAP_SPIRAM) */
+    MEM_CAP_COUNT
+} mem_cap_t;
+
+/**
+ * @brief One capability as the collector reads it
+ */
+typedef struct {
+    uint32_t total;         /**< Heap size (0: capability absent) */
+    uint32_t free;          /**< Free now */
+    uint32_t largest;       /**< Largest free block */
+    uint32_t min_free;      /**< Least free since boot */
+} mem_cap_sample_t;
+
+/**
+ * @brief Accumulators for one capability
+ */
+typedef struct {
+    atomic_uint total;
+    atomic_uint free;
+    atomic_uint largest;
+    atomic_uint min_free;
+    atomic_uint window_low;                 /**< Least free in the open window */
+    atomic_uint history[MEM_BUDGET_HISTORY]; /**< Least free per closed window */
+} mem_cap_stats_t;
+
+/**
+ * @brief Budget state
+ */
+typedef struct {
+    mem_cap_stats_t cap[MEM_CAP_COUNT];
+    atomic_uint windows;                    /**< Windows closed */
+    uint32_t window_start_s;                /**< Writer only */
+    uint32_t samples;                       /**< Writer only */
+} mem_budget_t;
+
+/** Heap budget (main/bg_task.c, PSRAM) */
+extern mem_budget_t g_mem_budget;
+
+/**
+ * @brief Reset all figures
+ */
+void mem_budget_init(mem_budget_t *b);
+
+/**
+ * @brief Record one reading of every capability (single writer)
+ *
+ * @param b Budget
+ * @param now_s Uptime, seconds
+ * @param caps One sample per mem_cap_t
+ */
+void mem_budget_record(mem_budget_t *b, uint32_t now_s,
+                       const mem_cap_sample_t caps[MEM_CAP_COUNT]);
+
+/**
+ * @brief Latest reading of one capability
+ */
+void mem_budget_get(const mem_budget_t *b, mem_cap_t cap, mem_cap_sample_t *out);
+
+/**
+ * @brief Low-water marks of the closed windows, oldest first
+ *
+ * @param b Budget
+ * @param cap Capability
+ * @param out Least free per window
+ * @param max Capacity of out
+ * @return Windows copied (at most MEM_BUDGET_HISTORY)
+ */
+size_t mem_budget_history(const mem_budget_t *b, mem_cap_t cap, uint32_t *out, size_t max);
+
+/**
+ * @brief Least free in the open window
+ */
+uint32_t mem_budget_window_low(const mem_budget_t *b, mem_cap_t cap);
+
+/**
+ * @brief Capability name ("internal", "dma", "psram")
+ */
+const char *mem_cap_str(mem_cap_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_MEM_BUDGET_H */
@@ -0,0 +1,140 @@
+/**
+ * @file metrics.h
+ * @brief Metrics registry rendered in the Prometheus text format
+ *
+ * Counters stay where they are (decoder stats, fault state, stream
+ * consumer entries, VPN and CWNet contexts); each component registers a
+ * static descriptor per value at init, saying how to read it. A scrape
+ * walks the table and reads every value at that moment, so nothing is
+ * copied or aggregated in the background.
+ *
+ * A descriptor reads its value either through a function or, with no
+ * function, straight from an atomic_uint the component already keeps.
+ * Names may carry labels (keyer_stream_dropped_total{consumer="edges"});
+ * the series of one family are written together under a single HELP and
+ * TYPE, taken from the first one registered, whatever order the
+ * components registered them in.
+ *
+ * The renderer formats line by line into a caller buffer and hands it to
+ * a write function whenever the next line would not fit: the HTTP handler
+ * passes httpd_resp_send_chunk, the host tests a string.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: No locks; slots are claimed with fetch_add, published by
+ *   their descriptor pointer
+ * - No heap: the table and descriptors are static
+ */
+
+#ifndef KEYER_METRICS_H
+#define KEYER_METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Metrics a table holds */
+#define METRICS_MAX 64U
+
+/**
+ * @brief Metric type (Prometheus TYPE line)
+ */
+typedef enum {
+    METRIC_COUNTER = 0,   /**< Only goes up (wraps with its source) */
+    METRIC_GAUGE,         /**< Current value */
+} metric_type_t;
+
+/**
+ * @brief Read a value at scrape time
+ */
+typedef int64_t (*metric_read_fn_t)(const void *ctx);
+
+/**
+ * @brief Metric descriptor (static)
+ */
+typedef struct {
+    const char *name;        /**< Name, optionally with {labels} */
+    const char *help;        /**< HELP text (first metric of a family) */
+    metric_type_t type;
+    metric_read_fn_t read;   /**< NULL: ctx is a const atomic_uint * */
+    const void *ctx;         /**< Passed to read */
+} metric_desc_t;
+
+/**
+ * @brief Metrics table
+ */
+typedef struct {
+    atomic_uint count;                                /**< Slots claimed (may exceed MAX) */
+    _Atomic(const metric_desc_t *) slots[METRICS_MAX]; /**< NULL until published */
+} metrics_t;
+
+/** Global table (main/main.c) */
+extern metrics_t g_metrics;
+
+/**
+ * @brief Write rendered text
+ *
+ * @return false to stop rendering (client gone)
+ */
+typedef bool (*metrics_write_fn_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Clear the table
+ */
+void metrics_init(metrics_t *m);
+
+/**
+ * @brief Register one metric
+ *
+ * @return false if the table is full
+ */
+bool metrics_register(metrics_t *m, const metric_desc_t *desc);
+
+/**
+ * @brief Register an array of metrics, in order
+ *
+ * @return Metrics registered
+ */
+size_t metrics_register_all(metrics_t *m, const metric_desc_t *descs, size_t n);
+
+/**
+ * @brief Read one metric's current value
+ */
+int64_t metrics_read(const metric_desc_t *desc);
+
+/**
+ * @brief Render every metric in the text exposition format
+ *
+ * @param m Table
+ * @param buf Scratch buffer (lines longer than cap are skipped)
+ * @param cap Size of buf
+ * @param write Called with each filled buffer
+ * @param ctx Passed to write
+ * @return false if write failed
+ */
+bool metrics_render(const metrics_t *m, char *buf, size_t cap,
+                    metrics_write_fn_t write, void *ctx);
+
+/**
+ * @brief Render every metric as one compact JSON object
+ *
+ * {"faults_total":0,"stream_dropped_total{consumer=edges}":3,...}: names
+ * lose the "keyer_" prefix and the quotes around label values, so the
+ * whole registry fits one telemetry message.
+ *
+ * @param m Table
+ * @param buf Destination (NUL-terminated)
+ * @param cap Size of buf
+ * @return Length written, 0 if it does not fit
+ */
+size_t metrics_render_json(const metrics_t *m, char *buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_METRICS_H */
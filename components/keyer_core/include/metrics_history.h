@@ -0,0 +1,179 @@
+/**
+ * @file metrics_history.h
+ * @brief Fixed-memory history of every registered metric
+ *
+ * A scrape of the registry (metrics.h) shows one moment; this keeps the
+ * past. Once a second the housekeeping service (main/bg_task.c) reads
+ * every metric and adds it to three rings of buckets, 1 s, 1 min and
+ * 15 min wide, each bucket holding the min, max and average of the
+ * readings inside it. With METRICS_HISTORY_CAPACITY buckets per level
+ * that is about 2 minutes, 2 hours and 32 hours of every series (PSRAM).
+ *
+ * Gauges are kept as read. Counters are kept as their increase per
+ * second, so a rate needs no client-side differencing; a counter that
+ * goes backwards (reset, wrap) counts as no increase. Values are clamped
+ * to int32.
+ *
+ * Series are the registry slots, by index: a metric registered late
+ * simply has no readings in the buckets before it. A bucket is published
+ * when the next one starts, so the newest 15 min point can be up to
+ * 15 minutes old.
+ *
+ * Single writer, lock-free readers (GET /api/metrics/history): buckets
+ * carry sequence numbers and a reader drops any the writer lapped while
+ * it copied, as in task_stats.h.
+ */
+
+#ifndef KEYER_METRICS_HISTORY_H
+#define KEYER_METRICS_HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "metrics.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Resolutions kept */
+#define METRICS_HISTORY_LEVELS 3U
+
+/** Buckets per level (the last CAPACITY - 1 are readable) and series tracked */
+#ifdef CONFIG_KEYER_INTERNAL_RAM_ONLY
+#define METRICS_HISTORY_CAPACITY 32U
+#define METRICS_HISTORY_SERIES 16U
+#else
+#define METRICS_HISTORY_CAPACITY 128U
+#define METRICS_HISTORY_SERIES METRICS_MAX
+#endif
+
+/** Binary range format version (metrics_history_encode) */
+#define METRICS_HISTORY_BIN_VERSION 1U
+
+/** Binary header and record sizes */
+#define METRICS_HISTORY_BIN_HEADER 12U
+#define METRICS_HISTORY_BIN_RECORD 16U
+
+/**
+ * @brief One bucket of one series
+ *
+ * min > max: no reading of the series in this bucket.
+ */
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t avg;
+} metrics_history_bucket_t;
+
+/**
+ * @brief One point of a range query
+ */
+typedef struct {
+    uint32_t time_s;    /**< Bucket start (seconds since boot) */
+    int32_t min;
+    int32_t max;
+    int32_t avg;
+} metrics_history_point_t;
+
+/**
+ * @brief Open bucket totals of one series (writer only)
+ */
+typedef struct {
+    int64_t min;
+    int64_t max;
+    int64_t sum;
+    uint32_t n;
+} metrics_history_acc_t;
+
+/**
+ * @brief One resolution
+ */
+typedef struct {
+    atomic_uint head;                          /**< Buckets published */
+    uint32_t open_s;                           /**< Start of the open bucket */
+    bool open;                                 /**< Open bucket has readings */
+    uint32_t time_s[METRICS_HISTORY_CAPACITY]; /**< Start of each bucket */
+    metrics_history_bucket_t ring[METRICS_HISTORY_CAPACITY][METRICS_HISTORY_SERIES];
+    metrics_history_acc_t acc[METRICS_HISTORY_SERIES];
+} metrics_history_level_t;
+
+/**
+ * @brief History store
+ */
+typedef struct {
+    metrics_history_level_t levels[METRICS_HISTORY_LEVELS];
+    int64_t prev[METRICS_HISTORY_SERIES];      /**< Last counter reading */
+    bool have_prev[METRICS_HISTORY_SERIES];
+    uint32_t prev_s;                           /**< Time of the last sample */
+} metrics_history_t;
+
+/** Global store (main/bg_task.c) */
+extern metrics_history_t g_metrics_history;
+
+/**
+ * @brief Clear the store
+ */
+void metrics_history_init(metrics_history_t *h);
+
+/**
+ * @brief Bucket width of a level in seconds (1, 60, 900)
+ */
+uint32_t metrics_history_step_s(uint32_t level);
+
+/**
+ * @brief Level from its name ("1s", "1m", "15m")
+ *
+ * @return Level, or -1 if unknown
+ */
+int metrics_history_level_from_str(const char *s);
+
+/**
+ * @brief Level name
+ */
+const char *metrics_history_level_str(uint32_t level);
+
+/**
+ * @brief Read every metric once and add the readings to all levels
+ *
+ * @param h Store
+ * @param m Registry
+ * @param now_s Seconds since boot; call at most once per second
+ */
+void metrics_history_sample(metrics_history_t *h, const metrics_t *m, uint32_t now_s);
+
+/**
+ * @brief Copy the points of one series
+ *
+ * @param h Store
+ * @param level Resolution
+ * @param series Registry slot
+ * @param from_s Skip buckets that start earlier (0: everything kept)
+ * @param out Destination, oldest first
+ * @param max Capacity of out
+ * @return Points copied (buckets without a reading are left out)
+ */
+size_t metrics_history_read(const metrics_history_t *h, uint32_t level, uint32_t series,
+                            uint32_t from_s, metrics_history_point_t *out, size_t max);
+
+/**
+ * @brief Encode points in the binary range format
+ *
+ * Little-endian; header "MH", version, level, step_s (u32), count (u32),
+ * then per point time_s (u32), min, max, avg (i32).
+ *
+ * @return Bytes written, 0 if cap is too small
+ */
+size_t metrics_history_encode(uint32_t level, const metrics_history_point_t *pts, size_t n,
+                              uint8_t *buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_METRICS_HISTORY_H */
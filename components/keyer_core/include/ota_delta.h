@@ -0,0 +1,138 @@
+/**
+ * @file ota_delta.h
+ * @brief Delta firmware patches: header and streaming op decoder
+ *
+ * tools/ota_delta/mkdelta.py turns two app images into a patch that
+ * rebuilds the new one from the one the device is running:
+ *
+ *   header (OTA_DELTA_HEADER_SIZE bytes, uncompressed)
+ *     u32 magic "KDL1", u16 version, u16 reserved,
+ *     u32 old_size, u32 new_size, u8 old_sha256[32], u8 new_sha256[32]
+ *   zlib stream of ops
+ *     0x01 COPY   u32 old_off, u32 len             new += old[off..off+len)
+ *     0x02 ADD    u32 old_off, u32 len, len bytes  new += old[off+i] + byte[i]
+ *     0x03 INSERT u32 len, len bytes               new += bytes
+ *     0x00 END
+ *
+ * ADD carries the bytewise difference from a shifted copy of the old
+ * image (code that moved and had its addresses changed), which is mostly
+ * zeros and compresses far better than the new bytes themselves.
+ *
+ * The decoder is fed the decompressed op stream in pieces of any size and
+ * produces the new image in order through callbacks: old bytes are read
+ * from the running partition, new bytes go to the OTA write. Its only
+ * buffer is a fixed scratch for old reads, so RAM does not grow with the
+ * image. Integers are little-endian.
+ *
+ * Pure logic, no ESP-IDF calls. Single owner.
+ */
+
+#ifndef KEYER_OTA_DELTA_H
+#define KEYER_OTA_DELTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ota_update.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** "KDL1" */
+#define OTA_DELTA_MAGIC 0x314C444BU
+
+/** Patch format version */
+#define OTA_DELTA_VERSION 1U
+
+/** Uncompressed header bytes */
+#define OTA_DELTA_HEADER_SIZE 80U
+
+/** Old-image bytes read per callback */
+#define OTA_DELTA_SCRATCH 512U
+
+/** Op codes */
+#define OTA_DELTA_OP_END    0x00U
+#define OTA_DELTA_OP_COPY   0x01U
+#define OTA_DELTA_OP_ADD    0x02U
+#define OTA_DELTA_OP_INSERT 0x03U
+
+/**
+ * @brief Patch header
+ */
+typedef struct {
+    uint32_t old_size;                   /**< Image the patch applies to */
+    uint32_t new_size;                   /**< Image it produces */
+    uint8_t old_sha[OTA_SHA256_LEN];
+    uint8_t new_sha[OTA_SHA256_LEN];
+} ota_delta_header_t;
+
+/**
+ * @brief Read old-image bytes
+ *
+ * @return false on a read error
+ */
+typedef bool (*ota_delta_read_fn)(void *ctx, uint32_t off, uint8_t *buf, size_t len);
+
+/**
+ * @brief Append new-image bytes
+ *
+ * @return false to stop (write error)
+ */
+typedef bool (*ota_delta_write_fn)(void *ctx, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Decoder result
+ */
+typedef enum {
+    OTA_DELTA_MORE = 0,     /**< Op stream not finished, feed more */
+    OTA_DELTA_DONE,         /**< END seen and exactly new_size bytes produced */
+    OTA_DELTA_ERROR,        /**< Bad op, out of range, size mismatch or callback failure */
+} ota_delta_status_t;
+
+/**
+ * @brief Decoder state
+ */
+typedef struct {
+    ota_delta_header_t hdr;
+    ota_delta_read_fn read;
+    ota_delta_write_fn write;
+    void *ctx;
+    uint32_t produced;           /**< New-image bytes written */
+    uint32_t old_pos;            /**< ADD: next old offset */
+    uint32_t remaining;          /**< ADD/INSERT: data bytes still to come */
+    uint8_t op;                  /**< Op being decoded */
+    uint8_t arg_len;             /**< Argument bytes collected */
+    uint8_t args[8];
+    uint8_t state;               /**< Internal */
+    uint8_t scratch[OTA_DELTA_SCRATCH];
+} ota_delta_t;
+
+/**
+ * @brief Parse and check a patch header
+ *
+ * @param buf OTA_DELTA_HEADER_SIZE bytes
+ * @param out Parsed header
+ * @return false if the magic or version do not match
+ */
+bool ota_delta_parse_header(const uint8_t *buf, ota_delta_header_t *out);
+
+/**
+ * @brief Start decoding ops
+ */
+void ota_delta_init(ota_delta_t *d, const ota_delta_header_t *hdr,
+                    ota_delta_read_fn read, ota_delta_write_fn write, void *ctx);
+
+/**
+ * @brief Feed decompressed op-stream bytes
+ *
+ * @return OTA_DELTA_DONE once END was decoded (bytes after it are an
+ *         error), OTA_DELTA_ERROR on any fault (sticky)
+ */
+ota_delta_status_t ota_delta_feed(ota_delta_t *d, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_OTA_DELTA_H */
@@ -0,0 +1,110 @@
+/**
+ * @file ota_update.h
+ * @brief Bookkeeping for streamed firmware updates and the post-update self-test
+ *
+ * POST /api/ota (keyer_webui/src/api_ota.c) writes the request body into
+ * the next OTA partition as it arrives. This module holds the parts of
+ * that pipeline that need no ESP-IDF: parsing the expected SHA-256 the
+ * client sends, deciding when a progress message is worth broadcasting,
+ * and judging the first boot of a new image (main/ota_check.c), which
+ * either confirms it or rolls back to the previous one.
+ *
+ * Pure logic, no ESP-IDF calls.
+ */
+
+#ifndef KEYER_OTA_UPDATE_H
+#define KEYER_OTA_UPDATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** SHA-256 digest bytes */
+#define OTA_SHA256_LEN 32U
+
+/** Progress is reported at least this many percent apart... */
+#define OTA_PROGRESS_STEP_PCT 2U
+
+/** ...and no more often than this */
+#define OTA_PROGRESS_MIN_US 250000
+
+/** A new image must run this long before it is confirmed */
+#define OTA_SELF_TEST_MS 30000U
+
+/** Roll back if it has not passed by then */
+#define OTA_SELF_TEST_DEADLINE_MS 120000U
+
+/** Internal heap a healthy image keeps free */
+#define OTA_SELF_TEST_MIN_HEAP 16384U
+
+/**
+ * @brief Parse a 64-digit hex digest (either case)
+ *
+ * @return false unless the string is exactly 64 hex digits
+ */
+bool ota_parse_sha256(const char *hex, uint8_t out[OTA_SHA256_LEN]);
+
+/**
+ * @brief Progress throttle
+ */
+typedef struct {
+    uint32_t total;            /**< Image bytes (Content-Length) */
+    uint32_t reported_pct;     /**< Last percentage sent */
+    int64_t reported_us;       /**< When it was sent */
+    bool started;              /**< Something was sent */
+} ota_progress_t;
+
+/**
+ * @brief Start tracking an upload
+ */
+void ota_progress_init(ota_progress_t *p, uint32_t total);
+
+/**
+ * @brief Account for written bytes
+ *
+ * @param p Throttle
+ * @param written Bytes written so far
+ * @param now_us Current time
+ * @param pct Current percentage (0..100)
+ * @return true if a progress message should go out now (the first call,
+ *         the last byte, or OTA_PROGRESS_STEP_PCT more and
+ *         OTA_PROGRESS_MIN_US later than the last one)
+ */
+bool ota_progress_step(ota_progress_t *p, uint32_t written, int64_t now_us, uint32_t *pct);
+
+/**
+ * @brief Health of a first boot after an update
+ */
+typedef struct {
+    uint32_t uptime_ms;
+    bool fault_active;          /**< Keying fault latched */
+    uint32_t heap_free;         /**< Free internal heap */
+    bool reachable;             /**< Network up (or deliberately off) for the next update */
+} ota_health_t;
+
+/**
+ * @brief Self-test verdict
+ */
+typedef enum {
+    OTA_VERDICT_PENDING = 0,    /**< Keep watching */
+    OTA_VERDICT_PASS,           /**< Confirm the image */
+    OTA_VERDICT_FAIL,           /**< Roll back */
+} ota_verdict_t;
+
+/**
+ * @brief Judge a running image that is still pending verification
+ *
+ * Passes once it has run OTA_SELF_TEST_MS healthy (no fault, enough heap,
+ * reachable); fails when OTA_SELF_TEST_DEADLINE_MS passes without that.
+ */
+ota_verdict_t ota_self_test_judge(const ota_health_t *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_OTA_UPDATE_H */
@@ -0,0 +1,167 @@
+/**
+ * @file paddle_capture.h
+ * @brief Timebase and debounce for hardware-captured paddle edges
+ *
+ * With CONFIG_KEYER_PADDLE_CAPTURE the paddle pins feed capture channels
+ * that latch a free-running counter on every edge, bounce included. The
+ * capture ISR only converts the count to esp_timer time and queues the raw
+ * edge; the RT task debounces the batch once per tick. No timer callbacks,
+ * no interrupt disable/re-arm.
+ *
+ * Timebase: consecutive edges are chained by their counter difference, so
+ * times inside a burst are exact to the counter tick. A burst (first edge
+ * after PADDLE_CAPTURE_REANCHOR_US of silence) is anchored at the ISR
+ * time, and pulled earlier whenever a later ISR proves it was serviced
+ * faster. The gap bound also keeps the 32-bit counter from wrapping.
+ *
+ * Debounce: the first edge that changes a paddle's level is accepted at
+ * its own time and opens a window of debounce_us in which further edges
+ * only track the raw level. If the raw level differs from the accepted one
+ * when the window closes (a tap shorter than the window, or a bounce that
+ * ended the other way), that level is accepted at the window end.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Clock state has one writer (the capture ISR), debounce
+ *   state one (the RT task); edges cross in paddle_edge_queue_t
+ * - RULE 3.1.4: Nothing blocks; a full output queue drops the edge
+ */
+
+#ifndef KEYER_PADDLE_CAPTURE_H
+#define KEYER_PADDLE_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "paddle_edge.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Silence after which the next edge re-anchors the timebase */
+#define PADDLE_CAPTURE_REANCHOR_US 100000
+
+/**
+ * @brief Capture counter → esp_timer time (capture ISR only)
+ */
+typedef struct {
+    uint32_t ticks_per_us;  /**< Capture counter resolution */
+    bool anchored;          /**< A burst is in progress */
+    uint32_t last_cap;      /**< Counter value of the previous edge */
+    uint32_t rem_ticks;     /**< Ticks not yet a whole µs */
+    int64_t last_us;        /**< Time given to the previous edge */
+    int64_t last_isr_us;    /**< ISR time of the previous edge */
+} paddle_capture_clock_t;
+
+/**
+ * @brief Initialize a timebase
+ *
+ * @param c Timebase
+ * @param resolution_hz Capture counter frequency (>= 1 MHz)
+ */
+static inline void paddle_capture_clock_init(paddle_capture_clock_t *c, uint32_t resolution_hz) {
+    uint32_t tpu = resolution_hz / 1000000U;
+    c->ticks_per_us = (tpu > 0) ? tpu : 1U;
+    c->anchored = false;
+    c->last_cap = 0;
+    c->rem_ticks = 0;
+    c->last_us = 0;
+    c->last_isr_us = 0;
+}
+
+/**
+ * @brief Time of a captured edge (capture ISR)
+ *
+ * @param c Timebase
+ * @param cap Counter value latched by the edge
+ * @param isr_us esp_timer time the ISR read now
+ * @return esp_timer time of the edge, never after isr_us
+ */
+static inline int64_t paddle_capture_clock_us(paddle_capture_clock_t *c, uint32_t cap,
+                                              int64_t isr_us) {
+    int64_t t = isr_us;
+    if (c->anchored && isr_us - c->last_isr_us <= PADDLE_CAPTURE_REANCHOR_US) {
+        uint32_t ticks = (uint32_t)(cap - c->last_cap) + c->rem_ticks;
+        c->rem_ticks = ticks % c->ticks_per_us;
+        t = c->last_us + (int64_t)(ticks / c->ticks_per_us);
+        if (t > isr_us) {
+            /* Anchor was serviced late: this ISR bounds the burst better */
+            t = isr_us;
+        }
+    } else {
+        c->anchored = true;
+        c->rem_ticks = 0;
+    }
+    c->last_cap = cap;
+    c->last_us = t;
+    c->last_isr_us = isr_us;
+    return t;
+}
+
+/**
+ * @brief Per-paddle debouncer over raw edges (RT task only)
+ *
+ * Indexed by paddle_edge_paddle_t.
+ */
+typedef struct {
+    uint32_t debounce_us;       /**< Window after an accepted edge */
+    uint8_t level[2];           /**< Accepted level (1 = pressed) */
+    uint8_t raw[2];             /**< Last raw level seen */
+    int64_t quiet_us[2];        /**< Window end of the last accepted edge */
+    int64_t last_out_us;        /**< Time of the last edge handed out */
+    uint32_t accepted;          /**< Edges handed out */
+    uint32_t rejected;          /**< Bounce edges swallowed */
+} paddle_debounce_t;
+
+/**
+ * @brief Initialize a debouncer (both paddles released)
+ *
+ * @param d Debouncer
+ * @param debounce_us Window after each accepted edge
+ */
+void paddle_debounce_init(paddle_debounce_t *d, uint32_t debounce_us);
+
+/**
+ * @brief Feed one raw edge, in time order (RT task)
+ *
+ * Windows that closed before the edge are settled first, so the output
+ * stays in time order across both paddles.
+ *
+ * @param d Debouncer
+ * @param raw Raw edge (level is logical: 1 = pressed)
+ * @param out Debounced edges
+ */
+void paddle_debounce_feed(paddle_debounce_t *d, const paddle_edge_t *raw,
+                          paddle_edge_queue_t *out);
+
+/**
+ * @brief Settle windows that have closed by now (RT task, every tick)
+ *
+ * @param d Debouncer
+ * @param now_us Current time
+ * @param out Debounced edges
+ */
+void paddle_debounce_settle(paddle_debounce_t *d, int64_t now_us, paddle_edge_queue_t *out);
+
+/**
+ * @brief Paddle has no open window at now_us
+ *
+ * A pin read then is trustworthy, so a level that differs from the
+ * accepted one means an edge was lost (capture overrun, full queue).
+ */
+static inline bool paddle_debounce_settled(const paddle_debounce_t *d, uint8_t paddle,
+                                           int64_t now_us) {
+    return now_us >= d->quiet_us[paddle & 1U];
+}
+
+/**
+ * @brief Accepted level of a paddle (1 = pressed)
+ */
+static inline uint8_t paddle_debounce_level(const paddle_debounce_t *d, uint8_t paddle) {
+    return d->level[paddle & 1U];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_PADDLE_CAPTURE_H */
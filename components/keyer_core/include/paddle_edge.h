@@ -0,0 +1,156 @@
+/**
+ * @file paddle_edge.h
+ * @brief Lock-free SPSC queue of timestamped paddle edges (ISR → RT task)
+ *
+ * The paddle ISRs record the exact time of every edge they see. The RT
+ * task drains the queue once per tick and feeds the edges to the iambic
+ * FSM in order, so memory-window and squeeze decisions use the true edge
+ * time instead of the tick time, and two presses inside one tick are not
+ * collapsed into one.
+ *
+ * Single producer: the DIT and DAH ISRs are both dispatched by the GPIO
+ * ISR service on the same core at the same interrupt level, so they never
+ * run concurrently. Single consumer: the RT task.
+ *
+ * All functions are static inline so the producer side is inlined into
+ * IRAM ISR handlers.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block (full queue drops the edge)
+ */
+
+#ifndef KEYER_PADDLE_EDGE_H
+#define KEYER_PADDLE_EDGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Queue capacity in edges (MUST be power of 2) */
+#define PADDLE_EDGE_QUEUE_CAPACITY 16
+
+/**
+ * @brief Paddle that produced an edge
+ */
+typedef enum {
+    PADDLE_EDGE_DIT = 0,
+    PADDLE_EDGE_DAH = 1,
+} paddle_edge_paddle_t;
+
+/**
+ * @brief One paddle edge
+ */
+typedef struct {
+    int64_t timestamp_us;   /**< esp_timer time of the edge */
+    uint8_t paddle;         /**< paddle_edge_paddle_t */
+    uint8_t level;          /**< 1 = pressed, 0 = released (logical, not pin level) */
+} paddle_edge_t;
+
+/**
+ * @brief SPSC ring of paddle edges
+ *
+ * head/tail are monotonic; index with & (capacity - 1).
+ */
+typedef struct {
+    paddle_edge_t buffer[PADDLE_EDGE_QUEUE_CAPACITY];
+    atomic_uint_fast32_t head;      /**< Producer write count */
+    atomic_uint_fast32_t tail;      /**< Consumer read count */
+    atomic_uint_fast32_t dropped;   /**< Edges dropped because queue was full */
+} paddle_edge_queue_t;
+
+/**
+ * @brief Initialize (or clear) queue
+ *
+ * @param q Queue to initialize
+ */
+static inline void paddle_edge_queue_init(paddle_edge_queue_t *q) {
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->dropped, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Push edge (producer / ISR only)
+ *
+ * @param q Queue
+ * @param edge Edge to record
+ * @return true on success, false if full (edge dropped and counted)
+ */
+static inline bool paddle_edge_push(paddle_edge_queue_t *q, const paddle_edge_t *edge) {
+    uint_fast32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint_fast32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+    if ((head - tail) >= PADDLE_EDGE_QUEUE_CAPACITY) {
+        atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    q->buffer[head & (PADDLE_EDGE_QUEUE_CAPACITY - 1)] = *edge;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Pop oldest edge (consumer / RT task only)
+ *
+ * @param q Queue
+ * @param out Output edge
+ * @return true if an edge was returned, false if empty
+ */
+static inline bool paddle_edge_pop(paddle_edge_queue_t *q, paddle_edge_t *out) {
+    uint_fast32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint_fast32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+    if (tail == head) {
+        return false;
+    }
+
+    *out = q->buffer[tail & (PADDLE_EDGE_QUEUE_CAPACITY - 1)];
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Look at the oldest edge without removing it (consumer / RT task only)
+ *
+ * @param q Queue
+ * @param out Output edge
+ * @return true if an edge was returned, false if empty
+ */
+static inline bool paddle_edge_peek(paddle_edge_queue_t *q, paddle_edge_t *out) {
+    uint_fast32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint_fast32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+    if (tail == head) {
+        return false;
+    }
+
+    *out = q->buffer[tail & (PADDLE_EDGE_QUEUE_CAPACITY - 1)];
+    return true;
+}
+
+/**
+ * @brief Check if queue has no pending edges
+ */
+static inline bool paddle_edge_queue_empty(paddle_edge_queue_t *q) {
+    return atomic_load_explicit(&q->tail, memory_order_relaxed) ==
+           atomic_load_explicit(&q->head, memory_order_acquire);
+}
+
+/**
+ * @brief Get number of edges dropped on overflow
+ */
+static inline uint32_t paddle_edge_dropped(paddle_edge_queue_t *q) {
+    return (uint32_t)atomic_load_explicit(&q->dropped, memory_order_relaxed);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_PADDLE_EDGE_H */
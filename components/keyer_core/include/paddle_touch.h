@@ -0,0 +1,93 @@
+/**
+ * @file paddle_touch.h
+ * @brief Scan plan and thresholds for capacitive touch paddles
+ *
+ * With CONFIG_KEYER_PADDLE_TOUCH the paddle pins are touch pads read by the
+ * ESP32-S3 touch sensor in hardware-scan (timer FSM) mode: it measures each
+ * pad in turn, then sleeps. Its IIR filters keep a benchmark (the untouched
+ * reading) and a smoothed reading per pad, and it interrupts when the
+ * smoothed reading crosses benchmark + threshold for its debounce count.
+ * The touch ISR timestamps the change into a raw edge queue that hal_gpio
+ * debounces like captured edges (paddle_capture.h).
+ *
+ * A press is seen PADDLE_TOUCH_FILTER_SAMPLES scans after it happens, so
+ * the scan period sets the sensing latency. The plan keeps that within a
+ * budget (one RT tick): the longest measurement that fits first, since it
+ * sets the signal to noise ratio, then sleep for the rest.
+ *
+ * Used once at init; nothing here runs on the RT path.
+ */
+
+#ifndef KEYER_PADDLE_TOUCH_H
+#define KEYER_PADDLE_TOUCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Touch pads are GPIO 1-14 on the S3 (pad n is GPIO n) */
+#define PADDLE_TOUCH_PAD_NONE 0U
+#define PADDLE_TOUCH_PAD_MIN 1U
+#define PADDLE_TOUCH_PAD_MAX 14U
+
+/** Scans from touch to interrupt: scan phase, IIR 1/2 smoothing, debounce 1 */
+#define PADDLE_TOUCH_FILTER_SAMPLES 3U
+
+/** One charge/discharge cycle of a paddle-sized pad (estimate) */
+#define PADDLE_TOUCH_CYCLE_NS 250U
+
+/** RTC slow clock that paces the sleep between scans (RC, 136 kHz) */
+#define PADDLE_TOUCH_SLOW_CLK_HZ 136000U
+
+/** Charge/discharge cycles per measurement: driver default, and the floor */
+#define PADDLE_TOUCH_MEAS_DEFAULT 500U
+#define PADDLE_TOUCH_MEAS_MIN 64U
+
+/**
+ * @brief Touch sensor timing
+ */
+typedef struct {
+    uint16_t meas_cycles;   /**< Charge/discharge cycles per pad measurement */
+    uint16_t sleep_cycles;  /**< Slow clock cycles between scans (>= 1) */
+    uint32_t scan_us;       /**< Scan period: every pad, then the sleep */
+    uint32_t latency_us;    /**< Touch to interrupt, worst case */
+} paddle_touch_scan_t;
+
+/**
+ * @brief Touch pad of a GPIO
+ * @return Pad number, PADDLE_TOUCH_PAD_NONE if the pin has none
+ */
+static inline uint8_t paddle_touch_pad(uint8_t gpio) {
+    return (gpio >= PADDLE_TOUCH_PAD_MIN && gpio <= PADDLE_TOUCH_PAD_MAX)
+               ? gpio : (uint8_t)PADDLE_TOUCH_PAD_NONE;
+}
+
+/**
+ * @brief Plan the scan for a sensing latency budget
+ *
+ * With a budget too short even for PADDLE_TOUCH_MEAS_MIN cycles and one
+ * sleep cycle, the plan is that minimum and latency_us says how far over
+ * it is.
+ *
+ * @param plan Result
+ * @param budget_us Longest touch to interrupt time wanted
+ * @param pads Pads scanned (at least 1)
+ */
+void paddle_touch_scan_plan(paddle_touch_scan_t *plan, uint32_t budget_us, uint8_t pads);
+
+/**
+ * @brief Touch threshold over the benchmark
+ *
+ * @param benchmark Untouched reading
+ * @param pct Threshold, percent of the benchmark
+ * @return Threshold in reading units (at least 1)
+ */
+uint32_t paddle_touch_threshold(uint32_t benchmark, uint8_t pct);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_PADDLE_TOUCH_H */
@@ -0,0 +1,116 @@
+/**
+ * @file radio_focus.h
+ * @brief SO2R radio focus: which TX output the keyer drives
+ *
+ * One operator, one set of paddles and one text keyer, up to
+ * RADIO_FOCUS_MAX radios: the keying goes to the radio in focus, the
+ * others stay unkeyed. keyer.radio asks for a radio (console, WinKeyer
+ * PinConfig, web UI); the RT task takes it over only on a tick with the
+ * key up and nothing half sent (no element, memory, text or remote
+ * keying in flight), so a character never starts on one radio and ends
+ * on the other.
+ *
+ * A request for a radio without an output (hardware.gpio_tx2 = 0) is
+ * kept but never taken.
+ *
+ * Writer: RT task only. Readers (console) see relaxed atomics.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Relaxed atomics, no locks, nothing allocated
+ * - RULE 3.1.4: One compare per tick with no switch pending
+ */
+
+#ifndef KEYER_RADIO_FOCUS_H
+#define KEYER_RADIO_FOCUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Radios the keyer can drive */
+#define RADIO_FOCUS_MAX 2U
+
+/**
+ * @brief Focus state
+ */
+typedef struct {
+    /* RT task only */
+    uint8_t count;              /**< Radios with a TX output (1..RADIO_FOCUS_MAX) */
+
+    /* RT task writes, any task reads */
+    atomic_uint active;         /**< Radio keyed now (0-based) */
+    atomic_uint requested;      /**< Radio asked for (0-based) */
+    atomic_uint switches;       /**< Focus changes taken */
+} radio_focus_t;
+
+/**
+ * @brief Snapshot for the console
+ */
+typedef struct {
+    uint8_t count;
+    uint8_t active;
+    uint8_t requested;
+    bool available;             /**< requested has an output */
+    uint32_t switches;
+} radio_focus_stats_t;
+
+/** Global focus (RT task writes, console reads) */
+extern radio_focus_t g_radio_focus;
+
+/**
+ * @brief Start on radio 0
+ *
+ * @param rf Focus
+ * @param count Radios with a TX output (clamped to 1..RADIO_FOCUS_MAX)
+ */
+void radio_focus_init(radio_focus_t *rf, uint8_t count);
+
+/**
+ * @brief Ask for a radio (RT task, on a config change)
+ *
+ * @param rf Focus
+ * @param radio Radio, 0-based
+ */
+void radio_focus_request(radio_focus_t *rf, uint8_t radio);
+
+/**
+ * @brief Radio keyed now
+ */
+static inline uint8_t radio_focus_active(const radio_focus_t *rf) {
+    return (uint8_t)atomic_load_explicit(&rf->active, memory_order_relaxed);
+}
+
+/**
+ * @brief Take a pending request (RT task, every tick)
+ *
+ * @param rf Focus
+ * @param idle Key up and nothing half sent on this tick
+ * @return true when the focus moved: route TX to radio_focus_active()
+ */
+static inline bool radio_focus_tick(radio_focus_t *rf, bool idle) {
+    unsigned want = atomic_load_explicit(&rf->requested, memory_order_relaxed);
+    if (!idle || want == atomic_load_explicit(&rf->active, memory_order_relaxed) ||
+        want >= rf->count) {
+        return false;
+    }
+    atomic_store_explicit(&rf->active, want, memory_order_relaxed);
+    atomic_store_explicit(&rf->switches,
+                          atomic_load_explicit(&rf->switches, memory_order_relaxed) + 1U,
+                          memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Snapshot (any task)
+ */
+void radio_focus_get(const radio_focus_t *rf, radio_focus_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_RADIO_FOCUS_H */
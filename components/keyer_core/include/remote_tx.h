@@ -0,0 +1,136 @@
+/**
+ * @file remote_tx.h
+ * @brief Tick-exact playout of received keying (monitor and remote TX)
+ *
+ * REMOTE lane events carry the LOCAL tick they play at (sample.h), but
+ * the consumer reads them when they are pushed, which the CWNet task does
+ * a little ahead of time. The hard RT consumer hands each one here; the RT
+ * task then asks for the key level once per tick and gets every edge on
+ * its own tick, so element lengths arrive at the transmitter as the
+ * jitter buffer scheduled them. An event whose tick has already passed
+ * plays at once and is counted late.
+ *
+ * Watchdog: a key held down for watchdog_ticks is released and stays up
+ * until the far end sends key up, so a link lost mid-element (or a
+ * sender stuck down) can not leave the transmitter keyed.
+ *
+ * Writer: RT task only. Readers (console) see relaxed atomics.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Relaxed atomics, no locks, nothing allocated
+ * - RULE 3.1.4: Bounded work per tick (queue depth)
+ */
+
+#ifndef KEYER_REMOTE_TX_H
+#define KEYER_REMOTE_TX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Events waiting for their tick (must be power of 2) */
+#define REMOTE_TX_QUEUE 16U
+
+/**
+ * @brief One queued event
+ */
+typedef struct {
+    uint64_t tick;      /**< Absolute LOCAL tick it plays at */
+    bool key_down;      /**< Key level */
+} remote_tx_event_t;
+
+/**
+ * @brief Remote keying playout state
+ */
+typedef struct {
+    /* RT task only */
+    remote_tx_event_t queue[REMOTE_TX_QUEUE];
+    uint32_t head;              /**< Next slot to fill */
+    uint32_t tail;              /**< Next slot to play */
+    uint32_t watchdog_ticks;    /**< Longest key down (0 = no watchdog) */
+    uint64_t now_tick;          /**< Tick of the last remote_tx_tick() */
+    uint64_t down_tick;         /**< Tick the key went down */
+    uint64_t edge_tick;         /**< Tick of the last edge played */
+    bool key_down;              /**< Level played */
+    bool tripped;               /**< Watchdog released the key, await key up */
+
+    /* Statistics (RT task writes, any task reads) */
+    atomic_uint events;         /**< Events queued */
+    atomic_uint late;           /**< Events played after their tick */
+    atomic_uint late_max_ticks; /**< Largest lateness */
+    atomic_uint lead_min_ticks; /**< Least time an event was queued ahead */
+    atomic_uint overflow;       /**< Events dropped on a full queue */
+    atomic_uint watchdog;       /**< Key-downs released by the watchdog */
+} remote_tx_t;
+
+/**
+ * @brief Snapshot of the statistics
+ */
+typedef struct {
+    uint32_t events;
+    uint32_t late;
+    uint32_t late_max_ticks;
+    uint32_t lead_min_ticks;    /**< UINT32_MAX until an event arrives ahead */
+    uint32_t overflow;
+    uint32_t watchdog;
+    uint32_t watchdog_ticks;
+} remote_tx_stats_t;
+
+/** Global playout state (RT task writes, console reads) */
+extern remote_tx_t g_remote_tx;
+
+/**
+ * @brief Initialize (key up, queue empty, statistics cleared)
+ *
+ * @param rt State
+ * @param watchdog_ticks Longest key down before a forced key up (0 = off)
+ */
+void remote_tx_init(remote_tx_t *rt, uint32_t watchdog_ticks);
+
+/**
+ * @brief Queue a received event (hard RT consumer)
+ *
+ * The 32-bit tick is widened against the tick of the last remote_tx_tick().
+ * On a full queue the backlog is dropped and the key released.
+ *
+ * @param rt State
+ * @param key_down Key level
+ * @param tick32 Low 32 bits of the play tick (sample_event_tick32())
+ */
+void remote_tx_event(remote_tx_t *rt, bool key_down, uint32_t tick32);
+
+/**
+ * @brief Play the events due by now_tick (RT task, every tick)
+ *
+ * @param rt State
+ * @param now_tick Current absolute LOCAL tick
+ * @return Remote key level for this tick
+ */
+bool remote_tx_tick(remote_tx_t *rt, uint64_t now_tick);
+
+/**
+ * @brief Drop queued events and release the key (fault, stop)
+ */
+void remote_tx_release(remote_tx_t *rt);
+
+/**
+ * @brief Nothing queued and the key up
+ */
+static inline bool remote_tx_idle(const remote_tx_t *rt) {
+    return rt->head == rt->tail && !rt->key_down;
+}
+
+/**
+ * @brief Snapshot the statistics (any task)
+ */
+void remote_tx_get(const remote_tx_t *rt, remote_tx_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_REMOTE_TX_H */
@@ -0,0 +1,120 @@
+/**
+ * @file rt_idle.h
+ * @brief RT loop idle tracking for tickless light sleep
+ *
+ * With timing.idle_sleep_s > 0 the RT task stops ticking after that long
+ * with nothing to do: paddles up, no text keyer, no remote CW, TX and PTT
+ * off, sidetone and rig audio silent. It then blocks until a paddle edge
+ * (or the wake timeout) and the chip may enter automatic light sleep.
+ *
+ * The ticks it slept through are handed back as a count, carried to the
+ * microsecond so repeated sleeps never drift the stream timebase, and the
+ * RT task records them as one silence marker (stream_producer_skip).
+ *
+ * Writer: RT task only. Readers (console) see relaxed atomics.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Relaxed atomics, no locks, nothing allocated
+ * - RULE 3.1.4: One compare per tick while awake
+ */
+
+#ifndef KEYER_RT_IDLE_H
+#define KEYER_RT_IDLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Idle tracker
+ */
+typedef struct {
+    /* RT task only */
+    uint32_t threshold_ticks;       /**< Quiet ticks before sleeping (0 = never) */
+    uint32_t quiet_ticks;           /**< Consecutive quiet ticks so far */
+    uint32_t carry_us;              /**< Slept time not yet a whole tick */
+
+    /* Statistics (RT task writes, any task reads) */
+    atomic_uint sleeps;             /**< Sleeps entered */
+    atomic_uint slept_s;            /**< Total time asleep, whole seconds */
+    atomic_uint slept_frac_us;      /**< Remainder of slept_s */
+    atomic_uint last_sleep_ms;      /**< Length of the last sleep */
+    atomic_uint paddle_wakes;       /**< Sleeps ended by a paddle edge */
+    atomic_uint wake_latency_us;    /**< Last edge → RT loop resumed */
+    atomic_uint wake_latency_max_us;/**< Largest of those */
+} rt_idle_t;
+
+/**
+ * @brief Snapshot of the statistics
+ */
+typedef struct {
+    uint32_t threshold_ticks;
+    uint32_t sleeps;
+    uint64_t slept_us;
+    uint32_t last_sleep_ms;
+    uint32_t paddle_wakes;
+    uint32_t wake_latency_us;
+    uint32_t wake_latency_max_us;
+} rt_idle_stats_t;
+
+/** Global tracker (RT task writes, console reads) */
+extern rt_idle_t g_rt_idle;
+
+/**
+ * @brief Clear everything
+ *
+ * @param idle Tracker
+ * @param threshold_ticks Quiet ticks before sleeping (0 = never sleep)
+ */
+void rt_idle_init(rt_idle_t *idle, uint32_t threshold_ticks);
+
+/**
+ * @brief Count one RT tick (RT task, every tick)
+ *
+ * @param idle Tracker
+ * @param quiet Nothing is keying, sounding or pending on this tick
+ * @return true when the loop should sleep now
+ */
+static inline bool rt_idle_tick(rt_idle_t *idle, bool quiet) {
+    if (!quiet || idle->threshold_ticks == 0) {
+        idle->quiet_ticks = 0;
+        return false;
+    }
+    if (idle->quiet_ticks < idle->threshold_ticks) {
+        idle->quiet_ticks++;
+    }
+    return idle->quiet_ticks >= idle->threshold_ticks;
+}
+
+/**
+ * @brief Account a finished sleep (RT task, on resume)
+ *
+ * Converts the slept time into whole ticks, keeping the remainder for the
+ * next sleep, and records statistics. The quiet count is kept: after a
+ * timeout the next quiet tick sleeps again at once, while a press makes
+ * the next tick busy and restarts it.
+ *
+ * @param idle Tracker
+ * @param slept_us Time from entering the sleep to resuming
+ * @param tick_period_us RT tick period
+ * @param edge_us ISR time of the paddle edge that woke us, 0 for a timeout
+ * @param resume_us Time the loop resumed (latency reference)
+ * @return Ticks the loop did not run
+ */
+uint32_t rt_idle_wake(rt_idle_t *idle, int64_t slept_us, uint32_t tick_period_us,
+                      int64_t edge_us, int64_t resume_us);
+
+/**
+ * @brief Snapshot the statistics (any task)
+ */
+void rt_idle_get(const rt_idle_t *idle, rt_idle_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_RT_IDLE_H */
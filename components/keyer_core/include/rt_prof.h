@@ -0,0 +1,158 @@
+/**
+ * @file rt_prof.h
+ * @brief Per-stage cycle-count instrumentation of the RT hot path
+ *
+ * Each RT loop stage (GPIO poll, iambic, stream push, consumer, sidetone,
+ * audio write) records its CPU cycle delta into min/max/mean and a log2
+ * histogram. Readers on Core 1 (console, web UI) take snapshots.
+ *
+ * Enabled by CONFIG_KEYER_RT_PROFILE (Kconfig, default on). When disabled
+ * the RT_PROF_* macros compile to nothing; the accumulator functions stay
+ * available so they can be tested on host.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Single writer (RT task), relaxed atomics only, no locks
+ * - RULE 3.1.4: Recording never blocks; resets are applied by the writer
+ */
+
+#ifndef KEYER_RT_PROF_H
+#define KEYER_RT_PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Histogram bins: bin k counts deltas in [2^(k-1), 2^k) cycles, last bin open */
+#define RT_PROF_HIST_BINS 24
+
+/**
+ * @brief Instrumented RT loop stages
+ */
+typedef enum {
+    RT_PROF_STAGE_GPIO = 0,     /**< Paddle poll + ISR edge handoff */
+    RT_PROF_STAGE_IAMBIC,       /**< iambic_tick_edges */
+    RT_PROF_STAGE_STREAM_PUSH,  /**< stream_push */
+    RT_PROF_STAGE_CONSUMER,     /**< hard_rt_consumer_tick + TX update */
+    RT_PROF_STAGE_SIDETONE,     /**< Sidetone sample rendering */
+    RT_PROF_STAGE_AUDIO_WRITE,  /**< hal_audio_write */
+    RT_PROF_STAGE_TOTAL,        /**< Whole loop body (excluding tick wait) */
+    RT_PROF_STAGE_COUNT
+} rt_prof_stage_t;
+
+/**
+ * @brief Accumulators for one stage (written by RT task only)
+ */
+typedef struct {
+    atomic_uint count;                      /**< Samples in sum */
+    atomic_uint sum;                        /**< Sum of deltas (halved with count on overflow) */
+    atomic_uint min;                        /**< Smallest delta */
+    atomic_uint max;                        /**< Largest delta */
+    atomic_uint hist[RT_PROF_HIST_BINS];    /**< log2 histogram */
+} rt_prof_stage_stats_t;
+
+/**
+ * @brief Profiler for one core
+ */
+typedef struct {
+    rt_prof_stage_stats_t stage[RT_PROF_STAGE_COUNT];
+    atomic_bool reset_requested;            /**< Set by readers, applied by writer */
+} rt_prof_t;
+
+/**
+ * @brief Snapshot of one stage
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint32_t mean_cycles;
+    uint32_t hist[RT_PROF_HIST_BINS];
+} rt_prof_snapshot_t;
+
+/** Global RT task profiler (Core 0) */
+extern rt_prof_t g_rt_prof;
+
+/**
+ * @brief Initialize profiler (clear all stages)
+ */
+void rt_prof_init(rt_prof_t *prof);
+
+/**
+ * @brief Record one cycle delta (writer only)
+ *
+ * @param prof Profiler
+ * @param stage Stage the delta belongs to
+ * @param cycles Cycle delta
+ */
+void rt_prof_record(rt_prof_t *prof, rt_prof_stage_t stage, uint32_t cycles);
+
+/**
+ * @brief Request a reset (any core, applied on the writer's next record)
+ */
+void rt_prof_reset(rt_prof_t *prof);
+
+/**
+ * @brief Snapshot one stage (any core)
+ *
+ * Fields are read individually, so a snapshot taken mid-update may mix
+ * two consecutive samples. Good enough for diagnostics.
+ */
+void rt_prof_get(rt_prof_t *prof, rt_prof_stage_t stage, rt_prof_snapshot_t *out);
+
+/**
+ * @brief Get stage name ("gpio", "iambic", ...)
+ */
+const char *rt_prof_stage_str(rt_prof_stage_t stage);
+
+/**
+ * @brief Histogram bin for a cycle delta
+ */
+static inline uint32_t rt_prof_hist_bin(uint32_t cycles) {
+    uint32_t bin = 0;
+    while (cycles != 0 && bin < RT_PROF_HIST_BINS - 1) {
+        cycles >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+/* ============================================================================
+ * Instrumentation Macros
+ * ============================================================================ */
+
+#if defined(CONFIG_KEYER_RT_PROFILE) && defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+
+/** Declare and start a lap timer */
+#define RT_PROF_START(t)  uint32_t t = (uint32_t)esp_cpu_get_cycle_count()
+
+/** Record cycles since t for stage and restart t */
+#define RT_PROF_LAP(stage, t) do { \
+    uint32_t rt_prof_now_ = (uint32_t)esp_cpu_get_cycle_count(); \
+    rt_prof_record(&g_rt_prof, (stage), rt_prof_now_ - (t)); \
+    (t) = rt_prof_now_; \
+} while (0)
+
+/** Record cycles since t for stage without restarting t */
+#define RT_PROF_SINCE(stage, t) \
+    rt_prof_record(&g_rt_prof, (stage), (uint32_t)esp_cpu_get_cycle_count() - (t))
+
+#else
+#define RT_PROF_START(t)        do { } while (0)
+#define RT_PROF_LAP(stage, t)   do { } while (0)
+#define RT_PROF_SINCE(stage, t) do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_RT_PROF_H */
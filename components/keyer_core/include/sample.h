@@ -2,11 +2,13 @@
  * @file sample.h
  * @brief Stream sample type - the fundamental keying event unit
  *
- * Each sample is 6 bytes packed, containing GPIO state, keying output,
- * audio level, flags, and config generation.
+ * Each sample is 6 bytes packed, containing the input channels, keying
+ * output, audio level, flags, and config generation. History archives can
+ * store it as a 16-bit compact record instead (stream_compact_t).
  *
  * ARCHITECTURE.md compliance:
  * - RULE 1.1.1: All keying events flow through KeyingStream
+ * - RULE 1.2.1: GPIO, local and remote channels in every sample
  * - RULE 3.1.1: Only atomic operations for synchronization
  */
 
@@ -21,18 +23,47 @@ extern "C" {
 #endif
 
 /* ============================================================================
- * GPIO State
+ * GPIO State / Channel Bits
  * ============================================================================ */
 
 /**
- * @brief GPIO paddle state (1 byte)
+ * Sample layout version (recorded in .cwk headers).
+ *
+ * 1: gpio held the paddle only (bits 0-1).
+ * 2: gpio is the channel byte below; the new bits read 0 from version 1.
+ */
+#define SAMPLE_LAYOUT_VERSION 2
+
+/**
+ * @brief GPIO input state / sample channel byte (1 byte)
+ *
+ * - bits 0-1: primary paddle dit/dah
+ * - bit 2:    straight key input
+ * - bits 3-4: secondary paddle dit/dah
+ * - bit 5:    remote key channel (LOCAL samples: the received keying as
+ *             played, see remote_tx.h)
+ * - bits 6-7: zero
+ *
+ * Silence markers and REMOTE events reuse the byte for tick bits.
  */
 typedef struct {
     uint8_t bits;
 } gpio_state_t;
 
-#define GPIO_DIT_BIT  0x01
-#define GPIO_DAH_BIT  0x02
+#define GPIO_DIT_BIT       0x01
+#define GPIO_DAH_BIT       0x02
+#define GPIO_STRAIGHT_BIT  0x04
+#define GPIO_DIT2_BIT      0x08
+#define GPIO_DAH2_BIT      0x10
+
+/** Remote key channel (not a physical input) */
+#define SAMPLE_CH_REMOTE   0x20
+
+/** Primary paddle */
+#define GPIO_PADDLE_MASK   (GPIO_DIT_BIT | GPIO_DAH_BIT)
+
+/** Every physical input (edges flagged FLAG_GPIO_EDGE) */
+#define GPIO_INPUT_MASK    (GPIO_PADDLE_MASK | GPIO_STRAIGHT_BIT | GPIO_DIT2_BIT | GPIO_DAH2_BIT)
 
 /** Idle state - no paddles pressed */
 #define GPIO_IDLE     ((gpio_state_t){.bits = 0})
@@ -50,9 +81,24 @@ static inline bool gpio_dah(gpio_state_t gs) {
     return (gs.bits & GPIO_DAH_BIT) != 0;
 }
 
-/** Check if no paddles pressed */
+/** Check if the straight key is closed */
+static inline bool gpio_straight(gpio_state_t gs) {
+    return (gs.bits & GPIO_STRAIGHT_BIT) != 0;
+}
+
+/** Check if the secondary paddle's DIT is pressed */
+static inline bool gpio_dit2(gpio_state_t gs) {
+    return (gs.bits & GPIO_DIT2_BIT) != 0;
+}
+
+/** Check if the secondary paddle's DAH is pressed */
+static inline bool gpio_dah2(gpio_state_t gs) {
+    return (gs.bits & GPIO_DAH2_BIT) != 0;
+}
+
+/** Check if no input is active (the remote channel does not count) */
 static inline bool gpio_is_idle(gpio_state_t gs) {
-    return gs.bits == 0;
+    return (gs.bits & GPIO_INPUT_MASK) == 0;
 }
 
 /** Check if both paddles pressed */
@@ -72,7 +118,7 @@ static inline gpio_state_t gpio_from_paddles(bool dit, bool dah) {
  * Sample Flags
  * ============================================================================ */
 
-/** GPIO state changed from previous sample */
+/** A physical input (GPIO_INPUT_MASK) changed from previous sample */
 #define FLAG_GPIO_EDGE      0x01
 
 /** Configuration changed */
@@ -81,8 +127,8 @@ static inline gpio_state_t gpio_from_paddles(bool dit, bool dah) {
 /** TX transmission started */
 #define FLAG_TX_START       0x04
 
-/** Remote CW reception started */
-#define FLAG_RX_START       0x08
+/** Remote key channel edge (SAMPLE_CH_REMOTE changed) */
+#define FLAG_REMOTE_EDGE    0x08
 
 /** Silence marker (RLE compression) */
 #define FLAG_SILENCE        0x10
@@ -90,6 +136,28 @@ static inline gpio_state_t gpio_from_paddles(bool dit, bool dah) {
 /** Local key state edge (on/off transition) */
 #define FLAG_LOCAL_EDGE     0x20
 
+/** Producer lane ID (bits 7-6), see stream_lane_t */
+#define FLAG_LANE_SHIFT     6
+#define FLAG_LANE_MASK      0xC0
+
+/* ============================================================================
+ * Producer Lanes
+ * ============================================================================ */
+
+/**
+ * @brief Producer lane carried in sample flags
+ *
+ * Each producer writes with its own lane ID and silence compression state.
+ * LOCAL is the RT tick producer and defines the stream timebase.
+ */
+typedef enum {
+    STREAM_LANE_LOCAL = 0,   /**< Paddles / iambic (RT task, Core 0) */
+    STREAM_LANE_TEXT = 1,    /**< Text keyer */
+    STREAM_LANE_REMOTE = 2,  /**< Remote CW (CWNet) */
+    STREAM_LANE_AUX = 3,     /**< Spare */
+    STREAM_LANE_COUNT = 4
+} stream_lane_t;
+
 /* ============================================================================
  * Stream Sample (6 bytes packed)
  * ============================================================================ */
@@ -97,15 +165,21 @@ static inline gpio_state_t gpio_from_paddles(bool dit, bool dah) {
 /**
  * @brief Stream sample - the fundamental keying event unit
  *
- * Layout (6 bytes total):
- * - gpio:       1 byte - Physical paddle state
+ * Layout (6 bytes total, SAMPLE_LAYOUT_VERSION):
+ * - gpio:       1 byte - Input and remote channel bits (gpio_state_t)
  * - local_key:  1 byte - Iambic keyer output (bool as u8)
- * - audio_level:1 byte - Audio output level (0-255)
+ * - audio_level:1 byte - Audio output level (0-255); key tag on LOCAL
+ *                       key-down samples from the iambic FSM
  * - flags:      1 byte - Edge flags and markers
  * - config_gen: 2 bytes - Config generation / silence ticks
+ *
+ * Silence markers (FLAG_SILENCE) carry a 32-bit tick count: bits 0-15 in
+ * config_gen, bits 16-23 in audio_level, bits 24-31 in gpio. local_key is
+ * always 0. Idle runs longer than SAMPLE_SILENCE_MAX_TICKS are chained as
+ * consecutive markers whose counts add up.
  */
 typedef struct __attribute__((packed)) {
-    gpio_state_t gpio;       /**< Physical paddle state */
+    gpio_state_t gpio;       /**< Input channels + remote channel */
     uint8_t      local_key;  /**< Keyer output: 1=key down, 0=key up */
     uint8_t      audio_level;/**< Audio output level (0-255) */
     uint8_t      flags;      /**< Edge flags and markers */
@@ -121,6 +195,28 @@ typedef struct __attribute__((packed)) {
     .config_gen = 0 \
 })
 
+/* ============================================================================
+ * Key Tags
+ * ============================================================================ */
+
+/*
+ * The iambic FSM knows which element it keys; it tags its LOCAL key-down
+ * samples so decoders need not re-derive that from durations. No producer
+ * fills audio_level, so the tag lives there; it is constant for a whole
+ * element, so silence compression and edge detection are unaffected.
+ * Key-up samples, text keyer and straight key samples are untagged (0).
+ * Compact archive records do not keep tags.
+ */
+
+/** Element type below is exact (set by the iambic FSM) */
+#define KEY_TAG_ELEMENT     0x01
+
+/** Element is a dah (otherwise a dit), with KEY_TAG_ELEMENT */
+#define KEY_TAG_DAH         0x02
+
+/** The space before this element was the FSM's inter-element gap */
+#define KEY_TAG_IN_CHAR     0x04
+
 /* ============================================================================
  * Sample Helper Functions
  * ============================================================================ */
@@ -130,17 +226,81 @@ static inline bool sample_is_silence(const stream_sample_t *s) {
     return (s->flags & FLAG_SILENCE) != 0;
 }
 
+/** Largest tick count one silence marker can carry */
+#define SAMPLE_SILENCE_MAX_TICKS UINT32_MAX
+
 /** Create a silence marker with the given tick count */
 static inline stream_sample_t sample_silence(uint32_t ticks) {
     stream_sample_t s = STREAM_SAMPLE_EMPTY;
     s.flags = FLAG_SILENCE;
-    s.config_gen = (uint16_t)(ticks > UINT16_MAX ? UINT16_MAX : ticks);
+    s.config_gen = (uint16_t)(ticks & 0xFFFFU);
+    s.audio_level = (uint8_t)(ticks >> 16);
+    s.gpio.bits = (uint8_t)(ticks >> 24);
     return s;
 }
 
 /** Get silence tick count from a silence marker */
 static inline uint32_t sample_silence_ticks(const stream_sample_t *s) {
-    return s->config_gen;
+    return (uint32_t)s->config_gen |
+           ((uint32_t)s->audio_level << 16) |
+           ((uint32_t)s->gpio.bits << 24);
+}
+
+/** Get producer lane of a sample */
+static inline stream_lane_t sample_lane(const stream_sample_t *s) {
+    return (stream_lane_t)((s->flags & FLAG_LANE_MASK) >> FLAG_LANE_SHIFT);
+}
+
+/** Tag sample with a producer lane */
+static inline stream_sample_t sample_with_lane(stream_sample_t s, stream_lane_t lane) {
+    s.flags = (uint8_t)((s.flags & (uint8_t)~FLAG_LANE_MASK) |
+                        (((uint8_t)lane << FLAG_LANE_SHIFT) & FLAG_LANE_MASK));
+    return s;
+}
+
+/**
+ * @brief Build a REMOTE lane key event
+ *
+ * REMOTE samples are pushed only on key changes, so their stream position
+ * says little about when they happen (LOCAL silence may still be pending).
+ * They carry the low 32 bits of the absolute LOCAL tick they play at in the
+ * payload bytes, packed like a silence count; local_key is the far station's
+ * key level. Resolve the tick with sample_resolve_tick().
+ */
+static inline stream_sample_t sample_remote_event(bool key_down, uint64_t tick) {
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    s.local_key = key_down ? 1U : 0U;
+    s.config_gen = (uint16_t)(tick & 0xFFFFU);
+    s.audio_level = (uint8_t)(tick >> 16);
+    s.gpio.bits = (uint8_t)(tick >> 24);
+    return sample_with_lane(s, STREAM_LANE_REMOTE);
+}
+
+/** Low 32 bits of the tick a REMOTE event plays at */
+static inline uint32_t sample_event_tick32(const stream_sample_t *s) {
+    return sample_silence_ticks(s);
+}
+
+/**
+ * @brief Widen a 32-bit event tick to the absolute tick nearest ref_tick
+ *
+ * @param ref_tick Any absolute LOCAL tick within +/-2^31 ticks of the event
+ * @param tick32 Value from sample_event_tick32()
+ */
+static inline uint64_t sample_resolve_tick(uint64_t ref_tick, uint32_t tick32) {
+    int32_t delta = (int32_t)(tick32 - (uint32_t)ref_tick);
+    return (uint64_t)((int64_t)ref_tick + delta);
+}
+
+/** Key tag of a LOCAL sample (0 = untagged or key up) */
+static inline uint8_t sample_key_tag(const stream_sample_t *s) {
+    return (s->local_key != 0 && !sample_is_silence(s)) ? s->audio_level : 0U;
+}
+
+/** Tag a key-down sample (KEY_TAG_* bits) */
+static inline stream_sample_t sample_with_key_tag(stream_sample_t s, uint8_t tag) {
+    s.audio_level = tag;
+    return s;
 }
 
 /** Check if sample has a GPIO edge flag */
@@ -153,10 +313,24 @@ static inline bool sample_has_local_edge(const stream_sample_t *s) {
     return (s->flags & FLAG_LOCAL_EDGE) != 0;
 }
 
+/** Remote key channel of a LOCAL sample */
+static inline bool sample_remote_channel(const stream_sample_t *s) {
+    return (s->gpio.bits & SAMPLE_CH_REMOTE) != 0;
+}
+
+/** Set the remote key channel of a LOCAL sample */
+static inline stream_sample_t sample_with_remote_channel(stream_sample_t s, bool key_down) {
+    s.gpio.bits = (uint8_t)(key_down ? (s.gpio.bits | SAMPLE_CH_REMOTE)
+                                     : (s.gpio.bits & (uint8_t)~SAMPLE_CH_REMOTE));
+    return s;
+}
+
 /**
  * @brief Check if sample has changed from another
  *
  * Used for silence compression - if no change, increment idle counter.
+ * Every channel is one byte compare: the channel byte holds all inputs
+ * and the remote key, so more channels cost nothing per push.
  */
 static inline bool sample_has_change_from(const stream_sample_t *a,
                                           const stream_sample_t *b) {
@@ -165,9 +339,153 @@ static inline bool sample_has_change_from(const stream_sample_t *a,
            a->audio_level != b->audio_level;
 }
 
+/* ============================================================================
+ * Compact Sample (16 bits, history archive)
+ * ============================================================================ */
+
+/**
+ * @brief 16-bit archive record of one stream sample
+ *
+ * Used by compact history archives (stream_attach_compact_archive()), two
+ * records per aligned 32-bit word, four times the depth of full slots in
+ * the same PSRAM. One record per sample, so stream indices still map 1:1.
+ *
+ * Layout (bit 15 clear, key sample):
+ * - bits 0-1:   gpio dit/dah
+ * - bit 2:      local_key
+ * - bits 3-7:   FLAG_GPIO_EDGE, FLAG_CONFIG_CHANGE, FLAG_TX_START, FLAG_REMOTE_EDGE,
+ *               FLAG_LOCAL_EDGE
+ * - bits 8-12:  audio_level >> 3
+ * - bits 13-14: producer lane
+ *
+ * REMOTE lane events keep local_key in bit 0 and the low 12 bits of their
+ * play tick in bits 1-12. Silence markers (bit 15 set) keep the lane in bits
+ * 13-14 and the tick count in bits 0-11, scaled by 2^10 when bit 12 is set.
+ *
+ * Lossy: config_gen is dropped, only the primary paddle of the channel
+ * byte is kept (the remote edge flag survives), audio_level keeps 5 bits, silences of 4096
+ * ticks or more round to 1024 ticks (saturating near 4.2M), and REMOTE
+ * ticks resolve only within +/-2048 ticks of the reader's running LOCAL
+ * tick (sample_compact_decode_at()).
+ */
+typedef uint16_t stream_compact_t;
+
+#define COMPACT_SILENCE          0x8000U
+#define COMPACT_LANE_SHIFT       13
+#define COMPACT_FLAGS_SHIFT      3
+#define COMPACT_LEVEL_SHIFT      8
+#define COMPACT_KEY              0x0004U
+#define COMPACT_SCALED           0x1000U
+#define COMPACT_COUNT_MASK       0x0FFFU
+#define COMPACT_SCALE_SHIFT      10
+#define COMPACT_REMOTE_TICK_MASK 0x0FFFU
+
+/** Compact-encode one sample */
+static inline stream_compact_t sample_compact_encode(const stream_sample_t *s) {
+    uint32_t lane = (uint32_t)sample_lane(s) << COMPACT_LANE_SHIFT;
+
+    if (sample_is_silence(s)) {
+        uint32_t ticks = sample_silence_ticks(s);
+        if (ticks <= COMPACT_COUNT_MASK) {
+            return (stream_compact_t)(COMPACT_SILENCE | lane | ticks);
+        }
+        uint32_t scaled = (ticks + (1U << (COMPACT_SCALE_SHIFT - 1))) >> COMPACT_SCALE_SHIFT;
+        if (scaled > COMPACT_COUNT_MASK || scaled < (ticks >> COMPACT_SCALE_SHIFT)) {
+            scaled = COMPACT_COUNT_MASK;
+        }
+        return (stream_compact_t)(COMPACT_SILENCE | COMPACT_SCALED | lane | scaled);
+    }
+
+    if (sample_lane(s) == STREAM_LANE_REMOTE) {
+        uint32_t tick = sample_event_tick32(s) & COMPACT_REMOTE_TICK_MASK;
+        return (stream_compact_t)(lane | (tick << 1) | (s->local_key ? 1U : 0U));
+    }
+
+    uint32_t flags = (s->flags & (FLAG_GPIO_EDGE | FLAG_CONFIG_CHANGE | FLAG_TX_START |
+                                  FLAG_REMOTE_EDGE)) |
+                     ((s->flags & FLAG_LOCAL_EDGE) ? FLAG_SILENCE : 0U);
+    return (stream_compact_t)(lane |
+                              ((uint32_t)(s->audio_level >> 3) << COMPACT_LEVEL_SHIFT) |
+                              (flags << COMPACT_FLAGS_SHIFT) |
+                              (s->local_key ? COMPACT_KEY : 0U) |
+                              (s->gpio.bits & GPIO_PADDLE_MASK));
+}
+
+/**
+ * @brief Widen a 12-bit compact REMOTE tick to the absolute tick nearest ref_tick
+ *
+ * @param ref_tick Absolute LOCAL tick within +/-2048 ticks of the event
+ * @param tick12 Low 12 bits of the event tick
+ */
+static inline uint64_t sample_compact_resolve_tick(uint64_t ref_tick, uint32_t tick12) {
+    uint32_t ahead = (tick12 - (uint32_t)ref_tick) & COMPACT_REMOTE_TICK_MASK;
+    uint32_t span = COMPACT_REMOTE_TICK_MASK + 1U;
+    if (ahead >= span / 2U && ref_tick >= span - ahead) {
+        return ref_tick - (span - ahead);
+    }
+    return ref_tick + ahead;
+}
+
+/**
+ * @brief Expand a compact record back to a stream sample
+ *
+ * REMOTE events come back with only the low 12 bits of their play tick;
+ * readers that know the LOCAL tick use sample_compact_decode_at().
+ */
+static inline stream_sample_t sample_compact_decode(stream_compact_t c) {
+    stream_lane_t lane = (stream_lane_t)((c >> COMPACT_LANE_SHIFT) & 0x3U);
+
+    if (c & COMPACT_SILENCE) {
+        uint32_t ticks = c & COMPACT_COUNT_MASK;
+        if (c & COMPACT_SCALED) {
+            ticks <<= COMPACT_SCALE_SHIFT;
+        }
+        return sample_with_lane(sample_silence(ticks), lane);
+    }
+
+    if (lane == STREAM_LANE_REMOTE) {
+        return sample_remote_event((c & 1U) != 0,
+                                   (uint64_t)((c >> 1) & COMPACT_REMOTE_TICK_MASK));
+    }
+
+    /* FLAG_SILENCE's position carries FLAG_LOCAL_EDGE (bit 5 does not fit) */
+    uint32_t packed = (c >> COMPACT_FLAGS_SHIFT) & 0x1FU;
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    s.gpio.bits = (uint8_t)(c & GPIO_PADDLE_MASK);
+    s.local_key = (c & COMPACT_KEY) ? 1U : 0U;
+    uint32_t level = (c >> COMPACT_LEVEL_SHIFT) & 0x1FU;
+    s.audio_level = (uint8_t)((level << 3) | (level >> 2));
+    s.flags = (uint8_t)((packed & (uint32_t)~FLAG_SILENCE) |
+                        ((packed & FLAG_SILENCE) ? FLAG_LOCAL_EDGE : 0U));
+    return sample_with_lane(s, lane);
+}
+
+/**
+ * @brief Expand a compact record, unwrapping a REMOTE play tick
+ *
+ * A REMOTE event is archived near the LOCAL tick it plays at, so its 12
+ * tick bits are put back at the absolute tick nearest the reader's running
+ * LOCAL tick. Other records decode as with sample_compact_decode().
+ *
+ * @param c Compact record
+ * @param ref_tick Absolute LOCAL tick at which the record's stream position starts
+ */
+static inline stream_sample_t sample_compact_decode_at(stream_compact_t c, uint64_t ref_tick) {
+    if ((c & COMPACT_SILENCE) == 0U &&
+        ((c >> COMPACT_LANE_SHIFT) & 0x3U) == (uint32_t)STREAM_LANE_REMOTE) {
+        return sample_remote_event((c & 1U) != 0,
+                                   sample_compact_resolve_tick(ref_tick,
+                                                               (c >> 1) & COMPACT_REMOTE_TICK_MASK));
+    }
+    return sample_compact_decode(c);
+}
+
 /**
  * @brief Create sample with edge flags computed from previous sample
  *
+ * FLAG_GPIO_EDGE for any input bit, FLAG_REMOTE_EDGE for the remote
+ * channel, FLAG_LOCAL_EDGE for the keyer output.
+ *
  * @param current Current sample state
  * @param previous Previous sample for edge detection
  * @return Sample with edge flags set
@@ -0,0 +1,163 @@
+/**
+ * @file service.h
+ * @brief Core 1 background services: descriptors and CPU accounting
+ *
+ * Background work runs as a few services, each a periodic function with
+ * its own task, period, priority and stack, so slow work (JSON pushes, LED
+ * transmits) in one cannot delay another. Services talk to each other only
+ * through the lock-free streams and rings they already share, never by
+ * calling into each other.
+ *
+ * A service polls either at a fixed period or adaptively: with a
+ * min_period_ms it polls that fast while its passes find work (stream lag,
+ * new edges) and for hold_ms after the last one, then doubles its sleep up
+ * to period_ms during silence. Work is still found by polling; the stream
+ * producer never notifies anyone (RULE 2.1.3).
+ *
+ * The table records every service and the time spent in its passes:
+ * total busy time, the longest pass and the passes that overran their
+ * period. Pass time is wall time and includes preemption by the tasks above
+ * it; each service also shows up as its own task in the FreeRTOS run-time
+ * stats ("stats tasks"). main/bg_task.c owns the tasks; the console reads
+ * the table ("stats svc").
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: No locks; each service is the only writer of its counters
+ * - RULE 3.1.4: Recording never blocks
+ */
+
+#ifndef KEYER_SERVICE_H
+#define KEYER_SERVICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Services a table holds */
+#define SERVICE_MAX 8U
+
+/**
+ * @brief Service init, called with the current time
+ */
+typedef void (*service_init_fn_t)(int64_t now_us);
+
+/**
+ * @brief Service pass, called with the current time
+ *
+ * @return true if the pass found work (adaptive services poll fast)
+ */
+typedef bool (*service_fn_t)(int64_t now_us);
+
+/**
+ * @brief Service descriptor (static)
+ */
+typedef struct {
+    const char *name;        /**< Task name */
+    service_init_fn_t init;  /**< Once, in the service task before its first pass (may be NULL) */
+    service_fn_t run;        /**< One pass */
+    uint32_t period_ms;      /**< Pass period (adaptive: longest sleep) */
+    uint32_t min_period_ms;  /**< Adaptive: sleep while busy (0 = fixed period) */
+    uint32_t hold_ms;        /**< Adaptive: stay fast this long after work */
+    uint8_t priority;        /**< Task priority */
+    uint32_t stack_bytes;    /**< Task stack */
+} service_desc_t;
+
+/**
+ * @brief Registered service
+ */
+typedef struct {
+    _Atomic(const service_desc_t *) desc;  /**< NULL until published */
+    atomic_uint runs;        /**< Passes */
+    atomic_uint busy_ms;     /**< Time in passes (wraps after 49 days) */
+    atomic_uint max_us;      /**< Longest pass */
+    atomic_uint last_us;     /**< Most recent pass */
+    atomic_uint overruns;    /**< Passes longer than the period */
+    atomic_uint delay_ms;    /**< Sleep chosen after the last pass */
+    uint32_t rem_us;         /**< Busy time not yet in busy_ms (writer only) */
+    int64_t last_work_us;    /**< Last pass that found work (writer only) */
+} service_t;
+
+/**
+ * @brief Service table
+ */
+typedef struct {
+    atomic_uint count;                  /**< Slots claimed (may exceed MAX) */
+    service_t slots[SERVICE_MAX];
+} service_table_t;
+
+/**
+ * @brief Service snapshot
+ */
+typedef struct {
+    const char *name;
+    uint32_t period_ms;
+    uint32_t min_period_ms;
+    uint8_t priority;
+    uint32_t delay_ms;
+    uint32_t runs;
+    uint32_t busy_ms;
+    uint32_t max_us;
+    uint32_t last_us;
+    uint32_t overruns;
+} service_info_t;
+
+/** Global service table (main/bg_task.c) */
+extern service_table_t g_services;
+
+/**
+ * @brief Clear the table (once, before any service registers)
+ */
+void service_table_init(service_table_t *t);
+
+/**
+ * @brief Add a service
+ *
+ * @param t Table
+ * @param desc Descriptor (must outlive the table)
+ * @return The service's slot, NULL if the table is full
+ */
+service_t *service_register(service_table_t *t, const service_desc_t *desc);
+
+/**
+ * @brief Account one pass (the service's own task only)
+ *
+ * @param svc Service
+ * @param start_us When the pass began
+ * @param end_us When it returned
+ */
+void service_record(service_t *svc, int64_t start_us, int64_t end_us);
+
+/**
+ * @brief Choose the sleep before the next pass (the service's own task only)
+ *
+ * Fixed services always get period_ms. Adaptive ones get min_period_ms
+ * while busy or within hold_ms of the last busy pass, then twice the
+ * previous sleep, up to period_ms.
+ *
+ * @param svc Service
+ * @param now_us When the pass returned
+ * @param busy The pass found work
+ * @return Sleep in ms
+ */
+uint32_t service_next_delay_ms(service_t *svc, int64_t now_us, bool busy);
+
+/**
+ * @brief Copy the registered services in registration order (any task)
+ *
+ * @param t Table
+ * @param out Destination
+ * @param max Capacity of out (SERVICE_MAX for everything)
+ * @return Services written
+ */
+size_t service_snapshot(const service_table_t *t, service_info_t *out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_SERVICE_H */
@@ -0,0 +1,136 @@
+/**
+ * @file stats_watch.h
+ * @brief Live stats sampling for the console ("stats watch")
+ *
+ * A sampler (keyer_console, console_watch.c) reads a handful of counters
+ * at a fixed interval and pushes them here; about once a second it asks
+ * for one compact line covering the samples since the previous line:
+ * running counters as deltas, levels as last [min-max], and peaks as the
+ * largest value any sample saw. A lag or latency spike that lasts one
+ * sample shows in the line even though nothing is printed for that sample.
+ *
+ * Peaks come from log2 histograms (rt_prof, cwnet latency): the bins that
+ * grew between two samples bound the worst value of that interval, so the
+ * cumulative maxima the one-shot stats print are not needed.
+ *
+ * Pure logic, single writer (the sampler task), no locks.
+ */
+
+#ifndef KEYER_STATS_WATCH_H
+#define KEYER_STATS_WATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Samples held between lines (older ones only lose their min/max) */
+#define STATS_WATCH_RING 32U
+
+/**
+ * @brief Counter groups a line can show
+ */
+typedef enum {
+    STATS_WATCH_RT = 0,     /**< RT loop body peak, missed ticks */
+    STATS_WATCH_LAG,        /**< Worst stream consumer lag, consumer drops */
+    STATS_WATCH_CWNET,      /**< Edges sent, edge-to-send latency peak */
+    STATS_WATCH_VPN,        /**< Tunnel packets sealed / opened */
+    STATS_WATCH_HEAP,       /**< Free heap */
+    STATS_WATCH_GROUP_COUNT
+} stats_watch_group_t;
+
+/** Every group */
+#define STATS_WATCH_ALL ((1U << STATS_WATCH_GROUP_COUNT) - 1U)
+
+/**
+ * @brief One sample
+ *
+ * "Running" fields are counters since boot; "peak" fields cover the time
+ * since the previous sample.
+ */
+typedef struct {
+    int64_t time_us;
+    uint32_t rt_peak_us;    /**< Longest RT loop body (log2 bound, 0 = none) */
+    uint32_t rt_missed;     /**< Missed ticks (running) */
+    uint32_t lag;           /**< Worst consumer lag now, samples */
+    uint32_t lag_dropped;   /**< Samples consumers lost (running) */
+    uint32_t cwnet_edges;   /**< Edges sent (running) */
+    uint32_t cwnet_peak_us; /**< Slowest edge to send (log2 bound, 0 = none) */
+    uint32_t vpn_tx;        /**< Packets sealed (running) */
+    uint32_t vpn_rx;        /**< Packets opened (running) */
+    uint32_t heap_free;     /**< Free heap now, bytes */
+} stats_watch_sample_t;
+
+/**
+ * @brief Sample ring and line state
+ */
+typedef struct {
+    stats_watch_sample_t ring[STATS_WATCH_RING];
+    uint32_t head;                  /**< Samples pushed */
+    uint32_t printed;               /**< head at the last line */
+    stats_watch_sample_t base;      /**< Newest sample of the last line */
+    bool have_base;
+    unsigned groups;                /**< STATS_WATCH_* bits shown */
+} stats_watch_t;
+
+/**
+ * @brief Start a watch
+ *
+ * @param w Watch
+ * @param groups Bit per stats_watch_group_t (0: all)
+ */
+void stats_watch_init(stats_watch_t *w, unsigned groups);
+
+/**
+ * @brief Add a sample
+ *
+ * The first one only sets the base the first deltas count from.
+ */
+void stats_watch_push(stats_watch_t *w, const stats_watch_sample_t *s);
+
+/**
+ * @brief Format the samples since the previous line
+ *
+ * e.g. "61.0s rt 128us miss +0 | lag 2 [0-37] drop +0 | heap 181220 [180904-181220]"
+ *
+ * @param w Watch
+ * @param buf Output (NUL-terminated, ends in CR LF)
+ * @param cap Size of buf
+ * @return Length written, 0 if there is no new sample
+ */
+size_t stats_watch_line(stats_watch_t *w, char *buf, size_t cap);
+
+/**
+ * @brief Bound of the largest value added to a log2 histogram
+ *
+ * Bin k holds values below 2^k.
+ *
+ * @param now Bins now
+ * @param prev Bins at the previous sample (updated to now)
+ * @param bins Bin count (at most 32)
+ * @return 2^k of the highest bin that grew, 0 if none did
+ */
+uint32_t stats_watch_hist_peak(const uint32_t *now, uint32_t *prev, size_t bins);
+
+/**
+ * @brief Parse a group list: "rt,lag,heap" or "all"
+ *
+ * @param list Comma-separated names
+ * @param groups Bits (valid if true returned)
+ * @return false on an unknown name
+ */
+bool stats_watch_parse_groups(const char *list, unsigned *groups);
+
+/**
+ * @brief Group name ("rt", "lag", "cwnet", "vpn", "heap")
+ */
+const char *stats_watch_group_str(stats_watch_group_t g);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_STATS_WATCH_H */
@@ -1,6 +1,6 @@
 /**
  * @file stream.h
- * @brief Lock-free SPMC (Single Producer, Multiple Consumer) stream buffer
+ * @brief Lock-free MPMC stream buffer (producer lanes, multiple consumers)
  *
  * This is the heart of keyer_c. All keying events flow through here.
  *
@@ -9,12 +9,42 @@
  *                     (lock-free)         (StreamConsumer)
  *                     (single truth)
  *
+ * Producers:
+ *   The RT task pushes on the built-in LOCAL lane with stream_push().
+ *   Other producers (text keyer, remote CW) own a stream_producer_t with
+ *   their own lane ID and silence compression state. Slots are claimed with
+ *   write_idx.fetch_add() and published by a per-slot commit tag, so a
+ *   consumer never reads a slot whose writer has not finished.
+ *   On the target every producer runs in the RT task: Core 1 sources
+ *   (CWNet, ESP-NOW) hand their samples over (stream_handoff.h) rather
+ *   than claim slots the hard-RT consumer would wait on.
+ *
+ *   Silence markers carry ticks of their own lane. Only the LOCAL lane
+ *   pushes once per tick and defines the stream timebase.
+ *
+ * Storage tiers:
+ *   The ring itself is the hot tier: small, in internal SRAM, serving the
+ *   producers and the hard-RT consumer. An optional archive (PSRAM, sized
+ *   at boot) holds older slots: a background spill stage copies committed
+ *   hot slots into it under their absolute index, so a consumer positioned
+ *   with consumer_init_at() / consumer_resync() reads history from either
+ *   tier without knowing which.
+ *
+ * Positions:
+ *   write_idx and consumer read_idx are size_t, which is 32 bits on the
+ *   ESP32 and wraps within a day at 50 kHz. Ring arithmetic only ever
+ *   subtracts indices, so the wrap is harmless there; for anything that
+ *   outlives it (history, checkpoints, recordings) the producer also
+ *   counts half laps of the 32-bit index in write_epoch, and
+ *   stream_position_abs() widens an index to a 64-bit absolute position.
+ *
  * ARCHITECTURE.md compliance:
  * - RULE 1.1.1: All keying events flow through KeyingStream
  * - RULE 1.1.2: No component communicates except through the stream
+ * - RULE 2.1.4: Multiple producers coordinate only through write_idx.fetch_add()
  * - RULE 3.1.1: Only atomic operations for synchronization
  * - RULE 3.1.4: No operation shall block
- * - RULE 9.1.4: PSRAM for stream buffer
+ * - RULE 9.1.4: Hot ring in internal SRAM, history archive in PSRAM
  */
 
 #ifndef KEYER_STREAM_H
@@ -25,6 +55,7 @@
 #include <stdbool.h>
 #include <stdatomic.h>
 #include "sample.h"
+#include "stream_registry.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,43 +65,372 @@ extern "C" {
  * KeyingStream - Lock-free SPMC Ring Buffer
  * ============================================================================ */
 
+/** Default sample tick period (1 kHz stream) */
+#define STREAM_DEFAULT_TICK_US 1000
+
+/**
+ * Line keying_stream_t is split on: the largest ESP32-S3 data cache line
+ * (PSRAM), and the common host line.
+ */
+#define STREAM_CACHE_LINE 64
+
+/**
+ * @brief One ring slot: sample plus commit tag
+ *
+ * commit holds (lap % 0xFFFF) + 1 of the write that filled the slot, where
+ * lap = idx >> log2(capacity). 0 means never written or being rewritten.
+ * Readers check the tag before and after copying the sample (seqlock), so
+ * a producer lapping a slow reader mid-copy is detected, not returned.
+ */
+typedef struct {
+    stream_sample_t      sample;  /**< Payload */
+    atomic_uint_least16_t commit; /**< Lap tag, stored (release) after sample */
+} stream_slot_t;
+
+struct keying_stream;
+
+/**
+ * @brief Producer handle: one lane with its own silence compression
+ *
+ * Owned by a single thread. Distinct producers may push concurrently.
+ */
+typedef struct {
+    struct keying_stream *stream;    /**< Stream written to */
+    stream_lane_t   lane;            /**< Lane ID stamped into every sample */
+    atomic_uint_fast32_t idle_ticks; /**< Silence compression counter */
+    stream_sample_t last_sample;     /**< Last sample for change detection */
+    uint64_t        ticks_emitted;   /**< Lane ticks covered by written slots */
+} stream_producer_t;
+
+/**
+ * @brief Tick anchor: a recent LOCAL slot and the absolute tick it starts at
+ *
+ * Published by the LOCAL producer after every slot it writes (seqlock:
+ * seq is odd while an update is in progress). Lets a consumer that joins
+ * late, or resyncs after a skip, learn the absolute tick of a position,
+ * and the key state in effect after that slot (every edge is a LOCAL slot,
+ * so the state is always current).
+ */
+typedef struct {
+    atomic_uint seq;   /**< Sequence (odd = writer active) */
+    size_t      idx;   /**< Stream index of the slot */
+    uint64_t    tick;  /**< Absolute LOCAL tick at which that slot starts */
+    uint32_t    span;  /**< Ticks the slot covers */
+    gpio_state_t gpio; /**< Paddle state after the slot */
+    uint8_t     local_key; /**< Keyer output after the slot */
+} stream_tick_anchor_t;
+
+/**
+ * @brief Stream tick -> synced network time (CWNet clock sync)
+ *
+ * Published by the clock-sync owner whenever its estimate moves (seqlock,
+ * single writer): LOCAL tick ref_tick starts at network time net_us, and
+ * the network clock gains drift_ppm on the stream's. Two stations synced
+ * to the same server share that clock, so their recordings line up on it.
+ */
+typedef struct {
+    atomic_uint seq;   /**< Sequence (odd = writer active) */
+    uint64_t    ref_tick;   /**< Absolute LOCAL tick of the reference */
+    int64_t     net_us;     /**< Network time at which ref_tick starts */
+    int32_t     drift_ppm;  /**< Network clock rate relative to the stream's */
+    uint32_t    updates;    /**< Estimates published, 0 = not synced */
+} stream_net_clock_t;
+
+/**
+ * @brief Network clock snapshot (stream_read_net_clock())
+ */
+typedef struct {
+    uint64_t ref_tick;
+    int64_t  net_us;
+    int32_t  drift_ppm;
+    uint32_t updates;
+} stream_net_time_t;
+
+/**
+ * @brief LOCAL key state at a stream position (stream_read_key_state())
+ */
+typedef struct {
+    size_t       idx;        /**< First index after the state checkpoint */
+    uint64_t     pos;        /**< idx as an absolute position */
+    uint64_t     tick;       /**< Absolute LOCAL tick at which idx starts */
+    gpio_state_t gpio;       /**< Paddle state in effect at idx */
+    uint8_t      local_key;  /**< Keyer output in effect at idx */
+} stream_key_state_t;
+
+/**
+ * @brief History tier behind the hot ring (PSRAM)
+ *
+ * Written only by the spill stage (stream_archive_spill(), one background
+ * thread). Slots keep their absolute stream index; commit tags use the
+ * archive's own lap, so readers validate them exactly like hot slots.
+ *
+ * A compact archive stores 16-bit records (stream_compact_t, two per
+ * 32-bit word) instead of slots: four times the depth, no zero-copy spans
+ * and no per-record tags, so only the current unbroken run is readable.
+ */
+typedef struct stream_archive {
+    stream_slot_t *buffer;      /**< Archive slots (PSRAM), NULL if compact */
+    uint32_t      *words;       /**< Compact records (PSRAM), NULL if slots */
+    size_t         capacity;    /**< Samples (power of 2, >= hot capacity) */
+    size_t         mask;        /**< capacity - 1 */
+    uint32_t       lap_shift;   /**< log2(capacity) */
+    atomic_size_t  head;        /**< Indices below are archived (release) */
+    atomic_size_t  claim;       /**< Indices below may be under rewrite */
+    atomic_size_t  base;        /**< First index of the current unbroken run */
+    atomic_uint    spilled;     /**< Slots copied */
+    atomic_uint    gaps;        /**< Spill fell a whole hot ring behind */
+} stream_archive_t;
+
 /**
- * @brief Lock-free SPMC ring buffer for keying events
+ * @brief Tier a span was read from (see stream_read_tiered_span())
+ */
+typedef enum {
+    STREAM_TIER_HOT = 0,        /**< Internal SRAM ring */
+    STREAM_TIER_ARCHIVE,        /**< PSRAM history */
+} stream_tier_t;
+
+/**
+ * @brief Lock-free ring buffer for keying events
  *
- * Single producer (RT thread), multiple consumers.
+ * Producer lanes, multiple consumers.
  * All coordination through atomic operations.
  *
  * Memory ordering:
- * - Producer uses memory_order_acq_rel for write_idx.fetch_add()
- * - Consumer uses memory_order_acquire for write_idx.load()
+ * - Producer uses memory_order_acq_rel for write_idx.fetch_add(), then
+ *   stores the slot commit tag with memory_order_release
+ * - Consumer uses memory_order_acquire for write_idx.load() and the tag
  *
  * Buffer must be power of 2 for fast modulo via mask.
+ *
+ * Every LOCAL sample (and every LOCAL silence tick) spans tick_period_us of
+ * real time. The producer sets it once before pushing; consumers convert
+ * ticks to time with stream_tick_period_us() instead of assuming 1ms.
+ * LOCAL tick 0 starts at epoch_us (esp_timer time base), so
+ * time_us = epoch_us + tick * tick_period_us (see timed_consumer_t).
+ *
+ * Layout: fields are grouped by who writes them, one cache line each
+ * (STREAM_CACHE_LINE), so a push on Core 0 does not invalidate the
+ * configuration every Core 1 consumer reads on each call:
+ * - configuration, set before the first push and then read-only;
+ * - the published write index (every slot written);
+ * - LOCAL producer state (every push, idle ones included);
+ * - the tick anchor (every LOCAL slot).
  */
-typedef struct {
-    stream_sample_t *buffer;      /**< External buffer (PSRAM) */
+typedef struct keying_stream {
+    /* Configuration (read-only once pushing) */
+    stream_slot_t   *buffer;      /**< Hot ring (internal SRAM) */
     size_t           capacity;    /**< Buffer size (must be power of 2) */
     size_t           mask;        /**< capacity - 1, for fast modulo */
-    atomic_size_t    write_idx;   /**< Producer write index (monotonic) */
-    atomic_uint_fast32_t idle_ticks; /**< Silence compression counter */
-    stream_sample_t  last_sample; /**< Last sample for change detection */
+    uint32_t         lap_shift;   /**< log2(capacity), for commit tags */
+    atomic_uint_fast32_t tick_period_us; /**< Real time spanned by one tick */
+    int64_t          epoch_us;    /**< Time at which LOCAL tick 0 starts */
+    stream_archive_t *archive;    /**< History tier, NULL if none */
+    stream_registry_t *registry;  /**< Consumer telemetry, NULL if none */
+
+    /* Published write position (producers write, consumers poll) */
+    /** Next slot to claim (monotonic) */
+    atomic_size_t    write_idx __attribute__((aligned(STREAM_CACHE_LINE)));
+    atomic_uint      write_epoch; /**< Absolute write position >> 31 (half laps) */
+
+    /* LOCAL producer (RT task) */
+    /** Built-in LOCAL lane (stream_push) */
+    stream_producer_t local __attribute__((aligned(STREAM_CACHE_LINE)));
+
+    /* Tick anchor (RT task writes, timed consumers read on resync) */
+    /** Latest LOCAL slot -> absolute tick */
+    stream_tick_anchor_t anchor __attribute__((aligned(STREAM_CACHE_LINE)));
+
+    /* Network clock (clock-sync owner writes, exporters read) */
+    /** LOCAL tick -> synced network time */
+    stream_net_clock_t net_clock __attribute__((aligned(STREAM_CACHE_LINE)));
 } keying_stream_t;
 
 /**
  * @brief Initialize stream with external buffer
  *
  * @param stream Stream to initialize
- * @param buffer External buffer (should be in PSRAM for large buffers)
+ * @param buffer Hot ring storage (internal SRAM)
  * @param capacity Buffer size (MUST be power of 2)
  *
  * @note Asserts if capacity is not power of 2
  */
-void stream_init(keying_stream_t *stream, stream_sample_t *buffer, size_t capacity);
+void stream_init(keying_stream_t *stream, stream_slot_t *buffer, size_t capacity);
+
+/**
+ * @brief Attach a history tier (before the first push)
+ *
+ * @param stream Stream to extend
+ * @param archive Archive state
+ * @param buffer Archive slots (PSRAM)
+ * @param capacity Archive size (power of 2, >= stream capacity)
+ */
+void stream_attach_archive(keying_stream_t *stream, stream_archive_t *archive,
+                           stream_slot_t *buffer, size_t capacity);
+
+/**
+ * @brief Attach a compact history tier (before the first push)
+ *
+ * @param stream Stream to extend
+ * @param archive Archive state
+ * @param words Record storage, capacity / 2 words (PSRAM)
+ * @param capacity Archive size in samples (power of 2, >= stream capacity)
+ */
+void stream_attach_compact_archive(keying_stream_t *stream, stream_archive_t *archive,
+                                   uint32_t *words, size_t capacity);
+
+/**
+ * @brief Decode archived samples from a compact archive
+ *
+ * Copies up to max samples starting at idx (stopping at the archive head)
+ * into out[].sample. Check stream_tier_intact(..., STREAM_TIER_ARCHIVE)
+ * afterwards before trusting them.
+ *
+ * REMOTE play ticks are unwrapped against ref_tick, advanced over the LOCAL
+ * samples decoded (sample_compact_decode_at()).
+ *
+ * @param ref_tick Absolute LOCAL tick at which idx starts (the reader's
+ *                 running tick; 0 if unknown: REMOTE ticks keep 12 bits)
+ * @return Samples decoded; 0 if idx is not archived or the archive is not compact
+ */
+size_t stream_archive_decode(const keying_stream_t *stream, size_t idx, uint64_t ref_tick,
+                             stream_slot_t *out, size_t max);
+
+/**
+ * @brief Copy newly committed hot slots into the archive (spill stage)
+ *
+ * Call from one background thread often enough to stay within one hot ring
+ * of the producers. If it falls further behind, the unreachable slots are
+ * lost (gaps counter) and the archive restarts from the oldest hot slot.
+ * Never blocks; a no-op without an archive.
+ *
+ * @param stream Stream to spill
+ * @param max Maximum slots to copy in this call
+ * @return Slots archived
+ */
+size_t stream_archive_spill(keying_stream_t *stream, size_t max);
+
+/**
+ * @brief Oldest index still readable from either tier
+ *
+ * @param stream Stream to query
+ * @return Oldest valid position (the hot ring's oldest without archive)
+ */
+size_t stream_oldest_position(const keying_stream_t *stream);
+
+/**
+ * @brief Set sample tick period (producer, before first push)
+ *
+ * @param stream Stream to configure
+ * @param tick_us Tick period in microseconds (0 is ignored)
+ */
+void stream_set_tick_period_us(keying_stream_t *stream, uint32_t tick_us);
+
+/**
+ * @brief Get sample tick period
+ *
+ * @param stream Stream to query
+ * @return Real time spanned by one sample tick, in microseconds
+ */
+static inline uint32_t stream_tick_period_us(const keying_stream_t *stream) {
+    return (uint32_t)atomic_load_explicit(&stream->tick_period_us, memory_order_relaxed);
+}
+
+/**
+ * @brief Set the time of LOCAL tick 0 (producer, before first push)
+ *
+ * @param stream Stream to configure
+ * @param epoch_us Timestamp at which the first tick starts
+ */
+void stream_set_epoch_us(keying_stream_t *stream, int64_t epoch_us);
+
+/**
+ * @brief Get the time of LOCAL tick 0
+ *
+ * @param stream Stream to query
+ * @return Epoch in microseconds
+ */
+static inline int64_t stream_epoch_us(const keying_stream_t *stream) {
+    return stream->epoch_us;
+}
+
+/**
+ * @brief LOCAL ticks held back by silence compression (consumer side)
+ *
+ * The idle run since the last written LOCAL slot; it reaches the ring
+ * only when the key state changes. A reader that has consumed every slot
+ * knows the LOCAL state has held for this many more ticks.
+ *
+ * @param stream Stream to query
+ * @return Pending idle ticks (may already be stale by one push)
+ */
+static inline uint32_t stream_pending_idle_ticks(const keying_stream_t *stream) {
+    return (uint32_t)atomic_load_explicit(&stream->local.idle_ticks, memory_order_relaxed);
+}
+
+/**
+ * @brief Read the latest tick anchor (consumer side)
+ *
+ * Retries while the producer is updating it; the producer never waits.
+ *
+ * @param stream Stream to query
+ * @param idx Stream index of the anchored slot
+ * @param tick Absolute LOCAL tick at which that slot starts
+ */
+void stream_read_anchor(const keying_stream_t *stream, size_t *idx, uint64_t *tick);
+
+/**
+ * @brief Publish the network time of a LOCAL tick (clock-sync owner only)
+ *
+ * @param stream Stream to stamp
+ * @param ref_tick Absolute LOCAL tick
+ * @param net_us Synced network time at which ref_tick starts
+ * @param drift_ppm Network clock rate relative to the stream's
+ */
+void stream_set_net_clock(keying_stream_t *stream, uint64_t ref_tick, int64_t net_us,
+                          int32_t drift_ppm);
+
+/**
+ * @brief Withdraw the network clock (sync lost or server changed)
+ */
+void stream_clear_net_clock(keying_stream_t *stream);
+
+/**
+ * @brief Read the network clock (any thread)
+ *
+ * @param stream Stream to query
+ * @param out Snapshot (zeroed when not synced)
+ * @return true if a mapping is published
+ */
+bool stream_read_net_clock(const keying_stream_t *stream, stream_net_time_t *out);
+
+/**
+ * @brief Network time at which a LOCAL tick starts
+ *
+ * @param clock Snapshot from stream_read_net_clock()
+ * @param tick Absolute LOCAL tick (either side of ref_tick)
+ * @param tick_us Stream tick period
+ * @return Synced network time in microseconds
+ */
+int64_t stream_net_time_us(const stream_net_time_t *clock, uint64_t tick, uint32_t tick_us);
+
+/**
+ * @brief Read the current LOCAL key state checkpoint (consumer side)
+ *
+ * O(1): a consumer starting at state->idx with this state sees every
+ * later change, without waiting for the next edge to learn the levels.
+ * Before the first LOCAL slot it is idle at index 0, tick 0.
+ *
+ * @param stream Stream to query
+ * @param state Position, tick and key state
+ */
+void stream_read_key_state(const keying_stream_t *stream, stream_key_state_t *state);
 
 /**
- * @brief Push sample to stream (producer only, RT thread)
+ * @brief Push sample to stream (LOCAL lane, RT thread only)
  *
  * If sample is unchanged from previous, increments idle counter
  * instead of writing (silence compression / RLE).
+ * Equivalent to stream_producer_push(&stream->local, sample).
  *
  * Timing: O(1), typically < 200ns. Never blocks.
  *
@@ -83,7 +443,8 @@ bool stream_push(keying_stream_t *stream, stream_sample_t sample);
 /**
  * @brief Push sample unconditionally (no silence compression)
  *
- * Use when every sample must be recorded.
+ * Use when every sample must be recorded. Raw slots carry no lane tick
+ * accounting and do not move the tick anchor.
  *
  * @param stream Stream to push to
  * @param sample Sample to push
@@ -92,7 +453,7 @@ bool stream_push(keying_stream_t *stream, stream_sample_t sample);
 bool stream_push_raw(keying_stream_t *stream, stream_sample_t sample);
 
 /**
- * @brief Flush accumulated idle ticks as silence marker
+ * @brief Flush accumulated idle ticks as silence marker (LOCAL lane)
  *
  * Call before shutdown to ensure all state is captured.
  *
@@ -100,15 +461,175 @@ bool stream_push_raw(keying_stream_t *stream, stream_sample_t sample);
  */
 void stream_flush(keying_stream_t *stream);
 
+/**
+ * @brief Account LOCAL ticks the RT loop did not run (idle sleep)
+ *
+ * Equivalent to stream_producer_skip(&stream->local, ticks).
+ *
+ * @param stream Stream
+ * @param ticks Ticks slept through
+ */
+void stream_skip(keying_stream_t *stream, uint32_t ticks);
+
+/**
+ * @brief Initialize a producer lane
+ *
+ * @param producer Producer to initialize
+ * @param stream Stream to write to
+ * @param lane Lane ID (LOCAL is taken by stream_push)
+ */
+void stream_producer_init(stream_producer_t *producer, keying_stream_t *stream,
+                          stream_lane_t lane);
+
+/**
+ * @brief Push sample on a producer lane (silence compressed)
+ *
+ * Never blocks; safe concurrently with other producers' pushes.
+ *
+ * @param producer Producer handle (owned by the calling thread)
+ * @param sample Sample to push (lane bits are overwritten)
+ * @return true on success
+ */
+bool stream_producer_push(stream_producer_t *producer, stream_sample_t sample);
+
+/**
+ * @brief Flush a producer lane's idle ticks as a silence marker
+ *
+ * @param producer Producer handle
+ */
+void stream_producer_flush(stream_producer_t *producer);
+
+/**
+ * @brief Add ticks a producer did not push as idle time
+ *
+ * For a producer that stopped ticking while its state was unchanged: the
+ * ticks join the current idle run, exactly as if each had pushed the last
+ * sample again, so the gap lands in the silence marker written at the next
+ * state change and the lane timebase stays aligned. Runs past
+ * SAMPLE_SILENCE_MAX_TICKS are chained.
+ *
+ * @param producer Producer handle (owned by the calling thread)
+ * @param ticks Ticks not pushed
+ */
+void stream_producer_skip(stream_producer_t *producer, uint32_t ticks);
+
+/**
+ * @brief Result of stream_read_slot()
+ */
+typedef enum {
+    STREAM_READ_OK = 0,       /**< Sample copied and validated */
+    STREAM_READ_EMPTY,        /**< Not yet written or not yet committed */
+    STREAM_READ_OVERWRITTEN,  /**< Producer lapped this index (before or during copy) */
+} stream_read_result_t;
+
+/**
+ * @brief Read sample at given index, validating the slot tag after the copy
+ *
+ * Indices the hot ring has already overwritten are looked up in the
+ * archive, if any.
+ *
+ * @param stream Stream to read from
+ * @param idx Index to read
+ * @param out Output sample (valid only if STREAM_READ_OK)
+ * @return Read result
+ */
+stream_read_result_t stream_read_slot(const keying_stream_t *stream, size_t idx,
+                                      stream_sample_t *out);
+
+/**
+ * @brief stream_read_slot() for a reader that tracks the LOCAL tick
+ *
+ * A compact archive keeps only 12 bits of a REMOTE event's play tick;
+ * they are unwrapped against ref_tick (sample_compact_decode_at()).
+ * stream_read_slot() passes 0, so archived REMOTE ticks keep 12 bits.
+ *
+ * @param ref_tick Absolute LOCAL tick at which idx starts
+ */
+stream_read_result_t stream_read_slot_at(const keying_stream_t *stream, size_t idx,
+                                         uint64_t ref_tick, stream_sample_t *out);
+
 /**
  * @brief Read sample at given index
  *
  * @param stream Stream to read from
  * @param idx Index to read
  * @param out Output sample (written on success)
- * @return true if sample available, false if not yet written or overwritten
+ * @return true if sample available, false if not yet written/committed or overwritten
+ */
+static inline bool stream_read(const keying_stream_t *stream, size_t idx, stream_sample_t *out) {
+    return stream_read_slot(stream, idx, out) == STREAM_READ_OK;
+}
+
+/**
+ * @brief Get up to max committed slots from idx as two contiguous spans
+ *
+ * One acquire per batch: write_idx is loaded once and the commit tags are
+ * scanned with relaxed loads followed by a single acquire fence. The span
+ * ends at the first slot not yet committed. `a` runs from idx to the end
+ * of the ring (or n), `b` continues from the ring start after a wrap.
+ *
+ * Slots stay owned by the producer: check stream_span_intact() after
+ * processing to learn whether any of them was overwritten meanwhile.
+ *
+ * @param stream Stream to read from
+ * @param idx First absolute index
+ * @param max Maximum number of slots to return
+ * @param a First span (NULL if empty)
+ * @param na Length of first span
+ * @param b Second span after wrap (NULL if empty)
+ * @param nb Length of second span
+ * @return Total slots (na + nb); 0 if caught up or idx already overwritten
+ */
+size_t stream_read_span(const keying_stream_t *stream, size_t idx, size_t max,
+                        const stream_slot_t **a, size_t *na,
+                        const stream_slot_t **b, size_t *nb);
+
+/**
+ * @brief Like stream_read_span(), falling back to the archive for old indices
+ *
+ * An archive span ends at the archive head; the next call continues in
+ * whichever tier holds the following index.
+ * Compact archives have no slots to point into: archived indices return 0
+ * with tier STREAM_TIER_ARCHIVE; use stream_archive_decode().
+ *
+ * @param tier Tier the span points into (for stream_tier_intact())
+ * @return Total slots (na + nb); 0 if caught up or idx is in neither tier
+ */
+size_t stream_read_tiered_span(const keying_stream_t *stream, size_t idx, size_t max,
+                               const stream_slot_t **a, size_t *na,
+                               const stream_slot_t **b, size_t *nb,
+                               stream_tier_t *tier);
+
+/**
+ * @brief stream_span_intact() for a span from stream_read_tiered_span()
+ *
+ * @param stream Stream the span came from
+ * @param idx First absolute index of the span
+ * @param tier Tier reported for the span
+ * @return true if the span's slots were not rewritten meanwhile
+ */
+bool stream_tier_intact(const keying_stream_t *stream, size_t idx, stream_tier_t tier);
+
+/**
+ * @brief Check that a span obtained at idx was not overwritten while in use
+ *
+ * @param stream Stream the span came from
+ * @param idx First absolute index of the span
+ * @return true if no producer has lapped idx yet
+ */
+bool stream_span_intact(const keying_stream_t *stream, size_t idx);
+
+/**
+ * @brief Check if the slot at idx has been committed by its writer
+ *
+ * A slot can be claimed (write_idx already past it) while its producer is
+ * still copying the sample. Consumers stop there and retry next tick.
+ *
+ * @param stream Stream to check
+ * @param idx Absolute index (must be < write position)
+ * @return true if the sample for idx is published
  */
-bool stream_read(const keying_stream_t *stream, size_t idx, stream_sample_t *out);
+bool stream_is_committed(const keying_stream_t *stream, size_t idx);
 
 /**
  * @brief Get current write position
@@ -120,6 +641,37 @@ bool stream_read(const keying_stream_t *stream, size_t idx, stream_sample_t *out
  */
 size_t stream_write_position(const keying_stream_t *stream);
 
+/**
+ * @brief Get current write position as an absolute 64-bit position
+ *
+ * The 32-bit index widened with write_epoch; never wraps.
+ *
+ * @param stream Stream to query
+ * @return Samples ever written
+ */
+uint64_t stream_write_position_abs(const keying_stream_t *stream);
+
+/**
+ * @brief Widen a stream index to an absolute position
+ *
+ * Valid for indices at most 2^31 behind the write position (every
+ * readable index, either tier).
+ *
+ * @param stream Stream the index belongs to
+ * @param idx Stream index (not ahead of the write position)
+ * @return Absolute position of idx
+ */
+uint64_t stream_position_abs(const keying_stream_t *stream, size_t idx);
+
+/**
+ * @brief Stream index of an absolute position
+ *
+ * @param stream Stream to query
+ * @param pos Absolute position (within 2^31 of the write position)
+ * @return Index to read pos at
+ */
+size_t stream_position_index(const keying_stream_t *stream, uint64_t pos);
+
 /**
  * @brief Calculate lag for consumer (samples behind producer)
  *
@@ -132,7 +684,9 @@ size_t stream_lag(const keying_stream_t *stream, size_t read_idx);
 /**
  * @brief Check if consumer has overrun (fell too far behind)
  *
- * If true, consumer has missed samples and should resync.
+ * Hot ring only: consumers that must not touch PSRAM (hard RT, skip-ahead
+ * best effort) treat anything older as lost. If true, consumer has missed
+ * samples and should resync.
  *
  * @param stream Stream to query
  * @param read_idx Consumer's current read index
@@ -160,9 +714,15 @@ static inline size_t stream_capacity(const keying_stream_t *stream) {
  * Each consumer has its own read_idx (thread-local, no sync needed).
  * Multiple consumers can read independently from the same stream.
  */
+/** Samples consumer_next_span() decodes per call from a compact archive */
+#define STREAM_CONSUMER_DECODE_SLOTS 32
+
 typedef struct {
     const keying_stream_t *stream;  /**< Stream being consumed */
     size_t read_idx;                /**< Thread-local read index */
+    size_t write_seen;              /**< Write index last loaded (consumer_next) */
+    stream_tier_t span_tier;        /**< Tier of the last consumer_next_span() */
+    stream_slot_t decoded[STREAM_CONSUMER_DECODE_SLOTS]; /**< Compact archive span */
 } stream_consumer_t;
 
 /**
@@ -178,7 +738,8 @@ void consumer_init(stream_consumer_t *consumer, const keying_stream_t *stream);
 /**
  * @brief Initialize consumer at specific position
  *
- * Useful for replaying history or resuming from known point.
+ * Useful for replaying history or resuming from known point. Positions
+ * older than the hot ring are read from the archive.
  *
  * @param consumer Consumer to initialize
  * @param stream Stream to consume from
@@ -187,15 +748,113 @@ void consumer_init(stream_consumer_t *consumer, const keying_stream_t *stream);
 void consumer_init_at(stream_consumer_t *consumer, const keying_stream_t *stream,
                       size_t position);
 
+/**
+ * @brief Initialize consumer at an absolute position
+ *
+ * @param consumer Consumer to initialize
+ * @param stream Stream to consume from
+ * @param pos Absolute starting position (stream_position_abs())
+ */
+void consumer_init_at_abs(stream_consumer_t *consumer, const keying_stream_t *stream,
+                          uint64_t pos);
+
+/**
+ * @brief Initialize consumer at the key state checkpoint
+ *
+ * For consumers that must know the current paddle/key levels from the
+ * start (WebUI, decoder restart, CWNet reconnect).
+ *
+ * @param consumer Consumer to initialize
+ * @param stream Stream to consume from
+ * @param state Key state in effect at the consumer's start position
+ */
+void consumer_init_with_state(stream_consumer_t *consumer, const keying_stream_t *stream,
+                              stream_key_state_t *state);
+
 /**
  * @brief Read next sample (non-blocking)
  *
+ * Slots below the write index last seen are validated by their commit tag
+ * alone; the shared write index is loaded again only when the consumer
+ * reaches it (or a slot fails), not once per sample.
+ *
  * @param consumer Consumer handle
  * @param out Output sample (written on success)
  * @return true if sample available, false if caught up
  */
 bool consumer_next(stream_consumer_t *consumer, stream_sample_t *out);
 
+/**
+ * @brief Get pending samples as up to two contiguous ring spans
+ *
+ * Zero-copy batch read (see stream_read_tiered_span()). Walk a[0..na) then
+ * b[0..nb) reading .sample, then call consumer_commit() with the number
+ * of slots consumed. read_idx does not move until commit. From a compact
+ * archive the span is decoded into the consumer (up to
+ * STREAM_CONSUMER_DECODE_SLOTS per call).
+ *
+ * @param consumer Consumer handle
+ * @param a First span
+ * @param na Length of first span
+ * @param b Second span after wrap
+ * @param nb Length of second span
+ * @param max Maximum number of slots to return
+ * @return Total slots available in the spans (0 if caught up or overrun)
+ */
+size_t consumer_next_span(stream_consumer_t *consumer,
+                          const stream_slot_t **a, size_t *na,
+                          const stream_slot_t **b, size_t *nb, size_t max);
+
+/**
+ * @brief Consume n slots returned by consumer_next_span()
+ *
+ * @param consumer Consumer handle
+ * @param n Slots consumed (<= span total)
+ * @return true if the span was intact, false if the producer overwrote it
+ *         while it was being processed
+ */
+bool consumer_commit(stream_consumer_t *consumer, size_t n);
+
+/**
+ * @brief Result of consumer_scan_until_edge()
+ */
+typedef enum {
+    STREAM_SCAN_EDGE = 0,       /**< Stopped on a slot carrying a requested flag */
+    STREAM_SCAN_IDLE,           /**< Caught up, or max slots scanned */
+    STREAM_SCAN_OVERWRITTEN,    /**< Producer lapped the scan (ticks not added) */
+} stream_scan_result_t;
+
+/**
+ * @brief Find the first slot in a span whose flags meet mask
+ *
+ * One 32-bit load per slot; LOCAL samples without a requested flag take
+ * a single test. LOCAL ticks of the slots passed over are added to ticks.
+ *
+ * @param slots Span (from a *_next_span() call)
+ * @param n Span length
+ * @param mask FLAG_* bits to stop at (lane bits ignored)
+ * @param ticks LOCAL tick accumulator
+ * @return Index of the first matching slot, n if none
+ */
+size_t stream_span_scan(const stream_slot_t *slots, size_t n, uint8_t mask, uint64_t *ticks);
+
+/**
+ * @brief Skip forward to the next slot whose flags meet mask
+ *
+ * For catch-up readers (decoder, timeline, export) that only act on some
+ * edges: steady key-down, paddle holds and silence markers between them
+ * are passed over a span at a time. The matching slot (any lane) is left
+ * unconsumed, so consumer_next() returns it.
+ *
+ * @param consumer Consumer handle
+ * @param mask FLAG_* bits to stop at, e.g. FLAG_LOCAL_EDGE | FLAG_GPIO_EDGE
+ * @param max Most slots to pass over in this call
+ * @param ticks LOCAL ticks (silence included) of the skipped slots, added
+ * @return Scan result
+ */
+stream_scan_result_t consumer_scan_until_edge(stream_consumer_t *consumer, uint8_t mask,
+                                              size_t max, uint64_t *ticks);
+
 /**
  * @brief Peek at next sample without consuming
  *
@@ -216,6 +875,8 @@ size_t consumer_lag(const stream_consumer_t *consumer);
 /**
  * @brief Check if consumer has fallen behind and missed samples
  *
+ * True once read_idx is older than stream_oldest_position() (both tiers).
+ *
  * @param consumer Consumer handle
  * @return true if overrun, false if OK
  */
@@ -234,7 +895,7 @@ size_t consumer_skip_to_latest(stream_consumer_t *consumer);
 /**
  * @brief Resync after overrun
  *
- * Moves read_idx to oldest valid position in buffer.
+ * Moves read_idx to the oldest valid position (archive included).
  *
  * @param consumer Consumer handle
  */
@@ -250,6 +911,16 @@ static inline size_t consumer_position(const stream_consumer_t *consumer) {
     return consumer->read_idx;
 }
 
+/**
+ * @brief Get current read position as an absolute position
+ *
+ * @param consumer Consumer handle
+ * @return Absolute position of read_idx
+ */
+static inline uint64_t consumer_position_abs(const stream_consumer_t *consumer) {
+    return stream_position_abs(consumer->stream, consumer->read_idx);
+}
+
 #ifdef __cplusplus
 }
 #endif
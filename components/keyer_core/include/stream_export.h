@@ -0,0 +1,132 @@
+/**
+ * @file stream_export.h
+ * @brief Keying history export as a .cwk binary recording
+ *
+ * A recording is a cwk_header_t followed by raw 6-byte stream_sample_t
+ * records, exactly as they sit in the stream, oldest first. Everything is
+ * little-endian. The header carries the tick period and the absolute LOCAL
+ * tick of the first record, so LOCAL samples and silence markers can be
+ * summed back into time; captured_tick/captured_us tie that timebase to
+ * the exporter's uptime. REMOTE samples carry their own tick as usual.
+ *
+ * With CWK_FLAG_NET_CLOCK set, net_first_us and net_drift_ppm also place
+ * the ticks on the CWNet synced clock (stream_read_net_clock()), which
+ * every station on the same server shares: recordings from both ends of a
+ * contact line up on it, and a LOCAL edge on one against the REMOTE edge
+ * it caused on the other is the one-way keying latency (tools/cwk).
+ *
+ * The exporter reads the stream tiers directly into the caller's chunk
+ * buffer, so a transport (HTTP chunked response, console) never holds more
+ * than one chunk. It is a plain reader: the producer is never blocked and
+ * a slow export that gets lapped stops early with `lost` set.
+ *
+ * Host converter: tools/cwk/cwk_convert.py (CSV / VCD).
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#ifndef KEYER_STREAM_EXPORT_H
+#define KEYER_STREAM_EXPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Recording magic */
+#define CWK_MAGIC   "CWK1"
+
+/** Recording format version (1: 48-byte header without the network clock) */
+#define CWK_VERSION 2
+
+/** net_first_us / net_drift_ppm are valid */
+#define CWK_FLAG_NET_CLOCK 0x0001U
+
+/**
+ * @brief .cwk recording header (64 bytes packed)
+ */
+typedef struct __attribute__((packed)) {
+    char     magic[4];       /**< CWK_MAGIC */
+    uint16_t version;        /**< CWK_VERSION */
+    uint16_t header_size;    /**< sizeof(cwk_header_t), records start here */
+    uint16_t sample_size;    /**< sizeof(stream_sample_t) */
+    uint16_t layout;         /**< SAMPLE_LAYOUT_VERSION (0 = before layouts) */
+    uint32_t tick_us;        /**< Stream tick period in microseconds */
+    uint32_t sample_count;   /**< Records in the snapshot */
+    uint32_t first_idx;      /**< Stream index of the first record (low 32 bits) */
+    uint64_t first_tick;     /**< Epoch: absolute LOCAL tick the first record starts at */
+    uint64_t captured_tick;  /**< LOCAL tick at the end of the snapshot */
+    uint64_t captured_us;    /**< Exporter uptime (us) when the snapshot was taken */
+    int64_t  net_first_us;   /**< Synced network time at which first_tick starts */
+    int32_t  net_drift_ppm;  /**< Network clock rate relative to the ticks */
+    uint32_t flags;          /**< CWK_FLAG_* */
+} cwk_header_t;
+
+_Static_assert(sizeof(cwk_header_t) == 64, "cwk_header_t must be 64 bytes");
+
+/**
+ * @brief Stamp a header with the network clock (first_tick and tick_us set)
+ *
+ * @param h Header
+ * @param clock Network clock snapshot, NULL or unsynced to leave it clear
+ */
+void cwk_header_set_net_clock(cwk_header_t *h, const stream_net_time_t *clock);
+
+/**
+ * @brief Export cursor over a snapshot of stream history
+ */
+typedef struct {
+    const keying_stream_t *stream; /**< Exported stream */
+    cwk_header_t header;           /**< Recording header */
+    size_t next_idx;               /**< Next record to emit */
+    size_t end_idx;                /**< One past the last record */
+    uint64_t tick;                 /**< LOCAL tick at next_idx (archived REMOTE ticks) */
+    size_t header_sent;            /**< Header bytes already emitted */
+    bool lost;                     /**< Producer overwrote unread records */
+} stream_export_t;
+
+/**
+ * @brief Snapshot the history window to export
+ *
+ * The snapshot ends at the last LOCAL slot and starts far enough back to
+ * cover window_ticks of LOCAL time (or the oldest sample still held in the
+ * hot ring or archive, whichever is newer).
+ *
+ * @param exp Exporter to initialize
+ * @param stream Stream to export
+ * @param window_ticks LOCAL ticks to cover (0 = all history)
+ * @param now_us Caller's uptime, stored as captured_us
+ */
+void stream_export_begin(stream_export_t *exp, const keying_stream_t *stream,
+                         uint64_t window_ticks, uint64_t now_us);
+
+/**
+ * @brief Emit the next chunk of the recording
+ *
+ * Fills buf with the rest of the header, then whole records. Stops early
+ * (setting exp->lost) if a record is no longer readable.
+ *
+ * @param exp Exporter
+ * @param buf Destination chunk
+ * @param len Chunk size (at least sizeof(stream_sample_t))
+ * @return Bytes written, 0 when the recording is complete
+ */
+size_t stream_export_read(stream_export_t *exp, uint8_t *buf, size_t len);
+
+/**
+ * @brief Total recording size in bytes (header + snapshot records)
+ */
+static inline size_t stream_export_size(const stream_export_t *exp) {
+    return sizeof(cwk_header_t) + (size_t)exp->header.sample_count * sizeof(stream_sample_t);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_STREAM_EXPORT_H */
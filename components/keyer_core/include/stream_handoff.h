@@ -0,0 +1,131 @@
+/**
+ * @file stream_handoff.h
+ * @brief Foreign lane handoff: Core 1 producers never write the hot ring
+ *
+ * The hard-RT consumer (consumer.h) waits on the next slot of the hot
+ * ring until it is committed. A Core 1 task that claimed a slot with
+ * write_idx.fetch_add() and was then preempted before committing it
+ * would hold the consumer there while the LOCAL lane kept writing, until
+ * the lag faults and the RT task silences TX, sidetone and PTT. So a
+ * best-effort task hands its samples over instead: it owns one handoff,
+ * a single-producer single-consumer ring, and the RT task drains every
+ * handoff at the top of its tick, writing the samples into the stream on
+ * the handoff's lane itself. Every hot slot is then claimed and committed
+ * by the RT task, on Core 0, within one tick.
+ *
+ * A handoff is attached once (stream_handoffs_attach) and never removed.
+ * The lane producer inside it belongs to the RT task from then on; the
+ * owner task only calls stream_handoff_put(), which never blocks: a full
+ * ring refuses the sample and counts it.
+ *
+ * Samples keep whatever tick they carry (REMOTE events are stamped with
+ * their play tick, sample.h), so the up-to-one-tick handoff delay does
+ * not move them.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 2.1.4: Only the RT task claims hot ring slots for foreign lanes
+ * - RULE 3.1.1: head/tail atomics, no locks
+ * - RULE 3.1.4: put never blocks; the drain is bounded per tick
+ */
+
+#ifndef KEYER_STREAM_HANDOFF_H
+#define KEYER_STREAM_HANDOFF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Samples a handoff holds (must be power of 2) */
+#define STREAM_HANDOFF_SIZE 64U
+
+/** Handoffs a table holds */
+#define STREAM_HANDOFF_MAX 4U
+
+/**
+ * @brief One producer's handoff ring
+ */
+typedef struct {
+    stream_producer_t producer;                 /**< Lane writer (RT task once attached) */
+    stream_sample_t ring[STREAM_HANDOFF_SIZE];
+    atomic_uint head;                           /**< Next slot to fill (owner task) */
+    atomic_uint tail;                           /**< Next slot to drain (RT task) */
+    atomic_uint dropped;                        /**< Samples refused on a full ring */
+} stream_handoff_t;
+
+/**
+ * @brief Handoffs the RT task drains
+ */
+typedef struct {
+    atomic_uint count;                                   /**< Slots claimed (may exceed MAX) */
+    _Atomic(stream_handoff_t *) slots[STREAM_HANDOFF_MAX]; /**< NULL until published */
+} stream_handoffs_t;
+
+/** Global table (main/main.c), drained by the RT task */
+extern stream_handoffs_t g_stream_handoffs;
+
+/**
+ * @brief Initialize a handoff (before attaching it)
+ *
+ * @param h Handoff
+ * @param stream Stream the RT task writes its samples to
+ * @param lane Lane stamped into them (not LOCAL)
+ */
+void stream_handoff_init(stream_handoff_t *h, keying_stream_t *stream, stream_lane_t lane);
+
+/**
+ * @brief Hand a sample over (owner task only, never blocks)
+ *
+ * @return false if the ring is full (sample dropped and counted)
+ */
+bool stream_handoff_put(stream_handoff_t *h, stream_sample_t sample);
+
+/**
+ * @brief Write up to max handed-over samples into the stream (RT task)
+ *
+ * @return Samples drained
+ */
+size_t stream_handoff_drain(stream_handoff_t *h, size_t max);
+
+/**
+ * @brief Samples waiting (any task)
+ */
+size_t stream_handoff_pending(const stream_handoff_t *h);
+
+/**
+ * @brief Clear the table
+ */
+void stream_handoffs_init(stream_handoffs_t *t);
+
+/**
+ * @brief Publish a handoff to the RT task
+ *
+ * @return false if the table is full
+ */
+bool stream_handoffs_attach(stream_handoffs_t *t, stream_handoff_t *h);
+
+/**
+ * @brief Drain every handoff, at most max samples in all (RT task, top of tick)
+ *
+ * Keep max within the hard-RT consumer's foreign budget
+ * (HARD_RT_MAX_FOREIGN_PER_TICK) so it reads them all on the same tick.
+ *
+ * @return Samples drained
+ */
+size_t stream_handoffs_drain(stream_handoffs_t *t, size_t max);
+
+/**
+ * @brief Any handoff has samples waiting (RT task, before idle sleep)
+ */
+bool stream_handoffs_pending(const stream_handoffs_t *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_STREAM_HANDOFF_H */
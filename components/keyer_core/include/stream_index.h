@@ -0,0 +1,131 @@
+/**
+ * @file stream_index.h
+ * @brief Time index over stream history: tick -> stream position seek
+ *
+ * History only says when a sample happened by summing every LOCAL sample
+ * and silence marker before it. The index keeps a ring of checkpoints
+ * {stream_idx, abs_pos, abs_tick} written by the edge-extraction stage every
+ * STREAM_INDEX_EVERY_EDGES key edges or STREAM_INDEX_EVERY_MS of stream
+ * time, whichever comes first, so a seek is a binary search plus a short
+ * forward scan instead of a walk over the whole history.
+ *
+ * Single producer (key_edge_stage_run(), bg task), any number of readers.
+ * Readers validate the entries they used against the write index like the
+ * key edge ring; a seek never blocks the producer.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#ifndef KEYER_STREAM_INDEX_H
+#define KEYER_STREAM_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Checkpoint ring capacity (MUST be power of 2) */
+#ifdef CONFIG_KEYER_INTERNAL_RAM_ONLY
+#define STREAM_INDEX_CAPACITY 256
+#else
+#define STREAM_INDEX_CAPACITY 1024
+#endif
+
+/** Checkpoint after this many key edges... */
+#define STREAM_INDEX_EVERY_EDGES 16
+
+/** ...or after this much stream time */
+#define STREAM_INDEX_EVERY_MS 1000
+
+/**
+ * @brief One checkpoint: the LOCAL sample at idx starts at tick
+ */
+typedef struct {
+    size_t   idx;   /**< Stream index */
+    uint64_t pos;   /**< idx as an absolute position (never wraps) */
+    uint64_t tick;  /**< Absolute LOCAL tick at which that sample starts */
+} stream_checkpoint_t;
+
+/**
+ * @brief Checkpoint ring (monotonic in both idx and tick)
+ */
+typedef struct {
+    stream_checkpoint_t buffer[STREAM_INDEX_CAPACITY]; /**< Checkpoints */
+    atomic_size_t write_idx;       /**< Next checkpoint to write (monotonic) */
+    const keying_stream_t *stream; /**< Indexed stream */
+    uint64_t next_tick;            /**< Time-based checkpoint due (producer) */
+    uint32_t edges_since;          /**< Edges since the last checkpoint (producer) */
+    stream_checkpoint_t last;      /**< Last checkpoint written (producer) */
+} stream_index_t;
+
+/**
+ * @brief Initialize an empty index
+ *
+ * @param index Index to initialize
+ * @param stream Stream to index
+ */
+void stream_index_init(stream_index_t *index, const keying_stream_t *stream);
+
+/**
+ * @brief Offer a LOCAL sample position to the index (producer only)
+ *
+ * Writes a checkpoint when enough edges or ticks have gone by since the
+ * last one (or for the first sample). Positions must be offered in stream
+ * order.
+ *
+ * @param index Index handle
+ * @param idx Absolute stream index of the sample
+ * @param tick Absolute LOCAL tick at which it starts
+ * @param edges Key edges produced since the last offer (this sample's included)
+ */
+void stream_index_note(stream_index_t *index, size_t idx, uint64_t tick, uint32_t edges);
+
+/**
+ * @brief Number of checkpoints currently held
+ */
+size_t stream_index_count(const stream_index_t *index);
+
+/**
+ * @brief Find the newest checkpoint at or before a tick
+ *
+ * @param index Index handle
+ * @param tick Absolute LOCAL tick
+ * @param out Checkpoint (valid if true returned)
+ * @return false if the index is empty or tick is older than every checkpoint
+ */
+bool stream_index_find(const stream_index_t *index, uint64_t tick, stream_checkpoint_t *out);
+
+/**
+ * @brief Position a consumer on the sample that covers an absolute tick
+ *
+ * Binary-searches the index, then scans forward from the checkpoint
+ * (reading the archive tier as needed) summing LOCAL ticks.
+ *
+ * @param consumer Consumer to move (unchanged if false returned)
+ * @param index Index of the consumer's stream
+ * @param tick Absolute LOCAL tick to seek to
+ * @param start_tick Tick at which the sample at the new position starts
+ *                   (may be NULL); if tick is ahead of the stream the
+ *                   consumer is left at the write position
+ * @return false if tick is older than the reachable history
+ */
+bool consumer_seek_time(stream_consumer_t *consumer, const stream_index_t *index,
+                        uint64_t tick, uint64_t *start_tick);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_STREAM_INDEX_H */
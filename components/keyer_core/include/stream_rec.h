@@ -0,0 +1,368 @@
+/**
+ * @file stream_rec.h
+ * @brief Long-term keying log on a flash partition
+ *
+ * The stream and its PSRAM archive hold minutes; the recorder keeps whole
+ * sessions. Samples are packed as 16-bit compact records (stream_compact_t,
+ * the archive format) into 4 KB chunks, one flash sector each:
+ *
+ *     stream_rec_header_t (64 bytes) | count compact records
+ *
+ * The partition is a circular log of chunks. Chunk number seq lives in
+ * sector seq % chunks, so sectors are erased and written strictly in turn
+ * and every one wears the same; the oldest chunks are erased, a few
+ * sectors ahead of the writer (STREAM_REC_ERASE_AHEAD), when the log is
+ * full. The records of a chunk are written first and its header last: a
+ * chunk cut short by a reset reads as empty, never as a valid chunk with
+ * garbage records. The CRC covers the header and the records.
+ *
+ * A session is a run of consecutive chunks with the same session number.
+ * The index of sessions is rebuilt at mount from the chunk headers alone,
+ * without reading any records.
+ *
+ * Writes go in slices (write calls) of whole flash pages. The pacer halves
+ * the slice whenever a call took longer than the bound and doubles it
+ * again while calls take under half of it, so the time the flash cache is
+ * off for one call stays near or under the bound. A sector erase cannot be
+ * split; the owner schedules those while the keyer is idle.
+ *
+ * Flash access goes through stream_rec_flash_t (esp_partition on target,
+ * a RAM image in the host tests). Not thread-safe: the owner serializes
+ * every call on a log, including exports.
+ */
+
+#ifndef KEYER_STREAM_REC_H
+#define KEYER_STREAM_REC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sample.h"
+#include "stream_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** One chunk, one flash sector */
+#define STREAM_REC_CHUNK_BYTES 4096U
+
+/** Flash program page: write slices end on page boundaries */
+#define STREAM_REC_PAGE_BYTES 256U
+
+/** Chunk magic ("KRC1" in flash byte order) */
+#define STREAM_REC_MAGIC 0x3143524BU
+
+/**
+ * Chunk format version. Version 1 had a 48-byte header without the
+ * network clock; its chunks do not validate, so such a log mounts empty
+ * and is overwritten in turn.
+ */
+#define STREAM_REC_VERSION 2
+
+/** net_us / net_drift_ppm are valid */
+#define STREAM_REC_FLAG_NET_CLOCK 0x0001U
+
+/** Sessions held in the index (older ones drop out of it first) */
+#define STREAM_REC_MAX_SESSIONS 64
+
+/** Sectors kept erased ahead of the writer */
+#define STREAM_REC_ERASE_AHEAD 4U
+
+/**
+ * @brief Chunk header (64 bytes packed, little-endian)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;       /**< STREAM_REC_MAGIC */
+    uint16_t version;     /**< STREAM_REC_VERSION */
+    uint16_t count;       /**< Compact records that follow */
+    uint32_t seq;         /**< Chunk number, +1 per chunk written */
+    uint32_t session;     /**< Session number */
+    uint32_t tick_us;     /**< Stream tick period */
+    uint32_t crc;         /**< CRC-32 of the header (this field 0) and the records */
+    uint64_t first_tick;  /**< Absolute LOCAL tick of the first record */
+    uint64_t end_tick;    /**< LOCAL tick after the last record */
+    int64_t  unix_us;     /**< Wall clock at first_tick (0 = not set) */
+    int64_t  net_us;      /**< CWNet synced time at first_tick (STREAM_REC_FLAG_NET_CLOCK) */
+    int32_t  net_drift_ppm; /**< Network clock rate relative to the ticks */
+    uint32_t flags;       /**< STREAM_REC_FLAG_* */
+} stream_rec_header_t;
+
+_Static_assert(sizeof(stream_rec_header_t) == 64, "stream_rec_header_t must be 64 bytes");
+
+/** Records per chunk */
+#define STREAM_REC_RECORDS \
+    ((STREAM_REC_CHUNK_BYTES - sizeof(stream_rec_header_t)) / sizeof(stream_compact_t))
+
+/**
+ * @brief One chunk as it sits in flash
+ */
+typedef struct {
+    stream_rec_header_t header;
+    stream_compact_t records[STREAM_REC_RECORDS];
+} stream_rec_chunk_t;
+
+_Static_assert(sizeof(stream_rec_chunk_t) == STREAM_REC_CHUNK_BYTES,
+               "stream_rec_chunk_t must fill one sector");
+
+/**
+ * @brief Flash the log lives in
+ *
+ * Offsets are from the start of the partition. erase clears the one chunk
+ * (sector) at offset. now_us times the calls for the pacer.
+ */
+typedef struct {
+    bool (*read)(void *ctx, size_t offset, void *buf, size_t len);
+    bool (*write)(void *ctx, size_t offset, const void *buf, size_t len);
+    bool (*erase)(void *ctx, size_t offset);
+    int64_t (*now_us)(void *ctx);
+    void *ctx;
+    uint32_t chunks;      /**< Partition size / STREAM_REC_CHUNK_BYTES */
+} stream_rec_flash_t;
+
+/**
+ * @brief One recorded session in the index
+ */
+typedef struct {
+    uint32_t id;          /**< Session number */
+    uint32_t first_seq;   /**< Oldest chunk still in flash */
+    uint32_t chunks;      /**< Consecutive chunks from first_seq */
+    uint32_t tick_us;     /**< Stream tick period */
+    uint64_t first_tick;  /**< LOCAL tick of the oldest record */
+    uint64_t end_tick;    /**< LOCAL tick after the newest record */
+    int64_t  unix_us;     /**< Wall clock at first_tick (0 = not set) */
+} stream_rec_session_t;
+
+/**
+ * @brief Write slice size controller
+ */
+typedef struct {
+    uint32_t bound_us;    /**< Longest a write call should take */
+    uint32_t slice;       /**< Bytes per write call now (pages) */
+    uint32_t worst_us;    /**< Longest write call seen */
+    uint32_t over;        /**< Write calls that took longer than bound_us */
+} stream_rec_pacer_t;
+
+/**
+ * @brief Log state
+ */
+typedef struct {
+    stream_rec_flash_t flash;
+    stream_rec_session_t sessions[STREAM_REC_MAX_SESSIONS]; /**< Oldest first */
+    size_t   session_count;
+    uint32_t head_seq;      /**< Number of the next chunk written */
+    uint32_t erased_seq;    /**< Sectors of chunks [head_seq, erased_seq) are erased */
+    uint32_t next_session;  /**< Number the next session gets */
+
+    const stream_rec_chunk_t *pending;  /**< Chunk being written (NULL = none) */
+    size_t   pending_off;               /**< Next record byte to write */
+
+    stream_rec_pacer_t pacer;
+    uint32_t chunks_written;
+    uint32_t erases;
+    uint32_t errors;        /**< Failed flash calls */
+    uint32_t erase_max_us;  /**< Longest sector erase */
+} stream_rec_log_t;
+
+/** Result of one stream_rec_write_step() */
+typedef enum {
+    STREAM_REC_STEP_IDLE = 0,  /**< No chunk being written */
+    STREAM_REC_STEP_MORE,      /**< Slice written, chunk not complete */
+    STREAM_REC_STEP_DONE,      /**< Header written: the chunk is in the log */
+    STREAM_REC_STEP_ERROR,     /**< Flash call failed, the chunk is abandoned */
+} stream_rec_step_t;
+
+/* ============================================================================
+ * Chunks
+ * ============================================================================ */
+
+/**
+ * @brief Start an empty chunk
+ *
+ * @param c Chunk buffer
+ * @param session Session number
+ * @param tick_us Stream tick period
+ * @param tick Absolute LOCAL tick the first record will start at
+ * @param unix_us Wall clock at tick (0 = not set)
+ */
+void stream_rec_chunk_begin(stream_rec_chunk_t *c, uint32_t session, uint32_t tick_us,
+                            uint64_t tick, int64_t unix_us);
+
+/**
+ * @brief Stamp an empty chunk with the network clock at its first tick
+ *
+ * @param c Chunk started with stream_rec_chunk_begin()
+ * @param clock Network clock snapshot (stream_read_net_clock())
+ */
+void stream_rec_chunk_set_net_clock(stream_rec_chunk_t *c, const stream_net_time_t *clock);
+
+/**
+ * @brief Append one sample
+ *
+ * A LOCAL silence is stored as exact records of at most COMPACT_COUNT_MASK
+ * ticks, and only from end_tick on: when the chunk fills part way through,
+ * add the sample again to the next chunk and it records the rest.
+ *
+ * @param c Chunk
+ * @param s Sample
+ * @param tick Absolute LOCAL tick the sample starts at (timed_consumer_step())
+ * @return false if the chunk is full (a long silence may be added in part)
+ */
+bool stream_rec_chunk_add(stream_rec_chunk_t *c, const stream_sample_t *s, uint64_t tick);
+
+/**
+ * @brief Chunk holds no records
+ */
+static inline bool stream_rec_chunk_empty(const stream_rec_chunk_t *c) {
+    return c->header.count == 0;
+}
+
+/**
+ * @brief Header is one the log wrote (magic, version, sizes)
+ */
+bool stream_rec_header_valid(const stream_rec_header_t *h);
+
+/**
+ * @brief Header and records match the CRC
+ */
+bool stream_rec_chunk_check(const stream_rec_chunk_t *c);
+
+/* ============================================================================
+ * Log
+ * ============================================================================ */
+
+/**
+ * @brief Mount the log: find the newest chunk and index the sessions
+ *
+ * Two passes over the chunk headers. Sectors ahead of the newest chunk are
+ * not trusted to be erased (a write may have been cut short there).
+ *
+ * @param log Log to initialize
+ * @param flash Partition access (copied)
+ * @param bound_us Write call bound for the pacer
+ * @return false if the partition holds no chunk at all (too small)
+ */
+bool stream_rec_mount(stream_rec_log_t *log, const stream_rec_flash_t *flash,
+                      uint32_t bound_us);
+
+/**
+ * @brief Number for a new session
+ */
+uint32_t stream_rec_new_session(stream_rec_log_t *log);
+
+/**
+ * @brief Sectors erased and waiting for the writer
+ */
+static inline uint32_t stream_rec_erased_ahead(const stream_rec_log_t *log) {
+    return log->erased_seq - log->head_seq;
+}
+
+/**
+ * @brief Chunks held in the log (at most flash.chunks)
+ */
+uint32_t stream_rec_used(const stream_rec_log_t *log);
+
+/**
+ * @brief Erase the next sector ahead of the writer
+ *
+ * On a full log this drops the oldest chunk from the index.
+ *
+ * @return false if the erase failed or STREAM_REC_ERASE_AHEAD are erased already
+ */
+bool stream_rec_erase_next(stream_rec_log_t *log);
+
+/**
+ * @brief Start writing a chunk into the next erased sector
+ *
+ * Seals the chunk (seq, CRC). It must stay unchanged until
+ * stream_rec_write_step() returns DONE or ERROR.
+ *
+ * @return false if a chunk is being written or no sector is erased
+ */
+bool stream_rec_write_begin(stream_rec_log_t *log, stream_rec_chunk_t *c);
+
+/**
+ * @brief Write the next slice of the pending chunk
+ *
+ * Records first, in pacer slices, then the header in a call of its own.
+ */
+stream_rec_step_t stream_rec_write_step(stream_rec_log_t *log);
+
+/**
+ * @brief Find a session in the index
+ *
+ * @return Session, or NULL if not in the log
+ */
+const stream_rec_session_t *stream_rec_find_session(const stream_rec_log_t *log,
+                                                    uint32_t id);
+
+/* ============================================================================
+ * Pacer
+ * ============================================================================ */
+
+/**
+ * @brief Start at four pages per call
+ */
+void stream_rec_pacer_init(stream_rec_pacer_t *p, uint32_t bound_us);
+
+/**
+ * @brief Account one write call of bytes that took elapsed_us
+ */
+void stream_rec_pacer_record(stream_rec_pacer_t *p, uint32_t bytes, uint32_t elapsed_us);
+
+/* ============================================================================
+ * Export
+ * ============================================================================ */
+
+/**
+ * @brief Session export as a .cwk recording (stream_export.h)
+ *
+ * Records are expanded back to stream samples; a gap between chunks (the
+ * recorder fell behind the stream) becomes a LOCAL silence marker, so
+ * ticks still sum to the right time. captured_us is the wall clock (Unix
+ * microseconds) at captured_tick when the session had one, otherwise the
+ * time since the session started. The network clock comes from the first
+ * chunk that was recorded while synced, carried back to the first tick.
+ */
+typedef struct {
+    stream_rec_log_t *log;
+    cwk_header_t header;
+    size_t   header_sent;
+    uint32_t session;     /**< Session exported */
+    uint32_t seq;         /**< Chunk being read */
+    uint32_t end_seq;     /**< One past the last chunk */
+    stream_rec_header_t chunk;  /**< Header of the chunk being read */
+    uint32_t record;      /**< Next record of that chunk */
+    uint32_t crc;         /**< Running CRC of that chunk */
+    uint64_t tick;        /**< LOCAL tick reached (gap filling) */
+    uint32_t corrupt;     /**< Chunks whose CRC did not match */
+    bool lost;            /**< A chunk was overwritten while exporting */
+} stream_rec_export_t;
+
+/**
+ * @brief Start exporting a session
+ *
+ * @return false if the session is not in the log
+ */
+bool stream_rec_export_begin(stream_rec_export_t *exp, stream_rec_log_t *log, uint32_t id);
+
+/**
+ * @brief Emit the next piece of the recording
+ *
+ * @param buf Destination (at least sizeof(stream_sample_t))
+ * @return Bytes written, 0 when the recording is complete
+ */
+size_t stream_rec_export_read(stream_rec_export_t *exp, uint8_t *buf, size_t len);
+
+/**
+ * @brief Total recording size in bytes
+ */
+static inline size_t stream_rec_export_size(const stream_rec_export_t *exp) {
+    return sizeof(cwk_header_t) + (size_t)exp->header.sample_count * sizeof(stream_sample_t);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_STREAM_REC_H */
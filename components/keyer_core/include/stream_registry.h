@@ -0,0 +1,163 @@
+/**
+ * @file stream_registry.h
+ * @brief Optional table of stream consumers with live lag telemetry
+ *
+ * A consumer that registers gets a slot and publishes, on each read, its
+ * read position, the lag it saw (worst case and a log2 histogram) and its
+ * drop/overrun counters. Readers (console "stats stream", GET
+ * /api/system/stats) take snapshots at any time, so buffer sizes and poll
+ * rates can be set from measured lag rather than guessed.
+ *
+ * Registration is optional: a stream without a registry, or a consumer
+ * that never registers, costs nothing.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: No locks; every slot has a single writer (its consumer)
+ * - RULE 3.1.4: Publishing is a handful of relaxed stores, safe on rt_task
+ */
+
+#ifndef KEYER_STREAM_REGISTRY_H
+#define KEYER_STREAM_REGISTRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Consumers a registry holds */
+#define STREAM_REGISTRY_MAX 8U
+
+/** Lag histogram bins: 0, 1, 2-3, 4-7, ... , >= 2^(BINS-2) */
+#define STREAM_LAG_HIST_BINS 14U
+
+struct keying_stream;
+
+/**
+ * @brief One registered consumer (written by that consumer only)
+ */
+typedef struct {
+    _Atomic(const char *) name;     /**< NULL until published */
+    atomic_size_t read_idx;         /**< Read position at the start of the last read */
+    atomic_uint max_lag;            /**< Worst lag seen */
+    atomic_uint dropped;            /**< Samples skipped */
+    atomic_uint overruns;           /**< Producer laps (overwritten reads / hard RT faults) */
+    atomic_uint reads;              /**< Lag observations */
+    atomic_uint hist[STREAM_LAG_HIST_BINS]; /**< Lag observations per log2 bin */
+} stream_consumer_entry_t;
+
+/**
+ * @brief Registry (attach to a stream with stream_attach_registry())
+ */
+typedef struct {
+    atomic_uint count;              /**< Slots claimed (may exceed MAX) */
+    stream_consumer_entry_t slots[STREAM_REGISTRY_MAX];
+} stream_registry_t;
+
+/**
+ * @brief Consumer snapshot
+ */
+typedef struct {
+    const char *name;
+    size_t read_idx;
+    size_t lag;                     /**< Lag now, from read_idx */
+    uint32_t max_lag;
+    uint32_t dropped;
+    uint32_t overruns;
+    uint32_t reads;
+    uint32_t hist[STREAM_LAG_HIST_BINS];
+} stream_consumer_info_t;
+
+/**
+ * @brief Clear a registry
+ */
+void stream_registry_init(stream_registry_t *reg);
+
+/**
+ * @brief Attach a registry to a stream (before its consumers start)
+ */
+void stream_attach_registry(struct keying_stream *stream, stream_registry_t *reg);
+
+/**
+ * @brief Claim a slot for a consumer
+ *
+ * @param stream Stream consumed
+ * @param name Consumer name (must outlive the stream)
+ * @param read_idx Consumer's start position
+ * @return Slot, NULL if the stream has no registry or it is full
+ */
+stream_consumer_entry_t *stream_register_consumer(const struct keying_stream *stream,
+                                                  const char *name, size_t read_idx);
+
+/**
+ * @brief Copy the registered consumers in registration order (any task)
+ *
+ * @param stream Stream
+ * @param out Destination
+ * @param max Capacity of out
+ * @return Consumers written (0 if the stream has no registry)
+ */
+size_t stream_registry_snapshot(const struct keying_stream *stream,
+                                stream_consumer_info_t *out, size_t max);
+
+/**
+ * @brief Histogram bin for a lag
+ */
+static inline unsigned stream_lag_bin(size_t lag) {
+    if (lag == 0) {
+        return 0;
+    }
+    unsigned bin = 1;
+    while (lag > 1 && bin < STREAM_LAG_HIST_BINS - 1U) {
+        lag >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+/**
+ * @brief Publish one read (the entry's consumer only; entry may be NULL)
+ *
+ * @param entry Slot from stream_register_consumer()
+ * @param read_idx Read position
+ * @param lag Lag seen before reading
+ * @param dropped Consumer's dropped total
+ */
+static inline void stream_registry_note(stream_consumer_entry_t *entry, size_t read_idx,
+                                        size_t lag, size_t dropped) {
+    if (entry == NULL) {
+        return;
+    }
+    uint32_t lag32 = (lag > UINT32_MAX) ? UINT32_MAX : (uint32_t)lag;
+    atomic_store_explicit(&entry->read_idx, read_idx, memory_order_relaxed);
+    if (lag32 > atomic_load_explicit(&entry->max_lag, memory_order_relaxed)) {
+        atomic_store_explicit(&entry->max_lag, lag32, memory_order_relaxed);
+    }
+    atomic_store_explicit(&entry->dropped, (unsigned)dropped, memory_order_relaxed);
+    atomic_uint *bin = &entry->hist[stream_lag_bin(lag)];
+    atomic_store_explicit(bin, atomic_load_explicit(bin, memory_order_relaxed) + 1U,
+                          memory_order_relaxed);
+    atomic_store_explicit(&entry->reads,
+                          atomic_load_explicit(&entry->reads, memory_order_relaxed) + 1U,
+                          memory_order_relaxed);
+}
+
+/**
+ * @brief Count one producer lap (the entry's consumer only; entry may be NULL)
+ */
+static inline void stream_registry_note_overrun(stream_consumer_entry_t *entry) {
+    if (entry == NULL) {
+        return;
+    }
+    atomic_store_explicit(&entry->overruns,
+                          atomic_load_explicit(&entry->overruns, memory_order_relaxed) + 1U,
+                          memory_order_relaxed);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_STREAM_REGISTRY_H */
@@ -0,0 +1,160 @@
+/**
+ * @file task_stats.h
+ * @brief Per-task CPU and stack high-water history
+ *
+ * Once a second the collector (main/bg_task.c, housekeeping service) feeds
+ * the FreeRTOS run-time counters and stack high-water marks of every task
+ * in; this module turns counter deltas into per-task CPU and per-core idle
+ * shares and keeps the last TASK_STATS_HISTORY seconds in a ring (PSRAM).
+ * Tasks are listed once in a catalog; samples refer to them by index.
+ *
+ * Single writer, lock-free readers (console "stats tasks", GET
+ * /api/system/tasks): samples carry sequence numbers and a reader drops
+ * any the writer lapped while it copied.
+ *
+ * Pure logic, no FreeRTOS calls: the collector converts TaskStatus_t.
+ */
+
+#ifndef KEYER_TASK_STATS_H
+#define KEYER_TASK_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Tasks the catalog holds (later ones are not tracked) */
+#define TASK_STATS_MAX_TASKS 32U
+
+/** Ring slots, one sample per second (the last HISTORY - 1 are readable) */
+#ifdef CONFIG_KEYER_INTERNAL_RAM_ONLY
+#define TASK_STATS_HISTORY 60U
+#else
+#define TASK_STATS_HISTORY 300U
+#endif
+
+/** Task name length, NUL included (configMAX_TASK_NAME_LEN) */
+#define TASK_STATS_NAME_LEN 16U
+
+/** Cores tracked */
+#define TASK_STATS_CORES 2U
+
+/** Core of a task not pinned to one */
+#define TASK_STATS_CORE_ANY 0xFFU
+
+/** Sample value of a task that did not exist at that time */
+#define TASK_STATS_ABSENT 0xFFFFU
+
+/**
+ * @brief One task as the collector sees it
+ */
+typedef struct {
+    uint32_t id;            /**< Unique task number (xTaskNumber) */
+    const char *name;       /**< Task name */
+    uint8_t core;           /**< Pinned core, TASK_STATS_CORE_ANY if none */
+    uint32_t runtime;       /**< Run-time counter (wraps) */
+    uint32_t stack_free;    /**< Stack high-water mark: least free space ever */
+} task_stats_input_t;
+
+/**
+ * @brief Catalog entry
+ */
+typedef struct {
+    char name[TASK_STATS_NAME_LEN];
+    uint32_t id;
+    uint8_t core;
+} task_stats_task_t;
+
+/**
+ * @brief One second of history
+ */
+typedef struct {
+    uint32_t seq;                               /**< Sample number (monotonic) */
+    uint32_t time_s;                            /**< Uptime */
+    uint16_t idle_pm[TASK_STATS_CORES];         /**< Idle share per core, 0-1000 */
+    uint16_t cpu_pm[TASK_STATS_MAX_TASKS];      /**< Per catalog task, 0-1000 of one core */
+    uint16_t stack_free[TASK_STATS_MAX_TASKS];  /**< Per catalog task, clamped to 65534 */
+} task_stats_sample_t;
+
+/**
+ * @brief History
+ */
+typedef struct {
+    task_stats_task_t tasks[TASK_STATS_MAX_TASKS];
+    atomic_uint task_count;                     /**< Catalog entries published */
+    task_stats_sample_t ring[TASK_STATS_HISTORY];
+    atomic_uint head;                           /**< Samples written (monotonic) */
+    /* Writer only */
+    uint32_t prev_runtime[TASK_STATS_MAX_TASKS];
+    uint8_t prev_valid[TASK_STATS_MAX_TASKS];
+    uint32_t prev_total;
+    uint8_t primed;
+} task_stats_t;
+
+/** Global history (main/bg_task.c) */
+extern task_stats_t g_task_stats;
+
+/**
+ * @brief Clear the history
+ */
+void task_stats_init(task_stats_t *ts);
+
+/**
+ * @brief Add one sample
+ *
+ * The first call only primes the counters. A task's share is its counter
+ * delta over the total delta, which is one core's worth of time; idle
+ * shares come from the idle tasks.
+ *
+ * @param ts History
+ * @param time_s Uptime
+ * @param total Total run-time counter (uxTaskGetSystemState)
+ * @param in Every task
+ * @param n Entries in in
+ * @param idle_id Idle task id per core
+ */
+void task_stats_record(task_stats_t *ts, uint32_t time_s, uint32_t total,
+                       const task_stats_input_t *in, size_t n,
+                       const uint32_t idle_id[TASK_STATS_CORES]);
+
+/**
+ * @brief Copy the task catalog (any task)
+ *
+ * @return Entries copied
+ */
+size_t task_stats_tasks(const task_stats_t *ts, task_stats_task_t *out, size_t max);
+
+/**
+ * @brief Sequence number the next sample will get
+ */
+static inline uint32_t task_stats_head(const task_stats_t *ts) {
+    return atomic_load_explicit(&ts->head, memory_order_acquire);
+}
+
+/**
+ * @brief Copy samples from sequence number `since` on (any task)
+ *
+ * Starts at the oldest retained sample if `since` was overwritten or is
+ * ahead of the head.
+ *
+ * @param ts History
+ * @param since First sequence number wanted
+ * @param out Destination
+ * @param max Capacity of out
+ * @return Samples copied, in order
+ */
+size_t task_stats_read(const task_stats_t *ts, uint32_t since,
+                       task_stats_sample_t *out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TASK_STATS_H */
@@ -0,0 +1,120 @@
+/**
+ * @file telemetry.h
+ * @brief Fleet telemetry payloads: metrics batches, fault events, link state
+ *
+ * What the MQTT publisher (keyer_telemetry) sends, kept free of the
+ * client so the host tests can check it:
+ * - metrics: the whole registry (metrics_render_json()) as one message
+ *   per interval, numbered so a collector sees lost batches
+ * - faults: one message per fault log event, as soon as it is recorded
+ * - link: WiFi, VPN and CWNet state, whenever one of them changes
+ *
+ * The publisher calls these from the net service between its other
+ * checks; nothing here blocks or allocates.
+ */
+
+#ifndef KEYER_TELEMETRY_H
+#define KEYER_TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "metrics.h"
+#include "fault.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Shortest batch interval (system.mqtt_interval_s) */
+#define TELEMETRY_INTERVAL_MIN_S 5U
+
+/**
+ * @brief Link state as published (codes compared, names sent)
+ */
+typedef struct {
+    uint8_t wifi;             /**< wifi_state_t */
+    uint8_t vpn;              /**< vpn_state_t */
+    uint8_t cwnet;            /**< cwnet_socket_state_t */
+    const char *wifi_str;
+    const char *vpn_str;
+    const char *cwnet_str;
+} telemetry_link_t;
+
+/**
+ * @brief Publisher state
+ */
+typedef struct {
+    int64_t next_batch_us;    /**< Next metrics batch, 0 = at the next check */
+    uint32_t batch_seq;       /**< Batches rendered */
+    unsigned fault_next;      /**< Fault log events handled (fault_log_read()) */
+    uint32_t faults_lost;     /**< Overwritten before they were published */
+    uint32_t link_key;        /**< Link state last published, UINT32_MAX = none */
+} telemetry_t;
+
+/**
+ * @brief Start with no link state published and every logged fault pending
+ */
+void telemetry_init(telemetry_t *t);
+
+/**
+ * @brief After a (re)connect: link state and a batch go out at once
+ */
+void telemetry_resync(telemetry_t *t);
+
+/**
+ * @brief Is a metrics batch due?
+ *
+ * @param interval_s Batch interval (raised to TELEMETRY_INTERVAL_MIN_S)
+ * @return true once per interval; the next one is scheduled from now_us
+ */
+bool telemetry_batch_due(telemetry_t *t, int64_t now_us, uint32_t interval_s);
+
+/**
+ * @brief Render a metrics batch
+ *
+ * {"seq":12,"up":360,"faults_lost":0,"m":{...}}
+ *
+ * @return Length written, 0 if it does not fit (the batch is still counted)
+ */
+size_t telemetry_render_batch(telemetry_t *t, const metrics_t *m, int64_t now_us,
+                              char *buf, size_t cap);
+
+/**
+ * @brief Take fault events not yet published, oldest first
+ *
+ * @return Events written to out
+ */
+size_t telemetry_take_faults(telemetry_t *t, const fault_log_t *log,
+                             fault_event_t *out, size_t max);
+
+/**
+ * @brief Render one fault event
+ *
+ * {"up_ms":1234,"event":"raised","code":"...","data":3}
+ *
+ * @return Length written, 0 if it does not fit
+ */
+size_t telemetry_render_fault(const fault_event_t *ev, char *buf, size_t cap);
+
+/**
+ * @brief Did the link state change since it was last published?
+ *
+ * Marks it published: call only when the message will be sent.
+ */
+bool telemetry_link_changed(telemetry_t *t, const telemetry_link_t *link);
+
+/**
+ * @brief Render the link state
+ *
+ * {"wifi":"connected","vpn":"disabled","cwnet":"ready"}
+ *
+ * @return Length written, 0 if it does not fit
+ */
+size_t telemetry_render_link(const telemetry_link_t *link, char *buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TELEMETRY_H */
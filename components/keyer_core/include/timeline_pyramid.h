@@ -0,0 +1,183 @@
+/**
+ * @file timeline_pyramid.h
+ * @brief Multi-resolution key history for zoomed-out timeline views
+ *
+ * The live WebUI timeline gets every edge; a view of the last minutes
+ * would need thousands of them. The pyramid summarises the key edge
+ * stream as it arrives into fixed-width buckets at three resolutions
+ * (10 ms, 100 ms, 1 s). Each bucket holds, per channel (key, dit, dah),
+ * the time spent down, the number of edges and the lowest and highest
+ * level seen, so a column of pixels can be drawn from one bucket (or a
+ * few merged) instead of from the edges under it.
+ *
+ * Each level is a ring of TIMELINE_PYRAMID_CAPACITY buckets, so the
+ * coarser the level the further back it reaches (about 40 s, 7 min and
+ * 68 min; 2.5 s, 25 s and 4 min in internal RAM only builds). A range query picks the finest level that both still holds
+ * the start of the range and needs no more buckets than pixels, and
+ * merges buckets into columns when even the coarsest one needs more.
+ *
+ * Single producer (the decoder service, which runs the edge stage), any
+ * number of readers. Only closed buckets are published, through a
+ * per-level head; readers check the head again after copying a bucket,
+ * like the key edge ring, so a query never blocks the producer.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#ifndef KEYER_TIMELINE_PYRAMID_H
+#define KEYER_TIMELINE_PYRAMID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Resolutions */
+#define TIMELINE_PYRAMID_LEVELS 3
+
+/** Channels summarised: key_edge_channel_t KEY, DIT, DAH */
+#define TIMELINE_PYRAMID_CHANNELS 3
+
+/** Buckets per level (MUST be power of 2) */
+#ifdef CONFIG_KEYER_INTERNAL_RAM_ONLY
+#define TIMELINE_PYRAMID_CAPACITY 256
+#else
+#define TIMELINE_PYRAMID_CAPACITY 4096
+#endif
+
+/** Bucket width of level 0; each level is 10x the one below */
+#define TIMELINE_PYRAMID_BASE_US 10000
+
+/**
+ * @brief One bucket of one level
+ */
+typedef struct {
+    uint32_t down_us[TIMELINE_PYRAMID_CHANNELS]; /**< Time spent down */
+    uint16_t edges[TIMELINE_PYRAMID_CHANNELS];   /**< Level changes (saturating) */
+    uint8_t lo;     /**< Bit per channel: down for the whole bucket */
+    uint8_t hi;     /**< Bit per channel: down at some point */
+} timeline_bucket_t;
+
+/**
+ * @brief One resolution
+ */
+typedef struct {
+    timeline_bucket_t buffer[TIMELINE_PYRAMID_CAPACITY];
+    atomic_uint_least32_t head;   /**< Bucket number after the newest closed one */
+    atomic_uint_least32_t first;  /**< Oldest bucket written (stored before head moves) */
+    uint32_t open;                /**< Bucket being filled (producer) */
+    timeline_bucket_t cur;        /**< Its contents so far (producer) */
+} timeline_level_t;
+
+/**
+ * @brief The pyramid
+ */
+typedef struct {
+    timeline_level_t level[TIMELINE_PYRAMID_LEVELS];
+    int64_t now_us;      /**< Time accounted up to (producer) */
+    uint8_t down;        /**< Bit per channel: current level (producer) */
+    bool started;        /**< now_us is valid (producer) */
+} timeline_pyramid_t;
+
+/**
+ * @brief One output column
+ */
+typedef struct {
+    int64_t start_us;                                /**< Column start */
+    uint16_t duty_pm[TIMELINE_PYRAMID_CHANNELS];     /**< Down time, per mille of the column */
+    uint32_t edges[TIMELINE_PYRAMID_CHANNELS];
+    uint8_t lo;                                      /**< AND of the buckets' lo */
+    uint8_t hi;                                      /**< OR of the buckets' hi */
+    bool valid;                                      /**< False if any bucket is not held */
+} timeline_column_t;
+
+/**
+ * @brief Range query in progress
+ */
+typedef struct {
+    uint8_t level;           /**< Level read */
+    uint32_t res_us;         /**< Its bucket width */
+    uint32_t per_column;     /**< Buckets merged into one column */
+    uint32_t next;           /**< Next bucket number to read */
+    uint32_t end;            /**< Bucket number after the range */
+    uint32_t columns;        /**< Columns in the range */
+} timeline_range_t;
+
+/**
+ * @brief Initialize an empty pyramid
+ */
+void timeline_pyramid_init(timeline_pyramid_t *p);
+
+/**
+ * @brief Account for time passing with no edge (producer only)
+ *
+ * Closes every bucket that ended before now_us. The first call starts
+ * the pyramid. Times before the last one are ignored.
+ *
+ * @param p Pyramid
+ * @param now_us Time (esp_timer base) every edge before which was fed
+ */
+void timeline_pyramid_advance(timeline_pyramid_t *p, int64_t now_us);
+
+/**
+ * @brief Feed one edge (producer only, in time order)
+ *
+ * @param p Pyramid
+ * @param time_us Edge time (esp_timer base)
+ * @param channel Channel (< TIMELINE_PYRAMID_CHANNELS, others ignored)
+ * @param level New level (1 = down)
+ */
+void timeline_pyramid_edge(timeline_pyramid_t *p, int64_t time_us, uint8_t channel,
+                           uint8_t level);
+
+/**
+ * @brief Bucket width of a level
+ */
+uint32_t timeline_pyramid_res_us(uint8_t level);
+
+/**
+ * @brief End of the published history (start of the open 10 ms bucket)
+ *
+ * @return 0 before the first bucket closed
+ */
+int64_t timeline_pyramid_end_us(const timeline_pyramid_t *p);
+
+/**
+ * @brief Plan a query for [from_us, to_us) drawn px columns wide
+ *
+ * The range is clamped to the published history of the chosen level and
+ * its start rounded down to a bucket.
+ *
+ * @param p Pyramid
+ * @param from_us Range start
+ * @param to_us Range end
+ * @param px Columns wanted (at least 1)
+ * @param it Query state for timeline_pyramid_range_next()
+ * @return Columns the query produces (may be fewer than px, 0 if empty)
+ */
+uint32_t timeline_pyramid_range_begin(const timeline_pyramid_t *p, int64_t from_us,
+                                      int64_t to_us, uint32_t px, timeline_range_t *it);
+
+/**
+ * @brief Produce the next column
+ *
+ * @return false once every column was produced
+ */
+bool timeline_pyramid_range_next(const timeline_pyramid_t *p, timeline_range_t *it,
+                                 timeline_column_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TIMELINE_PYRAMID_H */
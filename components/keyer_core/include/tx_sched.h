@@ -0,0 +1,115 @@
+/**
+ * @file tx_sched.h
+ * @brief Planning of hardware-timed TX edges (CONFIG_KEYER_TX_TIMED)
+ *
+ * The RT task sees a key edge up to one tick after it happened, but it
+ * knows when it happened: the iambic FSM element boundary. Instead of
+ * setting the TX pin on the tick, each edge is handed to a hardware timer
+ * for edge time + lead_us. With lead_us a tick plus a guard, every edge is
+ * still in the future when it is queued, so TX element lengths are exact
+ * whatever the tick rate or task jitter; TX just lags by a constant.
+ *
+ * An edge that would land less than guard_us from now (tick later than
+ * the guard covers) goes out at now + guard_us and is counted late.
+ *
+ * tx_sched_plan_delayed() adds a per-edge delay on top of the lead, e.g.
+ * the paddle PTT lead: TX follows PTT by that much for paddle keying only.
+ *
+ * Writer: RT task only. Readers (console) see relaxed atomics.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Relaxed atomics, no locks, nothing allocated
+ * - RULE 3.1.4: A few compares per edge
+ */
+
+#ifndef KEYER_TX_SCHED_H
+#define KEYER_TX_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Headroom over one tick of detection delay */
+#define TX_SCHED_GUARD_US 250U
+
+/**
+ * @brief TX edge planner
+ */
+typedef struct {
+    /* RT task only */
+    uint32_t lead_us;           /**< Key edge → TX output delay */
+    uint32_t guard_us;          /**< Output never closer to now than this */
+    bool level;                 /**< Level after the last planned edge */
+    int64_t last_at_us;         /**< Output time of the last planned edge */
+
+    /* Statistics (RT task writes, any task reads) */
+    atomic_uint edges;          /**< Edges planned */
+    atomic_uint late;           /**< Edges pushed back to now + guard */
+    atomic_uint late_max_us;    /**< Largest push-back */
+} tx_sched_t;
+
+/**
+ * @brief Snapshot of the statistics
+ */
+typedef struct {
+    uint32_t lead_us;
+    uint32_t edges;
+    uint32_t late;
+    uint32_t late_max_us;
+} tx_sched_stats_t;
+
+/** Global planner (RT task writes, console reads) */
+extern tx_sched_t g_tx_sched;
+
+/**
+ * @brief Initialize (key up, statistics cleared)
+ *
+ * @param s Planner
+ * @param lead_us Key edge → TX output delay (one tick + guard)
+ * @param guard_us Least time ahead of now an edge is queued
+ */
+void tx_sched_init(tx_sched_t *s, uint32_t lead_us, uint32_t guard_us);
+
+/**
+ * @brief Plan the TX output for this tick's key state (RT task, every tick)
+ *
+ * @param s Planner
+ * @param on Key state
+ * @param edge_us Time the key state changed (ignored if it did not)
+ * @param now_us Current time
+ * @return Output time of the edge, or 0 if the level is unchanged
+ */
+int64_t tx_sched_plan(tx_sched_t *s, bool on, int64_t edge_us, int64_t now_us);
+
+/**
+ * @brief As tx_sched_plan(), with the edge delay_us later still
+ *
+ * @param s Planner
+ * @param on Key state
+ * @param edge_us Time the key state changed (ignored if it did not)
+ * @param delay_us Added to the lead for this edge
+ * @param now_us Current time
+ * @return Output time of the edge, or 0 if the level is unchanged
+ */
+int64_t tx_sched_plan_delayed(tx_sched_t *s, bool on, int64_t edge_us,
+                              uint32_t delay_us, int64_t now_us);
+
+/**
+ * @brief Forget the planned level after TX was forced off (fault)
+ */
+void tx_sched_reset_level(tx_sched_t *s);
+
+/**
+ * @brief Snapshot the statistics (any task)
+ */
+void tx_sched_get(const tx_sched_t *s, tx_sched_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TX_SCHED_H */
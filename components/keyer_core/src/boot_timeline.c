@@ -0,0 +1,91 @@
+/**
+ * @file boot_timeline.c
+ * @brief Boot-phase timeline
+ *
+ * A slot is claimed with fetch_add, filled, then published by its state
+ * (release); readers copy only what the state says is there. end_us is
+ * written before the DONE state, so a reader never sees half of it.
+ */
+
+#include "boot_timeline.h"
+#include <string.h>
+
+#define SLOT_CLAIMED 0U
+#define SLOT_RUNNING 1U
+#define SLOT_DONE    2U
+
+void boot_timeline_init(boot_timeline_t *tl, const boot_heap_t *heap) {
+    memset(tl, 0, sizeof(*tl));
+    atomic_init(&tl->count, 0U);
+    for (size_t i = 0; i < BOOT_TIMELINE_MAX; i++) {
+        atomic_init(&tl->slots[i].state, SLOT_CLAIMED);
+    }
+    if (heap != NULL) {
+        tl->heap_start = *heap;
+    }
+    atomic_init(&tl->heap_last_internal, tl->heap_start.internal);
+    atomic_init(&tl->heap_last_psram, tl->heap_start.psram);
+}
+
+int boot_phase_begin(boot_timeline_t *tl, const char *name, uint8_t core, int64_t now_us,
+                     const boot_heap_t *heap) {
+    unsigned id = atomic_fetch_add_explicit(&tl->count, 1U, memory_order_relaxed);
+    if (id >= BOOT_TIMELINE_MAX) {
+        return -1;
+    }
+    boot_timeline_slot_t *slot = &tl->slots[id];
+    slot->phase.name = name;
+    slot->phase.start_us = now_us;
+    slot->phase.end_us = 0;
+    slot->phase.core = core;
+    slot->phase.heap_start = (heap != NULL) ? *heap : (boot_heap_t){ 0, 0 };
+    slot->phase.internal_used = 0;
+    slot->phase.psram_used = 0;
+    atomic_store_explicit(&slot->state, SLOT_RUNNING, memory_order_release);
+    return (int)id;
+}
+
+void boot_phase_end(boot_timeline_t *tl, int id, int64_t now_us, const boot_heap_t *heap) {
+    if (id < 0 || (unsigned)id >= BOOT_TIMELINE_MAX) {
+        return;
+    }
+    boot_timeline_slot_t *slot = &tl->slots[id];
+    slot->phase.end_us = now_us;
+    if (heap != NULL) {
+        slot->phase.internal_used = (int32_t)(slot->phase.heap_start.internal - heap->internal);
+        slot->phase.psram_used = (int32_t)(slot->phase.heap_start.psram - heap->psram);
+        atomic_store_explicit(&tl->heap_last_internal, heap->internal, memory_order_relaxed);
+        atomic_store_explicit(&tl->heap_last_psram, heap->psram, memory_order_relaxed);
+    }
+    atomic_store_explicit(&slot->state, SLOT_DONE, memory_order_release);
+}
+
+size_t boot_timeline_snapshot(const boot_timeline_t *tl, boot_phase_t *out, size_t max) {
+    unsigned count = atomic_load_explicit(&tl->count, memory_order_relaxed);
+    if (count > BOOT_TIMELINE_MAX) {
+        count = BOOT_TIMELINE_MAX;
+    }
+
+    size_t n = 0;
+    for (unsigned i = 0; i < count && n < max; i++) {
+        const boot_timeline_slot_t *slot = &tl->slots[i];
+        unsigned state = atomic_load_explicit(&slot->state, memory_order_acquire);
+        if (state == SLOT_CLAIMED) {
+            continue;
+        }
+        out[n] = slot->phase;
+        if (state != SLOT_DONE) {
+            out[n].end_us = 0;
+        }
+        n++;
+    }
+    return n;
+}
+
+void boot_timeline_heap_used(const boot_timeline_t *tl, int32_t *internal_used,
+                             int32_t *psram_used) {
+    uint32_t internal = atomic_load_explicit(&tl->heap_last_internal, memory_order_relaxed);
+    uint32_t psram = atomic_load_explicit(&tl->heap_last_psram, memory_order_relaxed);
+    *internal_used = (int32_t)(tl->heap_start.internal - internal);
+    *psram_used = (int32_t)(tl->heap_start.psram - psram);
+}
@@ -27,6 +27,79 @@ void hard_rt_consumer_init(hard_rt_consumer_t *consumer,
     consumer->fault = fault;
     consumer->read_idx = stream_write_position(stream);
     consumer->max_lag = max_lag;
+    consumer->remote_key = 0;
+    consumer->remote = NULL;
+    consumer->recovery = (hard_rt_recovery_t){0};
+    consumer->ticks = 0;
+    consumer->seen_faults = fault_get_count(fault);
+    consumer->clean = 0;
+    consumer->window_start = 0;
+    consumer->window_faults = 0;
+    consumer->recoveries = 0;
+    consumer->latched = false;
+    consumer->entry = NULL;
+}
+
+void hard_rt_consumer_set_recovery(hard_rt_consumer_t *consumer,
+                                   const hard_rt_recovery_t *recovery) {
+    assert(consumer != NULL);
+    assert(recovery != NULL);
+
+    consumer->recovery = *recovery;
+}
+
+/**
+ * @brief Count faults raised since the last look against the latch window
+ */
+static void hard_rt_note_faults(hard_rt_consumer_t *consumer) {
+    uint32_t count = fault_get_count(consumer->fault);
+    if (count == consumer->seen_faults) {
+        return;
+    }
+
+    if (consumer->ticks - consumer->window_start > consumer->recovery.latch_window) {
+        consumer->window_start = consumer->ticks;
+        consumer->window_faults = 0;
+    }
+    consumer->window_faults += count - consumer->seen_faults;
+    consumer->seen_faults = count;
+    consumer->clean = 0;
+
+    if (consumer->recovery.latch_after > 0 &&
+        consumer->window_faults >= consumer->recovery.latch_after) {
+        consumer->latched = true;
+    }
+}
+
+/**
+ * @brief One tick with the fault active: stay silent or recover
+ */
+static hard_rt_result_t hard_rt_hold(hard_rt_consumer_t *consumer) {
+    hard_rt_note_faults(consumer);
+    if (consumer->latched || consumer->recovery.clean_ticks == 0) {
+        return HARD_RT_FAULT;
+    }
+
+    /* Nothing pushed while silenced is ever played */
+    consumer->read_idx = stream_write_position(consumer->stream);
+    if (++consumer->clean < consumer->recovery.clean_ticks) {
+        return HARD_RT_FAULT;
+    }
+
+    fault_clear(consumer->fault);
+    consumer->clean = 0;
+    consumer->recoveries++;
+    return HARD_RT_RECOVERED;
+}
+
+void hard_rt_consumer_set_remote(hard_rt_consumer_t *consumer, remote_tx_t *remote) {
+    assert(consumer != NULL);
+    consumer->remote = remote;
+}
+
+void hard_rt_consumer_register(hard_rt_consumer_t *consumer, const char *name) {
+    assert(consumer != NULL);
+    consumer->entry = stream_register_consumer(consumer->stream, name, consumer->read_idx);
 }
 
 hard_rt_result_t hard_rt_consumer_tick(hard_rt_consumer_t *consumer,
@@ -34,40 +107,79 @@ hard_rt_result_t hard_rt_consumer_tick(hard_rt_consumer_t *consumer,
     assert(consumer != NULL);
     assert(out != NULL);
 
+    consumer->ticks++;
+
     /* Check if already faulted */
     if (fault_is_active(consumer->fault)) {
-        return HARD_RT_FAULT;
+        return hard_rt_hold(consumer);
     }
 
-    /* Check lag */
-    size_t lag = stream_lag(consumer->stream, consumer->read_idx);
-
-    if (lag > consumer->max_lag) {
-        /* FAULT: latency exceeded */
-        fault_set(consumer->fault, FAULT_LATENCY_EXCEEDED, (uint32_t)lag);
-        return HARD_RT_FAULT;
+    if (consumer->latched) {
+        /* Cleared elsewhere: what queued up behind the latch is stale */
+        consumer->latched = false;
+        consumer->window_faults = 0;
+        consumer->seen_faults = fault_get_count(consumer->fault);
+        consumer->read_idx = stream_write_position(consumer->stream);
     }
 
-    if (lag == 0) {
-        /* Caught up - no new data */
-        return HARD_RT_NO_DATA;
-    }
+    for (size_t foreign = 0; foreign <= HARD_RT_MAX_FOREIGN_PER_TICK; foreign++) {
+        /* Check lag */
+        size_t lag = stream_lag(consumer->stream, consumer->read_idx);
+        if (foreign == 0) {
+            stream_registry_note(consumer->entry, consumer->read_idx, lag, 0);
+        }
 
-    /* Check for overrun (buffer wrapped) */
-    if (stream_is_overrun(consumer->stream, consumer->read_idx)) {
-        fault_set(consumer->fault, FAULT_OVERRUN, (uint32_t)lag);
-        return HARD_RT_FAULT;
-    }
+        if (lag > consumer->max_lag) {
+            /* FAULT: latency exceeded */
+            fault_set(consumer->fault, FAULT_LATENCY_EXCEEDED, (uint32_t)lag);
+            stream_registry_note_overrun(consumer->entry);
+            return HARD_RT_FAULT;
+        }
 
-    /* Read sample */
-    if (!stream_read(consumer->stream, consumer->read_idx, out)) {
-        /* Should not happen if lag > 0 and not overrun */
-        fault_set(consumer->fault, FAULT_OVERRUN, (uint32_t)lag);
-        return HARD_RT_FAULT;
+        if (lag == 0) {
+            /* Caught up - no new data */
+            return HARD_RT_NO_DATA;
+        }
+
+        /* Check for overrun (buffer wrapped) */
+        if (stream_is_overrun(consumer->stream, consumer->read_idx)) {
+            fault_set(consumer->fault, FAULT_OVERRUN, (uint32_t)lag);
+            stream_registry_note_overrun(consumer->entry);
+            return HARD_RT_FAULT;
+        }
+
+        /* Read sample */
+        stream_sample_t s;
+        stream_read_result_t res = stream_read_slot(consumer->stream, consumer->read_idx, &s);
+        if (res == STREAM_READ_EMPTY) {
+            /* Another lane claimed the slot but has not committed it yet */
+            return HARD_RT_NO_DATA;
+        }
+        if (res == STREAM_READ_OVERWRITTEN) {
+            /* Producer lapped us between the lag check and the copy */
+            fault_set(consumer->fault, FAULT_OVERRUN, (uint32_t)lag);
+            stream_registry_note_overrun(consumer->entry);
+            return HARD_RT_FAULT;
+        }
+
+        consumer->read_idx++;
+
+        if (sample_lane(&s) == STREAM_LANE_LOCAL) {
+            *out = s;
+            return HARD_RT_OK;
+        }
+
+        /* Foreign lane: never drives TX */
+        if (sample_lane(&s) == STREAM_LANE_REMOTE && !sample_is_silence(&s)) {
+            consumer->remote_key = s.local_key;
+            if (consumer->remote != NULL) {
+                remote_tx_event(consumer->remote, s.local_key != 0, sample_event_tick32(&s));
+            }
+        }
     }
 
-    consumer->read_idx++;
-    return HARD_RT_OK;
+    /* Burst of foreign slots: finish it on the next tick */
+    return HARD_RT_NO_DATA;
 }
 
 void hard_rt_consumer_resync(hard_rt_consumer_t *consumer) {
@@ -94,47 +206,187 @@ void best_effort_consumer_init(best_effort_consumer_t *consumer,
     consumer->stream = stream;
     consumer->read_idx = stream_write_position(stream);
     consumer->dropped = 0;
+    consumer->overwritten = 0;
     consumer->skip_threshold = skip_threshold;
+    consumer->condensed = 0;
+    consumer->catch_up_end = 0;
+    consumer->catch_up_ticks = 0;
+    consumer->catching_up = false;
+    consumer->entry = NULL;
 }
 
-bool best_effort_consumer_tick(best_effort_consumer_t *consumer,
-                               stream_sample_t *out) {
+void best_effort_consumer_register(best_effort_consumer_t *consumer, const char *name) {
     assert(consumer != NULL);
-    assert(out != NULL);
+    consumer->entry = stream_register_consumer(consumer->stream, name, consumer->read_idx);
+}
 
+/** Where a skip or catch-up ends: near-latest, keeping a 2 sample buffer */
+static size_t best_effort_near_latest(const best_effort_consumer_t *consumer) {
+    size_t pos = stream_write_position(consumer->stream);
+    return (pos > 2) ? pos - 2 : pos;
+}
+
+/**
+ * @brief Apply overrun / skip_threshold handling
+ *
+ * @param condense Past the threshold, enter catch-up instead of skipping
+ * @return Lag after any skip (0 = nothing to read)
+ */
+static size_t best_effort_catch_up(best_effort_consumer_t *consumer, bool condense) {
     /* Check lag */
     size_t lag = stream_lag(consumer->stream, consumer->read_idx);
+    stream_registry_note(consumer->entry, consumer->read_idx, lag, consumer->dropped);
 
     if (lag == 0) {
         /* Caught up - no new data */
-        return false;
+        return 0;
     }
 
-    /* Check for overrun or lag threshold exceeded */
-    if (stream_is_overrun(consumer->stream, consumer->read_idx) ||
-        (consumer->skip_threshold > 0 && lag > consumer->skip_threshold)) {
-        /* Skip to near-latest, keep some buffer for smooth operation */
-        size_t skip_to = stream_write_position(consumer->stream);
-        if (skip_to > 2) {
-            skip_to -= 2;  /* Keep 2 samples buffer */
+    bool overrun = stream_is_overrun(consumer->stream, consumer->read_idx);
+    bool behind = consumer->skip_threshold > 0 && lag > consumer->skip_threshold;
+    if (!overrun && behind && condense) {
+        /* Still readable: scan through to near-latest keeping the edges */
+        if (!consumer->catching_up) {
+            consumer->catching_up = true;
+            consumer->catch_up_ticks = 0;
         }
+        consumer->catch_up_end = best_effort_near_latest(consumer);
+    } else if (overrun || behind) {
+        /* Skip to near-latest, keep some buffer for smooth operation */
+        size_t skip_to = best_effort_near_latest(consumer);
 
         size_t skipped = skip_to - consumer->read_idx;
         consumer->dropped += skipped;
         consumer->read_idx = skip_to;
+        consumer->catching_up = false;
+        consumer->catch_up_ticks = 0;
+        if (overrun) {
+            stream_registry_note_overrun(consumer->entry);
+        }
 
         /* Recalculate lag after skip */
         lag = stream_lag(consumer->stream, consumer->read_idx);
-        if (lag == 0) {
+    }
+
+    return lag;
+}
+
+/** A sample catch-up can fold away: it changes no state */
+static bool best_effort_foldable(const stream_sample_t *s) {
+    if (sample_is_silence(s)) {
+        return true;  /* Idle run (any lane) */
+    }
+    return sample_lane(s) == STREAM_LANE_LOCAL &&
+           (s->flags & (uint8_t)~FLAG_LANE_MASK) == 0;
+}
+
+/**
+ * @brief Return folded LOCAL ticks as one silence marker
+ */
+static bool best_effort_flush_ticks(best_effort_consumer_t *consumer, stream_sample_t *out) {
+    if (consumer->catch_up_ticks == 0) {
+        return false;
+    }
+    *out = sample_silence(consumer->catch_up_ticks);
+    consumer->catch_up_ticks = 0;
+    return true;
+}
+
+/**
+ * @brief One catch-up read: the next state change, or the ticks before it
+ *
+ * @param ref_tick LOCAL tick at read_idx before folding (0 if unknown)
+ * @return true if out holds a sample
+ */
+static bool best_effort_condense(best_effort_consumer_t *consumer, uint64_t ref_tick,
+                                 stream_sample_t *out) {
+    for (unsigned scanned = 0; scanned < BEST_EFFORT_CATCH_UP_SCAN; scanned++) {
+        if (consumer->read_idx >= consumer->catch_up_end) {
+            /* Caught up: normal reads resume after the folded ticks */
+            consumer->catching_up = false;
+            return best_effort_flush_ticks(consumer, out);
+        }
+
+        stream_sample_t s;
+        stream_read_result_t res = stream_read_slot_at(consumer->stream, consumer->read_idx,
+                                                       ref_tick + consumer->catch_up_ticks, &s);
+        if (res == STREAM_READ_EMPTY) {
+            /* Uncommitted slot: wait for it, ticks so far are exact */
+            return best_effort_flush_ticks(consumer, out);
+        }
+        if (res == STREAM_READ_OVERWRITTEN) {
+            /* Lapped while catching up after all - count it and resync */
+            size_t write_pos = stream_write_position(consumer->stream);
+            consumer->dropped += write_pos - consumer->read_idx;
+            consumer->overwritten++;
+            stream_registry_note_overrun(consumer->entry);
+            consumer->read_idx = write_pos;
+            consumer->catching_up = false;
+            consumer->catch_up_ticks = 0;
             return false;
         }
+
+        /* Ticks go out before the change they lead up to */
+        if (!best_effort_foldable(&s)) {
+            if (best_effort_flush_ticks(consumer, out)) {
+                return true;
+            }
+            *out = s;
+            consumer->read_idx++;
+            return true;
+        }
+
+        if (sample_lane(&s) == STREAM_LANE_LOCAL) {
+            uint32_t ticks = sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+            if (ticks > SAMPLE_SILENCE_MAX_TICKS - consumer->catch_up_ticks) {
+                return best_effort_flush_ticks(consumer, out);  /* Full marker */
+            }
+            consumer->catch_up_ticks += ticks;
+        }
+        consumer->read_idx++;
+        consumer->condensed++;
+    }
+
+    /* Scan budget spent: hand out what was folded, continue next call */
+    return best_effort_flush_ticks(consumer, out);
+}
+
+/**
+ * @brief best_effort_consumer_tick() for a reader that tracks the LOCAL tick
+ *
+ * @param ref_tick LOCAL tick at read_idx, unwraps archived REMOTE ticks
+ *                 (0 if unknown)
+ */
+static bool best_effort_next(best_effort_consumer_t *consumer, uint64_t ref_tick,
+                             stream_sample_t *out) {
+    if (best_effort_catch_up(consumer, true) == 0) {
+        return false;
+    }
+    if (consumer->catching_up) {
+        if (best_effort_condense(consumer, ref_tick, out)) {
+            return true;
+        }
+        if (consumer->catching_up ||
+            stream_lag(consumer->stream, consumer->read_idx) == 0) {
+            return false;
+        }
+        /* Caught up with no ticks folded: read normally */
     }
 
     /* Read sample */
-    if (!stream_read(consumer->stream, consumer->read_idx, out)) {
-        /* Buffer might have wrapped during our calculations - skip again */
-        consumer->read_idx = stream_write_position(consumer->stream);
-        consumer->dropped++;
+    stream_read_result_t res = stream_read_slot_at(consumer->stream, consumer->read_idx,
+                                                   ref_tick, out);
+    if (res == STREAM_READ_EMPTY) {
+        /* Another lane claimed the slot but has not committed it yet */
+        return false;
+    }
+    if (res == STREAM_READ_OVERWRITTEN) {
+        /* Producer lapped us during the read - count it and resync */
+        size_t write_pos = stream_write_position(consumer->stream);
+        consumer->dropped += write_pos - consumer->read_idx;
+        consumer->overwritten++;
+        stream_registry_note_overrun(consumer->entry);
+        consumer->read_idx = write_pos;
         return false;
     }
 
@@ -142,7 +394,163 @@ bool best_effort_consumer_tick(best_effort_consumer_t *consumer,
     return true;
 }
 
+bool best_effort_consumer_tick(best_effort_consumer_t *consumer,
+                               stream_sample_t *out) {
+    assert(consumer != NULL);
+    assert(out != NULL);
+
+    return best_effort_next(consumer, 0, out);
+}
+
+size_t best_effort_consumer_next_span(best_effort_consumer_t *consumer,
+                                      const stream_slot_t **a, size_t *na,
+                                      const stream_slot_t **b, size_t *nb,
+                                      size_t max) {
+    assert(consumer != NULL);
+
+    /* Span readers never catch up (a consumer reads samples or spans) */
+    consumer->catching_up = false;
+    consumer->catch_up_ticks = 0;
+    if (best_effort_catch_up(consumer, false) == 0) {
+        *a = NULL;
+        *na = 0;
+        *b = NULL;
+        *nb = 0;
+        return 0;
+    }
+
+    return stream_read_span(consumer->stream, consumer->read_idx, max, a, na, b, nb);
+}
+
+bool best_effort_consumer_commit(best_effort_consumer_t *consumer, size_t n) {
+    assert(consumer != NULL);
+
+    if (!stream_span_intact(consumer->stream, consumer->read_idx)) {
+        /* Producer lapped us while the span was processed - count and resync */
+        size_t write_pos = stream_write_position(consumer->stream);
+        consumer->dropped += write_pos - consumer->read_idx - n;
+        consumer->overwritten++;
+        stream_registry_note_overrun(consumer->entry);
+        consumer->read_idx = write_pos;
+        return false;
+    }
+
+    consumer->read_idx += n;
+    return true;
+}
+
 size_t best_effort_consumer_lag(const best_effort_consumer_t *consumer) {
     assert(consumer != NULL);
     return stream_lag(consumer->stream, consumer->read_idx);
 }
+
+/* ============================================================================
+ * Timed Consumer Implementation
+ * ============================================================================ */
+
+/**
+ * @brief Move to the tick anchor if it is still readable
+ *
+ * @return true if read_idx now sits on the anchor
+ */
+static bool timed_anchor(timed_consumer_t *consumer) {
+    const keying_stream_t *stream = consumer->base.stream;
+    size_t idx;
+    uint64_t tick;
+    stream_read_anchor(stream, &idx, &tick);
+
+    size_t limit = (consumer->base.skip_threshold > 0) ? consumer->base.skip_threshold
+                                                       : stream_capacity(stream);
+    consumer->tick = tick;
+    consumer->seen_dropped = consumer->base.dropped;
+    if (stream_lag(stream, idx) > limit) {
+        return false;
+    }
+    consumer->base.read_idx = idx;
+    return true;
+}
+
+static inline bool timed_skipped(const timed_consumer_t *consumer) {
+    return consumer->base.dropped != consumer->seen_dropped;
+}
+
+static void timed_resync(timed_consumer_t *consumer) {
+    (void)timed_anchor(consumer);
+    consumer->resyncs++;
+}
+
+void timed_consumer_init(timed_consumer_t *consumer,
+                         const keying_stream_t *stream,
+                         size_t skip_threshold) {
+    assert(consumer != NULL);
+    assert(stream != NULL);
+
+    best_effort_consumer_init(&consumer->base, stream, skip_threshold);
+    consumer->resyncs = 0;
+    (void)timed_anchor(consumer);
+}
+
+void timed_consumer_init_with_state(timed_consumer_t *consumer,
+                                    const keying_stream_t *stream,
+                                    size_t skip_threshold,
+                                    stream_key_state_t *state) {
+    assert(consumer != NULL);
+    assert(stream != NULL);
+    assert(state != NULL);
+
+    best_effort_consumer_init(&consumer->base, stream, skip_threshold);
+    consumer->resyncs = 0;
+    consumer->seen_dropped = consumer->base.dropped;
+    stream_read_key_state(stream, state);
+    consumer->base.read_idx = state->idx;
+    consumer->tick = state->tick;
+}
+
+bool timed_consumer_next(timed_consumer_t *consumer, stream_sample_t *out,
+                         uint64_t *tick) {
+    assert(consumer != NULL);
+    assert(out != NULL);
+    assert(tick != NULL);
+
+    if (timed_skipped(consumer)) {
+        timed_resync(consumer);
+    }
+    if (!best_effort_next(&consumer->base, consumer->tick, out)) {
+        return false;
+    }
+    if (timed_skipped(consumer)) {
+        /* Skipped ahead to get this sample: its tick is unknown */
+        timed_resync(consumer);
+        if (!best_effort_next(&consumer->base, consumer->tick, out)) {
+            return false;
+        }
+        consumer->seen_dropped = consumer->base.dropped;
+    }
+
+    *tick = timed_consumer_step(consumer, out);
+    return true;
+}
+
+size_t timed_consumer_next_span(timed_consumer_t *consumer,
+                                const stream_slot_t **a, size_t *na,
+                                const stream_slot_t **b, size_t *nb,
+                                size_t max) {
+    assert(consumer != NULL);
+
+    if (timed_skipped(consumer)) {
+        timed_resync(consumer);
+    }
+    size_t n = best_effort_consumer_next_span(&consumer->base, a, na, b, nb, max);
+    if (timed_skipped(consumer)) {
+        timed_resync(consumer);
+        n = best_effort_consumer_next_span(&consumer->base, a, na, b, nb, max);
+        consumer->seen_dropped = consumer->base.dropped;
+    }
+    return n;
+}
+
+bool timed_consumer_commit(timed_consumer_t *consumer, size_t n) {
+    assert(consumer != NULL);
+    /* An overwritten span bumps dropped: the next read re-anchors */
+    return best_effort_consumer_commit(&consumer->base, n);
+}
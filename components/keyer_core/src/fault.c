@@ -47,3 +47,100 @@ const char *fault_code_str(fault_code_t code) {
         default:                     return "UNKNOWN";
     }
 }
+
+/* ============================================================================
+ * Fault Timeline
+ * ============================================================================ */
+
+#define FAULT_LOG_MASK (FAULT_LOG_SIZE - 1U)
+
+_Static_assert((FAULT_LOG_SIZE & FAULT_LOG_MASK) == 0, "FAULT_LOG_SIZE must be power of 2");
+
+void fault_log_init(fault_log_t *log) {
+    for (size_t i = 0; i < FAULT_LOG_SIZE; i++) {
+        log->events[i] = (fault_event_t){0};
+    }
+    atomic_init(&log->head, 0);
+}
+
+void fault_log_record(fault_log_t *log, int64_t now_us, fault_event_kind_t kind,
+                      fault_code_t code, uint32_t data) {
+    unsigned head = atomic_load_explicit(&log->head, memory_order_relaxed);
+    fault_event_t *ev = &log->events[head & FAULT_LOG_MASK];
+
+    ev->time_us = now_us;
+    ev->data = data;
+    ev->code = (uint8_t)code;
+    ev->kind = (uint8_t)kind;
+
+    /* Publish the event with the index */
+    atomic_store_explicit(&log->head, head + 1U, memory_order_release);
+}
+
+size_t fault_log_snapshot(const fault_log_t *log, fault_event_t *out, size_t max) {
+    unsigned head = atomic_load_explicit(&log->head, memory_order_acquire);
+    unsigned first = (head > FAULT_LOG_SIZE) ? head - FAULT_LOG_SIZE : 0U;
+    if (head - first > max) {
+        first = head - (unsigned)max;
+    }
+
+    for (unsigned i = first; i < head; i++) {
+        out[i - first] = log->events[i & FAULT_LOG_MASK];
+    }
+
+    /* Slots from now + 1 - SIZE on may have been rewritten during the copy */
+    atomic_thread_fence(memory_order_acquire);
+    unsigned now = atomic_load_explicit(&log->head, memory_order_relaxed);
+    unsigned safe = (now + 1U > FAULT_LOG_SIZE) ? now + 1U - FAULT_LOG_SIZE : 0U;
+    if (safe <= first) {
+        return head - first;
+    }
+    if (safe >= head) {
+        return 0;
+    }
+    size_t keep = head - safe;
+    for (size_t i = 0; i < keep; i++) {
+        out[i] = out[safe - first + i];
+    }
+    return keep;
+}
+
+size_t fault_log_read(const fault_log_t *log, unsigned *next, fault_event_t *out, size_t max) {
+    unsigned head = atomic_load_explicit(&log->head, memory_order_acquire);
+    unsigned first = *next;
+    if (head - first > FAULT_LOG_SIZE) {
+        /* Behind by more than the ring, or ahead of a log that was reset */
+        first = (head > FAULT_LOG_SIZE) ? head - FAULT_LOG_SIZE : 0U;
+    }
+    unsigned end = (head - first > max) ? first + (unsigned)max : head;
+
+    for (unsigned i = first; i != end; i++) {
+        out[i - first] = log->events[i & FAULT_LOG_MASK];
+    }
+
+    /* As in fault_log_snapshot(): drop what the writer reached meanwhile */
+    atomic_thread_fence(memory_order_acquire);
+    unsigned now = atomic_load_explicit(&log->head, memory_order_relaxed);
+    unsigned safe = now + 1U - FAULT_LOG_SIZE;
+    *next = end;
+    if ((int)(safe - first) <= 0) {
+        return end - first;
+    }
+    if ((int)(safe - end) >= 0) {
+        return 0;
+    }
+    size_t keep = end - safe;
+    for (size_t i = 0; i < keep; i++) {
+        out[i] = out[safe - first + i];
+    }
+    return keep;
+}
+
+const char *fault_event_str(fault_event_kind_t kind) {
+    switch (kind) {
+        case FAULT_EV_RAISED:    return "raised";
+        case FAULT_EV_RECOVERED: return "recovered";
+        case FAULT_EV_LATCHED:   return "latched";
+        default:                 return "unknown";
+    }
+}
@@ -0,0 +1,183 @@
+/**
+ * @file flight_rec.c
+ * @brief Fault and crash flight recorder
+ *
+ * Each lane is written by one core only. An event is stored before the
+ * index that publishes it; a reader copies below the index it loaded and
+ * afterwards drops whatever the writer may have lapped meanwhile.
+ */
+
+#include "flight_rec.h"
+#include <string.h>
+#include <stdatomic.h>
+
+#define RT_MASK (FLIGHT_REC_RT_EVENTS - 1U)
+#define BG_MASK (FLIGHT_REC_BG_EVENTS - 1U)
+
+_Static_assert((FLIGHT_REC_RT_EVENTS & RT_MASK) == 0, "FLIGHT_REC_RT_EVENTS must be power of 2");
+_Static_assert((FLIGHT_REC_BG_EVENTS & BG_MASK) == 0, "FLIGHT_REC_BG_EVENTS must be power of 2");
+_Static_assert(sizeof(flight_rec_event_t) == 16, "flight_rec_event_t layout");
+
+static bool is_valid(const flight_rec_t *rec) {
+    return rec->magic == FLIGHT_REC_MAGIC &&
+           rec->version == FLIGHT_REC_VERSION &&
+           rec->size == (uint32_t)sizeof(flight_rec_t);
+}
+
+static void lane_put(flight_rec_event_t *events, uint32_t mask, volatile uint32_t *idx,
+                     const flight_rec_event_t *ev) {
+    uint32_t i = *idx;
+    events[i & mask] = *ev;
+    /* Event before index */
+    atomic_thread_fence(memory_order_release);
+    *idx = i + 1U;
+}
+
+static flight_rec_event_t make_event(const flight_rec_t *rec, int64_t now_us,
+                                     flight_rec_type_t type, uint8_t code, uint32_t value) {
+    flight_rec_event_t ev = {
+        .time_us = now_us,
+        .value = value,
+        .boot = (uint16_t)rec->boot_count,
+        .type = (uint8_t)type,
+        .code = code,
+    };
+    return ev;
+}
+
+bool flight_rec_boot(flight_rec_t *rec, uint8_t reset_reason, int64_t now_us) {
+    bool kept = is_valid(rec);
+    if (!kept) {
+        /* Power-on (or layout change): RTC contents are noise */
+        memset(rec, 0, sizeof(*rec));
+        rec->magic = FLIGHT_REC_MAGIC;
+        rec->version = FLIGHT_REC_VERSION;
+        rec->size = (uint32_t)sizeof(flight_rec_t);
+    }
+    rec->boot_count++;
+    memset(rec->stage_max, 0, sizeof(rec->stage_max));
+    flight_rec_bg(rec, now_us, FLIGHT_EV_BOOT, reset_reason, rec->boot_count);
+    return kept;
+}
+
+void flight_rec_rt(flight_rec_t *rec, int64_t now_us, flight_rec_type_t type,
+                   uint8_t code, uint32_t value) {
+    flight_rec_event_t ev = make_event(rec, now_us, type, code, value);
+    lane_put(rec->rt_events, RT_MASK, &rec->rt_idx, &ev);
+}
+
+void flight_rec_bg(flight_rec_t *rec, int64_t now_us, flight_rec_type_t type,
+                   uint8_t code, uint32_t value) {
+    flight_rec_event_t ev = make_event(rec, now_us, type, code, value);
+    lane_put(rec->bg_events, BG_MASK, &rec->bg_idx, &ev);
+}
+
+bool flight_rec_note_stage(flight_rec_t *rec, int64_t now_us, rt_prof_stage_t stage,
+                           uint32_t max_cycles) {
+    if ((unsigned)stage >= RT_PROF_STAGE_COUNT || max_cycles <= rec->stage_max[stage]) {
+        return false;
+    }
+    rec->stage_max[stage] = max_cycles;
+    flight_rec_bg(rec, now_us, FLIGHT_EV_STAGE, (uint8_t)stage, max_cycles);
+    return true;
+}
+
+/** a happened before b: boot first (wraps at 16 bits), then time */
+static bool earlier(const flight_rec_event_t *a, const flight_rec_event_t *b) {
+    int16_t boots = (int16_t)(uint16_t)(a->boot - b->boot);
+    if (boots != 0) {
+        return boots < 0;
+    }
+    return a->time_us < b->time_us;
+}
+
+/** Readable window of one lane: [first, end) */
+typedef struct {
+    const flight_rec_event_t *events;
+    uint32_t mask;
+    uint32_t first;
+    uint32_t end;
+} lane_view_t;
+
+static lane_view_t lane_view(const flight_rec_event_t *events, uint32_t size,
+                             const volatile uint32_t *idx) {
+    lane_view_t v = { events, size - 1U, 0, *idx };
+    atomic_thread_fence(memory_order_acquire);
+    v.first = (v.end > size) ? v.end - size : 0;
+    return v;
+}
+
+size_t flight_rec_snapshot(const flight_rec_t *rec, flight_rec_event_t *out, size_t max) {
+    if (!is_valid(rec) || max == 0) {
+        return 0;
+    }
+    if (max > FLIGHT_REC_MAX_EVENTS) {
+        max = FLIGHT_REC_MAX_EVENTS;
+    }
+
+    lane_view_t rt = lane_view(rec->rt_events, FLIGHT_REC_RT_EVENTS, &rec->rt_idx);
+    lane_view_t bg = lane_view(rec->bg_events, FLIGHT_REC_BG_EVENTS, &rec->bg_idx);
+
+    /* Merge, keeping the newest max events; remember each one's lane slot */
+    uint32_t total = (rt.end - rt.first) + (bg.end - bg.first);
+    uint32_t skip = (total > max) ? total - (uint32_t)max : 0;
+    uint32_t pos[FLIGHT_REC_MAX_EVENTS];
+    bool from_rt[FLIGHT_REC_MAX_EVENTS];
+    uint32_t r = rt.first;
+    uint32_t b = bg.first;
+    size_t n = 0;
+
+    while (r < rt.end || b < bg.end) {
+        const flight_rec_event_t *er = (r < rt.end) ? &rt.events[r & rt.mask] : NULL;
+        const flight_rec_event_t *eb = (b < bg.end) ? &bg.events[b & bg.mask] : NULL;
+        bool take_rt = (eb == NULL) || (er != NULL && earlier(er, eb));
+        if (skip > 0) {
+            skip--;
+        } else {
+            out[n] = take_rt ? *er : *eb;
+            pos[n] = take_rt ? r : b;
+            from_rt[n] = take_rt;
+            n++;
+        }
+        if (take_rt) {
+            r++;
+        } else {
+            b++;
+        }
+    }
+
+    /* Drop what the writers lapped while we copied (the slot of the
+     * unpublished event at *idx may be half-written too) */
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t rt_next = rec->rt_idx + 1U;
+    uint32_t bg_next = rec->bg_idx + 1U;
+    uint32_t rt_safe = (rt_next > FLIGHT_REC_RT_EVENTS) ? rt_next - FLIGHT_REC_RT_EVENTS : 0;
+    uint32_t bg_safe = (bg_next > FLIGHT_REC_BG_EVENTS) ? bg_next - FLIGHT_REC_BG_EVENTS : 0;
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t safe = from_rt[i] ? rt_safe : bg_safe;
+        if (pos[i] >= safe) {
+            out[kept++] = out[i];
+        }
+    }
+    return kept;
+}
+
+const char *flight_rec_type_str(uint8_t type) {
+    switch (type) {
+        case FLIGHT_EV_BOOT:  return "boot";
+        case FLIGHT_EV_FAULT: return "fault";
+        case FLIGHT_EV_EDGE:  return "edge";
+        case FLIGHT_EV_STAGE: return "stage";
+        default:              return "?";
+    }
+}
+
+const char *flight_rec_reset_str(uint8_t reason) {
+    /* esp_reset_reason_t order */
+    static const char *const names[] = {
+        "UNKNOWN", "POWERON", "EXT", "SW", "PANIC", "INT_WDT", "TASK_WDT", "WDT",
+        "DEEPSLEEP", "BROWNOUT", "SDIO", "USB", "JTAG", "EFUSE", "PWR_GLITCH", "CPU_LOCKUP",
+    };
+    return (reason < sizeof(names) / sizeof(names[0])) ? names[reason] : "?";
+}
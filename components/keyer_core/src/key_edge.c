@@ -0,0 +1,227 @@
+/**
+ * @file key_edge.c
+ * @brief Edge-extraction stage and key edge ring implementation
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#include "key_edge.h"
+#include <assert.h>
+#include <string.h>
+
+#define KEY_EDGE_RING_MASK (KEY_EDGE_RING_CAPACITY - 1)
+
+_Static_assert((KEY_EDGE_RING_CAPACITY & KEY_EDGE_RING_MASK) == 0,
+               "KEY_EDGE_RING_CAPACITY must be power of 2");
+
+/* ============================================================================
+ * Ring
+ * ============================================================================ */
+
+void key_edge_ring_init(key_edge_ring_t *ring, const keying_stream_t *stream) {
+    assert(ring != NULL);
+    assert(stream != NULL);
+
+    memset(ring->buffer, 0, sizeof(ring->buffer));
+    atomic_init(&ring->write_idx, 0);
+    atomic_init(&ring->head_tick32, 0);
+    ring->stream = stream;
+}
+
+/** Publish one edge (single producer) */
+static inline void ring_push(key_edge_ring_t *ring, uint64_t tick,
+                             key_edge_channel_t channel, uint8_t level, uint8_t tag) {
+    size_t idx = atomic_load_explicit(&ring->write_idx, memory_order_relaxed);
+    key_edge_t *e = &ring->buffer[idx & KEY_EDGE_RING_MASK];
+    e->tick = tick;
+    e->channel = (uint8_t)channel;
+    e->level = level;
+    e->tag = tag;
+
+    /* RULE 3.1.2: Release so readers see the edge before the index */
+    atomic_store_explicit(&ring->write_idx, idx + 1, memory_order_release);
+}
+
+void key_edge_ring_push(key_edge_ring_t *ring, uint64_t tick, key_edge_channel_t channel,
+                        uint8_t level) {
+    assert(ring != NULL);
+    ring_push(ring, tick, channel, level, 0);
+}
+
+void key_edge_ring_set_head(key_edge_ring_t *ring, uint64_t tick) {
+    assert(ring != NULL);
+    /* RULE 3.1.2: Release after the edges up to this tick */
+    atomic_store_explicit(&ring->head_tick32, (uint32_t)tick, memory_order_release);
+}
+
+/* ============================================================================
+ * Extraction stage
+ * ============================================================================ */
+
+void key_edge_stage_init(key_edge_stage_t *stage, const keying_stream_t *stream,
+                         key_edge_ring_t *ring) {
+    assert(stage != NULL);
+    assert(stream != NULL);
+    assert(ring != NULL);
+
+    /* skip_threshold=0: only skip on real overrun */
+    stream_key_state_t state;
+    timed_consumer_init_with_state(&stage->source, stream, 0, &state);
+    stage->ring = ring;
+    stage->prev_gpio = state.gpio;
+    stage->key_level = state.local_key ? 1U : 0U;
+    stage->remote_level = 0;
+    stage->index = NULL;
+}
+
+void key_edge_stage_attach_index(key_edge_stage_t *stage, stream_index_t *index) {
+    assert(stage != NULL);
+    stage->index = index;
+}
+
+/** Turn one sample's edge flags into ring entries */
+static size_t extract_edges(key_edge_stage_t *stage, const stream_sample_t *sample,
+                            uint64_t tick) {
+    size_t pushed = 0;
+
+    if (sample->flags & FLAG_GPIO_EDGE) {
+        uint8_t changed = (uint8_t)(sample->gpio.bits ^ stage->prev_gpio.bits);
+        if (changed & GPIO_DIT_BIT) {
+            ring_push(stage->ring, tick, KEY_EDGE_CH_DIT, gpio_dit(sample->gpio) ? 1U : 0U, 0);
+            pushed++;
+        }
+        if (changed & GPIO_DAH_BIT) {
+            ring_push(stage->ring, tick, KEY_EDGE_CH_DAH, gpio_dah(sample->gpio) ? 1U : 0U, 0);
+            pushed++;
+        }
+        stage->prev_gpio = sample->gpio;
+    }
+
+    if (sample->flags & FLAG_LOCAL_EDGE) {
+        stage->key_level = sample->local_key ? 1U : 0U;
+        ring_push(stage->ring, tick, KEY_EDGE_CH_KEY, stage->key_level, sample_key_tag(sample));
+        pushed++;
+    }
+
+    return pushed;
+}
+
+static size_t extract_sample(key_edge_stage_t *stage, const stream_sample_t *sample,
+                             size_t idx) {
+    uint64_t tick = timed_consumer_step(&stage->source, sample);
+    stream_lane_t lane = sample_lane(sample);
+
+    if (lane == STREAM_LANE_REMOTE) {
+        /* Every REMOTE event is a key change, stamped with its play tick */
+        if (sample_is_silence(sample)) {
+            return 0;
+        }
+        stage->remote_level = sample->local_key ? 1U : 0U;
+        ring_push(stage->ring, sample_resolve_tick(tick, sample_event_tick32(sample)),
+                  KEY_EDGE_CH_REMOTE, stage->remote_level, 0);
+        return 1;
+    }
+    if (lane != STREAM_LANE_LOCAL) {
+        return 0;
+    }
+
+    size_t pushed = sample_is_silence(sample) ? 0 : extract_edges(stage, sample, tick);
+    if (stage->index != NULL) {
+        stream_index_note(stage->index, idx, tick, (uint32_t)pushed);
+    }
+    return pushed;
+}
+
+size_t key_edge_stage_run(key_edge_stage_t *stage) {
+    assert(stage != NULL);
+
+    size_t pushed = 0;
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+
+    while (timed_consumer_next_span(&stage->source, &a, &na, &b, &nb, SIZE_MAX) > 0) {
+        size_t idx = stage->source.base.read_idx;
+        for (size_t i = 0; i < na; i++) {
+            pushed += extract_sample(stage, &a[i].sample, idx++);
+        }
+        for (size_t i = 0; i < nb; i++) {
+            pushed += extract_sample(stage, &b[i].sample, idx++);
+        }
+        timed_consumer_commit(&stage->source, na + nb);
+    }
+
+    /* Caught up: the LOCAL state also held through the pending idle run */
+    key_edge_ring_set_head(stage->ring,
+                           stage->source.tick + stream_pending_idle_ticks(stage->source.base.stream));
+    return pushed;
+}
+
+void key_edge_stage_levels(const key_edge_stage_t *stage, key_edge_t out[KEY_EDGE_CH_COUNT]) {
+    assert(stage != NULL);
+    assert(out != NULL);
+
+    const uint8_t levels[KEY_EDGE_CH_COUNT] = {
+        [KEY_EDGE_CH_KEY] = stage->key_level,
+        [KEY_EDGE_CH_DIT] = gpio_dit(stage->prev_gpio) ? 1U : 0U,
+        [KEY_EDGE_CH_DAH] = gpio_dah(stage->prev_gpio) ? 1U : 0U,
+        [KEY_EDGE_CH_REMOTE] = stage->remote_level,
+    };
+    for (int ch = 0; ch < KEY_EDGE_CH_COUNT; ch++) {
+        out[ch].tick = stage->source.tick;
+        out[ch].channel = (uint8_t)ch;
+        out[ch].level = levels[ch];
+        out[ch].tag = 0;
+    }
+}
+
+/* ============================================================================
+ * Reader
+ * ============================================================================ */
+
+void key_edge_reader_init(key_edge_reader_t *reader, const key_edge_ring_t *ring) {
+    assert(reader != NULL);
+    assert(ring != NULL);
+
+    reader->ring = ring;
+    reader->read_idx = atomic_load_explicit(&ring->write_idx, memory_order_acquire);
+    reader->dropped = 0;
+}
+
+bool key_edge_reader_next(key_edge_reader_t *reader, key_edge_t *out) {
+    assert(reader != NULL);
+    assert(out != NULL);
+
+    const key_edge_ring_t *ring = reader->ring;
+
+    for (;;) {
+        /* RULE 3.1.3: Acquire for read */
+        size_t write = atomic_load_explicit(&ring->write_idx, memory_order_acquire);
+        size_t behind = write - reader->read_idx;
+
+        if (behind == 0) {
+            return false;
+        }
+        if (behind > KEY_EDGE_RING_CAPACITY) {
+            /* Overwritten: jump to the oldest edge still in the ring */
+            reader->dropped += behind - KEY_EDGE_RING_CAPACITY;
+            reader->read_idx = write - KEY_EDGE_RING_CAPACITY;
+        }
+
+        key_edge_t copy = ring->buffer[reader->read_idx & KEY_EDGE_RING_MASK];
+
+        /* Producer may have lapped us during the copy */
+        atomic_thread_fence(memory_order_acquire);
+        write = atomic_load_explicit(&ring->write_idx, memory_order_relaxed);
+        if (write - reader->read_idx > KEY_EDGE_RING_CAPACITY) {
+            continue;
+        }
+
+        reader->read_idx++;
+        *out = copy;
+        return true;
+    }
+}
@@ -0,0 +1,276 @@
+/**
+ * @file key_latency.c
+ * @brief Paddle-to-output latency probe
+ *
+ * tx and audio are written by the RT task, loopback by the audio RX task.
+ * Every histogram field is a relaxed atomic so readers never see a torn
+ * word; reset requests are applied by the path's writer.
+ */
+
+#include "key_latency.h"
+
+key_latency_t g_key_latency;
+
+static void hist_clear(key_latency_hist_t *h) {
+    atomic_store_explicit(&h->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->min_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&h->max_us, 0, memory_order_relaxed);
+    for (size_t i = 0; i < KEY_LATENCY_HIST_BINS; i++) {
+        atomic_store_explicit(&h->hist[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&h->reset_requested, false, memory_order_relaxed);
+}
+
+static void hist_record(key_latency_hist_t *h, int64_t latency_us) {
+    if (atomic_exchange_explicit(&h->reset_requested, false, memory_order_relaxed)) {
+        hist_clear(h);
+    }
+
+    uint32_t us;
+    if (latency_us <= 0) {
+        us = 0;
+    } else if (latency_us >= (int64_t)UINT32_MAX) {
+        us = UINT32_MAX;
+    } else {
+        us = (uint32_t)latency_us;
+    }
+
+    uint32_t count = atomic_load_explicit(&h->count, memory_order_relaxed);
+    if (count == 0 || us < atomic_load_explicit(&h->min_us, memory_order_relaxed)) {
+        atomic_store_explicit(&h->min_us, us, memory_order_relaxed);
+    }
+    if (count == 0 || us > atomic_load_explicit(&h->max_us, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max_us, us, memory_order_relaxed);
+    }
+    if (count != UINT32_MAX) {
+        atomic_store_explicit(&h->count, count + 1, memory_order_relaxed);
+    }
+
+    uint32_t bin = key_latency_bin(us);
+    uint32_t n = atomic_load_explicit(&h->hist[bin], memory_order_relaxed);
+    if (n != UINT32_MAX) {
+        atomic_store_explicit(&h->hist[bin], n + 1, memory_order_relaxed);
+    }
+}
+
+void key_latency_init(key_latency_t *lat) {
+    if (lat == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < KEY_LATENCY_PATH_COUNT; i++) {
+        hist_clear(&lat->path[i]);
+    }
+    atomic_store_explicit(&lat->mode, KEY_LATENCY_OFF, memory_order_relaxed);
+    atomic_store_explicit(&lat->missed, 0, memory_order_relaxed);
+    lat->edge_us = 0;
+    lat->tx_pending = false;
+    lat->audio_pending = false;
+    lat->tx_on = false;
+    lat->audio_quiet = true;
+    atomic_store_explicit(&lat->loop_edge_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&lat->loop_armed, false, memory_order_relaxed);
+}
+
+void key_latency_set_mode(key_latency_t *lat, key_latency_mode_t mode) {
+    if (lat == NULL || (unsigned)mode > KEY_LATENCY_LOOPBACK) {
+        return;
+    }
+    atomic_store_explicit(&lat->mode, (unsigned)mode, memory_order_relaxed);
+}
+
+key_latency_mode_t key_latency_get_mode(const key_latency_t *lat) {
+    return (key_latency_mode_t)atomic_load_explicit(&lat->mode, memory_order_relaxed);
+}
+
+void key_latency_edge(key_latency_t *lat, int64_t edge_us) {
+    unsigned mode = atomic_load_explicit(&lat->mode, memory_order_relaxed);
+    if (mode == KEY_LATENCY_OFF || lat->tx_pending || lat->audio_pending ||
+        lat->tx_on || !lat->audio_quiet) {
+        return;
+    }
+    lat->edge_us = edge_us;
+    lat->tx_pending = true;
+    lat->audio_pending = true;
+
+    /* The RX task owns loop_armed once set; a stale arm just times out there */
+    if (mode == KEY_LATENCY_LOOPBACK &&
+        !atomic_load_explicit(&lat->loop_armed, memory_order_acquire)) {
+        atomic_store_explicit(&lat->loop_edge_us, (uint32_t)edge_us, memory_order_relaxed);
+        atomic_store_explicit(&lat->loop_armed, true, memory_order_release);
+    }
+}
+
+void key_latency_tx(key_latency_t *lat, bool tx_on, int64_t now_us) {
+    if (lat->tx_pending && tx_on && !lat->tx_on) {
+        hist_record(&lat->path[KEY_LATENCY_PATH_TX], now_us - lat->edge_us);
+        lat->tx_pending = false;
+    }
+    lat->tx_on = tx_on;
+
+    if ((lat->tx_pending || lat->audio_pending) &&
+        now_us - lat->edge_us > KEY_LATENCY_TIMEOUT_US) {
+        lat->tx_pending = false;
+        lat->audio_pending = false;
+        atomic_fetch_add_explicit(&lat->missed, 1, memory_order_relaxed);
+    }
+}
+
+void key_latency_audio(key_latency_t *lat, const int16_t *samples, size_t count,
+                       int64_t now_us) {
+    if (atomic_load_explicit(&lat->mode, memory_order_relaxed) == KEY_LATENCY_OFF &&
+        !lat->audio_pending) {
+        return;
+    }
+
+    bool sounding = false;
+    for (size_t i = 0; i < count; i++) {
+        if (samples[i] != 0) {
+            sounding = true;
+            break;
+        }
+    }
+    if (sounding && lat->audio_pending) {
+        hist_record(&lat->path[KEY_LATENCY_PATH_AUDIO], now_us - lat->edge_us);
+        lat->audio_pending = false;
+    }
+    lat->audio_quiet = !sounding;
+}
+
+void key_latency_loopback(key_latency_t *lat, const int16_t *samples, size_t count,
+                          int64_t end_us, uint32_t sample_rate_hz) {
+    if (!atomic_load_explicit(&lat->loop_armed, memory_order_acquire) ||
+        sample_rate_hz == 0) {
+        return;
+    }
+
+    /* 32-bit microsecond arithmetic: wraps every 71 minutes, differences are fine */
+    uint32_t edge = atomic_load_explicit(&lat->loop_edge_us, memory_order_relaxed);
+    uint32_t end = (uint32_t)end_us;
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = samples[i];
+        if (s < 0) {
+            s = -s;
+        }
+        if (s < KEY_LATENCY_LOOP_THRESHOLD) {
+            continue;
+        }
+        uint32_t back_us = (uint32_t)(((uint64_t)(count - 1U - i) * 1000000U) / sample_rate_hz);
+        int32_t latency = (int32_t)(end - back_us - edge);
+        if (latency < 0) {
+            continue;   /* Captured before the press: tail of the last tone */
+        }
+        hist_record(&lat->path[KEY_LATENCY_PATH_LOOPBACK], latency);
+        atomic_store_explicit(&lat->loop_armed, false, memory_order_release);
+        return;
+    }
+
+    if ((int32_t)(end - edge) > KEY_LATENCY_TIMEOUT_US) {
+        atomic_store_explicit(&lat->loop_armed, false, memory_order_release);
+        atomic_fetch_add_explicit(&lat->missed, 1, memory_order_relaxed);
+    }
+}
+
+void key_latency_reset(key_latency_t *lat) {
+    if (lat == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < KEY_LATENCY_PATH_COUNT; i++) {
+        atomic_store_explicit(&lat->path[i].reset_requested, true, memory_order_relaxed);
+    }
+    atomic_store_explicit(&lat->missed, 0, memory_order_relaxed);
+}
+
+void key_latency_get(key_latency_t *lat, key_latency_path_t path,
+                     key_latency_snapshot_t *out) {
+    if (lat == NULL || out == NULL || (unsigned)path >= KEY_LATENCY_PATH_COUNT) {
+        return;
+    }
+    key_latency_hist_t *h = &lat->path[path];
+    if (atomic_load_explicit(&h->reset_requested, memory_order_relaxed)) {
+        /* Not applied yet: the writer clears on its next record */
+        out->count = 0;
+        out->min_us = 0;
+        out->max_us = 0;
+        for (size_t i = 0; i < KEY_LATENCY_HIST_BINS; i++) {
+            out->hist[i] = 0;
+        }
+        return;
+    }
+    out->count = atomic_load_explicit(&h->count, memory_order_relaxed);
+    out->min_us = atomic_load_explicit(&h->min_us, memory_order_relaxed);
+    out->max_us = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+    for (size_t i = 0; i < KEY_LATENCY_HIST_BINS; i++) {
+        out->hist[i] = atomic_load_explicit(&h->hist[i], memory_order_relaxed);
+    }
+}
+
+uint32_t key_latency_bin_upper_us(uint32_t bin) {
+    if (bin < 4U) {
+        return bin;
+    }
+    if (bin >= KEY_LATENCY_HIST_BINS - 1U) {
+        return UINT32_MAX;
+    }
+    uint32_t octave = bin / 4U + 1U;
+    uint32_t step = 1UL << (octave - 2U);
+    return (4U + bin % 4U) * step + step - 1U;
+}
+
+uint32_t key_latency_percentile_us(const key_latency_snapshot_t *snap, uint32_t pct) {
+    if (snap == NULL) {
+        return 0;
+    }
+    if (pct > 100) {
+        pct = 100;
+    }
+
+    /* Bins saturate independently of count, so rank against their sum */
+    uint64_t total = 0;
+    for (size_t i = 0; i < KEY_LATENCY_HIST_BINS; i++) {
+        total += snap->hist[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (total * pct + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    uint32_t upper = snap->max_us;
+    for (uint32_t i = 0; i < KEY_LATENCY_HIST_BINS; i++) {
+        seen += snap->hist[i];
+        if (seen >= rank) {
+            upper = key_latency_bin_upper_us(i);
+            break;
+        }
+    }
+
+    if (upper > snap->max_us) {
+        upper = snap->max_us;
+    }
+    if (upper < snap->min_us) {
+        upper = snap->min_us;
+    }
+    return upper;
+}
+
+const char *key_latency_path_str(key_latency_path_t path) {
+    switch (path) {
+        case KEY_LATENCY_PATH_TX:       return "tx";
+        case KEY_LATENCY_PATH_AUDIO:    return "audio";
+        case KEY_LATENCY_PATH_LOOPBACK: return "loopback";
+        default:                        return "?";
+    }
+}
+
+const char *key_latency_mode_str(key_latency_mode_t mode) {
+    switch (mode) {
+        case KEY_LATENCY_OFF:      return "off";
+        case KEY_LATENCY_ON:       return "on";
+        case KEY_LATENCY_LOOPBACK: return "loopback";
+        default:                   return "?";
+    }
+}
@@ -0,0 +1,281 @@
+/**
+ * @file key_stats.c
+ * @brief Sliding-window keying statistics
+ */
+
+#include "key_stats.h"
+#include "sample.h"
+#include <string.h>
+
+static const uint32_t k_window_us[KEY_STATS_WINDOWS] = { 1000000, 10000000, 60000000 };
+
+uint32_t key_stats_window_us(key_stats_window_id_t window) {
+    return ((unsigned)window < KEY_STATS_WINDOWS) ? k_window_us[window] : 0U;
+}
+
+static uint32_t slot_us(int w) {
+    return k_window_us[w] / KEY_STATS_SLOTS;
+}
+
+void key_stats_init(key_stats_t *ks) {
+    memset(ks, 0, sizeof(*ks));
+    for (int ch = 0; ch < KEY_STATS_CHANNELS; ch++) {
+        ks->ch[ch].since_us = -1;
+    }
+    atomic_init(&ks->seq, 0);
+}
+
+static void acc_sub(key_stats_acc_t *a, const key_stats_acc_t *b) {
+    a->down_us -= b->down_us;
+    for (int k = 0; k < KEY_STATS_KINDS; k++) {
+        a->sum_us[k] -= b->sum_us[k];
+        a->count[k] = (uint16_t)(a->count[k] - b->count[k]);
+    }
+}
+
+/**
+ * @brief Move one window from pos to t with a constant level
+ */
+static void window_advance(key_stats_window_t *w, uint32_t width, int64_t pos, int64_t t,
+                           bool down) {
+    uint32_t target = (uint32_t)(t / width);
+    if (target - w->open >= KEY_STATS_SLOTS) {
+        /* Every slot falls out: only the last ones before t can be held */
+        memset(w->slot, 0, sizeof(w->slot));
+        memset(&w->sum, 0, sizeof(w->sum));
+        w->open = target - (KEY_STATS_SLOTS - 1U);
+        if (pos < (int64_t)w->open * width) {
+            pos = (int64_t)w->open * width;
+        }
+    }
+    while (w->open < target) {
+        int64_t end = (int64_t)(w->open + 1U) * width;
+        if (down) {
+            w->slot[w->open % KEY_STATS_SLOTS].down_us += (uint32_t)(end - pos);
+            w->sum.down_us += (uint32_t)(end - pos);
+        }
+        pos = end;
+        w->open++;
+        key_stats_acc_t *reused = &w->slot[w->open % KEY_STATS_SLOTS];
+        acc_sub(&w->sum, reused);
+        memset(reused, 0, sizeof(*reused));
+    }
+    if (down) {
+        w->slot[w->open % KEY_STATS_SLOTS].down_us += (uint32_t)(t - pos);
+        w->sum.down_us += (uint32_t)(t - pos);
+    }
+}
+
+static void channel_start(key_stats_channel_t *c, int64_t t) {
+    for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+        c->win[w].open = (uint32_t)(t / slot_us(w));
+    }
+    c->start_us = t;
+    c->now_us = t;
+    c->started = true;
+}
+
+static void channel_advance(key_stats_channel_t *c, int64_t t) {
+    if (t <= c->now_us) {
+        return;
+    }
+    for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+        window_advance(&c->win[w], slot_us(w), c->now_us, t, c->level != 0);
+    }
+    c->now_us = t;
+}
+
+/**
+ * @brief Count one element in the open slot of every window
+ */
+static void channel_count(key_stats_channel_t *c, key_stats_kind_t kind, int64_t dur_us) {
+    for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+        key_stats_window_t *win = &c->win[w];
+        key_stats_acc_t *a = &win->slot[win->open % KEY_STATS_SLOTS];
+        a->sum_us[kind] += (uint32_t)dur_us;
+        a->count[kind]++;
+        win->sum.sum_us[kind] += (uint32_t)dur_us;
+        win->sum.count[kind]++;
+    }
+}
+
+/**
+ * @brief Classify a mark that just ended and learn the unit from it
+ */
+static void mark_ended(key_stats_channel_t *c, int64_t dur_us) {
+    key_stats_kind_t kind;
+    uint32_t d = (uint32_t)dur_us;
+
+    if (c->tag & KEY_TAG_ELEMENT) {
+        kind = (c->tag & KEY_TAG_DAH) ? KEY_STATS_DAH : KEY_STATS_DIT;
+    } else if (c->unit_us == 0 || 2U * d < c->unit_us) {
+        /* First mark, or far shorter than the unit (it was learned from a
+         * dah, or the sender sped up): take it as the dit */
+        kind = KEY_STATS_DIT;
+        c->unit_us = d;
+    } else {
+        kind = (d >= 2U * c->unit_us) ? KEY_STATS_DAH : KEY_STATS_DIT;
+    }
+
+    uint32_t unit = (kind == KEY_STATS_DAH) ? d / 3U : d;
+    if (c->unit_us == 0) {
+        c->unit_us = unit;
+    } else {
+        c->unit_us = (uint32_t)((int32_t)c->unit_us + ((int32_t)unit - (int32_t)c->unit_us) / 4);
+    }
+    channel_count(c, kind, dur_us);
+}
+
+/**
+ * @brief Classify a space that a key-down edge with this tag ended
+ */
+static void space_ended(key_stats_channel_t *c, int64_t dur_us, uint8_t tag) {
+    if (c->unit_us == 0) {
+        return;
+    }
+    uint64_t units_x4 = (uint64_t)dur_us * 4U / c->unit_us;
+    if (units_x4 > 4U * KEY_STATS_PAUSE_UNITS) {
+        return;   /* A pause, not spacing */
+    }
+
+    key_stats_kind_t kind;
+    if ((tag & KEY_TAG_IN_CHAR) || (!(tag & KEY_TAG_ELEMENT) && units_x4 < 8U)) {
+        kind = KEY_STATS_GAP_ELEMENT;
+    } else if (units_x4 < 20U) {
+        kind = KEY_STATS_GAP_CHAR;
+    } else {
+        kind = KEY_STATS_GAP_WORD;
+    }
+    channel_count(c, kind, dur_us);
+}
+
+void key_stats_edge(key_stats_t *ks, int64_t time_us, uint8_t channel, uint8_t level,
+                    uint8_t tag) {
+    if (channel >= KEY_STATS_CHANNELS || time_us < 0) {
+        return;
+    }
+    key_stats_channel_t *c = &ks->ch[channel];
+    if (!c->started) {
+        channel_start(c, time_us);
+    }
+    level = level ? 1U : 0U;
+    if (level == c->level) {
+        return;   /* Not a change */
+    }
+    channel_advance(c, time_us);
+
+    int64_t dur_us = c->now_us - c->since_us;
+    if (c->since_us >= 0 && dur_us >= KEY_STATS_MIN_US) {
+        if (c->level) {
+            mark_ended(c, dur_us);
+        } else {
+            space_ended(c, dur_us, tag);
+        }
+    }
+    c->level = level;
+    c->since_us = c->now_us;
+    if (level) {
+        c->tag = tag;
+    }
+}
+
+static uint16_t clamp16(uint64_t v) {
+    return (v > UINT16_MAX) ? UINT16_MAX : (uint16_t)v;
+}
+
+static uint32_t mean_us(const key_stats_acc_t *a, key_stats_kind_t kind) {
+    return a->count[kind] ? a->sum_us[kind] / a->count[kind] : 0U;
+}
+
+static void view_compute(const key_stats_channel_t *c, int w, key_stats_view_t *v) {
+    const key_stats_window_t *win = &c->win[w];
+    const key_stats_acc_t *a = &win->sum;
+    uint32_t width = slot_us(w);
+
+    memset(v, 0, sizeof(*v));
+    if (!c->started) {
+        return;
+    }
+    int64_t span = (int64_t)(KEY_STATS_SLOTS - 1) * width +
+                   (c->now_us - (int64_t)win->open * width);
+    if (span > c->now_us - c->start_us) {
+        span = c->now_us - c->start_us;
+    }
+    if (span <= 0) {
+        return;
+    }
+    v->span_us = (uint32_t)span;
+    v->duty_pm = clamp16((uint64_t)a->down_us * 1000U / (uint64_t)span);
+
+    /* Dits, dahs and the gaps between them: 1, 3 and 1 units, and the weight
+     * moves time between marks and gaps without changing the total */
+    uint32_t units = (uint32_t)a->count[KEY_STATS_DIT] + 3U * a->count[KEY_STATS_DAH] +
+                     a->count[KEY_STATS_GAP_ELEMENT];
+    uint64_t unit_us = 0;
+    if (units > 0) {
+        unit_us = ((uint64_t)a->sum_us[KEY_STATS_DIT] + a->sum_us[KEY_STATS_DAH] +
+                   a->sum_us[KEY_STATS_GAP_ELEMENT]) / units;
+    }
+    if (unit_us > 0) {
+        v->wpm_x10 = clamp16(12000000U / unit_us);
+        v->char_gap_x100 = clamp16((uint64_t)mean_us(a, KEY_STATS_GAP_CHAR) * 100U / unit_us);
+        v->word_gap_x100 = clamp16((uint64_t)mean_us(a, KEY_STATS_GAP_WORD) * 100U / unit_us);
+    }
+
+    uint32_t dit = mean_us(a, KEY_STATS_DIT);
+    uint32_t gap = mean_us(a, KEY_STATS_GAP_ELEMENT);
+    if (dit > 0 && gap > 0) {
+        v->weight_pm = clamp16((uint64_t)dit * 1000U / ((uint64_t)dit + gap));
+    }
+    if (dit > 0) {
+        v->dah_ratio_x100 = clamp16((uint64_t)mean_us(a, KEY_STATS_DAH) * 100U / dit);
+    }
+    v->marks = (uint16_t)(a->count[KEY_STATS_DIT] + a->count[KEY_STATS_DAH]);
+    v->chars = (uint16_t)(a->count[KEY_STATS_GAP_CHAR] + a->count[KEY_STATS_GAP_WORD]);
+    v->words = a->count[KEY_STATS_GAP_WORD];
+}
+
+void key_stats_advance(key_stats_t *ks, int64_t now_us) {
+    if (now_us < 0) {
+        return;
+    }
+    key_stats_view_t views[KEY_STATS_CHANNELS][KEY_STATS_WINDOWS];
+    for (int ch = 0; ch < KEY_STATS_CHANNELS; ch++) {
+        key_stats_channel_t *c = &ks->ch[ch];
+        if (!c->started) {
+            channel_start(c, now_us);
+        }
+        channel_advance(c, now_us);
+        for (int w = 0; w < KEY_STATS_WINDOWS; w++) {
+            view_compute(c, w, &views[ch][w]);
+        }
+    }
+
+    /* Publish: seq odd while the views change */
+    unsigned seq = atomic_load_explicit(&ks->seq, memory_order_relaxed);
+    atomic_store_explicit(&ks->seq, seq + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(ks->view, views, sizeof(views));
+    ks->view_us = now_us;
+    atomic_store_explicit(&ks->seq, seq + 2U, memory_order_release);
+}
+
+int64_t key_stats_get(const key_stats_t *ks, uint8_t channel,
+                      key_stats_view_t out[KEY_STATS_WINDOWS]) {
+    if (channel >= KEY_STATS_CHANNELS) {
+        memset(out, 0, sizeof(key_stats_view_t) * KEY_STATS_WINDOWS);
+        return 0;
+    }
+    for (;;) {
+        unsigned s0 = atomic_load_explicit(&ks->seq, memory_order_acquire);
+        if (s0 & 1U) {
+            continue;  /* Producer mid-update (a copy, never blocks) */
+        }
+        memcpy(out, ks->view[channel], sizeof(key_stats_view_t) * KEY_STATS_WINDOWS);
+        int64_t at = ks->view_us;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&ks->seq, memory_order_relaxed) == s0) {
+            return at;
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/**
+ * @file load_shed.c
+ * @brief Overload supervisor: sheds optional Core 1 work in a fixed order
+ */
+
+#include "load_shed.h"
+#include <stdio.h>
+#include <string.h>
+
+void load_shed_init(load_shed_t *ls) {
+    if (ls == NULL) {
+        return;
+    }
+    memset(&ls->prev, 0, sizeof(ls->prev));
+    ls->prev_us = 0;
+    ls->change_us = 0;
+    ls->hot_us = 0;
+    ls->hot = 0;
+    ls->have_prev = false;
+    atomic_init(&ls->level, 0U);
+    atomic_init(&ls->why, 0U);
+    for (int s = 0; s < LOAD_SHED_STEPS; s++) {
+        atomic_init(&ls->sheds[s], 0U);
+        atomic_init(&ls->restores[s], 0U);
+    }
+}
+
+/** now - prev on a running counter; a reset counts as no change */
+static uint32_t counter_delta(uint32_t now, uint32_t prev) {
+    return (now >= prev) ? now - prev : 0U;
+}
+
+static void count(atomic_uint *c) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + 1U,
+                          memory_order_relaxed);
+}
+
+load_shed_event_t load_shed_update(load_shed_t *ls, int64_t now_us,
+                                   const load_shed_input_t *in,
+                                   const load_shed_limits_t *limits) {
+    load_shed_event_t ev = { .action = LOAD_SHED_NONE, .step = LOAD_SHED_LED, .why = 0 };
+    if (ls == NULL || in == NULL || limits == NULL) {
+        return ev;
+    }
+    if (!ls->have_prev) {
+        ls->prev = *in;
+        ls->prev_us = now_us;
+        ls->change_us = now_us;
+        ls->hot_us = now_us;
+        ls->have_prev = true;
+        return ev;
+    }
+
+    int64_t dt_us = now_us - ls->prev_us;
+    uint32_t missed = counter_delta(in->missed_ticks, ls->prev.missed_ticks);
+    if (dt_us > 0 &&
+        (uint64_t)missed * 1000000ULL > (uint64_t)limits->max_missed_per_s * (uint64_t)dt_us) {
+        ev.why |= LOAD_SHED_WHY_MISSED;
+    }
+    if (counter_delta(in->stalls, ls->prev.stalls) > 0U) {
+        ev.why |= LOAD_SHED_WHY_STALL;
+    }
+    if (in->lag > limits->max_lag) {
+        ev.why |= LOAD_SHED_WHY_LAG;
+    }
+    ls->prev = *in;
+    ls->prev_us = now_us;
+
+    unsigned level = atomic_load_explicit(&ls->level, memory_order_relaxed);
+
+    if (!limits->enabled) {
+        /* Switched off: everything comes back, one step per evaluation */
+        ls->hot = 0;
+        if (level > 0U) {
+            level--;
+            ev.action = LOAD_SHED_RESTORE;
+        }
+    } else if (ev.why != 0U) {
+        ls->hot++;
+        ls->hot_us = now_us;
+        bool settled = (level == 0U) ||
+                       (now_us - ls->change_us >= (int64_t)LOAD_SHED_STEP_MS * 1000);
+        if (ls->hot >= LOAD_SHED_HOT_EVALS && level < LOAD_SHED_STEPS && settled) {
+            ev.action = LOAD_SHED_SHED;
+            atomic_store_explicit(&ls->why, ev.why, memory_order_relaxed);
+            ev.step = (load_shed_step_t)level;
+            level++;
+        }
+    } else {
+        ls->hot = 0;
+        int64_t calm_from = (ls->hot_us > ls->change_us) ? ls->hot_us : ls->change_us;
+        if (level > 0U && now_us - calm_from >= (int64_t)LOAD_SHED_RESTORE_MS * 1000) {
+            level--;
+            ev.action = LOAD_SHED_RESTORE;
+        }
+    }
+
+    if (ev.action == LOAD_SHED_RESTORE) {
+        ev.step = (load_shed_step_t)level;
+        count(&ls->restores[level]);
+    } else if (ev.action == LOAD_SHED_SHED) {
+        count(&ls->sheds[ev.step]);
+    }
+    if (ev.action != LOAD_SHED_NONE) {
+        ls->change_us = now_us;
+        atomic_store_explicit(&ls->level, level, memory_order_relaxed);
+    }
+    return ev;
+}
+
+void load_shed_totals(const load_shed_t *ls, uint32_t *sheds, uint32_t *restores) {
+    uint32_t s = 0;
+    uint32_t r = 0;
+    for (int i = 0; i < LOAD_SHED_STEPS; i++) {
+        s += atomic_load_explicit(&ls->sheds[i], memory_order_relaxed);
+        r += atomic_load_explicit(&ls->restores[i], memory_order_relaxed);
+    }
+    if (sheds != NULL) {
+        *sheds = s;
+    }
+    if (restores != NULL) {
+        *restores = r;
+    }
+}
+
+const char *load_shed_step_str(load_shed_step_t step) {
+    switch (step) {
+        case LOAD_SHED_LED:      return "led";
+        case LOAD_SHED_TIMELINE: return "timeline";
+        case LOAD_SHED_DECODER:  return "decoder";
+        case LOAD_SHED_NVS:      return "nvs";
+        default:                 return "?";
+    }
+}
+
+const char *load_shed_why_str(unsigned why, char *buf, size_t cap) {
+    static const char *const k_names[] = { "missed", "stall", "lag" };
+    size_t len = 0;
+    if (cap == 0) {
+        return buf;
+    }
+    buf[0] = '\0';
+    for (size_t i = 0; i < sizeof(k_names) / sizeof(k_names[0]); i++) {
+        if ((why & (1U << i)) != 0U) {
+            int n = snprintf(buf + len, cap - len, "%s%s", len ? "+" : "", k_names[i]);
+            if (n < 0 || (size_t)n >= cap - len) {
+                break;
+            }
+            len += (size_t)n;
+        }
+    }
+    if (len == 0) {
+        snprintf(buf, cap, "none");
+    }
+    return buf;
+}
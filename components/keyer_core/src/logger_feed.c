@@ -0,0 +1,112 @@
+/**
+ * @file logger_feed.c
+ * @brief Logger feed datagrams: decoded text and TX/RX state over UDP
+ */
+
+#include "logger_feed.h"
+#include <stdio.h>
+#include <string.h>
+
+/** Longest event line ("W <ms> <word>\n") */
+#define LINE_MAX (24 + LOGGER_FEED_WORD_MAX)
+
+void logger_feed_batch_begin(logger_feed_batch_t *b, const logger_feed_header_t *hdr) {
+    int n = snprintf(b->buf, sizeof(b->buf), "CWKF 1 %s %lu wpm=%lu dec=%lu tx=%d rx=%d\n",
+                     (hdr->callsign != NULL && hdr->callsign[0] != '\0') ? hdr->callsign : "-",
+                     (unsigned long)hdr->seq, (unsigned long)hdr->keyer_wpm,
+                     (unsigned long)hdr->rx_wpm, hdr->tx ? 1 : 0, hdr->rx ? 1 : 0);
+    b->len = (n > 0 && (size_t)n < sizeof(b->buf)) ? (size_t)n : 0;
+    b->events = 0;
+}
+
+/** Append a formatted line if it fits whole */
+static bool append(logger_feed_batch_t *b, const char *line, int n) {
+    if (n <= 0 || (size_t)n >= LINE_MAX || b->len + (size_t)n > sizeof(b->buf)) {
+        return false;
+    }
+    memcpy(b->buf + b->len, line, (size_t)n);
+    b->len += (size_t)n;
+    b->events++;
+    return true;
+}
+
+bool logger_feed_batch_state(logger_feed_batch_t *b, char kind, int64_t ms, bool on) {
+    char line[LINE_MAX];
+    int n = snprintf(line, sizeof(line), "%c %lld %d\n", kind, (long long)ms, on ? 1 : 0);
+    return append(b, line, n);
+}
+
+bool logger_feed_batch_text(logger_feed_batch_t *b, logger_feed_words_t *w,
+                            int64_t ms, char c) {
+    char line[LINE_MAX];
+    int n;
+
+    if (c == ' ') {
+        if (w->len == 0) {
+            return true;
+        }
+        w->word[w->len] = '\0';
+        n = snprintf(line, sizeof(line), "W %lld %s\n", (long long)w->first_ms, w->word);
+        if (!append(b, line, n)) {
+            return false;
+        }
+        w->len = 0;
+        return true;
+    }
+
+    if (c < 0x21 || c > 0x7E) {
+        c = '?';
+    }
+    n = snprintf(line, sizeof(line), "C %lld %c\n", (long long)ms, c);
+    if (!append(b, line, n)) {
+        return false;
+    }
+    if (w->len == 0) {
+        w->first_ms = ms;
+    }
+    if (w->len < LOGGER_FEED_WORD_MAX) {
+        w->word[w->len++] = c;
+    }
+    return true;
+}
+
+bool logger_feed_batch_dropped(logger_feed_batch_t *b, uint32_t lost) {
+    char line[LINE_MAX];
+    int n = snprintf(line, sizeof(line), "D %lu\n", (unsigned long)lost);
+    return append(b, line, n);
+}
+
+void logger_feed_words_init(logger_feed_words_t *w) {
+    w->len = 0;
+    w->first_ms = 0;
+    w->word[0] = '\0';
+}
+
+void logger_feed_activity_init(logger_feed_activity_t *a) {
+    a->on = false;
+    a->down = false;
+    a->up_us = 0;
+}
+
+bool logger_feed_activity_edge(logger_feed_activity_t *a, int64_t time_us, bool down) {
+    a->down = down;
+    if (!down) {
+        a->up_us = time_us;
+        return false;
+    }
+    if (a->on) {
+        return false;
+    }
+    a->on = true;
+    return true;
+}
+
+bool logger_feed_activity_poll(logger_feed_activity_t *a, int64_t now_us, int64_t hold_us,
+                               int64_t *stop_us) {
+    if (!a->on || a->down || now_us - a->up_us < hold_us) {
+        return false;
+    }
+    a->on = false;
+    *stop_us = a->up_us;
+    return true;
+}
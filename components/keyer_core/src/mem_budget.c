@@ -0,0 +1,101 @@
+/**
+ * @file mem_budget.c
+ * @brief Heap budget per memory capability
+ */
+
+#include "mem_budget.h"
+#include <stdbool.h>
+#include <string.h>
+
+void mem_budget_init(mem_budget_t *b) {
+    if (b == NULL) {
+        return;
+    }
+    memset(b, 0, sizeof(*b));
+}
+
+void mem_budget_record(mem_budget_t *b, uint32_t now_s,
+                       const mem_cap_sample_t caps[MEM_CAP_COUNT]) {
+    if (b == NULL || caps == NULL) {
+        return;
+    }
+
+    /* Close the window before folding in a sample that lies past it */
+    bool open = b->samples > 0U;
+    if (open && now_s - b->window_start_s >= MEM_BUDGET_WINDOW_S) {
+        uint32_t w = atomic_load_explicit(&b->windows, memory_order_relaxed);
+        for (int c = 0; c < MEM_CAP_COUNT; c++) {
+            mem_cap_stats_t *st = &b->cap[c];
+            uint32_t low = atomic_load_explicit(&st->window_low, memory_order_relaxed);
+            atomic_store_explicit(&st->history[w % MEM_BUDGET_HISTORY], low,
+                                  memory_order_relaxed);
+        }
+        atomic_store_explicit(&b->windows, w + 1U, memory_order_release);
+        open = false;
+    }
+    if (!open) {
+        b->window_start_s = now_s;
+    }
+
+    for (int c = 0; c < MEM_CAP_COUNT; c++) {
+        mem_cap_stats_t *st = &b->cap[c];
+        const mem_cap_sample_t *s = &caps[c];
+        atomic_store_explicit(&st->total, s->total, memory_order_relaxed);
+        atomic_store_explicit(&st->free, s->free, memory_order_relaxed);
+        atomic_store_explicit(&st->largest, s->largest, memory_order_relaxed);
+        atomic_store_explicit(&st->min_free, s->min_free, memory_order_relaxed);
+        uint32_t low = atomic_load_explicit(&st->window_low, memory_order_relaxed);
+        if (!open || s->free < low) {
+            atomic_store_explicit(&st->window_low, s->free, memory_order_relaxed);
+        }
+    }
+    b->samples++;
+}
+
+void mem_budget_get(const mem_budget_t *b, mem_cap_t cap, mem_cap_sample_t *out) {
+    if (out == NULL) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (b == NULL || cap >= MEM_CAP_COUNT) {
+        return;
+    }
+    const mem_cap_stats_t *st = &b->cap[cap];
+    out->total = atomic_load_explicit(&st->total, memory_order_relaxed);
+    out->free = atomic_load_explicit(&st->free, memory_order_relaxed);
+    out->largest = atomic_load_explicit(&st->largest, memory_order_relaxed);
+    out->min_free = atomic_load_explicit(&st->min_free, memory_order_relaxed);
+}
+
+size_t mem_budget_history(const mem_budget_t *b, mem_cap_t cap, uint32_t *out, size_t max) {
+    if (b == NULL || out == NULL || cap >= MEM_CAP_COUNT) {
+        return 0;
+    }
+    uint32_t w = atomic_load_explicit(&b->windows, memory_order_acquire);
+    uint32_t n = (w < MEM_BUDGET_HISTORY) ? w : MEM_BUDGET_HISTORY;
+    if (n > max) {
+        n = (uint32_t)max;
+    }
+    const mem_cap_stats_t *st = &b->cap[cap];
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = atomic_load_explicit(&st->history[(w - n + i) % MEM_BUDGET_HISTORY],
+                                      memory_order_relaxed);
+    }
+    return n;
+}
+
+uint32_t mem_budget_window_low(const mem_budget_t *b, mem_cap_t cap) {
+    if (b == NULL || cap >= MEM_CAP_COUNT) {
+        return 0;
+    }
+    return atomic_load_explicit(&b->cap[cap].window_low, memory_order_relaxed);
+}
+
+const char *mem_cap_str(mem_cap_t cap) {
+    switch (cap) {
+        case MEM_CAP_INTERNAL: return "internal";
+        case MEM_CAP_DMA:      return "dma";
+        case MEM_CAP_PSRAM:    return "psram";
+        default:               return "?";
+    }
+}
@@ -0,0 +1,184 @@
+/**
+ * @file metrics.c
+ * @brief Metrics registry rendered in the Prometheus text format
+ */
+
+#include "metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <inttypes.h>
+
+void metrics_init(metrics_t *m) {
+    atomic_init(&m->count, 0U);
+    for (size_t i = 0; i < METRICS_MAX; i++) {
+        atomic_init(&m->slots[i], NULL);
+    }
+}
+
+bool metrics_register(metrics_t *m, const metric_desc_t *desc) {
+    unsigned id = atomic_fetch_add_explicit(&m->count, 1U, memory_order_relaxed);
+    if (id >= METRICS_MAX) {
+        return false;
+    }
+    atomic_store_explicit(&m->slots[id], desc, memory_order_release);
+    return true;
+}
+
+size_t metrics_register_all(metrics_t *m, const metric_desc_t *descs, size_t n) {
+    size_t done = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (metrics_register(m, &descs[i])) {
+            done++;
+        }
+    }
+    return done;
+}
+
+int64_t metrics_read(const metric_desc_t *desc) {
+    if (desc->read != NULL) {
+        return desc->read(desc->ctx);
+    }
+    if (desc->ctx == NULL) {
+        return 0;
+    }
+    return (int64_t)atomic_load_explicit((const atomic_uint *)desc->ctx, memory_order_relaxed);
+}
+
+/**
+ * @brief Output buffer state
+ */
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t used;
+    metrics_write_fn_t write;
+    void *ctx;
+    bool ok;
+} render_out_t;
+
+static void flush(render_out_t *out) {
+    if (out->ok && out->used > 0) {
+        out->ok = out->write(out->ctx, out->buf, out->used);
+    }
+    out->used = 0;
+}
+
+/**
+ * @brief Append one line, flushing first if it does not fit
+ */
+static void put_line(render_out_t *out, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void put_line(render_out_t *out, const char *fmt, ...) {
+    for (int attempt = 0; attempt < 2 && out->ok; attempt++) {
+        va_list ap;
+        va_start(ap, fmt);
+        int len = vsnprintf(out->buf + out->used, out->cap - out->used, fmt, ap);
+        va_end(ap);
+        if (len < 0) {
+            return;
+        }
+        if ((size_t)len < out->cap - out->used) {
+            out->used += (size_t)len;
+            return;
+        }
+        if (out->used == 0) {
+            return;  /* Longer than the whole buffer: skip it */
+        }
+        flush(out);
+    }
+}
+
+static bool same_family(const char *a, const char *b, size_t len) {
+    return strcspn(b, "{") == len && memcmp(a, b, len) == 0;
+}
+
+bool metrics_render(const metrics_t *m, char *buf, size_t cap,
+                    metrics_write_fn_t write, void *ctx) {
+    render_out_t out = { .buf = buf, .cap = cap, .used = 0, .write = write, .ctx = ctx,
+                         .ok = cap > 0 };
+    const metric_desc_t *descs[METRICS_MAX];
+
+    unsigned count = atomic_load_explicit(&m->count, memory_order_relaxed);
+    if (count > METRICS_MAX) {
+        count = METRICS_MAX;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        descs[i] = atomic_load_explicit(&m->slots[i], memory_order_acquire);
+    }
+
+    /* Each family at its first metric, all its labelled series together */
+    for (unsigned i = 0; i < count && out.ok; i++) {
+        if (descs[i] == NULL) {
+            continue;
+        }
+        const char *name = descs[i]->name;
+        size_t fam_len = strcspn(name, "{");
+        bool seen = false;
+        for (unsigned j = 0; j < i && !seen; j++) {
+            seen = descs[j] != NULL && same_family(name, descs[j]->name, fam_len);
+        }
+        if (seen) {
+            continue;
+        }
+
+        int fam = (int)fam_len;
+        if (descs[i]->help != NULL) {
+            put_line(&out, "# HELP %.*s %s\n", fam, name, descs[i]->help);
+        }
+        put_line(&out, "# TYPE %.*s %s\n", fam, name,
+                 descs[i]->type == METRIC_COUNTER ? "counter" : "gauge");
+        for (unsigned k = i; k < count; k++) {
+            if (descs[k] != NULL && same_family(name, descs[k]->name, fam_len)) {
+                put_line(&out, "%s %" PRId64 "\n", descs[k]->name, metrics_read(descs[k]));
+            }
+        }
+    }
+    flush(&out);
+    return out.ok;
+}
+
+size_t metrics_render_json(const metrics_t *m, char *buf, size_t cap) {
+    static const char k_prefix[] = "keyer_";
+    size_t used = 0;
+
+    if (cap < 3) {
+        return 0;
+    }
+    buf[used++] = '{';
+    unsigned count = atomic_load_explicit(&m->count, memory_order_relaxed);
+    if (count > METRICS_MAX) {
+        count = METRICS_MAX;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        const metric_desc_t *desc = atomic_load_explicit(&m->slots[i], memory_order_acquire);
+        if (desc == NULL) {
+            continue;
+        }
+        const char *name = desc->name;
+        if (strncmp(name, k_prefix, sizeof(k_prefix) - 1) == 0) {
+            name += sizeof(k_prefix) - 1;
+        }
+        if (used > 1) {
+            buf[used++] = ',';
+        }
+        buf[used++] = '"';
+        for (; *name != '\0' && used < cap; name++) {
+            if (*name != '"' && *name != '\\') {
+                buf[used++] = *name;
+            }
+        }
+        if (used >= cap) {
+            return 0;
+        }
+        int len = snprintf(buf + used, cap - used, "\":%" PRId64, metrics_read(desc));
+        if (len < 0 || (size_t)len + 2 > cap - used) {
+            return 0;   /* Room for "," or the closing brace, and the NUL */
+        }
+        used += (size_t)len;
+    }
+    buf[used++] = '}';
+    buf[used] = '\0';
+    return used;
+}
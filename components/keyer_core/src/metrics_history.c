@@ -0,0 +1,193 @@
+/**
+ * @file metrics_history.c
+ * @brief Fixed-memory history of every registered metric
+ */
+
+#include "metrics_history.h"
+#include <string.h>
+
+static const uint32_t k_step_s[METRICS_HISTORY_LEVELS] = { 1U, 60U, 900U };
+static const char *const k_level_names[METRICS_HISTORY_LEVELS] = { "1s", "1m", "15m" };
+
+static int32_t clamp32(int64_t v) {
+    if (v > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (v < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)v;
+}
+
+static void acc_reset(metrics_history_acc_t *a) {
+    a->min = INT64_MAX;
+    a->max = INT64_MIN;
+    a->sum = 0;
+    a->n = 0;
+}
+
+void metrics_history_init(metrics_history_t *h) {
+    memset(h, 0, sizeof(*h));
+    for (uint32_t l = 0; l < METRICS_HISTORY_LEVELS; l++) {
+        atomic_init(&h->levels[l].head, 0U);
+        for (uint32_t s = 0; s < METRICS_HISTORY_SERIES; s++) {
+            acc_reset(&h->levels[l].acc[s]);
+        }
+    }
+}
+
+uint32_t metrics_history_step_s(uint32_t level) {
+    return (level < METRICS_HISTORY_LEVELS) ? k_step_s[level] : 0U;
+}
+
+int metrics_history_level_from_str(const char *s) {
+    for (uint32_t l = 0; l < METRICS_HISTORY_LEVELS; l++) {
+        if (strcmp(s, k_level_names[l]) == 0) {
+            return (int)l;
+        }
+    }
+    return -1;
+}
+
+const char *metrics_history_level_str(uint32_t level) {
+    return (level < METRICS_HISTORY_LEVELS) ? k_level_names[level] : "?";
+}
+
+/**
+ * @brief Publish the open bucket of a level and start an empty one
+ */
+static void close_bucket(metrics_history_level_t *lv) {
+    uint32_t head = atomic_load_explicit(&lv->head, memory_order_relaxed);
+    uint32_t slot = head % METRICS_HISTORY_CAPACITY;
+
+    lv->time_s[slot] = lv->open_s;
+    for (uint32_t s = 0; s < METRICS_HISTORY_SERIES; s++) {
+        metrics_history_acc_t *a = &lv->acc[s];
+        metrics_history_bucket_t *b = &lv->ring[slot][s];
+        if (a->n == 0) {
+            b->min = INT32_MAX;
+            b->max = INT32_MIN;
+            b->avg = 0;
+        } else {
+            b->min = clamp32(a->min);
+            b->max = clamp32(a->max);
+            b->avg = clamp32(a->sum / (int64_t)a->n);
+        }
+        acc_reset(a);
+    }
+    lv->open = false;
+    atomic_store_explicit(&lv->head, head + 1U, memory_order_release);
+}
+
+void metrics_history_sample(metrics_history_t *h, const metrics_t *m, uint32_t now_s) {
+    for (uint32_t l = 0; l < METRICS_HISTORY_LEVELS; l++) {
+        metrics_history_level_t *lv = &h->levels[l];
+        uint32_t start = now_s - now_s % k_step_s[l];
+        if (lv->open && start != lv->open_s) {
+            close_bucket(lv);
+        }
+        lv->open_s = start;
+        lv->open = true;
+    }
+
+    unsigned count = atomic_load_explicit(&m->count, memory_order_acquire);
+    if (count > METRICS_HISTORY_SERIES) {
+        count = METRICS_HISTORY_SERIES;
+    }
+    uint32_t dt = now_s - h->prev_s;
+
+    for (unsigned s = 0; s < count; s++) {
+        const metric_desc_t *desc = atomic_load_explicit(&m->slots[s], memory_order_acquire);
+        if (desc == NULL) {
+            continue;
+        }
+        int64_t v = metrics_read(desc);
+
+        if (desc->type == METRIC_COUNTER) {
+            /* Increase per second; the first reading only sets the base */
+            bool first = !h->have_prev[s];
+            int64_t delta = v - h->prev[s];
+            h->prev[s] = v;
+            h->have_prev[s] = true;
+            if (first || dt == 0) {
+                continue;
+            }
+            v = (delta > 0) ? delta / (int64_t)dt : 0;
+        }
+
+        for (uint32_t l = 0; l < METRICS_HISTORY_LEVELS; l++) {
+            metrics_history_acc_t *a = &h->levels[l].acc[s];
+            if (v < a->min) {
+                a->min = v;
+            }
+            if (v > a->max) {
+                a->max = v;
+            }
+            a->sum += v;
+            a->n++;
+        }
+    }
+    h->prev_s = now_s;
+}
+
+size_t metrics_history_read(const metrics_history_t *h, uint32_t level, uint32_t series,
+                            uint32_t from_s, metrics_history_point_t *out, size_t max) {
+    if (level >= METRICS_HISTORY_LEVELS || series >= METRICS_HISTORY_SERIES) {
+        return 0;
+    }
+    const metrics_history_level_t *lv = &h->levels[level];
+
+    /* The slot of sequence head - CAPACITY is the one the writer fills next */
+    uint32_t head = atomic_load_explicit(&lv->head, memory_order_acquire);
+    uint32_t oldest = (head >= METRICS_HISTORY_CAPACITY) ? head - METRICS_HISTORY_CAPACITY + 1U : 0U;
+
+    size_t n = 0;
+    for (uint32_t seq = oldest; seq != head && n < max; seq++) {
+        uint32_t slot = seq % METRICS_HISTORY_CAPACITY;
+        metrics_history_point_t p = {
+            .time_s = lv->time_s[slot],
+            .min = lv->ring[slot][series].min,
+            .max = lv->ring[slot][series].max,
+            .avg = lv->ring[slot][series].avg,
+        };
+        /* Lapped while copying: the writer is on this slot or past it */
+        if (seq + METRICS_HISTORY_CAPACITY <= atomic_load_explicit(&lv->head, memory_order_acquire)) {
+            continue;
+        }
+        if (p.time_s < from_s || p.min > p.max) {
+            continue;
+        }
+        out[n++] = p;
+    }
+    return n;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+size_t metrics_history_encode(uint32_t level, const metrics_history_point_t *pts, size_t n,
+                              uint8_t *buf, size_t cap) {
+    size_t len = METRICS_HISTORY_BIN_HEADER + n * METRICS_HISTORY_BIN_RECORD;
+    if (len > cap) {
+        return 0;
+    }
+    uint8_t *p = buf;
+    *p++ = 'M';
+    *p++ = 'H';
+    *p++ = (uint8_t)METRICS_HISTORY_BIN_VERSION;
+    *p++ = (uint8_t)level;
+    p = put_u32(p, metrics_history_step_s(level));
+    p = put_u32(p, (uint32_t)n);
+    for (size_t i = 0; i < n; i++) {
+        p = put_u32(p, pts[i].time_s);
+        p = put_u32(p, (uint32_t)pts[i].min);
+        p = put_u32(p, (uint32_t)pts[i].max);
+        p = put_u32(p, (uint32_t)pts[i].avg);
+    }
+    return len;
+}
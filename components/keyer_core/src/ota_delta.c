@@ -0,0 +1,181 @@
+/**
+ * @file ota_delta.c
+ * @brief Delta firmware patch decoder
+ */
+
+#include "ota_delta.h"
+#include <string.h>
+
+enum {
+    ST_OP = 0,      /* Expecting an op code */
+    ST_ARGS,        /* Collecting the op's arguments */
+    ST_DATA,        /* ADD/INSERT data bytes */
+    ST_DONE,
+    ST_ERROR,
+};
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool ota_delta_parse_header(const uint8_t *buf, ota_delta_header_t *out) {
+    if (rd32(buf) != OTA_DELTA_MAGIC ||
+        ((uint32_t)buf[4] | ((uint32_t)buf[5] << 8)) != OTA_DELTA_VERSION) {
+        return false;
+    }
+    out->old_size = rd32(buf + 8);
+    out->new_size = rd32(buf + 12);
+    memcpy(out->old_sha, buf + 16, OTA_SHA256_LEN);
+    memcpy(out->new_sha, buf + 16 + OTA_SHA256_LEN, OTA_SHA256_LEN);
+    return true;
+}
+
+void ota_delta_init(ota_delta_t *d, const ota_delta_header_t *hdr,
+                    ota_delta_read_fn read, ota_delta_write_fn write, void *ctx) {
+    memset(d, 0, sizeof(*d));
+    d->hdr = *hdr;
+    d->read = read;
+    d->write = write;
+    d->ctx = ctx;
+    d->state = ST_OP;
+}
+
+/**
+ * @brief Check an old range and the room left in the new image
+ */
+static bool range_ok(const ota_delta_t *d, uint32_t off, uint32_t len) {
+    return off <= d->hdr.old_size && len <= d->hdr.old_size - off &&
+           len <= d->hdr.new_size - d->produced;
+}
+
+static bool emit(ota_delta_t *d, const uint8_t *buf, size_t len) {
+    if (!d->write(d->ctx, buf, len)) {
+        return false;
+    }
+    d->produced += (uint32_t)len;
+    return true;
+}
+
+static bool do_copy(ota_delta_t *d, uint32_t off, uint32_t len) {
+    while (len > 0) {
+        size_t n = (len < OTA_DELTA_SCRATCH) ? len : OTA_DELTA_SCRATCH;
+        if (!d->read(d->ctx, off, d->scratch, n) || !emit(d, d->scratch, n)) {
+            return false;
+        }
+        off += (uint32_t)n;
+        len -= (uint32_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief Apply ADD difference bytes to the old image at old_pos
+ */
+static bool do_add(ota_delta_t *d, const uint8_t *diff, size_t len) {
+    while (len > 0) {
+        size_t n = (len < OTA_DELTA_SCRATCH) ? len : OTA_DELTA_SCRATCH;
+        if (!d->read(d->ctx, d->old_pos, d->scratch, n)) {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            d->scratch[i] = (uint8_t)(d->scratch[i] + diff[i]);
+        }
+        if (!emit(d, d->scratch, n)) {
+            return false;
+        }
+        d->old_pos += (uint32_t)n;
+        diff += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief Arguments complete: run COPY, or set up ADD/INSERT data
+ */
+static bool start_op(ota_delta_t *d) {
+    switch (d->op) {
+        case OTA_DELTA_OP_COPY: {
+            uint32_t off = rd32(d->args);
+            uint32_t len = rd32(d->args + 4);
+            if (!range_ok(d, off, len) || !do_copy(d, off, len)) {
+                return false;
+            }
+            d->state = ST_OP;
+            return true;
+        }
+        case OTA_DELTA_OP_ADD:
+            d->old_pos = rd32(d->args);
+            d->remaining = rd32(d->args + 4);
+            if (!range_ok(d, d->old_pos, d->remaining)) {
+                return false;
+            }
+            break;
+        default:   /* INSERT */
+            d->remaining = rd32(d->args);
+            if (d->remaining > d->hdr.new_size - d->produced) {
+                return false;
+            }
+            break;
+    }
+    d->state = (d->remaining > 0) ? ST_DATA : ST_OP;
+    return true;
+}
+
+static size_t args_for(uint8_t op) {
+    return (op == OTA_DELTA_OP_INSERT) ? 4U : 8U;
+}
+
+ota_delta_status_t ota_delta_feed(ota_delta_t *d, const uint8_t *data, size_t len) {
+    size_t i = 0;
+    while (i < len && d->state != ST_ERROR) {
+        switch (d->state) {
+            case ST_OP:
+                d->op = data[i++];
+                d->arg_len = 0;
+                if (d->op == OTA_DELTA_OP_END) {
+                    d->state = (d->produced == d->hdr.new_size) ? ST_DONE : ST_ERROR;
+                } else if (d->op > OTA_DELTA_OP_INSERT) {
+                    d->state = ST_ERROR;
+                } else {
+                    d->state = ST_ARGS;
+                }
+                break;
+
+            case ST_ARGS: {
+                size_t need = args_for(d->op) - d->arg_len;
+                size_t take = (len - i < need) ? len - i : need;
+                memcpy(d->args + d->arg_len, data + i, take);
+                d->arg_len = (uint8_t)(d->arg_len + take);
+                i += take;
+                if (d->arg_len == args_for(d->op) && !start_op(d)) {
+                    d->state = ST_ERROR;
+                }
+                break;
+            }
+
+            case ST_DATA: {
+                size_t take = (len - i < d->remaining) ? len - i : d->remaining;
+                bool ok = (d->op == OTA_DELTA_OP_ADD) ? do_add(d, data + i, take)
+                                                      : emit(d, data + i, take);
+                i += take;
+                d->remaining -= (uint32_t)take;
+                if (!ok) {
+                    d->state = ST_ERROR;
+                } else if (d->remaining == 0) {
+                    d->state = ST_OP;
+                }
+                break;
+            }
+
+            default:   /* ST_DONE: nothing may follow END */
+                d->state = ST_ERROR;
+                break;
+        }
+    }
+    if (d->state == ST_ERROR) {
+        return OTA_DELTA_ERROR;
+    }
+    return (d->state == ST_DONE) ? OTA_DELTA_DONE : OTA_DELTA_MORE;
+}
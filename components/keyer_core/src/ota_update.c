@@ -0,0 +1,70 @@
+/**
+ * @file ota_update.c
+ * @brief Streamed firmware update bookkeeping
+ */
+
+#include "ota_update.h"
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool ota_parse_sha256(const char *hex, uint8_t out[OTA_SHA256_LEN]) {
+    for (size_t i = 0; i < OTA_SHA256_LEN; i++) {
+        int hi = hex_digit(hex[2 * i]);
+        int lo = (hi < 0) ? -1 : hex_digit(hex[2 * i + 1]);
+        if (lo < 0) {
+            return false;
+        }
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return hex[2 * OTA_SHA256_LEN] == '\0';
+}
+
+void ota_progress_init(ota_progress_t *p, uint32_t total) {
+    p->total = total;
+    p->reported_pct = 0;
+    p->reported_us = 0;
+    p->started = false;
+}
+
+bool ota_progress_step(ota_progress_t *p, uint32_t written, int64_t now_us, uint32_t *pct) {
+    uint32_t cur = (p->total == 0) ? 100U
+                 : (uint32_t)(((uint64_t)written * 100U) / p->total);
+    if (cur > 100U) {
+        cur = 100U;
+    }
+    *pct = cur;
+
+    bool done = (written >= p->total);
+    bool due = !p->started || done ||
+               (cur >= p->reported_pct + OTA_PROGRESS_STEP_PCT &&
+                now_us - p->reported_us >= OTA_PROGRESS_MIN_US);
+    if (!due || (p->started && done && p->reported_pct == 100U)) {
+        return false;
+    }
+    p->started = true;
+    p->reported_pct = cur;
+    p->reported_us = now_us;
+    return true;
+}
+
+ota_verdict_t ota_self_test_judge(const ota_health_t *h) {
+    bool healthy = !h->fault_active && h->heap_free >= OTA_SELF_TEST_MIN_HEAP && h->reachable;
+    if (healthy && h->uptime_ms >= OTA_SELF_TEST_MS) {
+        return OTA_VERDICT_PASS;
+    }
+    if (h->uptime_ms >= OTA_SELF_TEST_DEADLINE_MS) {
+        return OTA_VERDICT_FAIL;
+    }
+    return OTA_VERDICT_PENDING;
+}
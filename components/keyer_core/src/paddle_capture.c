@@ -0,0 +1,70 @@
+/**
+ * @file paddle_capture.c
+ * @brief Debounce of hardware-captured paddle edges
+ *
+ * Runs in the RT task only; the capture ISR side is inline in the header.
+ */
+
+#include "paddle_capture.h"
+#include <stddef.h>
+
+void paddle_debounce_init(paddle_debounce_t *d, uint32_t debounce_us) {
+    if (d == NULL) {
+        return;
+    }
+    d->debounce_us = debounce_us;
+    for (int p = 0; p < 2; p++) {
+        d->level[p] = 0;
+        d->raw[p] = 0;
+        d->quiet_us[p] = 0;
+    }
+    d->last_out_us = 0;
+    d->accepted = 0;
+    d->rejected = 0;
+}
+
+static void accept(paddle_debounce_t *d, uint8_t paddle, uint8_t level, int64_t t,
+                   paddle_edge_queue_t *out) {
+    if (t < d->last_out_us) {
+        t = d->last_out_us;
+    }
+    paddle_edge_t edge = { .timestamp_us = t, .paddle = paddle, .level = level };
+    (void)paddle_edge_push(out, &edge);
+    d->level[paddle] = level;
+    d->quiet_us[paddle] = t + (int64_t)d->debounce_us;
+    d->last_out_us = t;
+    d->accepted++;
+}
+
+void paddle_debounce_settle(paddle_debounce_t *d, int64_t now_us, paddle_edge_queue_t *out) {
+    /* At most one settle per paddle, earliest window first */
+    for (;;) {
+        int pick = -1;
+        for (int p = 0; p < 2; p++) {
+            if (d->raw[p] != d->level[p] && d->quiet_us[p] <= now_us &&
+                (pick < 0 || d->quiet_us[p] < d->quiet_us[pick])) {
+                pick = p;
+            }
+        }
+        if (pick < 0) {
+            return;
+        }
+        accept(d, (uint8_t)pick, d->raw[pick], d->quiet_us[pick], out);
+    }
+}
+
+void paddle_debounce_feed(paddle_debounce_t *d, const paddle_edge_t *raw,
+                          paddle_edge_queue_t *out) {
+    uint8_t p = raw->paddle & 1U;
+    uint8_t level = (raw->level != 0) ? 1U : 0U;
+    int64_t t = raw->timestamp_us;
+
+    paddle_debounce_settle(d, t, out);
+
+    d->raw[p] = level;
+    if (t < d->quiet_us[p]) {
+        d->rejected++;
+    } else if (level != d->level[p]) {
+        accept(d, p, level, t, out);
+    }
+}
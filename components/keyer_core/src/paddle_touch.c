@@ -0,0 +1,53 @@
+/**
+ * @file paddle_touch.c
+ * @brief Touch paddle scan plan
+ */
+
+#include "paddle_touch.h"
+#include <stddef.h>
+
+#define NS_PER_S 1000000000ULL
+
+void paddle_touch_scan_plan(paddle_touch_scan_t *plan, uint32_t budget_us, uint8_t pads) {
+    if (plan == NULL) {
+        return;
+    }
+    if (pads < 1U) {
+        pads = 1U;
+    }
+
+    /* Every sample of the filter chain costs one scan */
+    uint64_t scan_ns = (uint64_t)budget_us * 1000ULL / PADDLE_TOUCH_FILTER_SAMPLES;
+    uint64_t cycle_ns = (uint64_t)pads * PADDLE_TOUCH_CYCLE_NS;
+
+    uint64_t meas = PADDLE_TOUCH_MEAS_DEFAULT;
+    if (meas * cycle_ns > scan_ns) {
+        meas = scan_ns / cycle_ns;
+    }
+    if (meas < PADDLE_TOUCH_MEAS_MIN) {
+        meas = PADDLE_TOUCH_MEAS_MIN;
+    }
+    uint64_t meas_ns = meas * cycle_ns;
+
+    /* Sleep for the rest, rounded down to whole slow clock cycles */
+    uint64_t sleep_ns = (scan_ns > meas_ns) ? scan_ns - meas_ns : 0U;
+    uint64_t sleep = sleep_ns * PADDLE_TOUCH_SLOW_CLK_HZ / NS_PER_S;
+    if (sleep < 1U) {
+        sleep = 1U;
+    }
+    if (sleep > 0xFFFFU) {
+        sleep = 0xFFFFU;
+    }
+    sleep_ns = (sleep * NS_PER_S + PADDLE_TOUCH_SLOW_CLK_HZ - 1U) / PADDLE_TOUCH_SLOW_CLK_HZ;
+
+    uint64_t period_ns = meas_ns + sleep_ns;
+    plan->meas_cycles = (uint16_t)meas;
+    plan->sleep_cycles = (uint16_t)sleep;
+    plan->scan_us = (uint32_t)((period_ns + 999U) / 1000U);
+    plan->latency_us = (uint32_t)((period_ns * PADDLE_TOUCH_FILTER_SAMPLES + 999U) / 1000U);
+}
+
+uint32_t paddle_touch_threshold(uint32_t benchmark, uint8_t pct) {
+    uint32_t thr = (uint32_t)((uint64_t)benchmark * pct / 100U);
+    return (thr > 0U) ? thr : 1U;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file radio_focus.c
+ * @brief SO2R radio focus
+ */
+
+#include "radio_focus.h"
+#include <stddef.h>
+
+radio_focus_t g_radio_focus;
+
+void radio_focus_init(radio_focus_t *rf, uint8_t count) {
+    if (rf == NULL) {
+        return;
+    }
+    if (count < 1U) count = 1U;
+    if (count > RADIO_FOCUS_MAX) count = (uint8_t)RADIO_FOCUS_MAX;
+    rf->count = count;
+    atomic_store_explicit(&rf->active, 0, memory_order_relaxed);
+    atomic_store_explicit(&rf->requested, 0, memory_order_relaxed);
+    atomic_store_explicit(&rf->switches, 0, memory_order_relaxed);
+}
+
+void radio_focus_request(radio_focus_t *rf, uint8_t radio) {
+    if (rf == NULL || radio >= RADIO_FOCUS_MAX) {
+        return;
+    }
+    atomic_store_explicit(&rf->requested, radio, memory_order_relaxed);
+}
+
+void radio_focus_get(const radio_focus_t *rf, radio_focus_stats_t *out) {
+    if (rf == NULL || out == NULL) {
+        return;
+    }
+    out->count = rf->count;
+    out->active = (uint8_t)atomic_load_explicit(&rf->active, memory_order_relaxed);
+    out->requested = (uint8_t)atomic_load_explicit(&rf->requested, memory_order_relaxed);
+    out->available = out->requested < rf->count;
+    out->switches = atomic_load_explicit(&rf->switches, memory_order_relaxed);
+}
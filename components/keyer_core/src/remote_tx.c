@@ -0,0 +1,138 @@
+/**
+ * @file remote_tx.c
+ * @brief Tick-exact playout of received keying
+ *
+ * Everything is written by the RT task; statistics are relaxed atomics so
+ * the console never sees a torn word.
+ */
+
+#include "remote_tx.h"
+#include "sample.h"
+#include <stddef.h>
+
+#define REMOTE_TX_MASK (REMOTE_TX_QUEUE - 1U)
+
+_Static_assert((REMOTE_TX_QUEUE & (REMOTE_TX_QUEUE - 1U)) == 0,
+               "REMOTE_TX_QUEUE must be power of 2");
+
+remote_tx_t g_remote_tx;
+
+static void count(atomic_uint *counter) {
+    uint32_t n = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, n + 1U, memory_order_relaxed);
+}
+
+static uint32_t ticks32(uint64_t ticks) {
+    return (ticks >= UINT32_MAX) ? UINT32_MAX : (uint32_t)ticks;
+}
+
+void remote_tx_init(remote_tx_t *rt, uint32_t watchdog_ticks) {
+    if (rt == NULL) {
+        return;
+    }
+    rt->head = 0;
+    rt->tail = 0;
+    rt->watchdog_ticks = watchdog_ticks;
+    rt->now_tick = 0;
+    rt->down_tick = 0;
+    rt->edge_tick = 0;
+    rt->key_down = false;
+    rt->tripped = false;
+    atomic_store_explicit(&rt->events, 0, memory_order_relaxed);
+    atomic_store_explicit(&rt->late, 0, memory_order_relaxed);
+    atomic_store_explicit(&rt->late_max_ticks, 0, memory_order_relaxed);
+    atomic_store_explicit(&rt->lead_min_ticks, UINT32_MAX, memory_order_relaxed);
+    atomic_store_explicit(&rt->overflow, 0, memory_order_relaxed);
+    atomic_store_explicit(&rt->watchdog, 0, memory_order_relaxed);
+}
+
+void remote_tx_event(remote_tx_t *rt, bool key_down, uint32_t tick32) {
+    if (rt->head - rt->tail >= REMOTE_TX_QUEUE) {
+        /* Too far behind to play in time: fail safe, key up */
+        count(&rt->overflow);
+        remote_tx_release(rt);
+        return;
+    }
+
+    uint64_t tick = sample_resolve_tick(rt->now_tick, tick32);
+    uint32_t lead = (tick > rt->now_tick) ? ticks32(tick - rt->now_tick) : 0U;
+    if (lead < atomic_load_explicit(&rt->lead_min_ticks, memory_order_relaxed)) {
+        atomic_store_explicit(&rt->lead_min_ticks, lead, memory_order_relaxed);
+    }
+
+    remote_tx_event_t *ev = &rt->queue[rt->head & REMOTE_TX_MASK];
+    ev->tick = tick;
+    ev->key_down = key_down;
+    rt->head++;
+    count(&rt->events);
+}
+
+/** Apply one due event */
+static void play(remote_tx_t *rt, const remote_tx_event_t *ev, uint64_t now_tick) {
+    uint64_t at = ev->tick;
+    if (at < now_tick) {
+        uint32_t behind = ticks32(now_tick - at);
+        count(&rt->late);
+        if (behind > atomic_load_explicit(&rt->late_max_ticks, memory_order_relaxed)) {
+            atomic_store_explicit(&rt->late_max_ticks, behind, memory_order_relaxed);
+        }
+        at = now_tick;
+    }
+
+    if (!ev->key_down) {
+        rt->tripped = false;
+    } else if (rt->tripped) {
+        return;  /* Released by the watchdog: wait for key up */
+    }
+    if (ev->key_down != rt->key_down) {
+        rt->key_down = ev->key_down;
+        rt->edge_tick = at;
+        if (ev->key_down) {
+            rt->down_tick = at;
+        }
+    }
+}
+
+bool remote_tx_tick(remote_tx_t *rt, uint64_t now_tick) {
+    rt->now_tick = now_tick;
+
+    while (rt->tail != rt->head) {
+        const remote_tx_event_t *ev = &rt->queue[rt->tail & REMOTE_TX_MASK];
+        if (ev->tick > now_tick) {
+            break;
+        }
+        play(rt, ev, now_tick);
+        rt->tail++;
+    }
+
+    if (rt->key_down && rt->watchdog_ticks > 0 &&
+        now_tick - rt->down_tick >= rt->watchdog_ticks) {
+        rt->key_down = false;
+        rt->tripped = true;
+        rt->edge_tick = now_tick;
+        count(&rt->watchdog);
+    }
+    return rt->key_down;
+}
+
+void remote_tx_release(remote_tx_t *rt) {
+    rt->tail = rt->head;
+    if (rt->key_down) {
+        rt->key_down = false;
+        rt->edge_tick = rt->now_tick;
+    }
+    rt->tripped = false;
+}
+
+void remote_tx_get(const remote_tx_t *rt, remote_tx_stats_t *out) {
+    if (rt == NULL || out == NULL) {
+        return;
+    }
+    out->events = atomic_load_explicit(&rt->events, memory_order_relaxed);
+    out->late = atomic_load_explicit(&rt->late, memory_order_relaxed);
+    out->late_max_ticks = atomic_load_explicit(&rt->late_max_ticks, memory_order_relaxed);
+    out->lead_min_ticks = atomic_load_explicit(&rt->lead_min_ticks, memory_order_relaxed);
+    out->overflow = atomic_load_explicit(&rt->overflow, memory_order_relaxed);
+    out->watchdog = atomic_load_explicit(&rt->watchdog, memory_order_relaxed);
+    out->watchdog_ticks = rt->watchdog_ticks;
+}
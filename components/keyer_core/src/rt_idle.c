@@ -0,0 +1,89 @@
+/**
+ * @file rt_idle.c
+ * @brief RT loop idle tracking for tickless light sleep
+ *
+ * Everything is written by the RT task; statistics are relaxed atomics so
+ * the console never sees a torn word.
+ */
+
+#include "rt_idle.h"
+#include <stddef.h>
+
+rt_idle_t g_rt_idle;
+
+void rt_idle_init(rt_idle_t *idle, uint32_t threshold_ticks) {
+    if (idle == NULL) {
+        return;
+    }
+    idle->threshold_ticks = threshold_ticks;
+    idle->quiet_ticks = 0;
+    idle->carry_us = 0;
+    atomic_store_explicit(&idle->sleeps, 0, memory_order_relaxed);
+    atomic_store_explicit(&idle->slept_s, 0, memory_order_relaxed);
+    atomic_store_explicit(&idle->slept_frac_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&idle->last_sleep_ms, 0, memory_order_relaxed);
+    atomic_store_explicit(&idle->paddle_wakes, 0, memory_order_relaxed);
+    atomic_store_explicit(&idle->wake_latency_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&idle->wake_latency_max_us, 0, memory_order_relaxed);
+}
+
+uint32_t rt_idle_wake(rt_idle_t *idle, int64_t slept_us, uint32_t tick_period_us,
+                      int64_t edge_us, int64_t resume_us) {
+    if (slept_us < 0) {
+        slept_us = 0;
+    }
+    if (tick_period_us == 0) {
+        tick_period_us = 1;
+    }
+
+    /* Whole ticks; the remainder rides into the next sleep */
+    uint64_t total_us = (uint64_t)slept_us + idle->carry_us;
+    uint64_t ticks = total_us / tick_period_us;
+    idle->carry_us = (uint32_t)(total_us - ticks * tick_period_us);
+    if (ticks > UINT32_MAX) {
+        ticks = UINT32_MAX;
+    }
+
+    uint32_t sleeps = atomic_load_explicit(&idle->sleeps, memory_order_relaxed);
+    atomic_store_explicit(&idle->sleeps, sleeps + 1U, memory_order_relaxed);
+
+    uint64_t frac = atomic_load_explicit(&idle->slept_frac_us, memory_order_relaxed) +
+                    (uint64_t)slept_us;
+    uint32_t secs = atomic_load_explicit(&idle->slept_s, memory_order_relaxed);
+    atomic_store_explicit(&idle->slept_s, secs + (uint32_t)(frac / 1000000U),
+                          memory_order_relaxed);
+    atomic_store_explicit(&idle->slept_frac_us, (uint32_t)(frac % 1000000U),
+                          memory_order_relaxed);
+
+    uint64_t ms = (uint64_t)slept_us / 1000U;
+    atomic_store_explicit(&idle->last_sleep_ms, (ms > UINT32_MAX) ? UINT32_MAX : (uint32_t)ms,
+                          memory_order_relaxed);
+
+    if (edge_us > 0) {
+        int64_t lat = resume_us - edge_us;
+        uint32_t lat_us = (lat <= 0) ? 0U : (lat >= (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)lat;
+        uint32_t wakes = atomic_load_explicit(&idle->paddle_wakes, memory_order_relaxed);
+        atomic_store_explicit(&idle->paddle_wakes, wakes + 1U, memory_order_relaxed);
+        atomic_store_explicit(&idle->wake_latency_us, lat_us, memory_order_relaxed);
+        if (lat_us > atomic_load_explicit(&idle->wake_latency_max_us, memory_order_relaxed)) {
+            atomic_store_explicit(&idle->wake_latency_max_us, lat_us, memory_order_relaxed);
+        }
+    }
+
+    return (uint32_t)ticks;
+}
+
+void rt_idle_get(const rt_idle_t *idle, rt_idle_stats_t *out) {
+    if (idle == NULL || out == NULL) {
+        return;
+    }
+    out->threshold_ticks = idle->threshold_ticks;
+    out->sleeps = atomic_load_explicit(&idle->sleeps, memory_order_relaxed);
+    out->slept_us = (uint64_t)atomic_load_explicit(&idle->slept_s, memory_order_relaxed) * 1000000U +
+                    atomic_load_explicit(&idle->slept_frac_us, memory_order_relaxed);
+    out->last_sleep_ms = atomic_load_explicit(&idle->last_sleep_ms, memory_order_relaxed);
+    out->paddle_wakes = atomic_load_explicit(&idle->paddle_wakes, memory_order_relaxed);
+    out->wake_latency_us = atomic_load_explicit(&idle->wake_latency_us, memory_order_relaxed);
+    out->wake_latency_max_us = atomic_load_explicit(&idle->wake_latency_max_us,
+                                                    memory_order_relaxed);
+}
@@ -0,0 +1,109 @@
+/**
+ * @file rt_prof.c
+ * @brief RT hot path cycle-count accumulators
+ *
+ * Single writer (RT task). Every field is a relaxed atomic so readers on
+ * Core 1 never see a torn word; reset requests are applied by the writer
+ * so there is never a second writer.
+ */
+
+#include "rt_prof.h"
+#include <stddef.h>
+
+rt_prof_t g_rt_prof;
+
+static void stage_clear(rt_prof_stage_stats_t *s) {
+    atomic_store_explicit(&s->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->sum, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->min, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->max, 0, memory_order_relaxed);
+    for (size_t i = 0; i < RT_PROF_HIST_BINS; i++) {
+        atomic_store_explicit(&s->hist[i], 0, memory_order_relaxed);
+    }
+}
+
+static void prof_clear(rt_prof_t *prof) {
+    for (size_t i = 0; i < RT_PROF_STAGE_COUNT; i++) {
+        stage_clear(&prof->stage[i]);
+    }
+}
+
+void rt_prof_init(rt_prof_t *prof) {
+    if (prof == NULL) {
+        return;
+    }
+    prof_clear(prof);
+    atomic_store_explicit(&prof->reset_requested, false, memory_order_relaxed);
+}
+
+void rt_prof_record(rt_prof_t *prof, rt_prof_stage_t stage, uint32_t cycles) {
+    if ((unsigned)stage >= RT_PROF_STAGE_COUNT) {
+        return;
+    }
+    if (atomic_exchange_explicit(&prof->reset_requested, false, memory_order_relaxed)) {
+        prof_clear(prof);
+    }
+
+    rt_prof_stage_stats_t *s = &prof->stage[stage];
+    uint32_t count = atomic_load_explicit(&s->count, memory_order_relaxed);
+    uint32_t sum = atomic_load_explicit(&s->sum, memory_order_relaxed);
+
+    /* Keep the running mean bounded: halve both before the sum would wrap */
+    if (sum > (UINT32_MAX - cycles) || count == UINT32_MAX) {
+        count /= 2;
+        sum /= 2;
+    }
+
+    if (count == 0 || cycles < atomic_load_explicit(&s->min, memory_order_relaxed)) {
+        atomic_store_explicit(&s->min, cycles, memory_order_relaxed);
+    }
+    if (count == 0 || cycles > atomic_load_explicit(&s->max, memory_order_relaxed)) {
+        atomic_store_explicit(&s->max, cycles, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&s->sum, sum + cycles, memory_order_relaxed);
+    atomic_store_explicit(&s->count, count + 1, memory_order_relaxed);
+
+    uint32_t bin = rt_prof_hist_bin(cycles);
+    uint32_t h = atomic_load_explicit(&s->hist[bin], memory_order_relaxed);
+    if (h != UINT32_MAX) {
+        atomic_store_explicit(&s->hist[bin], h + 1, memory_order_relaxed);
+    }
+}
+
+void rt_prof_reset(rt_prof_t *prof) {
+    if (prof == NULL) {
+        return;
+    }
+    atomic_store_explicit(&prof->reset_requested, true, memory_order_relaxed);
+}
+
+void rt_prof_get(rt_prof_t *prof, rt_prof_stage_t stage, rt_prof_snapshot_t *out) {
+    if (prof == NULL || out == NULL || (unsigned)stage >= RT_PROF_STAGE_COUNT) {
+        return;
+    }
+    rt_prof_stage_stats_t *s = &prof->stage[stage];
+    uint32_t count = atomic_load_explicit(&s->count, memory_order_relaxed);
+    uint32_t sum = atomic_load_explicit(&s->sum, memory_order_relaxed);
+
+    out->count = count;
+    out->min_cycles = atomic_load_explicit(&s->min, memory_order_relaxed);
+    out->max_cycles = atomic_load_explicit(&s->max, memory_order_relaxed);
+    out->mean_cycles = (count > 0) ? (sum / count) : 0;
+    for (size_t i = 0; i < RT_PROF_HIST_BINS; i++) {
+        out->hist[i] = atomic_load_explicit(&s->hist[i], memory_order_relaxed);
+    }
+}
+
+const char *rt_prof_stage_str(rt_prof_stage_t stage) {
+    switch (stage) {
+        case RT_PROF_STAGE_GPIO:        return "gpio";
+        case RT_PROF_STAGE_IAMBIC:      return "iambic";
+        case RT_PROF_STAGE_STREAM_PUSH: return "push";
+        case RT_PROF_STAGE_CONSUMER:    return "consumer";
+        case RT_PROF_STAGE_SIDETONE:    return "sidetone";
+        case RT_PROF_STAGE_AUDIO_WRITE: return "audio";
+        case RT_PROF_STAGE_TOTAL:       return "total";
+        default:                        return "unknown";
+    }
+}
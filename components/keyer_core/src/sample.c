@@ -9,10 +9,14 @@ stream_sample_t sample_with_edges_from(stream_sample_t current,
                                        const stream_sample_t *previous) {
     uint8_t flags = current.flags;
 
-    /* Check for GPIO edge */
-    if (current.gpio.bits != previous->gpio.bits) {
+    /* Check for input and remote channel edges */
+    uint8_t changed = (uint8_t)(current.gpio.bits ^ previous->gpio.bits);
+    if (changed & GPIO_INPUT_MASK) {
         flags |= FLAG_GPIO_EDGE;
     }
+    if (changed & SAMPLE_CH_REMOTE) {
+        flags |= FLAG_REMOTE_EDGE;
+    }
 
     /* Check for local key edge */
     if (current.local_key != previous->local_key) {
@@ -0,0 +1,113 @@
+/**
+ * @file service.c
+ * @brief Core 1 background services: descriptors and CPU accounting
+ *
+ * Slots are claimed with fetch_add and published by their descriptor
+ * pointer (release), after the counters are cleared; readers skip slots
+ * whose descriptor is not there yet.
+ */
+
+#include "service.h"
+#include <string.h>
+
+void service_table_init(service_table_t *t) {
+    memset(t, 0, sizeof(*t));
+    atomic_init(&t->count, 0U);
+    for (size_t i = 0; i < SERVICE_MAX; i++) {
+        service_t *svc = &t->slots[i];
+        atomic_init(&svc->desc, NULL);
+        atomic_init(&svc->runs, 0U);
+        atomic_init(&svc->busy_ms, 0U);
+        atomic_init(&svc->max_us, 0U);
+        atomic_init(&svc->last_us, 0U);
+        atomic_init(&svc->overruns, 0U);
+        atomic_init(&svc->delay_ms, 0U);
+    }
+}
+
+service_t *service_register(service_table_t *t, const service_desc_t *desc) {
+    unsigned id = atomic_fetch_add_explicit(&t->count, 1U, memory_order_relaxed);
+    if (id >= SERVICE_MAX) {
+        return NULL;
+    }
+    service_t *svc = &t->slots[id];
+    svc->rem_us = 0;
+    svc->last_work_us = 0;
+    atomic_store_explicit(&svc->delay_ms, desc->period_ms, memory_order_relaxed);
+    atomic_store_explicit(&svc->desc, desc, memory_order_release);
+    return svc;
+}
+
+void service_record(service_t *svc, int64_t start_us, int64_t end_us) {
+    int64_t dur = end_us - start_us;
+    uint32_t us = (dur <= 0) ? 0U : (dur >= (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)dur);
+    const service_desc_t *desc = atomic_load_explicit(&svc->desc, memory_order_relaxed);
+
+    /* Carry sub-ms remainders so short passes still add up */
+    uint64_t total = (uint64_t)svc->rem_us + us;
+    svc->rem_us = (uint32_t)(total % 1000U);
+    uint32_t busy = atomic_load_explicit(&svc->busy_ms, memory_order_relaxed);
+    atomic_store_explicit(&svc->busy_ms, busy + (uint32_t)(total / 1000U), memory_order_relaxed);
+
+    atomic_store_explicit(&svc->last_us, us, memory_order_relaxed);
+    if (us > atomic_load_explicit(&svc->max_us, memory_order_relaxed)) {
+        atomic_store_explicit(&svc->max_us, us, memory_order_relaxed);
+    }
+    if (desc != NULL && (uint64_t)us > (uint64_t)desc->period_ms * 1000U) {
+        uint32_t over = atomic_load_explicit(&svc->overruns, memory_order_relaxed);
+        atomic_store_explicit(&svc->overruns, over + 1U, memory_order_relaxed);
+    }
+    uint32_t runs = atomic_load_explicit(&svc->runs, memory_order_relaxed);
+    atomic_store_explicit(&svc->runs, runs + 1U, memory_order_relaxed);
+}
+
+uint32_t service_next_delay_ms(service_t *svc, int64_t now_us, bool busy) {
+    const service_desc_t *desc = atomic_load_explicit(&svc->desc, memory_order_relaxed);
+    uint32_t delay = desc->period_ms;
+
+    if (desc->min_period_ms != 0 && desc->min_period_ms < desc->period_ms) {
+        if (busy) {
+            svc->last_work_us = now_us;
+        }
+        if (now_us - svc->last_work_us < (int64_t)desc->hold_ms * 1000) {
+            delay = desc->min_period_ms;
+        } else {
+            /* Silence: back off geometrically */
+            uint32_t prev = atomic_load_explicit(&svc->delay_ms, memory_order_relaxed);
+            if (prev < desc->min_period_ms) {
+                prev = desc->min_period_ms;
+            }
+            delay = (prev >= desc->period_ms / 2U) ? desc->period_ms : prev * 2U;
+        }
+    }
+    atomic_store_explicit(&svc->delay_ms, delay, memory_order_relaxed);
+    return delay;
+}
+
+size_t service_snapshot(const service_table_t *t, service_info_t *out, size_t max) {
+    unsigned count = atomic_load_explicit(&t->count, memory_order_relaxed);
+    if (count > SERVICE_MAX) {
+        count = SERVICE_MAX;
+    }
+
+    size_t n = 0;
+    for (unsigned i = 0; i < count && n < max; i++) {
+        const service_t *svc = &t->slots[i];
+        const service_desc_t *desc = atomic_load_explicit(&svc->desc, memory_order_acquire);
+        if (desc == NULL) {
+            continue;
+        }
+        out[n].name = desc->name;
+        out[n].period_ms = desc->period_ms;
+        out[n].min_period_ms = desc->min_period_ms;
+        out[n].priority = desc->priority;
+        out[n].delay_ms = atomic_load_explicit(&svc->delay_ms, memory_order_relaxed);
+        out[n].runs = atomic_load_explicit(&svc->runs, memory_order_relaxed);
+        out[n].busy_ms = atomic_load_explicit(&svc->busy_ms, memory_order_relaxed);
+        out[n].max_us = atomic_load_explicit(&svc->max_us, memory_order_relaxed);
+        out[n].last_us = atomic_load_explicit(&svc->last_us, memory_order_relaxed);
+        out[n].overruns = atomic_load_explicit(&svc->overruns, memory_order_relaxed);
+        n++;
+    }
+    return n;
+}
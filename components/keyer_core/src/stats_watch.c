@@ -0,0 +1,158 @@
+/**
+ * @file stats_watch.c
+ * @brief Live stats sampling for the console
+ */
+
+#include "stats_watch.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *const GROUP_NAMES[STATS_WATCH_GROUP_COUNT] = {
+    "rt", "lag", "cwnet", "vpn", "heap",
+};
+
+void stats_watch_init(stats_watch_t *w, unsigned groups) {
+    memset(w, 0, sizeof(*w));
+    w->groups = (groups != 0U) ? (groups & STATS_WATCH_ALL) : STATS_WATCH_ALL;
+}
+
+void stats_watch_push(stats_watch_t *w, const stats_watch_sample_t *s) {
+    if (!w->have_base) {
+        w->base = *s;
+        w->have_base = true;
+        return;
+    }
+    w->ring[w->head % STATS_WATCH_RING] = *s;
+    w->head++;
+}
+
+/** Append to a line, keeping it NUL-terminated when it runs out of room */
+static void put(char *buf, size_t cap, size_t *len, const char *fmt, ...) {
+    if (*len >= cap) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + *len, cap - *len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        *len += (size_t)n;
+        if (*len >= cap) {
+            *len = cap - 1U;
+        }
+    }
+}
+
+/** Running counter delta since the previous line */
+#define DELTA(field) ((unsigned long)(last->field - w->base.field))
+
+size_t stats_watch_line(stats_watch_t *w, char *buf, size_t cap) {
+    if (cap == 0U) {
+        return 0;
+    }
+    buf[0] = '\0';
+    if (w->head == w->printed) {
+        return 0;
+    }
+
+    uint32_t first = w->printed;
+    if (w->head - first > STATS_WATCH_RING) {
+        first = w->head - STATS_WATCH_RING;
+    }
+    const stats_watch_sample_t *last = &w->ring[(w->head - 1U) % STATS_WATCH_RING];
+
+    uint32_t rt_peak = 0, cw_peak = 0;
+    uint32_t lag_min = UINT32_MAX, lag_max = 0;
+    uint32_t heap_min = UINT32_MAX, heap_max = 0;
+    for (uint32_t i = first; i != w->head; i++) {
+        const stats_watch_sample_t *s = &w->ring[i % STATS_WATCH_RING];
+        rt_peak = (s->rt_peak_us > rt_peak) ? s->rt_peak_us : rt_peak;
+        cw_peak = (s->cwnet_peak_us > cw_peak) ? s->cwnet_peak_us : cw_peak;
+        lag_min = (s->lag < lag_min) ? s->lag : lag_min;
+        lag_max = (s->lag > lag_max) ? s->lag : lag_max;
+        heap_min = (s->heap_free < heap_min) ? s->heap_free : heap_min;
+        heap_max = (s->heap_free > heap_max) ? s->heap_free : heap_max;
+    }
+
+    size_t len = 0;
+    int64_t ms = last->time_us / 1000;
+    put(buf, cap, &len, "%lld.%llds", (long long)(ms / 1000), (long long)((ms % 1000) / 100));
+
+    const char *sep = " ";
+    if ((w->groups & (1U << STATS_WATCH_RT)) != 0U) {
+        put(buf, cap, &len, "%srt %luus miss +%lu", sep, (unsigned long)rt_peak,
+            DELTA(rt_missed));
+        sep = " | ";
+    }
+    if ((w->groups & (1U << STATS_WATCH_LAG)) != 0U) {
+        put(buf, cap, &len, "%slag %lu [%lu-%lu] drop +%lu", sep, (unsigned long)last->lag,
+            (unsigned long)lag_min, (unsigned long)lag_max, DELTA(lag_dropped));
+        sep = " | ";
+    }
+    if ((w->groups & (1U << STATS_WATCH_CWNET)) != 0U) {
+        put(buf, cap, &len, "%scwnet +%lu %luus", sep, DELTA(cwnet_edges),
+            (unsigned long)cw_peak);
+        sep = " | ";
+    }
+    if ((w->groups & (1U << STATS_WATCH_VPN)) != 0U) {
+        put(buf, cap, &len, "%svpn tx +%lu rx +%lu", sep, DELTA(vpn_tx), DELTA(vpn_rx));
+        sep = " | ";
+    }
+    if ((w->groups & (1U << STATS_WATCH_HEAP)) != 0U) {
+        put(buf, cap, &len, "%sheap %lu [%lu-%lu]", sep, (unsigned long)last->heap_free,
+            (unsigned long)heap_min, (unsigned long)heap_max);
+    }
+    put(buf, cap, &len, "\r\n");
+
+    w->base = *last;
+    w->printed = w->head;
+    return len;
+}
+
+uint32_t stats_watch_hist_peak(const uint32_t *now, uint32_t *prev, size_t bins) {
+    uint32_t peak = 0;
+    for (size_t b = 0; b < bins && b < 32U; b++) {
+        if (now[b] != prev[b]) {
+            peak = 1UL << b;
+        }
+        prev[b] = now[b];
+    }
+    return peak;
+}
+
+bool stats_watch_parse_groups(const char *list, unsigned *groups) {
+    unsigned bits = 0;
+    const char *p = list;
+    while (*p != '\0') {
+        const char *end = strchr(p, ',');
+        size_t n = (end != NULL) ? (size_t)(end - p) : strlen(p);
+        bool found = false;
+        if (n == 3U && strncmp(p, "all", 3) == 0) {
+            bits |= STATS_WATCH_ALL;
+            found = true;
+        }
+        for (unsigned g = 0; !found && g < STATS_WATCH_GROUP_COUNT; g++) {
+            if (strlen(GROUP_NAMES[g]) == n && strncmp(p, GROUP_NAMES[g], n) == 0) {
+                bits |= 1U << g;
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+        p += n;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    if (bits == 0U) {
+        return false;
+    }
+    *groups = bits;
+    return true;
+}
+
+const char *stats_watch_group_str(stats_watch_group_t g) {
+    return ((unsigned)g < STATS_WATCH_GROUP_COUNT) ? GROUP_NAMES[g] : "?";
+}
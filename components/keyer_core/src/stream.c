@@ -1,6 +1,6 @@
 /**
  * @file stream.c
- * @brief Lock-free SPMC stream buffer implementation
+ * @brief Lock-free stream buffer implementation (producer lanes, MPMC)
  *
  * ARCHITECTURE.md compliance:
  * - RULE 3.1.1: Only atomic operations for synchronization
@@ -21,11 +21,50 @@ static inline bool is_power_of_2(size_t n) {
     return n > 0 && (n & (n - 1)) == 0;
 }
 
+static inline uint32_t log2_of(size_t n) {
+    uint32_t shift = 0;
+    while (((size_t)1 << shift) < n) {
+        shift++;
+    }
+    return shift;
+}
+
+/** Commit tag for a write index: lap number + 1, never 0 (0 = no valid sample).
+ * Masked rather than taken modulo so the sequence stays continuous when
+ * the index wraps. */
+static inline uint_least16_t lap_tag(uint32_t lap_shift, size_t idx) {
+    return (uint_least16_t)(((idx >> lap_shift) & 0x7FFFU) + 1U);
+}
+
+/** Write indices per write_epoch step */
+#define STREAM_EPOCH_MASK 0x7FFFFFFFU
+
+/**
+ * Widen a 32-bit write index with the epoch loaded just before it.
+ * The epoch counts half laps, so its low bit names the half the index was
+ * in; an index already in the next half has passed a step the producer
+ * has not published yet.
+ */
+static inline uint64_t widen_write(uint32_t epoch, uint32_t w32) {
+    if ((w32 >> 31) != (epoch & 1U)) {
+        epoch++;
+    }
+    return ((uint64_t)(epoch >> 1) << 32) | w32;
+}
+
+/** Write index and its absolute position from one load */
+static inline size_t load_write_abs(const keying_stream_t *stream, uint64_t *abs) {
+    uint32_t epoch = (uint32_t)atomic_load_explicit(&stream->write_epoch, memory_order_acquire);
+    size_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
+    *abs = widen_write(epoch, (uint32_t)write);
+    return write;
+}
+
 /* ============================================================================
  * KeyingStream Implementation
  * ============================================================================ */
 
-void stream_init(keying_stream_t *stream, stream_sample_t *buffer, size_t capacity) {
+void stream_init(keying_stream_t *stream, stream_slot_t *buffer, size_t capacity) {
     assert(stream != NULL);
     assert(buffer != NULL);
     assert(capacity > 0);
@@ -34,75 +73,547 @@ void stream_init(keying_stream_t *stream, stream_sample_t *buffer, size_t capaci
     stream->buffer = buffer;
     stream->capacity = capacity;
     stream->mask = capacity - 1;
+    stream->lap_shift = log2_of(capacity);
     atomic_init(&stream->write_idx, 0);
-    atomic_init(&stream->idle_ticks, 0);
-    stream->last_sample = STREAM_SAMPLE_EMPTY;
+    atomic_init(&stream->write_epoch, 0);
+    stream_producer_init(&stream->local, stream, STREAM_LANE_LOCAL);
+    atomic_init(&stream->tick_period_us, STREAM_DEFAULT_TICK_US);
+    stream->epoch_us = 0;
+    atomic_init(&stream->anchor.seq, 0);
+    stream->anchor.idx = 0;
+    stream->anchor.tick = 0;
+    stream->anchor.span = 0;
+    stream->anchor.gpio = GPIO_IDLE;
+    stream->anchor.local_key = 0;
+    atomic_init(&stream->net_clock.seq, 0);
+    stream->net_clock.ref_tick = 0;
+    stream->net_clock.net_us = 0;
+    stream->net_clock.drift_ppm = 0;
+    stream->net_clock.updates = 0;
+    stream->archive = NULL;
+    stream->registry = NULL;
 
-    /* Zero the buffer */
-    memset(buffer, 0, capacity * sizeof(stream_sample_t));
+    /* Zero the buffer (commit tag 0 = never written) */
+    memset(buffer, 0, capacity * sizeof(stream_slot_t));
+}
+
+void stream_producer_init(stream_producer_t *producer, keying_stream_t *stream,
+                          stream_lane_t lane) {
+    assert(producer != NULL);
+    assert(stream != NULL);
+    assert(lane < STREAM_LANE_COUNT);
+
+    producer->stream = stream;
+    producer->lane = lane;
+    atomic_init(&producer->idle_ticks, 0);
+    producer->last_sample = STREAM_SAMPLE_EMPTY;
+    producer->ticks_emitted = 0;
+}
+
+void stream_set_epoch_us(keying_stream_t *stream, int64_t epoch_us) {
+    assert(stream != NULL);
+    stream->epoch_us = epoch_us;
+}
+
+void stream_read_anchor(const keying_stream_t *stream, size_t *idx, uint64_t *tick) {
+    assert(stream != NULL);
+    assert(idx != NULL && tick != NULL);
+
+    const stream_tick_anchor_t *a = &stream->anchor;
+    for (;;) {
+        unsigned s0 = atomic_load_explicit(&a->seq, memory_order_acquire);
+        if (s0 & 1U) {
+            continue;  /* Producer mid-update (a few stores, never blocks) */
+        }
+        size_t i = a->idx;
+        uint64_t t = a->tick;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&a->seq, memory_order_relaxed) == s0) {
+            *idx = i;
+            *tick = t;
+            return;
+        }
+    }
+}
+
+void stream_read_key_state(const keying_stream_t *stream, stream_key_state_t *state) {
+    assert(stream != NULL);
+    assert(state != NULL);
+
+    const stream_tick_anchor_t *a = &stream->anchor;
+    for (;;) {
+        unsigned s0 = atomic_load_explicit(&a->seq, memory_order_acquire);
+        if (s0 & 1U) {
+            continue;
+        }
+        stream_key_state_t copy = {
+            .idx = a->idx + 1,
+            .pos = 0,
+            .tick = a->tick + a->span,
+            .gpio = a->gpio,
+            .local_key = a->local_key,
+        };
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&a->seq, memory_order_relaxed) == s0) {
+            if (s0 == 0) {
+                copy.idx = 0;  /* No LOCAL slot yet */
+            } else {
+                copy.pos = stream_position_abs(stream, copy.idx);
+            }
+            *state = copy;
+            return;
+        }
+    }
+}
+
+/** Seqlock write of the network clock (single writer) */
+static void net_clock_store(keying_stream_t *stream, uint64_t ref_tick, int64_t net_us,
+                            int32_t drift_ppm, uint32_t updates) {
+    stream_net_clock_t *c = &stream->net_clock;
+    unsigned seq = atomic_load_explicit(&c->seq, memory_order_relaxed);
+    atomic_store_explicit(&c->seq, seq + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    c->ref_tick = ref_tick;
+    c->net_us = net_us;
+    c->drift_ppm = drift_ppm;
+    c->updates = updates;
+    atomic_store_explicit(&c->seq, seq + 2U, memory_order_release);
+}
+
+void stream_set_net_clock(keying_stream_t *stream, uint64_t ref_tick, int64_t net_us,
+                          int32_t drift_ppm) {
+    assert(stream != NULL);
+    uint32_t updates = stream->net_clock.updates + 1U;   /* Only this writer changes it */
+    net_clock_store(stream, ref_tick, net_us, drift_ppm, (updates != 0U) ? updates : 1U);
+}
+
+void stream_clear_net_clock(keying_stream_t *stream) {
+    assert(stream != NULL);
+    if (stream->net_clock.updates != 0U) {
+        net_clock_store(stream, 0, 0, 0, 0);
+    }
+}
+
+bool stream_read_net_clock(const keying_stream_t *stream, stream_net_time_t *out) {
+    assert(stream != NULL);
+    assert(out != NULL);
+
+    const stream_net_clock_t *c = &stream->net_clock;
+    for (;;) {
+        unsigned s0 = atomic_load_explicit(&c->seq, memory_order_acquire);
+        if (s0 & 1U) {
+            continue;  /* Writer mid-update */
+        }
+        stream_net_time_t copy = {
+            .ref_tick = c->ref_tick,
+            .net_us = c->net_us,
+            .drift_ppm = c->drift_ppm,
+            .updates = c->updates,
+        };
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&c->seq, memory_order_relaxed) == s0) {
+            *out = copy;
+            return copy.updates != 0U;
+        }
+    }
+}
+
+int64_t stream_net_time_us(const stream_net_time_t *clock, uint64_t tick, uint32_t tick_us) {
+    assert(clock != NULL);
+    int64_t local_us = (tick >= clock->ref_tick)
+                           ? (int64_t)((tick - clock->ref_tick) * tick_us)
+                           : -(int64_t)((clock->ref_tick - tick) * tick_us);
+    return clock->net_us + local_us + (local_us * clock->drift_ppm) / 1000000LL;
+}
+
+void stream_set_tick_period_us(keying_stream_t *stream, uint32_t tick_us) {
+    assert(stream != NULL);
+    if (tick_us == 0) {
+        return;
+    }
+    atomic_store_explicit(&stream->tick_period_us, tick_us, memory_order_relaxed);
+}
+
+static inline uint_least16_t commit_tag(const keying_stream_t *stream, size_t idx) {
+    return lap_tag(stream->lap_shift, idx);
 }
 
 /**
  * @brief Write a slot to the ring buffer
  *
- * Internal function - always writes, no compression.
+ * Internal function - always writes, no compression. The slot is claimed
+ * with fetch_add, invalidated, and published by its commit tag once the
+ * sample is in.
  */
-static inline bool stream_write_slot(keying_stream_t *stream, stream_sample_t sample) {
+static inline size_t stream_write_slot(keying_stream_t *stream, stream_sample_t sample) {
     /* RULE 3.1.2: AcqRel for read-modify-write */
     size_t idx = atomic_fetch_add_explicit(&stream->write_idx, 1, memory_order_acq_rel);
-    size_t slot_idx = idx & stream->mask;
+    stream_slot_t *slot = &stream->buffer[idx & stream->mask];
+
+    /* Claimed the last index of a half lap: only this writer steps the epoch */
+    if (((uint32_t)(idx + 1U) & STREAM_EPOCH_MASK) == 0) {
+        atomic_fetch_add_explicit(&stream->write_epoch, 1, memory_order_release);
+    }
+
+    /* Invalidate, write sample, then publish it */
+    atomic_store_explicit(&slot->commit, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->sample = sample;
+    atomic_store_explicit(&slot->commit, commit_tag(stream, idx), memory_order_release);
 
-    /* Write sample to slot */
-    stream->buffer[slot_idx] = sample;
+    return idx;
+}
+
+/**
+ * @brief Write one lane slot covering `ticks` ticks, keep the timebase
+ *
+ * LOCAL writes publish the tick anchor (seqlock, single writer).
+ */
+static inline bool producer_emit(stream_producer_t *producer, stream_sample_t sample,
+                                 uint32_t ticks) {
+    keying_stream_t *stream = producer->stream;
+    size_t idx = stream_write_slot(stream, sample_with_lane(sample, producer->lane));
 
+    if (producer->lane == STREAM_LANE_LOCAL) {
+        stream_tick_anchor_t *a = &stream->anchor;
+        unsigned seq = atomic_load_explicit(&a->seq, memory_order_relaxed);
+        atomic_store_explicit(&a->seq, seq + 1U, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        a->idx = idx;
+        a->tick = producer->ticks_emitted;
+        a->span = ticks;
+        if (!sample_is_silence(&sample)) {
+            a->gpio = sample.gpio;
+            a->local_key = sample.local_key;
+        }
+        atomic_store_explicit(&a->seq, seq + 2U, memory_order_release);
+    }
+
+    producer->ticks_emitted += ticks;
     return true;
 }
 
-bool stream_push(keying_stream_t *stream, stream_sample_t sample) {
-    assert(stream != NULL);
+bool stream_producer_push(stream_producer_t *producer, stream_sample_t sample) {
+    assert(producer != NULL);
 
     /* Check for change from last sample */
-    if (sample_has_change_from(&sample, &stream->last_sample)) {
+    if (sample_has_change_from(&sample, &producer->last_sample)) {
         /* State changed: flush accumulated idle ticks, then write sample */
 
-        uint32_t idle = (uint32_t)atomic_exchange_explicit(&stream->idle_ticks, 0, memory_order_relaxed);
+        uint32_t idle = (uint32_t)atomic_exchange_explicit(&producer->idle_ticks, 0, memory_order_relaxed);
         if (idle > 0) {
-            if (!stream_write_slot(stream, sample_silence(idle))) {
+            if (!producer_emit(producer, sample_silence(idle), idle)) {
                 return false;
             }
         }
 
         /* Write sample with edge flags */
-        stream_sample_t sample_with_edges = sample_with_edges_from(sample, &stream->last_sample);
-        if (!stream_write_slot(stream, sample_with_edges)) {
+        stream_sample_t sample_with_edges = sample_with_edges_from(sample, &producer->last_sample);
+        if (!producer_emit(producer, sample_with_edges, 1)) {
             return false;
         }
 
         /* Update last sample */
-        stream->last_sample = sample;
+        producer->last_sample = sample;
     } else {
         /* No change: accumulate idle ticks (silence compression) */
-        atomic_fetch_add_explicit(&stream->idle_ticks, 1, memory_order_relaxed);
+        uint32_t idle = (uint32_t)atomic_fetch_add_explicit(&producer->idle_ticks, 1,
+                                                            memory_order_relaxed) + 1U;
+        if (idle == SAMPLE_SILENCE_MAX_TICKS) {
+            /* Marker full: emit it and chain the next one */
+            atomic_store_explicit(&producer->idle_ticks, 0, memory_order_relaxed);
+            if (!producer_emit(producer, sample_silence(idle), idle)) {
+                return false;
+            }
+        }
     }
 
     return true;
 }
 
+void stream_producer_flush(stream_producer_t *producer) {
+    assert(producer != NULL);
+
+    uint32_t idle = (uint32_t)atomic_exchange_explicit(&producer->idle_ticks, 0, memory_order_relaxed);
+    if (idle > 0) {
+        (void)producer_emit(producer, sample_silence(idle), idle);
+    }
+}
+
+void stream_producer_skip(stream_producer_t *producer, uint32_t ticks) {
+    assert(producer != NULL);
+
+    uint32_t idle = (uint32_t)atomic_load_explicit(&producer->idle_ticks, memory_order_relaxed);
+    if (ticks >= SAMPLE_SILENCE_MAX_TICKS - idle) {
+        /* Marker full: emit it and carry the rest into the next one */
+        ticks -= SAMPLE_SILENCE_MAX_TICKS - idle;
+        idle = 0;
+        (void)producer_emit(producer, sample_silence(SAMPLE_SILENCE_MAX_TICKS),
+                            SAMPLE_SILENCE_MAX_TICKS);
+    }
+    atomic_store_explicit(&producer->idle_ticks, idle + ticks, memory_order_relaxed);
+}
+
+bool stream_push(keying_stream_t *stream, stream_sample_t sample) {
+    assert(stream != NULL);
+    return stream_producer_push(&stream->local, sample);
+}
+
 bool stream_push_raw(keying_stream_t *stream, stream_sample_t sample) {
     assert(stream != NULL);
-    return stream_write_slot(stream, sample);
+    (void)stream_write_slot(stream, sample);
+    return true;
 }
 
 void stream_flush(keying_stream_t *stream) {
     assert(stream != NULL);
+    stream_producer_flush(&stream->local);
+}
 
-    uint32_t idle = (uint32_t)atomic_exchange_explicit(&stream->idle_ticks, 0, memory_order_relaxed);
-    if (idle > 0) {
-        stream_write_slot(stream, sample_silence(idle));
+void stream_skip(keying_stream_t *stream, uint32_t ticks) {
+    assert(stream != NULL);
+    stream_producer_skip(&stream->local, ticks);
+}
+
+/* ============================================================================
+ * History Archive (PSRAM tier)
+ * ============================================================================ */
+
+static void archive_reset(keying_stream_t *stream, stream_archive_t *archive,
+                          size_t capacity) {
+    assert(is_power_of_2(capacity) && "Archive size must be power of 2");
+    assert(capacity >= stream->capacity);
+
+    size_t start = stream_write_position(stream);
+    archive->capacity = capacity;
+    archive->mask = capacity - 1;
+    archive->lap_shift = log2_of(capacity);
+    atomic_init(&archive->head, start);
+    atomic_init(&archive->claim, start);
+    atomic_init(&archive->base, start);
+    atomic_init(&archive->spilled, 0);
+    atomic_init(&archive->gaps, 0);
+}
+
+void stream_attach_archive(keying_stream_t *stream, stream_archive_t *archive,
+                           stream_slot_t *buffer, size_t capacity) {
+    assert(stream != NULL);
+    assert(archive != NULL);
+    assert(buffer != NULL);
+
+    archive_reset(stream, archive, capacity);
+    archive->buffer = buffer;
+    archive->words = NULL;
+    memset(buffer, 0, capacity * sizeof(stream_slot_t));
+    stream->archive = archive;
+}
+
+void stream_attach_compact_archive(keying_stream_t *stream, stream_archive_t *archive,
+                                   uint32_t *words, size_t capacity) {
+    assert(stream != NULL);
+    assert(archive != NULL);
+    assert(words != NULL);
+
+    archive_reset(stream, archive, capacity);
+    archive->buffer = NULL;
+    archive->words = words;
+    memset(words, 0, (capacity / 2) * sizeof(uint32_t));
+    stream->archive = archive;
+}
+
+/** Copy hot slots to the archive under their absolute indices (spill thread) */
+static void archive_store(stream_archive_t *ar, size_t idx,
+                          const stream_slot_t *src, size_t n) {
+    if (ar->words != NULL) {
+        for (size_t i = 0; i < n; i++) {
+            size_t pos = (idx + i) & ar->mask;
+            uint32_t shift = (uint32_t)(pos & 1U) * 16U;
+            uint32_t *word = &ar->words[pos >> 1];
+            *word = (*word & ~(0xFFFFU << shift)) |
+                    ((uint32_t)sample_compact_encode(&src[i].sample) << shift);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        stream_slot_t *dst = &ar->buffer[(idx + i) & ar->mask];
+        atomic_store_explicit(&dst->commit, 0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        dst->sample = src[i].sample;
+        atomic_store_explicit(&dst->commit, lap_tag(ar->lap_shift, idx + i),
+                              memory_order_release);
+    }
+}
+
+static void archive_invalidate(stream_archive_t *ar, size_t idx, size_t n) {
+    if (ar->words != NULL) {
+        return;  /* Beyond head: never read, the next call restarts the run */
+    }
+    for (size_t i = 0; i < n; i++) {
+        atomic_store_explicit(&ar->buffer[(idx + i) & ar->mask].commit, 0,
+                              memory_order_relaxed);
+    }
+}
+
+size_t stream_archive_spill(keying_stream_t *stream, size_t max) {
+    assert(stream != NULL);
+
+    stream_archive_t *ar = stream->archive;
+    if (ar == NULL || max == 0) {
+        return 0;
+    }
+
+    size_t idx = atomic_load_explicit(&ar->head, memory_order_relaxed);
+    size_t write = stream_write_position(stream);
+    if (write - idx > stream->capacity) {
+        /* The hot ring already dropped slots we never copied */
+        idx = write - stream->capacity;
+        atomic_store_explicit(&ar->base, idx, memory_order_relaxed);
+        atomic_store_explicit(&ar->head, idx, memory_order_release);
+        atomic_fetch_add_explicit(&ar->gaps, 1, memory_order_relaxed);
+    }
+
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+    size_t n = stream_read_span(stream, idx, max, &a, &na, &b, &nb);
+    if (n == 0) {
+        return 0;
+    }
+
+    /* Readers of the slots about to be rewritten see the claim first */
+    atomic_store_explicit(&ar->claim, idx + n, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    archive_store(ar, idx, a, na);
+    archive_store(ar, idx + na, b, nb);
+
+    if (!stream_span_intact(stream, idx)) {
+        /* Lapped mid-copy: the copies may be torn, next call records the gap */
+        archive_invalidate(ar, idx, n);
+        return 0;
     }
+
+    atomic_store_explicit(&ar->head, idx + n, memory_order_release);
+    atomic_fetch_add_explicit(&ar->spilled, (unsigned)n, memory_order_relaxed);
+    return n;
 }
 
-bool stream_read(const keying_stream_t *stream, size_t idx, stream_sample_t *out) {
+size_t stream_oldest_position(const keying_stream_t *stream) {
+    assert(stream != NULL);
+
+    /* Distances back from the write position, so the index may wrap */
+    uint64_t written;
+    size_t write = load_write_abs(stream, &written);
+    size_t hot_back = (written > stream->capacity) ? stream->capacity : (size_t)written;
+
+    const stream_archive_t *ar = stream->archive;
+    if (ar == NULL) {
+        return write - hot_back;
+    }
+
+    size_t head = atomic_load_explicit(&ar->head, memory_order_acquire);
+    if (write - head > stream->capacity) {
+        return write - hot_back;  /* Archive run does not reach the hot ring */
+    }
+
+    size_t claim = atomic_load_explicit(&ar->claim, memory_order_relaxed);
+    size_t base = atomic_load_explicit(&ar->base, memory_order_relaxed);
+    uint64_t back = (uint64_t)(write - claim) + ar->capacity;
+    if (back > written) {
+        back = written;
+    }
+    if (back > write - base) {
+        back = write - base;
+    }
+    return write - ((back > hot_back) ? (size_t)back : hot_back);
+}
+
+/** Archived-index window check: idx < head and not reclaimed by the spill */
+static inline size_t archive_behind(const stream_archive_t *ar, size_t idx) {
+    size_t head = atomic_load_explicit(&ar->head, memory_order_acquire);
+    size_t behind = head - idx;
+    size_t limit = ar->capacity;
+    if (ar->words != NULL) {
+        /* No per-record tags: only the current unbroken run is valid */
+        size_t run = head - atomic_load_explicit(&ar->base, memory_order_relaxed);
+        if (run < limit) {
+            limit = run;
+        }
+    }
+    return (behind == 0 || behind > limit) ? 0 : behind;
+}
+
+static inline stream_compact_t archive_record(const stream_archive_t *ar, size_t idx) {
+    size_t pos = idx & ar->mask;
+    return (stream_compact_t)(ar->words[pos >> 1] >> ((pos & 1U) * 16U));
+}
+
+static inline bool archive_intact(const stream_archive_t *ar, size_t idx) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&ar->claim, memory_order_relaxed) - idx <= ar->capacity;
+}
+
+static stream_read_result_t archive_read_slot(const stream_archive_t *ar, size_t idx,
+                                              uint64_t ref_tick, stream_sample_t *out) {
+    if (ar == NULL || archive_behind(ar, idx) == 0) {
+        return STREAM_READ_OVERWRITTEN;
+    }
+
+    if (ar->words != NULL) {
+        stream_compact_t rec = archive_record(ar, idx);
+        if (!archive_intact(ar, idx)) {
+            return STREAM_READ_OVERWRITTEN;
+        }
+        *out = sample_compact_decode_at(rec, ref_tick);
+        return STREAM_READ_OK;
+    }
+
+    const stream_slot_t *slot = &ar->buffer[idx & ar->mask];
+    uint_least16_t tag = lap_tag(ar->lap_shift, idx);
+    if (atomic_load_explicit(&slot->commit, memory_order_acquire) != tag) {
+        return STREAM_READ_OVERWRITTEN;  /* Lost in a spill gap, or reclaimed */
+    }
+
+    stream_sample_t copy = slot->sample;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->commit, memory_order_relaxed) != tag) {
+        return STREAM_READ_OVERWRITTEN;
+    }
+
+    *out = copy;
+    return STREAM_READ_OK;
+}
+
+/**
+ * Copy a hot slot known to be claimed, validated by its commit tag alone:
+ * EMPTY if the tag is not idx's (uncommitted or a later lap), OVERWRITTEN
+ * if a producer lapped it during the copy.
+ */
+static inline stream_read_result_t hot_read_slot(const keying_stream_t *stream, size_t idx,
+                                                 stream_sample_t *out) {
+    const stream_slot_t *slot = &stream->buffer[idx & stream->mask];
+    uint_least16_t tag = commit_tag(stream, idx);
+
+    if (atomic_load_explicit(&slot->commit, memory_order_acquire) != tag) {
+        return STREAM_READ_EMPTY;
+    }
+
+    /* Copy, then make sure no producer lapped us during the copy */
+    stream_sample_t copy = slot->sample;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->commit, memory_order_relaxed) != tag) {
+        return STREAM_READ_OVERWRITTEN;
+    }
+
+    *out = copy;
+    return STREAM_READ_OK;
+}
+
+/** stream_read_slot() with the tick archived REMOTE records unwrap against */
+static inline stream_read_result_t read_slot(const keying_stream_t *stream, size_t idx,
+                                             uint64_t ref_tick, stream_sample_t *out) {
     assert(stream != NULL);
     assert(out != NULL);
 
@@ -114,17 +625,189 @@ bool stream_read(const keying_stream_t *stream, size_t idx, stream_sample_t *out
 
     if (behind == 0) {
         /* Not yet written */
-        return false;
+        return STREAM_READ_EMPTY;
     }
     if (behind > stream->capacity) {
-        /* Overwritten (consumer too slow) */
-        return false;
+        /* Gone from the hot ring (consumer too slow): try the history */
+        return archive_read_slot(stream->archive, idx, ref_tick, out);
+    }
+
+    stream_read_result_t res = hot_read_slot(stream, idx, out);
+    if (res == STREAM_READ_EMPTY) {
+        /* Either our writer has not committed yet, or a later lap owns it */
+        write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
+        return (write - idx > stream->capacity) ? archive_read_slot(stream->archive, idx, ref_tick, out)
+                                                : STREAM_READ_EMPTY;
+    }
+    if (res == STREAM_READ_OVERWRITTEN) {
+        return archive_read_slot(stream->archive, idx, ref_tick, out);
     }
+    return STREAM_READ_OK;
+}
 
-    size_t slot_idx = idx & stream->mask;
-    *out = stream->buffer[slot_idx];
+stream_read_result_t stream_read_slot(const keying_stream_t *stream, size_t idx,
+                                      stream_sample_t *out) {
+    return read_slot(stream, idx, 0, out);
+}
 
-    return true;
+stream_read_result_t stream_read_slot_at(const keying_stream_t *stream, size_t idx,
+                                         uint64_t ref_tick, stream_sample_t *out) {
+    return read_slot(stream, idx, ref_tick, out);
+}
+
+/** Count leading slots in [start, start + n) carrying the given tag */
+static inline size_t span_committed(const stream_slot_t *start, size_t n, uint_least16_t tag) {
+    size_t i = 0;
+    while (i < n && atomic_load_explicit(&start[i].commit, memory_order_relaxed) == tag) {
+        i++;
+    }
+    return i;
+}
+
+size_t stream_read_span(const keying_stream_t *stream, size_t idx, size_t max,
+                        const stream_slot_t **a, size_t *na,
+                        const stream_slot_t **b, size_t *nb) {
+    assert(stream != NULL);
+    assert(a != NULL && na != NULL && b != NULL && nb != NULL);
+
+    *a = NULL;
+    *na = 0;
+    *b = NULL;
+    *nb = 0;
+
+    /* RULE 3.1.3: Acquire for read (once per batch) */
+    size_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
+    size_t behind = write - idx;
+
+    if (behind == 0 || behind > stream->capacity) {
+        return 0;
+    }
+
+    size_t n = (behind < max) ? behind : max;
+    size_t slot = idx & stream->mask;
+    size_t first = stream->capacity - slot;
+    if (first > n) {
+        first = n;
+    }
+
+    /* Stop at the first slot whose writer has not committed yet */
+    size_t got_a = span_committed(&stream->buffer[slot], first, commit_tag(stream, idx));
+    size_t got_b = 0;
+    if (got_a == first && n > first) {
+        got_b = span_committed(stream->buffer, n - first, commit_tag(stream, idx + first));
+    }
+
+    /* Sample reads below may not be hoisted above the tag loads */
+    atomic_thread_fence(memory_order_acquire);
+
+    if (got_a > 0) {
+        *a = &stream->buffer[slot];
+        *na = got_a;
+    }
+    if (got_b > 0) {
+        *b = stream->buffer;
+        *nb = got_b;
+    }
+    return got_a + got_b;
+}
+
+size_t stream_read_tiered_span(const keying_stream_t *stream, size_t idx, size_t max,
+                               const stream_slot_t **a, size_t *na,
+                               const stream_slot_t **b, size_t *nb,
+                               stream_tier_t *tier) {
+    assert(stream != NULL);
+    assert(tier != NULL);
+
+    *tier = STREAM_TIER_HOT;
+    size_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
+    const stream_archive_t *ar = stream->archive;
+    if (write - idx <= stream->capacity || ar == NULL) {
+        return stream_read_span(stream, idx, max, a, na, b, nb);
+    }
+
+    *a = NULL;
+    *na = 0;
+    *b = NULL;
+    *nb = 0;
+    *tier = STREAM_TIER_ARCHIVE;
+
+    size_t behind = archive_behind(ar, idx);
+    if (behind == 0 || ar->buffer == NULL) {
+        return 0;
+    }
+
+    size_t n = (behind < max) ? behind : max;
+    size_t slot = idx & ar->mask;
+    size_t first = ar->capacity - slot;
+    if (first > n) {
+        first = n;
+    }
+
+    /* Stops at the first slot lost in a spill gap */
+    size_t got_a = span_committed(&ar->buffer[slot], first, lap_tag(ar->lap_shift, idx));
+    size_t got_b = 0;
+    if (got_a == first && n > first) {
+        got_b = span_committed(ar->buffer, n - first, lap_tag(ar->lap_shift, idx + first));
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    if (got_a > 0) {
+        *a = &ar->buffer[slot];
+        *na = got_a;
+    }
+    if (got_b > 0) {
+        *b = ar->buffer;
+        *nb = got_b;
+    }
+    return got_a + got_b;
+}
+
+size_t stream_archive_decode(const keying_stream_t *stream, size_t idx, uint64_t ref_tick,
+                             stream_slot_t *out, size_t max) {
+    assert(stream != NULL);
+    assert(out != NULL);
+
+    const stream_archive_t *ar = stream->archive;
+    if (ar == NULL || ar->words == NULL) {
+        return 0;
+    }
+
+    size_t n = archive_behind(ar, idx);
+    if (n > max) {
+        n = max;
+    }
+    for (size_t i = 0; i < n; i++) {
+        stream_sample_t s = sample_compact_decode_at(archive_record(ar, idx + i), ref_tick);
+        if (sample_lane(&s) == STREAM_LANE_LOCAL) {
+            ref_tick += sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+        }
+        out[i].sample = s;
+    }
+    return n;
+}
+
+bool stream_tier_intact(const keying_stream_t *stream, size_t idx, stream_tier_t tier) {
+    assert(stream != NULL);
+
+    if (tier == STREAM_TIER_ARCHIVE) {
+        return stream->archive != NULL && archive_intact(stream->archive, idx);
+    }
+    return stream_span_intact(stream, idx);
+}
+
+bool stream_span_intact(const keying_stream_t *stream, size_t idx) {
+    assert(stream != NULL);
+
+    /* Sample reads made by the caller happen before this check */
+    atomic_thread_fence(memory_order_acquire);
+    size_t write = atomic_load_explicit(&stream->write_idx, memory_order_relaxed);
+    return write - idx <= stream->capacity;
+}
+
+bool stream_is_committed(const keying_stream_t *stream, size_t idx) {
+    assert(stream != NULL);
+    const stream_slot_t *slot = &stream->buffer[idx & stream->mask];
+    return atomic_load_explicit(&slot->commit, memory_order_acquire) == commit_tag(stream, idx);
 }
 
 size_t stream_write_position(const keying_stream_t *stream) {
@@ -132,6 +815,27 @@ size_t stream_write_position(const keying_stream_t *stream) {
     return atomic_load_explicit(&stream->write_idx, memory_order_acquire);
 }
 
+uint64_t stream_write_position_abs(const keying_stream_t *stream) {
+    assert(stream != NULL);
+    uint64_t abs;
+    (void)load_write_abs(stream, &abs);
+    return abs;
+}
+
+uint64_t stream_position_abs(const keying_stream_t *stream, size_t idx) {
+    assert(stream != NULL);
+    uint64_t abs;
+    size_t write = load_write_abs(stream, &abs);
+    return abs - (uint32_t)((uint32_t)write - (uint32_t)idx);
+}
+
+size_t stream_position_index(const keying_stream_t *stream, uint64_t pos) {
+    assert(stream != NULL);
+    uint64_t abs;
+    size_t write = load_write_abs(stream, &abs);
+    return write - (size_t)(abs - pos);
+}
+
 size_t stream_lag(const keying_stream_t *stream, size_t read_idx) {
     assert(stream != NULL);
     size_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
@@ -153,6 +857,8 @@ void consumer_init(stream_consumer_t *consumer, const keying_stream_t *stream) {
 
     consumer->stream = stream;
     consumer->read_idx = stream_write_position(stream);
+    consumer->write_seen = consumer->read_idx;
+    consumer->span_tier = STREAM_TIER_HOT;
 }
 
 void consumer_init_at(stream_consumer_t *consumer, const keying_stream_t *stream,
@@ -162,20 +868,151 @@ void consumer_init_at(stream_consumer_t *consumer, const keying_stream_t *stream
 
     consumer->stream = stream;
     consumer->read_idx = position;
+    consumer->write_seen = position;
+    consumer->span_tier = STREAM_TIER_HOT;
+}
+
+void consumer_init_at_abs(stream_consumer_t *consumer, const keying_stream_t *stream,
+                          uint64_t pos) {
+    assert(stream != NULL);
+    consumer_init_at(consumer, stream, stream_position_index(stream, pos));
+}
+
+void consumer_init_with_state(stream_consumer_t *consumer, const keying_stream_t *stream,
+                              stream_key_state_t *state) {
+    assert(state != NULL);
+
+    stream_read_key_state(stream, state);
+    consumer_init_at(consumer, stream, state->idx);
 }
 
 bool consumer_next(stream_consumer_t *consumer, stream_sample_t *out) {
     assert(consumer != NULL);
     assert(out != NULL);
 
-    if (!stream_read(consumer->stream, consumer->read_idx, out)) {
+    const keying_stream_t *stream = consumer->stream;
+    size_t idx = consumer->read_idx;
+
+    /* Behind the write index last seen: the slot is claimed, the tag
+     * alone says whether it holds idx (any other outcome reloads) */
+    if (consumer->write_seen - idx - 1U < stream->capacity &&
+        hot_read_slot(stream, idx, out) == STREAM_READ_OK) {
+        consumer->read_idx = idx + 1U;
+        return true;
+    }
+
+    consumer->write_seen = stream_write_position(stream);
+    if (!stream_read(stream, idx, out)) {
         return false;
     }
 
-    consumer->read_idx++;
+    consumer->read_idx = idx + 1U;
     return true;
 }
 
+size_t consumer_next_span(stream_consumer_t *consumer,
+                          const stream_slot_t **a, size_t *na,
+                          const stream_slot_t **b, size_t *nb, size_t max) {
+    assert(consumer != NULL);
+    size_t n = stream_read_tiered_span(consumer->stream, consumer->read_idx, max,
+                                       a, na, b, nb, &consumer->span_tier);
+    if (n == 0 && consumer->span_tier == STREAM_TIER_ARCHIVE) {
+        /* Compact archive: decode a window into the consumer */
+        if (max > STREAM_CONSUMER_DECODE_SLOTS) {
+            max = STREAM_CONSUMER_DECODE_SLOTS;
+        }
+        n = stream_archive_decode(consumer->stream, consumer->read_idx, 0,
+                                  consumer->decoded, max);
+        if (n > 0) {
+            *a = consumer->decoded;
+            *na = n;
+        }
+    }
+    return n;
+}
+
+bool consumer_commit(stream_consumer_t *consumer, size_t n) {
+    assert(consumer != NULL);
+
+    bool intact = stream_tier_intact(consumer->stream, consumer->read_idx,
+                                     consumer->span_tier);
+    consumer->read_idx += n;
+    return intact;
+}
+
+/* gpio, local_key, audio_level, flags: flags is the top byte of the
+ * slot's first word */
+_Static_assert(offsetof(stream_sample_t, flags) == 3, "flags must be byte 3");
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "stream_span_scan() assumes a little-endian word layout"
+#endif
+#define SCAN_FLAGS_SHIFT 24U
+
+static inline uint32_t slot_word(const stream_slot_t *slot) {
+    uint32_t w;
+    memcpy(&w, &slot->sample, sizeof(w));
+    return w;
+}
+
+size_t stream_span_scan(const stream_slot_t *slots, size_t n, uint8_t mask, uint64_t *ticks) {
+    assert(ticks != NULL);
+
+    uint32_t stop = (uint32_t)(mask & (uint8_t)~FLAG_LANE_MASK) << SCAN_FLAGS_SHIFT;
+    uint32_t slow = stop | ((uint32_t)(FLAG_SILENCE | FLAG_LANE_MASK) << SCAN_FLAGS_SHIFT);
+    uint64_t t = *ticks;
+
+    size_t i = 0;
+    for (; i < n; i++) {
+        uint32_t w = slot_word(&slots[i]);
+        if ((w & slow) == 0) {
+            t++;  /* LOCAL sample, nothing requested: one tick */
+            continue;
+        }
+        if (w & stop) {
+            break;
+        }
+        if (sample_lane(&slots[i].sample) == STREAM_LANE_LOCAL) {
+            t += sample_silence_ticks(&slots[i].sample);  /* Silence marker */
+        }
+    }
+
+    *ticks = t;
+    return i;
+}
+
+stream_scan_result_t consumer_scan_until_edge(stream_consumer_t *consumer, uint8_t mask,
+                                              size_t max, uint64_t *ticks) {
+    assert(consumer != NULL);
+    assert(ticks != NULL);
+
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+
+    while (max > 0) {
+        size_t n = consumer_next_span(consumer, &a, &na, &b, &nb, max);
+        if (n == 0) {
+            return STREAM_SCAN_IDLE;
+        }
+
+        uint64_t t = 0;
+        size_t i = stream_span_scan(a, na, mask, &t);
+        if (i == na && nb > 0) {
+            i += stream_span_scan(b, nb, mask, &t);
+        }
+        if (!consumer_commit(consumer, i)) {
+            return STREAM_SCAN_OVERWRITTEN;
+        }
+        *ticks += t;
+        if (i < n) {
+            return STREAM_SCAN_EDGE;
+        }
+        max -= n;
+    }
+    return STREAM_SCAN_IDLE;
+}
+
 bool consumer_peek(const stream_consumer_t *consumer, stream_sample_t *out) {
     assert(consumer != NULL);
     assert(out != NULL);
@@ -190,7 +1027,10 @@ size_t consumer_lag(const stream_consumer_t *consumer) {
 
 bool consumer_is_overrun(const stream_consumer_t *consumer) {
     assert(consumer != NULL);
-    return stream_is_overrun(consumer->stream, consumer->read_idx);
+
+    size_t write = stream_write_position(consumer->stream);
+    size_t oldest = stream_oldest_position(consumer->stream);
+    return write - consumer->read_idx > write - oldest;
 }
 
 size_t consumer_skip_to_latest(stream_consumer_t *consumer) {
@@ -204,13 +1044,6 @@ size_t consumer_skip_to_latest(stream_consumer_t *consumer) {
 void consumer_resync(stream_consumer_t *consumer) {
     assert(consumer != NULL);
 
-    size_t write_pos = stream_write_position(consumer->stream);
-    size_t capacity = stream_capacity(consumer->stream);
-
-    /* Move to oldest valid position */
-    if (write_pos >= capacity) {
-        consumer->read_idx = write_pos - capacity;
-    } else {
-        consumer->read_idx = 0;
-    }
+    /* Move to oldest valid position, archive included */
+    consumer->read_idx = stream_oldest_position(consumer->stream);
 }
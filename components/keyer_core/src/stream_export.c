@@ -0,0 +1,107 @@
+/**
+ * @file stream_export.c
+ * @brief Keying history export as a .cwk binary recording
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#include "stream_export.h"
+#include "sample.h"
+#include <assert.h>
+#include <string.h>
+
+void stream_export_begin(stream_export_t *exp, const keying_stream_t *stream,
+                         uint64_t window_ticks, uint64_t now_us) {
+    assert(exp != NULL);
+    assert(stream != NULL);
+
+    stream_key_state_t state;
+    stream_read_key_state(stream, &state);
+
+    /* Walk back from the last LOCAL slot until the window is covered */
+    size_t end = state.idx;
+    size_t oldest = stream_oldest_position(stream);
+    size_t start = end;
+    uint64_t covered = 0;
+    stream_sample_t s;
+    while (end - start < end - oldest && (window_ticks == 0 || covered < window_ticks)) {
+        if (!stream_read(stream, start - 1, &s)) {
+            break;  /* Overwritten while walking */
+        }
+        if (sample_lane(&s) == STREAM_LANE_LOCAL) {
+            covered += sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+        }
+        start--;
+    }
+
+    memset(exp, 0, sizeof(*exp));
+    exp->stream = stream;
+    exp->next_idx = start;
+    exp->end_idx = end;
+
+    cwk_header_t *h = &exp->header;
+    memcpy(h->magic, CWK_MAGIC, sizeof(h->magic));
+    h->version = CWK_VERSION;
+    h->header_size = (uint16_t)sizeof(cwk_header_t);
+    h->sample_size = (uint16_t)sizeof(stream_sample_t);
+    h->layout = SAMPLE_LAYOUT_VERSION;
+    h->tick_us = stream_tick_period_us(stream);
+    h->sample_count = (uint32_t)(end - start);
+    h->first_idx = (uint32_t)start;
+    h->first_tick = state.tick - covered;
+    h->captured_tick = state.tick;
+    h->captured_us = now_us;
+    exp->tick = h->first_tick;
+
+    stream_net_time_t clock;
+    if (stream_read_net_clock(stream, &clock)) {
+        cwk_header_set_net_clock(h, &clock);
+    }
+}
+
+void cwk_header_set_net_clock(cwk_header_t *h, const stream_net_time_t *clock) {
+    assert(h != NULL);
+    if (clock == NULL || clock->updates == 0U) {
+        h->net_first_us = 0;
+        h->net_drift_ppm = 0;
+        h->flags &= ~CWK_FLAG_NET_CLOCK;
+        return;
+    }
+    h->net_first_us = stream_net_time_us(clock, h->first_tick, h->tick_us);
+    h->net_drift_ppm = clock->drift_ppm;
+    h->flags |= CWK_FLAG_NET_CLOCK;
+}
+
+size_t stream_export_read(stream_export_t *exp, uint8_t *buf, size_t len) {
+    assert(exp != NULL);
+    assert(buf != NULL);
+
+    size_t n = 0;
+    if (exp->header_sent < sizeof(cwk_header_t)) {
+        size_t chunk = sizeof(cwk_header_t) - exp->header_sent;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(buf, (const uint8_t *)&exp->header + exp->header_sent, chunk);
+        exp->header_sent += chunk;
+        n = chunk;
+    }
+
+    stream_sample_t s;
+    while (exp->next_idx != exp->end_idx && len - n >= sizeof(stream_sample_t)) {
+        if (stream_read_slot_at(exp->stream, exp->next_idx, exp->tick, &s) != STREAM_READ_OK) {
+            /* Lapped: end the recording short rather than skip samples */
+            exp->lost = true;
+            exp->next_idx = exp->end_idx;
+            break;
+        }
+        if (sample_lane(&s) == STREAM_LANE_LOCAL) {
+            exp->tick += sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+        }
+        memcpy(buf + n, &s, sizeof(s));
+        n += sizeof(s);
+        exp->next_idx++;
+    }
+    return n;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file stream_handoff.c
+ * @brief Foreign lane handoff: Core 1 producers never write the hot ring
+ */
+
+#include "stream_handoff.h"
+#include <assert.h>
+
+#define HANDOFF_MASK (STREAM_HANDOFF_SIZE - 1U)
+
+_Static_assert((STREAM_HANDOFF_SIZE & HANDOFF_MASK) == 0, "STREAM_HANDOFF_SIZE must be a power of 2");
+
+void stream_handoff_init(stream_handoff_t *h, keying_stream_t *stream, stream_lane_t lane) {
+    assert(h != NULL);
+    assert(lane != STREAM_LANE_LOCAL);
+
+    stream_producer_init(&h->producer, stream, lane);
+    atomic_init(&h->head, 0U);
+    atomic_init(&h->tail, 0U);
+    atomic_init(&h->dropped, 0U);
+}
+
+bool stream_handoff_put(stream_handoff_t *h, stream_sample_t sample) {
+    unsigned head = atomic_load_explicit(&h->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&h->tail, memory_order_acquire);
+    if (head - tail >= STREAM_HANDOFF_SIZE) {
+        atomic_fetch_add_explicit(&h->dropped, 1U, memory_order_relaxed);
+        return false;
+    }
+    h->ring[head & HANDOFF_MASK] = sample;
+    atomic_store_explicit(&h->head, head + 1U, memory_order_release);
+    return true;
+}
+
+size_t stream_handoff_drain(stream_handoff_t *h, size_t max) {
+    unsigned tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&h->head, memory_order_acquire);
+    size_t n = 0;
+    while (tail != head && n < max) {
+        (void)stream_producer_push(&h->producer, h->ring[tail & HANDOFF_MASK]);
+        tail++;
+        n++;
+    }
+    atomic_store_explicit(&h->tail, tail, memory_order_release);
+    return n;
+}
+
+size_t stream_handoff_pending(const stream_handoff_t *h) {
+    unsigned tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&h->head, memory_order_acquire);
+    return (size_t)(head - tail);
+}
+
+void stream_handoffs_init(stream_handoffs_t *t) {
+    atomic_init(&t->count, 0U);
+    for (size_t i = 0; i < STREAM_HANDOFF_MAX; i++) {
+        atomic_init(&t->slots[i], NULL);
+    }
+}
+
+bool stream_handoffs_attach(stream_handoffs_t *t, stream_handoff_t *h) {
+    unsigned id = atomic_fetch_add_explicit(&t->count, 1U, memory_order_relaxed);
+    if (id >= STREAM_HANDOFF_MAX) {
+        return false;
+    }
+    atomic_store_explicit(&t->slots[id], h, memory_order_release);
+    return true;
+}
+
+size_t stream_handoffs_drain(stream_handoffs_t *t, size_t max) {
+    size_t n = 0;
+    for (size_t i = 0; i < STREAM_HANDOFF_MAX && n < max; i++) {
+        stream_handoff_t *h = atomic_load_explicit(&t->slots[i], memory_order_acquire);
+        if (h != NULL) {
+            n += stream_handoff_drain(h, max - n);
+        }
+    }
+    return n;
+}
+
+bool stream_handoffs_pending(const stream_handoffs_t *t) {
+    for (size_t i = 0; i < STREAM_HANDOFF_MAX; i++) {
+        const stream_handoff_t *h = atomic_load_explicit(&t->slots[i], memory_order_acquire);
+        if (h != NULL && stream_handoff_pending(h) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file stream_index.c
+ * @brief Time index over stream history
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#include "stream_index.h"
+#include "sample.h"
+#include <assert.h>
+#include <string.h>
+
+#define STREAM_INDEX_MASK (STREAM_INDEX_CAPACITY - 1)
+
+_Static_assert((STREAM_INDEX_CAPACITY & STREAM_INDEX_MASK) == 0,
+               "STREAM_INDEX_CAPACITY must be power of 2");
+
+void stream_index_init(stream_index_t *index, const keying_stream_t *stream) {
+    assert(index != NULL);
+    assert(stream != NULL);
+
+    memset(index->buffer, 0, sizeof(index->buffer));
+    atomic_init(&index->write_idx, 0);
+    index->stream = stream;
+    index->next_tick = 0;
+    index->edges_since = 0;
+    index->last.idx = 0;
+    index->last.pos = 0;
+    index->last.tick = 0;
+}
+
+/* ============================================================================
+ * Producer
+ * ============================================================================ */
+
+static uint64_t interval_ticks(const keying_stream_t *stream) {
+    uint32_t period_us = stream_tick_period_us(stream);
+    if (period_us == 0) {
+        period_us = 1000;
+    }
+    uint64_t ticks = (uint64_t)STREAM_INDEX_EVERY_MS * 1000U / period_us;
+    return (ticks > 0) ? ticks : 1U;
+}
+
+void stream_index_note(stream_index_t *index, size_t idx, uint64_t tick, uint32_t edges) {
+    assert(index != NULL);
+
+    index->edges_since += edges;
+
+    size_t write = atomic_load_explicit(&index->write_idx, memory_order_relaxed);
+    if (write != 0) {
+        /* Re-anchored backwards (consumer resync): keep the ring monotonic */
+        if (idx == index->last.idx || idx - index->last.idx > SIZE_MAX / 2 ||
+            tick < index->last.tick) {
+            return;
+        }
+        if (index->edges_since < STREAM_INDEX_EVERY_EDGES && tick < index->next_tick) {
+            return;
+        }
+    }
+
+    stream_checkpoint_t *c = &index->buffer[write & STREAM_INDEX_MASK];
+    c->idx = idx;
+    c->pos = stream_position_abs(index->stream, idx);
+    c->tick = tick;
+
+    /* RULE 3.1.2: Release so readers see the checkpoint before the index */
+    atomic_store_explicit(&index->write_idx, write + 1, memory_order_release);
+
+    index->last = *c;
+    index->edges_since = 0;
+    index->next_tick = tick + interval_ticks(index->stream);
+}
+
+/* ============================================================================
+ * Readers
+ * ============================================================================ */
+
+size_t stream_index_count(const stream_index_t *index) {
+    assert(index != NULL);
+
+    size_t write = atomic_load_explicit(&index->write_idx, memory_order_acquire);
+    return (write < STREAM_INDEX_CAPACITY) ? write : STREAM_INDEX_CAPACITY;
+}
+
+bool stream_index_find(const stream_index_t *index, uint64_t tick, stream_checkpoint_t *out) {
+    assert(index != NULL);
+    assert(out != NULL);
+
+    for (;;) {
+        size_t write = atomic_load_explicit(&index->write_idx, memory_order_acquire);
+        if (write == 0) {
+            return false;
+        }
+
+        /* Binary search over [oldest, write) for the last tick <= target.
+         * Entries the producer overwrites mid-search are caught below. */
+        size_t first = (write > STREAM_INDEX_CAPACITY) ? write - STREAM_INDEX_CAPACITY : 0;
+        size_t lo = first;
+        size_t hi = write;
+        if (index->buffer[lo & STREAM_INDEX_MASK].tick > tick) {
+            lo = hi;  /* Older than the oldest checkpoint */
+        } else {
+            while (hi - lo > 1) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (index->buffer[mid & STREAM_INDEX_MASK].tick <= tick) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+        }
+        stream_checkpoint_t copy = index->buffer[lo & STREAM_INDEX_MASK];
+
+        /* Producer may have lapped the search window */
+        atomic_thread_fence(memory_order_acquire);
+        size_t now = atomic_load_explicit(&index->write_idx, memory_order_relaxed);
+        if (now - first > STREAM_INDEX_CAPACITY) {
+            continue;
+        }
+
+        if (lo == write) {
+            return false;
+        }
+        *out = copy;
+        return true;
+    }
+}
+
+bool consumer_seek_time(stream_consumer_t *consumer, const stream_index_t *index,
+                        uint64_t tick, uint64_t *start_tick) {
+    assert(consumer != NULL);
+    assert(index != NULL);
+
+    stream_checkpoint_t cp;
+    if (!stream_index_find(index, tick, &cp)) {
+        return false;
+    }
+
+    const keying_stream_t *stream = index->stream;
+    size_t oldest = stream_oldest_position(stream);
+    size_t write = stream_write_position(stream);
+    if (write - cp.idx > write - oldest) {
+        return false;  /* Checkpoint fell out of the history tiers */
+    }
+
+    /* Walk forward summing LOCAL ticks, like timed_consumer_step() */
+    size_t idx = cp.idx;
+    uint64_t at = cp.tick;
+    stream_sample_t s;
+    while (stream_read(stream, idx, &s)) {
+        if (sample_lane(&s) == STREAM_LANE_LOCAL) {
+            uint64_t len = sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+            if (at + len > tick) {
+                break;
+            }
+            at += len;
+        }
+        idx++;
+    }
+
+    /* Stopped short of the write position: lost to an overwrite or a gap */
+    if (idx != stream_write_position(stream) && !stream_read(stream, idx, &s)) {
+        return false;
+    }
+
+    consumer->read_idx = idx;
+    if (start_tick != NULL) {
+        *start_tick = at;
+    }
+    return true;
+}
@@ -0,0 +1,540 @@
+/**
+ * @file stream_rec.c
+ * @brief Long-term keying log on a flash partition
+ */
+
+#include "stream_rec.h"
+#include <assert.h>
+#include <string.h>
+
+/* ============================================================================
+ * Chunks
+ * ============================================================================ */
+
+/** Reflected CRC-32 (IEEE), state kept inverted between calls */
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return crc;
+}
+
+/** CRC state after the header, with its crc field taken as 0 */
+static uint32_t header_crc(const stream_rec_header_t *h) {
+    stream_rec_header_t copy = *h;
+    copy.crc = 0;
+    return crc32_update(0xFFFFFFFFU, &copy, sizeof(copy));
+}
+
+static uint32_t chunk_crc(const stream_rec_chunk_t *c) {
+    uint32_t crc = header_crc(&c->header);
+    return ~crc32_update(crc, c->records, (size_t)c->header.count * sizeof(stream_compact_t));
+}
+
+void stream_rec_chunk_begin(stream_rec_chunk_t *c, uint32_t session, uint32_t tick_us,
+                            uint64_t tick, int64_t unix_us) {
+    assert(c != NULL);
+    memset(&c->header, 0, sizeof(c->header));
+    c->header.magic = STREAM_REC_MAGIC;
+    c->header.version = STREAM_REC_VERSION;
+    c->header.session = session;
+    c->header.tick_us = tick_us;
+    c->header.first_tick = tick;
+    c->header.end_tick = tick;
+    c->header.unix_us = unix_us;
+}
+
+void stream_rec_chunk_set_net_clock(stream_rec_chunk_t *c, const stream_net_time_t *clock) {
+    assert(c != NULL);
+    assert(clock != NULL);
+    if (clock->updates == 0U) {
+        return;
+    }
+    c->header.net_us = stream_net_time_us(clock, c->header.first_tick, c->header.tick_us);
+    c->header.net_drift_ppm = clock->drift_ppm;
+    c->header.flags |= STREAM_REC_FLAG_NET_CLOCK;
+}
+
+/* Chain a LOCAL silence as exact records, skipping the ticks the chunk already covers */
+static bool chunk_add_silence(stream_rec_chunk_t *c, uint64_t tick, uint32_t ticks) {
+    uint64_t end = tick + ticks;
+    uint64_t at = (tick > c->header.end_tick) ? tick : c->header.end_tick;
+    while (at < end) {
+        if (c->header.count >= STREAM_REC_RECORDS) {
+            return false;
+        }
+        uint32_t n = (end - at > COMPACT_COUNT_MASK) ? COMPACT_COUNT_MASK : (uint32_t)(end - at);
+        stream_sample_t piece = sample_silence(n);
+        c->records[c->header.count] = sample_compact_encode(&piece);
+        c->header.count++;
+        at += n;
+        c->header.end_tick = at;
+    }
+    return true;
+}
+
+bool stream_rec_chunk_add(stream_rec_chunk_t *c, const stream_sample_t *s, uint64_t tick) {
+    assert(c != NULL);
+    assert(s != NULL);
+
+    bool local = sample_lane(s) == STREAM_LANE_LOCAL;
+    if (local && sample_is_silence(s)) {
+        return chunk_add_silence(c, tick, sample_silence_ticks(s));
+    }
+    if (c->header.count >= STREAM_REC_RECORDS) {
+        return false;
+    }
+    if (local && c->header.count == 0U && tick < c->header.first_tick) {
+        /* Retried after the previous chunk filled: start where the sample does */
+        int64_t back_us = (int64_t)((c->header.first_tick - tick) * c->header.tick_us);
+        c->header.first_tick = tick;
+        c->header.end_tick = tick;
+        if (c->header.unix_us != 0) {
+            c->header.unix_us -= back_us;
+        }
+        if ((c->header.flags & STREAM_REC_FLAG_NET_CLOCK) != 0U) {
+            c->header.net_us -= back_us;
+        }
+    }
+    c->records[c->header.count] = sample_compact_encode(s);
+    c->header.count++;
+    if (local && tick + 1U > c->header.end_tick) {
+        c->header.end_tick = tick + 1U;
+    }
+    return true;
+}
+
+bool stream_rec_header_valid(const stream_rec_header_t *h) {
+    return h->magic == STREAM_REC_MAGIC &&
+           h->version == STREAM_REC_VERSION &&
+           h->count > 0 && h->count <= STREAM_REC_RECORDS &&
+           h->end_tick >= h->first_tick;
+}
+
+bool stream_rec_chunk_check(const stream_rec_chunk_t *c) {
+    return stream_rec_header_valid(&c->header) && chunk_crc(c) == c->header.crc;
+}
+
+/* ============================================================================
+ * Log
+ * ============================================================================ */
+
+static size_t chunk_offset(const stream_rec_log_t *log, uint32_t seq) {
+    return (size_t)(seq % log->flash.chunks) * STREAM_REC_CHUNK_BYTES;
+}
+
+/** Header of chunk seq, if that sector still holds it */
+static bool read_header(const stream_rec_log_t *log, uint32_t seq, stream_rec_header_t *h) {
+    return log->flash.read(log->flash.ctx, chunk_offset(log, seq), h, sizeof(*h)) &&
+           stream_rec_header_valid(h) && h->seq == seq;
+}
+
+/** Extend the newest session with a chunk, or start a session with it */
+static void index_add(stream_rec_log_t *log, const stream_rec_header_t *h) {
+    if (log->session_count > 0) {
+        stream_rec_session_t *last = &log->sessions[log->session_count - 1];
+        if (last->id == h->session && last->first_seq + last->chunks == h->seq) {
+            last->chunks++;
+            last->end_tick = h->end_tick;
+            return;
+        }
+    }
+    if (log->session_count == STREAM_REC_MAX_SESSIONS) {
+        memmove(&log->sessions[0], &log->sessions[1],
+                (STREAM_REC_MAX_SESSIONS - 1) * sizeof(log->sessions[0]));
+        log->session_count--;
+    }
+    log->sessions[log->session_count++] = (stream_rec_session_t){
+        .id = h->session,
+        .first_seq = h->seq,
+        .chunks = 1,
+        .tick_us = h->tick_us,
+        .first_tick = h->first_tick,
+        .end_tick = h->end_tick,
+        .unix_us = h->unix_us,
+    };
+}
+
+/** Chunk lost was erased: drop it (and anything older) from the index */
+static void index_drop(stream_rec_log_t *log, uint32_t lost) {
+    while (log->session_count > 0 && log->sessions[0].first_seq <= lost) {
+        stream_rec_session_t *s = &log->sessions[0];
+        uint32_t end = s->first_seq + s->chunks;
+        if (end <= lost + 1U) {
+            memmove(&log->sessions[0], &log->sessions[1],
+                    (log->session_count - 1) * sizeof(log->sessions[0]));
+            log->session_count--;
+            continue;
+        }
+        s->chunks = end - (lost + 1U);
+        s->first_seq = lost + 1U;
+        stream_rec_header_t h;
+        if (read_header(log, s->first_seq, &h)) {
+            s->first_tick = h.first_tick;
+            s->unix_us = h.unix_us;
+        }
+        break;
+    }
+}
+
+bool stream_rec_mount(stream_rec_log_t *log, const stream_rec_flash_t *flash,
+                      uint32_t bound_us) {
+    assert(log != NULL);
+    assert(flash != NULL);
+
+    memset(log, 0, sizeof(*log));
+    log->flash = *flash;
+    stream_rec_pacer_init(&log->pacer, bound_us);
+    if (flash->chunks < STREAM_REC_ERASE_AHEAD + 2U) {
+        return false;
+    }
+
+    /* Pass 1: newest chunk and highest session number */
+    bool any = false;
+    uint32_t max_seq = 0;
+    uint32_t max_session = 0;
+    for (uint32_t slot = 0; slot < flash->chunks; slot++) {
+        stream_rec_header_t h;
+        if (!flash->read(flash->ctx, (size_t)slot * STREAM_REC_CHUNK_BYTES, &h, sizeof(h)) ||
+            !stream_rec_header_valid(&h) || h.seq % flash->chunks != slot) {
+            continue;
+        }
+        if (!any || h.seq > max_seq) {
+            max_seq = h.seq;
+        }
+        if (h.session > max_session) {
+            max_session = h.session;
+        }
+        any = true;
+    }
+    log->head_seq = any ? max_seq + 1U : 0U;
+    log->erased_seq = log->head_seq;
+    log->next_session = max_session + 1U;
+
+    /* Pass 2: sessions, oldest chunk first */
+    uint32_t seq = (log->head_seq > flash->chunks) ? log->head_seq - flash->chunks : 0U;
+    for (; seq != log->head_seq; seq++) {
+        stream_rec_header_t h;
+        if (read_header(log, seq, &h)) {
+            index_add(log, &h);
+        }
+    }
+    return true;
+}
+
+uint32_t stream_rec_new_session(stream_rec_log_t *log) {
+    return log->next_session++;
+}
+
+uint32_t stream_rec_used(const stream_rec_log_t *log) {
+    uint32_t lost = (log->erased_seq > log->flash.chunks) ?
+                    log->erased_seq - log->flash.chunks : 0U;
+    return (log->head_seq > lost) ? log->head_seq - lost : 0U;
+}
+
+bool stream_rec_erase_next(stream_rec_log_t *log) {
+    assert(log != NULL);
+
+    if (stream_rec_erased_ahead(log) >= STREAM_REC_ERASE_AHEAD) {
+        return false;
+    }
+    uint32_t seq = log->erased_seq;
+    if (seq >= log->flash.chunks) {
+        index_drop(log, seq - log->flash.chunks);
+    }
+
+    int64_t start = log->flash.now_us(log->flash.ctx);
+    bool ok = log->flash.erase(log->flash.ctx, chunk_offset(log, seq));
+    uint32_t elapsed = (uint32_t)(log->flash.now_us(log->flash.ctx) - start);
+    log->erases++;
+    if (elapsed > log->erase_max_us) {
+        log->erase_max_us = elapsed;
+    }
+    if (!ok) {
+        log->errors++;
+        return false;
+    }
+    log->erased_seq++;
+    return true;
+}
+
+bool stream_rec_write_begin(stream_rec_log_t *log, stream_rec_chunk_t *c) {
+    assert(log != NULL);
+    assert(c != NULL);
+
+    if (log->pending != NULL || stream_rec_erased_ahead(log) == 0 ||
+        stream_rec_chunk_empty(c)) {
+        return false;
+    }
+    c->header.magic = STREAM_REC_MAGIC;
+    c->header.version = STREAM_REC_VERSION;
+    c->header.seq = log->head_seq;
+    c->header.crc = chunk_crc(c);
+    log->pending = c;
+    log->pending_off = sizeof(stream_rec_header_t);
+    return true;
+}
+
+/** One timed write call */
+static bool write_timed(stream_rec_log_t *log, size_t offset, const void *buf, size_t len) {
+    int64_t start = log->flash.now_us(log->flash.ctx);
+    bool ok = log->flash.write(log->flash.ctx, offset, buf, len);
+    int64_t elapsed = log->flash.now_us(log->flash.ctx) - start;
+    stream_rec_pacer_record(&log->pacer, (uint32_t)len, (uint32_t)elapsed);
+    return ok;
+}
+
+stream_rec_step_t stream_rec_write_step(stream_rec_log_t *log) {
+    assert(log != NULL);
+
+    const stream_rec_chunk_t *c = log->pending;
+    if (c == NULL) {
+        return STREAM_REC_STEP_IDLE;
+    }
+    size_t base = chunk_offset(log, log->head_seq);
+    size_t end = sizeof(stream_rec_header_t) + (size_t)c->header.count * sizeof(stream_compact_t);
+    bool ok;
+
+    if (log->pending_off < end) {
+        /* Records: one slice, ending on a page boundary */
+        size_t stop = (log->pending_off + log->pacer.slice) / STREAM_REC_PAGE_BYTES *
+                      STREAM_REC_PAGE_BYTES;
+        if (stop > end || stop <= log->pending_off) {
+            stop = end;
+        }
+        ok = write_timed(log, base + log->pending_off,
+                         (const uint8_t *)c + log->pending_off, stop - log->pending_off);
+        if (ok) {
+            log->pending_off = stop;
+            return STREAM_REC_STEP_MORE;
+        }
+    } else {
+        /* Header last: only now does the chunk exist */
+        ok = write_timed(log, base, &c->header, sizeof(c->header));
+        if (ok) {
+            index_add(log, &c->header);
+            log->chunks_written++;
+        }
+    }
+
+    /* Done, or the sector is dirty now: either way it is used up */
+    log->pending = NULL;
+    log->head_seq++;
+    if (!ok) {
+        log->errors++;
+        return STREAM_REC_STEP_ERROR;
+    }
+    return STREAM_REC_STEP_DONE;
+}
+
+const stream_rec_session_t *stream_rec_find_session(const stream_rec_log_t *log,
+                                                    uint32_t id) {
+    for (size_t i = log->session_count; i > 0; i--) {
+        if (log->sessions[i - 1].id == id) {
+            return &log->sessions[i - 1];
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Pacer
+ * ============================================================================ */
+
+void stream_rec_pacer_init(stream_rec_pacer_t *p, uint32_t bound_us) {
+    memset(p, 0, sizeof(*p));
+    p->bound_us = bound_us;
+    p->slice = 4U * STREAM_REC_PAGE_BYTES;
+}
+
+void stream_rec_pacer_record(stream_rec_pacer_t *p, uint32_t bytes, uint32_t elapsed_us) {
+    if (elapsed_us > p->worst_us) {
+        p->worst_us = elapsed_us;
+    }
+    if (elapsed_us > p->bound_us) {
+        p->over++;
+        if (p->slice > STREAM_REC_PAGE_BYTES) {
+            p->slice /= 2U;
+        }
+    } else if (bytes >= p->slice && elapsed_us < p->bound_us / 2U &&
+               p->slice < STREAM_REC_CHUNK_BYTES) {
+        /* Only full slices say how fast the flash is */
+        p->slice *= 2U;
+    }
+}
+
+/* ============================================================================
+ * Export
+ * ============================================================================ */
+
+/** Records expanded per flash read */
+#define EXPORT_BATCH 64U
+
+/** Silence markers needed to cover a gap */
+static uint32_t gap_markers(uint64_t gap) {
+    return (uint32_t)((gap + SAMPLE_SILENCE_MAX_TICKS - 1U) / SAMPLE_SILENCE_MAX_TICKS);
+}
+
+bool stream_rec_export_begin(stream_rec_export_t *exp, stream_rec_log_t *log, uint32_t id) {
+    assert(exp != NULL);
+    assert(log != NULL);
+
+    const stream_rec_session_t *s = stream_rec_find_session(log, id);
+    if (s == NULL) {
+        return false;
+    }
+    memset(exp, 0, sizeof(*exp));
+    exp->log = log;
+    exp->session = id;
+    exp->seq = s->first_seq;
+    exp->end_seq = s->first_seq + s->chunks;
+
+    /* Count samples (records plus gap markers) from the headers */
+    uint32_t samples = 0;
+    uint64_t first_tick = s->first_tick;
+    int64_t unix_us = s->unix_us;
+    uint64_t tick = 0;
+    stream_net_time_t net = {0};
+    for (uint32_t seq = exp->seq; seq != exp->end_seq; seq++) {
+        stream_rec_header_t h;
+        if (!read_header(log, seq, &h) || h.session != id) {
+            exp->end_seq = seq;
+            break;
+        }
+        if (net.updates == 0U && (h.flags & STREAM_REC_FLAG_NET_CLOCK) != 0U) {
+            net = (stream_net_time_t){
+                .ref_tick = h.first_tick,
+                .net_us = h.net_us,
+                .drift_ppm = h.net_drift_ppm,
+                .updates = 1,
+            };
+        }
+        if (seq == exp->seq) {
+            first_tick = h.first_tick;
+            unix_us = h.unix_us;
+            tick = first_tick;
+        }
+        if (h.first_tick > tick) {
+            samples += gap_markers(h.first_tick - tick);
+        }
+        samples += h.count;
+        tick = h.end_tick;
+    }
+    if (exp->end_seq == exp->seq) {
+        tick = first_tick;
+    }
+    exp->tick = first_tick;
+
+    cwk_header_t *ch = &exp->header;
+    memcpy(ch->magic, CWK_MAGIC, sizeof(ch->magic));
+    ch->version = CWK_VERSION;
+    ch->header_size = (uint16_t)sizeof(cwk_header_t);
+    ch->sample_size = (uint16_t)sizeof(stream_sample_t);
+    ch->layout = SAMPLE_LAYOUT_VERSION;
+    ch->tick_us = s->tick_us;
+    ch->sample_count = samples;
+    ch->first_idx = 0;
+    ch->first_tick = first_tick;
+    ch->captured_tick = tick;
+    ch->captured_us = (uint64_t)unix_us + (tick - first_tick) * s->tick_us;
+    cwk_header_set_net_clock(ch, &net);
+    return true;
+}
+
+/** Load the next chunk header; false at the end */
+static bool export_next_chunk(stream_rec_export_t *exp) {
+    if (exp->chunk.magic != 0U) {
+        if (~exp->crc != exp->chunk.crc) {
+            exp->corrupt++;
+        }
+        exp->tick = exp->chunk.end_tick;
+        exp->chunk.magic = 0;
+    }
+    if (exp->seq == exp->end_seq) {
+        return false;
+    }
+    if (!read_header(exp->log, exp->seq, &exp->chunk) || exp->chunk.session != exp->session) {
+        /* Erased under the export: the writer lapped it */
+        exp->lost = true;
+        exp->chunk.magic = 0;
+        exp->seq = exp->end_seq;
+        return false;
+    }
+    exp->seq++;
+    exp->record = 0;
+    exp->crc = header_crc(&exp->chunk);
+    return true;
+}
+
+size_t stream_rec_export_read(stream_rec_export_t *exp, uint8_t *buf, size_t len) {
+    assert(exp != NULL);
+    assert(buf != NULL);
+
+    size_t n = 0;
+    if (exp->header_sent < sizeof(cwk_header_t)) {
+        size_t part = sizeof(cwk_header_t) - exp->header_sent;
+        if (part > len) {
+            part = len;
+        }
+        memcpy(buf, (const uint8_t *)&exp->header + exp->header_sent, part);
+        exp->header_sent += part;
+        n = part;
+    }
+
+    while (len - n >= sizeof(stream_sample_t)) {
+        if (exp->chunk.magic == 0U || exp->record >= exp->chunk.count) {
+            if (!export_next_chunk(exp)) {
+                break;
+            }
+        }
+
+        /* The recorder fell behind the stream here: silence over the gap */
+        if (exp->record == 0 && exp->chunk.first_tick > exp->tick) {
+            uint64_t gap = exp->chunk.first_tick - exp->tick;
+            uint32_t ticks = (gap > SAMPLE_SILENCE_MAX_TICKS) ? SAMPLE_SILENCE_MAX_TICKS
+                                                              : (uint32_t)gap;
+            stream_sample_t s = sample_silence(ticks);
+            memcpy(buf + n, &s, sizeof(s));
+            n += sizeof(s);
+            exp->tick += ticks;
+            continue;
+        }
+
+        stream_compact_t rec[EXPORT_BATCH];
+        size_t k = exp->chunk.count - exp->record;
+        if (k > EXPORT_BATCH) {
+            k = EXPORT_BATCH;
+        }
+        if (k > (len - n) / sizeof(stream_sample_t)) {
+            k = (len - n) / sizeof(stream_sample_t);
+        }
+        size_t offset = chunk_offset(exp->log, exp->seq - 1U) + sizeof(stream_rec_header_t) +
+                        (size_t)exp->record * sizeof(stream_compact_t);
+        if (!exp->log->flash.read(exp->log->flash.ctx, offset, rec, k * sizeof(rec[0]))) {
+            exp->lost = true;
+            exp->chunk.magic = 0;
+            exp->seq = exp->end_seq;
+            break;
+        }
+        exp->crc = crc32_update(exp->crc, rec, k * sizeof(rec[0]));
+        for (size_t i = 0; i < k; i++) {
+            stream_sample_t s = sample_compact_decode_at(rec[i], exp->tick);
+            memcpy(buf + n, &s, sizeof(s));
+            n += sizeof(s);
+            if (sample_lane(&s) == STREAM_LANE_LOCAL) {
+                exp->tick += sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+            }
+        }
+        exp->record += (uint32_t)k;
+    }
+
+    /* Account the last chunk once its records are all out */
+    if (exp->chunk.magic != 0U && exp->record >= exp->chunk.count && exp->seq == exp->end_seq) {
+        (void)export_next_chunk(exp);
+    }
+    return n;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file stream_registry.c
+ * @brief Optional table of stream consumers with live lag telemetry
+ *
+ * Slots are claimed with fetch_add and published by their name pointer
+ * (release), after the counters are cleared; readers skip slots whose name
+ * is not there yet.
+ */
+
+#include "stream_registry.h"
+#include "stream.h"
+#include <string.h>
+
+void stream_registry_init(stream_registry_t *reg) {
+    memset(reg, 0, sizeof(*reg));
+    atomic_init(&reg->count, 0U);
+    for (size_t i = 0; i < STREAM_REGISTRY_MAX; i++) {
+        atomic_init(&reg->slots[i].name, NULL);
+    }
+}
+
+void stream_attach_registry(keying_stream_t *stream, stream_registry_t *reg) {
+    stream->registry = reg;
+}
+
+stream_consumer_entry_t *stream_register_consumer(const keying_stream_t *stream,
+                                                  const char *name, size_t read_idx) {
+    stream_registry_t *reg = stream->registry;
+    if (reg == NULL) {
+        return NULL;
+    }
+    unsigned id = atomic_fetch_add_explicit(&reg->count, 1U, memory_order_relaxed);
+    if (id >= STREAM_REGISTRY_MAX) {
+        return NULL;
+    }
+
+    stream_consumer_entry_t *entry = &reg->slots[id];
+    atomic_store_explicit(&entry->read_idx, read_idx, memory_order_relaxed);
+    atomic_store_explicit(&entry->max_lag, 0U, memory_order_relaxed);
+    atomic_store_explicit(&entry->dropped, 0U, memory_order_relaxed);
+    atomic_store_explicit(&entry->overruns, 0U, memory_order_relaxed);
+    atomic_store_explicit(&entry->reads, 0U, memory_order_relaxed);
+    for (size_t b = 0; b < STREAM_LAG_HIST_BINS; b++) {
+        atomic_store_explicit(&entry->hist[b], 0U, memory_order_relaxed);
+    }
+    atomic_store_explicit(&entry->name, name, memory_order_release);
+    return entry;
+}
+
+size_t stream_registry_snapshot(const keying_stream_t *stream,
+                                stream_consumer_info_t *out, size_t max) {
+    const stream_registry_t *reg = stream->registry;
+    if (reg == NULL) {
+        return 0;
+    }
+    unsigned count = atomic_load_explicit(&reg->count, memory_order_relaxed);
+    if (count > STREAM_REGISTRY_MAX) {
+        count = STREAM_REGISTRY_MAX;
+    }
+
+    size_t write = stream_write_position(stream);
+    size_t n = 0;
+    for (unsigned i = 0; i < count && n < max; i++) {
+        const stream_consumer_entry_t *entry = &reg->slots[i];
+        const char *name = atomic_load_explicit(&entry->name, memory_order_acquire);
+        if (name == NULL) {
+            continue;
+        }
+        stream_consumer_info_t *info = &out[n++];
+        info->name = name;
+        info->read_idx = atomic_load_explicit(&entry->read_idx, memory_order_relaxed);
+        info->lag = (write > info->read_idx) ? write - info->read_idx : 0;
+        info->max_lag = atomic_load_explicit(&entry->max_lag, memory_order_relaxed);
+        info->dropped = atomic_load_explicit(&entry->dropped, memory_order_relaxed);
+        info->overruns = atomic_load_explicit(&entry->overruns, memory_order_relaxed);
+        info->reads = atomic_load_explicit(&entry->reads, memory_order_relaxed);
+        for (size_t b = 0; b < STREAM_LAG_HIST_BINS; b++) {
+            info->hist[b] = atomic_load_explicit(&entry->hist[b], memory_order_relaxed);
+        }
+    }
+    return n;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file task_stats.c
+ * @brief Per-task CPU and stack high-water history
+ */
+
+#include "task_stats.h"
+#include <string.h>
+
+void task_stats_init(task_stats_t *ts) {
+    memset(ts, 0, sizeof(*ts));
+    atomic_init(&ts->task_count, 0U);
+    atomic_init(&ts->head, 0U);
+}
+
+/** Catalog index of a task, adding it if new; -1 if the catalog is full */
+static int catalog_find(task_stats_t *ts, const task_stats_input_t *task) {
+    unsigned count = atomic_load_explicit(&ts->task_count, memory_order_relaxed);
+    for (unsigned i = 0; i < count; i++) {
+        if (ts->tasks[i].id == task->id) {
+            return (int)i;
+        }
+    }
+    if (count >= TASK_STATS_MAX_TASKS) {
+        return -1;
+    }
+
+    task_stats_task_t *entry = &ts->tasks[count];
+    strncpy(entry->name, (task->name != NULL) ? task->name : "?", TASK_STATS_NAME_LEN - 1U);
+    entry->name[TASK_STATS_NAME_LEN - 1U] = '\0';
+    entry->id = task->id;
+    entry->core = task->core;
+    ts->prev_valid[count] = 0;
+    atomic_store_explicit(&ts->task_count, count + 1U, memory_order_release);
+    return (int)count;
+}
+
+static uint16_t share_pm(uint32_t delta, uint32_t total) {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t pm = (uint64_t)delta * 1000U / total;
+    return (uint16_t)((pm > 1000U) ? 1000U : pm);
+}
+
+void task_stats_record(task_stats_t *ts, uint32_t time_s, uint32_t total,
+                       const task_stats_input_t *in, size_t n,
+                       const uint32_t idle_id[TASK_STATS_CORES]) {
+    uint32_t head = atomic_load_explicit(&ts->head, memory_order_relaxed);
+    task_stats_sample_t *s = &ts->ring[head % TASK_STATS_HISTORY];
+    uint32_t total_delta = total - ts->prev_total;   /* Counters wrap */
+    uint8_t seen[TASK_STATS_MAX_TASKS] = {0};
+
+    s->seq = head;
+    s->time_s = time_s;
+    for (size_t c = 0; c < TASK_STATS_CORES; c++) {
+        s->idle_pm[c] = 0;
+    }
+    for (size_t i = 0; i < TASK_STATS_MAX_TASKS; i++) {
+        s->cpu_pm[i] = TASK_STATS_ABSENT;
+        s->stack_free[i] = TASK_STATS_ABSENT;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        int idx = catalog_find(ts, &in[i]);
+        if (idx < 0) {
+            continue;
+        }
+        uint16_t pm = 0;
+        if (ts->prev_valid[idx]) {
+            pm = share_pm(in[i].runtime - ts->prev_runtime[idx], total_delta);
+        }
+        ts->prev_runtime[idx] = in[i].runtime;
+        ts->prev_valid[idx] = 1;
+        seen[idx] = 1;
+
+        s->cpu_pm[idx] = pm;
+        s->stack_free[idx] = (uint16_t)((in[i].stack_free >= TASK_STATS_ABSENT)
+                                            ? TASK_STATS_ABSENT - 1U : in[i].stack_free);
+        for (size_t c = 0; c < TASK_STATS_CORES; c++) {
+            if (in[i].id == idle_id[c]) {
+                s->idle_pm[c] = pm;
+            }
+        }
+    }
+
+    /* A task that went away starts over if its number comes back */
+    for (size_t i = 0; i < TASK_STATS_MAX_TASKS; i++) {
+        if (!seen[i]) {
+            ts->prev_valid[i] = 0;
+        }
+    }
+    ts->prev_total = total;
+
+    if (!ts->primed) {
+        ts->primed = 1;     /* Deltas need two samples */
+        return;
+    }
+    atomic_store_explicit(&ts->head, head + 1U, memory_order_release);
+}
+
+size_t task_stats_tasks(const task_stats_t *ts, task_stats_task_t *out, size_t max) {
+    unsigned count = atomic_load_explicit(&ts->task_count, memory_order_acquire);
+    size_t n = (count < max) ? count : max;
+    memcpy(out, ts->tasks, n * sizeof(out[0]));
+    return n;
+}
+
+size_t task_stats_read(const task_stats_t *ts, uint32_t since,
+                       task_stats_sample_t *out, size_t max) {
+    /* The slot of sequence head - H is the one the writer fills next */
+    uint32_t head = task_stats_head(ts);
+    uint32_t oldest = (head >= TASK_STATS_HISTORY) ? head - TASK_STATS_HISTORY + 1U : 0U;
+    if (since < oldest || since > head) {
+        since = oldest;
+    }
+
+    size_t n = 0;
+    for (uint32_t seq = since; seq != head && n < max; seq++) {
+        out[n++] = ts->ring[seq % TASK_STATS_HISTORY];
+    }
+
+    /* Drop what the writer lapped during the copy (it writes slot head % H) */
+    uint32_t now = task_stats_head(ts);
+    uint32_t valid = (now >= TASK_STATS_HISTORY) ? now - TASK_STATS_HISTORY + 1U : 0U;
+    size_t skip = (valid > since) ? valid - since : 0U;
+    if (skip > n) {
+        skip = n;
+    }
+    if (skip > 0) {
+        memmove(out, out + skip, (n - skip) * sizeof(out[0]));
+        n -= skip;
+    }
+    return n;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file telemetry.c
+ * @brief Fleet telemetry payloads: metrics batches, fault events, link state
+ */
+
+#include "telemetry.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+void telemetry_init(telemetry_t *t) {
+    memset(t, 0, sizeof(*t));
+    t->link_key = UINT32_MAX;
+}
+
+void telemetry_resync(telemetry_t *t) {
+    t->next_batch_us = 0;
+    t->link_key = UINT32_MAX;
+}
+
+bool telemetry_batch_due(telemetry_t *t, int64_t now_us, uint32_t interval_s) {
+    if (t->next_batch_us != 0 && now_us < t->next_batch_us) {
+        return false;
+    }
+    if (interval_s < TELEMETRY_INTERVAL_MIN_S) {
+        interval_s = TELEMETRY_INTERVAL_MIN_S;
+    }
+    t->next_batch_us = now_us + (int64_t)interval_s * 1000000;
+    return true;
+}
+
+size_t telemetry_render_batch(telemetry_t *t, const metrics_t *m, int64_t now_us,
+                              char *buf, size_t cap) {
+    t->batch_seq++;
+    int len = snprintf(buf, cap, "{\"seq\":%" PRIu32 ",\"up\":%" PRId64 ",\"faults_lost\":%" PRIu32
+                       ",\"m\":", t->batch_seq, now_us / 1000000, t->faults_lost);
+    if (len < 0 || (size_t)len >= cap) {
+        return 0;
+    }
+    size_t used = (size_t)len;
+    size_t body = metrics_render_json(m, buf + used, cap - used);
+    if (body == 0 || used + body + 2 > cap) {
+        return 0;
+    }
+    used += body;
+    buf[used++] = '}';
+    buf[used] = '\0';
+    return used;
+}
+
+size_t telemetry_take_faults(telemetry_t *t, const fault_log_t *log,
+                             fault_event_t *out, size_t max) {
+    unsigned from = t->fault_next;
+    size_t n = fault_log_read(log, &t->fault_next, out, max);
+    unsigned taken = t->fault_next - from;
+    if (taken > n && taken - n <= FAULT_LOG_SIZE * 2U) {   /* Not a log reset */
+        t->faults_lost += (uint32_t)(taken - n);
+    }
+    return n;
+}
+
+size_t telemetry_render_fault(const fault_event_t *ev, char *buf, size_t cap) {
+    int len = snprintf(buf, cap, "{\"up_ms\":%" PRId64 ",\"event\":\"%s\",\"code\":\"%s\","
+                       "\"data\":%" PRIu32 "}",
+                       ev->time_us / 1000, fault_event_str((fault_event_kind_t)ev->kind),
+                       fault_code_str((fault_code_t)ev->code), ev->data);
+    return (len < 0 || (size_t)len >= cap) ? 0U : (size_t)len;
+}
+
+bool telemetry_link_changed(telemetry_t *t, const telemetry_link_t *link) {
+    uint32_t key = (uint32_t)link->wifi | ((uint32_t)link->vpn << 8) |
+                   ((uint32_t)link->cwnet << 16);
+    if (key == t->link_key) {
+        return false;
+    }
+    t->link_key = key;
+    return true;
+}
+
+size_t telemetry_render_link(const telemetry_link_t *link, char *buf, size_t cap) {
+    int len = snprintf(buf, cap, "{\"wifi\":\"%s\",\"vpn\":\"%s\",\"cwnet\":\"%s\"}",
+                       link->wifi_str, link->vpn_str, link->cwnet_str);
+    return (len < 0 || (size_t)len >= cap) ? 0U : (size_t)len;
+}
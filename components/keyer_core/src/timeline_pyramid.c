@@ -0,0 +1,223 @@
+/**
+ * @file timeline_pyramid.c
+ * @brief Multi-resolution key history
+ */
+
+#include "timeline_pyramid.h"
+#include <string.h>
+
+#define CAP ((uint32_t)TIMELINE_PYRAMID_CAPACITY)
+
+uint32_t timeline_pyramid_res_us(uint8_t level) {
+    uint32_t res = TIMELINE_PYRAMID_BASE_US;
+    for (uint8_t i = 0; i < level; i++) {
+        res *= 10U;
+    }
+    return res;
+}
+
+void timeline_pyramid_init(timeline_pyramid_t *p) {
+    memset(p, 0, sizeof(*p));
+    for (int l = 0; l < TIMELINE_PYRAMID_LEVELS; l++) {
+        atomic_init(&p->level[l].head, 0);
+        atomic_init(&p->level[l].first, 0);
+    }
+}
+
+/**
+ * @brief Start a bucket with the current levels
+ */
+static void bucket_open(timeline_bucket_t *b, uint8_t down) {
+    memset(b, 0, sizeof(*b));
+    b->lo = down;
+    b->hi = down;
+}
+
+static void bucket_add_time(timeline_bucket_t *b, uint8_t down, int64_t us) {
+    for (int ch = 0; ch < TIMELINE_PYRAMID_CHANNELS; ch++) {
+        if (down & (1U << ch)) {
+            b->down_us[ch] += (uint32_t)us;
+        }
+    }
+}
+
+/**
+ * @brief Publish the open bucket and start the next one
+ */
+static void level_close(timeline_level_t *lv, uint8_t down) {
+    lv->buffer[lv->open & (CAP - 1)] = lv->cur;
+    lv->open++;
+    atomic_store_explicit(&lv->head, lv->open, memory_order_release);
+    bucket_open(&lv->cur, down);
+}
+
+/**
+ * @brief Move one level from pos to t with constant levels
+ */
+static void level_advance(timeline_level_t *lv, uint32_t res, int64_t pos, int64_t t,
+                          uint8_t down) {
+    uint32_t target = (uint32_t)(t / res);
+    while (lv->open < target) {
+        int64_t end = (int64_t)(lv->open + 1U) * res;
+        bucket_add_time(&lv->cur, down, end - pos);
+        level_close(lv, down);
+        pos = end;
+        if (target - lv->open > CAP) {
+            /* Long gap: only the last CAP buckets can still be held */
+            lv->open = target - CAP;
+            atomic_store_explicit(&lv->first, lv->open, memory_order_relaxed);
+            pos = (int64_t)lv->open * res;
+        }
+    }
+    bucket_add_time(&lv->cur, down, t - pos);
+}
+
+static void pyramid_start(timeline_pyramid_t *p, int64_t t) {
+    for (uint8_t l = 0; l < TIMELINE_PYRAMID_LEVELS; l++) {
+        timeline_level_t *lv = &p->level[l];
+        lv->open = (uint32_t)(t / timeline_pyramid_res_us(l));
+        bucket_open(&lv->cur, p->down);
+        atomic_store_explicit(&lv->first, lv->open, memory_order_relaxed);
+        atomic_store_explicit(&lv->head, lv->open, memory_order_release);
+    }
+    p->now_us = t;
+    p->started = true;
+}
+
+void timeline_pyramid_advance(timeline_pyramid_t *p, int64_t now_us) {
+    if (now_us < 0) {
+        return;
+    }
+    if (!p->started) {
+        pyramid_start(p, now_us);
+        return;
+    }
+    if (now_us <= p->now_us) {
+        return;
+    }
+    for (uint8_t l = 0; l < TIMELINE_PYRAMID_LEVELS; l++) {
+        level_advance(&p->level[l], timeline_pyramid_res_us(l), p->now_us, now_us, p->down);
+    }
+    p->now_us = now_us;
+}
+
+void timeline_pyramid_edge(timeline_pyramid_t *p, int64_t time_us, uint8_t channel,
+                           uint8_t level) {
+    if (channel >= TIMELINE_PYRAMID_CHANNELS) {
+        return;
+    }
+    timeline_pyramid_advance(p, time_us);
+    uint8_t bit = (uint8_t)(1U << channel);
+    if (((p->down & bit) != 0) == (level != 0)) {
+        return;   /* Not a change */
+    }
+    p->down = (uint8_t)(level ? (p->down | bit) : (p->down & ~bit));
+    for (int l = 0; l < TIMELINE_PYRAMID_LEVELS; l++) {
+        timeline_bucket_t *b = &p->level[l].cur;
+        if (b->edges[channel] < UINT16_MAX) {
+            b->edges[channel]++;
+        }
+        if (level) {
+            b->hi |= bit;
+        } else {
+            b->lo &= (uint8_t)~bit;
+        }
+    }
+}
+
+int64_t timeline_pyramid_end_us(const timeline_pyramid_t *p) {
+    return (int64_t)atomic_load_explicit(&p->level[0].head, memory_order_acquire) *
+           TIMELINE_PYRAMID_BASE_US;
+}
+
+/**
+ * @brief Oldest bucket a reader may still use, given the current head
+ *
+ * The producer may be overwriting the slot of head - CAP while it fills
+ * bucket head, so that one is already gone.
+ */
+static uint32_t level_lowest(const timeline_level_t *lv, uint32_t head) {
+    uint32_t first = atomic_load_explicit(&lv->first, memory_order_relaxed);
+    uint32_t low = (head >= CAP) ? head - CAP + 1U : 0U;
+    return (first > low) ? first : low;
+}
+
+uint32_t timeline_pyramid_range_begin(const timeline_pyramid_t *p, int64_t from_us,
+                                      int64_t to_us, uint32_t px, timeline_range_t *it) {
+    memset(it, 0, sizeof(*it));
+    if (px == 0) {
+        px = 1;
+    }
+    if (from_us < 0) {
+        from_us = 0;
+    }
+
+    for (uint8_t l = 0; l < TIMELINE_PYRAMID_LEVELS; l++) {
+        const timeline_level_t *lv = &p->level[l];
+        uint32_t res = timeline_pyramid_res_us(l);
+        uint32_t head = atomic_load_explicit(&lv->head, memory_order_acquire);
+        uint32_t first = atomic_load_explicit(&lv->first, memory_order_relaxed);
+
+        int64_t from_b = from_us / res;
+        int64_t to_b = to_us / res + ((to_us % res) > 0);
+        uint32_t b0 = (from_b < (int64_t)first) ? first : (uint32_t)from_b;
+        uint32_t b1 = (to_b > (int64_t)head) ? head : (uint32_t)to_b;
+        uint32_t n = (b1 > b0) ? b1 - b0 : 0U;
+
+        bool last = (l == TIMELINE_PYRAMID_LEVELS - 1);
+        if (!last && (b0 < level_lowest(lv, head) || n > px)) {
+            continue;   /* Start already gone, or too many buckets: go coarser */
+        }
+        it->level = l;
+        it->res_us = res;
+        it->per_column = (n + px - 1U) / px;
+        if (it->per_column == 0) {
+            it->per_column = 1;
+        }
+        it->next = b0;
+        it->end = b0 + n;
+        it->columns = (n + it->per_column - 1U) / it->per_column;
+        break;
+    }
+    return it->columns;
+}
+
+bool timeline_pyramid_range_next(const timeline_pyramid_t *p, timeline_range_t *it,
+                                 timeline_column_t *out) {
+    if (it->next >= it->end) {
+        return false;
+    }
+    const timeline_level_t *lv = &p->level[it->level];
+    uint32_t b0 = it->next;
+    uint32_t count = it->end - b0;
+    if (count > it->per_column) {
+        count = it->per_column;
+    }
+    it->next += count;
+
+    uint64_t down[TIMELINE_PYRAMID_CHANNELS] = {0};
+    memset(out, 0, sizeof(*out));
+    out->start_us = (int64_t)b0 * it->res_us;
+    out->lo = 0xFF;
+    for (uint32_t i = 0; i < count; i++) {
+        const timeline_bucket_t *b = &lv->buffer[(b0 + i) & (CAP - 1)];
+        for (int ch = 0; ch < TIMELINE_PYRAMID_CHANNELS; ch++) {
+            down[ch] += b->down_us[ch];
+            out->edges[ch] += b->edges[ch];
+        }
+        out->lo &= b->lo;
+        out->hi |= b->hi;
+    }
+
+    /* Validate after copying: none of the buckets may have been lapped */
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&lv->head, memory_order_relaxed);
+    out->valid = (b0 >= level_lowest(lv, head));
+
+    uint64_t span = (uint64_t)count * it->res_us;
+    for (int ch = 0; ch < TIMELINE_PYRAMID_CHANNELS; ch++) {
+        uint64_t pm = (down[ch] * 1000U + span / 2U) / span;
+        out->duty_pm[ch] = (uint16_t)((pm > 1000U) ? 1000U : pm);
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file tx_sched.c
+ * @brief Planning of hardware-timed TX edges
+ *
+ * Everything is written by the RT task; statistics are relaxed atomics so
+ * the console never sees a torn word.
+ */
+
+#include "tx_sched.h"
+#include <stddef.h>
+
+tx_sched_t g_tx_sched;
+
+void tx_sched_init(tx_sched_t *s, uint32_t lead_us, uint32_t guard_us) {
+    if (s == NULL) {
+        return;
+    }
+    s->lead_us = lead_us;
+    s->guard_us = guard_us;
+    s->level = false;
+    s->last_at_us = 0;
+    atomic_store_explicit(&s->edges, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->late, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->late_max_us, 0, memory_order_relaxed);
+}
+
+int64_t tx_sched_plan(tx_sched_t *s, bool on, int64_t edge_us, int64_t now_us) {
+    return tx_sched_plan_delayed(s, on, edge_us, 0, now_us);
+}
+
+int64_t tx_sched_plan_delayed(tx_sched_t *s, bool on, int64_t edge_us,
+                              uint32_t delay_us, int64_t now_us) {
+    if (on == s->level) {
+        return 0;
+    }
+
+    /* The edge cannot be after the tick that reports it */
+    if (edge_us > now_us) {
+        edge_us = now_us;
+    }
+    int64_t at = edge_us + (int64_t)s->lead_us + (int64_t)delay_us;
+    int64_t earliest = now_us + (int64_t)s->guard_us;
+    if (at < earliest) {
+        int64_t back = earliest - at;
+        uint32_t back_us = (back >= (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)back;
+        uint32_t late = atomic_load_explicit(&s->late, memory_order_relaxed);
+        atomic_store_explicit(&s->late, late + 1U, memory_order_relaxed);
+        if (back_us > atomic_load_explicit(&s->late_max_us, memory_order_relaxed)) {
+            atomic_store_explicit(&s->late_max_us, back_us, memory_order_relaxed);
+        }
+        at = earliest;
+    }
+    /* Edges go out in order even if the FSM's times do not */
+    if (at <= s->last_at_us) {
+        at = s->last_at_us + 1;
+    }
+
+    s->level = on;
+    s->last_at_us = at;
+    uint32_t edges = atomic_load_explicit(&s->edges, memory_order_relaxed);
+    atomic_store_explicit(&s->edges, edges + 1U, memory_order_relaxed);
+    return at;
+}
+
+void tx_sched_reset_level(tx_sched_t *s) {
+    s->level = false;
+}
+
+void tx_sched_get(const tx_sched_t *s, tx_sched_stats_t *out) {
+    if (s == NULL || out == NULL) {
+        return;
+    }
+    out->lead_us = s->lead_us;
+    out->edges = atomic_load_explicit(&s->edges, memory_order_relaxed);
+    out->late = atomic_load_explicit(&s->late, memory_order_relaxed);
+    out->late_max_us = atomic_load_explicit(&s->late_max_us, memory_order_relaxed);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file cwnet_audio.h
+ * @brief CWNet rig audio blocks (IMA ADPCM, extension)
+ *
+ * The server streams receiver audio as CWNET_CMD_AUDIO long-block frames.
+ * Each payload is one self-contained IMA ADPCM block, so a block lost or
+ * dropped never corrupts the ones after it:
+ *
+ *   [0..1] Sequence number (LE), +1 per block
+ *   [2..3] Predictor before the first sample (int16 LE)
+ *   [4]    Step index before the first sample (0-88)
+ *   [5]    Sample rate in kHz (CWNET_AUDIO_RATE_KHZ)
+ *   [6..]  4-bit codes, low nibble first: 2 samples per byte
+ *
+ * A full block is CWNET_AUDIO_BLOCK_SAMPLES samples (32 ms at 8 kHz) in
+ * CWNET_AUDIO_PAYLOAD_MAX bytes, small enough for the client to join in
+ * its parser buffer when the frame wraps the receive ring.
+ *
+ * Pure codec: no I/O, no allocation. Decoding runs in the CWNet task.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Sample rate of the rig audio stream (matches the sidetone) */
+#define CWNET_AUDIO_RATE_KHZ 8
+
+/** Samples in a full block */
+#define CWNET_AUDIO_BLOCK_SAMPLES 256
+
+/** Block header bytes */
+#define CWNET_AUDIO_HEADER 6
+
+/** Largest payload: header + two samples per byte */
+#define CWNET_AUDIO_PAYLOAD_MAX (CWNET_AUDIO_HEADER + CWNET_AUDIO_BLOCK_SAMPLES / 2)
+
+/**
+ * @brief Encoder state (server side, tests and tools)
+ */
+typedef struct {
+    uint16_t seq;           /**< Sequence of the next block */
+    int16_t predictor;      /**< ADPCM predictor carried across blocks */
+    uint8_t step_index;     /**< ADPCM step index carried across blocks */
+} cwnet_audio_enc_t;
+
+/**
+ * @brief Decoder state and counters
+ */
+typedef struct {
+    bool synced;            /**< A block has been seen */
+    uint16_t next_seq;      /**< Sequence expected next */
+    uint32_t blocks;        /**< Blocks decoded */
+    uint32_t lost;          /**< Blocks missing from the sequence */
+    uint32_t rejected;      /**< Malformed or wrong-rate blocks */
+} cwnet_audio_dec_t;
+
+/**
+ * @brief Initialize encoder
+ */
+void cwnet_audio_enc_init(cwnet_audio_enc_t *enc);
+
+/**
+ * @brief Encode one block
+ *
+ * @param enc Encoder
+ * @param pcm Samples (count must be even and <= CWNET_AUDIO_BLOCK_SAMPLES)
+ * @param count Number of samples
+ * @param payload Output payload
+ * @param len Payload capacity
+ * @return Payload bytes, or 0 if count or len is invalid
+ */
+size_t cwnet_audio_encode(cwnet_audio_enc_t *enc, const int16_t *pcm, size_t count,
+                          uint8_t *payload, size_t len);
+
+/**
+ * @brief Initialize (or resync) decoder, clearing counters
+ */
+void cwnet_audio_dec_init(cwnet_audio_dec_t *dec);
+
+/**
+ * @brief Decode one block
+ *
+ * @param dec Decoder
+ * @param payload CWNET_CMD_AUDIO payload
+ * @param len Payload length
+ * @param pcm Output samples
+ * @param max Output capacity
+ * @return Samples decoded (0 if the block was rejected)
+ */
+size_t cwnet_audio_decode(cwnet_audio_dec_t *dec, const uint8_t *payload, size_t len,
+                          int16_t *pcm, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file cwnet_backoff.h
+ * @brief Jittered exponential reconnect backoff
+ *
+ * delay(n) = min(base * 2^n, max), then scaled by a random factor in
+ * [1 - jitter, 1 + jitter) so that several keyers losing the same server
+ * do not reconnect in lockstep. Pure function: the caller supplies the
+ * random word (esp_random() on target, a fixed value in tests).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** First retry delay */
+#define CWNET_BACKOFF_BASE_MS       250
+
+/** Delay cap (reached after a few failures) */
+#define CWNET_BACKOFF_MAX_MS        5000
+
+/** Jitter as a percentage of the nominal delay (+/-) */
+#define CWNET_BACKOFF_JITTER_PCT    25
+
+/**
+ * @brief Delay before reconnect attempt number `attempt`
+ *
+ * @param attempt Consecutive failures so far (0 = first retry)
+ * @param rand Uniform random 32-bit word
+ * @return Delay in ms
+ */
+static inline uint32_t cwnet_backoff_delay_ms(uint32_t attempt, uint32_t rand) {
+    uint32_t nominal = CWNET_BACKOFF_MAX_MS;
+    if (attempt < 16) {
+        uint32_t d = (uint32_t)CWNET_BACKOFF_BASE_MS << attempt;
+        if (d < nominal) {
+            nominal = d;
+        }
+    }
+
+    /* Map rand onto [-span, +span) */
+    uint32_t span = nominal * CWNET_BACKOFF_JITTER_PCT / 100U;
+    if (span == 0) {
+        return nominal;
+    }
+    uint32_t offset = rand % (2U * span);
+    return nominal - span + offset;
+}
+
+#ifdef __cplusplus
+}
+#endif
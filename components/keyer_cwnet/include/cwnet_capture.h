@@ -0,0 +1,182 @@
+/**
+ * @file cwnet_capture.h
+ * @brief On-device CWNet packet capture, exported as .pcap
+ *
+ * Every CWNet buffer the task sends or receives (TCP chunks and UDP edge
+ * datagrams, both directions) can be copied into a ring of fixed slots
+ * with its esp_timer timestamp: one memcpy into a preallocated slot per
+ * frame, nothing allocated, nothing logged. A TCP chunk longer than a
+ * slot takes several consecutive slots; UDP datagrams longer than a slot
+ * are truncated (orig_len keeps the real size). When the ring is full the
+ * oldest slots are overwritten.
+ *
+ * The export writes a classic libpcap file (microsecond timestamps,
+ * LINKTYPE_RAW) with a synthetic IPv4 + TCP/UDP header in front of each
+ * slot, built from the endpoints the slot was captured with, so Wireshark
+ * reassembles the TCP stream and tools/wireshark/cwnet.lua dissects it
+ * like a live capture. Timestamps are seconds since boot.
+ *
+ * Writer: the CWNet task only. The export is a plain reader (HTTP task):
+ * each slot carries a commit tag, and a slot the writer reused while it
+ * was being copied is skipped and counted in `lost`.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Relaxed atomics, no locks, nothing allocated
+ * - RULE 3.1.4: The writer never waits for the reader
+ */
+
+#ifndef KEYER_CWNET_CAPTURE_H
+#define KEYER_CWNET_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bytes per slot, header included */
+#define CWNET_CAPTURE_SLOT_BYTES 256U
+
+/** Payload bytes per slot */
+#define CWNET_CAPTURE_SNAP (CWNET_CAPTURE_SLOT_BYTES - 32U)
+
+/** Synthetic IPv4 header + TCP header (the larger transport header) */
+#define CWNET_CAPTURE_NET_HDR (20U + 20U)
+
+/** Largest exported packet record: pcap record header + packet */
+#define CWNET_CAPTURE_MAX_RECORD (16U + CWNET_CAPTURE_NET_HDR + CWNET_CAPTURE_SNAP)
+
+/** pcap link type: raw IPv4, no link layer */
+#define CWNET_CAPTURE_LINKTYPE_RAW 101U
+
+/**
+ * @brief Traffic direction
+ */
+typedef enum {
+    CWNET_CAPTURE_TX = 0,   /**< Keyer -> server */
+    CWNET_CAPTURE_RX = 1    /**< Server -> keyer */
+} cwnet_capture_dir_t;
+
+/**
+ * @brief Transport the bytes travelled on
+ */
+typedef enum {
+    CWNET_CAPTURE_TCP = 0,
+    CWNET_CAPTURE_UDP = 1
+} cwnet_capture_proto_t;
+
+/**
+ * @brief Socket endpoints (host byte order)
+ */
+typedef struct {
+    uint32_t local_ip;
+    uint32_t remote_ip;
+    uint16_t local_port;
+    uint16_t remote_port;
+} cwnet_capture_endpoint_t;
+
+/**
+ * @brief One captured chunk (CWNET_CAPTURE_SLOT_BYTES)
+ */
+typedef struct {
+    atomic_uint tag;                /**< Ring position + 1 once written, 0 while writing */
+    uint16_t len;                   /**< Bytes in data */
+    uint16_t orig_len;              /**< Bytes on the wire (> len: truncated) */
+    int64_t timestamp_us;           /**< esp_timer time of the send()/recv() */
+    cwnet_capture_endpoint_t ep;    /**< Endpoints the bytes travelled between */
+    uint8_t dir;                    /**< cwnet_capture_dir_t */
+    uint8_t proto;                  /**< cwnet_capture_proto_t */
+    uint8_t reserved[2];
+    uint8_t data[CWNET_CAPTURE_SNAP];
+} cwnet_capture_slot_t;
+
+_Static_assert(sizeof(cwnet_capture_slot_t) == CWNET_CAPTURE_SLOT_BYTES,
+               "cwnet_capture_slot_t must fill its slot exactly");
+
+/**
+ * @brief Capture ring
+ */
+typedef struct {
+    cwnet_capture_slot_t *slots;    /**< Caller-provided storage (PSRAM on target) */
+    uint32_t mask;                  /**< Slot count - 1 */
+    atomic_uint write;              /**< Next ring position (writer only stores) */
+    atomic_bool enabled;            /**< Capture on */
+} cwnet_capture_t;
+
+/** Global capture ring (CWNet task writes, web UI exports) */
+extern cwnet_capture_t g_cwnet_capture;
+
+/**
+ * @brief Attach slot storage (capture off, ring empty)
+ *
+ * @param cap Ring
+ * @param slots Storage, left untouched until the first capture
+ * @param count Slot count, power of 2
+ */
+void cwnet_capture_init(cwnet_capture_t *cap, cwnet_capture_slot_t *slots, uint32_t count);
+
+/**
+ * @brief Turn capture on or off (the ring keeps what it holds)
+ */
+static inline void cwnet_capture_enable(cwnet_capture_t *cap, bool on) {
+    atomic_store_explicit(&cap->enabled, on, memory_order_relaxed);
+}
+
+/**
+ * @brief Record one buffer that was sent or received (writer only)
+ *
+ * No-op while capture is off or before init.
+ *
+ * @param cap Ring
+ * @param dir Direction
+ * @param proto Transport
+ * @param ep Endpoints of the socket
+ * @param data Bytes
+ * @param len Byte count
+ * @param timestamp_us esp_timer time of the I/O
+ */
+void cwnet_capture_frame(cwnet_capture_t *cap, cwnet_capture_dir_t dir,
+                         cwnet_capture_proto_t proto, const cwnet_capture_endpoint_t *ep,
+                         const uint8_t *data, size_t len, int64_t timestamp_us);
+
+/**
+ * @brief Export cursor over a snapshot of the ring
+ */
+typedef struct {
+    const cwnet_capture_t *cap;     /**< Exported ring */
+    uint32_t next;                  /**< Next ring position to emit */
+    uint32_t end;                   /**< One past the last position */
+    uint32_t tcp_seq[2];            /**< Synthetic TCP sequence per direction */
+    uint16_t ip_id;                 /**< Synthetic IPv4 identification */
+    uint8_t rec[CWNET_CAPTURE_MAX_RECORD]; /**< Record being emitted */
+    size_t rec_len;                 /**< Bytes in rec */
+    size_t rec_sent;                /**< Bytes of rec already emitted */
+    uint32_t records;               /**< Packet records emitted */
+    uint32_t lost;                  /**< Slots overwritten before they were read */
+} cwnet_capture_export_t;
+
+/**
+ * @brief Snapshot the ring for export, oldest slot first
+ *
+ * Starts with the pcap global header pending.
+ */
+void cwnet_capture_export_begin(cwnet_capture_export_t *exp, const cwnet_capture_t *cap);
+
+/**
+ * @brief Emit the next chunk of the .pcap file
+ *
+ * @param exp Exporter
+ * @param buf Destination chunk
+ * @param len Chunk size
+ * @return Bytes written, 0 when the file is complete
+ */
+size_t cwnet_capture_export_read(cwnet_capture_export_t *exp, uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_CWNET_CAPTURE_H */
@@ -62,6 +62,8 @@ typedef enum {
     CWNET_CMD_PING = 0x03,      /**< Bidirectional: time sync */
     CWNET_CMD_CW_UP = 0x14,     /**< Key up event */
     CWNET_CMD_CW_DOWN = 0x15,   /**< Key down event */
+    CWNET_CMD_SEQ = 0x30,       /**< UDP datagram: sequence of newest edge (extension) */
+    CWNET_CMD_AUDIO = 0x31,     /**< Server -> Client: rig audio block, cwnet_audio.h (extension) */
 } cwnet_cmd_t;
 
 /** CONNECT payload field sizes */
@@ -145,10 +147,26 @@ typedef void (*cwnet_cw_event_cb_t)(bool key_down,
                                      int32_t timestamp_ms,
                                      void *user_data);
 
+/**
+ * @brief Rig audio block received callback (optional)
+ *
+ * Called with each CWNET_CMD_AUDIO payload (see cwnet_audio.h).
+ *
+ * @param payload Block payload (valid only during the call)
+ * @param len Payload length
+ * @param user_data User context pointer
+ */
+typedef void (*cwnet_audio_cb_t)(const uint8_t *payload,
+                                  size_t len,
+                                  void *user_data);
+
 /*===========================================================================*/
 /* Configuration                                                             */
 /*===========================================================================*/
 
+/** Outgoing frame arena (holds a CONNECT frame plus a burst of events) */
+#define CWNET_TX_ARENA_SIZE 256
+
 /**
  * @brief Client configuration
  */
@@ -164,8 +182,11 @@ typedef struct {
     /* Optional callbacks */
     cwnet_state_change_cb_t state_change_cb;  /**< State change notification */
     cwnet_cw_event_cb_t cw_event_cb;          /**< Received CW event */
+    cwnet_audio_cb_t audio_cb;                /**< Received rig audio block */
 
     void *user_data;                    /**< User context for callbacks */
+
+    bool coalesce;                      /**< Queue frames until cwnet_client_flush() */
 } cwnet_client_config_t;
 
 /*===========================================================================*/
@@ -188,6 +209,7 @@ typedef struct {
     cwnet_get_time_ms_cb_t get_time_ms_cb;
     cwnet_state_change_cb_t state_change_cb;
     cwnet_cw_event_cb_t cw_event_cb;
+    cwnet_audio_cb_t audio_cb;
     void *user_data;
 
     /* State */
@@ -195,12 +217,18 @@ typedef struct {
 
     /* Timer synchronization */
     cwnet_timer_t timer;
+    cwnet_sync_t sync;   /**< Filters PING samples into timer */
 
     /* Latency measurement */
     int32_t latency_ms;  /**< Last measured RTT, -1 if unknown */
 
     /* Frame parser for incoming data */
     cwnet_frame_parser_t parser;
+
+    /* Outgoing frames waiting for one send() (coalesce mode) */
+    bool coalesce;
+    uint8_t tx_buf[CWNET_TX_ARENA_SIZE];
+    size_t tx_len;
 } cwnet_client_t;
 
 /*===========================================================================*/
@@ -244,6 +272,34 @@ int32_t cwnet_client_get_synced_time(const cwnet_client_t *client);
  */
 int32_t cwnet_client_get_latency_ms(const cwnet_client_t *client);
 
+/**
+ * @brief Get clock sync filter statistics
+ *
+ * @param client Client context
+ * @param out Offset, drift, RTT minimum and jitter (RTTs -1 if unknown)
+ */
+void cwnet_client_get_sync_stats(const cwnet_client_t *client,
+                                 cwnet_sync_stats_t *out);
+
+/**
+ * @brief Send every queued frame with a single send_cb call
+ *
+ * Only needed in coalesce mode. If the callback takes part of the arena,
+ * the rest stays queued for the next flush.
+ *
+ * @param client Client context
+ * @return CWNET_CLIENT_OK if the arena is empty or partly sent,
+ *         CWNET_CLIENT_ERR_SEND_FAILED if the callback failed (arena dropped)
+ */
+cwnet_client_err_t cwnet_client_flush(cwnet_client_t *client);
+
+/**
+ * @brief Bytes queued in the TX arena
+ */
+static inline size_t cwnet_client_tx_pending(const cwnet_client_t *client) {
+    return client->tx_len;
+}
+
 /*===========================================================================*/
 /* Connection Events (called by socket layer)                                */
 /*===========================================================================*/
@@ -268,6 +324,18 @@ void cwnet_client_on_connected(cwnet_client_t *client);
  */
 void cwnet_client_on_disconnected(cwnet_client_t *client);
 
+/**
+ * @brief Handle one complete frame parsed in place (see cwnet_rx.h)
+ *
+ * Contiguous payloads are handled where they lie. A payload split by the
+ * ring wrap is joined in the parser buffer if it fits, which only happens
+ * to the rare control frame straddling the end of the ring.
+ *
+ * @param client Client context
+ * @param frame Frame view
+ */
+void cwnet_client_on_frame(cwnet_client_t *client, const cwnet_frame_view_t *frame);
+
 /**
  * @brief Feed received data to the client
  *
@@ -299,3 +367,20 @@ void cwnet_client_on_data(cwnet_client_t *client,
  */
 cwnet_client_err_t cwnet_client_send_key_event(cwnet_client_t *client,
                                                 bool key_down);
+
+/**
+ * @brief Send CW key event stamped with the time the edge happened
+ *
+ * Like cwnet_client_send_key_event(), but the frame carries the synced
+ * time of local_time_ms (same base as get_time_ms_cb) instead of now,
+ * so events drained late keep their real spacing.
+ *
+ * @param client Client context
+ * @param key_down true for key down, false for key up
+ * @param local_time_ms Local time of the edge in milliseconds
+ * @return CWNET_CLIENT_OK on success,
+ *         CWNET_CLIENT_ERR_NOT_READY if not in READY state
+ */
+cwnet_client_err_t cwnet_client_send_key_event_at(cwnet_client_t *client,
+                                                   bool key_down,
+                                                   int32_t local_time_ms);
@@ -80,6 +80,21 @@ typedef struct {
     size_t bytes_consumed;          /**< Bytes consumed from input buffer */
 } cwnet_parse_result_t;
 
+/**
+ * @brief Complete frame referenced in place
+ *
+ * The payload is a (up to na bytes) followed by b (nb bytes); b is only
+ * used when the payload wraps around the end of a ring buffer.
+ */
+typedef struct {
+    uint8_t command;                /**< Command type (bits 5-0) */
+    uint16_t payload_len;           /**< na + nb */
+    const uint8_t *a;               /**< First payload span (NULL if none) */
+    size_t na;                      /**< Bytes in a */
+    const uint8_t *b;               /**< Wrapped remainder (NULL if none) */
+    size_t nb;                      /**< Bytes in b */
+} cwnet_frame_view_t;
+
 /**
  * @brief Get frame category from command byte
  *
@@ -0,0 +1,152 @@
+/**
+ * @file cwnet_jitter.h
+ * @brief Adaptive playout (jitter) buffer for received CW events
+ *
+ * Received CW_DOWN/CW_UP events carry the sender's timestamp. After
+ * mapping it to local time, transit = arrival - event is one-way delay
+ * plus clock-sync error. The buffer tracks the minimum transit over a
+ * short window (the constant part) and a smoothed deviation above it (the
+ * jitter), and plays each event at
+ *
+ *   play = event + min_transit + margin,  margin = clamp(k * jitter)
+ *
+ * so element and gap lengths are reproduced exactly as sent. The margin
+ * only changes while the buffer is empty and the key is up, never inside
+ * a character. Until enough events have been seen it is seeded from the
+ * PING round-trip time. A configured floor (remote.playout_ms) raises the
+ * lower margin bound for links whose jitter comes in bursts the window
+ * does not see.
+ *
+ * All times are local milliseconds (wrap-safe int32 differences).
+ * Single-threaded: owned by the CWNet task.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Pending events (must be power of 2) */
+#define CWNET_JITTER_CAPACITY       64
+
+/** Transit samples in the minimum-tracking window */
+#define CWNET_JITTER_WINDOW         32
+
+/** Events before measured jitter replaces the RTT seed */
+#define CWNET_JITTER_WARMUP         8
+
+/** Margin bounds */
+#define CWNET_JITTER_MIN_MS         10
+#define CWNET_JITTER_MAX_MS         500
+
+/** Margin = CWNET_JITTER_K * smoothed jitter */
+#define CWNET_JITTER_K              3
+
+/**
+ * @brief One scheduled event
+ */
+typedef struct {
+    int32_t play_ms;    /**< Local time to play at */
+    bool key_down;      /**< Key level */
+} cwnet_jitter_event_t;
+
+/**
+ * @brief Jitter buffer state
+ */
+typedef struct {
+    cwnet_jitter_event_t events[CWNET_JITTER_CAPACITY];
+    uint32_t head;                          /**< Next slot to fill */
+    uint32_t tail;                          /**< Next slot to play */
+
+    int32_t transit[CWNET_JITTER_WINDOW];   /**< Recent transit samples */
+    uint32_t transit_idx;                   /**< Next window slot */
+    uint32_t transit_count;                 /**< Samples seen (saturating) */
+    int32_t jitter_q4;                      /**< Smoothed excess transit, ms * 16 */
+    int32_t seed_margin_ms;                 /**< Margin from RTT before warmup */
+    int32_t floor_ms;                       /**< Least margin (>= CWNET_JITTER_MIN_MS) */
+
+    int32_t base_ms;                        /**< Applied minimum transit */
+    int32_t margin_ms;                      /**< Applied margin above it */
+    bool anchored;                          /**< base_ms/margin_ms are set */
+    bool key_down;                          /**< Level of the last scheduled event */
+    int32_t last_play_ms;                   /**< Keeps playout monotonic */
+
+    uint32_t late;                          /**< Events that arrived after their slot */
+    uint32_t overflow;                      /**< Events dropped on a full buffer */
+} cwnet_jitter_t;
+
+/**
+ * @brief Initialize an empty buffer
+ */
+void cwnet_jitter_init(cwnet_jitter_t *jb);
+
+/**
+ * @brief Seed the margin from the PING round-trip time
+ *
+ * Used until CWNET_JITTER_WARMUP events have been measured.
+ *
+ * @param jb Buffer
+ * @param rtt_ms Last RTT, ignored if negative
+ */
+void cwnet_jitter_seed_rtt(cwnet_jitter_t *jb, int32_t rtt_ms);
+
+/**
+ * @brief Raise the least margin above CWNET_JITTER_MIN_MS
+ *
+ * Applies from the next re-anchor; cleared by cwnet_jitter_init().
+ *
+ * @param jb Buffer
+ * @param floor_ms Least margin, clamped to CWNET_JITTER_MAX_MS
+ */
+void cwnet_jitter_set_floor(cwnet_jitter_t *jb, int32_t floor_ms);
+
+/**
+ * @brief Schedule a received event
+ *
+ * @param jb Buffer
+ * @param key_down Key level
+ * @param event_ms Sender's event time, mapped to local time
+ * @param arrival_ms Local time the frame arrived
+ * @return false if the buffer was full (event dropped)
+ */
+bool cwnet_jitter_push(cwnet_jitter_t *jb, bool key_down,
+                       int32_t event_ms, int32_t arrival_ms);
+
+/**
+ * @brief Take the next event that is due
+ *
+ * @param jb Buffer
+ * @param now_ms Current local time
+ * @param out Event (valid if true returned)
+ * @return true if an event was due
+ */
+bool cwnet_jitter_pop(cwnet_jitter_t *jb, int32_t now_ms, cwnet_jitter_event_t *out);
+
+/**
+ * @brief Events waiting to play
+ */
+static inline uint32_t cwnet_jitter_pending(const cwnet_jitter_t *jb) {
+    return jb->head - jb->tail;
+}
+
+/**
+ * @brief Margin currently applied above the minimum transit
+ *
+ * @return Added playout delay in ms
+ */
+int32_t cwnet_jitter_margin_ms(const cwnet_jitter_t *jb);
+
+/**
+ * @brief Sender's event time to playout time
+ *
+ * @return Minimum transit + margin in ms, 0 before the first event
+ */
+int32_t cwnet_jitter_delay_ms(const cwnet_jitter_t *jb);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file cwnet_latency.h
+ * @brief Edge-to-send latency histogram for CWNet forwarding
+ *
+ * Measures the time from a key edge's stream timestamp (epoch + tick *
+ * tick period) to the moment its frame was handed to send(). Recorded by
+ * the CWNet forwarder only; console and web UI read snapshots.
+ *
+ * Bin k counts latencies in [2^(k-1), 2^k) microseconds (bin 0 is 0us),
+ * the last bin is open-ended.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Histogram bins (last bin holds everything >= 2^(bins-2) us, ~4 s) */
+#define CWNET_LATENCY_HIST_BINS 24
+
+/**
+ * @brief Latency accumulators (single writer, relaxed atomics)
+ */
+typedef struct {
+    atomic_uint count;                          /**< Edges recorded */
+    atomic_uint min_us;                         /**< Smallest latency */
+    atomic_uint max_us;                         /**< Largest latency */
+    atomic_uint hist[CWNET_LATENCY_HIST_BINS];  /**< log2 histogram */
+} cwnet_latency_t;
+
+/**
+ * @brief Snapshot of the accumulators
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t hist[CWNET_LATENCY_HIST_BINS];
+} cwnet_latency_snapshot_t;
+
+/**
+ * @brief Clear all accumulators
+ */
+void cwnet_latency_init(cwnet_latency_t *lat);
+
+/**
+ * @brief Record one edge-to-send latency (writer only)
+ *
+ * @param lat Accumulators
+ * @param latency_us Latency; negative values (clock skew) count as 0
+ */
+void cwnet_latency_record(cwnet_latency_t *lat, int64_t latency_us);
+
+/**
+ * @brief Snapshot the accumulators (any task)
+ */
+void cwnet_latency_get(cwnet_latency_t *lat, cwnet_latency_snapshot_t *out);
+
+/**
+ * @brief Latency percentile from a snapshot
+ *
+ * Resolution is one log2 bin: returns the upper edge of the bin holding
+ * the pct-th percentile, clamped to [min_us, max_us].
+ *
+ * @param snap Snapshot
+ * @param pct Percentile, 0-100 (e.g. 50, 99)
+ * @return Latency in us, 0 if nothing was recorded
+ */
+uint32_t cwnet_latency_percentile_us(const cwnet_latency_snapshot_t *snap, uint32_t pct);
+
+/**
+ * @brief Histogram bin for a latency
+ */
+static inline uint32_t cwnet_latency_bin(uint32_t latency_us) {
+    uint32_t bin = 0;
+    while (latency_us != 0 && bin < CWNET_LATENCY_HIST_BINS - 1) {
+        latency_us >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,120 @@
+/**
+ * @file cwnet_peer.h
+ * @brief CWNet listener-side session for direct peer-to-peer keying
+ *
+ * Plays the server role of the CWNet protocol towards one other keyer on
+ * the LAN, so two keyers can work each other without a relay server. The
+ * connecting keyer runs the ordinary cwnet_client; this side answers its
+ * CONNECT with WELCOME and acts as the time master:
+ *
+ *   IDLE -> on_accepted() -> WAIT_CONNECT
+ *   WAIT_CONNECT -> recv CONNECT -> send WELCOME + PING REQUEST -> READY
+ *   READY -> every CWNET_PEER_PING_MS: send PING REQUEST (t0 = our time)
+ *   READY -> recv PING RESPONSE_1 -> send RESPONSE_2 (t2 = our time), RTT
+ *   READY -> recv CW_DOWN/CW_UP -> cw_event_cb (timestamps are OUR clock)
+ *   any state -> recv DISCONNECT / on_closed() -> IDLE
+ *
+ * Because the peer syncs to our PING t0, its event timestamps are already
+ * on our local clock and ours go out unconverted. Like cwnet_client, this
+ * module never touches a socket: I/O is injected through callbacks.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cwnet_client.h"
+
+/** PING REQUEST period while a peer is connected */
+#define CWNET_PEER_PING_MS  1000
+
+/**
+ * @brief Peer session state
+ */
+typedef enum {
+    CWNET_PEER_IDLE = 0,        /**< No peer connected */
+    CWNET_PEER_WAIT_CONNECT,    /**< Accepted, waiting for CONNECT */
+    CWNET_PEER_READY,           /**< WELCOME sent, keying in both directions */
+} cwnet_peer_state_t;
+
+/**
+ * @brief Peer session configuration
+ */
+typedef struct {
+    cwnet_send_cb_t send_cb;               /**< Send data callback (required) */
+    cwnet_get_time_ms_cb_t get_time_ms_cb; /**< Local time callback (required) */
+    cwnet_cw_event_cb_t cw_event_cb;       /**< Received CW event (optional) */
+    void *user_data;                       /**< User context for callbacks */
+} cwnet_peer_config_t;
+
+/**
+ * @brief Peer session context
+ */
+typedef struct {
+    cwnet_send_cb_t send_cb;
+    cwnet_get_time_ms_cb_t get_time_ms_cb;
+    cwnet_cw_event_cb_t cw_event_cb;
+    void *user_data;
+
+    cwnet_peer_state_t state;
+    char name[CWNET_MAX_USERNAME_LEN];  /**< Username from the peer's CONNECT */
+    uint8_t ping_id;                    /**< ID of the last REQUEST sent */
+    int32_t last_ping_ms;               /**< When the last REQUEST was sent */
+    int32_t latency_ms;                 /**< Last measured RTT, -1 if unknown */
+
+    cwnet_frame_parser_t parser;
+} cwnet_peer_t;
+
+/**
+ * @brief Initialize an idle peer session
+ *
+ * @param peer Session context (must not be NULL)
+ * @param config Configuration (must not be NULL)
+ * @return CWNET_CLIENT_OK, or CWNET_CLIENT_ERR_INVALID_ARG
+ */
+cwnet_client_err_t cwnet_peer_init(cwnet_peer_t *peer, const cwnet_peer_config_t *config);
+
+/**
+ * @brief A peer connection was accepted; wait for its CONNECT
+ */
+void cwnet_peer_on_accepted(cwnet_peer_t *peer);
+
+/**
+ * @brief The peer connection closed or failed
+ */
+void cwnet_peer_on_closed(cwnet_peer_t *peer);
+
+/**
+ * @brief Feed received bytes (fragmentation-tolerant)
+ *
+ * After a DISCONNECT frame the state is IDLE; the caller closes the socket.
+ */
+void cwnet_peer_on_data(cwnet_peer_t *peer, const uint8_t *data, size_t len);
+
+/**
+ * @brief Send a PING REQUEST if one is due
+ *
+ * @return CWNET_CLIENT_ERR_SEND_FAILED if the send callback failed
+ */
+cwnet_client_err_t cwnet_peer_poll(cwnet_peer_t *peer);
+
+/**
+ * @brief Send a key edge that happened at local_time_ms
+ *
+ * @return CWNET_CLIENT_OK, CWNET_CLIENT_ERR_NOT_READY before CONNECT,
+ *         or CWNET_CLIENT_ERR_SEND_FAILED
+ */
+cwnet_client_err_t cwnet_peer_send_key_event_at(cwnet_peer_t *peer,
+                                                bool key_down,
+                                                int32_t local_time_ms);
+
+/**
+ * @brief Get current state (IDLE if peer is NULL)
+ */
+cwnet_peer_state_t cwnet_peer_get_state(const cwnet_peer_t *peer);
+
+/**
+ * @brief Last measured RTT to the peer, -1 if unknown
+ */
+int32_t cwnet_peer_get_latency_ms(const cwnet_peer_t *peer);
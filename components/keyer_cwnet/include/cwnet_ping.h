@@ -13,6 +13,12 @@
  *   - t0 (4 bytes): requester timestamp
  *   - t1 (4 bytes): responder 1 timestamp
  *   - t2 (4 bytes): responder 2 timestamp
+ *
+ * A single PING gives an offset skewed by that exchange's queueing delay.
+ * cwnet_sync_t keeps a short window of (offset, RTT) samples, trusts the
+ * minimum-RTT one and estimates linear drift between the best samples of
+ * the older and newer half of the window, so a late PING no longer moves
+ * every CW timestamp that follows it.
  */
 
 #pragma once
@@ -51,11 +57,64 @@ typedef struct {
  *
  * Maintains offset between local clock and server clock.
  * The offset is adjusted on every PING REQUEST to prevent drift.
+ * Between adjustments it moves by drift_ppm, measured from ref_local_ms.
  */
 typedef struct {
-    int64_t offset_ms;          /**< Offset: synced = local + offset */
+    int64_t offset_ms;          /**< Offset at ref_local_ms: synced = local + offset */
+    int32_t ref_local_ms;       /**< Local time offset_ms was measured at */
+    int32_t drift_ppm;          /**< Server clock rate relative to ours */
 } cwnet_timer_t;
 
+/** Samples in the sync filter window */
+#define CWNET_SYNC_WINDOW           8
+
+/** Minimum local span between the two drift points */
+#define CWNET_SYNC_MIN_SPAN_MS      5000
+
+/** Drift estimates are clamped to +/- this (crystals are well inside it) */
+#define CWNET_SYNC_MAX_DRIFT_PPM    500
+
+/** A raw offset this far from the estimate means the server clock stepped */
+#define CWNET_SYNC_STEP_MS          1000
+
+/**
+ * @brief One PING REQUEST as seen by the sync filter
+ */
+typedef struct {
+    int64_t offset_ms;          /**< Raw offset: server t0 - local receive time */
+    int32_t local_ms;           /**< Local receive time */
+    int32_t rtt_ms;             /**< RTT from the matching RESPONSE_2, -1 until known */
+    uint8_t id;                 /**< PING sequence ID */
+} cwnet_sync_sample_t;
+
+/**
+ * @brief Clock sync filter state
+ */
+typedef struct {
+    cwnet_sync_sample_t samples[CWNET_SYNC_WINDOW];
+    uint32_t next;              /**< Next slot to fill */
+    uint32_t count;             /**< Valid samples (saturates at window) */
+    int32_t drift_ppm;          /**< Last drift estimate */
+    int32_t last_rtt_ms;        /**< Latest RTT, -1 if none */
+    int32_t rtt_jitter_q4;      /**< Smoothed |RTT change|, ms * 16 */
+    int64_t last_residual_ms;   /**< Latest raw offset minus the applied one */
+    uint32_t resets;            /**< Window flushes on a clock step */
+} cwnet_sync_t;
+
+/**
+ * @brief Sync filter statistics (for UI and playout)
+ */
+typedef struct {
+    int64_t offset_ms;          /**< Offset applied now */
+    int32_t drift_ppm;          /**< Applied drift */
+    int32_t rtt_ms;             /**< Latest RTT, -1 if unknown */
+    int32_t rtt_min_ms;         /**< Minimum RTT in the window, -1 if unknown */
+    int32_t rtt_jitter_ms;      /**< Smoothed RTT variation */
+    int32_t residual_ms;        /**< Latest raw offset minus the applied one */
+    uint32_t samples;           /**< Samples in the window */
+    uint32_t resets;            /**< Clock steps seen */
+} cwnet_sync_stats_t;
+
 /*===========================================================================*/
 /* Timer Synchronization                                                     */
 /*===========================================================================*/
@@ -93,6 +152,82 @@ void cwnet_timer_sync_to_server(cwnet_timer_t *timer,
 int32_t cwnet_timer_read_synced_ms(const cwnet_timer_t *timer,
                                     int32_t local_time_ms);
 
+/**
+ * @brief Synchronized time at full width
+ *
+ * Same estimate as cwnet_timer_read_synced_ms(), without the protocol's
+ * 2^31 wrap, for placing the keying stream on the server clock
+ * (stream_set_net_clock()).
+ *
+ * @param timer Timer context (NULL returns local_time_us unchanged)
+ * @param local_time_us Local time in microseconds (esp_timer base)
+ * @return Server-relative time in microseconds
+ */
+int64_t cwnet_timer_synced_us(const cwnet_timer_t *timer, int64_t local_time_us);
+
+/**
+ * @brief Map a server timestamp back to local time
+ *
+ * Inverse of cwnet_timer_read_synced_ms() (ignoring its 2^31 wrap), used
+ * to place received CW events on the local clock.
+ *
+ * @param timer Timer context (NULL returns server_time_ms unchanged)
+ * @param server_time_ms Server-relative timestamp
+ * @return int32_t Local time of the same instant
+ */
+int32_t cwnet_timer_server_to_local_ms(const cwnet_timer_t *timer,
+                                        int32_t server_time_ms);
+
+/*===========================================================================*/
+/* Sync Filter                                                               */
+/*===========================================================================*/
+
+/**
+ * @brief Initialize an empty sync filter
+ *
+ * @param sync Filter (may be NULL - no-op)
+ */
+void cwnet_sync_init(cwnet_sync_t *sync);
+
+/**
+ * @brief Feed a PING REQUEST and resync the timer from the filter
+ *
+ * Replaces cwnet_timer_sync_to_server() on the REQUEST: the timer is
+ * still updated on every REQUEST, but from the filtered estimate. Until an
+ * RTT is known the raw offset is used, exactly like the single-shot sync.
+ *
+ * @param sync Filter
+ * @param timer Timer to update
+ * @param request Parsed REQUEST (t0 = server time)
+ * @param local_time_ms Local time the REQUEST was received
+ */
+void cwnet_sync_on_request(cwnet_sync_t *sync,
+                           cwnet_timer_t *timer,
+                           const cwnet_ping_t *request,
+                           int32_t local_time_ms);
+
+/**
+ * @brief Attach an RTT (from RESPONSE_2) to the REQUEST with the same ID
+ *
+ * @param sync Filter
+ * @param id PING sequence ID
+ * @param rtt_ms Measured RTT, ignored if negative
+ */
+void cwnet_sync_on_rtt(cwnet_sync_t *sync, uint8_t id, int32_t rtt_ms);
+
+/**
+ * @brief Read filter statistics
+ *
+ * @param sync Filter
+ * @param timer Timer the filter drives
+ * @param local_time_ms Local time to evaluate the offset at
+ * @param out Statistics
+ */
+void cwnet_sync_get_stats(const cwnet_sync_t *sync,
+                          const cwnet_timer_t *timer,
+                          int32_t local_time_ms,
+                          cwnet_sync_stats_t *out);
+
 /*===========================================================================*/
 /* PING Parsing and Building                                                 */
 /*===========================================================================*/
@@ -130,6 +265,21 @@ bool cwnet_ping_build_response(const cwnet_ping_t *request,
                                 size_t buf_len,
                                 int32_t our_time_ms);
 
+/**
+ * @brief Serialize any PING (all fields as given)
+ *
+ * Used by the listener side (cwnet_peer.h), which sends REQUEST and
+ * RESPONSE_2 itself.
+ *
+ * @param ping PING to serialize
+ * @param buffer Output buffer (must be >= 16 bytes)
+ * @param buf_len Buffer size
+ * @return true if built successfully
+ */
+bool cwnet_ping_build(const cwnet_ping_t *ping,
+                      uint8_t *buffer,
+                      size_t buf_len);
+
 /**
  * @brief Calculate round-trip latency from RESPONSE_2
  *
@@ -0,0 +1,89 @@
+/**
+ * @file cwnet_rx.h
+ * @brief Zero-copy CWNet receive ring
+ *
+ * The socket layer recv()s straight into the ring's free space and frames
+ * are parsed in place. A complete frame is returned as a view: its payload
+ * is one span, or two when it wraps around the end of the ring, in the
+ * same a/b span form the stream consumers use. Nothing is copied on the
+ * way from the socket to the frame handler.
+ *
+ * Views stay valid until the next cwnet_rx_write_span().
+ * Single-threaded: owned by the CWNet task.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cwnet_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Ring size in bytes (must be power of 2) */
+#define CWNET_RX_RING_SIZE 2048
+
+/**
+ * @brief Result of cwnet_rx_next_frame()
+ */
+typedef enum {
+    CWNET_RX_FRAME = 0,     /**< A complete frame is in the view */
+    CWNET_RX_NEED_MORE,     /**< Frame incomplete, recv() more */
+    CWNET_RX_SKIPPED        /**< Invalid or oversize frame dropped, call again */
+} cwnet_rx_status_t;
+
+/**
+ * @brief Receive ring state
+ */
+typedef struct {
+    uint8_t buf[CWNET_RX_RING_SIZE];
+    uint32_t head;          /**< Bytes written (free-running) */
+    uint32_t tail;          /**< Bytes parsed (free-running) */
+    uint32_t discard;       /**< Oversize payload bytes still to drop */
+    uint32_t skipped;       /**< Frames dropped (reserved command or oversize) */
+} cwnet_rx_ring_t;
+
+/**
+ * @brief Reset to empty (e.g. on reconnect)
+ */
+void cwnet_rx_init(cwnet_rx_ring_t *ring);
+
+/**
+ * @brief Contiguous free space to recv() into
+ *
+ * @param ring Ring
+ * @param dst Start of the free span
+ * @return Bytes that may be written at *dst (0 if full)
+ */
+size_t cwnet_rx_write_span(cwnet_rx_ring_t *ring, uint8_t **dst);
+
+/**
+ * @brief Publish n bytes written at the span from cwnet_rx_write_span()
+ */
+void cwnet_rx_commit(cwnet_rx_ring_t *ring, size_t n);
+
+/**
+ * @brief Parse the next frame in place
+ *
+ * The frame's bytes are released on return; the view points into the
+ * ring until more data is written.
+ *
+ * @param ring Ring
+ * @param out Frame view (valid if CWNET_RX_FRAME returned)
+ * @return Parse status
+ */
+cwnet_rx_status_t cwnet_rx_next_frame(cwnet_rx_ring_t *ring, cwnet_frame_view_t *out);
+
+/**
+ * @brief Bytes received but not yet parsed
+ */
+static inline uint32_t cwnet_rx_pending(const cwnet_rx_ring_t *ring) {
+    return ring->head - ring->tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
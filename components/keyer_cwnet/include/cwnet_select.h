@@ -0,0 +1,177 @@
+/**
+ * @file cwnet_select.h
+ * @brief Failover server selection: probe order, scoring, stale links
+ *
+ * With remote.server_list set, remote.server_host and the listed servers
+ * form a failover group. Two sessions serve it (cwnet_socket.c): the
+ * active one is keyed and heard; the standby is connected and clock
+ * synced but never keyed, so taking over costs no handshake.
+ *
+ * The standby probes: it connects to each other candidate in turn, lets
+ * the server's PINGs fill its sync filter and scores it
+ *
+ *     score = minimum RTT + CWNET_SELECT_JITTER_WEIGHT * RTT jitter
+ *
+ * then parks on the best one. A standby that beats the active link by
+ * CWNET_SELECT_HYSTERESIS_MS takes over, and so does any synced standby
+ * once the active link misses a PING by half its interval, so a silent
+ * server is left within one PING interval instead of after the TCP
+ * timeouts.
+ *
+ * Pure logic on the sync filter state, no sockets: host-tested.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cwnet_client.h"
+#include "cwnet_ping.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Candidates in a failover group: remote.server_host + remote.server_list */
+#define CWNET_SELECT_MAX                4
+
+/** No candidate (fewer than two configured) */
+#define CWNET_SELECT_NONE               0xFFU
+
+/** PINGs in the sync window before a candidate is scored */
+#define CWNET_SELECT_PROBE_SAMPLES      3
+
+/** A candidate still unscored this long after READY counts as failed */
+#define CWNET_SELECT_PROBE_TIMEOUT_MS   20000
+
+/** Weight of the RTT jitter in the score */
+#define CWNET_SELECT_JITTER_WEIGHT      2
+
+/** A standby must score this much lower to take over a healthy link */
+#define CWNET_SELECT_HYSTERESIS_MS      15
+
+/** Every candidate is probed again this often */
+#define CWNET_SELECT_REPROBE_MS         600000
+
+/**
+ * @brief One configured server
+ */
+typedef struct {
+    char host[CWNET_MAX_HOST_LEN];
+    uint16_t port;
+} cwnet_select_host_t;
+
+/**
+ * @brief What is known about one candidate
+ */
+typedef struct {
+    int32_t score_ms;           /**< Last score, -1 = unknown or unreachable */
+    uint32_t failures;          /**< Consecutive failed probes */
+    bool probed;                /**< Scored or failed this round */
+} cwnet_select_cand_t;
+
+/**
+ * @brief Failover group
+ */
+typedef struct {
+    cwnet_select_cand_t cand[CWNET_SELECT_MAX];
+    uint8_t count;              /**< Configured candidates */
+    uint8_t cursor;             /**< Last candidate handed out for probing */
+} cwnet_select_t;
+
+/**
+ * @brief Parse remote.server_list
+ *
+ * Entries are "host" or "host:port", separated by commas, semicolons or
+ * spaces. A missing or invalid port is default_port; empty entries are
+ * skipped and a host longer than CWNET_MAX_HOST_LEN - 1 is cut.
+ *
+ * @param list List (NULL = empty)
+ * @param default_port Port for entries without one
+ * @param out Parsed servers
+ * @param max Capacity of out
+ * @return Entries written
+ */
+size_t cwnet_select_parse_list(const char *list, uint16_t default_port,
+                               cwnet_select_host_t *out, size_t max);
+
+/**
+ * @brief Start a group of count candidates, all unknown
+ *
+ * @param count Clamped to CWNET_SELECT_MAX
+ */
+void cwnet_select_init(cwnet_select_t *sel, size_t count);
+
+/**
+ * @brief Score of a link from its sync filter statistics
+ *
+ * @return Score in ms (lower is better), -1 until CWNET_SELECT_PROBE_SAMPLES
+ *         PINGs and an RTT are in the window
+ */
+int32_t cwnet_select_score(const cwnet_sync_stats_t *stats);
+
+/**
+ * @brief Record a candidate's score (marks it probed)
+ *
+ * @param score_ms From cwnet_select_score(); negative is ignored
+ */
+void cwnet_select_report(cwnet_select_t *sel, size_t idx, int32_t score_ms);
+
+/**
+ * @brief Record a failed candidate: unreachable, timed out or closed
+ */
+void cwnet_select_fail(cwnet_select_t *sel, size_t idx);
+
+/**
+ * @brief Forget which candidates were probed: the standby tries them all again
+ *
+ * Scores are kept, so the standby still parks on the best known one.
+ */
+void cwnet_select_new_round(cwnet_select_t *sel);
+
+/**
+ * @brief Candidate the standby should hold next
+ *
+ * The next candidate not yet probed this round, in round-robin order;
+ * once all were, the best scored one. With none reachable, the next one
+ * round-robin so the standby keeps trying. The active candidate is never
+ * returned.
+ *
+ * @param active Candidate of the active session
+ * @return Candidate index, CWNET_SELECT_NONE with fewer than two
+ */
+uint8_t cwnet_select_next(cwnet_select_t *sel, uint8_t active);
+
+/**
+ * @brief Whether a scored standby should take over a healthy active link
+ *
+ * Never while either score is unknown: a link that just came up is not
+ * left for one that merely scored first.
+ *
+ * @param active_ms Score of the active link, -1 = none yet
+ * @param standby_ms Score of the standby, -1 = none yet
+ */
+bool cwnet_select_better(int32_t active_ms, int32_t standby_ms);
+
+/**
+ * @brief Longest gap between PINGs in the sync window
+ *
+ * @return Interval in ms, 0 until two PINGs were seen
+ */
+int32_t cwnet_select_ping_interval_ms(const cwnet_sync_t *sync);
+
+/**
+ * @brief Whether the server has gone quiet
+ *
+ * True once the last PING is older than the interval (as measured by
+ * cwnet_select_ping_interval_ms()) by half of it. Never true before the
+ * interval is known.
+ *
+ * @param now_ms Local time (the clock the sync samples use)
+ */
+bool cwnet_select_stale(const cwnet_sync_t *sync, int32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,16 +6,37 @@
  * Handles connection, reconnection, and data transfer.
  *
  * Usage:
- *   1. cwnet_socket_init() - once at startup
- *   2. cwnet_socket_process() - call periodically from bg_task (100Hz)
- *   3. cwnet_socket_send_key_event() - send CW events
+ *   Create cwnet_task() pinned to Core 1. It calls cwnet_socket_init() and
+ *   then loops cwnet_socket_process(), blocking in select() on the socket
+ *   between iterations.
+ *
+ * Local key edges are read from g_keying_stream by the socket layer itself
+ * and sent with their stream timestamps; callers do not forward them.
+ * Received events are played out through a jitter buffer onto the
+ * REMOTE lane of g_keying_stream.
+ *
+ * With remote.peer_port set, one LAN keyer can also connect directly
+ * (cwnet_peer.h); the server connection is then optional.
+ *
+ * Up to CWNET_MAX_SESSIONS servers are kept connected at once. Every local
+ * edge goes to each READY session, highest priority first; received keying
+ * and rig audio come from the highest priority READY session only. The
+ * single-session getters below report that session.
+ *
+ * With remote.server_list set, slot 0 is a failover group (cwnet_select.h):
+ * two of its sessions serve one net, the active one and a standby that
+ * is connected and synced but never keyed or heard. The standby takes
+ * over when the active link drops, misses a PING or scores clearly worse.
  */
 
 #pragma once
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "cwnet_client.h"
+#include "cwnet_latency.h"
+#include "cwnet_audio.h"
 
 /**
  * @brief Socket connection state
@@ -30,6 +51,26 @@ typedef enum {
     CWNET_SOCK_ERROR            /**< Error state, will retry */
 } cwnet_socket_state_t;
 
+/** Concurrent server sessions (failover pair on slot 0, remote.server2_*) */
+#define CWNET_MAX_SESSIONS 3
+
+/**
+ * @brief One server session, as status pages show it
+ */
+typedef struct {
+    const char *host;           /**< Server host name (valid while running) */
+    uint16_t port;              /**< Server TCP port */
+    uint8_t slot;               /**< Config slot: 0 = server_*, 1 = server2_* */
+    uint8_t priority;           /**< Configured priority, higher first */
+    cwnet_socket_state_t state; /**< Connection state */
+    int32_t latency_ms;         /**< RTT, -1 if unknown */
+    bool udp;                   /**< Edges go over UDP */
+    bool rx_owner;              /**< Its keying and audio are played */
+    uint32_t rx_ignored;        /**< Events dropped while another session played */
+    bool standby;               /**< Failover spare: connected, not keyed */
+    cwnet_latency_snapshot_t edge_latency; /**< Edge -> send() histogram */
+} cwnet_session_info_t;
+
 /**
  * @brief Initialize CWNet socket layer
  *
@@ -41,19 +82,41 @@ void cwnet_socket_init(void);
 /**
  * @brief Process CWNet socket
  *
- * Call this periodically (e.g., 100Hz from bg_task).
- * Handles connection, reconnection, sending/receiving.
+ * Called by cwnet_task() after every wakeup. Handles connection, reconnection, sending/receiving, and forwards
+ * every local key edge pending in the keying stream.
  */
 void cwnet_socket_process(void);
 
 /**
- * @brief Send CW key event
+ * @brief CWNet network I/O task entry point
+ *
+ * Deletes itself if CWNet is disabled in config.
+ *
+ * @param arg Unused
+ */
+void cwnet_task(void *arg);
+
+/**
+ * @brief Send CW key event to every READY session
  *
  * @param key_down true for key down, false for key up
- * @return true if sent successfully
+ * @return true if at least one session sent it
  */
 bool cwnet_socket_send_key_event(bool key_down);
 
+/**
+ * @brief Send CW key event that happened at event_us (esp_timer base)
+ *
+ * Handed to every READY session, highest priority first; each stamps it
+ * on its own server clock. The frame is queued and goes out with the rest
+ * of the service pass, held at most remote.coalesce_us.
+ *
+ * @param key_down true for key down, false for key up
+ * @param event_us Time of the edge, e.g. from timed_consumer_time_us()
+ * @return true if at least one session queued it
+ */
+bool cwnet_socket_send_key_event_at(bool key_down, int64_t event_us);
+
 /**
  * @brief Get current socket state
  */
@@ -71,6 +134,75 @@ bool cwnet_socket_is_ready(void);
  */
 int32_t cwnet_socket_get_latency_ms(void);
 
+/**
+ * @brief Number of configured server sessions
+ */
+size_t cwnet_socket_session_count(void);
+
+/**
+ * @brief Status of one server session
+ *
+ * @param index 0 .. cwnet_socket_session_count() - 1, highest priority first
+ * @param out Filled on success
+ * @return false if index is out of range
+ */
+bool cwnet_socket_get_session(size_t index, cwnet_session_info_t *out);
+
+/**
+ * @brief Times a failover standby took over the keying
+ */
+uint32_t cwnet_socket_get_failovers(void);
+
+/**
+ * @brief Directly connected LAN peer, if any
+ *
+ * @param name Peer username (valid until the peer disconnects), may be NULL
+ * @param rtt_ms Last RTT to the peer, -1 if unknown, may be NULL
+ * @return true if a peer is connected and keying
+ */
+bool cwnet_socket_get_peer(const char **name, int32_t *rtt_ms);
+
+/**
+ * @brief Rig audio decode statistics
+ *
+ * @param out Decoder counters (blocks, lost, rejected), reset on READY
+ * @param overflow Blocks cut short because g_rig_audio was full, may be NULL
+ */
+void cwnet_socket_get_audio_stats(cwnet_audio_dec_t *out, uint32_t *overflow);
+
+/**
+ * @brief Get clock sync filter statistics
+ *
+ * @param out Offset, drift, minimum RTT and RTT jitter
+ */
+void cwnet_socket_get_sync_stats(cwnet_sync_stats_t *out);
+
+/**
+ * @brief Snapshot the edge-to-send latency histogram
+ *
+ * Latency runs from the edge's stream timestamp to the send() of its frame.
+ */
+void cwnet_socket_get_edge_latency(cwnet_latency_snapshot_t *out);
+
+/**
+ * @brief Playout margin of the receive jitter buffer
+ *
+ * @return Delay added above the minimum transit, in ms
+ */
+int32_t cwnet_socket_get_rx_margin_ms(void);
+
+/**
+ * @brief Total playout delay of the receive jitter buffer
+ *
+ * @return Sender's edge to local playout (minimum transit + margin), in ms
+ */
+int32_t cwnet_socket_get_rx_delay_ms(void);
+
+/**
+ * @brief Received events that arrived after their playout slot
+ */
+uint32_t cwnet_socket_get_rx_late(void);
+
 /**
  * @brief Get state as string (for logging)
  */
@@ -0,0 +1,126 @@
+/**
+ * @file cwnet_udp.h
+ * @brief CWNet key edge datagrams for the optional UDP transport
+ *
+ * Over TCP one lost segment stalls every edge behind it. In UDP mode key
+ * edges travel as datagrams while TCP keeps the control traffic
+ * (CONNECT/WELCOME/PING). A datagram is plain cwnet_frame encoding:
+ *
+ *   SEQ (short, 4-byte LE sequence number of the newest edge)
+ *   CW_DOWN/CW_UP (short, 4-byte LE synced timestamp) x up to
+ *   CWNET_UDP_REDUNDANCY, oldest first
+ *
+ * Every datagram repeats the last few edges, so a single loss is repaired
+ * by the next datagram. The receiver puts edges back in order through a
+ * small reorder window and gives up on a missing edge after
+ * CWNET_UDP_HOLD_MS.
+ *
+ * SEQ is an extension; the peer must speak it (off by default).
+ * Pure code, no sockets: the socket layer moves the bytes.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Edges carried per datagram (newest plus repeats) */
+#define CWNET_UDP_REDUNDANCY    4
+
+/** Reorder window in edges (must be power of 2) */
+#define CWNET_UDP_WINDOW        16
+
+/** How long the receiver waits for a missing edge */
+#define CWNET_UDP_HOLD_MS       40
+
+/** Largest datagram built: SEQ frame + edge frames, 6 bytes each */
+#define CWNET_UDP_MAX_DATAGRAM  (6 * (1 + CWNET_UDP_REDUNDANCY))
+
+/**
+ * @brief One key edge
+ */
+typedef struct {
+    int32_t timestamp_ms;   /**< Synced (server) time of the edge */
+    bool key_down;          /**< Key level after the edge */
+} cwnet_udp_edge_t;
+
+/**
+ * @brief Sender state
+ */
+typedef struct {
+    cwnet_udp_edge_t recent[CWNET_UDP_REDUNDANCY];  /**< Ring of last edges */
+    uint32_t seq;                                   /**< Sequence of the next edge */
+} cwnet_udp_tx_t;
+
+/**
+ * @brief Receiver state
+ */
+typedef struct {
+    cwnet_udp_edge_t slots[CWNET_UDP_WINDOW];   /**< Edges by seq % window */
+    bool present[CWNET_UDP_WINDOW];             /**< Slot holds an undelivered edge */
+    uint32_t next_seq;                          /**< Next edge to deliver */
+    uint32_t pending;                           /**< Slots present */
+    bool started;                               /**< next_seq is known */
+    bool gap_open;                              /**< Waiting for next_seq */
+    int32_t gap_since_ms;                       /**< When the wait started */
+
+    uint32_t delivered;                         /**< Edges handed out */
+    uint32_t duplicates;                        /**< Repeats already seen */
+    uint32_t lost;                              /**< Edges given up on */
+    uint32_t malformed;                         /**< Datagrams rejected */
+} cwnet_udp_rx_t;
+
+/**
+ * @brief Initialize a sender (sequence starts at 0)
+ */
+void cwnet_udp_tx_init(cwnet_udp_tx_t *tx);
+
+/**
+ * @brief Record an edge and build the datagram that carries it
+ *
+ * @param tx Sender
+ * @param key_down Key level
+ * @param timestamp_ms Synced time of the edge
+ * @param out Datagram buffer (CWNET_UDP_MAX_DATAGRAM is always enough)
+ * @param cap Buffer size
+ * @return Datagram length, 0 if cap is too small
+ */
+size_t cwnet_udp_tx_build(cwnet_udp_tx_t *tx, bool key_down, int32_t timestamp_ms,
+                          uint8_t *out, size_t cap);
+
+/**
+ * @brief Initialize a receiver (synchronizes on the first datagram)
+ */
+void cwnet_udp_rx_init(cwnet_udp_rx_t *rx);
+
+/**
+ * @brief Feed one received datagram
+ *
+ * @param rx Receiver
+ * @param data Datagram bytes
+ * @param len Datagram length
+ * @param now_ms Local time
+ * @return false if the datagram was malformed
+ */
+bool cwnet_udp_rx_push(cwnet_udp_rx_t *rx, const uint8_t *data, size_t len, int32_t now_ms);
+
+/**
+ * @brief Take the next edge in sequence order
+ *
+ * A missing edge blocks later ones for at most CWNET_UDP_HOLD_MS.
+ *
+ * @param rx Receiver
+ * @param now_ms Local time
+ * @param out Edge (valid if true returned)
+ * @return true if an edge was delivered
+ */
+bool cwnet_udp_rx_pop(cwnet_udp_rx_t *rx, int32_t now_ms, cwnet_udp_edge_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,152 @@
+/**
+ * @file cwnet_audio.c
+ * @brief CWNet rig audio blocks (IMA ADPCM)
+ */
+
+#include "cwnet_audio.h"
+#include <string.h>
+
+#define STEP_INDEX_MAX 88
+
+static const int16_t s_step_table[STEP_INDEX_MAX + 1] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t s_index_table[8] = {
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/** Apply one 4-bit code to the predictor state, returning the new sample */
+static int16_t step(int32_t *predictor, int32_t *index, uint8_t code) {
+    int32_t st = s_step_table[*index];
+    int32_t diff = st >> 3;
+    if (code & 4U) {
+        diff += st;
+    }
+    if (code & 2U) {
+        diff += st >> 1;
+    }
+    if (code & 1U) {
+        diff += st >> 2;
+    }
+
+    int32_t p = (code & 8U) ? *predictor - diff : *predictor + diff;
+    if (p > INT16_MAX) {
+        p = INT16_MAX;
+    } else if (p < INT16_MIN) {
+        p = INT16_MIN;
+    }
+    *predictor = p;
+
+    int32_t i = *index + s_index_table[code & 7U];
+    *index = (i < 0) ? 0 : (i > STEP_INDEX_MAX) ? STEP_INDEX_MAX : i;
+    return (int16_t)p;
+}
+
+/** Pick the code that best approximates sample from the current state */
+static uint8_t quantize(int32_t predictor, int32_t index, int16_t sample) {
+    int32_t st = s_step_table[index];
+    int32_t diff = (int32_t)sample - predictor;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= st) {
+        code |= 4U;
+        diff -= st;
+    }
+    st >>= 1;
+    if (diff >= st) {
+        code |= 2U;
+        diff -= st;
+    }
+    st >>= 1;
+    if (diff >= st) {
+        code |= 1U;
+    }
+    return code;
+}
+
+void cwnet_audio_enc_init(cwnet_audio_enc_t *enc) {
+    memset(enc, 0, sizeof(*enc));
+}
+
+size_t cwnet_audio_encode(cwnet_audio_enc_t *enc, const int16_t *pcm, size_t count,
+                          uint8_t *payload, size_t len) {
+    size_t total = CWNET_AUDIO_HEADER + count / 2;
+    if (count == 0 || (count & 1U) != 0 || count > CWNET_AUDIO_BLOCK_SAMPLES || len < total) {
+        return 0;
+    }
+
+    uint16_t pred = (uint16_t)enc->predictor;
+    payload[0] = (uint8_t)(enc->seq & 0xFFU);
+    payload[1] = (uint8_t)(enc->seq >> 8);
+    payload[2] = (uint8_t)(pred & 0xFFU);
+    payload[3] = (uint8_t)(pred >> 8);
+    payload[4] = enc->step_index;
+    payload[5] = CWNET_AUDIO_RATE_KHZ;
+
+    int32_t predictor = enc->predictor;
+    int32_t index = enc->step_index;
+    for (size_t i = 0; i < count; i += 2) {
+        uint8_t lo = quantize(predictor, index, pcm[i]);
+        step(&predictor, &index, lo);
+        uint8_t hi = quantize(predictor, index, pcm[i + 1]);
+        step(&predictor, &index, hi);
+        payload[CWNET_AUDIO_HEADER + i / 2] = (uint8_t)(lo | (hi << 4));
+    }
+
+    enc->predictor = (int16_t)predictor;
+    enc->step_index = (uint8_t)index;
+    enc->seq++;
+    return total;
+}
+
+void cwnet_audio_dec_init(cwnet_audio_dec_t *dec) {
+    memset(dec, 0, sizeof(*dec));
+}
+
+size_t cwnet_audio_decode(cwnet_audio_dec_t *dec, const uint8_t *payload, size_t len,
+                          int16_t *pcm, size_t max) {
+    if (len <= CWNET_AUDIO_HEADER || len > CWNET_AUDIO_PAYLOAD_MAX ||
+        payload[4] > STEP_INDEX_MAX || payload[5] != CWNET_AUDIO_RATE_KHZ) {
+        dec->rejected++;
+        return 0;
+    }
+    size_t count = (len - CWNET_AUDIO_HEADER) * 2;
+    if (count > max) {
+        dec->rejected++;
+        return 0;
+    }
+
+    uint16_t seq = (uint16_t)((uint16_t)payload[0] | ((uint16_t)payload[1] << 8));
+    if (dec->synced) {
+        uint16_t gap = (uint16_t)(seq - dec->next_seq);
+        if (gap < 0x8000U) {
+            dec->lost += gap;
+        }
+    }
+    dec->synced = true;
+    dec->next_seq = (uint16_t)(seq + 1U);
+
+    int32_t predictor = (int16_t)((uint16_t)payload[2] | ((uint16_t)payload[3] << 8));
+    int32_t index = payload[4];
+    for (size_t i = 0; i < count; i += 2) {
+        uint8_t codes = payload[CWNET_AUDIO_HEADER + i / 2];
+        pcm[i] = step(&predictor, &index, (uint8_t)(codes & 0x0FU));
+        pcm[i + 1] = step(&predictor, &index, (uint8_t)(codes >> 4));
+    }
+
+    dec->blocks++;
+    return count;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file cwnet_capture.c
+ * @brief On-device CWNet packet capture, exported as .pcap
+ *
+ * A slot is published like a seqlock: tag cleared, payload written, tag
+ * set to position + 1 (release). The reader copies the slot and keeps
+ * it only if the tag read before and after the copy is the one expected.
+ */
+
+#include "cwnet_capture.h"
+#include <string.h>
+
+#define PCAP_MAGIC_US   0xA1B2C3D4U
+#define PCAP_SNAPLEN    65535U
+#define IP_HDR          20U
+#define TCP_HDR         20U
+#define UDP_HDR         8U
+#define IPPROTO_TCP_NUM 6U
+#define IPPROTO_UDP_NUM 17U
+#define TCP_FLAG_PSH    0x08U
+#define TCP_FLAG_ACK    0x10U
+
+/* pcap global header (24 bytes, host order) */
+#define PCAP_GLOBAL_HDR 24U
+
+cwnet_capture_t g_cwnet_capture;
+
+void cwnet_capture_init(cwnet_capture_t *cap, cwnet_capture_slot_t *slots, uint32_t count) {
+    if (cap == NULL) {
+        return;
+    }
+    cap->slots = slots;
+    cap->mask = (slots != NULL && count > 0 && (count & (count - 1U)) == 0) ? count - 1U : 0U;
+    if (cap->mask == 0) {
+        cap->slots = NULL;
+    }
+    atomic_store_explicit(&cap->write, 0, memory_order_relaxed);
+    atomic_store_explicit(&cap->enabled, false, memory_order_relaxed);
+}
+
+/** Fill the next slot with up to CWNET_CAPTURE_SNAP bytes */
+static void put_slot(cwnet_capture_t *cap, uint8_t dir, uint8_t proto,
+                     const cwnet_capture_endpoint_t *ep, const uint8_t *data,
+                     size_t len, size_t orig_len, int64_t timestamp_us) {
+    uint32_t pos = atomic_load_explicit(&cap->write, memory_order_relaxed);
+    cwnet_capture_slot_t *slot = &cap->slots[pos & cap->mask];
+
+    atomic_store_explicit(&slot->tag, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->len = (uint16_t)len;
+    slot->orig_len = (uint16_t)orig_len;
+    slot->timestamp_us = timestamp_us;
+    slot->ep = *ep;
+    slot->dir = dir;
+    slot->proto = proto;
+    memcpy(slot->data, data, len);
+    atomic_store_explicit(&slot->tag, pos + 1U, memory_order_release);
+    atomic_store_explicit(&cap->write, pos + 1U, memory_order_release);
+}
+
+void cwnet_capture_frame(cwnet_capture_t *cap, cwnet_capture_dir_t dir,
+                         cwnet_capture_proto_t proto, const cwnet_capture_endpoint_t *ep,
+                         const uint8_t *data, size_t len, int64_t timestamp_us) {
+    if (cap == NULL || cap->slots == NULL || data == NULL || len == 0 ||
+        !atomic_load_explicit(&cap->enabled, memory_order_relaxed)) {
+        return;
+    }
+
+    if (proto == CWNET_CAPTURE_UDP) {
+        /* A datagram can not be split: keep its head */
+        size_t n = (len < CWNET_CAPTURE_SNAP) ? len : CWNET_CAPTURE_SNAP;
+        size_t orig = (len < UINT16_MAX) ? len : UINT16_MAX;
+        put_slot(cap, (uint8_t)dir, (uint8_t)proto, ep, data, n, orig, timestamp_us);
+        return;
+    }
+
+    /* A stream chunk splits into consecutive segments */
+    while (len > 0) {
+        size_t n = (len < CWNET_CAPTURE_SNAP) ? len : CWNET_CAPTURE_SNAP;
+        put_slot(cap, (uint8_t)dir, (uint8_t)proto, ep, data, n, n, timestamp_us);
+        data += n;
+        len -= n;
+    }
+}
+
+/*===========================================================================*/
+/* Export                                                                    */
+/*===========================================================================*/
+
+static void put16le(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32le(uint8_t *p, uint32_t v) {
+    put16le(p, v);
+    put16le(p + 2, v >> 16);
+}
+
+static void put16be(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put32be(uint8_t *p, uint32_t v) {
+    put16be(p, v >> 16);
+    put16be(p + 2, v);
+}
+
+/** RFC 791 header checksum */
+static uint16_t ip_checksum(const uint8_t *hdr) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < IP_HDR; i += 2) {
+        sum += ((uint32_t)hdr[i] << 8) | hdr[i + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFFU) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+void cwnet_capture_export_begin(cwnet_capture_export_t *exp, const cwnet_capture_t *cap) {
+    memset(exp, 0, sizeof(*exp));
+    exp->cap = cap;
+    exp->tcp_seq[CWNET_CAPTURE_TX] = 1;
+    exp->tcp_seq[CWNET_CAPTURE_RX] = 1;
+
+    if (cap != NULL && cap->slots != NULL) {
+        uint32_t count = cap->mask + 1U;
+        exp->end = atomic_load_explicit(&cap->write, memory_order_acquire);
+        exp->next = (exp->end > count) ? exp->end - count : 0U;
+    }
+
+    uint8_t *h = exp->rec;
+    put32le(h, PCAP_MAGIC_US);
+    put16le(h + 4, 2);                  /* Version 2.4 */
+    put16le(h + 6, 4);
+    put32le(h + 8, 0);                  /* thiszone */
+    put32le(h + 12, 0);                 /* sigfigs */
+    put32le(h + 16, PCAP_SNAPLEN);
+    put32le(h + 20, CWNET_CAPTURE_LINKTYPE_RAW);
+    exp->rec_len = PCAP_GLOBAL_HDR;
+}
+
+/** Copy the slot at pos if the writer has not reused it meanwhile */
+static bool read_slot(const cwnet_capture_t *cap, uint32_t pos, cwnet_capture_slot_t *out) {
+    cwnet_capture_slot_t *slot = &cap->slots[pos & cap->mask];
+    uint32_t tag = atomic_load_explicit(&slot->tag, memory_order_acquire);
+    if (tag != pos + 1U) {
+        return false;
+    }
+    out->len = slot->len;
+    out->orig_len = slot->orig_len;
+    out->timestamp_us = slot->timestamp_us;
+    out->ep = slot->ep;
+    out->dir = slot->dir;
+    out->proto = slot->proto;
+    size_t n = (out->len <= CWNET_CAPTURE_SNAP) ? out->len : CWNET_CAPTURE_SNAP;
+    memcpy(out->data, slot->data, n);
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->tag, memory_order_relaxed) == tag && n == out->len;
+}
+
+/** Build the pcap record for one slot into exp->rec */
+static void build_record(cwnet_capture_export_t *exp, const cwnet_capture_slot_t *s) {
+    bool tx = (s->dir == CWNET_CAPTURE_TX);
+    bool tcp = (s->proto == CWNET_CAPTURE_TCP);
+    uint32_t l4 = tcp ? TCP_HDR : UDP_HDR;
+    uint32_t incl = IP_HDR + l4 + s->len;
+    uint32_t orig = IP_HDR + l4 + s->orig_len;
+
+    uint8_t *r = exp->rec;
+    int64_t ts = (s->timestamp_us > 0) ? s->timestamp_us : 0;
+    put32le(r, (uint32_t)(ts / 1000000));
+    put32le(r + 4, (uint32_t)(ts % 1000000));
+    put32le(r + 8, incl);
+    put32le(r + 12, orig);
+
+    uint32_t src = tx ? s->ep.local_ip : s->ep.remote_ip;
+    uint32_t dst = tx ? s->ep.remote_ip : s->ep.local_ip;
+    uint16_t sport = tx ? s->ep.local_port : s->ep.remote_port;
+    uint16_t dport = tx ? s->ep.remote_port : s->ep.local_port;
+
+    uint8_t *ip = r + 16;
+    memset(ip, 0, IP_HDR);
+    ip[0] = 0x45;                       /* IPv4, 5 words */
+    put16be(ip + 2, orig > 0xFFFFU ? 0xFFFFU : orig);
+    put16be(ip + 4, exp->ip_id++);
+    put16be(ip + 6, 0x4000);            /* Don't fragment */
+    ip[8] = 64;
+    ip[9] = (uint8_t)(tcp ? IPPROTO_TCP_NUM : IPPROTO_UDP_NUM);
+    put32be(ip + 12, src);
+    put32be(ip + 16, dst);
+    put16be(ip + 10, ip_checksum(ip));
+
+    uint8_t *l = ip + IP_HDR;
+    memset(l, 0, l4);
+    put16be(l, sport);
+    put16be(l + 2, dport);
+    if (tcp) {
+        /* Sequence follows the bytes seen, ack the other direction */
+        uint32_t *seq = &exp->tcp_seq[tx ? CWNET_CAPTURE_TX : CWNET_CAPTURE_RX];
+        put32be(l + 4, *seq);
+        put32be(l + 8, exp->tcp_seq[tx ? CWNET_CAPTURE_RX : CWNET_CAPTURE_TX]);
+        l[12] = (uint8_t)((TCP_HDR / 4U) << 4);
+        l[13] = (uint8_t)(TCP_FLAG_PSH | TCP_FLAG_ACK);
+        put16be(l + 14, 0xFFFF);        /* Window */
+        *seq += s->len;
+    } else {
+        put16be(l + 4, UDP_HDR + s->orig_len);
+    }
+
+    memcpy(l + l4, s->data, s->len);
+    exp->rec_len = 16U + incl;
+    exp->rec_sent = 0;
+    exp->records++;
+}
+
+size_t cwnet_capture_export_read(cwnet_capture_export_t *exp, uint8_t *buf, size_t len) {
+    size_t out = 0;
+    cwnet_capture_slot_t slot;
+
+    while (out < len) {
+        if (exp->rec_sent == exp->rec_len) {
+            if (exp->next == exp->end) {
+                break;
+            }
+            uint32_t pos = exp->next++;
+            if (!read_slot(exp->cap, pos, &slot)) {
+                exp->lost++;
+                continue;
+            }
+            build_record(exp, &slot);
+        }
+        size_t n = exp->rec_len - exp->rec_sent;
+        if (n > len - out) {
+            n = len - out;
+        }
+        memcpy(buf + out, exp->rec + exp->rec_sent, n);
+        exp->rec_sent += n;
+        out += n;
+    }
+    return out;
+}
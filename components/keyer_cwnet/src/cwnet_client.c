@@ -34,13 +34,27 @@ static void set_state(cwnet_client_t *client, cwnet_client_state_t new_state) {
 }
 
 /**
- * @brief Send a frame through the callback
+ * @brief Send a frame through the callback, or queue it in coalesce mode
  */
 static int send_frame(cwnet_client_t *client, const uint8_t *data, size_t len) {
     if (client == NULL || client->send_cb == NULL) {
         return -1;
     }
-    return client->send_cb(data, len, client->user_data);
+    if (!client->coalesce) {
+        return client->send_cb(data, len, client->user_data);
+    }
+
+    if (client->tx_len + len > sizeof(client->tx_buf)) {
+        if (cwnet_client_flush(client) != CWNET_CLIENT_OK) {
+            return -1;
+        }
+        if (client->tx_len + len > sizeof(client->tx_buf)) {
+            return -1;  /* Partial flush left no room: socket is backed up */
+        }
+    }
+    memcpy(&client->tx_buf[client->tx_len], data, len);
+    client->tx_len += len;
+    return (int)len;
 }
 
 /**
@@ -153,9 +167,9 @@ static cwnet_client_err_t send_ping_response(cwnet_client_t *client,
  *   - length: 4 (32-bit timestamp)
  *   - payload: 4-byte little-endian synced timestamp
  */
-static cwnet_client_err_t send_cw_event(cwnet_client_t *client, bool key_down) {
+static cwnet_client_err_t send_cw_event(cwnet_client_t *client, bool key_down,
+                                        int32_t local_time) {
     /* Get synced timestamp */
-    int32_t local_time = get_local_time(client);
     int32_t timestamp = cwnet_timer_read_synced_ms(&client->timer, local_time);
 
     /* Frame: cmd(1) + len(1) + timestamp(4) */
@@ -214,7 +228,7 @@ static void handle_ping(cwnet_client_t *client,
                 int32_t local_time = get_local_time(client);
                 int64_t old_offset = client->timer.offset_ms;
 
-                cwnet_timer_sync_to_server(&client->timer, ping.t0_ms, local_time);
+                cwnet_sync_on_request(&client->sync, &client->timer, &ping, local_time);
 
                 int64_t new_offset = client->timer.offset_ms;
                 int32_t synced_time = cwnet_timer_read_synced_ms(&client->timer, local_time);
@@ -233,6 +247,7 @@ static void handle_ping(cwnet_client_t *client,
                 int32_t latency = cwnet_ping_calc_latency(&ping);
                 if (latency >= 0) {
                     client->latency_ms = latency;
+                    cwnet_sync_on_rtt(&client->sync, ping.id, latency);
                     RT_DEBUG(&g_bg_log_stream, now_us, "RTT=%" PRId32 "ms", latency);
                 }
             }
@@ -293,6 +308,12 @@ static void process_frame(cwnet_client_t *client, const cwnet_parse_result_t *re
             handle_cw_event(client, false, payload, payload_len);
             break;
 
+        case CWNET_CMD_AUDIO:
+            if (client->audio_cb != NULL && payload != NULL) {
+                client->audio_cb(payload, payload_len, client->user_data);
+            }
+            break;
+
         default:
             /* Unknown command, ignore */
             break;
@@ -344,7 +365,9 @@ cwnet_client_err_t cwnet_client_init(cwnet_client_t *client,
     client->get_time_ms_cb = config->get_time_ms_cb;
     client->state_change_cb = config->state_change_cb;
     client->cw_event_cb = config->cw_event_cb;
+    client->audio_cb = config->audio_cb;
     client->user_data = config->user_data;
+    client->coalesce = config->coalesce;
 
     /* Initialize state */
     client->state = CWNET_STATE_DISCONNECTED;
@@ -352,6 +375,7 @@ cwnet_client_err_t cwnet_client_init(cwnet_client_t *client,
 
     /* Initialize timer */
     cwnet_timer_init(&client->timer);
+    cwnet_sync_init(&client->sync);
 
     /* Initialize frame parser */
     cwnet_frame_parser_init(&client->parser);
@@ -385,14 +409,53 @@ int32_t cwnet_client_get_latency_ms(const cwnet_client_t *client) {
     return client->latency_ms;
 }
 
+void cwnet_client_get_sync_stats(const cwnet_client_t *client,
+                                 cwnet_sync_stats_t *out) {
+    if (client == NULL) {
+        cwnet_sync_get_stats(NULL, NULL, 0, out);
+        return;
+    }
+    int32_t local_time = 0;
+    if (client->get_time_ms_cb != NULL) {
+        local_time = client->get_time_ms_cb(client->user_data);
+    }
+    cwnet_sync_get_stats(&client->sync, &client->timer, local_time, out);
+}
+
+cwnet_client_err_t cwnet_client_flush(cwnet_client_t *client) {
+    if (client == NULL || client->send_cb == NULL) {
+        return CWNET_CLIENT_ERR_INVALID_ARG;
+    }
+    if (client->tx_len == 0) {
+        return CWNET_CLIENT_OK;
+    }
+
+    int sent = client->send_cb(client->tx_buf, client->tx_len, client->user_data);
+    if (sent < 0) {
+        client->tx_len = 0;
+        return CWNET_CLIENT_ERR_SEND_FAILED;
+    }
+
+    size_t done = ((size_t)sent < client->tx_len) ? (size_t)sent : client->tx_len;
+    memmove(client->tx_buf, &client->tx_buf[done], client->tx_len - done);
+    client->tx_len -= done;
+    return CWNET_CLIENT_OK;
+}
+
 void cwnet_client_on_connected(cwnet_client_t *client) {
     if (client == NULL) {
         return;
     }
 
+    /* Nothing queued for the old connection may reach the new one */
+    client->tx_len = 0;
+
     /* Reset parser for new connection */
     cwnet_frame_parser_reset(&client->parser);
 
+    /* Samples from a previous session may be from another server */
+    cwnet_sync_init(&client->sync);
+
     /* Transition to CONNECTING */
     set_state(client, CWNET_STATE_CONNECTING);
 
@@ -407,11 +470,40 @@ void cwnet_client_on_disconnected(cwnet_client_t *client) {
 
     /* Reset parser */
     cwnet_frame_parser_reset(&client->parser);
+    client->tx_len = 0;
 
     /* Transition to DISCONNECTED */
     set_state(client, CWNET_STATE_DISCONNECTED);
 }
 
+void cwnet_client_on_frame(cwnet_client_t *client, const cwnet_frame_view_t *frame) {
+    if (client == NULL || frame == NULL) {
+        return;
+    }
+
+    cwnet_parse_result_t result = {
+        .status = CWNET_PARSE_OK,
+        .command = frame->command,
+        .payload_len = frame->payload_len,
+        .payload = frame->a,
+        .bytes_consumed = 0
+    };
+
+    if (frame->nb > 0) {
+        if (frame->payload_len > CWNET_FRAME_PARSER_BUF_SIZE) {
+            int64_t now_us = esp_timer_get_time();
+            RT_WARN(&g_bg_log_stream, now_us, "FRAME: cmd=0x%02X len=%u wrapped, dropped",
+                    frame->command, frame->payload_len);
+            return;
+        }
+        memcpy(client->parser.payload_buf, frame->a, frame->na);
+        memcpy(&client->parser.payload_buf[frame->na], frame->b, frame->nb);
+        result.payload = client->parser.payload_buf;
+    }
+
+    process_frame(client, &result);
+}
+
 void cwnet_client_on_data(cwnet_client_t *client,
                            const uint8_t *data,
                            size_t len) {
@@ -463,5 +555,19 @@ cwnet_client_err_t cwnet_client_send_key_event(cwnet_client_t *client,
         return CWNET_CLIENT_ERR_NOT_READY;
     }
 
-    return send_cw_event(client, key_down);
+    return send_cw_event(client, key_down, get_local_time(client));
+}
+
+cwnet_client_err_t cwnet_client_send_key_event_at(cwnet_client_t *client,
+                                                   bool key_down,
+                                                   int32_t local_time_ms) {
+    if (client == NULL) {
+        return CWNET_CLIENT_ERR_INVALID_ARG;
+    }
+
+    if (client->state != CWNET_STATE_READY) {
+        return CWNET_CLIENT_ERR_NOT_READY;
+    }
+
+    return send_cw_event(client, key_down, local_time_ms);
 }
@@ -0,0 +1,143 @@
+/**
+ * @file cwnet_jitter.c
+ * @brief Adaptive playout buffer for received CW events
+ */
+
+#include "cwnet_jitter.h"
+#include <stddef.h>
+#include <string.h>
+
+#define JITTER_MASK (CWNET_JITTER_CAPACITY - 1U)
+
+_Static_assert((CWNET_JITTER_CAPACITY & (CWNET_JITTER_CAPACITY - 1)) == 0,
+               "CWNET_JITTER_CAPACITY must be power of 2");
+
+static int32_t clamp_margin(const cwnet_jitter_t *jb, int32_t ms) {
+    if (ms < jb->floor_ms) {
+        return jb->floor_ms;
+    }
+    if (ms > CWNET_JITTER_MAX_MS) {
+        return CWNET_JITTER_MAX_MS;
+    }
+    return ms;
+}
+
+/** Record one transit sample, return the window minimum */
+static int32_t track_transit(cwnet_jitter_t *jb, int32_t transit) {
+    jb->transit[jb->transit_idx] = transit;
+    jb->transit_idx = (jb->transit_idx + 1U) % CWNET_JITTER_WINDOW;
+    if (jb->transit_count < UINT32_MAX) {
+        jb->transit_count++;
+    }
+
+    uint32_t n = (jb->transit_count < CWNET_JITTER_WINDOW) ? jb->transit_count
+                                                            : CWNET_JITTER_WINDOW;
+    int32_t min = jb->transit[0];
+    for (uint32_t i = 1; i < n; i++) {
+        if (jb->transit[i] < min) {
+            min = jb->transit[i];
+        }
+    }
+    return min;
+}
+
+void cwnet_jitter_init(cwnet_jitter_t *jb) {
+    if (jb == NULL) {
+        return;
+    }
+    memset(jb, 0, sizeof(*jb));
+    jb->floor_ms = CWNET_JITTER_MIN_MS;
+    jb->seed_margin_ms = CWNET_JITTER_MIN_MS;
+}
+
+void cwnet_jitter_set_floor(cwnet_jitter_t *jb, int32_t floor_ms) {
+    if (jb == NULL) {
+        return;
+    }
+    if (floor_ms < CWNET_JITTER_MIN_MS) {
+        floor_ms = CWNET_JITTER_MIN_MS;
+    }
+    if (floor_ms > CWNET_JITTER_MAX_MS) {
+        floor_ms = CWNET_JITTER_MAX_MS;
+    }
+    jb->floor_ms = floor_ms;
+    jb->seed_margin_ms = clamp_margin(jb, jb->seed_margin_ms);
+}
+
+void cwnet_jitter_seed_rtt(cwnet_jitter_t *jb, int32_t rtt_ms) {
+    if (jb == NULL || rtt_ms < 0) {
+        return;
+    }
+    /* Without measurements, assume one-way jitter up to half the RTT */
+    jb->seed_margin_ms = clamp_margin(jb, rtt_ms / 2);
+}
+
+bool cwnet_jitter_push(cwnet_jitter_t *jb, bool key_down,
+                       int32_t event_ms, int32_t arrival_ms) {
+    if (jb == NULL) {
+        return false;
+    }
+
+    int32_t transit = (int32_t)((uint32_t)arrival_ms - (uint32_t)event_ms);
+    int32_t min_transit = track_transit(jb, transit);
+
+    /* EWMA (1/8) of the excess over the minimum, in ms * 16 */
+    int32_t excess_q4 = (transit - min_transit) * 16;
+    jb->jitter_q4 += (excess_q4 - jb->jitter_q4) / 8;
+
+    /* Re-anchor only between transmissions: buffer empty and key up */
+    if (!jb->anchored || (cwnet_jitter_pending(jb) == 0 && !jb->key_down)) {
+        jb->base_ms = min_transit;
+        jb->margin_ms = (jb->transit_count >= CWNET_JITTER_WARMUP)
+                            ? clamp_margin(jb, CWNET_JITTER_K * jb->jitter_q4 / 16)
+                            : jb->seed_margin_ms;
+        jb->anchored = true;
+    }
+
+    if (cwnet_jitter_pending(jb) >= CWNET_JITTER_CAPACITY) {
+        jb->overflow++;
+        return false;
+    }
+
+    int32_t play_ms = (int32_t)((uint32_t)event_ms + (uint32_t)(jb->base_ms + jb->margin_ms));
+
+    /* Keep events in order (and gaps non-negative) even if the anchor moved back */
+    if (jb->head != 0 && (int32_t)((uint32_t)play_ms - (uint32_t)jb->last_play_ms) < 0) {
+        play_ms = jb->last_play_ms;
+    }
+    if ((int32_t)((uint32_t)play_ms - (uint32_t)arrival_ms) < 0) {
+        jb->late++;
+    }
+
+    cwnet_jitter_event_t *ev = &jb->events[jb->head & JITTER_MASK];
+    ev->play_ms = play_ms;
+    ev->key_down = key_down;
+    jb->head++;
+
+    jb->key_down = key_down;
+    jb->last_play_ms = play_ms;
+    return true;
+}
+
+bool cwnet_jitter_pop(cwnet_jitter_t *jb, int32_t now_ms, cwnet_jitter_event_t *out) {
+    if (jb == NULL || out == NULL || jb->head == jb->tail) {
+        return false;
+    }
+
+    const cwnet_jitter_event_t *ev = &jb->events[jb->tail & JITTER_MASK];
+    if ((int32_t)((uint32_t)now_ms - (uint32_t)ev->play_ms) < 0) {
+        return false;  /* Not due yet */
+    }
+
+    *out = *ev;
+    jb->tail++;
+    return true;
+}
+
+int32_t cwnet_jitter_margin_ms(const cwnet_jitter_t *jb) {
+    return (jb != NULL && jb->anchored) ? jb->margin_ms : 0;
+}
+
+int32_t cwnet_jitter_delay_ms(const cwnet_jitter_t *jb) {
+    return (jb != NULL && jb->anchored) ? jb->base_ms + jb->margin_ms : 0;
+}
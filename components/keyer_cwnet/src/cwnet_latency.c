@@ -0,0 +1,106 @@
+/**
+ * @file cwnet_latency.c
+ * @brief Edge-to-send latency histogram
+ */
+
+#include "cwnet_latency.h"
+#include <stddef.h>
+
+void cwnet_latency_init(cwnet_latency_t *lat) {
+    if (lat == NULL) {
+        return;
+    }
+    atomic_store_explicit(&lat->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&lat->min_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&lat->max_us, 0, memory_order_relaxed);
+    for (size_t i = 0; i < CWNET_LATENCY_HIST_BINS; i++) {
+        atomic_store_explicit(&lat->hist[i], 0, memory_order_relaxed);
+    }
+}
+
+void cwnet_latency_record(cwnet_latency_t *lat, int64_t latency_us) {
+    if (lat == NULL) {
+        return;
+    }
+
+    uint32_t us;
+    if (latency_us <= 0) {
+        us = 0;
+    } else if (latency_us >= (int64_t)UINT32_MAX) {
+        us = UINT32_MAX;
+    } else {
+        us = (uint32_t)latency_us;
+    }
+
+    uint32_t count = atomic_load_explicit(&lat->count, memory_order_relaxed);
+    if (count == 0 || us < atomic_load_explicit(&lat->min_us, memory_order_relaxed)) {
+        atomic_store_explicit(&lat->min_us, us, memory_order_relaxed);
+    }
+    if (count == 0 || us > atomic_load_explicit(&lat->max_us, memory_order_relaxed)) {
+        atomic_store_explicit(&lat->max_us, us, memory_order_relaxed);
+    }
+    if (count != UINT32_MAX) {
+        atomic_store_explicit(&lat->count, count + 1, memory_order_relaxed);
+    }
+
+    uint32_t bin = cwnet_latency_bin(us);
+    uint32_t h = atomic_load_explicit(&lat->hist[bin], memory_order_relaxed);
+    if (h != UINT32_MAX) {
+        atomic_store_explicit(&lat->hist[bin], h + 1, memory_order_relaxed);
+    }
+}
+
+void cwnet_latency_get(cwnet_latency_t *lat, cwnet_latency_snapshot_t *out) {
+    if (lat == NULL || out == NULL) {
+        return;
+    }
+    out->count = atomic_load_explicit(&lat->count, memory_order_relaxed);
+    out->min_us = atomic_load_explicit(&lat->min_us, memory_order_relaxed);
+    out->max_us = atomic_load_explicit(&lat->max_us, memory_order_relaxed);
+    for (size_t i = 0; i < CWNET_LATENCY_HIST_BINS; i++) {
+        out->hist[i] = atomic_load_explicit(&lat->hist[i], memory_order_relaxed);
+    }
+}
+
+uint32_t cwnet_latency_percentile_us(const cwnet_latency_snapshot_t *snap, uint32_t pct) {
+    if (snap == NULL) {
+        return 0;
+    }
+    if (pct > 100) {
+        pct = 100;
+    }
+
+    /* Bins saturate independently of count, so rank against their sum */
+    uint64_t total = 0;
+    for (size_t i = 0; i < CWNET_LATENCY_HIST_BINS; i++) {
+        total += snap->hist[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (total * pct + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    uint32_t upper = snap->max_us;
+    for (size_t i = 0; i < CWNET_LATENCY_HIST_BINS; i++) {
+        seen += snap->hist[i];
+        if (seen >= rank) {
+            if (i < CWNET_LATENCY_HIST_BINS - 1) {
+                upper = (i == 0) ? 0 : (uint32_t)((1UL << i) - 1);
+            }
+            break;
+        }
+    }
+
+    if (upper > snap->max_us) {
+        upper = snap->max_us;
+    }
+    if (upper < snap->min_us) {
+        upper = snap->min_us;
+    }
+    return upper;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file cwnet_peer.c
+ * @brief CWNet listener-side session for direct peer-to-peer keying
+ */
+
+#include "cwnet_peer.h"
+#include <string.h>
+
+#include "rt_log.h"
+#include "esp_timer.h"
+extern log_stream_t g_bg_log_stream;
+
+/*===========================================================================*/
+/* Internal Helpers                                                          */
+/*===========================================================================*/
+
+static int32_t peer_now(const cwnet_peer_t *peer) {
+    return peer->get_time_ms_cb(peer->user_data);
+}
+
+/** Send one short-payload frame */
+static cwnet_client_err_t send_short(cwnet_peer_t *peer, cwnet_cmd_t cmd,
+                                     const uint8_t *payload, uint8_t len) {
+    uint8_t frame[2 + CWNET_PING_PAYLOAD_SIZE];
+    if (len > CWNET_PING_PAYLOAD_SIZE) {
+        return CWNET_CLIENT_ERR_INVALID_ARG;
+    }
+
+    frame[0] = (uint8_t)((CWNET_FRAME_CAT_SHORT_PAYLOAD << 6) | (cmd & 0x3F));
+    frame[1] = len;
+    if (len > 0) {
+        memcpy(&frame[2], payload, len);
+    }
+
+    size_t total = 2U + len;
+    int sent = peer->send_cb(frame, total, peer->user_data);
+    if (sent < 0 || (size_t)sent != total) {
+        return CWNET_CLIENT_ERR_SEND_FAILED;
+    }
+    return CWNET_CLIENT_OK;
+}
+
+static cwnet_client_err_t send_ping(cwnet_peer_t *peer, const cwnet_ping_t *ping) {
+    uint8_t payload[CWNET_PING_PAYLOAD_SIZE];
+    if (!cwnet_ping_build(ping, payload, sizeof(payload))) {
+        return CWNET_CLIENT_ERR_PROTOCOL;
+    }
+    return send_short(peer, CWNET_CMD_PING, payload, CWNET_PING_PAYLOAD_SIZE);
+}
+
+/** Start a sync round: the peer adopts our t0 as its server time */
+static cwnet_client_err_t send_request(cwnet_peer_t *peer) {
+    int32_t now = peer_now(peer);
+    cwnet_ping_t req = {
+        .type = CWNET_PING_REQUEST,
+        .id = (uint8_t)(peer->ping_id + 1U),
+        .t0_ms = now,
+    };
+
+    peer->ping_id = req.id;
+    peer->last_ping_ms = now;
+    return send_ping(peer, &req);
+}
+
+/*===========================================================================*/
+/* Frame Handlers                                                            */
+/*===========================================================================*/
+
+static void handle_connect(cwnet_peer_t *peer, const uint8_t *payload, size_t len) {
+    if (peer->state != CWNET_PEER_WAIT_CONNECT) {
+        return;
+    }
+
+    /* Username field is null-padded; keep what fits */
+    size_t n = 0;
+    size_t max = (len < CWNET_CONNECT_USERNAME_LEN) ? len : CWNET_CONNECT_USERNAME_LEN;
+    while (n < max && n < sizeof(peer->name) - 1 && payload[n] != '\0') {
+        n++;
+    }
+    memcpy(peer->name, payload, n);
+    peer->name[n] = '\0';
+
+    if (send_short(peer, CWNET_CMD_WELCOME, NULL, 0) != CWNET_CLIENT_OK) {
+        return;
+    }
+    peer->state = CWNET_PEER_READY;
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "CWNet peer: \"%s\" connected", peer->name);
+
+    /* Sync the peer before its first key event */
+    (void)send_request(peer);
+}
+
+static void handle_ping(cwnet_peer_t *peer, const uint8_t *payload, size_t len) {
+    cwnet_ping_t ping;
+    if (peer->state != CWNET_PEER_READY || !cwnet_ping_parse(&ping, payload, len)) {
+        return;
+    }
+    if (ping.type != CWNET_PING_RESPONSE_1 || ping.id != peer->ping_id) {
+        return;  /* Only our own REQUEST is answered; the peer never sends one */
+    }
+
+    cwnet_ping_t rsp2 = ping;
+    rsp2.type = CWNET_PING_RESPONSE_2;
+    rsp2.t2_ms = peer_now(peer);
+    peer->latency_ms = cwnet_ping_calc_latency(&rsp2);
+    (void)send_ping(peer, &rsp2);
+}
+
+static void handle_cw_event(cwnet_peer_t *peer, bool key_down,
+                            const uint8_t *payload, size_t len) {
+    if (peer->state != CWNET_PEER_READY || peer->cw_event_cb == NULL || len < 4) {
+        return;
+    }
+
+    int32_t timestamp = (int32_t)((uint32_t)payload[0] |
+                                  ((uint32_t)payload[1] << 8) |
+                                  ((uint32_t)payload[2] << 16) |
+                                  ((uint32_t)payload[3] << 24));
+    peer->cw_event_cb(key_down, timestamp, peer->user_data);
+}
+
+static void process_frame(cwnet_peer_t *peer, const cwnet_parse_result_t *result) {
+    switch (result->command) {
+        case CWNET_CMD_CONNECT:
+            handle_connect(peer, result->payload, result->payload_len);
+            break;
+
+        case CWNET_CMD_PING:
+            handle_ping(peer, result->payload, result->payload_len);
+            break;
+
+        case CWNET_CMD_CW_DOWN:
+            handle_cw_event(peer, true, result->payload, result->payload_len);
+            break;
+
+        case CWNET_CMD_CW_UP:
+            handle_cw_event(peer, false, result->payload, result->payload_len);
+            break;
+
+        case CWNET_CMD_DISCONNECT:
+            cwnet_peer_on_closed(peer);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*===========================================================================*/
+/* Public API                                                                */
+/*===========================================================================*/
+
+cwnet_client_err_t cwnet_peer_init(cwnet_peer_t *peer, const cwnet_peer_config_t *config) {
+    if (peer == NULL || config == NULL ||
+        config->send_cb == NULL || config->get_time_ms_cb == NULL) {
+        return CWNET_CLIENT_ERR_INVALID_ARG;
+    }
+
+    memset(peer, 0, sizeof(*peer));
+    peer->send_cb = config->send_cb;
+    peer->get_time_ms_cb = config->get_time_ms_cb;
+    peer->cw_event_cb = config->cw_event_cb;
+    peer->user_data = config->user_data;
+    peer->state = CWNET_PEER_IDLE;
+    peer->latency_ms = -1;
+    cwnet_frame_parser_init(&peer->parser);
+    return CWNET_CLIENT_OK;
+}
+
+void cwnet_peer_on_accepted(cwnet_peer_t *peer) {
+    if (peer == NULL) {
+        return;
+    }
+    cwnet_frame_parser_reset(&peer->parser);
+    peer->name[0] = '\0';
+    peer->latency_ms = -1;
+    peer->state = CWNET_PEER_WAIT_CONNECT;
+}
+
+void cwnet_peer_on_closed(cwnet_peer_t *peer) {
+    if (peer == NULL) {
+        return;
+    }
+    cwnet_frame_parser_reset(&peer->parser);
+    peer->state = CWNET_PEER_IDLE;
+}
+
+void cwnet_peer_on_data(cwnet_peer_t *peer, const uint8_t *data, size_t len) {
+    if (peer == NULL || data == NULL) {
+        return;
+    }
+
+    size_t offset = 0;
+    while (offset < len && peer->state != CWNET_PEER_IDLE) {
+        cwnet_parse_result_t result = cwnet_frame_parse(&peer->parser,
+                                                         data + offset,
+                                                         len - offset);
+        switch (result.status) {
+            case CWNET_PARSE_OK:
+                process_frame(peer, &result);
+                cwnet_frame_parser_reset(&peer->parser);
+                offset += result.bytes_consumed;
+                break;
+
+            case CWNET_PARSE_NEED_MORE:
+                return;
+
+            case CWNET_PARSE_ERROR:
+                cwnet_frame_parser_reset(&peer->parser);
+                offset++;
+                break;
+        }
+    }
+}
+
+cwnet_client_err_t cwnet_peer_poll(cwnet_peer_t *peer) {
+    if (peer == NULL) {
+        return CWNET_CLIENT_ERR_INVALID_ARG;
+    }
+    if (peer->state != CWNET_PEER_READY ||
+        (peer_now(peer) - peer->last_ping_ms) < CWNET_PEER_PING_MS) {
+        return CWNET_CLIENT_OK;
+    }
+    return send_request(peer);
+}
+
+cwnet_client_err_t cwnet_peer_send_key_event_at(cwnet_peer_t *peer,
+                                                bool key_down,
+                                                int32_t local_time_ms) {
+    if (peer == NULL) {
+        return CWNET_CLIENT_ERR_INVALID_ARG;
+    }
+    if (peer->state != CWNET_PEER_READY) {
+        return CWNET_CLIENT_ERR_NOT_READY;
+    }
+
+    /* We are the time master: our clock is the session clock */
+    uint32_t ts = (uint32_t)local_time_ms;
+    uint8_t payload[4] = {
+        (uint8_t)(ts & 0xFF),
+        (uint8_t)((ts >> 8) & 0xFF),
+        (uint8_t)((ts >> 16) & 0xFF),
+        (uint8_t)((ts >> 24) & 0xFF),
+    };
+    return send_short(peer, key_down ? CWNET_CMD_CW_DOWN : CWNET_CMD_CW_UP,
+                      payload, sizeof(payload));
+}
+
+cwnet_peer_state_t cwnet_peer_get_state(const cwnet_peer_t *peer) {
+    return (peer != NULL) ? peer->state : CWNET_PEER_IDLE;
+}
+
+int32_t cwnet_peer_get_latency_ms(const cwnet_peer_t *peer) {
+    return (peer != NULL) ? peer->latency_ms : -1;
+}
@@ -10,11 +10,20 @@
 /* Timer Synchronization                                                     */
 /*===========================================================================*/
 
+/** Offset the timer applies at local_time_ms (drift extrapolated) */
+static int64_t timer_offset_at(const cwnet_timer_t *timer, int32_t local_time_ms) {
+    /* Millisecond clocks wrap: subtract modulo 2^32 */
+    int32_t elapsed = (int32_t)((uint32_t)local_time_ms - (uint32_t)timer->ref_local_ms);
+    return timer->offset_ms + ((int64_t)timer->drift_ppm * elapsed) / 1000000LL;
+}
+
 void cwnet_timer_init(cwnet_timer_t *timer) {
     if (timer == NULL) {
         return;
     }
     timer->offset_ms = 0;
+    timer->ref_local_ms = 0;
+    timer->drift_ppm = 0;
 }
 
 void cwnet_timer_sync_to_server(cwnet_timer_t *timer,
@@ -25,13 +34,15 @@ void cwnet_timer_sync_to_server(cwnet_timer_t *timer,
     }
 
     /* Calculate current synced time with existing offset */
-    int64_t current_synced = (int64_t)local_time_ms + timer->offset_ms;
+    int64_t current_synced = (int64_t)local_time_ms + timer_offset_at(timer, local_time_ms);
 
     /* Calculate delta from server time */
     int64_t delta = current_synced - (int64_t)server_time_ms;
 
-    /* Adjust offset to eliminate delta */
-    timer->offset_ms -= delta;
+    /* Adjust offset to eliminate delta (single point: no drift) */
+    timer->offset_ms = timer_offset_at(timer, local_time_ms) - delta;
+    timer->ref_local_ms = local_time_ms;
+    timer->drift_ppm = 0;
 }
 
 int32_t cwnet_timer_read_synced_ms(const cwnet_timer_t *timer,
@@ -40,13 +51,179 @@ int32_t cwnet_timer_read_synced_ms(const cwnet_timer_t *timer,
         return 0;
     }
 
-    int64_t synced = (int64_t)local_time_ms + timer->offset_ms;
+    int64_t synced = (int64_t)local_time_ms + timer_offset_at(timer, local_time_ms);
 
     /* Wrap to positive 31-bit range (protocol uses modulo 2^31) */
     /* This matches the official implementation */
     return (int32_t)(synced % 2147483647LL);
 }
 
+int64_t cwnet_timer_synced_us(const cwnet_timer_t *timer, int64_t local_time_us) {
+    if (timer == NULL) {
+        return local_time_us;
+    }
+    /* The timer runs on the 32-bit millisecond clock the client feeds it */
+    int32_t local_ms = (int32_t)(local_time_us / 1000);
+    return local_time_us + timer_offset_at(timer, local_ms) * 1000;
+}
+
+int32_t cwnet_timer_server_to_local_ms(const cwnet_timer_t *timer,
+                                        int32_t server_time_ms) {
+    if (timer == NULL) {
+        return server_time_ms;
+    }
+    /* Evaluating the drift at the offset-only estimate is exact to well
+     * under a millisecond for any realistic drift */
+    int32_t approx = (int32_t)((int64_t)server_time_ms - timer->offset_ms);
+    return (int32_t)((int64_t)server_time_ms - timer_offset_at(timer, approx));
+}
+
+/*===========================================================================*/
+/* Sync Filter                                                               */
+/*===========================================================================*/
+
+void cwnet_sync_init(cwnet_sync_t *sync) {
+    if (sync == NULL) {
+        return;
+    }
+    memset(sync, 0, sizeof(*sync));
+    sync->last_rtt_ms = -1;
+}
+
+/** Window slot of a sample by age: 0 = oldest */
+static uint32_t sync_index(const cwnet_sync_t *sync, uint32_t age) {
+    uint32_t first = (sync->next + CWNET_SYNC_WINDOW - sync->count) % CWNET_SYNC_WINDOW;
+    return (first + age) % CWNET_SYNC_WINDOW;
+}
+
+/** Minimum-RTT sample among ages [from, to), NULL if none has an RTT */
+static const cwnet_sync_sample_t *sync_best(const cwnet_sync_t *sync,
+                                            uint32_t from, uint32_t to) {
+    const cwnet_sync_sample_t *best = NULL;
+    for (uint32_t age = from; age < to; age++) {
+        const cwnet_sync_sample_t *smp = &sync->samples[sync_index(sync, age)];
+        if (smp->rtt_ms >= 0 && (best == NULL || smp->rtt_ms <= best->rtt_ms)) {
+            best = smp;  /* <= prefers the newer of equal RTTs */
+        }
+    }
+    return best;
+}
+
+void cwnet_sync_on_request(cwnet_sync_t *sync,
+                           cwnet_timer_t *timer,
+                           const cwnet_ping_t *request,
+                           int32_t local_time_ms) {
+    if (sync == NULL || timer == NULL || request == NULL) {
+        return;
+    }
+
+    int64_t raw = (int64_t)request->t0_ms - (int64_t)local_time_ms;
+
+    /* Server restarted or its clock stepped: old samples are meaningless */
+    if (sync->count > 0) {
+        int64_t step = raw - timer_offset_at(timer, local_time_ms);
+        if (step > CWNET_SYNC_STEP_MS || step < -CWNET_SYNC_STEP_MS) {
+            sync->count = 0;
+            sync->drift_ppm = 0;
+            sync->resets++;
+        }
+    }
+
+    cwnet_sync_sample_t *slot = &sync->samples[sync->next];
+    slot->offset_ms = raw;
+    slot->local_ms = local_time_ms;
+    slot->rtt_ms = -1;
+    slot->id = request->id;
+    sync->next = (sync->next + 1U) % CWNET_SYNC_WINDOW;
+    if (sync->count < CWNET_SYNC_WINDOW) {
+        sync->count++;
+    }
+
+    const cwnet_sync_sample_t *anchor = sync_best(sync, 0, sync->count);
+    if (anchor == NULL) {
+        /* No RTT yet: behave like the single-shot sync */
+        cwnet_timer_sync_to_server(timer, request->t0_ms, local_time_ms);
+        sync->last_residual_ms = 0;
+        return;
+    }
+
+    /* Drift from the best sample of each half of the window */
+    uint32_t half = sync->count / 2U;
+    const cwnet_sync_sample_t *older = sync_best(sync, 0, half);
+    const cwnet_sync_sample_t *newer = sync_best(sync, half, sync->count);
+    if (older != NULL && newer != NULL) {
+        int32_t span = newer->local_ms - older->local_ms;
+        if (span >= CWNET_SYNC_MIN_SPAN_MS) {
+            int64_t ppm = ((newer->offset_ms - older->offset_ms) * 1000000LL) / span;
+            if (ppm > CWNET_SYNC_MAX_DRIFT_PPM) {
+                ppm = CWNET_SYNC_MAX_DRIFT_PPM;
+            } else if (ppm < -CWNET_SYNC_MAX_DRIFT_PPM) {
+                ppm = -CWNET_SYNC_MAX_DRIFT_PPM;
+            }
+            sync->drift_ppm = (int32_t)ppm;
+        }
+    }
+
+    timer->offset_ms = anchor->offset_ms;
+    timer->ref_local_ms = anchor->local_ms;
+    timer->drift_ppm = sync->drift_ppm;
+    sync->last_residual_ms = raw - timer_offset_at(timer, local_time_ms);
+}
+
+void cwnet_sync_on_rtt(cwnet_sync_t *sync, uint8_t id, int32_t rtt_ms) {
+    if (sync == NULL || rtt_ms < 0) {
+        return;
+    }
+
+    /* RFC 3550 style: J += (|D| - J) / 16 */
+    if (sync->last_rtt_ms >= 0) {
+        int32_t d = rtt_ms - sync->last_rtt_ms;
+        if (d < 0) {
+            d = -d;
+        }
+        sync->rtt_jitter_q4 += d - (sync->rtt_jitter_q4 + 8) / 16;
+    }
+    sync->last_rtt_ms = rtt_ms;
+
+    /* Newest REQUEST with this ID (IDs wrap at 256) */
+    for (uint32_t age = sync->count; age > 0; age--) {
+        cwnet_sync_sample_t *smp = &sync->samples[sync_index(sync, age - 1U)];
+        if (smp->id == id) {
+            if (smp->rtt_ms < 0) {
+                smp->rtt_ms = rtt_ms;
+            }
+            return;
+        }
+    }
+}
+
+void cwnet_sync_get_stats(const cwnet_sync_t *sync,
+                          const cwnet_timer_t *timer,
+                          int32_t local_time_ms,
+                          cwnet_sync_stats_t *out) {
+    if (out == NULL) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    out->rtt_ms = -1;
+    out->rtt_min_ms = -1;
+    if (timer != NULL) {
+        out->offset_ms = timer_offset_at(timer, local_time_ms);
+        out->drift_ppm = timer->drift_ppm;
+    }
+    if (sync == NULL) {
+        return;
+    }
+
+    const cwnet_sync_sample_t *best = sync_best(sync, 0, sync->count);
+    out->rtt_ms = sync->last_rtt_ms;
+    out->rtt_min_ms = (best != NULL) ? best->rtt_ms : -1;
+    out->rtt_jitter_ms = sync->rtt_jitter_q4 / 16;
+    out->residual_ms = (int32_t)sync->last_residual_ms;
+    out->samples = sync->count;
+    out->resets = sync->resets;
+}
+
 /*===========================================================================*/
 /* PING Parsing                                                              */
 /*===========================================================================*/
@@ -123,6 +300,31 @@ bool cwnet_ping_build_response(const cwnet_ping_t *request,
     return true;
 }
 
+/** Store a 32-bit value little-endian */
+static void put_le32(uint8_t *dst, int32_t value) {
+    uint32_t v = (uint32_t)value;
+    dst[0] = (uint8_t)(v & 0xFF);
+    dst[1] = (uint8_t)((v >> 8) & 0xFF);
+    dst[2] = (uint8_t)((v >> 16) & 0xFF);
+    dst[3] = (uint8_t)((v >> 24) & 0xFF);
+}
+
+bool cwnet_ping_build(const cwnet_ping_t *ping,
+                      uint8_t *buffer,
+                      size_t buf_len) {
+    if (ping == NULL || buffer == NULL || buf_len < CWNET_PING_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    memset(buffer, 0, CWNET_PING_PAYLOAD_SIZE);
+    buffer[0] = (uint8_t)ping->type;
+    buffer[1] = ping->id;
+    put_le32(&buffer[4], ping->t0_ms);
+    put_le32(&buffer[8], ping->t1_ms);
+    put_le32(&buffer[12], ping->t2_ms);
+    return true;
+}
+
 /*===========================================================================*/
 /* Latency Calculation                                                       */
 /*===========================================================================*/
@@ -0,0 +1,114 @@
+/**
+ * @file cwnet_rx.c
+ * @brief Zero-copy CWNet receive ring implementation
+ */
+
+#include "cwnet_rx.h"
+#include <string.h>
+
+#define RX_MASK (CWNET_RX_RING_SIZE - 1U)
+
+_Static_assert((CWNET_RX_RING_SIZE & (CWNET_RX_RING_SIZE - 1)) == 0,
+               "CWNET_RX_RING_SIZE must be power of 2");
+
+/** Byte at offset from the read position */
+static inline uint8_t peek(const cwnet_rx_ring_t *ring, uint32_t offset) {
+    return ring->buf[(ring->tail + offset) & RX_MASK];
+}
+
+void cwnet_rx_init(cwnet_rx_ring_t *ring) {
+    if (ring == NULL) {
+        return;
+    }
+    ring->head = 0;
+    ring->tail = 0;
+    ring->discard = 0;
+    ring->skipped = 0;
+}
+
+size_t cwnet_rx_write_span(cwnet_rx_ring_t *ring, uint8_t **dst) {
+    uint32_t free_bytes = CWNET_RX_RING_SIZE - cwnet_rx_pending(ring);
+    uint32_t pos = ring->head & RX_MASK;
+    uint32_t to_end = CWNET_RX_RING_SIZE - pos;
+
+    *dst = &ring->buf[pos];
+    return (free_bytes < to_end) ? free_bytes : to_end;
+}
+
+void cwnet_rx_commit(cwnet_rx_ring_t *ring, size_t n) {
+    ring->head += (uint32_t)n;
+}
+
+cwnet_rx_status_t cwnet_rx_next_frame(cwnet_rx_ring_t *ring, cwnet_frame_view_t *out) {
+    uint32_t avail = cwnet_rx_pending(ring);
+
+    /* Still dropping the body of an oversize frame */
+    if (ring->discard > 0) {
+        uint32_t drop = (avail < ring->discard) ? avail : ring->discard;
+        ring->tail += drop;
+        ring->discard -= drop;
+        return (ring->discard > 0) ? CWNET_RX_NEED_MORE : CWNET_RX_SKIPPED;
+    }
+
+    if (avail == 0) {
+        return CWNET_RX_NEED_MORE;
+    }
+
+    uint8_t cmd = peek(ring, 0);
+    uint32_t header;
+    uint32_t len;
+
+    switch (cwnet_frame_get_category(cmd)) {
+        case CWNET_FRAME_CAT_NO_PAYLOAD:
+            header = 1;
+            len = 0;
+            break;
+
+        case CWNET_FRAME_CAT_SHORT_PAYLOAD:
+            if (avail < 2) {
+                return CWNET_RX_NEED_MORE;
+            }
+            header = 2;
+            len = peek(ring, 1);
+            break;
+
+        case CWNET_FRAME_CAT_LONG_PAYLOAD:
+            if (avail < 3) {
+                return CWNET_RX_NEED_MORE;
+            }
+            header = 3;
+            len = (uint32_t)peek(ring, 1) | ((uint32_t)peek(ring, 2) << 8);
+            break;
+
+        default:
+            /* Reserved: skip one byte to resync, as the stream parser does */
+            ring->tail++;
+            ring->skipped++;
+            return CWNET_RX_SKIPPED;
+    }
+
+    if (header + len > CWNET_RX_RING_SIZE) {
+        /* Can never be whole in the ring: drop it as it streams in */
+        ring->tail += header;
+        ring->discard = len;
+        ring->skipped++;
+        return cwnet_rx_next_frame(ring, out);
+    }
+
+    if (avail < header + len) {
+        return CWNET_RX_NEED_MORE;
+    }
+
+    uint32_t start = (ring->tail + header) & RX_MASK;
+    uint32_t to_end = CWNET_RX_RING_SIZE - start;
+
+    out->command = cwnet_frame_get_command(cmd);
+    out->payload_len = (uint16_t)len;
+    out->a = (len > 0) ? &ring->buf[start] : NULL;
+    out->na = (len < to_end) ? len : to_end;
+    out->b = (len > to_end) ? ring->buf : NULL;
+    out->nb = len - out->na;
+
+    ring->tail += header + len;
+    return CWNET_RX_FRAME;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file cwnet_select.c
+ * @brief Failover server selection: probe order, scoring, stale links
+ */
+
+#include "cwnet_select.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool is_separator(char c) {
+    return c == ',' || c == ';' || c == ' ' || c == '\t';
+}
+
+size_t cwnet_select_parse_list(const char *list, uint16_t default_port,
+                               cwnet_select_host_t *out, size_t max) {
+    size_t n = 0;
+    const char *p = list;
+
+    while (p != NULL && *p != '\0' && n < max) {
+        while (is_separator(*p)) {
+            p++;
+        }
+        const char *start = p;
+        while (*p != '\0' && !is_separator(*p)) {
+            p++;
+        }
+        size_t len = (size_t)(p - start);
+        if (len == 0) {
+            continue;
+        }
+
+        /* "host:port": the port follows the colon */
+        uint16_t port = default_port;
+        const char *colon = memchr(start, ':', len);
+        size_t host_len = len;
+        if (colon != NULL) {
+            host_len = (size_t)(colon - start);
+            char digits[8] = {0};
+            size_t dlen = len - host_len - 1;
+            if (dlen > 0 && dlen < sizeof(digits)) {
+                memcpy(digits, colon + 1, dlen);
+                char *end = NULL;
+                unsigned long v = strtoul(digits, &end, 10);
+                if (end != NULL && *end == '\0' && v > 0 && v <= 65535UL) {
+                    port = (uint16_t)v;
+                }
+            }
+        }
+        if (host_len == 0) {
+            continue;
+        }
+        if (host_len >= CWNET_MAX_HOST_LEN) {
+            host_len = CWNET_MAX_HOST_LEN - 1;
+        }
+        memcpy(out[n].host, start, host_len);
+        out[n].host[host_len] = '\0';
+        out[n].port = port;
+        n++;
+    }
+    return n;
+}
+
+void cwnet_select_init(cwnet_select_t *sel, size_t count) {
+    memset(sel, 0, sizeof(*sel));
+    sel->count = (uint8_t)((count < CWNET_SELECT_MAX) ? count : CWNET_SELECT_MAX);
+    sel->cursor = 0;
+    for (size_t i = 0; i < CWNET_SELECT_MAX; i++) {
+        sel->cand[i].score_ms = -1;
+    }
+}
+
+int32_t cwnet_select_score(const cwnet_sync_stats_t *stats) {
+    if (stats->samples < CWNET_SELECT_PROBE_SAMPLES || stats->rtt_min_ms < 0) {
+        return -1;
+    }
+    int32_t jitter = (stats->rtt_jitter_ms > 0) ? stats->rtt_jitter_ms : 0;
+    return stats->rtt_min_ms + CWNET_SELECT_JITTER_WEIGHT * jitter;
+}
+
+void cwnet_select_report(cwnet_select_t *sel, size_t idx, int32_t score_ms) {
+    if (idx >= sel->count || score_ms < 0) {
+        return;
+    }
+    sel->cand[idx].score_ms = score_ms;
+    sel->cand[idx].failures = 0;
+    sel->cand[idx].probed = true;
+}
+
+void cwnet_select_fail(cwnet_select_t *sel, size_t idx) {
+    if (idx >= sel->count) {
+        return;
+    }
+    sel->cand[idx].score_ms = -1;
+    if (sel->cand[idx].failures < UINT32_MAX) {
+        sel->cand[idx].failures++;
+    }
+    sel->cand[idx].probed = true;
+}
+
+void cwnet_select_new_round(cwnet_select_t *sel) {
+    for (size_t i = 0; i < sel->count; i++) {
+        sel->cand[i].probed = false;
+    }
+}
+
+uint8_t cwnet_select_next(cwnet_select_t *sel, uint8_t active) {
+    if (sel->count < 2) {
+        return CWNET_SELECT_NONE;
+    }
+
+    /* Unprobed first, round-robin from the last one handed out */
+    for (uint8_t step = 1; step <= sel->count; step++) {
+        uint8_t i = (uint8_t)((sel->cursor + step) % sel->count);
+        if (i != active && !sel->cand[i].probed) {
+            sel->cursor = i;
+            return i;
+        }
+    }
+
+    /* All probed: park on the best reachable one */
+    uint8_t best = CWNET_SELECT_NONE;
+    for (uint8_t i = 0; i < sel->count; i++) {
+        if (i == active || sel->cand[i].score_ms < 0) {
+            continue;
+        }
+        if (best == CWNET_SELECT_NONE || sel->cand[i].score_ms < sel->cand[best].score_ms) {
+            best = i;
+        }
+    }
+    if (best != CWNET_SELECT_NONE) {
+        return best;
+    }
+
+    /* Nothing reachable: keep walking the list */
+    for (uint8_t step = 1; step <= sel->count; step++) {
+        uint8_t i = (uint8_t)((sel->cursor + step) % sel->count);
+        if (i != active) {
+            sel->cursor = i;
+            return i;
+        }
+    }
+    return CWNET_SELECT_NONE;
+}
+
+bool cwnet_select_better(int32_t active_ms, int32_t standby_ms) {
+    if (active_ms < 0 || standby_ms < 0) {
+        return false;
+    }
+    return standby_ms + CWNET_SELECT_HYSTERESIS_MS < active_ms;
+}
+
+/** b - a on the wrapping millisecond clock */
+static int32_t elapsed_ms(int32_t a, int32_t b) {
+    return (int32_t)((uint32_t)b - (uint32_t)a);
+}
+
+int32_t cwnet_select_ping_interval_ms(const cwnet_sync_t *sync) {
+    if (sync->count < 2) {
+        return 0;
+    }
+
+    /* Oldest to newest: the slots before sync->next */
+    int32_t longest = 0;
+    uint32_t first = (sync->next + CWNET_SYNC_WINDOW - sync->count) % CWNET_SYNC_WINDOW;
+    for (uint32_t i = 1; i < sync->count; i++) {
+        const cwnet_sync_sample_t *prev = &sync->samples[(first + i - 1) % CWNET_SYNC_WINDOW];
+        const cwnet_sync_sample_t *cur = &sync->samples[(first + i) % CWNET_SYNC_WINDOW];
+        int32_t gap = elapsed_ms(prev->local_ms, cur->local_ms);
+        if (gap > longest) {
+            longest = gap;
+        }
+    }
+    return longest;
+}
+
+bool cwnet_select_stale(const cwnet_sync_t *sync, int32_t now_ms) {
+    int32_t interval = cwnet_select_ping_interval_ms(sync);
+    if (interval <= 0) {
+        return false;
+    }
+    const cwnet_sync_sample_t *last =
+        &sync->samples[(sync->next + CWNET_SYNC_WINDOW - 1) % CWNET_SYNC_WINDOW];
+    return elapsed_ms(last->local_ms, now_ms) > interval + interval / 2;
+}
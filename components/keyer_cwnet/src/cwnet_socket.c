@@ -1,21 +1,98 @@
 /**
  * @file cwnet_socket.c
  * @brief CWNet TCP socket integration for ESP-IDF
+ *
+ * Owns a timed consumer on g_keying_stream: every LOCAL key edge is
+ * forwarded with its stream timestamp, whether or not anyone has the
+ * web UI open.
+ *
+ * Up to CWNET_MAX_SESSIONS servers can be connected at once (remote.server_*
+ * and remote.server2_*). Each session has its own socket, client state
+ * machine, clock sync, backoff and statistics. A key edge is read once
+ * from the stream and its time computed once, then handed to every READY
+ * session in priority order; each session stamps it on its own server's
+ * clock. Received keying and rig audio are played only from the highest
+ * priority READY session, so two nets never key the sidetone at once.
+ *
+ * With remote.server_list set, slot 0 is a failover group instead
+ * (cwnet_select.h): remote.server_host and the listed servers are
+ * candidates for one net, served by two sessions. The active one is keyed
+ * and heard like any other; the standby stays connected and synced on
+ * another candidate, probing them in turn and parking on the best. It
+ * takes over at once when the active link drops or misses a PING, or
+ * when it scores clearly lower.
+ *
+ * Received CW events go through an adaptive jitter buffer and are
+ * published on the REMOTE lane of the same stream when they are due, so
+ * the sidetone and decoder pick them up like any other producer.
+ *
+ * Outgoing frames are coalesced: everything produced in one service pass
+ * (and up to remote.coalesce_us after the first queued key event) goes
+ * out in a single send() per session. Replies to the server are flushed
+ * right after the receive path so PING timing is not stretched.
+ *
+ * With a session's UDP port set, key edges travel as redundant UDP
+ * datagrams (cwnet_udp.h) once the TCP session is READY; TCP keeps the
+ * control traffic, and edges fall back to it while UDP is not open.
+ *
+ * With remote.peer_port set, the task also listens for one keyer on the
+ * LAN and runs the server side of the protocol for it (cwnet_peer.h),
+ * advertised over mDNS as _cwnet._tcp. The server connection is then
+ * optional: a peer-only setup leaves remote.server_host empty.
+ *
+ * Rig audio blocks from the server (cwnet_audio.h) are decoded here, on
+ * Core 1, into g_rig_audio; rt_task plays them with a fixed delay
+ * (audio_playout.h). Blocks are dropped unless audio.rig_volume is set.
+ *
+ * With remote.cwnet_capture set, every TCP chunk and UDP datagram the
+ * sessions send or receive is also copied into a PSRAM capture ring
+ * (cwnet_capture.h), downloadable as .pcap from /api/cwnet/capture.
+ *
+ * Runs in its own task (cwnet_task) that blocks in select() on the sockets.
+ * The RT task never signals it (the stream is the only interface), so the
+ * select() timeout doubles as the stream poll period: an edge waits at
+ * most CWNET_POLL_MS before it is sent.
  */
 
 #include "cwnet_socket.h"
+#include "cwnet_latency.h"
+#include "cwnet_jitter.h"
+#include "cwnet_rx.h"
+#include "cwnet_udp.h"
+#include "cwnet_peer.h"
+#include "cwnet_audio.h"
+#include "cwnet_capture.h"
+#include "cwnet_select.h"
+#include "audio_buffer.h"
 #include "config.h"
 #include "rt_log.h"
+#include "consumer.h"
+#include "stream_handoff.h"
+#include "metrics.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <sys/socket.h>
-#include <netdb.h>
+#include <netinet/tcp.h>
+#include <netinet/in.h>
 #include <fcntl.h>
 #include <unistd.h>
 
+#include "lwip/dns.h"
+#include "lwip/ip_addr.h"
+#include "lwip/tcpip.h"
+
+#include "cwnet_backoff.h"
+#include "esp_mac.h"
+#include "esp_random.h"
+#include "mdns.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "nvs.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 /* External log stream */
 extern log_stream_t g_bg_log_stream;
@@ -23,40 +100,158 @@ extern log_stream_t g_bg_log_stream;
 /* Configuration */
 extern keyer_config_t g_config;
 
+/* Keying stream (local edges forwarded, remote events published) */
+extern keying_stream_t g_keying_stream;
+
+/* Decoded rig audio (this task produces, rt_task consumes) */
+extern audio_ring_buffer_t g_rig_audio;
+
 /*===========================================================================*/
 /* Constants                                                                 */
 /*===========================================================================*/
 
-#define RECONNECT_DELAY_MS      5000    /* Wait between reconnect attempts */
 #define CONNECT_TIMEOUT_MS      10000   /* TCP connect timeout */
-#define RECV_TIMEOUT_MS         100     /* Non-blocking receive timeout */
+#define DNS_TIMEOUT_MS          10000   /* Give up on a lookup lwIP never answers */
+#define CWNET_POLL_MS           1       /* select() timeout while a socket is open */
+#define CWNET_IDLE_MS           10      /* Loop period with no socket (reconnect wait) */
+#define CWNET_TX_MAX_EDGES      32      /* Queued edges awaiting their send() */
+#define CWNET_RX_LOOKAHEAD_MS   4       /* Publish received events this early */
+#define CWNET_CAPTURE_SLOTS     1024    /* Capture ring (256 KB PSRAM, power of 2) */
+#define CWNET_MDNS_SERVICE      "_cwnet"
+#define CWNET_MDNS_PROTO        "_tcp"
+
+#define NVS_NAMESPACE           "cwnet"
+#define NVS_KEY_HOST            "host"  /* Host name the cached address belongs to */
+#define NVS_KEY_ADDR            "addr"  /* Last good IPv4 address (network order) */
+#define NVS_KEY_ALT             "f"     /* Infix for failover candidates 1.. */
 
 /*===========================================================================*/
 /* State                                                                     */
 /*===========================================================================*/
 
-static struct {
+/**
+ * DNS result handoff from the lwIP tcpip thread. The address is written
+ * before the status (release); cwnet_task reads the status (acquire).
+ */
+typedef enum {
+    DNS_IDLE = 0,
+    DNS_PENDING,
+    DNS_DONE,
+    DNS_FAILED
+} dns_status_t;
+
+typedef struct {
+    atomic_int status;      /* dns_status_t */
+    uint32_t addr;          /* Valid when status == DNS_DONE */
+} dns_handoff_t;
+
+/** One server connection */
+typedef struct {
+    const char *tag;            /* Log prefix */
+    uint8_t slot;               /* Config slot (0 = remote.server_*) */
+    uint8_t priority;           /* Higher sends first and owns the playout */
     cwnet_socket_state_t state;
     cwnet_client_t client;
     int sock;
     int64_t last_attempt_us;
     int64_t connect_start_us;
+    int64_t resolve_start_us;
+    uint32_t retry_delay_ms;    /* Backoff chosen at the last failure */
+    uint32_t failures;          /* Consecutive failures, reset on READY */
+    uint32_t server_addr;       /* Resolved IPv4 (network order), 0 = unknown */
+    bool need_resolve;          /* Refresh server_addr before the next connect */
     char host[CWNET_MAX_HOST_LEN];
     uint16_t port;
-    char username[CWNET_MAX_USERNAME_LEN];
+    char nvs_host[8];           /* Address cache keys for this slot */
+    char nvs_addr[8];
+    dns_handoff_t dns;
+    cwnet_latency_t latency;    /* Edge stream time -> send() */
+    cwnet_rx_ring_t rx;         /* recv() target, frames parsed in place */
+    int64_t tx_first_us;        /* When the oldest queued edge was queued */
+    int64_t tx_edge_us[CWNET_TX_MAX_EDGES]; /* Stream times of queued edges */
+    uint32_t tx_edges;          /* Entries in tx_edge_us */
+    uint16_t udp_port;          /* Server UDP port for edges, 0 = TCP only */
+    int udp_sock;               /* Connected UDP socket, -1 when closed */
+    cwnet_udp_tx_t udp_tx;      /* Outgoing edge sequence + redundancy */
+    cwnet_udp_rx_t udp_rx;      /* Incoming reorder window */
+    cwnet_audio_dec_t audio;    /* Rig audio block decoder */
+    uint32_t rx_ignored;        /* Events dropped: another session owns the playout */
+    cwnet_capture_endpoint_t cap_tcp; /* TCP endpoints, for the capture */
+    cwnet_capture_endpoint_t cap_udp; /* UDP endpoints, for the capture */
+    bool grouped;               /* Serves the failover group */
+    bool standby;               /* Group spare: connected and synced, never keyed or heard */
+    bool scored;                /* Its candidate was scored since it connected */
+    uint8_t cand;               /* Group candidate it holds (s_ctx.hosts) */
+    int64_t ready_us;           /* When it last became READY */
+} cwnet_session_t;
+
+static struct {
     bool enabled;
+    char username[CWNET_MAX_USERNAME_LEN];
+    cwnet_session_t sessions[CWNET_MAX_SESSIONS]; /* Highest priority first */
+    size_t session_count;       /* Configured sessions */
+    cwnet_session_t *rx_owner;  /* Session whose events are in the jitter buffer */
+    timed_consumer_t edges;     /* Own stream position, independent of web UI */
+    stream_handoff_t remote;    /* REMOTE lane: received events, written by rt_task */
+    cwnet_jitter_t rx_jitter;   /* Playout scheduling for received events */
+    int32_t playout_ms;         /* Least jitter margin (remote.playout_ms) */
+    bool remote_key;            /* Level last published on the REMOTE lane */
+    uint32_t coalesce_us;       /* Max hold time for queued key events */
+    uint16_t peer_port;         /* LAN listen port, 0 = no peer mode */
+    int listen_sock;            /* Listening socket, -1 when closed */
+    int peer_sock;              /* Accepted peer, -1 when none */
+    int64_t peer_accept_us;     /* When peer_sock was accepted */
+    cwnet_peer_t peer;          /* Server-role session for the peer */
+    uint32_t audio_overflow;    /* Blocks cut short: g_rig_audio full */
+    const cwnet_session_t *net_owner; /* Session whose clock is on the stream, NULL = none */
+    cwnet_timer_t net_timer;    /* Estimate last published (stream_set_net_clock) */
+    cwnet_select_host_t hosts[CWNET_SELECT_MAX]; /* Failover candidates, server_host first */
+    cwnet_select_t select;      /* What the group knows about them */
+    cwnet_session_t *group[2];  /* The group's two sessions, NULL without a list */
+    int64_t round_us;           /* Start of the current probe round */
+    atomic_uint failovers;      /* Standby promotions */
 } s_ctx;
 
+#define FOR_EACH_SESSION(s) \
+    for (cwnet_session_t *s = s_ctx.sessions; s < s_ctx.sessions + s_ctx.session_count; s++)
+
+/**
+ * @brief Session that owns the receive path
+ *
+ * The highest priority READY session; with none READY, the highest
+ * priority one (so status reads show what it is doing). A standby is
+ * never it.
+ */
+static cwnet_session_t *main_session(void) {
+    cwnet_session_t *first = NULL;
+    FOR_EACH_SESSION(s) {
+        if (s->standby) {
+            continue;
+        }
+        if (s->state == CWNET_SOCK_READY) {
+            return s;
+        }
+        if (first == NULL) {
+            first = s;
+        }
+    }
+    return first;
+}
+
 /*===========================================================================*/
 /* Callbacks for cwnet_client                                                */
 /*===========================================================================*/
 
 static int socket_send_cb(const uint8_t *data, size_t len, void *user_data) {
-    (void)user_data;
-    if (s_ctx.sock < 0) {
+    cwnet_session_t *s = user_data;
+    if (s->sock < 0) {
         return -1;
     }
-    ssize_t sent = send(s_ctx.sock, data, len, 0);
+    ssize_t sent = send(s->sock, data, len, 0);
+    if (sent > 0) {
+        cwnet_capture_frame(&g_cwnet_capture, CWNET_CAPTURE_TX, CWNET_CAPTURE_TCP,
+                            &s->cap_tcp, data, (size_t)sent, esp_timer_get_time());
+    }
     return (int)sent;
 }
 
@@ -65,31 +260,211 @@ static int32_t get_time_ms_cb(void *user_data) {
     return (int32_t)(esp_timer_get_time() / 1000);
 }
 
+/** Queue a received event for playout (event_ms on the local clock) */
+static void schedule_remote(bool key_down, int32_t event_ms, int32_t rtt_ms) {
+    int32_t arrival_ms = (int32_t)(esp_timer_get_time() / 1000);
+
+    cwnet_jitter_seed_rtt(&s_ctx.rx_jitter, rtt_ms);
+    if (!cwnet_jitter_push(&s_ctx.rx_jitter, key_down, event_ms, arrival_ms)) {
+        RT_WARN(&g_bg_log_stream, esp_timer_get_time(), "CWNet: RX jitter buffer full");
+    }
+}
+
+static void release_remote(void);
+
+/** Received CW_DOWN/CW_UP: schedule it on the local clock */
+static void cw_event_cb(bool key_down, int32_t timestamp_ms, void *user_data) {
+    cwnet_session_t *s = user_data;
+    if (s != main_session()) {
+        s->rx_ignored++;
+        return;
+    }
+    if (s_ctx.rx_owner != s) {
+        /* Playout moves to this session: drop what the last one queued */
+        if (s_ctx.rx_owner != NULL) {
+            release_remote();
+        }
+        s_ctx.rx_owner = s;
+    }
+    schedule_remote(key_down,
+                    cwnet_timer_server_to_local_ms(&s->client.timer, timestamp_ms),
+                    cwnet_client_get_latency_ms(&s->client));
+}
+
+/** Rig audio block: decode straight into the playout ring */
+static void audio_cb(const uint8_t *payload, size_t len, void *user_data) {
+    cwnet_session_t *s = user_data;
+    if (CONFIG_GET_RIG_VOLUME() == 0 || s != main_session()) {
+        return;
+    }
+    int16_t pcm[CWNET_AUDIO_BLOCK_SAMPLES];
+    size_t n = cwnet_audio_decode(&s->audio, payload, len, pcm, CWNET_AUDIO_BLOCK_SAMPLES);
+    if (audio_buffer_write(&g_rig_audio, pcm, n) < n) {
+        s_ctx.audio_overflow++;
+    }
+}
+
+/*===========================================================================*/
+/* Callbacks for cwnet_peer                                                  */
+/*===========================================================================*/
+
+static int peer_send_cb(const uint8_t *data, size_t len, void *user_data) {
+    (void)user_data;
+    if (s_ctx.peer_sock < 0) {
+        return -1;
+    }
+    return (int)send(s_ctx.peer_sock, data, len, MSG_DONTWAIT);
+}
+
+/** The peer syncs to our PING t0: its timestamps are already local */
+static void peer_event_cb(bool key_down, int32_t timestamp_ms, void *user_data) {
+    (void)user_data;
+    schedule_remote(key_down, timestamp_ms, cwnet_peer_get_latency_ms(&s_ctx.peer));
+}
+
+static void open_udp(cwnet_session_t *s);
+
 static void state_change_cb(cwnet_client_state_t old_state,
                             cwnet_client_state_t new_state,
                             void *user_data) {
-    (void)user_data;
+    cwnet_session_t *s = user_data;
     int64_t now_us = esp_timer_get_time();
 
     if (new_state == CWNET_STATE_READY) {
-        RT_INFO(&g_bg_log_stream, now_us, "CWNet: READY (connected to %s:%u)",
-                s_ctx.host, s_ctx.port);
-        s_ctx.state = CWNET_SOCK_READY;
+        RT_INFO(&g_bg_log_stream, now_us, "%s: READY (connected to %s:%u)",
+                s->tag, s->host, s->port);
+        s->state = CWNET_SOCK_READY;
+        s->failures = 0;
+        s->ready_us = now_us;
+        cwnet_audio_dec_init(&s->audio);
+        open_udp(s);
     } else if (new_state == CWNET_STATE_DISCONNECTED && old_state != CWNET_STATE_DISCONNECTED) {
-        RT_WARN(&g_bg_log_stream, now_us, "CWNet: disconnected");
+        RT_WARN(&g_bg_log_stream, now_us, "%s: disconnected", s->tag);
     }
 }
 
+/*===========================================================================*/
+/* Remote Playout                                                            */
+/*===========================================================================*/
+
+/** Empty the jitter buffer, keeping the configured playout floor */
+static void reset_rx_jitter(void) {
+    cwnet_jitter_init(&s_ctx.rx_jitter);
+    cwnet_jitter_set_floor(&s_ctx.rx_jitter, s_ctx.playout_ms);
+}
+
+/**
+ * Hand a remote key level to the RT task for the REMOTE lane, stamped with
+ * its play tick (stream_handoff.h: this task never claims hot ring slots)
+ */
+static void publish_remote(bool key_down, int64_t play_us) {
+    if (key_down == s_ctx.remote_key) {
+        return;
+    }
+    int64_t since_epoch = play_us - stream_epoch_us(&g_keying_stream);
+    uint32_t period = stream_tick_period_us(&g_keying_stream);
+    uint64_t tick = (since_epoch > 0 && period > 0)
+                        ? (uint64_t)(since_epoch / (int64_t)period) : 0U;
+
+    if (stream_handoff_put(&s_ctx.remote, sample_remote_event(key_down, tick))) {
+        s_ctx.remote_key = key_down;
+    }
+}
+
+/**
+ * Publish every received event due within the lookahead. Events carry
+ * their play tick and the RT task keys them on it (remote_tx.h), so handing
+ * them over early takes this task's polling jitter out of the timing.
+ */
+static void play_remote_events(void) {
+    int64_t now_us = esp_timer_get_time();
+    cwnet_jitter_event_t ev;
+
+    while (cwnet_jitter_pop(&s_ctx.rx_jitter,
+                            (int32_t)(now_us / 1000) + CWNET_RX_LOOKAHEAD_MS, &ev)) {
+        publish_remote(ev.key_down, (int64_t)ev.play_ms * 1000LL);
+    }
+}
+
+/** Drop pending remote events and never leave the remote key stuck down */
+static void release_remote(void) {
+    reset_rx_jitter();
+    publish_remote(false, esp_timer_get_time());
+}
+
 /*===========================================================================*/
 /* Socket Helpers                                                            */
 /*===========================================================================*/
 
-static void close_socket(void) {
-    if (s_ctx.sock >= 0) {
-        close(s_ctx.sock);
-        s_ctx.sock = -1;
+static void close_socket(cwnet_session_t *s) {
+    if (s->sock >= 0) {
+        close(s->sock);
+        s->sock = -1;
+    }
+    if (s->udp_sock >= 0) {
+        close(s->udp_sock);
+        s->udp_sock = -1;
+    }
+    cwnet_client_on_disconnected(&s->client);
+    cwnet_rx_init(&s->rx);
+    s->tx_edges = 0;
+    if (s_ctx.rx_owner == s) {
+        s_ctx.rx_owner = NULL;
+        release_remote();
+    }
+}
+
+/**
+ * @brief Enter ERROR and pick the next jittered backoff delay
+ */
+static void schedule_retry(cwnet_session_t *s, int64_t now_us) {
+    /* A failed connect may mean the server moved: look it up again next time */
+    if (s->state == CWNET_SOCK_CONNECTING) {
+        s->need_resolve = true;
+    }
+    if (s->grouped) {
+        cwnet_select_fail(&s_ctx.select, s->cand);
+    }
+    s->state = CWNET_SOCK_ERROR;
+    s->last_attempt_us = now_us;
+    s->retry_delay_ms = cwnet_backoff_delay_ms(s->failures, esp_random());
+    if (s->failures < UINT32_MAX) {
+        s->failures++;
     }
-    cwnet_client_on_disconnected(&s_ctx.client);
+}
+
+/**
+ * @brief Send the client's TX arena in one send()
+ *
+ * @param s Session
+ * @param now_us Current time
+ * @param force Ignore the coalescing delay
+ */
+static void flush_tx(cwnet_session_t *s, int64_t now_us, bool force) {
+    if (cwnet_client_tx_pending(&s->client) == 0) {
+        return;
+    }
+    if (!force && s->tx_edges > 0 &&
+        (now_us - s->tx_first_us) < (int64_t)s_ctx.coalesce_us) {
+        return;
+    }
+
+    if (cwnet_client_flush(&s->client) != CWNET_CLIENT_OK) {
+        RT_WARN(&g_bg_log_stream, now_us, "%s: send failed: %d", s->tag, errno);
+        s->tx_edges = 0;
+        close_socket(s);
+        schedule_retry(s, now_us);
+        return;
+    }
+    if (cwnet_client_tx_pending(&s->client) > 0) {
+        return;  /* Socket buffer full: the rest goes on the next pass */
+    }
+
+    /* Edge latency runs to the send() that carried the edge */
+    for (uint32_t i = 0; i < s->tx_edges; i++) {
+        cwnet_latency_record(&s->latency, now_us - s->tx_edge_us[i]);
+    }
+    s->tx_edges = 0;
 }
 
 static bool set_nonblocking(int sock) {
@@ -100,150 +475,970 @@ static bool set_nonblocking(int sock) {
     return fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
 }
 
-static bool start_connect(void) {
+/** Endpoints of a connected socket, as the capture records them */
+static void capture_endpoint(int sock, cwnet_capture_endpoint_t *ep) {
+    struct sockaddr_in local = {0};
+    struct sockaddr_in remote = {0};
+    socklen_t len = sizeof(local);
+    getsockname(sock, (struct sockaddr *)&local, &len);
+    len = sizeof(remote);
+    getpeername(sock, (struct sockaddr *)&remote, &len);
+    ep->local_ip = ntohl(local.sin_addr.s_addr);
+    ep->remote_ip = ntohl(remote.sin_addr.s_addr);
+    ep->local_port = ntohs(local.sin_port);
+    ep->remote_port = ntohs(remote.sin_port);
+}
+
+/**
+ * @brief Open the UDP edge path to the server (session just became READY)
+ *
+ * Best-effort: on failure edges keep going over TCP.
+ */
+static void open_udp(cwnet_session_t *s) {
+    if (s->udp_port == 0 || s->udp_sock >= 0) {
+        return;
+    }
     int64_t now_us = esp_timer_get_time();
 
-    /* DNS resolution */
-    struct addrinfo hints = {
-        .ai_family = AF_INET,
-        .ai_socktype = SOCK_STREAM,
-        .ai_protocol = IPPROTO_TCP
+    struct sockaddr_in dest = {
+        .sin_family = AF_INET,
+        .sin_port = htons(s->udp_port),
+        .sin_addr.s_addr = s->server_addr
     };
-    struct addrinfo *res = NULL;
 
-    char port_str[8];
-    snprintf(port_str, sizeof(port_str), "%u", s_ctx.port);
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0 || !set_nonblocking(sock) ||
+        connect(sock, (struct sockaddr *)&dest, sizeof(dest)) < 0) {
+        RT_WARN(&g_bg_log_stream, now_us, "%s: UDP open failed: %d", s->tag, errno);
+        if (sock >= 0) {
+            close(sock);
+        }
+        return;
+    }
+
+    /* New session: both ends restart their sequence */
+    capture_endpoint(sock, &s->cap_udp);
+    cwnet_udp_tx_init(&s->udp_tx);
+    cwnet_udp_rx_init(&s->udp_rx);
+    s->udp_sock = sock;
+    RT_INFO(&g_bg_log_stream, now_us, "%s: UDP edges to port %u", s->tag, s->udp_port);
+}
 
-    RT_INFO(&g_bg_log_stream, now_us, "CWNet: resolving %s:%s", s_ctx.host, port_str);
-    s_ctx.state = CWNET_SOCK_RESOLVING;
+/** Send one edge as a redundant datagram */
+static bool send_udp_edge(cwnet_session_t *s, bool key_down, int64_t event_us) {
+    int32_t ts = cwnet_timer_read_synced_ms(&s->client.timer, (int32_t)(event_us / 1000));
+    uint8_t dgram[CWNET_UDP_MAX_DATAGRAM];
+    size_t len = cwnet_udp_tx_build(&s->udp_tx, key_down, ts, dgram, sizeof(dgram));
 
-    int err = getaddrinfo(s_ctx.host, port_str, &hints, &res);
-    if (err != 0 || res == NULL) {
-        RT_WARN(&g_bg_log_stream, now_us, "CWNet: DNS failed for %s", s_ctx.host);
-        s_ctx.state = CWNET_SOCK_ERROR;
-        s_ctx.last_attempt_us = now_us;
+    /* A dropped datagram is repaired by the next one's repeats */
+    if (send(s->udp_sock, dgram, len, MSG_DONTWAIT) != (ssize_t)len) {
         return false;
     }
+    cwnet_capture_frame(&g_cwnet_capture, CWNET_CAPTURE_TX, CWNET_CAPTURE_UDP,
+                        &s->cap_udp, dgram, len, esp_timer_get_time());
+    return true;
+}
+
+/** Drain received datagrams into the playout path */
+static void process_udp_recv(cwnet_session_t *s) {
+    if (s->udp_sock < 0) {
+        return;
+    }
+
+    uint8_t dgram[64];
+    ssize_t n;
+    int32_t now_ms = (int32_t)(esp_timer_get_time() / 1000);
+    while ((n = recv(s->udp_sock, dgram, sizeof(dgram), MSG_DONTWAIT)) > 0) {
+        cwnet_capture_frame(&g_cwnet_capture, CWNET_CAPTURE_RX, CWNET_CAPTURE_UDP,
+                            &s->cap_udp, dgram, (size_t)n, esp_timer_get_time());
+        cwnet_udp_rx_push(&s->udp_rx, dgram, (size_t)n, now_ms);
+    }
+
+    cwnet_udp_edge_t e;
+    while (cwnet_udp_rx_pop(&s->udp_rx, now_ms, &e)) {
+        cw_event_cb(e.key_down, e.timestamp_ms, s);
+    }
+}
+
+/*===========================================================================*/
+/* Peer Listener                                                             */
+/*===========================================================================*/
+
+/** Advertise the listener as _cwnet._tcp, host name cwkeyer-XXXXXX.local */
+static void advertise_peer_port(void) {
+    int64_t now_us = esp_timer_get_time();
+    uint8_t mac[6] = {0};
+    char hostname[16];
+
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(hostname, sizeof(hostname), "cwkeyer-%02x%02x%02x", mac[3], mac[4], mac[5]);
+
+    mdns_txt_item_t txt[] = {
+        { "user", s_ctx.username },
+    };
+    if (mdns_init() != ESP_OK ||
+        mdns_hostname_set(hostname) != ESP_OK ||
+        mdns_service_add(s_ctx.username[0] != '\0' ? s_ctx.username : hostname,
+                         CWNET_MDNS_SERVICE, CWNET_MDNS_PROTO, s_ctx.peer_port,
+                         txt, sizeof(txt) / sizeof(txt[0])) != ESP_OK) {
+        RT_WARN(&g_bg_log_stream, now_us, "CWNet: mDNS advertise failed");
+        return;
+    }
+    RT_INFO(&g_bg_log_stream, now_us, "CWNet: peers can reach %s.local:%u",
+            hostname, s_ctx.peer_port);
+}
+
+/** Listen for a LAN peer on remote.peer_port */
+static void open_listener(void) {
+    int64_t now_us = esp_timer_get_time();
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(s_ctx.peer_port),
+        .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int reuse = 1;
+    if (sock >= 0) {
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+    if (sock < 0 || !set_nonblocking(sock) ||
+        bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(sock, 1) < 0) {
+        RT_ERROR(&g_bg_log_stream, now_us, "CWNet: peer listen on %u failed: %d",
+                 s_ctx.peer_port, errno);
+        if (sock >= 0) {
+            close(sock);
+        }
+        return;
+    }
+
+    s_ctx.listen_sock = sock;
+    advertise_peer_port();
+}
+
+static void close_peer(void) {
+    if (s_ctx.peer_sock >= 0) {
+        close(s_ctx.peer_sock);
+        s_ctx.peer_sock = -1;
+    }
+    if (cwnet_peer_get_state(&s_ctx.peer) != CWNET_PEER_IDLE) {
+        RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "CWNet peer: disconnected");
+    }
+    cwnet_peer_on_closed(&s_ctx.peer);
+    release_remote();
+}
+
+/** Take a waiting connection; a second keyer is turned away */
+static void accept_peer(void) {
+    int sock = accept(s_ctx.listen_sock, NULL, NULL);
+    if (sock < 0) {
+        return;
+    }
+    if (s_ctx.peer_sock >= 0 || !set_nonblocking(sock)) {
+        close(sock);
+        return;
+    }
+
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    s_ctx.peer_sock = sock;
+    s_ctx.peer_accept_us = esp_timer_get_time();
+    cwnet_peer_on_accepted(&s_ctx.peer);
+}
+
+/** Accept, receive and keep the peer's clock synced */
+static void process_peer(void) {
+    if (s_ctx.listen_sock < 0) {
+        return;
+    }
+    accept_peer();
+    if (s_ctx.peer_sock < 0) {
+        return;
+    }
+
+    uint8_t buf[256];
+    ssize_t n;
+    while ((n = recv(s_ctx.peer_sock, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        cwnet_peer_on_data(&s_ctx.peer, buf, (size_t)n);
+    }
+
+    /* A connection that never sends CONNECT must not hold the slot */
+    cwnet_peer_state_t st = cwnet_peer_get_state(&s_ctx.peer);
+    bool stalled = (st == CWNET_PEER_WAIT_CONNECT) &&
+                   (esp_timer_get_time() - s_ctx.peer_accept_us) > (CONNECT_TIMEOUT_MS * 1000LL);
+
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK) ||
+        st == CWNET_PEER_IDLE || stalled ||
+        cwnet_peer_poll(&s_ctx.peer) != CWNET_CLIENT_OK) {
+        close_peer();
+    }
+}
+
+/*===========================================================================*/
+/* Address Cache (NVS)                                                       */
+/*===========================================================================*/
+
+/** Load the last good address, if it was stored for the configured host */
+static void load_cached_addr(cwnet_session_t *s) {
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+
+    char host[CWNET_MAX_HOST_LEN];
+    size_t len = sizeof(host);
+    uint32_t addr = 0;
+    if (nvs_get_str(handle, s->nvs_host, host, &len) == ESP_OK &&
+        strcmp(host, s->host) == 0 &&
+        nvs_get_u32(handle, s->nvs_addr, &addr) == ESP_OK) {
+        s->server_addr = addr;
+    }
+    nvs_close(handle);
+}
+
+/** Persist a freshly resolved address (only when it changed) */
+static void save_cached_addr(const cwnet_session_t *s, uint32_t addr) {
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    nvs_set_str(handle, s->nvs_host, s->host);
+    nvs_set_u32(handle, s->nvs_addr, addr);
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+/*===========================================================================*/
+/* Asynchronous DNS                                                          */
+/*===========================================================================*/
+
+/** lwIP callback (tcpip thread) */
+static void dns_found_cb(const char *name, const ip_addr_t *ipaddr, void *arg) {
+    (void)name;
+    dns_handoff_t *dns = arg;
+    if (ipaddr != NULL && IP_IS_V4(ipaddr)) {
+        dns->addr = ip4_addr_get_u32(ip_2_ip4(ipaddr));
+        atomic_store_explicit(&dns->status, DNS_DONE, memory_order_release);
+    } else {
+        atomic_store_explicit(&dns->status, DNS_FAILED, memory_order_release);
+    }
+}
+
+/** Runs in the tcpip thread: dns_gethostbyname() is not thread-safe */
+static void dns_start_cb(void *arg) {
+    cwnet_session_t *s = arg;
+    ip_addr_t addr;
+    err_t err = dns_gethostbyname(s->host, &addr, dns_found_cb, &s->dns);
+    if (err == ERR_OK) {
+        /* Cached by lwIP or a numeric address: no callback will follow */
+        dns_found_cb(s->host, &addr, &s->dns);
+    } else if (err != ERR_INPROGRESS) {
+        atomic_store_explicit(&s->dns.status, DNS_FAILED, memory_order_release);
+    }
+}
+
+/**
+ * @brief Start resolving the server host without blocking
+ */
+static void start_resolve(cwnet_session_t *s) {
+    int64_t now_us = esp_timer_get_time();
+
+    RT_INFO(&g_bg_log_stream, now_us, "%s: resolving %s", s->tag, s->host);
+    s->state = CWNET_SOCK_RESOLVING;
+    s->resolve_start_us = now_us;
+    atomic_store_explicit(&s->dns.status, DNS_PENDING, memory_order_relaxed);
+
+    if (tcpip_callback(dns_start_cb, s) != ERR_OK) {
+        RT_WARN(&g_bg_log_stream, now_us, "%s: DNS request not queued", s->tag);
+        atomic_store_explicit(&s->dns.status, DNS_IDLE, memory_order_relaxed);
+        schedule_retry(s, now_us);
+    }
+}
+
+static bool start_connect(cwnet_session_t *s);
+
+/**
+ * @brief Check for a DNS answer; connect once it arrives
+ */
+static void check_resolve_complete(cwnet_session_t *s) {
+    int64_t now_us = esp_timer_get_time();
+    int status = atomic_load_explicit(&s->dns.status, memory_order_acquire);
+
+    if (status == DNS_DONE) {
+        uint32_t addr = s->dns.addr;
+        atomic_store_explicit(&s->dns.status, DNS_IDLE, memory_order_relaxed);
+        if (addr != s->server_addr) {
+            s->server_addr = addr;
+            save_cached_addr(s, addr);
+        }
+        s->need_resolve = false;
+        start_connect(s);
+        return;
+    }
+
+    bool failed = (status == DNS_FAILED);
+    if (!failed && (now_us - s->resolve_start_us) <= (DNS_TIMEOUT_MS * 1000LL)) {
+        return;  /* Still waiting */
+    }
+
+    /* A late callback only sets s->dns; the next attempt resets it */
+    atomic_store_explicit(&s->dns.status, DNS_IDLE, memory_order_relaxed);
+    RT_WARN(&g_bg_log_stream, now_us, "%s: DNS %s for %s",
+            s->tag, failed ? "failed" : "timeout", s->host);
+
+    if (s->server_addr != 0) {
+        /* DNS outage: fall back to the last good address */
+        s->need_resolve = false;
+        start_connect(s);
+    } else {
+        schedule_retry(s, now_us);
+    }
+}
+
+/*===========================================================================*/
+/* Connection                                                                */
+/*===========================================================================*/
+
+/**
+ * @brief Open a non-blocking TCP connection to s->server_addr
+ */
+static bool start_connect(cwnet_session_t *s) {
+    int64_t now_us = esp_timer_get_time();
+
+    struct sockaddr_in dest = {
+        .sin_family = AF_INET,
+        .sin_port = htons(s->port),
+        .sin_addr.s_addr = s->server_addr
+    };
 
     /* Create socket */
-    s_ctx.sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-    if (s_ctx.sock < 0) {
-        RT_ERROR(&g_bg_log_stream, now_us, "CWNet: socket() failed: %d", errno);
-        freeaddrinfo(res);
-        s_ctx.state = CWNET_SOCK_ERROR;
-        s_ctx.last_attempt_us = now_us;
+    s->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s->sock < 0) {
+        RT_ERROR(&g_bg_log_stream, now_us, "%s: socket() failed: %d", s->tag, errno);
+        schedule_retry(s, now_us);
         return false;
     }
 
+    /* Key events are tiny and latency-critical: never let Nagle hold them */
+    int nodelay = 1;
+    setsockopt(s->sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
     /* Set non-blocking */
-    if (!set_nonblocking(s_ctx.sock)) {
-        RT_ERROR(&g_bg_log_stream, now_us, "CWNet: fcntl failed");
-        close_socket();
-        freeaddrinfo(res);
-        s_ctx.state = CWNET_SOCK_ERROR;
-        s_ctx.last_attempt_us = now_us;
+    if (!set_nonblocking(s->sock)) {
+        RT_ERROR(&g_bg_log_stream, now_us, "%s: fcntl failed", s->tag);
+        close_socket(s);
+        schedule_retry(s, now_us);
         return false;
     }
 
     /* Start non-blocking connect */
-    RT_INFO(&g_bg_log_stream, now_us, "CWNet: connecting to %s:%u", s_ctx.host, s_ctx.port);
-    s_ctx.state = CWNET_SOCK_CONNECTING;
-    s_ctx.connect_start_us = now_us;
+    RT_INFO(&g_bg_log_stream, now_us, "%s: connecting to %s:%u", s->tag, s->host, s->port);
+    s->state = CWNET_SOCK_CONNECTING;
+    s->connect_start_us = now_us;
 
-    err = connect(s_ctx.sock, res->ai_addr, res->ai_addrlen);
-    freeaddrinfo(res);
+    int err = connect(s->sock, (struct sockaddr *)&dest, sizeof(dest));
 
     if (err < 0 && errno != EINPROGRESS) {
-        RT_WARN(&g_bg_log_stream, now_us, "CWNet: connect() failed: %d", errno);
-        close_socket();
-        s_ctx.state = CWNET_SOCK_ERROR;
-        s_ctx.last_attempt_us = now_us;
+        RT_WARN(&g_bg_log_stream, now_us, "%s: connect() failed: %d", s->tag, errno);
+        close_socket(s);
+        schedule_retry(s, now_us);
         return false;
     }
 
     return true;
 }
 
-static bool check_connect_complete(void) {
+static bool check_connect_complete(cwnet_session_t *s) {
     int64_t now_us = esp_timer_get_time();
 
     /* Check for timeout */
-    if ((now_us - s_ctx.connect_start_us) > (CONNECT_TIMEOUT_MS * 1000LL)) {
-        RT_WARN(&g_bg_log_stream, now_us, "CWNet: connect timeout");
-        close_socket();
-        s_ctx.state = CWNET_SOCK_ERROR;
-        s_ctx.last_attempt_us = now_us;
+    if ((now_us - s->connect_start_us) > (CONNECT_TIMEOUT_MS * 1000LL)) {
+        RT_WARN(&g_bg_log_stream, now_us, "%s: connect timeout", s->tag);
+        close_socket(s);
+        schedule_retry(s, now_us);
         return false;
     }
 
     /* Check if connect completed */
     fd_set write_fds;
     FD_ZERO(&write_fds);
-    FD_SET(s_ctx.sock, &write_fds);
+    FD_SET(s->sock, &write_fds);
 
     struct timeval tv = {0, 0};  /* Non-blocking check */
-    int ret = select(s_ctx.sock + 1, NULL, &write_fds, NULL, &tv);
+    int ret = select(s->sock + 1, NULL, &write_fds, NULL, &tv);
 
-    if (ret > 0 && FD_ISSET(s_ctx.sock, &write_fds)) {
+    if (ret > 0 && FD_ISSET(s->sock, &write_fds)) {
         /* Check for socket error */
         int so_error = 0;
         socklen_t len = sizeof(so_error);
-        getsockopt(s_ctx.sock, SOL_SOCKET, SO_ERROR, &so_error, &len);
+        getsockopt(s->sock, SOL_SOCKET, SO_ERROR, &so_error, &len);
 
         if (so_error != 0) {
-            RT_WARN(&g_bg_log_stream, now_us, "CWNet: connect error: %d", so_error);
-            close_socket();
-            s_ctx.state = CWNET_SOCK_ERROR;
-            s_ctx.last_attempt_us = now_us;
+            RT_WARN(&g_bg_log_stream, now_us, "%s: connect error: %d", s->tag, so_error);
+            close_socket(s);
+            schedule_retry(s, now_us);
             return false;
         }
 
         /* Connected! */
-        RT_INFO(&g_bg_log_stream, now_us, "CWNet: TCP connected");
-        s_ctx.state = CWNET_SOCK_CONNECTED;
-        cwnet_client_on_connected(&s_ctx.client);
+        RT_INFO(&g_bg_log_stream, now_us, "%s: TCP connected", s->tag);
+        capture_endpoint(s->sock, &s->cap_tcp);
+        s->state = CWNET_SOCK_CONNECTED;
+        cwnet_client_on_connected(&s->client);
         return true;
     }
 
     return false;  /* Still connecting */
 }
 
-static void process_recv(void) {
-    if (s_ctx.sock < 0) {
+/** Hand every complete frame in the ring to the client */
+static void deliver_frames(cwnet_session_t *s) {
+    cwnet_frame_view_t frame;
+    cwnet_rx_status_t st;
+
+    while ((st = cwnet_rx_next_frame(&s->rx, &frame)) != CWNET_RX_NEED_MORE) {
+        if (st == CWNET_RX_FRAME) {
+            cwnet_client_on_frame(&s->client, &frame);
+        }
+    }
+}
+
+static void process_recv(cwnet_session_t *s) {
+    if (s->sock < 0) {
         return;
     }
 
-    uint8_t buf[256];
-    ssize_t n = recv(s_ctx.sock, buf, sizeof(buf), MSG_DONTWAIT);
+    /* Drain everything the stack has queued, straight into the ring */
+    ssize_t n;
+    for (;;) {
+        uint8_t *dst;
+        size_t space = cwnet_rx_write_span(&s->rx, &dst);
+        if (space == 0) {
+            /* Unreachable: frames larger than the ring are discarded */
+            n = -1;
+            errno = ENOBUFS;
+            break;
+        }
+        n = recv(s->sock, dst, space, MSG_DONTWAIT);
+        if (n <= 0) {
+            break;
+        }
+        cwnet_capture_frame(&g_cwnet_capture, CWNET_CAPTURE_RX, CWNET_CAPTURE_TCP,
+                            &s->cap_tcp, dst, (size_t)n, esp_timer_get_time());
+        cwnet_rx_commit(&s->rx, (size_t)n);
+        deliver_frames(s);
+    }
 
-    if (n > 0) {
-        cwnet_client_on_data(&s_ctx.client, buf, (size_t)n);
-    } else if (n == 0) {
+    if (n == 0) {
         /* Connection closed by server */
         int64_t now_us = esp_timer_get_time();
-        RT_WARN(&g_bg_log_stream, now_us, "CWNet: server closed connection");
-        close_socket();
-        s_ctx.state = CWNET_SOCK_ERROR;
-        s_ctx.last_attempt_us = now_us;
+        RT_WARN(&g_bg_log_stream, now_us, "%s: server closed connection", s->tag);
+        close_socket(s);
+        schedule_retry(s, now_us);
     } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
         /* Actual error */
         int64_t now_us = esp_timer_get_time();
-        RT_ERROR(&g_bg_log_stream, now_us, "CWNet: recv error: %d", errno);
-        close_socket();
-        s_ctx.state = CWNET_SOCK_ERROR;
-        s_ctx.last_attempt_us = now_us;
+        RT_ERROR(&g_bg_log_stream, now_us, "%s: recv error: %d", s->tag, errno);
+        close_socket(s);
+        schedule_retry(s, now_us);
     }
     /* EAGAIN/EWOULDBLOCK is normal for non-blocking - no data available */
 }
 
+/**
+ * @brief Block until a socket has work or the poll period expires
+ */
+static void add_fd(int fd, fd_set *fds, int *maxfd) {
+    if (fd < 0) {
+        return;
+    }
+    FD_SET(fd, fds);
+    if (fd > *maxfd) {
+        *maxfd = fd;
+    }
+}
+
+static void wait_for_io(void) {
+    fd_set rfds;
+    fd_set wfds;
+    FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
+    int maxfd = -1;
+    bool connecting = false;
+    struct timeval tv = {0, CWNET_POLL_MS * 1000};
+    int64_t now_us = esp_timer_get_time();
+
+    FOR_EACH_SESSION(s) {
+        if (s->sock < 0) {
+            continue;
+        }
+        if (s->state == CWNET_SOCK_CONNECTING) {
+            add_fd(s->sock, &wfds, &maxfd);
+            connecting = true;
+        } else if (s->state == CWNET_SOCK_CONNECTED || s->state == CWNET_SOCK_READY) {
+            add_fd(s->sock, &rfds, &maxfd);
+            add_fd(s->udp_sock, &rfds, &maxfd);
+        }
+
+        /* Wake in time to flush held key events */
+        if (s->tx_edges > 0) {
+            int64_t left_us = s->tx_first_us + (int64_t)s_ctx.coalesce_us - now_us;
+            if (left_us < 0) {
+                left_us = 0;
+            }
+            if (left_us < tv.tv_usec) {
+                tv.tv_usec = (suseconds_t)left_us;
+            }
+        }
+    }
+
+    if (maxfd < 0 && s_ctx.listen_sock < 0) {
+        vTaskDelay(pdMS_TO_TICKS(CWNET_IDLE_MS));
+        return;
+    }
+    add_fd(s_ctx.listen_sock, &rfds, &maxfd);
+    add_fd(s_ctx.peer_sock, &rfds, &maxfd);
+
+    /* Result is not needed: cwnet_socket_process() does non-blocking I/O */
+    (void)select(maxfd + 1, &rfds, connecting ? &wfds : NULL, NULL, &tv);
+}
+
+/**
+ * @brief Queue one edge on a session (or send it over UDP)
+ *
+ * @return true if the session took it
+ */
+static bool session_send_edge(cwnet_session_t *s, bool key_down, int64_t event_us) {
+    if (s->state != CWNET_SOCK_READY || s->standby) {
+        return false;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    if (s->udp_sock >= 0) {
+        if (!send_udp_edge(s, key_down, event_us)) {
+            return false;
+        }
+        cwnet_latency_record(&s->latency, now_us - event_us);
+        return true;
+    }
+    if (s->tx_edges == CWNET_TX_MAX_EDGES) {
+        flush_tx(s, now_us, true);
+        if (s->tx_edges == CWNET_TX_MAX_EDGES) {
+            return false;  /* Socket backed up */
+        }
+    }
+
+    /* Queued in the client's TX arena; flush_tx() sends it */
+    cwnet_client_err_t err = cwnet_client_send_key_event_at(&s->client, key_down,
+                                                            (int32_t)(event_us / 1000));
+    if (err == CWNET_CLIENT_OK) {
+        if (s->tx_edges == 0) {
+            s->tx_first_us = now_us;
+        }
+        s->tx_edge_us[s->tx_edges++] = event_us;
+        RT_DEBUG(&g_bg_log_stream, now_us, "%s TX: %s @%lldus",
+                 s->tag, key_down ? "DOWN" : "UP", (long long)event_us);
+        return true;
+    }
+    return false;
+}
+
+/** Forward one sample if it carries a LOCAL key edge */
+static void forward_sample(const stream_sample_t *sample) {
+    uint64_t tick = timed_consumer_step(&s_ctx.edges, sample);
+
+    if (sample_is_silence(sample) || sample_lane(sample) != STREAM_LANE_LOCAL ||
+        !sample_has_local_edge(sample)) {
+        return;
+    }
+    int64_t event_us = timed_consumer_time_us(&s_ctx.edges, tick);
+    cwnet_socket_send_key_event_at(sample->local_key != 0, event_us);
+    if (cwnet_peer_send_key_event_at(&s_ctx.peer, sample->local_key != 0,
+                                     (int32_t)(event_us / 1000)) == CWNET_CLIENT_ERR_SEND_FAILED) {
+        close_peer();
+    }
+}
+
+/**
+ * @brief Drain pending stream samples, sending every key edge
+ *
+ * Runs in every state so the consumer stays current; edges seen while
+ * not READY are dropped rather than replayed on connect.
+ */
+static void forward_key_edges(void) {
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+
+    while (timed_consumer_next_span(&s_ctx.edges, &a, &na, &b, &nb, SIZE_MAX) > 0) {
+        for (size_t i = 0; i < na; i++) {
+            forward_sample(&a[i].sample);
+        }
+        for (size_t i = 0; i < nb; i++) {
+            forward_sample(&b[i].sample);
+        }
+        timed_consumer_commit(&s_ctx.edges, na + nb);
+    }
+}
+
+static void next_candidate(cwnet_session_t *s);
+
+/** One service pass of a session's connection state machine */
+static void process_session(cwnet_session_t *s, int64_t now_us) {
+    switch (s->state) {
+        case CWNET_SOCK_DISABLED:
+            /* Nothing to do */
+            break;
+
+        case CWNET_SOCK_DISCONNECTED:
+            /* Start connection attempt (cached address first) */
+            if (s->server_addr == 0 || s->need_resolve) {
+                start_resolve(s);
+            } else {
+                start_connect(s);
+            }
+            break;
+
+        case CWNET_SOCK_RESOLVING:
+            /* Waiting for the lwIP DNS callback */
+            check_resolve_complete(s);
+            break;
+
+        case CWNET_SOCK_CONNECTING:
+            /* Check if connect completed */
+            check_connect_complete(s);
+            break;
+
+        case CWNET_SOCK_CONNECTED:
+        case CWNET_SOCK_READY:
+            /* Process incoming data; replies go out at once */
+            process_recv(s);
+            process_udp_recv(s);
+            flush_tx(s, now_us, true);
+
+            /* Update state from client */
+            if (cwnet_client_get_state(&s->client) == CWNET_STATE_READY) {
+                s->state = CWNET_SOCK_READY;
+            }
+            break;
+
+        case CWNET_SOCK_ERROR:
+            /* Wait before reconnecting */
+            if ((now_us - s->last_attempt_us) > ((int64_t)s->retry_delay_ms * 1000LL)) {
+                if (s->standby) {
+                    next_candidate(s);
+                }
+                RT_INFO(&g_bg_log_stream, now_us, "%s: reconnecting (attempt %lu)...",
+                        s->tag, (unsigned long)s->failures + 1UL);
+                s->state = CWNET_SOCK_DISCONNECTED;
+            }
+            break;
+    }
+}
+
 /*===========================================================================*/
 /* Public API                                                                */
 /*===========================================================================*/
 
+static int64_t metric_latency_ms(const void *ctx) {
+    (void)ctx;
+    return cwnet_socket_get_latency_ms();
+}
+
+static int64_t metric_ready(const void *ctx) {
+    (void)ctx;
+    return cwnet_socket_is_ready() ? 1 : 0;
+}
+
+static int64_t metric_sessions_ready(const void *ctx) {
+    (void)ctx;
+    int64_t n = 0;
+    FOR_EACH_SESSION(s) {
+        n += (s->state == CWNET_SOCK_READY && !s->standby) ? 1 : 0;
+    }
+    return n;
+}
+
+static int64_t metric_rx_late(const void *ctx) {
+    (void)ctx;
+    return cwnet_socket_get_rx_late();
+}
+
+static int64_t metric_edges_dropped(const void *ctx) {
+    (void)ctx;
+    return (int64_t)best_effort_consumer_dropped(&s_ctx.edges.base);
+}
+
+static const metric_desc_t k_cwnet_metrics[] = {
+    { "keyer_cwnet_ready", "1 while a CWNet session is ready to key", METRIC_GAUGE,
+      metric_ready, NULL },
+    { "keyer_cwnet_sessions_ready", "CWNet server sessions ready to key", METRIC_GAUGE,
+      metric_sessions_ready, NULL },
+    { "keyer_cwnet_latency_ms", "Server round trip, -1 if unknown", METRIC_GAUGE,
+      metric_latency_ms, NULL },
+    { "keyer_cwnet_rx_late_total", "Remote key events that missed their playout time",
+      METRIC_COUNTER, metric_rx_late, NULL },
+    { "keyer_stream_dropped_total{consumer=\"cwnet\"}", "Samples a consumer skipped",
+      METRIC_COUNTER, metric_edges_dropped, NULL },
+    { "keyer_cwnet_failovers_total", "Failover standby sessions that took over the keying",
+      METRIC_COUNTER, NULL, &s_ctx.failovers },
+};
+
+/** Address cache keys: config slot 0 and failover candidate 0 share the original ones */
+static void set_cache_keys(cwnet_session_t *s, const char *infix, unsigned n) {
+    if (n == 0) {
+        snprintf(s->nvs_host, sizeof(s->nvs_host), "%s", NVS_KEY_HOST);
+        snprintf(s->nvs_addr, sizeof(s->nvs_addr), "%s", NVS_KEY_ADDR);
+    } else {
+        snprintf(s->nvs_host, sizeof(s->nvs_host), "%s%s%u", NVS_KEY_HOST, infix, n);
+        snprintf(s->nvs_addr, sizeof(s->nvs_addr), "%s%s%u", NVS_KEY_ADDR, infix, n);
+    }
+}
+
+/**
+ * @brief Configure one server session from its config slot (skipped without a host)
+ *
+ * @return The session, valid until the next add_session() moves it; NULL if skipped
+ */
+static cwnet_session_t *add_session(uint8_t slot, const char *tag, const char *host,
+                                    uint16_t port, uint16_t udp_port, uint8_t priority) {
+    if (host[0] == '\0' || s_ctx.session_count == CWNET_MAX_SESSIONS) {
+        return NULL;
+    }
+
+    /* Stable insert by priority: equal priorities keep config order */
+    size_t at = s_ctx.session_count;
+    while (at > 0 && s_ctx.sessions[at - 1].priority < priority) {
+        s_ctx.sessions[at] = s_ctx.sessions[at - 1];
+        at--;
+    }
+    s_ctx.session_count++;
+
+    cwnet_session_t *s = &s_ctx.sessions[at];
+    memset(s, 0, sizeof(*s));
+    s->tag = tag;
+    s->slot = slot;
+    s->priority = priority;
+    s->state = CWNET_SOCK_DISABLED;
+    s->sock = -1;
+    s->udp_sock = -1;
+    strncpy(s->host, host, sizeof(s->host) - 1);
+    s->port = port;
+    s->udp_port = udp_port;
+
+    /* Slot 0 keeps the keys it had before there were two servers */
+    set_cache_keys(s, "", (slot == 0) ? 0U : slot + 1U);
+    return s;
+}
+
+/** (Re)initialize a session's client for s->host */
+static cwnet_client_err_t init_client(cwnet_session_t *s) {
+    cwnet_client_config_t cfg = {
+        .server_host = s->host,
+        .server_port = s->port,
+        .username = s_ctx.username,
+        .send_cb = socket_send_cb,
+        .get_time_ms_cb = get_time_ms_cb,
+        .state_change_cb = state_change_cb,
+        .cw_event_cb = cw_event_cb,
+        .audio_cb = audio_cb,
+        .user_data = s,
+        .coalesce = true
+    };
+    return cwnet_client_init(&s->client, &cfg);
+}
+
+/** Start a configured session's client (after the sessions are sorted) */
+static void start_session(cwnet_session_t *s) {
+    cwnet_latency_init(&s->latency);
+    cwnet_rx_init(&s->rx);
+
+    /* Initialize client state machine */
+    int64_t now_us = esp_timer_get_time();
+    cwnet_client_err_t err = init_client(s);
+    if (err != CWNET_CLIENT_OK) {
+        RT_ERROR(&g_bg_log_stream, now_us, "%s: client init failed: %d", s->tag, err);
+        return;  /* Stays DISABLED */
+    }
+
+    RT_INFO(&g_bg_log_stream, now_us, "%s: initialized, server=%s:%u user=%s priority=%u%s",
+            s->tag, s->host, s->port, s_ctx.username, s->priority,
+            s->standby ? " (standby)" : "");
+
+    /* Connect straight to the last good address; DNS runs only if it fails */
+    load_cached_addr(s);
+
+    s->state = CWNET_SOCK_DISCONNECTED;
+}
+
+/*===========================================================================*/
+/* Failover Group                                                            */
+/*===========================================================================*/
+
+/** The group's session that is not s */
+static cwnet_session_t *group_other(const cwnet_session_t *s) {
+    return (s == s_ctx.group[0]) ? s_ctx.group[1] : s_ctx.group[0];
+}
+
+/** Point a group session at a candidate (socket closed) */
+static void assign_candidate(cwnet_session_t *s, uint8_t cand) {
+    const cwnet_select_host_t *h = &s_ctx.hosts[cand];
+    s->cand = cand;
+    snprintf(s->host, sizeof(s->host), "%s", h->host);
+    s->port = h->port;
+    s->server_addr = 0;
+    s->need_resolve = false;
+    s->scored = false;
+    set_cache_keys(s, NVS_KEY_ALT, cand);
+}
+
+/** Move a closed standby to the candidate the group wants it on next */
+static void next_candidate(cwnet_session_t *s) {
+    uint8_t next = cwnet_select_next(&s_ctx.select, group_other(s)->cand);
+    if (next == CWNET_SELECT_NONE || next == s->cand) {
+        return;
+    }
+    assign_candidate(s, next);
+    (void)init_client(s);   /* Cannot fail: the host is never empty */
+    load_cached_addr(s);
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "%s: standby probing %s:%u",
+            s->tag, s->host, s->port);
+}
+
+/** Score of a READY session's link, -1 otherwise */
+static int32_t session_score(const cwnet_session_t *s) {
+    if (s->state != CWNET_SOCK_READY) {
+        return -1;
+    }
+    cwnet_sync_stats_t st;
+    cwnet_client_get_sync_stats(&s->client, &st);
+    return cwnet_select_score(&st);
+}
+
+/**
+ * @brief Hand the keying to the standby
+ *
+ * @param drop Close the old active link (it went quiet) instead of
+ *             keeping it as the new standby
+ */
+static void promote(cwnet_session_t *from, cwnet_session_t *to, const char *why,
+                    bool drop, int64_t now_us) {
+    from->standby = true;
+    to->standby = false;
+    atomic_fetch_add_explicit(&s_ctx.failovers, 1U, memory_order_relaxed);
+    RT_WARN(&g_bg_log_stream, now_us, "CWNet: failover %s:%u -> %s:%u (%s)",
+            from->host, from->port, to->host, to->port, why);
+    if (drop && from->sock >= 0) {
+        close_socket(from);
+        schedule_retry(from, now_us);
+    }
+}
+
+/**
+ * @brief One pass of the failover group: score, take over, probe
+ *
+ * Runs after the sessions' own state machines, so a link that dropped in
+ * this pass is replaced in the same one.
+ */
+static void process_failover(int64_t now_us) {
+    if (s_ctx.group[0] == NULL) {
+        return;
+    }
+    cwnet_session_t *a = s_ctx.group[0]->standby ? s_ctx.group[1] : s_ctx.group[0];
+    cwnet_session_t *b = group_other(a);
+    int32_t now_ms = (int32_t)(now_us / 1000);
+
+    if ((now_us - s_ctx.round_us) > (CWNET_SELECT_REPROBE_MS * 1000LL)) {
+        s_ctx.round_us = now_us;
+        cwnet_select_new_round(&s_ctx.select);
+    }
+
+    int32_t a_score = session_score(a);
+    int32_t b_score = session_score(b);
+    cwnet_select_report(&s_ctx.select, a->cand, a_score);
+    cwnet_select_report(&s_ctx.select, b->cand, b_score);
+    if (b_score >= 0) {
+        b->scored = true;
+    }
+
+    /* A synced standby keys on the right clock from its first edge */
+    if (b->state == CWNET_SOCK_READY && b->client.sync.count > 0) {
+        if (a->state != CWNET_SOCK_READY) {
+            promote(a, b, "link down", false, now_us);
+            return;
+        }
+        if (cwnet_select_stale(&a->client.sync, now_ms)) {
+            promote(a, b, "PING missed", true, now_us);
+            return;
+        }
+        if (cwnet_select_better(a_score, b_score)) {
+            promote(a, b, "lower RTT", false, now_us);
+            return;
+        }
+    }
+
+    /* Standby: score its candidate, then move on or stay parked */
+    if (b->state != CWNET_SOCK_READY) {
+        return;
+    }
+    if (!b->scored) {
+        if ((now_us - b->ready_us) <= (CWNET_SELECT_PROBE_TIMEOUT_MS * 1000LL)) {
+            return;
+        }
+        RT_WARN(&g_bg_log_stream, now_us, "%s: %s:%u sent no usable PINGs",
+                b->tag, b->host, b->port);
+        cwnet_select_fail(&s_ctx.select, b->cand);
+        b->ready_us = now_us;
+    }
+    uint8_t next = cwnet_select_next(&s_ctx.select, a->cand);
+    if (next != CWNET_SELECT_NONE && next != b->cand) {
+        close_socket(b);
+        next_candidate(b);
+        b->state = CWNET_SOCK_DISCONNECTED;
+    }
+}
+
+/**
+ * @brief Slot 0 as a failover group: server_host plus remote.server_list
+ *
+ * @return false without a list (slot 0 is a plain session)
+ */
+static bool add_failover_group(void) {
+    s_ctx.hosts[0].port = g_config.remote.server_port;
+    snprintf(s_ctx.hosts[0].host, sizeof(s_ctx.hosts[0].host), "%s",
+             g_config.remote.server_host);
+    size_t n = 1 + cwnet_select_parse_list(g_config.remote.server_list,
+                                           g_config.remote.server_port,
+                                           &s_ctx.hosts[1], CWNET_SELECT_MAX - 1);
+    if (s_ctx.hosts[0].host[0] == '\0' || n < 2) {
+        return false;
+    }
+    cwnet_select_init(&s_ctx.select, n);
+
+    /* The configured server keys at once; the standby starts on the first alternate */
+    static const char *const tags[2] = { "CWNet/a", "CWNet/b" };
+    for (uint8_t i = 0; i < 2; i++) {
+        cwnet_session_t *s = add_session(0, tags[i], s_ctx.hosts[i].host, s_ctx.hosts[i].port,
+                                         g_config.remote.udp_port,
+                                         g_config.remote.server_priority);
+        if (s == NULL) {
+            return true;
+        }
+        s->grouped = true;
+        s->standby = (i == 1);
+        assign_candidate(s, i);
+    }
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "CWNet: failover group of %u servers",
+            (unsigned)n);
+    return true;
+}
+
 void cwnet_socket_init(void) {
     memset(&s_ctx, 0, sizeof(s_ctx));
-    s_ctx.sock = -1;
-    s_ctx.state = CWNET_SOCK_DISABLED;
+    s_ctx.listen_sock = -1;
+    s_ctx.peer_sock = -1;
 
     /* Read config */
     s_ctx.enabled = g_config.remote.cwnet_enabled;
@@ -254,116 +1449,270 @@ void cwnet_socket_init(void) {
     }
 
     /* Copy config values */
-    strncpy(s_ctx.host, g_config.remote.server_host, sizeof(s_ctx.host) - 1);
-    s_ctx.port = g_config.remote.server_port;
     strncpy(s_ctx.username, g_config.remote.username, sizeof(s_ctx.username) - 1);
+    s_ctx.coalesce_us = g_config.remote.coalesce_us;
+    s_ctx.peer_port = g_config.remote.peer_port;
+    s_ctx.playout_ms = (int32_t)g_config.remote.playout_ms;
+    if (!add_failover_group()) {
+        (void)add_session(0, "CWNet", g_config.remote.server_host, g_config.remote.server_port,
+                          g_config.remote.udp_port, g_config.remote.server_priority);
+    }
+    if (g_config.remote.server2_enabled) {
+        (void)add_session(1, "CWNet#2", g_config.remote.server2_host,
+                          g_config.remote.server2_port, g_config.remote.server2_udp_port,
+                          g_config.remote.server2_priority);
+    }
 
     /* Validate */
-    if (s_ctx.host[0] == '\0') {
+    if (s_ctx.session_count == 0 && s_ctx.peer_port == 0) {
         int64_t now_us = esp_timer_get_time();
         RT_WARN(&g_bg_log_stream, now_us, "CWNet: no server host configured");
         s_ctx.enabled = false;
         return;
     }
 
-    /* Initialize client state machine */
-    cwnet_client_config_t cfg = {
-        .server_host = s_ctx.host,
-        .server_port = s_ctx.port,
-        .username = s_ctx.username,
-        .send_cb = socket_send_cb,
+    /* Capture ring in PSRAM, allocated once; remote.cwnet_capture turns it on */
+    void *slots = heap_caps_calloc(CWNET_CAPTURE_SLOTS, sizeof(cwnet_capture_slot_t),
+                                   MALLOC_CAP_SPIRAM);
+    if (slots == NULL) {
+        RT_WARN(&g_bg_log_stream, esp_timer_get_time(), "CWNet: no PSRAM for capture");
+    }
+    cwnet_capture_init(&g_cwnet_capture, slots, CWNET_CAPTURE_SLOTS);
+
+    /* Shared by all sessions and the peer */
+    timed_consumer_init(&s_ctx.edges, &g_keying_stream, 0);
+    best_effort_consumer_register(&s_ctx.edges.base, "cwnet");
+    metrics_register_all(&g_metrics, k_cwnet_metrics,
+                         sizeof(k_cwnet_metrics) / sizeof(k_cwnet_metrics[0]));
+    stream_handoff_init(&s_ctx.remote, &g_keying_stream, STREAM_LANE_REMOTE);
+    if (!stream_handoffs_attach(&g_stream_handoffs, &s_ctx.remote)) {
+        RT_WARN(&g_bg_log_stream, esp_timer_get_time(), "CWNet: no stream handoff slot");
+    }
+    reset_rx_jitter();
+
+    cwnet_peer_config_t peer_cfg = {
+        .send_cb = peer_send_cb,
         .get_time_ms_cb = get_time_ms_cb,
-        .state_change_cb = state_change_cb,
-        .cw_event_cb = NULL,  /* TODO: handle received CW events */
+        .cw_event_cb = peer_event_cb,
         .user_data = NULL
     };
+    cwnet_peer_init(&s_ctx.peer, &peer_cfg);
+    if (s_ctx.peer_port != 0) {
+        open_listener();
+    }
+    if (s_ctx.session_count == 0) {
+        RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "CWNet: peer mode only");
+        return;  /* No server to reach */
+    }
 
-    cwnet_client_err_t err = cwnet_client_init(&s_ctx.client, &cfg);
-    if (err != CWNET_CLIENT_OK) {
-        int64_t now_us = esp_timer_get_time();
-        RT_ERROR(&g_bg_log_stream, now_us, "CWNet: client init failed: %d", err);
-        s_ctx.enabled = false;
-        return;
+    /* Sessions stay where they are from here on */
+    size_t grouped = 0;
+    FOR_EACH_SESSION(s) {
+        if (s->grouped && grouped < 2) {
+            s_ctx.group[grouped++] = s;
+        }
+        start_session(s);
     }
+    if (grouped < 2) {
+        s_ctx.group[0] = NULL;
+        s_ctx.group[1] = NULL;
+    }
+    s_ctx.round_us = esp_timer_get_time();
+}
 
-    int64_t now_us = esp_timer_get_time();
-    RT_INFO(&g_bg_log_stream, now_us, "CWNet: initialized, server=%s:%u user=%s",
-            s_ctx.host, s_ctx.port, s_ctx.username);
+/**
+ * @brief Keep the stream's network clock on the main session's estimate
+ *
+ * Republished whenever the sync filter moves the timer, withdrawn when no
+ * session is READY: another server is another clock.
+ */
+static void publish_net_clock(int64_t now_us) {
+    const cwnet_session_t *s = main_session();
+    if (s == NULL || s->state != CWNET_SOCK_READY || s->client.sync.count == 0) {
+        if (s_ctx.net_owner != NULL) {
+            stream_clear_net_clock(&g_keying_stream);
+            s_ctx.net_owner = NULL;
+        }
+        return;
+    }
+    const cwnet_timer_t *t = &s->client.timer;
+    if (s == s_ctx.net_owner && t->offset_ms == s_ctx.net_timer.offset_ms &&
+        t->ref_local_ms == s_ctx.net_timer.ref_local_ms &&
+        t->drift_ppm == s_ctx.net_timer.drift_ppm) {
+        return;
+    }
 
-    s_ctx.state = CWNET_SOCK_DISCONNECTED;
+    /* Reference: the LOCAL tick running now */
+    uint32_t period = stream_tick_period_us(&g_keying_stream);
+    int64_t since_epoch = now_us - stream_epoch_us(&g_keying_stream);
+    uint64_t tick = (since_epoch > 0) ? (uint64_t)since_epoch / period : 0U;
+    int64_t tick_us = stream_epoch_us(&g_keying_stream) + (int64_t)(tick * period);
+    stream_set_net_clock(&g_keying_stream, tick, cwnet_timer_synced_us(t, tick_us),
+                         t->drift_ppm);
+    s_ctx.net_owner = s;
+    s_ctx.net_timer = *t;
 }
 
 void cwnet_socket_process(void) {
     if (!s_ctx.enabled) {
         return;
     }
+    cwnet_capture_enable(&g_cwnet_capture, CONFIG_GET_CWNET_CAPTURE());
 
     int64_t now_us = esp_timer_get_time();
+    FOR_EACH_SESSION(s) {
+        process_session(s, now_us);
+    }
+    process_failover(now_us);
 
-    switch (s_ctx.state) {
-        case CWNET_SOCK_DISABLED:
-            /* Nothing to do */
-            break;
-
-        case CWNET_SOCK_DISCONNECTED:
-            /* Start connection attempt */
-            start_connect();
-            break;
+    publish_net_clock(now_us);
 
-        case CWNET_SOCK_RESOLVING:
-            /* DNS is blocking in start_connect, shouldn't reach here */
-            break;
+    /* LAN peer runs beside the server sessions */
+    process_peer();
 
-        case CWNET_SOCK_CONNECTING:
-            /* Check if connect completed */
-            check_connect_complete();
-            break;
+    /* Forward local key edges, then publish received ones that are due */
+    forward_key_edges();
+    play_remote_events();
 
-        case CWNET_SOCK_CONNECTED:
-        case CWNET_SOCK_READY:
-            /* Process incoming data */
-            process_recv();
+    /* One send() per session for everything queued this pass (or held for coalescing) */
+    now_us = esp_timer_get_time();
+    FOR_EACH_SESSION(s) {
+        flush_tx(s, now_us, false);
+    }
+}
 
-            /* Update state from client */
-            if (cwnet_client_get_state(&s_ctx.client) == CWNET_STATE_READY) {
-                s_ctx.state = CWNET_SOCK_READY;
-            }
-            break;
+bool cwnet_socket_send_key_event(bool key_down) {
+    bool sent = false;
+    FOR_EACH_SESSION(s) {
+        if (s->state == CWNET_SOCK_READY && !s->standby &&
+            cwnet_client_send_key_event(&s->client, key_down) == CWNET_CLIENT_OK) {
+            RT_DEBUG(&g_bg_log_stream, esp_timer_get_time(), "%s TX: %s",
+                     s->tag, key_down ? "DOWN" : "UP");
+            sent = true;
+        }
+    }
+    return sent;
+}
 
-        case CWNET_SOCK_ERROR:
-            /* Wait before reconnecting */
-            if ((now_us - s_ctx.last_attempt_us) > (RECONNECT_DELAY_MS * 1000LL)) {
-                RT_INFO(&g_bg_log_stream, now_us, "CWNet: reconnecting...");
-                s_ctx.state = CWNET_SOCK_DISCONNECTED;
-            }
-            break;
+bool cwnet_socket_send_key_event_at(bool key_down, int64_t event_us) {
+    /* Highest priority first: its send() is not held behind the others */
+    bool sent = false;
+    FOR_EACH_SESSION(s) {
+        sent |= session_send_edge(s, key_down, event_us);
     }
+    return sent;
 }
 
-bool cwnet_socket_send_key_event(bool key_down) {
-    if (s_ctx.state != CWNET_SOCK_READY) {
-        return false;
+void cwnet_task(void *arg) {
+    (void)arg;
+
+    cwnet_socket_init();
+    if (!s_ctx.enabled) {
+        vTaskDelete(NULL);
+        return;
     }
 
-    cwnet_client_err_t err = cwnet_client_send_key_event(&s_ctx.client, key_down);
-    if (err == CWNET_CLIENT_OK) {
-        int64_t now_us = esp_timer_get_time();
-        RT_DEBUG(&g_bg_log_stream, now_us, "CWNet TX: %s", key_down ? "DOWN" : "UP");
-        return true;
+    for (;;) {
+        cwnet_socket_process();
+        wait_for_io();
     }
-    return false;
 }
 
 cwnet_socket_state_t cwnet_socket_get_state(void) {
-    return s_ctx.state;
+    const cwnet_session_t *s = main_session();
+    return (s != NULL) ? s->state : CWNET_SOCK_DISABLED;
 }
 
 bool cwnet_socket_is_ready(void) {
-    return s_ctx.state == CWNET_SOCK_READY;
+    return cwnet_socket_get_state() == CWNET_SOCK_READY;
 }
 
 int32_t cwnet_socket_get_latency_ms(void) {
-    return cwnet_client_get_latency_ms(&s_ctx.client);
+    const cwnet_session_t *s = main_session();
+    return (s != NULL) ? cwnet_client_get_latency_ms(&s->client) : -1;
+}
+
+size_t cwnet_socket_session_count(void) {
+    return s_ctx.session_count;
+}
+
+bool cwnet_socket_get_session(size_t index, cwnet_session_info_t *out) {
+    if (index >= s_ctx.session_count || out == NULL) {
+        return false;
+    }
+    cwnet_session_t *s = &s_ctx.sessions[index];
+    out->host = s->host;
+    out->port = s->port;
+    out->slot = s->slot;
+    out->priority = s->priority;
+    out->state = s->state;
+    out->latency_ms = cwnet_client_get_latency_ms(&s->client);
+    out->udp = (s->udp_sock >= 0);
+    out->rx_owner = (s == main_session() && s->state == CWNET_SOCK_READY);
+    out->rx_ignored = s->rx_ignored;
+    out->standby = s->standby;
+    cwnet_latency_get(&s->latency, &out->edge_latency);
+    return true;
+}
+
+uint32_t cwnet_socket_get_failovers(void) {
+    return atomic_load_explicit(&s_ctx.failovers, memory_order_relaxed);
+}
+
+bool cwnet_socket_get_peer(const char **name, int32_t *rtt_ms) {
+    if (cwnet_peer_get_state(&s_ctx.peer) != CWNET_PEER_READY) {
+        return false;
+    }
+    if (name != NULL) {
+        *name = s_ctx.peer.name;
+    }
+    if (rtt_ms != NULL) {
+        *rtt_ms = cwnet_peer_get_latency_ms(&s_ctx.peer);
+    }
+    return true;
+}
+
+void cwnet_socket_get_audio_stats(cwnet_audio_dec_t *out, uint32_t *overflow) {
+    const cwnet_session_t *s = main_session();
+    if (s != NULL) {
+        *out = s->audio;
+    } else {
+        memset(out, 0, sizeof(*out));
+    }
+    if (overflow != NULL) {
+        *overflow = s_ctx.audio_overflow;
+    }
+}
+
+void cwnet_socket_get_sync_stats(cwnet_sync_stats_t *out) {
+    const cwnet_session_t *s = main_session();
+    if (s != NULL) {
+        cwnet_client_get_sync_stats(&s->client, out);
+    } else {
+        memset(out, 0, sizeof(*out));
+        out->rtt_ms = -1;
+    }
+}
+
+void cwnet_socket_get_edge_latency(cwnet_latency_snapshot_t *out) {
+    cwnet_session_t *s = main_session();
+    if (s != NULL) {
+        cwnet_latency_get(&s->latency, out);
+    } else {
+        memset(out, 0, sizeof(*out));
+    }
+}
+
+int32_t cwnet_socket_get_rx_margin_ms(void) {
+    return cwnet_jitter_margin_ms(&s_ctx.rx_jitter);
+}
+
+int32_t cwnet_socket_get_rx_delay_ms(void) {
+    return cwnet_jitter_delay_ms(&s_ctx.rx_jitter);
+}
+
+uint32_t cwnet_socket_get_rx_late(void) {
+    return s_ctx.rx_jitter.late;
 }
 
 const char *cwnet_socket_state_str(cwnet_socket_state_t state) {
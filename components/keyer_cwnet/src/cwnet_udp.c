@@ -0,0 +1,197 @@
+/**
+ * @file cwnet_udp.c
+ * @brief CWNet key edge datagrams implementation
+ */
+
+#include "cwnet_udp.h"
+#include "cwnet_client.h"
+#include "cwnet_frame.h"
+#include <string.h>
+
+#define UDP_WINDOW_MASK (CWNET_UDP_WINDOW - 1U)
+
+_Static_assert((CWNET_UDP_WINDOW & (CWNET_UDP_WINDOW - 1)) == 0,
+               "CWNET_UDP_WINDOW must be power of 2");
+
+/** Append a short frame with a 4-byte little-endian payload */
+static size_t put_frame32(uint8_t *out, cwnet_cmd_t cmd, uint32_t value) {
+    out[0] = (uint8_t)((CWNET_FRAME_CAT_SHORT_PAYLOAD << 6) | (cmd & 0x3F));
+    out[1] = 4;
+    out[2] = (uint8_t)(value & 0xFF);
+    out[3] = (uint8_t)((value >> 8) & 0xFF);
+    out[4] = (uint8_t)((value >> 16) & 0xFF);
+    out[5] = (uint8_t)((value >> 24) & 0xFF);
+    return 6;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*===========================================================================*/
+/* Sender                                                                    */
+/*===========================================================================*/
+
+void cwnet_udp_tx_init(cwnet_udp_tx_t *tx) {
+    if (tx == NULL) {
+        return;
+    }
+    memset(tx, 0, sizeof(*tx));
+}
+
+size_t cwnet_udp_tx_build(cwnet_udp_tx_t *tx, bool key_down, int32_t timestamp_ms,
+                          uint8_t *out, size_t cap) {
+    if (tx == NULL || out == NULL) {
+        return 0;
+    }
+
+    uint32_t newest = tx->seq;
+    uint32_t count = (newest + 1U < CWNET_UDP_REDUNDANCY) ? newest + 1U : CWNET_UDP_REDUNDANCY;
+    if (cap < 6U * (1U + count)) {
+        return 0;
+    }
+
+    tx->recent[newest % CWNET_UDP_REDUNDANCY] = (cwnet_udp_edge_t){
+        .timestamp_ms = timestamp_ms,
+        .key_down = key_down
+    };
+    tx->seq++;
+
+    size_t len = put_frame32(out, CWNET_CMD_SEQ, newest);
+    for (uint32_t i = 0; i < count; i++) {
+        const cwnet_udp_edge_t *e = &tx->recent[(newest - (count - 1U) + i) % CWNET_UDP_REDUNDANCY];
+        len += put_frame32(&out[len], e->key_down ? CWNET_CMD_CW_DOWN : CWNET_CMD_CW_UP,
+                           (uint32_t)e->timestamp_ms);
+    }
+    return len;
+}
+
+/*===========================================================================*/
+/* Receiver                                                                  */
+/*===========================================================================*/
+
+void cwnet_udp_rx_init(cwnet_udp_rx_t *rx) {
+    if (rx == NULL) {
+        return;
+    }
+    memset(rx, 0, sizeof(*rx));
+}
+
+/** Store one edge by sequence number */
+static void rx_store(cwnet_udp_rx_t *rx, uint32_t seq, const cwnet_udp_edge_t *e) {
+    uint32_t ahead = seq - rx->next_seq;
+    if ((int32_t)ahead < 0) {
+        rx->duplicates++;   /* Already delivered or given up */
+        return;
+    }
+    uint32_t idx = seq & UDP_WINDOW_MASK;
+    if (rx->present[idx]) {
+        rx->duplicates++;
+        return;
+    }
+    rx->slots[idx] = *e;
+    rx->present[idx] = true;
+    rx->pending++;
+}
+
+bool cwnet_udp_rx_push(cwnet_udp_rx_t *rx, const uint8_t *data, size_t len, int32_t now_ms) {
+    (void)now_ms;
+    if (rx == NULL || data == NULL) {
+        return false;
+    }
+
+    /* Datagrams are atomic: walk its frames in place, SEQ first */
+    cwnet_udp_edge_t edges[CWNET_UDP_REDUNDANCY];
+    uint32_t count = 0;
+    uint32_t newest = 0;
+    bool have_seq = false;
+    size_t pos = 0;
+
+    while (pos < len) {
+        if (pos + 6 > len || data[pos + 1] != 4 ||
+            cwnet_frame_get_category(data[pos]) != CWNET_FRAME_CAT_SHORT_PAYLOAD) {
+            rx->malformed++;
+            return false;
+        }
+        uint8_t cmd = cwnet_frame_get_command(data[pos]);
+        uint32_t value = get_u32(&data[pos + 2]);
+        pos += 6;
+
+        if (!have_seq) {
+            if (cmd != CWNET_CMD_SEQ) {
+                rx->malformed++;
+                return false;
+            }
+            newest = value;
+            have_seq = true;
+        } else if ((cmd == CWNET_CMD_CW_DOWN || cmd == CWNET_CMD_CW_UP) &&
+                   count < CWNET_UDP_REDUNDANCY) {
+            edges[count++] = (cwnet_udp_edge_t){
+                .timestamp_ms = (int32_t)value,
+                .key_down = (cmd == CWNET_CMD_CW_DOWN)
+            };
+        } else {
+            rx->malformed++;
+            return false;
+        }
+    }
+    if (!have_seq || count == 0) {
+        rx->malformed++;
+        return false;
+    }
+
+    uint32_t oldest = newest - (count - 1U);
+
+    /* First datagram, or so far ahead the window can not bridge the gap */
+    if (!rx->started || (int32_t)(newest - rx->next_seq) >= (int32_t)CWNET_UDP_WINDOW) {
+        if (rx->started) {
+            rx->lost += oldest - rx->next_seq;  /* Buffered ones included */
+        }
+        memset(rx->present, 0, sizeof(rx->present));
+        rx->pending = 0;
+        rx->next_seq = oldest;
+        rx->gap_open = false;
+        rx->started = true;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        rx_store(rx, oldest + i, &edges[i]);
+    }
+    return true;
+}
+
+bool cwnet_udp_rx_pop(cwnet_udp_rx_t *rx, int32_t now_ms, cwnet_udp_edge_t *out) {
+    if (rx == NULL || out == NULL || rx->pending == 0) {
+        if (rx != NULL) {
+            rx->gap_open = false;
+        }
+        return false;
+    }
+
+    uint32_t idx = rx->next_seq & UDP_WINDOW_MASK;
+    if (!rx->present[idx]) {
+        /* A later edge is here but next_seq is not: wait, then skip */
+        if (!rx->gap_open) {
+            rx->gap_open = true;
+            rx->gap_since_ms = now_ms;
+            return false;
+        }
+        if ((int32_t)(now_ms - rx->gap_since_ms) < CWNET_UDP_HOLD_MS) {
+            return false;
+        }
+        while (!rx->present[rx->next_seq & UDP_WINDOW_MASK]) {
+            rx->next_seq++;
+            rx->lost++;
+        }
+        idx = rx->next_seq & UDP_WINDOW_MASK;
+    }
+
+    *out = rx->slots[idx];
+    rx->present[idx] = false;
+    rx->pending--;
+    rx->next_seq++;
+    rx->gap_open = false;
+    rx->delivered++;
+    return true;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file audio_rx.h
+ * @brief Off-air decoding: receiver audio → tone detector → decoder channel
+ *
+ * Architecture:
+ *   codec ADC (I2S RX) → tone_detector → key_edge_ring (own) → decoder_t
+ *
+ * The pipeline owns a private key edge ring that only the tone detector
+ * feeds (channel KEY), and a decoder channel on it. Sample positions are
+ * mapped onto LOCAL stream ticks from the moment audio_rx_init() is
+ * called, so decoded characters carry esp_timer-based timestamps like the
+ * other channels.
+ *
+ * Each audio_rx_process() call is timed; the cost is compared with a
+ * budget of AUDIO_RX_BUDGET_PCT of the audio it covered, so the Core 1
+ * share of the detector is visible (console `decoder rx`).
+ *
+ * Single task: the audio RX task calls init and process. Console reads
+ * the decoder and stats like it reads the default channel.
+ */
+
+#ifndef KEYER_AUDIO_RX_H
+#define KEYER_AUDIO_RX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "tone_detector.h"
+#include "key_edge.h"
+#include "decoder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Core 1 share allowed for detection + decoding, % of the audio duration */
+#define AUDIO_RX_BUDGET_PCT 10U
+
+/**
+ * @brief Processing cost counters
+ */
+typedef struct {
+    uint32_t calls;            /**< audio_rx_process() calls */
+    uint32_t samples;          /**< Samples processed (wraps) */
+    uint32_t block_us_last;    /**< Cost of the last call */
+    uint32_t block_us_max;     /**< Worst call */
+    uint32_t block_us_avg;     /**< Moving average (1/16) */
+    uint32_t budget_us;        /**< Budget of the last call */
+    uint32_t over_budget;      /**< Calls that exceeded their budget */
+} audio_rx_stats_t;
+
+/**
+ * @brief Off-air decoding pipeline
+ */
+typedef struct {
+    tone_detector_t detector;  /**< Goertzel bank + threshold */
+    key_edge_ring_t ring;      /**< Tone edges (this pipeline only) */
+    decoder_t decoder;         /**< Decoder channel on ring */
+    uint64_t start_tick;       /**< Stream tick of sample 0 */
+    uint32_t tick_us;          /**< Stream tick period */
+    audio_rx_stats_t stats;    /**< Cost counters */
+} audio_rx_t;
+
+/**
+ * @brief Initialize the pipeline; sample 0 is "now"
+ *
+ * @param rx Pipeline
+ * @param stream Keying stream (tick period and epoch for timestamps)
+ * @param config Tone band and block size
+ * @param now_us esp_timer time of the first sample
+ */
+void audio_rx_init(audio_rx_t *rx, const keying_stream_t *stream,
+                   const tone_detector_config_t *config, int64_t now_us);
+
+/**
+ * @brief Detect, publish edges and decode one batch of samples
+ *
+ * @param rx Pipeline
+ * @param samples Mono 16-bit audio
+ * @param count Number of samples
+ */
+void audio_rx_process(audio_rx_t *rx, const int16_t *samples, size_t count);
+
+/** Decoder channel fed by the pipeline */
+static inline decoder_t *audio_rx_decoder(audio_rx_t *rx) {
+    return &rx->decoder;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_AUDIO_RX_H */
@@ -2,11 +2,18 @@
  * @file decoder.h
  * @brief CW Morse decoder - converts keying stream to text
  *
- * Best-effort consumer on Core 1. Reads mark/space transitions from
- * keying_stream_t, classifies timing, decodes patterns to characters.
+ * Best-effort reader on Core 1. Takes mark/space transitions from the
+ * shared key edge ring, classifies timing, decodes patterns to characters.
+ * Work is per edge, and every duration (including the inactivity timeout)
+ * is measured in stream ticks, so Core 1 scheduling lag never skews it.
  *
  * Architecture:
- *   keying_stream_t → decoder_consumer → timing_classifier → pattern_decoder → text buffer
+ *   keying_stream_t → key_edge_stage → key_edge_ring → timing_classifier → pattern_decoder → text buffer
+ *
+ * Each decoder_t is one channel with its own edge reader, timing classifier,
+ * pattern and text ring, so several sources (local keyer, paddles, remote
+ * RX) can be decoded at once. The decoder_*() functions without an
+ * instance argument drive the default channel (DECODER_SOURCE_ANY).
  */
 
 #ifndef KEYER_DECODER_H
@@ -15,7 +22,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdatomic.h>
 #include "timing_classifier.h"
+#include "morse_table.h"
+#include "key_edge.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,27 +58,133 @@ typedef struct {
     uint32_t chars_decoded;     /**< Total characters decoded */
     uint32_t words_decoded;     /**< Total words decoded (spaces) */
     uint32_t errors;            /**< Unrecognized patterns */
-    uint32_t samples_processed; /**< Stream samples processed */
-    uint32_t samples_dropped;   /**< Samples dropped (lag) */
+    uint32_t edges_processed;   /**< Key edges read */
+    uint32_t edges_dropped;     /**< Edges lost to ring overwrite (lag) */
+    uint32_t tagged_events;     /**< Events taken from keyer tags, not classified */
 } decoder_stats_t;
 
+/** Decoded text ring size per decoder */
+#define DECODER_BUFFER_SIZE 128
+
+/**
+ * @brief Which key a decoder channel listens to
+ */
+typedef enum {
+    DECODER_SOURCE_ANY = 0,    /**< Keyer output or remote RX, whichever is down */
+    DECODER_SOURCE_LOCAL_KEY,  /**< Local keyer output (LOCAL lane local_key) */
+    DECODER_SOURCE_GPIO,       /**< Raw paddles (LOCAL lane, either contact) */
+    DECODER_SOURCE_REMOTE,     /**< Remote RX (REMOTE lane key events) */
+} decoder_source_t;
+
+/**
+ * @brief One decoder channel (all state explicit, single task)
+ */
+typedef struct {
+    decoder_source_t source;        /**< Key this channel decodes */
+    key_edge_reader_t edges;        /**< Edge ring reader */
+    bool reader_initialized;        /**< edges attached to a ring */
+    atomic_bool enabled;            /**< Processing on/off */
+    timing_classifier_t timing;     /**< Speed tracking */
+    decoder_state_t state;          /**< IDLE / RECEIVING */
+    morse_code_t pattern;           /**< Pattern being accumulated */
+    morse_code_t last_pattern;      /**< Last finalized pattern (display) */
+
+    decoded_char_t buffer[DECODER_BUFFER_SIZE]; /**< Decoded text ring */
+    size_t buffer_head;             /**< Next write position */
+    size_t buffer_count;            /**< Characters in ring */
+    size_t buffer_read;             /**< Next pop position */
+
+    int64_t last_edge_us;           /**< Stream time of the last edge */
+    bool last_was_mark;             /**< Key level since last edge */
+    uint8_t mark_tag;               /**< Keyer tag of the latest mark (KEY_TAG_*) */
+    uint8_t levels[KEY_EDGE_CH_COUNT]; /**< Level of every edge channel */
+    uint64_t last_edge_tick;        /**< Tick of the last classified edge */
+    int64_t edge_time_us;           /**< Stream time of the latest edge read */
+    decoder_stats_t stats;          /**< Counters */
+} decoder_t;
+
 /* ============================================================================
- * Public API
+ * Instance API
+ * ============================================================================ */
+
+/**
+ * @brief Initialize a decoder channel on an edge ring
+ *
+ * Reads from the ring's current position; the stage feeding the ring
+ * runs elsewhere (bg_task).
+ *
+ * @param dec Decoder to initialize (enabled on return)
+ * @param ring Edges to decode (NULL = events only, see decoder_inst_handle_event)
+ * @param source Key to decode
+ */
+void decoder_inst_init(decoder_t *dec, const key_edge_ring_t *ring, decoder_source_t source);
+
+/** Drain pending edges (non-blocking); see decoder_process() */
+void decoder_inst_process(decoder_t *dec);
+
+/** Clear text and pattern, reset timing; keeps ring and source */
+void decoder_inst_reset(decoder_t *dec);
+
+/** Feed a classified key event directly */
+void decoder_inst_handle_event(decoder_t *dec, key_event_t event, int64_t timestamp_us);
+
+/** Enable/disable processing */
+void decoder_inst_set_enabled(decoder_t *dec, bool enabled);
+
+/** Check if processing is enabled */
+bool decoder_inst_is_enabled(const decoder_t *dec);
+
+/** Select the timing classifier algorithm (restarts speed learning) */
+void decoder_inst_set_timing_mode(decoder_t *dec, timing_mode_t mode);
+
+/** Most recent decoded text, see decoder_get_text() */
+size_t decoder_inst_get_text(const decoder_t *dec, char *buf, size_t max_len);
+
+/** Decoded text with timestamps, see decoder_get_text_with_timestamps() */
+size_t decoder_inst_get_text_with_timestamps(const decoder_t *dec, decoded_char_t *buf,
+                                             size_t max_count);
+
+/** Last decoded character (character='\0' if none) */
+decoded_char_t decoder_inst_get_last_char(const decoder_t *dec);
+
+/** Next unread character, FIFO (character='\0' if none) */
+decoded_char_t decoder_inst_pop_char(decoder_t *dec);
+
+/** Pattern being accumulated, else the last finalized one */
+size_t decoder_inst_get_current_pattern(const decoder_t *dec, char *buf, size_t max_len);
+
+/** Detected WPM (0 if not calibrated) */
+static inline uint32_t decoder_inst_get_wpm(const decoder_t *dec) {
+    return timing_classifier_get_wpm(&dec->timing);
+}
+
+/** Characters held in the text ring */
+static inline size_t decoder_inst_get_buffer_count(const decoder_t *dec) {
+    return dec->buffer_count;
+}
+
+/**
+ * @brief The default channel behind the decoder_*() API
+ */
+decoder_t *decoder_default(void);
+
+/* ============================================================================
+ * Default channel API
  * ============================================================================ */
 
 /**
  * @brief Initialize decoder
  *
  * Call from main() before starting bg_task.
- * Registers as best-effort consumer on keying_stream.
+ * Subscribes to the shared key edge ring (g_key_edge_ring).
  */
 void decoder_init(void);
 
 /**
- * @brief Process samples from stream
+ * @brief Process new key edges
  *
- * Call periodically from bg_task (e.g., every 10ms).
- * Non-blocking, processes all available samples.
+ * Call periodically from bg_task (e.g., every 10ms), after the edge
+ * stage has run. Non-blocking, processes all available edges.
  */
 void decoder_process(void);
 
@@ -159,6 +275,15 @@ void decoder_get_stats(decoder_stats_t *stats);
  */
 const timing_classifier_t *decoder_get_timing(void);
 
+/**
+ * @brief Select the timing classifier algorithm
+ *
+ * Kept across decoder_reset().
+ *
+ * @param mode TIMING_MODE_EMA (default) or TIMING_MODE_CLUSTER
+ */
+void decoder_set_timing_mode(timing_mode_t mode);
+
 /**
  * @brief Reset decoder state
  *
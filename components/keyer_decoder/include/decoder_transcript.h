@@ -0,0 +1,126 @@
+/**
+ * @file decoder_transcript.h
+ * @brief Long decoded-text history with sequence numbers (incremental sync)
+ *
+ * The decoder's own text ring (DECODER_BUFFER_SIZE) only holds what the
+ * display pops next. The transcript keeps the last TRANSCRIPT_CAPACITY
+ * characters (PSRAM on target), each numbered by a monotonic sequence
+ * number, plus the word number it belongs to. Clients remember the last
+ * sequence they saw and fetch only what follows (GET /api/decoder/text?
+ * since=N), so a reconnecting page resumes instead of starting blank.
+ *
+ * Single writer (bg task), any number of readers in other tasks. A reader
+ * that asks for characters already overwritten gets the oldest retained
+ * ones and can tell from first_seq that it missed some.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block (readers re-check, never lock)
+ */
+
+#ifndef KEYER_DECODER_TRANSCRIPT_H
+#define KEYER_DECODER_TRANSCRIPT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Characters retained (MUST be power of 2; 8 bytes each = 64 KB, 8 KB
+ *  without PSRAM) */
+#ifdef CONFIG_KEYER_INTERNAL_RAM_ONLY
+#define TRANSCRIPT_CAPACITY 1024
+#else
+#define TRANSCRIPT_CAPACITY 8192
+#endif
+
+/**
+ * @brief One transcript character
+ */
+typedef struct {
+    uint32_t word;       /**< Word number (spaces before it) */
+    char character;      /**< ASCII character or ' ' */
+    uint8_t wpm;         /**< Decoder speed when it was decoded */
+} transcript_entry_t;
+
+/**
+ * @brief Transcript ring
+ */
+typedef struct {
+    transcript_entry_t buffer[TRANSCRIPT_CAPACITY]; /**< Character storage */
+    atomic_uint_least32_t head_seq;  /**< Sequence of the next character (monotonic) */
+    atomic_uint_least32_t words;     /**< Words completed (spaces appended) */
+} transcript_t;
+
+/**
+ * @brief Result of a transcript read
+ */
+typedef struct {
+    uint32_t first_seq;   /**< Sequence of the first character returned */
+    uint32_t next_seq;    /**< Sequence to ask for next time */
+    uint32_t head_seq;    /**< Sequence of the next character to be decoded */
+    uint32_t first_word;  /**< Word number of the first character returned */
+    size_t count;         /**< Characters returned */
+} transcript_slice_t;
+
+/**
+ * @brief Initialize an empty transcript (sequence numbers start at 0)
+ *
+ * @param t Transcript to initialize
+ */
+void transcript_init(transcript_t *t);
+
+/**
+ * @brief Append one decoded character (single writer)
+ *
+ * @param t Transcript
+ * @param c Character (' ' ends a word)
+ * @param wpm Decoder speed
+ * @return Sequence number given to the character
+ */
+uint32_t transcript_append(transcript_t *t, char c, uint8_t wpm);
+
+/**
+ * @brief Sequence number the next appended character will get
+ */
+static inline uint32_t transcript_head(const transcript_t *t) {
+    return atomic_load_explicit(&t->head_seq, memory_order_acquire);
+}
+
+/**
+ * @brief Words completed so far
+ */
+static inline uint32_t transcript_words(const transcript_t *t) {
+    return atomic_load_explicit(&t->words, memory_order_relaxed);
+}
+
+/**
+ * @brief Copy characters from sequence number `since` on
+ *
+ * Starts at the oldest retained character if `since` was already
+ * overwritten, and also when `since` is ahead of the head (the keyer
+ * restarted under the client). Safe against a concurrent writer.
+ *
+ * @param t Transcript
+ * @param since First sequence number wanted
+ * @param out Characters (not NUL-terminated)
+ * @param max Capacity of out
+ * @param slice Filled with the sequence numbers of what was copied
+ * @return Characters copied (slice->count)
+ */
+size_t transcript_read(const transcript_t *t, uint32_t since, char *out, size_t max,
+                       transcript_slice_t *slice);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_DECODER_TRANSCRIPT_H */
@@ -2,23 +2,104 @@
  * @file morse_table.h
  * @brief ITU Morse code pattern to character lookup
  *
- * Static lookup table for decoding morse patterns (e.g., ".-" -> 'A').
- * Uses linear search over ~50 entries (<5us lookup time).
+ * Static lookup tables for decoding morse patterns (e.g., ".-" -> 'A'),
+ * generated at build time from morse_alphabet.yaml (scripts/gen_morse_tables.py).
+ * Patterns are handled as morse_code_t bit codes: decode and encode are a
+ * single array index, building a pattern is a shift-and-or. The string
+ * API is kept for display and for callers that already hold text.
  */
 
 #ifndef KEYER_MORSE_TABLE_H
 #define KEYER_MORSE_TABLE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Pattern codes
+ * ============================================================================ */
+
+/** Longest pattern a code holds (the 8-dot error signal) */
+#define MORSE_MAX_ELEMENTS 8
+
+/**
+ * @brief Morse pattern as (length, bits) in one integer
+ *
+ * A start bit followed by one bit per element, first element highest:
+ * dit = 0, dah = 1. The start bit position is the length.
+ *   ""  = 0x001, "." = 0x002, "-" = 0x003, ".-" = 0x005, "-..." = 0x018
+ */
+typedef uint16_t morse_code_t;
+
+/** Code of the empty pattern (start of a character) */
+#define MORSE_CODE_EMPTY   ((morse_code_t)0x001)
+
+/** Not a pattern (parse failure, unknown character) */
+#define MORSE_CODE_INVALID ((morse_code_t)0x000)
+
+/** Codes are below this (size of the direct decode table) */
+#define MORSE_CODE_LIMIT   (1U << (MORSE_MAX_ELEMENTS + 1))
+
+/** Append one element */
+static inline morse_code_t morse_code_push(morse_code_t code, bool dah) {
+    return (morse_code_t)((unsigned)(code << 1) | (dah ? 1U : 0U));
+}
+
+/** Number of elements (0 for empty or invalid) */
+static inline unsigned morse_code_len(morse_code_t code) {
+    return (code != 0) ? (unsigned)(31 - __builtin_clz((unsigned)code)) : 0U;
+}
+
+/**
+ * @brief Decode a code to its character
+ *
+ * @return Character, or '\0' if the pattern has none
+ */
+char morse_code_decode(morse_code_t code);
+
+/**
+ * @brief Code for a character (lowercase folded)
+ *
+ * @return Code, or MORSE_CODE_INVALID if the character has no pattern
+ */
+morse_code_t morse_code_encode(char c);
+
+/**
+ * @brief Parse a '.'/'-' string
+ *
+ * @return Code, or MORSE_CODE_INVALID for other characters or more than
+ *         MORSE_MAX_ELEMENTS elements
+ */
+morse_code_t morse_code_from_string(const char *pattern);
+
+/**
+ * @brief Render a code as a '.'/'-' string
+ *
+ * @param code Pattern code
+ * @param buf Output buffer (always terminated)
+ * @param size Buffer size
+ * @return Characters written (truncated to size - 1)
+ */
+size_t morse_code_to_string(morse_code_t code, char *buf, size_t size);
+
+/**
+ * @brief Prosign display tag for a code (e.g. "<SK>"), NULL if none
+ */
+const char *morse_code_prosign_tag(morse_code_t code);
+
+/* ============================================================================
+ * String API
+ * ============================================================================ */
+
 /**
  * @brief Lookup character for a morse pattern
  *
- * @param pattern Null-terminated string of '.' and '-' (max 6 chars)
+ * @param pattern Null-terminated string of '.' and '-' (max 8 chars)
  * @return Decoded character, or '\0' if pattern not found
  *
  * Example:
@@ -61,6 +142,15 @@ unsigned morse_table_count(void);
  */
 size_t morse_match_prosign(const char *text, const char **pattern_out);
 
+/**
+ * @brief morse_match_prosign() returning the pattern as a code
+ *
+ * @param text Text to check
+ * @param code_out Output: code if prosign found (can be NULL)
+ * @return Length of prosign tag if found, 0 otherwise
+ */
+size_t morse_match_prosign_code(const char *text, morse_code_t *code_out);
+
 /**
  * @brief Get prosign display name for pattern
  *
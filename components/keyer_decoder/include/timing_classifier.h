@@ -4,6 +4,13 @@
  *
  * Uses EMA (Exponential Moving Average) to learn operator's speed.
  * Classifies marks (dit/dah) and spaces (intra/char/word gap).
+ *
+ * TIMING_MODE_CLUSTER instead keeps fixed-point log2-duration histograms
+ * of the last TIMING_HIST_WINDOW marks and spaces and splits them into
+ * 2 (dit/dah) and 3 (element/char/word gap) clusters. Each event moves a
+ * split by at most TIMING_HIST_MAX_STEPS bins, so the cost per event is
+ * bounded; it follows speed changes and heavy weighting the fixed 25%
+ * tolerance cannot.
  */
 
 #ifndef KEYER_TIMING_CLASSIFIER_H
@@ -36,6 +43,46 @@ typedef enum {
  * Timing Classifier State
  * ============================================================================ */
 
+/**
+ * @brief Classification algorithm
+ */
+typedef enum {
+    TIMING_MODE_EMA = 0,      /**< Dit/dah EMA, fixed tolerance (default) */
+    TIMING_MODE_CLUSTER = 1,  /**< Sliding log-duration histograms, cluster split */
+} timing_mode_t;
+
+/** Histogram bins per octave (fixed-point log2, Q4) */
+#define TIMING_HIST_BINS_PER_OCTAVE 16
+
+/** Histogram bins: 2^12 us (4 ms) to 2^24 us (16 s) */
+#define TIMING_HIST_BINS (12 * TIMING_HIST_BINS_PER_OCTAVE)
+
+/** Events per histogram window */
+#define TIMING_HIST_WINDOW 32
+
+/** Most bins a split moves per event */
+#define TIMING_HIST_MAX_STEPS 8
+
+/** Most clusters per histogram (spaces) */
+#define TIMING_HIST_MAX_CLUSTERS 3
+
+/**
+ * @brief Sliding-window log-duration histogram split into clusters
+ *
+ * Bin b holds durations of about 2^(12 + b/16) us. Cluster k holds the
+ * bins from split[k-1] up to split[k] - 1.
+ */
+typedef struct {
+    uint8_t counts[TIMING_HIST_BINS];     /**< Windowed events per bin */
+    uint8_t window[TIMING_HIST_WINDOW];   /**< Bin of each windowed event (ring) */
+    uint8_t head;                         /**< Next window slot */
+    uint8_t filled;                       /**< Events in window */
+    uint8_t clusters;                     /**< 2 (marks) or 3 (spaces) */
+    uint8_t split[TIMING_HIST_MAX_CLUSTERS - 1]; /**< First bin of the next cluster */
+    uint16_t n[TIMING_HIST_MAX_CLUSTERS];        /**< Events per cluster */
+    uint32_t sum[TIMING_HIST_MAX_CLUSTERS];      /**< Sum of bins per cluster */
+} timing_hist_t;
+
 /**
  * @brief Timing classifier state
  *
@@ -50,6 +97,9 @@ typedef struct {
     uint32_t warmup_count;  /**< Events until calibrated */
     float tolerance_pct;    /**< Tolerance +/- % (default 25) */
     float ema_alpha;        /**< EMA smoothing factor (default 0.3) */
+    timing_mode_t mode;     /**< Classification algorithm */
+    timing_hist_t marks;    /**< CLUSTER: dit/dah histogram */
+    timing_hist_t spaces;   /**< CLUSTER: intra/char/word gap histogram */
 } timing_classifier_t;
 
 /* ============================================================================
@@ -69,6 +119,8 @@ void timing_classifier_init(timing_classifier_t *tc, float initial_wpm);
 /**
  * @brief Reset classifier to initial state
  *
+ * Keeps the classification mode.
+ *
  * @param tc Classifier to reset
  * @param initial_wpm Initial WPM estimate
  */
@@ -77,7 +129,7 @@ void timing_classifier_reset(timing_classifier_t *tc, float initial_wpm);
 /**
  * @brief Classify a duration
  *
- * @param tc Classifier state (updated with EMA)
+ * @param tc Classifier state (updated with EMA or histograms)
  * @param duration_us Duration in microseconds
  * @param is_mark true = key-on (mark), false = key-off (space)
  * @return Classified event type
@@ -89,6 +141,19 @@ key_event_t timing_classifier_classify(timing_classifier_t *tc,
                                         int64_t duration_us,
                                         bool is_mark);
 
+/**
+ * @brief Learn from an event whose type is already known
+ *
+ * For keying that arrives tagged with its element (iambic FSM): updates
+ * the averages / histograms and counters like classify would have,
+ * without deciding the type from the duration.
+ *
+ * @param tc Classifier state
+ * @param duration_us Duration in microseconds
+ * @param event Exact type (DIT/DAH for marks, *_GAP for spaces)
+ */
+void timing_classifier_learn(timing_classifier_t *tc, int64_t duration_us, key_event_t event);
+
 /**
  * @brief Get current detected WPM
  *
@@ -115,6 +180,24 @@ bool timing_classifier_is_calibrated(const timing_classifier_t *tc);
  */
 void timing_classifier_set_tolerance(timing_classifier_t *tc, float tolerance_pct);
 
+/**
+ * @brief Select the classification algorithm
+ *
+ * Restarts learning from the current dit estimate.
+ *
+ * @param tc Classifier state
+ * @param mode TIMING_MODE_EMA or TIMING_MODE_CLUSTER
+ */
+void timing_classifier_set_mode(timing_classifier_t *tc, timing_mode_t mode);
+
+/**
+ * @brief Get string name for a classification mode
+ *
+ * @param mode Mode
+ * @return Static string name ("ema", "cluster")
+ */
+const char *timing_mode_str(timing_mode_t mode);
+
 /**
  * @brief Get dit/dah ratio
  *
@@ -0,0 +1,129 @@
+/**
+ * @file tone_detector.h
+ * @brief Block Goertzel CW tone detector with adaptive threshold
+ *
+ * Turns receiver audio into key-down/key-up levels. Every block of
+ * block_samples runs one Goertzel filter per bin across the configured
+ * tone band (bins one block bandwidth apart), takes the strongest bin as
+ * the tone and compares its power against a threshold that adapts to the
+ * noise floor (learned while key up) and the tone level (learned while key
+ * down), with hysteresis. The first blocks after init only measure the
+ * noise floor, so start the detector on receiver noise rather than a tone.
+ *
+ * A new level must persist for two blocks. Level changes are stamped at
+ * the middle of the first block at the new level, so marks and spaces
+ * keep their length at block resolution (the decoder only needs
+ * durations).
+ *
+ * Pure logic, single caller (the audio RX task), no allocation.
+ */
+
+#ifndef KEYER_TONE_DETECTOR_H
+#define KEYER_TONE_DETECTOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum Goertzel bins across the tone band */
+#define TONE_DETECTOR_MAX_BINS 16
+
+/** Maximum block_samples */
+#define TONE_DETECTOR_MAX_BLOCK 256
+
+/**
+ * @brief Detector configuration
+ */
+typedef struct {
+    uint32_t sample_rate_hz;   /**< Input sample rate */
+    uint16_t block_samples;    /**< Samples per detection block (time resolution) */
+    uint16_t low_hz;           /**< Lowest tone searched */
+    uint16_t high_hz;          /**< Highest tone searched */
+} tone_detector_config_t;
+
+/** 8 kHz codec input, 8 ms blocks (125 Hz bins), 400-1000 Hz */
+#define TONE_DETECTOR_CONFIG_DEFAULT { \
+    .sample_rate_hz = 8000, \
+    .block_samples = 64, \
+    .low_hz = 400, \
+    .high_hz = 1000, \
+}
+
+/**
+ * @brief One level change
+ */
+typedef struct {
+    uint64_t sample;   /**< Input sample index (from tone_detector_init) */
+    uint8_t level;     /**< 1 = tone on, 0 = tone off */
+} tone_edge_t;
+
+/**
+ * @brief Detector counters (display)
+ */
+typedef struct {
+    uint32_t blocks;          /**< Blocks analysed */
+    uint32_t edges;           /**< Level changes emitted */
+    uint16_t tone_hz;         /**< Bin of the last detected tone */
+    float noise_power;        /**< Noise floor estimate (full scale = 1) */
+    float signal_power;       /**< Tone level estimate (0 = not learned) */
+} tone_detector_stats_t;
+
+/**
+ * @brief Detector state
+ *
+ * Goertzel state is kept as one array per term so the per-sample update
+ * runs the same multiply-add across all bins. Samples are Hann-windowed
+ * so tones outside the band do not leak into the edge bins.
+ */
+typedef struct {
+    tone_detector_config_t config;
+    uint8_t bins;                              /**< Bins in use */
+    uint16_t bin_hz[TONE_DETECTOR_MAX_BINS];   /**< Bin centre frequencies */
+    float coeff[TONE_DETECTOR_MAX_BINS];       /**< 2 cos(2 pi f / fs) per bin */
+    float s1[TONE_DETECTOR_MAX_BINS];          /**< Goertzel s[n-1] */
+    float s2[TONE_DETECTOR_MAX_BINS];          /**< Goertzel s[n-2] */
+    float window[TONE_DETECTOR_MAX_BLOCK];     /**< Hann window, input scale folded in */
+    uint16_t fill;                             /**< Samples in the current block */
+    uint64_t samples;                          /**< Samples consumed so far */
+    bool key_down;                             /**< Current level */
+    uint32_t held_blocks;                      /**< Blocks at the current level */
+    uint8_t pending;                           /**< Blocks the other level has been seen */
+    tone_detector_stats_t stats;
+} tone_detector_t;
+
+/**
+ * @brief Initialize a detector (bins spaced one block bandwidth apart)
+ *
+ * @param det Detector
+ * @param config Band and block size (block_samples 1..TONE_DETECTOR_MAX_BLOCK,
+ *               rate > 0, low <= high)
+ */
+void tone_detector_init(tone_detector_t *det, const tone_detector_config_t *config);
+
+/**
+ * @brief Feed samples, collect level changes
+ *
+ * @param det Detector
+ * @param samples Mono 16-bit input
+ * @param count Number of samples
+ * @param edges Level changes found (at most one per completed block)
+ * @param max_edges Capacity of edges
+ * @return Level changes written
+ */
+size_t tone_detector_process(tone_detector_t *det, const int16_t *samples, size_t count,
+                             tone_edge_t *edges, size_t max_edges);
+
+/** Current level (tone on) */
+static inline bool tone_detector_key_down(const tone_detector_t *det) {
+    return det->key_down;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TONE_DETECTOR_H */
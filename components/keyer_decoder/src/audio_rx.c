@@ -0,0 +1,62 @@
+/**
+ * @file audio_rx.c
+ * @brief Off-air decoding pipeline (tone detector → edge ring → decoder)
+ */
+
+#include "audio_rx.h"
+#include "esp_timer.h"
+#include <string.h>
+
+/** Detector edges per call before the rest are dropped (one per block) */
+#define AUDIO_RX_EDGES_MAX 32
+
+static uint64_t sample_tick(const audio_rx_t *rx, uint64_t sample) {
+    uint64_t den = (uint64_t)rx->detector.config.sample_rate_hz * rx->tick_us;
+    return rx->start_tick + sample * 1000000ULL / den;
+}
+
+void audio_rx_init(audio_rx_t *rx, const keying_stream_t *stream,
+                   const tone_detector_config_t *config, int64_t now_us) {
+    memset(&rx->stats, 0, sizeof(rx->stats));
+    tone_detector_init(&rx->detector, config);
+    key_edge_ring_init(&rx->ring, stream);
+
+    rx->tick_us = stream_tick_period_us(stream);
+    if (rx->tick_us == 0U) {
+        rx->tick_us = 1000U;
+    }
+    int64_t since_epoch = now_us - stream_epoch_us(stream);
+    rx->start_tick = (since_epoch > 0) ? (uint64_t)since_epoch / rx->tick_us : 0U;
+    key_edge_ring_set_head(&rx->ring, rx->start_tick);
+
+    decoder_inst_init(&rx->decoder, &rx->ring, DECODER_SOURCE_LOCAL_KEY);
+}
+
+void audio_rx_process(audio_rx_t *rx, const int16_t *samples, size_t count) {
+    int64_t t0 = esp_timer_get_time();
+
+    tone_edge_t edges[AUDIO_RX_EDGES_MAX];
+    size_t n = tone_detector_process(&rx->detector, samples, count, edges, AUDIO_RX_EDGES_MAX);
+    for (size_t i = 0; i < n; i++) {
+        key_edge_ring_push(&rx->ring, sample_tick(rx, edges[i].sample), KEY_EDGE_CH_KEY,
+                           edges[i].level);
+    }
+    key_edge_ring_set_head(&rx->ring, sample_tick(rx, rx->detector.samples));
+    decoder_inst_process(&rx->decoder);
+
+    audio_rx_stats_t *st = &rx->stats;
+    uint32_t cost = (uint32_t)(esp_timer_get_time() - t0);
+    st->calls++;
+    st->samples += (uint32_t)count;
+    st->block_us_last = cost;
+    if (cost > st->block_us_max) {
+        st->block_us_max = cost;
+    }
+    st->block_us_avg = (st->calls == 1U) ? cost
+                                         : st->block_us_avg - st->block_us_avg / 16U + cost / 16U;
+    st->budget_us = (uint32_t)((uint64_t)count * 1000000ULL * AUDIO_RX_BUDGET_PCT /
+                               ((uint64_t)rx->detector.config.sample_rate_hz * 100U));
+    if (cost > st->budget_us) {
+        st->over_budget++;
+    }
+}
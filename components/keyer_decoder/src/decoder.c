@@ -2,39 +2,38 @@
  * @file decoder.c
  * @brief CW Morse decoder implementation
  *
- * Consumes keying_stream_t as best-effort consumer.
- * Detects key transitions, classifies timing, decodes to text.
+ * Reads key_edge_t events from the shared edge ring as a best-effort
+ * subscriber and classifies the time between transitions. Each decoder_t
+ * channel picks its key with decoder_source_t; the default channel
+ * decodes LOCAL or REMOTE (whichever is down). Marks and intra-character
+ * gaps tagged by the iambic FSM (KEY_TAG_*) are taken as exact; only
+ * untagged keying (straight key, text keyer, remote, off-air) and the
+ * gaps that end characters and words are classified by duration.
  */
 
 #include "decoder.h"
 #include "morse_table.h"
 #include "timing_classifier.h"
-#include "consumer.h"
-#include "sample.h"
+#include "key_edge.h"
 
 #include <string.h>
+#include <stdint.h>
 #include <stdatomic.h>
 
 #ifdef ESP_PLATFORM
-#include "esp_timer.h"
 #include "esp_log.h"
+#include "esp_attr.h"
 static const char *TAG = "decoder";
 #else
-/* Host stub for esp_timer_get_time */
-static int64_t s_mock_time_us = 0;
-static inline int64_t esp_timer_get_time(void) { return s_mock_time_us; }
-void decoder_set_mock_time(int64_t time_us) { s_mock_time_us = time_us; }
+#define EXT_RAM_BSS_ATTR
 #endif
 
 /* ============================================================================
  * Configuration
  * ============================================================================ */
 
-/** Decoded text buffer size */
-#define DECODER_BUFFER_SIZE 128
-
 /** Maximum pattern length (ITU max is 6 for some punctuation) */
-#define MAX_PATTERN_LEN 8
+#define MAX_PATTERN_LEN MORSE_MAX_ELEMENTS
 
 /** Default initial WPM for timing classifier */
 #define DEFAULT_INITIAL_WPM 20.0f
@@ -47,260 +46,296 @@ void decoder_set_mock_time(int64_t time_us) { s_mock_time_us = time_us; }
  * ============================================================================ */
 
 #ifdef ESP_PLATFORM
-extern keying_stream_t g_keying_stream;
+/* Shared edge ring, fed by the edge stage in bg_task */
+extern key_edge_ring_t g_key_edge_ring;
 #else
-/* Host test: provide stream pointer */
+/* Host test: the default channel runs its own edge stage on a test stream */
 static keying_stream_t *s_test_stream = NULL;
+static key_edge_ring_t s_test_ring;
+static key_edge_stage_t s_test_stage;
 void decoder_set_test_stream(keying_stream_t *stream) { s_test_stream = stream; }
 #endif
 
 /* ============================================================================
- * Static state
+ * Default channel
  * ============================================================================ */
 
-/** Decoded text circular buffer */
-static decoded_char_t s_decoded_buffer[DECODER_BUFFER_SIZE];
-static size_t s_buffer_head = 0;   /* Next write position */
-static size_t s_buffer_count = 0;  /* Characters in buffer */
-static size_t s_buffer_read = 0;   /* Next read position (for pop) */
-
-/** Current pattern being accumulated */
-static char s_pattern[MAX_PATTERN_LEN + 1];
-static size_t s_pattern_len = 0;
-
-/** Last finalized pattern (for display) */
-static char s_last_pattern[MAX_PATTERN_LEN + 1];
-
-/** Decoder state */
-static decoder_state_t s_state = DECODER_STATE_IDLE;
-
-/** Timing classifier */
-static timing_classifier_t s_timing;
-
-/** Stream consumer */
-static best_effort_consumer_t s_consumer;
-static bool s_consumer_initialized = false;
-
-/** Enable flag */
-static atomic_bool s_enabled = false;
-
-/** Edge tracking */
-static int64_t s_last_edge_us = 0;
-static bool s_last_was_mark = false;
-
-/** Statistics */
-static decoder_stats_t s_stats;
+/* Decoder service (Core 1) only: text ring and timing state in PSRAM */
+static EXT_RAM_BSS_ATTR decoder_t s_default;
 
-/** Last event timestamp in sample time */
-static int64_t s_last_event_us = 0;
-
-/** Last event timestamp in wall clock (for inactivity detection) */
-static int64_t s_last_event_wall_us = 0;
-
-/** Sample-based time tracking (1 sample = 1ms = 1000us) */
-static int64_t s_sample_time_us = 0;
+decoder_t *decoder_default(void) {
+    return &s_default;
+}
 
 /* ============================================================================
  * Internal helpers
  * ============================================================================ */
 
+#ifdef ESP_PLATFORM
+/** Pattern as text for debug logs */
+static const char *pattern_str(morse_code_t code, char buf[MAX_PATTERN_LEN + 1]) {
+    morse_code_to_string(code, buf, MAX_PATTERN_LEN + 1);
+    return buf;
+}
+#endif
+
 /**
  * @brief Add character to decoded buffer
  */
-static void buffer_push(char c, int64_t timestamp_us) {
-    s_decoded_buffer[s_buffer_head].character = c;
-    s_decoded_buffer[s_buffer_head].timestamp_us = timestamp_us;
+static void buffer_push(decoder_t *dec, char c, int64_t timestamp_us) {
+    dec->buffer[dec->buffer_head].character = c;
+    dec->buffer[dec->buffer_head].timestamp_us = timestamp_us;
 
-    s_buffer_head = (s_buffer_head + 1) % DECODER_BUFFER_SIZE;
-    if (s_buffer_count < DECODER_BUFFER_SIZE) {
-        s_buffer_count++;
+    dec->buffer_head = (dec->buffer_head + 1) % DECODER_BUFFER_SIZE;
+    if (dec->buffer_count < DECODER_BUFFER_SIZE) {
+        dec->buffer_count++;
     }
 }
 
 /**
  * @brief Finalize current pattern and decode
  */
-static void finalize_pattern(int64_t timestamp_us) {
-    if (s_pattern_len == 0) {
+static void finalize_pattern(decoder_t *dec, int64_t timestamp_us) {
+    if (dec->pattern == MORSE_CODE_EMPTY) {
         return;
     }
 
-    s_pattern[s_pattern_len] = '\0';
-
     /* Save pattern before clearing (for display) */
-    memcpy(s_last_pattern, s_pattern, s_pattern_len + 1);
+    dec->last_pattern = dec->pattern;
 
-    char decoded = morse_table_lookup(s_pattern);
+    char decoded = morse_code_decode(dec->pattern);
 
+#ifdef ESP_PLATFORM
+    char text[MAX_PATTERN_LEN + 1];
+#endif
     if (decoded != '\0') {
-        buffer_push(decoded, timestamp_us);
-        s_stats.chars_decoded++;
+        buffer_push(dec, decoded, timestamp_us);
+        dec->stats.chars_decoded++;
 #ifdef ESP_PLATFORM
-        ESP_LOGD(TAG, "Decoded: '%s' -> '%c'", s_pattern, decoded);
+        ESP_LOGD(TAG, "Decoded: '%s' -> '%c'", pattern_str(dec->pattern, text), decoded);
 #endif
     } else {
         /* Unknown pattern */
-        s_stats.errors++;
+        dec->stats.errors++;
 #ifdef ESP_PLATFORM
-        ESP_LOGD(TAG, "Unknown pattern: '%s'", s_pattern);
+        ESP_LOGD(TAG, "Unknown pattern: '%s'", pattern_str(dec->pattern, text));
 #endif
     }
 
     /* Reset pattern */
-    s_pattern_len = 0;
-    s_state = DECODER_STATE_IDLE;
+    dec->pattern = MORSE_CODE_EMPTY;
+    dec->state = DECODER_STATE_IDLE;
 }
 
 /**
- * @brief Check for inactivity timeout (uses wall clock)
+ * @brief Check for inactivity timeout (stream time)
+ *
+ * Every edge before the stage's head tick has been read, so the key has
+ * held its level since the last edge until at least the head.
  */
-static void check_inactivity(void) {
-    if (s_state != DECODER_STATE_RECEIVING || s_last_event_wall_us == 0) {
+static void check_inactivity(decoder_t *dec) {
+    if (dec->state != DECODER_STATE_RECEIVING) {
         return;
     }
 
-    int64_t now_us = esp_timer_get_time();
-    int64_t elapsed_us = now_us - s_last_event_wall_us;
-    int64_t timeout_us = s_timing.dit_avg_us * INACTIVITY_DIT_UNITS;
+    const key_edge_ring_t *ring = dec->edges.ring;
+    int64_t head_us = key_edge_time_us(ring, key_edge_head_tick(ring, dec->last_edge_tick));
+    int64_t timeout_us = dec->timing.dit_avg_us * INACTIVITY_DIT_UNITS;
 
-    if (elapsed_us > timeout_us) {
+    if (head_us - dec->last_edge_us > timeout_us) {
         /* Force finalization */
-        finalize_pattern(s_sample_time_us);
+        finalize_pattern(dec, head_us);
         /* No word space - just character gap */
     }
 }
 
+/**
+ * @brief Clear text, pattern and edge tracking
+ */
+static void clear_state(decoder_t *dec) {
+    dec->buffer_head = 0;
+    dec->buffer_count = 0;
+    dec->buffer_read = 0;
+    dec->pattern = MORSE_CODE_EMPTY;
+    dec->last_pattern = MORSE_CODE_EMPTY;
+    dec->state = DECODER_STATE_IDLE;
+    dec->last_edge_us = 0;
+    dec->last_was_mark = false;
+    dec->mark_tag = 0;
+    dec->last_edge_tick = 0;
+    dec->edge_time_us = 0;
+    memset(dec->levels, 0, sizeof(dec->levels));
+
+    memset(&dec->stats, 0, sizeof(dec->stats));
+    memset(dec->buffer, 0, sizeof(dec->buffer));
+}
+
 /* ============================================================================
- * Public API
+ * Instance API
  * ============================================================================ */
 
-void decoder_init(void) {
-#ifdef ESP_PLATFORM
-    /* Enable DEBUG level for decoder tag */
-    esp_log_level_set(TAG, ESP_LOG_DEBUG);
-#endif
+void decoder_inst_init(decoder_t *dec, const key_edge_ring_t *ring, decoder_source_t source) {
+    dec->source = source;
 
     /* Initialize timing classifier with default WPM */
-    timing_classifier_init(&s_timing, DEFAULT_INITIAL_WPM);
-
-    /* Reset state */
-    s_buffer_head = 0;
-    s_buffer_count = 0;
-    s_buffer_read = 0;
-    s_pattern_len = 0;
-    s_state = DECODER_STATE_IDLE;
-    s_last_edge_us = 0;
-    s_last_was_mark = false;
-    s_last_event_us = 0;
-
-    memset(&s_stats, 0, sizeof(s_stats));
-    memset(s_decoded_buffer, 0, sizeof(s_decoded_buffer));
-    memset(s_pattern, 0, sizeof(s_pattern));
-    memset(s_last_pattern, 0, sizeof(s_last_pattern));
-
-    /* Initialize consumer */
-#ifdef ESP_PLATFORM
-    best_effort_consumer_init(&s_consumer, &g_keying_stream, 100);
-    s_consumer_initialized = true;
-#else
-    if (s_test_stream != NULL) {
-        best_effort_consumer_init(&s_consumer, s_test_stream, 100);
-        s_consumer_initialized = true;
+    timing_classifier_init(&dec->timing, DEFAULT_INITIAL_WPM);
+    clear_state(dec);
+
+    /* Subscribe to the edge ring */
+    dec->reader_initialized = false;
+    if (ring != NULL) {
+        key_edge_reader_init(&dec->edges, ring);
+        dec->reader_initialized = true;
     }
-#endif
 
-    atomic_store(&s_enabled, true);
+    atomic_store(&dec->enabled, true);
 }
 
-void decoder_process(void) {
-    if (!atomic_load(&s_enabled) || !s_consumer_initialized) {
-        return;
+/**
+ * @brief Key level this channel hears
+ */
+static bool source_is_mark(const decoder_t *dec) {
+    switch (dec->source) {
+        case DECODER_SOURCE_LOCAL_KEY:
+            return dec->levels[KEY_EDGE_CH_KEY] != 0;
+        case DECODER_SOURCE_GPIO:
+            return dec->levels[KEY_EDGE_CH_DIT] != 0 || dec->levels[KEY_EDGE_CH_DAH] != 0;
+        case DECODER_SOURCE_REMOTE:
+            return dec->levels[KEY_EDGE_CH_REMOTE] != 0;
+        case DECODER_SOURCE_ANY:
+        default:
+            return dec->levels[KEY_EDGE_CH_KEY] != 0 || dec->levels[KEY_EDGE_CH_REMOTE] != 0;
+    }
+}
+
+/**
+ * @brief Event known from the keyer tag of the current mark, else UNKNOWN
+ *
+ * Called on a transition: if a mark just ended it is the ended mark's tag,
+ * if a space just ended it is the tag of the mark that ended it.
+ */
+static key_event_t exact_event(const decoder_t *dec) {
+    if (dec->last_was_mark) {
+        if (dec->mark_tag & KEY_TAG_ELEMENT) {
+            return (dec->mark_tag & KEY_TAG_DAH) ? KEY_EVENT_DAH : KEY_EVENT_DIT;
+        }
+    } else if (dec->mark_tag & KEY_TAG_IN_CHAR) {
+        return KEY_EVENT_INTRA_GAP;
     }
+    return KEY_EVENT_UNKNOWN;
+}
 
-    /* Process all available samples */
-    stream_sample_t sample;
-    while (best_effort_consumer_tick(&s_consumer, &sample)) {
-        s_stats.samples_processed++;
+/**
+ * @brief Feed one key edge to the classifier
+ */
+static void process_edge(decoder_t *dec, const key_edge_t *edge) {
+    dec->stats.edges_processed++;
 
-        /* Advance sample time based on sample type:
-         * - Regular sample: 1ms (1000us)
-         * - Silence marker: config_gen ms (ticks * 1000us)
-         */
-        if (sample_is_silence(&sample)) {
-            s_sample_time_us += (int64_t)sample_silence_ticks(&sample) * 1000;
-            continue;  /* Silence doesn't change key state */
+    if (edge->channel >= KEY_EDGE_CH_COUNT) {
+        return;
+    }
+
+    int64_t time_us = key_edge_time_us(dec->edges.ring, edge->tick);
+    if (edge->channel == KEY_EDGE_CH_REMOTE) {
+        /* REMOTE play ticks may be ahead of LOCAL edges read later;
+         * never move the clock back for them */
+        if (time_us > dec->edge_time_us) {
+            dec->edge_time_us = time_us;
         }
-        s_sample_time_us += 1000;  /* 1 sample = 1ms */
+    } else {
+        dec->edge_time_us = time_us;
+    }
+    dec->levels[edge->channel] = edge->level;
+
+    /* We're interested in key transitions (mark/space) */
+    bool is_mark = source_is_mark(dec);
+    if (is_mark == dec->last_was_mark) {
+        return;  /* Another channel, or no change on ours */
+    }
 
-        /* We're interested in local_key transitions (mark/space) */
-        bool is_mark = (sample.local_key != 0);
+    if (is_mark) {
+        /* Iambic keying says what this mark is and whether it continues the character */
+        dec->mark_tag = (edge->channel == KEY_EDGE_CH_KEY) ? edge->tag : 0U;
+    }
 
-        /* Detect edge */
-        if (is_mark != s_last_was_mark) {
-            if (s_last_edge_us > 0) {
-                /* Edge detected - classify the duration */
-                int64_t duration_us = s_sample_time_us - s_last_edge_us;
+    if (dec->last_edge_us > 0) {
+        /* Edge detected - classify the duration */
+        int64_t duration_us = dec->edge_time_us - dec->last_edge_us;
 
-                /* s_last_was_mark tells us what just ended:
-                 * - true: a mark just ended (key went up) → classify as dit/dah
-                 * - false: a space just ended (key went down) → classify as gap
-                 */
-                key_event_t event = timing_classifier_classify(
-                    &s_timing, duration_us, s_last_was_mark);
+        /* last_was_mark tells us what just ended:
+         * - true: a mark just ended (key went up) → classify as dit/dah
+         * - false: a space just ended (key went down) → classify as gap
+         * Tagged keying is taken as is; the classifier only learns from it.
+         */
+        key_event_t event = exact_event(dec);
+        if (event != KEY_EVENT_UNKNOWN) {
+            timing_classifier_learn(&dec->timing, duration_us, event);
+            dec->stats.tagged_events++;
+        } else {
+            event = timing_classifier_classify(&dec->timing, duration_us, dec->last_was_mark);
+        }
 
 #ifdef ESP_PLATFORM
-                ESP_LOGD(TAG, "Edge: %s->%s dur=%lldus event=%d dit_avg=%lld",
-                         s_last_was_mark ? "MARK" : "SPACE",
-                         is_mark ? "MARK" : "SPACE",
-                         (long long)duration_us, (int)event,
-                         (long long)s_timing.dit_avg_us);
+        ESP_LOGD(TAG, "Edge: %s->%s dur=%lldus event=%d dit_avg=%lld",
+                 dec->last_was_mark ? "MARK" : "SPACE",
+                 is_mark ? "MARK" : "SPACE",
+                 (long long)duration_us, (int)event,
+                 (long long)dec->timing.dit_avg_us);
 #endif
 
-                decoder_handle_event(event, s_sample_time_us);
-                s_last_event_us = s_sample_time_us;
-                s_last_event_wall_us = esp_timer_get_time();
-            }
+        decoder_inst_handle_event(dec, event, dec->edge_time_us);
+    }
 
-            /* Update edge tracking only on transitions */
-            s_last_edge_us = s_sample_time_us;
-            s_last_was_mark = is_mark;
-        }
+    /* Update edge tracking only on transitions */
+    dec->last_edge_us = dec->edge_time_us;
+    dec->last_edge_tick = edge->tick;
+    dec->last_was_mark = is_mark;
+}
+
+void decoder_inst_process(decoder_t *dec) {
+    if (!atomic_load(&dec->enabled) || !dec->reader_initialized) {
+        return;
+    }
+
+    /* Work is per edge: silence between them costs nothing */
+    key_edge_t edge;
+    while (key_edge_reader_next(&dec->edges, &edge)) {
+        process_edge(dec, &edge);
     }
 
     /* Update dropped count */
-    s_stats.samples_dropped = (uint32_t)best_effort_consumer_dropped(&s_consumer);
+    dec->stats.edges_dropped = (uint32_t)dec->edges.dropped;
 
-    /* Check for inactivity timeout (uses wall clock) */
-    check_inactivity();
+    /* Check for inactivity timeout (stream time) */
+    check_inactivity(dec);
 }
 
-void decoder_handle_event(key_event_t event, int64_t timestamp_us) {
+void decoder_inst_handle_event(decoder_t *dec, key_event_t event, int64_t timestamp_us) {
 #ifdef ESP_PLATFORM
-    ESP_LOGD(TAG, "Event: %d pattern='%.*s' len=%zu",
-             (int)event, (int)s_pattern_len, s_pattern, s_pattern_len);
+    char text[MAX_PATTERN_LEN + 1];
+    ESP_LOGD(TAG, "Event: %d pattern='%s' len=%u",
+             (int)event, pattern_str(dec->pattern, text), morse_code_len(dec->pattern));
 #endif
 
     switch (event) {
         case KEY_EVENT_DIT:
-            if (s_pattern_len < MAX_PATTERN_LEN) {
-                s_pattern[s_pattern_len++] = '.';
+            if (morse_code_len(dec->pattern) < MAX_PATTERN_LEN) {
+                dec->pattern = morse_code_push(dec->pattern, false);
 #ifdef ESP_PLATFORM
-                ESP_LOGD(TAG, "Added DIT, pattern now: '%.*s'",
-                         (int)s_pattern_len, s_pattern);
+                ESP_LOGD(TAG, "Added DIT, pattern now: '%s'", pattern_str(dec->pattern, text));
 #endif
             }
-            s_state = DECODER_STATE_RECEIVING;
+            dec->state = DECODER_STATE_RECEIVING;
             break;
 
         case KEY_EVENT_DAH:
-            if (s_pattern_len < MAX_PATTERN_LEN) {
-                s_pattern[s_pattern_len++] = '-';
+            if (morse_code_len(dec->pattern) < MAX_PATTERN_LEN) {
+                dec->pattern = morse_code_push(dec->pattern, true);
 #ifdef ESP_PLATFORM
-                ESP_LOGD(TAG, "Added DAH, pattern now: '%.*s'",
-                         (int)s_pattern_len, s_pattern);
+                ESP_LOGD(TAG, "Added DAH, pattern now: '%s'", pattern_str(dec->pattern, text));
 #endif
             }
-            s_state = DECODER_STATE_RECEIVING;
+            dec->state = DECODER_STATE_RECEIVING;
             break;
 
         case KEY_EVENT_INTRA_GAP:
@@ -310,21 +345,19 @@ void decoder_handle_event(key_event_t event, int64_t timestamp_us) {
         case KEY_EVENT_CHAR_GAP:
             /* Character complete */
 #ifdef ESP_PLATFORM
-            ESP_LOGD(TAG, "CHAR_GAP: finalizing pattern '%.*s'",
-                     (int)s_pattern_len, s_pattern);
+            ESP_LOGD(TAG, "CHAR_GAP: finalizing pattern '%s'", pattern_str(dec->pattern, text));
 #endif
-            finalize_pattern(timestamp_us);
+            finalize_pattern(dec, timestamp_us);
             break;
 
         case KEY_EVENT_WORD_GAP:
             /* Word complete */
 #ifdef ESP_PLATFORM
-            ESP_LOGD(TAG, "WORD_GAP: finalizing pattern '%.*s'",
-                     (int)s_pattern_len, s_pattern);
+            ESP_LOGD(TAG, "WORD_GAP: finalizing pattern '%s'", pattern_str(dec->pattern, text));
 #endif
-            finalize_pattern(timestamp_us);
-            buffer_push(' ', timestamp_us);
-            s_stats.words_decoded++;
+            finalize_pattern(dec, timestamp_us);
+            buffer_push(dec, ' ', timestamp_us);
+            dec->stats.words_decoded++;
             break;
 
         case KEY_EVENT_UNKNOWN:
@@ -334,20 +367,29 @@ void decoder_handle_event(key_event_t event, int64_t timestamp_us) {
     }
 }
 
-void decoder_set_enabled(bool enabled) {
-    atomic_store(&s_enabled, enabled);
+void decoder_inst_reset(decoder_t *dec) {
+    clear_state(dec);
+    timing_classifier_reset(&dec->timing, DEFAULT_INITIAL_WPM);
 }
 
-bool decoder_is_enabled(void) {
-    return atomic_load(&s_enabled);
+void decoder_inst_set_enabled(decoder_t *dec, bool enabled) {
+    atomic_store(&dec->enabled, enabled);
 }
 
-size_t decoder_get_text(char *buf, size_t max_len) {
+bool decoder_inst_is_enabled(const decoder_t *dec) {
+    return atomic_load(&dec->enabled);
+}
+
+void decoder_inst_set_timing_mode(decoder_t *dec, timing_mode_t mode) {
+    timing_classifier_set_mode(&dec->timing, mode);
+}
+
+size_t decoder_inst_get_text(const decoder_t *dec, char *buf, size_t max_len) {
     if (buf == NULL || max_len == 0) {
         return 0;
     }
 
-    size_t count = (s_buffer_count < max_len - 1) ? s_buffer_count : max_len - 1;
+    size_t count = (dec->buffer_count < max_len - 1) ? dec->buffer_count : max_len - 1;
     if (count == 0) {
         buf[0] = '\0';
         return 0;
@@ -355,129 +397,173 @@ size_t decoder_get_text(char *buf, size_t max_len) {
 
     /* Calculate start position in circular buffer */
     size_t start;
-    if (s_buffer_count >= DECODER_BUFFER_SIZE) {
-        start = s_buffer_head;  /* Buffer wrapped, head is oldest */
+    if (dec->buffer_count >= DECODER_BUFFER_SIZE) {
+        start = dec->buffer_head;  /* Buffer wrapped, head is oldest */
     } else {
         start = 0;
     }
 
     /* Copy characters */
     for (size_t i = 0; i < count; i++) {
-        size_t idx = (start + s_buffer_count - count + i) % DECODER_BUFFER_SIZE;
-        buf[i] = s_decoded_buffer[idx].character;
+        size_t idx = (start + dec->buffer_count - count + i) % DECODER_BUFFER_SIZE;
+        buf[i] = dec->buffer[idx].character;
     }
     buf[count] = '\0';
 
     return count;
 }
 
-size_t decoder_get_text_with_timestamps(decoded_char_t *buf, size_t max_count) {
+size_t decoder_inst_get_text_with_timestamps(const decoder_t *dec, decoded_char_t *buf,
+                                             size_t max_count) {
     if (buf == NULL || max_count == 0) {
         return 0;
     }
 
-    size_t count = (s_buffer_count < max_count) ? s_buffer_count : max_count;
+    size_t count = (dec->buffer_count < max_count) ? dec->buffer_count : max_count;
     if (count == 0) {
         return 0;
     }
 
     /* Calculate start position */
     size_t start;
-    if (s_buffer_count >= DECODER_BUFFER_SIZE) {
-        start = s_buffer_head;
+    if (dec->buffer_count >= DECODER_BUFFER_SIZE) {
+        start = dec->buffer_head;
     } else {
         start = 0;
     }
 
     /* Copy entries */
     for (size_t i = 0; i < count; i++) {
-        size_t idx = (start + s_buffer_count - count + i) % DECODER_BUFFER_SIZE;
-        buf[i] = s_decoded_buffer[idx];
+        size_t idx = (start + dec->buffer_count - count + i) % DECODER_BUFFER_SIZE;
+        buf[i] = dec->buffer[idx];
     }
 
     return count;
 }
 
-decoded_char_t decoder_get_last_char(void) {
-    if (s_buffer_count == 0) {
+decoded_char_t decoder_inst_get_last_char(const decoder_t *dec) {
+    if (dec->buffer_count == 0) {
         return (decoded_char_t){ .character = '\0', .timestamp_us = 0 };
     }
 
-    size_t idx = (s_buffer_head + DECODER_BUFFER_SIZE - 1) % DECODER_BUFFER_SIZE;
-    return s_decoded_buffer[idx];
+    size_t idx = (dec->buffer_head + DECODER_BUFFER_SIZE - 1) % DECODER_BUFFER_SIZE;
+    return dec->buffer[idx];
 }
 
-decoded_char_t decoder_pop_char(void) {
+decoded_char_t decoder_inst_pop_char(decoder_t *dec) {
     /* Check if there are unread characters */
-    if (s_buffer_read == s_buffer_head) {
+    if (dec->buffer_read == dec->buffer_head) {
         return (decoded_char_t){ .character = '\0', .timestamp_us = 0 };
     }
 
     /* Get character at read position */
-    decoded_char_t result = s_decoded_buffer[s_buffer_read];
+    decoded_char_t result = dec->buffer[dec->buffer_read];
 
     /* Advance read pointer */
-    s_buffer_read = (s_buffer_read + 1) % DECODER_BUFFER_SIZE;
+    dec->buffer_read = (dec->buffer_read + 1) % DECODER_BUFFER_SIZE;
 
     return result;
 }
 
-uint32_t decoder_get_wpm(void) {
-    return timing_classifier_get_wpm(&s_timing);
-}
-
-size_t decoder_get_current_pattern(char *buf, size_t max_len) {
+size_t decoder_inst_get_current_pattern(const decoder_t *dec, char *buf, size_t max_len) {
     if (buf == NULL || max_len == 0) {
         return 0;
     }
 
     /* Return current pattern if being built, otherwise last finalized */
-    const char *src = (s_pattern_len > 0) ? s_pattern : s_last_pattern;
-    size_t src_len = strlen(src);
+    morse_code_t code = (dec->pattern != MORSE_CODE_EMPTY) ? dec->pattern : dec->last_pattern;
+    return morse_code_to_string(code, buf, max_len);
+}
 
-    size_t len = (src_len < max_len - 1) ? src_len : max_len - 1;
-    memcpy(buf, src, len);
-    buf[len] = '\0';
+/* ============================================================================
+ * Default channel API
+ * ============================================================================ */
 
-    return len;
+void decoder_init(void) {
+#ifdef ESP_PLATFORM
+    /* Enable DEBUG level for decoder tag */
+    esp_log_level_set(TAG, ESP_LOG_DEBUG);
+    decoder_inst_init(&s_default, &g_key_edge_ring, DECODER_SOURCE_ANY);
+#else
+    if (s_test_stream != NULL) {
+        key_edge_ring_init(&s_test_ring, s_test_stream);
+        key_edge_stage_init(&s_test_stage, s_test_stream, &s_test_ring);
+        decoder_inst_init(&s_default, &s_test_ring, DECODER_SOURCE_ANY);
+    } else {
+        decoder_inst_init(&s_default, NULL, DECODER_SOURCE_ANY);
+    }
+#endif
+}
+
+void decoder_process(void) {
+#ifndef ESP_PLATFORM
+    if (s_test_stream != NULL && s_default.reader_initialized) {
+        key_edge_stage_run(&s_test_stage);
+    }
+#endif
+    decoder_inst_process(&s_default);
+}
+
+void decoder_handle_event(key_event_t event, int64_t timestamp_us) {
+    decoder_inst_handle_event(&s_default, event, timestamp_us);
+}
+
+void decoder_set_enabled(bool enabled) {
+    decoder_inst_set_enabled(&s_default, enabled);
+}
+
+bool decoder_is_enabled(void) {
+    return decoder_inst_is_enabled(&s_default);
+}
+
+size_t decoder_get_text(char *buf, size_t max_len) {
+    return decoder_inst_get_text(&s_default, buf, max_len);
+}
+
+size_t decoder_get_text_with_timestamps(decoded_char_t *buf, size_t max_count) {
+    return decoder_inst_get_text_with_timestamps(&s_default, buf, max_count);
+}
+
+decoded_char_t decoder_get_last_char(void) {
+    return decoder_inst_get_last_char(&s_default);
+}
+
+decoded_char_t decoder_pop_char(void) {
+    return decoder_inst_pop_char(&s_default);
+}
+
+uint32_t decoder_get_wpm(void) {
+    return decoder_inst_get_wpm(&s_default);
+}
+
+size_t decoder_get_current_pattern(char *buf, size_t max_len) {
+    return decoder_inst_get_current_pattern(&s_default, buf, max_len);
 }
 
 decoder_state_t decoder_get_state(void) {
-    return s_state;
+    return s_default.state;
 }
 
 void decoder_get_stats(decoder_stats_t *stats) {
     if (stats != NULL) {
-        *stats = s_stats;
+        *stats = s_default.stats;
     }
 }
 
 const timing_classifier_t *decoder_get_timing(void) {
-    return &s_timing;
+    return &s_default.timing;
 }
 
-void decoder_reset(void) {
-    s_buffer_head = 0;
-    s_buffer_count = 0;
-    s_buffer_read = 0;
-    s_pattern_len = 0;
-    s_state = DECODER_STATE_IDLE;
-    s_last_edge_us = 0;
-    s_last_was_mark = false;
-    s_last_event_us = 0;
-    s_last_event_wall_us = 0;
-    s_sample_time_us = 0;
-
-    memset(&s_stats, 0, sizeof(s_stats));
-    memset(s_decoded_buffer, 0, sizeof(s_decoded_buffer));
-    memset(s_pattern, 0, sizeof(s_pattern));
-    memset(s_last_pattern, 0, sizeof(s_last_pattern));
+void decoder_set_timing_mode(timing_mode_t mode) {
+    decoder_inst_set_timing_mode(&s_default, mode);
+}
 
-    timing_classifier_reset(&s_timing, DEFAULT_INITIAL_WPM);
+void decoder_reset(void) {
+    decoder_inst_reset(&s_default);
 }
 
 size_t decoder_get_buffer_count(void) {
-    return s_buffer_count;
+    return s_default.buffer_count;
 }
 
 size_t decoder_get_buffer_capacity(void) {
@@ -0,0 +1,94 @@
+/**
+ * @file decoder_transcript.c
+ * @brief Sequence-numbered decoded text history
+ */
+
+#include "decoder_transcript.h"
+#include <string.h>
+
+#define TRANSCRIPT_MASK ((uint32_t)TRANSCRIPT_CAPACITY - 1U)
+
+_Static_assert((TRANSCRIPT_CAPACITY & (TRANSCRIPT_CAPACITY - 1)) == 0,
+               "TRANSCRIPT_CAPACITY must be a power of 2");
+
+/**
+ * Oldest sequence number that cannot be under rewrite: the writer may be
+ * filling the slot of `head` (which still holds head - CAPACITY).
+ */
+static uint32_t oldest_seq(uint32_t head) {
+    return (head >= TRANSCRIPT_CAPACITY) ? head - TRANSCRIPT_CAPACITY + 1U : 0U;
+}
+
+void transcript_init(transcript_t *t) {
+    memset(t->buffer, 0, sizeof(t->buffer));
+    atomic_init(&t->head_seq, 0U);
+    atomic_init(&t->words, 0U);
+}
+
+uint32_t transcript_append(transcript_t *t, char c, uint8_t wpm) {
+    uint32_t seq = atomic_load_explicit(&t->head_seq, memory_order_relaxed);
+    uint32_t words = atomic_load_explicit(&t->words, memory_order_relaxed);
+
+    transcript_entry_t *e = &t->buffer[seq & TRANSCRIPT_MASK];
+    e->word = words;
+    e->character = c;
+    e->wpm = wpm;
+
+    if (c == ' ') {
+        atomic_store_explicit(&t->words, words + 1U, memory_order_relaxed);
+    }
+    atomic_store_explicit(&t->head_seq, seq + 1U, memory_order_release);
+    return seq;
+}
+
+size_t transcript_read(const transcript_t *t, uint32_t since, char *out, size_t max,
+                       transcript_slice_t *slice) {
+    uint32_t head = transcript_head(t);
+    uint32_t start = since;
+    if (start < oldest_seq(head) || start > head) {
+        start = oldest_seq(head);
+    }
+
+    uint32_t n = head - start;
+    if (n > max) {
+        n = (uint32_t)max;
+    }
+
+    uint32_t last_word = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const transcript_entry_t *e = &t->buffer[(start + i) & TRANSCRIPT_MASK];
+        out[i] = e->character;
+        last_word = e->word;
+    }
+
+    /* Drop whatever the writer overwrote while we copied. The newest
+     * character copied is always intact, so word numbers count back from it. */
+    uint32_t head_after = transcript_head(t);
+    uint32_t skip = 0;
+    if (start < oldest_seq(head_after)) {
+        skip = oldest_seq(head_after) - start;
+        if (skip > n) {
+            skip = n;
+        }
+        memmove(out, out + skip, n - skip);
+        n -= skip;
+        start += skip;
+    }
+
+    uint32_t first_word = transcript_words(t);
+    if (n > 0) {
+        first_word = last_word;
+        for (uint32_t i = 0; i + 1U < n; i++) {
+            if (out[i] == ' ') {
+                first_word--;
+            }
+        }
+    }
+
+    slice->first_seq = start;
+    slice->next_seq = start + n;
+    slice->head_seq = head_after;
+    slice->first_word = first_word;
+    slice->count = n;
+    return n;
+}
@@ -5,177 +5,113 @@
 
 #include "morse_table.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
-/* ============================================================================
- * Morse Code Table (ITU Standard)
- * ============================================================================ */
-
-typedef struct {
-    const char *pattern;
-    char character;
-} morse_entry_t;
-
-/**
- * ITU International Morse Code table
- *
- * Letters: A-Z (26)
- * Numbers: 0-9 (10)
- * Punctuation and prosigns
- */
-static const morse_entry_t MORSE_TABLE[] = {
-    /* Letters A-Z */
-    { ".-",     'A' },
-    { "-...",   'B' },
-    { "-.-.",   'C' },
-    { "-..",    'D' },
-    { ".",      'E' },
-    { "..-.",   'F' },
-    { "--.",    'G' },
-    { "....",   'H' },
-    { "..",     'I' },
-    { ".---",   'J' },
-    { "-.-",    'K' },
-    { ".-..",   'L' },
-    { "--",     'M' },
-    { "-.",     'N' },
-    { "---",    'O' },
-    { ".--.",   'P' },
-    { "--.-",   'Q' },
-    { ".-.",    'R' },
-    { "...",    'S' },
-    { "-",      'T' },
-    { "..-",    'U' },
-    { "...-",   'V' },
-    { ".--",    'W' },
-    { "-..-",   'X' },
-    { "-.--",   'Y' },
-    { "--..",   'Z' },
-
-    /* Numbers 0-9 */
-    { "-----",  '0' },
-    { ".----",  '1' },
-    { "..---",  '2' },
-    { "...--",  '3' },
-    { "....-",  '4' },
-    { ".....",  '5' },
-    { "-....",  '6' },
-    { "--...",  '7' },
-    { "---..",  '8' },
-    { "----.",  '9' },
-
-    /* Punctuation */
-    { ".-.-.-", '.' },  /* Period */
-    { "--..--", ',' },  /* Comma */
-    { "..--..", '?' },  /* Question mark */
-    { ".----.", '\'' }, /* Apostrophe */
-    { "-.-.--", '!' },  /* Exclamation (KW) */
-    { "-..-.",  '/' },  /* Slash */
-    { "-.--.",  '(' },  /* Open parenthesis */
-    { "-.--.-", ')' },  /* Close parenthesis */
-    { ".-...",  '&' },  /* Ampersand (AS) */
-    { "---...", ':' },  /* Colon */
-    { "-.-.-.", ';' },  /* Semicolon */
-    { "-...-",  '=' },  /* Equals / BT prosign */
-    { ".-.-.",  '+' },  /* Plus / AR prosign */
-    { "-....-", '-' },  /* Hyphen */
-    { "..--.-", '_' },  /* Underscore */
-    { ".-..-.", '"' },  /* Quotation mark */
-    { "...-..-",'$' },  /* Dollar sign */
-    { ".--.-.", '@' },  /* At sign */
-
-    /* Prosigns (mapped to printable characters) */
-    { "...-.-", '*' },  /* SK (end of contact) */
-    { "-.-.-",  '<' },  /* CT (commence transmission) / KA */
-    { "........",'#' }, /* Error signal (8 dots) */
-};
-
-#define MORSE_TABLE_SIZE (sizeof(MORSE_TABLE) / sizeof(MORSE_TABLE[0]))
-
-/* ============================================================================
- * Prosign Table for Text Keyer
- * ============================================================================ */
-
-typedef struct {
-    const char *tag;      /* e.g., "<SK>" */
-    const char *pattern;  /* e.g., "...-.-" */
-} prosign_entry_t;
-
-static const prosign_entry_t PROSIGN_TABLE[] = {
-    { "<SK>", "...-.-" },   /* End of contact */
-    { "<AR>", ".-.-." },    /* End of message */
-    { "<BT>", "-...-" },    /* Break/Pause */
-    { "<KN>", "-.--." },    /* Specific station only */
-    { "<AS>", ".-..." },    /* Wait */
-    { "<SN>", "...-." },    /* Understood (also VE) */
-    { "<KA>", "-.-.-" },    /* Starting signal */
-};
-
-#define PROSIGN_TABLE_SIZE (sizeof(PROSIGN_TABLE) / sizeof(PROSIGN_TABLE[0]))
+/* MORSE_DECODE, MORSE_ENCODE, MORSE_PATTERN, MORSE_PROSIGNS: generated from
+ * morse_alphabet.yaml by scripts/gen_morse_tables.py */
+#include "morse_tables.h"
 
 /* ============================================================================
  * Public API
  * ============================================================================ */
 
-char morse_table_lookup(const char *pattern) {
-    if (pattern == NULL || pattern[0] == '\0') {
-        return '\0';
+morse_code_t morse_code_from_string(const char *pattern) {
+    if (pattern == NULL) {
+        return MORSE_CODE_INVALID;
     }
 
-    for (size_t i = 0; i < MORSE_TABLE_SIZE; i++) {
-        if (strcmp(MORSE_TABLE[i].pattern, pattern) == 0) {
-            return MORSE_TABLE[i].character;
+    morse_code_t code = MORSE_CODE_EMPTY;
+    for (size_t i = 0; pattern[i] != '\0'; i++) {
+        if (i >= MORSE_MAX_ELEMENTS || (pattern[i] != '.' && pattern[i] != '-')) {
+            return MORSE_CODE_INVALID;
         }
+        code = morse_code_push(code, pattern[i] == '-');
     }
-
-    return '\0';  /* Not found */
+    return code;
 }
 
-const char *morse_table_reverse(char c) {
-    /* Convert lowercase to uppercase for lookup */
-    if (c >= 'a' && c <= 'z') {
-        c = (char)(c - 'a' + 'A');
+size_t morse_code_to_string(morse_code_t code, char *buf, size_t size) {
+    if (buf == NULL || size == 0) {
+        return 0;
     }
 
-    for (size_t i = 0; i < MORSE_TABLE_SIZE; i++) {
-        if (MORSE_TABLE[i].character == c) {
-            return MORSE_TABLE[i].pattern;
-        }
+    unsigned total = morse_code_len(code);
+    unsigned len = (total < size) ? total : (unsigned)(size - 1);
+    for (unsigned i = 0; i < len; i++) {
+        buf[i] = (((unsigned)code >> (total - 1U - i)) & 1U) ? '-' : '.';
     }
+    buf[len] = '\0';
+    return len;
+}
 
-    return NULL;  /* Not found */
+char morse_code_decode(morse_code_t code) {
+    if (code >= MORSE_CODE_LIMIT) {
+        return '\0';
+    }
+    return MORSE_DECODE[code];
+}
+
+morse_code_t morse_code_encode(char c) {
+    unsigned char u = (unsigned char)c;
+    return (u < 128U) ? MORSE_ENCODE[u] : MORSE_CODE_INVALID;
+}
+
+char morse_table_lookup(const char *pattern) {
+    return morse_code_decode(morse_code_from_string(pattern));
+}
+
+const char *morse_table_reverse(char c) {
+    unsigned char u = (unsigned char)c;
+    return (u < 128U) ? MORSE_PATTERN[u] : NULL;
 }
 
 unsigned morse_table_count(void) {
-    return (unsigned)MORSE_TABLE_SIZE;
+    return MORSE_ALPHABET_SIZE;
 }
 
-size_t morse_match_prosign(const char *text, const char **pattern_out) {
+static const morse_prosign_t *match_prosign(const char *text, size_t *len_out) {
     if (text == NULL || text[0] != '<') {
-        return 0;
+        return NULL;
     }
 
-    for (size_t i = 0; i < PROSIGN_TABLE_SIZE; i++) {
-        size_t len = strlen(PROSIGN_TABLE[i].tag);
-        if (strncmp(text, PROSIGN_TABLE[i].tag, len) == 0) {
-            if (pattern_out != NULL) {
-                *pattern_out = PROSIGN_TABLE[i].pattern;
-            }
-            return len;
+    for (size_t i = 0; i < MORSE_PROSIGN_COUNT; i++) {
+        size_t len = strlen(MORSE_PROSIGNS[i].tag);
+        if (strncmp(text, MORSE_PROSIGNS[i].tag, len) == 0) {
+            *len_out = len;
+            return &MORSE_PROSIGNS[i];
         }
     }
 
-    return 0;
+    return NULL;
+}
+
+size_t morse_match_prosign(const char *text, const char **pattern_out) {
+    size_t len = 0;
+    const morse_prosign_t *p = match_prosign(text, &len);
+    if (p != NULL && pattern_out != NULL) {
+        *pattern_out = p->pattern;
+    }
+    return len;
+}
+
+size_t morse_match_prosign_code(const char *text, morse_code_t *code_out) {
+    size_t len = 0;
+    const morse_prosign_t *p = match_prosign(text, &len);
+    if (p != NULL && code_out != NULL) {
+        *code_out = p->code;
+    }
+    return len;
 }
 
 const char *morse_get_prosign_tag(const char *pattern) {
-    if (pattern == NULL) {
-        return NULL;
-    }
+    return morse_code_prosign_tag(morse_code_from_string(pattern));
+}
 
-    for (size_t i = 0; i < PROSIGN_TABLE_SIZE; i++) {
-        if (strcmp(PROSIGN_TABLE[i].pattern, pattern) == 0) {
-            return PROSIGN_TABLE[i].tag;
+const char *morse_code_prosign_tag(morse_code_t code) {
+    for (size_t i = 0; i < MORSE_PROSIGN_COUNT; i++) {
+        if (MORSE_PROSIGNS[i].code == code) {
+            return MORSE_PROSIGNS[i].tag;
         }
     }
 
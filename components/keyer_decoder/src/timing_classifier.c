@@ -5,6 +5,7 @@
 
 #include "timing_classifier.h"
 #include <stddef.h>
+#include <string.h>
 
 /* ============================================================================
  * Constants
@@ -25,6 +26,15 @@
 /** Maximum valid duration (5 seconds - likely idle) */
 #define MAX_DURATION_US 5000000
 
+/** log2 of the lowest histogram bin, in microseconds */
+#define HIST_MIN_LOG2 12
+
+/** Cluster means are kept in 1/16 bin units */
+#define Q_PER_BIN 16
+
+/** Means closer than this (bins, ~1.5x) are one cluster, not two */
+#define HIST_MIN_SEPARATION 10
+
 /* ============================================================================
  * Helper Functions
  * ============================================================================ */
@@ -61,6 +71,233 @@ static int64_t ema_update(int64_t old_avg, int64_t new_value, float alpha) {
     return (int64_t)new_avg;
 }
 
+/* ============================================================================
+ * Histogram Clustering (TIMING_MODE_CLUSTER)
+ * ============================================================================ */
+
+/* Nominal cluster positions in bins from the first: 1, 3, 7 dit units
+ * (16 * log2(3) = 25.4, 16 * log2(7) = 44.9) */
+static const int32_t MARK_OFFSETS[TIMING_HIST_MAX_CLUSTERS] = { 0, 25, 0 };
+static const int32_t SPACE_OFFSETS[TIMING_HIST_MAX_CLUSTERS] = { 0, 25, 45 };
+
+/**
+ * Duration to histogram bin: piecewise-linear log2 with 4 mantissa bits
+ */
+static uint8_t duration_bin(int64_t duration_us) {
+    if (duration_us < (1LL << HIST_MIN_LOG2)) {
+        return 0;
+    }
+    uint64_t us = (uint64_t)duration_us;
+    int e = 63 - __builtin_clzll(us);
+    if (e >= HIST_MIN_LOG2 + TIMING_HIST_BINS / TIMING_HIST_BINS_PER_OCTAVE) {
+        return TIMING_HIST_BINS - 1;
+    }
+    uint32_t mantissa = (uint32_t)(us >> (e - 4)) & 15U;
+    return (uint8_t)((e - HIST_MIN_LOG2) * TIMING_HIST_BINS_PER_OCTAVE + (int)mantissa);
+}
+
+/**
+ * Position in 1/16 bin units to microseconds (inverse of duration_bin)
+ */
+static int64_t q_to_us(int32_t q) {
+    if (q < 0) {
+        q = 0;
+    }
+    int32_t octave = q >> 8;                /* 16 bins x 16 q per octave */
+    int32_t frac = q & 255;
+    return ((int64_t)(256 + frac) << (octave + HIST_MIN_LOG2)) >> 8;
+}
+
+/** Center of the bin a duration falls in, in 1/16 bin units */
+static int32_t us_to_q(int64_t duration_us) {
+    return (int32_t)duration_bin(duration_us) * Q_PER_BIN + Q_PER_BIN / 2;
+}
+
+/**
+ * Mean of cluster k (1/16 bin units). An empty cluster sits at its nominal
+ * distance from the nearest populated one, or from ref_q if all are empty.
+ */
+static int32_t hist_mean(const timing_hist_t *h, int k, const int32_t *offsets, int32_t ref_q) {
+    if (h->n[k] > 0) {
+        return (int32_t)((h->sum[k] * Q_PER_BIN) / h->n[k]) + Q_PER_BIN / 2;
+    }
+    for (int d = 1; d < h->clusters; d++) {
+        int j = k - d;
+        if (j >= 0 && h->n[j] > 0) {
+            return hist_mean(h, j, offsets, ref_q) + (offsets[k] - offsets[j]) * Q_PER_BIN;
+        }
+        j = k + d;
+        if (j < h->clusters && h->n[j] > 0) {
+            return hist_mean(h, j, offsets, ref_q) - (offsets[j] - offsets[k]) * Q_PER_BIN;
+        }
+    }
+    return ref_q + offsets[k] * Q_PER_BIN;
+}
+
+/** Cluster a bin belongs to */
+static int hist_cluster(const timing_hist_t *h, uint8_t bin) {
+    int k = 0;
+    while (k < h->clusters - 1 && bin >= h->split[k]) {
+        k++;
+    }
+    return k;
+}
+
+/** First bin whose center is at or above the midpoint of two means */
+static int32_t midpoint_split(int32_t lo_q, int32_t hi_q) {
+    return ((lo_q + hi_q) / 2 + Q_PER_BIN / 2 - 1) / Q_PER_BIN;
+}
+
+/** Split between clusters j and j+1 that halves the distance of their means */
+static int32_t hist_target_split(const timing_hist_t *h, int j, const int32_t *offsets,
+                                 int32_t ref_q) {
+    int32_t lo = hist_mean(h, j, offsets, ref_q);
+    int32_t hi = hist_mean(h, j + 1, offsets, ref_q);
+    int32_t nominal = (offsets[j + 1] - offsets[j]) * Q_PER_BIN;
+
+    if (hi - lo < HIST_MIN_SEPARATION * Q_PER_BIN) {
+        /* Collapsed: trust the populated side, place the other nominally */
+        if (h->n[j] >= h->n[j + 1]) {
+            hi = lo + nominal;
+        } else {
+            lo = hi - nominal;
+        }
+    }
+
+    int32_t split = midpoint_split(lo, hi);
+    int32_t min = (j == 0) ? 1 : h->split[j - 1] + 1;
+    int32_t max = (j + 1 < h->clusters - 1) ? h->split[j + 1] - 1 : TIMING_HIST_BINS - 1;
+    if (split < min) {
+        split = min;
+    }
+    if (split > max) {
+        split = max;
+    }
+    return split;
+}
+
+/** Move each split toward its target, at most TIMING_HIST_MAX_STEPS bins */
+static void hist_retune(timing_hist_t *h, const int32_t *offsets, int32_t ref_q) {
+    for (int j = 0; j < h->clusters - 1; j++) {
+        for (int step = 0; step < TIMING_HIST_MAX_STEPS; step++) {
+            int32_t target = hist_target_split(h, j, offsets, ref_q);
+            uint8_t b;
+            if (target > h->split[j]) {
+                /* Lowest bin of cluster j+1 joins cluster j */
+                b = h->split[j]++;
+                h->n[j] = (uint16_t)(h->n[j] + h->counts[b]);
+                h->n[j + 1] = (uint16_t)(h->n[j + 1] - h->counts[b]);
+                h->sum[j] += (uint32_t)b * h->counts[b];
+                h->sum[j + 1] -= (uint32_t)b * h->counts[b];
+            } else if (target < h->split[j]) {
+                /* Highest bin of cluster j joins cluster j+1 */
+                b = --h->split[j];
+                h->n[j] = (uint16_t)(h->n[j] - h->counts[b]);
+                h->n[j + 1] = (uint16_t)(h->n[j + 1] + h->counts[b]);
+                h->sum[j] -= (uint32_t)b * h->counts[b];
+                h->sum[j + 1] += (uint32_t)b * h->counts[b];
+            } else {
+                break;
+            }
+        }
+    }
+}
+
+static void hist_init(timing_hist_t *h, uint8_t clusters, const int32_t *offsets, int32_t ref_q) {
+    memset(h, 0, sizeof(*h));
+    h->clusters = clusters;
+
+    /* Nominal positions are far enough apart to keep the splits ordered */
+    for (int j = 0; j < clusters - 1; j++) {
+        int32_t split = midpoint_split(ref_q + offsets[j] * Q_PER_BIN,
+                                       ref_q + offsets[j + 1] * Q_PER_BIN);
+        if (split < j + 1) {
+            split = j + 1;
+        }
+        if (split > TIMING_HIST_BINS - clusters + j + 1) {
+            split = TIMING_HIST_BINS - clusters + j + 1;
+        }
+        h->split[j] = (uint8_t)split;
+    }
+}
+
+/** Add one event to the window (evicting the oldest), then retune */
+static void hist_add(timing_hist_t *h, uint8_t bin, const int32_t *offsets, int32_t ref_q) {
+    int k;
+    if (h->filled == TIMING_HIST_WINDOW) {
+        uint8_t old = h->window[h->head];
+        k = hist_cluster(h, old);
+        h->counts[old]--;
+        h->n[k]--;
+        h->sum[k] -= old;
+    } else {
+        h->filled++;
+    }
+    h->window[h->head] = bin;
+    h->head = (uint8_t)((h->head + 1U) % TIMING_HIST_WINDOW);
+
+    k = hist_cluster(h, bin);
+    h->counts[bin]++;
+    h->n[k]++;
+    h->sum[k] += bin;
+
+    hist_retune(h, offsets, ref_q);
+}
+
+/** Dit estimate the space priors hang off */
+static int32_t dit_ref_q(const timing_classifier_t *tc) {
+    return hist_mean(&tc->marks, 0, MARK_OFFSETS, us_to_q(tc->dit_avg_us));
+}
+
+/** EMA: fold a mark of known type into its average */
+static void ema_add_mark(timing_classifier_t *tc, int64_t duration_us, key_event_t event) {
+    if (event == KEY_EVENT_DIT) {
+        tc->dit_avg_us = ema_update(tc->dit_avg_us, duration_us, tc->ema_alpha);
+    } else {
+        tc->dah_avg_us = ema_update(tc->dah_avg_us, duration_us, tc->ema_alpha);
+    }
+}
+
+/** Count a mark of known type */
+static void count_mark(timing_classifier_t *tc, key_event_t event) {
+    if (event == KEY_EVENT_DIT) {
+        tc->dit_count++;
+    } else {
+        tc->dah_count++;
+    }
+    if (tc->warmup_count > 0) {
+        tc->warmup_count--;
+    }
+}
+
+/** Add a mark to the histogram and re-derive the averages */
+static void cluster_add_mark(timing_classifier_t *tc, uint8_t bin) {
+    int32_t ref = us_to_q(tc->dit_avg_us);
+    hist_add(&tc->marks, bin, MARK_OFFSETS, ref);
+
+    tc->dit_avg_us = q_to_us(hist_mean(&tc->marks, 0, MARK_OFFSETS, ref));
+    tc->dah_avg_us = q_to_us(hist_mean(&tc->marks, 1, MARK_OFFSETS, ref));
+}
+
+static key_event_t classify_cluster(timing_classifier_t *tc, int64_t duration_us, bool is_mark) {
+    uint8_t bin = duration_bin(duration_us);
+
+    if (is_mark) {
+        key_event_t event = (hist_cluster(&tc->marks, bin) == 0) ? KEY_EVENT_DIT : KEY_EVENT_DAH;
+        cluster_add_mark(tc, bin);
+        count_mark(tc, event);
+        return event;
+    }
+
+    static const key_event_t gaps[TIMING_HIST_MAX_CLUSTERS] = {
+        KEY_EVENT_INTRA_GAP, KEY_EVENT_CHAR_GAP, KEY_EVENT_WORD_GAP
+    };
+    int32_t ref = dit_ref_q(tc);
+    key_event_t event = gaps[hist_cluster(&tc->spaces, bin)];
+    hist_add(&tc->spaces, bin, SPACE_OFFSETS, ref);
+    return event;
+}
+
 /* ============================================================================
  * Public API
  * ============================================================================ */
@@ -79,10 +316,27 @@ void timing_classifier_init(timing_classifier_t *tc, float initial_wpm) {
     tc->warmup_count = WARMUP_EVENTS;
     tc->tolerance_pct = DEFAULT_TOLERANCE_PCT;
     tc->ema_alpha = DEFAULT_EMA_ALPHA;
+    timing_classifier_set_mode(tc, TIMING_MODE_EMA);
 }
 
 void timing_classifier_reset(timing_classifier_t *tc, float initial_wpm) {
+    if (tc == NULL) {
+        return;
+    }
+    timing_mode_t mode = tc->mode;
     timing_classifier_init(tc, initial_wpm);
+    timing_classifier_set_mode(tc, mode);
+}
+
+void timing_classifier_set_mode(timing_classifier_t *tc, timing_mode_t mode) {
+    if (tc == NULL) {
+        return;
+    }
+    tc->mode = (mode == TIMING_MODE_CLUSTER) ? TIMING_MODE_CLUSTER : TIMING_MODE_EMA;
+
+    int32_t ref = us_to_q(tc->dit_avg_us);
+    hist_init(&tc->marks, 2, MARK_OFFSETS, ref);
+    hist_init(&tc->spaces, 3, SPACE_OFFSETS, ref);
 }
 
 key_event_t timing_classifier_classify(timing_classifier_t *tc,
@@ -97,6 +351,10 @@ key_event_t timing_classifier_classify(timing_classifier_t *tc,
         return KEY_EVENT_UNKNOWN;
     }
 
+    if (tc->mode == TIMING_MODE_CLUSTER) {
+        return classify_cluster(tc, duration_us, is_mark);
+    }
+
     if (is_mark) {
         /* Classify mark as dit or dah */
 
@@ -108,24 +366,9 @@ key_event_t timing_classifier_classify(timing_classifier_t *tc,
         float tolerance_factor = 1.0f + tc->tolerance_pct / 100.0f;
         int64_t adjusted_threshold = (int64_t)((float)threshold * tolerance_factor);
 
-        key_event_t event;
-        if (duration_us < adjusted_threshold) {
-            /* Dit */
-            event = KEY_EVENT_DIT;
-            tc->dit_avg_us = ema_update(tc->dit_avg_us, duration_us, tc->ema_alpha);
-            tc->dit_count++;
-        } else {
-            /* Dah */
-            event = KEY_EVENT_DAH;
-            tc->dah_avg_us = ema_update(tc->dah_avg_us, duration_us, tc->ema_alpha);
-            tc->dah_count++;
-        }
-
-        /* Decrement warmup counter */
-        if (tc->warmup_count > 0) {
-            tc->warmup_count--;
-        }
-
+        key_event_t event = (duration_us < adjusted_threshold) ? KEY_EVENT_DIT : KEY_EVENT_DAH;
+        ema_add_mark(tc, duration_us, event);
+        count_mark(tc, event);
         return event;
     } else {
         /* Classify space */
@@ -145,6 +388,30 @@ key_event_t timing_classifier_classify(timing_classifier_t *tc,
     }
 }
 
+void timing_classifier_learn(timing_classifier_t *tc, int64_t duration_us, key_event_t event) {
+    if (tc == NULL) {
+        return;
+    }
+    if (duration_us < MIN_DURATION_US || duration_us > MAX_DURATION_US) {
+        return;
+    }
+
+    bool is_mark = (event == KEY_EVENT_DIT || event == KEY_EVENT_DAH);
+    if (tc->mode == TIMING_MODE_CLUSTER) {
+        uint8_t bin = duration_bin(duration_us);
+        if (is_mark) {
+            cluster_add_mark(tc, bin);
+        } else if (event != KEY_EVENT_UNKNOWN) {
+            hist_add(&tc->spaces, bin, SPACE_OFFSETS, dit_ref_q(tc));
+        }
+    } else if (is_mark) {
+        ema_add_mark(tc, duration_us, event);
+    }
+    if (is_mark) {
+        count_mark(tc, event);
+    }
+}
+
 uint32_t timing_classifier_get_wpm(const timing_classifier_t *tc) {
     if (tc == NULL || tc->warmup_count > 0) {
         return 0;
@@ -173,6 +440,14 @@ float timing_classifier_get_ratio(const timing_classifier_t *tc) {
     return (float)tc->dah_avg_us / (float)tc->dit_avg_us;
 }
 
+const char *timing_mode_str(timing_mode_t mode) {
+    switch (mode) {
+        case TIMING_MODE_EMA:     return "ema";
+        case TIMING_MODE_CLUSTER: return "cluster";
+        default:                  return "???";
+    }
+}
+
 const char *key_event_str(key_event_t event) {
     switch (event) {
         case KEY_EVENT_DIT:       return "DIT";
@@ -0,0 +1,188 @@
+/**
+ * @file tone_detector.c
+ * @brief Block Goertzel CW tone detector
+ *
+ * Per Hann-windowed block (powers normalised so a full-scale on-bin sine
+ * is 1.0):
+ *   key up:   tone = strongest bin; noise floor follows it (slow up, fast down)
+ *   key down: tone = the bin that keyed down; signal level follows it
+ *   on  when tone > max(noise * 4, sqrt(noise * signal), floor)
+ *   off when tone < that threshold / 2  (3 dB hysteresis)
+ * A new level must hold for DEBOUNCE_BLOCKS blocks, so single-block key
+ * clicks and noise crashes never key.
+ * The geometric midpoint keeps strong signals clear of QSB and noise
+ * bursts; before any signal is learned the threshold is noise * 8. The
+ * first WARMUP_BLOCKS only measure the floor.
+ */
+
+#include "tone_detector.h"
+#include <math.h>
+#include <string.h>
+
+/** Threshold never below -60 dBFS (digital silence must not key) */
+#define POWER_FLOOR         1.0e-6f
+
+/** Blocks that only measure the noise floor after init */
+#define WARMUP_BLOCKS       4U
+
+/** Key-on margin over the noise floor: before / after a signal is learned */
+#define SNR_FIRST           8.0f
+#define SNR_MIN             4.0f
+
+/** Consecutive blocks a new level must persist (rejects key clicks, QRN) */
+#define DEBOUNCE_BLOCKS     2U
+
+/** Blocks a tone may be held before the noise floor starts to follow it */
+#define HELD_MAX_BLOCKS     375U    /* 3 s at 8 ms blocks */
+
+static const float PI_F = 3.14159265358979f;
+
+void tone_detector_init(tone_detector_t *det, const tone_detector_config_t *config) {
+    memset(det, 0, sizeof(*det));
+    det->config = *config;
+    if (det->config.block_samples > TONE_DETECTOR_MAX_BLOCK) {
+        det->config.block_samples = TONE_DETECTOR_MAX_BLOCK;
+    }
+    config = &det->config;
+
+    for (uint32_t n = 0; n < config->block_samples; n++) {
+        float w = 0.5f - 0.5f * cosf(2.0f * PI_F * (float)n / (float)config->block_samples);
+        det->window[n] = w * (1.0f / 32768.0f);
+    }
+
+    uint32_t bin_hz = config->sample_rate_hz / config->block_samples;
+    uint32_t span = (uint32_t)(config->high_hz - config->low_hz);
+    uint32_t bins = (bin_hz > 0U) ? span / bin_hz + 1U : 1U;
+    if (span > (bins - 1U) * bin_hz) {
+        bins++;  /* Cover high_hz too */
+    }
+    if (bins > TONE_DETECTOR_MAX_BINS) {
+        bins = TONE_DETECTOR_MAX_BINS;
+    }
+    det->bins = (uint8_t)bins;
+
+    for (uint32_t i = 0; i < bins; i++) {
+        uint32_t f = (bins > 1U) ? config->low_hz + span * i / (bins - 1U) : config->low_hz;
+        det->bin_hz[i] = (uint16_t)f;
+        det->coeff[i] = 2.0f * cosf(2.0f * PI_F * (float)f / (float)config->sample_rate_hz);
+    }
+}
+
+/** One block done: pick the tone power, update the level */
+static bool end_block(tone_detector_t *det) {
+    /* Hann coherent gain 1/2: |X|^2 of a unit sine is (N/4)^2 */
+    float norm = 16.0f / ((float)det->config.block_samples * (float)det->config.block_samples);
+    float power[TONE_DETECTOR_MAX_BINS];
+    uint8_t peak = 0;
+    for (uint8_t i = 0; i < det->bins; i++) {
+        float s1 = det->s1[i];
+        float s2 = det->s2[i];
+        power[i] = (s1 * s1 + s2 * s2 - det->coeff[i] * s1 * s2) * norm;
+        det->s1[i] = 0.0f;
+        det->s2[i] = 0.0f;
+        if (power[i] > power[peak]) {
+            peak = i;
+        }
+    }
+
+    tone_detector_stats_t *st = &det->stats;
+    st->blocks++;
+    det->held_blocks++;
+
+    float noise = st->noise_power;
+    if (st->blocks <= WARMUP_BLOCKS) {
+        st->noise_power = (st->blocks == 1U) ? power[peak] : (noise + power[peak]) * 0.5f;
+        return false;
+    }
+
+    float on = noise * SNR_FIRST;
+    if (st->signal_power > 0.0f) {
+        on = sqrtf(noise * st->signal_power);
+        if (on < noise * SNR_MIN) {
+            on = noise * SNR_MIN;
+        }
+    }
+    if (on < POWER_FLOOR) {
+        on = POWER_FLOOR;
+    }
+
+    if (!det->key_down) {
+        float p = power[peak];
+        if (p <= on) {
+            det->pending = 0;
+            st->noise_power = noise + (p - noise) * ((p > noise) ? (1.0f / 16.0f) : 0.5f);
+            return false;
+        }
+        if (det->pending++ == 0U) {
+            st->tone_hz = det->bin_hz[peak];  /* Candidate tone */
+        }
+        if (det->pending < DEBOUNCE_BLOCKS) {
+            return false;
+        }
+        det->key_down = true;
+        det->pending = 0;
+        det->held_blocks = 0;
+        if (st->signal_power == 0.0f) {
+            st->signal_power = p;
+        }
+        return true;
+    }
+
+    /* Key down: stay on the bin that keyed (QRM elsewhere in the band is ignored) */
+    uint8_t tone = peak;
+    for (uint8_t i = 0; i < det->bins; i++) {
+        if (det->bin_hz[i] == st->tone_hz) {
+            tone = i;
+            break;
+        }
+    }
+    float p = power[tone];
+    if (p >= on * 0.5f) {
+        det->pending = 0;
+        st->signal_power += (p - st->signal_power) * 0.25f;
+        if (det->held_blocks > HELD_MAX_BLOCKS) {
+            st->noise_power = noise + (p - noise) * (1.0f / 64.0f);  /* Carrier, not keying */
+        }
+        return false;
+    }
+    if (++det->pending < DEBOUNCE_BLOCKS) {
+        return false;
+    }
+    det->key_down = false;
+    det->pending = 0;
+    det->held_blocks = 0;
+    return true;
+}
+
+size_t tone_detector_process(tone_detector_t *det, const int16_t *samples, size_t count,
+                             tone_edge_t *edges, size_t max_edges) {
+    size_t written = 0;
+    const uint8_t bins = det->bins;
+    const uint16_t block = det->config.block_samples;
+
+    for (size_t n = 0; n < count; n++) {
+        float x = (float)samples[n] * det->window[det->fill];
+        for (uint8_t i = 0; i < bins; i++) {
+            float s0 = x + det->coeff[i] * det->s1[i] - det->s2[i];
+            det->s2[i] = det->s1[i];
+            det->s1[i] = s0;
+        }
+        det->samples++;
+
+        if (++det->fill < block) {
+            continue;
+        }
+        det->fill = 0;
+        if (end_block(det)) {
+            det->stats.edges++;
+            if (written < max_edges) {
+                /* Middle of the first block at the new level */
+                edges[written].sample = det->samples - block / 2U -
+                                        (uint64_t)(DEBOUNCE_BLOCKS - 1U) * block;
+                edges[written].level = det->key_down ? 1U : 0U;
+                written++;
+            }
+        }
+    }
+    return written;
+}
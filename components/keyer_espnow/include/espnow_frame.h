@@ -0,0 +1,131 @@
+/**
+ * @file espnow_frame.h
+ * @brief ESP-NOW key edge frames (sequence numbers, redundancy)
+ *
+ * Every frame carries the newest edge plus the previous
+ * ESPNOW_FRAME_REDUNDANCY - 1 edges, so a lost frame is repaired by the
+ * next one without any retransmission round trip.
+ *
+ * Frame layout (little-endian, 12 + 6 * count bytes):
+ *   [0..1]  magic 'K','E'
+ *   [2]     version (1)
+ *   [3..4]  session: random per boot, a change resyncs the receiver
+ *   [5..6]  sequence number of the newest edge
+ *   [7..10] sender clock at send, us (low 32 bits)
+ *   [11]    count: edges that follow, newest first (seq, seq-1, ...)
+ *   per edge: time us (u32, sender clock), channel (u8), level (u8)
+ *
+ * The two keyers never sync clocks: the receiver places an edge at
+ * arrival - (sent - edge time), i.e. it only trusts the sender's clock
+ * over the few ms between the edge and its frame. ESP-NOW air time is
+ * well under a millisecond, so the error is that of one frame.
+ *
+ * Pure code: no ESP-IDF calls (the radio glue is espnow_link.c).
+ */
+
+#ifndef KEYER_ESPNOW_FRAME_H
+#define KEYER_ESPNOW_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Edges repeated per frame */
+#define ESPNOW_FRAME_REDUNDANCY 4
+
+/** Header bytes before the edges */
+#define ESPNOW_FRAME_HEADER     12
+
+/** Bytes per edge */
+#define ESPNOW_FRAME_EDGE_SIZE  6
+
+/** Largest frame built */
+#define ESPNOW_FRAME_MAX        (ESPNOW_FRAME_HEADER + ESPNOW_FRAME_REDUNDANCY * ESPNOW_FRAME_EDGE_SIZE)
+
+/** Frame format version */
+#define ESPNOW_FRAME_VERSION    1
+
+/**
+ * @brief One edge on the wire
+ */
+typedef struct {
+    uint32_t time_us;   /**< Edge time (sender clock on TX, receiver clock after parse) */
+    uint8_t channel;    /**< key_edge_channel_t */
+    uint8_t level;      /**< 1 = down/pressed, 0 = up/released */
+} espnow_edge_t;
+
+/**
+ * @brief Sender state
+ */
+typedef struct {
+    uint16_t session;                               /**< Sender session ID */
+    uint16_t seq;                                   /**< Sequence of the newest edge */
+    espnow_edge_t recent[ESPNOW_FRAME_REDUNDANCY];  /**< Newest first */
+    uint32_t count;                                 /**< Valid entries in recent */
+} espnow_tx_t;
+
+/**
+ * @brief Receiver state
+ */
+typedef struct {
+    bool synced;         /**< A frame of the current session was seen */
+    uint16_t session;    /**< Session being followed */
+    uint16_t last_seq;   /**< Newest sequence delivered */
+    uint32_t frames;     /**< Valid frames seen */
+    uint32_t repaired;   /**< Edges recovered from a later frame's repeats */
+    uint32_t lost;       /**< Edges missed by every frame */
+    uint32_t rejected;   /**< Malformed or foreign frames */
+} espnow_rx_t;
+
+/**
+ * @brief Start a sender session
+ *
+ * @param tx Sender state
+ * @param session Random per boot (e.g. esp_random())
+ */
+void espnow_tx_init(espnow_tx_t *tx, uint16_t session);
+
+/**
+ * @brief Add a new edge and build the frame that carries it
+ *
+ * @param tx Sender state
+ * @param edge New edge (sender clock)
+ * @param now_us Sender clock at send
+ * @param buf Output buffer
+ * @param len Buffer size (ESPNOW_FRAME_MAX is always enough)
+ * @return Frame length, 0 if buf is too small
+ */
+size_t espnow_tx_build(espnow_tx_t *tx, const espnow_edge_t *edge, uint32_t now_us,
+                       uint8_t *buf, size_t len);
+
+/**
+ * @brief Start a receiver with no session
+ */
+void espnow_rx_init(espnow_rx_t *rx);
+
+/**
+ * @brief Parse a frame and return the edges not delivered yet
+ *
+ * Edges come out oldest first with time_us on the receiver clock. The
+ * first frame of a new session delivers only its newest edge.
+ *
+ * @param rx Receiver state
+ * @param frame Received bytes
+ * @param len Frame length
+ * @param arrival_us Receiver clock at arrival
+ * @param out Output edges
+ * @param max Capacity of out (ESPNOW_FRAME_REDUNDANCY is always enough)
+ * @return Number of new edges
+ */
+size_t espnow_rx_parse(espnow_rx_t *rx, const uint8_t *frame, size_t len,
+                       uint32_t arrival_us, espnow_edge_t *out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_ESPNOW_FRAME_H */
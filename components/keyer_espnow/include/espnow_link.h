@@ -0,0 +1,59 @@
+/**
+ * @file espnow_link.h
+ * @brief ESP-NOW keying link between two paired keyers
+ *
+ * Sends every local key edge straight over ESP-NOW (no access point,
+ * TCP or VPN in the path) and plays the paired keyer's edges on the
+ * REMOTE lane of g_keying_stream, a fixed remote.espnow_delay_ms after
+ * they happened on the sender.
+ *
+ * Usage:
+ *   Create espnow_task() pinned to Core 1 after WiFi is started. It
+ *   deletes itself unless remote.espnow_enabled. Both keyers must be on
+ *   the same WiFi channel (same AP, or both unassociated).
+ *
+ * Edges come from the task's own key_edge stage on g_keying_stream, so
+ * they leave within one 1 ms poll of the RT tick that produced them.
+ */
+
+#ifndef KEYER_ESPNOW_LINK_H
+#define KEYER_ESPNOW_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Link statistics
+ */
+typedef struct {
+    bool running;           /**< ESP-NOW is up */
+    uint32_t tx_frames;     /**< Frames sent */
+    uint32_t tx_errors;     /**< esp_now_send() failures */
+    uint32_t rx_frames;     /**< Valid frames received */
+    uint32_t rx_repaired;   /**< Edges recovered from redundancy */
+    uint32_t rx_lost;       /**< Edges missed by every frame */
+    uint32_t rx_dropped;    /**< Frames dropped: receive queue full */
+    uint32_t rx_late;       /**< Edges that arrived after their play time */
+} espnow_link_stats_t;
+
+/**
+ * @brief ESP-NOW link task entry point
+ *
+ * @param arg Unused
+ */
+void espnow_task(void *arg);
+
+/**
+ * @brief Snapshot link statistics
+ */
+void espnow_link_get_stats(espnow_link_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_ESPNOW_LINK_H */
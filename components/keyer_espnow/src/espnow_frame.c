@@ -0,0 +1,132 @@
+/**
+ * @file espnow_frame.c
+ * @brief ESP-NOW key edge frames (sequence numbers, redundancy)
+ */
+
+#include "espnow_frame.h"
+#include <string.h>
+
+#define MAGIC0 'K'
+#define MAGIC1 'E'
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFFU);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v & 0xFFU);
+    p[1] = (uint8_t)((v >> 8) & 0xFFU);
+    p[2] = (uint8_t)((v >> 16) & 0xFFU);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void espnow_tx_init(espnow_tx_t *tx, uint16_t session) {
+    memset(tx, 0, sizeof(*tx));
+    tx->session = session;
+}
+
+size_t espnow_tx_build(espnow_tx_t *tx, const espnow_edge_t *edge, uint32_t now_us,
+                       uint8_t *buf, size_t len) {
+    /* Shift the history and put the new edge in front */
+    memmove(&tx->recent[1], &tx->recent[0],
+            (ESPNOW_FRAME_REDUNDANCY - 1) * sizeof(tx->recent[0]));
+    tx->recent[0] = *edge;
+    if (tx->count < ESPNOW_FRAME_REDUNDANCY) {
+        tx->count++;
+    }
+    tx->seq++;
+
+    size_t total = ESPNOW_FRAME_HEADER + tx->count * ESPNOW_FRAME_EDGE_SIZE;
+    if (len < total) {
+        return 0;
+    }
+
+    buf[0] = MAGIC0;
+    buf[1] = MAGIC1;
+    buf[2] = ESPNOW_FRAME_VERSION;
+    put_le16(&buf[3], tx->session);
+    put_le16(&buf[5], tx->seq);
+    put_le32(&buf[7], now_us);
+    buf[11] = (uint8_t)tx->count;
+
+    uint8_t *p = &buf[ESPNOW_FRAME_HEADER];
+    for (uint32_t i = 0; i < tx->count; i++) {
+        put_le32(p, tx->recent[i].time_us);
+        p[4] = tx->recent[i].channel;
+        p[5] = tx->recent[i].level;
+        p += ESPNOW_FRAME_EDGE_SIZE;
+    }
+    return total;
+}
+
+void espnow_rx_init(espnow_rx_t *rx) {
+    memset(rx, 0, sizeof(*rx));
+}
+
+size_t espnow_rx_parse(espnow_rx_t *rx, const uint8_t *frame, size_t len,
+                       uint32_t arrival_us, espnow_edge_t *out, size_t max) {
+    if (len < ESPNOW_FRAME_HEADER || frame[0] != MAGIC0 || frame[1] != MAGIC1 ||
+        frame[2] != ESPNOW_FRAME_VERSION) {
+        rx->rejected++;
+        return 0;
+    }
+    uint32_t count = frame[11];
+    if (count == 0 || count > ESPNOW_FRAME_REDUNDANCY ||
+        len < ESPNOW_FRAME_HEADER + count * ESPNOW_FRAME_EDGE_SIZE) {
+        rx->rejected++;
+        return 0;
+    }
+
+    uint16_t session = get_le16(&frame[3]);
+    uint16_t seq = get_le16(&frame[5]);
+    uint32_t sent_us = get_le32(&frame[7]);
+    rx->frames++;
+
+    /* New sender (or it rebooted): follow it from its newest edge */
+    uint32_t fresh;
+    if (!rx->synced || session != rx->session) {
+        rx->synced = true;
+        rx->session = session;
+        fresh = 1;
+    } else {
+        uint16_t ahead = (uint16_t)(seq - rx->last_seq);
+        if (ahead == 0 || ahead > 0x8000U) {
+            return 0;  /* Duplicate or stale */
+        }
+        if (ahead > count) {
+            rx->lost += ahead - count;
+            fresh = count;
+        } else {
+            fresh = ahead;
+        }
+        if (fresh > 1) {
+            rx->repaired += fresh - 1;
+        }
+    }
+    if (fresh > max) {
+        fresh = (uint32_t)max;
+    }
+    rx->last_seq = seq;
+
+    /* Entry i is seq - i: emit the fresh ones oldest first */
+    size_t n = 0;
+    for (uint32_t i = fresh; i-- > 0;) {
+        const uint8_t *p = &frame[ESPNOW_FRAME_HEADER + i * ESPNOW_FRAME_EDGE_SIZE];
+        uint32_t age_us = sent_us - get_le32(p);
+        out[n].time_us = arrival_us - age_us;
+        out[n].channel = p[4];
+        out[n].level = p[5];
+        n++;
+    }
+    return n;
+}
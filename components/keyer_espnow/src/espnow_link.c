@@ -0,0 +1,317 @@
+/**
+ * @file espnow_link.c
+ * @brief ESP-NOW keying link between two paired keyers
+ *
+ * The WiFi task's receive callback only copies the frame into a lock-free
+ * SPSC queue; parsing and playout run in espnow_task (Core 1), which polls
+ * the queue and the key edge stage every 1 ms and hands due edges to the
+ * RT task for the REMOTE lane (stream_handoff.h).
+ */
+
+#include "espnow_link.h"
+#include "espnow_frame.h"
+#include "key_edge.h"
+#include "stream_handoff.h"
+#include "config.h"
+#include "rt_log.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+#include "esp_now.h"
+#include "esp_wifi.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/* External log stream */
+extern log_stream_t g_bg_log_stream;
+
+/* Configuration */
+extern keyer_config_t g_config;
+
+/* Keying stream (local edges read, remote edges published) */
+extern keying_stream_t g_keying_stream;
+
+/*===========================================================================*/
+/* Constants                                                                 */
+/*===========================================================================*/
+
+#define ESPNOW_POLL_MS      1   /* Loop period: edge stage + receive queue */
+#define ESPNOW_RXQ_SLOTS    8   /* Frames between callback and task (power of 2) */
+#define ESPNOW_PLAYOUT_MAX  16  /* Received edges waiting for their play time */
+
+/*===========================================================================*/
+/* State                                                                     */
+/*===========================================================================*/
+
+typedef struct {
+    uint8_t data[ESPNOW_FRAME_MAX];
+    uint8_t len;
+    int64_t arrival_us;
+} rx_slot_t;
+
+typedef struct {
+    int64_t play_us;
+    bool key_down;
+} playout_t;
+
+static struct {
+    uint8_t peer[ESP_NOW_ETH_ALEN];     /* Paired keyer (broadcast if unset) */
+    bool peer_set;                      /* Only frames from peer are accepted */
+    int64_t delay_us;                   /* Playout delay after the sender's edge */
+
+    key_edge_ring_t ring;               /* Own edge ring: no bg_task latency */
+    key_edge_stage_t stage;
+    key_edge_reader_t edges;
+    espnow_tx_t tx;
+
+    espnow_rx_t rx;
+    stream_handoff_t remote;            /* REMOTE lane: received edges, written by rt_task */
+    bool remote_key;                    /* Level last published */
+    playout_t playout[ESPNOW_PLAYOUT_MAX];
+    uint32_t playout_head;
+    uint32_t playout_count;
+
+    espnow_link_stats_t stats;          /* Task-owned counters */
+} s_link;
+
+/* Written by the WiFi task (producer), read by espnow_task (consumer) */
+static struct {
+    rx_slot_t slots[ESPNOW_RXQ_SLOTS];
+    atomic_uint head;                   /* Next slot to fill */
+    atomic_uint tail;                   /* Next slot to drain */
+    atomic_uint dropped;
+} s_rxq;
+
+/*===========================================================================*/
+/* Receive                                                                   */
+/*===========================================================================*/
+
+/** WiFi task context: copy and hand over, nothing else */
+static void recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+    if (info == NULL || data == NULL || len <= 0 || len > ESPNOW_FRAME_MAX) {
+        return;
+    }
+    if (s_link.peer_set && memcmp(info->src_addr, s_link.peer, ESP_NOW_ETH_ALEN) != 0) {
+        return;
+    }
+
+    unsigned head = atomic_load_explicit(&s_rxq.head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&s_rxq.tail, memory_order_acquire);
+    if (head - tail >= ESPNOW_RXQ_SLOTS) {
+        atomic_fetch_add_explicit(&s_rxq.dropped, 1U, memory_order_relaxed);
+        return;
+    }
+
+    rx_slot_t *slot = &s_rxq.slots[head & (ESPNOW_RXQ_SLOTS - 1U)];
+    memcpy(slot->data, data, (size_t)len);
+    slot->len = (uint8_t)len;
+    slot->arrival_us = esp_timer_get_time();
+    atomic_store_explicit(&s_rxq.head, head + 1U, memory_order_release);
+}
+
+/** Queue a received key level for playout */
+static void schedule_edge(bool key_down, int64_t play_us) {
+    if (s_link.playout_count == ESPNOW_PLAYOUT_MAX) {
+        return;  /* Sender is keying faster than any fist: drop */
+    }
+    uint32_t idx = (s_link.playout_head + s_link.playout_count) % ESPNOW_PLAYOUT_MAX;
+    s_link.playout[idx].play_us = play_us;
+    s_link.playout[idx].key_down = key_down;
+    s_link.playout_count++;
+}
+
+/** Parse every queued frame */
+static void drain_rx_queue(void) {
+    unsigned tail = atomic_load_explicit(&s_rxq.tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&s_rxq.head, memory_order_acquire);
+
+    while (tail != head) {
+        const rx_slot_t *slot = &s_rxq.slots[tail & (ESPNOW_RXQ_SLOTS - 1U)];
+        espnow_edge_t out[ESPNOW_FRAME_REDUNDANCY];
+        uint32_t arrival_lo = (uint32_t)slot->arrival_us;
+        size_t n = espnow_rx_parse(&s_link.rx, slot->data, slot->len, arrival_lo,
+                                   out, ESPNOW_FRAME_REDUNDANCY);
+
+        for (size_t i = 0; i < n; i++) {
+            if (out[i].channel != KEY_EDGE_CH_KEY) {
+                continue;
+            }
+            /* Widen the 32-bit edge time back to esp_timer time */
+            int64_t edge_us = slot->arrival_us - (int64_t)(uint32_t)(arrival_lo - out[i].time_us);
+            schedule_edge(out[i].level != 0, edge_us + s_link.delay_us);
+        }
+
+        tail++;
+        atomic_store_explicit(&s_rxq.tail, tail, memory_order_release);
+    }
+
+    s_link.stats.rx_frames = s_link.rx.frames;
+    s_link.stats.rx_repaired = s_link.rx.repaired;
+    s_link.stats.rx_lost = s_link.rx.lost;
+}
+
+/**
+ * Hand a key level to the RT task for the REMOTE lane, stamped with its
+ * play tick (stream_handoff.h: this task never claims hot ring slots)
+ */
+static void publish_remote(bool key_down, int64_t play_us) {
+    if (key_down == s_link.remote_key) {
+        return;
+    }
+    int64_t since_epoch = play_us - stream_epoch_us(&g_keying_stream);
+    uint32_t period = stream_tick_period_us(&g_keying_stream);
+    uint64_t tick = (since_epoch > 0 && period > 0)
+                        ? (uint64_t)(since_epoch / (int64_t)period) : 0U;
+
+    if (stream_handoff_put(&s_link.remote, sample_remote_event(key_down, tick))) {
+        s_link.remote_key = key_down;
+    }
+}
+
+/** Play every received edge that is due */
+static void play_due_edges(int64_t now_us) {
+    while (s_link.playout_count > 0) {
+        const playout_t *p = &s_link.playout[s_link.playout_head];
+        if (p->play_us > now_us) {
+            break;
+        }
+        if (p->play_us < now_us - (int64_t)(ESPNOW_POLL_MS * 1000)) {
+            s_link.stats.rx_late++;
+        }
+        publish_remote(p->key_down, p->play_us);
+        s_link.playout_head = (s_link.playout_head + 1U) % ESPNOW_PLAYOUT_MAX;
+        s_link.playout_count--;
+    }
+}
+
+/*===========================================================================*/
+/* Transmit                                                                  */
+/*===========================================================================*/
+
+/** Send every new keyer output edge, each frame repeating the last few */
+static void send_new_edges(void) {
+    key_edge_t edge;
+
+    key_edge_stage_run(&s_link.stage);
+    while (key_edge_reader_next(&s_link.edges, &edge)) {
+        if (edge.channel != KEY_EDGE_CH_KEY) {
+            continue;  /* Paddle contacts stay local */
+        }
+
+        espnow_edge_t e = {
+            .time_us = (uint32_t)key_edge_time_us(&s_link.ring, edge.tick),
+            .channel = edge.channel,
+            .level = edge.level,
+        };
+        uint8_t frame[ESPNOW_FRAME_MAX];
+        size_t len = espnow_tx_build(&s_link.tx, &e, (uint32_t)esp_timer_get_time(),
+                                     frame, sizeof(frame));
+
+        /* A lost frame is repaired by the next one's repeats */
+        if (esp_now_send(s_link.peer, frame, len) == ESP_OK) {
+            s_link.stats.tx_frames++;
+        } else {
+            s_link.stats.tx_errors++;
+        }
+    }
+}
+
+/*===========================================================================*/
+/* Setup                                                                     */
+/*===========================================================================*/
+
+/** Parse "aa:bb:cc:dd:ee:ff"; false leaves mac untouched */
+static bool parse_mac(const char *text, uint8_t mac[ESP_NOW_ETH_ALEN]) {
+    unsigned v[ESP_NOW_ETH_ALEN];
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < ESP_NOW_ETH_ALEN; i++) {
+        if (v[i] > 0xFFU) {
+            return false;
+        }
+        mac[i] = (uint8_t)v[i];
+    }
+    return true;
+}
+
+static bool link_init(void) {
+    int64_t now_us = esp_timer_get_time();
+
+    memset(&s_link, 0, sizeof(s_link));
+    memset(s_link.peer, 0xFF, sizeof(s_link.peer));
+    s_link.delay_us = (int64_t)g_config.remote.espnow_delay_ms * 1000LL;
+    if (g_config.remote.espnow_peer[0] != '\0') {
+        s_link.peer_set = parse_mac(g_config.remote.espnow_peer, s_link.peer);
+        if (!s_link.peer_set) {
+            RT_WARN(&g_bg_log_stream, now_us, "ESP-NOW: bad peer MAC \"%s\", using broadcast",
+                    g_config.remote.espnow_peer);
+        }
+    }
+
+    esp_err_t err = esp_now_init();
+    if (err != ESP_OK) {
+        RT_ERROR(&g_bg_log_stream, now_us, "ESP-NOW: init failed: %d (WiFi not started?)", err);
+        return false;
+    }
+
+    esp_now_peer_info_t peer = {
+        .channel = 0,           /* Whatever channel the radio is on */
+        .ifidx = WIFI_IF_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, s_link.peer, ESP_NOW_ETH_ALEN);
+    if (esp_now_add_peer(&peer) != ESP_OK || esp_now_register_recv_cb(recv_cb) != ESP_OK) {
+        RT_ERROR(&g_bg_log_stream, now_us, "ESP-NOW: peer setup failed");
+        esp_now_deinit();
+        return false;
+    }
+
+    key_edge_ring_init(&s_link.ring, &g_keying_stream);
+    key_edge_stage_init(&s_link.stage, &g_keying_stream, &s_link.ring);
+    key_edge_reader_init(&s_link.edges, &s_link.ring);
+    espnow_tx_init(&s_link.tx, (uint16_t)esp_random());
+    espnow_rx_init(&s_link.rx);
+    stream_handoff_init(&s_link.remote, &g_keying_stream, STREAM_LANE_REMOTE);
+    if (!stream_handoffs_attach(&g_stream_handoffs, &s_link.remote)) {
+        RT_ERROR(&g_bg_log_stream, now_us, "ESP-NOW: no stream handoff slot");
+        esp_now_deinit();
+        return false;
+    }
+
+    s_link.stats.running = true;
+    RT_INFO(&g_bg_log_stream, now_us, "ESP-NOW: link up, peer %02x:%02x:%02x:%02x:%02x:%02x, delay %ums",
+            s_link.peer[0], s_link.peer[1], s_link.peer[2],
+            s_link.peer[3], s_link.peer[4], s_link.peer[5],
+            (unsigned)g_config.remote.espnow_delay_ms);
+    return true;
+}
+
+/*===========================================================================*/
+/* Public API                                                                */
+/*===========================================================================*/
+
+void espnow_task(void *arg) {
+    (void)arg;
+
+    if (!g_config.remote.espnow_enabled || !link_init()) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    for (;;) {
+        send_new_edges();
+        drain_rx_queue();
+        play_due_edges(esp_timer_get_time());
+        vTaskDelay(pdMS_TO_TICKS(ESPNOW_POLL_MS));
+    }
+}
+
+void espnow_link_get_stats(espnow_link_stats_t *out) {
+    *out = s_link.stats;
+    out->rx_dropped = atomic_load_explicit(&s_rxq.dropped, memory_order_relaxed);
+}
@@ -1,6 +1,15 @@
 /**
  * @file hal_audio.h
- * @brief Audio HAL - ES8311 codec + TCA9555 PA control
+ * @brief Audio HAL - ES8311 codec, PA through a TCA9555 or a GPIO
+ *
+ * Pins and PA control come from the target's board (hal_target.h).
+ *
+ * Two output modes:
+ * - CODEC_WRITE: hal_audio_write() duplicates mono to stereo and calls
+ *   esp_codec_dev_write() synchronously (may block on a full DMA queue)
+ * - DMA_RING:    I2S runs in mono slot mode; hal_audio_write() only copies
+ *   into a lock-free ring that the I2S on_sent callback drains into the
+ *   DMA buffer just sent. The RT task never enters the driver.
  */
 
 #ifndef KEYER_HAL_AUDIO_H
@@ -15,6 +24,36 @@
 extern "C" {
 #endif
 
+/** DMA_RING: ring capacity in mono samples (21ms at 48 kHz, power of 2) */
+#define HAL_AUDIO_RING_SAMPLES  1024
+
+/** DMA_RING: I2S DMA descriptors */
+#define HAL_AUDIO_DMA_DESC_NUM  3
+
+/** DMA_RING: frames per DMA descriptor (4ms at 8 kHz) */
+#define HAL_AUDIO_DMA_FRAME_NUM 32
+
+/**
+ * @brief Audio output mode
+ *
+ * Values match the `audio.audio_output` enum in parameters.yaml.
+ */
+typedef enum {
+    HAL_AUDIO_OUTPUT_CODEC_WRITE = 0,  /**< Blocking esp_codec_dev_write per block */
+    HAL_AUDIO_OUTPUT_DMA_RING = 1,     /**< Lock-free ring drained by I2S on_sent */
+} hal_audio_output_mode_t;
+
+/**
+ * @brief Audio output statistics
+ */
+typedef struct {
+    hal_audio_output_mode_t mode;   /**< Active output mode */
+    uint32_t underrun_samples;      /**< Samples zero-filled because the ring ran dry */
+    uint32_t overrun_samples;       /**< Samples dropped because the ring was full */
+    uint32_t ring_level;            /**< Samples currently queued */
+    uint32_t dma_callbacks;         /**< on_sent callbacks serviced */
+} hal_audio_stats_t;
+
 /**
  * @brief Audio HAL configuration
  */
@@ -29,45 +68,42 @@ typedef struct {
     int i2s_bclk_pin;
     int i2s_lrck_pin;
     int i2s_dout_pin;
+    int i2s_din_pin;         /**< Codec ADC data (ES8311 ASDOUT), -1 = none */
 
     /* Audio parameters */
-    uint32_t sample_rate;    /**< Sample rate in Hz (typically 8000) */
+    uint32_t sample_rate;    /**< Sample rate in Hz: 8000, 16000 or 48000 */
     uint8_t volume_percent;  /**< Initial volume 0-100 */
 
     /* PA control */
     bool pa_via_io_expander; /**< true = TCA9555, false = direct GPIO */
-    int pa_pin;              /**< TCA9555 pin or GPIO number */
+    int pa_pin;              /**< TCA9555 pin or GPIO number, -1 = none */
     bool pa_active_high;     /**< PA enable polarity */
-} hal_audio_config_t;
 
-/**
- * @brief Default audio configuration (matches reference hardware)
- */
-#define HAL_AUDIO_CONFIG_DEFAULT { \
-    .i2c_sda_pin = 11, \
-    .i2c_scl_pin = 10, \
-    .i2c_freq_hz = 400000, \
-    .i2s_mclk_pin = 12, \
-    .i2s_bclk_pin = 13, \
-    .i2s_lrck_pin = 14, \
-    .i2s_dout_pin = 16, \
-    .sample_rate = 8000, \
-    .volume_percent = 70, \
-    .pa_via_io_expander = true, \
-    .pa_pin = 8, \
-    .pa_active_high = true, \
-}
+    /* Output path */
+    hal_audio_output_mode_t output_mode; /**< Blocking codec write or DMA ring */
+
+    /* Input path (receiver audio for the off-air decoder) */
+    bool input_enable;       /**< Open I2S RX and the codec ADC */
+    float input_gain_db;     /**< Codec microphone/line gain */
+} hal_audio_config_t;
 
 /**
- * @brief Initialize audio HAL (ES8311 + I2S + TCA9555)
+ * @brief Initialize audio HAL (ES8311 + I2S + PA control)
  * @param config Configuration structure
  * @return ESP_OK on success, error code on failure
  * @note Audio failure does not block boot - system degrades gracefully
+ * @note May run in an init task while rt_task already calls hal_audio_write();
+ *       output is discarded until the codec is up
  */
 esp_err_t hal_audio_init(const hal_audio_config_t *config);
 
 /**
  * @brief Write audio samples to I2S buffer
+ *
+ * CODEC_WRITE: synchronous codec write (may block).
+ * DMA_RING: copies into the output ring and returns immediately; samples
+ * that do not fit are dropped and counted as overrun.
+ *
  * @param samples Pointer to sample buffer (mono, 16-bit signed)
  * @param count Number of samples
  * @return Number of samples actually written
@@ -83,10 +119,10 @@ size_t hal_audio_write(const int16_t *samples, size_t count);
 esp_err_t hal_audio_set_volume(uint8_t volume_percent);
 
 /**
- * @brief Enable/disable PA via TCA9555
+ * @brief Enable/disable PA (TCA9555 or direct GPIO)
  * @param enable true = PA on, false = PA off
- * @return ESP_OK on success
- * @note NOT RT-safe (I2C transaction)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE without PA control
+ * @note NOT RT-safe (I2C transaction, codec mute)
  */
 esp_err_t hal_audio_set_pa(bool enable);
 
@@ -100,6 +136,53 @@ void hal_audio_start(void);
  */
 void hal_audio_stop(void);
 
+/**
+ * @brief Enter or leave output standby (RT task, idle sleep only)
+ *
+ * Standby mutes the codec, turns the PA off and stops the I2S TX channel,
+ * releasing its power management lock so the chip can light-sleep. Leaving
+ * it restarts the channel with an empty ring and restores the PA state it
+ * found. The input (RX) channel is not touched.
+ *
+ * @param standby true to enter, false to leave
+ * @note NOT RT-safe (I2C transactions); only called with the keyer idle
+ */
+void hal_audio_standby(bool standby);
+
+/**
+ * @brief Get active output mode (after any fallback)
+ */
+hal_audio_output_mode_t hal_audio_get_output_mode(void);
+
+/**
+ * @brief Get output mode name ("codec_write" / "dma_ring")
+ */
+const char *hal_audio_output_mode_str(hal_audio_output_mode_t mode);
+
+/**
+ * @brief Snapshot output statistics (any core)
+ * @param out Output statistics
+ */
+void hal_audio_get_stats(hal_audio_stats_t *out);
+
+/**
+ * @brief Read receiver audio from the codec ADC (input_enable only)
+ *
+ * Reads the I2S RX channel directly, mono 16-bit. Blocks up to timeout_ms
+ * for DMA data, so only the audio RX task calls it.
+ *
+ * @param samples Output buffer
+ * @param count Samples wanted
+ * @param timeout_ms Maximum wait
+ * @return Samples read (0 on timeout or without input)
+ */
+size_t hal_audio_read(int16_t *samples, size_t count, uint32_t timeout_ms);
+
+/**
+ * @brief Check if the input path is open
+ */
+bool hal_audio_input_available(void);
+
 /**
  * @brief Check if audio HAL is initialized and available
  * @return true if audio is functional
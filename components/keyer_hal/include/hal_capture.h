@@ -0,0 +1,52 @@
+/**
+ * @file hal_capture.h
+ * @brief MCPWM capture of paddle edges (CONFIG_KEYER_PADDLE_CAPTURE)
+ *
+ * Each paddle pin drives an MCPWM capture channel on both edges. The
+ * capture counter latches in hardware at the edge, so the time no longer
+ * depends on interrupt latency; the ISR converts it (paddle_capture.h) and
+ * queues every raw edge, bounce included. hal_gpio drains the queue from
+ * the RT task and debounces it there (hal_gpio_collect_edges).
+ *
+ * Without the option this is a stub and hal_gpio keeps the GPIO ISR with
+ * blanking timers.
+ */
+
+#ifndef KEYER_HAL_CAPTURE_H
+#define KEYER_HAL_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "paddle_edge.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start capturing both paddle pins (once, from hal_gpio_init)
+ *
+ * The pins must already be configured as inputs with their pull-ups.
+ *
+ * @param dit_pin DIT paddle GPIO
+ * @param dah_pin DAH paddle GPIO
+ * @param active_low Paddles pull the pin low
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED (option off), or a driver error
+ */
+esp_err_t hal_capture_init(uint8_t dit_pin, uint8_t dah_pin, bool active_low);
+
+/**
+ * @brief Raw captured edges (capture ISR producer, RT task consumer)
+ *
+ * Levels are logical (1 = pressed); times are esp_timer µs.
+ *
+ * @return Edge queue (never NULL)
+ */
+paddle_edge_queue_t *hal_capture_queue(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_HAL_CAPTURE_H */
@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "sample.h"
+#include "paddle_edge.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,10 +21,13 @@ extern "C" {
 typedef struct {
     uint8_t dit_pin;       /**< DIT paddle GPIO pin */
     uint8_t dah_pin;       /**< DAH paddle GPIO pin */
-    uint8_t tx_pin;        /**< TX output GPIO pin */
+    uint8_t tx_pin;        /**< TX output GPIO pin (radio 1) */
+    uint8_t tx2_pin;       /**< Radio 2 TX output GPIO pin (0 = single radio) */
     bool active_low;       /**< Paddle inputs are active low */
     bool tx_active_high;   /**< TX output is active high */
-    uint32_t isr_blanking_us; /**< ISR blanking period in µs (0 = disable ISR, use polling only) */
+    uint32_t isr_blanking_us; /**< ISR blanking (capture, touch: debounce) period in µs (0 = disable ISR, use polling only) */
+    uint8_t touch_threshold_pct; /**< Touch paddles: threshold, % over the untouched reading */
+    uint32_t touch_latency_us;   /**< Touch paddles: longest sensing latency (one RT tick) */
 } hal_gpio_config_t;
 
 /**
@@ -33,9 +37,12 @@ typedef struct {
     .dit_pin = 4, \
     .dah_pin = 5, \
     .tx_pin = 6, \
+    .tx2_pin = 0, \
     .active_low = true, \
     .tx_active_high = true, \
-    .isr_blanking_us = 1500 \
+    .isr_blanking_us = 1500, \
+    .touch_threshold_pct = 20, \
+    .touch_latency_us = 1000 \
 }
 
 /**
@@ -56,12 +63,46 @@ gpio_state_t hal_gpio_read_paddles(void);
  */
 void hal_gpio_set_tx(bool on);
 
+/**
+ * @brief Set TX output at a planned time (RT task)
+ *
+ * With CONFIG_KEYER_TX_TIMED a timer alarm writes the pin at at_us
+ * (tx_sched.h plans it); otherwise this is hal_gpio_set_tx(on) now.
+ * hal_gpio_set_tx drops an edge still pending.
+ *
+ * @param on true to key TX, false to unkey
+ * @param at_us esp_timer time of the edge
+ */
+void hal_gpio_set_tx_at(bool on, int64_t at_us);
+
+/**
+ * @brief Check if TX edges are hardware-timed
+ * @return true if hal_gpio_set_tx_at uses the timer
+ */
+bool hal_gpio_tx_timed(void);
+
 /**
  * @brief Get TX state
- * @return true if TX is keyed
+ * @return true if TX is keyed (or planned to be, with timed TX)
  */
 bool hal_gpio_get_tx(void);
 
+/**
+ * @brief Number of TX outputs (2 with a radio 2 pin, radio_focus.h)
+ */
+uint8_t hal_gpio_tx_count(void);
+
+/**
+ * @brief Route TX to another radio's output (RT task, with TX up)
+ *
+ * The previous output is left unkeyed and a pending timed edge is
+ * dropped; hal_gpio_set_tx and hal_gpio_set_tx_at drive the new one.
+ * A radio without an output is ignored.
+ *
+ * @param radio Radio, 0-based
+ */
+void hal_gpio_select_tx(uint8_t radio);
+
 /**
  * @brief Get current GPIO configuration
  * @return Current configuration
@@ -82,12 +123,34 @@ bool hal_gpio_consume_dit_press(void);
  */
 bool hal_gpio_consume_dah_press(void);
 
+/**
+ * @brief Get the ISR paddle edge queue
+ *
+ * Filled by the paddle ISRs with the esp_timer time of every press edge
+ * they see; drained by the RT task (iambic_tick_edges).
+ *
+ * @return Edge queue (never NULL)
+ */
+paddle_edge_queue_t *hal_gpio_edge_queue(void);
+
 /**
  * @brief Check if ISR mode is enabled
  * @return true if ISR-based paddle detection is active
  */
 bool hal_gpio_isr_enabled(void);
 
+/**
+ * @brief Debounce captured edges into the edge queue (RT task, every tick)
+ *
+ * With CONFIG_KEYER_PADDLE_CAPTURE or CONFIG_KEYER_PADDLE_TOUCH, moves the
+ * edges captured (or sensed) since the last call through the debouncer
+ * (paddle_capture.h) into hal_gpio_edge_queue(). Call before draining that
+ * queue. No-op with the GPIO ISR backend.
+ *
+ * @param now_us Current timestamp from esp_timer_get_time()
+ */
+void hal_gpio_collect_edges(int64_t now_us);
+
 /**
  * @brief Process ISR blanking timers (call from RT task every tick)
  *
@@ -95,11 +158,31 @@ bool hal_gpio_isr_enabled(void);
  * - Starts blanking timers requested by ISR (safe in task context)
  * - Implements watchdog recovery for stuck interrupts
  *
+ * No-op with the capture and touch backends, which need neither.
+ *
  * @param now_us Current timestamp from esp_timer_get_time()
  * @note Must be called from task context (not ISR)
  */
 void hal_gpio_isr_tick(int64_t now_us);
 
+/**
+ * @brief Block until a paddle press or the timeout (RT task, idle sleep)
+ *
+ * Arms level-triggered GPIO wakeup on both paddle pins, so a press also
+ * ends automatic light sleep, and waits for the paddle ISR to notify the
+ * calling task. The press is queued on the edge queue as usual, with its
+ * ISR time (capture backend: its captured time if the chip stayed awake).
+ * With CONFIG_KEYER_ULP_PADDLE and RTC-capable pins the ULP
+ * samples the pins instead (hal_ulp.h); touch paddles wake the chip with
+ * the touch sensor (hal_touch.h). Without ISR detection
+ * (hal_gpio_isr_enabled() false) this is a plain delay.
+ *
+ * @param timeout_ms Longest wait
+ * @return true if a paddle press ended the wait
+ * @note Must be called from task context (not ISR)
+ */
+bool hal_gpio_wait_press(uint32_t timeout_ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,43 @@
+/**
+ * @file hal_sleep.h
+ * @brief RT idle sleep (timing.idle_sleep_s)
+ *
+ * Stops the RT tick, puts the audio output in standby and blocks the RT
+ * task on a paddle press. With CONFIG_PM_ENABLE and FreeRTOS tickless idle
+ * the chip then enters automatic light sleep whenever no other task or
+ * driver holds a power management lock; the paddle pins are armed as GPIO
+ * wakeup sources, or sampled by the ULP (CONFIG_KEYER_ULP_PADDLE), so a
+ * press ends the sleep and is queued with its edge time as usual. Without
+ * power management the RT task still blocks instead of spinning the loop.
+ *
+ * Sleeping is a cold path and is excluded from the RT IRAM check: it is
+ * only entered with everything idle, and leaving it takes the driver calls
+ * it needs (I2C for the PA, gptimer and I2S restarts).
+ */
+
+#ifndef KEYER_HAL_SLEEP_H
+#define KEYER_HAL_SLEEP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sleep until a paddle press or the timeout (RT task only)
+ *
+ * On return the tick source runs again (next tick one period away) and
+ * the audio output is out of standby with an empty ring.
+ *
+ * @param timeout_ms Longest sleep
+ * @return true if a paddle press ended the sleep
+ */
+bool hal_sleep_until_press(uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_HAL_SLEEP_H */
@@ -0,0 +1,57 @@
+/**
+ * @file hal_target.h
+ * @brief Per-target backend: chip capabilities and reference board wiring
+ *
+ * The HAL drivers (GPIO, gptimer, I2S, I2C, MCPWM) are the same on every
+ * chip ESP-IDF supports; what differs per target is the board around
+ * them and a few peripherals only some chips have. Each target has one
+ * backend, src/target/hal_target_<IDF_TARGET>.c, picked by the component
+ * CMakeLists; a target without one does not build.
+ *
+ * - esp32s3: reference board, ES8311 codec, PA through a TCA9555 expander
+ * - esp32p4: ESP32-P4-Function-EV-Board, ES8311 codec, PA on a GPIO;
+ *            WiFi through the ESP32-C6 coprocessor (esp_wifi_remote)
+ *
+ * Build settings per target (CPU clock, PSRAM speed, hot stream ring)
+ * live in profiles/<target>.defaults and the Kconfig defaults.
+ */
+
+#ifndef KEYER_HAL_TARGET_H
+#define KEYER_HAL_TARGET_H
+
+#include <stdbool.h>
+#include "hal_audio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What the target offers
+ */
+typedef struct {
+    const char *name;           /**< IDF_TARGET ("esp32s3") */
+    const char *board;          /**< Board the default wiring matches */
+    bool native_wifi;           /**< Radio on chip (else esp_wifi_remote) */
+    bool touch_paddles;         /**< KEYER_PADDLE_TOUCH backend available */
+    bool ulp_paddles;           /**< KEYER_ULP_PADDLE backend available */
+} hal_target_t;
+
+/**
+ * @brief The target built for
+ */
+const hal_target_t *hal_target(void);
+
+/**
+ * @brief Audio wiring of the target's reference board
+ *
+ * @param cfg Filled with pins, PA control and the default rate, volume
+ *            and output mode; the caller applies the parameters on top
+ */
+void hal_target_audio_defaults(hal_audio_config_t *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_HAL_TARGET_H */
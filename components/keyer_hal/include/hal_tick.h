@@ -0,0 +1,135 @@
+/**
+ * @file hal_tick.h
+ * @brief RT loop pacing source (FreeRTOS delay or hardware timer)
+ *
+ * Two pacing modes for the RT task:
+ * - TASK_DELAY: vTaskDelayUntil() on the FreeRTOS tick (1ms, fallback)
+ * - HW_TIMER:   gptimer alarm ISR wakes the RT task with a direct-to-task
+ *               notification at a configurable period (100µs - 1ms)
+ *
+ * Wake jitter (actual interval minus nominal period) is measured on every
+ * wake in both modes, so the two can be compared on real hardware.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.2.3: Statistics use relaxed atomics only
+ * - RULE 4.3.6: The ISR only notifies; all work stays in the RT task
+ */
+
+#ifndef KEYER_HAL_TICK_H
+#define KEYER_HAL_TICK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Shortest supported hardware timer period (10 kHz) */
+#define HAL_TICK_MIN_PERIOD_US  100
+
+/** Longest supported hardware timer period (1 kHz) */
+#define HAL_TICK_MAX_PERIOD_US  1000
+
+/**
+ * @brief RT loop pacing mode
+ *
+ * Values match the `timing.rt_pacing` enum in parameters.yaml.
+ */
+typedef enum {
+    HAL_TICK_MODE_TASK_DELAY = 0,  /**< vTaskDelayUntil on FreeRTOS tick */
+    HAL_TICK_MODE_HW_TIMER = 1,    /**< gptimer ISR + task notification */
+} hal_tick_mode_t;
+
+/**
+ * @brief Tick source configuration
+ */
+typedef struct {
+    hal_tick_mode_t mode;   /**< Requested pacing mode */
+    uint32_t period_us;     /**< Tick period (HW_TIMER only, clamped to 100-1000) */
+} hal_tick_config_t;
+
+/**
+ * @brief Wake jitter statistics snapshot
+ *
+ * Jitter is the measured wake-to-wake interval minus the nominal period.
+ */
+typedef struct {
+    hal_tick_mode_t mode;      /**< Active pacing mode */
+    uint32_t period_us;        /**< Active tick period */
+    uint32_t wakes;            /**< Wakes measured since last reset */
+    int32_t  jitter_min_us;    /**< Most negative interval error */
+    int32_t  jitter_max_us;    /**< Most positive interval error */
+    uint32_t jitter_mean_us;   /**< Mean absolute interval error */
+    uint32_t missed_ticks;     /**< Timer periods that elapsed unserviced */
+    uint32_t timeouts;         /**< Waits that timed out (timer stalled) */
+} hal_tick_stats_t;
+
+/**
+ * @brief Initialize tick source
+ *
+ * MUST be called from the RT task itself: the calling task is the one
+ * woken by the timer ISR. If the hardware timer cannot be set up, falls
+ * back to TASK_DELAY mode.
+ *
+ * @param config Tick configuration
+ * @return ESP_OK on success (possibly after fallback), ESP_ERR_INVALID_ARG on NULL
+ */
+esp_err_t hal_tick_init(const hal_tick_config_t *config);
+
+/**
+ * @brief Block until the next tick
+ *
+ * Updates wake jitter statistics. RT task only.
+ */
+void hal_tick_wait(void);
+
+/**
+ * @brief Stop ticking (RT task, before an idle sleep)
+ *
+ * HW_TIMER: the gptimer is stopped and disabled, releasing its power
+ * management lock. Pending tick notifications are dropped, so the RT task
+ * can block on its own wake source until hal_tick_resume().
+ */
+void hal_tick_suspend(void);
+
+/**
+ * @brief Restart ticking after hal_tick_suspend() (RT task)
+ *
+ * The next tick is one period from now; the gap is not counted as jitter
+ * or missed ticks.
+ */
+void hal_tick_resume(void);
+
+/**
+ * @brief Get active pacing mode (after any fallback)
+ */
+hal_tick_mode_t hal_tick_get_mode(void);
+
+/**
+ * @brief Get active tick period in microseconds
+ */
+uint32_t hal_tick_get_period_us(void);
+
+/**
+ * @brief Get pacing mode name ("task_delay" / "hw_timer")
+ */
+const char *hal_tick_mode_str(hal_tick_mode_t mode);
+
+/**
+ * @brief Snapshot wake jitter statistics (any core)
+ * @param out Output statistics
+ */
+void hal_tick_get_stats(hal_tick_stats_t *out);
+
+/**
+ * @brief Reset wake jitter statistics (any core)
+ */
+void hal_tick_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_HAL_TICK_H */
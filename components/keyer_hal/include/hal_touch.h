@@ -0,0 +1,63 @@
+/**
+ * @file hal_touch.h
+ * @brief Capacitive touch paddles (CONFIG_KEYER_PADDLE_TOUCH)
+ *
+ * The paddle pins are ESP32-S3 touch pads, scanned by the touch sensor's
+ * timer FSM with its IIR benchmark and smoothing filters; a pad crossing
+ * its threshold raises the touch interrupt. The ISR queues the edge with
+ * its time, and hal_gpio drains the queue from the RT task through the
+ * same debouncer as captured edges (hal_gpio_collect_edges). Scan timing
+ * keeps the sensing latency within a budget (paddle_touch.h).
+ *
+ * Without the option this is a stub and hal_gpio uses contact paddles.
+ */
+
+#ifndef KEYER_HAL_TOUCH_H
+#define KEYER_HAL_TOUCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "paddle_edge.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start touch sensing on both paddle pins (once, from hal_gpio_init)
+ *
+ * Takes the pins for the touch sensor and waits about 100 ms for the
+ * benchmark to settle: keep the paddles untouched at boot.
+ *
+ * @param dit_pin DIT paddle GPIO (a touch pad, 1-14)
+ * @param dah_pin DAH paddle GPIO (a touch pad, 1-14)
+ * @param threshold_pct Touch threshold, percent over the untouched reading
+ * @param budget_us Longest touch to interrupt time wanted (one RT tick)
+ * @param on_press Called from the ISR when a paddle is touched (NULL: none)
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED (option off), ESP_ERR_INVALID_ARG
+ *         (not touch pads), or a driver error
+ */
+esp_err_t hal_touch_init(uint8_t dit_pin, uint8_t dah_pin, uint8_t threshold_pct,
+                         uint32_t budget_us, void (*on_press)(void));
+
+/**
+ * @brief Raw touch edges (touch ISR producer, RT task consumer)
+ *
+ * Levels are logical (1 = touched); times are esp_timer µs.
+ *
+ * @return Edge queue (never NULL)
+ */
+paddle_edge_queue_t *hal_touch_queue(void);
+
+/**
+ * @brief Touched paddles as of the last interrupt
+ * @return Bit per paddle_edge_paddle_t (1 = touched)
+ */
+uint8_t hal_touch_levels(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_HAL_TOUCH_H */
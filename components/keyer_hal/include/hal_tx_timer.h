@@ -0,0 +1,61 @@
+/**
+ * @file hal_tx_timer.h
+ * @brief Hardware-timed TX output (CONFIG_KEYER_TX_TIMED)
+ *
+ * A free-running 1 MHz gptimer whose alarm sets the TX pin. The RT task
+ * arms one edge at a time, about a tick ahead (tx_sched.h); the alarm ISR
+ * only writes the pin, so the edge lands within interrupt latency of its
+ * planned time whatever the RT tick is doing. Armed relative to the
+ * current count, so the timer need not track esp_timer across light sleep.
+ *
+ * Without the option this is a stub and hal_gpio sets TX on the tick.
+ */
+
+#ifndef KEYER_HAL_TX_TIMER_H
+#define KEYER_HAL_TX_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create and start the timer (once, from hal_gpio_init)
+ *
+ * @param tx_pin TX output GPIO (already configured as output)
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED (option off), or a driver error
+ */
+esp_err_t hal_tx_timer_init(uint8_t tx_pin);
+
+/**
+ * @brief Set the TX pin to pin_level at at_us (RT task)
+ *
+ * Replaces an edge still pending. A time already past fires at once.
+ *
+ * @param pin_level Pin level (not key state)
+ * @param at_us esp_timer time of the edge
+ */
+void hal_tx_timer_arm(uint32_t pin_level, int64_t at_us);
+
+/**
+ * @brief Drop a pending edge (task context)
+ */
+void hal_tx_timer_cancel(void);
+
+/**
+ * @brief Move the alarm to another TX pin (RT task, TX up)
+ *
+ * Drops a pending edge, which would otherwise land on the new pin.
+ *
+ * @param tx_pin TX output GPIO (already configured as output)
+ */
+void hal_tx_timer_set_pin(uint8_t tx_pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_HAL_TX_TIMER_H */
@@ -0,0 +1,82 @@
+/**
+ * @file hal_ulp.h
+ * @brief ULP RISC-V paddle sampling for the idle sleep (CONFIG_KEYER_ULP_PADDLE)
+ *
+ * While the RT task sleeps (hal_sleep_until_press) the ULP coprocessor
+ * samples the paddle pins every HAL_ULP_PERIOD_US with a debounce of
+ * HAL_ULP_DEBOUNCE runs, and wakes the main cores on a press. A contact
+ * glitch no longer wakes the chip, and the press keeps the time of its
+ * first pressed reading: hal_gpio queues it with that time, so the iambic
+ * FSM starts the first element as if it had seen the edge live (within
+ * one ULP period).
+ *
+ * The paddle pins must be RTC GPIOs (0-21 on the ESP32-S3); they are
+ * handed to the RTC IO mux only for the sleep. Without the option, or
+ * with other pins, hal_gpio falls back to GPIO wakeup.
+ */
+
+#ifndef KEYER_HAL_ULP_H
+#define KEYER_HAL_ULP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** ULP sampling period */
+#define HAL_ULP_PERIOD_US   1000U
+
+/** Consecutive pressed readings that make a press */
+#define HAL_ULP_DEBOUNCE    2U
+
+/** Press bits in hal_ulp_press_t.mask */
+#define HAL_ULP_DIT         (1U << 0)
+#define HAL_ULP_DAH         (1U << 1)
+
+/**
+ * @brief Presses reported by the ULP
+ */
+typedef struct {
+    uint32_t mask;          /**< HAL_ULP_DIT | HAL_ULP_DAH */
+    uint32_t dit_age_us;    /**< DIT press started this long before stop */
+    uint32_t dah_age_us;    /**< DAH press started this long before stop */
+} hal_ulp_press_t;
+
+/**
+ * @brief Load the ULP program (once, from hal_gpio_init)
+ *
+ * @param dit_pin DIT paddle GPIO
+ * @param dah_pin DAH paddle GPIO
+ * @param active_low Paddles pull the pin low
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED (option off or not RTC pins), or a
+ *         ULP load error
+ */
+esp_err_t hal_ulp_paddle_init(uint8_t dit_pin, uint8_t dah_pin, bool active_low);
+
+/**
+ * @brief Hand the paddle pins to the ULP and start sampling (task context)
+ *
+ * Also enables ULP wakeup from sleep.
+ */
+void hal_ulp_paddle_start(void);
+
+/**
+ * @brief A press has been reported since the last start (any context)
+ */
+bool hal_ulp_paddle_pending(void);
+
+/**
+ * @brief Stop sampling and give the pins back to the GPIO matrix (task context)
+ *
+ * @param out Presses seen, with their age at this call
+ */
+void hal_ulp_paddle_stop(hal_ulp_press_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_HAL_ULP_H */
@@ -1,15 +1,95 @@
 /**
  * @file hal_audio.c
- * @brief Audio HAL - ES8311 codec + TCA9555 PA control
+ * @brief Audio HAL - ES8311 codec, PA through a TCA9555 or a GPIO
+ *
+ * DMA_RING output strategy:
+ * 1. I2S TX runs in mono slot mode (the peripheral duplicates L/R)
+ * 2. RT task: hal_audio_write() copies into a static SPSC ring, never blocks
+ * 3. I2S on_sent callback (ISR): refills the DMA buffer that just finished
+ *    from the ring, zero-filling and counting underruns when it runs dry
+ *
+ * Counters have one writer each: overruns (RT task), underruns and
+ * callbacks (I2S ISR).
+ *
+ * Input (input_enable): I2S RX on the same port, mono, and the ES8311 ADC
+ * opened alongside the DAC. hal_audio_read() reads the RX channel directly
+ * for the audio RX task; the RT task never touches it.
  */
 
 #include "hal_audio.h"
+#include "audio_buffer.h"
+#include <stdatomic.h>
+
+static hal_audio_output_mode_t s_output_mode = HAL_AUDIO_OUTPUT_CODEC_WRITE;
+
+/* DMA_RING output ring (RT task producer, I2S ISR consumer) */
+static int16_t s_ring_storage[HAL_AUDIO_RING_SAMPLES];
+static audio_ring_buffer_t s_ring;
+static atomic_bool s_ring_primed = ATOMIC_VAR_INIT(false);
+static atomic_uint s_underrun_samples = ATOMIC_VAR_INIT(0);
+static atomic_uint s_overrun_samples = ATOMIC_VAR_INIT(0);
+static atomic_uint s_dma_callbacks = ATOMIC_VAR_INIT(0);
+
+/**
+ * @brief Queue samples for the DMA ring (RT task only)
+ */
+static size_t ring_write(const int16_t *samples, size_t count) {
+    size_t written = audio_buffer_write(&s_ring, samples, count);
+    if (written < count) {
+        atomic_fetch_add_explicit(&s_overrun_samples, (unsigned)(count - written),
+                                  memory_order_relaxed);
+    }
+    atomic_store_explicit(&s_ring_primed, true, memory_order_relaxed);
+    return written;
+}
+
+/**
+ * @brief Fill one DMA buffer from the ring (I2S ISR only)
+ */
+static void ring_fill(int16_t *dst, size_t n) {
+    size_t got = audio_buffer_read(&s_ring, dst, n);
+    for (size_t i = got; i < n; i++) {
+        dst[i] = 0;
+    }
+    /* Before the RT task starts writing, silence is expected, not an underrun */
+    if (got < n && atomic_load_explicit(&s_ring_primed, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&s_underrun_samples, (unsigned)(n - got),
+                                  memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&s_dma_callbacks, 1, memory_order_relaxed);
+}
+
+hal_audio_output_mode_t hal_audio_get_output_mode(void) {
+    return s_output_mode;
+}
+
+const char *hal_audio_output_mode_str(hal_audio_output_mode_t mode) {
+    switch (mode) {
+        case HAL_AUDIO_OUTPUT_CODEC_WRITE: return "codec_write";
+        case HAL_AUDIO_OUTPUT_DMA_RING:    return "dma_ring";
+        default:                           return "unknown";
+    }
+}
+
+void hal_audio_get_stats(hal_audio_stats_t *out) {
+    if (out == NULL) {
+        return;
+    }
+    out->mode = s_output_mode;
+    out->underrun_samples = atomic_load_explicit(&s_underrun_samples, memory_order_relaxed);
+    out->overrun_samples = atomic_load_explicit(&s_overrun_samples, memory_order_relaxed);
+    out->ring_level = (s_output_mode == HAL_AUDIO_OUTPUT_DMA_RING)
+                          ? (uint32_t)audio_buffer_len(&s_ring) : 0;
+    out->dma_callbacks = atomic_load_explicit(&s_dma_callbacks, memory_order_relaxed);
+}
 
 #ifdef ESP_PLATFORM
 
+#include "sdkconfig.h"
 #include "driver/i2c_master.h"
 #include "driver/i2s_std.h"
 #include "esp_log.h"
+#include "driver/gpio.h"
 #include "esp_io_expander.h"
 #include "esp_io_expander_tca95xx_16bit.h"
 #include "esp_codec_dev.h"
@@ -21,14 +101,20 @@ static const char *TAG = "hal_audio";
 static hal_audio_config_t s_config;
 static i2c_master_bus_handle_t s_i2c_bus = NULL;
 static esp_io_expander_handle_t s_io_expander = NULL;
+static bool s_pa_gpio = false;   /**< PA enable on a GPIO of its own */
 static bool s_pa_enabled = false;
+static bool s_standby = false;
+static bool s_pa_before_standby = false;
 static i2s_chan_handle_t s_i2s_tx = NULL;
+static i2s_chan_handle_t s_i2s_rx = NULL;
 static esp_codec_dev_handle_t s_codec_dev = NULL;
 static const audio_codec_ctrl_if_t *s_ctrl_if = NULL;
 static const audio_codec_data_if_t *s_data_if = NULL;
 static const audio_codec_gpio_if_t *s_gpio_if = NULL;
 static const audio_codec_if_t *s_codec_if = NULL;
-static bool s_audio_available = false;
+/* Published last by hal_audio_init() (release): init may run on another
+ * core while rt_task is already writing */
+static atomic_bool s_audio_available = false;
 
 /**
  * @brief Initialize I2C bus
@@ -58,13 +144,40 @@ static esp_err_t init_i2c(void) {
     return ESP_OK;
 }
 
+/**
+ * @brief Initialize the PA enable GPIO, initially OFF
+ */
+static esp_err_t init_pa_gpio(void) {
+    if (s_config.pa_pin < 0) {
+        ESP_LOGI(TAG, "No PA control");
+        return ESP_OK;
+    }
+    const gpio_config_t io_cfg = {
+        .pin_bit_mask = 1ULL << (uint32_t)s_config.pa_pin,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    esp_err_t ret = gpio_config(&io_cfg);
+    if (ret == ESP_OK) {
+        ret = gpio_set_level((gpio_num_t)s_config.pa_pin, s_config.pa_active_high ? 0U : 1U);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "PA GPIO %d init failed: %s", s_config.pa_pin, esp_err_to_name(ret));
+        return ret;
+    }
+    s_pa_gpio = true;
+    ESP_LOGI(TAG, "PA via direct GPIO %d", s_config.pa_pin);
+    return ESP_OK;
+}
+
 /**
  * @brief Initialize TCA9555 IO expander for PA control
  */
 static esp_err_t init_io_expander(void) {
     if (!s_config.pa_via_io_expander) {
-        ESP_LOGI(TAG, "PA via direct GPIO (not IO expander)");
-        return ESP_OK;
+        return init_pa_gpio();
     }
 
     esp_err_t ret = esp_io_expander_new_i2c_tca95xx_16bit(
@@ -95,28 +208,71 @@ static esp_err_t init_io_expander(void) {
     return ESP_OK;
 }
 
+/**
+ * @brief I2S on_sent callback (DMA_RING): refill the buffer just sent
+ *
+ * Runs in the I2S ISR. The driver ISR is not IRAM-safe unless
+ * CONFIG_I2S_ISR_IRAM_SAFE is set, so calling flash code here is fine.
+ */
+static bool IRAM_ATTR i2s_on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event,
+                                  void *user_ctx) {
+    (void)handle;
+    (void)user_ctx;
+
+    if (event->dma_buf != NULL) {
+        ring_fill((int16_t *)event->dma_buf, event->size / sizeof(int16_t));
+    }
+    return false;  /* No task woken */
+}
+
 /**
  * @brief Initialize I2S for audio output
  */
 static esp_err_t init_i2s(void) {
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
-    chan_cfg.auto_clear = true;
+    if (s_output_mode == HAL_AUDIO_OUTPUT_DMA_RING) {
+        /* Short DMA chain: latency is ring level + ~2 descriptors */
+        chan_cfg.dma_desc_num = HAL_AUDIO_DMA_DESC_NUM;
+        chan_cfg.dma_frame_num = HAL_AUDIO_DMA_FRAME_NUM;
+        chan_cfg.auto_clear = false;  /* on_sent rewrites every buffer itself */
+    } else {
+        chan_cfg.auto_clear = true;
+    }
 
-    esp_err_t ret = i2s_new_channel(&chan_cfg, &s_i2s_tx, NULL);
+    bool want_rx = s_config.input_enable && s_config.i2s_din_pin >= 0;
+    esp_err_t ret = i2s_new_channel(&chan_cfg, &s_i2s_tx, want_rx ? &s_i2s_rx : NULL);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "I2S channel create failed: %s", esp_err_to_name(ret));
         return ret;
     }
 
+    if (s_output_mode == HAL_AUDIO_OUTPUT_DMA_RING) {
+        audio_buffer_init(&s_ring, s_ring_storage, HAL_AUDIO_RING_SAMPLES);
+        i2s_event_callbacks_t cbs = {
+            .on_sent = i2s_on_sent,
+        };
+        ret = i2s_channel_register_event_callback(s_i2s_tx, &cbs, NULL);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "I2S on_sent registration failed (%s), using codec write",
+                     esp_err_to_name(ret));
+            s_output_mode = HAL_AUDIO_OUTPUT_CODEC_WRITE;
+#ifdef CONFIG_KEYER_RT_IRAM
+            ESP_LOGE(TAG, "KEYER_RT_IRAM: sidetone muted without the DMA ring");
+#endif
+        }
+    }
+
+    i2s_slot_mode_t slot_mode = (s_output_mode == HAL_AUDIO_OUTPUT_DMA_RING)
+                                    ? I2S_SLOT_MODE_MONO : I2S_SLOT_MODE_STEREO;
     i2s_std_config_t std_cfg = {
         .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(s_config.sample_rate),
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, slot_mode),
         .gpio_cfg = {
             .mclk = s_config.i2s_mclk_pin,
             .bclk = s_config.i2s_bclk_pin,
             .ws = s_config.i2s_lrck_pin,
             .dout = s_config.i2s_dout_pin,
-            .din = GPIO_NUM_NC,
+            .din = want_rx ? s_config.i2s_din_pin : GPIO_NUM_NC,
             .invert_flags = {
                 .mclk_inv = false,
                 .bclk_inv = false,
@@ -142,10 +298,28 @@ static esp_err_t init_i2s(void) {
         return ret;
     }
 
-    ESP_LOGI(TAG, "I2S initialized (MCLK=%d, BCLK=%d, LRCK=%d, DOUT=%d, rate=%lu)",
+    /* Input: mono left slot (the codec ADC), independent of the TX mode */
+    if (s_i2s_rx != NULL) {
+        std_cfg.slot_cfg = (i2s_std_slot_config_t)I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(
+            I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO);
+        ret = i2s_channel_init_std_mode(s_i2s_rx, &std_cfg);
+        if (ret == ESP_OK) {
+            ret = i2s_channel_enable(s_i2s_rx);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "I2S RX unavailable (%s), audio input off", esp_err_to_name(ret));
+            i2s_del_channel(s_i2s_rx);
+            s_i2s_rx = NULL;
+        } else {
+            ESP_LOGI(TAG, "I2S RX initialized (DIN=%d)", s_config.i2s_din_pin);
+        }
+    }
+
+    ESP_LOGI(TAG, "I2S initialized (MCLK=%d, BCLK=%d, LRCK=%d, DOUT=%d, rate=%lu, %s)",
              s_config.i2s_mclk_pin, s_config.i2s_bclk_pin,
              s_config.i2s_lrck_pin, s_config.i2s_dout_pin,
-             (unsigned long)s_config.sample_rate);
+             (unsigned long)s_config.sample_rate,
+             hal_audio_output_mode_str(s_output_mode));
     return ESP_OK;
 }
 
@@ -170,7 +344,7 @@ static esp_err_t init_codec(void) {
     /* Create I2S data interface */
     audio_codec_i2s_cfg_t i2s_cfg = {
         .port = I2S_NUM_0,
-        .rx_handle = NULL,
+        .rx_handle = NULL,  /* RX is read directly: the device must not reformat it */
         .tx_handle = s_i2s_tx,
     };
     s_data_if = audio_codec_new_i2s_data(&i2s_cfg);
@@ -190,8 +364,9 @@ static esp_err_t init_codec(void) {
     es8311_codec_cfg_t es_cfg = {
         .ctrl_if = s_ctrl_if,
         .gpio_if = s_gpio_if,
-        .codec_mode = ESP_CODEC_DEV_WORK_MODE_DAC,
-        .pa_pin = -1,  /* PA managed separately via TCA9555 */
+        .codec_mode = (s_i2s_rx != NULL) ? ESP_CODEC_DEV_WORK_MODE_BOTH
+                                         : ESP_CODEC_DEV_WORK_MODE_DAC,
+        .pa_pin = -1,  /* PA managed separately (TCA9555 or GPIO) */
         .pa_reverted = false,
         .master_mode = false,
         .use_mclk = (s_config.i2s_mclk_pin >= 0),
@@ -225,10 +400,13 @@ static esp_err_t init_codec(void) {
     }
 
     /* Configure sample info */
+    /* DMA_RING runs I2S in mono slot mode; keep the codec format in step */
+    bool mono = (s_output_mode == HAL_AUDIO_OUTPUT_DMA_RING);
     esp_codec_dev_sample_info_t sample_info = {
         .bits_per_sample = 16,
-        .channel = 2,  /* Stereo */
-        .channel_mask = ESP_CODEC_DEV_MAKE_CHANNEL_MASK(0) | ESP_CODEC_DEV_MAKE_CHANNEL_MASK(1),
+        .channel = mono ? 1 : 2,
+        .channel_mask = mono ? ESP_CODEC_DEV_MAKE_CHANNEL_MASK(0)
+                             : (ESP_CODEC_DEV_MAKE_CHANNEL_MASK(0) | ESP_CODEC_DEV_MAKE_CHANNEL_MASK(1)),
         .sample_rate = s_config.sample_rate,
         .mclk_multiple = 0,  /* Auto */
     };
@@ -240,6 +418,9 @@ static esp_err_t init_codec(void) {
     /* Set initial volume but keep MUTED until PA is enabled */
     esp_codec_dev_set_out_mute(s_codec_dev, true);  /* Start muted */
     esp_codec_dev_set_out_vol(s_codec_dev, (int)s_config.volume_percent);
+    if (s_i2s_rx != NULL && s_codec_if->set_mic_gain != NULL) {
+        s_codec_if->set_mic_gain(s_codec_if, s_config.input_gain_db);  /* ADC runs in BOTH mode */
+    }
 
     ESP_LOGI(TAG, "ES8311 codec initialized (volume=%d%%, muted)", s_config.volume_percent);
     return ESP_OK;
@@ -251,7 +432,14 @@ esp_err_t hal_audio_init(const hal_audio_config_t *config) {
     }
 
     s_config = *config;
-    s_audio_available = false;
+    atomic_store_explicit(&s_audio_available, false, memory_order_relaxed);
+    s_output_mode = config->output_mode;
+#ifdef CONFIG_KEYER_RT_IRAM
+    if (s_output_mode != HAL_AUDIO_OUTPUT_DMA_RING) {
+        ESP_LOGW(TAG, "KEYER_RT_IRAM: codec write unavailable, using DMA ring");
+        s_output_mode = HAL_AUDIO_OUTPUT_DMA_RING;
+    }
+#endif
 
     /* Step 1: Initialize I2C bus */
     esp_err_t ret = init_i2c();
@@ -260,10 +448,10 @@ esp_err_t hal_audio_init(const hal_audio_config_t *config) {
         return ESP_OK;  /* Don't block boot */
     }
 
-    /* Step 2: Initialize TCA9555 IO expander */
+    /* Step 2: Initialize PA control (TCA9555 IO expander or GPIO) */
     ret = init_io_expander();
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "IO expander init failed, PA control unavailable");
+        ESP_LOGW(TAG, "PA control init failed, PA control unavailable");
         /* Continue - PA control is not critical */
     }
 
@@ -281,17 +469,17 @@ esp_err_t hal_audio_init(const hal_audio_config_t *config) {
         return ESP_OK;  /* Don't block boot */
     }
 
-    s_audio_available = true;
+    atomic_store_explicit(&s_audio_available, true, memory_order_release);
     ESP_LOGI(TAG, "Audio HAL initialized (sample_rate=%lu)",
              (unsigned long)s_config.sample_rate);
     return ESP_OK;
 }
 
-size_t hal_audio_write(const int16_t *samples, size_t count) {
-    if (!s_audio_available || s_codec_dev == NULL) {
-        return count;  /* Silently discard */
-    }
-
+#ifndef CONFIG_KEYER_RT_IRAM
+/**
+ * @brief Blocking write through the codec device (CODEC_WRITE mode)
+ */
+static size_t codec_write(const int16_t *samples, size_t count) {
     /* Convert mono to stereo for ES8311 */
     static int16_t stereo_buf[256];  /* 128 mono samples max */
     size_t to_write = count > 128 ? 128 : count;
@@ -327,6 +515,24 @@ size_t hal_audio_write(const int16_t *samples, size_t count) {
 
     return to_write;
 }
+#endif
+
+size_t hal_audio_write(const int16_t *samples, size_t count) {
+    if (!atomic_load_explicit(&s_audio_available, memory_order_acquire) || s_codec_dev == NULL) {
+        return count;  /* Silently discard */
+    }
+
+    if (s_output_mode == HAL_AUDIO_OUTPUT_DMA_RING) {
+        return ring_write(samples, count);  /* Never blocks */
+    }
+
+#ifdef CONFIG_KEYER_RT_IRAM
+    /* esp_codec_dev runs from flash: not callable from the IRAM RT path */
+    return count;
+#else
+    return codec_write(samples, count);
+#endif
+}
 
 esp_err_t hal_audio_set_volume(uint8_t volume_percent) {
     if (s_codec_dev == NULL) {
@@ -346,8 +552,20 @@ esp_err_t hal_audio_set_volume(uint8_t volume_percent) {
     return ESP_OK;
 }
 
+/**
+ * @brief Drive the PA enable, on the expander or the GPIO
+ */
+static esp_err_t pa_write(bool on) {
+    uint32_t level = (on == s_config.pa_active_high) ? 1U : 0U;
+    if (s_pa_gpio) {
+        return gpio_set_level((gpio_num_t)s_config.pa_pin, level);
+    }
+    uint32_t pa_mask = (1u << (uint32_t)s_config.pa_pin);
+    return esp_io_expander_set_level(s_io_expander, pa_mask, level);
+}
+
 esp_err_t hal_audio_set_pa(bool enable) {
-    if (s_io_expander == NULL) {
+    if (s_io_expander == NULL && !s_pa_gpio) {
         return ESP_ERR_INVALID_STATE;
     }
 
@@ -358,9 +576,7 @@ esp_err_t hal_audio_set_pa(bool enable) {
     /* Enable PA first, THEN unmute codec (reverse order when disabling) */
     if (enable) {
         /* Step 1: Enable PA */
-        uint32_t pa_mask = (1u << (uint32_t)s_config.pa_pin);
-        uint8_t level = s_config.pa_active_high ? 1 : 0;
-        esp_err_t ret = esp_io_expander_set_level(s_io_expander, pa_mask, level);
+        esp_err_t ret = pa_write(true);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Failed to enable PA: %s", esp_err_to_name(ret));
             return ret;
@@ -378,9 +594,7 @@ esp_err_t hal_audio_set_pa(bool enable) {
         }
 
         /* Step 2: Disable PA */
-        uint32_t pa_mask = (1u << (uint32_t)s_config.pa_pin);
-        uint8_t level = s_config.pa_active_high ? 0 : 1;
-        esp_err_t ret = esp_io_expander_set_level(s_io_expander, pa_mask, level);
+        esp_err_t ret = pa_write(false);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Failed to disable PA: %s", esp_err_to_name(ret));
             return ret;
@@ -404,8 +618,42 @@ void hal_audio_stop(void) {
     }
 }
 
+void hal_audio_standby(bool standby) {
+    if (standby == s_standby || s_i2s_tx == NULL) {
+        return;
+    }
+    if (standby) {
+        s_pa_before_standby = s_pa_enabled;
+        (void)hal_audio_set_pa(false);
+        i2s_channel_disable(s_i2s_tx);
+        /* Channel stopped: the silence that follows is not an underrun */
+        atomic_store_explicit(&s_ring_primed, false, memory_order_relaxed);
+    } else {
+        /* No DMA callbacks while disabled: the ring is ours to clear */
+        audio_buffer_clear(&s_ring);
+        i2s_channel_enable(s_i2s_tx);
+        if (s_pa_before_standby) {
+            (void)hal_audio_set_pa(true);
+        }
+    }
+    s_standby = standby;
+}
+
 bool hal_audio_is_available(void) {
-    return s_audio_available;
+    return atomic_load_explicit(&s_audio_available, memory_order_acquire);
+}
+
+size_t hal_audio_read(int16_t *samples, size_t count, uint32_t timeout_ms) {
+    if (!atomic_load_explicit(&s_audio_available, memory_order_acquire) || s_i2s_rx == NULL) {
+        return 0;
+    }
+    size_t bytes = 0;
+    i2s_channel_read(s_i2s_rx, samples, count * sizeof(int16_t), &bytes, timeout_ms);
+    return bytes / sizeof(int16_t);
+}
+
+bool hal_audio_input_available(void) {
+    return atomic_load_explicit(&s_audio_available, memory_order_acquire) && s_i2s_rx != NULL;
 }
 
 #else
@@ -414,12 +662,20 @@ bool hal_audio_is_available(void) {
 static bool s_available = false;
 
 esp_err_t hal_audio_init(const hal_audio_config_t *config) {
-    (void)config;
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_output_mode = config->output_mode;
+    atomic_store(&s_ring_primed, false);
+    audio_buffer_init(&s_ring, s_ring_storage, HAL_AUDIO_RING_SAMPLES);
     s_available = true;
     return ESP_OK;
 }
 
 size_t hal_audio_write(const int16_t *samples, size_t count) {
+    if (s_output_mode == HAL_AUDIO_OUTPUT_DMA_RING) {
+        return ring_write(samples, count);
+    }
     (void)samples;
     return count;
 }
@@ -436,6 +692,24 @@ esp_err_t hal_audio_set_pa(bool enable) {
 
 void hal_audio_start(void) {}
 void hal_audio_stop(void) {}
+
+void hal_audio_standby(bool standby) {
+    if (standby) {
+        atomic_store(&s_ring_primed, false);
+    } else {
+        audio_buffer_clear(&s_ring);
+    }
+}
+
 bool hal_audio_is_available(void) { return s_available; }
 
+size_t hal_audio_read(int16_t *samples, size_t count, uint32_t timeout_ms) {
+    (void)samples;
+    (void)count;
+    (void)timeout_ms;
+    return 0;
+}
+
+bool hal_audio_input_available(void) { return false; }
+
 #endif /* ESP_PLATFORM */
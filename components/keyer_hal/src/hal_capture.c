@@ -0,0 +1,128 @@
+/**
+ * @file hal_capture.c
+ * @brief MCPWM capture of paddle edges implementation
+ *
+ * One capture timer on MCPWM group 0 counts at its clock source rate; the
+ * two channels latch it on either edge of their pin. Both channels share
+ * the group interrupt on one core, so their callbacks never run at the
+ * same time and the raw queue and the timebase have a single producer.
+ */
+
+#include "hal_capture.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if defined(ESP_PLATFORM) && defined(CONFIG_KEYER_PADDLE_CAPTURE)
+
+#include "driver/mcpwm_cap.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "paddle_capture.h"
+
+static const char *TAG = "hal_capture";
+
+static paddle_edge_queue_t s_raw;
+static paddle_capture_clock_t s_clock;
+static bool s_active_low = true;
+
+static mcpwm_cap_timer_handle_t s_timer = NULL;
+static mcpwm_cap_channel_handle_t s_chan[2] = { NULL, NULL };
+
+static bool IRAM_ATTR on_capture(mcpwm_cap_channel_handle_t chan,
+                                 const mcpwm_capture_event_data_t *edata, void *user_ctx) {
+    (void)chan;
+    int64_t now_us = esp_timer_get_time();
+    bool high = edata->cap_edge == MCPWM_CAP_EDGE_POS;
+
+    paddle_edge_t edge = {
+        .timestamp_us = paddle_capture_clock_us(&s_clock, edata->cap_value, now_us),
+        .paddle = (uint8_t)(uintptr_t)user_ctx,
+        .level = (high != s_active_low) ? 1U : 0U,
+    };
+    paddle_edge_push(&s_raw, &edge);
+    return false;
+}
+
+static esp_err_t add_channel(paddle_edge_paddle_t paddle, uint8_t pin) {
+    mcpwm_capture_channel_config_t cfg = {
+        .gpio_num = pin,
+        .prescale = 1,
+        .flags.pos_edge = true,
+        .flags.neg_edge = true,
+    };
+    esp_err_t ret = mcpwm_new_capture_channel(s_timer, &cfg, &s_chan[paddle]);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    mcpwm_capture_event_callbacks_t cbs = { .on_cap = on_capture };
+    ret = mcpwm_capture_channel_register_event_callbacks(s_chan[paddle], &cbs,
+                                                         (void *)(uintptr_t)paddle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return mcpwm_capture_channel_enable(s_chan[paddle]);
+}
+
+esp_err_t hal_capture_init(uint8_t dit_pin, uint8_t dah_pin, bool active_low) {
+    paddle_edge_queue_init(&s_raw);
+    s_active_low = active_low;
+
+    mcpwm_capture_timer_config_t timer_cfg = {
+        .group_id = 0,
+        .clk_src = MCPWM_CAPTURE_CLK_SRC_DEFAULT,
+    };
+    esp_err_t ret = mcpwm_new_capture_timer(&timer_cfg, &s_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Capture timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    uint32_t resolution_hz = 0;
+    mcpwm_capture_timer_get_resolution(s_timer, &resolution_hz);
+    paddle_capture_clock_init(&s_clock, resolution_hz);
+
+    ret = add_channel(PADDLE_EDGE_DIT, dit_pin);
+    if (ret == ESP_OK) {
+        ret = add_channel(PADDLE_EDGE_DAH, dah_pin);
+    }
+    if (ret == ESP_OK) {
+        ret = mcpwm_capture_timer_enable(s_timer);
+    }
+    if (ret == ESP_OK) {
+        ret = mcpwm_capture_timer_start(s_timer);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Capture channels: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "MCPWM paddle capture on GPIO%u/%u (%luHz)",
+             (unsigned)dit_pin, (unsigned)dah_pin, (unsigned long)resolution_hz);
+    return ESP_OK;
+}
+
+paddle_edge_queue_t *hal_capture_queue(void) {
+    return &s_raw;
+}
+
+#else
+/* Capture not built in (or host build): hal_gpio uses the GPIO ISR */
+
+static paddle_edge_queue_t s_raw;
+
+esp_err_t hal_capture_init(uint8_t dit_pin, uint8_t dah_pin, bool active_low) {
+    (void)dit_pin;
+    (void)dah_pin;
+    (void)active_low;
+    paddle_edge_queue_init(&s_raw);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+paddle_edge_queue_t *hal_capture_queue(void) {
+    return &s_raw;
+}
+
+#endif
@@ -4,14 +4,42 @@
  *
  * ISR + Blanking Strategy (ISR-safe design):
  * 1. GPIO interrupt triggers on falling edge (paddle press)
- * 2. ISR sets atomic flags and disables interrupt (ISR-safe ops only)
+ * 2. ISR timestamps the edge into the paddle edge queue, sets atomic flags
+ *    and disables interrupt (ISR-safe ops only)
  * 3. RT task (via hal_gpio_isr_tick) starts blanking timer (task context)
  * 4. Blanking timer callback re-enables interrupt after blanking period
- * 5. RT task reads atomic flag to detect press
+ * 5. RT task drains the edge queue into the iambic FSM (exact edge time)
  *
  * Key insight: esp_timer_start_once() is NOT ISR-safe (uses spinlocks).
  * Solution: ISR sets a flag, RT task starts the timer from task context.
  * This adds ~1ms latency to blanking start but avoids crashes.
+ *
+ * Idle sleep (hal_gpio_wait_press): the paddle interrupts are switched to
+ * level type with GPIO wakeup for the wait, and the ISR also notifies the
+ * waiting task. The ISR still disables its interrupt on the first hit, so
+ * a held paddle cannot storm; edge type is restored before blanking ends.
+ *
+ * With CONFIG_KEYER_ULP_PADDLE (hal_ulp.h) the ULP samples the pins for
+ * the wait instead: the paddle interrupts stay off, an idle hook notifies
+ * the waiting task once the ULP reports a press, and the press is queued
+ * here with the time the ULP first saw it, then blanked like an ISR edge.
+ *
+ * With CONFIG_KEYER_PADDLE_CAPTURE (hal_capture.h) neither ISR nor timers
+ * are used for keying: MCPWM capture channels timestamp every edge in
+ * hardware, and hal_gpio_collect_edges debounces the batch in the RT task
+ * (paddle_capture.h) into the same edge queue. The GPIO interrupt is only
+ * armed for the idle sleep wait, to wake the chip.
+ *
+ * With CONFIG_KEYER_PADDLE_TOUCH (hal_touch.h) and the paddle pins on touch
+ * pads, the touch sensor takes them instead: its ISR queues every change
+ * in what is touched, debounced the same way, and the paddle state is what
+ * the sensor last reported. Tried first; contact backends are the fallback.
+ *
+ * TX output: hal_gpio_set_tx writes the pin at once. With
+ * CONFIG_KEYER_TX_TIMED (hal_tx_timer.h) the RT task can instead plan each
+ * edge a tick ahead with hal_gpio_set_tx_at, and a timer alarm writes it.
+ * With a radio 2 pin (SO2R) both are outputs and hal_gpio_select_tx picks
+ * the one keyed; the other is held unkeyed.
  */
 
 #include "hal_gpio.h"
@@ -22,12 +50,24 @@
 #include "esp_private/gpio.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_sleep.h"
+#include "esp_freertos_hooks.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hal_ulp.h"
+#include "hal_capture.h"
+#include "hal_touch.h"
+#include "paddle_capture.h"
+#include "hal_tx_timer.h"
 #include <stdatomic.h>
 
 static const char *TAG = "hal_gpio";
 static hal_gpio_config_t s_config = HAL_GPIO_CONFIG_DEFAULT;
 static bool s_tx_state = false;
+static bool s_tx_timed = false;
 static bool s_isr_enabled = false;
+static uint8_t s_tx_pin = 6;        /* Output of the radio in focus */
+static uint8_t s_tx_count = 1;
 
 /* ============================================================================
  * ISR State (atomic communication with RT task)
@@ -37,6 +77,9 @@ static bool s_isr_enabled = false;
 static volatile atomic_bool s_dit_pending = ATOMIC_VAR_INIT(false);
 static volatile atomic_bool s_dah_pending = ATOMIC_VAR_INIT(false);
 
+/* Timestamped press edges (ISR producer, RT task consumer) */
+static paddle_edge_queue_t s_edge_queue;
+
 /* Flags to signal RT task to start blanking timers (ISR-safe handoff) */
 static volatile atomic_bool s_dit_needs_blanking = ATOMIC_VAR_INIT(false);
 static volatile atomic_bool s_dah_needs_blanking = ATOMIC_VAR_INIT(false);
@@ -49,6 +92,24 @@ static volatile int64_t s_dah_disabled_at_us = 0;
 static esp_timer_handle_t s_dit_blanking_timer = NULL;
 static esp_timer_handle_t s_dah_blanking_timer = NULL;
 
+/* Task blocked in hal_gpio_wait_press (NULL when nobody waits) */
+static TaskHandle_t volatile s_wait_task = NULL;
+
+/* ULP samples the paddles during the wait (hal_ulp.h) */
+static bool s_ulp_ready = false;
+static bool ulp_idle_hook(void);
+
+/* Edges come from MCPWM capture (hal_capture.h), debounced by the RT task */
+static bool s_capture = false;
+static bool s_capture_wake = false;
+static paddle_debounce_t s_debounce;
+
+/* Edges come from the touch sensor (hal_touch.h), debounced likewise */
+static bool s_touch = false;
+
+/* ISR time of the press that ended a capture-mode wait (0 = none) */
+static volatile int64_t s_wake_at_us[2] = { 0, 0 };
+
 /* ============================================================================
  * ISR Handlers (IRAM_ATTR - must be in internal RAM)
  *
@@ -62,8 +123,24 @@ static esp_timer_handle_t s_dah_blanking_timer = NULL;
  * - ESP_LOGx (uses locks)
  * ============================================================================ */
 
+static void IRAM_ATTR notify_waiter(void) {
+    TaskHandle_t task = s_wait_task;
+    if (task != NULL) {
+        BaseType_t high_task_woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &high_task_woken);
+        if (high_task_woken == pdTRUE) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
 static void IRAM_ATTR dit_isr_handler(void *arg) {
     (void)arg;
+    int64_t now_us = esp_timer_get_time();
+
+    /* Record exact edge time for the iambic FSM */
+    paddle_edge_t edge = { .timestamp_us = now_us, .paddle = PADDLE_EDGE_DIT, .level = 1 };
+    paddle_edge_push(&s_edge_queue, &edge);
 
     /* Set pending flag for RT task */
     atomic_store_explicit(&s_dit_pending, true, memory_order_release);
@@ -72,19 +149,34 @@ static void IRAM_ATTR dit_isr_handler(void *arg) {
     gpio_intr_disable((gpio_num_t)s_config.dit_pin);
 
     /* Record when we disabled (for watchdog) */
-    s_dit_disabled_at_us = esp_timer_get_time();
+    s_dit_disabled_at_us = now_us;
 
     /* Signal RT task to start blanking timer */
     atomic_store_explicit(&s_dit_needs_blanking, true, memory_order_release);
+    notify_waiter();
 }
 
 static void IRAM_ATTR dah_isr_handler(void *arg) {
     (void)arg;
+    int64_t now_us = esp_timer_get_time();
+
+    paddle_edge_t edge = { .timestamp_us = now_us, .paddle = PADDLE_EDGE_DAH, .level = 1 };
+    paddle_edge_push(&s_edge_queue, &edge);
 
     atomic_store_explicit(&s_dah_pending, true, memory_order_release);
     gpio_intr_disable((gpio_num_t)s_config.dah_pin);
-    s_dah_disabled_at_us = esp_timer_get_time();
+    s_dah_disabled_at_us = now_us;
     atomic_store_explicit(&s_dah_needs_blanking, true, memory_order_release);
+    notify_waiter();
+}
+
+/* Capture mode: idle sleep wakeup only, the edge itself comes from capture */
+static void IRAM_ATTR wake_isr_handler(void *arg) {
+    uintptr_t paddle = (uintptr_t)arg;
+    gpio_intr_disable((gpio_num_t)(paddle == PADDLE_EDGE_DIT ? s_config.dit_pin
+                                                               : s_config.dah_pin));
+    s_wake_at_us[paddle & 1U] = esp_timer_get_time();
+    notify_waiter();
 }
 
 /* ============================================================================
@@ -110,6 +202,8 @@ static void dah_blanking_expired(void *arg) {
 static esp_err_t init_isr(void) {
     esp_err_t ret;
 
+    paddle_edge_queue_init(&s_edge_queue);
+
     /* Create blanking timers */
     esp_timer_create_args_t dit_timer_args = {
         .callback = dit_blanking_expired,
@@ -165,6 +259,68 @@ static esp_err_t init_isr(void) {
     return ESP_OK;
 }
 
+static esp_err_t init_capture(void) {
+    gpio_num_t dit = (gpio_num_t)s_config.dit_pin;
+    gpio_num_t dah = (gpio_num_t)s_config.dah_pin;
+
+    esp_err_t ret = hal_capture_init(s_config.dit_pin, s_config.dah_pin, s_config.active_low);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    paddle_edge_queue_init(&s_edge_queue);
+    paddle_debounce_init(&s_debounce, s_config.isr_blanking_us);
+    gpio_intr_disable(dit);
+    gpio_intr_disable(dah);
+    gpio_set_intr_type(dit, GPIO_INTR_DISABLE);
+    gpio_set_intr_type(dah, GPIO_INTR_DISABLE);
+    s_capture = true;
+    s_isr_enabled = true;
+
+    /* Wake handlers for the idle sleep; keying works without them */
+    ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (ret == ESP_OK || ret == ESP_ERR_INVALID_STATE) {
+        ret = gpio_isr_handler_add(dit, wake_isr_handler, (void *)(uintptr_t)PADDLE_EDGE_DIT);
+    }
+    if (ret == ESP_OK) {
+        ret = gpio_isr_handler_add(dah, wake_isr_handler, (void *)(uintptr_t)PADDLE_EDGE_DAH);
+    }
+    s_capture_wake = (ret == ESP_OK);
+    if (!s_capture_wake) {
+        ESP_LOGW(TAG, "Paddle wake handlers: %s, idle sleep polls", esp_err_to_name(ret));
+    }
+
+    ESP_LOGI(TAG, "Capture paddle detection enabled (debounce=%luus)",
+             (unsigned long)s_config.isr_blanking_us);
+    return ESP_OK;
+}
+
+static esp_err_t init_touch(void) {
+    gpio_num_t dit = (gpio_num_t)s_config.dit_pin;
+    gpio_num_t dah = (gpio_num_t)s_config.dah_pin;
+
+    esp_err_t ret = hal_touch_init(s_config.dit_pin, s_config.dah_pin,
+                                   s_config.touch_threshold_pct, s_config.touch_latency_us,
+                                   notify_waiter);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    gpio_intr_disable(dit);
+    gpio_intr_disable(dah);
+    gpio_set_intr_type(dit, GPIO_INTR_DISABLE);
+    gpio_set_intr_type(dah, GPIO_INTR_DISABLE);
+
+    paddle_edge_queue_init(&s_edge_queue);
+    paddle_debounce_init(&s_debounce, s_config.isr_blanking_us);
+    s_touch = true;
+    s_isr_enabled = true;
+
+    ESP_LOGI(TAG, "Touch paddle detection enabled (debounce=%luus)",
+             (unsigned long)s_config.isr_blanking_us);
+    return ESP_OK;
+}
+
 /* ============================================================================
  * GPIO Reset Helper
  * ============================================================================ */
@@ -230,14 +386,37 @@ void hal_gpio_init(const hal_gpio_config_t *config) {
     };
     err = gpio_config(&tx_conf);
     ESP_LOGI(TAG, "TX GPIO%d config: %s", config->tx_pin, esp_err_to_name(err));
+    s_tx_pin = config->tx_pin;
+
+    /* Radio 2 output, held unkeyed until selected */
+    s_tx_count = 1;
+    if (config->tx2_pin != 0 && config->tx2_pin != config->tx_pin &&
+        config->tx2_pin != config->dit_pin && config->tx2_pin != config->dah_pin) {
+        tx_conf.pin_bit_mask = 1ULL << config->tx2_pin;
+        err = gpio_config(&tx_conf);
+        ESP_LOGI(TAG, "TX2 GPIO%d config: %s", config->tx2_pin, esp_err_to_name(err));
+        if (err == ESP_OK) {
+            gpio_set_level(config->tx2_pin, config->tx_active_high ? 0U : 1U);
+            s_tx_count = 2;
+        }
+    }
 
     hal_gpio_set_tx(false);
+    s_tx_timed = (hal_tx_timer_init(config->tx_pin) == ESP_OK);
 
-    /* Initialize ISR if configured */
+    /* Initialize touch, capture or ISR if configured */
     if (config->isr_blanking_us > 0) {
-        err = init_isr();
-        if (err != ESP_OK) {
+        if (init_touch() == ESP_OK) {
+            /* Touch sensor owns the pins; its ISR wakes the idle sleep */
+        } else if (init_capture() == ESP_OK) {
+            /* Debounced in hal_gpio_collect_edges; no ULP, it would take the pins */
+        } else if (init_isr() != ESP_OK) {
             ESP_LOGW(TAG, "ISR init failed, using polling only");
+        } else if (hal_ulp_paddle_init(config->dit_pin, config->dah_pin,
+                                       config->active_low) == ESP_OK &&
+                   esp_register_freertos_idle_hook_for_cpu(ulp_idle_hook, 0) == ESP_OK) {
+            /* Idle sleep waits on the ULP instead of GPIO wakeup */
+            s_ulp_ready = true;
         }
     } else {
         ESP_LOGI(TAG, "ISR disabled, using polling only");
@@ -249,6 +428,12 @@ void hal_gpio_init(const hal_gpio_config_t *config) {
 }
 
 gpio_state_t hal_gpio_read_paddles(void) {
+    if (s_touch) {
+        uint8_t touched = hal_touch_levels();
+        return gpio_from_paddles((touched & (1U << PADDLE_EDGE_DIT)) != 0U,
+                                 (touched & (1U << PADDLE_EDGE_DAH)) != 0U);
+    }
+
     int dit_level = gpio_get_level((gpio_num_t)s_config.dit_pin);
     int dah_level = gpio_get_level((gpio_num_t)s_config.dah_pin);
 
@@ -258,16 +443,53 @@ gpio_state_t hal_gpio_read_paddles(void) {
     return gpio_from_paddles(dit_pressed, dah_pressed);
 }
 
+static uint32_t tx_pin_level(bool on) {
+    return s_config.tx_active_high ? (on ? 1U : 0U) : (on ? 0U : 1U);
+}
+
 void hal_gpio_set_tx(bool on) {
+    if (s_tx_timed) {
+        hal_tx_timer_cancel();
+    }
     s_tx_state = on;
-    uint32_t level = s_config.tx_active_high ? (on ? 1U : 0U) : (on ? 0U : 1U);
-    gpio_set_level(s_config.tx_pin, level);
+    gpio_set_level(s_tx_pin, tx_pin_level(on));
+}
+
+void hal_gpio_set_tx_at(bool on, int64_t at_us) {
+    if (!s_tx_timed) {
+        hal_gpio_set_tx(on);
+        return;
+    }
+    s_tx_state = on;
+    hal_tx_timer_arm(tx_pin_level(on), at_us);
+}
+
+bool hal_gpio_tx_timed(void) {
+    return s_tx_timed;
 }
 
 bool hal_gpio_get_tx(void) {
     return s_tx_state;
 }
 
+uint8_t hal_gpio_tx_count(void) {
+    return s_tx_count;
+}
+
+void hal_gpio_select_tx(uint8_t radio) {
+    uint8_t pin = (radio == 0U) ? s_config.tx_pin : s_config.tx2_pin;
+    if (radio >= s_tx_count || pin == s_tx_pin) {
+        return;
+    }
+    if (s_tx_timed) {
+        hal_tx_timer_set_pin(pin);
+    }
+    gpio_set_level(s_tx_pin, tx_pin_level(false));
+    s_tx_pin = pin;
+    s_tx_state = false;
+    gpio_set_level(s_tx_pin, tx_pin_level(false));
+}
+
 hal_gpio_config_t hal_gpio_get_config(void) {
     return s_config;
 }
@@ -280,12 +502,41 @@ bool hal_gpio_consume_dah_press(void) {
     return atomic_exchange_explicit(&s_dah_pending, false, memory_order_acquire);
 }
 
+paddle_edge_queue_t *hal_gpio_edge_queue(void) {
+    return &s_edge_queue;
+}
+
 bool hal_gpio_isr_enabled(void) {
     return s_isr_enabled;
 }
 
+void hal_gpio_collect_edges(int64_t now_us) {
+    if (!s_capture && !s_touch) {
+        return;
+    }
+
+    paddle_edge_queue_t *raw = s_touch ? hal_touch_queue() : hal_capture_queue();
+    paddle_edge_t edge;
+    while (paddle_edge_pop(raw, &edge)) {
+        paddle_debounce_feed(&s_debounce, &edge, &s_edge_queue);
+    }
+    paddle_debounce_settle(&s_debounce, now_us, &s_edge_queue);
+
+    /* A settled paddle whose pin (touch: sensor state) disagrees lost an
+     * edge: overrun or full queue. It is stable there, take its level now */
+    gpio_state_t pins = hal_gpio_read_paddles();
+    for (uint8_t p = 0; p < 2; p++) {
+        uint8_t level = (p == PADDLE_EDGE_DIT ? gpio_dit(pins) : gpio_dah(pins)) ? 1U : 0U;
+        if (level != paddle_debounce_level(&s_debounce, p) &&
+            paddle_debounce_settled(&s_debounce, p, now_us)) {
+            paddle_edge_t fix = { .timestamp_us = now_us, .paddle = p, .level = level };
+            paddle_debounce_feed(&s_debounce, &fix, &s_edge_queue);
+        }
+    }
+}
+
 void hal_gpio_isr_tick(int64_t now_us) {
-    if (!s_isr_enabled) {
+    if (!s_isr_enabled || s_capture || s_touch) {
         return;
     }
 
@@ -316,6 +567,186 @@ void hal_gpio_isr_tick(int64_t now_us) {
     }
 }
 
+/* ============================================================================
+ * ULP Paddle Wait (CONFIG_KEYER_ULP_PADDLE)
+ * ============================================================================ */
+
+/**
+ * @brief Idle hook: wake the waiting task once the ULP reports a press
+ *
+ * The ULP ends the light sleep; the idle task runs this before it can
+ * sleep again.
+ */
+static bool ulp_idle_hook(void) {
+    TaskHandle_t task = s_wait_task;
+    if (task != NULL && hal_ulp_paddle_pending()) {
+        xTaskNotifyGive(task);
+    }
+    return true;
+}
+
+/**
+ * @brief Queue a ULP press as the ISR would have
+ */
+static void queue_ulp_press(paddle_edge_paddle_t paddle, int64_t edge_us, int64_t now_us) {
+    paddle_edge_t edge = { .timestamp_us = edge_us, .paddle = (uint8_t)paddle, .level = 1 };
+    paddle_edge_push(&s_edge_queue, &edge);
+    if (paddle == PADDLE_EDGE_DIT) {
+        atomic_store_explicit(&s_dit_pending, true, memory_order_release);
+        s_dit_disabled_at_us = now_us;
+        atomic_store_explicit(&s_dit_needs_blanking, true, memory_order_release);
+    } else {
+        atomic_store_explicit(&s_dah_pending, true, memory_order_release);
+        s_dah_disabled_at_us = now_us;
+        atomic_store_explicit(&s_dah_needs_blanking, true, memory_order_release);
+    }
+}
+
+static bool wait_press_ulp(uint32_t timeout_ms) {
+    gpio_num_t dit = (gpio_num_t)s_config.dit_pin;
+    gpio_num_t dah = (gpio_num_t)s_config.dah_pin;
+
+    /* The ISRs stay off while the pins belong to the RTC IO mux, so the
+     * edge queue has a single producer: this task, below */
+    gpio_intr_disable(dit);
+    gpio_intr_disable(dah);
+    s_wait_task = xTaskGetCurrentTaskHandle();
+    hal_ulp_paddle_start();
+
+    (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+
+    s_wait_task = NULL;
+    int64_t now_us = esp_timer_get_time();
+    hal_ulp_press_t press;
+    hal_ulp_paddle_stop(&press);
+
+    /* Oldest first; a reported paddle is re-enabled when its blanking ends */
+    bool dit_first = press.dit_age_us >= press.dah_age_us;
+    for (int i = 0; i < 2; i++) {
+        bool is_dit = (i == 0) == dit_first;
+        uint32_t bit = is_dit ? HAL_ULP_DIT : HAL_ULP_DAH;
+        if ((press.mask & bit) != 0U) {
+            uint32_t age = is_dit ? press.dit_age_us : press.dah_age_us;
+            queue_ulp_press(is_dit ? PADDLE_EDGE_DIT : PADDLE_EDGE_DAH,
+                            now_us - (int64_t)age, now_us);
+        }
+    }
+    if ((press.mask & HAL_ULP_DIT) == 0U) {
+        gpio_intr_enable(dit);
+    }
+    if ((press.mask & HAL_ULP_DAH) == 0U) {
+        gpio_intr_enable(dah);
+    }
+    return press.mask != 0U;
+}
+
+/* ============================================================================
+ * Capture Mode Wait (CONFIG_KEYER_PADDLE_CAPTURE)
+ * ============================================================================ */
+
+static bool wait_press_capture(uint32_t timeout_ms) {
+    gpio_num_t dit = (gpio_num_t)s_config.dit_pin;
+    gpio_num_t dah = (gpio_num_t)s_config.dah_pin;
+    gpio_int_type_t level = s_config.active_low ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL;
+
+    s_wake_at_us[PADDLE_EDGE_DIT] = 0;
+    s_wake_at_us[PADDLE_EDGE_DAH] = 0;
+    s_wait_task = xTaskGetCurrentTaskHandle();
+    gpio_wakeup_enable(dit, level);
+    gpio_wakeup_enable(dah, level);
+    esp_sleep_enable_gpio_wakeup();
+    gpio_intr_enable(dit);
+    gpio_intr_enable(dah);
+
+    uint32_t woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+
+    s_wait_task = NULL;
+    gpio_intr_disable(dit);
+    gpio_intr_disable(dah);
+    gpio_wakeup_disable(dit);
+    gpio_wakeup_disable(dah);
+    gpio_set_intr_type(dit, GPIO_INTR_DISABLE);
+    gpio_set_intr_type(dah, GPIO_INTR_DISABLE);
+
+    /* Awake, capture saw the edge; in light sleep only the wake ISR did.
+     * Capture first, then the wake time for a press it missed, oldest first */
+    paddle_edge_queue_t *raw = hal_capture_queue();
+    paddle_edge_t edge;
+    while (paddle_edge_pop(raw, &edge)) {
+        paddle_debounce_feed(&s_debounce, &edge, &s_edge_queue);
+    }
+    int64_t at[2] = { s_wake_at_us[PADDLE_EDGE_DIT], s_wake_at_us[PADDLE_EDGE_DAH] };
+    uint8_t first = (at[PADDLE_EDGE_DAH] != 0 &&
+                     (at[PADDLE_EDGE_DIT] == 0 || at[PADDLE_EDGE_DAH] < at[PADDLE_EDGE_DIT]))
+                        ? (uint8_t)PADDLE_EDGE_DAH : (uint8_t)PADDLE_EDGE_DIT;
+    for (uint8_t i = 0; i < 2; i++) {
+        uint8_t p = (uint8_t)(first ^ i);
+        if (at[p] != 0 && paddle_debounce_level(&s_debounce, p) == 0) {
+            paddle_edge_t press = { .timestamp_us = at[p], .paddle = p, .level = 1 };
+            paddle_debounce_feed(&s_debounce, &press, &s_edge_queue);
+        }
+    }
+    return woken > 0;
+}
+
+/* ============================================================================
+ * Touch Mode Wait (CONFIG_KEYER_PADDLE_TOUCH)
+ * ============================================================================ */
+
+static bool wait_press_touch(uint32_t timeout_ms) {
+    s_wait_task = xTaskGetCurrentTaskHandle();
+    esp_sleep_enable_touchpad_wakeup();
+
+    /* Waiter first: a touch from here on notifies; one already held
+     * raises no new interrupt */
+    uint32_t woken = (hal_touch_levels() != 0U)
+                         ? 1U : ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+
+    s_wait_task = NULL;
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TOUCHPAD);
+    return woken > 0;
+}
+
+bool hal_gpio_wait_press(uint32_t timeout_ms) {
+    if (s_touch) {
+        return wait_press_touch(timeout_ms);
+    }
+    if (s_ulp_ready) {
+        return wait_press_ulp(timeout_ms);
+    }
+    if (s_capture_wake) {
+        return wait_press_capture(timeout_ms);
+    }
+    if (!s_isr_enabled || s_capture) {
+        vTaskDelay(pdMS_TO_TICKS(timeout_ms));
+        return false;
+    }
+
+    gpio_num_t dit = (gpio_num_t)s_config.dit_pin;
+    gpio_num_t dah = (gpio_num_t)s_config.dah_pin;
+    gpio_int_type_t level = s_config.active_low ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL;
+    gpio_int_type_t edge = s_config.active_low ? GPIO_INTR_NEGEDGE : GPIO_INTR_POSEDGE;
+
+    s_wait_task = xTaskGetCurrentTaskHandle();
+    gpio_wakeup_enable(dit, level);
+    gpio_wakeup_enable(dah, level);
+    esp_sleep_enable_gpio_wakeup();
+
+    /* Level type: a paddle already held fires at once, no press is lost
+     * between the caller's idle check and here */
+    gpio_intr_enable(dit);
+    gpio_intr_enable(dah);
+
+    uint32_t woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+
+    s_wait_task = NULL;
+    gpio_wakeup_disable(dit);
+    gpio_wakeup_disable(dah);
+    gpio_set_intr_type(dit, edge);
+    gpio_set_intr_type(dah, edge);
+    return woken > 0;
+}
+
 #else
 /* ============================================================================
  * Host Stub Implementation
@@ -328,9 +759,11 @@ static gpio_state_t s_paddle_state = {0};
 static bool s_tx_state = false;
 static atomic_bool s_dit_pending = ATOMIC_VAR_INIT(false);
 static atomic_bool s_dah_pending = ATOMIC_VAR_INIT(false);
+static paddle_edge_queue_t s_edge_queue;
 
 void hal_gpio_init(const hal_gpio_config_t *config) {
     s_config = *config;
+    paddle_edge_queue_init(&s_edge_queue);
 }
 
 gpio_state_t hal_gpio_read_paddles(void) {
@@ -341,10 +774,28 @@ void hal_gpio_set_tx(bool on) {
     s_tx_state = on;
 }
 
+void hal_gpio_set_tx_at(bool on, int64_t at_us) {
+    (void)at_us;
+    s_tx_state = on;
+}
+
+bool hal_gpio_tx_timed(void) {
+    return false;
+}
+
 bool hal_gpio_get_tx(void) {
     return s_tx_state;
 }
 
+uint8_t hal_gpio_tx_count(void) {
+    return (s_config.tx2_pin != 0) ? 2U : 1U;
+}
+
+void hal_gpio_select_tx(uint8_t radio) {
+    (void)radio;
+    s_tx_state = false;
+}
+
 hal_gpio_config_t hal_gpio_get_config(void) {
     return s_config;
 }
@@ -357,14 +808,27 @@ bool hal_gpio_consume_dah_press(void) {
     return atomic_exchange(&s_dah_pending, false);
 }
 
+paddle_edge_queue_t *hal_gpio_edge_queue(void) {
+    return &s_edge_queue;
+}
+
 bool hal_gpio_isr_enabled(void) {
     return s_config.isr_blanking_us > 0;
 }
 
+void hal_gpio_collect_edges(int64_t now_us) {
+    (void)now_us;
+}
+
 void hal_gpio_isr_tick(int64_t now_us) {
     (void)now_us;
 }
 
+bool hal_gpio_wait_press(uint32_t timeout_ms) {
+    (void)timeout_ms;
+    return !paddle_edge_queue_empty(&s_edge_queue);
+}
+
 /* Test helpers */
 void hal_gpio_test_set_paddles(bool dit, bool dah) {
     s_paddle_state = gpio_from_paddles(dit, dah);
@@ -375,4 +839,13 @@ void hal_gpio_test_inject_isr_press(bool dit, bool dah) {
     if (dah) atomic_store(&s_dah_pending, true);
 }
 
+void hal_gpio_test_inject_edge(paddle_edge_paddle_t paddle, bool pressed, int64_t timestamp_us) {
+    paddle_edge_t edge = {
+        .timestamp_us = timestamp_us,
+        .paddle = (uint8_t)paddle,
+        .level = pressed ? 1 : 0,
+    };
+    paddle_edge_push(&s_edge_queue, &edge);
+}
+
 #endif /* ESP_PLATFORM */
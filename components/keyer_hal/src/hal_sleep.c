@@ -0,0 +1,23 @@
+/**
+ * @file hal_sleep.c
+ * @brief RT idle sleep implementation
+ *
+ * Order matters on the way out: the tick restarts last, so the first tick
+ * after the sleep is a full period after the output is back.
+ */
+
+#include "hal_sleep.h"
+#include "hal_tick.h"
+#include "hal_audio.h"
+#include "hal_gpio.h"
+
+bool hal_sleep_until_press(uint32_t timeout_ms) {
+    hal_tick_suspend();
+    hal_audio_standby(true);
+
+    bool pressed = hal_gpio_wait_press(timeout_ms);
+
+    hal_audio_standby(false);
+    hal_tick_resume();
+    return pressed;
+}
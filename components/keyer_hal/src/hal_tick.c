@@ -0,0 +1,313 @@
+/**
+ * @file hal_tick.c
+ * @brief RT loop pacing source implementation
+ *
+ * HW_TIMER strategy:
+ * 1. gptimer counts at 1 MHz with auto-reload alarm at period_us
+ * 2. Alarm ISR calls vTaskNotifyGiveFromISR() on the RT task (nothing else)
+ * 3. RT task blocks in ulTaskNotifyTake(); the returned count tells how many
+ *    periods elapsed, so count > 1 means ticks were missed
+ *
+ * Statistics are written only by the RT task (single writer) with relaxed
+ * atomics. Resets requested from Core 1 are applied by the RT task on its
+ * next wake, so there is never more than one writer.
+ */
+
+#include "hal_tick.h"
+#include <stddef.h>
+#include <stdatomic.h>
+
+/* ============================================================================
+ * Jitter Statistics (shared by target and host builds)
+ * ============================================================================ */
+
+/** Halve accumulators at this many wakes to keep the mean recent and bounded */
+#define STATS_DECAY_WAKES  (1U << 20)
+
+/* Pacing in use: written by the RT task at init, read from Core 1 (stats rt) */
+static atomic_int s_mode = ATOMIC_VAR_INIT(HAL_TICK_MODE_TASK_DELAY);
+static atomic_uint s_period_us = ATOMIC_VAR_INIT(HAL_TICK_MAX_PERIOD_US);
+
+static atomic_uint s_wakes = ATOMIC_VAR_INIT(0);
+static atomic_uint s_sum_abs_us = ATOMIC_VAR_INIT(0);
+static atomic_int s_min_us = ATOMIC_VAR_INIT(0);
+static atomic_int s_max_us = ATOMIC_VAR_INIT(0);
+static atomic_uint s_missed = ATOMIC_VAR_INIT(0);
+static atomic_uint s_timeouts = ATOMIC_VAR_INIT(0);
+static atomic_bool s_reset_requested = ATOMIC_VAR_INIT(false);
+
+static hal_tick_mode_t get_mode(void) {
+    return (hal_tick_mode_t)atomic_load_explicit(&s_mode, memory_order_relaxed);
+}
+
+static uint32_t get_period_us(void) {
+    return atomic_load_explicit(&s_period_us, memory_order_relaxed);
+}
+
+static void set_pacing(hal_tick_mode_t mode, uint32_t period_us) {
+    atomic_store_explicit(&s_mode, (int)mode, memory_order_relaxed);
+    atomic_store_explicit(&s_period_us, period_us, memory_order_relaxed);
+}
+
+/* Previous wake time (RT task only) */
+static int64_t s_prev_wake_us = 0;
+
+static void stats_clear(void) {
+    atomic_store_explicit(&s_wakes, 0, memory_order_relaxed);
+    atomic_store_explicit(&s_sum_abs_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&s_min_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&s_max_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&s_missed, 0, memory_order_relaxed);
+    atomic_store_explicit(&s_timeouts, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Record one wake (RT task only)
+ */
+static void stats_record_wake(int64_t now_us) {
+    if (atomic_exchange_explicit(&s_reset_requested, false, memory_order_relaxed)) {
+        stats_clear();
+        s_prev_wake_us = 0;
+    }
+
+    if (s_prev_wake_us > 0) {
+        int64_t err = (now_us - s_prev_wake_us) - (int64_t)get_period_us();
+        if (err > INT32_MAX) err = INT32_MAX;
+        if (err < -INT32_MAX) err = -INT32_MAX;
+        int32_t err32 = (int32_t)err;
+        uint32_t abs_err = (uint32_t)(err32 < 0 ? -err32 : err32);
+
+        uint32_t wakes = atomic_load_explicit(&s_wakes, memory_order_relaxed);
+        uint32_t sum = atomic_load_explicit(&s_sum_abs_us, memory_order_relaxed);
+        if (wakes >= STATS_DECAY_WAKES) {
+            wakes /= 2;
+            sum /= 2;
+        }
+
+        if (wakes == 0 || err32 < atomic_load_explicit(&s_min_us, memory_order_relaxed)) {
+            atomic_store_explicit(&s_min_us, err32, memory_order_relaxed);
+        }
+        if (wakes == 0 || err32 > atomic_load_explicit(&s_max_us, memory_order_relaxed)) {
+            atomic_store_explicit(&s_max_us, err32, memory_order_relaxed);
+        }
+
+        atomic_store_explicit(&s_sum_abs_us, sum + abs_err, memory_order_relaxed);
+        atomic_store_explicit(&s_wakes, wakes + 1, memory_order_relaxed);
+    }
+    s_prev_wake_us = now_us;
+}
+
+hal_tick_mode_t hal_tick_get_mode(void) {
+    return get_mode();
+}
+
+uint32_t hal_tick_get_period_us(void) {
+    return get_period_us();
+}
+
+const char *hal_tick_mode_str(hal_tick_mode_t mode) {
+    switch (mode) {
+        case HAL_TICK_MODE_TASK_DELAY: return "task_delay";
+        case HAL_TICK_MODE_HW_TIMER:   return "hw_timer";
+        default:                       return "unknown";
+    }
+}
+
+void hal_tick_get_stats(hal_tick_stats_t *out) {
+    if (out == NULL) {
+        return;
+    }
+    uint32_t wakes = atomic_load_explicit(&s_wakes, memory_order_relaxed);
+    uint32_t sum = atomic_load_explicit(&s_sum_abs_us, memory_order_relaxed);
+
+    out->mode = get_mode();
+    out->period_us = get_period_us();
+    out->wakes = wakes;
+    out->jitter_min_us = atomic_load_explicit(&s_min_us, memory_order_relaxed);
+    out->jitter_max_us = atomic_load_explicit(&s_max_us, memory_order_relaxed);
+    out->jitter_mean_us = (wakes > 0) ? (sum / wakes) : 0;
+    out->missed_ticks = atomic_load_explicit(&s_missed, memory_order_relaxed);
+    out->timeouts = atomic_load_explicit(&s_timeouts, memory_order_relaxed);
+}
+
+void hal_tick_reset_stats(void) {
+    atomic_store_explicit(&s_reset_requested, true, memory_order_relaxed);
+}
+
+static uint32_t clamp_period(uint32_t period_us) {
+    if (period_us < HAL_TICK_MIN_PERIOD_US) return HAL_TICK_MIN_PERIOD_US;
+    if (period_us > HAL_TICK_MAX_PERIOD_US) return HAL_TICK_MAX_PERIOD_US;
+    return period_us;
+}
+
+#ifdef ESP_PLATFORM
+/* ESP-IDF target build */
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gptimer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "hal_tick";
+
+/** Wait timeout in HW_TIMER mode (timer stalled → keep loop alive) */
+#define HW_WAIT_TIMEOUT_MS  10
+
+static TaskHandle_t s_rt_task = NULL;
+static gptimer_handle_t s_timer = NULL;
+static TickType_t s_last_wake = 0;
+
+/* ============================================================================
+ * Timer ISR (IRAM - notification only)
+ * ============================================================================ */
+
+static bool IRAM_ATTR tick_alarm_isr(gptimer_handle_t timer,
+                                     const gptimer_alarm_event_data_t *edata,
+                                     void *user_ctx) {
+    (void)timer;
+    (void)edata;
+    (void)user_ctx;
+
+    BaseType_t high_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_rt_task, &high_task_woken);
+    return high_task_woken == pdTRUE;
+}
+
+static esp_err_t init_hw_timer(uint32_t period_us) {
+    gptimer_config_t timer_cfg = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,  /* 1 count = 1µs */
+    };
+    esp_err_t ret = gptimer_new_timer(&timer_cfg, &s_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "gptimer_new_timer failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    gptimer_event_callbacks_t cbs = {
+        .on_alarm = tick_alarm_isr,
+    };
+    ret = gptimer_register_event_callbacks(s_timer, &cbs, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "gptimer callback registration failed: %s", esp_err_to_name(ret));
+        gptimer_del_timer(s_timer);
+        s_timer = NULL;
+        return ret;
+    }
+
+    gptimer_alarm_config_t alarm_cfg = {
+        .reload_count = 0,
+        .alarm_count = period_us,
+        .flags.auto_reload_on_alarm = true,
+    };
+    ret = gptimer_set_alarm_action(s_timer, &alarm_cfg);
+    if (ret == ESP_OK) {
+        ret = gptimer_enable(s_timer);
+        if (ret == ESP_OK) {
+            ret = gptimer_start(s_timer);
+            if (ret != ESP_OK) {
+                gptimer_disable(s_timer);
+            }
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "gptimer start failed: %s", esp_err_to_name(ret));
+        gptimer_del_timer(s_timer);
+        s_timer = NULL;
+        return ret;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t hal_tick_init(const hal_tick_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_rt_task = xTaskGetCurrentTaskHandle();
+    s_last_wake = xTaskGetTickCount();
+    s_prev_wake_us = 0;
+    stats_clear();
+
+    if (config->mode == HAL_TICK_MODE_HW_TIMER) {
+        uint32_t period_us = clamp_period(config->period_us);
+        if (init_hw_timer(period_us) == ESP_OK) {
+            set_pacing(HAL_TICK_MODE_HW_TIMER, period_us);
+            ESP_LOGI(TAG, "HW timer pacing: %luus", (unsigned long)period_us);
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "HW timer unavailable, falling back to task delay");
+    }
+
+    set_pacing(HAL_TICK_MODE_TASK_DELAY, (uint32_t)portTICK_PERIOD_MS * 1000U);
+    ESP_LOGI(TAG, "Task delay pacing: %luus", (unsigned long)get_period_us());
+    return ESP_OK;
+}
+
+void hal_tick_wait(void) {
+    if (get_mode() == HAL_TICK_MODE_HW_TIMER) {
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HW_WAIT_TIMEOUT_MS));
+        if (pending == 0) {
+            atomic_fetch_add_explicit(&s_timeouts, 1, memory_order_relaxed);
+        } else if (pending > 1) {
+            atomic_fetch_add_explicit(&s_missed, pending - 1, memory_order_relaxed);
+        }
+    } else {
+        vTaskDelayUntil(&s_last_wake, 1);
+    }
+
+    stats_record_wake(esp_timer_get_time());
+}
+
+void hal_tick_suspend(void) {
+    if (get_mode() == HAL_TICK_MODE_HW_TIMER && s_timer != NULL) {
+        gptimer_stop(s_timer);
+        gptimer_disable(s_timer);
+    }
+    (void)ulTaskNotifyTake(pdTRUE, 0);
+}
+
+void hal_tick_resume(void) {
+    /* Restarting from 0 puts the next alarm one period away */
+    s_prev_wake_us = 0;
+    s_last_wake = xTaskGetTickCount();
+    if (get_mode() == HAL_TICK_MODE_HW_TIMER && s_timer != NULL) {
+        (void)ulTaskNotifyTake(pdTRUE, 0);
+        gptimer_set_raw_count(s_timer, 0);
+        gptimer_enable(s_timer);
+        gptimer_start(s_timer);
+    }
+}
+
+#else
+/* ============================================================================
+ * Host Stub Implementation
+ * ============================================================================ */
+
+esp_err_t hal_tick_init(const hal_tick_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    set_pacing(config->mode, (config->mode == HAL_TICK_MODE_HW_TIMER)
+                                 ? clamp_period(config->period_us)
+                                 : HAL_TICK_MAX_PERIOD_US);
+    s_prev_wake_us = 0;
+    stats_clear();
+    return ESP_OK;
+}
+
+void hal_tick_wait(void) {
+    /* Host: no blocking; advance the virtual wake clock by one period */
+    stats_record_wake(s_prev_wake_us + (int64_t)get_period_us());
+}
+
+void hal_tick_suspend(void) {
+}
+
+void hal_tick_resume(void) {
+    s_prev_wake_us = 0;
+}
+
+#endif /* ESP_PLATFORM */
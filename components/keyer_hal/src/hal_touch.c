@@ -0,0 +1,176 @@
+/**
+ * @file hal_touch.c
+ * @brief Capacitive touch paddles implementation
+ *
+ * The touch sensor runs on its own (timer FSM): it scans both pads, filters
+ * and compares in hardware, and interrupts on each active/inactive change.
+ * The ISR reads which pads are touched now and queues an edge for each
+ * paddle that changed, so the raw queue and the level word have a single
+ * producer. The legacy touch driver's ISR is not IRAM-safe: during a flash
+ * write a touch is queued when the write ends.
+ */
+
+#include "hal_touch.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if defined(ESP_PLATFORM) && defined(CONFIG_KEYER_PADDLE_TOUCH)
+
+#include "driver/touch_pad.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "paddle_touch.h"
+#include <stdatomic.h>
+
+static const char *TAG = "hal_touch";
+
+/* Untouched scans before the benchmark is read for the thresholds */
+#define HAL_TOUCH_SETTLE_MS 100
+
+#define HAL_TOUCH_INTR (TOUCH_PAD_INTR_MASK_ACTIVE | TOUCH_PAD_INTR_MASK_INACTIVE)
+
+static paddle_edge_queue_t s_raw;
+static touch_pad_t s_pad[2];
+static atomic_uint s_levels;        /* Bit per paddle, written by the ISR */
+static void (*s_on_press)(void);
+
+static void touch_isr(void *arg) {
+    (void)arg;
+    if ((touch_pad_read_intr_status_mask() & HAL_TOUCH_INTR) == 0U) {
+        return;
+    }
+    int64_t now_us = esp_timer_get_time();
+    uint32_t status = touch_pad_get_status();
+
+    unsigned prev = atomic_load_explicit(&s_levels, memory_order_relaxed);
+    unsigned levels = 0;
+    for (uint8_t p = 0; p < 2; p++) {
+        unsigned bit = 1U << p;
+        if (((status >> s_pad[p]) & 1U) != 0U) {
+            levels |= bit;
+        }
+        if (((levels ^ prev) & bit) != 0U) {
+            paddle_edge_t edge = {
+                .timestamp_us = now_us,
+                .paddle = p,
+                .level = ((levels & bit) != 0U) ? 1U : 0U,
+            };
+            paddle_edge_push(&s_raw, &edge);
+        }
+    }
+    atomic_store_explicit(&s_levels, levels, memory_order_release);
+
+    if ((levels & ~prev) != 0U && s_on_press != NULL) {
+        s_on_press();
+    }
+}
+
+esp_err_t hal_touch_init(uint8_t dit_pin, uint8_t dah_pin, uint8_t threshold_pct,
+                         uint32_t budget_us, void (*on_press)(void)) {
+    paddle_edge_queue_init(&s_raw);
+    atomic_store_explicit(&s_levels, 0U, memory_order_relaxed);
+    s_on_press = on_press;
+
+    uint8_t dit = paddle_touch_pad(dit_pin);
+    uint8_t dah = paddle_touch_pad(dah_pin);
+    if (dit == PADDLE_TOUCH_PAD_NONE || dah == PADDLE_TOUCH_PAD_NONE || dit == dah) {
+        ESP_LOGE(TAG, "GPIO%u/%u are not two touch pads (GPIO%u-%u)",
+                 (unsigned)dit_pin, (unsigned)dah_pin,
+                 (unsigned)PADDLE_TOUCH_PAD_MIN, (unsigned)PADDLE_TOUCH_PAD_MAX);
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pad[PADDLE_EDGE_DIT] = (touch_pad_t)dit;
+    s_pad[PADDLE_EDGE_DAH] = (touch_pad_t)dah;
+
+    paddle_touch_scan_t plan;
+    paddle_touch_scan_plan(&plan, budget_us, 2);
+
+    esp_err_t ret = touch_pad_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Touch sensor: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    touch_pad_config(s_pad[PADDLE_EDGE_DIT]);
+    touch_pad_config(s_pad[PADDLE_EDGE_DAH]);
+    touch_pad_set_charge_discharge_times(plan.meas_cycles);
+    touch_pad_set_measurement_interval(plan.sleep_cycles);
+
+    /* Benchmark follows slow drift only; the smoothed reading lags one
+     * sample and must stay over the threshold for one more
+     * (PADDLE_TOUCH_FILTER_SAMPLES) */
+    touch_filter_config_t filter = {
+        .mode = TOUCH_PAD_FILTER_IIR_16,
+        .debounce_cnt = 1,
+        .noise_thr = 0,
+        .jitter_step = 4,
+        .smh_lvl = TOUCH_PAD_SMOOTH_IIR_2,
+    };
+    touch_pad_filter_set_config(&filter);
+    touch_pad_filter_enable();
+    touch_pad_set_fsm_mode(TOUCH_FSM_MODE_TIMER);
+    touch_pad_fsm_start();
+
+    vTaskDelay(pdMS_TO_TICKS(HAL_TOUCH_SETTLE_MS));
+    uint32_t bench[2] = { 0, 0 };
+    for (uint8_t p = 0; p < 2; p++) {
+        touch_pad_read_benchmark(s_pad[p], &bench[p]);
+        touch_pad_set_thresh(s_pad[p], paddle_touch_threshold(bench[p], threshold_pct));
+    }
+
+    ret = touch_pad_isr_register(touch_isr, NULL, HAL_TOUCH_INTR);
+    if (ret == ESP_OK) {
+        ret = touch_pad_intr_enable(HAL_TOUCH_INTR);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Touch interrupt: %s", esp_err_to_name(ret));
+        touch_pad_fsm_stop();
+        touch_pad_deinit();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Touch paddles on GPIO%u/%u: %u cycles, sleep %u, scan %luus, "
+             "latency %luus (budget %luus), bench %lu/%lu, threshold %u%%",
+             (unsigned)dit_pin, (unsigned)dah_pin, (unsigned)plan.meas_cycles,
+             (unsigned)plan.sleep_cycles, (unsigned long)plan.scan_us,
+             (unsigned long)plan.latency_us, (unsigned long)budget_us,
+             (unsigned long)bench[0], (unsigned long)bench[1], (unsigned)threshold_pct);
+    return ESP_OK;
+}
+
+paddle_edge_queue_t *hal_touch_queue(void) {
+    return &s_raw;
+}
+
+uint8_t hal_touch_levels(void) {
+    return (uint8_t)atomic_load_explicit(&s_levels, memory_order_acquire);
+}
+
+#else
+/* Touch not built in (or host build): hal_gpio uses contact paddles */
+
+static paddle_edge_queue_t s_raw;
+
+esp_err_t hal_touch_init(uint8_t dit_pin, uint8_t dah_pin, uint8_t threshold_pct,
+                         uint32_t budget_us, void (*on_press)(void)) {
+    (void)dit_pin;
+    (void)dah_pin;
+    (void)threshold_pct;
+    (void)budget_us;
+    (void)on_press;
+    paddle_edge_queue_init(&s_raw);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+paddle_edge_queue_t *hal_touch_queue(void) {
+    return &s_raw;
+}
+
+uint8_t hal_touch_levels(void) {
+    return 0;
+}
+
+#endif
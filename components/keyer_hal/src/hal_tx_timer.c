@@ -0,0 +1,128 @@
+/**
+ * @file hal_tx_timer.c
+ * @brief Hardware-timed TX output implementation
+ *
+ * The alarm is one-shot: each arm reads the count and sets the alarm that
+ * many µs ahead. The ISR takes the armed flag with one exchange, so a
+ * cancel that wins the race leaves the pin alone.
+ */
+
+#include "hal_tx_timer.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if defined(ESP_PLATFORM) && defined(CONFIG_KEYER_TX_TIMED)
+
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+
+static const char *TAG = "hal_tx_timer";
+
+static gptimer_handle_t s_timer = NULL;
+static gpio_num_t s_pin = GPIO_NUM_NC;
+static volatile uint32_t s_level = 0;
+static atomic_bool s_armed = ATOMIC_VAR_INIT(false);
+
+static bool IRAM_ATTR tx_alarm_isr(gptimer_handle_t timer,
+                                   const gptimer_alarm_event_data_t *edata,
+                                   void *user_ctx) {
+    (void)timer;
+    (void)edata;
+    (void)user_ctx;
+
+    if (atomic_exchange_explicit(&s_armed, false, memory_order_acquire)) {
+        gpio_set_level(s_pin, s_level);
+    }
+    return false;
+}
+
+esp_err_t hal_tx_timer_init(uint8_t tx_pin) {
+    gptimer_config_t timer_cfg = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,  /* 1 count = 1µs */
+    };
+    esp_err_t ret = gptimer_new_timer(&timer_cfg, &s_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "gptimer_new_timer failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    gptimer_event_callbacks_t cbs = {
+        .on_alarm = tx_alarm_isr,
+    };
+    ret = gptimer_register_event_callbacks(s_timer, &cbs, NULL);
+    if (ret == ESP_OK) {
+        ret = gptimer_enable(s_timer);
+    }
+    if (ret == ESP_OK) {
+        ret = gptimer_start(s_timer);
+        if (ret != ESP_OK) {
+            gptimer_disable(s_timer);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "gptimer start failed: %s", esp_err_to_name(ret));
+        gptimer_del_timer(s_timer);
+        s_timer = NULL;
+        return ret;
+    }
+
+    s_pin = (gpio_num_t)tx_pin;
+    ESP_LOGI(TAG, "Timed TX output on GPIO%u", (unsigned)tx_pin);
+    return ESP_OK;
+}
+
+void hal_tx_timer_arm(uint32_t pin_level, int64_t at_us) {
+    uint64_t count = 0;
+    gptimer_get_raw_count(s_timer, &count);
+    int64_t wait = at_us - esp_timer_get_time();
+    if (wait < 1) {
+        wait = 1;
+    }
+
+    s_level = pin_level;
+    atomic_store_explicit(&s_armed, true, memory_order_release);
+    gptimer_alarm_config_t alarm_cfg = {
+        .alarm_count = count + (uint64_t)wait,
+        .flags.auto_reload_on_alarm = false,
+    };
+    gptimer_set_alarm_action(s_timer, &alarm_cfg);
+}
+
+void hal_tx_timer_cancel(void) {
+    atomic_store_explicit(&s_armed, false, memory_order_release);
+}
+
+void hal_tx_timer_set_pin(uint8_t tx_pin) {
+    /* Read by the alarm ISR only while armed: the next arm publishes it */
+    atomic_store_explicit(&s_armed, false, memory_order_release);
+    s_pin = (gpio_num_t)tx_pin;
+}
+
+#else
+/* Timed TX not built in (or host build): hal_gpio sets TX on the tick */
+
+esp_err_t hal_tx_timer_init(uint8_t tx_pin) {
+    (void)tx_pin;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void hal_tx_timer_arm(uint32_t pin_level, int64_t at_us) {
+    (void)pin_level;
+    (void)at_us;
+}
+
+void hal_tx_timer_cancel(void) {
+}
+
+void hal_tx_timer_set_pin(uint8_t tx_pin) {
+    (void)tx_pin;
+}
+
+#endif
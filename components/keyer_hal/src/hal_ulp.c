@@ -0,0 +1,147 @@
+/**
+ * @file hal_ulp.c
+ * @brief ULP RISC-V paddle sampling implementation
+ *
+ * The ULP program (ulp/ulp_paddle.c) is loaded once. Each start resets its
+ * shared state, moves the paddle pins to the RTC IO mux with the same
+ * pull-ups and runs it from the ULP timer; each stop halts it, moves the
+ * pins back and converts the run numbers of any press into ages.
+ */
+
+#include "hal_ulp.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if defined(ESP_PLATFORM) && defined(CONFIG_KEYER_ULP_PADDLE)
+
+#include "driver/gpio.h"
+#include "driver/rtc_io.h"
+#include "esp_sleep.h"
+#include "esp_log.h"
+#include "ulp_riscv.h"
+#include "ulp_paddle.h"
+
+static const char *TAG = "hal_ulp";
+
+extern const uint8_t ulp_paddle_bin_start[] asm("_binary_ulp_paddle_bin_start");
+extern const uint8_t ulp_paddle_bin_end[] asm("_binary_ulp_paddle_bin_end");
+
+static gpio_num_t s_dit = GPIO_NUM_NC;
+static gpio_num_t s_dah = GPIO_NUM_NC;
+static bool s_loaded = false;
+
+static void pin_to_rtc(gpio_num_t pin) {
+    rtc_gpio_init(pin);
+    rtc_gpio_set_direction(pin, RTC_GPIO_MODE_INPUT_ONLY);
+    rtc_gpio_pulldown_dis(pin);
+    rtc_gpio_pullup_en(pin);
+}
+
+static void pin_to_gpio(gpio_num_t pin) {
+    rtc_gpio_deinit(pin);
+    gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+}
+
+esp_err_t hal_ulp_paddle_init(uint8_t dit_pin, uint8_t dah_pin, bool active_low) {
+    if (!rtc_gpio_is_valid_gpio((gpio_num_t)dit_pin) ||
+        !rtc_gpio_is_valid_gpio((gpio_num_t)dah_pin)) {
+        ESP_LOGW(TAG, "Paddle pins %u/%u are not RTC GPIOs, ULP sampling off",
+                 (unsigned)dit_pin, (unsigned)dah_pin);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    esp_err_t ret = ulp_riscv_load_binary(ulp_paddle_bin_start,
+                                          (size_t)(ulp_paddle_bin_end - ulp_paddle_bin_start));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ULP load failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    s_dit = (gpio_num_t)dit_pin;
+    s_dah = (gpio_num_t)dah_pin;
+    ulp_dit_pin = dit_pin;
+    ulp_dah_pin = dah_pin;
+    ulp_active_low = active_low ? 1U : 0U;
+    ulp_debounce = HAL_ULP_DEBOUNCE;
+    s_loaded = true;
+    ESP_LOGI(TAG, "ULP paddle sampling ready (%uus, debounce %u)",
+             (unsigned)HAL_ULP_PERIOD_US, (unsigned)HAL_ULP_DEBOUNCE);
+    return ESP_OK;
+}
+
+void hal_ulp_paddle_start(void) {
+    if (!s_loaded) {
+        return;
+    }
+    ulp_samples = 0;
+    ulp_edge_mask = 0;
+    ulp_dit_run = 0;
+    ulp_dah_run = 0;
+
+    pin_to_rtc(s_dit);
+    pin_to_rtc(s_dah);
+
+    ulp_set_wakeup_period(0, HAL_ULP_PERIOD_US);
+    esp_sleep_enable_ulp_wakeup();
+    ulp_riscv_run();
+}
+
+bool hal_ulp_paddle_pending(void) {
+    return s_loaded && ulp_edge_mask != 0U;
+}
+
+static uint32_t age_us(uint32_t now, uint32_t first) {
+    return (now - first) * HAL_ULP_PERIOD_US;
+}
+
+void hal_ulp_paddle_stop(hal_ulp_press_t *out) {
+    out->mask = 0;
+    out->dit_age_us = 0;
+    out->dah_age_us = 0;
+    if (!s_loaded) {
+        return;
+    }
+
+    ulp_riscv_timer_stop();
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ULP);
+
+    /* Read once: a run may still be finishing (its update is one word) */
+    uint32_t now = ulp_samples;
+    out->mask = ulp_edge_mask & (HAL_ULP_DIT | HAL_ULP_DAH);
+    if ((out->mask & HAL_ULP_DIT) != 0U) {
+        out->dit_age_us = age_us(now, ulp_dit_sample);
+    }
+    if ((out->mask & HAL_ULP_DAH) != 0U) {
+        out->dah_age_us = age_us(now, ulp_dah_sample);
+    }
+
+    pin_to_gpio(s_dit);
+    pin_to_gpio(s_dah);
+}
+
+#else
+/* ULP sampling not built in (or host build): hal_gpio uses GPIO wakeup */
+
+esp_err_t hal_ulp_paddle_init(uint8_t dit_pin, uint8_t dah_pin, bool active_low) {
+    (void)dit_pin;
+    (void)dah_pin;
+    (void)active_low;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void hal_ulp_paddle_start(void) {
+}
+
+bool hal_ulp_paddle_pending(void) {
+    return false;
+}
+
+void hal_ulp_paddle_stop(hal_ulp_press_t *out) {
+    out->mask = 0;
+    out->dit_age_us = 0;
+    out->dah_age_us = 0;
+}
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * @file hal_target_esp32p4.c
+ * @brief ESP32-P4 backend: ESP32-P4-Function-EV-Board wiring
+ *
+ * The board has the same ES8311 codec as the S3 reference, on other
+ * pins, with the NS4150 PA enable on GPIO53 instead of an IO expander.
+ * The radio is the ESP32-C6 on SDIO (esp_hosted); touch and ULP paddle
+ * backends are S3 drivers and stay off.
+ */
+
+#include "hal_target.h"
+
+static const hal_target_t k_target = {
+    .name = "esp32p4",
+    .board = "ESP32-P4-Function-EV-Board",
+    .native_wifi = false,
+    .touch_paddles = false,
+    .ulp_paddles = false,
+};
+
+const hal_target_t *hal_target(void) {
+    return &k_target;
+}
+
+void hal_target_audio_defaults(hal_audio_config_t *cfg) {
+    *cfg = (hal_audio_config_t){
+        .i2c_sda_pin = 7,
+        .i2c_scl_pin = 8,
+        .i2c_freq_hz = 400000,
+        .i2s_mclk_pin = 13,
+        .i2s_bclk_pin = 12,
+        .i2s_lrck_pin = 10,
+        .i2s_dout_pin = 9,
+        .i2s_din_pin = 11,
+        .sample_rate = 8000,
+        .volume_percent = 70,
+        .pa_via_io_expander = false,
+        .pa_pin = 53,
+        .pa_active_high = true,
+        .output_mode = HAL_AUDIO_OUTPUT_CODEC_WRITE,
+        .input_enable = false,
+        .input_gain_db = 24.0f,
+    };
+}
@@ -0,0 +1,39 @@
+/**
+ * @file hal_target_esp32s3.c
+ * @brief ESP32-S3 backend: reference board wiring
+ */
+
+#include "hal_target.h"
+
+static const hal_target_t k_target = {
+    .name = "esp32s3",
+    .board = "RemoteCWKeyer reference",
+    .native_wifi = true,
+    .touch_paddles = true,
+    .ulp_paddles = true,
+};
+
+const hal_target_t *hal_target(void) {
+    return &k_target;
+}
+
+void hal_target_audio_defaults(hal_audio_config_t *cfg) {
+    *cfg = (hal_audio_config_t){
+        .i2c_sda_pin = 11,
+        .i2c_scl_pin = 10,
+        .i2c_freq_hz = 400000,
+        .i2s_mclk_pin = 12,
+        .i2s_bclk_pin = 13,
+        .i2s_lrck_pin = 14,
+        .i2s_dout_pin = 16,
+        .i2s_din_pin = 15,
+        .sample_rate = 8000,
+        .volume_percent = 70,
+        .pa_via_io_expander = true,     /* TCA9555 at 0x20 */
+        .pa_pin = 8,
+        .pa_active_high = true,
+        .output_mode = HAL_AUDIO_OUTPUT_CODEC_WRITE,
+        .input_enable = false,
+        .input_gain_db = 24.0f,
+    };
+}
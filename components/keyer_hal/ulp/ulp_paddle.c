@@ -0,0 +1,65 @@
+/**
+ * @file ulp_paddle.c
+ * @brief ULP RISC-V paddle sampler (CONFIG_KEYER_ULP_PADDLE)
+ *
+ * Runs once per ULP timer period while the main cores sleep. Each run
+ * reads both paddle pins; a paddle seen pressed on `debounce` consecutive
+ * runs is reported with the run number of its first pressed reading, and
+ * the main processor is woken. Runs keep counting after that, so the main
+ * cores can tell how long ago the press started (hal_ulp_paddle_stop).
+ *
+ * Globals persist across runs and are shared with the main cores as
+ * ulp_<name> (generated ulp_paddle.h).
+ */
+
+#include <stdint.h>
+#include "ulp_riscv_utils.h"
+#include "ulp_riscv_gpio.h"
+
+/* Set by the main cores before each start */
+uint32_t dit_pin;
+uint32_t dah_pin;
+uint32_t active_low;
+uint32_t debounce;
+
+/* Written here, read by the main cores */
+uint32_t samples;       /* Runs since start */
+uint32_t edge_mask;     /* Bit 0 DIT, bit 1 DAH: debounced press seen */
+uint32_t dit_sample;    /* Run of the first pressed DIT reading */
+uint32_t dah_sample;    /* Run of the first pressed DAH reading */
+
+/* Consecutive pressed readings (reset by the main cores with the rest) */
+uint32_t dit_run;
+uint32_t dah_run;
+
+static uint32_t pressed(uint32_t pin) {
+    uint32_t level = (uint32_t)ulp_riscv_gpio_get_level((gpio_num_t)pin);
+    return active_low ? (level == 0U) : (level != 0U);
+}
+
+static void sample(uint32_t pin, uint32_t bit, uint32_t *run, uint32_t *first) {
+    if ((edge_mask & bit) != 0U) {
+        return;     /* Already reported */
+    }
+    if (!pressed(pin)) {
+        *run = 0;
+        return;
+    }
+    if (++*run >= debounce) {
+        *first = samples - (*run - 1U);
+        edge_mask |= bit;
+    }
+}
+
+int main(void) {
+    samples++;
+
+    uint32_t before = edge_mask;
+    sample(dit_pin, 1U, &dit_run, &dit_sample);
+    sample(dah_pin, 2U, &dah_run, &dah_sample);
+
+    if (before == 0U && edge_mask != 0U) {
+        ulp_riscv_wakeup_main_processor();
+    }
+    return 0;
+}
@@ -18,6 +18,26 @@
  * - After paddle release, a 5ms blanking period suppresses bounce
  * - New presses of the same paddle are ignored during this window
  * - Prevents false triggers from mechanical contact bounce on open
+ *
+ * Config Changes:
+ * - iambic_queue_config() stages a new config; it is latched at the next
+ *   element start or gap entry, so speed changes never wait for IDLE
+ * - iambic_queue_plan() stages a plan built beforehand (a preset plan,
+ *   see iambic_preset_plan()): latching copies it, nothing is recomputed
+ *
+ * Edge Timestamps:
+ * - iambic_tick_edges() replays ISR paddle edges at their own timestamps
+ *   before the polled tick, so memory window checks use the edge time
+ *
+ * Mode Specialization:
+ * - Each (iambic mode, squeeze mode) pair has its own step function with
+ *   those branches resolved at compile time; the config picks one when it
+ *   is applied, so a tick runs no mode dispatch
+ *
+ * Key Tags:
+ * - Key-down samples carry the element being keyed and whether it follows
+ *   the previous element's gap directly (KEY_TAG_*, see sample.h), so the
+ *   decoder takes local paddle keying as exact instead of classifying it
  */
 
 #ifndef KEYER_IAMBIC_H
@@ -27,6 +47,7 @@
 #include <stdbool.h>
 #include "sample.h"
 #include "iambic_preset.h"
+#include "paddle_edge.h"
 
 /**
  * @brief Release debounce blanking period in microseconds
@@ -144,6 +165,26 @@ static inline int64_t iambic_gap_duration_us(const iambic_config_t *config) {
     return iambic_dit_duration_us(config);
 }
 
+/**
+ * @brief Timing table derived from the active config
+ *
+ * Computed once when a config is applied so the FSM only compares and
+ * adds (memory mode included, as one arming flag per paddle). Memory window bounds are offsets from element start: elapsed time
+ * t is inside the window when win_start_us <= t < win_end_us, matching
+ * iambic_in_memory_window() on the integer progress percentage.
+ */
+typedef struct {
+    int64_t dit_us;            /**< Dit duration */
+    int64_t dah_us;            /**< Dah duration */
+    int64_t gap_us;            /**< Inter-element gap */
+    int64_t dit_win_start_us;  /**< DIT memory window start offset */
+    int64_t dit_win_end_us;    /**< DIT memory window end offset (exclusive) */
+    int64_t dah_win_start_us;  /**< DAH memory window start offset */
+    int64_t dah_win_end_us;    /**< DAH memory window end offset (exclusive) */
+    bool dit_memory_enabled;   /**< memory_mode remembers the dit paddle */
+    bool dah_memory_enabled;   /**< memory_mode remembers the dah paddle */
+} iambic_timing_t;
+
 /* ============================================================================
  * Processor
  * ============================================================================ */
@@ -158,20 +199,49 @@ typedef enum {
     IAMBIC_STATE_GAP = 3,
 } iambic_state_t;
 
+struct iambic_processor;
+
+/**
+ * @brief FSM step specialized for one iambic mode and squeeze mode
+ */
+typedef void (*iambic_step_fn_t)(struct iambic_processor *proc, int64_t now_us,
+                                 gpio_state_t gpio);
+
+/**
+ * @brief Everything a config turns into: timing table and step variant
+ *
+ * Built once off the RT path (iambic_plan_build()); making it active is a
+ * copy, no divisions.
+ */
+typedef struct {
+    iambic_config_t config;    /**< Configuration the plan was built from */
+    iambic_timing_t timing;    /**< Durations and memory arming for config */
+    iambic_step_fn_t step;     /**< Step variant for config */
+} iambic_plan_t;
+
 /**
  * @brief Iambic keyer processor
  *
  * Pure FSM that converts paddle GPIO state into keying output.
  * No hardware dependencies, fully testable on host.
  */
-typedef struct {
+typedef struct iambic_processor {
     iambic_config_t config;    /**< Current configuration */
+    iambic_timing_t timing;    /**< Durations for config */
+    iambic_step_fn_t step;     /**< Step variant for config.mode and config.squeeze_mode */
+
+    /* Staged configuration (latched at element boundaries) */
+    iambic_plan_t staged_plan; /**< Plan built by iambic_queue_config() */
+    const iambic_plan_t *pending_plan; /**< Plan to latch (staged_plan or caller's) */
+    bool config_pending;       /**< pending_plan waiting to be latched */
 
     /* FSM state */
     iambic_state_t state;      /**< Current FSM state */
     int64_t element_start_us;  /**< Timestamp when current element started */
     int64_t element_end_us;    /**< Timestamp when current element ends */
     int64_t element_duration_us; /**< Duration of current element */
+    int64_t win_start_us;      /**< Memory window start offset of current element */
+    int64_t win_end_us;        /**< Memory window end offset of current element */
     iambic_element_t last_element; /**< Last element sent (for alternation) */
 
     /* Paddle state */
@@ -196,6 +266,11 @@ typedef struct {
 
     /* Output state */
     bool key_down;             /**< Current key output state */
+    bool element_in_char;      /**< Current element started straight from a gap */
+
+    /* Edge replay */
+    gpio_state_t raw_gpio;     /**< Last raw paddle state fed to the FSM */
+    int64_t last_tick_us;      /**< Timestamp of last FSM step (edges never go earlier) */
 } iambic_processor_t;
 
 /**
@@ -207,13 +282,46 @@ typedef struct {
 void iambic_init(iambic_processor_t *proc, const iambic_config_t *config);
 
 /**
- * @brief Update processor configuration
+ * @brief Update processor configuration immediately
+ *
+ * Discards any staged config. Changing speed mid-element leaves the
+ * current element's end time as it was.
  *
  * @param proc Processor
  * @param config New configuration
  */
 void iambic_set_config(iambic_processor_t *proc, const iambic_config_t *config);
 
+/**
+ * @brief Stage a configuration for the next element boundary
+ *
+ * Applied at once when IDLE, otherwise latched at the next element start
+ * or gap entry. A later call replaces a config that is still staged.
+ *
+ * @param proc Processor
+ * @param config New configuration
+ */
+void iambic_queue_config(iambic_processor_t *proc, const iambic_config_t *config);
+
+/**
+ * @brief Build the plan for a configuration
+ *
+ * @param plan Plan to fill
+ * @param config Configuration
+ */
+void iambic_plan_build(iambic_plan_t *plan, const iambic_config_t *config);
+
+/**
+ * @brief Stage a prebuilt plan for the next element boundary
+ *
+ * Like iambic_queue_config(), but latching only copies the plan. The
+ * plan is read when it is latched, so it must stay valid until then.
+ *
+ * @param proc Processor
+ * @param plan Plan to latch
+ */
+void iambic_queue_plan(iambic_processor_t *proc, const iambic_plan_t *plan);
+
 /**
  * @brief Tick the FSM and produce output sample
  *
@@ -224,6 +332,77 @@ void iambic_set_config(iambic_processor_t *proc, const iambic_config_t *config);
  */
 stream_sample_t iambic_tick(iambic_processor_t *proc, int64_t now_us, gpio_state_t gpio);
 
+/**
+ * @brief Replay queued paddle edges, then tick at now_us
+ *
+ * Each edge is applied as an FSM step at its own timestamp (clamped to
+ * the last step and now_us), then a normal tick runs with the polled
+ * GPIO state. A press and release that both fall inside one tick still
+ * start an element at the press time.
+ *
+ * @param proc Processor
+ * @param now_us Current timestamp in microseconds
+ * @param gpio Current polled paddle GPIO state
+ * @param edges Edge queue to drain (NULL = plain iambic_tick)
+ * @return StreamSample with local_key set to current keying state
+ */
+stream_sample_t iambic_tick_edges(iambic_processor_t *proc, int64_t now_us,
+                                  gpio_state_t gpio, paddle_edge_queue_t *edges);
+
+/* ============================================================================
+ * Preset Plans (iambic_preset.c)
+ * ============================================================================ */
+
+/**
+ * @brief Plan of a preset, rebuilt whenever the preset is edited
+ *
+ * Each preset keeps two plans and publishes the fresh one after a
+ * rebuild, so a plan handed to iambic_queue_plan() stays intact across
+ * one further edit of the same preset.
+ *
+ * @param index Preset index (0-9)
+ * @return Plan, or NULL if index invalid
+ */
+const iambic_plan_t *iambic_preset_plan(uint32_t index);
+
+/**
+ * @brief Plan of the active preset (RT-safe)
+ *
+ * Core 1 reads it; the RT task gets it through the handoff below.
+ *
+ * @return Plan (never NULL)
+ */
+const iambic_plan_t *iambic_preset_active_plan(void);
+
+/**
+ * @brief What the RT task's FSM should run, as published by Core 1
+ *
+ * iambic_preset_activate(), iambic_preset_deactivate() and every rebuild
+ * of the active preset's plan copy it out with a seqlock (seq odd while a
+ * writer is copying), like the config RT snapshot. The RT task copies it
+ * into storage of its own and hands that to iambic_queue_plan(), so the
+ * plan it latches at the next element boundary can never be rewritten
+ * under it, however many edits follow.
+ */
+typedef struct {
+    bool in_use;          /**< false: the keyer.* parameters drive the FSM */
+    iambic_plan_t plan;   /**< Active preset's plan (meaningful if in_use) */
+} iambic_preset_handoff_t;
+
+/**
+ * @brief Current handoff sequence (cheap change check, one atomic load)
+ */
+unsigned iambic_preset_handoff_seq(void);
+
+/**
+ * @brief Read the handoff without blocking (RT-safe)
+ *
+ * @param out Destination (left untouched on failure)
+ * @param seq_out Sequence the copy was taken at (compare with iambic_preset_handoff_seq())
+ * @return true on a consistent copy, false if a writer was active (retry next tick)
+ */
+bool iambic_preset_read_handoff(iambic_preset_handoff_t *out, unsigned *seq_out);
+
 /**
  * @brief Check if key output is currently active
  *
@@ -234,6 +413,21 @@ static inline bool iambic_is_key_down(const iambic_processor_t *proc) {
     return proc->key_down;
 }
 
+/**
+ * @brief Key tag of the element being keyed (KEY_TAG_*, 0 when key up)
+ *
+ * @param proc Processor
+ * @return Tag bits for the current output sample
+ */
+static inline uint8_t iambic_key_tag(const iambic_processor_t *proc) {
+    if (!proc->key_down) {
+        return 0;
+    }
+    return (uint8_t)(KEY_TAG_ELEMENT |
+                     ((proc->state == IAMBIC_STATE_SEND_DAH) ? KEY_TAG_DAH : 0U) |
+                     (proc->element_in_char ? KEY_TAG_IN_CHAR : 0U));
+}
+
 /**
  * @brief Reset FSM to idle state
  *
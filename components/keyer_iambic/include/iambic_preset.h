@@ -9,6 +9,15 @@
  * Static allocation: No heap, all data compile-time sized.
  * Atomic operations: All configuration changes via atomics.
  *
+ * Every edit rebuilds the preset's plan (timing table and FSM step
+ * variant, see iambic_preset_plan() in iambic.h) off the RT path, so
+ * switching presets never computes anything on the RT side. All presets
+ * persist as one NVS blob (iambic_preset_save()).
+ *
+ * keyer.preset selects (1-10) or releases (0) a preset; housekeeping
+ * (main/bg_task.c) follows it with iambic_preset_activate() and
+ * iambic_preset_deactivate().
+ *
  * @deprecated This preset system is deprecated in favor of unified g_config.
  *             Enum types (iambic_mode_t, memory_mode_t, squeeze_mode_t) still used.
  *             Future: NVS-backed presets integrated with g_config.
@@ -20,6 +29,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdatomic.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +48,12 @@ extern "C" {
 /** NVS schema version for migration support */
 #define IAMBIC_PRESET_SCHEMA_VERSION 1
 
+/** Bytes per preset in the NVS blob */
+#define IAMBIC_PRESET_BLOB_ENTRY (IAMBIC_PRESET_NAME_MAX + 8)
+
+/** NVS blob size: u8 version, u8 count, u8 active, u8 reserved, entries */
+#define IAMBIC_PRESET_BLOB_SIZE (4 + IAMBIC_PRESET_COUNT * IAMBIC_PRESET_BLOB_ENTRY)
+
 /* ============================================================================
  * Enums
  * ============================================================================ */
@@ -162,11 +178,27 @@ iambic_preset_t* iambic_preset_get_mut(uint32_t index);
 /**
  * @brief Switch to preset by index
  *
+ * Puts the preset in use: its plan is handed to the RT task
+ * (iambic_preset_read_handoff() in iambic.h), which latches it at the
+ * next element boundary. Core 1 only.
+ *
  * @param index Preset index (0-9)
  * @return true if switched successfully, false if index invalid
  */
 bool iambic_preset_activate(uint32_t index);
 
+/**
+ * @brief Stop using presets: the keyer.* parameters drive the FSM again
+ *
+ * The active index is kept for the next iambic_preset_activate(). Core 1 only.
+ */
+void iambic_preset_deactivate(void);
+
+/**
+ * @brief Check if a preset is in use (activated and not deactivated)
+ */
+bool iambic_preset_in_use(void);
+
 /**
  * @brief Get active preset index
  *
@@ -200,6 +232,58 @@ bool iambic_preset_reset(uint32_t index);
  */
 bool iambic_preset_set_name(uint32_t index, const char* name);
 
+/**
+ * @brief Rebuild the plan of an edited preset
+ *
+ * Called by the setters below; call it after editing a preset's atomics
+ * directly.
+ *
+ * @param preset Preset from iambic_preset_get_mut()
+ */
+void iambic_preset_edited(iambic_preset_t* preset);
+
+/* ============================================================================
+ * Persistence
+ * ============================================================================ */
+
+/**
+ * @brief Serialize all presets and the active index
+ *
+ * Layout: u8 schema version, u8 preset count, u8 active index, u8 0, then
+ * per preset the name (NUL padded) and u8 wpm, mode, memory mode, squeeze
+ * mode, window start, window end, two zero bytes.
+ *
+ * @param out Buffer of at least IAMBIC_PRESET_BLOB_SIZE bytes
+ * @return Bytes written (IAMBIC_PRESET_BLOB_SIZE)
+ */
+size_t iambic_preset_pack(uint8_t* out);
+
+/**
+ * @brief Replace all presets from a blob (all-or-nothing)
+ *
+ * Every value is range-checked before anything changes; plans are
+ * rebuilt for every preset.
+ *
+ * @param data Blob from iambic_preset_pack()
+ * @param len Blob length
+ * @return true if applied, false if the blob was rejected
+ */
+bool iambic_preset_unpack(const uint8_t* data, size_t len);
+
+/**
+ * @brief Load presets from NVS (keeps the current ones if none saved)
+ *
+ * @return true if presets were loaded
+ */
+bool iambic_preset_load(void);
+
+/**
+ * @brief Save all presets to NVS as one blob
+ *
+ * @return true if saved
+ */
+bool iambic_preset_save(void);
+
 /* ============================================================================
  * Preset Value Accessors (RT-safe)
  * ============================================================================ */
@@ -256,6 +340,7 @@ static inline uint8_t iambic_preset_get_mem_end(const iambic_preset_t* preset) {
 static inline void iambic_preset_set_wpm(iambic_preset_t* preset, uint32_t wpm) {
     if (wpm >= 5 && wpm <= 100) {
         atomic_store_explicit(&preset->speed_wpm, wpm, memory_order_relaxed);
+        iambic_preset_edited(preset);
     }
 }
 
@@ -264,6 +349,7 @@ static inline void iambic_preset_set_wpm(iambic_preset_t* preset, uint32_t wpm)
  */
 static inline void iambic_preset_set_mode(iambic_preset_t* preset, iambic_mode_t mode) {
     atomic_store_explicit(&preset->iambic_mode, (uint8_t)mode, memory_order_relaxed);
+    iambic_preset_edited(preset);
 }
 
 /**
@@ -271,6 +357,7 @@ static inline void iambic_preset_set_mode(iambic_preset_t* preset, iambic_mode_t
  */
 static inline void iambic_preset_set_memory_mode(iambic_preset_t* preset, memory_mode_t mode) {
     atomic_store_explicit(&preset->memory_mode, (uint8_t)mode, memory_order_relaxed);
+    iambic_preset_edited(preset);
 }
 
 /**
@@ -278,6 +365,7 @@ static inline void iambic_preset_set_memory_mode(iambic_preset_t* preset, memory
  */
 static inline void iambic_preset_set_squeeze_mode(iambic_preset_t* preset, squeeze_mode_t mode) {
     atomic_store_explicit(&preset->squeeze_mode, (uint8_t)mode, memory_order_relaxed);
+    iambic_preset_edited(preset);
 }
 
 /**
@@ -286,6 +374,7 @@ static inline void iambic_preset_set_squeeze_mode(iambic_preset_t* preset, squee
 static inline void iambic_preset_set_mem_start(iambic_preset_t* preset, uint8_t pct) {
     if (pct <= 100) {
         atomic_store_explicit(&preset->mem_window_start_pct, pct, memory_order_relaxed);
+        iambic_preset_edited(preset);
     }
 }
 
@@ -295,6 +384,7 @@ static inline void iambic_preset_set_mem_start(iambic_preset_t* preset, uint8_t
 static inline void iambic_preset_set_mem_end(iambic_preset_t* preset, uint8_t pct) {
     if (pct <= 100) {
         atomic_store_explicit(&preset->mem_window_end_pct, pct, memory_order_relaxed);
+        iambic_preset_edited(preset);
     }
 }
 
@@ -7,23 +7,39 @@
  * Memory Window Logic:
  * Paddle inputs are only memorized when within the memory window
  * (between mem_window_start_pct and mem_window_end_pct of element duration).
+ * With iambic_tick_edges() the window is evaluated at the ISR edge time.
+ *
+ * Config Latching:
+ * A queued config is built into a plan right away and the plan is swapped
+ * in at element start and gap entry, the only points where element
+ * durations are read. Latching copies the plan and computes nothing.
+ *
+ * Specialization:
+ * step_impl() takes the iambic mode and squeeze mode as arguments and is
+ * always inlined into one step function per combination, where both are
+ * constants and their branches fold away. iambic_plan_build() picks the
+ * variant from s_step_table; memory mode becomes two arming flags in the
+ * timing table. Forced inlining because the ESP-IDF default -Og build
+ * does not inline on its own.
  */
 
 #include "iambic.h"
 #include <assert.h>
 #include <string.h>
 
+/** Helpers specialized per step variant */
+#define IAMBIC_INLINE static inline __attribute__((always_inline))
+
 /* ============================================================================
  * Forward Declarations
  * ============================================================================ */
 
-static void update_gpio(iambic_processor_t *proc, gpio_state_t gpio, int64_t now_us);
-static void tick_idle(iambic_processor_t *proc, int64_t now_us);
+static void apply_config(iambic_processor_t *proc, const iambic_config_t *config);
+static void apply_plan(iambic_processor_t *proc, const iambic_plan_t *plan);
+static void latch_pending_config(iambic_processor_t *proc);
 static void tick_sending(iambic_processor_t *proc, int64_t now_us, iambic_element_t element);
-static void tick_gap(iambic_processor_t *proc, int64_t now_us);
-static iambic_element_t *decide_next_element(iambic_processor_t *proc, iambic_element_t *out);
-static void start_element(iambic_processor_t *proc, iambic_element_t element, int64_t now_us);
-static bool is_in_memory_window(const iambic_processor_t *proc, int64_t now_us);
+static void start_element(iambic_processor_t *proc, iambic_element_t element, int64_t now_us,
+                          bool in_char);
 
 /* ============================================================================
  * Public Functions
@@ -33,11 +49,15 @@ void iambic_init(iambic_processor_t *proc, const iambic_config_t *config) {
     assert(proc != NULL);
     assert(config != NULL);
 
-    proc->config = *config;
+    apply_config(proc, config);
+    proc->pending_plan = NULL;
+    proc->config_pending = false;
     proc->state = IAMBIC_STATE_IDLE;
     proc->element_start_us = 0;
     proc->element_end_us = 0;
     proc->element_duration_us = 0;
+    proc->win_start_us = 0;
+    proc->win_end_us = 0;
     proc->last_element = ELEMENT_DAH;  /* Start with DAH so first DIT press works */
     proc->dit_pressed = false;
     proc->dah_pressed = false;
@@ -50,47 +70,93 @@ void iambic_init(iambic_processor_t *proc, const iambic_config_t *config) {
     proc->squeeze_seen = false;
     proc->squeeze_latched = false;
     proc->key_down = false;
+    proc->element_in_char = false;
+    proc->raw_gpio = GPIO_IDLE;
+    proc->last_tick_us = 0;
 }
 
 void iambic_set_config(iambic_processor_t *proc, const iambic_config_t *config) {
     assert(proc != NULL);
     assert(config != NULL);
 
-    proc->config = *config;
+    apply_config(proc, config);
+    proc->config_pending = false;
 }
 
-stream_sample_t iambic_tick(iambic_processor_t *proc, int64_t now_us, gpio_state_t gpio) {
+void iambic_queue_config(iambic_processor_t *proc, const iambic_config_t *config) {
     assert(proc != NULL);
+    assert(config != NULL);
 
-    /* Update paddle state and memory */
-    update_gpio(proc, gpio, now_us);
+    if (proc->state == IAMBIC_STATE_IDLE) {
+        iambic_set_config(proc, config);
+        return;
+    }
+    iambic_plan_build(&proc->staged_plan, config);
+    proc->pending_plan = &proc->staged_plan;
+    proc->config_pending = true;
+}
 
-    /* Run FSM */
-    switch (proc->state) {
-        case IAMBIC_STATE_IDLE:
-            tick_idle(proc, now_us);
-            break;
-        case IAMBIC_STATE_SEND_DIT:
-            tick_sending(proc, now_us, ELEMENT_DIT);
-            break;
-        case IAMBIC_STATE_SEND_DAH:
-            tick_sending(proc, now_us, ELEMENT_DAH);
-            break;
-        case IAMBIC_STATE_GAP:
-            tick_gap(proc, now_us);
-            break;
+void iambic_queue_plan(iambic_processor_t *proc, const iambic_plan_t *plan) {
+    assert(proc != NULL);
+    assert(plan != NULL);
+
+    if (proc->state == IAMBIC_STATE_IDLE) {
+        apply_plan(proc, plan);
+        proc->config_pending = false;
+        return;
     }
+    proc->pending_plan = plan;
+    proc->config_pending = true;
+}
+
+stream_sample_t iambic_tick(iambic_processor_t *proc, int64_t now_us, gpio_state_t gpio) {
+    assert(proc != NULL);
+
+    proc->step(proc, now_us, gpio);
 
     /* Produce output sample */
     stream_sample_t sample = STREAM_SAMPLE_EMPTY;
     sample.gpio = gpio;
     sample.local_key = proc->key_down ? 1 : 0;
-    /* audio_level filled by audio envelope later */
+    if (proc->key_down) {
+        sample = sample_with_key_tag(sample, iambic_key_tag(proc));
+    }
     /* flags and config_gen set by RT loop */
 
     return sample;
 }
 
+stream_sample_t iambic_tick_edges(iambic_processor_t *proc, int64_t now_us,
+                                  gpio_state_t gpio, paddle_edge_queue_t *edges) {
+    assert(proc != NULL);
+
+    if (edges != NULL) {
+        paddle_edge_t edge;
+        while (paddle_edge_pop(edges, &edge)) {
+            /* Keep FSM time monotonic and never ahead of the tick */
+            int64_t t = edge.timestamp_us;
+            if (t < proc->last_tick_us) {
+                t = proc->last_tick_us;
+            }
+            if (t > now_us) {
+                t = now_us;
+            }
+
+            uint8_t bit = (edge.paddle == PADDLE_EDGE_DIT) ? GPIO_DIT_BIT : GPIO_DAH_BIT;
+            gpio_state_t edge_gpio = proc->raw_gpio;
+            if (edge.level != 0) {
+                edge_gpio.bits |= bit;
+            } else {
+                edge_gpio.bits &= (uint8_t)~bit;
+            }
+
+            proc->step(proc, t, edge_gpio);
+        }
+    }
+
+    return iambic_tick(proc, now_us, gpio);
+}
+
 void iambic_reset(iambic_processor_t *proc) {
     assert(proc != NULL);
 
@@ -98,25 +164,53 @@ void iambic_reset(iambic_processor_t *proc) {
     proc->element_start_us = 0;
     proc->element_end_us = 0;
     proc->element_duration_us = 0;
+    proc->win_start_us = 0;
+    proc->win_end_us = 0;
     proc->dit_memory = false;
     proc->dah_memory = false;
     proc->squeeze_seen = false;
     proc->squeeze_latched = false;
     proc->key_down = false;
+    proc->element_in_char = false;
     proc->dit_release_time_us = 0;
     proc->dah_release_time_us = 0;
     proc->dit_press_start_us = 0;
     proc->dah_press_start_us = 0;
+    proc->raw_gpio = GPIO_IDLE;
+    proc->last_tick_us = 0;
+    latch_pending_config(proc);
 }
 
 /* ============================================================================
  * Private Functions
  * ============================================================================ */
 
+/**
+ * @brief Smallest elapsed time whose progress percentage reaches pct
+ *
+ * progress = elapsed * 100 / duration (truncated), so progress >= pct
+ * exactly when elapsed >= ceil(pct * duration / 100).
+ */
+static int64_t pct_threshold_us(int64_t duration_us, uint32_t pct) {
+    return ((int64_t)pct * duration_us + 99) / 100;
+}
+
+/**
+ * @brief Window offsets for one element duration
+ */
+static void window_bounds(int64_t duration_us, const iambic_config_t *config,
+                          int64_t *start_us, int64_t *end_us) {
+    *start_us = pct_threshold_us(duration_us, config->mem_window_start_pct);
+    /* Progress saturates at 100%, so an end of 100 never closes the window */
+    *end_us = (config->mem_window_end_pct >= 100)
+        ? INT64_MAX
+        : pct_threshold_us(duration_us, (uint32_t)config->mem_window_end_pct + 1U);
+}
+
 /**
  * @brief Check if current time is within the memory window of current element
  */
-static bool is_in_memory_window(const iambic_processor_t *proc, int64_t now_us) {
+IAMBIC_INLINE bool is_in_memory_window(const iambic_processor_t *proc, int64_t now_us) {
     /* Only applies during element transmission (not gap) */
     if (proc->state != IAMBIC_STATE_SEND_DIT && proc->state != IAMBIC_STATE_SEND_DAH) {
         return false;  /* NEVER arm memory during gap - use current paddle state */
@@ -126,26 +220,20 @@ static bool is_in_memory_window(const iambic_processor_t *proc, int64_t now_us)
         return true;  /* Fallback: no window defined */
     }
 
-    /* Calculate progress percentage (0-100) */
+    /* Window bounds precomputed at element start (see iambic_timing_t) */
     int64_t elapsed = now_us - proc->element_start_us;
     if (elapsed < 0) {
         elapsed = 0;
     }
 
-    /* Avoid overflow: (elapsed * 100) could overflow for large durations */
-    uint8_t progress_pct;
-    if (elapsed >= proc->element_duration_us) {
-        progress_pct = 100;
-    } else {
-        progress_pct = (uint8_t)((elapsed * 100) / proc->element_duration_us);
-    }
-
-    return iambic_in_memory_window(progress_pct,
-                                    proc->config.mem_window_start_pct,
-                                    proc->config.mem_window_end_pct);
+    return elapsed >= proc->win_start_us && elapsed < proc->win_end_us;
 }
 
-static void update_gpio(iambic_processor_t *proc, gpio_state_t gpio, int64_t now_us) {
+/**
+ * @brief Sample paddles, arm memory, track squeeze
+ */
+IAMBIC_INLINE void update_gpio(iambic_processor_t *proc, gpio_state_t gpio, int64_t now_us,
+                               iambic_mode_t mode, squeeze_mode_t squeeze) {
     bool was_dit_pressed = proc->dit_pressed;
     bool was_dah_pressed = proc->dah_pressed;
     bool was_squeeze = was_dit_pressed && was_dah_pressed;
@@ -189,7 +277,7 @@ static void update_gpio(iambic_processor_t *proc, gpio_state_t gpio, int64_t now
     }
 
     /* Handle squeeze mode (LATCH_ON vs LATCH_OFF) */
-    if (proc->config.squeeze_mode == SQUEEZE_MODE_LATCH_ON) {
+    if (squeeze == SQUEEZE_MODE_LATCH_ON) {
         /* LATCH_ON: Capture squeeze state at element start, don't update during element */
         /* squeeze_latched is set in start_element() and used for squeeze detection */
     } else {
@@ -207,7 +295,7 @@ static void update_gpio(iambic_processor_t *proc, gpio_state_t gpio, int64_t now
 
         /* Determine if we should check for memory arming based on squeeze_mode */
         bool check_dit, check_dah;
-        if (proc->config.squeeze_mode == SQUEEZE_MODE_LATCH_ON) {
+        if (squeeze == SQUEEZE_MODE_LATCH_ON) {
             /* LATCH_ON: Only arm memory if squeeze was active at element start */
             check_dit = proc->squeeze_latched && proc->dit_pressed;
             check_dah = proc->squeeze_latched && proc->dah_pressed;
@@ -224,27 +312,27 @@ static void update_gpio(iambic_processor_t *proc, gpio_state_t gpio, int64_t now
             bool dah_is_fresh = (proc->dah_press_start_us > proc->element_start_us);
 
             /* Inside window: arm memory if paddle pressed AND it's a fresh press */
-            if (can_arm_dit && check_dit && dit_is_fresh && iambic_dit_memory_enabled(proc->config.memory_mode)) {
+            if (can_arm_dit && check_dit && dit_is_fresh && proc->timing.dit_memory_enabled) {
                 proc->dit_memory = true;
             }
-            if (can_arm_dah && check_dah && dah_is_fresh && iambic_dah_memory_enabled(proc->config.memory_mode)) {
+            if (can_arm_dah && check_dah && dah_is_fresh && proc->timing.dah_memory_enabled) {
                 proc->dah_memory = true;
             }
         }
 
         /* Reset squeeze_seen if squeeze released BEFORE memory window (Mode B fix) */
-        if (proc->config.mode == IAMBIC_MODE_B && proc->squeeze_seen) {
-            bool current_squeeze = (proc->config.squeeze_mode == SQUEEZE_MODE_LATCH_ON)
+        if (mode == IAMBIC_MODE_B && proc->squeeze_seen) {
+            bool current_squeeze = (squeeze == SQUEEZE_MODE_LATCH_ON)
                                     ? proc->squeeze_latched
                                     : (proc->dit_pressed && proc->dah_pressed);
             if (!current_squeeze) {
                 /* Squeeze released - check if before window */
                 int64_t elapsed = now_us - proc->element_start_us;
-                uint8_t progress_pct = (proc->element_duration_us > 0)
-                    ? (uint8_t)((elapsed * 100) / proc->element_duration_us)
-                    : 0;
+                bool before_window = (proc->element_duration_us > 0)
+                    ? (elapsed < proc->win_start_us)
+                    : (proc->config.mem_window_start_pct > 0);
 
-                if (progress_pct < proc->config.mem_window_start_pct) {
+                if (before_window) {
                     /* Released BEFORE window start - cancel Mode B bonus */
                     proc->squeeze_seen = false;
                 }
@@ -253,42 +341,11 @@ static void update_gpio(iambic_processor_t *proc, gpio_state_t gpio, int64_t now
     }
 }
 
-static void tick_idle(iambic_processor_t *proc, int64_t now_us) {
-    /* Determine next element from memory or current paddle state */
-    iambic_element_t next_element;
-    const iambic_element_t *next = decide_next_element(proc, &next_element);
-
-    if (next != NULL) {
-        start_element(proc, *next, now_us);
-    }
-}
-
-static void tick_sending(iambic_processor_t *proc, int64_t now_us, iambic_element_t element) {
-    if (now_us >= proc->element_end_us) {
-        /* Element complete */
-        proc->key_down = false;
-        proc->last_element = element;
-
-        /* Enter gap */
-        proc->state = IAMBIC_STATE_GAP;
-        proc->element_start_us = now_us;
-        proc->element_duration_us = iambic_gap_duration_us(&proc->config);
-        proc->element_end_us = now_us + proc->element_duration_us;
-    }
-}
-
-static void tick_gap(iambic_processor_t *proc, int64_t now_us) {
-    if (now_us >= proc->element_end_us) {
-        /* Gap complete */
-        proc->state = IAMBIC_STATE_IDLE;
-        proc->element_duration_us = 0;
-
-        /* Immediately check for next element */
-        tick_idle(proc, now_us);
-    }
-}
-
-static iambic_element_t *decide_next_element(iambic_processor_t *proc, iambic_element_t *out) {
+/**
+ * @brief Pick the element to send next, NULL when the paddles are idle
+ */
+IAMBIC_INLINE iambic_element_t *decide_next_element(iambic_processor_t *proc, iambic_element_t *out,
+                                                    iambic_mode_t mode, squeeze_mode_t squeeze) {
     /* Priority 1: Memory (armed during previous element) */
     if (proc->dit_memory) {
         proc->dit_memory = false;
@@ -302,9 +359,9 @@ static iambic_element_t *decide_next_element(iambic_processor_t *proc, iambic_el
     }
 
     /* Priority 2: Mode B bonus element */
-    if (proc->config.mode == IAMBIC_MODE_B && proc->squeeze_seen) {
+    if (mode == IAMBIC_MODE_B && proc->squeeze_seen) {
         /* Check if squeeze was released */
-        bool current_squeeze = (proc->config.squeeze_mode == SQUEEZE_MODE_LATCH_ON)
+        bool current_squeeze = (squeeze == SQUEEZE_MODE_LATCH_ON)
                                 ? proc->squeeze_latched
                                 : (proc->dit_pressed && proc->dah_pressed);
         if (!current_squeeze) {
@@ -332,8 +389,147 @@ static iambic_element_t *decide_next_element(iambic_processor_t *proc, iambic_el
     }
 }
 
-static void start_element(iambic_processor_t *proc, iambic_element_t element, int64_t now_us) {
+IAMBIC_INLINE void tick_idle(iambic_processor_t *proc, int64_t now_us, bool in_char,
+                             iambic_mode_t mode, squeeze_mode_t squeeze) {
+    /* Determine next element from memory or current paddle state */
+    iambic_element_t next_element;
+    const iambic_element_t *next = decide_next_element(proc, &next_element, mode, squeeze);
+
+    if (next != NULL) {
+        start_element(proc, *next, now_us, in_char);
+    }
+}
+
+static void tick_sending(iambic_processor_t *proc, int64_t now_us, iambic_element_t element) {
+    if (now_us >= proc->element_end_us) {
+        /* Element complete */
+        proc->key_down = false;
+        proc->last_element = element;
+
+        /* Enter gap (element boundary: staged config takes effect) */
+        latch_pending_config(proc);
+        proc->state = IAMBIC_STATE_GAP;
+        proc->element_start_us = now_us;
+        proc->element_duration_us = proc->timing.gap_us;
+        proc->element_end_us = now_us + proc->element_duration_us;
+    }
+}
+
+IAMBIC_INLINE void tick_gap(iambic_processor_t *proc, int64_t now_us,
+                            iambic_mode_t mode, squeeze_mode_t squeeze) {
+    if (now_us >= proc->element_end_us) {
+        /* Gap complete */
+        proc->state = IAMBIC_STATE_IDLE;
+        proc->element_duration_us = 0;
+
+        /* Immediately check for next element (same character) */
+        tick_idle(proc, now_us, true, mode, squeeze);
+    }
+}
+
+/**
+ * @brief Advance FSM to now_us with the given raw paddle state
+ *
+ * Only ever called with constant mode and squeeze (see IAMBIC_STEP).
+ */
+IAMBIC_INLINE void step_impl(iambic_processor_t *proc, int64_t now_us, gpio_state_t gpio,
+                             iambic_mode_t mode, squeeze_mode_t squeeze) {
+    /* Update paddle state and memory */
+    update_gpio(proc, gpio, now_us, mode, squeeze);
+    proc->raw_gpio = gpio;
+    proc->last_tick_us = now_us;
+
+    /* Run FSM */
+    switch (proc->state) {
+        case IAMBIC_STATE_IDLE:
+            tick_idle(proc, now_us, false, mode, squeeze);
+            break;
+        case IAMBIC_STATE_SEND_DIT:
+            tick_sending(proc, now_us, ELEMENT_DIT);
+            break;
+        case IAMBIC_STATE_SEND_DAH:
+            tick_sending(proc, now_us, ELEMENT_DAH);
+            break;
+        case IAMBIC_STATE_GAP:
+            tick_gap(proc, now_us, mode, squeeze);
+            break;
+    }
+}
+
+/** One step function per (iambic mode, squeeze mode) */
+#define IAMBIC_STEP(name, mode, squeeze) \
+    static void name(iambic_processor_t *proc, int64_t now_us, gpio_state_t gpio) { \
+        step_impl(proc, now_us, gpio, mode, squeeze); \
+    }
+
+IAMBIC_STEP(step_a_live,  IAMBIC_MODE_A, SQUEEZE_MODE_LATCH_OFF)
+IAMBIC_STEP(step_a_latch, IAMBIC_MODE_A, SQUEEZE_MODE_LATCH_ON)
+IAMBIC_STEP(step_b_live,  IAMBIC_MODE_B, SQUEEZE_MODE_LATCH_OFF)
+IAMBIC_STEP(step_b_latch, IAMBIC_MODE_B, SQUEEZE_MODE_LATCH_ON)
+
+/** Step variant for [mode == B][squeeze == LATCH_ON] */
+static const iambic_step_fn_t s_step_table[2][2] = {
+    { step_a_live, step_a_latch },
+    { step_b_live, step_b_latch },
+};
+
+/* ============================================================================
+ * Plans
+ * ============================================================================ */
+
+void iambic_plan_build(iambic_plan_t *plan, const iambic_config_t *config) {
+    assert(plan != NULL);
+    assert(config != NULL);
+
+    iambic_timing_t *t = &plan->timing;
+
+    plan->config = *config;
+    t->dit_us = iambic_dit_duration_us(config);
+    t->dah_us = iambic_dah_duration_us(config);
+    t->gap_us = iambic_gap_duration_us(config);
+    window_bounds(t->dit_us, config, &t->dit_win_start_us, &t->dit_win_end_us);
+    window_bounds(t->dah_us, config, &t->dah_win_start_us, &t->dah_win_end_us);
+    t->dit_memory_enabled = iambic_dit_memory_enabled(config->memory_mode);
+    t->dah_memory_enabled = iambic_dah_memory_enabled(config->memory_mode);
+
+    /* Anything but B / LATCH_ON behaves as A / LATCH_OFF */
+    plan->step = s_step_table[config->mode == IAMBIC_MODE_B]
+                             [config->squeeze_mode == SQUEEZE_MODE_LATCH_ON];
+}
+
+/**
+ * @brief Make a plan active (copy only)
+ */
+static void apply_plan(iambic_processor_t *proc, const iambic_plan_t *plan) {
+    proc->config = plan->config;
+    proc->timing = plan->timing;
+    proc->step = plan->step;
+}
+
+/**
+ * @brief Make config active
+ */
+static void apply_config(iambic_processor_t *proc, const iambic_config_t *config) {
+    iambic_plan_t plan;
+    iambic_plan_build(&plan, config);
+    apply_plan(proc, &plan);
+}
+
+/**
+ * @brief Swap in the staged config, if any (element boundary)
+ */
+static void latch_pending_config(iambic_processor_t *proc) {
+    if (proc->config_pending) {
+        apply_plan(proc, proc->pending_plan);
+        proc->config_pending = false;
+    }
+}
+
+static void start_element(iambic_processor_t *proc, iambic_element_t element, int64_t now_us,
+                          bool in_char) {
+    latch_pending_config(proc);
     proc->key_down = true;
+    proc->element_in_char = in_char;
 
     /* Latch squeeze state at element start (for LATCH_ON mode) */
     proc->squeeze_latched = proc->dit_pressed && proc->dah_pressed;
@@ -342,11 +538,15 @@ static void start_element(iambic_processor_t *proc, iambic_element_t element, in
     int64_t duration;
     switch (element) {
         case ELEMENT_DIT:
-            duration = iambic_dit_duration_us(&proc->config);
+            duration = proc->timing.dit_us;
+            proc->win_start_us = proc->timing.dit_win_start_us;
+            proc->win_end_us = proc->timing.dit_win_end_us;
             proc->state = IAMBIC_STATE_SEND_DIT;
             break;
         case ELEMENT_DAH:
-            duration = iambic_dah_duration_us(&proc->config);
+            duration = proc->timing.dah_us;
+            proc->win_start_us = proc->timing.dah_win_start_us;
+            proc->win_end_us = proc->timing.dah_win_end_us;
             proc->state = IAMBIC_STATE_SEND_DAH;
             break;
         default:
@@ -4,8 +4,17 @@
  */
 
 #include "iambic_preset.h"
+#include "iambic.h"
 #include <string.h>
 
+#ifdef CONFIG_IDF_TARGET
+#include "nvs.h"
+#include "esp_log.h"
+static const char *TAG = "preset";
+#define NVS_NAMESPACE "iambic"
+#define NVS_KEY_PRESETS "presets"
+#endif
+
 /* ============================================================================
  * Global Preset System Instance
  * ============================================================================ */
@@ -43,6 +52,120 @@ static const uint32_t DEFAULT_PRESET_WPM[IAMBIC_PRESET_COUNT] = {
  */
 iambic_preset_system_t g_iambic_presets;
 
+/**
+ * Two plans per preset: a rebuild fills the one not published, then
+ * publishes it
+ */
+static iambic_plan_t s_plans[IAMBIC_PRESET_COUNT][2];
+static atomic_uint_fast8_t s_plan_live[IAMBIC_PRESET_COUNT];
+
+/** Set by iambic_preset_activate(), cleared by iambic_preset_deactivate() */
+static atomic_bool s_in_use;
+
+/* RT handoff (iambic.h): seq odd while a writer copies into s_handoff */
+static atomic_uint s_handoff_seq;
+static iambic_preset_handoff_t s_handoff;
+
+/* Bumped by every change the handoff must reflect. Set while a writer owns
+ * s_handoff; a concurrent writer leaves its change to the owner, which
+ * re-copies until s_changes stops moving */
+static atomic_uint s_changes;
+static atomic_bool s_publishing;
+
+/* ============================================================================
+ * RT Handoff
+ * ============================================================================ */
+
+static void publish_handoff(void) {
+    atomic_fetch_add(&s_changes, 1U);
+    for (;;) {
+        if (atomic_exchange(&s_publishing, true)) {
+            return;
+        }
+        unsigned changes = atomic_load(&s_changes);
+
+        unsigned seq = atomic_load_explicit(&s_handoff_seq, memory_order_relaxed);
+        atomic_store_explicit(&s_handoff_seq, seq + 1U, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+        s_handoff.in_use = atomic_load(&s_in_use);
+        s_handoff.plan = *iambic_preset_active_plan();
+
+        atomic_store_explicit(&s_handoff_seq, seq + 2U, memory_order_release);
+        atomic_store(&s_publishing, false);
+
+        if (atomic_load(&s_changes) == changes) {
+            return;
+        }
+    }
+}
+
+unsigned iambic_preset_handoff_seq(void) {
+    return atomic_load_explicit(&s_handoff_seq, memory_order_acquire);
+}
+
+bool iambic_preset_read_handoff(iambic_preset_handoff_t *out, unsigned *seq_out) {
+    unsigned s1 = atomic_load_explicit(&s_handoff_seq, memory_order_acquire);
+    if (s1 & 1U) {
+        return false;
+    }
+    iambic_preset_handoff_t tmp = s_handoff;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&s_handoff_seq, memory_order_relaxed) != s1) {
+        return false;
+    }
+    *out = tmp;
+    *seq_out = s1;
+    return true;
+}
+
+/* ============================================================================
+ * Plans
+ * ============================================================================ */
+
+static void rebuild_plan(uint32_t index) {
+    const iambic_preset_t* preset = &g_iambic_presets.presets[index];
+    iambic_config_t config = {
+        .wpm = iambic_preset_get_wpm(preset),
+        .mode = iambic_preset_get_mode(preset),
+        .memory_mode = iambic_preset_get_memory_mode(preset),
+        .squeeze_mode = iambic_preset_get_squeeze_mode(preset),
+        .mem_window_start_pct = iambic_preset_get_mem_start(preset),
+        .mem_window_end_pct = iambic_preset_get_mem_end(preset),
+    };
+
+    uint_fast8_t next = 1U - atomic_load_explicit(&s_plan_live[index], memory_order_relaxed);
+    iambic_plan_build(&s_plans[index][next], &config);
+    atomic_store_explicit(&s_plan_live[index], next, memory_order_release);
+
+    if (index == iambic_preset_active_index()) {
+        publish_handoff();
+    }
+}
+
+void iambic_preset_edited(iambic_preset_t* preset) {
+    if (preset < g_iambic_presets.presets ||
+        preset >= g_iambic_presets.presets + IAMBIC_PRESET_COUNT) {
+        return;
+    }
+    rebuild_plan((uint32_t)(preset - g_iambic_presets.presets));
+}
+
+const iambic_plan_t* iambic_preset_plan(uint32_t index) {
+    if (index >= IAMBIC_PRESET_COUNT) {
+        return NULL;
+    }
+    return &s_plans[index][atomic_load_explicit(&s_plan_live[index], memory_order_acquire)];
+}
+
+const iambic_plan_t* iambic_preset_active_plan(void) {
+    uint32_t idx = (uint32_t)atomic_load_explicit(&g_iambic_presets.active_index, memory_order_relaxed);
+    if (idx >= IAMBIC_PRESET_COUNT) {
+        idx = 0;  /* Safety fallback */
+    }
+    return iambic_preset_plan(idx);
+}
+
 /* ============================================================================
  * Initialization
  * ============================================================================ */
@@ -66,10 +189,14 @@ void iambic_preset_init(void) {
         /* Set default memory window (0% - 100% = full window, compatible with legacy) */
         atomic_store_explicit(&preset->mem_window_start_pct, 0, memory_order_relaxed);
         atomic_store_explicit(&preset->mem_window_end_pct, 100, memory_order_relaxed);
+
+        rebuild_plan(i);
     }
 
-    /* Start with first preset active */
+    /* Start with first preset active, none in use */
     atomic_store_explicit(&g_iambic_presets.active_index, 0, memory_order_relaxed);
+    atomic_store(&s_in_use, false);
+    publish_handoff();
 }
 
 /* ============================================================================
@@ -103,9 +230,20 @@ bool iambic_preset_activate(uint32_t index) {
         return false;
     }
     atomic_store_explicit(&g_iambic_presets.active_index, index, memory_order_release);
+    atomic_store(&s_in_use, true);
+    publish_handoff();
     return true;
 }
 
+void iambic_preset_deactivate(void) {
+    atomic_store(&s_in_use, false);
+    publish_handoff();
+}
+
+bool iambic_preset_in_use(void) {
+    return atomic_load(&s_in_use);
+}
+
 uint32_t iambic_preset_active_index(void) {
     return (uint32_t)atomic_load_explicit(&g_iambic_presets.active_index, memory_order_relaxed);
 }
@@ -153,6 +291,7 @@ bool iambic_preset_copy(uint32_t src_index, uint32_t dst_index) {
         atomic_load_explicit(&src->mem_window_end_pct, memory_order_relaxed),
         memory_order_relaxed);
 
+    rebuild_plan(dst_index);
     return true;
 }
 
@@ -175,6 +314,7 @@ bool iambic_preset_reset(uint32_t index) {
     atomic_store_explicit(&preset->mem_window_start_pct, 60, memory_order_relaxed);
     atomic_store_explicit(&preset->mem_window_end_pct, 99, memory_order_relaxed);
 
+    rebuild_plan(index);
     return true;
 }
 
@@ -189,3 +329,113 @@ bool iambic_preset_set_name(uint32_t index, const char* name) {
 
     return true;
 }
+
+/* ============================================================================
+ * Persistence
+ * ============================================================================ */
+
+size_t iambic_preset_pack(uint8_t* out) {
+    memset(out, 0, IAMBIC_PRESET_BLOB_SIZE);
+    out[0] = IAMBIC_PRESET_SCHEMA_VERSION;
+    out[1] = IAMBIC_PRESET_COUNT;
+    out[2] = (uint8_t)iambic_preset_active_index();
+
+    for (uint32_t i = 0; i < IAMBIC_PRESET_COUNT; i++) {
+        const iambic_preset_t* preset = &g_iambic_presets.presets[i];
+        uint8_t* e = out + 4 + i * IAMBIC_PRESET_BLOB_ENTRY;
+
+        strncpy((char*)e, preset->name, IAMBIC_PRESET_NAME_MAX - 1);
+        e += IAMBIC_PRESET_NAME_MAX;
+        e[0] = (uint8_t)iambic_preset_get_wpm(preset);
+        e[1] = (uint8_t)iambic_preset_get_mode(preset);
+        e[2] = (uint8_t)iambic_preset_get_memory_mode(preset);
+        e[3] = (uint8_t)iambic_preset_get_squeeze_mode(preset);
+        e[4] = iambic_preset_get_mem_start(preset);
+        e[5] = iambic_preset_get_mem_end(preset);
+    }
+    return IAMBIC_PRESET_BLOB_SIZE;
+}
+
+/** Check one blob entry against the setter ranges */
+static bool entry_valid(const uint8_t* e) {
+    const uint8_t* v = e + IAMBIC_PRESET_NAME_MAX;
+    return v[0] >= 5 && v[0] <= 100 &&
+           v[1] <= IAMBIC_MODE_B &&
+           v[2] <= MEMORY_MODE_DOT_AND_DAH &&
+           v[3] <= SQUEEZE_MODE_LATCH_ON &&
+           v[4] <= 100 && v[5] <= 100;
+}
+
+bool iambic_preset_unpack(const uint8_t* data, size_t len) {
+    if (data == NULL || len != IAMBIC_PRESET_BLOB_SIZE ||
+        data[0] != IAMBIC_PRESET_SCHEMA_VERSION || data[1] != IAMBIC_PRESET_COUNT ||
+        data[2] >= IAMBIC_PRESET_COUNT) {
+        return false;
+    }
+    for (uint32_t i = 0; i < IAMBIC_PRESET_COUNT; i++) {
+        if (!entry_valid(data + 4 + i * IAMBIC_PRESET_BLOB_ENTRY)) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < IAMBIC_PRESET_COUNT; i++) {
+        const uint8_t* e = data + 4 + i * IAMBIC_PRESET_BLOB_ENTRY;
+        const uint8_t* v = e + IAMBIC_PRESET_NAME_MAX;
+        iambic_preset_t* preset = &g_iambic_presets.presets[i];
+
+        memcpy(preset->name, e, IAMBIC_PRESET_NAME_MAX);
+        preset->name[IAMBIC_PRESET_NAME_MAX - 1] = '\0';
+        atomic_store_explicit(&preset->speed_wpm, v[0], memory_order_relaxed);
+        atomic_store_explicit(&preset->iambic_mode, v[1], memory_order_relaxed);
+        atomic_store_explicit(&preset->memory_mode, v[2], memory_order_relaxed);
+        atomic_store_explicit(&preset->squeeze_mode, v[3], memory_order_relaxed);
+        atomic_store_explicit(&preset->mem_window_start_pct, v[4], memory_order_relaxed);
+        atomic_store_explicit(&preset->mem_window_end_pct, v[5], memory_order_relaxed);
+        rebuild_plan(i);
+    }
+    atomic_store_explicit(&g_iambic_presets.active_index, data[2], memory_order_release);
+    publish_handoff();
+    return true;
+}
+
+#ifdef CONFIG_IDF_TARGET
+bool iambic_preset_load(void) {
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+
+    uint8_t blob[IAMBIC_PRESET_BLOB_SIZE];
+    size_t len = sizeof(blob);
+    bool ok = nvs_get_blob(handle, NVS_KEY_PRESETS, blob, &len) == ESP_OK &&
+              iambic_preset_unpack(blob, len);
+    nvs_close(handle);
+
+    if (!ok) {
+        ESP_LOGW(TAG, "No valid saved presets, keeping defaults");
+    }
+    return ok;
+}
+
+bool iambic_preset_save(void) {
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return false;
+    }
+
+    uint8_t blob[IAMBIC_PRESET_BLOB_SIZE];
+    size_t len = iambic_preset_pack(blob);
+    bool ok = nvs_set_blob(handle, NVS_KEY_PRESETS, blob, len) == ESP_OK &&
+              nvs_commit(handle) == ESP_OK;
+    nvs_close(handle);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to save presets");
+    }
+    return ok;
+}
+#else
+/* Host stubs */
+bool iambic_preset_load(void) { return false; }
+bool iambic_preset_save(void) { return true; }
+#endif
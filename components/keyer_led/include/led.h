@@ -92,6 +92,9 @@ led_state_t led_get_state(void);
  * - State machine animations (breathing, flashing)
  * - Keying overlay (DIT/DAH/squeeze)
  *
+ * Renders every call but transmits only when the frame changed, so a
+ * steady state costs one compare per tick.
+ *
  * @param now_us Current timestamp in microseconds
  * @param dit DIT paddle pressed
  * @param dah DAH paddle pressed
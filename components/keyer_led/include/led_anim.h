@@ -0,0 +1,103 @@
+/**
+ * @file led_anim.h
+ * @brief Precomputed LED animations rendered into a framebuffer
+ *
+ * Everything that does not depend on time is computed once: the breathing
+ * curve as a level per 10ms step, and each palette color scaled to the
+ * full, dim and breathing levels it is shown at. Rendering a frame is then
+ * a table lookup and a fill, so led_tick() can render every tick and
+ * compare the result with the frame on the strip, transmitting only when
+ * it changed.
+ *
+ * Pure logic, no ESP-IDF calls: led.c owns one instance. Single owner, not
+ * thread-safe.
+ */
+
+#ifndef KEYER_LED_ANIM_H
+#define KEYER_LED_ANIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "led.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** LEDs a frame can hold */
+#define LED_ANIM_MAX_LEDS 16U
+
+/** Bytes per frame (RGB) */
+#define LED_ANIM_FRAME_BYTES (LED_ANIM_MAX_LEDS * 3U)
+
+/** Breathing cycle */
+#define LED_ANIM_BREATH_PERIOD_US 2000000
+
+/** Breathing curve resolution: one level per 10ms bg_task tick */
+#define LED_ANIM_BREATH_STEPS 200U
+
+/**
+ * @brief Palette (base colors of the animations)
+ */
+typedef enum {
+    LED_COLOR_RED = 0,
+    LED_COLOR_GREEN,
+    LED_COLOR_BLUE,
+    LED_COLOR_ORANGE,
+    LED_COLOR_YELLOW,
+    LED_COLOR_MAGENTA,
+    LED_COLOR_COUNT
+} led_color_t;
+
+/**
+ * @brief Precomputed tables
+ */
+typedef struct {
+    uint8_t brightness;                           /**< Levels the tables were built for */
+    uint8_t brightness_dim;
+    uint8_t breath[LED_ANIM_BREATH_STEPS];        /**< Breathing level (0..brightness) per step */
+    uint32_t full[LED_COLOR_COUNT];               /**< Palette at brightness (0xRRGGBB) */
+    uint32_t dim[LED_COLOR_COUNT];                /**< Palette at brightness_dim */
+} led_anim_t;
+
+/**
+ * @brief Build the tables
+ *
+ * Call at init and whenever the brightness changes.
+ *
+ * @param anim Tables
+ * @param brightness Master brightness 0-100
+ * @param brightness_dim Dim brightness 0-100
+ */
+void led_anim_init(led_anim_t *anim, uint8_t brightness, uint8_t brightness_dim);
+
+/**
+ * @brief Render one frame
+ *
+ * Timed states end by themselves: WIFI_FAILED after its red flash, and
+ * CONNECTED after three green flashes. Their follow-up state is returned
+ * and nothing is rendered; the caller switches state and renders again.
+ *
+ * @param anim Tables
+ * @param state State to show
+ * @param elapsed_us Time since the state was entered
+ * @param dit DIT paddle pressed (IDLE overlay)
+ * @param dah DAH paddle pressed (IDLE overlay)
+ * @param frame Destination, count * 3 bytes RGB
+ * @param count LEDs (at most LED_ANIM_MAX_LEDS)
+ * @return state, or the state to switch to
+ */
+led_state_t led_anim_render(const led_anim_t *anim, led_state_t state, int64_t elapsed_us,
+                            bool dit, bool dah, uint8_t *frame, size_t count);
+
+/**
+ * @brief Scale a 0xRRGGBB color to a brightness level 0-100
+ */
+uint32_t led_anim_scale(uint32_t color, uint8_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_LED_ANIM_H */
@@ -1,36 +1,25 @@
 /**
  * @file led.c
  * @brief WS2812B RGB LED driver implementation
+ *
+ * led_tick() renders the current animation (led_anim.h) into a frame and
+ * transmits it only when it differs from the frame on the strip: steady
+ * states cost one compare per tick, and the RMT encoder / ISR runs only on
+ * a visible change. The frame goes out by DMA where the RMT supports it,
+ * in one burst instead of a refill interrupt every half memory block.
  */
 
 #include "led.h"
+#include "led_anim.h"
 #include "driver/rmt_tx.h"
 #include "esp_timer.h"
 #include <string.h>
 #include <stdatomic.h>
 #include "esp_log.h"
+#include "soc/soc_caps.h"
 
 static const char *TAG = "led";
 
-/* Maximum number of LEDs supported */
-#define MAX_LEDS 16
-
-/* RGB color definitions (format: 0xRRGGBB) */
-#define COLOR_OFF       0x000000U
-#define COLOR_RED       0xFF0000U   /* R=FF, G=0, B=0 */
-#define COLOR_GREEN     0x00FF00U   /* R=0, G=FF, B=0 */
-#define COLOR_BLUE      0x0000FFU   /* R=0, G=0, B=FF */
-#define COLOR_ORANGE    0xFF8000U   /* R=FF, G=80, B=0 */
-#define COLOR_YELLOW    0xFFA000U   /* R=FF, G=A0, B=0 */
-#define COLOR_MAGENTA   0xFF00FFU   /* R=FF, G=0, B=FF */
-
-/* Animation timing constants */
-#define BREATH_PERIOD_US    2000000  /* 2s full breath cycle */
-#define FLASH_DURATION_US   100000   /* 100ms per flash */
-#define FLASH_GAP_US        100000   /* 100ms between flashes */
-#define RED_FLASH_US        500000   /* 500ms red flash */
-#define AP_TOGGLE_US        500000   /* 500ms alternating */
-
 /* RMT configuration */
 #define RMT_RESOLUTION_HZ   10000000 /* 10MHz resolution (100ns) */
 #define WS2812B_T0H_TICKS   4        /* 0: 400ns high */
@@ -39,6 +28,10 @@ static const char *TAG = "led";
 #define WS2812B_T1L_TICKS   5        /* 1: 500ns low */
 #define WS2812B_RESET_TICKS 100      /* Reset: 10µs low */
 
+/* RMT symbols: 24 per LED plus the reset code; a DMA buffer holds a whole frame */
+#define RMT_MEM_SYMBOLS     64
+#define RMT_DMA_SYMBOLS     ((LED_ANIM_MAX_LEDS * 24U + 1U + 63U) & ~63U)
+
 /**
  * @brief LED strip encoder state
  */
@@ -58,7 +51,11 @@ static struct {
     led_config_t config;
     rmt_channel_handle_t rmt_channel;
     rmt_encoder_handle_t encoder;
-    uint8_t pixel_buf[MAX_LEDS * 3];
+    uint8_t pixel_buf[LED_ANIM_FRAME_BYTES];  /* Frame on the strip (RMT reads it) */
+    uint8_t frame[LED_ANIM_FRAME_BYTES];      /* Frame being rendered */
+    bool frame_sent;                          /* pixel_buf is on the strip */
+    bool dma;                                 /* Channel transmits by DMA */
+    led_anim_t anim;
     _Atomic led_state_t state;
     int64_t state_start_us;
     _Atomic uint8_t brightness;
@@ -200,59 +197,15 @@ static esp_err_t led_strip_reset(rmt_encoder_t *encoder)
     return ESP_OK;
 }
 
-/**
- * @brief Apply brightness scaling to a 24-bit GRB color
- */
-static uint32_t apply_brightness(uint32_t color, uint8_t brightness)
-{
-    if (brightness >= 100U) {
-        return color;
-    }
-
-    uint8_t g = (uint8_t)((color >> 16) & 0xFFU);
-    uint8_t r = (uint8_t)((color >> 8) & 0xFFU);
-    uint8_t b = (uint8_t)(color & 0xFFU);
-
-    g = (uint8_t)((g * brightness) / 100U);
-    r = (uint8_t)((r * brightness) / 100U);
-    b = (uint8_t)((b * brightness) / 100U);
-
-    return ((uint32_t)g << 16) | ((uint32_t)r << 8) | (uint32_t)b;
-}
-
-/**
- * @brief Set all LEDs to a single color
- */
-static void set_all_leds(uint32_t color)
-{
-    for (size_t i = 0; i < s_led.config.led_count; i++) {
-        s_led.pixel_buf[i * 3U + 0U] = (uint8_t)((color >> 16) & 0xFFU); /* R */
-        s_led.pixel_buf[i * 3U + 1U] = (uint8_t)((color >> 8) & 0xFFU);  /* G */
-        s_led.pixel_buf[i * 3U + 2U] = (uint8_t)(color & 0xFFU);         /* B */
-    }
-}
-
-/**
- * @brief Set a single LED to a color
- */
-static void set_led(size_t index, uint32_t color)
-{
-    if (index >= s_led.config.led_count) {
-        return;
-    }
-
-    s_led.pixel_buf[index * 3U + 0U] = (uint8_t)((color >> 16) & 0xFFU); /* R */
-    s_led.pixel_buf[index * 3U + 1U] = (uint8_t)((color >> 8) & 0xFFU);  /* G */
-    s_led.pixel_buf[index * 3U + 2U] = (uint8_t)(color & 0xFFU);         /* B */
-}
-
 /**
  * @brief Transmit pixel buffer to LEDs
+ *
+ * @return true if the frame was queued
  */
-static void transmit_leds(void)
+static bool transmit_leds(void)
 {
     if (!s_led.initialized) {
-        return;
+        return false;
     }
 
     rmt_transmit_config_t tx_config = {
@@ -264,28 +217,9 @@ static void transmit_leds(void)
                                   s_led.pixel_buf, buf_size, &tx_config);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "rmt_transmit failed: %s", esp_err_to_name(ret));
+        return false;
     }
-}
-
-/**
- * @brief Calculate breathing brightness (triangle wave)
- */
-static uint8_t calculate_breathing(int64_t elapsed_us, uint8_t brightness)
-{
-    /* Triangle wave: 0 -> max -> 0 over BREATH_PERIOD_US */
-    int64_t phase = elapsed_us % BREATH_PERIOD_US;
-    uint32_t half_period = (uint32_t)(BREATH_PERIOD_US / 2);
-
-    uint32_t value;
-    if (phase < (int64_t)half_period) {
-        /* Rising edge: 0 to brightness */
-        value = ((uint32_t)phase * brightness) / half_period;
-    } else {
-        /* Falling edge: brightness to 0 */
-        value = (((uint32_t)(BREATH_PERIOD_US - phase)) * brightness) / half_period;
-    }
-
-    return (uint8_t)value;
+    return true;
 }
 
 esp_err_t led_init(const led_config_t *config)
@@ -299,8 +233,8 @@ esp_err_t led_init(const led_config_t *config)
         return ESP_OK;
     }
 
-    if (config->led_count > MAX_LEDS) {
-        ESP_LOGE(TAG, "led_count %u exceeds MAX_LEDS %u", config->led_count, MAX_LEDS);
+    if (config->led_count > LED_ANIM_MAX_LEDS) {
+        ESP_LOGE(TAG, "led_count %u exceeds %u", config->led_count, LED_ANIM_MAX_LEDS);
         return ESP_ERR_INVALID_ARG;
     }
 
@@ -315,19 +249,35 @@ esp_err_t led_init(const led_config_t *config)
     atomic_store_explicit(&s_led.brightness_dim, config->brightness_dim, memory_order_relaxed);
     atomic_store_explicit(&s_led.state, LED_STATE_OFF, memory_order_relaxed);
     s_led.state_start_us = 0;
+    led_anim_init(&s_led.anim, config->brightness, config->brightness_dim);
 
     /* Configure RMT TX channel */
     rmt_tx_channel_config_t tx_config = {
         .gpio_num = (gpio_num_t)config->gpio_data,
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .resolution_hz = RMT_RESOLUTION_HZ,
-        .mem_block_symbols = 64,
+        .mem_block_symbols = RMT_MEM_SYMBOLS,
         .trans_queue_depth = 4,
         .flags.invert_out = false,
         .flags.with_dma = false,
     };
 
-    esp_err_t ret = rmt_new_tx_channel(&tx_config, &s_led.rmt_channel);
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+#if SOC_RMT_SUPPORT_DMA
+    /* The only DMA-capable TX channel may be taken: fall back to RMT memory */
+    tx_config.mem_block_symbols = RMT_DMA_SYMBOLS;
+    tx_config.flags.with_dma = true;
+    ret = rmt_new_tx_channel(&tx_config, &s_led.rmt_channel);
+    s_led.dma = (ret == ESP_OK);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "RMT DMA unavailable (%s), using RMT memory", esp_err_to_name(ret));
+        tx_config.mem_block_symbols = RMT_MEM_SYMBOLS;
+        tx_config.flags.with_dma = false;
+    }
+#endif
+    if (ret != ESP_OK) {
+        ret = rmt_new_tx_channel(&tx_config, &s_led.rmt_channel);
+    }
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "rmt_new_tx_channel failed: %s", esp_err_to_name(ret));
         return ret;
@@ -351,12 +301,13 @@ esp_err_t led_init(const led_config_t *config)
     }
 
     /* Initialize all LEDs off */
+    s_led.initialized = true;
     memset(s_led.pixel_buf, 0, sizeof(s_led.pixel_buf));
-    transmit_leds();
+    s_led.frame_sent = transmit_leds();
 
-    s_led.initialized = true;
-    ESP_LOGI(TAG, "Initialized: gpio=%u, count=%u, brightness=%u/%u",
-             config->gpio_data, config->led_count, config->brightness, config->brightness_dim);
+    ESP_LOGI(TAG, "Initialized: gpio=%u, count=%u, brightness=%u/%u, %s",
+             config->gpio_data, config->led_count, config->brightness, config->brightness_dim,
+             s_led.dma ? "DMA" : "no DMA");
 
     return ESP_OK;
 }
@@ -368,8 +319,10 @@ void led_deinit(void)
     }
 
     /* Turn off all LEDs */
+    rmt_tx_wait_all_done(s_led.rmt_channel, 100);
     memset(s_led.pixel_buf, 0, sizeof(s_led.pixel_buf));
     transmit_leds();
+    rmt_tx_wait_all_done(s_led.rmt_channel, 100);
 
     /* Disable and delete RMT resources */
     rmt_disable(s_led.rmt_channel);
@@ -401,116 +354,35 @@ void led_tick(int64_t now_us, bool dit, bool dah)
         return;
     }
 
-    led_state_t current_state = atomic_load_explicit(&s_led.state, memory_order_relaxed);
-    int64_t elapsed_us = now_us - s_led.state_start_us;
     uint8_t brightness = atomic_load_explicit(&s_led.brightness, memory_order_relaxed);
     uint8_t brightness_dim = atomic_load_explicit(&s_led.brightness_dim, memory_order_relaxed);
-
-    switch (current_state) {
-    case LED_STATE_OFF:
-        set_all_leds(COLOR_OFF);
-        break;
-
-    case LED_STATE_BOOT:
-    case LED_STATE_WIFI_CONNECTING: {
-        /* Orange breathing */
-        uint8_t breath = calculate_breathing(elapsed_us, brightness);
-        uint32_t color = apply_brightness(COLOR_ORANGE, breath);
-        set_all_leds(color);
-        break;
-    }
-
-    case LED_STATE_WIFI_FAILED: {
-        /* Red flash for 500ms, then auto-transition to DEGRADED */
-        if (elapsed_us < RED_FLASH_US) {
-            uint32_t color = apply_brightness(COLOR_RED, brightness);
-            set_all_leds(color);
-        } else {
-            led_set_state(LED_STATE_DEGRADED);
-            return; /* Will be rendered on next tick */
-        }
-        break;
+    if (brightness != s_led.anim.brightness || brightness_dim != s_led.anim.brightness_dim) {
+        led_anim_init(&s_led.anim, brightness, brightness_dim);
     }
 
-    case LED_STATE_DEGRADED: {
-        /* Dim yellow steady */
-        uint32_t color = apply_brightness(COLOR_YELLOW, brightness_dim);
-        set_all_leds(color);
-        break;
-    }
-
-    case LED_STATE_AP_MODE: {
-        /* Alternating orange/blue every 500ms */
-        int64_t phase = elapsed_us % (AP_TOGGLE_US * 2);
-        uint32_t base_color = (phase < AP_TOGGLE_US) ? COLOR_ORANGE : COLOR_BLUE;
-        uint32_t color = apply_brightness(base_color, brightness);
-        set_all_leds(color);
-        break;
-    }
-
-    case LED_STATE_PROVISIONING: {
-        /* Blue breathing for provisioning mode */
-        uint8_t breath_brightness = calculate_breathing(elapsed_us, brightness);
-        uint32_t color = apply_brightness(COLOR_BLUE, breath_brightness);
-        set_all_leds(color);
-        break;
-    }
-
-    case LED_STATE_CONNECTED: {
-        /* 3 quick green flashes, then auto-transition to IDLE */
-        int64_t flash_cycle = FLASH_DURATION_US + FLASH_GAP_US;
-        int64_t flash_num = elapsed_us / flash_cycle;
-
-        if (flash_num >= 3) {
-            led_set_state(LED_STATE_IDLE);
-            return; /* Will be rendered on next tick */
-        }
-
-        int64_t phase = elapsed_us % flash_cycle;
-        if (phase < FLASH_DURATION_US) {
-            uint32_t color = apply_brightness(COLOR_GREEN, brightness);
-            set_all_leds(color);
-        } else {
-            set_all_leds(COLOR_OFF);
-        }
-        break;
+    led_state_t current_state = atomic_load_explicit(&s_led.state, memory_order_relaxed);
+    size_t count = (size_t)s_led.config.led_count;
+    led_state_t next_state = led_anim_render(&s_led.anim, current_state,
+                                             now_us - s_led.state_start_us,
+                                             dit, dah, s_led.frame, count);
+    if (next_state != current_state) {
+        led_set_state(next_state);
+        return; /* Will be rendered on next tick */
     }
 
-    case LED_STATE_IDLE: {
-        /* Dim green steady with keying overlay */
-        uint32_t base_color = apply_brightness(COLOR_GREEN, brightness_dim);
-        set_all_leds(base_color);
-
-        /* Keying overlay */
-        if (dit && dah) {
-            /* Squeeze: center LED magenta */
-            size_t center = (size_t)s_led.config.led_count / 2U;
-            uint32_t magenta = apply_brightness(COLOR_MAGENTA, brightness);
-            set_led(center, magenta);
-        } else if (dit) {
-            /* DIT: left LEDs bright green */
-            size_t center = (size_t)s_led.config.led_count / 2U;
-            uint32_t bright_green = apply_brightness(COLOR_GREEN, brightness);
-            for (size_t i = 0; i < center; i++) {
-                set_led(i, bright_green);
-            }
-        } else if (dah) {
-            /* DAH: right LEDs bright green */
-            size_t center = (size_t)s_led.config.led_count / 2U;
-            uint32_t bright_green = apply_brightness(COLOR_GREEN, brightness);
-            for (size_t i = center + 1U; i < s_led.config.led_count; i++) {
-                set_led(i, bright_green);
-            }
-        }
-        break;
+    /* Unchanged frame: nothing to send */
+    size_t bytes = count * 3U;
+    if (s_led.frame_sent && memcmp(s_led.frame, s_led.pixel_buf, bytes) == 0) {
+        return;
     }
 
-    default:
-        set_all_leds(COLOR_OFF);
-        break;
+    /* RMT still reading pixel_buf: keep the frame for the next tick */
+    if (rmt_tx_wait_all_done(s_led.rmt_channel, 0) != ESP_OK) {
+        return;
     }
 
-    transmit_leds();
+    memcpy(s_led.pixel_buf, s_led.frame, bytes);
+    s_led.frame_sent = transmit_leds();
 }
 
 void led_set_brightness(uint8_t brightness, uint8_t brightness_dim)
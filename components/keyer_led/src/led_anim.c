@@ -0,0 +1,175 @@
+/**
+ * @file led_anim.c
+ * @brief Precomputed LED animations rendered into a framebuffer
+ */
+
+#include "led_anim.h"
+#include <string.h>
+
+/* Animation timing */
+#define AP_TOGGLE_US 500000   /* 500ms alternating */
+
+/* Base colors, 0xRRGGBB (led_color_t order) */
+static const uint32_t k_palette[LED_COLOR_COUNT] = {
+    [LED_COLOR_RED]     = 0xFF0000U,
+    [LED_COLOR_GREEN]   = 0x00FF00U,
+    [LED_COLOR_BLUE]    = 0x0000FFU,
+    [LED_COLOR_ORANGE]  = 0xFF8000U,
+    [LED_COLOR_YELLOW]  = 0xFFA000U,
+    [LED_COLOR_MAGENTA] = 0xFF00FFU,
+};
+
+/**
+ * @brief Step of a flash sequence: lit or dark until end_us
+ */
+typedef struct {
+    int32_t end_us;
+    bool lit;
+} flash_step_t;
+
+/* WIFI_FAILED: one 500ms red flash */
+static const flash_step_t k_failed_seq[] = {
+    { 500000, true },
+};
+
+/* CONNECTED: three 100ms green flashes, 100ms apart */
+static const flash_step_t k_connected_seq[] = {
+    { 100000, true }, { 200000, false },
+    { 300000, true }, { 400000, false },
+    { 500000, true }, { 600000, false },
+};
+
+#define SEQ_LEN(seq) (sizeof(seq) / sizeof((seq)[0]))
+
+/**
+ * @brief Look up a flash sequence
+ *
+ * @return 1 lit, 0 dark, -1 once the sequence is over
+ */
+static int flash_at(const flash_step_t *seq, size_t len, int64_t elapsed_us) {
+    for (size_t i = 0; i < len; i++) {
+        if (elapsed_us < seq[i].end_us) {
+            return seq[i].lit ? 1 : 0;
+        }
+    }
+    return -1;
+}
+
+uint32_t led_anim_scale(uint32_t color, uint8_t level) {
+    if (level >= 100U) {
+        return color;
+    }
+    uint32_t r = ((color >> 16) & 0xFFU) * level / 100U;
+    uint32_t g = ((color >> 8) & 0xFFU) * level / 100U;
+    uint32_t b = (color & 0xFFU) * level / 100U;
+    return (r << 16) | (g << 8) | b;
+}
+
+void led_anim_init(led_anim_t *anim, uint8_t brightness, uint8_t brightness_dim) {
+    anim->brightness = brightness;
+    anim->brightness_dim = brightness_dim;
+
+    /* Triangle wave: 0 -> brightness -> 0 over one period */
+    const uint32_t half = LED_ANIM_BREATH_STEPS / 2U;
+    for (uint32_t i = 0; i < LED_ANIM_BREATH_STEPS; i++) {
+        uint32_t rise = (i < half) ? i : (LED_ANIM_BREATH_STEPS - i);
+        anim->breath[i] = (uint8_t)(rise * brightness / half);
+    }
+
+    for (size_t c = 0; c < LED_COLOR_COUNT; c++) {
+        anim->full[c] = led_anim_scale(k_palette[c], brightness);
+        anim->dim[c] = led_anim_scale(k_palette[c], brightness_dim);
+    }
+}
+
+static void fill(uint8_t *frame, size_t from, size_t to, uint32_t color) {
+    for (size_t i = from; i < to; i++) {
+        frame[i * 3U + 0U] = (uint8_t)((color >> 16) & 0xFFU); /* R */
+        frame[i * 3U + 1U] = (uint8_t)((color >> 8) & 0xFFU);  /* G */
+        frame[i * 3U + 2U] = (uint8_t)(color & 0xFFU);         /* B */
+    }
+}
+
+static uint32_t breathing(const led_anim_t *anim, led_color_t color, int64_t elapsed_us) {
+    int64_t step = (elapsed_us % LED_ANIM_BREATH_PERIOD_US) /
+                   (LED_ANIM_BREATH_PERIOD_US / (int64_t)LED_ANIM_BREATH_STEPS);
+    return led_anim_scale(k_palette[color], anim->breath[step]);
+}
+
+led_state_t led_anim_render(const led_anim_t *anim, led_state_t state, int64_t elapsed_us,
+                            bool dit, bool dah, uint8_t *frame, size_t count) {
+    if (count > LED_ANIM_MAX_LEDS) {
+        count = LED_ANIM_MAX_LEDS;
+    }
+    if (elapsed_us < 0) {
+        elapsed_us = 0;
+    }
+
+    switch (state) {
+    case LED_STATE_BOOT:
+    case LED_STATE_WIFI_CONNECTING:
+        /* Orange breathing */
+        fill(frame, 0, count, breathing(anim, LED_COLOR_ORANGE, elapsed_us));
+        break;
+
+    case LED_STATE_WIFI_FAILED: {
+        /* Red flash, then DEGRADED */
+        int lit = flash_at(k_failed_seq, SEQ_LEN(k_failed_seq), elapsed_us);
+        if (lit < 0) {
+            return LED_STATE_DEGRADED;
+        }
+        fill(frame, 0, count, lit ? anim->full[LED_COLOR_RED] : 0U);
+        break;
+    }
+
+    case LED_STATE_DEGRADED:
+        /* Dim yellow steady */
+        fill(frame, 0, count, anim->dim[LED_COLOR_YELLOW]);
+        break;
+
+    case LED_STATE_AP_MODE: {
+        /* Alternating orange/blue */
+        bool first = (elapsed_us % (AP_TOGGLE_US * 2)) < AP_TOGGLE_US;
+        fill(frame, 0, count, anim->full[first ? LED_COLOR_ORANGE : LED_COLOR_BLUE]);
+        break;
+    }
+
+    case LED_STATE_PROVISIONING:
+        /* Blue breathing */
+        fill(frame, 0, count, breathing(anim, LED_COLOR_BLUE, elapsed_us));
+        break;
+
+    case LED_STATE_CONNECTED: {
+        /* Green flashes, then IDLE */
+        int lit = flash_at(k_connected_seq, SEQ_LEN(k_connected_seq), elapsed_us);
+        if (lit < 0) {
+            return LED_STATE_IDLE;
+        }
+        fill(frame, 0, count, lit ? anim->full[LED_COLOR_GREEN] : 0U);
+        break;
+    }
+
+    case LED_STATE_IDLE: {
+        /* Dim green steady with keying overlay */
+        size_t center = count / 2U;
+        fill(frame, 0, count, anim->dim[LED_COLOR_GREEN]);
+        if (dit && dah) {
+            /* Squeeze: center LED magenta */
+            fill(frame, center, center + 1U, anim->full[LED_COLOR_MAGENTA]);
+        } else if (dit) {
+            /* DIT: left LEDs bright green */
+            fill(frame, 0, center, anim->full[LED_COLOR_GREEN]);
+        } else if (dah) {
+            /* DAH: right LEDs bright green */
+            fill(frame, center + 1U, count, anim->full[LED_COLOR_GREEN]);
+        }
+        break;
+    }
+
+    case LED_STATE_OFF:
+    default:
+        memset(frame, 0, count * 3U);
+        break;
+    }
+    return state;
+}
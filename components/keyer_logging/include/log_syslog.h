@@ -0,0 +1,131 @@
+/**
+ * @file log_syslog.h
+ * @brief Remote syslog datagrams (RFC 5424 text or packed binary)
+ *
+ * What the syslog sink (syslog_sink.h) sends to system.syslog_host, kept
+ * free of sockets so the host tests can check it. Two formats:
+ *
+ * - RFC5424: one message per datagram, as RFC 5426 requires, so any
+ *   collector takes it:
+ *     <134>1 2026-10-14T09:12:03.250000Z N0CALL keyer - BG
+ *         [meta sequenceId="42" sysUpTime="12345"] WiFi connected
+ *   The timestamp is "-" while the wall clock is unset; sysUpTime is the
+ *   record's own time in hundredths of a second since boot.
+ *
+ * - BINARY: log_wire.h frames packed into one datagram, as many records
+ *   as fit. Every datagram starts with HELLO and a fresh format
+ *   dictionary, so each one decodes alone whatever was lost before it
+ *   (tools/logdec --udp).
+ *
+ * A token bucket bounds the datagrams sent per second. Records the sink
+ * cannot send stay in the log ring; what the ring overwrites meanwhile is
+ * counted by the sink's reader and reported as dropped.
+ */
+
+#ifndef KEYER_LOG_SYSLOG_H
+#define KEYER_LOG_SYSLOG_H
+
+#include "rt_log.h"
+#include "log_wire.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default collector port */
+#define LOG_SYSLOG_PORT 514U
+
+/** Datagram size: under the WireGuard tunnel MTU (1420) with room to spare */
+#define LOG_SYSLOG_DATAGRAM_MAX 1200U
+
+/** Facility: local0 */
+#define LOG_SYSLOG_FACILITY 16U
+
+/**
+ * @brief Datagram format (system.syslog_format)
+ */
+typedef enum {
+    LOG_SYSLOG_RFC5424 = 0,
+    LOG_SYSLOG_BINARY = 1,
+} log_syslog_format_t;
+
+/**
+ * @brief Datagram being filled (BINARY)
+ */
+typedef struct {
+    uint8_t buf[LOG_SYSLOG_DATAGRAM_MAX];
+    size_t len;                   /**< Bytes used, HELLO included */
+    uint32_t records;             /**< RECORD frames in buf */
+    log_wire_dict_t dict;         /**< Formats announced in this datagram */
+} log_syslog_batch_t;
+
+/**
+ * @brief Token bucket (datagrams per second)
+ */
+typedef struct {
+    int64_t last_us;              /**< Last refill */
+    uint32_t tokens_x1000;        /**< Datagrams that may go now, thousandths */
+} log_syslog_rate_t;
+
+/**
+ * @brief Syslog severity of a log level
+ */
+uint8_t log_syslog_severity(log_level_t level);
+
+/**
+ * @brief Format one RFC 5424 message
+ *
+ * @param entry Record
+ * @param host HOSTNAME field (spaces become '_', empty = "-")
+ * @param msgid MSGID field: the log stream ("RT", "BG")
+ * @param seq sequenceId (1 .. 2^31 - 1)
+ * @param wall_us Wall clock minus uptime, in microseconds; 0 = unset
+ * @param buf Destination (NUL-terminated)
+ * @param cap Size of buf
+ * @return Length written (the message is cut to fit)
+ */
+size_t log_syslog_rfc5424(const log_entry_t *entry, const char *host, const char *msgid,
+                          uint32_t seq, int64_t wall_us, char *buf, size_t cap);
+
+/**
+ * @brief Start an empty BINARY datagram (HELLO, new dictionary)
+ */
+void log_syslog_batch_begin(log_syslog_batch_t *batch);
+
+/**
+ * @brief Add one record to the datagram
+ *
+ * @param tag Stream tag ID (LOG_TAGS)
+ * @return false if it does not fit: send the datagram and begin another
+ */
+bool log_syslog_batch_add(log_syslog_batch_t *batch, const log_entry_t *entry, uint8_t tag);
+
+/**
+ * @brief Add a DROPPED frame (records a stream lost)
+ *
+ * @return false if it does not fit
+ */
+bool log_syslog_batch_dropped(log_syslog_batch_t *batch, uint8_t tag, uint32_t count);
+
+/**
+ * @brief Fill the bucket (starts full)
+ */
+void log_syslog_rate_init(log_syslog_rate_t *rate, int64_t now_us, uint32_t per_s);
+
+/**
+ * @brief Take one datagram from the bucket
+ *
+ * Refills at per_s a second, holding up to one second's worth.
+ *
+ * @return true if one may be sent now
+ */
+bool log_syslog_rate_take(log_syslog_rate_t *rate, int64_t now_us, uint32_t per_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_LOG_SYSLOG_H */
@@ -0,0 +1,107 @@
+/**
+ * @file log_wire.h
+ * @brief Binary log wire format (deferred formatting on the host)
+ *
+ * A log entry goes out as its format ID, tag ID and the raw argument bytes
+ * log_vpack() stored; tools/logdec expands them on the PC. Neither core
+ * formats text, so verbose diagnostics can stream at full USB speed.
+ *
+ * Frame:
+ *   0xA5 | type | len | payload[len] | sum
+ *   sum = type + len + payload bytes (mod 256); multi-byte fields LE
+ *
+ * Types:
+ *   HELLO   version, sizeof int, long, long long, size_t, void *
+ *           (the widths log_vpack() used)
+ *   FMT     u16 id, format string bytes: defines an ID before first use
+ *   RECORD  i64 timestamp_us, u8 level, u8 tag, u16 fmt id, args
+ *           (fmt id LOG_WIRE_TEXT_ID: args is plain text)
+ *   DROPPED u8 tag, u32 entries lost since the last report
+ *
+ * Tag IDs index LOG_TAGS (scripts/gen_log_tags.py, log_tags.h); the
+ * decoder reads the same generated header. Format IDs are assigned on
+ * the fly and announced with a FMT frame the first time each is used, so
+ * the host needs no table built from the firmware image. A new session
+ * (HELLO) starts with an empty dictionary.
+ */
+
+#ifndef KEYER_LOG_WIRE_H
+#define KEYER_LOG_WIRE_H
+
+#include "rt_log.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_WIRE_SYNC     0xA5U
+#define LOG_WIRE_VERSION  1U
+
+#define LOG_WIRE_HELLO    0x00U
+#define LOG_WIRE_FMT      0x01U
+#define LOG_WIRE_RECORD   0x02U
+#define LOG_WIRE_DROPPED  0x03U
+
+/** Sync, type, len, checksum */
+#define LOG_WIRE_OVERHEAD 4U
+
+/** Largest frame */
+#define LOG_WIRE_FRAME_MAX (LOG_WIRE_OVERHEAD + 255U)
+
+/** Format strings longer than this are cut in FMT frames */
+#define LOG_WIRE_FMT_MAX  (255U - 2U)
+
+/** RECORD fmt id of a plain-text entry */
+#define LOG_WIRE_TEXT_ID  0xFFFFU
+
+/** Format IDs per session (power of 2); a full dictionary sends text */
+#define LOG_WIRE_DICT_SIZE 256U
+
+/**
+ * @brief Format pointers announced in the current session
+ */
+typedef struct {
+    const char *fmts[LOG_WIRE_DICT_SIZE];
+} log_wire_dict_t;
+
+/**
+ * @brief Forget every announced format (new session)
+ */
+void log_wire_dict_reset(log_wire_dict_t *dict);
+
+/**
+ * @brief HELLO frame
+ *
+ * @param buf At least LOG_WIRE_FRAME_MAX bytes
+ * @return Frame length
+ */
+size_t log_wire_hello(uint8_t *buf);
+
+/**
+ * @brief DROPPED frame
+ *
+ * @param buf At least LOG_WIRE_FRAME_MAX bytes
+ * @return Frame length
+ */
+size_t log_wire_dropped(uint8_t *buf, uint8_t tag, uint32_t count);
+
+/**
+ * @brief RECORD frame for an entry, preceded by FMT if its format is new
+ *
+ * Entries whose format does not fit in the dictionary are formatted here
+ * and sent as text.
+ *
+ * @param buf At least 2 * LOG_WIRE_FRAME_MAX bytes
+ * @return Bytes written
+ */
+size_t log_wire_encode(log_wire_dict_t *dict, const log_entry_t *entry, uint8_t tag,
+                       uint8_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_LOG_WIRE_H */
@@ -2,8 +2,17 @@
  * @file rt_log.h
  * @brief RT-safe non-blocking logging system
  *
- * Lock-free log stream with ~100-200ns push latency.
- * UART drain task runs on Core 1.
+ * Lock-free log stream with ~100-200ns push latency. Single producer,
+ * any number of readers (log_reader_t): every sink (UART, USB, ...) keeps
+ * its own cursor, level filter and drop counter, so one push serves all
+ * of them. The producer never waits for a reader; a full ring overwrites
+ * its oldest records and a reader that falls behind loses those.
+ *
+ * Formatting is deferred: RT_LOG stores the format pointer and the raw
+ * argument bytes (log_vpack()), and only the drain side expands them
+ * (log_entry_format()), or ships them as they are (usb_log binary mode).
+ * Format strings must therefore be literals; %s arguments are copied at
+ * push time.
  *
  * ARCHITECTURE.md compliance:
  * - RULE 3.1.4: No operation shall block
@@ -18,6 +27,11 @@
 #include <stdbool.h>
 #include <stdatomic.h>
 #include <stdio.h>
+#include <stdarg.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,11 +41,20 @@ extern "C" {
  * Configuration
  * ============================================================================ */
 
-/** Maximum message length (truncated if exceeded) */
+/** Maximum message length (truncated if exceeded), also the packed argument space */
 #define LOG_MAX_MSG_LEN 120
 
-/** Log buffer size (number of entries, must be power of 2) */
-#define LOG_BUFFER_SIZE 256
+/**
+ * Log ring size in bytes (must be power of 2). Records are a
+ * log_record_t header plus their argument bytes, ~20-40 bytes for a
+ * typical RT message: room for about 256 of them (128 without PSRAM,
+ * CONFIG_KEYER_INTERNAL_RAM_ONLY).
+ */
+#ifdef CONFIG_KEYER_INTERNAL_RAM_ONLY
+#define LOG_RING_BYTES 4096
+#else
+#define LOG_RING_BYTES 8192
+#endif
 
 /* ============================================================================
  * Types
@@ -49,23 +72,47 @@ typedef enum {
 } log_level_t;
 
 /**
- * @brief Log entry
+ * @brief Log entry: a drained record, unpacked (consumer side)
+ *
+ * args holds the arguments packed by log_vpack() for fmt, each at its
+ * native width (%s inline, NUL-terminated), or plain text when fmt is
+ * NULL (log_stream_push()).
  */
 typedef struct {
     int64_t timestamp_us;              /**< Timestamp in microseconds */
+    const char *fmt;                   /**< Format (static storage), NULL for text */
     log_level_t level;                 /**< Log level */
-    uint8_t len;                       /**< Message length */
-    char msg[LOG_MAX_MSG_LEN];         /**< Message buffer */
+    uint8_t len;                       /**< Bytes used in args */
+    uint8_t args[LOG_MAX_MSG_LEN];     /**< Packed arguments or message text */
 } log_entry_t;
 
 /**
- * @brief Lock-free log stream
+ * @brief Record header in the ring, followed by len argument bytes
+ *
+ * Unaligned in the ring (records are packed back to back and may wrap),
+ * so always copied in and out with memcpy.
+ */
+typedef struct __attribute__((packed)) {
+    int64_t timestamp_us;              /**< Timestamp in microseconds */
+    const char *fmt;                   /**< Format (static storage), NULL for text */
+    uint32_t seq;                      /**< Record number: readers count gaps */
+    uint8_t level;                     /**< log_level_t */
+    uint8_t len;                       /**< Argument / text bytes that follow */
+} log_record_t;
+
+/**
+ * @brief Lock-free log stream: variable-length records in a byte ring
+ *
+ * Bytes [tail_idx, write_idx) hold intact records. Only the producer
+ * writes the indices; it moves tail_idx past the records it is about to
+ * overwrite before touching their bytes, which is what readers check.
  */
 typedef struct {
-    log_entry_t entries[LOG_BUFFER_SIZE]; /**< Entry ring buffer */
-    atomic_uint write_idx;                 /**< Producer write index */
-    atomic_uint read_idx;                  /**< Consumer read index */
-    atomic_uint dropped;                   /**< Dropped message counter */
+    uint8_t ring[LOG_RING_BYTES];          /**< Record bytes */
+    atomic_uint write_idx;                 /**< Producer byte position (monotonic) */
+    atomic_uint tail_idx;                  /**< Oldest intact record (monotonic) */
+    atomic_uint seq;                       /**< Records pushed */
+    atomic_uint tail_seq;                  /**< seq of the record at tail_idx */
 } log_stream_t;
 
 /**
@@ -73,10 +120,26 @@ typedef struct {
  */
 #define LOG_STREAM_INIT { \
     .write_idx = ATOMIC_VAR_INIT(0), \
-    .read_idx = ATOMIC_VAR_INIT(0), \
-    .dropped = ATOMIC_VAR_INIT(0) \
+    .tail_idx = ATOMIC_VAR_INIT(0), \
+    .seq = ATOMIC_VAR_INIT(0), \
+    .tail_seq = ATOMIC_VAR_INIT(0) \
 }
 
+/**
+ * @brief One sink's cursor on a log stream (owned by the draining task)
+ *
+ * Like best_effort_consumer_t: never slows the producer, counts what it
+ * missed instead.
+ */
+typedef struct {
+    const log_stream_t *stream;  /**< Stream being read */
+    uint32_t read_idx;           /**< Byte position of the next record */
+    uint32_t next_seq;           /**< seq expected next */
+    uint32_t dropped;            /**< Records overwritten before this reader got them */
+    uint32_t overwritten;        /**< Reads torn by the producer (retried) */
+    log_level_t level;           /**< Records above this level are skipped */
+} log_reader_t;
+
 /* ============================================================================
  * Global Instances
  * ============================================================================ */
@@ -103,53 +166,122 @@ void log_stream_init(log_stream_t *stream);
 /**
  * @brief Push log entry (RT-safe, non-blocking)
  *
- * Timing: ~100-200ns. Never blocks. If buffer full, increments dropped counter.
+ * Timing: ~100-200ns. Never blocks. If the ring is full, the oldest
+ * records are overwritten.
  *
  * @param stream Stream to push to
  * @param timestamp_us Timestamp in microseconds
  * @param level Log level
  * @param msg Message string
  * @param len Message length (max LOG_MAX_MSG_LEN)
- * @return true if pushed, false if dropped
+ * @return true (kept for callers that checked for drops)
  */
 bool log_stream_push(log_stream_t *stream, int64_t timestamp_us,
                      log_level_t level, const char *msg, size_t len);
 
 /**
- * @brief Drain log entry (consumer side)
+ * @brief Push a deferred-format entry (RT-safe, non-blocking)
  *
- * @param stream Stream to drain from
- * @param out Output entry (written on success)
- * @return true if entry available
+ * Only walks fmt to copy the arguments; no digit conversion. Arguments
+ * that do not fit in LOG_MAX_MSG_LEN bytes format as zero / "".
+ *
+ * @param fmt Format string with static storage duration
+ * @return true (kept for callers that checked for drops)
  */
-bool log_stream_drain(log_stream_t *stream, log_entry_t *out);
+bool log_stream_pushf(log_stream_t *stream, int64_t timestamp_us,
+                      log_level_t level, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
 
 /**
- * @brief Get dropped message count
+ * @brief Get number of records held in the ring
  * @param stream Stream
- * @return Number of dropped messages
+ * @return Records a reader starting now could still read
  */
-uint32_t log_stream_dropped(const log_stream_t *stream);
+uint32_t log_stream_count(const log_stream_t *stream);
 
 /**
- * @brief Check if stream has entries
+ * @brief Get ring bytes in use
  * @param stream Stream
- * @return true if entries available
+ * @return Bytes held (of LOG_RING_BYTES)
  */
-bool log_stream_has_entries(const log_stream_t *stream);
+uint32_t log_stream_bytes(const log_stream_t *stream);
 
 /**
- * @brief Reset dropped counter
- * @param stream Stream
+ * @brief Attach a reader at the oldest record still in the ring
+ *
+ * @param reader Reader to initialize
+ * @param stream Stream to read
+ * @param level Highest level passed (LOG_LEVEL_TRACE: everything)
  */
-void log_stream_reset_dropped(log_stream_t *stream);
+void log_reader_init(log_reader_t *reader, const log_stream_t *stream, log_level_t level);
 
 /**
- * @brief Get number of entries in stream
- * @param stream Stream
- * @return Number of entries waiting to be drained
+ * @brief Read the next record that passes the reader's level
+ *
+ * A reader the producer lapped resumes at the oldest intact record and
+ * adds the records it missed to dropped.
+ *
+ * @param reader Reader
+ * @param out Output entry (written on success)
+ * @return true if entry available
  */
-uint32_t log_stream_count(const log_stream_t *stream);
+bool log_reader_next(log_reader_t *reader, log_entry_t *out);
+
+/**
+ * @brief Get records waiting for this reader (filtered ones included)
+ */
+uint32_t log_reader_pending(const log_reader_t *reader);
+
+/**
+ * @brief Get records this reader lost to overwrite
+ */
+static inline uint32_t log_reader_dropped(const log_reader_t *reader) {
+    return reader->dropped;
+}
+
+static inline void log_reader_reset_dropped(log_reader_t *reader) {
+    reader->dropped = 0;
+    reader->overwritten = 0;
+}
+
+static inline void log_reader_set_level(log_reader_t *reader, log_level_t level) {
+    reader->level = level;
+}
+
+/**
+ * @brief Format a log message (snprintf subset, no newlib)
+ *
+ * Supports flags '-' and '0', field width, precision, the hh/h/l/ll/z
+ * length modifiers and %d %i %u %x %X %c %s %p %%. Self-contained so it
+ * can sit in IRAM (CONFIG_KEYER_RT_IRAM), where newlib's formatter is in
+ * flash.
+ *
+ * @return Length of the full message (as snprintf; may exceed size - 1)
+ */
+int log_format(char *buf, size_t size, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Pack the arguments fmt consumes (log_format() conversions)
+ *
+ * @param out Destination
+ * @param cap Destination size
+ * @return Bytes written (arguments past cap are dropped)
+ */
+size_t log_vpack(uint8_t *out, size_t cap, const char *fmt, va_list ap);
+
+/**
+ * @brief log_format() with arguments from log_vpack()
+ */
+int log_format_packed(char *buf, size_t size, const char *fmt,
+                      const uint8_t *args, size_t len);
+
+/**
+ * @brief Expand an entry's message (drain side)
+ *
+ * @return Length of the full message (as snprintf)
+ */
+int log_entry_format(const log_entry_t *entry, char *buf, size_t size);
 
 /**
  * @brief Get log level name
@@ -162,10 +294,26 @@ const char *log_level_str(log_level_t level);
  * UART Logger
  * ============================================================================ */
 
+/** UART log baud before the configuration is loaded */
+#define UART_LOG_BOOT_BAUD 115200U
+
+/**
+ * @brief UART logger statistics
+ */
+typedef struct {
+    uint32_t baud;              /**< Current line rate */
+    uint32_t entries;           /**< Records written */
+    uint32_t bytes;             /**< Bytes queued to the UART */
+    uint32_t batches;           /**< uart_write_bytes() calls */
+    uint32_t stalls;            /**< Batches that had to wait for TX buffer room */
+    uint32_t dropped;           /**< Records overwritten before the UART got them */
+} uart_logger_stats_t;
+
 /**
  * @brief Initialize UART logger (UART1 on GPIO6)
  *
- * Configures UART1 at 115200 baud for log output.
+ * Configures UART1 at UART_LOG_BOOT_BAUD with a large interrupt-fed TX
+ * buffer. The task switches to system.uart_log_baud once it runs.
  * Must be called before starting uart_logger_task.
  */
 void uart_logger_init(void);
@@ -173,13 +321,18 @@ void uart_logger_init(void);
 /**
  * @brief UART logger task
  *
- * Drains RT and BG log streams to UART.
+ * Drains RT and BG log streams to UART, several records per write.
  * Runs on Core 1, priority normal.
  *
  * @param arg Unused
  */
 void uart_logger_task(void *arg);
 
+/**
+ * @brief Get UART logger statistics
+ */
+void uart_logger_get_stats(uart_logger_stats_t *out);
+
 /* ============================================================================
  * RT-Safe Logging Macros
  * ============================================================================ */
@@ -187,16 +340,10 @@ void uart_logger_task(void *arg);
 /**
  * @brief RT-safe log macro (internal)
  *
- * Uses snprintf to format message, then pushes to stream.
+ * Stores the format and packed arguments; the drain side formats.
  */
-#define RT_LOG(stream, level, ts, fmt, ...) do { \
-    char _rt_log_buf[LOG_MAX_MSG_LEN]; \
-    int _rt_log_len = snprintf(_rt_log_buf, sizeof(_rt_log_buf), fmt, ##__VA_ARGS__); \
-    if (_rt_log_len > 0) { \
-        log_stream_push((stream), (ts), (level), _rt_log_buf, \
-            (_rt_log_len > LOG_MAX_MSG_LEN) ? LOG_MAX_MSG_LEN : (size_t)_rt_log_len); \
-    } \
-} while(0)
+#define RT_LOG(stream, level, ts, fmt, ...) \
+    (void)log_stream_pushf((stream), (ts), (level), fmt, ##__VA_ARGS__)
 
 /** Log error (critical) */
 #define RT_ERROR(stream, ts, fmt, ...) \
@@ -0,0 +1,428 @@
+/**
+ * @file log_format.c
+ * @brief Minimal printf-style formatter and argument packer for log records
+ *
+ * Self-contained so that it can be placed in IRAM with the rt_task call
+ * graph (CONFIG_KEYER_RT_IRAM); newlib's vsnprintf runs from flash.
+ *
+ * The producer side only packs: log_vpack() walks the format string and
+ * copies each argument's bytes into the entry. The drain side expands the
+ * same bytes with log_format_packed(); both share one conversion parser,
+ * so they always agree on what a format consumes.
+ */
+
+#include "rt_log.h"
+#include <stdarg.h>
+#include <string.h>
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t pos;
+} fmt_out_t;
+
+/** Argument width class of one conversion */
+typedef enum {
+    ARG_NONE = 0,   /* %% or unsupported: consumes nothing */
+    ARG_INT,        /* int (char/short promoted) */
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_PTR,
+    ARG_STR,
+} arg_kind_t;
+
+typedef struct {
+    bool left;
+    bool zero_pad;
+    unsigned width;
+    int precision;      /* -1 = none */
+    int longs;          /* -2 hh, -1 h, 0, 1 l, 2 ll, 3 z */
+    char conv;
+    arg_kind_t kind;
+} fmt_spec_t;
+
+/** Where conversion values come from: a live va_list or packed bytes */
+typedef struct {
+    va_list *ap;
+    const uint8_t *packed;
+    size_t len;
+    size_t pos;
+} arg_src_t;
+
+/* ============================================================================
+ * Conversion parser (shared by format and pack)
+ * ============================================================================ */
+
+/**
+ * @brief Parse the conversion after a '%'
+ *
+ * @return Past the conversion character, or NULL at the end of the string
+ */
+static const char *parse_spec(const char *fmt, fmt_spec_t *s) {
+    s->left = false;
+    s->zero_pad = false;
+    for (;; fmt++) {
+        if (*fmt == '-') {
+            s->left = true;
+        } else if (*fmt == '0') {
+            s->zero_pad = true;
+        } else {
+            break;
+        }
+    }
+
+    s->width = 0;
+    while (*fmt >= '0' && *fmt <= '9') {
+        s->width = s->width * 10U + (unsigned)(*fmt++ - '0');
+    }
+
+    s->precision = -1;
+    if (*fmt == '.') {
+        fmt++;
+        s->precision = 0;
+        while (*fmt >= '0' && *fmt <= '9') {
+            s->precision = s->precision * 10 + (*fmt++ - '0');
+        }
+    }
+
+    s->longs = 0;
+    if (*fmt == 'h') {
+        fmt++;
+        s->longs = -1;
+        if (*fmt == 'h') {
+            fmt++;
+            s->longs = -2;
+        }
+    } else if (*fmt == 'l') {
+        fmt++;
+        s->longs = 1;
+        if (*fmt == 'l') {
+            fmt++;
+            s->longs = 2;
+        }
+    } else if (*fmt == 'z') {
+        fmt++;
+        s->longs = 3;
+    }
+
+    s->conv = *fmt;
+    if (s->conv == '\0') {
+        return NULL;
+    }
+
+    switch (s->conv) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+            s->kind = (s->longs == 1) ? ARG_LONG :
+                      (s->longs == 2) ? ARG_LLONG :
+                      (s->longs == 3) ? ARG_SIZE : ARG_INT;
+            break;
+        case 'c':
+            s->kind = ARG_INT;
+            break;
+        case 'p':
+            s->kind = ARG_PTR;
+            break;
+        case 's':
+            s->kind = ARG_STR;
+            break;
+        default:
+            s->kind = ARG_NONE;
+            break;
+    }
+    return fmt + 1;
+}
+
+/* ============================================================================
+ * Argument sources
+ * ============================================================================ */
+
+/** Copy n packed bytes; past the end (truncated record) reads as zero */
+static void take(arg_src_t *src, void *dst, size_t n) {
+    if (src->pos + n <= src->len) {
+        memcpy(dst, src->packed + src->pos, n);
+        src->pos += n;
+    } else {
+        src->pos = src->len;
+    }
+}
+
+static long long fetch_signed(arg_src_t *src, arg_kind_t kind) {
+    if (src->ap != NULL) {
+        switch (kind) {
+            case ARG_LONG:  return va_arg(*src->ap, long);
+            case ARG_LLONG: return va_arg(*src->ap, long long);
+            case ARG_SIZE:  return (long long)va_arg(*src->ap, size_t);
+            default:        return va_arg(*src->ap, int);
+        }
+    }
+    switch (kind) {
+        case ARG_LONG:  { long v = 0; take(src, &v, sizeof(v)); return v; }
+        case ARG_LLONG: { long long v = 0; take(src, &v, sizeof(v)); return v; }
+        case ARG_SIZE:  { size_t v = 0; take(src, &v, sizeof(v)); return (long long)v; }
+        default:        { int v = 0; take(src, &v, sizeof(v)); return v; }
+    }
+}
+
+static unsigned long long fetch_unsigned(arg_src_t *src, arg_kind_t kind) {
+    if (src->ap != NULL) {
+        switch (kind) {
+            case ARG_LONG:  return va_arg(*src->ap, unsigned long);
+            case ARG_LLONG: return va_arg(*src->ap, unsigned long long);
+            case ARG_SIZE:  return va_arg(*src->ap, size_t);
+            case ARG_PTR:   return (unsigned long long)(uintptr_t)va_arg(*src->ap, void *);
+            default:        return va_arg(*src->ap, unsigned int);
+        }
+    }
+    switch (kind) {
+        case ARG_LONG:  { unsigned long v = 0; take(src, &v, sizeof(v)); return v; }
+        case ARG_LLONG: { unsigned long long v = 0; take(src, &v, sizeof(v)); return v; }
+        case ARG_SIZE:  { size_t v = 0; take(src, &v, sizeof(v)); return v; }
+        case ARG_PTR:   { uintptr_t v = 0; take(src, &v, sizeof(v)); return v; }
+        default:        { unsigned int v = 0; take(src, &v, sizeof(v)); return v; }
+    }
+}
+
+/** Packed strings are stored inline and NUL-terminated */
+static const char *fetch_str(arg_src_t *src) {
+    if (src->ap != NULL) {
+        return va_arg(*src->ap, const char *);
+    }
+    if (src->pos >= src->len) {
+        return "";
+    }
+    const char *str = (const char *)src->packed + src->pos;
+    size_t n = strnlen(str, src->len - src->pos);
+    src->pos += (n < src->len - src->pos) ? n + 1 : n;
+    return str;
+}
+
+/* ============================================================================
+ * Formatter
+ * ============================================================================ */
+
+static void out_char(fmt_out_t *o, char c) {
+    if (o->pos + 1 < o->size) {
+        o->buf[o->pos] = c;
+    }
+    o->pos++;
+}
+
+static void out_repeat(fmt_out_t *o, char c, size_t n) {
+    while (n-- > 0) {
+        out_char(o, c);
+    }
+}
+
+/**
+ * @brief Emit prefix (sign / "0x"), zero padding and body within a field
+ */
+static void out_field(fmt_out_t *o, const char *prefix, size_t prefix_len,
+                      const char *body, size_t body_len, size_t zeros,
+                      unsigned width, bool left, bool zero_pad) {
+    size_t len = prefix_len + zeros + body_len;
+    size_t fill = (width > len) ? width - len : 0;
+
+    if (zero_pad && !left) {
+        zeros += fill;
+        fill = 0;
+    }
+    if (!left) {
+        out_repeat(o, ' ', fill);
+    }
+    for (size_t i = 0; i < prefix_len; i++) {
+        out_char(o, prefix[i]);
+    }
+    out_repeat(o, '0', zeros);
+    for (size_t i = 0; i < body_len; i++) {
+        out_char(o, body[i]);
+    }
+    if (left) {
+        out_repeat(o, ' ', fill);
+    }
+}
+
+static size_t utoa_rev(char *tmp, unsigned long long v, unsigned base, bool upper) {
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    size_t n = 0;
+    do {
+        tmp[n++] = digits[v % base];
+        v /= base;
+    } while (v != 0);
+    return n;
+}
+
+static int format_from(char *buf, size_t size, const char *fmt, arg_src_t *src) {
+    fmt_out_t o = { .buf = buf, .size = size, .pos = 0 };
+    fmt_spec_t s;
+
+    while (*fmt != '\0') {
+        if (*fmt != '%') {
+            out_char(&o, *fmt++);
+            continue;
+        }
+        const char *spec = fmt++;
+        fmt = parse_spec(fmt, &s);
+        if (fmt == NULL) {
+            break;
+        }
+
+        char tmp[24];
+        switch (s.conv) {
+            case 'd':
+            case 'i': {
+                long long v = fetch_signed(src, s.kind);
+                if (s.longs == -1) {
+                    v = (short)v;
+                } else if (s.longs == -2) {
+                    v = (signed char)v;
+                }
+                unsigned long long mag = (v < 0) ? 0ULL - (unsigned long long)v
+                                                 : (unsigned long long)v;
+                size_t n = utoa_rev(tmp, mag, 10, false);
+                char rev[24];
+                for (size_t i = 0; i < n; i++) {
+                    rev[i] = tmp[n - 1 - i];
+                }
+                size_t zeros = (s.precision > 0 && (size_t)s.precision > n) ?
+                               (size_t)s.precision - n : 0;
+                out_field(&o, "-", (v < 0) ? 1 : 0, rev, n, zeros, s.width, s.left,
+                          s.zero_pad && s.precision < 0);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'p': {
+                unsigned long long v = fetch_unsigned(src, s.kind);
+                if (s.longs == -1) {
+                    v = (unsigned short)v;
+                } else if (s.longs == -2) {
+                    v = (unsigned char)v;
+                }
+                unsigned base = (s.conv == 'u') ? 10U : 16U;
+                size_t n = utoa_rev(tmp, v, base, s.conv == 'X');
+                char rev[24];
+                for (size_t i = 0; i < n; i++) {
+                    rev[i] = tmp[n - 1 - i];
+                }
+                size_t zeros = (s.precision > 0 && (size_t)s.precision > n) ?
+                               (size_t)s.precision - n : 0;
+                out_field(&o, "0x", (s.conv == 'p') ? 2 : 0, rev, n, zeros, s.width, s.left,
+                          s.zero_pad && s.precision < 0);
+                break;
+            }
+            case 'c':
+                tmp[0] = (char)fetch_signed(src, ARG_INT);
+                out_field(&o, "", 0, tmp, 1, 0, s.width, s.left, false);
+                break;
+            case 's': {
+                const char *str = fetch_str(src);
+                if (str == NULL) {
+                    str = "(null)";
+                }
+                size_t n = 0;
+                while (str[n] != '\0' && (s.precision < 0 || n < (size_t)s.precision)) {
+                    n++;
+                }
+                out_field(&o, "", 0, str, n, 0, s.width, s.left, false);
+                break;
+            }
+            case '%':
+                out_char(&o, '%');
+                break;
+            default:
+                /* Unsupported conversion: copy the spec through verbatim */
+                while (spec < fmt) {
+                    out_char(&o, *spec++);
+                }
+                break;
+        }
+    }
+
+    if (size > 0) {
+        buf[(o.pos < size) ? o.pos : size - 1] = '\0';
+    }
+    return (int)o.pos;
+}
+
+int log_format(char *buf, size_t size, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    arg_src_t src = { .ap = &ap };
+    int len = format_from(buf, size, fmt, &src);
+    va_end(ap);
+    return len;
+}
+
+int log_format_packed(char *buf, size_t size, const char *fmt,
+                      const uint8_t *args, size_t len) {
+    arg_src_t src = { .ap = NULL, .packed = args, .len = len, .pos = 0 };
+    return format_from(buf, size, fmt, &src);
+}
+
+/* ============================================================================
+ * Packer
+ * ============================================================================ */
+
+/** Append n bytes; false once the record is full */
+static bool put(uint8_t *out, size_t cap, size_t *pos, const void *src, size_t n) {
+    if (*pos + n > cap) {
+        return false;
+    }
+    memcpy(out + *pos, src, n);
+    *pos += n;
+    return true;
+}
+
+size_t log_vpack(uint8_t *out, size_t cap, const char *fmt, va_list ap) {
+    size_t pos = 0;
+    fmt_spec_t s;
+
+    while (*fmt != '\0') {
+        if (*fmt++ != '%') {
+            continue;
+        }
+        fmt = parse_spec(fmt, &s);
+        if (fmt == NULL) {
+            break;
+        }
+
+        bool ok = true;
+        switch (s.kind) {
+            case ARG_INT:   { int v = va_arg(ap, int); ok = put(out, cap, &pos, &v, sizeof(v)); break; }
+            case ARG_LONG:  { long v = va_arg(ap, long); ok = put(out, cap, &pos, &v, sizeof(v)); break; }
+            case ARG_LLONG: { long long v = va_arg(ap, long long); ok = put(out, cap, &pos, &v, sizeof(v)); break; }
+            case ARG_SIZE:  { size_t v = va_arg(ap, size_t); ok = put(out, cap, &pos, &v, sizeof(v)); break; }
+            case ARG_PTR:   { uintptr_t v = (uintptr_t)va_arg(ap, void *); ok = put(out, cap, &pos, &v, sizeof(v)); break; }
+            case ARG_STR: {
+                /* Copied now: the caller's buffer is gone by drain time */
+                const char *str = va_arg(ap, const char *);
+                if (str == NULL) {
+                    str = "(null)";
+                }
+                size_t n = strlen(str);
+                if (pos + n + 1 > cap) {
+                    n = (cap > pos + 1) ? cap - pos - 1 : 0;
+                    ok = false;
+                }
+                if (pos < cap) {
+                    memcpy(out + pos, str, n);
+                    out[pos + n] = '\0';
+                    pos += n + 1;
+                }
+                break;
+            }
+            case ARG_NONE:
+                break;
+        }
+        if (!ok) {
+            break;  /* Full: later conversions format as zero / "" */
+        }
+    }
+    return pos;
+}
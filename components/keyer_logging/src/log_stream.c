@@ -5,91 +5,214 @@
 
 #include "rt_log.h"
 #include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
 
-/* Global log stream instances */
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define EXT_RAM_BSS_ATTR
+#endif
+
+/* Global log stream instances: rt_task writes the RT one, so only the BG
+ * one (Core 1 tasks) goes to PSRAM. log_stream_init() runs at boot. */
 log_stream_t g_rt_log_stream = LOG_STREAM_INIT;
-log_stream_t g_bg_log_stream = LOG_STREAM_INIT;
+EXT_RAM_BSS_ATTR log_stream_t g_bg_log_stream;
 
 /* Diagnostic logging enable flag (default: off) */
 atomic_bool g_rt_diag_enabled = false;
 
+#define RING_MASK (LOG_RING_BYTES - 1U)
+
+_Static_assert((LOG_RING_BYTES & RING_MASK) == 0, "LOG_RING_BYTES must be power of 2");
+_Static_assert(LOG_RING_BYTES >= 4U * (sizeof(log_record_t) + LOG_MAX_MSG_LEN),
+               "LOG_RING_BYTES too small for the largest record");
+
 void log_stream_init(log_stream_t *stream) {
     atomic_init(&stream->write_idx, 0);
-    atomic_init(&stream->read_idx, 0);
-    atomic_init(&stream->dropped, 0);
-    memset(stream->entries, 0, sizeof(stream->entries));
+    atomic_init(&stream->tail_idx, 0);
+    atomic_init(&stream->seq, 0);
+    atomic_init(&stream->tail_seq, 0);
+    memset(stream->ring, 0, sizeof(stream->ring));
 }
 
-bool log_stream_push(log_stream_t *stream, int64_t timestamp_us,
-                     log_level_t level, const char *msg, size_t len) {
-    /* Check if buffer is full */
-    uint32_t write = atomic_load_explicit(&stream->write_idx, memory_order_relaxed);
-    uint32_t read = atomic_load_explicit(&stream->read_idx, memory_order_relaxed);
+/** Copy len bytes in at byte position pos, wrapping at the ring end */
+static inline void ring_put(log_stream_t *stream, uint32_t pos, const void *src, size_t len) {
+    uint32_t at = pos & RING_MASK;
+    size_t first = LOG_RING_BYTES - at;
+    if (first >= len) {
+        memcpy(&stream->ring[at], src, len);
+    } else {
+        memcpy(&stream->ring[at], src, first);
+        memcpy(stream->ring, (const uint8_t *)src + first, len - first);
+    }
+}
 
-    if (write - read >= LOG_BUFFER_SIZE) {
-        /* Buffer full - drop message */
-        atomic_fetch_add_explicit(&stream->dropped, 1, memory_order_relaxed);
-        return false;
+static inline void ring_get(const log_stream_t *stream, uint32_t pos, void *dst, size_t len) {
+    uint32_t at = pos & RING_MASK;
+    size_t first = LOG_RING_BYTES - at;
+    if (first >= len) {
+        memcpy(dst, &stream->ring[at], len);
+    } else {
+        memcpy(dst, &stream->ring[at], first);
+        memcpy((uint8_t *)dst + first, stream->ring, len - first);
     }
+}
 
-    /* Get slot */
-    uint32_t slot = write & (LOG_BUFFER_SIZE - 1);
-    log_entry_t *entry = &stream->entries[slot];
+/**
+ * @brief Append header + payload as one record
+ *
+ * Evicts the oldest records first if needed: tail_idx moves past them,
+ * and the release fence orders that before the overwriting stores, so a
+ * reader that re-checks tail_idx after its copy sees that it was torn.
+ */
+static inline bool push_record(log_stream_t *stream, int64_t timestamp_us, const char *fmt,
+                               log_level_t level, const uint8_t *payload, size_t len) {
+    uint32_t write = atomic_load_explicit(&stream->write_idx, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&stream->tail_idx, memory_order_relaxed);
+    uint32_t seq = atomic_load_explicit(&stream->seq, memory_order_relaxed);
+    uint32_t need = (uint32_t)(sizeof(log_record_t) + len);
+
+    if (write + need - tail > LOG_RING_BYTES) {
+        uint32_t evicted = 0;
+        while (write + need - tail > LOG_RING_BYTES) {
+            uint8_t old_len;
+            ring_get(stream, tail + (uint32_t)offsetof(log_record_t, len), &old_len, 1);
+            tail += (uint32_t)sizeof(log_record_t) + old_len;
+            evicted++;
+        }
+        uint32_t tail_seq = atomic_load_explicit(&stream->tail_seq, memory_order_relaxed);
+        atomic_store_explicit(&stream->tail_seq, tail_seq + evicted, memory_order_relaxed);
+        atomic_store_explicit(&stream->tail_idx, tail, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
 
-    /* Fill entry */
-    entry->timestamp_us = timestamp_us;
-    entry->level = level;
+    log_record_t rec = {
+        .timestamp_us = timestamp_us,
+        .fmt = fmt,
+        .seq = seq,
+        .level = (uint8_t)level,
+        .len = (uint8_t)len,
+    };
+    ring_put(stream, write, &rec, sizeof(rec));
+    ring_put(stream, write + (uint32_t)sizeof(rec), payload, len);
+
+    /* Publish record */
+    atomic_store_explicit(&stream->seq, seq + 1, memory_order_relaxed);
+    atomic_store_explicit(&stream->write_idx, write + need, memory_order_release);
+    return true;
+}
 
+bool log_stream_push(log_stream_t *stream, int64_t timestamp_us,
+                     log_level_t level, const char *msg, size_t len) {
     /* Copy message (truncate if needed) */
     size_t copy_len = (len > LOG_MAX_MSG_LEN) ? LOG_MAX_MSG_LEN : len;
-    memcpy(entry->msg, msg, copy_len);
-    entry->len = (uint8_t)copy_len;
+    return push_record(stream, timestamp_us, NULL, level, (const uint8_t *)msg, copy_len);
+}
 
-    /* Publish entry */
-    atomic_store_explicit(&stream->write_idx, write + 1, memory_order_release);
+bool log_stream_pushf(log_stream_t *stream, int64_t timestamp_us,
+                      log_level_t level, const char *fmt, ...) {
+    /* Raw argument bytes only: formatting is the drain side's job */
+    uint8_t args[LOG_MAX_MSG_LEN];
+    va_list ap;
+    va_start(ap, fmt);
+    size_t len = log_vpack(args, sizeof(args), fmt, ap);
+    va_end(ap);
 
-    return true;
+    return push_record(stream, timestamp_us, fmt, level, args, len);
 }
 
-bool log_stream_drain(log_stream_t *stream, log_entry_t *out) {
-    uint32_t read = atomic_load_explicit(&stream->read_idx, memory_order_relaxed);
-    uint32_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
-
-    if (read == write) {
-        /* Empty */
-        return false;
+int log_entry_format(const log_entry_t *entry, char *buf, size_t size) {
+    if (entry->fmt != NULL) {
+        return log_format_packed(buf, size, entry->fmt, entry->args, entry->len);
     }
+    if (size > 0) {
+        size_t n = (entry->len < size) ? entry->len : size - 1;
+        memcpy(buf, entry->args, n);
+        buf[n] = '\0';
+    }
+    return (int)entry->len;
+}
 
-    /* Get slot */
-    uint32_t slot = read & (LOG_BUFFER_SIZE - 1);
-
-    /* Copy entry */
-    *out = stream->entries[slot];
-
-    /* Advance read index */
-    atomic_store_explicit(&stream->read_idx, read + 1, memory_order_release);
+uint32_t log_stream_count(const log_stream_t *stream) {
+    uint32_t tail_seq = atomic_load_explicit(&stream->tail_seq, memory_order_relaxed);
+    uint32_t seq = atomic_load_explicit(&stream->seq, memory_order_acquire);
+    return seq - tail_seq;
+}
 
-    return true;
+uint32_t log_stream_bytes(const log_stream_t *stream) {
+    uint32_t tail = atomic_load_explicit(&stream->tail_idx, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
+    return write - tail;
 }
 
-uint32_t log_stream_dropped(const log_stream_t *stream) {
-    return atomic_load_explicit(&stream->dropped, memory_order_relaxed);
+void log_reader_init(log_reader_t *reader, const log_stream_t *stream, log_level_t level) {
+    reader->stream = stream;
+    reader->next_seq = atomic_load_explicit(&stream->tail_seq, memory_order_relaxed);
+    reader->read_idx = atomic_load_explicit(&stream->tail_idx, memory_order_acquire);
+    reader->dropped = 0;
+    reader->overwritten = 0;
+    reader->level = level;
 }
 
-bool log_stream_has_entries(const log_stream_t *stream) {
-    uint32_t read = atomic_load_explicit(&stream->read_idx, memory_order_relaxed);
-    uint32_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
-    return read != write;
+/** Positions compare modulo 2^32 */
+static inline bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
 }
 
-void log_stream_reset_dropped(log_stream_t *stream) {
-    atomic_store_explicit(&stream->dropped, 0, memory_order_relaxed);
+bool log_reader_next(log_reader_t *reader, log_entry_t *out) {
+    const log_stream_t *stream = reader->stream;
+
+    for (;;) {
+        uint32_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
+        if (reader->read_idx == write) {
+            /* Caught up */
+            return false;
+        }
+
+        /* Lapped: resume at the oldest intact record */
+        uint32_t tail = atomic_load_explicit(&stream->tail_idx, memory_order_acquire);
+        if (before(reader->read_idx, tail)) {
+            reader->read_idx = tail;
+        }
+
+        /* Copy record (len bounded: a torn header is rejected below) */
+        log_record_t rec;
+        ring_get(stream, reader->read_idx, &rec, sizeof(rec));
+        uint8_t len = (rec.len > LOG_MAX_MSG_LEN) ? (uint8_t)LOG_MAX_MSG_LEN : rec.len;
+        ring_get(stream, reader->read_idx + (uint32_t)sizeof(rec), out->args, len);
+
+        /* Overwritten while copying? */
+        atomic_thread_fence(memory_order_acquire);
+        tail = atomic_load_explicit(&stream->tail_idx, memory_order_relaxed);
+        if (before(reader->read_idx, tail)) {
+            reader->overwritten++;
+            continue;
+        }
+
+        reader->read_idx += (uint32_t)sizeof(rec) + len;
+        int32_t gap = (int32_t)(rec.seq - reader->next_seq);
+        if (gap > 0) {
+            reader->dropped += (uint32_t)gap;
+        }
+        reader->next_seq = rec.seq + 1;
+
+        if (rec.level > reader->level) {
+            continue;
+        }
+        out->timestamp_us = rec.timestamp_us;
+        out->fmt = rec.fmt;
+        out->level = (log_level_t)rec.level;
+        out->len = len;
+        return true;
+    }
 }
 
-uint32_t log_stream_count(const log_stream_t *stream) {
-    uint32_t read = atomic_load_explicit(&stream->read_idx, memory_order_relaxed);
-    uint32_t write = atomic_load_explicit(&stream->write_idx, memory_order_acquire);
-    return write - read;
+uint32_t log_reader_pending(const log_reader_t *reader) {
+    uint32_t seq = atomic_load_explicit(&reader->stream->seq, memory_order_acquire);
+    uint32_t held = log_stream_count(reader->stream);
+    uint32_t behind = seq - reader->next_seq;
+    return (behind < held) ? behind : held;
 }
 
 const char *log_level_str(log_level_t level) {
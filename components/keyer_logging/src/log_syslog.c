@@ -0,0 +1,140 @@
+/**
+ * @file log_syslog.c
+ * @brief Remote syslog datagrams (RFC 5424 text or packed binary)
+ */
+
+#include "log_syslog.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+
+uint8_t log_syslog_severity(log_level_t level) {
+    switch (level) {
+        case LOG_LEVEL_ERROR: return 3;   /* err */
+        case LOG_LEVEL_WARN:  return 4;   /* warning */
+        case LOG_LEVEL_INFO:  return 6;   /* info */
+        default:              return 7;   /* debug */
+    }
+}
+
+/** Append a header field: printable ASCII without spaces, "-" if empty */
+static size_t put_field(char *buf, size_t cap, size_t used, const char *s, size_t max) {
+    size_t start = used;
+    for (size_t i = 0; s != NULL && s[i] != '\0' && i < max && used + 1 < cap; i++) {
+        char c = s[i];
+        buf[used++] = (c > ' ' && c < 0x7F) ? c : '_';
+    }
+    if (used == start && used + 1 < cap) {
+        buf[used++] = '-';
+    }
+    if (used + 1 < cap) {
+        buf[used++] = ' ';
+    }
+    buf[used] = '\0';
+    return used;
+}
+
+size_t log_syslog_rfc5424(const log_entry_t *entry, const char *host, const char *msgid,
+                          uint32_t seq, int64_t wall_us, char *buf, size_t cap) {
+    if (cap == 0) {
+        return 0;
+    }
+    buf[0] = '\0';
+
+    unsigned pri = LOG_SYSLOG_FACILITY * 8U + log_syslog_severity(entry->level);
+    int len = snprintf(buf, cap, "<%u>1 ", pri);
+    if (len < 0 || (size_t)len >= cap) {
+        return 0;
+    }
+    size_t used = (size_t)len;
+
+    /* TIMESTAMP: the record's wall time, or NILVALUE before the clock is set */
+    char stamp[64] = "-";
+    if (wall_us > 0) {
+        int64_t at_us = wall_us + entry->timestamp_us;
+        time_t secs = (time_t)(at_us / 1000000);
+        struct tm tm;
+        if (gmtime_r(&secs, &tm) != NULL) {
+            snprintf(stamp, sizeof(stamp), "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ",
+                     tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                     tm.tm_hour, tm.tm_min, tm.tm_sec, (long)(at_us % 1000000));
+        }
+    }
+    used = put_field(buf, cap, used, stamp, sizeof(stamp));
+    used = put_field(buf, cap, used, host, 255);       /* HOSTNAME */
+    used = put_field(buf, cap, used, "keyer", 48);     /* APP-NAME */
+    used = put_field(buf, cap, used, NULL, 0);         /* PROCID */
+    used = put_field(buf, cap, used, msgid, 32);       /* MSGID */
+
+    char msg[LOG_MAX_MSG_LEN];
+    if (log_entry_format(entry, msg, sizeof(msg)) < 0) {
+        msg[0] = '\0';
+    }
+    len = snprintf(buf + used, cap - used,
+                   "[meta sequenceId=\"%" PRIu32 "\" sysUpTime=\"%" PRId64 "\"] %s",
+                   seq, entry->timestamp_us / 10000, msg);
+    if (len < 0) {
+        return used;
+    }
+    used += ((size_t)len < cap - used) ? (size_t)len : cap - used - 1;
+    return used;
+}
+
+void log_syslog_batch_begin(log_syslog_batch_t *batch) {
+    log_wire_dict_reset(&batch->dict);
+    batch->len = log_wire_hello(batch->buf);
+    batch->records = 0;
+}
+
+/** Append encoded bytes if they fit */
+static bool batch_put(log_syslog_batch_t *batch, const uint8_t *data, size_t len) {
+    if (batch->len + len > sizeof(batch->buf)) {
+        return false;
+    }
+    memcpy(batch->buf + batch->len, data, len);
+    batch->len += len;
+    return true;
+}
+
+bool log_syslog_batch_add(log_syslog_batch_t *batch, const log_entry_t *entry, uint8_t tag) {
+    uint8_t frames[2 * LOG_WIRE_FRAME_MAX];
+    size_t len = log_wire_encode(&batch->dict, entry, tag, frames);
+    if (!batch_put(batch, frames, len)) {
+        return false;   /* The format may now be in the dictionary: begin a new one */
+    }
+    batch->records++;
+    return true;
+}
+
+bool log_syslog_batch_dropped(log_syslog_batch_t *batch, uint8_t tag, uint32_t count) {
+    uint8_t frame[LOG_WIRE_FRAME_MAX];
+    return batch_put(batch, frame, log_wire_dropped(frame, tag, count));
+}
+
+void log_syslog_rate_init(log_syslog_rate_t *rate, int64_t now_us, uint32_t per_s) {
+    rate->last_us = now_us;
+    rate->tokens_x1000 = per_s * 1000U;
+}
+
+bool log_syslog_rate_take(log_syslog_rate_t *rate, int64_t now_us, uint32_t per_s) {
+    uint32_t cap = per_s * 1000U;
+    int64_t elapsed_us = now_us - rate->last_us;
+    if (elapsed_us > 0) {
+        /* per_s tokens a second: per_s * 1000 thousandths per 1e6 us */
+        int64_t add = elapsed_us * (int64_t)per_s / 1000;
+        if (add > 0) {
+            int64_t tokens = (int64_t)rate->tokens_x1000 + add;
+            rate->tokens_x1000 = (tokens > (int64_t)cap) ? cap : (uint32_t)tokens;
+            rate->last_us = now_us;
+        }
+    }
+    if (rate->tokens_x1000 > cap) {
+        rate->tokens_x1000 = cap;   /* Rate lowered at run time */
+    }
+    if (rate->tokens_x1000 < 1000U) {
+        return false;
+    }
+    rate->tokens_x1000 -= 1000U;
+    return true;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file log_wire.c
+ * @brief Binary log wire format encoder
+ */
+
+#include "log_wire.h"
+#include <string.h>
+
+#define DICT_MASK (LOG_WIRE_DICT_SIZE - 1U)
+
+_Static_assert((LOG_WIRE_DICT_SIZE & DICT_MASK) == 0,
+               "LOG_WIRE_DICT_SIZE must be power of 2");
+_Static_assert(12U + LOG_MAX_MSG_LEN <= 255U, "RECORD payload must fit a frame");
+
+void log_wire_dict_reset(log_wire_dict_t *dict) {
+    memset(dict->fmts, 0, sizeof(dict->fmts));
+}
+
+/**
+ * @brief Slot of fmt, claiming a free one if new
+ *
+ * @return Format ID, or -1 if the dictionary is full
+ */
+static int dict_lookup(log_wire_dict_t *dict, const char *fmt, bool *is_new) {
+    uint32_t h = (uint32_t)((uintptr_t)fmt >> 2) * 2654435761U;
+    uint32_t slot = (h >> 24) & DICT_MASK;
+
+    for (uint32_t probe = 0; probe < LOG_WIRE_DICT_SIZE; probe++) {
+        uint32_t i = (slot + probe) & DICT_MASK;
+        if (dict->fmts[i] == fmt) {
+            *is_new = false;
+            return (int)i;
+        }
+        if (dict->fmts[i] == NULL) {
+            dict->fmts[i] = fmt;
+            *is_new = true;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/** Wrap payload (already at buf + 3) in a frame */
+static size_t frame(uint8_t *buf, uint8_t type, size_t len) {
+    uint8_t sum = (uint8_t)(type + len);
+    for (size_t i = 0; i < len; i++) {
+        sum = (uint8_t)(sum + buf[3 + i]);
+    }
+    buf[0] = LOG_WIRE_SYNC;
+    buf[1] = type;
+    buf[2] = (uint8_t)len;
+    buf[3 + len] = sum;
+    return LOG_WIRE_OVERHEAD + len;
+}
+
+static void put_le(uint8_t *p, uint64_t v, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        p[i] = (uint8_t)(v >> (8U * i));
+    }
+}
+
+size_t log_wire_hello(uint8_t *buf) {
+    uint8_t *p = buf + 3;
+    p[0] = LOG_WIRE_VERSION;
+    p[1] = (uint8_t)sizeof(int);
+    p[2] = (uint8_t)sizeof(long);
+    p[3] = (uint8_t)sizeof(long long);
+    p[4] = (uint8_t)sizeof(size_t);
+    p[5] = (uint8_t)sizeof(void *);
+    return frame(buf, LOG_WIRE_HELLO, 6);
+}
+
+size_t log_wire_dropped(uint8_t *buf, uint8_t tag, uint32_t count) {
+    buf[3] = tag;
+    put_le(buf + 4, count, 4);
+    return frame(buf, LOG_WIRE_DROPPED, 5);
+}
+
+static size_t fmt_frame(uint8_t *buf, uint16_t id, const char *fmt) {
+    size_t n = strnlen(fmt, LOG_WIRE_FMT_MAX);
+    put_le(buf + 3, id, 2);
+    memcpy(buf + 5, fmt, n);
+    return frame(buf, LOG_WIRE_FMT, 2 + n);
+}
+
+static size_t record_frame(uint8_t *buf, const log_entry_t *entry, uint8_t tag,
+                           uint16_t fmt_id, const uint8_t *args, size_t len) {
+    uint8_t *p = buf + 3;
+    put_le(p, (uint64_t)entry->timestamp_us, 8);
+    p[8] = (uint8_t)entry->level;
+    p[9] = tag;
+    put_le(p + 10, fmt_id, 2);
+    memcpy(p + 12, args, len);
+    return frame(buf, LOG_WIRE_RECORD, 12 + len);
+}
+
+size_t log_wire_encode(log_wire_dict_t *dict, const log_entry_t *entry, uint8_t tag,
+                       uint8_t *buf) {
+    if (entry->fmt == NULL) {
+        return record_frame(buf, entry, tag, LOG_WIRE_TEXT_ID, entry->args, entry->len);
+    }
+
+    bool is_new = false;
+    int id = dict_lookup(dict, entry->fmt, &is_new);
+    if (id < 0) {
+        char text[LOG_MAX_MSG_LEN];
+        int n = log_entry_format(entry, text, sizeof(text));
+        size_t len = (n < 0) ? 0 : ((size_t)n < sizeof(text) ? (size_t)n : sizeof(text) - 1);
+        return record_frame(buf, entry, tag, LOG_WIRE_TEXT_ID, (const uint8_t *)text, len);
+    }
+
+    size_t pos = 0;
+    if (is_new) {
+        pos = fmt_frame(buf, (uint16_t)id, entry->fmt);
+    }
+    return pos + record_frame(buf + pos, entry, tag, (uint16_t)id, entry->args, entry->len);
+}
@@ -3,6 +3,12 @@
  * @brief UART log drain task
  *
  * Runs on Core 1, drains log streams to UART on GPIO6.
+ *
+ * Formatted lines are collected in a batch buffer and handed to the
+ * driver several at a time; the driver's TX ring buffer (refilled from the
+ * FIFO interrupt) then feeds the wire while the task formats the next
+ * batch. At 2-3 Mbaud the line keeps up with diagnostic bursts that
+ * overran the old one-write-per-entry path at 115200.
  */
 
 #include "rt_log.h"
@@ -17,20 +23,43 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_timer.h"
+#include "config.h"
+#include "metrics.h"
 
 #define UART_LOG_PORT    UART_NUM_1
 #define UART_LOG_TX_PIN  GPIO_NUM_6
-#define UART_LOG_BAUD    115200
-#define UART_BUF_SIZE    256
+#define UART_TX_BUF_SIZE 8192   /* Driver TX ring: ~30 ms at 2 Mbaud */
+#define UART_RX_BUF_SIZE 256    /* Minimum the driver accepts; RX unused */
+#define UART_BATCH_SIZE  1024
+
+/* One formatted line: "[ts] LEVEL: " + message + CRLF */
+#define UART_LINE_MAX    (32 + LOG_MAX_MSG_LEN)
+
+static char s_batch[UART_BATCH_SIZE];
+static size_t s_batch_len;
+static uart_logger_stats_t s_stats;
+
+static int64_t metric_u32(const void *ctx) {
+    return (int64_t)*(const volatile uint32_t *)ctx;
+}
 
-static char s_format_buf[256];
+static const metric_desc_t k_log_metrics[] = {
+    { "keyer_log_entries_total", "Log records written to the UART", METRIC_COUNTER,
+      metric_u32, &s_stats.entries },
+    { "keyer_log_bytes_total", "Log bytes queued to the UART", METRIC_COUNTER,
+      metric_u32, &s_stats.bytes },
+    { "keyer_log_stalls_total", "Log batches that waited for TX buffer room", METRIC_COUNTER,
+      metric_u32, &s_stats.stalls },
+    { "keyer_log_dropped_total", "Log records overwritten before the UART got them",
+      METRIC_COUNTER, metric_u32, &s_stats.dropped },
+};
 
 /**
  * @brief Initialize UART logger
  */
 void uart_logger_init(void) {
     uart_config_t uart_config = {
-        .baud_rate = UART_LOG_BAUD,
+        .baud_rate = UART_LOG_BOOT_BAUD,
         .data_bits = UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
@@ -39,26 +68,79 @@ void uart_logger_init(void) {
     };
 
     /* Configure UART */
-    uart_driver_install(UART_LOG_PORT, UART_BUF_SIZE, 0, 0, NULL, 0);
+    uart_driver_install(UART_LOG_PORT, UART_RX_BUF_SIZE, UART_TX_BUF_SIZE, 0, NULL, 0);
     uart_param_config(UART_LOG_PORT, &uart_config);
     uart_set_pin(UART_LOG_PORT, UART_LOG_TX_PIN, UART_PIN_NO_CHANGE,
                  UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    s_stats.baud = UART_LOG_BOOT_BAUD;
+    metrics_register_all(&g_metrics, k_log_metrics, sizeof(k_log_metrics) / sizeof(k_log_metrics[0]));
+}
+
+/**
+ * @brief Queue the batch to the driver
+ */
+static void flush_batch(void) {
+    if (s_batch_len == 0) {
+        return;
+    }
+    size_t room = 0;
+    if (uart_get_tx_buffer_free_size(UART_LOG_PORT, &room) == ESP_OK && room < s_batch_len) {
+        s_stats.stalls++;
+    }
+    uart_write_bytes(UART_LOG_PORT, s_batch, s_batch_len);
+    s_stats.bytes += (uint32_t)s_batch_len;
+    s_stats.batches++;
+    s_batch_len = 0;
+}
+
+/**
+ * @brief Append formatted text to the batch, flushing first if full
+ */
+static void batch_append(const char *text, int len) {
+    if (len <= 0) {
+        return;
+    }
+    size_t n = ((size_t)len < UART_LINE_MAX) ? (size_t)len : UART_LINE_MAX - 1;
+    if (s_batch_len + n > sizeof(s_batch)) {
+        flush_batch();
+    }
+    memcpy(&s_batch[s_batch_len], text, n);
+    s_batch_len += n;
 }
 
 /**
- * @brief Format and send log entry to UART
+ * @brief Format log entry into the batch
  */
 static void send_entry(const log_entry_t *entry) {
+    char msg[LOG_MAX_MSG_LEN];
+    char line[UART_LINE_MAX];
+    int msg_len = log_entry_format(entry, msg, sizeof(msg));
+    if (msg_len < 0) {
+        return;
+    }
+
     /* Format: [timestamp_us] LEVEL: message\r\n */
-    int len = snprintf(s_format_buf, sizeof(s_format_buf),
-                       "[%lld] %s: %.*s\r\n",
+    int len = snprintf(line, sizeof(line),
+                       "[%lld] %s: %s\r\n",
                        (long long)entry->timestamp_us,
                        log_level_str(entry->level),
-                       (int)entry->len,
-                       entry->msg);
+                       msg);
+    batch_append(line, len);
+    s_stats.entries++;
+}
 
-    if (len > 0) {
-        uart_write_bytes(UART_LOG_PORT, s_format_buf, (size_t)len);
+/**
+ * @brief Follow system.uart_log_baud (applied between batches)
+ */
+static void apply_baud(void) {
+    uint32_t baud = CONFIG_GET_UART_LOG_BAUD();
+    if (baud == s_stats.baud || baud == 0) {
+        return;
+    }
+    /* Let queued bytes leave at the old rate */
+    uart_wait_tx_done(UART_LOG_PORT, pdMS_TO_TICKS(100));
+    if (uart_set_baudrate(UART_LOG_PORT, baud) == ESP_OK) {
+        s_stats.baud = baud;
     }
 }
 
@@ -72,19 +154,27 @@ void uart_logger_task(void *arg) {
     (void)arg;
 
     log_entry_t entry;
+    log_reader_t rt_reader;
+    log_reader_t bg_reader;
     uint32_t last_dropped_report_ms = 0;
 
+    /* Own cursors: the USB drain reads the same records */
+    log_reader_init(&rt_reader, &g_rt_log_stream, LOG_LEVEL_TRACE);
+    log_reader_init(&bg_reader, &g_bg_log_stream, LOG_LEVEL_TRACE);
+
     for (;;) {
         bool had_entry = false;
 
+        apply_baud();
+
         /* Drain RT log stream (higher priority) */
-        while (log_stream_drain(&g_rt_log_stream, &entry)) {
+        while (log_reader_next(&rt_reader, &entry)) {
             send_entry(&entry);
             had_entry = true;
         }
 
         /* Drain BG log stream */
-        while (log_stream_drain(&g_bg_log_stream, &entry)) {
+        while (log_reader_next(&bg_reader, &entry)) {
             send_entry(&entry);
             had_entry = true;
         }
@@ -92,24 +182,27 @@ void uart_logger_task(void *arg) {
         /* Report dropped messages periodically */
         uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
         if (now_ms - last_dropped_report_ms >= 10000) {
-            uint32_t rt_dropped = log_stream_dropped(&g_rt_log_stream);
-            uint32_t bg_dropped = log_stream_dropped(&g_bg_log_stream);
+            uint32_t rt_dropped = log_reader_dropped(&rt_reader);
+            uint32_t bg_dropped = log_reader_dropped(&bg_reader);
 
             if (rt_dropped > 0 || bg_dropped > 0) {
-                int len = snprintf(s_format_buf, sizeof(s_format_buf),
+                char line[UART_LINE_MAX];
+                int len = snprintf(line, sizeof(line),
                                    "[%" PRIu32 "] WARN: Dropped logs: RT=%" PRIu32 " BG=%" PRIu32 "\r\n",
                                    now_ms, rt_dropped, bg_dropped);
-                if (len > 0) {
-                    uart_write_bytes(UART_LOG_PORT, s_format_buf, (size_t)len);
-                }
+                batch_append(line, len);
 
-                log_stream_reset_dropped(&g_rt_log_stream);
-                log_stream_reset_dropped(&g_bg_log_stream);
+                s_stats.dropped += rt_dropped + bg_dropped;
+                log_reader_reset_dropped(&rt_reader);
+                log_reader_reset_dropped(&bg_reader);
             }
 
             last_dropped_report_ms = now_ms;
         }
 
+        /* One write for everything drained this pass */
+        flush_batch();
+
         /* Sleep if no entries */
         if (!had_entry) {
             vTaskDelay(pdMS_TO_TICKS(1));
@@ -117,6 +210,10 @@ void uart_logger_task(void *arg) {
     }
 }
 
+void uart_logger_get_stats(uart_logger_stats_t *out) {
+    *out = s_stats;
+}
+
 #else
 /* Host stub */
 
@@ -129,4 +226,8 @@ void uart_logger_task(void *arg) {
     /* No-op on host */
 }
 
+void uart_logger_get_stats(uart_logger_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
 #endif /* ESP_PLATFORM */
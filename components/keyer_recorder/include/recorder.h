@@ -0,0 +1,125 @@
+/**
+ * @file recorder.h
+ * @brief Long-term keying recorder on the "recorder" flash partition
+ *
+ * A background service (bg_task.c) reads the keying stream like any other
+ * best-effort consumer and packs it into 4 KB chunks (stream_rec.h). Full
+ * chunks wait in a RAM queue and go to flash only while the keyer is
+ * idle: record slices after RECORDER_WRITE_IDLE_MS without keying, sector
+ * erases (tens of milliseconds with the cache off) after
+ * RECORDER_ERASE_IDLE_MS. A queue half full is written while keying too,
+ * one bounded slice (system.recorder_write_us) per pass. What does not fit
+ * the queue is dropped and counted; the export marks the gap as silence.
+ *
+ * One session per power-on (or system.recorder switched on, or "rec new").
+ * Sessions are listed by GET /api/stream/sessions and downloaded as .cwk
+ * from GET /api/stream/export?session=N.
+ *
+ * The service task owns the log; the other calls take the recorder lock,
+ * so an export only ever waits for one flash call.
+ */
+
+#ifndef KEYER_RECORDER_H
+#define KEYER_RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "stream_rec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Idle time before record slices are written (queue under half full) */
+#define RECORDER_WRITE_IDLE_MS 250
+
+/** Idle time before a sector is erased ahead of the writer */
+#define RECORDER_ERASE_IDLE_MS 2000
+
+/** Idle time before a part-filled chunk is queued */
+#define RECORDER_FLUSH_IDLE_MS 10000
+
+/**
+ * @brief Recorder status
+ */
+typedef struct {
+    bool     mounted;         /**< Partition found and scanned */
+    bool     recording;       /**< system.recorder on, session open */
+    uint32_t session;         /**< Session being recorded */
+    uint32_t sessions;        /**< Sessions in the index */
+    uint32_t chunks;          /**< Partition size in chunks */
+    uint32_t used;            /**< Chunks holding records */
+    uint32_t erased_ahead;    /**< Sectors erased for the writer */
+    uint32_t queued;          /**< Full chunks waiting for flash */
+    uint32_t queue_size;      /**< Queue capacity */
+    uint32_t chunks_written;
+    uint32_t chunks_dropped;  /**< Queue full: chunks never written */
+    uint32_t resyncs;         /**< Stream gaps (the recorder fell behind) */
+    uint32_t erases;
+    uint32_t errors;          /**< Failed flash calls */
+    uint32_t slice_bytes;     /**< Write slice now */
+    uint32_t bound_us;        /**< Write slice bound */
+    uint32_t write_max_us;    /**< Longest write call */
+    uint32_t write_over;      /**< Write calls over the bound */
+    uint32_t erase_max_us;    /**< Longest sector erase */
+} recorder_stats_t;
+
+/** Session export (.cwk) */
+typedef stream_rec_export_t recorder_export_t;
+
+/**
+ * @brief Find the partition, set the idle probe
+ *
+ * @param is_idle true while nothing is being keyed (NULL = always idle)
+ */
+void recorder_init(bool (*is_idle)(void));
+
+/**
+ * @brief Mount the log and join the stream (service task, once)
+ */
+void recorder_service_init(int64_t now_us);
+
+/**
+ * @brief One pass: pack new samples, write or erase while idle
+ *
+ * @return true while there is flash work it may do now
+ */
+bool recorder_service_run(int64_t now_us);
+
+/**
+ * @brief Close the current session and start another
+ *
+ * Takes effect on the next service pass.
+ */
+void recorder_new_session(void);
+
+/**
+ * @brief Get recorder status
+ */
+void recorder_get_stats(recorder_stats_t *stats);
+
+/**
+ * @brief Copy the session index, oldest first
+ *
+ * @return Sessions copied
+ */
+size_t recorder_get_sessions(stream_rec_session_t *out, size_t max);
+
+/**
+ * @brief Start exporting a session
+ *
+ * @return false if the session is not in the log
+ */
+bool recorder_export_begin(recorder_export_t *exp, uint32_t session);
+
+/**
+ * @brief Next piece of the recording (stream_rec_export_read())
+ */
+size_t recorder_export_read(recorder_export_t *exp, uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_RECORDER_H */
@@ -0,0 +1,390 @@
+/**
+ * @file recorder.c
+ * @brief Long-term keying recorder on the "recorder" flash partition
+ *
+ * Chunks live in one ring: the oldest RECORDER_CHUNKS - 1 are queued for
+ * flash, the one after them is being filled, so a full chunk is queued
+ * without a copy. Writes come from the queue head; the log keeps a pointer
+ * to the chunk until its header is written.
+ *
+ * Reads go through a mapping of the partition when the MMU has room for
+ * it (no cache stall per read), otherwise through esp_partition_read().
+ */
+
+#include "recorder.h"
+#include "sdkconfig.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "consumer.h"
+#include "metrics.h"
+#include "config.h"
+#include "rt_log.h"
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "recorder";
+
+/* Keying stream (main/main.c) */
+extern keying_stream_t g_keying_stream;
+
+/* Data partition subtype (partitions.csv; webui is 0x40) */
+#define RECORDER_PARTITION_SUBTYPE 0x41
+
+/* Chunk ring: queue plus the chunk being filled */
+#ifdef CONFIG_KEYER_INTERNAL_RAM_ONLY
+#define RECORDER_CHUNKS 3U
+#else
+#define RECORDER_CHUNKS 9U
+#endif
+
+/* Earliest wall clock taken as set: 2020-01-01 */
+#define RECORDER_MIN_UNIX_S 1577836800LL
+
+static const esp_partition_t *s_part;
+static const uint8_t *s_map;                 /* Partition mapped for reads, or NULL */
+static esp_partition_mmap_handle_t s_map_handle;
+static bool (*s_is_idle)(void);
+
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+
+static EXT_RAM_BSS_ATTR stream_rec_log_t s_log;
+static EXT_RAM_BSS_ATTR stream_rec_chunk_t s_chunks[RECORDER_CHUNKS];
+static size_t s_queue_head;                  /* Oldest queued chunk */
+static size_t s_queued;                      /* Chunks queued for flash */
+
+static timed_consumer_t s_consumer;
+static size_t s_seen_dropped;
+static size_t s_seen_resyncs;
+
+static bool s_mounted;
+static bool s_recording;
+static uint32_t s_session;
+static int64_t s_busy_us;                    /* Last pass the keyer was not idle */
+static atomic_bool s_new_session;
+
+static uint32_t s_dropped;
+static uint32_t s_resyncs;
+
+/* ============================================================================
+ * Partition access (stream_rec_flash_t)
+ * ============================================================================ */
+
+static bool part_read(void *ctx, size_t offset, void *buf, size_t len) {
+    if (s_map != NULL) {
+        memcpy(buf, s_map + offset, len);
+        return true;
+    }
+    return esp_partition_read((const esp_partition_t *)ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool part_write(void *ctx, size_t offset, const void *buf, size_t len) {
+    return esp_partition_write((const esp_partition_t *)ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool part_erase(void *ctx, size_t offset) {
+    return esp_partition_erase_range((const esp_partition_t *)ctx, offset,
+                                     STREAM_REC_CHUNK_BYTES) == ESP_OK;
+}
+
+static int64_t part_now_us(void *ctx) {
+    (void)ctx;
+    return esp_timer_get_time();
+}
+
+/* ============================================================================
+ * Chunks
+ * ============================================================================ */
+
+static inline stream_rec_chunk_t *fill_chunk(void) {
+    return &s_chunks[(s_queue_head + s_queued) % RECORDER_CHUNKS];
+}
+
+/** Wall clock at a stream tick, 0 while the clock is not set */
+static int64_t unix_us_at(uint64_t tick) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if ((int64_t)tv.tv_sec < RECORDER_MIN_UNIX_S) {
+        return 0;
+    }
+    int64_t age_us = esp_timer_get_time() - timed_consumer_time_us(&s_consumer, tick);
+    return (int64_t)tv.tv_sec * 1000000 + (int64_t)tv.tv_usec - age_us;
+}
+
+static void begin_chunk(void) {
+    stream_rec_chunk_t *c = fill_chunk();
+    stream_rec_chunk_begin(c, s_session, stream_tick_period_us(&g_keying_stream),
+                           s_consumer.tick, unix_us_at(s_consumer.tick));
+    stream_net_time_t clock;
+    if (stream_read_net_clock(&g_keying_stream, &clock)) {
+        stream_rec_chunk_set_net_clock(c, &clock);
+    }
+}
+
+/** Queue the chunk being filled (if it holds anything) and start the next */
+static void close_chunk(void) {
+    if (!stream_rec_chunk_empty(fill_chunk())) {
+        if (s_queued < RECORDER_CHUNKS - 1U) {
+            s_queued++;
+        } else {
+            s_dropped++;   /* Flash fell behind: this chunk is lost */
+        }
+    }
+    begin_chunk();
+}
+
+static void recording_start(void) {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_session = stream_rec_new_session(&s_log);
+    xSemaphoreGive(s_lock);
+
+    /* History still in the stream goes into the new session */
+    timed_consumer_init(&s_consumer, &g_keying_stream, 0);
+    s_seen_dropped = s_consumer.base.dropped;
+    s_seen_resyncs = s_consumer.resyncs;
+    begin_chunk();
+    s_recording = true;
+}
+
+/** Pack new stream samples; a gap in the stream starts a new chunk */
+static bool record_samples(void) {
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+    bool any = false;
+
+    while (timed_consumer_next_span(&s_consumer, &a, &na, &b, &nb, SIZE_MAX) > 0) {
+        if (s_consumer.resyncs != s_seen_resyncs || s_consumer.base.dropped != s_seen_dropped) {
+            s_seen_resyncs = s_consumer.resyncs;
+            s_seen_dropped = s_consumer.base.dropped;
+            s_resyncs++;
+            close_chunk();
+        }
+        for (size_t i = 0; i < na + nb; i++) {
+            const stream_sample_t *s = (i < na) ? &a[i].sample : &b[i - na].sample;
+            uint64_t tick = timed_consumer_step(&s_consumer, s);
+            if (!stream_rec_chunk_add(fill_chunk(), s, tick)) {
+                close_chunk();
+                (void)stream_rec_chunk_add(fill_chunk(), s, tick);
+            }
+        }
+        timed_consumer_commit(&s_consumer, na + nb);
+        any = true;
+    }
+    return any;
+}
+
+/* ============================================================================
+ * Flash work
+ * ============================================================================ */
+
+/**
+ * @brief At most one flash call per pass
+ *
+ * @return true if there is more to do under the same conditions
+ */
+static bool flash_work(uint32_t idle_ms) {
+    bool pressure = s_queued * 2U >= RECORDER_CHUNKS - 1U;
+    bool more = false;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_log.pacer.bound_us = CONFIG_GET_RECORDER_WRITE_US();
+
+    if (s_log.pending == NULL && s_queued > 0) {
+        (void)stream_rec_write_begin(&s_log, &s_chunks[s_queue_head]);
+    }
+    if (s_log.pending != NULL && (idle_ms >= RECORDER_WRITE_IDLE_MS || pressure)) {
+        stream_rec_step_t step = stream_rec_write_step(&s_log);
+        if (step == STREAM_REC_STEP_DONE || step == STREAM_REC_STEP_ERROR) {
+            s_queue_head = (s_queue_head + 1U) % RECORDER_CHUNKS;
+            s_queued--;
+        }
+        more = true;
+    } else if (stream_rec_erased_ahead(&s_log) < STREAM_REC_ERASE_AHEAD &&
+               idle_ms >= RECORDER_ERASE_IDLE_MS) {
+        more = stream_rec_erase_next(&s_log);
+#ifdef CONFIG_KEYER_RT_IRAM
+    } else if (s_queued == RECORDER_CHUNKS - 1U && stream_rec_erased_ahead(&s_log) == 0) {
+        /* Queue full: the RT path runs from IRAM and rides out the cache stall */
+        more = stream_rec_erase_next(&s_log);
+#endif
+    }
+    xSemaphoreGive(s_lock);
+    return more;
+}
+
+/* ============================================================================
+ * Service
+ * ============================================================================ */
+
+void recorder_init(bool (*is_idle)(void)) {
+    s_is_idle = is_idle;
+    s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                      (esp_partition_subtype_t)RECORDER_PARTITION_SUBTYPE,
+                                      "recorder");
+    if (s_part == NULL) {
+        ESP_LOGW(TAG, "No recorder partition: keying recorder off");
+    }
+}
+
+static int64_t metric_recorder(const void *ctx) {
+    recorder_stats_t st;
+    recorder_get_stats(&st);
+    switch ((uintptr_t)ctx) {
+        case 0:  return st.chunks_written;
+        case 1:  return st.chunks_dropped;
+        case 2:  return st.write_max_us;
+        default: return st.used;
+    }
+}
+
+static const metric_desc_t k_recorder_metrics[] = {
+    { "keyer_recorder_chunks_total", "Recorder chunks written to flash", METRIC_COUNTER,
+      metric_recorder, (const void *)0 },
+    { "keyer_recorder_dropped_total", "Recorder chunks lost to a full queue", METRIC_COUNTER,
+      metric_recorder, (const void *)1 },
+    { "keyer_recorder_write_max_us", "Longest recorder flash write call", METRIC_GAUGE,
+      metric_recorder, (const void *)2 },
+    { "keyer_recorder_used_chunks", "Recorder chunks holding records", METRIC_GAUGE,
+      metric_recorder, (const void *)3 },
+};
+
+void recorder_service_init(int64_t now_us) {
+    s_busy_us = now_us;
+    if (s_part == NULL) {
+        return;
+    }
+
+    const void *map = NULL;
+    if (esp_partition_mmap(s_part, 0, s_part->size, ESP_PARTITION_MMAP_DATA,
+                           &map, &s_map_handle) == ESP_OK) {
+        s_map = (const uint8_t *)map;
+    }
+
+    const stream_rec_flash_t flash = {
+        .read = part_read,
+        .write = part_write,
+        .erase = part_erase,
+        .now_us = part_now_us,
+        .ctx = (void *)s_part,
+        .chunks = (uint32_t)(s_part->size / STREAM_REC_CHUNK_BYTES),
+    };
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_mounted = stream_rec_mount(&s_log, &flash, CONFIG_GET_RECORDER_WRITE_US());
+    xSemaphoreGive(s_lock);
+
+    int64_t end_us = esp_timer_get_time();
+    if (!s_mounted) {
+        RT_WARN(&g_bg_log_stream, end_us, "Recorder: partition too small (%lu bytes)",
+                (unsigned long)s_part->size);
+        return;
+    }
+    timed_consumer_init(&s_consumer, &g_keying_stream, 0);
+    best_effort_consumer_register(&s_consumer.base, "recorder");
+    metrics_register_all(&g_metrics, k_recorder_metrics,
+                         sizeof(k_recorder_metrics) / sizeof(k_recorder_metrics[0]));
+    RT_INFO(&g_bg_log_stream, end_us, "Recorder: %u sessions, %lu/%lu chunks, mounted in %lums%s",
+            (unsigned)s_log.session_count, (unsigned long)stream_rec_used(&s_log),
+            (unsigned long)flash.chunks, (unsigned long)((end_us - now_us) / 1000),
+            s_map != NULL ? "" : " (unmapped)");
+}
+
+bool recorder_service_run(int64_t now_us) {
+    if (!s_mounted) {
+        return false;
+    }
+    if (s_is_idle != NULL && !s_is_idle()) {
+        s_busy_us = now_us;
+    }
+    uint32_t idle_ms = (uint32_t)((now_us - s_busy_us) / 1000);
+
+    bool enabled = CONFIG_GET_RECORDER();
+    if (enabled && !s_recording) {
+        atomic_store_explicit(&s_new_session, false, memory_order_relaxed);
+        recording_start();
+    } else if (!enabled && s_recording) {
+        close_chunk();
+        s_recording = false;
+    }
+
+    if (s_recording) {
+        (void)record_samples();
+        if (atomic_exchange_explicit(&s_new_session, false, memory_order_relaxed)) {
+            close_chunk();
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            s_session = stream_rec_new_session(&s_log);
+            xSemaphoreGive(s_lock);
+            begin_chunk();
+        } else if (idle_ms >= RECORDER_FLUSH_IDLE_MS && !stream_rec_chunk_empty(fill_chunk())) {
+            close_chunk();
+        }
+    }
+    return flash_work(idle_ms);
+}
+
+void recorder_new_session(void) {
+    atomic_store_explicit(&s_new_session, true, memory_order_relaxed);
+}
+
+void recorder_get_stats(recorder_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->mounted = s_mounted;
+    stats->queue_size = RECORDER_CHUNKS - 1U;
+    if (!s_mounted) {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    stats->recording = s_recording;
+    stats->session = s_session;
+    stats->sessions = (uint32_t)s_log.session_count;
+    stats->chunks = s_log.flash.chunks;
+    stats->used = stream_rec_used(&s_log);
+    stats->erased_ahead = stream_rec_erased_ahead(&s_log);
+    stats->queued = (uint32_t)s_queued;
+    stats->chunks_written = s_log.chunks_written;
+    stats->chunks_dropped = s_dropped;
+    stats->resyncs = s_resyncs;
+    stats->erases = s_log.erases;
+    stats->errors = s_log.errors;
+    stats->slice_bytes = s_log.pacer.slice;
+    stats->bound_us = s_log.pacer.bound_us;
+    stats->write_max_us = s_log.pacer.worst_us;
+    stats->write_over = s_log.pacer.over;
+    stats->erase_max_us = s_log.erase_max_us;
+    xSemaphoreGive(s_lock);
+}
+
+size_t recorder_get_sessions(stream_rec_session_t *out, size_t max) {
+    if (!s_mounted) {
+        return 0;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    size_t n = (s_log.session_count < max) ? s_log.session_count : max;
+    memcpy(out, s_log.sessions, n * sizeof(out[0]));
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+bool recorder_export_begin(recorder_export_t *exp, uint32_t session) {
+    if (!s_mounted) {
+        return false;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool ok = stream_rec_export_begin(exp, &s_log, session);
+    xSemaphoreGive(s_lock);
+    return ok;
+}
+
+size_t recorder_export_read(recorder_export_t *exp, uint8_t *buf, size_t len) {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    size_t n = stream_rec_export_read(exp, buf, len);
+    xSemaphoreGive(s_lock);
+    return n;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file logger_feed_udp.h
+ * @brief Logger feed over UDP broadcast/multicast (system.logger_feed)
+ *
+ * With system.logger_feed set to "addr[:port]" (a broadcast address such
+ * as 192.168.1.255, 255.255.255.255, or an IPv4 multicast group; port
+ * LOGGER_FEED_PORT by default), the feed service (bg_task.c) sends what
+ * logging programs listen for, in the datagrams of logger_feed.h:
+ * - decoded characters and words, read from the decoder transcript
+ * - TX and RX start/stop, from the local and remote key edges
+ * - the keyer and decoded speed, in every header
+ *
+ * Characters are stamped with the pass that read them, so within one
+ * LOGGER_FEED_BATCH_MS of when they were decoded; key state changes with
+ * their edge time. Datagrams go out only while WiFi is connected, with
+ * MSG_DONTWAIT: what the stack refuses is counted, not retried. Changing
+ * the address takes effect at the next pass; clearing it stops the feed.
+ */
+
+#ifndef KEYER_LOGGER_FEED_UDP_H
+#define KEYER_LOGGER_FEED_UDP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Feed snapshot (console)
+ */
+typedef struct {
+    bool active;            /**< Address valid, socket open */
+    uint32_t sent;          /**< Datagrams sent */
+    uint32_t events;        /**< Event lines in them */
+    uint32_t dropped;       /**< Characters or key edges lost before they went out */
+    uint32_t errors;        /**< sendto() failures */
+} logger_feed_stats_t;
+
+/**
+ * @brief Feed service init
+ */
+void logger_feed_init(int64_t now_us);
+
+/**
+ * @brief One feed service pass: send the events since the last one
+ *
+ * @return false (fixed period)
+ */
+bool logger_feed_run(int64_t now_us);
+
+/**
+ * @brief Feed snapshot (best-effort from other tasks)
+ */
+void logger_feed_get_stats(logger_feed_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_LOGGER_FEED_UDP_H */
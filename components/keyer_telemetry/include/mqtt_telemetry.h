@@ -0,0 +1,54 @@
+/**
+ * @file mqtt_telemetry.h
+ * @brief MQTT fleet telemetry (system.mqtt_url)
+ *
+ * Publishes under <system.mqtt_topic>/<callsign>/:
+ * - metrics: the metrics registry, one batch per system.mqtt_interval_s
+ * - faults:  each fault log event as it is recorded (QoS 1)
+ * - link:    WiFi, VPN and CWNet state when it changes (retained)
+ * - status:  "online", or "offline" as the broker's last will (retained)
+ *
+ * The payloads are built by the telemetry service (bg_task.c, lowest
+ * priority on Core 1) and only queued to the esp-mqtt client, whose own
+ * task sends them at the same priority. Nothing is queued while the
+ * broker is unreachable: metrics are skipped, faults wait in the fault
+ * log, and the link state goes out again on the next connect.
+ *
+ * Without CONFIG_KEYER_TELEMETRY the API below is a stub.
+ */
+
+#ifndef KEYER_MQTT_TELEMETRY_H
+#define KEYER_MQTT_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the client if system.mqtt_url is set
+ *
+ * Call once the network stack is up; the client connects when an
+ * interface comes up and reconnects by itself.
+ */
+void mqtt_telemetry_init(void);
+
+/**
+ * @brief One telemetry service pass: queue what is due
+ *
+ * @return true while fault events are still waiting
+ */
+bool mqtt_telemetry_run(int64_t now_us);
+
+/**
+ * @brief Connected to the broker?
+ */
+bool mqtt_telemetry_is_connected(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_MQTT_TELEMETRY_H */
@@ -0,0 +1,351 @@
+/**
+ * @file logger_feed_udp.c
+ * @brief Logger feed over UDP broadcast/multicast (system.logger_feed)
+ *
+ * Everything runs in the feed service, which owns the socket, the key
+ * edge reader and the transcript cursor. They attach when the feed goes
+ * active (address set, WiFi up), so a logger hears what was decoded from
+ * then on, never a replay of the transcript.
+ */
+
+#include "logger_feed_udp.h"
+#include "logger_feed.h"
+#include "key_edge.h"
+#include "decoder.h"
+#include "decoder_transcript.h"
+#include "metrics.h"
+#include "rt_log.h"
+#include "wifi.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+/** system.logger_feed, kept to notice changes */
+#define FEED_SPEC_MAX 64
+
+/** Key state changes held per pass (a few per over at most) */
+#define FEED_STATES_MAX 8
+
+/** Transcript characters read at a time */
+#define FEED_TEXT_CHUNK 64
+
+/** Any wall clock before this was never set (2020-09-13) */
+#define FEED_MIN_UNIX_S 1600000000LL
+
+extern key_edge_ring_t g_key_edge_ring;
+extern transcript_t g_decoder_transcript;
+
+typedef struct {
+    char kind;                /**< 'T' or 'R' */
+    bool on;
+    int64_t time_us;
+} feed_state_t;
+
+/** One keyed signal: TX from the keyer output, RX from the remote key */
+typedef struct {
+    logger_feed_activity_t activity;
+    uint64_t last_tick;       /**< Last edge (key_edge_head_tick reference) */
+} feed_key_t;
+
+static struct {
+    char spec[FEED_SPEC_MAX];
+    bool valid;               /**< spec parsed to an address */
+    bool attached;            /**< Reader and cursor follow the sources */
+    bool registered;          /**< Metrics registered */
+    int sock;
+    struct sockaddr_in addr;
+    key_edge_reader_t edges;
+    uint32_t text_seq;        /**< Next transcript character */
+    feed_key_t tx;
+    feed_key_t rx;
+    logger_feed_words_t words;
+    uint32_t lost;            /**< Not yet reported */
+    uint32_t seq;             /**< Datagrams built */
+    int64_t last_send_us;
+    atomic_bool active;
+    atomic_uint sent;
+    atomic_uint events;
+    atomic_uint dropped;
+    atomic_uint errors;
+} s_feed = { .sock = -1 };
+
+static logger_feed_batch_t s_batch;
+
+static const metric_desc_t k_feed_metrics[] = {
+    { "keyer_feed_sent_total", "Logger feed datagrams sent", METRIC_COUNTER,
+      NULL, &s_feed.sent },
+    { "keyer_feed_dropped_total", "Characters or key edges lost before the logger feed sent them",
+      METRIC_COUNTER, NULL, &s_feed.dropped },
+    { "keyer_feed_errors_total", "Logger feed datagrams the stack refused", METRIC_COUNTER,
+      NULL, &s_feed.errors },
+};
+
+/** system.logger_feed: "addr[:port]", a broadcast or multicast address */
+static bool parse(const char *spec) {
+    char host[FEED_SPEC_MAX];
+    strncpy(host, spec, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+
+    unsigned long port = LOGGER_FEED_PORT;
+    char *colon = strrchr(host, ':');
+    if (colon != NULL) {
+        *colon = '\0';
+        port = strtoul(colon + 1, NULL, 10);
+        if (port == 0 || port > 65535UL) {
+            port = LOGGER_FEED_PORT;
+        }
+    }
+
+    memset(&s_feed.addr, 0, sizeof(s_feed.addr));
+    s_feed.addr.sin_family = AF_INET;
+    s_feed.addr.sin_port = htons((uint16_t)port);
+    return inet_aton(host, &s_feed.addr.sin_addr) != 0;
+}
+
+static bool open_socket(void) {
+    if (s_feed.sock >= 0) {
+        return true;
+    }
+    s_feed.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_feed.sock < 0) {
+        return false;
+    }
+    int on = 1;
+    uint8_t ttl = 1;   /* Multicast stays on the LAN */
+    (void)setsockopt(s_feed.sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    (void)setsockopt(s_feed.sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    return true;
+}
+
+/** Wall clock minus uptime, 0 while the clock is unset */
+static int64_t wall_offset_us(int64_t now_us) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    if ((int64_t)tv.tv_sec < FEED_MIN_UNIX_S) {
+        return 0;
+    }
+    return (int64_t)tv.tv_sec * 1000000 + (int64_t)tv.tv_usec - now_us;
+}
+
+static void attach(int64_t now_us) {
+    key_edge_reader_init(&s_feed.edges, &g_key_edge_ring);
+    s_feed.text_seq = transcript_head(&g_decoder_transcript);
+    logger_feed_activity_init(&s_feed.tx.activity);
+    logger_feed_activity_init(&s_feed.rx.activity);
+    logger_feed_words_init(&s_feed.words);
+    s_feed.lost = 0;
+    s_feed.last_send_us = now_us - (int64_t)LOGGER_FEED_HEARTBEAT_MS * 1000;
+    s_feed.attached = true;
+    if (!s_feed.registered) {
+        metrics_register_all(&g_metrics, k_feed_metrics,
+                             sizeof(k_feed_metrics) / sizeof(k_feed_metrics[0]));
+        s_feed.registered = true;
+    }
+    RT_INFO(&g_bg_log_stream, now_us, "Feed: sending to %s:%u",
+            inet_ntoa(s_feed.addr.sin_addr), (unsigned)ntohs(s_feed.addr.sin_port));
+}
+
+static void lose(uint32_t n) {
+    s_feed.lost += n;
+    atomic_fetch_add_explicit(&s_feed.dropped, n, memory_order_relaxed);
+}
+
+/** Start or stop of one key, if it changed */
+static void key_poll(feed_key_t *key, char kind, int64_t hold_us,
+                     feed_state_t *states, size_t *count) {
+    int64_t head_us = key_edge_time_us(&g_key_edge_ring,
+                                       key_edge_head_tick(&g_key_edge_ring, key->last_tick));
+    int64_t stop_us;
+    if (logger_feed_activity_poll(&key->activity, head_us, hold_us, &stop_us)) {
+        if (*count < FEED_STATES_MAX) {
+            states[(*count)++] = (feed_state_t){ .kind = kind, .on = false, .time_us = stop_us };
+        } else {
+            lose(1);
+        }
+    }
+}
+
+/** Key edges since the last pass, as TX/RX starts and stops */
+static size_t read_keys(feed_state_t *states, int64_t hold_us) {
+    size_t count = 0;
+    key_edge_t edge;
+    while (key_edge_reader_next(&s_feed.edges, &edge)) {
+        feed_key_t *key;
+        char kind;
+        if (edge.channel == KEY_EDGE_CH_KEY) {
+            key = &s_feed.tx;
+            kind = 'T';
+        } else if (edge.channel == KEY_EDGE_CH_REMOTE) {
+            key = &s_feed.rx;
+            kind = 'R';
+        } else {
+            continue;
+        }
+        int64_t time_us = key_edge_time_us(&g_key_edge_ring, edge.tick);
+        /* A stop falls between the edges: the hold may have passed before this one */
+        int64_t stop_us;
+        if (key->activity.on && !key->activity.down && edge.level != 0 &&
+            logger_feed_activity_poll(&key->activity, time_us, hold_us, &stop_us)) {
+            if (count < FEED_STATES_MAX) {
+                states[count++] = (feed_state_t){ .kind = kind, .on = false, .time_us = stop_us };
+            } else {
+                lose(1);
+            }
+        }
+        key->last_tick = edge.tick;
+        if (logger_feed_activity_edge(&key->activity, time_us, edge.level != 0)) {
+            if (count < FEED_STATES_MAX) {
+                states[count++] = (feed_state_t){ .kind = kind, .on = true, .time_us = time_us };
+            } else {
+                lose(1);
+            }
+        }
+    }
+    if (s_feed.edges.dropped != 0) {
+        lose((uint32_t)s_feed.edges.dropped);
+        s_feed.edges.dropped = 0;
+    }
+    key_poll(&s_feed.tx, 'T', hold_us, states, &count);
+    key_poll(&s_feed.rx, 'R', hold_us, states, &count);
+    return count;
+}
+
+static void begin_batch(void) {
+    logger_feed_header_t hdr = {
+        .callsign = CONFIG_GET_CALLSIGN(),
+        .seq = s_feed.seq++,
+        .keyer_wpm = CONFIG_GET_WPM(),
+        .rx_wpm = decoder_get_wpm(),
+        .tx = s_feed.tx.activity.on,
+        .rx = s_feed.rx.activity.on,
+    };
+    logger_feed_batch_begin(&s_batch, &hdr);
+    if (s_feed.lost != 0 && logger_feed_batch_dropped(&s_batch, s_feed.lost)) {
+        s_feed.lost = 0;
+    }
+}
+
+static void send_batch(int64_t now_us) {
+    ssize_t n = sendto(s_feed.sock, s_batch.buf, s_batch.len, MSG_DONTWAIT,
+                       (const struct sockaddr *)&s_feed.addr, sizeof(s_feed.addr));
+    s_feed.last_send_us = now_us;
+    if (n < 0) {
+        atomic_fetch_add_explicit(&s_feed.errors, 1U, memory_order_relaxed);
+        return;
+    }
+    atomic_fetch_add_explicit(&s_feed.sent, 1U, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_feed.events, s_batch.events, memory_order_relaxed);
+}
+
+static void detach(void) {
+    s_feed.attached = false;
+    atomic_store_explicit(&s_feed.active, false, memory_order_relaxed);
+}
+
+void logger_feed_init(int64_t now_us) {
+    (void)now_us;
+    s_feed.spec[0] = '\0';
+    s_feed.valid = false;
+    detach();
+}
+
+bool logger_feed_run(int64_t now_us) {
+    const char *spec = CONFIG_GET_LOGGER_FEED();
+    if (strncmp(spec, s_feed.spec, sizeof(s_feed.spec)) != 0) {
+        strncpy(s_feed.spec, spec, sizeof(s_feed.spec) - 1);
+        s_feed.spec[sizeof(s_feed.spec) - 1] = '\0';
+        detach();
+        s_feed.valid = spec[0] != '\0' && parse(spec);
+        if (spec[0] != '\0' && !s_feed.valid) {
+            RT_WARN(&g_bg_log_stream, now_us,
+                    "Feed: '%s' is not a broadcast or multicast address", spec);
+        }
+    }
+    if (!s_feed.valid || !wifi_is_connected()) {
+        detach();
+        return false;
+    }
+    if (!s_feed.attached) {
+        if (!open_socket()) {
+            return false;
+        }
+        attach(now_us);
+        atomic_store_explicit(&s_feed.active, true, memory_order_relaxed);
+    }
+
+    int64_t wall_us = wall_offset_us(now_us);
+    int64_t hold_us = (int64_t)CONFIG_GET_PTT_TAIL_MS() * 1000;
+    feed_state_t states[FEED_STATES_MAX];
+    size_t nstates = read_keys(states, hold_us);
+    size_t state_i = 0;
+
+    /* Characters the transcript overwrote before this pass got to them */
+    uint32_t head = transcript_head(&g_decoder_transcript);
+    if (head - s_feed.text_seq > TRANSCRIPT_CAPACITY) {
+        lose(head - s_feed.text_seq - TRANSCRIPT_CAPACITY);
+        s_feed.text_seq = head - TRANSCRIPT_CAPACITY;
+    }
+
+    char text[FEED_TEXT_CHUNK];
+    size_t text_n = 0;
+    size_t text_i = 0;
+    int64_t text_ms = (now_us + wall_us) / 1000;
+
+    for (;;) {
+        begin_batch();
+        bool full = false;
+        for (; state_i < nstates && !full; state_i++) {
+            const feed_state_t *st = &states[state_i];
+            if (!logger_feed_batch_state(&s_batch, st->kind, (st->time_us + wall_us) / 1000,
+                                         st->on)) {
+                full = true;
+                break;
+            }
+        }
+        while (!full) {
+            if (text_i == text_n) {
+                transcript_slice_t slice;
+                text_n = transcript_read(&g_decoder_transcript, s_feed.text_seq, text,
+                                         sizeof(text), &slice);
+                text_i = 0;
+                if (slice.first_seq != s_feed.text_seq) {
+                    lose(slice.first_seq - s_feed.text_seq);   /* Lapped meanwhile */
+                    s_feed.text_seq = slice.first_seq;
+                }
+                if (text_n == 0) {
+                    break;
+                }
+            }
+            if (!logger_feed_batch_text(&s_batch, &s_feed.words, text_ms, text[text_i])) {
+                full = true;
+                break;
+            }
+            text_i++;
+            s_feed.text_seq++;
+        }
+
+        if (s_batch.events != 0 ||
+            now_us - s_feed.last_send_us >= (int64_t)LOGGER_FEED_HEARTBEAT_MS * 1000) {
+            send_batch(now_us);
+        }
+        if (!full) {
+            return false;
+        }
+    }
+}
+
+void logger_feed_get_stats(logger_feed_stats_t *out) {
+    out->active = atomic_load_explicit(&s_feed.active, memory_order_relaxed);
+    out->sent = atomic_load_explicit(&s_feed.sent, memory_order_relaxed);
+    out->events = atomic_load_explicit(&s_feed.events, memory_order_relaxed);
+    out->dropped = atomic_load_explicit(&s_feed.dropped, memory_order_relaxed);
+    out->errors = atomic_load_explicit(&s_feed.errors, memory_order_relaxed);
+}
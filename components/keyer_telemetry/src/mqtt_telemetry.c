@@ -0,0 +1,231 @@
+/**
+ * @file mqtt_telemetry.c
+ * @brief MQTT fleet telemetry (system.mqtt_url)
+ *
+ * The esp-mqtt event handler only flips the connected flag; everything
+ * else runs in the telemetry service, which owns the telemetry_t state
+ * and the payload buffer.
+ */
+
+#include "mqtt_telemetry.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "config.h"
+
+#define TAG "mqtt"
+
+#ifdef CONFIG_KEYER_TELEMETRY
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "mqtt_client.h"
+#include "telemetry.h"
+#include "metrics.h"
+#include "fault.h"
+#include "rt_log.h"
+#include "wifi.h"
+#include "vpn.h"
+#include "cwnet_socket.h"
+
+/** Metrics batch and every other payload (the registry is about 2.5 KB) */
+#define MQTT_PAYLOAD_MAX 3072
+
+/** Messages the client may hold before it refuses more (bytes) */
+#define MQTT_OUTBOX_LIMIT 8192
+
+/** Fault events queued per pass */
+#define MQTT_FAULTS_PER_PASS 4
+
+/** <mqtt_topic>/<callsign> */
+#define MQTT_PREFIX_MAX 48
+
+extern fault_log_t g_fault_log;
+
+static struct {
+    esp_mqtt_client_handle_t client;
+    atomic_bool connected;
+    atomic_bool resync;       /**< Connected since the last pass */
+    telemetry_t state;        /**< Telemetry service only */
+    char prefix[MQTT_PREFIX_MAX];
+    char will_topic[MQTT_PREFIX_MAX + 8];
+    atomic_uint published;
+    atomic_uint dropped;
+    atomic_uint connects;
+} s_tel;
+
+EXT_RAM_BSS_ATTR static char s_payload[MQTT_PAYLOAD_MAX];
+
+static int64_t metric_connected(const void *ctx) {
+    (void)ctx;
+    return mqtt_telemetry_is_connected() ? 1 : 0;
+}
+
+static const metric_desc_t k_mqtt_metrics[] = {
+    { "keyer_mqtt_connected", "1 while the telemetry broker is connected", METRIC_GAUGE,
+      metric_connected, NULL },
+    { "keyer_mqtt_connects_total", "Telemetry broker connections", METRIC_COUNTER,
+      NULL, &s_tel.connects },
+    { "keyer_mqtt_published_total", "Telemetry messages queued", METRIC_COUNTER,
+      NULL, &s_tel.published },
+    { "keyer_mqtt_dropped_total", "Telemetry messages the client refused (outbox full)",
+      METRIC_COUNTER, NULL, &s_tel.dropped },
+};
+
+static void mqtt_event(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    (void)arg;
+    (void)base;
+    (void)data;
+    switch ((esp_mqtt_event_id_t)id) {
+        case MQTT_EVENT_CONNECTED:
+            atomic_fetch_add_explicit(&s_tel.connects, 1U, memory_order_relaxed);
+            atomic_store_explicit(&s_tel.resync, true, memory_order_relaxed);
+            atomic_store_explicit(&s_tel.connected, true, memory_order_release);
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+            atomic_store_explicit(&s_tel.connected, false, memory_order_relaxed);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Topic level from a parameter: MQTT wildcards and spaces become '_'
+ */
+static void topic_append(char *dst, size_t cap, const char *src) {
+    size_t len = strlen(dst);
+    for (; *src != '\0' && len + 1 < cap; src++) {
+        dst[len++] = (*src == '+' || *src == '#' || *src == ' ') ? '_' : *src;
+    }
+    dst[len] = '\0';
+}
+
+/**
+ * @brief Queue one message (the client's task sends it)
+ */
+static void publish(const char *leaf, const char *data, size_t len, int qos, bool retain) {
+    char topic[MQTT_PREFIX_MAX + 16];
+    snprintf(topic, sizeof(topic), "%s/%s", s_tel.prefix, leaf);
+    if (len == 0 ||
+        esp_mqtt_client_enqueue(s_tel.client, topic, data, (int)len, qos, retain, true) < 0) {
+        atomic_fetch_add_explicit(&s_tel.dropped, 1U, memory_order_relaxed);
+        return;
+    }
+    atomic_fetch_add_explicit(&s_tel.published, 1U, memory_order_relaxed);
+}
+
+void mqtt_telemetry_init(void) {
+    const char *url = CONFIG_GET_MQTT_URL();
+    if (url[0] == '\0' || s_tel.client != NULL) {
+        return;
+    }
+
+    s_tel.prefix[0] = '\0';
+    topic_append(s_tel.prefix, sizeof(s_tel.prefix), CONFIG_GET_MQTT_TOPIC());
+    topic_append(s_tel.prefix, sizeof(s_tel.prefix), "/");
+    topic_append(s_tel.prefix, sizeof(s_tel.prefix), CONFIG_GET_CALLSIGN());
+    snprintf(s_tel.will_topic, sizeof(s_tel.will_topic), "%s/status", s_tel.prefix);
+    telemetry_init(&s_tel.state);
+
+    const esp_mqtt_client_config_t cfg = {
+        .broker.address.uri = url,
+        .session.last_will = {
+            .topic = s_tel.will_topic,
+            .msg = "offline",
+            .msg_len = 7,
+            .qos = 1,
+            .retain = 1,
+        },
+        .session.keepalive = 60,
+        .buffer.size = 512,
+        .buffer.out_size = MQTT_PAYLOAD_MAX + 128,
+        .outbox.limit = MQTT_OUTBOX_LIMIT,
+        /* Same priority as the telemetry service, below cwnet and the BG services
+         * (core: CONFIG_MQTT_USE_CORE_1) */
+        .task.priority = tskIDLE_PRIORITY + 1,
+        .task.stack_size = 4096,
+    };
+    s_tel.client = esp_mqtt_client_init(&cfg);
+    if (s_tel.client == NULL) {
+        ESP_LOGE(TAG, "Client init failed");
+        return;
+    }
+    esp_mqtt_client_register_event(s_tel.client, ESP_EVENT_ANY_ID, mqtt_event, NULL);
+    esp_err_t ret = esp_mqtt_client_start(s_tel.client);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Client start failed: %s", esp_err_to_name(ret));
+        esp_mqtt_client_destroy(s_tel.client);
+        s_tel.client = NULL;
+        return;
+    }
+    metrics_register_all(&g_metrics, k_mqtt_metrics, sizeof(k_mqtt_metrics) / sizeof(k_mqtt_metrics[0]));
+    ESP_LOGI(TAG, "Telemetry to %s", s_tel.prefix);
+}
+
+bool mqtt_telemetry_run(int64_t now_us) {
+    if (!mqtt_telemetry_is_connected()) {
+        return false;
+    }
+
+    if (atomic_exchange_explicit(&s_tel.resync, false, memory_order_relaxed)) {
+        RT_INFO(&g_bg_log_stream, now_us, "MQTT: connected, publishing to %s", s_tel.prefix);
+        telemetry_resync(&s_tel.state);
+        publish("status", "online", 6, 1, true);
+    }
+
+    /* Link state on change, retained so a new subscriber sees it at once */
+    telemetry_link_t link = {
+        .wifi = (uint8_t)wifi_get_state(),
+        .vpn = (uint8_t)vpn_get_state(),
+        .cwnet = (uint8_t)cwnet_socket_get_state(),
+    };
+    if (telemetry_link_changed(&s_tel.state, &link)) {
+        link.wifi_str = wifi_state_str((wifi_state_t)link.wifi);
+        link.vpn_str = vpn_state_str((vpn_state_t)link.vpn);
+        link.cwnet_str = cwnet_socket_state_str((cwnet_socket_state_t)link.cwnet);
+        publish("link", s_payload, telemetry_render_link(&link, s_payload, sizeof(s_payload)),
+                1, true);
+    }
+
+    /* Fault events as they happen */
+    fault_event_t events[MQTT_FAULTS_PER_PASS];
+    size_t n = telemetry_take_faults(&s_tel.state, &g_fault_log, events, MQTT_FAULTS_PER_PASS);
+    for (size_t i = 0; i < n; i++) {
+        publish("faults", s_payload, telemetry_render_fault(&events[i], s_payload, sizeof(s_payload)),
+                1, false);
+    }
+
+    /* The whole registry, one message per interval */
+    if (telemetry_batch_due(&s_tel.state, now_us, CONFIG_GET_MQTT_INTERVAL_S())) {
+        size_t len = telemetry_render_batch(&s_tel.state, &g_metrics, now_us,
+                                            s_payload, sizeof(s_payload));
+        publish("metrics", s_payload, len, 0, false);
+    }
+    return n == MQTT_FAULTS_PER_PASS;
+}
+
+bool mqtt_telemetry_is_connected(void) {
+    return atomic_load_explicit(&s_tel.connected, memory_order_acquire);
+}
+
+#else /* !CONFIG_KEYER_TELEMETRY */
+
+void mqtt_telemetry_init(void) {
+    if (CONFIG_GET_MQTT_URL()[0] != '\0') {
+        ESP_LOGW(TAG, "Telemetry not built in (CONFIG_KEYER_TELEMETRY)");
+    }
+}
+
+bool mqtt_telemetry_run(int64_t now_us) {
+    (void)now_us;
+    return false;
+}
+
+bool mqtt_telemetry_is_connected(void) {
+    return false;
+}
+
+#endif /* CONFIG_KEYER_TELEMETRY */
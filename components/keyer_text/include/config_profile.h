@@ -0,0 +1,102 @@
+/**
+ * @file config_profile.h
+ * @brief Whole-device settings profile: parameters and text memories
+ *
+ * One binary blob that carries every parameter of parameters.yaml and the
+ * eight text memories, to back a keyer up or clone it onto another one
+ * (GET/PUT /api/config/profile, console "profile save/load").
+ *
+ * Layout, little-endian:
+ *
+ *   header   u32 magic "KPRF", u16 version, u16 sections,
+ *            u32 payload length, u32 CRC-32 of the payload
+ *   section  u8 id, u8 reserved, u16 length, data
+ *
+ *   params   per parameter: u32 config_name_hash(full_path, 0), u8 type,
+ *            u8 length, value (1/2/4 bytes, or the string without NUL)
+ *   memories per slot: u8 text length, text, u8 label length, label
+ *
+ * Parameters are keyed by name hash, not by position, so a profile
+ * outlives parameters.yaml changes: keys this firmware does not know are
+ * skipped, parameters the profile lacks keep their value, and a number
+ * whose width changed is still accepted if it is in range.
+ *
+ * Import is all-or-nothing: every value is checked before anything is
+ * applied, then the parameters land under one generation bump and one
+ * deferred NVS commit (config_persist_request()), the memories with one
+ * commit of their own namespace.
+ *
+ * Lives with the text memories: keyer_config is generated and sits below
+ * keyer_text in the component graph.
+ */
+
+#ifndef KEYER_TEXT_CONFIG_PROFILE_H
+#define KEYER_TEXT_CONFIG_PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Format version written in the header */
+#define CONFIG_PROFILE_VERSION 1U
+
+/** Largest profile (every string at its maximum, every memory full) */
+#define CONFIG_PROFILE_MAX_SIZE 4096U
+
+/** Section ids */
+#define CONFIG_PROFILE_SEC_PARAMS   1U
+#define CONFIG_PROFILE_SEC_MEMORIES 2U
+
+/** Import errors */
+#define CONFIG_PROFILE_ERR_FORMAT  (-1)  /**< Not a profile, truncated */
+#define CONFIG_PROFILE_ERR_CRC     (-2)  /**< Payload corrupted */
+#define CONFIG_PROFILE_ERR_VERSION (-3)  /**< Written by a newer format */
+#define CONFIG_PROFILE_ERR_VALUE   (-4)  /**< Parameter out of range (bad_key) */
+#define CONFIG_PROFILE_ERR_MEMORY  (-5)  /**< Malformed memories section */
+#define CONFIG_PROFILE_ERR_BUSY    (-6)  /**< Another import in progress */
+#define CONFIG_PROFILE_ERR_SAVE    (-7)  /**< Memories not written to NVS */
+
+/**
+ * @brief What an import did
+ */
+typedef struct {
+    unsigned applied;        /**< Parameters set */
+    unsigned skipped;        /**< Unknown keys ignored */
+    unsigned memories;       /**< Memory slots replaced (0 or 8) */
+    const char *bad_key;     /**< Rejected parameter (ERR_VALUE), else NULL */
+} config_profile_result_t;
+
+/**
+ * @brief Write the current settings as a profile
+ *
+ * @param out Buffer
+ * @param cap Its size (CONFIG_PROFILE_MAX_SIZE always fits)
+ * @return Profile length, 0 if it does not fit
+ */
+size_t config_profile_export(uint8_t *out, size_t cap);
+
+/**
+ * @brief Check and apply a profile
+ *
+ * @param data Profile
+ * @param len Its length
+ * @param res What was done (may be NULL)
+ * @return 0 on success, CONFIG_PROFILE_ERR_* (nothing applied, except
+ *         ERR_SAVE where the parameters are set but the memories only
+ *         in RAM)
+ */
+int config_profile_import(const uint8_t *data, size_t len, config_profile_result_t *res);
+
+/**
+ * @brief Human readable import error
+ */
+const char *config_profile_strerror(int err);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TEXT_CONFIG_PROFILE_H */
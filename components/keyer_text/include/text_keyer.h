@@ -2,13 +2,18 @@
  * @file text_keyer.h
  * @brief Text-to-Morse keyer
  *
- * Converts text to morse code and produces samples on keying stream.
- * Runs on Core 1 (bg_task) with ~10ms tick resolution.
+ * Converts text to morse code. Text is appended to a type-ahead queue
+ * (text_typeahead.h) from any task; text_keyer_tick() on Core 1 (bg_task,
+ * ~10ms) compiles it into a run-length key schedule (text_schedule.h) a
+ * few characters ahead; the RT task on Core 0 plays it back with
+ * text_keyer_rt_tick(), so element edges fall on RT ticks instead of the
+ * bg loop period.
  *
  * Features:
- * - Free-form text via send command
+ * - Free-form text via send command, type-ahead while sending
+ * - Take back queued text (backspace, cancel message)
  * - 8 memory slots in NVS
- * - Paddle abort via atomic flag
+ * - Paddle abort on the same RT tick
  * - Uses global WPM from config
  */
 
@@ -36,6 +41,16 @@ typedef enum {
     TEXT_KEYER_PAUSED,        /**< Paused (can resume) */
 } text_keyer_state_t;
 
+/**
+ * @brief Type-ahead queue occupancy
+ */
+typedef struct {
+    size_t queued;      /**< Characters waiting to be compiled */
+    size_t free;        /**< Characters text_keyer_send() can still take */
+    size_t capacity;    /**< Queue size in characters */
+    uint32_t rejected;  /**< Sends refused for lack of room */
+} text_keyer_buffer_t;
+
 /**
  * @brief Text keyer configuration
  */
@@ -54,13 +69,49 @@ int text_keyer_init(const text_keyer_config_t *config);
 /**
  * @brief Send text as morse code
  *
+ * Queued behind any text still being sent. Safe from any task; a single
+ * character per call is fine (keystroke streaming).
+ *
  * @param text Text to send (A-Z, 0-9, punctuation, prosigns, spaces)
- * @return 0 on success, -1 if already sending or invalid
+ * @return 0 on success, -1 if invalid, the queue is full or an abort is
+ *         being retired
  */
 int text_keyer_send(const char *text);
 
 /**
- * @brief Abort current transmission
+ * @brief Send a memory slot, fields filled in ({SERIAL}, {CALL}, ...)
+ *
+ * Plays the slot's compiled macro. When nothing else is queued the first
+ * runs are compiled before this returns, so the first element keys on
+ * the next RT tick; behind queued text the slot goes through the
+ * type-ahead like text_keyer_send(). The serial advances after each send
+ * of a slot that uses {SERIAL}.
+ *
+ * @param slot Slot index (0-7)
+ * @return 0 on success, -1 if the slot is empty or invalid, the queue is
+ *         full or an abort is being retired
+ */
+int text_keyer_send_memory(uint8_t slot);
+
+/**
+ * @brief Take back queued text that has not been compiled yet
+ *
+ * The last few characters ahead of playback are already in the schedule
+ * and are sent regardless.
+ *
+ * @param whole_message false: newest character (backspace);
+ *                      true: what is left of the newest send
+ * @return Characters removed
+ */
+size_t text_keyer_cancel_last(bool whole_message);
+
+/**
+ * @brief Get type-ahead queue occupancy
+ */
+void text_keyer_get_buffer(text_keyer_buffer_t *out);
+
+/**
+ * @brief Abort current transmission and everything queued
  */
 void text_keyer_abort(void);
 
@@ -84,6 +135,8 @@ text_keyer_state_t text_keyer_get_state(void);
 /**
  * @brief Get transmission progress
  *
+ * Counts since the keyer was last idle, so text typed ahead adds to total.
+ *
  * @param sent Output: characters sent so far
  * @param total Output: total characters
  */
@@ -92,14 +145,41 @@ void text_keyer_get_progress(size_t *sent, size_t *total);
 /**
  * @brief Tick function - call from bg_task (~10ms)
  *
+ * Compiles queued text ahead into the schedule, retires aborted text.
+ *
  * @param now_us Current timestamp in microseconds
  */
 void text_keyer_tick(int64_t now_us);
 
 /**
- * @brief Get current key-down state (RT-safe)
+ * @brief Play the schedule for one RT tick (Core 0 RT task only)
+ *
+ * A paddle active during playback stops the text on this tick; the
+ * key is up from this tick on.
+ *
+ * @param tick_us RT tick period
+ * @param paddle_active A paddle is pressed (or an edge is queued)
+ * @return true if the text keyer has key down for this tick
+ */
+bool text_keyer_rt_tick(uint32_t tick_us, bool paddle_active);
+
+/**
+ * @brief Time until the text keyer keys down (Core 0 RT task only)
+ *
+ * @param limit_us Look no further ahead than this
+ * @return 0 if keyed now, UINT32_MAX if nothing keys within limit_us
+ */
+uint32_t text_keyer_rt_until_key_us(uint32_t limit_us);
+
+/**
+ * @brief Hold text playback with the key up, e.g. for the PTT lead
+ *        (Core 0 RT task only)
+ */
+void text_keyer_rt_hold(bool hold);
+
+/**
+ * @brief Key-down state of the last RT tick
  *
- * Called from Core 0 RT task every 1ms to poll text keyer state.
  * Uses atomic load for lock-free access across cores.
  *
  * @return true if text keyer has key down
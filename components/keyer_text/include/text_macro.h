@@ -0,0 +1,162 @@
+/**
+ * @file text_macro.h
+ * @brief Contest macros: memory text compiled into morse tokens
+ *
+ * A memory slot is compiled once, when it is saved, into a token list:
+ * one morse code per character or prosign, a word gap per space, and a
+ * field token for each {FIELD}. Playing it needs no parsing and no
+ * character lookup; only the fields are turned into codes, at play time,
+ * from their current values (text_macro_expand()).
+ *
+ * Fields (case-insensitive):
+ * - {SERIAL}  Contest serial number, at least three digits ("007")
+ * - {CALL}    Call of the station worked
+ * - {MYCALL}  Own callsign (system.callsign)
+ * - {RST}     Report, "599" unless set ("5NN")
+ *
+ * Braces that do not name a field are sent as the text between them
+ * (the braces themselves have no morse).
+ *
+ * Field values are written from the console or web UI and read by
+ * whichever task plays a macro; a sequence counter keeps a reader from
+ * seeing a half-written value.
+ */
+
+#ifndef KEYER_TEXT_MACRO_H
+#define KEYER_TEXT_MACRO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Token: a morse code (below MORSE_CODE_LIMIT), a word gap or a field */
+typedef uint16_t text_macro_token_t;
+
+/** Word gap token */
+#define TEXT_MACRO_WORD_GAP ((text_macro_token_t)0xFFFFU)
+
+/** Field token for a text_macro_field_t */
+#define TEXT_MACRO_FIELD(id) ((text_macro_token_t)(0xFF00U | (unsigned)(id)))
+
+/** Field id of a token, or -1 if it is not a field */
+static inline int text_macro_token_field(text_macro_token_t tok) {
+    return ((tok & 0xFF00U) == 0xFF00U && tok != TEXT_MACRO_WORD_GAP) ? (int)(tok & 0xFFU) : -1;
+}
+
+/** Tokens a compiled slot can hold (one per character at most) */
+#define TEXT_MACRO_MAX_TOKENS 128
+
+/** Longest field value, NUL included */
+#define TEXT_MACRO_FIELD_LEN 16
+
+/** Tokens a played macro expands to at most (the rest is cut) */
+#define TEXT_MACRO_MAX_EXPANDED (2U * TEXT_MACRO_MAX_TOKENS)
+
+/**
+ * @brief Fields
+ */
+typedef enum {
+    TEXT_MACRO_SERIAL = 0,
+    TEXT_MACRO_CALL,
+    TEXT_MACRO_MYCALL,
+    TEXT_MACRO_RST,
+    TEXT_MACRO_FIELD_COUNT
+} text_macro_field_t;
+
+/**
+ * @brief Compiled slot
+ */
+typedef struct {
+    uint16_t len;              /**< Tokens used */
+    uint16_t fields;           /**< Bit per text_macro_field_t present */
+    text_macro_token_t tok[TEXT_MACRO_MAX_TOKENS];
+} text_macro_t;
+
+/**
+ * @brief Field values for one expansion
+ */
+typedef struct {
+    uint32_t serial;
+    char call[TEXT_MACRO_FIELD_LEN];
+    char mycall[TEXT_MACRO_FIELD_LEN];
+    char rst[TEXT_MACRO_FIELD_LEN];
+} text_macro_values_t;
+
+/**
+ * @brief Compile memory text
+ *
+ * @param m Compiled slot (empty for NULL or empty text)
+ * @param text Slot text
+ */
+void text_macro_compile(text_macro_t *m, const char *text);
+
+/** The macro uses a field */
+static inline bool text_macro_has_field(const text_macro_t *m, text_macro_field_t f) {
+    return (m->fields & (1U << f)) != 0;
+}
+
+/**
+ * @brief Replace field tokens with the codes of their values
+ *
+ * @param m Compiled slot
+ * @param v Field values
+ * @param out Token list to fill
+ * @param cap Capacity of out
+ * @return Tokens written (cut at cap)
+ */
+size_t text_macro_expand(const text_macro_t *m, const text_macro_values_t *v,
+                         text_macro_token_t *out, size_t cap);
+
+/**
+ * @brief Substitute fields into memory text (for display or plain sends)
+ *
+ * @param text Slot text
+ * @param v Field values
+ * @param out Output, always terminated
+ * @param cap Size of out
+ * @return Characters written
+ */
+size_t text_macro_render(const char *text, const text_macro_values_t *v, char *out, size_t cap);
+
+/**
+ * @brief Field name ("SERIAL", ...), NULL for an invalid id
+ */
+const char *text_macro_field_name(text_macro_field_t f);
+
+/* ---- Field values (any task) ------------------------------------------- */
+
+/** Current serial number */
+uint32_t text_macro_serial(void);
+
+/** Set the serial number */
+void text_macro_set_serial(uint32_t serial);
+
+/** Advance the serial number by one (after an exchange was sent) */
+void text_macro_next_serial(void);
+
+/**
+ * @brief Set a text field (CALL or RST; MYCALL comes from the config)
+ *
+ * Cut to TEXT_MACRO_FIELD_LEN - 1 characters; NULL or "" clears it (RST
+ * goes back to "599").
+ *
+ * @return false for a field that can not be set
+ */
+bool text_macro_set_field(text_macro_field_t f, const char *value);
+
+/**
+ * @brief Snapshot the field values
+ *
+ * @param v Values (mycall left as it is: the caller fills it)
+ */
+void text_macro_get_values(text_macro_values_t *v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TEXT_MACRO_H */
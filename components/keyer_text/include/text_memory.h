@@ -3,6 +3,12 @@
  * @brief Memory slots for stored text messages (NVS)
  *
  * 8 slots for frequently used messages (CQ, 73, contest exchanges).
+ * Each slot is compiled into a macro (text_macro.h) whenever it is saved
+ * or loaded, so sending it does not parse the text again.
+ *
+ * Edits reach NVS through the deferred persistence worker
+ * (config_persist.h): only the slots that changed are written, in one
+ * commit, once the keyer is idle.
  */
 
 #ifndef KEYER_TEXT_MEMORY_H
@@ -11,6 +17,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "text_macro.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,7 +62,8 @@ int text_memory_get(uint8_t slot, text_memory_slot_t *out);
  * @param slot Slot number (0-7)
  * @param text Text to store (NULL to clear)
  * @param label Label (NULL to keep existing or use default)
- * @return 0 on success, -1 on error
+ * @return 0 on success, -1 on error (saved later, an unchanged slot
+ *         is not written at all)
  */
 int text_memory_set(uint8_t slot, const char *text, const char *label);
 
@@ -77,12 +85,31 @@ int text_memory_clear(uint8_t slot);
 int text_memory_set_label(uint8_t slot, const char *label);
 
 /**
- * @brief Save all slots to NVS
+ * @brief Replace every slot at once (one NVS commit)
+ *
+ * Strings are cut to the slot sizes like text_memory_set(). The slots
+ * that changed are written before this returns.
  *
+ * @param slots TEXT_MEMORY_SLOTS slots, empty text clears a slot
  * @return 0 on success, -1 on error
  */
+int text_memory_replace_all(const text_memory_slot_t *slots);
+
+/**
+ * @brief Write the changed slots to NVS now, without waiting for idle
+ *
+ * @return 0 on success (also when nothing changed), -1 on error
+ */
 int text_memory_save(void);
 
+/**
+ * @brief Compiled macro of a slot
+ *
+ * @param slot Slot number (0-7)
+ * @return Macro (len 0 when the slot is empty), NULL if slot invalid
+ */
+const text_macro_t *text_memory_macro(uint8_t slot);
+
 /**
  * @brief Check if slot has content
  *
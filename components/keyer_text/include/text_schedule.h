@@ -0,0 +1,184 @@
+/**
+ * @file text_schedule.h
+ * @brief SPSC run-length key schedule: text keyer (Core 1) → RT task (Core 0)
+ *
+ * The text keyer compiles text into runs of {level, duration} a few
+ * characters ahead of playback; the RT task plays them back one tick at
+ * a time with text_schedule_play(). Element edges therefore land on RT
+ * ticks, whatever the bg loop period or load. Durations are kept in
+ * microseconds and consumed tick_us per tick with the remainder carried
+ * into the next run, so edges stay within one tick of the ideal time and
+ * never drift (the producer does not need to know the tick rate).
+ *
+ * Stopping: any task may request a stop (text_schedule_stop()); the RT
+ * task also stops on its own when a paddle is active during playback.
+ * While a stop is pending the player keeps the key up and discards every
+ * run. The producer acknowledges it with text_schedule_flush(), which
+ * also drops runs it queued before noticing.
+ *
+ * Hold: the RT task can keep playback from starting (key up, run time
+ * kept) until PTT has been up long enough, using text_schedule_until_key_us()
+ * to see the first element coming.
+ *
+ * Single producer (text_keyer_tick), single consumer (rt_task).
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#ifndef KEYER_TEXT_SCHEDULE_H
+#define KEYER_TEXT_SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Ring capacity in runs (MUST be power of 2) */
+#define TEXT_SCHEDULE_CAPACITY 256
+
+/** Longest single run; longer gaps are queued as several key-up runs */
+#define TEXT_SCHEDULE_MAX_RUN_US 0xFFFFFFU
+
+/** Largest text position a run can carry */
+#define TEXT_SCHEDULE_MAX_POS 0x7FU
+
+/**
+ * @brief One run, packed
+ *
+ * - bits 0-23:  duration in microseconds
+ * - bits 24-30: text position reached when the run starts (progress)
+ * - bit 31:     key level
+ */
+typedef uint32_t text_run_t;
+
+/** Pack a run */
+static inline text_run_t text_run_make(bool key_down, uint32_t duration_us, uint32_t pos) {
+    if (duration_us > TEXT_SCHEDULE_MAX_RUN_US) {
+        duration_us = TEXT_SCHEDULE_MAX_RUN_US;
+    }
+    if (pos > TEXT_SCHEDULE_MAX_POS) {
+        pos = TEXT_SCHEDULE_MAX_POS;
+    }
+    return (key_down ? 0x80000000U : 0U) | (pos << 24) | duration_us;
+}
+
+static inline bool text_run_key_down(text_run_t run) {
+    return (run & 0x80000000U) != 0;
+}
+
+static inline uint32_t text_run_duration_us(text_run_t run) {
+    return run & TEXT_SCHEDULE_MAX_RUN_US;
+}
+
+static inline uint32_t text_run_pos(text_run_t run) {
+    return (run >> 24) & TEXT_SCHEDULE_MAX_POS;
+}
+
+/**
+ * @brief Schedule ring plus player state
+ */
+typedef struct {
+    text_run_t buffer[TEXT_SCHEDULE_CAPACITY]; /**< Run storage */
+    atomic_size_t write_idx;   /**< Next run to write (producer, monotonic) */
+    atomic_size_t read_idx;    /**< Run being played / next to play (consumer) */
+    atomic_size_t flush_idx;   /**< Runs below are dropped (producer, flush) */
+    atomic_bool stop;          /**< Stop requested, key held up until flushed */
+    atomic_bool paused;        /**< Playback holds (key up, run time kept) */
+    atomic_uint_least32_t pos; /**< Text position of the run playing */
+
+    /* Player (consumer only) */
+    bool playing;              /**< A run is in progress */
+    int32_t remaining_us;      /**< Time left in the current run (carries over) */
+    bool key_down;             /**< Level of the run in progress */
+    bool held;                 /**< Held for the PTT lead (never mid-element) */
+} text_schedule_t;
+
+/**
+ * @brief Initialize an empty schedule
+ */
+void text_schedule_init(text_schedule_t *s);
+
+/* ---- Producer ---------------------------------------------------------- */
+
+/** Free runs in the ring */
+size_t text_schedule_space(const text_schedule_t *s);
+
+/**
+ * @brief Queue a run
+ *
+ * @return false if the ring is full (run not queued)
+ */
+bool text_schedule_push(text_schedule_t *s, text_run_t run);
+
+/**
+ * @brief Drop all queued runs and clear a pending stop
+ *
+ * Runs already pushed never play; the player releases the key on its
+ * next tick if it was playing.
+ */
+void text_schedule_flush(text_schedule_t *s);
+
+/** Nothing queued or playing */
+bool text_schedule_idle(const text_schedule_t *s);
+
+/* ---- Any task ---------------------------------------------------------- */
+
+/** Request a stop: key up on the next RT tick, runs discarded until flushed */
+void text_schedule_stop(text_schedule_t *s);
+
+/** A stop is waiting for text_schedule_flush() */
+bool text_schedule_stop_pending(const text_schedule_t *s);
+
+/** Hold or continue playback (a run interrupted by pause resumes where it was) */
+void text_schedule_set_paused(text_schedule_t *s, bool paused);
+
+/** Playback is held */
+bool text_schedule_paused(const text_schedule_t *s);
+
+/** Text position of the run playing (progress) */
+static inline uint32_t text_schedule_pos(const text_schedule_t *s) {
+    return (uint32_t)atomic_load_explicit(&s->pos, memory_order_relaxed);
+}
+
+/* ---- Consumer (RT task, once per tick) --------------------------------- */
+
+/**
+ * @brief Advance playback by one tick
+ *
+ * Bounded: a tick consumes at most the runs that end inside it.
+ *
+ * @param s Schedule
+ * @param tick_us Tick period
+ * @param paddle_active A paddle is pressed on this tick (stops playback)
+ * @return Key level for this tick
+ */
+bool text_schedule_play(text_schedule_t *s, uint32_t tick_us, bool paddle_active);
+
+/**
+ * @brief Hold playback with the key up (ignored inside a key-down run)
+ */
+void text_schedule_hold(text_schedule_t *s, bool hold);
+
+/**
+ * @brief Time until the next key-down run starts
+ *
+ * Bounded: stops looking limit_us ahead.
+ *
+ * @param s Schedule
+ * @param limit_us Look no further ahead than this
+ * @return 0 if the key is down, UINT32_MAX if nothing keys within
+ *         limit_us (or stopped/paused)
+ */
+uint32_t text_schedule_until_key_us(const text_schedule_t *s, uint32_t limit_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TEXT_SCHEDULE_H */
@@ -0,0 +1,125 @@
+/**
+ * @file text_typeahead.h
+ * @brief MPSC type-ahead character queue: any task → text keyer (Core 1)
+ *
+ * Text waiting to be sent. Producers (console, HTTP handlers, WebSocket
+ * keystrokes) append whole messages or single keystrokes while earlier
+ * text is still on the air; the text keyer pops characters only a few
+ * characters ahead of playback, so the newest queued text can still be
+ * taken back (text_typeahead_cancel_last()).
+ *
+ * Each slot is one atomic word holding the position it belongs to, a
+ * full flag, a message-start flag and the character, so publishing,
+ * popping and cancelling a character are single CAS/store operations.
+ * A cancelled character stays in its slot as a 0 and is skipped by the
+ * consumer.
+ *
+ * Multiple producers / cancellers, single consumer (text_keyer_tick).
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#ifndef KEYER_TEXT_TYPEAHEAD_H
+#define KEYER_TEXT_TYPEAHEAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Queue capacity in characters (MUST be power of 2) */
+#define TEXT_TYPEAHEAD_CAPACITY 512
+
+/**
+ * @brief What text_typeahead_cancel_last() takes back
+ */
+typedef enum {
+    TEXT_TYPEAHEAD_CANCEL_CHAR = 0,   /**< Newest queued character (backspace) */
+    TEXT_TYPEAHEAD_CANCEL_MESSAGE,    /**< Queued rest of the newest message */
+} text_typeahead_cancel_t;
+
+/**
+ * @brief Queue occupancy (display)
+ */
+typedef struct {
+    size_t queued;      /**< Characters waiting (cancelled ones until popped) */
+    size_t free;        /**< Characters an append can still take */
+    size_t capacity;    /**< TEXT_TYPEAHEAD_CAPACITY */
+    uint32_t rejected;  /**< Appends refused for lack of room */
+} text_typeahead_status_t;
+
+/**
+ * @brief Type-ahead queue
+ *
+ * Slot word:
+ * - bits 0-7:   character (0 = cancelled)
+ * - bit 8:      first character of an append
+ * - bit 9:      full
+ * - bits 10-31: position tag (low 22 bits of the queue position)
+ */
+typedef struct {
+    atomic_uint_least32_t slots[TEXT_TYPEAHEAD_CAPACITY];
+    atomic_uint_least32_t head;      /**< Positions claimed by producers (monotonic) */
+    atomic_uint_least32_t tail;      /**< Next position to pop (consumer) */
+    atomic_uint_least32_t rejected;  /**< Appends refused (full) */
+} text_typeahead_t;
+
+/**
+ * @brief Initialize an empty queue
+ */
+void text_typeahead_init(text_typeahead_t *q);
+
+/**
+ * @brief Append characters (all or nothing)
+ *
+ * NUL bytes are not queued. Safe from any task.
+ *
+ * @param q Queue
+ * @param text Characters
+ * @param len Number of characters
+ * @return false if empty or there is no room for all of them
+ */
+bool text_typeahead_append(text_typeahead_t *q, const char *text, size_t len);
+
+/**
+ * @brief Take back queued characters from the newest end
+ *
+ * Characters the consumer already popped are never touched, so a cancel
+ * only removes text that has not reached the schedule. Safe from any task.
+ *
+ * @param q Queue
+ * @param what One character, or everything left of the newest message
+ * @return Characters removed
+ */
+size_t text_typeahead_cancel_last(text_typeahead_t *q, text_typeahead_cancel_t what);
+
+/**
+ * @brief Pop the oldest character (consumer only)
+ *
+ * Cancelled characters are skipped. Stops at a slot whose append is
+ * still being written, so characters come out in order.
+ *
+ * @return false if nothing is ready
+ */
+bool text_typeahead_pop(text_typeahead_t *q, char *out);
+
+/** Nothing queued */
+bool text_typeahead_empty(const text_typeahead_t *q);
+
+/** Drop everything queued (consumer only) */
+void text_typeahead_clear(text_typeahead_t *q);
+
+/** Occupancy snapshot */
+void text_typeahead_get_status(const text_typeahead_t *q, text_typeahead_status_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_TEXT_TYPEAHEAD_H */
@@ -0,0 +1,430 @@
+/**
+ * @file config_profile.c
+ * @brief Settings profile export / import
+ */
+
+#include "config_profile.h"
+#include "config.h"
+#include "config_console.h"
+#include "config_persist.h"
+#include "text_memory.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define EXT_RAM_BSS_ATTR
+#endif
+
+#define PROFILE_MAGIC      0x4652504BU  /* "KPRF" */
+#define PROFILE_HEADER     16U
+#define PROFILE_SEC_HEADER 4U
+#define PROFILE_ENTRY_HEAD 6U           /* hash, type, length */
+
+/* Profile keys: full path hashes, computed once */
+static uint32_t s_keys[CONSOLE_PARAM_COUNT];
+static atomic_bool s_keys_ready;
+
+/* One import at a time (HTTP worker or console); owns s_mem */
+static atomic_bool s_importing;
+static EXT_RAM_BSS_ATTR text_memory_slot_t s_mem[TEXT_MEMORY_SLOTS];
+
+static void put_u16(uint8_t *b, uint16_t v) {
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *b, uint32_t v) {
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+    b[2] = (uint8_t)(v >> 16);
+    b[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *b) {
+    return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *b) {
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+           ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+/* CRC-32 (IEEE, reflected), bitwise like the config blob */
+static uint32_t profile_crc32(const uint8_t *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static const uint32_t *profile_keys(void) {
+    if (!atomic_load_explicit(&s_keys_ready, memory_order_acquire)) {
+        /* Two first callers at once compute the same values */
+        for (size_t i = 0; i < CONSOLE_PARAM_COUNT; i++) {
+            s_keys[i] = config_name_hash(CONSOLE_PARAMS[i].full_path, 0);
+        }
+        atomic_store_explicit(&s_keys_ready, true, memory_order_release);
+    }
+    return s_keys;
+}
+
+static const param_descriptor_t *find_key(uint32_t key) {
+    const uint32_t *keys = profile_keys();
+    for (size_t i = 0; i < CONSOLE_PARAM_COUNT; i++) {
+        if (keys[i] == key) {
+            return &CONSOLE_PARAMS[i];
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Export
+ * ============================================================================ */
+
+/** Append one parameter entry, false if it does not fit */
+static bool put_param(uint8_t *out, size_t cap, size_t *pos, size_t i) {
+    const param_descriptor_t *p = &CONSOLE_PARAMS[i];
+    param_value_t v = p->get_fn();
+    uint8_t value[4];
+    const uint8_t *data = value;
+    size_t n;
+
+    switch (p->type) {
+        case PARAM_TYPE_U8:
+        case PARAM_TYPE_ENUM:
+            value[0] = v.u8;
+            n = 1;
+            break;
+        case PARAM_TYPE_BOOL:
+            value[0] = v.b ? 1U : 0U;
+            n = 1;
+            break;
+        case PARAM_TYPE_U16:
+            put_u16(value, v.u16);
+            n = 2;
+            break;
+        case PARAM_TYPE_U32:
+            put_u32(value, v.u32);
+            n = 4;
+            break;
+        case PARAM_TYPE_STRING:
+            data = (const uint8_t *)(v.str ? v.str : "");
+            n = strnlen((const char *)data, UINT8_MAX);
+            break;
+        default:
+            return true;
+    }
+
+    if (*pos + PROFILE_ENTRY_HEAD + n > cap) {
+        return false;
+    }
+    uint8_t *b = &out[*pos];
+    put_u32(b, profile_keys()[i]);
+    b[4] = (uint8_t)p->type;
+    b[5] = (uint8_t)n;
+    memcpy(&b[PROFILE_ENTRY_HEAD], data, n);
+    *pos += PROFILE_ENTRY_HEAD + n;
+    return true;
+}
+
+/** Append a length-prefixed string, false if it does not fit */
+static bool put_str(uint8_t *out, size_t cap, size_t *pos, const char *s, size_t max) {
+    size_t n = strnlen(s, max);
+    if (*pos + 1U + n > cap) {
+        return false;
+    }
+    out[*pos] = (uint8_t)n;
+    memcpy(&out[*pos + 1U], s, n);
+    *pos += 1U + n;
+    return true;
+}
+
+/** Close a section opened at start, false if it grew past u16 */
+static bool end_section(uint8_t *out, size_t start, size_t pos) {
+    size_t len = pos - start - PROFILE_SEC_HEADER;
+    if (len > UINT16_MAX) {
+        return false;
+    }
+    put_u16(&out[start + 2U], (uint16_t)len);
+    return true;
+}
+
+size_t config_profile_export(uint8_t *out, size_t cap) {
+    if (out == NULL || cap < PROFILE_HEADER + 2U * PROFILE_SEC_HEADER) {
+        return 0;
+    }
+    size_t pos = PROFILE_HEADER;
+
+    /* Parameters */
+    size_t start = pos;
+    out[pos] = CONFIG_PROFILE_SEC_PARAMS;
+    out[pos + 1U] = 0;
+    pos += PROFILE_SEC_HEADER;
+    for (size_t i = 0; i < CONSOLE_PARAM_COUNT; i++) {
+        if (!put_param(out, cap, &pos, i)) {
+            return 0;
+        }
+    }
+    if (!end_section(out, start, pos) || pos + PROFILE_SEC_HEADER > cap) {
+        return 0;
+    }
+
+    /* Text memories, empty slots included so they clear on import */
+    start = pos;
+    out[pos] = CONFIG_PROFILE_SEC_MEMORIES;
+    out[pos + 1U] = 0;
+    pos += PROFILE_SEC_HEADER;
+    for (uint8_t i = 0; i < TEXT_MEMORY_SLOTS; i++) {
+        text_memory_slot_t slot;
+        if (text_memory_get(i, &slot) != 0) {
+            slot.text[0] = '\0';
+            slot.label[0] = '\0';
+        }
+        if (!put_str(out, cap, &pos, slot.text, TEXT_MEMORY_MAX_LEN - 1U) ||
+            !put_str(out, cap, &pos, slot.label, TEXT_MEMORY_LABEL_LEN - 1U)) {
+            return 0;
+        }
+    }
+    if (!end_section(out, start, pos)) {
+        return 0;
+    }
+
+    size_t payload = pos - PROFILE_HEADER;
+    put_u32(&out[0], PROFILE_MAGIC);
+    put_u16(&out[4], CONFIG_PROFILE_VERSION);
+    put_u16(&out[6], 2);
+    put_u32(&out[8], (uint32_t)payload);
+    put_u32(&out[12], profile_crc32(&out[PROFILE_HEADER], payload));
+    return pos;
+}
+
+/* ============================================================================
+ * Import
+ * ============================================================================ */
+
+/**
+ * @brief Check one parameter entry against its descriptor
+ *
+ * @return true if the value is acceptable; *v holds it (strings: not
+ *         terminated, see apply_params)
+ */
+static bool check_param(const param_descriptor_t *p, uint8_t type, const uint8_t *data,
+                        size_t n, uint32_t *v) {
+    if (p->type == PARAM_TYPE_STRING) {
+        return type == PARAM_TYPE_STRING && n <= p->max && memchr(data, '\0', n) == NULL;
+    }
+    if (type == PARAM_TYPE_STRING) {
+        return false;
+    }
+
+    /* Width taken from the entry: a parameter may have been widened */
+    if (n == 1U) {
+        *v = data[0];
+    } else if (n == 2U) {
+        *v = get_u16(data);
+    } else if (n == 4U) {
+        *v = get_u32(data);
+    } else {
+        return false;
+    }
+    if (p->type == PARAM_TYPE_BOOL) {
+        return *v <= 1U;
+    }
+    return *v >= p->min && *v <= p->max;
+}
+
+/**
+ * @brief Walk the parameters section: check only, or apply
+ *
+ * @return 0, or CONFIG_PROFILE_ERR_*
+ */
+static int walk_params(const uint8_t *d, size_t len, bool apply, config_profile_result_t *res) {
+    size_t pos = 0;
+    while (pos < len) {
+        if (len - pos < PROFILE_ENTRY_HEAD) {
+            return CONFIG_PROFILE_ERR_FORMAT;
+        }
+        uint32_t key = get_u32(&d[pos]);
+        uint8_t type = d[pos + 4U];
+        size_t n = d[pos + 5U];
+        const uint8_t *data = &d[pos + PROFILE_ENTRY_HEAD];
+        if (len - pos - PROFILE_ENTRY_HEAD < n) {
+            return CONFIG_PROFILE_ERR_FORMAT;
+        }
+        pos += PROFILE_ENTRY_HEAD + n;
+
+        const param_descriptor_t *p = find_key(key);
+        if (p == NULL) {
+            if (apply) {
+                res->skipped++;
+            }
+            continue;
+        }
+
+        uint32_t v = 0;
+        if (!check_param(p, type, data, n, &v)) {
+            res->bad_key = p->full_path;
+            return CONFIG_PROFILE_ERR_VALUE;
+        }
+        if (!apply) {
+            continue;
+        }
+
+        param_value_t pv;
+        char str[UINT8_MAX + 1];
+        switch (p->type) {
+            case PARAM_TYPE_STRING:
+                memcpy(str, data, n);
+                str[n] = '\0';
+                pv.str = str;
+                break;
+            case PARAM_TYPE_BOOL:
+                pv.b = (v != 0U);
+                break;
+            case PARAM_TYPE_U16:
+                pv.u16 = (uint16_t)v;
+                break;
+            case PARAM_TYPE_U32:
+                pv.u32 = v;
+                break;
+            default:
+                pv.u8 = (uint8_t)v;
+                break;
+        }
+        p->set_fn(pv);
+        res->applied++;
+    }
+    return 0;
+}
+
+/** Parse the memories section into s_mem */
+static int parse_memories(const uint8_t *d, size_t len) {
+    size_t pos = 0;
+    for (uint8_t i = 0; i < TEXT_MEMORY_SLOTS; i++) {
+        char *fields[2] = { s_mem[i].text, s_mem[i].label };
+        const size_t caps[2] = { TEXT_MEMORY_MAX_LEN, TEXT_MEMORY_LABEL_LEN };
+        for (int f = 0; f < 2; f++) {
+            if (pos >= len) {
+                return CONFIG_PROFILE_ERR_MEMORY;
+            }
+            size_t n = d[pos++];
+            if (n >= caps[f] || len - pos < n || memchr(&d[pos], '\0', n) != NULL) {
+                return CONFIG_PROFILE_ERR_MEMORY;
+            }
+            memcpy(fields[f], &d[pos], n);
+            fields[f][n] = '\0';
+            pos += n;
+        }
+    }
+    return (pos == len) ? 0 : CONFIG_PROFILE_ERR_MEMORY;
+}
+
+/**
+ * @brief Check the header and every section
+ *
+ * @param params Parameters section (NULL if absent)
+ * @param memories Whether a memories section was parsed into s_mem
+ */
+static int profile_check(const uint8_t *data, size_t len, const uint8_t **params,
+                         size_t *params_len, bool *memories, config_profile_result_t *res) {
+    if (data == NULL || len < PROFILE_HEADER || get_u32(&data[0]) != PROFILE_MAGIC) {
+        return CONFIG_PROFILE_ERR_FORMAT;
+    }
+    if (get_u16(&data[4]) > CONFIG_PROFILE_VERSION) {
+        return CONFIG_PROFILE_ERR_VERSION;
+    }
+    size_t payload = get_u32(&data[8]);
+    if (payload != len - PROFILE_HEADER) {
+        return CONFIG_PROFILE_ERR_FORMAT;
+    }
+    const uint8_t *d = &data[PROFILE_HEADER];
+    if (get_u32(&data[12]) != profile_crc32(d, payload)) {
+        return CONFIG_PROFILE_ERR_CRC;
+    }
+
+    unsigned sections = get_u16(&data[6]);
+    size_t pos = 0;
+    for (unsigned s = 0; s < sections; s++) {
+        if (payload - pos < PROFILE_SEC_HEADER) {
+            return CONFIG_PROFILE_ERR_FORMAT;
+        }
+        uint8_t id = d[pos];
+        size_t n = get_u16(&d[pos + 2U]);
+        pos += PROFILE_SEC_HEADER;
+        if (payload - pos < n) {
+            return CONFIG_PROFILE_ERR_FORMAT;
+        }
+
+        int err = 0;
+        if (id == CONFIG_PROFILE_SEC_PARAMS) {
+            err = walk_params(&d[pos], n, false, res);
+            *params = &d[pos];
+            *params_len = n;
+        } else if (id == CONFIG_PROFILE_SEC_MEMORIES) {
+            err = parse_memories(&d[pos], n);
+            *memories = true;
+        }
+        /* Other ids: written by a later firmware, skipped */
+        if (err != 0) {
+            return err;
+        }
+        pos += n;
+    }
+    return (pos == payload) ? 0 : CONFIG_PROFILE_ERR_FORMAT;
+}
+
+int config_profile_import(const uint8_t *data, size_t len, config_profile_result_t *res) {
+    config_profile_result_t local;
+    if (res == NULL) {
+        res = &local;
+    }
+    memset(res, 0, sizeof(*res));
+
+    if (atomic_exchange_explicit(&s_importing, true, memory_order_acquire)) {
+        return CONFIG_PROFILE_ERR_BUSY;
+    }
+
+    const uint8_t *params = NULL;
+    size_t params_len = 0;
+    bool memories = false;
+    int err = profile_check(data, len, &params, &params_len, &memories, res);
+
+    if (err == 0 && params != NULL) {
+        walk_params(params, params_len, true, res);
+        if (res->applied > 0) {
+            config_bump_generation(&g_config);
+            config_persist_request();
+        }
+    }
+    if (err == 0 && memories) {
+        res->memories = TEXT_MEMORY_SLOTS;
+        if (text_memory_replace_all(s_mem) != 0) {
+            err = CONFIG_PROFILE_ERR_SAVE;
+        }
+    }
+
+    atomic_store_explicit(&s_importing, false, memory_order_release);
+    return err;
+}
+
+const char *config_profile_strerror(int err) {
+    switch (err) {
+        case 0:                          return "OK";
+        case CONFIG_PROFILE_ERR_FORMAT:  return "Not a profile or truncated";
+        case CONFIG_PROFILE_ERR_CRC:     return "Checksum mismatch";
+        case CONFIG_PROFILE_ERR_VERSION: return "Profile from a newer firmware";
+        case CONFIG_PROFILE_ERR_VALUE:   return "Invalid value";
+        case CONFIG_PROFILE_ERR_MEMORY:  return "Malformed text memories";
+        case CONFIG_PROFILE_ERR_BUSY:    return "Import in progress";
+        case CONFIG_PROFILE_ERR_SAVE:    return "Text memories not saved";
+        default:                         return "Error";
+    }
+}
@@ -1,9 +1,25 @@
 /**
  * @file text_keyer.c
  * @brief Text-to-Morse keyer implementation
+ *
+ * text_keyer_send() appends to the type-ahead queue; text_keyer_tick()
+ * (bg_task) pops it a few characters ahead of playback and compiles it
+ * into the run-length schedule; the RT task plays it tick by tick with
+ * text_keyer_rt_tick(). The bg side never times an element itself.
+ *
+ * Memories: text_keyer_send_memory() expands the slot's compiled macro
+ * into s_send.play and, when nothing else is waiting, compiles the first
+ * runs into the schedule itself, so the RT task keys the first element
+ * on its next tick instead of after the next bg tick. The schedule still
+ * has one producer at a time: whoever holds s_producer (the bg tick or
+ * the sending task) owns s_send and the write side of the schedule.
  */
 
 #include "text_keyer.h"
+#include "text_schedule.h"
+#include "text_typeahead.h"
+#include "text_memory.h"
+#include "text_macro.h"
 #include "morse_table.h"
 #include "config.h"
 #include <string.h>
@@ -13,23 +29,35 @@
  * Internal Types
  * ============================================================================ */
 
-typedef enum {
-    ELEMENT_DIT,
-    ELEMENT_DAH,
-    ELEMENT_INTRA_GAP,
-    ELEMENT_CHAR_GAP,
-    ELEMENT_WORD_GAP,
-} element_type_t;
+/** Runs one character can add: a gap before each element plus the element */
+#define RUNS_PER_CHAR (2U * MORSE_MAX_ELEMENTS)
+
+/**
+ * Runs compiled ahead of playback. Kept short so text still in the
+ * type-ahead queue can be cancelled until shortly before it is sent.
+ */
+#define TEXT_KEYER_LEAD_RUNS 32U
+
+/** Characters held to recognise a prosign tag ("<SOS>" plus margin) */
+#define TEXT_KEYER_LOOKAHEAD 8U
+
+_Static_assert(TEXT_KEYER_LEAD_RUNS + RUNS_PER_CHAR <= TEXT_SCHEDULE_CAPACITY,
+               "compile lead must fit the schedule");
 
 typedef struct {
-    char text[TEXT_KEYER_MAX_LEN];
-    size_t text_len;
-    size_t char_index;
-    const char *current_pattern;
-    size_t pattern_index;
-    element_type_t element;
-    int64_t element_end_us;
-    bool key_down;
+    char look[TEXT_KEYER_LOOKAHEAD + 1]; /* Popped, not yet compiled (NUL-terminated) */
+    size_t look_len;
+    size_t popped;             /* Characters taken from the queue this burst */
+    size_t consumed;           /* Characters compiled this burst */
+    bool active;               /* A burst is in progress (counters valid) */
+    uint32_t gap_us;           /* Key-up time owed before the next element */
+    uint32_t idle_us;          /* Part of gap_us already spent with the schedule idle */
+    bool after_char;           /* gap_us is the char gap of the last character */
+    bool was_idle;             /* Schedule was idle on the previous tick */
+    int64_t last_tick_us;
+    text_macro_token_t play[TEXT_MACRO_MAX_EXPANDED]; /* Expanded memory being compiled */
+    size_t play_len;
+    size_t play_pos;           /* Next token of play to compile */
 } send_state_t;
 
 /* ============================================================================
@@ -37,141 +65,239 @@ typedef struct {
  * ============================================================================ */
 
 static const atomic_bool *s_paddle_abort = NULL;
-static text_keyer_state_t s_state = TEXT_KEYER_IDLE;
 static send_state_t s_send = {0};
 
-/* Atomic key state for RT task polling (Core 0 reads, Core 1 writes) */
+/* Text waiting to be compiled (any task appends, text_keyer_tick pops) */
+static text_typeahead_t s_typeahead;
+
+/* Compiled runs, played by the RT task (Core 1 writes, Core 0 reads) */
+static text_schedule_t s_schedule;
+
+/* Characters held in s_send.look, for other readers of the state */
+static atomic_bool s_compiling = ATOMIC_VAR_INIT(false);
+
+/* Level of the last RT tick, for other readers */
 static atomic_bool s_key_down = ATOMIC_VAR_INIT(false);
 
+/* Producer side of s_send and s_schedule is taken (bg tick or memory send) */
+static atomic_bool s_producer = ATOMIC_VAR_INIT(false);
+
 /* ============================================================================
  * Timing Helpers
  * ============================================================================ */
 
-static int64_t dit_duration_us(void) {
+static uint32_t dit_duration_us(void) {
     uint32_t wpm = CONFIG_GET_WPM();
     if (wpm < 5) wpm = 5;
     if (wpm > 60) wpm = 60;
-    return 1200000 / (int64_t)wpm;
+    return 1200000U / wpm;
 }
 
-/* ============================================================================
- * Key State Management
- * ============================================================================ */
+static bool producer_acquire(void) {
+    bool expected = false;
+    return atomic_compare_exchange_strong_explicit(&s_producer, &expected, true,
+                                                   memory_order_acquire, memory_order_relaxed);
+}
 
-static void set_key_down(bool key_down) {
-    atomic_store_explicit(&s_key_down, key_down, memory_order_release);
+static void producer_release(void) {
+    atomic_store_explicit(&s_producer, false, memory_order_release);
 }
 
 /* ============================================================================
  * Pattern Navigation
  * ============================================================================ */
 
-static const char *get_next_pattern(void) {
-    while (s_send.char_index < s_send.text_len) {
-        char c = s_send.text[s_send.char_index];
+/**
+ * @brief Pop the next character, or a whole prosign tag, into the lookahead
+ *
+ * Characters stay in the type-ahead queue (cancellable) until the one
+ * that is about to be compiled; only a '<' pulls in what follows it.
+ */
+static void fill_lookahead(void) {
+    char c;
+    while (s_send.look_len < TEXT_KEYER_LOOKAHEAD) {
+        if (s_send.look_len > 0 &&
+            (s_send.look[0] != '<' || s_send.look[s_send.look_len - 1] == '>')) {
+            break;
+        }
+        if (!text_typeahead_pop(&s_typeahead, &c)) {
+            break;
+        }
+        s_send.look[s_send.look_len++] = c;
+        s_send.popped++;
+    }
+    s_send.look[s_send.look_len] = '\0';
+}
+
+/** Drop n compiled characters from the front of the lookahead */
+static void consume(size_t n) {
+    s_send.look_len -= n;
+    memmove(s_send.look, &s_send.look[n], s_send.look_len + 1U);
+    s_send.consumed += n;
+}
+
+/**
+ * @brief Code of the next character to send
+ *
+ * @param word_gap Set when the next item is a word gap instead
+ * @return Code, or MORSE_CODE_INVALID when nothing is ready or for a gap
+ */
+static morse_code_t get_next_code(bool *word_gap) {
+    *word_gap = false;
+
+    /* A memory being played goes first: already codes, no lookup */
+    if (s_send.play_pos < s_send.play_len) {
+        text_macro_token_t tok = s_send.play[s_send.play_pos++];
+        s_send.consumed++;
+        if (tok == TEXT_MACRO_WORD_GAP) {
+            *word_gap = true;
+            return MORSE_CODE_INVALID;
+        }
+        return tok;
+    }
+
+    for (;;) {
+        fill_lookahead();
+        if (s_send.look_len == 0) {
+            return MORSE_CODE_INVALID;
+        }
+        char c = s_send.look[0];
 
         /* Check for prosign */
         if (c == '<') {
-            const char *pattern = NULL;
-            size_t len = morse_match_prosign(&s_send.text[s_send.char_index], &pattern);
-            if (len > 0 && pattern != NULL) {
-                s_send.char_index += len;
-                return pattern;
+            morse_code_t code = MORSE_CODE_INVALID;
+            size_t len = morse_match_prosign_code(s_send.look, &code);
+            if (len > 0) {
+                consume(len);
+                return code;
+            }
+            /* Rest of the tag may still be typed while earlier text plays */
+            if (s_send.look[s_send.look_len - 1] != '>' &&
+                s_send.look_len < TEXT_KEYER_LOOKAHEAD &&
+                !text_schedule_idle(&s_schedule)) {
+                return MORSE_CODE_INVALID;
             }
         }
 
         /* Space = word gap */
         if (c == ' ') {
-            s_send.char_index++;
-            return " ";  /* Special marker for word gap */
+            consume(1);
+            *word_gap = true;
+            return MORSE_CODE_INVALID;
         }
 
-        /* Regular character */
-        const char *pattern = morse_table_reverse(c);
-        s_send.char_index++;
+        /* Regular character: one table index, no search */
+        morse_code_t code = morse_code_encode(c);
+        consume(1);
 
-        if (pattern != NULL) {
-            return pattern;
+        if (code != MORSE_CODE_INVALID) {
+            return code;
         }
         /* Skip unknown characters */
     }
-    return NULL;
 }
 
-static bool start_next_element(int64_t now_us) {
-    int64_t dit_us = dit_duration_us();
-
-    /* Need new pattern? */
-    if (s_send.current_pattern == NULL ||
-        s_send.current_pattern[s_send.pattern_index] == '\0') {
-
-        /* Char gap before next character (unless first or word gap) */
-        if (s_send.current_pattern != NULL &&
-            s_send.current_pattern[0] != ' ') {
-            s_send.element = ELEMENT_CHAR_GAP;
-            s_send.element_end_us = now_us + (dit_us * 3);
-            s_send.key_down = false;
-            set_key_down(false);
-        }
-
-        s_send.current_pattern = get_next_pattern();
-        s_send.pattern_index = 0;
-
-        if (s_send.current_pattern == NULL) {
-            return false;  /* Done */
-        }
-
-        /* Word gap */
-        if (s_send.current_pattern[0] == ' ') {
-            s_send.element = ELEMENT_WORD_GAP;
-            s_send.element_end_us = now_us + (dit_us * 7);
-            s_send.key_down = false;
-            set_key_down(false);
-            s_send.current_pattern = NULL;  /* Force get next pattern */
-            return true;
-        }
+/* ============================================================================
+ * Schedule Compilation
+ * ============================================================================ */
 
-        /* Skip char gap if we just set one */
-        if (s_send.element == ELEMENT_CHAR_GAP) {
-            return true;
-        }
+/** Queue one element, after the gap owed before it */
+static void push_element(bool dah, uint32_t dit_us) {
+    uint32_t pos = (uint32_t)s_send.consumed & TEXT_SCHEDULE_MAX_POS;
+    /* Time the schedule already sat idle counts towards the gap */
+    uint32_t gap = (s_send.gap_us > s_send.idle_us) ? s_send.gap_us - s_send.idle_us : 0U;
+    if (gap > 0) {
+        (void)text_schedule_push(&s_schedule, text_run_make(false, gap, pos));
     }
+    (void)text_schedule_push(&s_schedule, text_run_make(true, dah ? dit_us * 3U : dit_us, pos));
+    s_send.gap_us = dit_us;  /* Intra-character gap unless the character ends */
+    s_send.idle_us = 0;
+    s_send.after_char = false;
+}
 
-    /* Send dit or dah */
-    char elem = s_send.current_pattern[s_send.pattern_index++];
-
-    if (elem == '.') {
-        s_send.element = ELEMENT_DIT;
-        s_send.element_end_us = now_us + dit_us;
-    } else if (elem == '-') {
-        s_send.element = ELEMENT_DAH;
-        s_send.element_end_us = now_us + (dit_us * 3);
-    } else {
-        return start_next_element(now_us);  /* Skip invalid */
+/**
+ * @brief Compile the next character or word gap
+ *
+ * Needs RUNS_PER_CHAR free runs. Speed is read per character, so a WPM
+ * change applies a few characters ahead of where playback is.
+ *
+ * @return false when nothing is ready to compile
+ */
+static bool compile_next(void) {
+    uint32_t dit_us = dit_duration_us();
+
+    bool word_gap;
+    morse_code_t code = get_next_code(&word_gap);
+
+    if (word_gap) {
+        /* A word gap replaces the char gap before it; more spaces add up */
+        uint32_t gap = s_send.after_char ? 0U : s_send.gap_us;
+        gap += dit_us * 7U;
+        s_send.gap_us = (gap > TEXT_SCHEDULE_MAX_RUN_US) ? TEXT_SCHEDULE_MAX_RUN_US : gap;
+        s_send.after_char = false;
+        return true;
+    }
+    if (code == MORSE_CODE_INVALID) {
+        return false;
     }
 
-    s_send.key_down = true;
-    set_key_down(true);
+    /* First element in the highest bit */
+    for (unsigned left = morse_code_len(code); left > 0; left--) {
+        push_element(((code >> (left - 1U)) & 1U) != 0, dit_us);
+    }
+    s_send.gap_us = dit_us * 3U;
+    s_send.after_char = true;
     return true;
 }
 
-static void finish_element(int64_t now_us) {
-    int64_t dit_us = dit_duration_us();
-
-    if (s_send.key_down) {
-        s_send.key_down = false;
-        set_key_down(false);
+/** Compile ahead up to the lead */
+static void compile_ahead(void) {
+    while (TEXT_SCHEDULE_CAPACITY - text_schedule_space(&s_schedule) < TEXT_KEYER_LEAD_RUNS) {
+        if (!compile_next()) {
+            break;
+        }
+    }
+    atomic_store_explicit(&s_compiling, s_send.look_len > 0 || s_send.play_pos < s_send.play_len,
+                          memory_order_release);
+}
 
-        /* Intra-element gap if more elements in pattern */
-        if (s_send.current_pattern != NULL &&
-            s_send.current_pattern[s_send.pattern_index] != '\0') {
-            s_send.element = ELEMENT_INTRA_GAP;
-            s_send.element_end_us = now_us + dit_us;
-            return;
+/** Track how long the schedule has been idle with a gap owed */
+static void track_idle(int64_t now_us) {
+    bool idle = text_schedule_idle(&s_schedule);
+    if (idle && s_send.was_idle && s_send.idle_us < s_send.gap_us) {
+        int64_t elapsed = now_us - s_send.last_tick_us;
+        if (elapsed > 0) {
+            uint32_t left = s_send.gap_us - s_send.idle_us;
+            s_send.idle_us += ((uint64_t)elapsed < left) ? (uint32_t)elapsed : left;
         }
     }
+    s_send.was_idle = idle;
+    s_send.last_tick_us = now_us;
+}
+
+/** New burst after idle: progress counts from here */
+static void start_burst(void) {
+    if (!s_send.active) {
+        s_send.active = true;
+        s_send.popped = 0;
+        s_send.consumed = 0;
+    }
+}
 
-    s_send.element_end_us = 0;
+/** Retire everything queued (abort, paddle) */
+static void drop_all(void) {
+    text_typeahead_clear(&s_typeahead);
+    text_schedule_flush(&s_schedule);
+    text_schedule_set_paused(&s_schedule, false);
+    s_send.look_len = 0;
+    s_send.look[0] = '\0';
+    s_send.play_len = 0;
+    s_send.play_pos = 0;
+    s_send.gap_us = 0;
+    s_send.idle_us = 0;
+    s_send.after_char = false;
+    s_send.active = false;
+    atomic_store_explicit(&s_compiling, false, memory_order_release);
 }
 
 /* ============================================================================
@@ -184,9 +310,11 @@ int text_keyer_init(const text_keyer_config_t *config) {
     }
 
     s_paddle_abort = config->paddle_abort;
-    s_state = TEXT_KEYER_IDLE;
-    set_key_down(false);
     memset(&s_send, 0, sizeof(s_send));
+    text_typeahead_init(&s_typeahead);
+    text_schedule_init(&s_schedule);
+    atomic_store_explicit(&s_compiling, false, memory_order_release);
+    atomic_store_explicit(&s_key_down, false, memory_order_release);
 
     return 0;
 }
@@ -196,97 +324,169 @@ int text_keyer_send(const char *text) {
         return -1;
     }
 
-    if (s_state != TEXT_KEYER_IDLE) {
+    /* An abort being retired would drop the new text with the old */
+    if (text_schedule_stop_pending(&s_schedule)) {
         return -1;
     }
 
-    size_t len = strlen(text);
-    if (len >= TEXT_KEYER_MAX_LEN) {
-        len = TEXT_KEYER_MAX_LEN - 1;
+    /* Compiled by text_keyer_tick() behind whatever is queued already */
+    return text_typeahead_append(&s_typeahead, text, strlen(text)) ? 0 : -1;
+}
+
+int text_keyer_send_memory(uint8_t slot) {
+    const text_macro_t *macro = text_memory_macro(slot);
+    if (macro == NULL || macro->len == 0) {
+        return -1;
+    }
+    if (text_schedule_stop_pending(&s_schedule)) {
+        return -1;
     }
 
-    memset(&s_send, 0, sizeof(s_send));
-    memcpy(s_send.text, text, len);
-    s_send.text[len] = '\0';
-    s_send.text_len = len;
+    text_macro_values_t values;
+    text_macro_get_values(&values);
+    strncpy(values.mycall, CONFIG_GET_CALLSIGN(), sizeof(values.mycall) - 1);
+    values.mycall[sizeof(values.mycall) - 1] = '\0';
+
+    int ret = -1;
+    bool played = false;
+    if (producer_acquire()) {
+        /* Only when nothing is waiting to be compiled, or it would jump the queue */
+        if (s_send.look_len == 0 && s_send.play_pos == s_send.play_len &&
+            text_typeahead_empty(&s_typeahead)) {
+            s_send.play_len = text_macro_expand(macro, &values, s_send.play, TEXT_MACRO_MAX_EXPANDED);
+            s_send.play_pos = 0;
+            start_burst();
+            s_send.popped += s_send.play_len;
+            compile_ahead();
+            played = true;
+            ret = 0;
+        }
+        producer_release();
+    }
 
-    /* Count actual characters (excluding spaces and prosign brackets) */
-    s_send.char_index = 0;
+    if (!played) {
+        /* Behind queued text: goes through the type-ahead, fields filled now */
+        text_memory_slot_t mem;
+        char text[TEXT_MACRO_MAX_EXPANDED + 1];
+        if (text_memory_get(slot, &mem) == 0 &&
+            text_macro_render(mem.text, &values, text, sizeof(text)) > 0) {
+            ret = text_keyer_send(text);
+        }
+    }
 
-    s_state = TEXT_KEYER_SENDING;
-    return 0;
+    if (ret == 0 && text_macro_has_field(macro, TEXT_MACRO_SERIAL)) {
+        text_macro_next_serial();
+    }
+    return ret;
 }
 
-void text_keyer_abort(void) {
-    if (s_state == TEXT_KEYER_IDLE) return;
+size_t text_keyer_cancel_last(bool whole_message) {
+    return text_typeahead_cancel_last(&s_typeahead, whole_message ? TEXT_TYPEAHEAD_CANCEL_MESSAGE
+                                                                  : TEXT_TYPEAHEAD_CANCEL_CHAR);
+}
 
-    /* Always ensure key is released on abort */
-    set_key_down(false);
+void text_keyer_abort(void) {
+    if (text_keyer_get_state() == TEXT_KEYER_IDLE) return;
 
-    s_state = TEXT_KEYER_IDLE;
-    memset(&s_send, 0, sizeof(s_send));
+    /* Key released on the next RT tick; text_keyer_tick() retires the text */
+    text_schedule_stop(&s_schedule);
 }
 
 void text_keyer_pause(void) {
-    if (s_state != TEXT_KEYER_SENDING) return;
-
-    if (s_send.key_down) {
-        set_key_down(false);
-        s_send.key_down = false;
-    }
+    if (text_keyer_get_state() != TEXT_KEYER_SENDING) return;
 
-    s_state = TEXT_KEYER_PAUSED;
+    text_schedule_set_paused(&s_schedule, true);
 }
 
 void text_keyer_resume(void) {
-    if (s_state != TEXT_KEYER_PAUSED) return;
+    if (text_keyer_get_state() != TEXT_KEYER_PAUSED) return;
 
-    s_send.element_end_us = 0;  /* Restart timing */
-    s_state = TEXT_KEYER_SENDING;
+    /* The interrupted run continues with the time it had left */
+    text_schedule_set_paused(&s_schedule, false);
 }
 
 text_keyer_state_t text_keyer_get_state(void) {
-    return s_state;
+    bool busy = atomic_load_explicit(&s_compiling, memory_order_acquire) ||
+                !text_typeahead_empty(&s_typeahead) ||
+                !text_schedule_idle(&s_schedule) ||
+                text_schedule_stop_pending(&s_schedule);
+    if (!busy) {
+        return TEXT_KEYER_IDLE;
+    }
+    return text_schedule_paused(&s_schedule) ? TEXT_KEYER_PAUSED : TEXT_KEYER_SENDING;
 }
 
 void text_keyer_get_progress(size_t *sent, size_t *total) {
+    size_t consumed = s_send.consumed;
     if (sent != NULL) {
-        *sent = s_send.char_index;
+        if (text_schedule_idle(&s_schedule)) {
+            *sent = consumed;
+        } else {
+            /* Runs carry the low bits of the position they were compiled at */
+            size_t behind = (consumed - text_schedule_pos(&s_schedule)) & TEXT_SCHEDULE_MAX_POS;
+            *sent = consumed - behind;
+        }
     }
     if (total != NULL) {
-        *total = s_send.text_len;
+        text_typeahead_status_t st;
+        text_typeahead_get_status(&s_typeahead, &st);
+        *total = s_send.popped + st.queued;
     }
 }
 
+void text_keyer_get_buffer(text_keyer_buffer_t *out) {
+    if (out == NULL) return;
+
+    text_typeahead_status_t st;
+    text_typeahead_get_status(&s_typeahead, &st);
+    out->queued = st.queued;
+    out->free = st.free;
+    out->capacity = st.capacity;
+    out->rejected = st.rejected;
+}
+
 void text_keyer_tick(int64_t now_us) {
-    if (s_state != TEXT_KEYER_SENDING) return;
+    /* A memory send is compiling its first runs: try again next tick */
+    if (!producer_acquire()) {
+        return;
+    }
+
+    bool busy = s_send.look_len > 0 || s_send.play_pos < s_send.play_len ||
+                !text_typeahead_empty(&s_typeahead) || !text_schedule_idle(&s_schedule);
 
-    /* Check paddle abort */
-    if (s_paddle_abort != NULL &&
+    /* Check paddle abort (the RT player also stops on the paddle itself) */
+    if (busy && s_paddle_abort != NULL &&
         atomic_load_explicit(s_paddle_abort, memory_order_acquire)) {
-        text_keyer_abort();
-        return;
+        text_schedule_stop(&s_schedule);
     }
 
-    /* First tick - start first element */
-    if (s_send.element_end_us == 0) {
-        if (!start_next_element(now_us)) {
-            s_state = TEXT_KEYER_IDLE;
+    if (text_schedule_stop_pending(&s_schedule)) {
+        /* Abort or paddle: drop what is queued, key is already up */
+        drop_all();
+    } else {
+        track_idle(now_us);
+        if (!busy) {
+            s_send.active = false;
+        } else {
+            start_burst();
+            compile_ahead();
         }
-        return;
     }
+    producer_release();
+}
 
-    /* Check if current element finished */
-    if (now_us >= s_send.element_end_us) {
-        finish_element(now_us);
+bool text_keyer_rt_tick(uint32_t tick_us, bool paddle_active) {
+    bool key_down = text_schedule_play(&s_schedule, tick_us, paddle_active);
+    atomic_store_explicit(&s_key_down, key_down, memory_order_release);
+    return key_down;
+}
 
-        if (s_send.element_end_us == 0) {
-            if (!start_next_element(now_us)) {
-                s_state = TEXT_KEYER_IDLE;
-                set_key_down(false);  /* Ensure key released when done */
-            }
-        }
-    }
+uint32_t text_keyer_rt_until_key_us(uint32_t limit_us) {
+    return text_schedule_until_key_us(&s_schedule, limit_us);
+}
+
+void text_keyer_rt_hold(bool hold) {
+    text_schedule_hold(&s_schedule, hold);
 }
 
 bool text_keyer_is_key_down(void) {
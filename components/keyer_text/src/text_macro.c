@@ -0,0 +1,216 @@
+/**
+ * @file text_macro.c
+ * @brief Contest macro compiler and field values
+ */
+
+#include "text_macro.h"
+#include "morse_table.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+/* ============================================================================
+ * Field Values
+ * ============================================================================ */
+
+static const char *const FIELD_NAMES[TEXT_MACRO_FIELD_COUNT] = {
+    "SERIAL", "CALL", "MYCALL", "RST",
+};
+
+#define DEFAULT_RST "599"
+
+/* Text fields, written under an odd sequence */
+static struct {
+    atomic_uint seq;
+    char call[TEXT_MACRO_FIELD_LEN];
+    char rst[TEXT_MACRO_FIELD_LEN];
+} s_fields = { .rst = DEFAULT_RST };
+
+static atomic_uint s_serial = ATOMIC_VAR_INIT(1);
+
+const char *text_macro_field_name(text_macro_field_t f) {
+    return ((unsigned)f < TEXT_MACRO_FIELD_COUNT) ? FIELD_NAMES[f] : NULL;
+}
+
+uint32_t text_macro_serial(void) {
+    return atomic_load_explicit(&s_serial, memory_order_relaxed);
+}
+
+void text_macro_set_serial(uint32_t serial) {
+    atomic_store_explicit(&s_serial, serial, memory_order_relaxed);
+}
+
+void text_macro_next_serial(void) {
+    atomic_fetch_add_explicit(&s_serial, 1U, memory_order_relaxed);
+}
+
+bool text_macro_set_field(text_macro_field_t f, const char *value) {
+    char *dst;
+    if (f == TEXT_MACRO_CALL) {
+        dst = s_fields.call;
+    } else if (f == TEXT_MACRO_RST) {
+        dst = s_fields.rst;
+    } else {
+        return false;
+    }
+    if (value == NULL || value[0] == '\0') {
+        value = (f == TEXT_MACRO_RST) ? DEFAULT_RST : "";
+    }
+
+    atomic_fetch_add_explicit(&s_fields.seq, 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    strncpy(dst, value, TEXT_MACRO_FIELD_LEN - 1);
+    dst[TEXT_MACRO_FIELD_LEN - 1] = '\0';
+    atomic_fetch_add_explicit(&s_fields.seq, 1U, memory_order_release);
+    return true;
+}
+
+void text_macro_get_values(text_macro_values_t *v) {
+    unsigned seq;
+    do {
+        seq = atomic_load_explicit(&s_fields.seq, memory_order_acquire);
+        memcpy(v->call, s_fields.call, sizeof(v->call));
+        memcpy(v->rst, s_fields.rst, sizeof(v->rst));
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1U) != 0 ||
+             atomic_load_explicit(&s_fields.seq, memory_order_relaxed) != seq);
+    v->call[TEXT_MACRO_FIELD_LEN - 1] = '\0';
+    v->rst[TEXT_MACRO_FIELD_LEN - 1] = '\0';
+    v->serial = text_macro_serial();
+}
+
+/* ============================================================================
+ * Compiler
+ * ============================================================================ */
+
+/**
+ * @brief Field named by the "{NAME}" at text
+ *
+ * @return Tag length, 0 if text does not start with a field tag
+ */
+static size_t match_field(const char *text, text_macro_field_t *out) {
+    if (text[0] != '{') {
+        return 0;
+    }
+    for (unsigned f = 0; f < TEXT_MACRO_FIELD_COUNT; f++) {
+        size_t n = strlen(FIELD_NAMES[f]);
+        size_t i = 0;
+        while (i < n && toupper((unsigned char)text[1 + i]) == FIELD_NAMES[f][i]) {
+            i++;
+        }
+        if (i == n && text[1 + n] == '}') {
+            *out = (text_macro_field_t)f;
+            return n + 2;
+        }
+    }
+    return 0;
+}
+
+void text_macro_compile(text_macro_t *m, const char *text) {
+    m->len = 0;
+    m->fields = 0;
+    if (text == NULL) {
+        return;
+    }
+
+    const char *p = text;
+    while (*p != '\0' && m->len < TEXT_MACRO_MAX_TOKENS) {
+        text_macro_field_t f;
+        size_t n = match_field(p, &f);
+        if (n > 0) {
+            m->tok[m->len++] = TEXT_MACRO_FIELD(f);
+            m->fields = (uint16_t)(m->fields | (1U << f));
+            p += n;
+            continue;
+        }
+
+        morse_code_t code = MORSE_CODE_INVALID;
+        if (*p == '<') {
+            n = morse_match_prosign_code(p, &code);
+            if (n > 0) {
+                m->tok[m->len++] = code;
+                p += n;
+                continue;
+            }
+        }
+
+        if (*p == ' ') {
+            m->tok[m->len++] = TEXT_MACRO_WORD_GAP;
+        } else {
+            /* Unknown characters (braces too) are dropped, as when typed */
+            code = morse_code_encode(*p);
+            if (code != MORSE_CODE_INVALID) {
+                m->tok[m->len++] = code;
+            }
+        }
+        p++;
+    }
+}
+
+/* ============================================================================
+ * Expansion
+ * ============================================================================ */
+
+/** Value of a field as text */
+static const char *field_text(text_macro_field_t f, const text_macro_values_t *v,
+                              char *buf, size_t cap) {
+    switch (f) {
+        case TEXT_MACRO_SERIAL:
+            snprintf(buf, cap, "%03lu", (unsigned long)v->serial);
+            return buf;
+        case TEXT_MACRO_CALL:
+            return v->call;
+        case TEXT_MACRO_MYCALL:
+            return v->mycall;
+        case TEXT_MACRO_RST:
+            return v->rst;
+        default:
+            return "";
+    }
+}
+
+size_t text_macro_expand(const text_macro_t *m, const text_macro_values_t *v,
+                         text_macro_token_t *out, size_t cap) {
+    size_t n = 0;
+    char buf[TEXT_MACRO_FIELD_LEN];
+
+    for (size_t i = 0; i < m->len && n < cap; i++) {
+        int f = text_macro_token_field(m->tok[i]);
+        if (f < 0) {
+            out[n++] = m->tok[i];
+            continue;
+        }
+        for (const char *c = field_text((text_macro_field_t)f, v, buf, sizeof(buf));
+             *c != '\0' && n < cap; c++) {
+            morse_code_t code = morse_code_encode(*c);
+            if (code != MORSE_CODE_INVALID) {
+                out[n++] = code;
+            }
+        }
+    }
+    return n;
+}
+
+size_t text_macro_render(const char *text, const text_macro_values_t *v, char *out, size_t cap) {
+    size_t n = 0;
+    char buf[TEXT_MACRO_FIELD_LEN];
+
+    if (cap == 0) {
+        return 0;
+    }
+    while (text != NULL && *text != '\0' && n + 1 < cap) {
+        text_macro_field_t f;
+        size_t len = match_field(text, &f);
+        if (len == 0) {
+            out[n++] = *text++;
+            continue;
+        }
+        for (const char *c = field_text(f, v, buf, sizeof(buf)); *c != '\0' && n + 1 < cap; c++) {
+            out[n++] = *c;
+        }
+        text += len;
+    }
+    out[n] = '\0';
+    return n;
+}
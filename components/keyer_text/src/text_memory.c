@@ -1,28 +1,43 @@
 /**
  * @file text_memory.c
  * @brief Memory slots implementation (NVS persistence)
+ *
+ * Edits only mark their slot dirty and ask the persistence worker for a
+ * commit (config_persist_request()); the worker writes the dirty slots,
+ * and just those, once the keyer is idle. A slot edited while it is being
+ * written is marked again and goes out with the next commit.
  */
 
 #include "text_memory.h"
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdatomic.h>
 
 #ifdef CONFIG_IDF_TARGET
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_log.h"
+#include "config_persist.h"
+#include "esp_attr.h"
 static const char *TAG = "text_mem";
 #define NVS_NAMESPACE "text_mem"
+#else
+#define EXT_RAM_BSS_ATTR
 #endif
 
 /* ============================================================================
  * Module State
  * ============================================================================ */
 
-static text_memory_slot_t s_slots[TEXT_MEMORY_SLOTS];
+/* Core 1 only (text keyer, console, web UI): PSRAM */
+static EXT_RAM_BSS_ATTR text_memory_slot_t s_slots[TEXT_MEMORY_SLOTS];
+static EXT_RAM_BSS_ATTR text_macro_t s_macros[TEXT_MEMORY_SLOTS];
 static bool s_initialized = false;
 
+/* Slots changed since they were last written, bit per slot */
+static atomic_uint s_dirty = ATOMIC_VAR_INIT(0);
+
 /* Default messages */
 static const text_memory_slot_t DEFAULT_SLOTS[] = {
     { .text = "CQ CQ CQ DE IU3QEZ IU3QEZ K", .label = "CQ" },
@@ -35,6 +50,35 @@ static const text_memory_slot_t DEFAULT_SLOTS[] = {
     { .text = "", .label = "" },
 };
 
+_Static_assert(TEXT_MACRO_MAX_TOKENS >= TEXT_MEMORY_MAX_LEN,
+               "a compiled slot must hold one token per character");
+
+/** Recompile every slot (after a load or a bulk change) */
+static void compile_all(void) {
+    for (uint8_t i = 0; i < TEXT_MEMORY_SLOTS; i++) {
+        text_macro_compile(&s_macros[i], s_slots[i].text);
+    }
+}
+
+static void mark_dirty(uint8_t slot) {
+    atomic_fetch_or_explicit(&s_dirty, 1U << slot, memory_order_release);
+}
+
+/**
+ * @brief Copy a string field, cut to cap - 1
+ *
+ * @return true if the field changed
+ */
+static bool copy_field(char *dst, const char *src, size_t cap) {
+    size_t n = strnlen(src, cap - 1);
+    if (strncmp(dst, src, n) == 0 && dst[n] == '\0') {
+        return false;
+    }
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+    return true;
+}
+
 /* ============================================================================
  * NVS Helpers
  * ============================================================================ */
@@ -65,38 +109,74 @@ static void load_from_nvs(void) {
     ESP_LOGI(TAG, "Loaded slots from NVS");
 }
 
-static int save_to_nvs(void) {
+/**
+ * @brief Write the dirty slots in one commit
+ *
+ * @return Slots written, -1 on error (they stay dirty)
+ */
+static int save_dirty_to_nvs(void) {
+    unsigned dirty = atomic_exchange_explicit(&s_dirty, 0U, memory_order_acq_rel);
+    if (dirty == 0) {
+        return 0;
+    }
+
     nvs_handle_t handle;
     esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
     if (err != ESP_OK) {
+        atomic_fetch_or_explicit(&s_dirty, dirty, memory_order_relaxed);
         ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
         return -1;
     }
 
     char key[16];
-    for (uint8_t i = 0; i < TEXT_MEMORY_SLOTS; i++) {
+    int written = 0;
+    for (uint8_t i = 0; i < TEXT_MEMORY_SLOTS && err == ESP_OK; i++) {
+        if ((dirty & (1U << i)) == 0) {
+            continue;
+        }
         snprintf(key, sizeof(key), "slot%d_text", i);
-        nvs_set_str(handle, key, s_slots[i].text);
-
-        snprintf(key, sizeof(key), "slot%d_label", i);
-        nvs_set_str(handle, key, s_slots[i].label);
+        err = nvs_set_str(handle, key, s_slots[i].text);
+        if (err == ESP_OK) {
+            snprintf(key, sizeof(key), "slot%d_label", i);
+            err = nvs_set_str(handle, key, s_slots[i].label);
+        }
+        written++;
     }
 
-    err = nvs_commit(handle);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
     nvs_close(handle);
 
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(err));
+        atomic_fetch_or_explicit(&s_dirty, dirty, memory_order_relaxed);
+        ESP_LOGE(TAG, "Failed to save slots: %s", esp_err_to_name(err));
         return -1;
     }
 
-    ESP_LOGI(TAG, "Saved slots to NVS");
-    return 0;
+    ESP_LOGI(TAG, "Saved %d slots to NVS", written);
+    return written;
+}
+
+static void request_save(void) {
+    config_persist_request();
+}
+
+static void add_store(void) {
+    static bool s_added = false;
+    if (!s_added) {
+        s_added = config_persist_add_store(save_dirty_to_nvs);
+    }
 }
 #else
 /* Host stubs */
 static void load_from_nvs(void) {}
-static int save_to_nvs(void) { return 0; }
+static int save_dirty_to_nvs(void) {
+    atomic_store_explicit(&s_dirty, 0U, memory_order_relaxed);
+    return 0;
+}
+static void request_save(void) {}
+static void add_store(void) {}
 #endif
 
 /* ============================================================================
@@ -109,6 +189,9 @@ int text_memory_init(void) {
 
     /* Override with NVS if available */
     load_from_nvs();
+    compile_all();
+    atomic_store_explicit(&s_dirty, 0U, memory_order_relaxed);
+    add_store();
 
     s_initialized = true;
     return 0;
@@ -142,19 +225,19 @@ int text_memory_set(uint8_t slot, const char *text, const char *label) {
         text_memory_init();
     }
 
-    if (text == NULL) {
-        s_slots[slot].text[0] = '\0';
-    } else {
-        strncpy(s_slots[slot].text, text, TEXT_MEMORY_MAX_LEN - 1);
-        s_slots[slot].text[TEXT_MEMORY_MAX_LEN - 1] = '\0';
+    bool changed = copy_field(s_slots[slot].text, text != NULL ? text : "", TEXT_MEMORY_MAX_LEN);
+    if (changed) {
+        text_macro_compile(&s_macros[slot], s_slots[slot].text);
     }
-
     if (label != NULL) {
-        strncpy(s_slots[slot].label, label, TEXT_MEMORY_LABEL_LEN - 1);
-        s_slots[slot].label[TEXT_MEMORY_LABEL_LEN - 1] = '\0';
+        changed = copy_field(s_slots[slot].label, label, TEXT_MEMORY_LABEL_LEN) || changed;
     }
 
-    return save_to_nvs();
+    if (changed) {
+        mark_dirty(slot);
+        request_save();
+    }
+    return 0;
 }
 
 int text_memory_clear(uint8_t slot) {
@@ -170,14 +253,34 @@ int text_memory_set_label(uint8_t slot, const char *label) {
         text_memory_init();
     }
 
-    strncpy(s_slots[slot].label, label, TEXT_MEMORY_LABEL_LEN - 1);
-    s_slots[slot].label[TEXT_MEMORY_LABEL_LEN - 1] = '\0';
+    if (copy_field(s_slots[slot].label, label, TEXT_MEMORY_LABEL_LEN)) {
+        mark_dirty(slot);
+        request_save();
+    }
+    return 0;
+}
+
+int text_memory_replace_all(const text_memory_slot_t *slots) {
+    if (slots == NULL) {
+        return -1;
+    }
 
-    return save_to_nvs();
+    for (uint8_t i = 0; i < TEXT_MEMORY_SLOTS; i++) {
+        bool changed = copy_field(s_slots[i].text, slots[i].text, TEXT_MEMORY_MAX_LEN);
+        changed = copy_field(s_slots[i].label, slots[i].label, TEXT_MEMORY_LABEL_LEN) || changed;
+        if (changed) {
+            mark_dirty(i);
+        }
+    }
+    s_initialized = true;
+    compile_all();
+
+    /* A profile import reports whether the memories reached flash */
+    return (save_dirty_to_nvs() < 0) ? -1 : 0;
 }
 
 int text_memory_save(void) {
-    return save_to_nvs();
+    return (save_dirty_to_nvs() < 0) ? -1 : 0;
 }
 
 bool text_memory_is_set(uint8_t slot) {
@@ -186,3 +289,14 @@ bool text_memory_is_set(uint8_t slot) {
     }
     return s_slots[slot].text[0] != '\0';
 }
+
+const text_macro_t *text_memory_macro(uint8_t slot) {
+    if (slot >= TEXT_MEMORY_SLOTS) {
+        return NULL;
+    }
+
+    if (!s_initialized) {
+        text_memory_init();
+    }
+    return &s_macros[slot];
+}
@@ -0,0 +1,212 @@
+/**
+ * @file text_schedule.c
+ * @brief SPSC run-length key schedule implementation
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block
+ */
+
+#include "text_schedule.h"
+#include <assert.h>
+#include <string.h>
+
+#define TEXT_SCHEDULE_MASK (TEXT_SCHEDULE_CAPACITY - 1)
+
+_Static_assert((TEXT_SCHEDULE_CAPACITY & TEXT_SCHEDULE_MASK) == 0,
+               "TEXT_SCHEDULE_CAPACITY must be power of 2");
+
+void text_schedule_init(text_schedule_t *s) {
+    assert(s != NULL);
+
+    memset(s->buffer, 0, sizeof(s->buffer));
+    atomic_init(&s->write_idx, 0);
+    atomic_init(&s->read_idx, 0);
+    atomic_init(&s->flush_idx, 0);
+    atomic_init(&s->stop, false);
+    atomic_init(&s->paused, false);
+    atomic_init(&s->pos, 0);
+    s->playing = false;
+    s->remaining_us = 0;
+    s->key_down = false;
+    s->held = false;
+}
+
+/* ============================================================================
+ * Producer
+ * ============================================================================ */
+
+size_t text_schedule_space(const text_schedule_t *s) {
+    size_t write = atomic_load_explicit(&s->write_idx, memory_order_relaxed);
+    size_t read = atomic_load_explicit(&s->read_idx, memory_order_acquire);
+    return TEXT_SCHEDULE_CAPACITY - (write - read);
+}
+
+bool text_schedule_push(text_schedule_t *s, text_run_t run) {
+    assert(s != NULL);
+
+    if (text_schedule_space(s) == 0) {
+        return false;
+    }
+    size_t write = atomic_load_explicit(&s->write_idx, memory_order_relaxed);
+    s->buffer[write & TEXT_SCHEDULE_MASK] = run;
+
+    /* RULE 3.1.2: Release so the player sees the run before the index */
+    atomic_store_explicit(&s->write_idx, write + 1, memory_order_release);
+    return true;
+}
+
+void text_schedule_flush(text_schedule_t *s) {
+    assert(s != NULL);
+
+    size_t write = atomic_load_explicit(&s->write_idx, memory_order_relaxed);
+    atomic_store_explicit(&s->flush_idx, write, memory_order_release);
+    /* Flush point first: a player that sees the stop cleared sees it too */
+    atomic_store_explicit(&s->stop, false, memory_order_release);
+}
+
+bool text_schedule_idle(const text_schedule_t *s) {
+    size_t write = atomic_load_explicit(&s->write_idx, memory_order_relaxed);
+    size_t read = atomic_load_explicit(&s->read_idx, memory_order_acquire);
+    return read == write;
+}
+
+/* ============================================================================
+ * Any task
+ * ============================================================================ */
+
+void text_schedule_stop(text_schedule_t *s) {
+    assert(s != NULL);
+    atomic_store_explicit(&s->stop, true, memory_order_release);
+}
+
+bool text_schedule_stop_pending(const text_schedule_t *s) {
+    return atomic_load_explicit(&s->stop, memory_order_acquire);
+}
+
+void text_schedule_set_paused(text_schedule_t *s, bool paused) {
+    assert(s != NULL);
+    atomic_store_explicit(&s->paused, paused, memory_order_release);
+}
+
+bool text_schedule_paused(const text_schedule_t *s) {
+    return atomic_load_explicit(&s->paused, memory_order_acquire);
+}
+
+/* ============================================================================
+ * Consumer
+ * ============================================================================ */
+
+/** Drop everything queued so far (consumer owns read_idx) */
+static void discard_all(text_schedule_t *s, size_t write) {
+    atomic_store_explicit(&s->read_idx, write, memory_order_release);
+    s->playing = false;
+    s->remaining_us = 0;
+    s->key_down = false;
+}
+
+/** Start the run at read, carrying the previous run's overshoot */
+static void start_run(text_schedule_t *s, size_t read) {
+    text_run_t run = s->buffer[read & TEXT_SCHEDULE_MASK];
+    s->remaining_us += (int32_t)text_run_duration_us(run);
+    s->key_down = text_run_key_down(run);
+    s->playing = true;
+    atomic_store_explicit(&s->pos, text_run_pos(run), memory_order_relaxed);
+}
+
+bool text_schedule_play(text_schedule_t *s, uint32_t tick_us, bool paddle_active) {
+    assert(s != NULL);
+
+    /* RULE 3.1.3: Acquire for the runs behind the index */
+    size_t write = atomic_load_explicit(&s->write_idx, memory_order_acquire);
+    size_t read = atomic_load_explicit(&s->read_idx, memory_order_relaxed);
+
+    if (atomic_load_explicit(&s->stop, memory_order_acquire)) {
+        discard_all(s, write);
+        return false;
+    }
+
+    /* Runs below the flush point were cancelled */
+    size_t flush = atomic_load_explicit(&s->flush_idx, memory_order_acquire);
+    if (flush - read - 1U < TEXT_SCHEDULE_CAPACITY) {
+        read = flush;
+        discard_all(s, read);
+    }
+
+    bool busy = s->playing || read != write;
+    if (!busy) {
+        return false;
+    }
+    if (atomic_load_explicit(&s->paused, memory_order_acquire)) {
+        return false;  /* Run and its time left are kept for resume */
+    }
+    if (paddle_active) {
+        /* Operator takes over on this very tick */
+        atomic_store_explicit(&s->stop, true, memory_order_release);
+        discard_all(s, write);
+        return false;
+    }
+    if (s->held && !(s->playing && s->key_down)) {
+        return false;  /* Waiting for the PTT lead, key up */
+    }
+
+    if (!s->playing) {
+        s->remaining_us = 0;
+        start_run(s, read);
+    }
+    bool level = s->key_down;
+
+    /* Consume this tick; runs that end inside it hand their overshoot on */
+    s->remaining_us -= (int32_t)tick_us;
+    while (s->remaining_us <= 0) {
+        read++;
+        atomic_store_explicit(&s->read_idx, read, memory_order_release);
+        if (read == write) {
+            s->playing = false;
+            s->remaining_us = 0;
+            break;
+        }
+        start_run(s, read);
+    }
+    return level;
+}
+
+void text_schedule_hold(text_schedule_t *s, bool hold) {
+    assert(s != NULL);
+    s->held = hold;
+}
+
+uint32_t text_schedule_until_key_us(const text_schedule_t *s, uint32_t limit_us) {
+    assert(s != NULL);
+
+    size_t write = atomic_load_explicit(&s->write_idx, memory_order_acquire);
+    size_t read = atomic_load_explicit(&s->read_idx, memory_order_relaxed);
+    if (atomic_load_explicit(&s->stop, memory_order_acquire) ||
+        atomic_load_explicit(&s->paused, memory_order_acquire)) {
+        return UINT32_MAX;
+    }
+
+    bool playing = s->playing;
+    size_t flush = atomic_load_explicit(&s->flush_idx, memory_order_acquire);
+    if (flush - read - 1U < TEXT_SCHEDULE_CAPACITY) {
+        read = flush;
+        playing = false;
+    }
+
+    uint32_t until = 0;
+    if (playing) {
+        if (s->key_down) {
+            return 0;
+        }
+        until = (s->remaining_us > 0) ? (uint32_t)s->remaining_us : 0U;
+        read++;
+    }
+    for (; read != write && until <= limit_us; read++) {
+        text_run_t run = s->buffer[read & TEXT_SCHEDULE_MASK];
+        if (text_run_key_down(run)) {
+            return until;
+        }
+        until += text_run_duration_us(run);
+    }
+    return UINT32_MAX;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file text_typeahead.c
+ * @brief MPSC type-ahead character queue implementation
+ *
+ * A position p owns slot p & MASK. The slot reads EMPTY(p) until the
+ * producer that claimed p publishes FULL(p); the consumer turns it into
+ * EMPTY(p + CAPACITY) before advancing tail, which is what the space
+ * check of the next lap's producer waits for. Cancelling clears the
+ * character of a FULL slot in place with a CAS, so it races safely with
+ * the consumer taking the same slot: exactly one of the two wins.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block (CAS retries only on contention)
+ */
+
+#include "text_typeahead.h"
+#include <assert.h>
+
+#define TEXT_TYPEAHEAD_MASK ((uint32_t)TEXT_TYPEAHEAD_CAPACITY - 1U)
+
+_Static_assert((TEXT_TYPEAHEAD_CAPACITY & (TEXT_TYPEAHEAD_CAPACITY - 1)) == 0,
+               "TEXT_TYPEAHEAD_CAPACITY must be power of 2");
+
+#define SLOT_CHAR_MASK  0xFFU
+#define SLOT_START      0x100U
+#define SLOT_FULL       0x200U
+#define SLOT_TAG_SHIFT  10
+#define SLOT_TAG_MASK   0x3FFFFFU
+
+static inline uint32_t slot_tag(uint32_t pos) {
+    return pos & SLOT_TAG_MASK;
+}
+
+static inline uint32_t slot_empty(uint32_t pos) {
+    return slot_tag(pos) << SLOT_TAG_SHIFT;
+}
+
+static inline uint32_t slot_full(uint32_t pos, bool start, char c) {
+    return slot_empty(pos) | SLOT_FULL | (start ? SLOT_START : 0U) |
+           ((uint32_t)(unsigned char)c & SLOT_CHAR_MASK);
+}
+
+static inline bool slot_is_full_for(uint32_t word, uint32_t pos) {
+    return (word >> SLOT_TAG_SHIFT) == slot_tag(pos) && (word & SLOT_FULL) != 0U;
+}
+
+void text_typeahead_init(text_typeahead_t *q) {
+    assert(q != NULL);
+
+    for (uint32_t i = 0; i < TEXT_TYPEAHEAD_CAPACITY; i++) {
+        atomic_init(&q->slots[i], slot_empty(i));
+    }
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->rejected, 0);
+}
+
+/* ============================================================================
+ * Producers
+ * ============================================================================ */
+
+bool text_typeahead_append(text_typeahead_t *q, const char *text, size_t len) {
+    assert(q != NULL);
+
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] != '\0') {
+            n++;
+        }
+    }
+    if (n == 0) {
+        return false;
+    }
+
+    /* Claim n consecutive positions */
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    for (;;) {
+        uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if ((size_t)(head - tail) + n > TEXT_TYPEAHEAD_CAPACITY) {
+            atomic_fetch_add_explicit(&q->rejected, 1, memory_order_relaxed);
+            return false;
+        }
+        if (atomic_compare_exchange_weak_explicit(&q->head, &head, head + (uint32_t)n,
+                                                  memory_order_acq_rel,
+                                                  memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    /* RULE 3.1.2: Release publishes each character to the consumer */
+    uint32_t pos = head;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\0') {
+            continue;
+        }
+        atomic_store_explicit(&q->slots[pos & TEXT_TYPEAHEAD_MASK],
+                              slot_full(pos, pos == head, text[i]),
+                              memory_order_release);
+        pos++;
+    }
+    return true;
+}
+
+size_t text_typeahead_cancel_last(text_typeahead_t *q, text_typeahead_cancel_t what) {
+    assert(q != NULL);
+
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    size_t removed = 0;
+
+    for (uint32_t pos = head; pos != tail; ) {
+        pos--;
+        atomic_uint_least32_t *slot = &q->slots[pos & TEXT_TYPEAHEAD_MASK];
+        uint32_t word = atomic_load_explicit(slot, memory_order_acquire);
+
+        if (!slot_is_full_for(word, pos)) {
+            if ((word >> SLOT_TAG_SHIFT) == slot_tag(pos)) {
+                continue;  /* Another append is still writing this one */
+            }
+            break;         /* Popped: everything older is gone too */
+        }
+        if ((word & SLOT_CHAR_MASK) == 0U) {
+            continue;      /* Already cancelled */
+        }
+        if (!atomic_compare_exchange_strong_explicit(slot, &word, word & ~SLOT_CHAR_MASK,
+                                                     memory_order_acq_rel,
+                                                     memory_order_acquire)) {
+            break;         /* Consumer took it meanwhile */
+        }
+        removed++;
+        if (what == TEXT_TYPEAHEAD_CANCEL_CHAR || (word & SLOT_START) != 0U) {
+            break;
+        }
+    }
+    return removed;
+}
+
+/* ============================================================================
+ * Consumer
+ * ============================================================================ */
+
+bool text_typeahead_pop(text_typeahead_t *q, char *out) {
+    assert(q != NULL);
+
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    for (;;) {
+        atomic_uint_least32_t *slot = &q->slots[tail & TEXT_TYPEAHEAD_MASK];
+        uint32_t word = atomic_load_explicit(slot, memory_order_acquire);
+        if (!slot_is_full_for(word, tail)) {
+            return false;  /* Empty, or its producer has not published yet */
+        }
+        /* Fails only when a cancel cleared the character meanwhile: retry */
+        if (!atomic_compare_exchange_weak_explicit(slot, &word,
+                                                   slot_empty(tail + TEXT_TYPEAHEAD_CAPACITY),
+                                                   memory_order_acq_rel,
+                                                   memory_order_relaxed)) {
+            continue;
+        }
+        tail++;
+        atomic_store_explicit(&q->tail, tail, memory_order_release);
+
+        char c = (char)(word & SLOT_CHAR_MASK);
+        if (c != '\0') {
+            *out = c;
+            return true;
+        }
+    }
+}
+
+bool text_typeahead_empty(const text_typeahead_t *q) {
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    return head == tail;
+}
+
+void text_typeahead_clear(text_typeahead_t *q) {
+    char c;
+    while (text_typeahead_pop(q, &c)) {
+    }
+}
+
+void text_typeahead_get_status(const text_typeahead_t *q, text_typeahead_status_t *out) {
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    size_t queued = (size_t)(head - tail);
+    if (queued > TEXT_TYPEAHEAD_CAPACITY) {
+        queued = TEXT_TYPEAHEAD_CAPACITY;  /* Torn snapshot */
+    }
+    out->queued = queued;
+    out->free = TEXT_TYPEAHEAD_CAPACITY - queued;
+    out->capacity = TEXT_TYPEAHEAD_CAPACITY;
+    out->rejected = (uint32_t)atomic_load_explicit(&q->rejected, memory_order_relaxed);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file cdc_batch.h
+ * @brief Coalescing output buffer for one CDC interface
+ *
+ * Console output arrives as many short writes (one per printf, one per
+ * echoed key). Queuing and flushing each one costs a USB transaction per
+ * fragment, so lines of a long listing go out a few bytes at a time.
+ * A batch gathers the bytes and hands them to the port one full-speed
+ * bulk packet (CDC_BATCH_SIZE) at a time; a partial packet goes out when
+ * it has waited CDC_BATCH_HOLD_US or on an explicit flush (the prompt).
+ *
+ * The port callbacks must not block: a packet the port takes only in
+ * part (host not reading, TX FIFO full) loses the rest, counted in
+ * dropped, and the writer goes on.
+ *
+ * Not thread-safe: the owner serializes put, poll and flush.
+ */
+
+#ifndef KEYER_CDC_BATCH_H
+#define KEYER_CDC_BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** One full-speed bulk packet */
+#define CDC_BATCH_SIZE 64U
+
+/** Longest a partial packet waits */
+#define CDC_BATCH_HOLD_US 2000
+
+/**
+ * @brief Queue bytes on the port without blocking
+ * @return Bytes accepted
+ */
+typedef size_t (*cdc_batch_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief Start sending what the port has queued, without blocking
+ */
+typedef void (*cdc_batch_flush_fn)(void *ctx);
+
+/**
+ * @brief Batch state
+ */
+typedef struct {
+    uint8_t buf[CDC_BATCH_SIZE];
+    size_t len;                 /**< Bytes held */
+    int64_t first_us;           /**< Time the oldest held byte arrived */
+    cdc_batch_write_fn write;
+    cdc_batch_flush_fn flush;
+    void *ctx;
+    uint32_t bytes;             /**< Bytes handed to the port */
+    uint32_t packets;           /**< Port flushes */
+    uint32_t dropped;           /**< Bytes the port refused */
+} cdc_batch_t;
+
+/**
+ * @brief Initialize a batch
+ *
+ * @param b Batch
+ * @param write Port queue (non-blocking)
+ * @param flush Port flush (non-blocking)
+ * @param ctx Passed to both
+ */
+void cdc_batch_init(cdc_batch_t *b, cdc_batch_write_fn write, cdc_batch_flush_fn flush,
+                    void *ctx);
+
+/**
+ * @brief Add bytes; every full packet goes to the port at once
+ *
+ * A held partial packet older than CDC_BATCH_HOLD_US goes first.
+ *
+ * @param b Batch
+ * @param data Bytes
+ * @param len Byte count
+ * @param now_us Current time
+ */
+void cdc_batch_put(cdc_batch_t *b, const void *data, size_t len, int64_t now_us);
+
+/**
+ * @brief Send a partial packet that has waited long enough
+ *
+ * @param b Batch
+ * @param now_us Current time
+ * @return true if bytes are still held (poll again later)
+ */
+bool cdc_batch_poll(cdc_batch_t *b, int64_t now_us);
+
+/**
+ * @brief Send whatever is held now
+ *
+ * @param b Batch
+ */
+void cdc_batch_flush(cdc_batch_t *b);
+
+/**
+ * @brief Bytes are held, waiting for more or for the hold time
+ */
+static inline bool cdc_batch_pending(const cdc_batch_t *b) {
+    return b->len > 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_CDC_BATCH_H */
@@ -0,0 +1,82 @@
+/**
+ * @file usb_audio.h
+ * @brief USB Audio Class 2 capture of the keyer's audio mix
+ *
+ * When audio.usb_audio is set, the device exposes a UAC2 microphone
+ * (8 kHz, 16-bit mono) carrying the same blocks rt_task writes to the
+ * codec: sidetone for local and remote keying plus CWNet rig audio.
+ * PC-side headphones, recorders and SDR/contest software can then listen
+ * without an analog loop from the ES8311 output.
+ *
+ * rt_task copies each block into g_usb_audio (audio_buffer_write(), never
+ * blocks, drops what does not fit); the TinyUSB task drains it one
+ * isochronous packet per 1 ms frame. The stream is asynchronous IN, so
+ * the keyer clock is the master: packets carry 7, 8 or 9 samples to hold
+ * the ring near USB_AUDIO_TARGET_SAMPLES and absorb the drift between
+ * the RT tick and the USB frame clock (no feedback endpoint: that is for
+ * OUT streams).
+ *
+ * esp_tinyusb has no audio class, so a minimal class driver is registered
+ * through TinyUSB's application driver hook. The function takes one of
+ * CDC1's endpoints (usb_descriptors.h): log output and winkeyer.wk_usb
+ * are off while it is enabled.
+ */
+
+#ifndef KEYER_USB_AUDIO_H
+#define KEYER_USB_AUDIO_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Stream sample rate (the rt_task audio rate) */
+#define USB_AUDIO_SAMPLE_RATE_HZ 8000
+
+/** Largest isochronous packet: one frame plus the servo's extra sample */
+#define USB_AUDIO_MAX_PACKET_SAMPLES (USB_AUDIO_SAMPLE_RATE_HZ / 1000 + 1)
+#define USB_AUDIO_EP_SIZE (USB_AUDIO_MAX_PACKET_SAMPLES * 2)
+
+/** g_usb_audio capacity in samples (power of 2, 32 ms) */
+#define USB_AUDIO_RING_SAMPLES 256
+
+/** Ring level the packet size servo holds (4 ms) */
+#define USB_AUDIO_TARGET_SAMPLES 32
+
+/**
+ * @brief Counters (console)
+ */
+typedef struct {
+    bool streaming;        /**< Host has the stream open */
+    uint32_t packets;      /**< Isochronous packets sent */
+    uint32_t underruns;    /**< Packets padded with silence */
+    uint32_t level;        /**< Samples waiting in the ring */
+    bool muted;            /**< Host mute */
+    int16_t volume_db;     /**< Host volume, whole dB */
+} usb_audio_stats_t;
+
+/**
+ * @brief Read audio.usb_audio (called by usb_cdc_init before TinyUSB starts)
+ *
+ * @return ESP_OK
+ */
+esp_err_t usb_audio_init(void);
+
+/**
+ * @brief USB audio replaces CDC1 (set at boot)
+ */
+bool usb_audio_is_enabled(void);
+
+/**
+ * @brief Counters snapshot
+ */
+void usb_audio_get_stats(usb_audio_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_USB_AUDIO_H */
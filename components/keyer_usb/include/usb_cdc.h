@@ -3,8 +3,11 @@
  * @brief TinyUSB multi-CDC initialization and management
  *
  * CDC0: Console (interactive commands with immediate echo)
- * CDC1: Log (RT-safe ring buffer drain)
- * CDC2: Winkeyer3 (stub for future)
+ * CDC1: Log (RT-safe ring buffer drain), or WinKeyer 2 (winkeyer.wk_usb)
+ *
+ * With USB audio (audio.usb_audio), MIDI or HID paddle output
+ * (usb.usb_midi, usb.usb_hid) on, those functions take CDC1's place
+ * (usb_descriptors.h).
  */
 
 #ifndef KEYER_USB_CDC_H
@@ -21,11 +24,12 @@ extern "C" {
 /** CDC interface numbers */
 #define CDC_ITF_CONSOLE  0
 #define CDC_ITF_LOG      1
-#define CDC_ITF_WINKEYER 2  /* Future */
+#define CDC_ITF_WINKEYER 1  /* Replaces the log when winkeyer.wk_usb is set */
 
 /** USB identification */
 #define USB_VID          0x303A  /* Espressif */
 #define USB_PID          0x8002  /* Custom device */
+#define USB_PID_COMPOSITE 0x8003 /* CDC0 + optional functions: hosts must not reuse the CDC-only binding */
 #define USB_SERIAL       "KEYER-IU3QEZ-001"
 
 /**
@@ -38,6 +42,11 @@ extern "C" {
  */
 esp_err_t usb_cdc_init(void);
 
+/**
+ * @brief CDC1 is in the descriptor (no optional function took its place)
+ */
+bool usb_cdc_port1_enabled(void);
+
 /**
  * @brief Write to specific CDC interface
  *
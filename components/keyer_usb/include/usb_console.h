@@ -4,6 +4,10 @@
  *
  * Uses TinyUSB callback for character-by-character processing
  * with immediate echo before pushing to console state machine.
+ *
+ * Output is coalesced into full USB packets (cdc_batch.h) and never
+ * blocks: a partial packet is sent at the prompt or after 2 ms, and
+ * output the host does not read is dropped.
  */
 
 #ifndef KEYER_USB_CONSOLE_H
@@ -11,11 +15,22 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Console output counters
+ */
+typedef struct {
+    uint32_t bytes;     /**< Bytes queued on CDC0 */
+    uint32_t packets;   /**< Flushes (one per packet, or per partial one) */
+    uint32_t dropped;   /**< Bytes lost: host not reading, TX FIFO full */
+} usb_console_stats_t;
+
 /**
  * @brief Initialize USB console on CDC0
  *
@@ -32,6 +47,14 @@ esp_err_t usb_console_init(void);
  */
 void usb_console_print(const char *str);
 
+/**
+ * @brief Write bytes to console (CDC0)
+ *
+ * @param data Bytes
+ * @param len Byte count
+ */
+void usb_console_write(const char *data, size_t len);
+
 /**
  * @brief Print formatted string to console (CDC0)
  *
@@ -41,10 +64,21 @@ void usb_console_print(const char *str);
 void usb_console_printf(const char *fmt, ...);
 
 /**
- * @brief Print prompt to console
+ * @brief Send held console output now
+ */
+void usb_console_flush(void);
+
+/**
+ * @brief Print prompt to console (and flush)
  */
 void usb_console_prompt(void);
 
+/**
+ * @brief Get console output counters
+ * @param out Counters
+ */
+void usb_console_get_stats(usb_console_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,58 @@
+/**
+ * @file usb_descriptors.h
+ * @brief Composite descriptors for the optional USB functions
+ *
+ * Optional functions replace CDC1: two CDC-ACM ports already use four of
+ * the five IN endpoints the ESP32-S3 has, and CDC1's two give room for
+ * any two of audio (UAC2 IN), MIDI (bulk IN/OUT) and HID (interrupt IN).
+ * Interfaces follow CDC0 in that order, one endpoint number each (3,
+ * then 4). Without optional functions the device keeps both CDC ports;
+ * that descriptor is here too, as esp_tinyusb will not build its default
+ * once the HID and MIDI classes are compiled in.
+ */
+
+#ifndef KEYER_USB_DESCRIPTORS_H
+#define KEYER_USB_DESCRIPTORS_H
+
+#include "tusb.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Optional functions (bit mask) */
+#define USB_FUNC_AUDIO 0x01U
+#define USB_FUNC_MIDI  0x02U
+#define USB_FUNC_HID   0x04U
+
+/** Optional functions that fit in CDC1's endpoints */
+#define USB_FUNC_MAX 2
+
+/** HID keyboard report ID (boot keyboard, no report ID) */
+#define USB_HID_REPORT_ID 0
+
+/**
+ * @brief Device descriptor with optional functions (own PID)
+ */
+const tusb_desc_device_t *usb_descriptors_device(void);
+
+/**
+ * @brief Configuration descriptor: CDC0 plus the optional functions
+ *
+ * @param funcs USB_FUNC_* mask, at most USB_FUNC_MAX bits (0 = CDC0 + CDC1)
+ * @return Descriptor, NULL if there are too many
+ */
+const uint8_t *usb_descriptors_config(uint8_t funcs);
+
+/**
+ * @brief HID report descriptor (boot keyboard)
+ */
+const uint8_t *usb_descriptors_hid_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_USB_DESCRIPTORS_H */
@@ -2,8 +2,9 @@
  * @file usb_log.h
  * @brief CDC1 log drain with filtering
  *
- * Drains RT-safe log ring buffer to CDC1.
- * Supports tag/level filtering via console commands.
+ * Drains RT-safe log ring buffer to CDC1, as text or, with
+ * usb.usb_log_binary, as log_wire.h frames for tools/logdec.
+ * Supports tag/level filtering via console commands (tags "RT", "BG").
  */
 
 #ifndef KEYER_USB_LOG_H
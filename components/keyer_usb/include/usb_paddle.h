@@ -0,0 +1,83 @@
+/**
+ * @file usb_paddle.h
+ * @brief Paddle and key state to the PC as USB MIDI and/or HID keyboard
+ *
+ * Browser and desktop CW trainers (Vail, VBand, MorseWalker, ...) read a
+ * keyer over USB instead of a serial port:
+ *
+ *   usb.usb_midi  MIDI note on/off, channel 1: note 0 = keyed output,
+ *                 1 = dit paddle, 2 = dah paddle (Vail adapter mapping)
+ *   usb.usb_hid   Boot keyboard: PADDLES reports dit as Left Ctrl and dah
+ *                 as Right Ctrl (VBand), KEY reports the keyed output as
+ *                 Left Ctrl (straight key mode)
+ *
+ * Both functions take CDC1's endpoints (usb_descriptors.h), shared with
+ * audio.usb_audio: at most USB_FUNC_MAX of the three are enabled, in the
+ * order audio, MIDI, HID; the rest are dropped with a warning at boot.
+ *
+ * Usage:
+ *   usb_cdc_init() calls usb_paddle_init() before TinyUSB starts. Create
+ *   usb_paddle_task() pinned to Core 1; it deletes itself unless a
+ *   function is enabled. Edges come from the task's own key_edge stage on
+ *   g_keying_stream, so they reach the host within one 1 ms poll (USB-MIDI
+ *   events carry no timestamp of their own).
+ */
+
+#ifndef KEYER_USB_PADDLE_H
+#define KEYER_USB_PADDLE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** usb.usb_hid values */
+#define USB_HID_MODE_NONE    0
+#define USB_HID_MODE_PADDLES 1
+#define USB_HID_MODE_KEY     2
+
+/**
+ * @brief Counters (console)
+ */
+typedef struct {
+    bool midi;                  /**< MIDI function enabled */
+    uint8_t hid_mode;           /**< USB_HID_MODE_* in use */
+    uint32_t midi_events;       /**< Note on/off packets sent */
+    uint32_t midi_dropped;      /**< Packets the MIDI FIFO refused */
+    uint32_t hid_reports;       /**< Keyboard reports sent */
+    uint32_t edges_lost;        /**< Edges the stage ring overwrote */
+} usb_paddle_stats_t;
+
+/**
+ * @brief Read usb.usb_midi / usb.usb_hid and fit them in the free slots
+ *
+ * @param taken_funcs USB_FUNC_* already claimed (audio)
+ * @return ESP_OK
+ */
+esp_err_t usb_paddle_init(uint8_t taken_funcs);
+
+/**
+ * @brief USB_FUNC_* this module enabled (set at boot)
+ */
+uint8_t usb_paddle_functions(void);
+
+/**
+ * @brief Paddle output task entry point
+ *
+ * @param arg Unused
+ */
+void usb_paddle_task(void *arg);
+
+/**
+ * @brief Counters snapshot
+ */
+void usb_paddle_get_stats(usb_paddle_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_USB_PADDLE_H */
@@ -1,14 +1,19 @@
 /**
  * @file usb_winkeyer.h
- * @brief CDC2 Winkeyer3 emulation (stub)
+ * @brief WinKeyer 2 host port on USB CDC
  *
- * Future implementation for K1EL Winkeyer3 protocol.
+ * When winkeyer.wk_usb is set, CDC1 carries the WinKeyer protocol
+ * (winkeyer.h) instead of the log: esp_tinyusb provides two CDC-ACM
+ * ports. The RX callback wakes usb_winkeyer_task, which owns the
+ * engine: it parses what arrived, answers within the same wake-up, and
+ * pushes status / speed pot changes on a 1 ms poll (one USB frame).
  */
 
 #ifndef KEYER_USB_WINKEYER_H
 #define KEYER_USB_WINKEYER_H
 
 #include "esp_err.h"
+#include "winkeyer.h"
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -16,19 +21,31 @@ extern "C" {
 #endif
 
 /**
- * @brief Initialize Winkeyer3 on CDC2 (stub)
+ * @brief Read winkeyer.wk_usb (config must be loaded)
  *
- * @return ESP_OK (always, stub implementation)
+ * @return ESP_OK
  */
 esp_err_t usb_winkeyer_init(void);
 
 /**
- * @brief Check if Winkeyer is enabled
+ * @brief Check if CDC1 is the WinKeyer port
  *
- * @return false (stub, not implemented)
+ * @return true if winkeyer.wk_usb was set at boot
  */
 bool usb_winkeyer_is_enabled(void);
 
+/**
+ * @brief WinKeyer port task (Core 1)
+ *
+ * Deletes itself unless usb_winkeyer_is_enabled().
+ */
+void usb_winkeyer_task(void *arg);
+
+/**
+ * @brief Engine of the USB port (console stats), NULL when disabled
+ */
+const winkeyer_t *usb_winkeyer_engine(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,73 @@
+/**
+ * @file cdc_batch.c
+ * @brief Coalescing output buffer for one CDC interface
+ */
+
+#include "cdc_batch.h"
+#include <string.h>
+
+void cdc_batch_init(cdc_batch_t *b, cdc_batch_write_fn write, cdc_batch_flush_fn flush,
+                    void *ctx) {
+    if (b == NULL) {
+        return;
+    }
+    memset(b, 0, sizeof(*b));
+    b->write = write;
+    b->flush = flush;
+    b->ctx = ctx;
+}
+
+/** Hand the held bytes to the port and start sending them */
+static void push(cdc_batch_t *b) {
+    size_t taken = b->write(b->ctx, b->buf, b->len);
+    if (taken > b->len) {
+        taken = b->len;
+    }
+    b->bytes += (uint32_t)taken;
+    b->dropped += (uint32_t)(b->len - taken);
+    b->len = 0;
+    b->flush(b->ctx);
+    b->packets++;
+}
+
+void cdc_batch_put(cdc_batch_t *b, const void *data, size_t len, int64_t now_us) {
+    if (b == NULL || data == NULL) {
+        return;
+    }
+    (void)cdc_batch_poll(b, now_us);
+
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+        if (b->len == 0) {
+            b->first_us = now_us;
+        }
+        size_t n = CDC_BATCH_SIZE - b->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&b->buf[b->len], p, n);
+        b->len += n;
+        p += n;
+        len -= n;
+        if (b->len == CDC_BATCH_SIZE) {
+            push(b);
+        }
+    }
+}
+
+bool cdc_batch_poll(cdc_batch_t *b, int64_t now_us) {
+    if (b == NULL || b->len == 0) {
+        return false;
+    }
+    if (now_us - b->first_us >= CDC_BATCH_HOLD_US) {
+        push(b);
+        return false;
+    }
+    return true;
+}
+
+void cdc_batch_flush(cdc_batch_t *b) {
+    if (b != NULL && b->len > 0) {
+        push(b);
+    }
+}
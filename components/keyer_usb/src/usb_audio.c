@@ -0,0 +1,392 @@
+/**
+ * @file usb_audio.c
+ * @brief USB Audio Class 2 capture of the keyer's audio mix
+ *
+ * Minimal UAC2 class driver (TinyUSB application driver): one clock
+ * source, a feature unit for host mute / volume and one asynchronous
+ * isochronous IN endpoint. The descriptor (usb_descriptors.c) comes from
+ * TUD_AUDIO_MIC_ONE_CH_DESCRIPTOR, which fixes the entity IDs below.
+ */
+
+#include "usb_audio.h"
+#include "audio_buffer.h"
+#include "config.h"
+
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "usb_audio";
+
+/** Filled by rt_task with every block it writes to the codec */
+extern audio_ring_buffer_t g_usb_audio;
+
+/** Samples per 1 ms frame at the nominal rate */
+#define SAMPLES_PER_FRAME  (USB_AUDIO_SAMPLE_RATE_HZ / 1000)
+
+/** Ring level band around the target before packet size changes */
+#define SERVO_BAND_SAMPLES 4
+
+/** Host volume range, whole dB (reported in 1/256 dB) */
+#define VOLUME_MIN_DB (-60)
+#define VOLUME_MAX_DB 0
+
+/* UAC2 requests (spec 5.2) and the entities of TUD_AUDIO_MIC_ONE_CH_DESCRIPTOR */
+#define UAC2_REQ_CUR          0x01
+#define UAC2_REQ_RANGE        0x02
+#define UAC2_CS_SAM_FREQ      0x01
+#define UAC2_CS_CLOCK_VALID   0x02
+#define UAC2_FU_MUTE          0x01
+#define UAC2_FU_VOLUME        0x02
+#define UAC2_ENTITY_FEATURE   0x02
+#define UAC2_ENTITY_CLOCK     0x04
+#define UAC2_SUBCLASS_CONTROL 0x01
+#define UAC2_PROTOCOL_V2      0x20
+
+/* ============================================================================
+ * State (TinyUSB task only; stats are read best-effort)
+ * ============================================================================ */
+
+static struct {
+    bool enabled;
+    uint8_t itf_ac;
+    uint8_t ep_in;
+    const tusb_desc_endpoint_t *ep_desc;
+    bool ep_open;
+    uint8_t alt;
+
+    bool streaming;
+    bool priming;          /**< Wait for the ring to reach the target */
+    bool muted;
+    int16_t volume;        /**< 1/256 dB, as the host set it */
+    int32_t gain_q15;
+
+    uint32_t packets;
+    uint32_t underruns;
+
+    uint8_t ctrl[16];      /**< Control transfer data (must outlive the request) */
+} s_ua;
+
+CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN static int16_t s_packet[USB_AUDIO_MAX_PACKET_SAMPLES];
+
+/** Gain for a whole-dB attenuation: 10^(-1/20) is 29205/32768 per dB */
+static int32_t gain_from_db(int32_t db) {
+    int32_t g = 32768;
+    for (int32_t i = db; i < 0; i++) {
+        g = (g * 29205) >> 15;
+    }
+    return g;
+}
+
+static int32_t volume_db(void) {
+    int32_t db = s_ua.volume / 256;
+    if (db < VOLUME_MIN_DB) db = VOLUME_MIN_DB;
+    if (db > VOLUME_MAX_DB) db = VOLUME_MAX_DB;
+    return db;
+}
+
+/* ============================================================================
+ * Streaming
+ * ============================================================================ */
+
+/** Packet size that steers the ring back towards the target */
+static size_t packet_samples(size_t level) {
+    if (level > USB_AUDIO_TARGET_SAMPLES + SERVO_BAND_SAMPLES) {
+        return SAMPLES_PER_FRAME + 1;
+    }
+    if (level + SERVO_BAND_SAMPLES < USB_AUDIO_TARGET_SAMPLES) {
+        return SAMPLES_PER_FRAME - 1;
+    }
+    return SAMPLES_PER_FRAME;
+}
+
+static void send_packet(uint8_t rhport) {
+    size_t level = audio_buffer_len(&g_usb_audio);
+    if (s_ua.priming && level >= USB_AUDIO_TARGET_SAMPLES) {
+        s_ua.priming = false;
+    }
+
+    size_t n = packet_samples(level);
+    size_t got = 0;
+    if (!s_ua.priming) {
+        got = audio_buffer_read(&g_usb_audio, s_packet, n);
+        if (got < n) {
+            s_ua.underruns++;
+            s_ua.priming = true;  /* Refill before playing on */
+        }
+    }
+    for (size_t i = got; i < n; i++) {
+        s_packet[i] = 0;
+    }
+
+    if (s_ua.muted) {
+        memset(s_packet, 0, n * sizeof(s_packet[0]));
+    } else if (s_ua.gain_q15 < 32768) {
+        for (size_t i = 0; i < got; i++) {
+            s_packet[i] = (int16_t)(((int32_t)s_packet[i] * s_ua.gain_q15) >> 15);
+        }
+    }
+
+    if (usbd_edpt_xfer(rhport, s_ua.ep_in, (uint8_t *)s_packet,
+                       (uint16_t)(n * sizeof(s_packet[0])))) {
+        s_ua.packets++;
+    }
+}
+
+static bool set_interface(uint8_t rhport, const tusb_control_request_t *request) {
+    uint8_t itf = TU_U16_LOW(request->wIndex);
+    uint8_t alt = TU_U16_LOW(request->wValue);
+
+    if (itf == s_ua.itf_ac) {
+        TU_VERIFY(alt == 0);
+        return tud_control_status(rhport, request);
+    }
+    TU_VERIFY(itf == s_ua.itf_ac + 1 && alt <= 1);
+
+    s_ua.streaming = false;
+    if (alt == 1 && !s_ua.ep_open) {
+#ifdef TUP_DCD_EDPT_ISO_ALLOC
+        TU_VERIFY(usbd_edpt_iso_activate(rhport, s_ua.ep_desc));
+#else
+        TU_VERIFY(usbd_edpt_open(rhport, s_ua.ep_desc));
+#endif
+        s_ua.ep_open = true;
+    } else if (alt == 0 && s_ua.ep_open) {
+#ifndef TUP_DCD_EDPT_ISO_ALLOC
+        usbd_edpt_close(rhport, s_ua.ep_in);
+        s_ua.ep_open = false;
+#endif
+    }
+    s_ua.alt = alt;
+
+    if (alt == 1) {
+        /* Everything queued while nobody listened is stale */
+        size_t level = audio_buffer_len(&g_usb_audio);
+        if (level > USB_AUDIO_TARGET_SAMPLES) {
+            (void)audio_buffer_discard(&g_usb_audio, level - USB_AUDIO_TARGET_SAMPLES);
+        }
+        s_ua.priming = true;
+        s_ua.streaming = true;
+        send_packet(rhport);
+    }
+    return tud_control_status(rhport, request);
+}
+
+/* ============================================================================
+ * Entity requests
+ * ============================================================================ */
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFFU);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)(v & 0xFFFFU));
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static bool clock_request(uint8_t rhport, const tusb_control_request_t *request, uint8_t cs) {
+    TU_VERIFY(request->bmRequestType_bit.direction == TUSB_DIR_IN);
+
+    if (cs == UAC2_CS_SAM_FREQ && request->bRequest == UAC2_REQ_CUR) {
+        put_u32(s_ua.ctrl, USB_AUDIO_SAMPLE_RATE_HZ);
+        return tud_control_xfer(rhport, request, s_ua.ctrl, 4);
+    }
+    if (cs == UAC2_CS_SAM_FREQ && request->bRequest == UAC2_REQ_RANGE) {
+        put_u16(s_ua.ctrl, 1);                               /* One subrange */
+        put_u32(s_ua.ctrl + 2, USB_AUDIO_SAMPLE_RATE_HZ);    /* Min */
+        put_u32(s_ua.ctrl + 6, USB_AUDIO_SAMPLE_RATE_HZ);    /* Max */
+        put_u32(s_ua.ctrl + 10, 0);                          /* Resolution */
+        return tud_control_xfer(rhport, request, s_ua.ctrl, 14);
+    }
+    if (cs == UAC2_CS_CLOCK_VALID && request->bRequest == UAC2_REQ_CUR) {
+        s_ua.ctrl[0] = 1;
+        return tud_control_xfer(rhport, request, s_ua.ctrl, 1);
+    }
+    return false;
+}
+
+static bool feature_request(uint8_t rhport, const tusb_control_request_t *request, uint8_t cs) {
+    bool get = (request->bmRequestType_bit.direction == TUSB_DIR_IN);
+
+    if (cs == UAC2_FU_MUTE && request->bRequest == UAC2_REQ_CUR) {
+        if (get) {
+            s_ua.ctrl[0] = s_ua.muted ? 1 : 0;
+        }
+        return tud_control_xfer(rhport, request, s_ua.ctrl, 1);
+    }
+    if (cs == UAC2_FU_VOLUME && request->bRequest == UAC2_REQ_CUR) {
+        if (get) {
+            put_u16(s_ua.ctrl, (uint16_t)s_ua.volume);
+        }
+        return tud_control_xfer(rhport, request, s_ua.ctrl, 2);
+    }
+    if (cs == UAC2_FU_VOLUME && request->bRequest == UAC2_REQ_RANGE && get) {
+        put_u16(s_ua.ctrl, 1);
+        put_u16(s_ua.ctrl + 2, (uint16_t)(int16_t)(VOLUME_MIN_DB * 256));
+        put_u16(s_ua.ctrl + 4, (uint16_t)(int16_t)(VOLUME_MAX_DB * 256));
+        put_u16(s_ua.ctrl + 6, 256);                         /* 1 dB steps */
+        return tud_control_xfer(rhport, request, s_ua.ctrl, 8);
+    }
+    return false;
+}
+
+/** Data stage of a SET_CUR to the feature unit */
+static bool feature_set(const tusb_control_request_t *request, uint8_t cs) {
+    if (cs == UAC2_FU_MUTE) {
+        s_ua.muted = (s_ua.ctrl[0] != 0);
+    } else if (cs == UAC2_FU_VOLUME) {
+        s_ua.volume = (int16_t)(s_ua.ctrl[0] | (s_ua.ctrl[1] << 8));
+        s_ua.gain_q15 = gain_from_db(volume_db());
+    }
+    (void)request;
+    return true;
+}
+
+/* ============================================================================
+ * Class driver
+ * ============================================================================ */
+
+static void ua_init(void) {
+    s_ua.ep_desc = NULL;
+    s_ua.ep_open = false;
+    s_ua.streaming = false;
+    s_ua.muted = false;
+    s_ua.volume = 0;
+    s_ua.gain_q15 = 32768;
+}
+
+static void ua_reset(uint8_t rhport) {
+    (void)rhport;
+    ua_init();
+}
+
+static uint16_t ua_open(uint8_t rhport, const tusb_desc_interface_t *itf, uint16_t max_len) {
+    TU_VERIFY(itf->bInterfaceClass == TUSB_CLASS_AUDIO &&
+              itf->bInterfaceSubClass == UAC2_SUBCLASS_CONTROL &&
+              itf->bInterfaceProtocol == UAC2_PROTOCOL_V2, 0);
+
+    /* Claim the control interface and the streaming interface after it */
+    s_ua.itf_ac = itf->bInterfaceNumber;
+    const uint8_t *p = (const uint8_t *)itf;
+    const uint8_t *end = p + max_len;
+    uint16_t len = 0;
+    while (p < end && tu_desc_len(p) != 0) {
+        if (tu_desc_type(p) == TUSB_DESC_INTERFACE_ASSOCIATION) {
+            break;
+        }
+        if (tu_desc_type(p) == TUSB_DESC_INTERFACE) {
+            uint8_t num = ((const tusb_desc_interface_t *)p)->bInterfaceNumber;
+            if (num != s_ua.itf_ac && num != s_ua.itf_ac + 1) {
+                break;
+            }
+        } else if (tu_desc_type(p) == TUSB_DESC_ENDPOINT) {
+            const tusb_desc_endpoint_t *ep = (const tusb_desc_endpoint_t *)p;
+            if (ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS &&
+                tu_edpt_dir(ep->bEndpointAddress) == TUSB_DIR_IN) {
+                s_ua.ep_desc = ep;
+                s_ua.ep_in = ep->bEndpointAddress;
+            }
+        }
+        len = (uint16_t)(len + tu_desc_len(p));
+        p = tu_desc_next(p);
+    }
+    TU_VERIFY(s_ua.ep_desc != NULL, 0);
+
+#ifdef TUP_DCD_EDPT_ISO_ALLOC
+    TU_VERIFY(usbd_edpt_iso_alloc(rhport, s_ua.ep_in, tu_edpt_packet_size(s_ua.ep_desc)), 0);
+#else
+    (void)rhport;
+#endif
+    return len;
+}
+
+static bool ua_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control_request_t *request) {
+    TU_VERIFY(request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_INTERFACE);
+
+    if (request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD) {
+        if (stage != CONTROL_STAGE_SETUP) {
+            return true;
+        }
+        if (request->bRequest == TUSB_REQ_SET_INTERFACE) {
+            return set_interface(rhport, request);
+        }
+        if (request->bRequest == TUSB_REQ_GET_INTERFACE) {
+            s_ua.ctrl[0] = (TU_U16_LOW(request->wIndex) == s_ua.itf_ac + 1) ? s_ua.alt : 0;
+            return tud_control_xfer(rhport, request, s_ua.ctrl, 1);
+        }
+        return false;
+    }
+    TU_VERIFY(request->bmRequestType_bit.type == TUSB_REQ_TYPE_CLASS);
+
+    uint8_t entity = TU_U16_HIGH(request->wIndex);
+    uint8_t cs = TU_U16_HIGH(request->wValue);
+    if (stage == CONTROL_STAGE_SETUP) {
+        if (entity == UAC2_ENTITY_CLOCK) {
+            return clock_request(rhport, request, cs);
+        }
+        if (entity == UAC2_ENTITY_FEATURE) {
+            return feature_request(rhport, request, cs);
+        }
+        return false;
+    }
+    if (stage == CONTROL_STAGE_DATA &&
+        request->bmRequestType_bit.direction == TUSB_DIR_OUT &&
+        entity == UAC2_ENTITY_FEATURE) {
+        return feature_set(request, cs);
+    }
+    return true;
+}
+
+static bool ua_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+    (void)result;
+    (void)xferred_bytes;
+
+    if (ep_addr == s_ua.ep_in && s_ua.streaming) {
+        send_packet(rhport);  /* Missed frames show up as ring level: the servo catches up */
+    }
+    return true;
+}
+
+static const usbd_class_driver_t s_driver = {
+    .init = ua_init,
+    .reset = ua_reset,
+    .open = ua_open,
+    .control_xfer_cb = ua_control_xfer_cb,
+    .xfer_cb = ua_xfer_cb,
+    .sof = NULL,
+};
+
+/** TinyUSB application driver hook (tried before the built-in classes) */
+const usbd_class_driver_t *usbd_app_driver_get_cb(uint8_t *driver_count) {
+    *driver_count = s_ua.enabled ? 1 : 0;
+    return &s_driver;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+esp_err_t usb_audio_init(void) {
+    s_ua.enabled = CONFIG_GET_USB_AUDIO();
+    if (s_ua.enabled) {
+        ESP_LOGI(TAG, "UAC2 capture %d Hz mono replaces CDC1 (log output off)",
+                 USB_AUDIO_SAMPLE_RATE_HZ);
+    }
+    return ESP_OK;
+}
+
+bool usb_audio_is_enabled(void) {
+    return s_ua.enabled;
+}
+
+void usb_audio_get_stats(usb_audio_stats_t *out) {
+    out->streaming = s_ua.streaming;
+    out->packets = s_ua.packets;
+    out->underruns = s_ua.underruns;
+    out->level = (uint32_t)audio_buffer_len(&g_usb_audio);
+    out->muted = s_ua.muted;
+    out->volume_db = (int16_t)volume_db();
+}
@@ -8,6 +8,9 @@
 #include "usb_log.h"
 #include "usb_winkeyer.h"
 #include "usb_uf2.h"
+#include "usb_audio.h"
+#include "usb_paddle.h"
+#include "usb_descriptors.h"
 
 #include "tinyusb.h"
 #include "tusb_cdc_acm.h"
@@ -15,18 +18,33 @@
 
 static const char *TAG = "usb_cdc";
 
+static bool s_port1 = true;
+
 esp_err_t usb_cdc_init(void) {
     ESP_LOGI(TAG, "Initializing TinyUSB multi-CDC");
 
+    /* Before the driver starts: it asks for the audio class driver */
+    esp_err_t ret = usb_audio_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    uint8_t funcs = usb_audio_is_enabled() ? USB_FUNC_AUDIO : 0U;
+    ret = usb_paddle_init(funcs);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    funcs |= usb_paddle_functions();
+    s_port1 = (funcs == 0U);
+
     /* TinyUSB configuration */
     const tinyusb_config_t tusb_cfg = {
-        .device_descriptor = NULL,  /* Use default */
+        .device_descriptor = s_port1 ? NULL : usb_descriptors_device(),  /* NULL: default */
         .string_descriptor = NULL,  /* Use default */
         .external_phy = false,
-        .configuration_descriptor = NULL,  /* Use default */
+        .configuration_descriptor = usb_descriptors_config(funcs),
     };
 
-    esp_err_t ret = tinyusb_driver_install(&tusb_cfg);
+    ret = tinyusb_driver_install(&tusb_cfg);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "TinyUSB driver install failed: %s", esp_err_to_name(ret));
         return ret;
@@ -51,12 +69,14 @@ esp_err_t usb_cdc_init(void) {
         return ret;
     }
 
-    /* CDC1: Log */
-    acm_cfg.cdc_port = TINYUSB_CDC_ACM_1;
-    ret = tusb_cdc_acm_init(&acm_cfg);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "CDC1 init failed: %s", esp_err_to_name(ret));
-        return ret;
+    /* CDC1: Log (not in the descriptor when optional functions have its endpoints) */
+    if (s_port1) {
+        acm_cfg.cdc_port = TINYUSB_CDC_ACM_1;
+        ret = tusb_cdc_acm_init(&acm_cfg);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "CDC1 init failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
     }
 
     /* Initialize sub-components */
@@ -92,6 +112,10 @@ void usb_cdc_flush(uint8_t itf) {
     tinyusb_cdcacm_write_flush((tinyusb_cdcacm_itf_t)itf, 0);
 }
 
+bool usb_cdc_port1_enabled(void) {
+    return s_port1;
+}
+
 bool usb_cdc_connected(uint8_t itf) {
     return tusb_cdc_acm_initialized((tinyusb_cdcacm_itf_t)itf);
 }
@@ -1,20 +1,68 @@
 /**
  * @file usb_console.c
  * @brief CDC0 console with immediate echo
+ *
+ * Echo and command output go through one coalescing batch (cdc_batch.h):
+ * full packets leave at once, a partial one at the prompt, at the end of
+ * an RX callback, or from a one-shot timer CDC_BATCH_HOLD_US after its
+ * first byte (a long command printing progress). The lock serializes the
+ * console task, the timer and any other task printing here.
  */
 
 #include "usb_console.h"
 #include "usb_cdc.h"
+#include "cdc_batch.h"
 #include "console.h"
 
 #include "tusb_cdc_acm.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "usb_console";
 
+static cdc_batch_t s_out;
+static SemaphoreHandle_t s_out_lock = NULL;
+static StaticSemaphore_t s_out_lock_buf;
+static esp_timer_handle_t s_out_timer = NULL;
+
+static size_t port_write(void *ctx, const uint8_t *data, size_t len) {
+    (void)ctx;
+    return tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, data, len);
+}
+
+static void port_flush(void *ctx) {
+    (void)ctx;
+    (void)tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+}
+
+/**
+ * @brief Add console output (before init: straight to the port)
+ */
+static void out_put(const void *data, size_t len) {
+    if (s_out_lock == NULL) {
+        port_write(NULL, (const uint8_t *)data, len);
+        port_flush(NULL);
+        return;
+    }
+    xSemaphoreTake(s_out_lock, portMAX_DELAY);
+    cdc_batch_put(&s_out, data, len, esp_timer_get_time());
+    if (cdc_batch_pending(&s_out) && !esp_timer_is_active(s_out_timer)) {
+        esp_timer_start_once(s_out_timer, CDC_BATCH_HOLD_US);
+    }
+    xSemaphoreGive(s_out_lock);
+}
+
+/** esp_timer: a partial packet has waited its hold time */
+static void out_hold_expired(void *arg) {
+    (void)arg;
+    usb_console_flush();
+}
+
 /**
  * @brief Echo single character to CDC0
  */
@@ -41,7 +89,7 @@ static void echo_char(char c) {
     /* Ctrl+C, Ctrl+U: no echo */
 
     if (len > 0) {
-        tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, buf, len);
+        out_put(buf, len);
     }
 }
 
@@ -76,12 +124,27 @@ static void console_rx_callback(int itf, cdcacm_event_t *event) {
         }
     }
 
-    tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+    usb_console_flush();
 }
 
 esp_err_t usb_console_init(void) {
     ESP_LOGI(TAG, "Initializing USB console on CDC0");
 
+    cdc_batch_init(&s_out, port_write, port_flush, NULL);
+    const esp_timer_create_args_t timer_args = {
+        .callback = out_hold_expired,
+        .name = "console_out",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &s_out_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Output timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_out_lock = xSemaphoreCreateMutexStatic(&s_out_lock_buf);
+    if (s_out_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
     /* Register RX callback */
     tinyusb_cdcacm_register_callback(
         TINYUSB_CDC_ACM_0,
@@ -93,9 +156,11 @@ esp_err_t usb_console_init(void) {
 }
 
 void usb_console_print(const char *str) {
-    size_t len = strlen(str);
-    tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, (const uint8_t *)str, len);
-    tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+    out_put(str, strlen(str));
+}
+
+void usb_console_write(const char *data, size_t len) {
+    out_put(data, len);
 }
 
 void usb_console_printf(const char *fmt, ...) {
@@ -106,11 +171,32 @@ void usb_console_printf(const char *fmt, ...) {
     va_end(args);
 
     if (len > 0) {
-        tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, (const uint8_t *)buf, (size_t)len);
-        tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+        out_put(buf, ((size_t)len < sizeof(buf)) ? (size_t)len : sizeof(buf) - 1);
     }
 }
 
+void usb_console_flush(void) {
+    if (s_out_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_out_lock, portMAX_DELAY);
+    cdc_batch_flush(&s_out);
+    xSemaphoreGive(s_out_lock);
+}
+
 void usb_console_prompt(void) {
     console_print_prompt();
+    usb_console_flush();
+}
+
+void usb_console_get_stats(usb_console_stats_t *out) {
+    if (s_out_lock == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(s_out_lock, portMAX_DELAY);
+    out->bytes = s_out.bytes;
+    out->packets = s_out.packets;
+    out->dropped = s_out.dropped;
+    xSemaphoreGive(s_out_lock);
 }
@@ -0,0 +1,131 @@
+/**
+ * @file usb_descriptors.c
+ * @brief Composite descriptors for the optional USB functions
+ */
+
+#include "usb_descriptors.h"
+#include "usb_audio.h"
+#include "usb_cdc.h"
+
+#if !CFG_TUD_HID || !CFG_TUD_MIDI
+#error "USB HID/MIDI paddle output needs CONFIG_TINYUSB_HID_COUNT=1 and CONFIG_TINYUSB_MIDI_COUNT=1 (sdkconfig.defaults)"
+#endif
+
+#define ITF_NUM_CDC_0      0   /* CDC0 control + data: interfaces 0 and 1 */
+#define ITF_NUM_FIRST      2   /* First optional function */
+
+#define EPNUM_CDC_0_NOTIF  0x81
+#define EPNUM_CDC_0_OUT    0x02
+#define EPNUM_CDC_0_IN     0x82
+#define EPNUM_FIRST        0x03  /* First optional function's endpoint number */
+#define EPNUM_SECOND       0x04
+
+#define EPNUM_CDC_1_NOTIF  0x83  /* CDC1 in the same place */
+#define EPNUM_CDC_1_OUT    0x04
+#define EPNUM_CDC_1_IN     0x84
+#define ITF_NUM_CDC_1      2
+#define ITFS_CDC           2
+
+#define MIDI_EP_SIZE       64
+#define HID_EP_SIZE        8
+
+static const uint8_t s_hid_report[] = {
+    TUD_HID_REPORT_DESC_KEYBOARD()
+};
+
+/* One optional function: interface number, endpoint number */
+#define FUNC_AUDIO(_itf, _ep) \
+    TUD_AUDIO_MIC_ONE_CH_DESCRIPTOR(_itf, 0, 2, 16, 0x80 | (_ep), USB_AUDIO_EP_SIZE)
+#define FUNC_MIDI(_itf, _ep) \
+    TUD_MIDI_DESCRIPTOR(_itf, 0, _ep, 0x80 | (_ep), MIDI_EP_SIZE)
+#define FUNC_HID(_itf, _ep) \
+    TUD_HID_DESCRIPTOR(_itf, 0, HID_ITF_PROTOCOL_KEYBOARD, sizeof(s_hid_report), \
+                       0x80 | (_ep), HID_EP_SIZE, 1)
+
+#define ITFS_AUDIO 2
+#define ITFS_MIDI  2
+#define ITFS_HID   1
+
+#define CONFIG_HEAD(_itfs, _len) \
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_FIRST + (_itfs), 0, \
+                          TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + (_len), 0x00, 100), \
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_0, 4, EPNUM_CDC_0_NOTIF, 8, \
+                       EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 64)
+
+/* Both CDC ports, as esp_tinyusb would build them: it refuses to when HID/MIDI are compiled in */
+static const uint8_t s_config_cdc[] = {
+    CONFIG_HEAD(ITFS_CDC, TUD_CDC_DESC_LEN),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_1, 4, EPNUM_CDC_1_NOTIF, 8,
+                       EPNUM_CDC_1_OUT, EPNUM_CDC_1_IN, 64),
+};
+
+static const uint8_t s_config_a[] = {
+    CONFIG_HEAD(ITFS_AUDIO, TUD_AUDIO_MIC_ONE_CH_DESC_LEN),
+    FUNC_AUDIO(ITF_NUM_FIRST, EPNUM_FIRST),
+};
+
+static const uint8_t s_config_m[] = {
+    CONFIG_HEAD(ITFS_MIDI, TUD_MIDI_DESC_LEN),
+    FUNC_MIDI(ITF_NUM_FIRST, EPNUM_FIRST),
+};
+
+static const uint8_t s_config_h[] = {
+    CONFIG_HEAD(ITFS_HID, TUD_HID_DESC_LEN),
+    FUNC_HID(ITF_NUM_FIRST, EPNUM_FIRST),
+};
+
+static const uint8_t s_config_am[] = {
+    CONFIG_HEAD(ITFS_AUDIO + ITFS_MIDI, TUD_AUDIO_MIC_ONE_CH_DESC_LEN + TUD_MIDI_DESC_LEN),
+    FUNC_AUDIO(ITF_NUM_FIRST, EPNUM_FIRST),
+    FUNC_MIDI(ITF_NUM_FIRST + ITFS_AUDIO, EPNUM_SECOND),
+};
+
+static const uint8_t s_config_ah[] = {
+    CONFIG_HEAD(ITFS_AUDIO + ITFS_HID, TUD_AUDIO_MIC_ONE_CH_DESC_LEN + TUD_HID_DESC_LEN),
+    FUNC_AUDIO(ITF_NUM_FIRST, EPNUM_FIRST),
+    FUNC_HID(ITF_NUM_FIRST + ITFS_AUDIO, EPNUM_SECOND),
+};
+
+static const uint8_t s_config_mh[] = {
+    CONFIG_HEAD(ITFS_MIDI + ITFS_HID, TUD_MIDI_DESC_LEN + TUD_HID_DESC_LEN),
+    FUNC_MIDI(ITF_NUM_FIRST, EPNUM_FIRST),
+    FUNC_HID(ITF_NUM_FIRST + ITFS_MIDI, EPNUM_SECOND),
+};
+
+static const tusb_desc_device_t s_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = TUSB_CLASS_MISC,       /* IAD composite */
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_VID,
+    .idProduct = USB_PID_COMPOSITE,
+    .bcdDevice = 0x0100,
+    .iManufacturer = 0x01,                 /* esp_tinyusb default strings */
+    .iProduct = 0x02,
+    .iSerialNumber = 0x03,
+    .bNumConfigurations = 0x01
+};
+
+const tusb_desc_device_t *usb_descriptors_device(void) {
+    return &s_device;
+}
+
+const uint8_t *usb_descriptors_config(uint8_t funcs) {
+    switch (funcs) {
+        case 0:                               return s_config_cdc;
+        case USB_FUNC_AUDIO:                  return s_config_a;
+        case USB_FUNC_MIDI:                   return s_config_m;
+        case USB_FUNC_HID:                    return s_config_h;
+        case USB_FUNC_AUDIO | USB_FUNC_MIDI:  return s_config_am;
+        case USB_FUNC_AUDIO | USB_FUNC_HID:   return s_config_ah;
+        case USB_FUNC_MIDI | USB_FUNC_HID:    return s_config_mh;
+        default:                              return NULL;
+    }
+}
+
+const uint8_t *usb_descriptors_hid_report(void) {
+    return s_hid_report;
+}
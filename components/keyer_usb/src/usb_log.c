@@ -1,12 +1,24 @@
 /**
  * @file usb_log.c
  * @brief CDC1 log drain with filtering
+ *
+ * Text mode formats each entry on Core 1 as "[ts] LEVEL: message".
+ * Binary mode (usb.usb_log_binary) sends log_wire frames instead: the
+ * entry's format ID, tag ID and argument bytes, expanded on the PC by
+ * tools/logdec. A binary session starts (HELLO, empty format dictionary)
+ * whenever the host raises DTR, so a decoder that opens the port late
+ * still receives every format definition it needs.
  */
 
 #include "usb_log.h"
 #include "usb_cdc.h"
+#include "usb_winkeyer.h"
 #include "rt_log.h"
+#include "log_wire.h"
+#include "log_tags.h"
+#include "config.h"
 
+#include "tusb.h"
 #include "tusb_cdc_acm.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -29,73 +41,128 @@ static log_level_t s_global_level = LOG_LEVEL_INFO;
 static tag_filter_t s_tag_filters[MAX_TAG_FILTERS];
 static size_t s_tag_filter_count = 0;
 
-/**
- * @brief Check if entry passes filter
- */
-static bool filter_pass(const log_entry_t *entry, const char *tag) {
-    /* Check tag-specific filter first */
-    for (size_t i = 0; i < s_tag_filter_count; i++) {
-        if (strcmp(s_tag_filters[i].tag, tag) == 0) {
-            return entry->level <= s_tag_filters[i].level;
+/** The drained streams: tag name, LOG_TAGS ID and this sink's cursor */
+typedef struct {
+    log_stream_t *stream;
+    const char *tag;
+    uint8_t tag_id;
+    log_reader_t reader;     /* Level resolved from the filters when they change */
+} log_source_t;
+
+static log_source_t s_sources[] = {
+    { .stream = &g_rt_log_stream, .tag = "RT" },
+    { .stream = &g_bg_log_stream, .tag = "BG" },
+};
+
+#define SOURCE_COUNT (sizeof(s_sources) / sizeof(s_sources[0]))
+
+static log_wire_dict_t s_dict;
+static uint8_t s_wire[2 * LOG_WIRE_FRAME_MAX];
+
+/** Per-entry filtering is one compare: resolve tag names here instead */
+static void resolve_levels(void) {
+    for (size_t s = 0; s < SOURCE_COUNT; s++) {
+        log_level_t level = s_global_level;
+        for (size_t i = 0; i < s_tag_filter_count; i++) {
+            if (strcmp(s_tag_filters[i].tag, s_sources[s].tag) == 0) {
+                level = s_tag_filters[i].level;
+                break;
+            }
         }
+        log_reader_set_level(&s_sources[s].reader, level);
     }
+}
 
-    /* Fall back to global level */
-    return entry->level <= s_global_level;
+static uint8_t tag_id(const char *tag) {
+    for (size_t i = 0; i < LOG_TAGS_COUNT; i++) {
+        if (strcmp(LOG_TAGS[i], tag) == 0) {
+            return (uint8_t)i;
+        }
+    }
+    return 0xFF;
 }
 
 esp_err_t usb_log_init(void) {
     ESP_LOGI(TAG, "Initializing USB log on CDC1");
+    for (size_t s = 0; s < SOURCE_COUNT; s++) {
+        s_sources[s].tag_id = tag_id(s_sources[s].tag);
+        log_reader_init(&s_sources[s].reader, s_sources[s].stream, s_global_level);
+    }
+    resolve_levels();
     return ESP_OK;
 }
 
+static void write_port(const uint8_t *data, size_t len) {
+    tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_1, data, len);
+}
+
+static void send_text(const log_entry_t *entry) {
+    char msg[LOG_MAX_MSG_LEN];
+    char line[160];
+
+    (void)log_entry_format(entry, msg, sizeof(msg));
+    int len = snprintf(line, sizeof(line), "[%lld] %s: %s\r\n",
+                       entry->timestamp_us, log_level_str(entry->level), msg);
+    if (len > 0) {
+        write_port((const uint8_t *)line, ((size_t)len < sizeof(line)) ? (size_t)len
+                                                                        : sizeof(line) - 1);
+    }
+}
+
+static void report_dropped(log_source_t *src) {
+    uint32_t lost = log_reader_dropped(&src->reader);
+    if (lost == 0) {
+        return;
+    }
+    log_reader_reset_dropped(&src->reader);
+    write_port(s_wire, log_wire_dropped(s_wire, src->tag_id, lost));
+}
+
 void usb_log_task(void *arg) {
     (void)arg;
 
     log_entry_t entry;
-    char line[160];
+    bool session = false;   /* Binary session open (HELLO sent) */
 
     ESP_LOGI(TAG, "USB log drain task started");
 
     for (;;) {
-        /* Drain RT log stream */
-        while (log_stream_drain(&g_rt_log_stream, &entry)) {
-            if (!filter_pass(&entry, "RT")) {
-                continue;
-            }
-
-            int len = snprintf(line, sizeof(line),
-                "[%lld] %s: %.*s\r\n",
-                entry.timestamp_us,
-                log_level_str(entry.level),
-                (int)entry.len,
-                entry.msg);
-
-            if (len > 0 && usb_cdc_connected(CDC_ITF_LOG)) {
-                tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_1, (uint8_t *)line, (size_t)len);
+        /* CDC1 may be the WinKeyer port: drain, but keep logs off it */
+        bool log_port = !usb_winkeyer_is_enabled() && usb_cdc_connected(CDC_ITF_LOG);
+        bool binary = CONFIG_GET_USB_LOG_BINARY();
+
+        /* Binary frames only while a host holds the port open (DTR) */
+        bool host = log_port && tud_cdc_n_connected(CDC_ITF_LOG);
+        if (!binary || !host) {
+            session = false;
+        } else if (!session) {
+            log_wire_dict_reset(&s_dict);
+            write_port(s_wire, log_wire_hello(s_wire));
+            for (size_t s = 0; s < SOURCE_COUNT; s++) {
+                log_reader_reset_dropped(&s_sources[s].reader);
             }
+            session = true;
         }
 
-        /* Drain BG log stream */
-        while (log_stream_drain(&g_bg_log_stream, &entry)) {
-            if (!filter_pass(&entry, "BG")) {
-                continue;
+        for (size_t s = 0; s < SOURCE_COUNT; s++) {
+            log_source_t *src = &s_sources[s];
+            while (log_reader_next(&src->reader, &entry)) {
+                if (!log_port) {
+                    continue;
+                }
+                if (!binary) {
+                    send_text(&entry);
+                } else if (session) {
+                    write_port(s_wire, log_wire_encode(&s_dict, &entry, src->tag_id, s_wire));
+                }
             }
-
-            int len = snprintf(line, sizeof(line),
-                "[%lld] %s: %.*s\r\n",
-                entry.timestamp_us,
-                log_level_str(entry.level),
-                (int)entry.len,
-                entry.msg);
-
-            if (len > 0 && usb_cdc_connected(CDC_ITF_LOG)) {
-                tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_1, (uint8_t *)line, (size_t)len);
+            if (session) {
+                report_dropped(src);
             }
         }
 
         /* Flush and yield */
-        if (usb_cdc_connected(CDC_ITF_LOG)) {
+        if (log_port) {
             tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_1, 0);
         }
         vTaskDelay(pdMS_TO_TICKS(10));
@@ -104,6 +171,7 @@ void usb_log_task(void *arg) {
 
 void usb_log_set_level(log_level_t level) {
     s_global_level = level;
+    resolve_levels();
 }
 
 esp_err_t usb_log_set_tag_level(const char *tag, log_level_t level) {
@@ -111,6 +179,7 @@ esp_err_t usb_log_set_tag_level(const char *tag, log_level_t level) {
     for (size_t i = 0; i < s_tag_filter_count; i++) {
         if (strcmp(s_tag_filters[i].tag, tag) == 0) {
             s_tag_filters[i].level = level;
+            resolve_levels();
             return ESP_OK;
         }
     }
@@ -124,6 +193,7 @@ esp_err_t usb_log_set_tag_level(const char *tag, log_level_t level) {
     s_tag_filters[s_tag_filter_count].tag[MAX_TAG_LEN - 1] = '\0';
     s_tag_filters[s_tag_filter_count].level = level;
     s_tag_filter_count++;
+    resolve_levels();
 
     return ESP_OK;
 }
@@ -134,4 +204,5 @@ log_level_t usb_log_get_level(void) {
 
 void usb_log_clear_filters(void) {
     s_tag_filter_count = 0;
+    resolve_levels();
 }
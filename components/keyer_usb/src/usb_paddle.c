@@ -0,0 +1,231 @@
+/**
+ * @file usb_paddle.c
+ * @brief Paddle and key state to the PC as USB MIDI and/or HID keyboard
+ *
+ * usb_paddle_task (Core 1) runs its own key_edge stage every 1 ms: MIDI
+ * gets one note event per edge, HID one keyboard report whenever the
+ * modifier byte the edges add up to differs from the last one sent.
+ */
+
+#include "usb_paddle.h"
+#include "usb_descriptors.h"
+#include "key_edge.h"
+#include "config.h"
+
+#include "tusb.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "usb_paddle";
+
+/* Keying stream (local edges read) */
+extern keying_stream_t g_keying_stream;
+
+#define PADDLE_POLL_MS 1
+
+/* USB-MIDI 1.0 event packet: cable 0, code index = status high nibble */
+#define MIDI_CIN_NOTE_OFF 0x08
+#define MIDI_CIN_NOTE_ON  0x09
+#define MIDI_NOTE_OFF     0x80  /* Channel 1 */
+#define MIDI_NOTE_ON      0x90
+#define MIDI_VELOCITY     0x7F
+
+/** MIDI note per edge channel (Vail adapter: 0 key, 1 dit, 2 dah) */
+static const uint8_t s_midi_note[KEY_EDGE_CH_COUNT] = {
+    [KEY_EDGE_CH_KEY] = 0,
+    [KEY_EDGE_CH_DIT] = 1,
+    [KEY_EDGE_CH_DAH] = 2,
+};
+
+static struct {
+    uint8_t funcs;                 /* USB_FUNC_MIDI / USB_FUNC_HID */
+    uint8_t hid_mode;
+
+    key_edge_ring_t ring;          /* Own edge ring: no bg_task latency */
+    key_edge_stage_t stage;
+    key_edge_reader_t edges;
+    uint8_t levels[KEY_EDGE_CH_COUNT];
+    uint8_t hid_sent;              /* Modifier byte the host last got */
+
+    usb_paddle_stats_t stats;      /* Task-owned counters */
+} s_paddle;
+
+/*===========================================================================*/
+/* Output                                                                    */
+/*===========================================================================*/
+
+static void send_midi(const key_edge_t *edge) {
+    uint8_t note = s_midi_note[edge->channel];
+    uint8_t packet[4] = {
+        edge->level ? MIDI_CIN_NOTE_ON : MIDI_CIN_NOTE_OFF,
+        edge->level ? MIDI_NOTE_ON : MIDI_NOTE_OFF,
+        note,
+        edge->level ? MIDI_VELOCITY : 0,
+    };
+    if (tud_midi_packet_write(packet)) {
+        s_paddle.stats.midi_events++;
+    } else {
+        s_paddle.stats.midi_dropped++;
+    }
+}
+
+static uint8_t hid_modifier(void) {
+    if (s_paddle.hid_mode == USB_HID_MODE_KEY) {
+        return s_paddle.levels[KEY_EDGE_CH_KEY] ? KEYBOARD_MODIFIER_LEFTCTRL : 0;
+    }
+    uint8_t mod = 0;
+    if (s_paddle.levels[KEY_EDGE_CH_DIT]) {
+        mod |= KEYBOARD_MODIFIER_LEFTCTRL;
+    }
+    if (s_paddle.levels[KEY_EDGE_CH_DAH]) {
+        mod |= KEYBOARD_MODIFIER_RIGHTCTRL;
+    }
+    return mod;
+}
+
+/** Report the current state; a busy endpoint retries on the next poll */
+static void send_hid(void) {
+    uint8_t mod = hid_modifier();
+    if (mod == s_paddle.hid_sent || !tud_hid_ready()) {
+        return;
+    }
+    if (tud_hid_keyboard_report(USB_HID_REPORT_ID, mod, NULL)) {
+        s_paddle.hid_sent = mod;
+        s_paddle.stats.hid_reports++;
+    }
+}
+
+static void poll(void) {
+    key_edge_t edge;
+    bool midi = (s_paddle.funcs & USB_FUNC_MIDI) && tud_midi_mounted();
+
+    /* Host OUT traffic is unused: keep the FIFO from filling */
+    if (midi) {
+        uint8_t packet[4];
+        while (tud_midi_available()) {
+            (void)tud_midi_packet_read(packet);
+        }
+    }
+
+    key_edge_stage_run(&s_paddle.stage);
+    while (key_edge_reader_next(&s_paddle.edges, &edge)) {
+        if (edge.channel == KEY_EDGE_CH_REMOTE) {
+            continue;  /* Only this keyer's paddles and output */
+        }
+        s_paddle.levels[edge.channel] = edge.level;
+        if (midi) {
+            send_midi(&edge);
+        }
+    }
+    s_paddle.stats.edges_lost = (uint32_t)s_paddle.edges.dropped;
+
+    if ((s_paddle.funcs & USB_FUNC_HID) && tud_mounted()) {
+        send_hid();
+    }
+}
+
+/*===========================================================================*/
+/* Public API                                                                */
+/*===========================================================================*/
+
+esp_err_t usb_paddle_init(uint8_t taken_funcs) {
+    int free_slots = USB_FUNC_MAX - __builtin_popcount(taken_funcs);
+
+    s_paddle.funcs = 0;
+    s_paddle.hid_mode = USB_HID_MODE_NONE;
+
+    if (CONFIG_GET_USB_MIDI()) {
+        if (free_slots > 0) {
+            s_paddle.funcs |= USB_FUNC_MIDI;
+            free_slots--;
+        } else {
+            ESP_LOGW(TAG, "usb_midi off: audio and HID/MIDI share %d endpoint slots",
+                     USB_FUNC_MAX);
+        }
+    }
+    uint8_t hid = CONFIG_GET_USB_HID();
+    if (hid != USB_HID_MODE_NONE) {
+        if (free_slots > 0) {
+            s_paddle.funcs |= USB_FUNC_HID;
+            s_paddle.hid_mode = hid;
+        } else {
+            ESP_LOGW(TAG, "usb_hid off: audio and HID/MIDI share %d endpoint slots",
+                     USB_FUNC_MAX);
+        }
+    }
+
+    if (s_paddle.funcs != 0) {
+        ESP_LOGI(TAG, "%s%s%s replaces CDC1 (log output off)",
+                 (s_paddle.funcs & USB_FUNC_MIDI) ? "MIDI" : "",
+                 s_paddle.funcs == (USB_FUNC_MIDI | USB_FUNC_HID) ? " + " : "",
+                 (s_paddle.funcs & USB_FUNC_HID) ? "HID keyboard" : "");
+    }
+    return ESP_OK;
+}
+
+uint8_t usb_paddle_functions(void) {
+    return s_paddle.funcs;
+}
+
+void usb_paddle_task(void *arg) {
+    (void)arg;
+
+    if (s_paddle.funcs == 0) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    key_edge_ring_init(&s_paddle.ring, &g_keying_stream);
+    key_edge_stage_init(&s_paddle.stage, &g_keying_stream, &s_paddle.ring);
+    key_edge_reader_init(&s_paddle.edges, &s_paddle.ring);
+
+    key_edge_t now[KEY_EDGE_CH_COUNT];
+    key_edge_stage_levels(&s_paddle.stage, now);
+    for (int ch = 0; ch < KEY_EDGE_CH_COUNT; ch++) {
+        s_paddle.levels[ch] = now[ch].level;
+    }
+
+    s_paddle.stats.midi = (s_paddle.funcs & USB_FUNC_MIDI) != 0;
+    s_paddle.stats.hid_mode = s_paddle.hid_mode;
+
+    for (;;) {
+        poll();
+        vTaskDelay(pdMS_TO_TICKS(PADDLE_POLL_MS));
+    }
+}
+
+void usb_paddle_get_stats(usb_paddle_stats_t *out) {
+    *out = s_paddle.stats;
+}
+
+/*===========================================================================*/
+/* TinyUSB HID callbacks                                                     */
+/*===========================================================================*/
+
+uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance) {
+    (void)instance;
+    return usb_descriptors_hid_report();
+}
+
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id,
+                               hid_report_type_t report_type, uint8_t *buffer,
+                               uint16_t reqlen) {
+    (void)instance;
+    (void)report_id;
+    (void)report_type;
+    (void)buffer;
+    (void)reqlen;
+    return 0;  /* STALL: state only goes out on the interrupt endpoint */
+}
+
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id,
+                           hid_report_type_t report_type, uint8_t const *buffer,
+                           uint16_t bufsize) {
+    /* Keyboard LEDs: nothing to show */
+    (void)instance;
+    (void)report_id;
+    (void)report_type;
+    (void)buffer;
+    (void)bufsize;
+}
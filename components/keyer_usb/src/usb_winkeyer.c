@@ -1,26 +1,103 @@
 /**
  * @file usb_winkeyer.c
- * @brief CDC2 Winkeyer3 emulation (stub)
+ * @brief WinKeyer 2 host port on USB CDC1
  */
 
 #include "usb_winkeyer.h"
+#include "usb_cdc.h"
+#include "winkeyer_keyer.h"
+#include "config.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "tusb_cdc_acm.h"
 #include "esp_log.h"
 
 static const char *TAG = "usb_winkeyer";
 
+/** Status poll period: one USB full-speed frame */
+#define WK_POLL_TICKS pdMS_TO_TICKS(1)
+
+static bool s_enabled = false;
+static winkeyer_t s_wk;
+static TaskHandle_t s_task = NULL;
+static bool s_tx_pending = false;
+
+/**
+ * @brief RX callback for CDC1: wake the port task (it owns the engine)
+ */
+static void winkeyer_rx_callback(int itf, cdcacm_event_t *event) {
+    (void)event;
+
+    if (itf != TINYUSB_CDC_ACM_1 || s_task == NULL) {
+        return;
+    }
+    xTaskNotifyGive(s_task);
+}
+
+static void winkeyer_send(const uint8_t *data, size_t len, void *user_data) {
+    (void)user_data;
+    tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_1, data, len);
+    s_tx_pending = true;
+}
+
 esp_err_t usb_winkeyer_init(void) {
-    ESP_LOGI(TAG, "Winkeyer3 stub initialized (not implemented)");
-    /* TODO: Implement Winkeyer3 protocol on CDC2
-     * - Admin commands (0x00)
-     * - Speed (0x02), Sidetone (0x03), Weight (0x04)
-     * - PTT timing (0x05)
-     * - Clear buffer (0x0A)
-     * - Message slots (0x1x)
-     * - Status responses
-     */
+    s_enabled = CONFIG_GET_WK_USB();
+    if (s_enabled && !usb_cdc_port1_enabled()) {
+        ESP_LOGW(TAG, "WinKeyer USB off: CDC1 is taken by USB audio / MIDI / HID");
+        s_enabled = false;
+    }
+    if (s_enabled) {
+        ESP_LOGI(TAG, "WinKeyer 2 host port on CDC%d (log output off)", CDC_ITF_WINKEYER);
+    }
     return ESP_OK;
 }
 
 bool usb_winkeyer_is_enabled(void) {
-    return false;
+    return s_enabled;
+}
+
+const winkeyer_t *usb_winkeyer_engine(void) {
+    return s_enabled ? &s_wk : NULL;
+}
+
+void usb_winkeyer_task(void *arg) {
+    (void)arg;
+
+    if (!s_enabled) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    winkeyer_config_t cfg = {
+        .send_cb = winkeyer_send,
+        .action_cb = winkeyer_keyer_action,
+        .user_data = NULL,
+    };
+    winkeyer_init(&s_wk, &cfg);
+
+    /* Handle first, then the callback that uses it */
+    s_task = xTaskGetCurrentTaskHandle();
+    tinyusb_cdcacm_register_callback(TINYUSB_CDC_ACM_1, CDC_EVENT_RX, winkeyer_rx_callback);
+
+    uint8_t buf[64];
+    winkeyer_status_t status;
+    for (;;) {
+        /* Woken by RX, or after one frame for the status poll */
+        (void)ulTaskNotifyTake(pdTRUE, WK_POLL_TICKS);
+
+        size_t len = 0;
+        while (tinyusb_cdcacm_read(TINYUSB_CDC_ACM_1, buf, sizeof(buf), &len) == ESP_OK && len > 0) {
+            winkeyer_feed(&s_wk, buf, len);
+            len = 0;
+        }
+
+        winkeyer_keyer_status(&status);
+        winkeyer_update(&s_wk, &status);
+
+        if (s_tx_pending) {
+            s_tx_pending = false;
+            tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_1, 0);
+        }
+    }
 }
@@ -4,7 +4,8 @@
  *
  * Manages WireGuard VPN tunnel:
  * - Waits for WiFi connectivity
- * - Syncs time via NTP (required for WireGuard handshake)
+ * - Restores the persisted wall clock, or syncs via NTP when there is none
+ *   (the WireGuard handshake needs a timestamp newer than the last one)
  * - Establishes encrypted tunnel to server
  * - Reports state via atomic for monitoring
  *
@@ -17,6 +18,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "vpn_clock.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,7 +30,7 @@ extern "C" {
 typedef enum {
     VPN_STATE_DISABLED = 0,    /**< VPN disabled in config */
     VPN_STATE_WAITING_WIFI,    /**< Waiting for WiFi connection */
-    VPN_STATE_WAITING_TIME,    /**< Syncing time via NTP */
+    VPN_STATE_WAITING_TIME,    /**< Syncing time via NTP (no saved clock) */
     VPN_STATE_CONNECTING,      /**< WireGuard handshake in progress */
     VPN_STATE_CONNECTED,       /**< Tunnel established */
     VPN_STATE_FAILED,          /**< Connection failed */
@@ -70,6 +72,15 @@ typedef struct {
     uint64_t rx_bytes;          /**< Bytes received through tunnel */
     uint32_t handshakes;        /**< Number of successful handshakes */
     int64_t last_handshake_us;  /**< Timestamp of last handshake (us) */
+    uint32_t tx_packets;        /**< Data packets sealed (keepalives included) */
+    uint32_t rx_packets;        /**< Data packets authenticated */
+    uint32_t tx_cycles_avg;     /**< CPU cycles per sealed packet, last interval with traffic */
+    uint32_t tx_cycles_max;     /**< Worst sealed packet */
+    uint32_t rx_cycles_avg;     /**< CPU cycles per opened packet, last interval with traffic */
+    uint32_t rx_cycles_max;     /**< Worst opened packet */
+    uint32_t tx_pool_misses;    /**< Sealed packets that fell back to the lwIP heap */
+    uint32_t timer_wakeups;     /**< Driver timer runs (one per deadline, not per 400 ms) */
+    uint32_t keepalives;        /**< Keepalives sent (other tunnel traffic stands in for them) */
 } vpn_stats_t;
 
 /**
@@ -85,7 +96,7 @@ esp_err_t vpn_app_init(const vpn_config_app_t *config);
  *
  * Non-blocking. Spawns task on Core 1 that:
  * 1. Waits for WiFi
- * 2. Syncs time via NTP
+ * 2. Restores the saved wall clock, or waits for NTP without one
  * 3. Initiates WireGuard handshake
  *
  * Call vpn_get_state() to monitor progress.
@@ -117,14 +128,35 @@ vpn_state_t vpn_get_state(void);
  */
 bool vpn_is_connected(void);
 
+/**
+ * @brief Get this device's tunnel IP
+ *
+ * Set once the tunnel is configured; read it only while connected.
+ *
+ * @return Dotted-quad string, "" before the tunnel is set up (never NULL)
+ */
+const char *vpn_get_address(void);
+
 /**
  * @brief Get tunnel statistics
  *
+ * Data path counters are sampled by the VPN task every monitor interval
+ * (5 s), so they lag the tunnel by up to that much.
+ *
  * @param stats Output buffer for statistics
  * @return true if stats available (connected or was connected)
  */
 bool vpn_get_stats(vpn_stats_t *stats);
 
+/**
+ * @brief Get where the wall clock came from
+ *
+ * RTC/NVS estimates turn into VPN_CLOCK_NTP once SNTP completes.
+ *
+ * @return Clock source (thread-safe)
+ */
+vpn_clock_source_t vpn_get_clock_source(void);
+
 /**
  * @brief Get state as human-readable string
  *
@@ -0,0 +1,117 @@
+/**
+ * @file vpn_clock.h
+ * @brief Persisted wall clock so the tunnel need not wait for NTP
+ *
+ * A WireGuard handshake carries a TAI64N timestamp and the peer drops any
+ * initiation that is not newer than the last one it accepted, so the tunnel
+ * needs a wall clock that never goes back across reboots. It does not need
+ * the *right* time: NTP only has to be close enough for everything else.
+ *
+ * The last known wall time is kept paired with the RTC timer (which keeps
+ * counting through software resets and deep sleep) in an RTC_NOINIT record,
+ * and copied to NVS on clean shutdown and on every NTP sync. At boot:
+ * - RTC record valid: saved time + RTC time elapsed, corrected by the drift
+ *   learnt at the last NTP sync
+ * - Only the NVS copy (power cycle): the saved time itself, which is still
+ *   later than any handshake sent before a clean shutdown
+ * - Neither: wait for NTP as before
+ * NTP keeps running in the background and replaces the estimate when it
+ * completes.
+ *
+ * Pure arithmetic, no ESP-IDF calls: vpn.c owns the record.
+ */
+
+#ifndef KEYER_VPN_CLOCK_H
+#define KEYER_VPN_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Record magic ("WCLK") */
+#define VPN_CLOCK_MAGIC 0x57434C4BU
+
+/** Drift is only learnt over at least this much RTC time */
+#define VPN_CLOCK_MIN_LEARN_US (10LL * 60 * 1000000)
+
+/** Learnt drift is clamped to this (RC slow clock worst case) */
+#define VPN_CLOCK_MAX_DRIFT_PPM 50000
+
+/** Earliest plausible wall time: 2020-01-01 */
+#define VPN_CLOCK_MIN_UNIX_US (1577836800LL * 1000000)
+
+/**
+ * @brief Where the current wall time came from
+ */
+typedef enum {
+    VPN_CLOCK_NONE = 0,   /**< No valid time yet */
+    VPN_CLOCK_KEPT,       /**< System time survived the reset */
+    VPN_CLOCK_RTC,        /**< Restored from the RTC record */
+    VPN_CLOCK_NVS,        /**< Restored from the NVS copy (power cycle) */
+    VPN_CLOCK_NTP,        /**< Set by NTP */
+} vpn_clock_source_t;
+
+/**
+ * @brief Persisted wall-clock record
+ */
+typedef struct {
+    uint32_t magic;       /**< VPN_CLOCK_MAGIC when valid */
+    int32_t drift_ppm;    /**< RTC timer error learnt from NTP (+ = RTC slow) */
+    int64_t unix_us;      /**< Wall time at the save point */
+    int64_t rtc_us;       /**< RTC timer at the save point, -1 if unknown (NVS copy) */
+    int64_t sync_unix_us; /**< Wall time of the last NTP sync, 0 if none */
+    int64_t sync_rtc_us;  /**< RTC timer at the last NTP sync */
+} vpn_clock_rec_t;
+
+/**
+ * @brief Check a record (RTC_NOINIT memory is garbage after power-on)
+ */
+bool vpn_clock_valid(const vpn_clock_rec_t *rec);
+
+/**
+ * @brief Store a save point, keeping the learnt drift
+ *
+ * @param rec Record
+ * @param unix_us Current wall time (ignored if implausible)
+ * @param rtc_us Current RTC timer, -1 if unknown
+ */
+void vpn_clock_save(vpn_clock_rec_t *rec, int64_t unix_us, int64_t rtc_us);
+
+/**
+ * @brief Estimate the current wall time from a record
+ *
+ * Never earlier than the saved time. With an unknown or rewound RTC timer
+ * (power-on reset) the saved time itself is returned.
+ *
+ * @param rec Record
+ * @param rtc_us Current RTC timer
+ * @return Estimated wall time, 0 if the record is invalid
+ */
+int64_t vpn_clock_estimate(const vpn_clock_rec_t *rec, int64_t rtc_us);
+
+/**
+ * @brief Learn drift from an NTP sync, then save the synced time
+ *
+ * The drift is learnt between consecutive syncs (SNTP resyncs periodically)
+ * and only over at least VPN_CLOCK_MIN_LEARN_US of RTC time, so short
+ * intervals do not turn NTP rounding into a bogus correction.
+ *
+ * @param rec Record
+ * @param unix_us Wall time just set by NTP
+ * @param rtc_us Current RTC timer
+ */
+void vpn_clock_calibrate(vpn_clock_rec_t *rec, int64_t unix_us, int64_t rtc_us);
+
+/**
+ * @brief Get source name ("none", "kept", "rtc", "nvs", "ntp")
+ */
+const char *vpn_clock_source_str(vpn_clock_source_t source);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_VPN_CLOCK_H */
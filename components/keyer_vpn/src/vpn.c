@@ -4,14 +4,29 @@
  *
  * Implements WireGuard VPN tunnel:
  * - Waits for WiFi connectivity
- * - Syncs time via NTP (required for WireGuard handshake)
+ * - Restores the wall clock persisted across resets (vpn_clock.h), or waits
+ *   for NTP when there is none; NTP refreshes it in the background
  * - Establishes encrypted tunnel to server
  * - Reports state via atomic for monitoring
  *
  * Runs entirely on Core 1 (best-effort). Zero impact on RT path.
+ *
+ * The VPN task is static and lives for the whole uptime: vpn_app_start()
+ * wakes it for one session, vpn_app_stop() asks the session to end.
+ * Starting and stopping takes no heap.
+ *
+ * Without CONFIG_KEYER_VPN the API below is a stub that stays DISABLED.
  */
 
 #include "vpn.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+#define TAG "vpn"
+
+#ifdef CONFIG_KEYER_VPN
+
+#include "vpn_clock.h"
 #include "wifi.h"
 #include <string.h>
 #include <stdatomic.h>
@@ -19,12 +34,14 @@
 #include <sys/time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_rtc_time.h"
 #include "esp_sntp.h"
+#include "nvs.h"
 #include "esp_wireguard.h"
-
-#define TAG "vpn"
+#include "metrics.h"
 
 /* NTP timeout in milliseconds */
 #define NTP_TIMEOUT_MS      15000
@@ -32,19 +49,39 @@
 /* Task stack size (WireGuard crypto needs room) */
 #define VPN_TASK_STACK_SIZE 6144
 
+/* How long vpn_app_stop() waits for the session to end */
+#define STOP_WAIT_MS 1000
+
 /* Keepalive check interval */
 #define MONITOR_INTERVAL_MS 5000
 
+/* NVS copy of the wall clock (power cycles lose the RTC record) */
+#define CLOCK_NVS_NAMESPACE "vpn_clk"
+#define CLOCK_NVS_KEY_TIME  "unix_us"
+#define CLOCK_NVS_KEY_DRIFT "drift"
+
+/* Internal RAM: the task saves the wall clock to NVS */
+static StackType_t s_vpn_stack[VPN_TASK_STACK_SIZE];
+static StaticTask_t s_vpn_tcb;
+
+/* Wall clock record: survives software resets, garbage after power-on */
+static RTC_NOINIT_ATTR vpn_clock_rec_t s_rtc_clock;
+
 /* VPN state */
 static struct {
     bool initialized;
     vpn_config_app_t config;
     wireguard_config_t wg_config;
     wireguard_ctx_t wg_ctx;
-    TaskHandle_t task_handle;
+    TaskHandle_t task_handle;               /* Created on the first start */
+    atomic_bool running;                    /* A session is in progress */
+    atomic_bool stop;                       /* Session asked to end */
     _Atomic vpn_state_t state;
     vpn_stats_t stats;
-    bool time_synced;
+    wireguard_stats_t wg_last;  /* Driver counters at the previous sample */
+    bool sntp_started;
+    atomic_bool ntp_pending;                /* Set by the SNTP callback */
+    _Atomic vpn_clock_source_t clock_source;
     char ip_str[16];
     char mask_str[16];
 } s_vpn;
@@ -52,8 +89,12 @@ static struct {
 /* Forward declarations */
 static void vpn_task(void *pvParameters);
 static bool wait_for_time_sync(uint32_t timeout_ms);
+static bool prepare_time(void);
+static bool clock_tick(void);
+static void clock_shutdown_handler(void);
 static bool wait_for_wifi(uint32_t check_interval_ms);
 static esp_err_t setup_wireguard(void);
+static void sample_tunnel_stats(void);
 
 /* State names for logging */
 static const char *s_state_names[] = {
@@ -65,6 +106,39 @@ static const char *s_state_names[] = {
     [VPN_STATE_FAILED]       = "FAILED",
 };
 
+static int64_t metric_u64(const void *ctx)
+{
+    return (int64_t)*(const uint64_t *)ctx;
+}
+
+static int64_t metric_u32(const void *ctx)
+{
+    return (int64_t)*(const uint32_t *)ctx;
+}
+
+static int64_t metric_connected(const void *ctx)
+{
+    (void)ctx;
+    return vpn_is_connected() ? 1 : 0;
+}
+
+static const metric_desc_t k_vpn_metrics[] = {
+    { "keyer_vpn_connected", "1 while the WireGuard tunnel is up", METRIC_GAUGE,
+      metric_connected, NULL },
+    { "keyer_vpn_tx_bytes_total", "Bytes sent through the tunnel", METRIC_COUNTER,
+      metric_u64, &s_vpn.stats.tx_bytes },
+    { "keyer_vpn_rx_bytes_total", "Bytes received through the tunnel", METRIC_COUNTER,
+      metric_u64, &s_vpn.stats.rx_bytes },
+    { "keyer_vpn_tx_packets_total", "Data packets sealed", METRIC_COUNTER,
+      metric_u32, &s_vpn.stats.tx_packets },
+    { "keyer_vpn_rx_packets_total", "Data packets authenticated", METRIC_COUNTER,
+      metric_u32, &s_vpn.stats.rx_packets },
+    { "keyer_vpn_handshakes_total", "Successful handshakes", METRIC_COUNTER,
+      metric_u32, &s_vpn.stats.handshakes },
+    { "keyer_vpn_tx_pool_misses_total", "Sealed packets that fell back to the lwIP heap",
+      METRIC_COUNTER, metric_u32, &s_vpn.stats.tx_pool_misses },
+};
+
 esp_err_t vpn_app_init(const vpn_config_app_t *config)
 {
     if (config == NULL) {
@@ -83,8 +157,19 @@ esp_err_t vpn_app_init(const vpn_config_app_t *config)
     atomic_store_explicit(&s_vpn.state, VPN_STATE_DISABLED, memory_order_relaxed);
     memset(&s_vpn.stats, 0, sizeof(vpn_stats_t));
     s_vpn.task_handle = NULL;
-    s_vpn.time_synced = false;
+    atomic_init(&s_vpn.running, false);
+    atomic_init(&s_vpn.stop, false);
+    s_vpn.sntp_started = false;
+    atomic_init(&s_vpn.ntp_pending, false);
+    atomic_init(&s_vpn.clock_source, VPN_CLOCK_NONE);
     s_vpn.initialized = true;
+    metrics_register_all(&g_metrics, k_vpn_metrics, sizeof(k_vpn_metrics) / sizeof(k_vpn_metrics[0]));
+
+    /* esp_restart() paths (reboot, OTA) leave the clock in NVS */
+    esp_err_t ret = esp_register_shutdown_handler(clock_shutdown_handler);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Clock shutdown handler: %s", esp_err_to_name(ret));
+    }
 
     ESP_LOGI(TAG, "VPN initialized");
     return ESP_OK;
@@ -98,7 +183,7 @@ esp_err_t vpn_app_start(void)
     }
 
     /* Check if already running */
-    if (s_vpn.task_handle != NULL) {
+    if (atomic_load_explicit(&s_vpn.running, memory_order_acquire)) {
         ESP_LOGW(TAG, "VPN task already running");
         return ESP_OK;
     }
@@ -129,22 +214,28 @@ esp_err_t vpn_app_start(void)
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Create VPN task on Core 1 */
-    BaseType_t task_ret = xTaskCreatePinnedToCore(
-        vpn_task,
-        "vpn_task",
-        VPN_TASK_STACK_SIZE,
-        NULL,
-        5,                  /* Same priority as WiFi task */
-        &s_vpn.task_handle,
-        1                   /* Core 1 only - keep RT path on Core 0 clean */
-    );
-
-    if (task_ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create VPN task");
-        return ESP_ERR_NO_MEM;
+    /* Create VPN task on Core 1 (once; later starts wake it) */
+    if (s_vpn.task_handle == NULL) {
+        s_vpn.task_handle = xTaskCreateStaticPinnedToCore(
+            vpn_task,
+            "vpn_task",
+            sizeof(s_vpn_stack),
+            NULL,
+            5,                  /* Same priority as WiFi task */
+            s_vpn_stack,
+            &s_vpn_tcb,
+            1                   /* Core 1 only - keep RT path on Core 0 clean */
+        );
+        if (s_vpn.task_handle == NULL) {
+            ESP_LOGE(TAG, "Failed to create VPN task");
+            return ESP_ERR_NO_MEM;
+        }
     }
 
+    atomic_store_explicit(&s_vpn.stop, false, memory_order_relaxed);
+    atomic_store_explicit(&s_vpn.running, true, memory_order_release);
+    xTaskNotifyGive(s_vpn.task_handle);
+
     ESP_LOGI(TAG, "VPN start initiated");
     return ESP_OK;
 }
@@ -155,26 +246,19 @@ void vpn_app_stop(void)
         return;
     }
 
-    /* Disconnect WireGuard */
-    vpn_state_t current_state = atomic_load_explicit(&s_vpn.state, memory_order_relaxed);
-    if (current_state == VPN_STATE_CONNECTED || current_state == VPN_STATE_CONNECTING) {
-        ESP_LOGI(TAG, "Disconnecting WireGuard tunnel");
-        esp_wireguard_disconnect(&s_vpn.wg_ctx);
-    }
-
-    /* Stop task if running */
-    if (s_vpn.task_handle != NULL) {
-        /* Signal task to stop by setting state */
-        atomic_store_explicit(&s_vpn.state, VPN_STATE_DISABLED, memory_order_release);
+    /* Ask the session to end; it disconnects the tunnel on its way out */
+    if (atomic_load_explicit(&s_vpn.running, memory_order_acquire)) {
+        atomic_store_explicit(&s_vpn.stop, true, memory_order_release);
+        xTaskNotifyGive(s_vpn.task_handle);     /* Cut the monitor sleep short */
 
-        /* Give task time to notice and exit */
-        vTaskDelay(pdMS_TO_TICKS(100));
-
-        /* If task still running, delete it */
-        if (eTaskGetState(s_vpn.task_handle) != eDeleted) {
-            vTaskDelete(s_vpn.task_handle);
+        for (uint32_t waited = 0; waited < STOP_WAIT_MS &&
+             atomic_load_explicit(&s_vpn.running, memory_order_acquire); waited += 10) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        if (atomic_load_explicit(&s_vpn.running, memory_order_acquire)) {
+            ESP_LOGW(TAG, "VPN session still ending");
+            return;
         }
-        s_vpn.task_handle = NULL;
     }
 
     atomic_store_explicit(&s_vpn.state, VPN_STATE_DISABLED, memory_order_relaxed);
@@ -191,6 +275,11 @@ bool vpn_is_connected(void)
     return (vpn_get_state() == VPN_STATE_CONNECTED);
 }
 
+const char *vpn_get_address(void)
+{
+    return s_vpn.ip_str;
+}
+
 bool vpn_get_stats(vpn_stats_t *stats)
 {
     if (stats == NULL) {
@@ -201,6 +290,11 @@ bool vpn_get_stats(vpn_stats_t *stats)
     return true;
 }
 
+vpn_clock_source_t vpn_get_clock_source(void)
+{
+    return atomic_load_explicit(&s_vpn.clock_source, memory_order_relaxed);
+}
+
 const char *vpn_state_str(vpn_state_t state)
 {
     if (state < sizeof(s_state_names) / sizeof(s_state_names[0])) {
@@ -217,7 +311,7 @@ static bool wait_for_wifi(uint32_t check_interval_ms)
 
     while (!wifi_is_connected()) {
         /* Check if we should stop */
-        if (atomic_load_explicit(&s_vpn.state, memory_order_acquire) == VPN_STATE_DISABLED) {
+        if (atomic_load_explicit(&s_vpn.stop, memory_order_acquire)) {
             return false;
         }
         vTaskDelay(pdMS_TO_TICKS(check_interval_ms));
@@ -227,41 +321,150 @@ static bool wait_for_wifi(uint32_t check_interval_ms)
     return true;
 }
 
-/* NTP time sync callback */
-static void time_sync_notification_cb(struct timeval *tv)
+/* Current wall time */
+static int64_t wall_now_us(void)
 {
-    (void)tv;
-    ESP_LOGI(TAG, "NTP time synchronized");
-    s_vpn.time_synced = true;
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
 }
 
-/* Wait for NTP time sync */
-static bool wait_for_time_sync(uint32_t timeout_ms)
+static void set_wall_us(int64_t unix_us)
 {
-    ESP_LOGI(TAG, "Starting NTP time sync...");
-    atomic_store_explicit(&s_vpn.state, VPN_STATE_WAITING_TIME, memory_order_release);
+    struct timeval tv = {
+        .tv_sec = (time_t)(unix_us / 1000000),
+        .tv_usec = (suseconds_t)(unix_us % 1000000),
+    };
+    settimeofday(&tv, NULL);
+}
 
-    /* Check if time is already valid (from previous sync or RTC) */
+static void log_wall_time(const char *what)
+{
     time_t now = 0;
     struct tm timeinfo = {0};
     time(&now);
     localtime_r(&now, &timeinfo);
+    ESP_LOGI(TAG, "%s: %d-%02d-%02d %02d:%02d:%02d", what,
+             timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+             timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+}
+
+/* Write the clock record's time and drift to NVS */
+static void clock_save_nvs(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(CLOCK_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    esp_err_t err = nvs_set_i64(handle, CLOCK_NVS_KEY_TIME, s_rtc_clock.unix_us);
+    if (err == ESP_OK) {
+        err = nvs_set_i32(handle, CLOCK_NVS_KEY_DRIFT, s_rtc_clock.drift_ppm);
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Clock save failed: %s", esp_err_to_name(err));
+    }
+}
 
-    if (timeinfo.tm_year >= (2020 - 1900)) {
-        ESP_LOGI(TAG, "System time already valid: %d-%02d-%02d %02d:%02d:%02d",
-                 timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                 timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-        return true;
+/* Load the NVS copy as a record without an RTC save point */
+static bool clock_load_nvs(vpn_clock_rec_t *rec)
+{
+    nvs_handle_t handle;
+    if (nvs_open(CLOCK_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    int64_t unix_us = 0;
+    int32_t drift = 0;
+    bool ok = nvs_get_i64(handle, CLOCK_NVS_KEY_TIME, &unix_us) == ESP_OK;
+    (void)nvs_get_i32(handle, CLOCK_NVS_KEY_DRIFT, &drift);
+    nvs_close(handle);
+    if (!ok) {
+        return false;
     }
 
-    /* Initialize SNTP */
-    s_vpn.time_synced = false;
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = VPN_CLOCK_MAGIC;
+    rec->drift_ppm = drift;
+    rec->unix_us = unix_us;
+    rec->rtc_us = -1;
+    return vpn_clock_valid(rec);
+}
+
+/* Clean shutdown: last save point to NVS */
+static void clock_shutdown_handler(void)
+{
+    if (atomic_load_explicit(&s_vpn.clock_source, memory_order_relaxed) == VPN_CLOCK_NONE) {
+        return;
+    }
+    vpn_clock_save(&s_rtc_clock, wall_now_us(), esp_rtc_get_time_us());
+    clock_save_nvs();
+}
 
+/* NTP time sync callback (lwIP context: only flag it) */
+static void time_sync_notification_cb(struct timeval *tv)
+{
+    (void)tv;
+    atomic_store_explicit(&s_vpn.ntp_pending, true, memory_order_release);
+}
+
+/* Start SNTP once; it keeps running and resyncs periodically */
+static void start_sntp(void)
+{
+    if (s_vpn.sntp_started) {
+        return;
+    }
     esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
     esp_sntp_setservername(0, "pool.ntp.org");
     esp_sntp_setservername(1, "time.google.com");
     esp_sntp_set_time_sync_notification_cb(time_sync_notification_cb);
     esp_sntp_init();
+    s_vpn.sntp_started = true;
+}
+
+/**
+ * @brief Fold a pending NTP sync into the clock record, else save a point
+ *
+ * VPN task only. RTC memory is cheap to write, so the record follows the
+ * wall clock every monitor pass; NVS is written only on NTP syncs (and on
+ * clean shutdown) to spare the flash.
+ *
+ * @return true if NTP replaced a restored estimate
+ */
+static bool clock_tick(void)
+{
+    int64_t rtc_us = esp_rtc_get_time_us();
+    vpn_clock_source_t source = atomic_load_explicit(&s_vpn.clock_source, memory_order_relaxed);
+
+    if (atomic_exchange_explicit(&s_vpn.ntp_pending, false, memory_order_acquire)) {
+        int64_t now_us = wall_now_us();
+        bool estimated = (source == VPN_CLOCK_RTC || source == VPN_CLOCK_NVS);
+        if (estimated) {
+            /* The record still follows the estimate: compare before calibrating */
+            int64_t err_ms = (now_us - vpn_clock_estimate(&s_rtc_clock, rtc_us)) / 1000;
+            ESP_LOGI(TAG, "NTP replaced %s estimate (off by %lld ms)",
+                     vpn_clock_source_str(source), (long long)err_ms);
+        }
+        vpn_clock_calibrate(&s_rtc_clock, now_us, rtc_us);
+        atomic_store_explicit(&s_vpn.clock_source, VPN_CLOCK_NTP, memory_order_relaxed);
+        clock_save_nvs();
+        log_wall_time("NTP time synchronized");
+        return estimated;
+    }
+
+    if (source != VPN_CLOCK_NONE) {
+        vpn_clock_save(&s_rtc_clock, wall_now_us(), rtc_us);
+    }
+    return false;
+}
+
+/* Wait for NTP time sync (nothing to restore the clock from) */
+static bool wait_for_time_sync(uint32_t timeout_ms)
+{
+    ESP_LOGI(TAG, "No saved clock, waiting for NTP...");
+    atomic_store_explicit(&s_vpn.state, VPN_STATE_WAITING_TIME, memory_order_release);
 
     /* Wait for time sync or timeout */
     uint32_t elapsed = 0;
@@ -269,40 +472,67 @@ static bool wait_for_time_sync(uint32_t timeout_ms)
 
     while (elapsed < timeout_ms) {
         /* Check if we should stop */
-        if (atomic_load_explicit(&s_vpn.state, memory_order_acquire) == VPN_STATE_DISABLED) {
-            esp_sntp_stop();
+        if (atomic_load_explicit(&s_vpn.stop, memory_order_acquire)) {
             return false;
         }
 
         /* Check if callback fired */
-        if (s_vpn.time_synced) {
-            break;
-        }
-
-        /* Check sync status */
-        if (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED) {
-            break;
+        if (atomic_load_explicit(&s_vpn.ntp_pending, memory_order_acquire)) {
+            clock_tick();
+            return true;
         }
 
         vTaskDelay(pdMS_TO_TICKS(poll_interval));
         elapsed += poll_interval;
     }
 
-    esp_sntp_stop();
+    ESP_LOGW(TAG, "Time sync failed after %lu ms", (unsigned long)elapsed);
+    return false;
+}
 
-    /* Verify time is now valid */
-    time(&now);
-    localtime_r(&now, &timeinfo);
+/**
+ * @brief Get a wall clock good enough for a handshake
+ *
+ * A handshake only needs a timestamp later than the previous one, so a
+ * restored estimate lets the tunnel start without waiting for NTP, which
+ * keeps running and replaces the estimate when it completes.
+ */
+static bool prepare_time(void)
+{
+    start_sntp();
 
-    if (timeinfo.tm_year >= (2020 - 1900)) {
-        ESP_LOGI(TAG, "Time synced: %d-%02d-%02d %02d:%02d:%02d",
-                 timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                 timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-        return true;
+    vpn_clock_source_t source = VPN_CLOCK_NONE;
+    if (wall_now_us() >= VPN_CLOCK_MIN_UNIX_US) {
+        /* Software reset with the RTC-backed system time intact */
+        source = VPN_CLOCK_KEPT;
+    } else {
+        int64_t est_us = vpn_clock_estimate(&s_rtc_clock, esp_rtc_get_time_us());
+        if (est_us > 0) {
+            source = VPN_CLOCK_RTC;
+        } else {
+            vpn_clock_rec_t saved;
+            if (clock_load_nvs(&saved)) {
+                /* RTC record lost: keep the learnt drift for the next reset */
+                s_rtc_clock = saved;
+                est_us = saved.unix_us;
+                source = VPN_CLOCK_NVS;
+            }
+        }
+        if (source != VPN_CLOCK_NONE) {
+            set_wall_us(est_us);
+        }
     }
 
-    ESP_LOGW(TAG, "Time sync failed after %lu ms", (unsigned long)elapsed);
-    return false;
+    if (source == VPN_CLOCK_NONE) {
+        return wait_for_time_sync(NTP_TIMEOUT_MS);
+    }
+
+    atomic_store_explicit(&s_vpn.clock_source, source, memory_order_relaxed);
+    vpn_clock_save(&s_rtc_clock, wall_now_us(), esp_rtc_get_time_us());
+    ESP_LOGI(TAG, "Wall clock from %s, NTP refreshing in background",
+             vpn_clock_source_str(source));
+    log_wall_time("Handshake time");
+    return true;
 }
 
 /* Setup WireGuard configuration */
@@ -366,27 +596,57 @@ static esp_err_t setup_wireguard(void)
     return ESP_OK;
 }
 
-/* VPN task */
-static void vpn_task(void *pvParameters)
+/**
+ * @brief Fold the driver's data path counters into s_vpn.stats
+ *
+ * Only the VPN task calls this, so the interface cannot be torn down under
+ * it. Driver counters are 32-bit and wrap, so everything is taken as a
+ * delta since the previous sample: bytes add up into the 64-bit totals,
+ * cycles are averaged over the packets of the interval.
+ */
+static void sample_tunnel_stats(void)
 {
-    (void)pvParameters;
+    wireguard_stats_t wg;
+    if (esp_wireguard_get_stats(&s_vpn.wg_ctx, &wg) != ESP_OK) {
+        return;
+    }
 
-    ESP_LOGI(TAG, "VPN task started on Core %d", xPortGetCoreID());
+    vpn_stats_t *st = &s_vpn.stats;
+    st->tx_bytes += (uint32_t)(wg.tx_bytes - s_vpn.wg_last.tx_bytes);
+    st->rx_bytes += (uint32_t)(wg.rx_bytes - s_vpn.wg_last.rx_bytes);
+    st->tx_packets = wg.tx_packets;
+    st->rx_packets = wg.rx_packets;
+    uint32_t tx_new = wg.tx_packets - s_vpn.wg_last.tx_packets;
+    if (tx_new > 0) {
+        st->tx_cycles_avg = (wg.tx_cycles - s_vpn.wg_last.tx_cycles) / tx_new;
+    }
+    uint32_t rx_new = wg.rx_packets - s_vpn.wg_last.rx_packets;
+    if (rx_new > 0) {
+        st->rx_cycles_avg = (wg.rx_cycles - s_vpn.wg_last.rx_cycles) / rx_new;
+    }
+    st->tx_cycles_max = wg.tx_cycles_max;
+    st->rx_cycles_max = wg.rx_cycles_max;
+    st->tx_pool_misses = wg.tx_pool_misses;
+    st->timer_wakeups = wg.timer_wakeups;
+    st->keepalives = wg.keepalives;
+    s_vpn.wg_last = wg;
+}
+
+/* One session: connect, then keep the tunnel up until asked to stop */
+static void vpn_session(void)
+{
+    ESP_LOGI(TAG, "VPN session started on Core %d", xPortGetCoreID());
 
     /* Step 1: Wait for WiFi */
     if (!wait_for_wifi(500)) {
         ESP_LOGW(TAG, "VPN task stopping (WiFi wait aborted)");
-        s_vpn.task_handle = NULL;
-        vTaskDelete(NULL);
         return;
     }
 
-    /* Step 2: Sync time via NTP */
-    if (!wait_for_time_sync(NTP_TIMEOUT_MS)) {
+    /* Step 2: Wall clock (restored, or NTP when there is nothing to restore) */
+    if (!prepare_time()) {
         ESP_LOGE(TAG, "NTP time sync failed - WireGuard requires valid time");
         atomic_store_explicit(&s_vpn.state, VPN_STATE_FAILED, memory_order_release);
-        s_vpn.task_handle = NULL;
-        vTaskDelete(NULL);
         return;
     }
 
@@ -395,8 +655,6 @@ static void vpn_task(void *pvParameters)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "WireGuard setup failed");
         atomic_store_explicit(&s_vpn.state, VPN_STATE_FAILED, memory_order_release);
-        s_vpn.task_handle = NULL;
-        vTaskDelete(NULL);
         return;
     }
 
@@ -408,8 +666,6 @@ static void vpn_task(void *pvParameters)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "esp_wireguard_connect failed: %s", esp_err_to_name(ret));
         atomic_store_explicit(&s_vpn.state, VPN_STATE_FAILED, memory_order_release);
-        s_vpn.task_handle = NULL;
-        vTaskDelete(NULL);
         return;
     }
 
@@ -420,10 +676,16 @@ static void vpn_task(void *pvParameters)
     ESP_LOGI(TAG, "VPN tunnel established");
 
     /* Step 5: Monitor loop */
-    while (atomic_load_explicit(&s_vpn.state, memory_order_acquire) != VPN_STATE_DISABLED) {
+    while (!atomic_load_explicit(&s_vpn.stop, memory_order_acquire)) {
+        /* NTP may have replaced the estimate the last handshake was refused with */
+        bool refreshed = clock_tick();
+
         /* Check if peer is still up */
         ret = esp_wireguardif_peer_is_up(&s_vpn.wg_ctx);
         if (ret != ESP_OK) {
+            if (refreshed) {
+                ESP_LOGI(TAG, "Retrying handshake with NTP time");
+            }
             /* Tunnel down - try to reconnect */
             ESP_LOGW(TAG, "VPN tunnel down, reconnecting...");
             atomic_store_explicit(&s_vpn.state, VPN_STATE_CONNECTING, memory_order_release);
@@ -446,16 +708,87 @@ static void vpn_task(void *pvParameters)
             } else {
                 ESP_LOGE(TAG, "Reconnect failed: %s", esp_err_to_name(ret));
                 atomic_store_explicit(&s_vpn.state, VPN_STATE_FAILED, memory_order_release);
-                vTaskDelay(pdMS_TO_TICKS(5000));  /* Back off before retry */
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5000));  /* Back off before retry */
             }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(MONITOR_INTERVAL_MS));
+        sample_tunnel_stats();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MONITOR_INTERVAL_MS));
     }
 
     /* Cleanup */
     ESP_LOGI(TAG, "VPN task stopping");
+    sample_tunnel_stats();
     esp_wireguard_disconnect(&s_vpn.wg_ctx);
-    s_vpn.task_handle = NULL;
-    vTaskDelete(NULL);
+    memset(&s_vpn.wg_last, 0, sizeof(s_vpn.wg_last));  /* Next interface counts from 0 */
+}
+
+/* VPN task: one session per vpn_app_start() */
+static void vpn_task(void *pvParameters)
+{
+    (void)pvParameters;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!atomic_load_explicit(&s_vpn.running, memory_order_acquire)) {
+            continue;   /* A stop notification that arrived after the session */
+        }
+        vpn_session();
+        if (atomic_load_explicit(&s_vpn.stop, memory_order_acquire)) {
+            atomic_store_explicit(&s_vpn.state, VPN_STATE_DISABLED, memory_order_release);
+        }
+        atomic_store_explicit(&s_vpn.running, false, memory_order_release);
+    }
+}
+
+#else
+/* WireGuard not built in: the tunnel is never up */
+
+esp_err_t vpn_app_init(const vpn_config_app_t *config)
+{
+    (void)config;
+    ESP_LOGW(TAG, "VPN not built in (CONFIG_KEYER_VPN)");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t vpn_app_start(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void vpn_app_stop(void)
+{
+}
+
+vpn_state_t vpn_get_state(void)
+{
+    return VPN_STATE_DISABLED;
 }
+
+bool vpn_is_connected(void)
+{
+    return false;
+}
+
+const char *vpn_get_address(void)
+{
+    return "";
+}
+
+bool vpn_get_stats(vpn_stats_t *stats)
+{
+    (void)stats;
+    return false;
+}
+
+vpn_clock_source_t vpn_get_clock_source(void)
+{
+    return VPN_CLOCK_NONE;
+}
+
+const char *vpn_state_str(vpn_state_t state)
+{
+    return (state == VPN_STATE_DISABLED) ? "DISABLED" : "UNKNOWN";
+}
+
+#endif
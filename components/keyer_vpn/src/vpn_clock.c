@@ -0,0 +1,73 @@
+/**
+ * @file vpn_clock.c
+ * @brief Persisted wall clock so the tunnel need not wait for NTP
+ */
+
+#include "vpn_clock.h"
+#include <string.h>
+
+bool vpn_clock_valid(const vpn_clock_rec_t *rec) {
+    return rec->magic == VPN_CLOCK_MAGIC &&
+           rec->unix_us >= VPN_CLOCK_MIN_UNIX_US &&
+           rec->drift_ppm >= -VPN_CLOCK_MAX_DRIFT_PPM &&
+           rec->drift_ppm <= VPN_CLOCK_MAX_DRIFT_PPM;
+}
+
+void vpn_clock_save(vpn_clock_rec_t *rec, int64_t unix_us, int64_t rtc_us) {
+    if (unix_us < VPN_CLOCK_MIN_UNIX_US) {
+        return;
+    }
+    if (!vpn_clock_valid(rec)) {
+        memset(rec, 0, sizeof(*rec));
+        rec->magic = VPN_CLOCK_MAGIC;
+    }
+    rec->unix_us = unix_us;
+    rec->rtc_us = rtc_us;
+}
+
+int64_t vpn_clock_estimate(const vpn_clock_rec_t *rec, int64_t rtc_us) {
+    if (!vpn_clock_valid(rec)) {
+        return 0;
+    }
+    if (rec->rtc_us < 0 || rtc_us < rec->rtc_us) {
+        return rec->unix_us;
+    }
+    int64_t elapsed = rtc_us - rec->rtc_us;
+    return rec->unix_us + elapsed + elapsed * rec->drift_ppm / 1000000;
+}
+
+void vpn_clock_calibrate(vpn_clock_rec_t *rec, int64_t unix_us, int64_t rtc_us) {
+    if (unix_us < VPN_CLOCK_MIN_UNIX_US) {
+        return;
+    }
+    if (vpn_clock_valid(rec) && rec->sync_unix_us > 0 && rtc_us >= rec->sync_rtc_us) {
+        int64_t rtc_elapsed = rtc_us - rec->sync_rtc_us;
+        if (rtc_elapsed >= VPN_CLOCK_MIN_LEARN_US) {
+            /* Clamp the error first: a stepped clock must not overflow */
+            int64_t err = unix_us - rec->sync_unix_us - rtc_elapsed;
+            int64_t err_max = rtc_elapsed / 1000000 * VPN_CLOCK_MAX_DRIFT_PPM;
+            if (err > err_max) {
+                rec->drift_ppm = VPN_CLOCK_MAX_DRIFT_PPM;
+            } else if (err < -err_max) {
+                rec->drift_ppm = -VPN_CLOCK_MAX_DRIFT_PPM;
+            } else {
+                rec->drift_ppm = (int32_t)(err * 1000000 / rtc_elapsed);
+            }
+        }
+    }
+
+    vpn_clock_save(rec, unix_us, rtc_us);
+    rec->sync_unix_us = unix_us;
+    rec->sync_rtc_us = rtc_us;
+}
+
+const char *vpn_clock_source_str(vpn_clock_source_t source) {
+    switch (source) {
+        case VPN_CLOCK_NONE: return "none";
+        case VPN_CLOCK_KEPT: return "kept";
+        case VPN_CLOCK_RTC:  return "rtc";
+        case VPN_CLOCK_NVS:  return "nvs";
+        case VPN_CLOCK_NTP:  return "ntp";
+        default:             return "unknown";
+    }
+}
@@ -2,12 +2,15 @@ import type {
   DeviceStatus,
   SystemStats,
   DecoderStatus,
+  DecoderText,
   TimelineConfig,
   ConfigSchema,
   ConfigValues,
   TextKeyerStatus,
   MemorySlot,
-  VpnStatus
+  VpnStatus,
+  LogEntry,
+  LogLevel
 } from './types';
 
 class ApiClient {
@@ -48,6 +51,11 @@ class ApiClient {
   }
 
   async setParameter(param: string, value: number | boolean | string): Promise<void> {
+    const reply = await this.command({ type: 'param', param, value });
+    if (reply) {
+      if (!reply.ok) throw new Error(`API error: ${(reply as WSMessageParam).error ?? 'rejected'}`);
+      return;
+    }
     await this.fetchJson('/api/parameter', {
       method: 'POST',
       headers: { 'Content-Type': 'application/json' },
@@ -55,16 +63,50 @@ class ApiClient {
     });
   }
 
+  // Applied together under one config generation; save=true persists them too
+  async setParameters(values: Record<string, number | boolean | string>, save = false): Promise<void> {
+    await this.fetchJson('/api/parameters/batch', {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/json' },
+      body: JSON.stringify({ values, save })
+    });
+  }
+
   async saveConfig(reboot = false): Promise<void> {
     const url = reboot ? '/api/config/save?reboot=true' : '/api/config/save';
     await this.fetchJson(url, { method: 'POST' });
   }
 
+  // Binary settings profile: every parameter plus the text memories
+  async exportProfile(): Promise<Blob> {
+    const response = await fetch(`${this.baseUrl}/api/config/profile`);
+    if (!response.ok) {
+      throw new Error(`API error: ${response.statusText}`);
+    }
+    return response.blob();
+  }
+
+  async importProfile(profile: Blob): Promise<{ applied: number; skipped: number; memories: number }> {
+    const response = await fetch(`${this.baseUrl}/api/config/profile`, {
+      method: 'PUT',
+      headers: { 'Content-Type': 'application/octet-stream' },
+      body: profile
+    });
+    if (!response.ok) {
+      throw new Error((await response.text()) || `API error: ${response.statusText}`);
+    }
+    return response.json();
+  }
+
   // Decoder
   async getDecoderStatus(): Promise<DecoderStatus> {
     return this.fetchJson('/api/decoder/status');
   }
 
+  async getDecoderText(since: number): Promise<DecoderText> {
+    return this.fetchJson(`/api/decoder/text?since=${since}`);
+  }
+
   async setDecoderEnabled(enabled: boolean): Promise<void> {
     await this.fetchJson('/api/decoder/enable', {
       method: 'POST',
@@ -80,6 +122,7 @@ class ApiClient {
 
   // Text Keyer
   async sendText(text: string): Promise<void> {
+    if (await this.textCommand({ type: 'text', data: text })) return;
     await this.fetchJson('/api/text/send', {
       method: 'POST',
       headers: { 'Content-Type': 'application/json' },
@@ -91,18 +134,87 @@ class ApiClient {
     return this.fetchJson('/api/text/status');
   }
 
+  // Take back queued text: the newest character, or the rest of the newest send
+  async cancelText(message: boolean): Promise<{ removed: number }> {
+    const reply = await this.command({ type: message ? 'text_cancel' : 'text_back' });
+    if (reply) return { removed: (reply as WSMessageTextStatus).removed ?? 0 };
+    return this.fetchJson('/api/text/cancel', {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/json' },
+      body: JSON.stringify({ message })
+    });
+  }
+
+  // Keystrokes over the open WebSocket (answered with a text_status frame)
+  sendTextKeys(data: string): boolean {
+    return this.sendCommand({ type: 'text', data });
+  }
+
+  sendTextBackspace(): boolean {
+    return this.sendCommand({ type: 'text_back' });
+  }
+
+  private sendCommand(cmd: object): boolean {
+    return this.sendFrame(JSON.stringify(cmd));
+  }
+
+  private sendFrame(frame: string): boolean {
+    if (this.ws?.readyState !== WebSocket.OPEN) return false;
+    this.ws.send(frame);
+    return true;
+  }
+
+  // Command over the open WebSocket, resolved by the reply carrying its id.
+  // null when the socket is closed or the frame would not fit: use HTTP.
+  private command(cmd: Record<string, unknown>): Promise<WSReply | null> {
+    const id = this.nextCommandId++;
+    const frame = JSON.stringify({ ...cmd, id });
+    if (new TextEncoder().encode(frame).length > WS_COMMAND_MAX || !this.sendFrame(frame)) {
+      return Promise.resolve(null);
+    }
+    return new Promise((resolve, reject) => {
+      const timer = setTimeout(() => {
+        this.pending.delete(id);
+        reject(new Error('No reply from device'));
+      }, WS_COMMAND_TIMEOUT_MS);
+      this.pending.set(id, { resolve, reject, timer });
+    });
+  }
+
+  // Text keyer command; true when the device took it over the WebSocket
+  private async textCommand(cmd: Record<string, unknown>): Promise<boolean> {
+    const reply = await this.command(cmd);
+    if (reply && !reply.ok) throw new Error('API error: rejected');
+    return reply !== null;
+  }
+
   async abortText(): Promise<void> {
+    if (await this.textCommand({ type: 'text_abort' })) return;
     await this.fetchJson('/api/text/abort', { method: 'POST' });
   }
 
   async pauseText(): Promise<void> {
+    if (await this.textCommand({ type: 'text_pause' })) return;
     await this.fetchJson('/api/text/pause', { method: 'POST' });
   }
 
   async resumeText(): Promise<void> {
+    if (await this.textCommand({ type: 'text_resume' })) return;
     await this.fetchJson('/api/text/resume', { method: 'POST' });
   }
 
+  // Log subscription: records arrive through onLog, the held history first.
+  // 'OFF' (everywhere) ends it. Resolves false if the device refused it.
+  async subscribeLog(level: LogLevel, tags: Partial<Record<'RT' | 'BG', LogLevel>> = {}): Promise<boolean> {
+    const reply = await this.command({ type: 'log', level, tags });
+    return reply?.ok ?? false;
+  }
+
+  // Ask for a text_status frame (delivered to onTextStatus)
+  requestTextStatus(): boolean {
+    return this.sendCommand({ type: 'text_status' });
+  }
+
   async getMemorySlots(): Promise<{ slots: MemorySlot[] }> {
     return this.fetchJson('/api/text/memory');
   }
@@ -116,6 +228,7 @@ class ApiClient {
   }
 
   async playMemorySlot(slot: number): Promise<void> {
+    if (await this.textCommand({ type: 'memory_play', slot })) return;
     await this.fetchJson('/api/text/play', {
       method: 'POST',
       headers: { 'Content-Type': 'application/json' },
@@ -132,7 +245,11 @@ class ApiClient {
   private ws: WebSocket | null = null;
   private wsCallbacks: WSCallbacks = {};
   private reconnectTimer: ReturnType<typeof setTimeout> | null = null;
+  private keepaliveTimer: ReturnType<typeof setInterval> | null = null;
   private intentionalDisconnect = false;
+  private nextCommandId = 1;
+  private pending = new Map<number, PendingCommand>();
+  private deltaSeq: number | null = null;
 
   // Time synchronization: map device timestamps to browser time
   private deviceBaseTime: number | null = null;
@@ -152,8 +269,18 @@ class ApiClient {
     const url = `${protocol}//${host}/ws`;
 
     this.ws = new WebSocket(url);
+    this.ws.binaryType = 'arraybuffer';
 
     this.ws.onopen = () => {
+      this.deltaSeq = null;
+      // Only what this page shows: the device does no work for a topic
+      // nobody is subscribed to
+      if (this.wsCallbacks.topics) {
+        this.sendCommand({ type: 'subscribe', topics: this.wsCallbacks.topics });
+      }
+      // The device closes its least recently used socket when it runs out:
+      // a quiet page must still talk now and then to keep its WebSocket
+      this.keepaliveTimer = setInterval(() => this.sendCommand({ type: 'ping' }), WS_KEEPALIVE_MS);
       this.wsCallbacks.onConnect?.();
       if (this.reconnectTimer) {
         clearTimeout(this.reconnectTimer);
@@ -162,6 +289,8 @@ class ApiClient {
     };
 
     this.ws.onclose = () => {
+      this.stopKeepalive();
+      this.failPending();
       this.wsCallbacks.onDisconnect?.();
       // Auto-reconnect after 3 seconds (unless intentionally disconnected)
       if (!this.reconnectTimer && !this.intentionalDisconnect) {
@@ -177,6 +306,10 @@ class ApiClient {
     };
 
     this.ws.onmessage = (e) => {
+      if (e.data instanceof ArrayBuffer) {
+        this.handleTimelineFrame(e.data);
+        return;
+      }
       try {
         const msg = JSON.parse(e.data);
         this.handleWSMessage(msg);
@@ -186,31 +319,54 @@ class ApiClient {
     };
   }
 
-  private handleWSMessage(msg: WSMessage): void {
-    // Convert device timestamp to browser time, preserving relative offsets
-    let ts: number;
-    if (msg.ts !== undefined) {
-      const browserNow = Date.now();
-      if (this.deviceBaseTime === null) {
-        // First event with timestamp: establish baseline
-        this.deviceBaseTime = msg.ts;
-        this.browserBaseTime = browserNow;
-        ts = browserNow;
+  // Convert device timestamp to browser time, preserving relative offsets
+  private toBrowserTime(deviceMs: number): number {
+    const browserNow = Date.now();
+    if (this.deviceBaseTime === null) {
+      // First event with timestamp: establish baseline
+      this.deviceBaseTime = deviceMs;
+      this.browserBaseTime = browserNow;
+      return browserNow;
+    }
+    // Calculate browser time preserving device offset
+    const ts = this.browserBaseTime! + (deviceMs - this.deviceBaseTime);
+    // Don't let events appear in the future
+    return ts > browserNow ? browserNow : ts;
+  }
+
+  // Binary timeline frame: batched key edges (see ws_timeline.h)
+  private handleTimelineFrame(buf: ArrayBuffer): void {
+    const view = new DataView(buf);
+    if (buf.byteLength < TIMELINE_HEADER || view.getUint8(0) !== TIMELINE_VERSION) {
+      console.warn('Invalid timeline frame');
+      return;
+    }
+    const count = Math.min(view.getUint8(1), Math.floor((buf.byteLength - TIMELINE_HEADER) / TIMELINE_RECORD));
+    const periodUs = view.getUint16(2, true);
+    let timeUs = view.getUint32(4, true) + view.getUint32(8, true) * 0x100000000;
+    const sink = this.wsCallbacks.edges;
+
+    for (let i = 0, off = TIMELINE_HEADER; i < count; i++, off += TIMELINE_RECORD) {
+      timeUs += view.getUint16(off, true) * periodUs;
+      const channel = view.getUint8(off + 2);
+      const level = view.getUint8(off + 3);
+      const ts = this.toBrowserTime(timeUs / 1000);
+      if (sink) {
+        sink.push(ts, channel === TIMELINE_CH_KEY ? 2 : channel === TIMELINE_CH_DIT ? 0 : 1, level);
+      } else if (channel === TIMELINE_CH_KEY) {
+        this.wsCallbacks.onKeying?.(ts, 0, level);
       } else {
-        // Calculate browser time preserving device offset
-        ts = this.browserBaseTime! + (msg.ts - this.deviceBaseTime);
-        // Don't let events appear in the future
-        if (ts > browserNow) {
-          ts = browserNow;
-        }
+        this.wsCallbacks.onPaddle?.(ts, channel === TIMELINE_CH_DIT ? 0 : 1, level);
       }
-    } else {
-      ts = Date.now();
     }
+  }
+
+  private handleWSMessage(msg: WSMessage): void {
+    const ts = 'ts' in msg && msg.ts !== undefined ? this.toBrowserTime(msg.ts) : Date.now();
 
     switch (msg.type) {
       case 'decoded':
-        this.wsCallbacks.onDecodedChar?.(msg.char, msg.wpm);
+        this.wsCallbacks.onDecodedChar?.(msg.char, msg.wpm, msg.seq);
         break;
       case 'word':
         this.wsCallbacks.onWord?.();
@@ -227,11 +383,68 @@ class ApiClient {
       case 'gap':
         this.wsCallbacks.onGap?.(ts, msg.gap_type);
         break;
+      case 'text_status':
+        this.wsCallbacks.onTextStatus?.(msg);
+        this.settle(msg);
+        break;
+      case 'param':
+      case 'log_sub':
+      case 'subscribed':
+        this.settle(msg);
+        break;
+      case 'log':
+        this.wsCallbacks.onLog?.(msg.entries.map(([ts, src, level, text]) => ({ ts, src, level, text })));
+        break;
+      case 'key_stats':
+        this.wsCallbacks.onKeyStats?.(msg);
+        break;
+      case 'config':
+      case 'status':
+        this.handleDelta(msg);
+        break;
+    }
+  }
+
+  // Deltas are numbered across types: a gap means one was dropped on the
+  // device (queue full), so the page fetches the whole documents again
+  private handleDelta(msg: WSMessageDelta): void {
+    if (this.deltaSeq !== null && msg.seq !== this.deltaSeq + 1) {
+      this.wsCallbacks.onResync?.();
+    }
+    this.deltaSeq = msg.seq;
+    if (msg.type === 'config') {
+      this.wsCallbacks.onConfigDelta?.(msg.set);
+    } else {
+      this.wsCallbacks.onStatusDelta?.(msg.set);
+    }
+  }
+
+  private settle(reply: WSReply): void {
+    const p = reply.id !== undefined ? this.pending.get(reply.id) : undefined;
+    if (!p) return;
+    clearTimeout(p.timer);
+    this.pending.delete(reply.id!);
+    p.resolve(reply);
+  }
+
+  private failPending(): void {
+    for (const p of this.pending.values()) {
+      clearTimeout(p.timer);
+      p.reject(new Error('WebSocket closed'));
+    }
+    this.pending.clear();
+  }
+
+  private stopKeepalive(): void {
+    if (this.keepaliveTimer) {
+      clearInterval(this.keepaliveTimer);
+      this.keepaliveTimer = null;
     }
   }
 
   disconnect(): void {
     this.intentionalDisconnect = true;
+    this.stopKeepalive();
     if (this.reconnectTimer) {
       clearTimeout(this.reconnectTimer);
       this.reconnectTimer = null;
@@ -240,6 +453,7 @@ class ApiClient {
       this.ws.close();
       this.ws = null;
     }
+    this.failPending();
     // Reset time sync on disconnect
     this.deviceBaseTime = null;
     this.browserBaseTime = null;
@@ -250,11 +464,24 @@ class ApiClient {
   }
 }
 
+// Binary timeline frame layout (ws_timeline.h)
+const TIMELINE_VERSION = 1;
+const TIMELINE_HEADER = 12;
+const TIMELINE_RECORD = 4;
+const TIMELINE_CH_KEY = 0;
+const TIMELINE_CH_DIT = 1;
+
+// Command frames the device accepts (WS_CMD_MAX in ws_server.c, less the NUL)
+const WS_COMMAND_MAX = 255;
+const WS_COMMAND_TIMEOUT_MS = 2000;
+const WS_KEEPALIVE_MS = 20000;
+
 // WebSocket message types
 interface WSMessageDecoded {
   type: 'decoded';
   char: string;
   wpm: number;
+  seq: number;
 }
 
 interface WSMessageWord {
@@ -286,15 +513,114 @@ interface WSMessageGap {
   gap_type: number;
 }
 
-type WSMessage = WSMessageDecoded | WSMessageWord | WSMessagePattern | WSMessagePaddle | WSMessageKeying | WSMessageGap;
+// Replies to commands; id echoes the command's
+interface WSMessageTextStatus extends TextKeyerStatus {
+  type: 'text_status';
+  ok: boolean;
+  removed?: number;
+  id?: number;
+}
+
+interface WSMessageParam {
+  type: 'param';
+  param: string;
+  ok: boolean;
+  error?: string;
+  id?: number;
+}
+
+interface WSMessageLogSub {
+  type: 'log_sub';
+  ok: boolean;
+  id?: number;
+}
+
+interface WSMessageSubscribed {
+  type: 'subscribed';
+  ok: boolean;
+  topics: WSTopic[];
+  id?: number;
+}
+
+// Log batch (ws_log.h): [timestamp_us, stream, level, message] per record
+interface WSMessageLog {
+  type: 'log';
+  entries: [number, string, LogLevel, string][];
+}
+
+// Keying statistics (key_stats.h), once a second on the 'stats' topic:
+// one frame per channel, each figure over the 1 s, 10 s and 60 s windows
+export interface KeyStats {
+  ch: 'key' | 'remote';
+  wpm: number[];       // Tenths of WPM
+  weight: number[];    // Per mille (500 = even)
+  dah: number[];       // Dah/dit ratio, hundredths
+  char_gap: number[];  // Units, hundredths
+  word_gap: number[];  // Units, hundredths
+  duty: number[];      // Key-down time, per mille
+  marks: number[];
+}
+
+interface WSMessageKeyStats extends KeyStats {
+  type: 'key_stats';
+}
+
+// Pushed changes (ws_delta.h): dotted paths into /api/config or /api/status
+interface WSMessageDelta {
+  type: 'config' | 'status';
+  seq: number;
+  set: DeltaSet;
+}
+
+export type DeltaSet = Record<string, number | boolean | string>;
+
+// Apply a delta to a mirror of the matching REST document, in place
+export function applyDelta(target: Record<string, any>, set: DeltaSet): void {
+  for (const [path, value] of Object.entries(set)) {
+    const parts = path.split('.');
+    let obj = target;
+    for (const key of parts.slice(0, -1)) {
+      if (typeof obj[key] !== 'object' || obj[key] === null) obj[key] = {};
+      obj = obj[key];
+    }
+    obj[parts[parts.length - 1]] = value;
+  }
+}
+
+type WSReply = WSMessageTextStatus | WSMessageParam | WSMessageLogSub | WSMessageSubscribed;
+
+interface PendingCommand {
+  resolve: (reply: WSReply) => void;
+  reject: (err: Error) => void;
+  timer: ReturnType<typeof setTimeout>;
+}
+
+type WSMessage = WSMessageDecoded | WSMessageWord | WSMessagePattern | WSMessagePaddle | WSMessageKeying | WSMessageGap | WSReply | WSMessageLog | WSMessageDelta | WSMessageKeyStats;
+
+// Takes binary timeline edges directly instead of onPaddle/onKeying
+// (track 0 = DIT, 1 = DAH, 2 = OUT)
+export interface EdgeSink {
+  push(ts: number, track: number, level: number): void;
+}
+
+// Subscription topics (ws_topic.h); 'logs' is added by subscribeLog()
+export type WSTopic = 'timeline' | 'decoder' | 'text' | 'config' | 'status' | 'logs' | 'stats';
 
 export interface WSCallbacks {
-  onDecodedChar?: (char: string, wpm: number) => void;
+  topics?: WSTopic[];  // Sent on every (re)connect; omitted: all but logs and stats
+  edges?: EdgeSink;
+  onDecodedChar?: (char: string, wpm: number, seq: number) => void;
   onWord?: () => void;
   onPattern?: (pattern: string) => void;
   onPaddle?: (ts: number, paddle: number, state: number) => void;
   onKeying?: (ts: number, element: number, state: number) => void;
   onGap?: (ts: number, gapType: number) => void;
+  onTextStatus?: (status: TextKeyerStatus) => void;
+  onLog?: (entries: LogEntry[]) => void;
+  onKeyStats?: (stats: KeyStats) => void;
+  onConfigDelta?: (set: DeltaSet) => void;
+  onStatusDelta?: (set: DeltaSet) => void;
+  onResync?: () => void;  // A delta was lost: refetch /api/config and /api/status
   onConnect?: () => void;
   onDisconnect?: () => void;
 }
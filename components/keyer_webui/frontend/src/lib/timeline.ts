@@ -0,0 +1,253 @@
+// Timeline edge history and canvas renderer.
+//
+// Key edges from the binary timeline frames go straight into a typed-array
+// ring (no objects, no Svelte state per edge). The renderer keeps the pulses
+// on their own canvas layer and, each animation frame, shifts it left by the
+// whole pixels that elapsed and paints only the strip that scrolled in (plus
+// any region a late edge landed in). The grid and labels live on a static
+// layer underneath that is repainted only when the view changes.
+
+export const TRACKS = [
+  { name: 'DIT', color: '#4169E1', label: 'Dit paddle input' },
+  { name: 'DAH', color: '#DC143C', label: 'Dah paddle input' },
+  { name: 'OUT', color: '#00ff41', label: 'Keying output' },
+];
+
+const RING_SIZE = 8192;  // Power of 2
+
+// Edges in arrival order with the level of every track after each one
+export class EdgeRing {
+  readonly times = new Float64Array(RING_SIZE);
+  readonly states = new Uint8Array(RING_SIZE);  // Bit per track after the edge
+  head = 0;        // Edges ever pushed
+  level = 0;       // Current bitmap
+  dirtyFrom = Infinity;  // Oldest edge time since the renderer last looked
+
+  push(ts: number, track: number, down: number): void {
+    const bit = 1 << track;
+    const next = down ? this.level | bit : this.level & ~bit;
+    if (next === this.level) return;
+    const last = this.head > 0 ? this.times[(this.head - 1) & (RING_SIZE - 1)] : -Infinity;
+    const t = ts < last ? last : ts;  // Keep times sorted for the search below
+    const i = this.head & (RING_SIZE - 1);
+    this.times[i] = t;
+    this.states[i] = next;
+    this.level = next;
+    this.head++;
+    if (t < this.dirtyFrom) this.dirtyFrom = t;
+  }
+
+  get count(): number {
+    return Math.min(this.head, RING_SIZE);
+  }
+
+  clear(): void {
+    this.head = 0;
+    this.level = 0;
+    this.dirtyFrom = Infinity;
+  }
+
+  // Absolute index of the first held edge at or after t
+  firstAfter(t: number): number {
+    let lo = this.head - this.count;
+    let hi = this.head;
+    while (lo < hi) {
+      const mid = (lo + hi) >>> 1;
+      if (this.times[mid & (RING_SIZE - 1)] < t) lo = mid + 1;
+      else hi = mid;
+    }
+    return lo;
+  }
+
+  // Track levels just before absolute index i (0 before the oldest held edge)
+  stateBefore(i: number): number {
+    return i > this.head - this.count ? this.states[(i - 1) & (RING_SIZE - 1)] : 0;
+  }
+
+  timeAt(i: number): number {
+    return this.times[i & (RING_SIZE - 1)];
+  }
+
+  stateAt(i: number): number {
+    return this.states[i & (RING_SIZE - 1)];
+  }
+}
+
+export class TimelineRenderer {
+  private bg: CanvasRenderingContext2D;
+  private fg: CanvasRenderingContext2D;
+  private width: number;
+  private height: number;
+  private trackHeight: number;
+  private pxPerMs = 1;
+  private rightTime = 0;   // Time at the right edge of the pulse layer
+  private full = true;     // Pulse layer must be repainted completely
+
+  constructor(bgCanvas: HTMLCanvasElement, fgCanvas: HTMLCanvasElement, private ring: EdgeRing) {
+    this.bg = bgCanvas.getContext('2d')!;
+    this.fg = fgCanvas.getContext('2d')!;
+    this.width = fgCanvas.width;
+    this.height = fgCanvas.height;
+    this.trackHeight = this.height / TRACKS.length;
+  }
+
+  // Window or WPM changed: repaint both layers on the next frame
+  setView(durationS: number, wpm: number): void {
+    this.pxPerMs = this.width / (durationS * 1000);
+    this.drawBackground(durationS, wpm);
+    this.full = true;
+  }
+
+  invalidate(): void {
+    this.full = true;
+  }
+
+  // One animation frame with the right edge at `now` (browser ms)
+  frame(now: number): void {
+    const ring = this.ring;
+    let fromX: number;
+
+    if (this.full) {
+      this.rightTime = now;
+      fromX = 0;
+    } else {
+      const dx = Math.floor((now - this.rightTime) * this.pxPerMs);
+      if (dx <= 0 && ring.dirtyFrom === Infinity) return;
+      if (dx > 0) {
+        this.rightTime += dx / this.pxPerMs;
+        if (dx >= this.width) {
+          fromX = 0;
+        } else {
+          // Shift what is already drawn; only the new strip is painted
+          this.fg.globalCompositeOperation = 'copy';
+          this.fg.drawImage(this.fg.canvas, -dx, 0);
+          this.fg.globalCompositeOperation = 'source-over';
+          fromX = this.width - dx - 1;
+        }
+      } else {
+        fromX = this.width;
+      }
+      if (ring.dirtyFrom !== Infinity) {
+        fromX = Math.min(fromX, Math.floor(this.xOf(ring.dirtyFrom)) - 1);
+      }
+    }
+    this.full = false;
+    ring.dirtyFrom = Infinity;
+    this.paint(Math.max(0, fromX));
+  }
+
+  private xOf(t: number): number {
+    return this.width - (this.rightTime - t) * this.pxPerMs;
+  }
+
+  // Repaint pulses from x0 to the right edge
+  private paint(x0: number): void {
+    const ctx = this.fg;
+    const ring = this.ring;
+    const t0 = this.rightTime - (this.width - x0) / this.pxPerMs;
+    ctx.clearRect(x0, 0, this.width - x0, this.height);
+
+    let i = ring.firstAfter(t0);
+    let state = ring.stateBefore(i);
+    const startX = [x0, x0, x0];
+    for (; i < ring.head; i++) {
+      const t = ring.timeAt(i);
+      if (t > this.rightTime) break;
+      const next = ring.stateAt(i);
+      const x = this.xOf(t);
+      for (let tr = 0; tr < TRACKS.length; tr++) {
+        const bit = 1 << tr;
+        if ((next & bit) && !(state & bit)) {
+          startX[tr] = x;
+        } else if (!(next & bit) && (state & bit)) {
+          this.pulse(tr, startX[tr], x);
+        }
+      }
+      state = next;
+    }
+    for (let tr = 0; tr < TRACKS.length; tr++) {
+      if (state & (1 << tr)) this.pulse(tr, startX[tr], this.width);
+    }
+  }
+
+  private pulse(track: number, x0: number, x1: number): void {
+    const from = Math.max(0, Math.round(x0));
+    const to = Math.min(this.width, Math.round(x1));
+    if (to <= from) return;
+    this.fg.fillStyle = TRACKS[track].color;
+    this.fg.fillRect(from, track * this.trackHeight + 8, to - from, this.trackHeight - 16);
+  }
+
+  private drawBackground(durationS: number, wpm: number): void {
+    const ctx = this.bg;
+    const { width, height, trackHeight, pxPerMs } = this;
+
+    ctx.fillStyle = '#0d1117';
+    ctx.fillRect(0, 0, width, height);
+
+    for (let i = 0; i < TRACKS.length; i++) {
+      const y = i * trackHeight;
+      ctx.fillStyle = '#161b22';
+      ctx.fillRect(0, y, width, trackHeight - 2);
+      ctx.fillStyle = '#6b8f71';  // --text-dim
+      ctx.font = '11px "JetBrains Mono", monospace';
+      ctx.fillText(TRACKS[i].name, 5, y + 14);
+    }
+
+    // Dit grid lines (ITU timing) - subtle, dah lines every 3 dits
+    const gridStep = (1200 / wpm) * pxPerMs;
+    this.vlines(gridStep, 3, '#1f3f2f', 1);
+    this.vlines(gridStep * 3, 10, '#2f5f3f', 1);
+
+    // Time scale labels
+    ctx.font = '10px "JetBrains Mono", monospace';
+    const labelStep = 500;
+    if (labelStep * pxPerMs > 30) {
+      for (let i = 0; i <= Math.ceil(durationS * 1000 / labelStep); i++) {
+        const msFromRight = i * labelStep;
+        const x = width - msFromRight * pxPerMs;
+        if (x < 0) continue;
+        ctx.strokeStyle = '#4ec968';  // --text-secondary
+        ctx.lineWidth = 1.5;
+        ctx.beginPath();
+        ctx.moveTo(x, 0);
+        ctx.lineTo(x, height);
+        ctx.stroke();
+        const label = msFromRight === 0 ? 'NOW' : `-${msFromRight}ms`;
+        ctx.fillStyle = '#6b8f71';
+        ctx.fillText(label, x - ctx.measureText(label).width / 2, height - 3);
+      }
+    }
+
+    // Horizontal track separators
+    ctx.strokeStyle = '#2f5f3f';  // --border-dim
+    ctx.lineWidth = 1;
+    for (let i = 1; i < TRACKS.length; i++) {
+      ctx.beginPath();
+      ctx.moveTo(0, i * trackHeight);
+      ctx.lineTo(width, i * trackHeight);
+      ctx.stroke();
+    }
+
+    // Current time marker
+    ctx.strokeStyle = '#ffb000';
+    ctx.lineWidth = 2;
+    ctx.beginPath();
+    ctx.moveTo(width - 2, 0);
+    ctx.lineTo(width - 2, height);
+    ctx.stroke();
+  }
+
+  private vlines(step: number, minStep: number, color: string, lineWidth: number): void {
+    if (step <= minStep) return;
+    const ctx = this.bg;
+    ctx.strokeStyle = color;
+    ctx.lineWidth = lineWidth;
+    ctx.beginPath();
+    for (let x = this.width; x >= 0; x -= step) {
+      ctx.moveTo(x, 0);
+      ctx.lineTo(x, this.height);
+    }
+    ctx.stroke();
+  }
+}
@@ -8,6 +8,8 @@ export interface DeviceStatus {
   ip: string;
   ready: boolean;
   cwnet?: CWNetStatus;
+  vpn?: { state: string };
+  fault?: { active: boolean; code: string };
 }
 
 export interface SystemUptime {
@@ -31,10 +33,25 @@ export interface TaskInfo {
   stack_hwm: number;
 }
 
+export interface RtStageProfile {
+  name: string;
+  count: number;
+  min_cycles: number;
+  mean_cycles: number;
+  max_cycles: number;
+  hist_log2: number[];
+}
+
+export interface RtProfile {
+  cpu_mhz: number;
+  stages: RtStageProfile[];
+}
+
 export interface SystemStats {
   uptime: SystemUptime;
   heap: HeapInfo;
   tasks: TaskInfo[];
+  rt_profile?: RtProfile;
 }
 
 export interface DecoderStatus {
@@ -44,6 +61,16 @@ export interface DecoderStatus {
   text: string;
 }
 
+/** GET /api/decoder/text?since=N: transcript characters first..next-1 */
+export interface DecoderText {
+  first: number;   // > since when characters were lost
+  next: number;    // since= for the following request
+  head: number;    // next sequence the decoder will assign
+  word: number;    // word number of text[0]
+  words: number;   // words completed
+  text: string;
+}
+
 export interface TimelineConfig {
   wpm: number;
   wpm_source: string;
@@ -73,6 +100,8 @@ export interface TextKeyerStatus {
   sent: number;
   total: number;
   progress: number;
+  queued?: number;  // Characters waiting in the type-ahead queue
+  free?: number;
 }
 
 export interface MemorySlot {
@@ -84,6 +113,15 @@ export interface MemorySlot {
 export interface VpnStats {
   handshakes: number;
   last_handshake_us: number;
+  tx_bytes: number;
+  rx_bytes: number;
+  tx_packets: number;
+  rx_packets: number;
+  tx_cycles_avg: number;
+  tx_cycles_max: number;
+  rx_cycles_avg: number;
+  rx_cycles_max: number;
+  tx_pool_misses: number;
 }
 
 export interface VpnStatus {
@@ -91,3 +129,13 @@ export interface VpnStatus {
   connected: boolean;
   stats?: VpnStats;
 }
+
+// Log viewer (WebSocket log subscription)
+export type LogLevel = 'ERROR' | 'WARN' | 'INFO' | 'DEBUG' | 'TRACE' | 'OFF';
+
+export interface LogEntry {
+  ts: number;        // Device time, microseconds since boot
+  src: string;       // 'RT' or 'BG' stream
+  level: LogLevel;
+  text: string;
+}
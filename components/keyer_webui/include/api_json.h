@@ -0,0 +1,62 @@
+/**
+ * @file api_json.h
+ * @brief Chunked JSON responses for the API handlers
+ *
+ * Wraps json_writer around httpd_resp_send_chunk with a buffer on the
+ * handler's stack: nothing is allocated per request. A handler calls
+ * api_json_begin(), writes its document through api_json_writer() and
+ * ends with api_json_end(), which sends the last chunk.
+ *
+ * With CONFIG_KEYER_WEBUI_HEAP_TRACE each response logs its size and the
+ * internal heap change while it was built.
+ */
+
+#ifndef KEYER_WEBUI_API_JSON_H
+#define KEYER_WEBUI_API_JSON_H
+
+#include "esp_http_server.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bytes per response chunk */
+#define API_JSON_CHUNK 512
+
+/**
+ * @brief Response in progress
+ */
+typedef struct {
+    json_writer_t w;
+    httpd_req_t *req;
+#ifdef CONFIG_KEYER_WEBUI_HEAP_TRACE
+    size_t heap_before;
+#endif
+    char buf[API_JSON_CHUNK];
+} api_json_t;
+
+/**
+ * @brief Start an application/json response
+ */
+void api_json_begin(api_json_t *resp, httpd_req_t *req);
+
+/**
+ * @brief Writer for the response body
+ */
+static inline json_writer_t *api_json_writer(api_json_t *resp) {
+    return &resp->w;
+}
+
+/**
+ * @brief Send the rest and terminate the chunked response
+ *
+ * @return ESP_OK, or ESP_FAIL if the client went away
+ */
+esp_err_t api_json_end(api_json_t *resp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_API_JSON_H */
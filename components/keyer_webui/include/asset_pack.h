@@ -0,0 +1,113 @@
+/**
+ * @file asset_pack.h
+ * @brief Web UI asset image stored in the "webui" flash partition
+ *
+ * embed_assets.py --pack writes the built frontend as one image: a
+ * header, a fixed-size entry per file, the path and type strings, then
+ * the compressed bodies. The firmware memory-maps the partition and
+ * serves bodies straight from flash, so the UI can be reflashed on its
+ * own (idf.py webui-flash) without rebuilding or reflashing the app.
+ *
+ * Every body is stored gzipped and, when it comes out smaller, also as
+ * Brotli; the handler picks one by Accept-Encoding. Every entry carries
+ * a quoted ETag, a hash of the uncompressed file, and an immutable flag
+ * for files whose name already contains a content hash (Vite's
+ * [name]-[hash] output), which the browser may cache without
+ * revalidating.
+ *
+ * All integers are little-endian. The parser only reads the image and
+ * checks every offset against its length before handing out pointers.
+ *
+ * Pure logic, no ESP-IDF calls.
+ */
+
+#ifndef KEYER_WEBUI_ASSET_PACK_H
+#define KEYER_WEBUI_ASSET_PACK_H
+
+#include "assets.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** "KWUI" */
+#define ASSET_PACK_MAGIC 0x4955574BU
+
+/** Image format version */
+#define ASSET_PACK_VERSION 2U
+
+/** Header bytes */
+#define ASSET_PACK_HEADER_SIZE 16U
+
+/** Bytes per entry */
+#define ASSET_PACK_ENTRY_SIZE 48U
+
+/** ETag field, quotes and NUL included */
+#define ASSET_PACK_ETAG_LEN 20U
+
+/** Entry flags */
+#define ASSET_PACK_F_GZIP      0x01U
+#define ASSET_PACK_F_IMMUTABLE 0x02U
+
+/*
+ * Header:  u32 magic, u16 version, u16 count, u32 image_len, u32 reserved
+ * Entry:   u32 path_off, u32 type_off, u32 data_off, u32 data_len,
+ *          u32 br_off, u32 br_len (0: no Brotli body),
+ *          char etag[20], u8 flags, u8 pad[3]
+ * Offsets are from the start of the image; strings are NUL-terminated.
+ */
+
+/**
+ * @brief Parsed image
+ */
+typedef struct {
+    const uint8_t *base;   /**< Start of the image (mapped flash) */
+    uint32_t len;          /**< Image bytes */
+    uint16_t count;        /**< Entries */
+} asset_pack_t;
+
+/**
+ * @brief Read the image length from a header
+ *
+ * @param hdr At least ASSET_PACK_HEADER_SIZE bytes
+ * @return Image bytes, 0 if the magic or version do not match
+ */
+uint32_t asset_pack_image_len(const uint8_t *hdr);
+
+/**
+ * @brief Check an image and prepare lookups
+ *
+ * @param pack Output
+ * @param base Image
+ * @param len Bytes available at base
+ * @return false if the image is truncated or an entry points outside it
+ */
+bool asset_pack_open(asset_pack_t *pack, const uint8_t *base, size_t len);
+
+/**
+ * @brief Find a file by URL path
+ *
+ * @param pack Opened image
+ * @param path URL path ("/index.html"; "/" is stored as its own entry)
+ * @param out Filled with pointers into the image
+ * @return false if absent
+ */
+bool asset_pack_find(const asset_pack_t *pack, const char *path, webui_asset_t *out);
+
+/**
+ * @brief True if an Accept-Encoding header value allows Brotli
+ *
+ * Looks for a "br" coding that is not disabled with q=0.
+ *
+ * @param accept_encoding Header value
+ */
+bool asset_accepts_br(const char *accept_encoding);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_ASSET_PACK_H */
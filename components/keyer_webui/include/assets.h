@@ -10,31 +10,56 @@ extern "C" {
 #endif
 
 /**
- * @brief Embedded asset descriptor
+ * @brief Asset descriptor
  */
 typedef struct {
     const char *path;           /**< URL path (e.g., "/index.html") */
     const char *content_type;   /**< MIME type */
     const uint8_t *data;        /**< Gzip-compressed data */
     size_t length;              /**< Data length */
-    bool gzipped;               /**< Always true for embedded assets */
+    bool gzipped;               /**< Always true for built assets */
+    const uint8_t *br_data;     /**< Brotli-compressed data, NULL if none */
+    size_t br_length;           /**< Brotli data length (0 if none) */
+    const char *etag;           /**< Quoted content hash */
+    bool immutable;             /**< File name carries a content hash */
 } webui_asset_t;
 
+/**
+ * @brief Locate the asset source (call once before serving)
+ *
+ * Maps the "webui" partition when CONFIG_KEYER_WEBUI_ASSETS_PARTITION is
+ * set and it holds a valid image; otherwise the assets compiled into the
+ * app are used.
+ */
+void webui_assets_init(void);
+
 /**
  * @brief Find asset by path
  * @param path URL path
- * @return Asset pointer or NULL
+ * @param out Filled on success (pointers stay valid while the app runs)
+ * @return false if absent
  */
-const webui_asset_t *webui_find_asset(const char *path);
+bool webui_find_asset(const char *path, webui_asset_t *out);
 
 /**
  * @brief Get asset count
- * @return Number of embedded assets
+ * @return Number of assets in the active source
  */
 size_t webui_get_asset_count(void);
 
 /**
- * @brief Get all assets
+ * @brief Find an asset compiled into the app (generated assets.c)
+ * @return Asset pointer or NULL
+ */
+const webui_asset_t *webui_embedded_find(const char *path);
+
+/**
+ * @brief Number of assets compiled into the app
+ */
+size_t webui_embedded_count(void);
+
+/**
+ * @brief Get all assets compiled into the app
  * @return Array of assets (NULL-terminated)
  */
 const webui_asset_t *webui_get_assets(void);
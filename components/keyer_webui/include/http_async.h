@@ -0,0 +1,89 @@
+/**
+ * @file http_async.h
+ * @brief API endpoints with latency stats, slow ones on a worker pool
+ *
+ * httpd serves every socket from one task, so a handler that takes a
+ * while (an NVS commit, a long JSON document, an OTA upload) stalls all
+ * other clients. Endpoints registered here go through a trampoline that
+ * times each request, and those marked async are handed to one of
+ * CONFIG_KEYER_WEBUI_ASYNC_WORKERS worker tasks with
+ * httpd_req_async_handler_begin(): the httpd task is free again at once.
+ *
+ * Handlers keep their snapshots in static buffers (they were written for
+ * one handler at a time), so an async endpoint never runs twice at once:
+ * a second request while it is in flight gets 503 with Retry-After. With
+ * every worker busy the request runs inline as before.
+ *
+ * Workers are claimed with a CAS and woken by task notification; stats
+ * are atomics readable from any task.
+ */
+
+#ifndef KEYER_WEBUI_HTTP_ASYNC_H
+#define KEYER_WEBUI_HTTP_ASYNC_H
+
+#include "esp_http_server.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Counters of one endpoint
+ */
+typedef struct {
+    atomic_uint count;       /**< Requests handled */
+    atomic_uint errors;      /**< Handler returned an error */
+    atomic_uint deferred;    /**< Run on a worker */
+    atomic_uint inline_runs; /**< Async endpoint run inline (pool busy) */
+    atomic_uint rejected;    /**< 503: already in flight */
+    atomic_uint avg_us;      /**< Moving average, 1/8 weight per request */
+    atomic_uint max_us;      /**< Slowest request */
+    atomic_bool busy;        /**< Async endpoint in flight */
+} http_endpoint_stats_t;
+
+/**
+ * @brief One API endpoint
+ */
+typedef struct {
+    httpd_uri_t uri;               /**< Handler and user_ctx as the handler expects them */
+    bool async;                    /**< Run on the worker pool */
+    http_endpoint_stats_t stats;
+} http_endpoint_t;
+
+/**
+ * @brief Start the worker tasks (once, before registering async endpoints)
+ */
+esp_err_t http_async_init(void);
+
+/**
+ * @brief Register an endpoint through the timing trampoline
+ *
+ * @param server httpd handle
+ * @param ep Endpoint, static storage (the trampoline keeps a pointer)
+ */
+esp_err_t http_endpoint_register(httpd_handle_t server, http_endpoint_t *ep);
+
+/**
+ * @brief Workers started
+ */
+int http_async_worker_count(void);
+
+/**
+ * @brief Endpoints registered so far
+ */
+size_t http_endpoint_count(void);
+
+/**
+ * @brief Endpoint i in registration order, NULL past the end
+ */
+const http_endpoint_t *http_endpoint_at(size_t i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_HTTP_ASYNC_H */
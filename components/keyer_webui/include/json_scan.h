@@ -0,0 +1,116 @@
+/**
+ * @file json_scan.h
+ * @brief In-place JSON tokenizer for small request bodies
+ *
+ * The POST handlers take a few fields from bodies of at most a few
+ * hundred bytes. Instead of building a cJSON tree on the heap for each
+ * request, json_scan() checks the body and records one token per value
+ * in a caller array (usually on the handler's stack). Each token gives
+ * the value's offset and length in the body and the index just past its
+ * subtree, so members can be looked up and skipped without copying.
+ * Strings are unescaped only when a field is read, into a caller buffer.
+ *
+ * Memory use is the token array and the body buffer, fixed per handler,
+ * and nothing outlives the request.
+ *
+ * Pure logic, no ESP-IDF calls.
+ */
+
+#ifndef KEYER_WEBUI_JSON_SCAN_H
+#define KEYER_WEBUI_JSON_SCAN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Deepest nesting accepted */
+#define JSON_SCAN_MAX_DEPTH 8U
+
+/** Longest body accepted (token offsets are 16-bit) */
+#define JSON_SCAN_MAX_LEN 65535U
+
+/**
+ * @brief Token type
+ */
+typedef enum {
+    JSON_TOK_OBJECT = 0,
+    JSON_TOK_ARRAY,
+    JSON_TOK_STRING,     /**< start/len exclude the quotes, still escaped */
+    JSON_TOK_NUMBER,
+    JSON_TOK_TRUE,
+    JSON_TOK_FALSE,
+    JSON_TOK_NULL,
+} json_tok_type_t;
+
+/**
+ * @brief One value (object members are a key string, then its value)
+ */
+typedef struct {
+    uint16_t start;      /**< Offset in the body */
+    uint16_t len;        /**< Bytes */
+    uint16_t next;       /**< Index of the first token after this value */
+    uint8_t type;        /**< json_tok_type_t */
+} json_tok_t;
+
+/**
+ * @brief Tokenize a document
+ *
+ * @param js Body (need not be NUL-terminated)
+ * @param len Bytes in js
+ * @param toks Token array
+ * @param max Capacity of toks
+ * @return Tokens used (the root is toks[0]), -1 if the body is not valid
+ *         JSON, too deep, too long or has more values than max
+ */
+int json_scan(const char *js, size_t len, json_tok_t *toks, size_t max);
+
+/**
+ * @brief Find a member of an object
+ *
+ * @param js Body
+ * @param toks Tokens
+ * @param obj Index of the object token
+ * @param key Member name, compared with the key as written in the body
+ * @return Index of the member's value, -1 if absent or obj is no object
+ */
+int json_scan_get(const char *js, const json_tok_t *toks, int obj, const char *key);
+
+/**
+ * @brief Copy a string value, unescaped and NUL-terminated
+ *
+ * @return false if tok is not a string or it does not fit in cap
+ */
+bool json_scan_string(const char *js, const json_tok_t *tok, char *out, size_t cap);
+
+/**
+ * @brief Read a number as int (fraction dropped, clamped like cJSON valueint)
+ *
+ * @return false if tok is not a number
+ */
+bool json_scan_int(const char *js, const json_tok_t *tok, int *out);
+
+/**
+ * @brief Format a scalar as config_set_param_str() takes it
+ *
+ * true/false, a number as an int (see json_scan_int), a string unescaped.
+ *
+ * @return false for objects, arrays and null, or if it does not fit in cap
+ */
+bool json_scan_value_str(const char *js, const json_tok_t *tok, char *out, size_t cap);
+
+/**
+ * @brief True only for a literal true (false, absent and other types are false)
+ */
+static inline bool json_scan_is_true(const json_tok_t *toks, int idx) {
+    return idx >= 0 && toks[idx].type == JSON_TOK_TRUE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_JSON_SCAN_H */
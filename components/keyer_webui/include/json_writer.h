@@ -0,0 +1,106 @@
+/**
+ * @file json_writer.h
+ * @brief Streaming JSON writer over a fixed buffer
+ *
+ * Writes JSON text straight into a caller buffer and hands it to a flush
+ * function each time it fills, so a response of any size goes out in
+ * buffer-sized chunks without a document tree or a printed copy on the
+ * heap. The HTTP handlers flush with httpd_resp_send_chunk (api_json.h).
+ *
+ * Values are written in order: open an object or array, add members with
+ * their key (NULL inside arrays), close it. Commas are tracked per
+ * nesting level. Once a flush fails the writer stops producing output and
+ * json_writer_finish() reports it.
+ *
+ * Pure logic, no ESP-IDF calls. Single owner, not thread-safe.
+ */
+
+#ifndef KEYER_WEBUI_JSON_WRITER_H
+#define KEYER_WEBUI_JSON_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Deepest nesting of objects and arrays */
+#define JSON_WRITER_MAX_DEPTH 16U
+
+/**
+ * @brief Send a filled buffer
+ *
+ * @return false to stop writing (client gone)
+ */
+typedef bool (*json_flush_fn_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Writer state
+ */
+typedef struct {
+    char *buf;                /**< Chunk buffer */
+    size_t cap;
+    size_t len;               /**< Bytes waiting in buf */
+    size_t total;             /**< Bytes produced so far */
+    json_flush_fn_t flush;
+    void *ctx;
+    uint32_t need_comma;      /**< Bit per nesting level: a member was written */
+    uint8_t depth;
+    bool ok;                  /**< No flush failed, nesting within bounds */
+} json_writer_t;
+
+/**
+ * @brief Start a document
+ *
+ * @param w Writer
+ * @param buf Chunk buffer
+ * @param cap Size of buf (at least 1)
+ * @param flush Called with each filled buffer
+ * @param ctx Passed to flush
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t cap, json_flush_fn_t flush, void *ctx);
+
+/** @brief Open an object (key NULL at the root and inside arrays) */
+void json_object_begin(json_writer_t *w, const char *key);
+
+/** @brief Close the innermost object */
+void json_object_end(json_writer_t *w);
+
+/** @brief Open an array */
+void json_array_begin(json_writer_t *w, const char *key);
+
+/** @brief Close the innermost array */
+void json_array_end(json_writer_t *w);
+
+/** @brief String member, escaped (NULL writes null) */
+void json_string(json_writer_t *w, const char *key, const char *value);
+
+/** @brief Signed integer member */
+void json_int(json_writer_t *w, const char *key, int64_t value);
+
+/** @brief Unsigned integer member */
+void json_uint(json_writer_t *w, const char *key, uint64_t value);
+
+/** @brief Number member, 15 significant digits (NaN and infinities write null) */
+void json_double(json_writer_t *w, const char *key, double value);
+
+/** @brief Boolean member */
+void json_bool(json_writer_t *w, const char *key, bool value);
+
+/** @brief null member */
+void json_null(json_writer_t *w, const char *key);
+
+/**
+ * @brief Flush what is left
+ *
+ * @return true if every flush succeeded and all containers were closed
+ */
+bool json_writer_finish(json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_JSON_WRITER_H */
@@ -2,7 +2,10 @@
 #define KEYER_WEBUI_H
 
 #include "esp_err.h"
+#include "ws_topic.h"
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,10 +16,52 @@ esp_err_t webui_start(void);
 esp_err_t webui_stop(void);
 
 void webui_timeline_push(const char *event_type, const char *json_data);
-void webui_decoder_push_char(char c, uint8_t wpm);
+
+/**
+ * @brief Push a batch of key edges to the timeline
+ * @param frame Encoded ws_timeline.h frame
+ * @param len Frame length
+ */
+void webui_timeline_push_edges(const uint8_t *frame, size_t len);
+/**
+ * @brief Push a decoded character to WebSocket clients
+ * @param c Decoded character
+ * @param wpm Current WPM
+ * @param seq Transcript sequence number (clients resume from it)
+ */
+void webui_decoder_push_char(char c, uint8_t wpm, uint32_t seq);
 void webui_decoder_push_word(void);
 void webui_decoder_push_pattern(const char *pattern);
 
+/**
+ * @brief Push the text keyer state and progress to WebSocket clients
+ */
+void webui_text_status_push(void);
+
+/**
+ * @brief Push the keying statistics to WebSocket stats subscribers
+ */
+void webui_key_stats_push(void);
+
+/**
+ * @brief Push log records to WebSocket log subscribers
+ * @return true if anything was sent
+ */
+bool webui_log_push(void);
+
+/**
+ * @brief Push config and status deltas to WebSocket clients
+ * @return true if anything was sent
+ */
+bool webui_state_push(void);
+
+/**
+ * @brief Whether any WebSocket client is subscribed to a topic
+ *
+ * The push service skips the work for a topic nobody watches.
+ */
+bool webui_topic_active(ws_topic_t topic);
+
 /**
  * @brief Get number of connected WebSocket clients
  * @return Number of active WebSocket connections
@@ -0,0 +1,101 @@
+/**
+ * @file ws_delta.h
+ * @brief Change frames pushed to the web UI instead of polled state
+ *
+ * The device sends only what changed, as members of a "set" object:
+ *
+ *   {"type":"config","seq":12,"set":{"keyer.wpm":25,"system.callsign":"IU3QEZ"}}
+ *   {"type":"status","seq":13,"set":{"mode":"CONNECTED","ip":"192.168.1.7"}}
+ *
+ * Keys are dotted paths into the matching REST document (/api/config,
+ * /api/status). Every frame takes the next sequence number, shared by
+ * all types: a client whose queue overflowed sees the gap and fetches the
+ * documents again. A change set that does not fit one frame goes out as
+ * several, each with its own number.
+ *
+ * The publisher remembers each member by signature (ws_delta_sig(), a
+ * 32-bit FNV-1a of its JSON value), one word per member instead of a copy
+ * of every value.
+ *
+ * Pure logic, no ESP-IDF calls. Single owner, not thread-safe.
+ */
+
+#ifndef KEYER_WEBUI_WS_DELTA_H
+#define KEYER_WEBUI_WS_DELTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ws_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest frame, NUL excluded (ws_broadcast() takes it NUL-terminated) */
+#define WS_DELTA_FRAME_MAX (WS_QUEUE_MSG_MAX - 1U)
+
+/**
+ * @brief Hand over a finished frame
+ */
+typedef void (*ws_delta_send_fn)(const char *frame, size_t len, void *ctx);
+
+/**
+ * @brief Frames of one change set
+ */
+typedef struct {
+    char buf[WS_DELTA_FRAME_MAX + 1U];
+    size_t len;
+    unsigned members;         /**< Members in the open frame */
+    const char *type;
+    uint32_t *seq;            /**< Last number used, advanced per frame */
+    ws_delta_send_fn send;
+    void *ctx;
+    unsigned frames;          /**< Frames sent */
+    unsigned dropped;         /**< Members too large for any frame */
+} ws_delta_t;
+
+/**
+ * @brief Start a change set
+ *
+ * @param d Change set
+ * @param type Frame type ("config", "status")
+ * @param seq Sequence counter, shared by every change set
+ * @param send Called once per frame
+ * @param ctx Passed to send
+ */
+void ws_delta_begin(ws_delta_t *d, const char *type, uint32_t *seq,
+                    ws_delta_send_fn send, void *ctx);
+
+/**
+ * @brief Add a member, sending the open frame first if it is full
+ *
+ * @param key Dotted path, not escaped
+ * @param value JSON value text (number, true/false, quoted string)
+ */
+void ws_delta_put(ws_delta_t *d, const char *key, const char *value);
+
+/**
+ * @brief Send the last frame (nothing if no member was added)
+ *
+ * @return Frames sent for this change set
+ */
+unsigned ws_delta_end(ws_delta_t *d);
+
+/**
+ * @brief Quote and escape a string as a JSON value
+ *
+ * @return Length written, 0 if it does not fit (out left empty)
+ */
+size_t ws_delta_json_string(char *out, size_t cap, const char *s);
+
+/**
+ * @brief Signature of a JSON value text
+ */
+uint32_t ws_delta_sig(const char *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_WS_DELTA_H */
@@ -0,0 +1,108 @@
+/**
+ * @file ws_log.h
+ * @brief Log subscription frames for WebSocket clients
+ *
+ * Each subscribed client gets its own cursor on the RT and BG log
+ * streams (log_reader_t, like the UART and USB drains), so watching the
+ * logs from a browser takes nothing away from the other sinks. Records
+ * from both streams are merged in time order, filtered per stream by
+ * level on the device, and packed several to a text frame:
+ *
+ *   {"type":"log","entries":[[ts_us,"BG","INFO","WiFi connected"],...]}
+ *
+ * A client that cannot keep up is simply not read for a while: the
+ * producer laps its cursor, and the records lost show up as one summary
+ * entry ("... entries dropped") in front of the next one read.
+ *
+ * Pure logic, no ESP-IDF calls. Each cursor belongs to one task.
+ */
+
+#ifndef KEYER_WEBUI_WS_LOG_H
+#define KEYER_WEBUI_WS_LOG_H
+
+#include "rt_log.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Streams a subscription reads: RT, BG */
+#define WS_LOG_SOURCES 2
+
+/** Filter level that mutes a stream */
+#define WS_LOG_LEVEL_OFF 7U
+
+/**
+ * @brief Subscription filter: a level per stream, packed in one word
+ *
+ * Bits 0-2 RT level, 4-6 BG level (log_level_t or WS_LOG_LEVEL_OFF).
+ * 0 is not a valid filter and means "not subscribed".
+ */
+typedef uint32_t ws_log_filter_t;
+
+#define WS_LOG_FILTER_ON 0x80U
+
+/**
+ * @brief One stream as seen by one cursor
+ */
+typedef struct {
+    log_reader_t reader;
+    log_entry_t entry;       /**< Next record, read ahead to merge by time */
+    bool pending;            /**< entry is valid */
+    bool muted;              /**< WS_LOG_LEVEL_OFF */
+    uint32_t lost;           /**< Records dropped, not reported yet */
+} ws_log_source_t;
+
+/**
+ * @brief One client's log cursor
+ */
+typedef struct {
+    ws_log_source_t src[WS_LOG_SOURCES];
+} ws_log_cursor_t;
+
+/**
+ * @brief Build a filter
+ */
+ws_log_filter_t ws_log_filter_make(unsigned rt_level, unsigned bg_level);
+
+/**
+ * @brief Parse "ERROR" ... "TRACE" or "OFF"
+ *
+ * @return false if the name is unknown
+ */
+bool ws_log_parse_level(const char *name, unsigned *level);
+
+/**
+ * @brief Attach a cursor at the oldest records still held
+ *
+ * A new subscription therefore starts with the recent history.
+ *
+ * @param c Cursor
+ * @param rt RT log stream
+ * @param bg BG log stream
+ * @param filter Levels (ws_log_filter_make())
+ */
+void ws_log_cursor_init(ws_log_cursor_t *c, const log_stream_t *rt,
+                        const log_stream_t *bg, ws_log_filter_t filter);
+
+/**
+ * @brief Fill one frame with as many records as fit
+ *
+ * Records that do not fit stay for the next frame; one that would not
+ * fit even alone is cut.
+ *
+ * @param c Cursor
+ * @param out Frame buffer
+ * @param cap Its size (at least 96)
+ * @return Frame length, 0 if there was nothing to send
+ */
+size_t ws_log_batch(ws_log_cursor_t *c, char *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_WS_LOG_H */
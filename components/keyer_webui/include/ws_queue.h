@@ -0,0 +1,146 @@
+/**
+ * @file ws_queue.h
+ * @brief Per-client WebSocket send queue (lock-free, bounded)
+ *
+ * One queue per client between the broadcaster (bg_task) and the httpd
+ * send worker. A slow client only fills its own queue; what happens then
+ * depends on the message kind:
+ *
+ *   WS_MSG_TIMELINE  Drop oldest: the newest edges are the ones on screen
+ *   WS_MSG_DECODED   Drop newest: queued text stays contiguous
+ *   WS_MSG_PATTERN   Coalesce: one mailbox, only the latest value is sent
+ *   WS_MSG_LOG       Drop newest (the log pusher leaves room before it reads)
+ *
+ * Each drop is counted per kind. The scheduled flag keeps at most one
+ * send worker per client queued or running (in-flight tracking).
+ *
+ * Single producer, single consumer. Drop-oldest makes the producer
+ * advance the tail too, so the consumer copies a message and then claims
+ * it with a CAS, discarding the copy if the producer dropped it first.
+ * The pattern mailbox is a seqlock like the RT config snapshot.
+ *
+ * ARCHITECTURE.md compliance:
+ * - RULE 3.1.1: Only atomic operations for synchronization
+ * - RULE 3.1.4: No operation shall block (full queues drop, never stall)
+ */
+
+#ifndef KEYER_WEBUI_WS_QUEUE_H
+#define KEYER_WEBUI_WS_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Messages queued per client (MUST be power of 2) */
+#define WS_QUEUE_SLOTS 8
+
+/** Largest message (JSON text or binary frame) */
+#define WS_QUEUE_MSG_MAX 256
+
+/**
+ * @brief Message kind (selects the overflow policy)
+ */
+typedef enum {
+    WS_MSG_TIMELINE = 0,   /**< Binary timeline frame (drop oldest) */
+    WS_MSG_DECODED,        /**< Decoded char / word separator (drop newest) */
+    WS_MSG_PATTERN,        /**< Current decoder pattern (coalesce) */
+    WS_MSG_LOG,            /**< Log subscription batch (drop newest) */
+    WS_MSG_KIND_COUNT
+} ws_msg_kind_t;
+
+/**
+ * @brief One outgoing message
+ */
+typedef struct {
+    uint8_t kind;                   /**< ws_msg_kind_t */
+    bool binary;                    /**< BINARY frame, else TEXT */
+    uint16_t len;                   /**< Bytes in data */
+    uint8_t data[WS_QUEUE_MSG_MAX]; /**< Payload (not NUL terminated) */
+} ws_msg_t;
+
+/**
+ * @brief Per-client queue
+ */
+typedef struct {
+    ws_msg_t slots[WS_QUEUE_SLOTS];
+    atomic_uint head;               /**< Next slot to fill (producer) */
+    atomic_uint tail;               /**< Next slot to send (CAS: consumer, drop-oldest) */
+
+    ws_msg_t latest;                /**< Coalesced mailbox */
+    atomic_uint latest_seq;         /**< Mailbox seqlock, odd while writing */
+    atomic_uint latest_sent;        /**< Mailbox seq last taken (consumer) */
+
+    atomic_bool scheduled;          /**< A send worker is queued or running */
+
+    /* Statistics */
+    atomic_uint dropped[WS_MSG_KIND_COUNT]; /**< Lost to overflow, per kind */
+    atomic_uint coalesced;          /**< Mailbox values replaced before sending */
+    atomic_uint sent;               /**< Messages handed to the socket */
+} ws_queue_t;
+
+/**
+ * @brief Reset a queue to empty, clearing counters
+ *
+ * Only while neither side is using it (before the client goes active).
+ */
+void ws_queue_init(ws_queue_t *q);
+
+/**
+ * @brief Queue a message (producer)
+ *
+ * @param q Queue
+ * @param kind Message kind (policy)
+ * @param binary true for a BINARY frame
+ * @param data Payload
+ * @param len Payload length (<= WS_QUEUE_MSG_MAX)
+ * @return false if the message itself was dropped or too long
+ */
+bool ws_queue_push(ws_queue_t *q, ws_msg_kind_t kind, bool binary,
+                   const uint8_t *data, size_t len);
+
+/**
+ * @brief Take the send worker slot (producer)
+ *
+ * @return true if the caller must schedule the worker now
+ */
+bool ws_queue_schedule(ws_queue_t *q);
+
+/**
+ * @brief Next message to send (consumer)
+ *
+ * Queued messages first, then the mailbox if it changed.
+ *
+ * @param q Queue
+ * @param out Message copy (valid if true returned)
+ * @return true if a message was taken
+ */
+bool ws_queue_pop(ws_queue_t *q, ws_msg_t *out);
+
+/**
+ * @brief Release the send worker slot (consumer)
+ *
+ * Re-takes the slot if a message arrived since the last pop, so a
+ * producer that saw the worker busy never leaves a message stranded.
+ *
+ * @return true if the worker must keep running
+ */
+bool ws_queue_worker_done(ws_queue_t *q);
+
+/**
+ * @brief Messages waiting (queue only, not the mailbox)
+ */
+static inline unsigned ws_queue_len(const ws_queue_t *q) {
+    return atomic_load_explicit(&q->head, memory_order_acquire) -
+           atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_WS_QUEUE_H */
@@ -5,16 +5,24 @@
  * Provides a single /ws endpoint for all real-time data:
  * - Decoder events (decoded chars, word separators)
  * - Timeline events (paddle, keying, gaps)
+ * - Key edges, batched in binary timeline frames (ws_timeline.h)
+ * - Log records for clients that subscribe (ws_log.h)
+ * - Config and status deltas (ws_delta.h)
  *
+ * Each client chooses the topics it gets (ws_topic.h).
  * Replaces SSE implementation for better connection management.
+ * Each client has a bounded send queue; overflow policy depends on the
+ * message kind (ws_queue.h).
  */
 
 #ifndef KEYER_WEBUI_WS_SERVER_H
 #define KEYER_WEBUI_WS_SERVER_H
 
 #include "esp_http_server.h"
+#include "ws_topic.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,6 +30,18 @@ extern "C" {
 
 #define WS_MAX_CLIENTS 8
 
+/**
+ * @brief Send queue counters for one connected client
+ */
+typedef struct {
+    int fd;                     /**< Socket file descriptor */
+    uint32_t queued;            /**< Messages waiting now */
+    uint32_t sent;              /**< Messages handed to the socket */
+    uint32_t dropped_timeline;  /**< Timeline frames lost (oldest first) */
+    uint32_t dropped_text;      /**< Decoder text lost (queue full) */
+    uint32_t coalesced;         /**< Pattern updates replaced before sending */
+} ws_client_stats_t;
+
 /**
  * @brief Initialize WebSocket server subsystem
  */
@@ -33,6 +53,12 @@ void ws_server_init(void);
  */
 void ws_server_set_httpd_handle(httpd_handle_t handle);
 
+/**
+ * @brief Forget the client on a closed socket (httpd close_fn, httpd task)
+ * @param fd Socket being closed, WebSocket or not
+ */
+void ws_server_session_closed(int fd);
+
 /**
  * @brief WebSocket URI handler (called by httpd)
  * @param req HTTP request
@@ -41,17 +67,26 @@ void ws_server_set_httpd_handle(httpd_handle_t handle);
 esp_err_t ws_handler(httpd_req_t *req);
 
 /**
- * @brief Broadcast raw JSON message to all connected WebSocket clients
+ * @brief Broadcast raw JSON message to the clients subscribed to a topic
+ * @param topic Topic of the message
  * @param message JSON message string (null-terminated)
  */
-void ws_broadcast(const char *message);
+void ws_broadcast(ws_topic_t topic, const char *message);
+
+/**
+ * @brief Broadcast a binary timeline message to the timeline subscribers
+ * @param data Message bytes (e.g. a ws_timeline.h frame, max 256)
+ * @param len Message length
+ */
+void ws_broadcast_binary(const uint8_t *data, size_t len);
 
 /**
  * @brief Broadcast decoder character event
  * @param c Decoded character
  * @param wpm Current WPM
+ * @param seq Transcript sequence number of the character
  */
-void ws_broadcast_decoder_char(char c, uint8_t wpm);
+void ws_broadcast_decoder_char(char c, uint8_t wpm, uint32_t seq);
 
 /**
  * @brief Broadcast decoder word separator event
@@ -71,12 +106,68 @@ void ws_broadcast_decoder_pattern(const char *pattern);
  */
 void ws_broadcast_timeline(const char *event_type, const char *json_data);
 
+/**
+ * @brief Push the text keyer state to all clients (text_status message)
+ *
+ * Called by the UI push service when the state, progress or queue changes.
+ */
+void ws_broadcast_text_status(void);
+
+/**
+ * @brief Push the keying statistics to the stats subscribers
+ *
+ * One key_stats message per channel that was ever keyed (key, remote),
+ * called by the UI push service once a second.
+ */
+void ws_broadcast_key_stats(void);
+
+/**
+ * @brief Send log records to the clients subscribed to them
+ *
+ * Called by the UI push service; the log cursors belong to its task.
+ *
+ * @return true if any frame was queued
+ */
+bool ws_push_logs(void);
+
+/**
+ * @brief Push config and status changes to all clients (ws_delta.h)
+ *
+ * Called by the UI push service; its change tracking belongs to that task.
+ *
+ * @return true if any frame was queued
+ */
+bool ws_push_state(void);
+
+/**
+ * @brief Whether any client is subscribed to a topic
+ *
+ * One atomic load: producers call it before formatting anything.
+ */
+bool ws_topic_active(ws_topic_t topic);
+
+/**
+ * @brief Count of topic joins (a client gaining a topic), only ever grows
+ *
+ * A publisher that sends changes only sees a new subscriber by this
+ * moving, and sends it the full state once.
+ */
+unsigned ws_topic_joins(void);
+
 /**
  * @brief Get connected WebSocket client count
  * @return Number of active clients
  */
 int ws_get_client_count(void);
 
+/**
+ * @brief Get send queue counters of the connected clients
+ * @param out Array to fill
+ * @param max Capacity of out
+ * @return Number of entries filled
+ */
+int ws_get_client_stats(ws_client_stats_t *out, int max);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,92 @@
+/**
+ * @file ws_timeline.h
+ * @brief Binary WebSocket timeline frames (batched key edges)
+ *
+ * All key edges from one bg_task pass travel in one binary WebSocket
+ * frame instead of one JSON text message each. Little-endian layout:
+ *
+ *   Header (WS_TIMELINE_HEADER bytes)
+ *     [0]     Version (WS_TIMELINE_VERSION)
+ *     [1]     Record count
+ *     [2..3]  Stream tick period in us (u16)
+ *     [4..11] Stream time of the first record in us (u64, esp_timer base)
+ *   Records (WS_TIMELINE_RECORD bytes each)
+ *     [0..1]  Ticks since the previous record (u16, 0 for the first)
+ *     [2]     Channel (key_edge_channel_t: 0 key, 1 dit, 2 dah)
+ *     [3]     Level (1 = down/pressed)
+ *
+ * Records are 4-byte aligned after the header, so the browser decodes
+ * them from the ArrayBuffer with a DataView without copying.
+ *
+ * Pure encoder: no I/O, no allocation; the caller owns the frame.
+ */
+
+#ifndef KEYER_WEBUI_WS_TIMELINE_H
+#define KEYER_WEBUI_WS_TIMELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WS_TIMELINE_VERSION     1
+#define WS_TIMELINE_HEADER      12
+#define WS_TIMELINE_RECORD      4
+
+/** Records per frame (header + records fit a 256-byte WebSocket slot) */
+#define WS_TIMELINE_MAX_RECORDS 60
+
+#define WS_TIMELINE_FRAME_MAX   (WS_TIMELINE_HEADER + WS_TIMELINE_MAX_RECORDS * WS_TIMELINE_RECORD)
+
+/**
+ * @brief Frame under construction
+ */
+typedef struct {
+    uint8_t buf[WS_TIMELINE_FRAME_MAX]; /**< Encoded frame */
+    size_t len;                         /**< Bytes used (0 while empty) */
+    uint32_t count;                     /**< Records in buf */
+    uint32_t tick_period_us;            /**< Period written into the header */
+    uint64_t last_tick;                 /**< Tick of the newest record */
+} ws_timeline_frame_t;
+
+/**
+ * @brief Start an empty frame
+ *
+ * @param f Frame
+ * @param tick_period_us Stream tick period (must fit u16)
+ */
+void ws_timeline_reset(ws_timeline_frame_t *f, uint32_t tick_period_us);
+
+/**
+ * @brief Append one edge
+ *
+ * The first edge of a frame sets its base time. Returns false, leaving
+ * the frame unchanged, when it is full or the edge is more than 65535
+ * ticks after the previous one (or before it): send the frame, reset
+ * it and add the edge again.
+ *
+ * @param f Frame
+ * @param tick Absolute stream tick of the edge
+ * @param time_us Stream time of the edge (used for the first record)
+ * @param channel Edge channel
+ * @param level New level
+ * @return true if appended
+ */
+bool ws_timeline_add(ws_timeline_frame_t *f, uint64_t tick, int64_t time_us,
+                     uint8_t channel, uint8_t level);
+
+/**
+ * @brief Check if the frame holds no records
+ */
+static inline bool ws_timeline_is_empty(const ws_timeline_frame_t *f) {
+    return f->count == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_WS_TIMELINE_H */
@@ -0,0 +1,80 @@
+/**
+ * @file ws_topic.h
+ * @brief WebSocket subscription topics
+ *
+ * Every message the device pushes belongs to one topic, and a client
+ * gets only the topics it subscribed to:
+ *
+ *   {"type":"subscribe","topics":["decoder","text"]}
+ *
+ * replaces the client's set. A client that never subscribes gets
+ * WS_TOPICS_DEFAULT (everything but the logs and the keying statistics),
+ * as before topics existed. Unknown names are ignored, so a newer page
+ * still works with older firmware.
+ *
+ * The server keeps the union of all clients' sets as one word, and the
+ * producers skip the work for a topic nobody watches.
+ *
+ * Pure logic, no ESP-IDF calls.
+ */
+
+#ifndef KEYER_WEBUI_WS_TOPIC_H
+#define KEYER_WEBUI_WS_TOPIC_H
+
+#include "json_scan.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Topics
+ */
+typedef enum {
+    WS_TOPIC_TIMELINE = 0,   /**< Key edges (binary frames) and timeline events */
+    WS_TOPIC_DECODER,        /**< Decoded characters, words, current pattern */
+    WS_TOPIC_TEXT,           /**< Text keyer state (text_status) */
+    WS_TOPIC_CONFIG,         /**< Config deltas */
+    WS_TOPIC_STATUS,         /**< Status deltas, OTA progress */
+    WS_TOPIC_LOGS,           /**< Log records (filter set by the "log" command) */
+    WS_TOPIC_STATS,          /**< Keying statistics (key_stats.h), once a second */
+    WS_TOPIC_COUNT
+} ws_topic_t;
+
+#define WS_TOPIC_BIT(t) (1U << (unsigned)(t))
+
+#define WS_TOPICS_ALL ((1U << WS_TOPIC_COUNT) - 1U)
+
+/** Set of a client that has not subscribed (the topics that existed before) */
+#define WS_TOPICS_DEFAULT \
+    (WS_TOPICS_ALL & ~(WS_TOPIC_BIT(WS_TOPIC_LOGS) | WS_TOPIC_BIT(WS_TOPIC_STATS)))
+
+/**
+ * @brief Topic name ("timeline", ...), NULL for an invalid topic
+ */
+const char *ws_topic_name(ws_topic_t topic);
+
+/**
+ * @brief Topic of a name
+ *
+ * @return Topic, -1 if the name is unknown
+ */
+int ws_topic_parse(const char *name);
+
+/**
+ * @brief Topic set of a JSON array of names
+ *
+ * @param js Body
+ * @param toks Tokens (json_scan.h)
+ * @param arr Index of the array token
+ * @param mask Set of the known names
+ * @return false if arr is not an array of strings
+ */
+bool ws_topic_mask_parse(const char *js, const json_tok_t *toks, int arr, unsigned *mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WEBUI_WS_TOPIC_H */
@@ -1,16 +1,36 @@
 #!/usr/bin/env python3
 """
-Embed web assets as C arrays with gzip compression.
+Embed web assets as C arrays with gzip and Brotli compression, or pack them
+into an image for the "webui" flash partition.
 
 Usage:
-    python3 embed_assets.py <dist_dir> <output.c>
+    python3 embed_assets.py <dist_dir> <output.c> [--pack <webui.bin>] [--prefix <name>]
+
+With --pack the assets go into <webui.bin> (format in include/asset_pack.h)
+and <output.c> gets an empty table, so the app image carries no UI.
+
+--prefix names the generated table for another component: "prov" includes
+prov_assets.h and defines prov_embedded_find() etc. over prov_asset_t,
+which that header declares with the same fields as webui_asset_t.
+
+Each file is stored gzipped and, when it comes out smaller, as Brotli too
+(quality 11). Brotli comes from the brotli Python module if installed,
+otherwise from Node's zlib (Node is needed for the frontend build anyway);
+without either only gzip is stored.
 
 Example:
     python3 embed_assets.py frontend/dist src/assets.c
+    python3 embed_assets.py frontend/dist src/assets.c --pack build/webui.bin
+    python3 embed_assets.py www build/prov_assets.c --prefix prov
 """
 
 import sys
 import gzip
+import hashlib
+import re
+import shutil
+import struct
+import subprocess
 from pathlib import Path
 
 
@@ -24,6 +44,16 @@ MIME_TYPES = {
     '.ico': 'image/x-icon',
 }
 
+# Vite output names: assets/<name>-<8 char hash>.<ext>
+HASHED_NAME = re.compile(r'^/assets/.+-[A-Za-z0-9_-]{8}\.[A-Za-z0-9]+$')
+
+PACK_MAGIC = 0x4955574B  # "KWUI"
+PACK_VERSION = 2
+PACK_HEADER = struct.Struct('<IHHII')
+PACK_ENTRY = struct.Struct('<IIIIII20sB3x')
+PACK_F_GZIP = 0x01
+PACK_F_IMMUTABLE = 0x02
+
 
 def get_mime_type(path: Path) -> str:
     return MIME_TYPES.get(path.suffix.lower(), 'application/octet-stream')
@@ -44,13 +74,135 @@ def bytes_to_c_array(data: bytes) -> str:
     return '\n'.join(lines)
 
 
+# AP-mode link rate the build report estimates transfer time for
+REPORT_LINK_BPS = 1_000_000
+
+NODE_BROTLI = (
+    "const z=require('zlib');const c=[];process.stdin.on('data',d=>c.push(d));"
+    "process.stdin.on('end',()=>process.stdout.write(z.brotliCompressSync("
+    "Buffer.concat(c),{params:{[z.constants.BROTLI_PARAM_QUALITY]:11}})));"
+)
+
+
+def brotli_compress(content: bytes):
+    """Brotli at quality 11, or None if no encoder is available."""
+    try:
+        import brotli
+        return brotli.compress(content, quality=11)
+    except ImportError:
+        pass
+    node = shutil.which('node')
+    if node is None:
+        return None
+    result = subprocess.run([node, '-e', NODE_BROTLI], input=content,
+                            capture_output=True, check=True)
+    return result.stdout
+
+
+def content_etag(content: bytes) -> str:
+    """Quoted ETag from the uncompressed file (stable across gzip builds)."""
+    return '"' + hashlib.sha256(content).hexdigest()[:16] + '"'
+
+
+def with_root_alias(assets: list) -> list:
+    """Serve index.html at "/" too."""
+    index_asset = next((a for a in assets if a['path'] == '/index.html'), None)
+    if index_asset is None:
+        return assets
+    return [dict(index_asset, path='/')] + assets
+
+
+def write_pack(assets: list, output: Path) -> None:
+    entries = with_root_alias(assets)
+    strings = bytearray()
+    string_offsets = {}
+    table_end = PACK_HEADER.size + PACK_ENTRY.size * len(entries)
+
+    def string_at(s: str) -> int:
+        if s not in string_offsets:
+            string_offsets[s] = table_end + len(strings)
+            strings.extend(s.encode() + b'\0')
+        return string_offsets[s]
+
+    refs = [(string_at(a['path']), string_at(a['mime'])) for a in entries]
+
+    data = bytearray()
+    data_start = (table_end + len(strings) + 3) & ~3
+
+    def body_at(body) -> int:
+        if not body:
+            return 0
+        off = data_start + len(data)
+        data.extend(body)
+        data.extend(b'\0' * (-len(data) % 4))
+        return off
+
+    data_offsets = {a['path']: (body_at(a['data']), body_at(a['br'])) for a in assets}
+
+    table = bytearray()
+    for a, (path_off, mime_off) in zip(entries, refs):
+        source = '/index.html' if a['path'] == '/' else a['path']
+        gz_off, br_off = data_offsets[source]
+        flags = PACK_F_GZIP | (PACK_F_IMMUTABLE if a['immutable'] else 0)
+        table.extend(PACK_ENTRY.pack(path_off, mime_off, gz_off, len(a['data']),
+                                     br_off, len(a['br'] or b''),
+                                     a['etag'].encode(), flags))
+
+    body = table + strings + b'\0' * (data_start - table_end - len(strings)) + data
+    image_len = PACK_HEADER.size + len(body)
+    header = PACK_HEADER.pack(PACK_MAGIC, PACK_VERSION, len(entries), image_len, 0)
+    output.parent.mkdir(parents=True, exist_ok=True)
+    output.write_bytes(header + body)
+    print(f"\nPacked {len(entries)} assets into {output} ({image_len} bytes)")
+
+
+def report(assets: list) -> None:
+    """Totals and what they cost to load over a slow AP-mode link."""
+    raw = sum(a['original_size'] for a in assets)
+    gz = sum(len(a['data']) for a in assets)
+    br = sum(len(a['br'] or a['data']) for a in assets)
+    stored = gz + sum(len(a['br']) for a in assets if a['br'] is not None)
+
+    def load_ms(n: int) -> int:
+        return n * 8 * 1000 // REPORT_LINK_BPS
+
+    print(f"\n  total {raw} bytes: gzip {gz}, brotli {br} "
+          f"({100 - 100 * br // max(gz, 1)}% smaller), stored {stored}")
+    print(f"  first load at {REPORT_LINK_BPS // 1000} kbit/s: "
+          f"gzip {load_ms(gz)} ms, brotli {load_ms(br)} ms")
+    if all(a['br'] is None for a in assets):
+        print("  WARNING: no Brotli encoder (pip install brotli, or node); gzip only")
+
+
 def main():
-    if len(sys.argv) < 3:
-        print(f"Usage: {sys.argv[0]} <dist_dir> <output.c>", file=sys.stderr)
+    args = sys.argv[1:]
+    pack_file = None
+    if '--pack' in args:
+        i = args.index('--pack')
+        if i + 1 >= len(args):
+            print("ERROR: --pack needs an output file", file=sys.stderr)
+            sys.exit(1)
+        pack_file = Path(args[i + 1])
+        del args[i:i + 2]
+
+    prefix = 'webui'
+    if '--prefix' in args:
+        i = args.index('--prefix')
+        if i + 1 >= len(args) or not re.fullmatch(r'[a-z_][a-z0-9_]*', args[i + 1]):
+            print("ERROR: --prefix needs a C identifier", file=sys.stderr)
+            sys.exit(1)
+        prefix = args[i + 1]
+        del args[i:i + 2]
+    header = 'assets.h' if prefix == 'webui' else f'{prefix}_assets.h'
+
+    if len(args) < 2:
+        print(f"Usage: {sys.argv[0]} <dist_dir> <output.c> [--pack <webui.bin>] "
+              "[--prefix <name>]",
+              file=sys.stderr)
         sys.exit(1)
 
-    dist_dir = Path(sys.argv[1])
-    output_file = Path(sys.argv[2])
+    dist_dir = Path(args[0])
+    output_file = Path(args[1])
 
     if not dist_dir.exists():
         print(f"ERROR: {dist_dir} not found", file=sys.stderr)
@@ -63,9 +215,12 @@ def main():
         if file_path.is_dir():
             continue
 
-        rel_path = '/' + str(file_path.relative_to(dist_dir))
+        rel_path = '/' + file_path.relative_to(dist_dir).as_posix()
         content = file_path.read_bytes()
-        compressed = gzip.compress(content, compresslevel=9)
+        compressed = gzip.compress(content, compresslevel=9, mtime=0)
+        br = brotli_compress(content)
+        if br is not None and len(br) >= len(compressed):
+            br = None
 
         assets.append({
             'path': rel_path,
@@ -73,48 +228,64 @@ def main():
             'mime': get_mime_type(file_path),
             'data': compressed,
             'original_size': len(content),
+            'br': br,
+            'etag': content_etag(content),
+            'immutable': HASHED_NAME.match(rel_path) is not None,
         })
 
-        print(f"  {rel_path}: {len(content)} -> {len(compressed)} bytes "
-              f"({100*len(compressed)//len(content)}%)")
+        br_note = f", br {len(br)}" if br is not None else ", br -"
+        print(f"  {rel_path}: {len(content)} -> gz {len(compressed)}{br_note} bytes")
+
+    report(assets)
+
+    if pack_file is not None:
+        write_pack(assets, pack_file)
+        embedded = []
+    else:
+        embedded = with_root_alias(assets)
 
     # Generate C file
     output_lines = [
         '/* Auto-generated by embed_assets.py - DO NOT EDIT */',
-        '#include "assets.h"',
+        f'#include "{header}"',
         '#include <string.h>',
         '',
     ]
 
     # Data arrays
-    for asset in assets:
+    for asset in assets if pack_file is None else []:
         output_lines.append(f'static const uint8_t asset_{asset["name"]}[] = {{')
         output_lines.append(bytes_to_c_array(asset['data']))
         output_lines.append('};')
         output_lines.append('')
+        if asset['br'] is not None:
+            output_lines.append(f'static const uint8_t asset_{asset["name"]}_br[] = {{')
+            output_lines.append(bytes_to_c_array(asset['br']))
+            output_lines.append('};')
+            output_lines.append('')
 
-    # Asset table
-    output_lines.append('static const webui_asset_t s_assets[] = {')
-
-    # Add root alias for index.html
-    index_asset = next((a for a in assets if a['path'] == '/index.html'), None)
-    if index_asset:
-        output_lines.append(f'    {{"/", "{index_asset["mime"]}", '
-                          f'asset_{index_asset["name"]}, {len(index_asset["data"])}, true}},')
-
-    for asset in assets:
+    # Asset table ("/" shares index.html's data)
+    output_lines.append(f'static const {prefix}_asset_t s_assets[] = {{')
+    for asset in embedded:
+        name = sanitize_name('/index.html') if asset['path'] == '/' else asset['name']
+        immutable = 'true' if asset['immutable'] else 'false'
+        etag = asset['etag'].replace('"', '\\"')
+        if asset['br'] is not None:
+            br = f'asset_{name}_br, {len(asset["br"])}'
+        else:
+            br = 'NULL, 0'
         output_lines.append(f'    {{"{asset["path"]}", "{asset["mime"]}", '
-                          f'asset_{asset["name"]}, {len(asset["data"])}, true}},')
-
-    output_lines.append('    {NULL, NULL, NULL, 0, false},  /* Terminator */')
+                            f'asset_{name}, {len(asset["data"])}, true, {br}, '
+                            f'"{etag}", {immutable}}},')
+    output_lines.append('    {NULL, NULL, NULL, 0, false, NULL, 0, NULL, false},  /* Terminator */')
     output_lines.append('};')
     output_lines.append('')
 
     # Functions
     output_lines.extend([
-        f'static const size_t s_asset_count = {len(assets) + (1 if index_asset else 0)};',
+        f'static const size_t s_asset_count = {len(embedded)};',
         '',
-        'const webui_asset_t *webui_find_asset(const char *path) {',
+        f'const {prefix}_asset_t *{prefix}_embedded_find(const char *path) {{',
         '    for (size_t i = 0; s_assets[i].path != NULL; i++) {',
         '        if (strcmp(s_assets[i].path, path) == 0) {',
         '            return &s_assets[i];',
@@ -123,17 +294,17 @@ def main():
         '    return NULL;',
         '}',
         '',
-        'size_t webui_get_asset_count(void) {',
+        f'size_t {prefix}_embedded_count(void) {{',
         '    return s_asset_count;',
         '}',
         '',
-        'const webui_asset_t *webui_get_assets(void) {',
+        f'const {prefix}_asset_t *{prefix}_get_assets(void) {{',
         '    return s_assets;',
         '}',
     ])
 
     output_file.write_text('\n'.join(output_lines) + '\n')
-    print(f"\nGenerated {output_file} with {len(assets)} assets")
+    print(f"\nGenerated {output_file} with {len(embedded)} assets")
 
 
 if __name__ == '__main__':
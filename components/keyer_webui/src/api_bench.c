@@ -0,0 +1,107 @@
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "bench.h"
+#include "json_writer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "api_bench";
+
+/* ============================================================================
+ * JSON writer kernel (keyer_bench cannot reach keyer_webui)
+ * ============================================================================ */
+
+static bool bench_json_flush(void *ctx, const char *data, size_t len) {
+    (void)data;
+    *(size_t *)ctx += len;
+    return true;
+}
+
+/* One document shaped like /api/system/stats: a few scalars and an array
+ * of eight small objects, streamed through a 256-byte chunk buffer */
+static uint32_t k_json_writer(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    static char chunk[256];
+    static const char *const names[] = {
+        "decoder", "net", "ui_push", "housekeeping", "persist", "console", "http", "led",
+    };
+    size_t sent = 0;
+
+    uint32_t t0 = bench_cycles();
+    for (uint32_t i = 0; i < ops; i++) {
+        json_writer_t w;
+        json_writer_init(&w, chunk, sizeof(chunk), bench_json_flush, &sent);
+        json_object_begin(&w, NULL);
+        json_uint(&w, "uptime_us", 123456789ULL + i);
+        json_uint(&w, "heap_free", 181234);
+        json_string(&w, "state", "connected");
+        json_array_begin(&w, "services");
+        for (size_t s = 0; s < sizeof(names) / sizeof(names[0]); s++) {
+            json_object_begin(&w, NULL);
+            json_string(&w, "name", names[s]);
+            json_uint(&w, "passes", 1000U + s);
+            json_uint(&w, "busy_us", 52341U * s);
+            json_bool(&w, "adaptive", (s & 1U) != 0);
+            json_object_end(&w);
+        }
+        json_array_end(&w);
+        json_object_end(&w);
+        json_writer_finish(&w);
+    }
+    uint32_t cycles = bench_cycles() - t0;
+
+    if (sent == 0) {
+        ESP_LOGW(TAG, "JSON kernel wrote nothing");
+    }
+    return cycles;
+}
+
+static const bench_kernel_t s_webui_kernels[] = {
+    { "json_writer_stats", k_json_writer, 2048, 0 },
+};
+
+void api_bench_init(void) {
+    bench_register(s_webui_kernels, sizeof(s_webui_kernels) / sizeof(s_webui_kernels[0]));
+}
+
+/* ============================================================================
+ * GET /api/bench[?filter=prefix]
+ * ============================================================================ */
+
+/* Runs for about a second: registered async, so never twice at once */
+esp_err_t api_bench_handler(httpd_req_t *req) {
+    static bench_result_t s_results[BENCH_MAX_RESULTS];
+    char query[48];
+    char filter[32] = "";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "filter", filter, sizeof(filter));
+    }
+
+    int n = bench_run(filter[0] ? filter : NULL, s_results, BENCH_MAX_RESULTS);
+    if (n < 0) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "2");
+        httpd_resp_set_type(req, "application/json");
+        return httpd_resp_sendstr(req, "{\"error\":\"Benchmark running\"}");
+    }
+
+    const size_t cap = 4096;
+    char *json = malloc(cap);
+    if (json == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    size_t len = bench_format_json(s_results, (size_t)n, json, cap);
+    if (len == 0) {
+        free(json);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Results too large");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Bench: %d kernels", n);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    esp_err_t ret = httpd_resp_send(req, json, (ssize_t)len);
+    free(json);
+    return ret;
+}
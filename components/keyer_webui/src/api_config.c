@@ -1,27 +1,72 @@
 #include "esp_http_server.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "cJSON.h"
+#include "json_scan.h"
 #include "config.h"
 #include "config_console.h"
 #include "config_nvs.h"
+#include "config_persist.h"
 #include "config_schema.h"
+#include "config_profile.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "api_config";
 
-/* GET /api/config/schema */
+/*
+ * Serialized GET /api/config, rebuilt only when g_config.generation moves.
+ * Handlers all run in the httpd task, so the cache needs no locking.
+ * The ETag carries a per-boot stamp because generation restarts at 0.
+ */
+static struct {
+    char *json;         /**< PSRAM buffer (NULL until first request) */
+    size_t len;         /**< Bytes of JSON in json */
+    size_t cap;         /**< Allocated size of json */
+    bool valid;         /**< json matches generation */
+    uint16_t generation;
+    uint32_t boot_stamp;
+    char etag[32];
+} s_cfg_cache;
+
+/**
+ * @brief Answer 304 if the request's If-None-Match equals etag
+ */
+static bool send_not_modified(httpd_req_t *req, const char *etag) {
+    char if_none_match[40];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match,
+                                    sizeof(if_none_match)) != ESP_OK) {
+        return false;
+    }
+    if (strcmp(if_none_match, etag) != 0) {
+        return false;
+    }
+    httpd_resp_set_status(req, "304 Not Modified");
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_send(req, NULL, 0);
+    return true;
+}
+
+/* GET /api/config/schema - gzipped at build time by gen_config_c.py */
 esp_err_t api_config_schema_handler(httpd_req_t *req) {
+    if (send_not_modified(req, CONFIG_SCHEMA_ETAG)) {
+        return ESP_OK;
+    }
     httpd_resp_set_type(req, "application/json");
-    return httpd_resp_send(req, CONFIG_SCHEMA_JSON, HTTPD_RESP_USE_STRLEN);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "ETag", CONFIG_SCHEMA_ETAG);
+    return httpd_resp_send(req, (const char *)CONFIG_SCHEMA_JSON_GZ,
+                           (ssize_t)CONFIG_SCHEMA_JSON_GZ_LEN);
 }
 
-/* GET /api/config */
-esp_err_t api_config_get_handler(httpd_req_t *req) {
+static char *build_config_json(void) {
     cJSON *root = cJSON_CreateObject();
     if (root == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON alloc failed");
-        return ESP_FAIL;
+        return NULL;
     }
 
     /* Iterate all parameters and add to JSON */
@@ -64,16 +109,83 @@ esp_err_t api_config_get_handler(httpd_req_t *req) {
 
     char *json_str = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
+    return json_str;
+}
 
+/**
+ * @brief Bring the cached config JSON up to the current generation
+ */
+static bool refresh_config_cache(void) {
+    uint16_t gen = atomic_load_explicit(&g_config.generation, memory_order_acquire);
+    if (s_cfg_cache.valid && s_cfg_cache.generation == gen) {
+        return true;
+    }
+
+    char *json_str = build_config_json();
     if (json_str == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON print failed");
+        return false;
+    }
+
+    size_t len = strlen(json_str);
+    if (len + 1 > s_cfg_cache.cap) {
+        size_t cap = len + 1 + 256;   /* Headroom for longer strings */
+        char *buf = heap_caps_realloc(s_cfg_cache.json, cap, MALLOC_CAP_SPIRAM);
+        if (buf == NULL) {
+            buf = realloc(s_cfg_cache.json, cap);
+        }
+        if (buf == NULL) {
+            cJSON_free(json_str);
+            return false;
+        }
+        s_cfg_cache.json = buf;
+        s_cfg_cache.cap = cap;
+    }
+    memcpy(s_cfg_cache.json, json_str, len + 1);
+    cJSON_free(json_str);
+
+    if (s_cfg_cache.boot_stamp == 0) {
+        s_cfg_cache.boot_stamp = (uint32_t)esp_timer_get_time() | 1U;
+    }
+    s_cfg_cache.len = len;
+    /* A set landing mid-build leaves gen stale: the next request rebuilds */
+    s_cfg_cache.generation = gen;
+    s_cfg_cache.valid = true;
+    snprintf(s_cfg_cache.etag, sizeof(s_cfg_cache.etag), "\"%08" PRIx32 "-%u\"",
+             s_cfg_cache.boot_stamp, (unsigned)gen);
+    return true;
+}
+
+/* GET /api/config */
+esp_err_t api_config_get_handler(httpd_req_t *req) {
+    if (!refresh_config_cache()) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON build failed");
         return ESP_FAIL;
     }
 
+    if (send_not_modified(req, s_cfg_cache.etag)) {
+        return ESP_OK;
+    }
+
     httpd_resp_set_type(req, "application/json");
-    esp_err_t ret = httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
-    cJSON_free(json_str);
-    return ret;
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "ETag", s_cfg_cache.etag);
+    return httpd_resp_send(req, s_cfg_cache.json, (ssize_t)s_cfg_cache.len);
+}
+
+/**
+ * @brief Convert a JSON bool/number/string to the config_set_param_str form
+ */
+static bool json_value_to_str(const cJSON *item, char *buf, size_t len) {
+    if (cJSON_IsBool(item)) {
+        snprintf(buf, len, "%s", cJSON_IsTrue(item) ? "true" : "false");
+    } else if (cJSON_IsNumber(item)) {
+        snprintf(buf, len, "%d", item->valueint);
+    } else if (cJSON_IsString(item)) {
+        snprintf(buf, len, "%s", item->valuestring);
+    } else {
+        return false;
+    }
+    return true;
 }
 
 /* POST /api/parameter - body: {"param": "keyer.wpm", "value": 25} */
@@ -84,44 +196,30 @@ esp_err_t api_parameter_set_handler(httpd_req_t *req) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No body");
         return ESP_FAIL;
     }
-    buf[received] = '\0';
 
-    cJSON *json = cJSON_Parse(buf);
-    if (json == NULL) {
+    /* Tokenized in place: nothing on the heap */
+    json_tok_t toks[16];
+    if (json_scan(buf, (size_t)received, toks, sizeof(toks) / sizeof(toks[0])) < 0) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
     }
 
-    cJSON *param_item = cJSON_GetObjectItem(json, "param");
-    cJSON *value_item = cJSON_GetObjectItem(json, "value");
+    int param_idx = json_scan_get(buf, toks, 0, "param");
+    int value_idx = json_scan_get(buf, toks, 0, "value");
 
-    if (!cJSON_IsString(param_item) || value_item == NULL) {
-        cJSON_Delete(json);
+    char param_name[64];
+    if (param_idx < 0 || value_idx < 0 ||
+        !json_scan_string(buf, &toks[param_idx], param_name, sizeof(param_name))) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing param or value");
         return ESP_FAIL;
     }
 
-    /* Copy param name before freeing json */
-    char param_name[64];
-    snprintf(param_name, sizeof(param_name), "%s", param_item->valuestring);
-
     char value_str[64];
-
-    if (cJSON_IsBool(value_item)) {
-        snprintf(value_str, sizeof(value_str), "%s",
-                 cJSON_IsTrue(value_item) ? "true" : "false");
-    } else if (cJSON_IsNumber(value_item)) {
-        snprintf(value_str, sizeof(value_str), "%d", value_item->valueint);
-    } else if (cJSON_IsString(value_item)) {
-        snprintf(value_str, sizeof(value_str), "%s", value_item->valuestring);
-    } else {
-        cJSON_Delete(json);
+    if (!json_scan_value_str(buf, &toks[value_idx], value_str, sizeof(value_str))) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid value type");
         return ESP_FAIL;
     }
 
-    cJSON_Delete(json);
-
     int result = config_set_param_str(param_name, value_str);
     if (result != 0) {
         ESP_LOGW(TAG, "Failed to set %s = %s (error=%d)", param_name, value_str, result);
@@ -143,17 +241,101 @@ esp_err_t api_parameter_set_handler(httpd_req_t *req) {
     return httpd_resp_send(req, "{\"success\":true,\"requires_reset\":false}", HTTPD_RESP_USE_STRLEN);
 }
 
-/* POST /api/config/save */
-esp_err_t api_config_save_handler(httpd_req_t *req) {
-    /* Rate-limit NVS saves to prevent flash wear */
-    static int64_t last_save_us = 0;
-    int64_t now_us = esp_timer_get_time();
-    if (last_save_us > 0 && (now_us - last_save_us) < (int64_t)10 * 1000000) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "Save rate limited (10s interval)");
+/*
+ * POST /api/parameters/batch
+ * body: {"values": {"keyer.wpm": 25, "audio.sidetone_freq_hz": 700}, "save": true}
+ *
+ * All-or-nothing: every value is validated before any is applied, and the
+ * whole batch costs one generation bump (one "Config updated" on rt_task).
+ * "save" queues the same deferred single-commit save as /api/config/save.
+ */
+esp_err_t api_parameters_batch_handler(httpd_req_t *req) {
+    if (req->content_len == 0 || req->content_len > 4096) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body missing or too large");
+        return ESP_FAIL;
+    }
+
+    char *body = malloc(req->content_len + 1);
+    if (body == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    size_t received = 0;
+    while (received < req->content_len) {
+        int r = httpd_req_recv(req, body + received, req->content_len - received);
+        if (r <= 0) {
+            free(body);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body read failed");
+            return ESP_FAIL;
+        }
+        received += (size_t)r;
+    }
+    body[received] = '\0';
+
+    cJSON *json = cJSON_Parse(body);
+    free(body);
+    cJSON *values = cJSON_GetObjectItem(json, "values");
+    if (json == NULL || !cJSON_IsObject(values)) {
+        cJSON_Delete(json);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing values object");
+        return ESP_FAIL;
+    }
+    bool do_save = cJSON_IsTrue(cJSON_GetObjectItem(json, "save"));
+
+    /* Value strings live here until applied; names point into the tree */
+    static char s_value_bufs[CONFIG_BATCH_MAX][64];
+    const char *names[CONFIG_BATCH_MAX];
+    const char *value_strs[CONFIG_BATCH_MAX];
+    size_t count = 0;
+
+    const cJSON *item = NULL;
+    cJSON_ArrayForEach(item, values) {
+        if (count >= CONFIG_BATCH_MAX) {
+            cJSON_Delete(json);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Too many parameters");
+            return ESP_FAIL;
+        }
+        if (!json_value_to_str(item, s_value_bufs[count], sizeof(s_value_bufs[count]))) {
+            char err_msg[128];
+            snprintf(err_msg, sizeof(err_msg), "Invalid value type: %.60s", item->string);
+            cJSON_Delete(json);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, err_msg);
+            return ESP_FAIL;
+        }
+        names[count] = item->string;
+        value_strs[count] = s_value_bufs[count];
+        count++;
+    }
+
+    size_t bad = 0;
+    int result = config_set_params_batch(names, value_strs, count, &bad);
+    if (result != 0) {
+        char err_msg[128];
+        const char *why = (result == -1) ? "Parameter not found" : "Invalid value";
+        snprintf(err_msg, sizeof(err_msg), "%s: %.60s", why, names[bad]);
+        ESP_LOGW(TAG, "Batch rejected at %.60s (error=%d)", names[bad], result);
+        cJSON_Delete(json);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, err_msg);
         return ESP_FAIL;
     }
+    cJSON_Delete(json);
+
+    ESP_LOGI(TAG, "Batch set %u parameters", (unsigned)count);
+
+    if (do_save) {
+        config_persist_request();
+    }
+
+    char response[96];
+    snprintf(response, sizeof(response), "{\"success\":true,\"applied\":%u,\"queued\":%s}",
+             (unsigned)count, do_save ? "true" : "false");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
+}
 
+/* POST /api/config/save[?reboot=true] */
+esp_err_t api_config_save_handler(httpd_req_t *req) {
     /* Check for reboot query param */
     char query[32] = {0};
     bool do_reboot = false;
@@ -165,18 +347,18 @@ esp_err_t api_config_save_handler(httpd_req_t *req) {
         }
     }
 
-    int saved = config_save_to_nvs();
-    last_save_us = esp_timer_get_time();
-    if (saved < 0) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "NVS save failed");
-        return ESP_FAIL;
+    /* Only dirty keys are written, debounced and deferred until the keyer
+     * is idle (config_persist.h), so repeated saves cost no flash wear */
+    bool dirty = config_any_dirty();
+    config_persist_request();
+    if (do_reboot) {
+        config_persist_flush();
     }
 
-    ESP_LOGI(TAG, "Saved %d parameters to NVS", saved);
-
     httpd_resp_set_type(req, "application/json");
     char response[64];
-    snprintf(response, sizeof(response), "{\"success\":true,\"saved\":%d}", saved);
+    snprintf(response, sizeof(response), "{\"success\":true,\"queued\":%s}",
+             dirty ? "true" : "false");
     esp_err_t ret = httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
 
     if (do_reboot) {
@@ -187,3 +369,74 @@ esp_err_t api_config_save_handler(httpd_req_t *req) {
 
     return ret;
 }
+
+/* GET /api/config/profile - every parameter and the text memories, binary
+ * (config_profile.h); PUT the same file back on this or another keyer */
+esp_err_t api_config_profile_get_handler(httpd_req_t *req) {
+    uint8_t *buf = malloc(CONFIG_PROFILE_MAX_SIZE);
+    if (buf == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    size_t len = config_profile_export(buf, CONFIG_PROFILE_MAX_SIZE);
+    if (len == 0) {
+        free(buf);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Profile too large");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"keyer.kprf\"");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    esp_err_t ret = httpd_resp_send(req, (const char *)buf, (ssize_t)len);
+    free(buf);
+    return ret;
+}
+
+/* PUT /api/config/profile - all-or-nothing, one generation bump, saved */
+esp_err_t api_config_profile_put_handler(httpd_req_t *req) {
+    if (req->content_len == 0 || req->content_len > CONFIG_PROFILE_MAX_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body missing or too large");
+        return ESP_FAIL;
+    }
+
+    uint8_t *buf = malloc(req->content_len);
+    if (buf == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    size_t received = 0;
+    while (received < req->content_len) {
+        int r = httpd_req_recv(req, (char *)buf + received, req->content_len - received);
+        if (r <= 0) {
+            free(buf);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Body read failed");
+            return ESP_FAIL;
+        }
+        received += (size_t)r;
+    }
+
+    config_profile_result_t res;
+    int err = config_profile_import(buf, received, &res);
+    free(buf);
+    if (err != 0 && err != CONFIG_PROFILE_ERR_SAVE) {
+        char err_msg[128];
+        snprintf(err_msg, sizeof(err_msg), "%s%s%.60s", config_profile_strerror(err),
+                 res.bad_key ? ": " : "", res.bad_key ? res.bad_key : "");
+        ESP_LOGW(TAG, "Profile rejected (error=%d)", err);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, err_msg);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Profile applied: %u parameters, %u unknown, %u memories",
+             res.applied, res.skipped, res.memories);
+
+    char response[128];
+    snprintf(response, sizeof(response),
+             "{\"success\":%s,\"applied\":%u,\"skipped\":%u,\"memories\":%u}",
+             err == 0 ? "true" : "false", res.applied, res.skipped, res.memories);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
+}
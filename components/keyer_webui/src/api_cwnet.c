@@ -0,0 +1,29 @@
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "cwnet_capture.h"
+
+static const char *TAG = "api_cwnet";
+
+/* GET /api/cwnet/capture - .pcap of the frames in the capture ring */
+esp_err_t api_cwnet_capture_handler(httpd_req_t *req) {
+    cwnet_capture_export_t exp;
+    cwnet_capture_export_begin(&exp, &g_cwnet_capture);
+
+    httpd_resp_set_type(req, "application/vnd.tcpdump.pcap");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"cwnet.pcap\"");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Records are built from the ring one chunk at a time */
+    uint8_t chunk[1024];
+    size_t n;
+    while ((n = cwnet_capture_export_read(&exp, chunk, sizeof(chunk))) > 0) {
+        if (httpd_resp_send_chunk(req, (const char *)chunk, (ssize_t)n) != ESP_OK) {
+            ESP_LOGW(TAG, "Capture download aborted by client");
+            return ESP_FAIL;
+        }
+    }
+    if (exp.lost) {
+        ESP_LOGW(TAG, "Capture lapped during download, %u slots skipped", (unsigned)exp.lost);
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
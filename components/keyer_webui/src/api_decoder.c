@@ -1,41 +1,36 @@
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "cJSON.h"
+#include "api_json.h"
 #include "decoder.h"
+#include "decoder_transcript.h"
+#include <stdlib.h>
 
 static const char *TAG = "api_decoder";
 
+/* Decoded text history (main/bg_task.c) */
+extern transcript_t g_decoder_transcript;
+
 /* GET /api/decoder/status */
 esp_err_t api_decoder_status_handler(httpd_req_t *req) {
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON alloc failed");
-        return ESP_FAIL;
-    }
+    api_json_t resp;
+    api_json_begin(&resp, req);
+    json_writer_t *w = api_json_writer(&resp);
+    json_object_begin(w, NULL);
 
-    cJSON_AddBoolToObject(root, "enabled", decoder_is_enabled());
-    cJSON_AddNumberToObject(root, "wpm", (int)decoder_get_wpm());
+    json_bool(w, "enabled", decoder_is_enabled());
+    json_uint(w, "wpm", decoder_get_wpm());
 
     char pattern[16];
     decoder_get_current_pattern(pattern, sizeof(pattern));
-    cJSON_AddStringToObject(root, "pattern", pattern);
+    json_string(w, "pattern", pattern);
 
     char text[128];
     decoder_get_text(text, sizeof(text));
-    cJSON_AddStringToObject(root, "text", text);
-
-    char *json_str = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    if (json_str == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON print failed");
-        return ESP_FAIL;
-    }
+    json_string(w, "text", text);
 
-    httpd_resp_set_type(req, "application/json");
-    esp_err_t ret = httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
-    cJSON_free(json_str);
-    return ret;
+    json_object_end(w);
+    return api_json_end(&resp);
 }
 
 /* POST /api/decoder/enable - body: {"enabled": true} */
@@ -70,3 +65,57 @@ esp_err_t api_decoder_enable_handler(httpd_req_t *req) {
     httpd_resp_set_type(req, "application/json");
     return httpd_resp_send(req, "{\"success\":true}", HTTPD_RESP_USE_STRLEN);
 }
+
+/* Characters per /api/decoder/text response (client asks again while next < head) */
+#define TEXT_CHUNK_CHARS 1024
+
+/* GET /api/decoder/text[?since=SEQ] - transcript from sequence SEQ on */
+esp_err_t api_decoder_text_handler(httpd_req_t *req) {
+    uint32_t since = 0;
+    char query[32] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char param[12];
+        if (httpd_query_key_value(query, "since", param, sizeof(param)) == ESP_OK) {
+            since = (uint32_t)strtoul(param, NULL, 10);
+        }
+    }
+
+    char *text = malloc(TEXT_CHUNK_CHARS + 1);
+    if (text == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    transcript_slice_t slice;
+    size_t n = transcript_read(&g_decoder_transcript, since, text, TEXT_CHUNK_CHARS, &slice);
+    text[n] = '\0';
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        free(text);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON alloc failed");
+        return ESP_FAIL;
+    }
+
+    /* first > since: characters were lost (overwritten, or keyer restarted) */
+    cJSON_AddNumberToObject(root, "first", (double)slice.first_seq);
+    cJSON_AddNumberToObject(root, "next", (double)slice.next_seq);
+    cJSON_AddNumberToObject(root, "head", (double)slice.head_seq);
+    cJSON_AddNumberToObject(root, "word", (double)slice.first_word);
+    cJSON_AddNumberToObject(root, "words", (double)transcript_words(&g_decoder_transcript));
+    cJSON_AddStringToObject(root, "text", text);
+    free(text);
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (json_str == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON print failed");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    esp_err_t ret = httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
+    cJSON_free(json_str);
+    return ret;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file api_json.c
+ * @brief Chunked JSON responses for the API handlers
+ */
+
+#include "api_json.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+#ifdef CONFIG_KEYER_WEBUI_HEAP_TRACE
+static const char *TAG = "api_json";
+#endif
+
+static bool send_chunk(void *ctx, const char *data, size_t len) {
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, (ssize_t)len) == ESP_OK;
+}
+
+void api_json_begin(api_json_t *resp, httpd_req_t *req) {
+    resp->req = req;
+#ifdef CONFIG_KEYER_WEBUI_HEAP_TRACE
+    resp->heap_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+#endif
+    httpd_resp_set_type(req, "application/json");
+    json_writer_init(&resp->w, resp->buf, sizeof(resp->buf), send_chunk, req);
+}
+
+esp_err_t api_json_end(api_json_t *resp) {
+    bool ok = json_writer_finish(&resp->w);
+    if (ok) {
+        ok = httpd_resp_send_chunk(resp->req, NULL, 0) == ESP_OK;
+    }
+#ifdef CONFIG_KEYER_WEBUI_HEAP_TRACE
+    int held = (int)resp->heap_before - (int)heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    ESP_LOGI(TAG, "%s: %u bytes, internal heap %+d", resp->req->uri,
+             (unsigned)resp->w.total, held);
+#endif
+    return ok ? ESP_OK : ESP_FAIL;
+}
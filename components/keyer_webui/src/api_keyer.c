@@ -6,8 +6,11 @@
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "cJSON.h"
+#include "api_json.h"
+#include "json_scan.h"
 #include "text_keyer.h"
 #include "text_memory.h"
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "api_keyer";
@@ -43,71 +46,78 @@ static int read_post_body(httpd_req_t *req, char *buf, size_t max_len) {
     return (int)received;
 }
 
-/* POST /api/text/send - Send arbitrary text */
-esp_err_t api_text_send_handler(httpd_req_t *req) {
-    char buf[256];
-    if (read_post_body(req, buf, sizeof(buf)) < 0) {
+/* Tokens per request body: the bodies below are flat objects of a few fields */
+#define BODY_TOKENS 16
+
+/**
+ * @brief Read and tokenize a POST body into caller buffers (no heap)
+ *
+ * @return Tokens, or -1 after sending the 400 response
+ */
+static int scan_post_body(httpd_req_t *req, char *buf, size_t max_len, json_tok_t *toks) {
+    int len = read_post_body(req, buf, max_len);
+    if (len < 0) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid body");
-        return ESP_FAIL;
+        return -1;
     }
-
-    cJSON *json = cJSON_Parse(buf);
-    if (json == NULL) {
+    int n = json_scan(buf, (size_t)len, toks, BODY_TOKENS);
+    if (n < 0) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+    }
+    return n;
+}
+
+/* POST /api/text/send - Send arbitrary text */
+esp_err_t api_text_send_handler(httpd_req_t *req) {
+    char buf[256];
+    json_tok_t toks[BODY_TOKENS];
+    if (scan_post_body(req, buf, sizeof(buf), toks) < 0) {
         return ESP_FAIL;
     }
 
-    cJSON *text_obj = cJSON_GetObjectItem(json, "text");
-    if (!cJSON_IsString(text_obj) || text_obj->valuestring == NULL) {
-        cJSON_Delete(json);
+    /* Unescaped text is never longer than the body */
+    char text[256];
+    int text_idx = json_scan_get(buf, toks, 0, "text");
+    if (text_idx < 0 || !json_scan_string(buf, &toks[text_idx], text, sizeof(text))) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing 'text' field");
         return ESP_FAIL;
     }
 
-    int ret = text_keyer_send(text_obj->valuestring);
-    cJSON_Delete(json);
+    int ret = text_keyer_send(text);
 
     if (ret != 0) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Keyer busy or invalid text");
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Type-ahead full or invalid text");
         return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "Text send started");
+    ESP_LOGI(TAG, "Text queued");
     httpd_resp_set_type(req, "application/json");
     return httpd_resp_send(req, "{\"success\":true}", HTTPD_RESP_USE_STRLEN);
 }
 
 /* GET /api/text/status - Get keyer state and progress */
 esp_err_t api_text_status_handler(httpd_req_t *req) {
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON alloc failed");
-        return ESP_FAIL;
-    }
-
     text_keyer_state_t state = text_keyer_get_state();
     size_t sent = 0, total = 0;
     text_keyer_get_progress(&sent, &total);
 
     int progress = (total > 0) ? (int)((sent * 100) / total) : 0;
 
-    cJSON_AddStringToObject(root, "state", state_to_string(state));
-    cJSON_AddNumberToObject(root, "sent", (int)sent);
-    cJSON_AddNumberToObject(root, "total", (int)total);
-    cJSON_AddNumberToObject(root, "progress", progress);
-
-    char *json_str = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    if (json_str == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON print failed");
-        return ESP_FAIL;
-    }
-
-    httpd_resp_set_type(req, "application/json");
-    esp_err_t ret = httpd_resp_send(req, json_str, HTTPD_RESP_USE_STRLEN);
-    cJSON_free(json_str);
-    return ret;
+    text_keyer_buffer_t buffer;
+    text_keyer_get_buffer(&buffer);
+
+    api_json_t resp;
+    api_json_begin(&resp, req);
+    json_writer_t *w = api_json_writer(&resp);
+    json_object_begin(w, NULL);
+    json_string(w, "state", state_to_string(state));
+    json_uint(w, "sent", sent);
+    json_uint(w, "total", total);
+    json_int(w, "progress", progress);
+    json_uint(w, "queued", buffer.queued);
+    json_uint(w, "free", buffer.free);
+    json_object_end(w);
+    return api_json_end(&resp);
 }
 
 /* POST /api/text/abort - Abort transmission */
@@ -134,6 +144,26 @@ esp_err_t api_text_resume_handler(httpd_req_t *req) {
     return httpd_resp_send(req, "{\"success\":true}", HTTPD_RESP_USE_STRLEN);
 }
 
+/* POST /api/text/cancel - Take back queued text ({"message":true} for the whole send) */
+esp_err_t api_text_cancel_handler(httpd_req_t *req) {
+    bool whole_message = false;
+    char buf[64];
+    if (req->content_len > 0) {
+        json_tok_t toks[BODY_TOKENS];
+        if (scan_post_body(req, buf, sizeof(buf), toks) < 0) {
+            return ESP_FAIL;
+        }
+        whole_message = json_scan_is_true(toks, json_scan_get(buf, toks, 0, "message"));
+    }
+
+    size_t removed = text_keyer_cancel_last(whole_message);
+
+    char resp[48];
+    snprintf(resp, sizeof(resp), "{\"success\":true,\"removed\":%u}", (unsigned)removed);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+}
+
 /* GET /api/text/memory - List all memory slots */
 esp_err_t api_text_memory_list_handler(httpd_req_t *req) {
     cJSON *root = cJSON_CreateObject();
@@ -188,43 +218,37 @@ esp_err_t api_text_memory_list_handler(httpd_req_t *req) {
 /* POST /api/text/memory - Set memory slot */
 esp_err_t api_text_memory_set_handler(httpd_req_t *req) {
     char buf[256];
-    if (read_post_body(req, buf, sizeof(buf)) < 0) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid body");
+    json_tok_t toks[BODY_TOKENS];
+    if (scan_post_body(req, buf, sizeof(buf), toks) < 0) {
         return ESP_FAIL;
     }
 
-    cJSON *json = cJSON_Parse(buf);
-    if (json == NULL) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
-        return ESP_FAIL;
-    }
-
-    cJSON *slot_obj = cJSON_GetObjectItem(json, "slot");
-    cJSON *text_obj = cJSON_GetObjectItem(json, "text");
-    cJSON *label_obj = cJSON_GetObjectItem(json, "label");
-
-    if (!cJSON_IsNumber(slot_obj)) {
-        cJSON_Delete(json);
+    int slot;
+    int slot_idx = json_scan_get(buf, toks, 0, "slot");
+    if (slot_idx < 0 || !json_scan_int(buf, &toks[slot_idx], &slot)) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing 'slot' field");
         return ESP_FAIL;
     }
 
-    int slot = slot_obj->valueint;
     if (slot < 0 || slot >= TEXT_MEMORY_SLOTS) {
-        cJSON_Delete(json);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid slot number");
         return ESP_FAIL;
     }
 
-    const char *text = cJSON_IsString(text_obj) ? text_obj->valuestring : NULL;
-    const char *label = cJSON_IsString(label_obj) ? label_obj->valuestring : NULL;
-
+    /* Absent or non-string fields are left unchanged (NULL); text_memory truncates */
+    char text_buf[sizeof(buf)];
+    char label_buf[sizeof(buf)];
+    int text_idx = json_scan_get(buf, toks, 0, "text");
+    int label_idx = json_scan_get(buf, toks, 0, "label");
+    const char *text = (text_idx >= 0 &&
+                        json_scan_string(buf, &toks[text_idx], text_buf, sizeof(text_buf)))
+                       ? text_buf : NULL;
+    const char *label = (label_idx >= 0 &&
+                         json_scan_string(buf, &toks[label_idx], label_buf, sizeof(label_buf)))
+                        ? label_buf : NULL;
+
+    /* Written to NVS by the persistence worker once the keyer is idle */
     int ret = text_memory_set((uint8_t)slot, text, label);
-    if (ret == 0) {
-        text_memory_save();
-    }
-    cJSON_Delete(json);
-
     if (ret != 0) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set slot");
         return ESP_FAIL;
@@ -238,27 +262,18 @@ esp_err_t api_text_memory_set_handler(httpd_req_t *req) {
 /* POST /api/text/play - Play memory slot */
 esp_err_t api_text_play_handler(httpd_req_t *req) {
     char buf[64];
-    if (read_post_body(req, buf, sizeof(buf)) < 0) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid body");
+    json_tok_t toks[BODY_TOKENS];
+    if (scan_post_body(req, buf, sizeof(buf), toks) < 0) {
         return ESP_FAIL;
     }
 
-    cJSON *json = cJSON_Parse(buf);
-    if (json == NULL) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
-        return ESP_FAIL;
-    }
-
-    cJSON *slot_obj = cJSON_GetObjectItem(json, "slot");
-    if (!cJSON_IsNumber(slot_obj)) {
-        cJSON_Delete(json);
+    int slot;
+    int slot_idx = json_scan_get(buf, toks, 0, "slot");
+    if (slot_idx < 0 || !json_scan_int(buf, &toks[slot_idx], &slot)) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing 'slot' field");
         return ESP_FAIL;
     }
 
-    int slot = slot_obj->valueint;
-    cJSON_Delete(json);
-
     if (slot < 0 || slot >= TEXT_MEMORY_SLOTS) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid slot number");
         return ESP_FAIL;
@@ -270,9 +285,9 @@ esp_err_t api_text_play_handler(httpd_req_t *req) {
         return ESP_FAIL;
     }
 
-    int ret = text_keyer_send(slot_data.text);
+    int ret = text_keyer_send_memory((uint8_t)slot);
     if (ret != 0) {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Keyer busy");
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Type-ahead full");
         return ESP_FAIL;
     }
 
@@ -0,0 +1,425 @@
+/**
+ * @file api_ota.c
+ * @brief POST /api/ota - streamed firmware update
+ *
+ * The body is the raw app image (build/keyer_c.bin). It is never held in
+ * RAM: a writer task reads it in OTA_CHUNK pieces, hashes each piece and
+ * writes it to the next OTA partition (erased sector by sector as the
+ * write reaches it, not all at once up front). Progress goes to the
+ * WebSocket clients as {"type":"ota",...} messages.
+ *
+ * The request is handed to the writer with httpd_req_async_handler_begin()
+ * so the HTTP server task stays free to deliver those messages. The writer
+ * runs on Core 1 at the lowest service priority, like the NVS persistence
+ * worker: it never competes with the RT task, the network stack or the
+ * HTTP server for CPU, and it writes flash only between elements (keyer
+ * idle) unless the operator keeps keying for OTA_IDLE_WAIT_MS. Flash
+ * writes still stall the other core unless CONFIG_KEYER_RT_IRAM (with
+ * flash auto-suspend) is set.
+ *
+ * POST /api/ota/delta takes a patch from tools/ota_delta/mkdelta.py
+ * instead (format in ota_delta.h). The patch header names the image it
+ * applies to; the running partition is hashed and must match. The body
+ * is inflated through a 32 KB window and the op decoder rebuilds the new
+ * image from the running partition and the patch data, into the same
+ * write path. Window and decoder live in PSRAM for the upload only.
+ *
+ * An optional X-OTA-SHA256 header (64 hex digits) is compared with the
+ * digest of the new image (for a patch, in addition to its own digest in
+ * the header); esp_ota_end() then checks the image's appended hash. On
+ * success the new partition boots next; it must pass the self-test in main/ota_check.c or the bootloader rolls back.
+ */
+
+#include "esp_http_server.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/sha256.h"
+#include "miniz.h"
+#include "config_persist.h"
+#include "text_keyer.h"
+#include "ota_update.h"
+#include "ota_delta.h"
+#include "ws_server.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Paddle state (main/rt_task.c) */
+extern atomic_bool g_paddle_active;
+
+static const char *TAG = "api_ota";
+
+/** Bytes read and written per step */
+#define OTA_CHUNK 4096U
+
+/** Longest a chunk waits for the keyer to go idle before it is written anyway */
+#define OTA_IDLE_WAIT_MS 2000
+
+/** Consecutive receive timeouts before the upload is abandoned */
+#define OTA_RECV_RETRIES 5
+
+typedef struct {
+    httpd_req_t *req;                 /**< Async copy, owned by the writer */
+    uint8_t expected[OTA_SHA256_LEN];
+    bool check_sha;
+    bool delta;                       /**< Body is an ota_delta.h patch */
+} ota_job_t;
+
+/**
+ * @brief Output side: everything written to the new image goes through here
+ */
+typedef struct {
+    esp_ota_handle_t handle;
+    mbedtls_sha256_context sha;       /**< Digest of the new image */
+    const esp_partition_t *running;   /**< Delta base */
+    uint32_t capacity;                /**< Target partition size */
+    uint32_t written;
+} ota_sink_t;
+
+/**
+ * @brief Delta decoding state, in PSRAM for the duration of one upload
+ */
+typedef struct {
+    tinfl_decompressor inflate;
+    uint8_t window[TINFL_LZ_DICT_SIZE];   /**< Inflate output ring */
+    size_t window_pos;
+    ota_delta_t dec;
+    uint8_t header[OTA_DELTA_HEADER_SIZE];
+    size_t header_len;
+    bool started;                         /**< Header checked, ops flowing */
+    ota_delta_status_t status;
+} ota_delta_job_t;
+
+static atomic_bool s_busy;
+static ota_job_t s_job;
+static uint8_t s_chunk[OTA_CHUNK];   /* One upload at a time (s_busy) */
+
+static bool keyer_idle(void) {
+    return !atomic_load_explicit(&g_paddle_active, memory_order_acquire) &&
+           text_keyer_get_state() == TEXT_KEYER_IDLE;
+}
+
+static void wait_keyer_idle(void) {
+    for (int waited = 0; waited < OTA_IDLE_WAIT_MS && !keyer_idle(); waited += 10) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void broadcast_state(const char *state, uint32_t written, uint32_t total,
+                            uint32_t pct, const char *error) {
+    char json[160];
+    if (error != NULL) {
+        snprintf(json, sizeof(json),
+                 "{\"type\":\"ota\",\"state\":\"%s\",\"written\":%lu,\"total\":%lu,"
+                 "\"pct\":%lu,\"error\":\"%s\"}",
+                 state, (unsigned long)written, (unsigned long)total,
+                 (unsigned long)pct, error);
+    } else {
+        snprintf(json, sizeof(json),
+                 "{\"type\":\"ota\",\"state\":\"%s\",\"written\":%lu,\"total\":%lu,\"pct\":%lu}",
+                 state, (unsigned long)written, (unsigned long)total, (unsigned long)pct);
+    }
+    ws_broadcast(WS_TOPIC_STATUS, json);
+}
+
+static bool sink_write(void *ctx, const uint8_t *buf, size_t len) {
+    ota_sink_t *sink = (ota_sink_t *)ctx;
+    (void)mbedtls_sha256_update(&sink->sha, buf, len);
+    wait_keyer_idle();
+    esp_err_t err = esp_ota_write(sink->handle, buf, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_write: %s", esp_err_to_name(err));
+        return false;
+    }
+    sink->written += (uint32_t)len;
+    return true;
+}
+
+static bool base_read(void *ctx, uint32_t off, uint8_t *buf, size_t len) {
+    ota_sink_t *sink = (ota_sink_t *)ctx;
+    return esp_partition_read(sink->running, off, buf, len) == ESP_OK;
+}
+
+/**
+ * @brief Check the running image is the one the patch was made against
+ *
+ * Hashes the first old_size bytes of the running partition, using the
+ * (still unused) inflate window as the read buffer.
+ */
+static const char *delta_check_base(ota_delta_job_t *dj, ota_sink_t *sink) {
+    ota_delta_header_t hdr;
+    if (!ota_delta_parse_header(dj->header, &hdr)) {
+        return "not a delta patch";
+    }
+    if (hdr.old_size > sink->running->size) {
+        return "patch base larger than running partition";
+    }
+    if (hdr.new_size > sink->capacity) {
+        return "patched image larger than partition";
+    }
+
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    (void)mbedtls_sha256_starts(&sha, 0);
+    bool read_ok = true;
+    for (uint32_t off = 0; off < hdr.old_size && read_ok; off += (uint32_t)sizeof(dj->window)) {
+        size_t n = hdr.old_size - off;
+        if (n > sizeof(dj->window)) {
+            n = sizeof(dj->window);
+        }
+        read_ok = base_read(sink, off, dj->window, n);
+        (void)mbedtls_sha256_update(&sha, dj->window, n);
+    }
+    uint8_t digest[OTA_SHA256_LEN];
+    (void)mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    if (!read_ok) {
+        return "cannot read running image";
+    }
+    if (memcmp(digest, hdr.old_sha, sizeof(digest)) != 0) {
+        return "patch is for a different firmware";
+    }
+
+    ota_delta_init(&dj->dec, &hdr, base_read, sink_write, sink);
+    tinfl_init(&dj->inflate);
+    dj->window_pos = 0;
+    dj->started = true;
+    return NULL;
+}
+
+/**
+ * @brief Feed received patch bytes: header first, then inflate into the op decoder
+ */
+static const char *delta_consume(ota_delta_job_t *dj, ota_sink_t *sink,
+                                 const uint8_t *data, size_t len, bool last) {
+    if (!dj->started) {
+        size_t take = OTA_DELTA_HEADER_SIZE - dj->header_len;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(dj->header + dj->header_len, data, take);
+        dj->header_len += take;
+        data += take;
+        len -= take;
+        if (dj->header_len < OTA_DELTA_HEADER_SIZE) {
+            return last ? "truncated patch" : NULL;
+        }
+        const char *error = delta_check_base(dj, sink);
+        if (error != NULL) {
+            return error;
+        }
+    }
+
+    for (;;) {
+        size_t in_bytes = len;
+        size_t out_bytes = sizeof(dj->window) - dj->window_pos;
+        mz_uint32 flags = TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32 |
+                          (last ? 0 : TINFL_FLAG_HAS_MORE_INPUT);
+        tinfl_status st = tinfl_decompress(&dj->inflate, data, &in_bytes, dj->window,
+                                           dj->window + dj->window_pos, &out_bytes, flags);
+        data += in_bytes;
+        len -= in_bytes;
+
+        if (out_bytes > 0) {
+            dj->status = ota_delta_feed(&dj->dec, dj->window + dj->window_pos, out_bytes);
+            dj->window_pos = (dj->window_pos + out_bytes) & (sizeof(dj->window) - 1);
+            if (dj->status == OTA_DELTA_ERROR) {
+                return "bad patch data";
+            }
+        }
+        if (st < TINFL_STATUS_DONE) {
+            return "patch decompression failed";
+        }
+        if (st == TINFL_STATUS_DONE) {
+            return (dj->status == OTA_DELTA_DONE && len == 0) ? NULL : "bad patch data";
+        }
+        if (st == TINFL_STATUS_NEEDS_MORE_INPUT && len == 0) {
+            return last ? "truncated patch" : NULL;
+        }
+        /* HAS_MORE_OUTPUT, or input left: go round */
+    }
+}
+
+/**
+ * @brief Receive the whole body and write the new image
+ *
+ * @return NULL on success, otherwise a short reason for the client
+ */
+static const char *ota_stream(httpd_req_t *req, const ota_job_t *job) {
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+    if (part == NULL) {
+        return "no OTA partition";
+    }
+    uint32_t total = (uint32_t)req->content_len;
+    if (total > part->size) {
+        return "upload larger than partition";
+    }
+
+    ota_delta_job_t *dj = NULL;
+    if (job->delta) {
+        dj = heap_caps_calloc(1, sizeof(*dj), MALLOC_CAP_SPIRAM);
+        if (dj == NULL) {
+            dj = heap_caps_calloc(1, sizeof(*dj), MALLOC_CAP_DEFAULT);
+        }
+        if (dj == NULL) {
+            return "no memory for delta";
+        }
+    }
+
+    ota_sink_t sink = {
+        .running = esp_ota_get_running_partition(),
+        .capacity = (uint32_t)part->size,
+    };
+    esp_err_t err = esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &sink.handle);
+    if (err != ESP_OK) {
+        heap_caps_free(dj);
+        return "esp_ota_begin failed";
+    }
+    mbedtls_sha256_init(&sink.sha);
+    (void)mbedtls_sha256_starts(&sink.sha, 0);
+
+    ota_progress_t progress;
+    ota_progress_init(&progress, total);
+    uint32_t received = 0;
+    uint32_t pct = 0;
+    int timeouts = 0;
+    const char *error = NULL;
+    int64_t t0 = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "Receiving %lu byte %s for %s", (unsigned long)total,
+             job->delta ? "patch" : "image", part->label);
+    broadcast_state("writing", 0, total, 0, NULL);
+
+    while (received < total && error == NULL) {
+        size_t want = total - received;
+        int n = httpd_req_recv(req, (char *)s_chunk, want < OTA_CHUNK ? want : OTA_CHUNK);
+        if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < OTA_RECV_RETRIES) {
+            continue;
+        }
+        if (n <= 0) {
+            error = "upload interrupted";
+            break;
+        }
+        timeouts = 0;
+        received += (uint32_t)n;
+
+        if (dj != NULL) {
+            error = delta_consume(dj, &sink, s_chunk, (size_t)n, received == total);
+        } else if (!sink_write(&sink, s_chunk, (size_t)n)) {
+            error = "flash write failed";
+        }
+
+        if (ota_progress_step(&progress, received, esp_timer_get_time(), &pct)) {
+            broadcast_state("writing", received, total, pct, NULL);
+        }
+    }
+
+    uint8_t digest[OTA_SHA256_LEN];
+    (void)mbedtls_sha256_finish(&sink.sha, digest);
+    mbedtls_sha256_free(&sink.sha);
+
+    if (error == NULL && dj != NULL) {
+        if (dj->status != OTA_DELTA_DONE) {
+            error = "truncated patch";
+        } else if (memcmp(digest, dj->dec.hdr.new_sha, sizeof(digest)) != 0) {
+            error = "patched image SHA-256 mismatch";
+        }
+    }
+    heap_caps_free(dj);
+    if (error == NULL && job->check_sha && memcmp(digest, job->expected, sizeof(digest)) != 0) {
+        error = "SHA-256 mismatch";
+    }
+    if (error != NULL) {
+        esp_ota_abort(sink.handle);
+        return error;
+    }
+
+    err = esp_ota_end(sink.handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_end: %s", esp_err_to_name(err));
+        return (err == ESP_ERR_OTA_VALIDATE_FAILED) ? "image validation failed" : "esp_ota_end failed";
+    }
+    err = esp_ota_set_boot_partition(part);
+    if (err != ESP_OK) {
+        return "cannot select boot partition";
+    }
+    ESP_LOGI(TAG, "%lu byte image written in %lld ms, booting %s next",
+             (unsigned long)sink.written,
+             (long long)((esp_timer_get_time() - t0) / 1000), part->label);
+    return NULL;
+}
+
+static void ota_task(void *arg) {
+    ota_job_t *job = (ota_job_t *)arg;
+    httpd_req_t *req = job->req;
+    uint32_t total = (uint32_t)req->content_len;
+
+    const char *error = ota_stream(req, job);
+
+    httpd_resp_set_type(req, "application/json");
+    if (error != NULL) {
+        ESP_LOGE(TAG, "Update failed: %s", error);
+        broadcast_state("error", 0, total, 0, error);
+        char body[96];
+        snprintf(body, sizeof(body), "{\"success\":false,\"error\":\"%s\"}", error);
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        httpd_resp_set_hdr(req, "Connection", "close");   /* Rest of the body is unread */
+        httpd_resp_sendstr(req, body);
+        httpd_req_async_handler_complete(req);
+        atomic_store_explicit(&s_busy, false, memory_order_release);
+        vTaskDelete(NULL);
+    }
+
+    broadcast_state("rebooting", total, total, 100, NULL);
+    httpd_resp_sendstr(req, "{\"success\":true,\"rebooting\":true}");
+    httpd_req_async_handler_complete(req);
+
+    config_persist_flush();
+    vTaskDelay(pdMS_TO_TICKS(1000));   /* Let the response and last WS message out */
+    esp_restart();
+}
+
+/* POST /api/ota (full image) and /api/ota/delta (user_ctx non-NULL: patch) */
+esp_err_t api_ota_handler(httpd_req_t *req) {
+    if (req->content_len == 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Empty body");
+        return ESP_OK;
+    }
+    if (atomic_exchange_explicit(&s_busy, true, memory_order_acq_rel)) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"update in progress\"}");
+        return ESP_OK;
+    }
+
+    char hex[2 * OTA_SHA256_LEN + 2];
+    s_job.delta = (req->user_ctx != NULL);
+    s_job.check_sha = false;
+    if (httpd_req_get_hdr_value_str(req, "X-OTA-SHA256", hex, sizeof(hex)) == ESP_OK) {
+        if (!ota_parse_sha256(hex, s_job.expected)) {
+            atomic_store_explicit(&s_busy, false, memory_order_release);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad X-OTA-SHA256");
+            return ESP_OK;
+        }
+        s_job.check_sha = true;
+    }
+
+    if (httpd_req_async_handler_begin(req, &s_job.req) != ESP_OK) {
+        atomic_store_explicit(&s_busy, false, memory_order_release);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Busy");
+        return ESP_OK;
+    }
+
+    /* Core 1, lowest BG priority: see the file comment */
+    if (xTaskCreatePinnedToCore(ota_task, "ota", 4096, &s_job,
+                                tskIDLE_PRIORITY + 1, NULL, 1) != pdPASS) {
+        httpd_resp_send_err(s_job.req, HTTPD_500_INTERNAL_SERVER_ERROR, "No memory");
+        httpd_req_async_handler_complete(s_job.req);
+        atomic_store_explicit(&s_busy, false, memory_order_release);
+    }
+    return ESP_OK;
+}
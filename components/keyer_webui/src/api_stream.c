@@ -0,0 +1,134 @@
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "stream.h"
+#include "stream_export.h"
+#include "recorder.h"
+#include "api_json.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "api_stream";
+
+/* Keying stream (main/main.c) */
+extern keying_stream_t g_keying_stream;
+
+/* Records per HTTP chunk */
+#define EXPORT_CHUNK_BYTES (256 * sizeof(stream_sample_t))
+
+/* GET /api/stream/export?session=N - .cwk recording of a recorder session */
+static esp_err_t export_session(httpd_req_t *req, uint32_t session) {
+    recorder_export_t exp;
+    if (!recorder_export_begin(&exp, session)) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No such session");
+        return ESP_OK;
+    }
+
+    char size[16];
+    char disposition[64];
+    snprintf(size, sizeof(size), "%u", (unsigned)stream_rec_export_size(&exp));
+    snprintf(disposition, sizeof(disposition), "attachment; filename=\"session-%lu.cwk\"",
+             (unsigned long)session);
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+    httpd_resp_set_hdr(req, "X-CWK-Bytes", size);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Read from flash one chunk at a time, under the recorder lock */
+    uint8_t chunk[EXPORT_CHUNK_BYTES];
+    size_t n;
+    while ((n = recorder_export_read(&exp, chunk, sizeof(chunk))) > 0) {
+        if (httpd_resp_send_chunk(req, (const char *)chunk, (ssize_t)n) != ESP_OK) {
+            ESP_LOGW(TAG, "Export aborted by client");
+            return ESP_FAIL;
+        }
+    }
+    if (exp.lost) {
+        ESP_LOGW(TAG, "Session %lu overwritten while exporting, recording truncated",
+                 (unsigned long)session);
+    }
+    if (exp.corrupt > 0) {
+        ESP_LOGW(TAG, "Session %lu: %lu chunks failed their CRC", (unsigned long)session,
+                 (unsigned long)exp.corrupt);
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/* GET /api/stream/export[?seconds=N | ?session=N] - .cwk recording of recent
+ * history, or of a session from the flash recorder */
+esp_err_t api_stream_export_handler(httpd_req_t *req) {
+    uint64_t window_ticks = 0;
+    char query[32] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char param[12];
+        if (httpd_query_key_value(query, "session", param, sizeof(param)) == ESP_OK) {
+            return export_session(req, (uint32_t)strtoul(param, NULL, 10));
+        }
+        if (httpd_query_key_value(query, "seconds", param, sizeof(param)) == ESP_OK) {
+            uint32_t tick_us = stream_tick_period_us(&g_keying_stream);
+            window_ticks = strtoull(param, NULL, 10) * 1000000ULL / (tick_us ? tick_us : 1000U);
+        }
+    }
+
+    stream_export_t exp;
+    stream_export_begin(&exp, &g_keying_stream, window_ticks, (uint64_t)esp_timer_get_time());
+
+    char size[16];
+    snprintf(size, sizeof(size), "%u", (unsigned)stream_export_size(&exp));
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"keying.cwk\"");
+    httpd_resp_set_hdr(req, "X-CWK-Bytes", size);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    /* Encoded straight from the stream tiers, one chunk at a time */
+    uint8_t chunk[EXPORT_CHUNK_BYTES];
+    size_t n;
+    while ((n = stream_export_read(&exp, chunk, sizeof(chunk))) > 0) {
+        if (httpd_resp_send_chunk(req, (const char *)chunk, (ssize_t)n) != ESP_OK) {
+            ESP_LOGW(TAG, "Export aborted by client");
+            return ESP_FAIL;
+        }
+    }
+    if (exp.lost) {
+        ESP_LOGW(TAG, "Export lapped by the producer, recording truncated");
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/* GET /api/stream/sessions - recorder status and its sessions, oldest first */
+esp_err_t api_stream_sessions_handler(httpd_req_t *req) {
+    static stream_rec_session_t sessions[STREAM_REC_MAX_SESSIONS];
+    recorder_stats_t st;
+    recorder_get_stats(&st);
+    size_t n = recorder_get_sessions(sessions, STREAM_REC_MAX_SESSIONS);
+
+    api_json_t resp;
+    api_json_begin(&resp, req);
+    json_writer_t *w = api_json_writer(&resp);
+    json_object_begin(w, NULL);
+    json_bool(w, "mounted", st.mounted);
+    json_bool(w, "recording", st.recording);
+    json_uint(w, "session", st.session);
+    json_uint(w, "chunks", st.chunks);
+    json_uint(w, "used", st.used);
+    json_uint(w, "chunk_bytes", STREAM_REC_CHUNK_BYTES);
+    json_uint(w, "dropped", st.chunks_dropped);
+    json_array_begin(w, "sessions");
+    for (size_t i = 0; i < n; i++) {
+        const stream_rec_session_t *s = &sessions[i];
+        json_object_begin(w, NULL);
+        json_uint(w, "id", s->id);
+        json_uint(w, "chunks", s->chunks);
+        json_uint(w, "first_tick", s->first_tick);
+        json_uint(w, "duration_ms", (s->end_tick - s->first_tick) * s->tick_us / 1000U);
+        if (s->unix_us != 0) {
+            json_int(w, "start_unix", s->unix_us / 1000000);
+        } else {
+            json_null(w, "start_unix");
+        }
+        json_object_end(w);
+    }
+    json_array_end(w);
+    json_object_end(w);
+    return api_json_end(&resp);
+}
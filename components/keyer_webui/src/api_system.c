@@ -3,32 +3,41 @@
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "cJSON.h"
 #include "wifi.h"
+#include "vpn.h"
 #include "cwnet_socket.h"
+#include "rt_prof.h"
+#include "key_latency.h"
+#include "flight_rec.h"
+#include "fault.h"
+#include "ws_server.h"
+#include "http_async.h"
+#include "config.h"
+#include "config_persist.h"
+#include "stream.h"
+#include "task_stats.h"
+#include "metrics.h"
+#include "metrics_history.h"
+#include "api_json.h"
+#include <stdlib.h>
+#include <string.h>
 
-static const char *TAG = "api_system";
+extern keying_stream_t g_keying_stream;
+extern fault_state_t g_fault_state;
+extern fault_log_t g_fault_log;
 
-static const char *wifi_state_to_string(wifi_state_t state) {
-    switch (state) {
-        case WIFI_STATE_DISABLED:   return "DISABLED";
-        case WIFI_STATE_CONNECTING: return "CONNECTING";
-        case WIFI_STATE_CONNECTED:  return "CONNECTED";
-        case WIFI_STATE_FAILED:     return "FAILED";
-        case WIFI_STATE_AP_MODE:    return "AP_MODE";
-        default:                    return "UNKNOWN";
-    }
-}
+static const char *TAG = "api_system";
 
 /* GET /api/status */
 esp_err_t api_status_handler(httpd_req_t *req) {
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON alloc failed");
-        return ESP_FAIL;
-    }
+    api_json_t resp;
+    api_json_begin(&resp, req);
+    json_writer_t *w = api_json_writer(&resp);
+    json_object_begin(w, NULL);
 
     /* Get WiFi state */
     wifi_state_t state = wifi_get_state();
@@ -37,16 +46,281 @@ esp_err_t api_status_handler(httpd_req_t *req) {
 
     bool ready = (state == WIFI_STATE_CONNECTED || state == WIFI_STATE_AP_MODE);
 
-    cJSON_AddStringToObject(root, "mode", wifi_state_to_string(state));
-    cJSON_AddStringToObject(root, "ip", ip_buf);
-    cJSON_AddBoolToObject(root, "ready", ready);
+    json_string(w, "mode", wifi_state_str(state));
+    json_string(w, "ip", ip_buf);
+    json_bool(w, "ready", ready);
+
+    /* WiFi power save, with the CWNet RTT jitter seen in each mode */
+    wifi_ps_status_t ps;
+    wifi_get_power_save(&ps);
+    json_object_begin(w, "power_save");
+    json_string(w, "mode", ps.saving ? "modem" : "off");
+    json_string(w, "policy", wifi_ps_policy_str((wifi_ps_policy_t)CONFIG_GET_POWER_SAVE()));
+    json_uint(w, "switches", ps.switches);
+    json_int(w, "jitter_awake_ms", ps.jitter_awake_ms);
+    json_int(w, "jitter_saving_ms", ps.jitter_saving_ms);
+    json_object_end(w);
 
     /* CWNet status */
-    cJSON *cwnet = cJSON_CreateObject();
-    cwnet_socket_state_t cwnet_state = cwnet_socket_get_state();
-    cJSON_AddStringToObject(cwnet, "state", cwnet_socket_state_str(cwnet_state));
-    cJSON_AddNumberToObject(cwnet, "latency_ms", cwnet_socket_get_latency_ms());
-    cJSON_AddItemToObject(root, "cwnet", cwnet);
+    json_object_begin(w, "cwnet");
+    json_string(w, "state", cwnet_socket_state_str(cwnet_socket_get_state()));
+    json_int(w, "latency_ms", cwnet_socket_get_latency_ms());
+    cwnet_sync_stats_t sync;
+    cwnet_socket_get_sync_stats(&sync);
+    json_int(w, "rtt_min_ms", sync.rtt_min_ms);
+    json_int(w, "rtt_jitter_ms", sync.rtt_jitter_ms);
+    json_int(w, "clock_offset_ms", sync.offset_ms);
+    json_int(w, "clock_drift_ppm", sync.drift_ppm);
+    json_array_begin(w, "servers");
+    for (size_t i = 0; i < cwnet_socket_session_count(); i++) {
+        cwnet_session_info_t si;
+        if (!cwnet_socket_get_session(i, &si)) {
+            continue;
+        }
+        json_object_begin(w, NULL);
+        json_string(w, "host", si.host);
+        json_int(w, "port", si.port);
+        json_int(w, "priority", si.priority);
+        json_string(w, "state", cwnet_socket_state_str(si.state));
+        json_int(w, "latency_ms", si.latency_ms);
+        json_bool(w, "udp", si.udp);
+        json_bool(w, "heard", si.rx_owner);
+        json_bool(w, "standby", si.standby);
+        json_uint(w, "edges", si.edge_latency.count);
+        json_object_end(w);
+    }
+    json_array_end(w);
+    json_uint(w, "failovers", cwnet_socket_get_failovers());
+    json_object_end(w);
+
+    json_object_begin(w, "vpn");
+    json_string(w, "state", vpn_state_str(vpn_get_state()));
+    json_object_end(w);
+
+    json_object_begin(w, "fault");
+    json_bool(w, "active", fault_is_active(&g_fault_state));
+    json_string(w, "code", fault_code_str(fault_get_code(&g_fault_state)));
+    json_object_end(w);
+
+    /* WebSocket send queues */
+    ws_client_stats_t ws_stats[WS_MAX_CLIENTS];
+    int ws_count = ws_get_client_stats(ws_stats, WS_MAX_CLIENTS);
+    json_array_begin(w, "ws_clients");
+    for (int i = 0; i < ws_count; i++) {
+        json_object_begin(w, NULL);
+        json_int(w, "fd", ws_stats[i].fd);
+        json_uint(w, "queued", ws_stats[i].queued);
+        json_uint(w, "sent", ws_stats[i].sent);
+        json_uint(w, "dropped_timeline", ws_stats[i].dropped_timeline);
+        json_uint(w, "dropped_text", ws_stats[i].dropped_text);
+        json_uint(w, "coalesced", ws_stats[i].coalesced);
+        json_object_end(w);
+    }
+    json_array_end(w);
+
+    /* API endpoints: request latency, and how slow ones were scheduled */
+    json_object_begin(w, "http");
+    json_int(w, "workers", http_async_worker_count());
+    json_array_begin(w, "endpoints");
+    for (size_t i = 0; i < http_endpoint_count(); i++) {
+        const http_endpoint_t *ep = http_endpoint_at(i);
+        const http_endpoint_stats_t *st = &ep->stats;
+        json_object_begin(w, NULL);
+        json_string(w, "uri", ep->uri.uri);
+        json_string(w, "method", http_method_str(ep->uri.method));
+        json_bool(w, "async", ep->async);
+        json_uint(w, "count", atomic_load_explicit(&st->count, memory_order_relaxed));
+        json_uint(w, "errors", atomic_load_explicit(&st->errors, memory_order_relaxed));
+        json_uint(w, "deferred", atomic_load_explicit(&st->deferred, memory_order_relaxed));
+        json_uint(w, "inline", atomic_load_explicit(&st->inline_runs, memory_order_relaxed));
+        json_uint(w, "rejected", atomic_load_explicit(&st->rejected, memory_order_relaxed));
+        json_uint(w, "avg_us", atomic_load_explicit(&st->avg_us, memory_order_relaxed));
+        json_uint(w, "max_us", atomic_load_explicit(&st->max_us, memory_order_relaxed));
+        json_object_end(w);
+    }
+    json_array_end(w);
+    json_object_end(w);
+
+    /* Deferred NVS persistence */
+    config_persist_stats_t nvs;
+    config_persist_get_stats(&nvs);
+    json_object_begin(w, "nvs");
+    json_bool(w, "pending", nvs.pending);
+    json_bool(w, "dirty", nvs.dirty);
+    json_uint(w, "commits", nvs.saves);
+    json_uint(w, "failures", nvs.failures);
+    json_uint(w, "last_commit_us", nvs.last_commit_us);
+    json_uint(w, "max_commit_us", nvs.max_commit_us);
+    json_object_end(w);
+
+    json_object_end(w);
+    return api_json_end(&resp);
+}
+
+/* GET /api/system/stats */
+esp_err_t api_system_stats_handler(httpd_req_t *req) {
+    /* A handler never runs twice at once (http_async.h): snapshots can be static */
+    static TaskStatus_t task_array[TASK_STATS_MAX_TASKS + 8];
+    static fault_event_t fault_events[FAULT_LOG_SIZE];
+    static stream_consumer_info_t cons[STREAM_REGISTRY_MAX];
+
+    api_json_t resp;
+    api_json_begin(&resp, req);
+    json_writer_t *w = api_json_writer(&resp);
+    json_object_begin(w, NULL);
+
+    /* Uptime */
+    int64_t uptime_sec = esp_timer_get_time() / 1000000;
+    json_object_begin(w, "uptime");
+    json_int(w, "hours", uptime_sec / 3600);
+    json_int(w, "minutes", (uptime_sec % 3600) / 60);
+    json_int(w, "seconds", uptime_sec % 60);
+    json_int(w, "total_seconds", uptime_sec);
+    json_object_end(w);
+
+    /* Heap */
+    multi_heap_info_t heap_info;
+    heap_caps_get_info(&heap_info, MALLOC_CAP_DEFAULT);
+    json_object_begin(w, "heap");
+    json_uint(w, "free_bytes", heap_info.total_free_bytes);
+    json_uint(w, "minimum_free_bytes", heap_info.minimum_free_bytes);
+    json_uint(w, "total_bytes", heap_info.total_free_bytes + heap_info.total_allocated_bytes);
+    json_uint(w, "largest_free_block", heap_info.largest_free_block);
+    json_object_end(w);
+
+    /* Tasks */
+    json_array_begin(w, "tasks");
+    configRUN_TIME_COUNTER_TYPE total_runtime;
+    UBaseType_t task_count = uxTaskGetSystemState(task_array,
+                                                  sizeof(task_array) / sizeof(task_array[0]),
+                                                  &total_runtime);
+    for (UBaseType_t i = 0; i < task_count; i++) {
+        json_object_begin(w, NULL);
+        json_string(w, "name", task_array[i].pcTaskName);
+        const char *state_str;
+        switch (task_array[i].eCurrentState) {
+            case eRunning: state_str = "Running"; break;
+            case eReady: state_str = "Ready"; break;
+            case eBlocked: state_str = "Blocked"; break;
+            case eSuspended: state_str = "Suspended"; break;
+            default: state_str = "Unknown"; break;
+        }
+        json_string(w, "state", state_str);
+        json_uint(w, "priority", task_array[i].uxCurrentPriority);
+        json_uint(w, "stack_hwm", task_array[i].usStackHighWaterMark);
+        json_object_end(w);
+    }
+    json_array_end(w);
+
+    /* Fault state and timeline */
+    json_object_begin(w, "faults");
+    json_bool(w, "active", fault_is_active(&g_fault_state));
+    json_string(w, "code", fault_code_str(fault_get_code(&g_fault_state)));
+    json_uint(w, "count", fault_get_count(&g_fault_state));
+    size_t n_faults = fault_log_snapshot(&g_fault_log, fault_events, FAULT_LOG_SIZE);
+    json_array_begin(w, "events");
+    for (size_t i = 0; i < n_faults; i++) {
+        json_object_begin(w, NULL);
+        json_int(w, "time_us", fault_events[i].time_us);
+        json_string(w, "event", fault_event_str((fault_event_kind_t)fault_events[i].kind));
+        json_string(w, "code", fault_code_str((fault_code_t)fault_events[i].code));
+        json_uint(w, "data", fault_events[i].data);
+        json_object_end(w);
+    }
+    json_array_end(w);
+    json_object_end(w);
+
+#ifdef CONFIG_KEYER_RT_PROFILE
+    /* RT hot path per-stage cycle counts */
+    json_object_begin(w, "rt_profile");
+    json_uint(w, "cpu_mhz", esp_rom_get_cpu_ticks_per_us());
+    json_array_begin(w, "stages");
+    for (int st = 0; st < RT_PROF_STAGE_COUNT; st++) {
+        rt_prof_snapshot_t ps;
+        rt_prof_get(&g_rt_prof, (rt_prof_stage_t)st, &ps);
+        json_object_begin(w, NULL);
+        json_string(w, "name", rt_prof_stage_str((rt_prof_stage_t)st));
+        json_uint(w, "count", ps.count);
+        json_uint(w, "min_cycles", ps.min_cycles);
+        json_uint(w, "mean_cycles", ps.mean_cycles);
+        json_uint(w, "max_cycles", ps.max_cycles);
+        json_array_begin(w, "hist_log2");
+        for (int b = 0; b < RT_PROF_HIST_BINS; b++) {
+            json_uint(w, NULL, ps.hist[b]);
+        }
+        json_array_end(w);
+        json_object_end(w);
+    }
+    json_array_end(w);
+    json_object_end(w);
+#endif
+
+    /* Stream consumers: position, lag and losses */
+    size_t n_cons = stream_registry_snapshot(&g_keying_stream, cons, STREAM_REGISTRY_MAX);
+    json_object_begin(w, "stream");
+    json_uint(w, "write_idx", stream_write_position(&g_keying_stream));
+    json_uint(w, "capacity", stream_capacity(&g_keying_stream));
+    json_array_begin(w, "consumers");
+    for (size_t i = 0; i < n_cons; i++) {
+        json_object_begin(w, NULL);
+        json_string(w, "name", cons[i].name);
+        json_uint(w, "read_idx", cons[i].read_idx);
+        json_uint(w, "lag", cons[i].lag);
+        json_uint(w, "max_lag", cons[i].max_lag);
+        json_uint(w, "dropped", cons[i].dropped);
+        json_uint(w, "overruns", cons[i].overruns);
+        json_array_begin(w, "lag_hist_log2");
+        for (size_t b = 0; b < STREAM_LAG_HIST_BINS; b++) {
+            json_uint(w, NULL, cons[i].hist[b]);
+        }
+        json_array_end(w);
+        json_object_end(w);
+    }
+    json_array_end(w);
+    json_object_end(w);
+
+    json_object_end(w);
+    return api_json_end(&resp);
+}
+
+/* GET /api/system/flightrec - faults, key edges and stage peaks across resets */
+esp_err_t api_system_flightrec_handler(httpd_req_t *req) {
+    static flight_rec_event_t events[FLIGHT_REC_MAX_EVENTS];
+    size_t n = flight_rec_snapshot(&g_flight_rec, events, FLIGHT_REC_MAX_EVENTS);
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON alloc failed");
+        return ESP_FAIL;
+    }
+    cJSON_AddNumberToObject(root, "boot", (double)g_flight_rec.boot_count);
+
+    cJSON *list = cJSON_CreateArray();
+    for (size_t i = 0; i < n; i++) {
+        const flight_rec_event_t *ev = &events[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "boot", ev->boot);
+        cJSON_AddNumberToObject(item, "time_us", (double)ev->time_us);
+        cJSON_AddStringToObject(item, "type", flight_rec_type_str(ev->type));
+        cJSON_AddNumberToObject(item, "code", ev->code);
+        cJSON_AddNumberToObject(item, "value", (double)ev->value);
+        switch (ev->type) {
+            case FLIGHT_EV_BOOT:
+                cJSON_AddStringToObject(item, "reset", flight_rec_reset_str(ev->code));
+                break;
+            case FLIGHT_EV_FAULT:
+                cJSON_AddStringToObject(item, "fault", fault_code_str((fault_code_t)ev->code));
+                break;
+            case FLIGHT_EV_STAGE:
+                cJSON_AddStringToObject(item, "stage",
+                                        rt_prof_stage_str((rt_prof_stage_t)ev->code));
+                break;
+            default:
+                break;
+        }
+        cJSON_AddItemToArray(list, item);
+    }
+    cJSON_AddItemToObject(root, "events", list);
 
     char *json_str = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
@@ -62,61 +336,79 @@ esp_err_t api_status_handler(httpd_req_t *req) {
     return ret;
 }
 
-/* GET /api/system/stats */
-esp_err_t api_system_stats_handler(httpd_req_t *req) {
+/** Samples returned per /api/system/tasks response */
+#define TASKS_CHUNK_SAMPLES 60
+
+/* GET /api/system/tasks[?since=SEQ] - per-task CPU and stack history (1 s samples) */
+esp_err_t api_system_tasks_handler(httpd_req_t *req) {
+    static task_stats_task_t tasks[TASK_STATS_MAX_TASKS];
+    static task_stats_sample_t samples[TASKS_CHUNK_SAMPLES];
+
+    uint32_t since = 0;
+    char query[32] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char param[12];
+        if (httpd_query_key_value(query, "since", param, sizeof(param)) == ESP_OK) {
+            since = (uint32_t)strtoul(param, NULL, 10);
+        }
+    }
+
+    size_t n_tasks = task_stats_tasks(&g_task_stats, tasks, TASK_STATS_MAX_TASKS);
+    uint32_t head = task_stats_head(&g_task_stats);
+    size_t n = task_stats_read(&g_task_stats, since, samples, TASKS_CHUNK_SAMPLES);
+
     cJSON *root = cJSON_CreateObject();
     if (root == NULL) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON alloc failed");
         return ESP_FAIL;
     }
+    cJSON_AddNumberToObject(root, "head", head);
+    cJSON_AddNumberToObject(root, "first", n > 0 ? samples[0].seq : head);
+    cJSON_AddNumberToObject(root, "next", n > 0 ? samples[n - 1].seq + 1U : head);
 
-    /* Uptime */
-    int64_t uptime_us = esp_timer_get_time();
-    int64_t uptime_sec = uptime_us / 1000000;
-    cJSON *uptime = cJSON_CreateObject();
-    cJSON_AddNumberToObject(uptime, "hours", (int)(uptime_sec / 3600));
-    cJSON_AddNumberToObject(uptime, "minutes", (int)((uptime_sec % 3600) / 60));
-    cJSON_AddNumberToObject(uptime, "seconds", (int)(uptime_sec % 60));
-    cJSON_AddNumberToObject(uptime, "total_seconds", (int)uptime_sec);
-    cJSON_AddItemToObject(root, "uptime", uptime);
+    cJSON *list = cJSON_CreateArray();
+    for (size_t i = 0; i < n_tasks; i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", tasks[i].name);
+        if (tasks[i].core == TASK_STATS_CORE_ANY) {
+            cJSON_AddNullToObject(item, "core");
+        } else {
+            cJSON_AddNumberToObject(item, "core", tasks[i].core);
+        }
+        cJSON_AddItemToArray(list, item);
+    }
+    cJSON_AddItemToObject(root, "tasks", list);
 
-    /* Heap */
-    cJSON *heap = cJSON_CreateObject();
-    multi_heap_info_t heap_info;
-    heap_caps_get_info(&heap_info, MALLOC_CAP_DEFAULT);
-    cJSON_AddNumberToObject(heap, "free_bytes", (int)heap_info.total_free_bytes);
-    cJSON_AddNumberToObject(heap, "minimum_free_bytes", (int)heap_info.minimum_free_bytes);
-    cJSON_AddNumberToObject(heap, "total_bytes",
-        (int)(heap_info.total_free_bytes + heap_info.total_allocated_bytes));
-    cJSON_AddNumberToObject(heap, "largest_free_block", (int)heap_info.largest_free_block);
-    cJSON_AddItemToObject(root, "heap", heap);
+    /* cpu[] and stack[] follow the tasks[] order; null where a task was absent */
+    cJSON *series = cJSON_CreateArray();
+    for (size_t s = 0; s < n; s++) {
+        const task_stats_sample_t *smp = &samples[s];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "seq", smp->seq);
+        cJSON_AddNumberToObject(item, "t", smp->time_s);
 
-    /* Tasks */
-    cJSON *tasks = cJSON_CreateArray();
-    UBaseType_t task_count = uxTaskGetNumberOfTasks();
-    TaskStatus_t *task_array = malloc(task_count * sizeof(TaskStatus_t));
-    if (task_array != NULL) {
-        uint32_t total_runtime;
-        task_count = uxTaskGetSystemState(task_array, task_count, &total_runtime);
-        for (UBaseType_t i = 0; i < task_count; i++) {
-            cJSON *task = cJSON_CreateObject();
-            cJSON_AddStringToObject(task, "name", task_array[i].pcTaskName);
-            const char *state_str;
-            switch (task_array[i].eCurrentState) {
-                case eRunning: state_str = "Running"; break;
-                case eReady: state_str = "Ready"; break;
-                case eBlocked: state_str = "Blocked"; break;
-                case eSuspended: state_str = "Suspended"; break;
-                default: state_str = "Unknown"; break;
+        cJSON *idle = cJSON_CreateArray();
+        for (size_t c = 0; c < TASK_STATS_CORES; c++) {
+            cJSON_AddItemToArray(idle, cJSON_CreateNumber(smp->idle_pm[c] / 10.0));
+        }
+        cJSON_AddItemToObject(item, "idle", idle);
+
+        cJSON *cpu = cJSON_CreateArray();
+        cJSON *stack = cJSON_CreateArray();
+        for (size_t i = 0; i < n_tasks; i++) {
+            if (smp->cpu_pm[i] == TASK_STATS_ABSENT) {
+                cJSON_AddItemToArray(cpu, cJSON_CreateNull());
+                cJSON_AddItemToArray(stack, cJSON_CreateNull());
+            } else {
+                cJSON_AddItemToArray(cpu, cJSON_CreateNumber(smp->cpu_pm[i] / 10.0));
+                cJSON_AddItemToArray(stack, cJSON_CreateNumber(smp->stack_free[i]));
             }
-            cJSON_AddStringToObject(task, "state", state_str);
-            cJSON_AddNumberToObject(task, "priority", (int)task_array[i].uxCurrentPriority);
-            cJSON_AddNumberToObject(task, "stack_hwm", (int)task_array[i].usStackHighWaterMark);
-            cJSON_AddItemToArray(tasks, task);
         }
-        free(task_array);
+        cJSON_AddItemToObject(item, "cpu", cpu);
+        cJSON_AddItemToObject(item, "stack", stack);
+        cJSON_AddItemToArray(series, item);
     }
-    cJSON_AddItemToObject(root, "tasks", tasks);
+    cJSON_AddItemToObject(root, "samples", series);
 
     char *json_str = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
@@ -132,9 +424,172 @@ esp_err_t api_system_stats_handler(httpd_req_t *req) {
     return ret;
 }
 
+/* GET /api/system/latency - paddle-to-output latency per path (console `latency`) */
+esp_err_t api_system_latency_handler(httpd_req_t *req) {
+    api_json_t resp;
+    api_json_begin(&resp, req);
+    json_writer_t *w = api_json_writer(&resp);
+    json_object_begin(w, NULL);
+    json_string(w, "mode", key_latency_mode_str(key_latency_get_mode(&g_key_latency)));
+    json_uint(w, "missed", atomic_load_explicit(&g_key_latency.missed, memory_order_relaxed));
+    json_array_begin(w, "paths");
+    for (int p = 0; p < KEY_LATENCY_PATH_COUNT; p++) {
+        key_latency_snapshot_t ls;
+        key_latency_get(&g_key_latency, (key_latency_path_t)p, &ls);
+        json_object_begin(w, NULL);
+        json_string(w, "name", key_latency_path_str((key_latency_path_t)p));
+        json_uint(w, "count", ls.count);
+        json_uint(w, "min_us", ls.min_us);
+        json_uint(w, "p50_us", key_latency_percentile_us(&ls, 50));
+        json_uint(w, "p99_us", key_latency_percentile_us(&ls, 99));
+        json_uint(w, "max_us", ls.max_us);
+        /* Non-empty bins only: upper edge (inclusive) and count */
+        json_array_begin(w, "hist");
+        for (uint32_t b = 0; b < KEY_LATENCY_HIST_BINS; b++) {
+            if (ls.hist[b] == 0) {
+                continue;
+            }
+            json_object_begin(w, NULL);
+            json_uint(w, "le_us", key_latency_bin_upper_us(b));
+            json_uint(w, "count", ls.hist[b]);
+            json_object_end(w);
+        }
+        json_array_end(w);
+        json_object_end(w);
+    }
+    json_array_end(w);
+    json_object_end(w);
+    return api_json_end(&resp);
+}
+
+static bool metrics_send_chunk(void *ctx, const char *data, size_t len) {
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, (ssize_t)len) == ESP_OK;
+}
+
+/* GET /metrics - every registered counter, Prometheus text format */
+esp_err_t api_metrics_handler(httpd_req_t *req) {
+    static char buf[1024];
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    if (!metrics_render(&g_metrics, buf, sizeof(buf), metrics_send_chunk, req)) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/*
+ * GET /api/metrics/history[?series=N&res=1s|1m|15m&from=S&format=json|bin]
+ *
+ * Without series: the series (registry slots) and levels kept. With it:
+ * the points of one series at one resolution (default 1s) starting at or
+ * after from (seconds since boot, as "now"), each [t, min, max, avg];
+ * format=bin sends them as metrics_history_encode() does instead.
+ */
+esp_err_t api_metrics_history_handler(httpd_req_t *req) {
+    static metrics_history_point_t pts[METRICS_HISTORY_CAPACITY];
+    static uint8_t bin[METRICS_HISTORY_BIN_HEADER + METRICS_HISTORY_CAPACITY * METRICS_HISTORY_BIN_RECORD];
+
+    long series = -1;
+    int level = 0;
+    uint32_t from_s = 0;
+    bool binary = false;
+    char query[80] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char param[12];
+        if (httpd_query_key_value(query, "series", param, sizeof(param)) == ESP_OK) {
+            series = strtol(param, NULL, 10);
+        }
+        if (httpd_query_key_value(query, "res", param, sizeof(param)) == ESP_OK) {
+            level = metrics_history_level_from_str(param);
+        }
+        if (httpd_query_key_value(query, "from", param, sizeof(param)) == ESP_OK) {
+            from_s = (uint32_t)strtoul(param, NULL, 10);
+        }
+        if (httpd_query_key_value(query, "format", param, sizeof(param)) == ESP_OK) {
+            binary = strcmp(param, "bin") == 0;
+        }
+    }
+    if (level < 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "res must be 1s, 1m or 15m");
+        return ESP_FAIL;
+    }
+
+    unsigned count = atomic_load_explicit(&g_metrics.count, memory_order_acquire);
+    if (count > METRICS_HISTORY_SERIES) {
+        count = METRICS_HISTORY_SERIES;
+    }
+    const metric_desc_t *desc = NULL;
+    if (series >= 0 && (unsigned long)series < count) {
+        desc = atomic_load_explicit(&g_metrics.slots[series], memory_order_acquire);
+    }
+    if (series >= 0 && desc == NULL) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No such series");
+        return ESP_FAIL;
+    }
+
+    size_t n = 0;
+    if (desc != NULL) {
+        n = metrics_history_read(&g_metrics_history, (uint32_t)level, (uint32_t)series,
+                                 from_s, pts, METRICS_HISTORY_CAPACITY);
+    }
+    if (desc != NULL && binary) {
+        size_t len = metrics_history_encode((uint32_t)level, pts, n, bin, sizeof(bin));
+        httpd_resp_set_type(req, "application/octet-stream");
+        return httpd_resp_send(req, (const char *)bin, (ssize_t)len);
+    }
+
+    api_json_t resp;
+    api_json_begin(&resp, req);
+    json_writer_t *w = api_json_writer(&resp);
+    json_object_begin(w, NULL);
+    json_uint(w, "now", (uint64_t)(esp_timer_get_time() / 1000000));
+    if (desc == NULL) {
+        json_array_begin(w, "levels");
+        for (uint32_t l = 0; l < METRICS_HISTORY_LEVELS; l++) {
+            json_object_begin(w, NULL);
+            json_string(w, "res", metrics_history_level_str(l));
+            json_uint(w, "step_s", metrics_history_step_s(l));
+            json_uint(w, "capacity", METRICS_HISTORY_CAPACITY - 1U);
+            json_object_end(w);
+        }
+        json_array_end(w);
+        json_array_begin(w, "series");
+        for (unsigned s = 0; s < count; s++) {
+            const metric_desc_t *d = atomic_load_explicit(&g_metrics.slots[s], memory_order_acquire);
+            if (d == NULL) {
+                continue;
+            }
+            json_object_begin(w, NULL);
+            json_uint(w, "id", s);
+            json_string(w, "name", d->name);
+            json_string(w, "type", d->type == METRIC_COUNTER ? "rate" : "gauge");
+            json_object_end(w);
+        }
+        json_array_end(w);
+    } else {
+        json_string(w, "name", desc->name);
+        json_string(w, "type", desc->type == METRIC_COUNTER ? "rate" : "gauge");
+        json_string(w, "res", metrics_history_level_str((uint32_t)level));
+        json_uint(w, "step_s", metrics_history_step_s((uint32_t)level));
+        json_array_begin(w, "points");
+        for (size_t i = 0; i < n; i++) {
+            json_array_begin(w, NULL);
+            json_uint(w, NULL, pts[i].time_s);
+            json_int(w, NULL, pts[i].min);
+            json_int(w, NULL, pts[i].max);
+            json_int(w, NULL, pts[i].avg);
+            json_array_end(w);
+        }
+        json_array_end(w);
+    }
+    json_object_end(w);
+    return api_json_end(&resp);
+}
+
 /* POST /api/system/reboot */
 esp_err_t api_system_reboot_handler(httpd_req_t *req) {
     ESP_LOGI(TAG, "Reboot requested");
+    config_persist_flush();
 
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, "{\"success\":true}", HTTPD_RESP_USE_STRLEN);
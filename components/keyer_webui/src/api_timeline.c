@@ -1,10 +1,21 @@
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "cJSON.h"
+#include "api_json.h"
 #include "config.h"
+#include "timeline_pyramid.h"
+#include <stdlib.h>
 
 static const char *TAG __attribute__((unused)) = "api_timeline";
 
+/* Key history summary (main/bg_task.c) */
+extern timeline_pyramid_t g_timeline_pyramid;
+
+/* Range defaults and the widest view served */
+#define RANGE_DEFAULT_US 60000000LL
+#define RANGE_DEFAULT_PX 600U
+#define RANGE_MAX_PX     2000U
+
 /* GET /api/timeline/config */
 esp_err_t api_timeline_config_handler(httpd_req_t *req) {
     cJSON *root = cJSON_CreateObject();
@@ -30,3 +41,84 @@ esp_err_t api_timeline_config_handler(httpd_req_t *req) {
     cJSON_free(json_str);
     return ret;
 }
+
+static bool query_int64(const char *query, const char *key, int64_t *out) {
+    char param[24];
+    if (httpd_query_key_value(query, key, param, sizeof(param)) != ESP_OK) {
+        return false;
+    }
+    *out = strtoll(param, NULL, 10);
+    return true;
+}
+
+/*
+ * GET /api/timeline/range?from=<us>&to=<us>&px=<n>
+ *
+ * Times are esp_timer microseconds, the base of the WebSocket timeline
+ * frames. Defaults: the last minute, 600 columns. Each column is
+ * [duty_key, duty_dit, duty_dah, edges_key, edges_dit, edges_dah, lo, hi]
+ * with duty in per mille and lo/hi as channel bitmaps (timeline_pyramid.h),
+ * or null where that history is no longer held.
+ */
+esp_err_t api_timeline_range_handler(httpd_req_t *req) {
+    int64_t end_us = timeline_pyramid_end_us(&g_timeline_pyramid);
+    int64_t to_us = end_us;
+    int64_t from_us = -1;
+    int64_t px = RANGE_DEFAULT_PX;
+
+    char query[96] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        query_int64(query, "to", &to_us);
+        query_int64(query, "from", &from_us);
+        query_int64(query, "px", &px);
+    }
+    if (from_us < 0) {
+        from_us = (to_us > RANGE_DEFAULT_US) ? to_us - RANGE_DEFAULT_US : 0;
+    }
+    if (to_us < from_us) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "to before from");
+        return ESP_FAIL;
+    }
+    if (px < 1) {
+        px = 1;
+    } else if (px > RANGE_MAX_PX) {
+        px = RANGE_MAX_PX;
+    }
+
+    timeline_range_t it;
+    timeline_pyramid_range_begin(&g_timeline_pyramid, from_us, to_us, (uint32_t)px, &it);
+
+    api_json_t resp;
+    api_json_begin(&resp, req);
+    json_writer_t *w = api_json_writer(&resp);
+    json_object_begin(w, NULL);
+    json_int(w, "from_us", (int64_t)it.next * it.res_us);
+    json_int(w, "to_us", (int64_t)it.end * it.res_us);
+    json_int(w, "end_us", end_us);
+    json_uint(w, "level", it.level);
+    json_uint(w, "res_us", it.res_us);
+    json_uint(w, "span_us", (uint64_t)it.res_us * it.per_column);
+
+    json_array_begin(w, "cols");
+    timeline_column_t col;
+    while (timeline_pyramid_range_next(&g_timeline_pyramid, &it, &col)) {
+        if (!col.valid) {
+            json_null(w, NULL);
+            continue;
+        }
+        json_array_begin(w, NULL);
+        for (int ch = 0; ch < TIMELINE_PYRAMID_CHANNELS; ch++) {
+            json_uint(w, NULL, col.duty_pm[ch]);
+        }
+        for (int ch = 0; ch < TIMELINE_PYRAMID_CHANNELS; ch++) {
+            json_uint(w, NULL, col.edges[ch]);
+        }
+        json_uint(w, NULL, col.lo);
+        json_uint(w, NULL, col.hi);
+        json_array_end(w);
+    }
+    json_array_end(w);
+
+    json_object_end(w);
+    return api_json_end(&resp);
+}
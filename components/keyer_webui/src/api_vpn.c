@@ -15,12 +15,24 @@ esp_err_t api_vpn_status_handler(httpd_req_t *req) {
     vpn_state_t state = vpn_get_state();
     cJSON_AddStringToObject(root, "state", vpn_state_str(state));
     cJSON_AddBoolToObject(root, "connected", state == VPN_STATE_CONNECTED);
+    cJSON_AddStringToObject(root, "clock", vpn_clock_source_str(vpn_get_clock_source()));
 
     vpn_stats_t stats;
     if (vpn_get_stats(&stats)) {
         cJSON *stats_obj = cJSON_CreateObject();
         cJSON_AddNumberToObject(stats_obj, "handshakes", stats.handshakes);
         cJSON_AddNumberToObject(stats_obj, "last_handshake_us", (double)stats.last_handshake_us);
+        cJSON_AddNumberToObject(stats_obj, "tx_bytes", (double)stats.tx_bytes);
+        cJSON_AddNumberToObject(stats_obj, "rx_bytes", (double)stats.rx_bytes);
+        cJSON_AddNumberToObject(stats_obj, "tx_packets", stats.tx_packets);
+        cJSON_AddNumberToObject(stats_obj, "rx_packets", stats.rx_packets);
+        cJSON_AddNumberToObject(stats_obj, "tx_cycles_avg", stats.tx_cycles_avg);
+        cJSON_AddNumberToObject(stats_obj, "tx_cycles_max", stats.tx_cycles_max);
+        cJSON_AddNumberToObject(stats_obj, "rx_cycles_avg", stats.rx_cycles_avg);
+        cJSON_AddNumberToObject(stats_obj, "rx_cycles_max", stats.rx_cycles_max);
+        cJSON_AddNumberToObject(stats_obj, "tx_pool_misses", stats.tx_pool_misses);
+        cJSON_AddNumberToObject(stats_obj, "timer_wakeups", stats.timer_wakeups);
+        cJSON_AddNumberToObject(stats_obj, "keepalives", stats.keepalives);
         cJSON_AddItemToObject(root, "stats", stats_obj);
     }
 
@@ -0,0 +1,142 @@
+/**
+ * @file asset_pack.c
+ * @brief Web UI asset image parser
+ */
+
+#include "asset_pack.h"
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+/** Offset of the ETag in an entry */
+#define ETAG_AT 24U
+
+static uint16_t rd16(const uint8_t *p) {
+    return (uint16_t)((unsigned)p[0] | ((unsigned)p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const uint8_t *entry_at(const asset_pack_t *pack, uint16_t i) {
+    return pack->base + ASSET_PACK_HEADER_SIZE + (size_t)i * ASSET_PACK_ENTRY_SIZE;
+}
+
+/**
+ * @brief True if a NUL-terminated string starts at off inside the image
+ */
+static bool string_ok(const asset_pack_t *pack, uint32_t off) {
+    if (off >= pack->len) {
+        return false;
+    }
+    return memchr(pack->base + off, '\0', pack->len - off) != NULL;
+}
+
+static bool range_ok(const asset_pack_t *pack, uint32_t off, uint32_t len) {
+    return off <= pack->len && len <= pack->len - off;
+}
+
+uint32_t asset_pack_image_len(const uint8_t *hdr) {
+    if (rd32(hdr) != ASSET_PACK_MAGIC || rd16(hdr + 4) != ASSET_PACK_VERSION) {
+        return 0;
+    }
+    return rd32(hdr + 8);
+}
+
+bool asset_pack_open(asset_pack_t *pack, const uint8_t *base, size_t len) {
+    memset(pack, 0, sizeof(*pack));
+    if (len < ASSET_PACK_HEADER_SIZE) {
+        return false;
+    }
+    uint32_t image_len = asset_pack_image_len(base);
+    if (image_len < ASSET_PACK_HEADER_SIZE || image_len > len) {
+        return false;
+    }
+    uint16_t count = rd16(base + 6);
+    if ((size_t)ASSET_PACK_HEADER_SIZE + (size_t)count * ASSET_PACK_ENTRY_SIZE > image_len) {
+        return false;
+    }
+
+    asset_pack_t p = { .base = base, .len = image_len, .count = count };
+    for (uint16_t i = 0; i < count; i++) {
+        const uint8_t *e = entry_at(&p, i);
+        if (!string_ok(&p, rd32(e)) || !string_ok(&p, rd32(e + 4)) ||
+            !range_ok(&p, rd32(e + 8), rd32(e + 12)) ||
+            !range_ok(&p, rd32(e + 16), rd32(e + 20)) ||
+            e[ETAG_AT + ASSET_PACK_ETAG_LEN - 1] != '\0') {
+            return false;
+        }
+    }
+    *pack = p;
+    return true;
+}
+
+bool asset_pack_find(const asset_pack_t *pack, const char *path, webui_asset_t *out) {
+    for (uint16_t i = 0; i < pack->count; i++) {
+        const uint8_t *e = entry_at(pack, i);
+        const char *entry_path = (const char *)(pack->base + rd32(e));
+        if (strcmp(entry_path, path) != 0) {
+            continue;
+        }
+        uint8_t flags = e[ETAG_AT + ASSET_PACK_ETAG_LEN];
+        uint32_t br_len = rd32(e + 20);
+        out->path = entry_path;
+        out->content_type = (const char *)(pack->base + rd32(e + 4));
+        out->data = pack->base + rd32(e + 8);
+        out->length = rd32(e + 12);
+        out->gzipped = (flags & ASSET_PACK_F_GZIP) != 0;
+        out->br_data = (br_len > 0) ? pack->base + rd32(e + 16) : NULL;
+        out->br_length = br_len;
+        out->etag = (const char *)(e + ETAG_AT);
+        out->immutable = (flags & ASSET_PACK_F_IMMUTABLE) != 0;
+        return true;
+    }
+    return false;
+}
+
+bool asset_accepts_br(const char *accept_encoding) {
+    const char *p = accept_encoding;
+    while (*p != '\0') {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        const char *name = p;
+        while (*p != '\0' && *p != ',' && *p != ';' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        bool is_br = ((size_t)(p - name) == 2U && strncasecmp(name, "br", 2) == 0);
+
+        /* Parameters: only q matters, and only q=0 (any number of zero decimals) */
+        bool disabled = false;
+        while (*p != '\0' && *p != ',') {
+            if (*p == ';') {
+                p++;
+                while (*p == ' ' || *p == '\t') {
+                    p++;
+                }
+                if ((p[0] == 'q' || p[0] == 'Q') && p[1] == '=') {
+                    p += 2;
+                    disabled = (*p == '0');
+                    if (disabled) {
+                        p++;
+                        if (*p == '.') {
+                            p++;
+                            while (*p == '0') {
+                                p++;
+                            }
+                            disabled = !isdigit((unsigned char)*p);
+                        }
+                    }
+                }
+                continue;
+            }
+            p++;
+        }
+        if (is_br && !disabled) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file asset_store.c
+ * @brief Web UI assets from the "webui" partition, or compiled into the app
+ *
+ * The partition is memory-mapped once at init and stays mapped, so the
+ * asset pointers handed to the HTTP handlers point into flash and bodies
+ * are sent without a copy in RAM.
+ */
+
+#include "assets.h"
+#include "asset_pack.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_KEYER_WEBUI_ASSETS_PARTITION
+#include "esp_partition.h"
+#endif
+
+static const char *TAG = "webui_assets";
+
+static asset_pack_t s_pack;
+static bool s_pack_ok = false;
+
+#ifdef CONFIG_KEYER_WEBUI_ASSETS_PARTITION
+/** Subtype of the webui partition in partitions.csv */
+#define WEBUI_PARTITION_SUBTYPE 0x40
+
+static void map_partition(void) {
+    const esp_partition_t *part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)WEBUI_PARTITION_SUBTYPE, "webui");
+    if (part == NULL) {
+        ESP_LOGW(TAG, "No webui partition");
+        return;
+    }
+
+    uint8_t hdr[ASSET_PACK_HEADER_SIZE];
+    if (esp_partition_read(part, 0, hdr, sizeof(hdr)) != ESP_OK) {
+        return;
+    }
+    uint32_t image_len = asset_pack_image_len(hdr);
+    if (image_len == 0 || image_len > part->size) {
+        ESP_LOGW(TAG, "webui partition holds no UI image (idf.py webui-flash)");
+        return;
+    }
+
+    const void *base = NULL;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(part, 0, image_len, ESP_PARTITION_MMAP_DATA,
+                                       &base, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mmap failed: %s", esp_err_to_name(err));
+        return;
+    }
+    if (!asset_pack_open(&s_pack, (const uint8_t *)base, image_len)) {
+        ESP_LOGE(TAG, "webui image is corrupt");
+        esp_partition_munmap(handle);
+        return;
+    }
+    s_pack_ok = true;
+    ESP_LOGI(TAG, "UI mapped from partition: %u assets, %lu bytes",
+             (unsigned)s_pack.count, (unsigned long)image_len);
+}
+#endif
+
+void webui_assets_init(void) {
+#ifdef CONFIG_KEYER_WEBUI_ASSETS_PARTITION
+    map_partition();
+#endif
+}
+
+bool webui_find_asset(const char *path, webui_asset_t *out) {
+    if (s_pack_ok) {
+        return asset_pack_find(&s_pack, path, out);
+    }
+    const webui_asset_t *asset = webui_embedded_find(path);
+    if (asset == NULL) {
+        return false;
+    }
+    *out = *asset;
+    return true;
+}
+
+size_t webui_get_asset_count(void) {
+    return s_pack_ok ? s_pack.count : webui_embedded_count();
+}
@@ -0,0 +1,211 @@
+/**
+ * @file http_async.c
+ * @brief API endpoints with latency stats, slow ones on a worker pool
+ */
+
+#include "http_async.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+
+static const char *TAG = "http_async";
+
+/* Same stack as the httpd task: handlers run unchanged on a worker */
+#define HTTP_ASYNC_STACK_BYTES 8192
+
+/* Endpoints kept for the stats (see http_endpoint_at) */
+#define HTTP_ENDPOINTS_MAX 40
+
+typedef struct {
+    TaskHandle_t task;
+    atomic_bool idle;        /**< Claimed by the httpd task with a CAS */
+    http_endpoint_t *ep;     /**< Job, written before the notification */
+    httpd_req_t *req;        /**< Async copy of the request */
+} http_worker_t;
+
+#define HTTP_ASYNC_SLOTS (CONFIG_KEYER_WEBUI_ASYNC_WORKERS > 0 ? \
+                          CONFIG_KEYER_WEBUI_ASYNC_WORKERS : 1)
+
+static http_worker_t s_workers[HTTP_ASYNC_SLOTS];
+#if CONFIG_KEYER_WEBUI_ASYNC_WORKERS > 0
+/* Workers live for the whole uptime: static, no heap at init */
+static StackType_t s_worker_stacks[CONFIG_KEYER_WEBUI_ASYNC_WORKERS][HTTP_ASYNC_STACK_BYTES];
+static StaticTask_t s_worker_tcbs[CONFIG_KEYER_WEBUI_ASYNC_WORKERS];
+#endif
+static int s_worker_count;
+
+static http_endpoint_t *s_endpoints[HTTP_ENDPOINTS_MAX];
+static atomic_size_t s_endpoint_count;
+
+/**
+ * @brief Run the handler and account for it
+ *
+ * Only one task runs a given endpoint at a time (the httpd task, or one
+ * worker while busy is held), so the averages need no read-modify-write.
+ */
+static esp_err_t endpoint_run(http_endpoint_t *ep, httpd_req_t *req) {
+    http_endpoint_stats_t *s = &ep->stats;
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = ep->uri.handler(req);
+    int64_t elapsed = esp_timer_get_time() - start;
+    unsigned us = (elapsed > (int64_t)UINT32_MAX) ? UINT32_MAX : (unsigned)elapsed;
+
+    unsigned count = atomic_load_explicit(&s->count, memory_order_relaxed);
+    unsigned avg = atomic_load_explicit(&s->avg_us, memory_order_relaxed);
+    if (count == 0) {
+        avg = us;
+    } else if (us > avg) {
+        avg += (us - avg) / 8U;
+    } else {
+        avg -= (avg - us) / 8U;
+    }
+    atomic_store_explicit(&s->avg_us, avg, memory_order_relaxed);
+    if (us > atomic_load_explicit(&s->max_us, memory_order_relaxed)) {
+        atomic_store_explicit(&s->max_us, us, memory_order_relaxed);
+    }
+    atomic_store_explicit(&s->count, count + 1U, memory_order_relaxed);
+    if (err != ESP_OK) {
+        atomic_fetch_add_explicit(&s->errors, 1, memory_order_relaxed);
+    }
+    return err;
+}
+
+static void endpoint_release(http_endpoint_t *ep) {
+    atomic_store_explicit(&ep->stats.busy, false, memory_order_release);
+}
+
+static void worker_task(void *arg) {
+    http_worker_t *w = (http_worker_t *)arg;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        http_endpoint_t *ep = w->ep;
+        httpd_req_t *req = w->req;
+
+        /* A failed handler closes the session, as it would inline */
+        if (endpoint_run(ep, req) != ESP_OK) {
+            httpd_sess_trigger_close(req->handle, httpd_req_to_sockfd(req));
+        }
+        httpd_req_async_handler_complete(req);
+        endpoint_release(ep);
+        atomic_store_explicit(&w->idle, true, memory_order_release);
+    }
+}
+
+static http_worker_t *worker_claim(void) {
+    for (int i = 0; i < s_worker_count; i++) {
+        bool idle = true;
+        if (atomic_compare_exchange_strong_explicit(&s_workers[i].idle, &idle, false,
+                                                    memory_order_acquire,
+                                                    memory_order_relaxed)) {
+            return &s_workers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Registered handler of every endpoint (user_ctx is the endpoint)
+ */
+static esp_err_t endpoint_trampoline(httpd_req_t *req) {
+    http_endpoint_t *ep = (http_endpoint_t *)req->user_ctx;
+    http_endpoint_stats_t *s = &ep->stats;
+    req->user_ctx = ep->uri.user_ctx;
+
+    if (!ep->async) {
+        return endpoint_run(ep, req);
+    }
+
+    if (atomic_exchange_explicit(&s->busy, true, memory_order_acquire)) {
+        atomic_fetch_add_explicit(&s->rejected, 1, memory_order_relaxed);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"error\":\"Busy\"}");
+        return ESP_OK;
+    }
+
+    http_worker_t *w = worker_claim();
+    if (w != NULL) {
+        httpd_req_t *copy = NULL;
+        if (httpd_req_async_handler_begin(req, &copy) == ESP_OK) {
+            w->ep = ep;
+            w->req = copy;
+            atomic_fetch_add_explicit(&s->deferred, 1, memory_order_relaxed);
+            xTaskNotifyGive(w->task);
+            return ESP_OK;
+        }
+        atomic_store_explicit(&w->idle, true, memory_order_release);
+    }
+
+    /* Every worker busy: fall back to the old behaviour */
+    atomic_fetch_add_explicit(&s->inline_runs, 1, memory_order_relaxed);
+    esp_err_t err = endpoint_run(ep, req);
+    endpoint_release(ep);
+    return err;
+}
+
+esp_err_t http_async_init(void) {
+    if (s_worker_count > 0) {
+        return ESP_OK;
+    }
+#if CONFIG_KEYER_WEBUI_ASYNC_WORKERS > 0
+    for (int i = 0; i < CONFIG_KEYER_WEBUI_ASYNC_WORKERS; i++) {
+        http_worker_t *w = &s_workers[i];
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "http_w%d", i);
+        /* Core 1 with the other background services; the stack stays in
+         * internal RAM because handlers write flash (NVS, OTA) */
+        w->task = xTaskCreateStaticPinnedToCore(worker_task, name, HTTP_ASYNC_STACK_BYTES, w,
+                                                tskIDLE_PRIORITY + 1, s_worker_stacks[i],
+                                                &s_worker_tcbs[i], 1);
+        if (w->task == NULL) {
+            ESP_LOGW(TAG, "Worker %d not started, %d running", i, s_worker_count);
+            break;
+        }
+        atomic_store_explicit(&w->idle, true, memory_order_release);
+        s_worker_count++;
+    }
+#endif
+    ESP_LOGI(TAG, "%d async workers", s_worker_count);
+    return ESP_OK;
+}
+
+esp_err_t http_endpoint_register(httpd_handle_t server, http_endpoint_t *ep) {
+    httpd_uri_t uri = ep->uri;
+    uri.handler = endpoint_trampoline;
+    uri.user_ctx = ep;
+    esp_err_t err = httpd_register_uri_handler(server, &uri);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Register %s failed: %s", ep->uri.uri, esp_err_to_name(err));
+        return err;
+    }
+
+    /* A restarted server registers the same endpoints again */
+    size_t n = atomic_load_explicit(&s_endpoint_count, memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+        if (s_endpoints[i] == ep) {
+            return ESP_OK;
+        }
+    }
+    if (n < HTTP_ENDPOINTS_MAX) {
+        s_endpoints[n] = ep;
+        atomic_store_explicit(&s_endpoint_count, n + 1U, memory_order_release);
+    }
+    return ESP_OK;
+}
+
+int http_async_worker_count(void) {
+    return s_worker_count;
+}
+
+size_t http_endpoint_count(void) {
+    return atomic_load_explicit(&s_endpoint_count, memory_order_acquire);
+}
+
+const http_endpoint_t *http_endpoint_at(size_t i) {
+    return (i < http_endpoint_count()) ? s_endpoints[i] : NULL;
+}
@@ -1,33 +1,67 @@
 #include "webui.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "webui";
+
+#ifdef CONFIG_KEYER_WEBUI
+
 #include "assets.h"
+#include "asset_pack.h"
 #include "ws_server.h"
+#include "http_async.h"
 #include "esp_http_server.h"
-#include "esp_log.h"
+#include <stdio.h>
 #include <string.h>
-
-static const char *TAG = "webui";
+#include <unistd.h>
+
+/*
+ * Every WebSocket client plus a few page loads at once. httpd keeps three
+ * sockets for itself (listener and control), and lwIP must still have room
+ * for CWNet, WinKeyer TCP and the VPN.
+ */
+#define WEBUI_MAX_OPEN_SOCKETS (WS_MAX_CLIENTS + 4)
+_Static_assert(WEBUI_MAX_OPEN_SOCKETS + 3 + 4 <= CONFIG_LWIP_MAX_SOCKETS,
+               "raise CONFIG_LWIP_MAX_SOCKETS for the web UI sockets");
 static httpd_handle_t s_server = NULL;
 
 /* API handlers (implemented in api_*.c) */
 extern esp_err_t api_config_schema_handler(httpd_req_t *req);
+extern esp_err_t api_parameters_batch_handler(httpd_req_t *req);
 extern esp_err_t api_config_get_handler(httpd_req_t *req);
 extern esp_err_t api_parameter_set_handler(httpd_req_t *req);
 extern esp_err_t api_config_save_handler(httpd_req_t *req);
+extern esp_err_t api_config_profile_get_handler(httpd_req_t *req);
+extern esp_err_t api_config_profile_put_handler(httpd_req_t *req);
 extern esp_err_t api_status_handler(httpd_req_t *req);
 extern esp_err_t api_system_stats_handler(httpd_req_t *req);
 extern esp_err_t api_system_reboot_handler(httpd_req_t *req);
+extern esp_err_t api_system_flightrec_handler(httpd_req_t *req);
+extern esp_err_t api_system_tasks_handler(httpd_req_t *req);
+extern esp_err_t api_system_latency_handler(httpd_req_t *req);
+extern esp_err_t api_metrics_handler(httpd_req_t *req);
+extern esp_err_t api_metrics_history_handler(httpd_req_t *req);
+extern esp_err_t api_bench_handler(httpd_req_t *req);
+extern void api_bench_init(void);
 extern esp_err_t api_decoder_status_handler(httpd_req_t *req);
 extern esp_err_t api_decoder_enable_handler(httpd_req_t *req);
+extern esp_err_t api_decoder_text_handler(httpd_req_t *req);
 extern esp_err_t api_timeline_config_handler(httpd_req_t *req);
+extern esp_err_t api_timeline_range_handler(httpd_req_t *req);
 extern esp_err_t api_text_send_handler(httpd_req_t *req);
 extern esp_err_t api_text_status_handler(httpd_req_t *req);
 extern esp_err_t api_text_abort_handler(httpd_req_t *req);
 extern esp_err_t api_text_pause_handler(httpd_req_t *req);
 extern esp_err_t api_text_resume_handler(httpd_req_t *req);
+extern esp_err_t api_text_cancel_handler(httpd_req_t *req);
 extern esp_err_t api_text_memory_list_handler(httpd_req_t *req);
 extern esp_err_t api_text_memory_set_handler(httpd_req_t *req);
 extern esp_err_t api_text_play_handler(httpd_req_t *req);
 extern esp_err_t api_vpn_status_handler(httpd_req_t *req);
+extern esp_err_t api_stream_export_handler(httpd_req_t *req);
+extern esp_err_t api_stream_sessions_handler(httpd_req_t *req);
+extern esp_err_t api_cwnet_capture_handler(httpd_req_t *req);
+extern esp_err_t api_ota_handler(httpd_req_t *req);
 
 /* SPA routes that should serve index.html */
 static const char *SPA_ROUTES[] = {
@@ -37,6 +71,7 @@ static const char *SPA_ROUTES[] = {
     "/keyer",
     "/decoder",
     "/timeline",
+    "/log",
     "/firmware",
     NULL
 };
@@ -50,30 +85,68 @@ static bool is_spa_route(const char *uri) {
     return false;
 }
 
+/**
+ * @brief Send an asset from flash (or the app image), or 304 if the client has it
+ *
+ * Brotli is sent to clients that accept it, gzip to everyone else; the
+ * Brotli variant gets its own ETag ("<hash>-br") so caches keep them apart.
+ * Hashed file names never change content, so they are cached for a year
+ * without revalidation; everything else (index.html) revalidates by ETag
+ * so a reflashed UI is picked up on the next load.
+ */
 static esp_err_t serve_asset(httpd_req_t *req, const webui_asset_t *asset) {
+    const uint8_t *data = asset->data;
+    size_t length = asset->length;
+    const char *encoding = asset->gzipped ? "gzip" : NULL;
+    const char *etag = asset->etag;
+    char br_etag[ASSET_PACK_ETAG_LEN + 3];
+
+    if (asset->br_data != NULL) {
+        char accept[128];
+        if (httpd_req_get_hdr_value_str(req, "Accept-Encoding", accept,
+                                        sizeof(accept)) == ESP_OK &&
+            asset_accepts_br(accept)) {
+            data = asset->br_data;
+            length = asset->br_length;
+            encoding = "br";
+            size_t n = strlen(asset->etag);
+            snprintf(br_etag, sizeof(br_etag), "%.*s-br\"", (int)(n - 1), asset->etag);
+            etag = br_etag;
+        }
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    }
+
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", asset->immutable
+                       ? "public, max-age=31536000, immutable" : "no-cache");
+
+    char if_none_match[ASSET_PACK_ETAG_LEN + 8];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match,
+                                    sizeof(if_none_match)) == ESP_OK &&
+        strcmp(if_none_match, etag) == 0) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
     httpd_resp_set_type(req, asset->content_type);
-    if (asset->gzipped) {
-        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    if (encoding != NULL) {
+        httpd_resp_set_hdr(req, "Content-Encoding", encoding);
     }
-    httpd_resp_set_hdr(req, "Cache-Control", "max-age=86400");
-    return httpd_resp_send(req, (const char *)asset->data, (ssize_t)asset->length);
+    return httpd_resp_send(req, (const char *)data, (ssize_t)length);
 }
 
 static esp_err_t handle_static(httpd_req_t *req) {
     const char *uri = req->uri;
+    webui_asset_t asset;
 
     /* Try exact match first */
-    const webui_asset_t *asset = webui_find_asset(uri);
-    if (asset != NULL) {
-        return serve_asset(req, asset);
+    if (webui_find_asset(uri, &asset)) {
+        return serve_asset(req, &asset);
     }
 
     /* SPA routes serve index.html */
-    if (is_spa_route(uri)) {
-        asset = webui_find_asset("/index.html");
-        if (asset != NULL) {
-            return serve_asset(req, asset);
-        }
+    if (is_spa_route(uri) && webui_find_asset("/index.html", &asset)) {
+        return serve_asset(req, &asset);
     }
 
     /* 404 */
@@ -103,101 +176,80 @@ static void register_static_routes(httpd_handle_t server) {
     httpd_register_uri_handler(server, &assets_uri);
 }
 
-static void register_api_routes(httpd_handle_t server) {
-    /* Config API */
-    httpd_uri_t schema = {
-        .uri = "/api/config/schema",
-        .method = HTTP_GET,
-        .handler = api_config_schema_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &schema);
+/* Shorthand for the endpoint table */
+#define API(m, u, h, a) { .uri = { .uri = (u), .method = (m), .handler = (h) }, .async = (a) }
 
-    httpd_uri_t config_get = {
-        .uri = "/api/config",
-        .method = HTTP_GET,
-        .handler = api_config_get_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &config_get);
+/*
+ * API endpoints, timed by http_async.c. Those marked async (NVS commits,
+ * long JSON documents, uploads) run on a worker so the other sockets are
+ * served meanwhile; quick ones stay on the httpd task.
+ */
+static http_endpoint_t s_api[] = {
+    /* Config API */
+    API(HTTP_GET,  "/api/config/schema",      api_config_schema_handler,      true),
+    API(HTTP_GET,  "/api/config",             api_config_get_handler,         true),
+    API(HTTP_POST, "/api/parameter",          api_parameter_set_handler,      false),
+    API(HTTP_POST, "/api/parameters/batch",   api_parameters_batch_handler,   true),
+    API(HTTP_POST, "/api/config/save",        api_config_save_handler,        true),
+    API(HTTP_GET,  "/api/config/profile",     api_config_profile_get_handler, true),
+    API(HTTP_PUT,  "/api/config/profile",     api_config_profile_put_handler, true),
 
-    httpd_uri_t param_set = {
-        .uri = "/api/parameter",
-        .method = HTTP_POST,
-        .handler = api_parameter_set_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &param_set);
+    /* System API */
+    API(HTTP_GET,  "/api/status",             api_status_handler,             false),
+    API(HTTP_GET,  "/api/system/stats",       api_system_stats_handler,       false),
+    API(HTTP_GET,  "/api/system/flightrec",   api_system_flightrec_handler,   true),
+    API(HTTP_GET,  "/api/system/tasks",       api_system_tasks_handler,       true),
+    API(HTTP_GET,  "/api/system/latency",     api_system_latency_handler,     false),
+    API(HTTP_GET,  "/metrics",                api_metrics_handler,            true),
+    API(HTTP_GET,  "/api/metrics/history",    api_metrics_history_handler,    true),
+    API(HTTP_GET,  "/api/bench",              api_bench_handler,              true),
+    API(HTTP_POST, "/api/system/reboot",      api_system_reboot_handler,      false),
 
-    httpd_uri_t config_save = {
-        .uri = "/api/config/save",
-        .method = HTTP_POST,
-        .handler = api_config_save_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &config_save);
+    /* VPN API */
+    API(HTTP_GET,  "/api/vpn/status",         api_vpn_status_handler,         false),
 
-    /* System API */
-    httpd_uri_t status = {
-        .uri = "/api/status",
-        .method = HTTP_GET,
-        .handler = api_status_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &status);
+    /* Decoder API */
+    API(HTTP_GET,  "/api/decoder/status",     api_decoder_status_handler,     false),
+    API(HTTP_POST, "/api/decoder/enable",     api_decoder_enable_handler,     false),
+    API(HTTP_GET,  "/api/decoder/text",       api_decoder_text_handler,       false),
 
-    httpd_uri_t stats = {
-        .uri = "/api/system/stats",
-        .method = HTTP_GET,
-        .handler = api_system_stats_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &stats);
+    /* Timeline API */
+    API(HTTP_GET,  "/api/timeline/config",    api_timeline_config_handler,    false),
+    API(HTTP_GET,  "/api/timeline/range",     api_timeline_range_handler,     true),
 
-    httpd_uri_t reboot = {
-        .uri = "/api/system/reboot",
-        .method = HTTP_POST,
-        .handler = api_system_reboot_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &reboot);
+    /* Stream API */
+    API(HTTP_GET,  "/api/stream/export",      api_stream_export_handler,      true),
+    API(HTTP_GET,  "/api/stream/sessions",    api_stream_sessions_handler,    false),
 
-    /* VPN API */
-    httpd_uri_t vpn_status = {
-        .uri = "/api/vpn/status",
-        .method = HTTP_GET,
-        .handler = api_vpn_status_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &vpn_status);
+    /* CWNet API */
+    API(HTTP_GET,  "/api/cwnet/capture",      api_cwnet_capture_handler,      true),
 
-    /* Decoder API */
-    httpd_uri_t decoder_status = {
-        .uri = "/api/decoder/status",
-        .method = HTTP_GET,
-        .handler = api_decoder_status_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &decoder_status);
+    /* Text Keyer API */
+    API(HTTP_POST, "/api/text/send",          api_text_send_handler,          false),
+    API(HTTP_GET,  "/api/text/status",        api_text_status_handler,        false),
+    API(HTTP_POST, "/api/text/abort",         api_text_abort_handler,         false),
+    API(HTTP_POST, "/api/text/pause",         api_text_pause_handler,         false),
+    API(HTTP_POST, "/api/text/resume",        api_text_resume_handler,        false),
+    API(HTTP_POST, "/api/text/cancel",        api_text_cancel_handler,        false),
+    API(HTTP_GET,  "/api/text/memory",        api_text_memory_list_handler,   false),
+    API(HTTP_POST, "/api/text/memory",        api_text_memory_set_handler,    false),
+    API(HTTP_POST, "/api/text/play",          api_text_play_handler,          false),
+
+    /* Firmware update (streamed into the next OTA partition) */
+    API(HTTP_POST, "/api/ota",                api_ota_handler,                true),
+    { .uri = { .uri = "/api/ota/delta", .method = HTTP_POST, .handler = api_ota_handler,
+               .user_ctx = (void *)1 },   /* Body is a delta patch */
+      .async = true },
+};
 
-    httpd_uri_t decoder_enable = {
-        .uri = "/api/decoder/enable",
-        .method = HTTP_POST,
-        .handler = api_decoder_enable_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &decoder_enable);
+#undef API
 
-    /* Timeline API */
-    httpd_uri_t timeline_config = {
-        .uri = "/api/timeline/config",
-        .method = HTTP_GET,
-        .handler = api_timeline_config_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &timeline_config);
+static void register_api_routes(httpd_handle_t server) {
+    for (size_t i = 0; i < sizeof(s_api) / sizeof(s_api[0]); i++) {
+        http_endpoint_register(server, &s_api[i]);
+    }
 
-    /* WebSocket endpoint for real-time streaming */
+    /* WebSocket endpoint for real-time streaming (long-lived, not timed) */
     httpd_uri_t ws = {
         .uri = "/ws",
         .method = HTTP_GET,
@@ -207,75 +259,24 @@ static void register_api_routes(httpd_handle_t server) {
         .handle_ws_control_frames = true,
     };
     httpd_register_uri_handler(server, &ws);
+}
 
-    /* Text Keyer API */
-    httpd_uri_t text_send = {
-        .uri = "/api/text/send",
-        .method = HTTP_POST,
-        .handler = api_text_send_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &text_send);
-
-    httpd_uri_t text_status = {
-        .uri = "/api/text/status",
-        .method = HTTP_GET,
-        .handler = api_text_status_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &text_status);
-
-    httpd_uri_t text_abort = {
-        .uri = "/api/text/abort",
-        .method = HTTP_POST,
-        .handler = api_text_abort_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &text_abort);
-
-    httpd_uri_t text_pause = {
-        .uri = "/api/text/pause",
-        .method = HTTP_POST,
-        .handler = api_text_pause_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &text_pause);
-
-    httpd_uri_t text_resume = {
-        .uri = "/api/text/resume",
-        .method = HTTP_POST,
-        .handler = api_text_resume_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &text_resume);
-
-    httpd_uri_t text_memory_list = {
-        .uri = "/api/text/memory",
-        .method = HTTP_GET,
-        .handler = api_text_memory_list_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &text_memory_list);
-
-    httpd_uri_t text_memory_set = {
-        .uri = "/api/text/memory",
-        .method = HTTP_POST,
-        .handler = api_text_memory_set_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &text_memory_set);
-
-    httpd_uri_t text_play = {
-        .uri = "/api/text/play",
-        .method = HTTP_POST,
-        .handler = api_text_play_handler,
-        .user_ctx = NULL,
-    };
-    httpd_register_uri_handler(server, &text_play);
+/**
+ * @brief Session closed (client gone, purged or shut down)
+ *
+ * With lru_purge_enable httpd closes the least recently used socket to
+ * accept a new one; a WebSocket client must not be left registered on
+ * a socket that no longer exists.
+ */
+static void session_closed(httpd_handle_t hd, int sockfd) {
+    ws_server_session_closed(sockfd);
+    close(sockfd);
 }
 
 esp_err_t webui_init(void) {
     ws_server_init();
+    webui_assets_init();
+    api_bench_init();
     ESP_LOGI(TAG, "WebUI initialized (%zu assets)", webui_get_asset_count());
     return ESP_OK;
 }
@@ -286,9 +287,12 @@ esp_err_t webui_start(void) {
     }
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 32;
+    config.max_uri_handlers = 48;
     config.stack_size = 8192;
     config.uri_match_fn = httpd_uri_match_wildcard;
+    config.max_open_sockets = WEBUI_MAX_OPEN_SOCKETS;
+    config.lru_purge_enable = true;
+    config.close_fn = session_closed;
 
     esp_err_t ret = httpd_start(&s_server, &config);
     if (ret != ESP_OK) {
@@ -296,6 +300,8 @@ esp_err_t webui_start(void) {
         return ret;
     }
 
+    http_async_init();
+
     /* Set httpd handle for WebSocket session management */
     ws_server_set_httpd_handle(s_server);
 
@@ -322,9 +328,13 @@ void webui_timeline_push(const char *event_type, const char *json_data) {
     ws_broadcast_timeline(event_type, json_data);
 }
 
-void webui_decoder_push_char(char c, uint8_t wpm) {
+void webui_timeline_push_edges(const uint8_t *frame, size_t len) {
+    ws_broadcast_binary(frame, len);
+}
+
+void webui_decoder_push_char(char c, uint8_t wpm, uint32_t seq) {
     ESP_LOGI(TAG, "Push char '%c' wpm=%u clients=%d", c, wpm, ws_get_client_count());
-    ws_broadcast_decoder_char(c, wpm);
+    ws_broadcast_decoder_char(c, wpm, seq);
 }
 
 void webui_decoder_push_word(void) {
@@ -335,6 +345,90 @@ void webui_decoder_push_pattern(const char *pattern) {
     ws_broadcast_decoder_pattern(pattern);
 }
 
+void webui_text_status_push(void) {
+    ws_broadcast_text_status();
+}
+
+void webui_key_stats_push(void) {
+    ws_broadcast_key_stats();
+}
+
+bool webui_log_push(void) {
+    return ws_push_logs();
+}
+
+bool webui_state_push(void) {
+    return ws_push_state();
+}
+
+bool webui_topic_active(ws_topic_t topic) {
+    return ws_topic_active(topic);
+}
+
 int webui_get_ws_client_count(void) {
     return ws_get_client_count();
 }
+
+#else
+/* Web UI not built in (CONFIG_KEYER_WEBUI): nothing served, nobody subscribed */
+
+esp_err_t webui_init(void) {
+    ESP_LOGI(TAG, "WebUI not built in (CONFIG_KEYER_WEBUI)");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t webui_start(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t webui_stop(void) {
+    return ESP_OK;
+}
+
+void webui_timeline_push(const char *event_type, const char *json_data) {
+    (void)event_type;
+    (void)json_data;
+}
+
+void webui_timeline_push_edges(const uint8_t *frame, size_t len) {
+    (void)frame;
+    (void)len;
+}
+
+void webui_decoder_push_char(char c, uint8_t wpm, uint32_t seq) {
+    (void)c;
+    (void)wpm;
+    (void)seq;
+}
+
+void webui_decoder_push_word(void) {
+}
+
+void webui_decoder_push_pattern(const char *pattern) {
+    (void)pattern;
+}
+
+void webui_text_status_push(void) {
+}
+
+void webui_key_stats_push(void) {
+}
+
+bool webui_log_push(void) {
+    return false;
+}
+
+bool webui_state_push(void) {
+    return false;
+}
+
+bool webui_topic_active(ws_topic_t topic) {
+    (void)topic;
+    return false;
+}
+
+int webui_get_ws_client_count(void) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,374 @@
+/**
+ * @file json_scan.c
+ * @brief In-place JSON tokenizer for small request bodies
+ */
+
+#include "json_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+typedef struct {
+    const char *js;
+    size_t len;
+    size_t pos;
+    json_tok_t *toks;
+    size_t max;
+    size_t count;
+} scanner_t;
+
+static void skip_ws(scanner_t *s) {
+    while (s->pos < s->len) {
+        char c = s->js[s->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        s->pos++;
+    }
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool is_hex(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static json_tok_t *new_token(scanner_t *s, json_tok_type_t type) {
+    if (s->count >= s->max) {
+        return NULL;
+    }
+    json_tok_t *tok = &s->toks[s->count++];
+    tok->type = (uint8_t)type;
+    tok->start = (uint16_t)s->pos;
+    tok->len = 0;
+    tok->next = 0;
+    return tok;
+}
+
+static void close_token(scanner_t *s, json_tok_t *tok) {
+    tok->len = (uint16_t)(s->pos - tok->start);
+    tok->next = (uint16_t)s->count;
+}
+
+static bool scan_string(scanner_t *s) {
+    s->pos++;  /* Opening quote */
+    json_tok_t *tok = new_token(s, JSON_TOK_STRING);
+    if (tok == NULL) {
+        return false;
+    }
+    while (s->pos < s->len) {
+        unsigned char c = (unsigned char)s->js[s->pos];
+        if (c == '"') {
+            close_token(s, tok);
+            s->pos++;
+            return true;
+        }
+        if (c < 0x20U) {
+            return false;
+        }
+        if (c == '\\') {
+            if (++s->pos >= s->len) {
+                return false;
+            }
+            char e = s->js[s->pos];
+            if (e == 'u') {
+                for (int i = 0; i < 4; i++) {
+                    if (++s->pos >= s->len || !is_hex(s->js[s->pos])) {
+                        return false;
+                    }
+                }
+            } else if (strchr("\"\\/bfnrt", e) == NULL || e == '\0') {
+                return false;
+            }
+        }
+        s->pos++;
+    }
+    return false;
+}
+
+static bool scan_number(scanner_t *s) {
+    json_tok_t *tok = new_token(s, JSON_TOK_NUMBER);
+    if (tok == NULL) {
+        return false;
+    }
+    if (s->js[s->pos] == '-') {
+        s->pos++;
+    }
+    if (s->pos >= s->len || !is_digit(s->js[s->pos])) {
+        return false;
+    }
+    if (s->js[s->pos] == '0') {
+        s->pos++;
+    } else {
+        while (s->pos < s->len && is_digit(s->js[s->pos])) {
+            s->pos++;
+        }
+    }
+    if (s->pos < s->len && s->js[s->pos] == '.') {
+        s->pos++;
+        if (s->pos >= s->len || !is_digit(s->js[s->pos])) {
+            return false;
+        }
+        while (s->pos < s->len && is_digit(s->js[s->pos])) {
+            s->pos++;
+        }
+    }
+    if (s->pos < s->len && (s->js[s->pos] == 'e' || s->js[s->pos] == 'E')) {
+        s->pos++;
+        if (s->pos < s->len && (s->js[s->pos] == '+' || s->js[s->pos] == '-')) {
+            s->pos++;
+        }
+        if (s->pos >= s->len || !is_digit(s->js[s->pos])) {
+            return false;
+        }
+        while (s->pos < s->len && is_digit(s->js[s->pos])) {
+            s->pos++;
+        }
+    }
+    close_token(s, tok);
+    return true;
+}
+
+static bool scan_literal(scanner_t *s, const char *word, json_tok_type_t type) {
+    size_t n = strlen(word);
+    if (s->len - s->pos < n || memcmp(s->js + s->pos, word, n) != 0) {
+        return false;
+    }
+    json_tok_t *tok = new_token(s, type);
+    if (tok == NULL) {
+        return false;
+    }
+    s->pos += n;
+    close_token(s, tok);
+    return true;
+}
+
+static bool scan_value(scanner_t *s, unsigned depth);
+
+static bool scan_container(scanner_t *s, unsigned depth, bool object) {
+    if (depth >= JSON_SCAN_MAX_DEPTH) {
+        return false;
+    }
+    json_tok_t *tok = new_token(s, object ? JSON_TOK_OBJECT : JSON_TOK_ARRAY);
+    if (tok == NULL) {
+        return false;
+    }
+    char end = object ? '}' : ']';
+    s->pos++;
+    skip_ws(s);
+    if (s->pos < s->len && s->js[s->pos] == end) {
+        s->pos++;
+        close_token(s, tok);
+        return true;
+    }
+    for (;;) {
+        if (object) {
+            skip_ws(s);
+            if (s->pos >= s->len || s->js[s->pos] != '"' || !scan_string(s)) {
+                return false;
+            }
+            skip_ws(s);
+            if (s->pos >= s->len || s->js[s->pos] != ':') {
+                return false;
+            }
+            s->pos++;
+        }
+        if (!scan_value(s, depth + 1U)) {
+            return false;
+        }
+        skip_ws(s);
+        if (s->pos >= s->len) {
+            return false;
+        }
+        char c = s->js[s->pos++];
+        if (c == end) {
+            close_token(s, tok);
+            return true;
+        }
+        if (c != ',') {
+            return false;
+        }
+    }
+}
+
+static bool scan_value(scanner_t *s, unsigned depth) {
+    skip_ws(s);
+    if (s->pos >= s->len) {
+        return false;
+    }
+    char c = s->js[s->pos];
+    switch (c) {
+        case '{': return scan_container(s, depth, true);
+        case '[': return scan_container(s, depth, false);
+        case '"': return scan_string(s);
+        case 't': return scan_literal(s, "true", JSON_TOK_TRUE);
+        case 'f': return scan_literal(s, "false", JSON_TOK_FALSE);
+        case 'n': return scan_literal(s, "null", JSON_TOK_NULL);
+        default:
+            return (c == '-' || is_digit(c)) && scan_number(s);
+    }
+}
+
+int json_scan(const char *js, size_t len, json_tok_t *toks, size_t max) {
+    if (len > JSON_SCAN_MAX_LEN || max > (size_t)UINT16_MAX) {
+        return -1;
+    }
+    scanner_t s = { .js = js, .len = len, .pos = 0, .toks = toks, .max = max, .count = 0 };
+    if (!scan_value(&s, 0)) {
+        return -1;
+    }
+    skip_ws(&s);
+    if (s.pos != s.len) {
+        return -1;
+    }
+    return (int)s.count;
+}
+
+int json_scan_get(const char *js, const json_tok_t *toks, int obj, const char *key) {
+    if (obj < 0 || toks[obj].type != JSON_TOK_OBJECT) {
+        return -1;
+    }
+    size_t key_len = strlen(key);
+    int i = obj + 1;
+    while (i < (int)toks[obj].next) {
+        const json_tok_t *k = &toks[i];
+        if (k->len == key_len && memcmp(js + k->start, key, key_len) == 0) {
+            return i + 1;
+        }
+        i = (int)toks[i + 1].next;
+    }
+    return -1;
+}
+
+static unsigned hex4(const char *p) {
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        unsigned d = is_digit(c) ? (unsigned)(c - '0') :
+                     (c >= 'a') ? (unsigned)(c - 'a' + 10) : (unsigned)(c - 'A' + 10);
+        v = (v << 4) | d;
+    }
+    return v;
+}
+
+/**
+ * @brief Append a code point as UTF-8
+ */
+static bool put_utf8(char *out, size_t cap, size_t *n, unsigned cp) {
+    char enc[4];
+    size_t len;
+    if (cp < 0x80U) {
+        enc[0] = (char)cp;
+        len = 1;
+    } else if (cp < 0x800U) {
+        enc[0] = (char)(0xC0U | (cp >> 6));
+        enc[1] = (char)(0x80U | (cp & 0x3FU));
+        len = 2;
+    } else if (cp < 0x10000U) {
+        enc[0] = (char)(0xE0U | (cp >> 12));
+        enc[1] = (char)(0x80U | ((cp >> 6) & 0x3FU));
+        enc[2] = (char)(0x80U | (cp & 0x3FU));
+        len = 3;
+    } else {
+        enc[0] = (char)(0xF0U | (cp >> 18));
+        enc[1] = (char)(0x80U | ((cp >> 12) & 0x3FU));
+        enc[2] = (char)(0x80U | ((cp >> 6) & 0x3FU));
+        enc[3] = (char)(0x80U | (cp & 0x3FU));
+        len = 4;
+    }
+    if (*n + len >= cap) {
+        return false;
+    }
+    memcpy(out + *n, enc, len);
+    *n += len;
+    return true;
+}
+
+bool json_scan_string(const char *js, const json_tok_t *tok, char *out, size_t cap) {
+    if (tok->type != JSON_TOK_STRING || cap == 0) {
+        return false;
+    }
+    const char *p = js + tok->start;
+    const char *end = p + tok->len;
+    size_t n = 0;
+    while (p < end) {
+        unsigned cp;
+        if (*p != '\\') {
+            cp = (unsigned char)*p++;
+            if (n + 1 >= cap) {
+                return false;
+            }
+            out[n++] = (char)cp;
+            continue;
+        }
+        char e = p[1];
+        p += 2;
+        switch (e) {
+            case 'b': cp = '\b'; break;
+            case 'f': cp = '\f'; break;
+            case 'n': cp = '\n'; break;
+            case 'r': cp = '\r'; break;
+            case 't': cp = '\t'; break;
+            case 'u':
+                cp = hex4(p);
+                p += 4;
+                /* Surrogate pair; a lone half becomes U+FFFD */
+                if (cp >= 0xD800U && cp < 0xDC00U && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    unsigned lo = hex4(p + 2);
+                    if (lo >= 0xDC00U && lo < 0xE000U) {
+                        cp = 0x10000U + ((cp - 0xD800U) << 10) + (lo - 0xDC00U);
+                        p += 6;
+                    }
+                }
+                if (cp >= 0xD800U && cp < 0xE000U) {
+                    cp = 0xFFFDU;
+                }
+                break;
+            default:  cp = (unsigned char)e; break;   /* \" \\ \/ */
+        }
+        if (!put_utf8(out, cap, &n, cp)) {
+            return false;
+        }
+    }
+    out[n] = '\0';
+    return true;
+}
+
+bool json_scan_int(const char *js, const json_tok_t *tok, int *out) {
+    if (tok->type != JSON_TOK_NUMBER) {
+        return false;
+    }
+    char num[32];
+    size_t len = tok->len < sizeof(num) - 1 ? tok->len : sizeof(num) - 1;
+    memcpy(num, js + tok->start, len);
+    num[len] = '\0';
+    double v = strtod(num, NULL);
+    if (v >= (double)INT_MAX) {
+        *out = INT_MAX;
+    } else if (v <= (double)INT_MIN) {
+        *out = INT_MIN;
+    } else {
+        *out = (int)v;
+    }
+    return true;
+}
+
+bool json_scan_value_str(const char *js, const json_tok_t *tok, char *out, size_t cap) {
+    int v;
+    switch (tok->type) {
+        case JSON_TOK_TRUE:
+            return snprintf(out, cap, "true") < (int)cap;
+        case JSON_TOK_FALSE:
+            return snprintf(out, cap, "false") < (int)cap;
+        case JSON_TOK_STRING:
+            return json_scan_string(js, tok, out, cap);
+        case JSON_TOK_NUMBER:
+            json_scan_int(js, tok, &v);
+            return snprintf(out, cap, "%d", v) < (int)cap;
+        default:
+            return false;
+    }
+}
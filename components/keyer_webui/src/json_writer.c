@@ -0,0 +1,180 @@
+/**
+ * @file json_writer.c
+ * @brief Streaming JSON writer over a fixed buffer
+ */
+
+#include "json_writer.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+static void flush_buf(json_writer_t *w) {
+    if (w->ok && w->len > 0) {
+        w->ok = w->flush(w->ctx, w->buf, w->len);
+    }
+    w->len = 0;
+}
+
+static void put(json_writer_t *w, const char *s, size_t n) {
+    w->total += n;
+    while (n > 0 && w->ok) {
+        if (w->len == w->cap) {
+            flush_buf(w);
+            continue;
+        }
+        size_t room = w->cap - w->len;
+        size_t take = (n < room) ? n : room;
+        memcpy(w->buf + w->len, s, take);
+        w->len += take;
+        s += take;
+        n -= take;
+    }
+}
+
+static void put_char(json_writer_t *w, char c) {
+    put(w, &c, 1);
+}
+
+static void put_escaped(json_writer_t *w, const char *s) {
+    put_char(w, '"');
+    const char *run = s;
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20U && c != '"' && c != '\\') {
+            continue;
+        }
+        put(w, run, (size_t)(s - run));
+        char esc[8];
+        switch (c) {
+            case '"':  put(w, "\\\"", 2); break;
+            case '\\': put(w, "\\\\", 2); break;
+            case '\n': put(w, "\\n", 2); break;
+            case '\r': put(w, "\\r", 2); break;
+            case '\t': put(w, "\\t", 2); break;
+            default:
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                put(w, esc, 6);
+                break;
+        }
+        run = s + 1;
+    }
+    put(w, run, (size_t)(s - run));
+    put_char(w, '"');
+}
+
+/**
+ * @brief Comma and key before a value
+ */
+static void member(json_writer_t *w, const char *key) {
+    uint32_t bit = 1U << w->depth;
+    if (w->need_comma & bit) {
+        put_char(w, ',');
+    }
+    w->need_comma |= bit;
+    if (key != NULL) {
+        put_escaped(w, key);
+        put_char(w, ':');
+    }
+}
+
+static void container_open(json_writer_t *w, const char *key, char c) {
+    member(w, key);
+    put_char(w, c);
+    if (w->depth + 1U >= JSON_WRITER_MAX_DEPTH) {
+        w->ok = false;
+        return;
+    }
+    w->depth++;
+    w->need_comma &= ~(1U << w->depth);
+}
+
+static void container_close(json_writer_t *w, char c) {
+    if (w->depth == 0) {
+        w->ok = false;
+        return;
+    }
+    w->depth--;
+    put_char(w, c);
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap, json_flush_fn_t flush, void *ctx) {
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->total = 0;
+    w->flush = flush;
+    w->ctx = ctx;
+    w->need_comma = 0;
+    w->depth = 0;
+    w->ok = (cap > 0);
+}
+
+void json_object_begin(json_writer_t *w, const char *key) {
+    container_open(w, key, '{');
+}
+
+void json_object_end(json_writer_t *w) {
+    container_close(w, '}');
+}
+
+void json_array_begin(json_writer_t *w, const char *key) {
+    container_open(w, key, '[');
+}
+
+void json_array_end(json_writer_t *w) {
+    container_close(w, ']');
+}
+
+void json_string(json_writer_t *w, const char *key, const char *value) {
+    member(w, key);
+    if (value == NULL) {
+        put(w, "null", 4);
+    } else {
+        put_escaped(w, value);
+    }
+}
+
+void json_int(json_writer_t *w, const char *key, int64_t value) {
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%" PRId64, value);
+    member(w, key);
+    put(w, num, (size_t)n);
+}
+
+void json_uint(json_writer_t *w, const char *key, uint64_t value) {
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%" PRIu64, value);
+    member(w, key);
+    put(w, num, (size_t)n);
+}
+
+void json_double(json_writer_t *w, const char *key, double value) {
+    member(w, key);
+    if (!isfinite(value)) {
+        put(w, "null", 4);
+        return;
+    }
+    char num[32];
+    int n = snprintf(num, sizeof(num), "%.15g", value);
+    put(w, num, (size_t)n);
+}
+
+void json_bool(json_writer_t *w, const char *key, bool value) {
+    member(w, key);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_null(json_writer_t *w, const char *key) {
+    member(w, key);
+    put(w, "null", 4);
+}
+
+bool json_writer_finish(json_writer_t *w) {
+    flush_buf(w);
+    return w->ok && w->depth == 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file ws_delta.c
+ * @brief Change frames pushed to the web UI
+ */
+
+#include "ws_delta.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Closing "}}" of the set and the frame */
+#define FRAME_TAIL 2U
+
+static void open_frame(ws_delta_t *d) {
+    (*d->seq)++;
+    int n = snprintf(d->buf, sizeof(d->buf), "{\"type\":\"%s\",\"seq\":%lu,\"set\":{",
+                     d->type, (unsigned long)*d->seq);
+    d->len = (n > 0 && (size_t)n < sizeof(d->buf)) ? (size_t)n : 0U;
+    d->members = 0;
+}
+
+static void send_frame(ws_delta_t *d) {
+    d->buf[d->len++] = '}';
+    d->buf[d->len++] = '}';
+    d->buf[d->len] = '\0';
+    d->send(d->buf, d->len, d->ctx);
+    d->frames++;
+}
+
+/** Append "key":value to the open frame, if it fits */
+static bool append(ws_delta_t *d, const char *key, const char *value) {
+    size_t key_len = strlen(key);
+    size_t value_len = strlen(value);
+    size_t need = (d->members > 0 ? 1U : 0U) + key_len + 3U + value_len;
+
+    if (d->len + need + FRAME_TAIL > WS_DELTA_FRAME_MAX) {
+        return false;
+    }
+    char *p = d->buf + d->len;
+    if (d->members > 0) {
+        *p++ = ',';
+    }
+    *p++ = '"';
+    memcpy(p, key, key_len);
+    p += key_len;
+    *p++ = '"';
+    *p++ = ':';
+    memcpy(p, value, value_len);
+    d->len += need;
+    d->members++;
+    return true;
+}
+
+void ws_delta_begin(ws_delta_t *d, const char *type, uint32_t *seq,
+                    ws_delta_send_fn send, void *ctx) {
+    d->len = 0;
+    d->members = 0;
+    d->type = type;
+    d->seq = seq;
+    d->send = send;
+    d->ctx = ctx;
+    d->frames = 0;
+    d->dropped = 0;
+}
+
+void ws_delta_put(ws_delta_t *d, const char *key, const char *value) {
+    if (d->len == 0) {
+        open_frame(d);
+    }
+    if (append(d, key, value)) {
+        return;
+    }
+    if (d->members > 0) {
+        /* Full: send it and carry on in a new frame */
+        send_frame(d);
+        open_frame(d);
+        if (append(d, key, value)) {
+            return;
+        }
+    }
+    d->dropped++;
+}
+
+unsigned ws_delta_end(ws_delta_t *d) {
+    if (d->members > 0) {
+        send_frame(d);
+    } else if (d->len > 0) {
+        /* The number was taken but not sent: give it back, or it looks lost */
+        (*d->seq)--;
+    }
+    d->len = 0;
+    d->members = 0;
+    return d->frames;
+}
+
+size_t ws_delta_json_string(char *out, size_t cap, const char *s) {
+    static const char HEX[] = "0123456789abcdef";
+    size_t n = 0;
+
+    if (cap < 3U) {
+        if (cap > 0) {
+            out[0] = '\0';
+        }
+        return 0;
+    }
+    out[n++] = '"';
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        size_t need = (c == '"' || c == '\\') ? 2U : (c < 0x20U) ? 6U : 1U;
+        if (n + need + 2U > cap) {
+            out[0] = '\0';
+            return 0;
+        }
+        if (need == 2U) {
+            out[n++] = '\\';
+            out[n++] = (char)c;
+        } else if (need == 6U) {
+            memcpy(out + n, "\\u00", 4);
+            out[n + 4] = HEX[c >> 4];
+            out[n + 5] = HEX[c & 0x0FU];
+            n += 6;
+        } else {
+            out[n++] = (char)c;
+        }
+    }
+    out[n++] = '"';
+    out[n] = '\0';
+    return n;
+}
+
+uint32_t ws_delta_sig(const char *value) {
+    uint32_t h = 2166136261U;
+    for (; *value != '\0'; value++) {
+        h ^= (unsigned char)*value;
+        h *= 16777619U;
+    }
+    return h;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file ws_log.c
+ * @brief Log subscription frames for WebSocket clients
+ */
+
+#include "ws_log.h"
+#include "json_writer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *const SOURCE_TAGS[WS_LOG_SOURCES] = {"RT", "BG"};
+
+static const char FRAME_HEAD[] = "{\"type\":\"log\",\"entries\":[";
+static const char FRAME_TAIL[] = "]}";
+
+ws_log_filter_t ws_log_filter_make(unsigned rt_level, unsigned bg_level) {
+    return WS_LOG_FILTER_ON | (rt_level & 7U) | ((bg_level & 7U) << 4);
+}
+
+bool ws_log_parse_level(const char *name, unsigned *level) {
+    static const char *const NAMES[] = {"ERROR", "WARN", "INFO", "DEBUG", "TRACE"};
+    for (unsigned i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); i++) {
+        if (strcmp(name, NAMES[i]) == 0) {
+            *level = i;
+            return true;
+        }
+    }
+    if (strcmp(name, "OFF") == 0) {
+        *level = WS_LOG_LEVEL_OFF;
+        return true;
+    }
+    return false;
+}
+
+void ws_log_cursor_init(ws_log_cursor_t *c, const log_stream_t *rt,
+                        const log_stream_t *bg, ws_log_filter_t filter) {
+    const log_stream_t *streams[WS_LOG_SOURCES] = {rt, bg};
+    memset(c, 0, sizeof(*c));
+    for (int s = 0; s < WS_LOG_SOURCES; s++) {
+        unsigned level = (filter >> (4 * s)) & 7U;
+        ws_log_source_t *src = &c->src[s];
+        src->muted = (level > LOG_LEVEL_TRACE);
+        log_reader_init(&src->reader, streams[s],
+                        src->muted ? LOG_LEVEL_ERROR : (log_level_t)level);
+    }
+}
+
+/**
+ * @brief Read ahead one record, collecting what the reader lost
+ */
+static void source_fill(ws_log_source_t *src) {
+    if (src->pending || src->muted) {
+        return;
+    }
+    src->pending = log_reader_next(&src->reader, &src->entry);
+    uint32_t dropped = log_reader_dropped(&src->reader);
+    if (dropped > 0) {
+        src->lost += dropped;
+        log_reader_reset_dropped(&src->reader);
+    }
+}
+
+/**
+ * @brief Oldest pending record of all streams
+ */
+static int source_next(ws_log_cursor_t *c) {
+    int best = -1;
+    for (int s = 0; s < WS_LOG_SOURCES; s++) {
+        source_fill(&c->src[s]);
+        if (c->src[s].pending &&
+            (best < 0 || c->src[s].entry.timestamp_us < c->src[best].entry.timestamp_us)) {
+            best = s;
+        }
+    }
+    return best;
+}
+
+static bool overflow(void *ctx, const char *data, size_t len) {
+    (void)ctx;
+    (void)data;
+    (void)len;
+    return false;
+}
+
+/**
+ * @brief Append [ts,"tag","LEVEL","msg"] if it fits before the tail
+ */
+static bool put_entry(char *out, size_t cap, size_t *len, bool first, int64_t ts,
+                      const char *tag, log_level_t level, const char *msg) {
+    size_t sep = first ? 0U : 1U;
+    size_t used = *len + sep + sizeof(FRAME_TAIL) - 1U;
+    if (used >= cap) {
+        return false;
+    }
+
+    json_writer_t w;
+    size_t room = cap - used;
+    json_writer_init(&w, out + *len + sep, room, overflow, NULL);
+    json_array_begin(&w, NULL);
+    json_int(&w, NULL, ts);
+    json_string(&w, NULL, tag);
+    json_string(&w, NULL, log_level_str(level));
+    json_string(&w, NULL, msg);
+    json_array_end(&w);
+    if (!w.ok || w.total > room) {
+        return false;
+    }
+    if (!first) {
+        out[*len] = ',';
+    }
+    *len += sep + w.total;
+    return true;
+}
+
+size_t ws_log_batch(ws_log_cursor_t *c, char *out, size_t cap) {
+    size_t len = sizeof(FRAME_HEAD) - 1U;
+    bool first = true;
+    char msg[LOG_MAX_MSG_LEN];
+
+    if (cap < len + sizeof(FRAME_TAIL)) {
+        return 0;
+    }
+    memcpy(out, FRAME_HEAD, len);
+
+    int s;
+    while ((s = source_next(c)) >= 0) {
+        ws_log_source_t *src = &c->src[s];
+        const log_entry_t *e = &src->entry;
+
+        if (src->lost > 0) {
+            snprintf(msg, sizeof(msg), "%u records dropped", (unsigned)src->lost);
+            if (!put_entry(out, cap, &len, first, e->timestamp_us, SOURCE_TAGS[s],
+                           LOG_LEVEL_WARN, msg)) {
+                break;
+            }
+            src->lost = 0;
+            first = false;
+        }
+
+        int n = log_entry_format(e, msg, sizeof(msg));
+        size_t keep = (n < 0) ? 0U : ((size_t)n < sizeof(msg)) ? (size_t)n : sizeof(msg) - 1U;
+        msg[keep] = '\0';
+        bool put;
+        for (;;) {
+            put = put_entry(out, cap, &len, first, e->timestamp_us, SOURCE_TAGS[s],
+                            e->level, msg);
+            if (put || !first || keep == 0) {
+                break;
+            }
+            /* Alone in the frame and still too long: cut it */
+            keep /= 2U;
+            msg[keep] = '\0';
+        }
+        if (!put) {
+            break;
+        }
+        src->pending = false;
+        first = false;
+    }
+
+    if (first) {
+        return 0;
+    }
+    memcpy(out + len, FRAME_TAIL, sizeof(FRAME_TAIL) - 1U);
+    return len + sizeof(FRAME_TAIL) - 1U;
+}
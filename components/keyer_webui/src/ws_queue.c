@@ -0,0 +1,145 @@
+/**
+ * @file ws_queue.c
+ * @brief Per-client WebSocket send queue
+ */
+
+#include "ws_queue.h"
+#include <string.h>
+
+#define WS_QUEUE_MASK (WS_QUEUE_SLOTS - 1U)
+
+_Static_assert((WS_QUEUE_SLOTS & WS_QUEUE_MASK) == 0, "WS_QUEUE_SLOTS must be power of 2");
+
+static void fill_msg(ws_msg_t *m, ws_msg_kind_t kind, bool binary,
+                     const uint8_t *data, size_t len) {
+    m->kind = (uint8_t)kind;
+    m->binary = binary;
+    m->len = (uint16_t)len;
+    memcpy(m->data, data, len);
+}
+
+void ws_queue_init(ws_queue_t *q) {
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->latest_seq, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->latest_sent, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->scheduled, false, memory_order_relaxed);
+    for (int i = 0; i < WS_MSG_KIND_COUNT; i++) {
+        atomic_store_explicit(&q->dropped[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&q->coalesced, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->sent, 0, memory_order_release);
+}
+
+static bool push_mailbox(ws_queue_t *q, const uint8_t *data, size_t len, bool binary) {
+    unsigned seq = atomic_load_explicit(&q->latest_seq, memory_order_relaxed);
+
+    /* Consumer has not taken the previous value yet: it is replaced */
+    if (seq != atomic_load_explicit(&q->latest_sent, memory_order_acquire)) {
+        atomic_fetch_add_explicit(&q->coalesced, 1, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&q->latest_seq, seq + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    fill_msg(&q->latest, WS_MSG_PATTERN, binary, data, len);
+    atomic_store_explicit(&q->latest_seq, seq + 2U, memory_order_release);
+    return true;
+}
+
+bool ws_queue_push(ws_queue_t *q, ws_msg_kind_t kind, bool binary,
+                   const uint8_t *data, size_t len) {
+    if (len > WS_QUEUE_MSG_MAX || (unsigned)kind >= WS_MSG_KIND_COUNT) {
+        return false;
+    }
+
+    if (kind == WS_MSG_PATTERN) {
+        return push_mailbox(q, data, len, binary);
+    }
+
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+    if (head - tail >= WS_QUEUE_SLOTS) {
+        if (kind != WS_MSG_TIMELINE) {
+            atomic_fetch_add_explicit(&q->dropped[kind], 1, memory_order_relaxed);
+            return false;
+        }
+        /* Drop oldest; if the CAS fails the consumer just freed a slot */
+        if (atomic_compare_exchange_strong_explicit(&q->tail, &tail, tail + 1U,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            ws_msg_t *old = &q->slots[tail & WS_QUEUE_MASK];
+            unsigned old_kind = (old->kind < WS_MSG_KIND_COUNT) ? old->kind : WS_MSG_TIMELINE;
+            atomic_fetch_add_explicit(&q->dropped[old_kind], 1, memory_order_relaxed);
+        }
+    }
+
+    fill_msg(&q->slots[head & WS_QUEUE_MASK], kind, binary, data, len);
+    atomic_store_explicit(&q->head, head + 1U, memory_order_release);
+    return true;
+}
+
+bool ws_queue_schedule(ws_queue_t *q) {
+    bool expected = false;
+    return atomic_compare_exchange_strong_explicit(&q->scheduled, &expected, true,
+                                                   memory_order_acq_rel,
+                                                   memory_order_acquire);
+}
+
+static bool pop_mailbox(ws_queue_t *q, ws_msg_t *out) {
+    unsigned seq = atomic_load_explicit(&q->latest_seq, memory_order_acquire);
+    if (seq == atomic_load_explicit(&q->latest_sent, memory_order_relaxed) ||
+        (seq & 1U) != 0) {
+        return false;
+    }
+
+    *out = q->latest;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&q->latest_seq, memory_order_relaxed) != seq) {
+        return false;   /* Torn: the writer's own schedule brings us back */
+    }
+
+    atomic_store_explicit(&q->latest_sent, seq, memory_order_release);
+    return true;
+}
+
+bool ws_queue_pop(ws_queue_t *q, ws_msg_t *out) {
+    for (;;) {
+        unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail == head) {
+            break;
+        }
+
+        *out = q->slots[tail & WS_QUEUE_MASK];
+        if (atomic_compare_exchange_strong_explicit(&q->tail, &tail, tail + 1U,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            atomic_fetch_add_explicit(&q->sent, 1, memory_order_relaxed);
+            return true;
+        }
+        /* Producer dropped it under us: copy may be torn, take the next */
+    }
+
+    if (pop_mailbox(q, out)) {
+        atomic_fetch_add_explicit(&q->sent, 1, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+static bool has_pending(const ws_queue_t *q) {
+    unsigned seq = atomic_load_explicit(&q->latest_seq, memory_order_acquire);
+    return ws_queue_len(q) != 0 ||
+           seq != atomic_load_explicit(&q->latest_sent, memory_order_relaxed);
+}
+
+bool ws_queue_worker_done(ws_queue_t *q) {
+    atomic_store_explicit(&q->scheduled, false, memory_order_seq_cst);
+
+    /* A producer that saw us busy skipped scheduling: pick its message up */
+    if (has_pending(q)) {
+        return ws_queue_schedule(q);
+    }
+    return false;
+}
@@ -4,46 +4,147 @@
  *
  * Handles WebSocket connections and broadcasts events to all clients.
  * Uses httpd_queue_work() for async sending from bg_task context.
+ * Decoder events are JSON text frames; key edges go out as batched
+ * binary timeline frames (ws_timeline.h).
+ *
+ * Every client has its own bounded send queue (ws_queue.h): a stalled
+ * browser loses its own oldest timeline frames or newest decoder text,
+ * counted per client, and never delays the other clients.
+ *
+ * A client can also subscribe to the log streams (ws_log.h). The UI push
+ * service drains its cursor only while the client's queue has room, so a
+ * slow viewer loses log records (reported as a summary line), never
+ * keying data or the other clients' logs.
+ *
+ * Config and status changes are pushed as delta frames (ws_state.c), so
+ * an open page does not poll /api/config or /api/status.
+ *
+ * Every message belongs to a topic (ws_topic.h). A client gets only the
+ * topics it subscribed to, and the producers look at the union of all
+ * sets (ws_topic_active()) before doing any work for one.
+ *
+ * A client can also open a console terminal (ws_console): a session of
+ * the command console from a small pool, answered inline.
  */
 
 #include "ws_server.h"
+#include "ws_queue.h"
+#include "ws_log.h"
+#include "ws_topic.h"
+#include "ws_delta.h"
+#include "console.h"
+#include "cdc_batch.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "json_scan.h"
+#include "config_console.h"
+#include "text_keyer.h"
+#include "text_memory.h"
+#include "key_stats.h"
+#include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 
 static const char *TAG = "ws_server";
 
 /**
  * @brief WebSocket client tracking
+ *
+ * register/unregister run in the httpd task; bg_task only reads active
+ * and topics and pushes into the client's queue.
  */
 typedef struct {
-    int fd;      /**< Socket file descriptor (-1 if unused) */
-    bool active; /**< Connection active flag */
+    int fd;                 /**< Socket file descriptor (-1 if unused) */
+    atomic_bool active;     /**< Connection active flag */
+    bool warned;            /**< Overflow logged since the queue last drained */
+    atomic_uint topics;     /**< Subscribed topics (WS_TOPIC_BIT set) */
+    atomic_uint log_sub;    /**< Log subscription, 0 if none (generation << 8 | filter) */
+    ws_queue_t queue;       /**< Outgoing messages (ws_queue.h) */
 } ws_client_t;
 
-static ws_client_t s_clients[WS_MAX_CLIENTS];
+/* ~2.3 KB of queue per client: keep it out of internal RAM */
+static EXT_RAM_BSS_ATTR ws_client_t s_clients[WS_MAX_CLIENTS];
 static httpd_handle_t s_httpd_handle = NULL;
 
+/* Messages sent per worker run before yielding to other clients */
+#define WS_SEND_BURST 4
+
+/* Longest command frame, NUL included */
+#define WS_CMD_MAX 256
+
+/* Log frames per client per push, and queue slots they always leave free */
+#define WS_LOG_FRAMES 2
+#define WS_LOG_RESERVE 3
+
+/* Log cursors, owned by the UI push service (ws_push_logs) */
+static EXT_RAM_BSS_ATTR ws_log_cursor_t s_log_cursors[WS_MAX_CLIENTS];
+static unsigned s_log_seen[WS_MAX_CLIENTS];
+static unsigned s_log_generation;   /* httpd task only */
+
+/* Union of the active clients' topics, and a count of topic joins; both
+ * written by the httpd task only */
+static atomic_uint s_topic_mask;
+static atomic_uint s_topic_joins;
+
+/* Console terminals open at once (each ~0.6 KB) */
+#define WS_CONSOLE_MAX 2
+
 /**
- * @brief Async message structure for httpd_queue_work
+ * @brief Console terminal of one client (httpd task only)
  */
 typedef struct {
-    httpd_handle_t hd;
-    int fd;
-    char message[256];
-} ws_async_msg_t;
+    int fd;                     /**< Owning client, -1 if free */
+    httpd_req_t *req;           /**< Frame being answered while input runs */
+    cdc_batch_t out;
+    console_session_t session;
+} ws_console_t;
 
-/* Pre-allocated message pool to avoid malloc in hot path */
-static ws_async_msg_t s_msg_pool[WS_MAX_CLIENTS];
-static uint8_t s_msg_pool_idx = 0;
+static EXT_RAM_BSS_ATTR ws_console_t s_consoles[WS_CONSOLE_MAX];
+
+static bool ws_client_is_active(const ws_client_t *c) {
+    return atomic_load_explicit(&c->active, memory_order_acquire);
+}
+
+/**
+ * @brief Recompute the union of the topics (httpd task)
+ */
+static void ws_topics_update(void) {
+    unsigned mask = 0;
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_client_is_active(&s_clients[i])) {
+            mask |= atomic_load_explicit(&s_clients[i].topics, memory_order_relaxed);
+        }
+    }
+    atomic_store_explicit(&s_topic_mask, mask, memory_order_release);
+}
+
+/**
+ * @brief Replace a client's topics (httpd task)
+ */
+static void ws_client_set_topics(ws_client_t *c, unsigned topics) {
+    unsigned old = atomic_exchange_explicit(&c->topics, topics, memory_order_relaxed);
+    if ((topics & ~old) != 0) {
+        atomic_fetch_add_explicit(&s_topic_joins, 1U, memory_order_relaxed);
+    }
+    ws_topics_update();
+}
 
 /**
  * @brief Register a new WebSocket client
  */
 static void ws_client_register(int fd) {
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
-        if (!s_clients[i].active) {
-            s_clients[i].fd = fd;
-            s_clients[i].active = true;
+        ws_client_t *c = &s_clients[i];
+        if (!ws_client_is_active(c)) {
+            ws_queue_init(&c->queue);
+            c->fd = fd;
+            c->warned = false;
+            atomic_store_explicit(&c->topics, 0, memory_order_relaxed);
+            atomic_store_explicit(&c->log_sub, 0, memory_order_relaxed);
+            atomic_store_explicit(&c->active, true, memory_order_release);
+            ws_client_set_topics(c, WS_TOPICS_DEFAULT);
             ESP_LOGI(TAG, "Client registered: slot=%d fd=%d", i, fd);
             return;
         }
@@ -56,21 +157,46 @@ static void ws_client_register(int fd) {
  */
 static void ws_client_unregister(int fd) {
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
-        if (s_clients[i].active && s_clients[i].fd == fd) {
-            s_clients[i].active = false;
-            s_clients[i].fd = -1;
-            ESP_LOGI(TAG, "Client unregistered: slot=%d fd=%d", i, fd);
+        ws_client_t *c = &s_clients[i];
+        if (ws_client_is_active(c) && c->fd == fd) {
+            atomic_store_explicit(&c->active, false, memory_order_release);
+            c->fd = -1;
+            ws_topics_update();
+            for (int k = 0; k < WS_CONSOLE_MAX; k++) {
+                if (s_consoles[k].fd == fd) {
+                    console_session_close(&s_consoles[k].session);
+                    s_consoles[k].fd = -1;
+                }
+            }
+            ESP_LOGI(TAG, "Client unregistered: slot=%d fd=%d sent=%u dropped=%u/%u coalesced=%u",
+                     i, fd,
+                     atomic_load_explicit(&c->queue.sent, memory_order_relaxed),
+                     atomic_load_explicit(&c->queue.dropped[WS_MSG_TIMELINE], memory_order_relaxed),
+                     atomic_load_explicit(&c->queue.dropped[WS_MSG_DECODED], memory_order_relaxed),
+                     atomic_load_explicit(&c->queue.coalesced, memory_order_relaxed));
             return;
         }
     }
 }
 
+/**
+ * @brief Active client on a socket, NULL if none
+ */
+static ws_client_t *ws_client_find(int fd) {
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_client_is_active(&s_clients[i]) && s_clients[i].fd == fd) {
+            return &s_clients[i];
+        }
+    }
+    return NULL;
+}
+
 /**
  * @brief Check if a client is already registered
  */
 static bool ws_client_is_registered(int fd) {
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
-        if (s_clients[i].active && s_clients[i].fd == fd) {
+        if (ws_client_is_active(&s_clients[i]) && s_clients[i].fd == fd) {
             return true;
         }
     }
@@ -79,22 +205,48 @@ static bool ws_client_is_registered(int fd) {
 
 /**
  * @brief Async send worker (runs in httpd context)
+ *
+ * At most one per client is queued or running (ws_queue_schedule). It
+ * drains a burst, then requeues itself so one slow client cannot hog
+ * the httpd task.
  */
 static void ws_async_send_worker(void *arg) {
-    ws_async_msg_t *msg = (ws_async_msg_t *)arg;
+    ws_client_t *c = (ws_client_t *)arg;
+    static ws_msg_t s_msg;  /* httpd runs workers one at a time */
 
-    httpd_ws_frame_t ws_pkt;
-    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
-    ws_pkt.payload = (uint8_t *)msg->message;
-    ws_pkt.len = strlen(msg->message);
-    ws_pkt.type = HTTPD_WS_TYPE_TEXT;
-    ws_pkt.final = true;
+    for (int n = 0; n < WS_SEND_BURST; n++) {
+        if (!ws_client_is_active(c)) {
+            atomic_store_explicit(&c->queue.scheduled, false, memory_order_release);
+            return;
+        }
+        if (!ws_queue_pop(&c->queue, &s_msg)) {
+            break;
+        }
 
-    esp_err_t ret = httpd_ws_send_frame_async(msg->hd, msg->fd, &ws_pkt);
-    if (ret != ESP_OK) {
-        /* Client disconnected - mark inactive */
-        ESP_LOGD(TAG, "Send failed fd=%d: %s", msg->fd, esp_err_to_name(ret));
-        ws_client_unregister(msg->fd);
+        httpd_ws_frame_t ws_pkt;
+        memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+        ws_pkt.payload = s_msg.data;
+        ws_pkt.len = s_msg.len;
+        ws_pkt.type = s_msg.binary ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT;
+        ws_pkt.final = true;
+
+        esp_err_t ret = httpd_ws_send_frame_async(s_httpd_handle, c->fd, &ws_pkt);
+        if (ret != ESP_OK) {
+            /* Client disconnected - mark inactive */
+            ESP_LOGD(TAG, "Send failed fd=%d: %s", c->fd, esp_err_to_name(ret));
+            ws_client_unregister(c->fd);
+            atomic_store_explicit(&c->queue.scheduled, false, memory_order_release);
+            return;
+        }
+    }
+
+    if (ws_queue_len(&c->queue) == 0) {
+        c->warned = false;
+    }
+    if (ws_queue_worker_done(&c->queue)) {
+        if (httpd_queue_work(s_httpd_handle, ws_async_send_worker, c) != ESP_OK) {
+            atomic_store_explicit(&c->queue.scheduled, false, memory_order_release);
+        }
     }
 }
 
@@ -102,6 +254,11 @@ void ws_server_init(void) {
     memset(s_clients, 0, sizeof(s_clients));
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
         s_clients[i].fd = -1;
+        atomic_init(&s_clients[i].active, false);
+        ws_queue_init(&s_clients[i].queue);
+    }
+    for (int i = 0; i < WS_CONSOLE_MAX; i++) {
+        s_consoles[i].fd = -1;
     }
     ESP_LOGI(TAG, "WebSocket server initialized (max %d clients)", WS_MAX_CLIENTS);
 }
@@ -110,6 +267,412 @@ void ws_server_set_httpd_handle(httpd_handle_t handle) {
     s_httpd_handle = handle;
 }
 
+void ws_server_session_closed(int fd) {
+    ws_client_unregister(fd);
+}
+
+/**
+ * @brief Format the text keyer state as a text_status message
+ *
+ * Output: {"type":"text_status","ok":true,"state":"SENDING","sent":3,"total":12,
+ *          "progress":25,"queued":5,"free":507,"removed":0[,"id":7]}
+ *
+ * @param id Client request id to echo, negative for pushed updates
+ */
+static int ws_format_text_status(char *json, size_t cap, bool ok, size_t removed, int id) {
+    static const char *const STATES[] = {"IDLE", "SENDING", "PAUSED"};
+    text_keyer_state_t state = text_keyer_get_state();
+    size_t sent = 0, total = 0;
+    text_keyer_get_progress(&sent, &total);
+    text_keyer_buffer_t buffer;
+    text_keyer_get_buffer(&buffer);
+
+    int len = snprintf(json, cap,
+                       "{\"type\":\"text_status\",\"ok\":%s,\"state\":\"%s\","
+                       "\"sent\":%u,\"total\":%u,\"progress\":%u,"
+                       "\"queued\":%u,\"free\":%u,\"removed\":%u",
+                       ok ? "true" : "false",
+                       ((unsigned)state < 3U) ? STATES[state] : "UNKNOWN",
+                       (unsigned)sent, (unsigned)total,
+                       (unsigned)((total > 0) ? (sent * 100U) / total : 0U),
+                       (unsigned)buffer.queued, (unsigned)buffer.free, (unsigned)removed);
+    if (id >= 0) {
+        len += snprintf(json + len, cap - (size_t)len, ",\"id\":%d", id);
+    }
+    len += snprintf(json + len, cap - (size_t)len, "}");
+    return len;
+}
+
+static esp_err_t ws_reply(httpd_req_t *req, const char *json, int len) {
+    httpd_ws_frame_t ws_pkt;
+    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+    ws_pkt.payload = (uint8_t *)json;
+    ws_pkt.len = (size_t)len;
+    ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+    ws_pkt.final = true;
+    return httpd_ws_send_frame(req, &ws_pkt);
+}
+
+static esp_err_t ws_send_text_status(httpd_req_t *req, bool ok, size_t removed, int id) {
+    char json[192];
+    return ws_reply(req, json, ws_format_text_status(json, sizeof(json), ok, removed, id));
+}
+
+/**
+ * @brief Play a memory slot (same checks as POST /api/text/play)
+ */
+static bool ws_play_memory(const char *js, const json_tok_t *toks) {
+    int slot;
+    int idx = json_scan_get(js, toks, 0, "slot");
+    if (idx < 0 || !json_scan_int(js, &toks[idx], &slot) ||
+        slot < 0 || slot >= TEXT_MEMORY_SLOTS) {
+        return false;
+    }
+    return text_keyer_send_memory((uint8_t)slot) == 0;
+}
+
+/**
+ * @brief Set one parameter (same rules as POST /api/parameter)
+ *
+ * Reply: {"type":"param","param":"keyer.wpm","ok":true[,"error":"..."][,"id":7]}
+ */
+static esp_err_t ws_set_param(httpd_req_t *req, const char *js, const json_tok_t *toks, int id) {
+    char name[64] = "";
+    char value[64];
+    const char *error = NULL;
+
+    int param_idx = json_scan_get(js, toks, 0, "param");
+    int value_idx = json_scan_get(js, toks, 0, "value");
+    if (param_idx < 0 || value_idx < 0 ||
+        !json_scan_string(js, &toks[param_idx], name, sizeof(name)) ||
+        !json_scan_value_str(js, &toks[value_idx], value, sizeof(value))) {
+        error = "missing param or value";
+    } else {
+        switch (config_set_param_str(name, value)) {
+            case 0:  ESP_LOGI(TAG, "Set %s = %s", name, value); break;
+            case -1: error = "parameter not found"; break;
+            case -2: error = "invalid value format"; break;
+            case -4: error = "value out of range"; break;
+            default: error = "rejected"; break;
+        }
+    }
+
+    /* The name is echoed as is: drop it if it would need escaping */
+    for (const char *c = name; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\' || (unsigned char)*c < 0x20) {
+            name[0] = '\0';
+            break;
+        }
+    }
+
+    char json[160];
+    int len = snprintf(json, sizeof(json), "{\"type\":\"param\",\"param\":\"%s\",\"ok\":%s",
+                       name, (error == NULL) ? "true" : "false");
+    if (error != NULL) {
+        len += snprintf(json + len, sizeof(json) - (size_t)len, ",\"error\":\"%s\"", error);
+    }
+    if (id >= 0) {
+        len += snprintf(json + len, sizeof(json) - (size_t)len, ",\"id\":%d", id);
+    }
+    len += snprintf(json + len, sizeof(json) - (size_t)len, "}");
+    return ws_reply(req, json, len);
+}
+
+/**
+ * @brief Level of one stream: its entry in "tags", else the global level
+ */
+static bool ws_log_level(const char *js, const json_tok_t *toks, int tags, const char *tag,
+                         unsigned global, unsigned *level) {
+    char name[8];
+    int idx = json_scan_get(js, toks, tags, tag);
+    if (idx < 0) {
+        *level = global;
+        return true;
+    }
+    return json_scan_string(js, &toks[idx], name, sizeof(name)) &&
+           ws_log_parse_level(name, level);
+}
+
+/**
+ * @brief Set a client's log filter and its logs topic (httpd task)
+ *
+ * Both levels WS_LOG_LEVEL_OFF end the subscription.
+ */
+static void ws_client_set_log(ws_client_t *c, unsigned rt, unsigned bg) {
+    unsigned sub = 0;
+    if (rt != WS_LOG_LEVEL_OFF || bg != WS_LOG_LEVEL_OFF) {
+        s_log_generation = (s_log_generation + 1U) & 0xFFFFFFU;
+        sub = (s_log_generation << 8) | ws_log_filter_make(rt, bg);
+    }
+    atomic_store_explicit(&c->log_sub, sub, memory_order_release);
+
+    unsigned topics = atomic_load_explicit(&c->topics, memory_order_relaxed) &
+                      ~WS_TOPIC_BIT(WS_TOPIC_LOGS);
+    ws_client_set_topics(c, (sub != 0) ? (topics | WS_TOPIC_BIT(WS_TOPIC_LOGS)) : topics);
+}
+
+/**
+ * @brief Subscribe the sending client to the log streams, or unsubscribe
+ *
+ * {"type":"log","level":"DEBUG","tags":{"RT":"WARN"}}; level "OFF" ends
+ * the subscription. Every (re)subscription starts at the oldest record
+ * still held, so a viewer that changes its filter gets the history again.
+ * Reply: {"type":"log_sub","ok":true[,"id":7]}
+ */
+static esp_err_t ws_log_subscribe(httpd_req_t *req, const char *js, const json_tok_t *toks,
+                                  int id) {
+    char name[8] = "INFO";
+    unsigned global = LOG_LEVEL_INFO;
+    unsigned rt = 0;
+    unsigned bg = 0;
+    int level_idx = json_scan_get(js, toks, 0, "level");
+    int tags = json_scan_get(js, toks, 0, "tags");
+
+    bool ok = (level_idx < 0 || json_scan_string(js, &toks[level_idx], name, sizeof(name))) &&
+              ws_log_parse_level(name, &global) &&
+              ws_log_level(js, toks, tags, "RT", global, &rt) &&
+              ws_log_level(js, toks, tags, "BG", global, &bg);
+
+    ws_client_t *c = ws_client_find(httpd_req_to_sockfd(req));
+    if (ok && c != NULL) {
+        ws_client_set_log(c, rt, bg);
+    }
+
+    char json[48];
+    int len = snprintf(json, sizeof(json), "{\"type\":\"log_sub\",\"ok\":%s",
+                       ok ? "true" : "false");
+    if (id >= 0) {
+        len += snprintf(json + len, sizeof(json) - (size_t)len, ",\"id\":%d", id);
+    }
+    len += snprintf(json + len, sizeof(json) - (size_t)len, "}");
+    return ws_reply(req, json, len);
+}
+
+/**
+ * @brief Replace the sending client's topics (ws_topic.h)
+ *
+ * {"type":"subscribe","topics":["decoder","text"]}. "logs" keeps the
+ * client's log filter, or starts one at INFO; leaving it out ends the
+ * log subscription. The reply lists the topics taken, so a page can
+ * tell which ones this firmware knows:
+ * {"type":"subscribed","ok":true,"topics":["decoder","text"][,"id":7]}
+ */
+static esp_err_t ws_subscribe(httpd_req_t *req, const char *js, const json_tok_t *toks, int id) {
+    unsigned topics = 0;
+    bool ok = ws_topic_mask_parse(js, toks, json_scan_get(js, toks, 0, "topics"), &topics);
+
+    ws_client_t *c = ws_client_find(httpd_req_to_sockfd(req));
+    if (ok && c != NULL) {
+        bool logs = (topics & WS_TOPIC_BIT(WS_TOPIC_LOGS)) != 0;
+        bool had_logs = atomic_load_explicit(&c->log_sub, memory_order_relaxed) != 0;
+        ws_client_set_topics(c, topics & ~WS_TOPIC_BIT(WS_TOPIC_LOGS));
+        if (logs && had_logs) {
+            ws_client_set_topics(c, topics);
+        } else if (logs || had_logs) {
+            ws_client_set_log(c, logs ? LOG_LEVEL_INFO : WS_LOG_LEVEL_OFF,
+                              logs ? LOG_LEVEL_INFO : WS_LOG_LEVEL_OFF);
+        }
+    }
+
+    char json[128];
+    int len = snprintf(json, sizeof(json), "{\"type\":\"subscribed\",\"ok\":%s,\"topics\":[",
+                       ok ? "true" : "false");
+    bool first = true;
+    for (unsigned t = 0; ok && t < WS_TOPIC_COUNT; t++) {
+        if ((topics & WS_TOPIC_BIT(t)) != 0) {
+            len += snprintf(json + len, sizeof(json) - (size_t)len, "%s\"%s\"",
+                            first ? "" : ",", ws_topic_name((ws_topic_t)t));
+            first = false;
+        }
+    }
+    len += snprintf(json + len, sizeof(json) - (size_t)len, "]");
+    if (id >= 0) {
+        len += snprintf(json + len, sizeof(json) - (size_t)len, ",\"id\":%d", id);
+    }
+    len += snprintf(json + len, sizeof(json) - (size_t)len, "}");
+    return ws_reply(req, json, len);
+}
+
+/**
+ * @brief cdc_batch port: one console frame per coalesced packet
+ *
+ * Sent inline on the request socket like every reply; a frame the
+ * socket refuses is dropped.
+ */
+static size_t ws_console_port_write(void *ctx, const uint8_t *data, size_t len) {
+    ws_console_t *con = (ws_console_t *)ctx;
+    static char s_text[CDC_BATCH_SIZE + 1];
+    static char s_frame[CDC_BATCH_SIZE * 6U + 32U];   /* Every byte \u00XX at worst */
+
+    if (con->req == NULL) {
+        return 0;
+    }
+    memcpy(s_text, data, len);
+    s_text[len] = '\0';
+    int n = snprintf(s_frame, sizeof(s_frame), "{\"type\":\"console\",\"data\":");
+    size_t q = ws_delta_json_string(s_frame + n, sizeof(s_frame) - (size_t)n - 1U, s_text);
+    if (q == 0) {
+        return 0;
+    }
+    n += (int)q;
+    s_frame[n++] = '}';
+    return (ws_reply(con->req, s_frame, n) == ESP_OK) ? len : 0;
+}
+
+static void ws_console_port_flush(void *ctx) {
+    (void)ctx;
+}
+
+/** Console session sink */
+static void ws_console_write(void *ctx, const char *data, size_t len) {
+    ws_console_t *con = (ws_console_t *)ctx;
+    cdc_batch_put(&con->out, data, len, esp_timer_get_time());
+}
+
+static void ws_console_flush(void *ctx) {
+    ws_console_t *con = (ws_console_t *)ctx;
+    cdc_batch_flush(&con->out);
+}
+
+/**
+ * @brief Terminal input for the sending client's console session
+ *
+ * {"type":"console","data":"show wpm\r"}: keystrokes, echoed like a
+ * telnet session. Output comes back as {"type":"console","data":"..."}
+ * frames before the next message is read. The first message opens the
+ * session (data may be empty) and gets the prompt; with every terminal
+ * taken the answer is {"type":"console","ok":false}.
+ */
+static esp_err_t ws_console(httpd_req_t *req, const char *js, const json_tok_t *toks) {
+    int fd = httpd_req_to_sockfd(req);
+    char data[WS_CMD_MAX] = "";
+    int data_idx = json_scan_get(js, toks, 0, "data");
+    if (data_idx >= 0 && !json_scan_string(js, &toks[data_idx], data, sizeof(data))) {
+        return ESP_OK;
+    }
+
+    ws_console_t *con = NULL;
+    ws_console_t *spare = NULL;
+    for (int i = 0; i < WS_CONSOLE_MAX; i++) {
+        if (s_consoles[i].fd == fd) {
+            con = &s_consoles[i];
+        } else if (s_consoles[i].fd < 0 && spare == NULL) {
+            spare = &s_consoles[i];
+        }
+    }
+
+    bool opened = false;
+    if (con == NULL) {
+        if (spare == NULL || ws_client_find(fd) == NULL) {
+            static const char FULL[] = "{\"type\":\"console\",\"ok\":false}";
+            return ws_reply(req, FULL, (int)(sizeof(FULL) - 1));
+        }
+        con = spare;
+        con->fd = fd;
+        cdc_batch_init(&con->out, ws_console_port_write, ws_console_port_flush, con);
+        console_session_init(&con->session, ws_console_write, ws_console_flush, con, true);
+        opened = true;
+    }
+
+    con->req = req;
+    if (opened) {
+        console_session_prompt(&con->session);
+    }
+    console_session_input(&con->session, data, strlen(data));
+    con->req = NULL;
+    return ESP_OK;
+}
+
+/**
+ * @brief Handle a client command
+ *
+ * Keyer control over the open socket, so a keystroke or a button costs
+ * one frame instead of an HTTP request on the limited httpd sockets:
+ *   {"type":"text","data":"CQ "}        queue text (one keystroke or more)
+ *   {"type":"text_back"}                take back the newest queued character
+ *   {"type":"text_cancel"}              take back the rest of the newest send
+ *   {"type":"text_abort"}               stop and drop everything queued
+ *   {"type":"text_pause"} / {"type":"text_resume"}
+ *   {"type":"text_status"}              just report
+ *   {"type":"memory_play","slot":2}     queue a memory slot
+ *   {"type":"param","param":"keyer.wpm","value":25}
+ *   {"type":"log","level":"DEBUG"}      subscribe to the logs (ws_log_subscribe)
+ *   {"type":"subscribe","topics":[...]} choose the pushed topics (ws_subscribe)
+ *   {"type":"console","data":"help\r"}  console terminal keystrokes (ws_console)
+ * Text commands are answered with a text_status frame (ok false when the
+ * command was refused), param with a param frame. An optional numeric
+ * "id" is echoed in the answer. Progress is also pushed to every client
+ * as it changes (ws_broadcast_text_status). Unknown types are ignored.
+ * Parsed in place (json_scan.h): nothing is allocated per command.
+ */
+static esp_err_t ws_handle_command(httpd_req_t *req, const char *msg, size_t len) {
+    json_tok_t toks[16];
+    if (json_scan(msg, len, toks, sizeof(toks) / sizeof(toks[0])) < 0 ||
+        toks[0].type != JSON_TOK_OBJECT) {
+        return ESP_OK;
+    }
+
+    char t[16];
+    int type_idx = json_scan_get(msg, toks, 0, "type");
+    if (type_idx < 0 || !json_scan_string(msg, &toks[type_idx], t, sizeof(t))) {
+        return ESP_OK;
+    }
+    int id = -1;
+    int id_idx = json_scan_get(msg, toks, 0, "id");
+    if (id_idx >= 0 && json_scan_int(msg, &toks[id_idx], &id) && id < 0) {
+        id = -1;
+    }
+
+    if (strcmp(t, "text") == 0) {
+        char data[WS_CMD_MAX];
+        int data_idx = json_scan_get(msg, toks, 0, "data");
+        bool ok = data_idx >= 0 && json_scan_string(msg, &toks[data_idx], data, sizeof(data)) &&
+                  text_keyer_send(data) == 0;
+        return ws_send_text_status(req, ok, 0, id);
+    }
+    if (strcmp(t, "text_back") == 0 || strcmp(t, "text_cancel") == 0) {
+        size_t removed = text_keyer_cancel_last(strcmp(t, "text_cancel") == 0);
+        return ws_send_text_status(req, true, removed, id);
+    }
+    if (strcmp(t, "text_abort") == 0) {
+        text_keyer_abort();
+        return ws_send_text_status(req, true, 0, id);
+    }
+    if (strcmp(t, "text_pause") == 0) {
+        text_keyer_pause();
+        return ws_send_text_status(req, true, 0, id);
+    }
+    if (strcmp(t, "text_resume") == 0) {
+        text_keyer_resume();
+        return ws_send_text_status(req, true, 0, id);
+    }
+    if (strcmp(t, "text_status") == 0) {
+        return ws_send_text_status(req, true, 0, id);
+    }
+    if (strcmp(t, "memory_play") == 0) {
+        return ws_send_text_status(req, ws_play_memory(msg, toks), 0, id);
+    }
+    if (strcmp(t, "param") == 0) {
+        return ws_set_param(req, msg, toks, id);
+    }
+    if (strcmp(t, "log") == 0) {
+        return ws_log_subscribe(req, msg, toks, id);
+    }
+    if (strcmp(t, "subscribe") == 0) {
+        return ws_subscribe(req, msg, toks, id);
+    }
+    if (strcmp(t, "console") == 0) {
+        return ws_console(req, msg, toks);
+    }
+    if (strcmp(t, "ping") == 0) {
+        /* Keepalive: browsers cannot send control frames, and a socket
+         * that never receives is the first one httpd's LRU purge closes */
+        static const char PONG[] = "{\"type\":\"pong\"}";
+        return ws_reply(req, PONG, (int)(sizeof(PONG) - 1));
+    }
+    return ESP_OK;
+}
+
 esp_err_t ws_handler(httpd_req_t *req) {
     /* First call with GET method: WebSocket handshake */
     if (req->method == HTTP_GET) {
@@ -148,7 +711,7 @@ esp_err_t ws_handler(httpd_req_t *req) {
 
     /* Handle text frames (client commands) */
     if (ws_pkt.type == HTTPD_WS_TYPE_TEXT && ws_pkt.len > 0) {
-        static uint8_t s_cmd_buf[256];
+        static uint8_t s_cmd_buf[WS_CMD_MAX];
 
         if (ws_pkt.len >= sizeof(s_cmd_buf)) {
             ESP_LOGW(TAG, "WS message too large: %zu bytes (max %zu)",
@@ -161,61 +724,88 @@ esp_err_t ws_handler(httpd_req_t *req) {
         if (ret == ESP_OK) {
             s_cmd_buf[ws_pkt.len] = '\0';
             ESP_LOGD(TAG, "Received from fd=%d: %s", fd, (char *)s_cmd_buf);
-            /* Future: parse JSON commands here */
+            ret = ws_handle_command(req, (const char *)s_cmd_buf, ws_pkt.len);
         }
+        return ret;
     }
 
     return ESP_OK;
 }
 
-void ws_broadcast(const char *message) {
-    if (s_httpd_handle == NULL) {
+/**
+ * @brief Start the client's send worker unless one is queued or running
+ */
+static void ws_client_kick(ws_client_t *c) {
+    if (ws_queue_schedule(&c->queue)) {
+        if (httpd_queue_work(s_httpd_handle, ws_async_send_worker, c) != ESP_OK) {
+            ESP_LOGD(TAG, "Failed to queue work for fd=%d", c->fd);
+            atomic_store_explicit(&c->queue.scheduled, false, memory_order_release);
+        }
+    }
+}
+
+/**
+ * @brief Queue one message to every client subscribed to its topic
+ */
+static void ws_broadcast_frame(ws_topic_t topic, ws_msg_kind_t kind, bool binary,
+                               const uint8_t *data, size_t len) {
+    if (s_httpd_handle == NULL || !ws_topic_active(topic)) {
         return;
     }
 
-    size_t len = strlen(message);
-    if (len >= sizeof(s_msg_pool[0].message)) {
+    if (len > WS_QUEUE_MSG_MAX) {
         ESP_LOGW(TAG, "Message too long: %zu bytes", len);
         return;
     }
 
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
-        if (s_clients[i].active && s_clients[i].fd >= 0) {
-            /* Get next pool slot (round-robin) */
-            uint8_t pool_idx = s_msg_pool_idx;
-            s_msg_pool_idx = (uint8_t)((s_msg_pool_idx + 1) % WS_MAX_CLIENTS);
-
-            ws_async_msg_t *msg = &s_msg_pool[pool_idx];
-            msg->hd = s_httpd_handle;
-            msg->fd = s_clients[i].fd;
-            strncpy(msg->message, message, sizeof(msg->message) - 1);
-            msg->message[sizeof(msg->message) - 1] = '\0';
-
-            esp_err_t ret = httpd_queue_work(s_httpd_handle, ws_async_send_worker, msg);
-            if (ret != ESP_OK) {
-                ESP_LOGD(TAG, "Failed to queue work for fd=%d", s_clients[i].fd);
-            }
+        ws_client_t *c = &s_clients[i];
+        if (!ws_client_is_active(c) ||
+            (atomic_load_explicit(&c->topics, memory_order_relaxed) & WS_TOPIC_BIT(topic)) == 0) {
+            continue;
+        }
+
+        unsigned queued = ws_queue_len(&c->queue);
+        ws_queue_push(&c->queue, kind, binary, data, len);
+        if (queued >= WS_QUEUE_SLOTS && kind != WS_MSG_PATTERN && !c->warned) {
+            c->warned = true;
+            ESP_LOGW(TAG, "Client fd=%d not keeping up, dropping", c->fd);
         }
+
+        ws_client_kick(c);
+    }
+}
+
+void ws_broadcast(ws_topic_t topic, const char *message) {
+    size_t len = strlen(message);
+    if (len >= WS_QUEUE_MSG_MAX) {
+        ESP_LOGW(TAG, "Message too long: %zu bytes", len);
+        return;
     }
+    ws_broadcast_frame(topic, WS_MSG_DECODED, false, (const uint8_t *)message, len);
 }
 
-void ws_broadcast_decoder_char(char c, uint8_t wpm) {
+void ws_broadcast_binary(const uint8_t *data, size_t len) {
+    ws_broadcast_frame(WS_TOPIC_TIMELINE, WS_MSG_TIMELINE, true, data, len);
+}
+
+void ws_broadcast_decoder_char(char c, uint8_t wpm, uint32_t seq) {
     char json[64];
 
     /* Handle special characters that need JSON escaping */
     if (c == '"') {
-        snprintf(json, sizeof(json), "{\"type\":\"decoded\",\"char\":\"\\\"\",\"wpm\":%u}", wpm);
+        snprintf(json, sizeof(json), "{\"type\":\"decoded\",\"char\":\"\\\"\",\"wpm\":%u,\"seq\":%" PRIu32 "}", wpm, seq);
     } else if (c == '\\') {
-        snprintf(json, sizeof(json), "{\"type\":\"decoded\",\"char\":\"\\\\\",\"wpm\":%u}", wpm);
+        snprintf(json, sizeof(json), "{\"type\":\"decoded\",\"char\":\"\\\\\",\"wpm\":%u,\"seq\":%" PRIu32 "}", wpm, seq);
     } else {
-        snprintf(json, sizeof(json), "{\"type\":\"decoded\",\"char\":\"%c\",\"wpm\":%u}", c, wpm);
+        snprintf(json, sizeof(json), "{\"type\":\"decoded\",\"char\":\"%c\",\"wpm\":%u,\"seq\":%" PRIu32 "}", c, wpm, seq);
     }
 
-    ws_broadcast(json);
+    ws_broadcast(WS_TOPIC_DECODER, json);
 }
 
 void ws_broadcast_decoder_word(void) {
-    ws_broadcast("{\"type\":\"word\"}");
+    ws_broadcast(WS_TOPIC_DECODER, "{\"type\":\"word\"}");
 }
 
 void ws_broadcast_decoder_pattern(const char *pattern) {
@@ -223,7 +813,7 @@ void ws_broadcast_decoder_pattern(const char *pattern) {
     snprintf(json, sizeof(json), "{\"type\":\"pattern\",\"pattern\":\"%s\"}",
              pattern ? pattern : "");
     ESP_LOGI(TAG, "Push pattern '%s' clients=%d", pattern ? pattern : "", ws_get_client_count());
-    ws_broadcast(json);
+    ws_broadcast_frame(WS_TOPIC_DECODER, WS_MSG_PATTERN, false, (const uint8_t *)json, strlen(json));
 }
 
 void ws_broadcast_timeline(const char *event_type, const char *json_data) {
@@ -243,15 +833,122 @@ void ws_broadcast_timeline(const char *event_type, const char *json_data) {
                  event_type, json_data ? json_data : "null");
     }
 
-    ws_broadcast(json);
+    ws_broadcast_frame(WS_TOPIC_TIMELINE, WS_MSG_TIMELINE, false, (const uint8_t *)json, strlen(json));
+}
+
+void ws_broadcast_text_status(void) {
+    char json[192];
+    int len = ws_format_text_status(json, sizeof(json), true, 0, -1);
+    ws_broadcast_frame(WS_TOPIC_TEXT, WS_MSG_DECODED, false, (const uint8_t *)json, (size_t)len);
+}
+
+void ws_broadcast_key_stats(void) {
+    static const struct {
+        uint8_t ch;
+        const char *name;
+    } k_channels[] = {
+        { KEY_EDGE_CH_KEY, "key" },
+        { KEY_EDGE_CH_REMOTE, "remote" },
+    };
+
+    for (size_t i = 0; i < sizeof(k_channels) / sizeof(k_channels[0]); i++) {
+        key_stats_view_t v[KEY_STATS_WINDOWS];
+        key_stats_get(&g_key_stats, k_channels[i].ch, v);
+        if (k_channels[i].ch != KEY_EDGE_CH_KEY && v[KEY_STATS_60S].marks == 0 &&
+            v[KEY_STATS_60S].duty_pm == 0) {
+            continue;   /* Remote quiet for a minute: nothing to show */
+        }
+
+        /* One value per window (1 s, 10 s, 60 s), in key_stats_view_t units */
+#define WINDOWS3(f) (unsigned)v[0].f, (unsigned)v[1].f, (unsigned)v[2].f
+        char json[WS_QUEUE_MSG_MAX];
+        snprintf(json, sizeof(json),
+                 "{\"type\":\"key_stats\",\"ch\":\"%s\",\"wpm\":[%u,%u,%u],"
+                 "\"weight\":[%u,%u,%u],\"dah\":[%u,%u,%u],\"char_gap\":[%u,%u,%u],"
+                 "\"word_gap\":[%u,%u,%u],\"duty\":[%u,%u,%u],\"marks\":[%u,%u,%u]}",
+                 k_channels[i].name, WINDOWS3(wpm_x10), WINDOWS3(weight_pm),
+                 WINDOWS3(dah_ratio_x100), WINDOWS3(char_gap_x100), WINDOWS3(word_gap_x100),
+                 WINDOWS3(duty_pm), WINDOWS3(marks));
+#undef WINDOWS3
+        ws_broadcast(WS_TOPIC_STATS, json);
+    }
+}
+
+bool ws_push_logs(void) {
+    static char s_frame[WS_QUEUE_MSG_MAX];
+    bool busy = false;
+
+    if (s_httpd_handle == NULL) {
+        return false;
+    }
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        ws_client_t *c = &s_clients[i];
+        unsigned sub = ws_client_is_active(c)
+                           ? atomic_load_explicit(&c->log_sub, memory_order_acquire) : 0U;
+        if (sub != s_log_seen[i]) {
+            s_log_seen[i] = sub;
+            if (sub != 0) {
+                ws_log_cursor_init(&s_log_cursors[i], &g_rt_log_stream, &g_bg_log_stream,
+                                   (ws_log_filter_t)(sub & 0xFFU));
+            }
+        }
+        if (sub == 0) {
+            continue;
+        }
+
+        /* Backpressure: leave the cursor where it is; the ring laps it */
+        bool pushed = false;
+        for (int n = 0; n < WS_LOG_FRAMES &&
+                        ws_queue_len(&c->queue) + WS_LOG_RESERVE <= WS_QUEUE_SLOTS; n++) {
+            size_t len = ws_log_batch(&s_log_cursors[i], s_frame, sizeof(s_frame));
+            if (len == 0) {
+                break;
+            }
+            ws_queue_push(&c->queue, WS_MSG_LOG, false, (const uint8_t *)s_frame, len);
+            pushed = true;
+        }
+        if (pushed) {
+            ws_client_kick(c);
+            busy = true;
+        }
+    }
+    return busy;
+}
+
+bool ws_topic_active(ws_topic_t topic) {
+    return (atomic_load_explicit(&s_topic_mask, memory_order_acquire) & WS_TOPIC_BIT(topic)) != 0;
+}
+
+unsigned ws_topic_joins(void) {
+    return atomic_load_explicit(&s_topic_joins, memory_order_acquire);
 }
 
 int ws_get_client_count(void) {
     int count = 0;
     for (int i = 0; i < WS_MAX_CLIENTS; i++) {
-        if (s_clients[i].active) {
+        if (ws_client_is_active(&s_clients[i])) {
             count++;
         }
     }
     return count;
 }
+
+int ws_get_client_stats(ws_client_stats_t *out, int max) {
+    int n = 0;
+    for (int i = 0; i < WS_MAX_CLIENTS && n < max; i++) {
+        ws_client_t *c = &s_clients[i];
+        if (!ws_client_is_active(c)) {
+            continue;
+        }
+        out[n].fd = c->fd;
+        out[n].queued = ws_queue_len(&c->queue);
+        out[n].sent = atomic_load_explicit(&c->queue.sent, memory_order_relaxed);
+        out[n].dropped_timeline =
+            atomic_load_explicit(&c->queue.dropped[WS_MSG_TIMELINE], memory_order_relaxed);
+        out[n].dropped_text =
+            atomic_load_explicit(&c->queue.dropped[WS_MSG_DECODED], memory_order_relaxed);
+        out[n].coalesced = atomic_load_explicit(&c->queue.coalesced, memory_order_relaxed);
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file ws_state.c
+ * @brief Config and status deltas for the web UI (ws_delta.h)
+ *
+ * Run by the UI push service (bg_task), each half only while a client
+ * is subscribed to its topic (ws_topic.h). Config is looked at only when
+ * g_config.generation moves; each parameter is then formatted and
+ * compared with the signature of what was last sent, so a change of one
+ * parameter sends one member. Status is sampled every WS_STATE_STATUS_MS
+ * and sent field by field the same way, in full when a client subscribes
+ * (clients fetch /api/config themselves on connect).
+ */
+
+#include "ws_server.h"
+#include "ws_delta.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "config_console.h"
+#include "wifi.h"
+#include "vpn.h"
+#include "cwnet_socket.h"
+#include "fault.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+extern fault_state_t g_fault_state;
+
+/* Status sampling period */
+#define WS_STATE_STATUS_MS 250
+
+/* Longest value text (strings escaped, quotes included) */
+#define WS_STATE_VALUE_MAX 160
+
+typedef enum {
+    ST_MODE = 0,
+    ST_IP,
+    ST_READY,
+    ST_CWNET,
+    ST_VPN,
+    ST_FAULT_ACTIVE,
+    ST_FAULT_CODE,
+    ST_COUNT
+} status_field_t;
+
+/* Keys into GET /api/status */
+static const char *const STATUS_KEYS[ST_COUNT] = {
+    "mode", "ip", "ready", "cwnet.state", "vpn.state", "fault.active", "fault.code",
+};
+
+/* All owned by the UI push service */
+static uint32_t s_seq;
+static uint32_t s_param_sig[CONSOLE_PARAM_COUNT];
+static uint16_t s_config_gen;
+static bool s_config_primed;
+static uint32_t s_status_sig[ST_COUNT];
+static bool s_status_valid;
+static int64_t s_status_next_us;
+static unsigned s_joins_seen;
+
+/* ctx is the topic */
+static void send_frame(const char *frame, size_t len, void *ctx) {
+    (void)len;
+    ws_broadcast((ws_topic_t)(uintptr_t)ctx, frame);
+}
+
+/** Parameter value as in GET /api/config */
+static void param_json(const param_descriptor_t *p, char *out, size_t cap) {
+    param_value_t v = p->get_fn();
+    switch (p->type) {
+        case PARAM_TYPE_BOOL:
+            snprintf(out, cap, "%s", v.b ? "true" : "false");
+            break;
+        case PARAM_TYPE_U8:
+        case PARAM_TYPE_ENUM:
+            snprintf(out, cap, "%u", (unsigned)v.u8);
+            break;
+        case PARAM_TYPE_U16:
+            snprintf(out, cap, "%u", (unsigned)v.u16);
+            break;
+        case PARAM_TYPE_U32:
+            snprintf(out, cap, "%lu", (unsigned long)v.u32);
+            break;
+        case PARAM_TYPE_STRING:
+        default:
+            if (ws_delta_json_string(out, cap, v.str != NULL ? v.str : "") == 0) {
+                snprintf(out, cap, "\"\"");
+            }
+            break;
+    }
+}
+
+/** Send the parameters that changed since the last call (the first call only remembers) */
+static bool push_config(void) {
+    uint16_t gen = atomic_load_explicit(&g_config.generation, memory_order_acquire);
+    if (s_config_primed && gen == s_config_gen) {
+        return false;
+    }
+    s_config_gen = gen;
+
+    char value[WS_STATE_VALUE_MAX];
+    ws_delta_t d;
+    ws_delta_begin(&d, "config", &s_seq, send_frame, (void *)(uintptr_t)WS_TOPIC_CONFIG);
+    for (unsigned i = 0; i < CONSOLE_PARAM_COUNT; i++) {
+        param_json(&CONSOLE_PARAMS[i], value, sizeof(value));
+        uint32_t sig = ws_delta_sig(value);
+        if (s_config_primed && sig == s_param_sig[i]) {
+            continue;
+        }
+        s_param_sig[i] = sig;
+        if (s_config_primed) {
+            ws_delta_put(&d, CONSOLE_PARAMS[i].full_path, value);
+        }
+    }
+    s_config_primed = true;
+    return ws_delta_end(&d) > 0;
+}
+
+static void status_json(status_field_t f, char *out, size_t cap) {
+    char ip[16] = "0.0.0.0";
+    wifi_state_t wifi = wifi_get_state();
+
+    switch (f) {
+        case ST_MODE:
+            ws_delta_json_string(out, cap, wifi_state_str(wifi));
+            break;
+        case ST_IP:
+            wifi_get_ip(ip, sizeof(ip));
+            ws_delta_json_string(out, cap, ip);
+            break;
+        case ST_READY:
+            snprintf(out, cap, "%s", (wifi == WIFI_STATE_CONNECTED || wifi == WIFI_STATE_AP_MODE)
+                                         ? "true" : "false");
+            break;
+        case ST_CWNET:
+            ws_delta_json_string(out, cap, cwnet_socket_state_str(cwnet_socket_get_state()));
+            break;
+        case ST_VPN:
+            ws_delta_json_string(out, cap, vpn_state_str(vpn_get_state()));
+            break;
+        case ST_FAULT_ACTIVE:
+            snprintf(out, cap, "%s", fault_is_active(&g_fault_state) ? "true" : "false");
+            break;
+        case ST_FAULT_CODE:
+        default:
+            ws_delta_json_string(out, cap, fault_code_str(fault_get_code(&g_fault_state)));
+            break;
+    }
+}
+
+static bool push_status(int64_t now_us) {
+    if (s_status_valid && now_us < s_status_next_us) {
+        return false;
+    }
+    s_status_next_us = now_us + (int64_t)WS_STATE_STATUS_MS * 1000;
+
+    char value[WS_STATE_VALUE_MAX];
+    ws_delta_t d;
+    ws_delta_begin(&d, "status", &s_seq, send_frame, (void *)(uintptr_t)WS_TOPIC_STATUS);
+    for (unsigned i = 0; i < ST_COUNT; i++) {
+        status_json((status_field_t)i, value, sizeof(value));
+        uint32_t sig = ws_delta_sig(value);
+        if (s_status_valid && sig == s_status_sig[i]) {
+            continue;
+        }
+        s_status_sig[i] = sig;
+        ws_delta_put(&d, STATUS_KEYS[i], value);
+    }
+    s_status_valid = true;
+    return ws_delta_end(&d) > 0;
+}
+
+bool ws_push_state(void) {
+    bool busy = false;
+
+    if (ws_topic_active(WS_TOPIC_CONFIG)) {
+        busy = push_config();
+    } else {
+        /* The next subscriber fetches /api/config on connect: start over then */
+        s_config_primed = false;
+    }
+
+    unsigned joins = ws_topic_joins();
+    if (joins != s_joins_seen) {
+        s_joins_seen = joins;
+        s_status_valid = false;   /* A newcomer gets every status field */
+    }
+    if (ws_topic_active(WS_TOPIC_STATUS)) {
+        busy |= push_status(esp_timer_get_time());
+    } else {
+        s_status_valid = false;
+    }
+    return busy;
+}
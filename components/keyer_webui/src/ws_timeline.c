@@ -0,0 +1,51 @@
+/**
+ * @file ws_timeline.c
+ * @brief Binary WebSocket timeline frames
+ */
+
+#include "ws_timeline.h"
+
+void ws_timeline_reset(ws_timeline_frame_t *f, uint32_t tick_period_us) {
+    f->len = 0;
+    f->count = 0;
+    f->tick_period_us = tick_period_us;
+    f->last_tick = 0;
+}
+
+bool ws_timeline_add(ws_timeline_frame_t *f, uint64_t tick, int64_t time_us,
+                     uint8_t channel, uint8_t level) {
+    if (f->count >= WS_TIMELINE_MAX_RECORDS) {
+        return false;
+    }
+
+    uint16_t delta = 0;
+    if (f->count == 0) {
+        uint16_t period = (uint16_t)((f->tick_period_us > UINT16_MAX) ? UINT16_MAX
+                                                                      : f->tick_period_us);
+        uint64_t base = (uint64_t)time_us;
+        f->buf[0] = WS_TIMELINE_VERSION;
+        f->buf[2] = (uint8_t)(period & 0xFFU);
+        f->buf[3] = (uint8_t)(period >> 8);
+        for (int i = 0; i < 8; i++) {
+            f->buf[4 + i] = (uint8_t)((base >> (8 * i)) & 0xFFU);
+        }
+        f->len = WS_TIMELINE_HEADER;
+    } else {
+        if (tick < f->last_tick || tick - f->last_tick > UINT16_MAX) {
+            return false;
+        }
+        delta = (uint16_t)(tick - f->last_tick);
+    }
+
+    uint8_t *rec = &f->buf[f->len];
+    rec[0] = (uint8_t)(delta & 0xFFU);
+    rec[1] = (uint8_t)(delta >> 8);
+    rec[2] = channel;
+    rec[3] = level;
+
+    f->len += WS_TIMELINE_RECORD;
+    f->count++;
+    f->buf[1] = (uint8_t)f->count;
+    f->last_tick = tick;
+    return true;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file ws_topic.c
+ * @brief WebSocket subscription topics
+ */
+
+#include "ws_topic.h"
+#include <string.h>
+
+static const char *const TOPIC_NAMES[WS_TOPIC_COUNT] = {
+    "timeline", "decoder", "text", "config", "status", "logs", "stats",
+};
+
+const char *ws_topic_name(ws_topic_t topic) {
+    return ((unsigned)topic < WS_TOPIC_COUNT) ? TOPIC_NAMES[topic] : NULL;
+}
+
+int ws_topic_parse(const char *name) {
+    for (unsigned t = 0; t < WS_TOPIC_COUNT; t++) {
+        if (strcmp(name, TOPIC_NAMES[t]) == 0) {
+            return (int)t;
+        }
+    }
+    return -1;
+}
+
+bool ws_topic_mask_parse(const char *js, const json_tok_t *toks, int arr, unsigned *mask) {
+    if (arr < 0 || toks[arr].type != JSON_TOK_ARRAY) {
+        return false;
+    }
+
+    unsigned set = 0;
+    char name[16];
+    for (int i = arr + 1; i < (int)toks[arr].next; i = (int)toks[i].next) {
+        if (toks[i].type != JSON_TOK_STRING) {
+            return false;
+        }
+        /* Too long for any known name: skip it like an unknown one */
+        if (!json_scan_string(js, &toks[i], name, sizeof(name))) {
+            continue;
+        }
+        int t = ws_topic_parse(name);
+        if (t >= 0) {
+            set |= WS_TOPIC_BIT(t);
+        }
+    }
+    *mask = set;
+    return true;
+}
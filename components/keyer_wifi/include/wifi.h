@@ -6,6 +6,7 @@
  * - Attempts STA connection on startup
  * - Falls back to open AP if connection fails
  * - Reports state via atomic for LED integration
+ * - Reconnects straight to the last AP (BSSID and channel cached in NVS)
  */
 
 #ifndef KEYER_WIFI_H
@@ -14,6 +15,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "wifi_ps.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +47,26 @@ typedef struct {
     char dns[16];              /**< DNS server */
 } wifi_config_app_t;
 
+/**
+ * @brief Power-save status (see wifi_ps.h)
+ */
+typedef struct {
+    bool saving;               /**< Modem sleep on */
+    uint32_t switches;         /**< Mode changes since the first connection */
+    int32_t jitter_awake_ms;   /**< Last RTT jitter with power save off, -1 if none */
+    int32_t jitter_saving_ms;  /**< Last RTT jitter with modem sleep, -1 if none */
+} wifi_ps_status_t;
+
+/**
+ * @brief Connection timeline, ms since boot (0 = not reached yet)
+ */
+typedef struct {
+    uint32_t start_ms;         /**< Connection task started */
+    uint32_t assoc_ms;         /**< Associated to the AP */
+    uint32_t ip_ms;            /**< Got an IP (DHCP or static) */
+    bool fast;                 /**< Associated straight to the cached AP (no scan) */
+} wifi_connect_timing_t;
+
 /**
  * @brief Default WiFi configuration
  */
@@ -91,6 +113,14 @@ void wifi_app_stop(void);
  */
 wifi_state_t wifi_get_state(void);
 
+/**
+ * @brief Get state as string
+ *
+ * @param state WiFi state
+ * @return Static string (never NULL)
+ */
+const char *wifi_state_str(wifi_state_t state);
+
 /**
  * @brief Get current IP address
  *
@@ -107,6 +137,40 @@ bool wifi_get_ip(char *buf, size_t len);
  */
 bool wifi_is_connected(void);
 
+/**
+ * @brief Run the power-save policy and apply its decision
+ *
+ * Call periodically from one Core 1 task. Does nothing unless the STA is
+ * connected; the radio keeps the last applied mode across reconnects.
+ *
+ * @param policy Configured policy (wifi.power_save)
+ * @param idle_s Idle seconds before AUTO sleeps again (wifi.ps_idle_s)
+ * @param now_us Current time
+ * @param activity_pos Keying stream write position
+ * @param link_busy CWNet READY or a LAN peer keying
+ * @param jitter_ms Current RTT jitter, -1 if unknown
+ */
+void wifi_power_save_tick(wifi_ps_policy_t policy, uint32_t idle_s, int64_t now_us,
+                          size_t activity_pos, bool link_busy, int32_t jitter_ms);
+
+/**
+ * @brief Get power-save status
+ *
+ * Thread-safe (atomics).
+ *
+ * @param out Current mode, switch count and jitter per mode
+ */
+void wifi_get_power_save(wifi_ps_status_t *out);
+
+/**
+ * @brief Get the STA connection timeline
+ *
+ * Thread-safe (atomics). Times are those of the latest association.
+ *
+ * @param out Start, association and IP times
+ */
+void wifi_get_connect_timing(wifi_connect_timing_t *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,94 @@
+/**
+ * @file wifi_ps.h
+ * @brief WiFi power-save policy driven by keying activity
+ *
+ * Modem sleep (WIFI_PS_MIN_MODEM, the ESP-IDF STA default) wakes the radio
+ * only at DTIM beacons, so inbound packets wait up to a beacon interval
+ * (~100ms or more) at the AP. That is invisible to a web page but shows up
+ * as ping jitter on a CWNet link. The AUTO policy turns power save off while
+ * latency matters and back on once the keyer has been idle:
+ * - Off while CWNet is READY (or a LAN peer is keying)
+ * - Off for idle_s seconds after the last keying stream activity
+ * - On otherwise
+ *
+ * Activity is any movement of the keying stream write position: silence
+ * compression means the stream only grows on key changes, so an idle keyer
+ * leaves it still.
+ *
+ * Pure decision logic, no ESP-IDF calls: wifi.c owns one instance and
+ * applies the result with esp_wifi_set_ps(). Single owner, not thread-safe.
+ */
+
+#ifndef KEYER_WIFI_PS_H
+#define KEYER_WIFI_PS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Power-save policy (wifi.power_save, same order)
+ */
+typedef enum {
+    WIFI_PS_POLICY_NEVER = 0,  /**< Never sleep: lowest latency, most current */
+    WIFI_PS_POLICY_ALWAYS,     /**< Always modem sleep (ESP-IDF default) */
+    WIFI_PS_POLICY_AUTO,       /**< Sleep only when idle */
+} wifi_ps_policy_t;
+
+/**
+ * @brief Policy state
+ */
+typedef struct {
+    bool saving;               /**< Current decision: modem sleep on */
+    bool primed;               /**< activity_pos holds a real position */
+    bool active_seen;          /**< last_active_us is valid */
+    size_t activity_pos;       /**< Stream write position at the last update */
+    int64_t last_active_us;    /**< Last time the stream moved */
+    uint32_t switches;         /**< Decisions changed since init */
+    int32_t jitter_ms[2];      /**< Last RTT jitter seen per mode [awake, saving], -1 if none */
+} wifi_ps_t;
+
+/**
+ * @brief Initialize policy state
+ *
+ * @param ps Policy state
+ * @param saving Mode the radio is in now (true after esp_wifi_start())
+ */
+void wifi_ps_init(wifi_ps_t *ps, bool saving);
+
+/**
+ * @brief Re-evaluate the decision
+ *
+ * @param ps Policy state
+ * @param policy Configured policy
+ * @param idle_s Seconds without activity before AUTO sleeps again
+ * @param now_us Current time
+ * @param activity_pos Keying stream write position
+ * @param link_busy A latency-sensitive link is up (CWNet READY, LAN peer)
+ * @return true if ps->saving changed and must be applied
+ */
+bool wifi_ps_update(wifi_ps_t *ps, wifi_ps_policy_t policy, uint32_t idle_s,
+                    int64_t now_us, size_t activity_pos, bool link_busy);
+
+/**
+ * @brief Record the RTT jitter measured in the current mode
+ *
+ * @param ps Policy state
+ * @param jitter_ms Smoothed RTT variation, ignored if negative (unknown)
+ */
+void wifi_ps_note_jitter(wifi_ps_t *ps, int32_t jitter_ms);
+
+/**
+ * @brief Get policy name ("never", "always", "auto")
+ */
+const char *wifi_ps_policy_str(wifi_ps_policy_t policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WIFI_PS_H */
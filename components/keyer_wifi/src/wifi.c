@@ -6,6 +6,9 @@
  * - Attempts STA connection with retry logic
  * - Falls back to open AP if connection fails
  * - Reports state via atomic for LED integration
+ * - Switches modem sleep with keying activity (wifi_ps.h)
+ * - Fast reconnect: associates straight to the last AP's BSSID and
+ *   channel (NVS cache), skipping the scan; falls back to a full scan
  */
 
 #include "wifi.h"
@@ -19,6 +22,8 @@
 #include "esp_netif.h"
 #include "esp_mac.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
 
 #define TAG "wifi"
 
@@ -35,6 +40,12 @@
 #define MAX_RETRY_COUNT     3
 #define FAILED_STATE_DELAY_MS 600
 
+/* Last AP cache (fast reconnect) */
+#define NVS_NAMESPACE       "wifi_fc"
+#define NVS_KEY_SSID        "ssid"
+#define NVS_KEY_BSSID       "bssid"
+#define NVS_KEY_CHANNEL     "chan"
+
 /* WiFi state */
 static struct {
     bool initialized;
@@ -45,14 +56,42 @@ static struct {
     _Atomic wifi_state_t state;
     int retry_count;
     esp_ip4_addr_t ip_addr;
+    wifi_config_t sta_config;           /**< Applied STA config (bssid_set on a fast attempt) */
+    uint8_t ap_bssid[6];                /**< AP of the current association */
+    uint8_t ap_channel;
+    _Atomic bool fast_connect;          /**< Current attempt uses the cached AP */
+    _Atomic uint32_t t_start_ms;        /**< Connection timeline, ms since boot (0 = not yet) */
+    _Atomic uint32_t t_assoc_ms;
+    _Atomic uint32_t t_ip_ms;
+    wifi_ps_t ps;                       /**< Owned by the wifi_power_save_tick() caller */
+    bool ps_ready;
+    _Atomic bool ps_saving;
+    _Atomic uint32_t ps_switches;
+    _Atomic int32_t ps_jitter_ms[2];
 } s_wifi;
 
+/* Connection task and event group: static, created once per boot. The
+ * task ends itself, so its buffers are never reused (wifi_app_start is
+ * one-shot). */
+#define CONN_TASK_STACK_SIZE 4096
+static StackType_t s_conn_stack[CONN_TASK_STACK_SIZE];
+static StaticTask_t s_conn_tcb;
+static bool s_conn_started;
+static StaticEventGroup_t s_event_group_buf;
+
 /* Forward declarations */
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                 int32_t event_id, void *event_data);
 static void connection_task(void *pvParameters);
 static esp_err_t start_ap_mode(void);
 static esp_err_t configure_static_ip(void);
+static bool load_cached_ap(wifi_config_t *sta_config);
+static void save_cached_ap(void);
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
 
 esp_err_t wifi_app_init(const wifi_config_app_t *config)
 {
@@ -67,6 +106,9 @@ esp_err_t wifi_app_init(const wifi_config_app_t *config)
 
     /* Save configuration */
     memcpy(&s_wifi.config, config, sizeof(wifi_config_app_t));
+    atomic_store_explicit(&s_wifi.ps_saving, true, memory_order_relaxed);
+    atomic_store_explicit(&s_wifi.ps_jitter_ms[0], -1, memory_order_relaxed);
+    atomic_store_explicit(&s_wifi.ps_jitter_ms[1], -1, memory_order_relaxed);
 
     /* TCP/IP stack and event loop are initialized in main.c unconditionally.
      * These calls are safe to repeat - esp_netif_init() is idempotent and
@@ -85,7 +127,7 @@ esp_err_t wifi_app_init(const wifi_config_app_t *config)
     }
 
     /* Create event group */
-    s_wifi.event_group = xEventGroupCreate();
+    s_wifi.event_group = xEventGroupCreateStatic(&s_event_group_buf);
     if (s_wifi.event_group == NULL) {
         ESP_LOGE(TAG, "Failed to create event group");
         return ESP_ERR_NO_MEM;
@@ -173,16 +215,17 @@ esp_err_t wifi_app_start(void)
     }
 
     /* Create connection task */
-    BaseType_t task_ret = xTaskCreate(connection_task,
-                                       "wifi_conn",
-                                       4096,
-                                       NULL,
-                                       5,
-                                       NULL);
-    if (task_ret != pdPASS) {
+    if (s_conn_started) {
+        ESP_LOGE(TAG, "Connection task already started");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xTaskCreateStaticPinnedToCore(connection_task, "wifi_conn", sizeof(s_conn_stack),
+                                      NULL, 5, s_conn_stack, &s_conn_tcb,
+                                      tskNO_AFFINITY) == NULL) {
         ESP_LOGE(TAG, "Failed to create connection task");
         return ESP_ERR_NO_MEM;
     }
+    s_conn_started = true;
 
     ESP_LOGI(TAG, "WiFi start initiated");
     return ESP_OK;
@@ -207,6 +250,18 @@ wifi_state_t wifi_get_state(void)
     return atomic_load_explicit(&s_wifi.state, memory_order_relaxed);
 }
 
+const char *wifi_state_str(wifi_state_t state)
+{
+    switch (state) {
+        case WIFI_STATE_DISABLED:   return "DISABLED";
+        case WIFI_STATE_CONNECTING: return "CONNECTING";
+        case WIFI_STATE_CONNECTED:  return "CONNECTED";
+        case WIFI_STATE_FAILED:     return "FAILED";
+        case WIFI_STATE_AP_MODE:    return "AP_MODE";
+        default:                    return "UNKNOWN";
+    }
+}
+
 bool wifi_get_ip(char *buf, size_t len)
 {
     if (buf == NULL || len < 16) {
@@ -227,6 +282,64 @@ bool wifi_is_connected(void)
     return (state == WIFI_STATE_CONNECTED);
 }
 
+void wifi_power_save_tick(wifi_ps_policy_t policy, uint32_t idle_s, int64_t now_us,
+                          size_t activity_pos, bool link_busy, int32_t jitter_ms)
+{
+    if (!wifi_is_connected()) {
+        return;
+    }
+
+    if (!s_wifi.ps_ready) {
+        /* esp_wifi_start() leaves the STA in WIFI_PS_MIN_MODEM */
+        wifi_ps_init(&s_wifi.ps, true);
+        s_wifi.ps_ready = true;
+    }
+
+    if (wifi_ps_update(&s_wifi.ps, policy, idle_s, now_us, activity_pos, link_busy)) {
+        bool saving = s_wifi.ps.saving;
+        esp_err_t ret = esp_wifi_set_ps(saving ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+        if (ret != ESP_OK) {
+            /* Undo so the next tick retries */
+            ESP_LOGW(TAG, "esp_wifi_set_ps failed: %s", esp_err_to_name(ret));
+            s_wifi.ps.saving = !saving;
+            s_wifi.ps.switches--;
+        } else {
+            ESP_LOGI(TAG, "Power save %s (policy %s)", saving ? "on" : "off",
+                     wifi_ps_policy_str(policy));
+            atomic_store_explicit(&s_wifi.ps_saving, saving, memory_order_relaxed);
+            atomic_store_explicit(&s_wifi.ps_switches, s_wifi.ps.switches, memory_order_relaxed);
+        }
+    }
+
+    wifi_ps_note_jitter(&s_wifi.ps, jitter_ms);
+    atomic_store_explicit(&s_wifi.ps_jitter_ms[0], s_wifi.ps.jitter_ms[0], memory_order_relaxed);
+    atomic_store_explicit(&s_wifi.ps_jitter_ms[1], s_wifi.ps.jitter_ms[1], memory_order_relaxed);
+}
+
+void wifi_get_power_save(wifi_ps_status_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+
+    out->saving = atomic_load_explicit(&s_wifi.ps_saving, memory_order_relaxed);
+    out->switches = atomic_load_explicit(&s_wifi.ps_switches, memory_order_relaxed);
+    out->jitter_awake_ms = atomic_load_explicit(&s_wifi.ps_jitter_ms[0], memory_order_relaxed);
+    out->jitter_saving_ms = atomic_load_explicit(&s_wifi.ps_jitter_ms[1], memory_order_relaxed);
+}
+
+void wifi_get_connect_timing(wifi_connect_timing_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+
+    out->start_ms = atomic_load_explicit(&s_wifi.t_start_ms, memory_order_relaxed);
+    out->assoc_ms = atomic_load_explicit(&s_wifi.t_assoc_ms, memory_order_relaxed);
+    out->ip_ms = atomic_load_explicit(&s_wifi.t_ip_ms, memory_order_relaxed);
+    out->fast = atomic_load_explicit(&s_wifi.fast_connect, memory_order_relaxed);
+}
+
 /* WiFi event handler */
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                 int32_t event_id, void *event_data)
@@ -240,7 +353,29 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                 esp_wifi_connect();
                 break;
 
+            case WIFI_EVENT_STA_CONNECTED: {
+                wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *)event_data;
+                memcpy(s_wifi.ap_bssid, event->bssid, sizeof(s_wifi.ap_bssid));
+                s_wifi.ap_channel = event->channel;
+                atomic_store_explicit(&s_wifi.t_assoc_ms, now_ms(), memory_order_relaxed);
+                ESP_LOGI(TAG, "Associated to " MACSTR " ch %u", MAC2STR(event->bssid),
+                         (unsigned)event->channel);
+                break;
+            }
+
             case WIFI_EVENT_STA_DISCONNECTED:
+                if (s_wifi.sta_config.sta.bssid_set) {
+                    /* Cached AP gone or moved (or a later drop): scan from now on */
+                    s_wifi.sta_config.sta.bssid_set = false;
+                    s_wifi.sta_config.sta.channel = 0;
+                    esp_wifi_set_config(WIFI_IF_STA, &s_wifi.sta_config);
+                    if (atomic_load_explicit(&s_wifi.t_assoc_ms, memory_order_relaxed) == 0) {
+                        ESP_LOGW(TAG, "Cached AP not reachable, scanning");
+                        atomic_store_explicit(&s_wifi.fast_connect, false, memory_order_relaxed);
+                        esp_wifi_connect();
+                        break;
+                    }
+                }
                 s_wifi.retry_count++;
                 ESP_LOGW(TAG, "STA disconnected (retry %d/%d)", s_wifi.retry_count, MAX_RETRY_COUNT);
 
@@ -271,6 +406,7 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
         if (event_id == IP_EVENT_STA_GOT_IP) {
             ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
             s_wifi.ip_addr = event->ip_info.ip;
+            atomic_store_explicit(&s_wifi.t_ip_ms, now_ms(), memory_order_relaxed);
             ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&s_wifi.ip_addr));
             s_wifi.retry_count = 0;
             xEventGroupSetBits(s_wifi.event_group, WIFI_CONNECTED_BIT);
@@ -332,6 +468,58 @@ static esp_err_t configure_static_ip(void)
     return ESP_OK;
 }
 
+/* Load the last AP for this SSID into sta_config (BSSID + channel) */
+static bool load_cached_ap(wifi_config_t *sta_config)
+{
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+
+    char ssid[33];
+    size_t ssid_len = sizeof(ssid);
+    uint8_t bssid[6];
+    size_t bssid_len = sizeof(bssid);
+    uint8_t channel = 0;
+    bool ok = nvs_get_str(handle, NVS_KEY_SSID, ssid, &ssid_len) == ESP_OK &&
+              strcmp(ssid, s_wifi.config.ssid) == 0 &&
+              nvs_get_blob(handle, NVS_KEY_BSSID, bssid, &bssid_len) == ESP_OK &&
+              bssid_len == sizeof(bssid) &&
+              nvs_get_u8(handle, NVS_KEY_CHANNEL, &channel) == ESP_OK &&
+              channel != 0;
+    nvs_close(handle);
+
+    if (ok) {
+        memcpy(sta_config->sta.bssid, bssid, sizeof(bssid));
+        sta_config->sta.bssid_set = true;
+        sta_config->sta.channel = channel;
+    }
+    return ok;
+}
+
+/* Persist the AP just associated to (only when it changed) */
+static void save_cached_ap(void)
+{
+    wifi_config_t cached = {0};
+    if (load_cached_ap(&cached) &&
+        memcmp(cached.sta.bssid, s_wifi.ap_bssid, sizeof(s_wifi.ap_bssid)) == 0 &&
+        cached.sta.channel == s_wifi.ap_channel) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    nvs_set_str(handle, NVS_KEY_SSID, s_wifi.config.ssid);
+    nvs_set_blob(handle, NVS_KEY_BSSID, s_wifi.ap_bssid, sizeof(s_wifi.ap_bssid));
+    nvs_set_u8(handle, NVS_KEY_CHANNEL, s_wifi.ap_channel);
+    nvs_commit(handle);
+    nvs_close(handle);
+    ESP_LOGI(TAG, "Cached AP " MACSTR " ch %u", MAC2STR(s_wifi.ap_bssid),
+             (unsigned)s_wifi.ap_channel);
+}
+
 /* Start AP mode with MAC-based SSID */
 static esp_err_t start_ap_mode(void)
 {
@@ -404,6 +592,7 @@ static void connection_task(void *pvParameters)
     (void)pvParameters;
 
     ESP_LOGI(TAG, "Connection task started");
+    atomic_store_explicit(&s_wifi.t_start_ms, now_ms(), memory_order_relaxed);
     atomic_store_explicit(&s_wifi.state, WIFI_STATE_CONNECTING, memory_order_relaxed);
 
     /* STA netif already created in wifi_app_init() */
@@ -414,21 +603,30 @@ static void connection_task(void *pvParameters)
         ESP_LOGW(TAG, "Static IP configuration failed, continuing with DHCP");
     }
 
-    /* Configure STA */
-    wifi_config_t sta_config = {0};
+    /* Configure STA (kept in s_wifi: the event handler drops the cached BSSID) */
+    wifi_config_t *sta_config = &s_wifi.sta_config;
+    memset(sta_config, 0, sizeof(*sta_config));
     size_t ssid_len = strlen(s_wifi.config.ssid);
-    if (ssid_len >= sizeof(sta_config.sta.ssid)) {
-        ssid_len = sizeof(sta_config.sta.ssid) - 1U;
+    if (ssid_len >= sizeof(sta_config->sta.ssid)) {
+        ssid_len = sizeof(sta_config->sta.ssid) - 1U;
     }
-    memcpy(sta_config.sta.ssid, s_wifi.config.ssid, ssid_len);
-    sta_config.sta.ssid[ssid_len] = '\0';
+    memcpy(sta_config->sta.ssid, s_wifi.config.ssid, ssid_len);
+    sta_config->sta.ssid[ssid_len] = '\0';
 
     size_t pass_len = strlen(s_wifi.config.password);
-    if (pass_len >= sizeof(sta_config.sta.password)) {
-        pass_len = sizeof(sta_config.sta.password) - 1U;
+    if (pass_len >= sizeof(sta_config->sta.password)) {
+        pass_len = sizeof(sta_config->sta.password) - 1U;
+    }
+    memcpy(sta_config->sta.password, s_wifi.config.password, pass_len);
+    sta_config->sta.password[pass_len] = '\0';
+
+    /* Fast reconnect: go straight to the last AP, no scan */
+    bool fast = load_cached_ap(sta_config);
+    atomic_store_explicit(&s_wifi.fast_connect, fast, memory_order_relaxed);
+    if (fast) {
+        ESP_LOGI(TAG, "Fast connect to " MACSTR " ch %u", MAC2STR(sta_config->sta.bssid),
+                 (unsigned)sta_config->sta.channel);
     }
-    memcpy(sta_config.sta.password, s_wifi.config.password, pass_len);
-    sta_config.sta.password[pass_len] = '\0';
 
     /* Set WiFi mode to STA */
     ret = esp_wifi_set_mode(WIFI_MODE_STA);
@@ -439,7 +637,7 @@ static void connection_task(void *pvParameters)
         return;
     }
 
-    ret = esp_wifi_set_config(WIFI_IF_STA, &sta_config);
+    ret = esp_wifi_set_config(WIFI_IF_STA, sta_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set STA config: %s", esp_err_to_name(ret));
         atomic_store_explicit(&s_wifi.state, WIFI_STATE_FAILED, memory_order_relaxed);
@@ -471,7 +669,11 @@ static void connection_task(void *pvParameters)
     if (bits & WIFI_CONNECTED_BIT) {
         /* Successfully connected */
         atomic_store_explicit(&s_wifi.state, WIFI_STATE_CONNECTED, memory_order_relaxed);
-        ESP_LOGI(TAG, "Connected to SSID: %s", s_wifi.config.ssid);
+        ESP_LOGI(TAG, "Connected to SSID: %s (%s, %lums)", s_wifi.config.ssid,
+                 atomic_load_explicit(&s_wifi.fast_connect, memory_order_relaxed) ? "fast" : "scan",
+                 (unsigned long)(atomic_load_explicit(&s_wifi.t_ip_ms, memory_order_relaxed) -
+                                 atomic_load_explicit(&s_wifi.t_start_ms, memory_order_relaxed)));
+        save_cached_ap();
     } else {
         /* Failed or timeout */
         ESP_LOGW(TAG, "Connection failed or timeout");
@@ -0,0 +1,66 @@
+/**
+ * @file wifi_ps.c
+ * @brief WiFi power-save policy driven by keying activity
+ */
+
+#include "wifi_ps.h"
+#include <string.h>
+
+void wifi_ps_init(wifi_ps_t *ps, bool saving) {
+    memset(ps, 0, sizeof(*ps));
+    ps->saving = saving;
+    ps->jitter_ms[0] = -1;
+    ps->jitter_ms[1] = -1;
+}
+
+bool wifi_ps_update(wifi_ps_t *ps, wifi_ps_policy_t policy, uint32_t idle_s,
+                    int64_t now_us, size_t activity_pos, bool link_busy) {
+    /* The first position is a baseline, not activity */
+    if (!ps->primed) {
+        ps->activity_pos = activity_pos;
+        ps->primed = true;
+    } else if (activity_pos != ps->activity_pos) {
+        ps->activity_pos = activity_pos;
+        ps->last_active_us = now_us;
+        ps->active_seen = true;
+    }
+
+    bool saving;
+    switch (policy) {
+        case WIFI_PS_POLICY_NEVER:
+            saving = false;
+            break;
+        case WIFI_PS_POLICY_ALWAYS:
+            saving = true;
+            break;
+        case WIFI_PS_POLICY_AUTO:
+        default: {
+            bool recent = ps->active_seen &&
+                          now_us - ps->last_active_us < (int64_t)idle_s * 1000000;
+            saving = !link_busy && !recent;
+            break;
+        }
+    }
+
+    if (saving == ps->saving) {
+        return false;
+    }
+    ps->saving = saving;
+    ps->switches++;
+    return true;
+}
+
+void wifi_ps_note_jitter(wifi_ps_t *ps, int32_t jitter_ms) {
+    if (jitter_ms >= 0) {
+        ps->jitter_ms[ps->saving ? 1 : 0] = jitter_ms;
+    }
+}
+
+const char *wifi_ps_policy_str(wifi_ps_policy_t policy) {
+    switch (policy) {
+        case WIFI_PS_POLICY_NEVER:  return "never";
+        case WIFI_PS_POLICY_ALWAYS: return "always";
+        case WIFI_PS_POLICY_AUTO:   return "auto";
+        default:                    return "unknown";
+    }
+}
@@ -0,0 +1,205 @@
+/**
+ * @file winkeyer.h
+ * @brief K1EL WinKeyer 2 host-mode protocol engine
+ *
+ * Byte-stream parser and responder for the WK2 host protocol, independent
+ * of the transport (USB CDC, TCP). Bytes from the host are fed as they
+ * arrive; commands execute as soon as their last argument byte is in, so
+ * replies (version, echo test, status, speed pot) go out from the same
+ * call. Text bytes are batched per feed and handed over in one action so
+ * the keyer's type-ahead queue sees them in order with the commands that
+ * bracket them.
+ *
+ * Keyer-side effects are delivered through action_cb (winkeyer_action_t);
+ * the engine keeps only the WK registers the host can read back. Status
+ * and speed-pot bytes are pushed by winkeyer_update() when the keyer
+ * state it is given changes while the host port is open.
+ *
+ * Differences from a real WK2:
+ * - Buffered commands (speed change, PTT, key, wait, pointer) act when
+ *   received; text is compiled only a few characters ahead of the air,
+ *   so a buffered speed change lands close to where it was queued.
+ * - Merged letters (0x1B) are sent as a `<..>` prosign tag.
+ * - No EEPROM: dump returns nothing, load is accepted and discarded.
+ * - The speed pot reports the keyer's WPM (set from any source).
+ *
+ * Single-threaded: feed and update from the same task.
+ */
+
+#ifndef KEYER_WINKEYER_H
+#define KEYER_WINKEYER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Firmware revision reported on host open (WK2 = 23) */
+#define WINKEYER_VERSION 23
+
+/** Text bytes collected before they are handed over */
+#define WINKEYER_TEXT_MAX 64
+
+/** Status byte: fixed tag bits and flags */
+#define WINKEYER_STATUS_TAG      0xC0
+#define WINKEYER_STATUS_XOFF     0x01  /**< Buffer more than 2/3 full */
+#define WINKEYER_STATUS_BREAKIN  0x02  /**< Paddle break-in */
+#define WINKEYER_STATUS_BUSY     0x04  /**< Sending */
+#define WINKEYER_STATUS_KEYDOWN  0x08  /**< Key-down (tune) */
+#define WINKEYER_STATUS_WAIT     0x10  /**< Waiting (buffered wait) */
+
+/** Speed pot byte tag */
+#define WINKEYER_POT_TAG         0x80
+
+/**
+ * @brief Register values, in Load Defaults (0x0F) / Get Values order
+ */
+typedef enum {
+    WINKEYER_REG_MODE = 0,
+    WINKEYER_REG_SPEED,
+    WINKEYER_REG_SIDETONE,
+    WINKEYER_REG_WEIGHT,
+    WINKEYER_REG_LEAD,
+    WINKEYER_REG_TAIL,
+    WINKEYER_REG_MIN_WPM,
+    WINKEYER_REG_WPM_RANGE,
+    WINKEYER_REG_EXTENSION,
+    WINKEYER_REG_KEY_COMP,
+    WINKEYER_REG_FARNSWORTH,
+    WINKEYER_REG_SWITCHPOINT,
+    WINKEYER_REG_RATIO,
+    WINKEYER_REG_PIN_CONFIG,
+    WINKEYER_REG_SPARE,
+    WINKEYER_REG_COUNT
+} winkeyer_reg_t;
+
+/**
+ * @brief What the host asked the keyer to do
+ */
+typedef enum {
+    WINKEYER_ACTION_TEXT = 0,     /**< Queue text / len */
+    WINKEYER_ACTION_BACKSPACE,    /**< Take back the newest queued character */
+    WINKEYER_ACTION_CLEAR,        /**< Stop sending, drop the buffer */
+    WINKEYER_ACTION_SPEED,        /**< value = WPM */
+    WINKEYER_ACTION_WEIGHT,       /**< value = weight (10-90, 50 = 1:3) */
+    WINKEYER_ACTION_SIDETONE,     /**< value = tone in Hz */
+    WINKEYER_ACTION_PAUSE,        /**< value = 1 pause, 0 resume */
+    WINKEYER_ACTION_KEY,          /**< value = 1 key down, 0 key up (tune) */
+    WINKEYER_ACTION_MESSAGE,      /**< value = message slot (0-based) */
+    WINKEYER_ACTION_HOST,         /**< value = 1 host open, 0 host closed */
+    WINKEYER_ACTION_RADIO,        /**< value = radio 1-2 (PinConfig KeyOut1/KeyOut2) */
+} winkeyer_action_type_t;
+
+/**
+ * @brief One action (text valid only during the callback)
+ */
+typedef struct {
+    winkeyer_action_type_t type;
+    uint16_t value;
+    const char *text;
+    size_t len;
+} winkeyer_action_t;
+
+/**
+ * @brief Keyer state reported to the host
+ */
+typedef struct {
+    bool busy;       /**< Text being sent */
+    bool breakin;    /**< Paddle in use */
+    bool key_down;   /**< Key held down (tune) */
+    bool xoff;       /**< Type-ahead more than 2/3 full */
+    uint8_t wpm;     /**< Current speed */
+} winkeyer_status_t;
+
+/**
+ * @brief Bytes to the host (required)
+ */
+typedef void (*winkeyer_send_cb_t)(const uint8_t *data, size_t len, void *user_data);
+
+/**
+ * @brief Keyer action (required)
+ */
+typedef void (*winkeyer_action_cb_t)(const winkeyer_action_t *action, void *user_data);
+
+/**
+ * @brief Engine configuration
+ */
+typedef struct {
+    winkeyer_send_cb_t send_cb;
+    winkeyer_action_cb_t action_cb;
+    void *user_data;
+} winkeyer_config_t;
+
+/**
+ * @brief Counters (console)
+ */
+typedef struct {
+    uint32_t commands;      /**< Commands executed */
+    uint32_t text_bytes;    /**< Text bytes queued */
+    uint32_t status_sent;   /**< Status bytes pushed */
+    uint32_t pot_sent;      /**< Speed pot bytes pushed */
+} winkeyer_stats_t;
+
+/**
+ * @brief Engine state
+ */
+typedef struct {
+    winkeyer_send_cb_t send_cb;
+    winkeyer_action_cb_t action_cb;
+    void *user_data;
+
+    bool host_open;
+    uint8_t regs[WINKEYER_REG_COUNT];
+
+    /* Parser */
+    uint8_t cmd;                       /**< Command collecting arguments */
+    uint8_t need;                      /**< Argument bytes still expected */
+    uint8_t got;                       /**< Argument bytes collected */
+    uint8_t args[WINKEYER_REG_COUNT];  /**< Longest argument list is Load Defaults */
+    uint16_t discard;                  /**< Bytes to drop (EEPROM load) */
+    char text[WINKEYER_TEXT_MAX];
+    size_t text_len;
+
+    /* Reporting */
+    winkeyer_status_t status;          /**< Last keyer state given */
+    uint8_t status_sent;               /**< Last status byte pushed */
+    uint8_t pot_sent;                  /**< Last pot byte pushed (0 = none) */
+
+    winkeyer_stats_t stats;
+} winkeyer_t;
+
+/**
+ * @brief Initialize (host closed, WK2 power-on registers)
+ */
+void winkeyer_init(winkeyer_t *wk, const winkeyer_config_t *config);
+
+/**
+ * @brief Feed bytes from the host
+ *
+ * Replies are sent and actions delivered before this returns.
+ */
+void winkeyer_feed(winkeyer_t *wk, const uint8_t *data, size_t len);
+
+/**
+ * @brief Give the keyer state; pushes status / pot bytes that changed
+ *
+ * Call often (every millisecond) while the host port is open.
+ */
+void winkeyer_update(winkeyer_t *wk, const winkeyer_status_t *status);
+
+/** Status byte for a keyer state */
+uint8_t winkeyer_status_byte(const winkeyer_status_t *status);
+
+/** Host mode is open */
+static inline bool winkeyer_host_open(const winkeyer_t *wk) {
+    return wk->host_open;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WINKEYER_H */
@@ -0,0 +1,36 @@
+/**
+ * @file winkeyer_keyer.h
+ * @brief WinKeyer engine binding to this keyer
+ *
+ * Maps winkeyer_t actions onto the text keyer (type-ahead queue, pause,
+ * abort, memories) and the config (speed, weight, sidetone), and reads
+ * the keyer state the engine reports back. Shared by every WinKeyer
+ * transport, so all sessions drive the same text keyer and config.
+ *
+ * Safe from any Core 1 task (text keyer and config calls are lock-free).
+ */
+
+#ifndef KEYER_WINKEYER_KEYER_H
+#define KEYER_WINKEYER_KEYER_H
+
+#include "winkeyer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Apply an engine action (winkeyer_action_cb_t; user_data unused)
+ */
+void winkeyer_keyer_action(const winkeyer_action_t *action, void *user_data);
+
+/**
+ * @brief Current keyer state for winkeyer_update()
+ */
+void winkeyer_keyer_status(winkeyer_status_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WINKEYER_KEYER_H */
@@ -0,0 +1,61 @@
+/**
+ * @file winkeyer_tcp.h
+ * @brief WinKeyer 2 host port over TCP
+ *
+ * With winkeyer.wk_tcp_port set, winkeyer_tcp_task listens on that port
+ * for network loggers (N1MM+, Win-Test and friends via a TCP serial
+ * bridge). Each connection gets its own protocol engine, so every logger
+ * sees its own host open / echo / status replies, while all of them drive
+ * the same text keyer type-ahead queue and config through
+ * winkeyer_keyer.h: the last command received wins (speed, clear, pause).
+ *
+ * With winkeyer.wk_tcp_vpn_only set, a connection is accepted only when
+ * it arrived on the WireGuard tunnel address (keyer_vpn) while the
+ * tunnel is up.
+ *
+ * Runs in its own task on Core 1, blocking in select() with a 1 ms
+ * timeout that doubles as the status poll. Sockets use TCP_NODELAY so
+ * single status bytes are not held back by Nagle.
+ */
+
+#ifndef KEYER_WINKEYER_TCP_H
+#define KEYER_WINKEYER_TCP_H
+
+#include "winkeyer.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Concurrent logger connections */
+#define WINKEYER_TCP_MAX_SESSIONS 3
+
+/**
+ * @brief Listener snapshot (console)
+ */
+typedef struct {
+    uint16_t port;          /**< Listen port (0 = off) */
+    size_t sessions;        /**< Connections open now */
+    size_t host_open;       /**< Of which in host mode */
+    uint32_t accepted;      /**< Connections accepted since boot */
+    uint32_t refused;       /**< Turned away (full, or not on the VPN) */
+    winkeyer_stats_t stats; /**< Engine counters summed over open sessions */
+} winkeyer_tcp_info_t;
+
+/**
+ * @brief TCP port task (deletes itself unless winkeyer.wk_tcp_port is set)
+ */
+void winkeyer_tcp_task(void *arg);
+
+/**
+ * @brief Listener snapshot (best-effort from other tasks)
+ */
+void winkeyer_tcp_get_info(winkeyer_tcp_info_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_WINKEYER_TCP_H */
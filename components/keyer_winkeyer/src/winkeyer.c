@@ -0,0 +1,404 @@
+/**
+ * @file winkeyer.c
+ * @brief K1EL WinKeyer 2 host-mode protocol engine
+ *
+ * Bytes 0x20-0x7F are text; 0x00-0x1F start a command whose argument
+ * count is fixed per command (ARG_COUNT), except Admin (0x00) and Pointer
+ * (0x16), whose first argument selects how many more follow.
+ */
+
+#include "winkeyer.h"
+#include <string.h>
+
+#define CMD_NONE 0xFFU
+
+/* Immediate commands */
+#define CMD_ADMIN        0x00U
+#define CMD_SIDETONE     0x01U
+#define CMD_SPEED        0x02U
+#define CMD_WEIGHT       0x03U
+#define CMD_PTT_TIMING   0x04U
+#define CMD_POT_SETUP    0x05U
+#define CMD_PAUSE        0x06U
+#define CMD_GET_POT      0x07U
+#define CMD_BACKSPACE    0x08U
+#define CMD_PIN_CONFIG   0x09U
+#define CMD_CLEAR        0x0AU
+#define CMD_KEY_IMMED    0x0BU
+#define CMD_FARNSWORTH   0x0DU
+#define CMD_MODE         0x0EU
+#define CMD_DEFAULTS     0x0FU
+#define CMD_EXTENSION    0x10U
+#define CMD_KEY_COMP     0x11U
+#define CMD_SWITCHPOINT  0x12U
+#define CMD_STATUS       0x15U
+#define CMD_POINTER      0x16U
+#define CMD_RATIO        0x17U
+
+/* Buffered commands */
+#define CMD_MERGE        0x1BU
+#define CMD_BUF_SPEED    0x1CU
+#define CMD_CANCEL_SPEED 0x1EU
+
+/* Admin sub-commands */
+#define ADMIN_CALIBRATE  0U
+#define ADMIN_RESET      1U
+#define ADMIN_OPEN       2U
+#define ADMIN_CLOSE      3U
+#define ADMIN_ECHO       4U
+#define ADMIN_PADDLE_A2D 5U
+#define ADMIN_SPEED_A2D  6U
+#define ADMIN_GET_VALUES 7U
+#define ADMIN_LOAD_EEPROM 13U
+#define ADMIN_MESSAGE    14U
+#define ADMIN_X1MODE     15U
+
+/** EEPROM image size (Load EEPROM argument) */
+#define EEPROM_SIZE 256U
+
+/** Argument bytes per command (Admin and Pointer: the selector only) */
+static const uint8_t ARG_COUNT[0x20] = {
+    1, 1, 1, 1, 2, 3, 1, 0,   /* 00-07 */
+    0, 1, 0, 1, 1, 1, 1, 15,  /* 08-0F */
+    1, 1, 1, 0, 1, 0, 1, 1,   /* 10-17 */
+    1, 1, 1, 2, 1, 1, 0, 0,   /* 18-1F */
+};
+
+/** WK2 power-on registers */
+static const uint8_t DEFAULT_REGS[WINKEYER_REG_COUNT] = {
+    [WINKEYER_REG_MODE] = 0x00,
+    [WINKEYER_REG_SPEED] = 0,           /* 0 = follow the pot */
+    [WINKEYER_REG_SIDETONE] = 5,        /* 800 Hz */
+    [WINKEYER_REG_WEIGHT] = 50,
+    [WINKEYER_REG_LEAD] = 0,
+    [WINKEYER_REG_TAIL] = 0,
+    [WINKEYER_REG_MIN_WPM] = 10,
+    [WINKEYER_REG_WPM_RANGE] = 25,
+    [WINKEYER_REG_EXTENSION] = 0,
+    [WINKEYER_REG_KEY_COMP] = 0,
+    [WINKEYER_REG_FARNSWORTH] = 0,
+    [WINKEYER_REG_SWITCHPOINT] = 50,
+    [WINKEYER_REG_RATIO] = 50,
+    [WINKEYER_REG_PIN_CONFIG] = 0x05,
+    [WINKEYER_REG_SPARE] = 0xFF,
+};
+
+void winkeyer_init(winkeyer_t *wk, const winkeyer_config_t *config) {
+    memset(wk, 0, sizeof(*wk));
+    wk->send_cb = config->send_cb;
+    wk->action_cb = config->action_cb;
+    wk->user_data = config->user_data;
+    memcpy(wk->regs, DEFAULT_REGS, sizeof(wk->regs));
+    wk->cmd = CMD_NONE;
+}
+
+/* ============================================================================
+ * Output
+ * ============================================================================ */
+
+static void send_bytes(winkeyer_t *wk, const uint8_t *data, size_t len) {
+    wk->send_cb(data, len, wk->user_data);
+}
+
+static void send_byte(winkeyer_t *wk, uint8_t b) {
+    send_bytes(wk, &b, 1);
+}
+
+static void act(winkeyer_t *wk, winkeyer_action_type_t type, uint16_t value) {
+    winkeyer_action_t action = { .type = type, .value = value, .text = NULL, .len = 0 };
+    wk->action_cb(&action, wk->user_data);
+}
+
+/** Hand collected text over (before any command, so order is kept) */
+static void flush_text(winkeyer_t *wk) {
+    if (wk->text_len == 0) {
+        return;
+    }
+    winkeyer_action_t action = {
+        .type = WINKEYER_ACTION_TEXT, .value = 0, .text = wk->text, .len = wk->text_len,
+    };
+    wk->action_cb(&action, wk->user_data);
+    wk->stats.text_bytes += (uint32_t)wk->text_len;
+    wk->text_len = 0;
+}
+
+static void queue_text(winkeyer_t *wk, char c) {
+    if (wk->text_len == WINKEYER_TEXT_MAX) {
+        flush_text(wk);
+    }
+    wk->text[wk->text_len++] = c;
+}
+
+uint8_t winkeyer_status_byte(const winkeyer_status_t *status) {
+    uint8_t b = WINKEYER_STATUS_TAG;
+    if (status->xoff) b |= WINKEYER_STATUS_XOFF;
+    if (status->breakin) b |= WINKEYER_STATUS_BREAKIN;
+    if (status->busy) b |= WINKEYER_STATUS_BUSY;
+    if (status->key_down) b |= WINKEYER_STATUS_KEYDOWN;
+    return b;
+}
+
+/** Speed pot byte: speed above MinWPM, within the pot range */
+static uint8_t pot_byte(const winkeyer_t *wk, uint8_t wpm) {
+    uint8_t min = wk->regs[WINKEYER_REG_MIN_WPM];
+    uint8_t range = wk->regs[WINKEYER_REG_WPM_RANGE];
+    uint8_t v = (wpm > min) ? (uint8_t)(wpm - min) : 0U;
+    if (v > range) {
+        v = range;
+    }
+    return (uint8_t)(WINKEYER_POT_TAG | (v & 0x3FU));
+}
+
+/* ============================================================================
+ * Commands
+ * ============================================================================ */
+
+/** WK2 sidetone code: 4000 Hz / n (low nibble 1-10) */
+static uint16_t sidetone_hz(uint8_t code) {
+    uint8_t n = code & 0x0FU;
+    if (n == 0U) n = 1U;
+    if (n > 10U) n = 10U;
+    return (uint16_t)(4000U / n);
+}
+
+/** PinConfig key outputs (bit 2 KeyOut1, bit 3 KeyOut2): SO2R radio */
+static void set_key_outputs(winkeyer_t *wk, uint8_t pin_config) {
+    switch (pin_config & 0x0CU) {
+        case 0x04U: act(wk, WINKEYER_ACTION_RADIO, 1); break;
+        case 0x08U: act(wk, WINKEYER_ACTION_RADIO, 2); break;
+        default: break;  /* Both or neither: the focus stays */
+    }
+}
+
+static void set_speed(winkeyer_t *wk, uint8_t wpm) {
+    if (wpm == 0U) {
+        return;  /* Follow the pot: the keyer keeps its own speed */
+    }
+    act(wk, WINKEYER_ACTION_SPEED, wpm);
+    wk->status.wpm = wpm;               /* Not a pot move: no pot byte for it */
+    wk->pot_sent = pot_byte(wk, wpm);
+}
+
+static void exec_admin(winkeyer_t *wk) {
+    switch (wk->args[0]) {
+        case ADMIN_RESET:
+            memcpy(wk->regs, DEFAULT_REGS, sizeof(wk->regs));
+            if (wk->host_open) {
+                wk->host_open = false;
+                act(wk, WINKEYER_ACTION_HOST, 0);
+            }
+            break;
+        case ADMIN_OPEN:
+            wk->host_open = true;
+            wk->status_sent = 0;        /* Current status goes out on the next update */
+            send_byte(wk, WINKEYER_VERSION);
+            act(wk, WINKEYER_ACTION_HOST, 1);
+            break;
+        case ADMIN_CLOSE:
+            wk->host_open = false;
+            act(wk, WINKEYER_ACTION_HOST, 0);
+            break;
+        case ADMIN_ECHO:
+            send_byte(wk, wk->args[1]);
+            break;
+        case ADMIN_PADDLE_A2D:
+        case ADMIN_SPEED_A2D:
+            send_byte(wk, 0);           /* No analog inputs */
+            break;
+        case ADMIN_GET_VALUES:
+            send_bytes(wk, wk->regs, sizeof(wk->regs));
+            break;
+        case ADMIN_MESSAGE:
+            if (wk->args[1] >= 1U) {
+                act(wk, WINKEYER_ACTION_MESSAGE, (uint16_t)(wk->args[1] - 1U));
+            }
+            break;
+        default:
+            break;  /* Calibrate, WK1/WK2 mode, X1MODE, EEPROM: nothing to do */
+    }
+}
+
+static void exec(winkeyer_t *wk) {
+    const uint8_t *a = wk->args;
+    wk->stats.commands++;
+
+    switch (wk->cmd) {
+        case CMD_ADMIN:
+            exec_admin(wk);
+            break;
+        case CMD_SIDETONE:
+            wk->regs[WINKEYER_REG_SIDETONE] = a[0];
+            act(wk, WINKEYER_ACTION_SIDETONE, sidetone_hz(a[0]));
+            break;
+        case CMD_SPEED:
+            wk->regs[WINKEYER_REG_SPEED] = a[0];
+            set_speed(wk, a[0]);
+            break;
+        case CMD_WEIGHT:
+            wk->regs[WINKEYER_REG_WEIGHT] = a[0];
+            act(wk, WINKEYER_ACTION_WEIGHT, a[0]);
+            break;
+        case CMD_PTT_TIMING:
+            wk->regs[WINKEYER_REG_LEAD] = a[0];
+            wk->regs[WINKEYER_REG_TAIL] = a[1];
+            break;
+        case CMD_POT_SETUP:
+            wk->regs[WINKEYER_REG_MIN_WPM] = a[0];
+            wk->regs[WINKEYER_REG_WPM_RANGE] = a[1];
+            wk->pot_sent = 0;           /* Report against the new range */
+            break;
+        case CMD_PAUSE:
+            act(wk, WINKEYER_ACTION_PAUSE, (a[0] != 0U) ? 1U : 0U);
+            break;
+        case CMD_GET_POT:
+            wk->pot_sent = pot_byte(wk, wk->status.wpm);
+            send_byte(wk, wk->pot_sent);
+            break;
+        case CMD_BACKSPACE:
+            act(wk, WINKEYER_ACTION_BACKSPACE, 0);
+            break;
+        case CMD_PIN_CONFIG:
+            wk->regs[WINKEYER_REG_PIN_CONFIG] = a[0];
+            set_key_outputs(wk, a[0]);
+            break;
+        case CMD_CLEAR:
+            act(wk, WINKEYER_ACTION_CLEAR, 0);
+            break;
+        case CMD_KEY_IMMED:
+            act(wk, WINKEYER_ACTION_KEY, (a[0] != 0U) ? 1U : 0U);
+            break;
+        case CMD_FARNSWORTH:
+            wk->regs[WINKEYER_REG_FARNSWORTH] = a[0];
+            break;
+        case CMD_MODE:
+            wk->regs[WINKEYER_REG_MODE] = a[0];
+            break;
+        case CMD_DEFAULTS:
+            memcpy(wk->regs, a, sizeof(wk->regs));
+            act(wk, WINKEYER_ACTION_SIDETONE, sidetone_hz(a[WINKEYER_REG_SIDETONE]));
+            act(wk, WINKEYER_ACTION_WEIGHT, a[WINKEYER_REG_WEIGHT]);
+            set_key_outputs(wk, a[WINKEYER_REG_PIN_CONFIG]);
+            set_speed(wk, a[WINKEYER_REG_SPEED]);
+            wk->pot_sent = 0;
+            break;
+        case CMD_EXTENSION:
+            wk->regs[WINKEYER_REG_EXTENSION] = a[0];
+            break;
+        case CMD_KEY_COMP:
+            wk->regs[WINKEYER_REG_KEY_COMP] = a[0];
+            break;
+        case CMD_SWITCHPOINT:
+            wk->regs[WINKEYER_REG_SWITCHPOINT] = a[0];
+            break;
+        case CMD_STATUS:
+            wk->status_sent = winkeyer_status_byte(&wk->status);
+            send_byte(wk, wk->status_sent);
+            break;
+        case CMD_RATIO:
+            wk->regs[WINKEYER_REG_RATIO] = a[0];
+            break;
+        case CMD_MERGE: {
+            char tag[4] = { '<', (char)a[0], (char)a[1], '>' };
+            for (size_t i = 0; i < sizeof(tag); i++) {
+                queue_text(wk, tag[i]);
+            }
+            flush_text(wk);
+            break;
+        }
+        case CMD_BUF_SPEED:
+            set_speed(wk, a[0]);
+            break;
+        case CMD_CANCEL_SPEED:
+            set_speed(wk, wk->regs[WINKEYER_REG_SPEED]);
+            break;
+        default:
+            break;  /* Pointer, HSCW, PTT, software paddle, key/wait, NOP */
+    }
+}
+
+/** First argument in: Admin and Pointer decide how many more follow */
+static uint8_t extra_args(winkeyer_t *wk) {
+    uint8_t sub = wk->args[0];
+    if (wk->cmd == CMD_ADMIN) {
+        switch (sub) {
+            case ADMIN_CALIBRATE:
+            case ADMIN_ECHO:
+            case ADMIN_MESSAGE:
+            case ADMIN_X1MODE:
+                return 1;
+            case ADMIN_LOAD_EEPROM:
+                wk->discard = EEPROM_SIZE;
+                return 0;
+            default:
+                return 0;
+        }
+    }
+    if (wk->cmd == CMD_POINTER) {
+        return (sub == 1U || sub == 3U) ? 1U : 0U;
+    }
+    return 0;
+}
+
+void winkeyer_feed(winkeyer_t *wk, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = data[i];
+
+        if (wk->discard > 0) {
+            wk->discard--;
+            continue;
+        }
+
+        if (wk->cmd == CMD_NONE) {
+            if (b >= 0x20U) {
+                if (b < 0x80U) {
+                    queue_text(wk, (char)b);
+                }
+                continue;
+            }
+            flush_text(wk);
+            wk->cmd = b;
+            wk->got = 0;
+            wk->need = ARG_COUNT[b];
+            if (wk->need == 0U) {
+                exec(wk);
+                wk->cmd = CMD_NONE;
+            }
+            continue;
+        }
+
+        if (wk->got < sizeof(wk->args)) {
+            wk->args[wk->got] = b;
+        }
+        wk->got++;
+        wk->need--;
+        if (wk->got == 1U && (wk->cmd == CMD_ADMIN || wk->cmd == CMD_POINTER)) {
+            wk->need = extra_args(wk);
+        }
+        if (wk->need == 0U) {
+            exec(wk);
+            wk->cmd = CMD_NONE;
+        }
+    }
+    flush_text(wk);
+}
+
+void winkeyer_update(winkeyer_t *wk, const winkeyer_status_t *status) {
+    wk->status = *status;
+    if (!wk->host_open) {
+        return;
+    }
+
+    uint8_t st = winkeyer_status_byte(status);
+    if (st != wk->status_sent) {
+        wk->status_sent = st;
+        send_byte(wk, st);
+        wk->stats.status_sent++;
+    }
+
+    uint8_t pot = pot_byte(wk, status->wpm);
+    if (pot != wk->pot_sent) {
+        wk->pot_sent = pot;
+        send_byte(wk, pot);
+        wk->stats.pot_sent++;
+    }
+}
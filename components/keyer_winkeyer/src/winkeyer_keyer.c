@@ -0,0 +1,98 @@
+/**
+ * @file winkeyer_keyer.c
+ * @brief WinKeyer engine binding to the text keyer and config
+ */
+
+#include "winkeyer_keyer.h"
+#include "text_keyer.h"
+#include "text_memory.h"
+#include "config.h"
+#include "config_console.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+/** Paddle activity from the RT task (break-in) */
+extern atomic_bool g_paddle_active;
+
+/** Set a numeric parameter, clamped to its schema range */
+static void set_param_clamped(const char *name, uint32_t value) {
+    const param_descriptor_t *p = config_find_param(name);
+    if (p == NULL) {
+        return;
+    }
+    if (value < p->min) value = p->min;
+    if (value > p->max) value = p->max;
+
+    char buf[12];
+    snprintf(buf, sizeof(buf), "%u", (unsigned)value);
+    (void)config_set_param_str(name, buf);
+}
+
+/** Queue text: the engine hands over at most WINKEYER_TEXT_MAX bytes */
+static void send_text(const char *text, size_t len) {
+    char buf[WINKEYER_TEXT_MAX + 1];
+    if (len > WINKEYER_TEXT_MAX) {
+        len = WINKEYER_TEXT_MAX;
+    }
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = text[i];
+    }
+    buf[len] = '\0';
+    (void)text_keyer_send(buf);  /* Full queue: the host sees XOFF first */
+}
+
+void winkeyer_keyer_action(const winkeyer_action_t *action, void *user_data) {
+    (void)user_data;
+
+    switch (action->type) {
+        case WINKEYER_ACTION_TEXT:
+            send_text(action->text, action->len);
+            break;
+        case WINKEYER_ACTION_BACKSPACE:
+            (void)text_keyer_cancel_last(false);
+            break;
+        case WINKEYER_ACTION_CLEAR:
+            text_keyer_abort();
+            break;
+        case WINKEYER_ACTION_SPEED:
+            set_param_clamped("wpm", action->value);
+            break;
+        case WINKEYER_ACTION_WEIGHT:
+            set_param_clamped("weight", action->value);
+            break;
+        case WINKEYER_ACTION_SIDETONE:
+            set_param_clamped("sidetone_freq_hz", action->value);
+            break;
+        case WINKEYER_ACTION_RADIO:
+            set_param_clamped("radio", action->value);
+            break;
+        case WINKEYER_ACTION_PAUSE:
+            if (action->value != 0U) {
+                text_keyer_pause();
+            } else {
+                text_keyer_resume();
+            }
+            break;
+        case WINKEYER_ACTION_MESSAGE:
+            if (action->value < TEXT_MEMORY_SLOTS) {
+                (void)text_keyer_send_memory((uint8_t)action->value);
+            }
+            break;
+        case WINKEYER_ACTION_KEY:     /* No tune path in the text keyer */
+        case WINKEYER_ACTION_HOST:
+        default:
+            break;
+    }
+}
+
+void winkeyer_keyer_status(winkeyer_status_t *out) {
+    text_keyer_buffer_t buffer;
+    text_keyer_get_buffer(&buffer);
+
+    uint32_t wpm = CONFIG_GET_WPM();
+    out->busy = text_keyer_get_state() != TEXT_KEYER_IDLE;
+    out->breakin = atomic_load_explicit(&g_paddle_active, memory_order_acquire);
+    out->key_down = false;
+    out->xoff = buffer.free * 3U < buffer.capacity;
+    out->wpm = (uint8_t)((wpm > 99U) ? 99U : wpm);
+}
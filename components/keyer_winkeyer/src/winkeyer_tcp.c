@@ -0,0 +1,239 @@
+/**
+ * @file winkeyer_tcp.c
+ * @brief WinKeyer 2 host port over TCP
+ */
+
+#include "winkeyer_tcp.h"
+#include "winkeyer_keyer.h"
+#include "vpn.h"
+#include "config.h"
+#include "rt_log.h"
+
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+/** select() timeout: the status poll period */
+#define WK_TCP_POLL_MS 1
+
+/** Listener retry after a failed open */
+#define WK_TCP_RETRY_MS 1000
+
+typedef struct {
+    int sock;
+    bool broken;       /**< A send failed: close at the end of the pass */
+    winkeyer_t wk;
+} wk_session_t;
+
+static struct {
+    uint16_t port;
+    bool vpn_only;
+    int listen_sock;
+    wk_session_t sessions[WINKEYER_TCP_MAX_SESSIONS];
+    uint32_t accepted;
+    uint32_t refused;
+} s_tcp = { .listen_sock = -1 };
+
+static bool set_nonblocking(int sock) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0) {
+        return false;
+    }
+    return fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/** Replies are a few bytes: a full send buffer means the logger is gone */
+static void session_send(const uint8_t *data, size_t len, void *user_data) {
+    wk_session_t *s = (wk_session_t *)user_data;
+    if (s->sock < 0 || s->broken) {
+        return;
+    }
+    ssize_t n = send(s->sock, data, len, MSG_DONTWAIT);
+    if (n != (ssize_t)len) {
+        s->broken = true;
+    }
+}
+
+static bool open_listener(void) {
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(s_tcp.port),
+        .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int reuse = 1;
+    if (sock >= 0) {
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+    if (sock < 0 || !set_nonblocking(sock) ||
+        bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(sock, WINKEYER_TCP_MAX_SESSIONS) < 0) {
+        RT_ERROR(&g_bg_log_stream, esp_timer_get_time(),
+                 "WinKeyer TCP: listen on %u failed: %d", s_tcp.port, errno);
+        if (sock >= 0) {
+            close(sock);
+        }
+        return false;
+    }
+
+    s_tcp.listen_sock = sock;
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "WinKeyer TCP: listening on %u%s",
+            s_tcp.port, s_tcp.vpn_only ? " (VPN only)" : "");
+    return true;
+}
+
+/** The connection came in on the WireGuard tunnel address */
+static bool on_vpn(int sock) {
+    if (!vpn_is_connected()) {
+        return false;
+    }
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    if (getsockname(sock, (struct sockaddr *)&local, &len) < 0) {
+        return false;
+    }
+    struct in_addr tunnel;
+    return inet_aton(vpn_get_address(), &tunnel) != 0 &&
+           local.sin_addr.s_addr == tunnel.s_addr;
+}
+
+static wk_session_t *free_session(void) {
+    for (size_t i = 0; i < WINKEYER_TCP_MAX_SESSIONS; i++) {
+        if (s_tcp.sessions[i].sock < 0) {
+            return &s_tcp.sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static void accept_sessions(void) {
+    int sock;
+    while ((sock = accept(s_tcp.listen_sock, NULL, NULL)) >= 0) {
+        wk_session_t *s = free_session();
+        if (s == NULL || !set_nonblocking(sock) || (s_tcp.vpn_only && !on_vpn(sock))) {
+            close(sock);
+            s_tcp.refused++;
+            continue;
+        }
+
+        int nodelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        winkeyer_config_t cfg = {
+            .send_cb = session_send,
+            .action_cb = winkeyer_keyer_action,
+            .user_data = s,
+        };
+        winkeyer_init(&s->wk, &cfg);
+        s->broken = false;
+        s->sock = sock;
+        s_tcp.accepted++;
+        RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "WinKeyer TCP: logger connected");
+    }
+}
+
+static void close_session(wk_session_t *s) {
+    close(s->sock);
+    s->sock = -1;
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "WinKeyer TCP: logger disconnected");
+}
+
+/** Feed what arrived; false once the peer closed or the socket failed */
+static bool receive(wk_session_t *s) {
+    uint8_t buf[128];
+    ssize_t n;
+    while ((n = recv(s->sock, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        winkeyer_feed(&s->wk, buf, (size_t)n);
+    }
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+static void wait_for_io(void) {
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    int maxfd = s_tcp.listen_sock;
+    FD_SET(s_tcp.listen_sock, &rfds);
+    for (size_t i = 0; i < WINKEYER_TCP_MAX_SESSIONS; i++) {
+        int fd = s_tcp.sessions[i].sock;
+        if (fd >= 0) {
+            FD_SET(fd, &rfds);
+            if (fd > maxfd) {
+                maxfd = fd;
+            }
+        }
+    }
+    struct timeval tv = {0, WK_TCP_POLL_MS * 1000};
+    (void)select(maxfd + 1, &rfds, NULL, NULL, &tv);
+}
+
+void winkeyer_tcp_task(void *arg) {
+    (void)arg;
+
+    s_tcp.port = CONFIG_GET_WK_TCP_PORT();
+    s_tcp.vpn_only = CONFIG_GET_WK_TCP_VPN_ONLY();
+    for (size_t i = 0; i < WINKEYER_TCP_MAX_SESSIONS; i++) {
+        s_tcp.sessions[i].sock = -1;
+    }
+    if (s_tcp.port == 0) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    while (!open_listener()) {
+        vTaskDelay(pdMS_TO_TICKS(WK_TCP_RETRY_MS));
+    }
+
+    winkeyer_status_t status;
+    for (;;) {
+        wait_for_io();
+        accept_sessions();
+
+        /* One keyer state for every session: they share the text keyer */
+        winkeyer_keyer_status(&status);
+        for (size_t i = 0; i < WINKEYER_TCP_MAX_SESSIONS; i++) {
+            wk_session_t *s = &s_tcp.sessions[i];
+            if (s->sock < 0) {
+                continue;
+            }
+            if (!receive(s)) {
+                close_session(s);
+                continue;
+            }
+            winkeyer_update(&s->wk, &status);
+            if (s->broken) {
+                close_session(s);
+            }
+        }
+    }
+}
+
+void winkeyer_tcp_get_info(winkeyer_tcp_info_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->port = s_tcp.port;
+    out->accepted = s_tcp.accepted;
+    out->refused = s_tcp.refused;
+    for (size_t i = 0; i < WINKEYER_TCP_MAX_SESSIONS; i++) {
+        const wk_session_t *s = &s_tcp.sessions[i];
+        if (s->sock < 0) {
+            continue;
+        }
+        out->sessions++;
+        if (winkeyer_host_open(&s->wk)) {
+            out->host_open++;
+        }
+        out->stats.commands += s->wk.stats.commands;
+        out->stats.text_bytes += s->wk.stats.text_bytes;
+        out->stats.status_sent += s->wk.stats.status_sent;
+        out->stats.pot_sent += s->wk.stats.pot_sent;
+    }
+}
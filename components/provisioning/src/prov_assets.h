@@ -0,0 +1,49 @@
+/**
+ * @file prov_assets.h
+ * @brief Portal pages, compressed at build time
+ *
+ * www/ is run through keyer_webui's embed_assets.py (--prefix prov) into
+ * prov_assets.c in the build directory: gzip plus Brotli when smaller,
+ * the same pipeline as the main WebUI. Only the script is shared; the
+ * table and its lookup live here.
+ */
+
+#ifndef PROV_ASSETS_H
+#define PROV_ASSETS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Page descriptor (same fields as webui_asset_t)
+ */
+typedef struct {
+    const char *path;           /**< URL path (e.g., "/index.html") */
+    const char *content_type;   /**< MIME type */
+    const uint8_t *data;        /**< Gzip-compressed data */
+    size_t length;              /**< Data length */
+    bool gzipped;               /**< Always true */
+    const uint8_t *br_data;     /**< Brotli-compressed data, NULL if none */
+    size_t br_length;           /**< Brotli data length (0 if none) */
+    const char *etag;           /**< Quoted content hash */
+    bool immutable;             /**< Unused here */
+} prov_asset_t;
+
+/**
+ * @brief Find a page by path ("/" is index.html)
+ * @return Page or NULL
+ */
+const prov_asset_t *prov_embedded_find(const char *path);
+
+/**
+ * @brief Number of pages
+ */
+size_t prov_embedded_count(void);
+
+/**
+ * @brief Page table, NULL-path terminated
+ */
+const prov_asset_t *prov_get_assets(void);
+
+#endif /* PROV_ASSETS_H */
@@ -7,6 +7,7 @@
  */
 
 #include "provisioning.h"
+#include "sdkconfig.h"
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -39,6 +40,10 @@ static const char *TAG = "provisioning";
 
 bool provisioning_is_needed(void)
 {
+#ifndef CONFIG_KEYER_PROVISIONING
+    /* No portal built in: boot normally, WiFi stays off until configured */
+    return false;
+#else
     nvs_handle_t handle;
     esp_err_t err = nvs_open(PROV_NVS_NAMESPACE, NVS_READONLY, &handle);
 
@@ -73,6 +78,7 @@ bool provisioning_is_needed(void)
 
     ESP_LOGI(TAG, "WiFi configured (SSID: %s) - normal boot", ssid);
     return false;
+#endif
 }
 
 bool provisioning_check_factory_reset(gpio_num_t dit_gpio, gpio_num_t dah_gpio, uint32_t hold_ms)
@@ -218,6 +224,10 @@ void prov_schedule_reboot(uint32_t delay_ms)
 
 void provisioning_start(void)
 {
+#ifndef CONFIG_KEYER_PROVISIONING
+    ESP_LOGE(TAG, "Provisioning not built in (CONFIG_KEYER_PROVISIONING)");
+    return;
+#else
     ESP_LOGI(TAG, "=== PROVISIONING MODE ===");
     ESP_LOGI(TAG, "Starting AP and web server...");
 
@@ -241,4 +251,5 @@ void provisioning_start(void)
         }
         vTaskDelay(pdMS_TO_TICKS(20));  /* ~50 Hz update for smooth breathing */
     }
+#endif
 }
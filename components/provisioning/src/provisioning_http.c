@@ -9,22 +9,22 @@
 #include <stdlib.h>
 #include "esp_http_server.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "prov_assets.h"
 
 static const char *TAG = "prov_http";
 
 /* External functions */
-extern const char *prov_get_html_form(void);
-extern const char *prov_get_html_success(void);
-extern int prov_wifi_scan(char *json_buf, size_t buf_size);
+extern int prov_wifi_scan(char *json_buf, size_t buf_size, bool refresh);
 extern esp_err_t prov_save_config(const char *ssid, const char *password,
                                    const char *callsign, uint8_t theme);
 extern void prov_schedule_reboot(uint32_t delay_ms);
 
 static httpd_handle_t s_server = NULL;
 
-/* Buffer for scan results JSON */
-#define SCAN_JSON_BUF_SIZE  2048
-static char s_scan_json[SCAN_JSON_BUF_SIZE];
+/* Buffer for scan results JSON (cached list plus the wrapper) */
+#define SCAN_JSON_BUF_SIZE  2176
+static EXT_RAM_BSS_ATTR char s_scan_json[SCAN_JSON_BUF_SIZE];
 
 /* Buffer for POST data */
 #define POST_BUF_SIZE  512
@@ -115,27 +115,62 @@ static bool validate_callsign(const char *callsign)
     return true;
 }
 
+/**
+ * @brief Send a compressed page: Brotli if the client takes it, else gzip
+ */
+static esp_err_t send_page(httpd_req_t *req, const char *path)
+{
+    const prov_asset_t *page = prov_embedded_find(path);
+    if (page == NULL) {
+        ESP_LOGE(TAG, "Page %s missing", path);
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+        return ESP_FAIL;
+    }
+
+    const uint8_t *data = page->data;
+    size_t length = page->length;
+    const char *encoding = "gzip";
+    char accept[64];
+    if (page->br_data != NULL &&
+        httpd_req_get_hdr_value_str(req, "Accept-Encoding", accept, sizeof(accept)) == ESP_OK &&
+        strstr(accept, "br") != NULL) {
+        data = page->br_data;
+        length = page->br_length;
+        encoding = "br";
+    }
+
+    httpd_resp_set_type(req, page->content_type);
+    httpd_resp_set_hdr(req, "Content-Encoding", encoding);
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    return httpd_resp_send(req, (const char *)data, (ssize_t)length);
+}
+
 /**
  * @brief Handler for GET / - serve HTML form
  */
 static esp_err_t handle_root(httpd_req_t *req)
 {
     ESP_LOGI(TAG, "GET /");
-
-    const char *html = prov_get_html_form();
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, html, HTTPD_RESP_USE_STRLEN);
-    return ESP_OK;
+    return send_page(req, "/");
 }
 
 /**
- * @brief Handler for GET /scan - return WiFi networks JSON
+ * @brief Handler for GET /scan[?refresh=1] - cached WiFi networks JSON
+ *
+ * Answers from the background scan's cache at once; refresh starts a
+ * new scan, which the page polls for.
  */
 static esp_err_t handle_scan(httpd_req_t *req)
 {
     ESP_LOGI(TAG, "GET /scan");
 
-    prov_wifi_scan(s_scan_json, sizeof(s_scan_json));
+    char query[32];
+    char value[4];
+    bool refresh = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+                   httpd_query_key_value(query, "refresh", value, sizeof(value)) == ESP_OK &&
+                   value[0] == '1';
+    prov_wifi_scan(s_scan_json, sizeof(s_scan_json), refresh);
 
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, s_scan_json, HTTPD_RESP_USE_STRLEN);
@@ -206,9 +241,7 @@ static esp_err_t handle_save(httpd_req_t *req)
     }
 
     /* Send success page */
-    const char *html = prov_get_html_success();
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, html, HTTPD_RESP_USE_STRLEN);
+    send_page(req, "/success.html");
 
     /* Schedule reboot after response sent */
     prov_schedule_reboot(3500);  /* 3.5s to allow page load + countdown */
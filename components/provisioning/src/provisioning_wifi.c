@@ -3,10 +3,17 @@
  * @brief WiFi AP mode and network scanning for provisioning
  *
  * Creates open AP for initial device setup.
- * Provides WiFi scan functionality for network selection.
+ *
+ * Networks are scanned in the background (at start, then every
+ * PROV_SCAN_PERIOD_US or on request) and the results kept as a ready
+ * JSON document, so the form gets its list at once instead of waiting
+ * for the radio. Scans return to the AP channel between channels to
+ * keep the phone's connection usable meanwhile.
  */
 
 #include <string.h>
+#include <stdio.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -15,6 +22,8 @@
 #include "esp_netif.h"
 #include "esp_log.h"
 #include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
 
 static const char *TAG = "prov_wifi";
 
@@ -24,15 +33,30 @@ static const char *TAG = "prov_wifi";
 #define PROV_AP_MAX_CONN    4
 
 /* Scan configuration */
-#define PROV_SCAN_MAX_AP    20
+#define PROV_SCAN_MAX_AP        20
+#define PROV_SCAN_PERIOD_US     (60LL * 1000 * 1000)
+#define PROV_SCAN_HOME_DWELL_MS 60      /* On the AP channel between channels */
+#define PROV_SCAN_JSON_SIZE     2048
 
 /* State */
 static esp_netif_t *s_ap_netif = NULL;
 static bool s_initialized = false;
+static esp_timer_handle_t s_scan_timer = NULL;
+
+/* Scan results storage (event task only) */
+static EXT_RAM_BSS_ATTR wifi_ap_record_t s_scan_results[PROV_SCAN_MAX_AP];
+
+/*
+ * Cached results, double-buffered: the event task writes the buffer not
+ * published in s_scan_seq and then publishes it; readers copy and check
+ * that the sequence did not move meanwhile.
+ */
+static EXT_RAM_BSS_ATTR char s_scan_json[2][PROV_SCAN_JSON_SIZE];
+static atomic_uint s_scan_seq;          /* Bit 0: buffer to read */
+static atomic_bool s_scanning;
+static atomic_int_fast64_t s_scan_done_us;
 
-/* Scan results storage */
-static wifi_ap_record_t s_scan_results[PROV_SCAN_MAX_AP];
-static uint16_t s_scan_count = 0;
+static void scan_publish(uint16_t count);
 
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                 int32_t event_id, void *event_data)
@@ -51,12 +75,109 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                 ESP_LOGI(TAG, "Station " MACSTR " disconnected", MAC2STR(event->mac));
                 break;
             }
+            case WIFI_EVENT_SCAN_DONE: {
+                uint16_t count = PROV_SCAN_MAX_AP;
+                if (esp_wifi_scan_get_ap_records(&count, s_scan_results) != ESP_OK) {
+                    count = 0;
+                }
+                scan_publish(count);
+                break;
+            }
             default:
                 break;
         }
     }
 }
 
+/**
+ * @brief Format the records as the /scan networks array and publish it
+ */
+static void scan_publish(uint16_t count)
+{
+    unsigned seq = atomic_load_explicit(&s_scan_seq, memory_order_relaxed);
+    char *json_buf = s_scan_json[(seq + 1U) & 1U];
+    size_t buf_size = PROV_SCAN_JSON_SIZE;
+
+    ESP_LOGI(TAG, "Scan found %d networks", count);
+
+    /* Build JSON array */
+    size_t offset = 0;
+    offset += (size_t)snprintf(json_buf + offset, buf_size - offset, "[");
+
+    for (uint16_t i = 0; i < count && offset < buf_size - 100; i++) {
+        /* Escape SSID for JSON (quotes, backslashes, control characters) */
+        char escaped_ssid[65] = {0};
+        const char *src = (const char *)s_scan_results[i].ssid;
+        size_t j = 0;
+        for (size_t k = 0; src[k] != '\0' && j < sizeof(escaped_ssid) - 2; k++) {
+            if ((unsigned char)src[k] < 0x20) {
+                continue;
+            }
+            if (src[k] == '"' || src[k] == '\\') {
+                escaped_ssid[j++] = '\\';
+            }
+            escaped_ssid[j++] = src[k];
+        }
+        escaped_ssid[j] = '\0';
+        if (j == 0) {
+            continue;   /* Hidden network */
+        }
+
+        /* Auth mode: 0=open, others=secured */
+        int auth = (s_scan_results[i].authmode == WIFI_AUTH_OPEN) ? 0 : 1;
+
+        offset += (size_t)snprintf(json_buf + offset, buf_size - offset,
+                                    "%s{\"ssid\":\"%s\",\"rssi\":%d,\"auth\":%d}",
+                                    (offset > 1) ? "," : "",
+                                    escaped_ssid,
+                                    s_scan_results[i].rssi,
+                                    auth);
+    }
+
+    snprintf(json_buf + offset, buf_size - offset, "]");
+
+    atomic_store_explicit(&s_scan_seq, seq + 1U, memory_order_release);
+    atomic_store_explicit(&s_scan_done_us, esp_timer_get_time(), memory_order_relaxed);
+    atomic_store_explicit(&s_scanning, false, memory_order_release);
+}
+
+/**
+ * @brief Start a background scan unless one is running
+ */
+static void scan_kick(void)
+{
+    if (atomic_exchange_explicit(&s_scanning, true, memory_order_acq_rel)) {
+        return;
+    }
+
+    wifi_scan_config_t scan_config = {
+        .ssid = NULL,
+        .bssid = NULL,
+        .channel = 0,
+        .show_hidden = false,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+        .scan_time = {
+            .active = {
+                .min = 100,
+                .max = 300,
+            },
+        },
+        .home_chan_dwell_time = PROV_SCAN_HOME_DWELL_MS,
+    };
+
+    esp_err_t err = esp_wifi_scan_start(&scan_config, false);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Scan start failed: %s", esp_err_to_name(err));
+        atomic_store_explicit(&s_scanning, false, memory_order_release);
+    }
+}
+
+static void scan_timer_cb(void *arg)
+{
+    (void)arg;
+    scan_kick();
+}
+
 void prov_wifi_start_ap(void)
 {
     if (s_initialized) {
@@ -109,6 +230,18 @@ void prov_wifi_start_ap(void)
     s_initialized = true;
 
     ESP_LOGI(TAG, "AP started: SSID=%s (open), IP=192.168.4.1", PROV_AP_SSID);
+
+    /* First scan now, before anyone has joined; then keep the list fresh */
+    snprintf(s_scan_json[0], PROV_SCAN_JSON_SIZE, "[]");
+    atomic_store_explicit(&s_scan_seq, 0, memory_order_release);
+    const esp_timer_create_args_t timer_args = {
+        .callback = scan_timer_cb,
+        .name = "prov_scan",
+    };
+    if (esp_timer_create(&timer_args, &s_scan_timer) == ESP_OK) {
+        esp_timer_start_periodic(s_scan_timer, PROV_SCAN_PERIOD_US);
+    }
+    scan_kick();
 }
 
 void prov_wifi_stop(void)
@@ -117,6 +250,12 @@ void prov_wifi_stop(void)
         return;
     }
 
+    if (s_scan_timer != NULL) {
+        esp_timer_stop(s_scan_timer);
+        esp_timer_delete(s_scan_timer);
+        s_scan_timer = NULL;
+    }
+    esp_wifi_scan_stop();
     esp_wifi_stop();
     esp_wifi_deinit();
 
@@ -129,81 +268,44 @@ void prov_wifi_stop(void)
     ESP_LOGI(TAG, "WiFi stopped");
 }
 
-int prov_wifi_scan(char *json_buf, size_t buf_size)
+/**
+ * @brief Cached scan results for GET /scan
+ *
+ * Output: {"scanning":false,"age_s":12,"networks":[{"ssid":"x","rssi":-60,"auth":1},...]}
+ *
+ * @param refresh Start a new scan as well (the answer is still the cache)
+ * @return 0, or -1 if the AP is not up
+ */
+int prov_wifi_scan(char *json_buf, size_t buf_size, bool refresh)
 {
     if (!s_initialized) {
         ESP_LOGE(TAG, "WiFi not initialized");
         return -1;
     }
 
-    ESP_LOGI(TAG, "Starting WiFi scan...");
-
-    /* Configure scan */
-    wifi_scan_config_t scan_config = {
-        .ssid = NULL,
-        .bssid = NULL,
-        .channel = 0,
-        .show_hidden = false,
-        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-        .scan_time = {
-            .active = {
-                .min = 100,
-                .max = 300,
-            },
-        },
-    };
-
-    /* Start scan (blocking) */
-    esp_err_t err = esp_wifi_scan_start(&scan_config, true);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Scan start failed: %s", esp_err_to_name(err));
-        snprintf(json_buf, buf_size, "[]");
-        return 0;
-    }
-
-    /* Get results */
-    s_scan_count = PROV_SCAN_MAX_AP;
-    err = esp_wifi_scan_get_ap_records(&s_scan_count, s_scan_results);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get scan results: %s", esp_err_to_name(err));
-        snprintf(json_buf, buf_size, "[]");
-        return 0;
+    if (refresh) {
+        scan_kick();
     }
 
-    ESP_LOGI(TAG, "Scan found %d networks", s_scan_count);
-
-    /* Build JSON array */
-    size_t offset = 0;
-    offset += (size_t)snprintf(json_buf + offset, buf_size - offset, "[");
-
-    for (uint16_t i = 0; i < s_scan_count && offset < buf_size - 100; i++) {
-        if (i > 0) {
-            offset += (size_t)snprintf(json_buf + offset, buf_size - offset, ",");
-        }
-
-        /* Escape SSID for JSON (simple escape for quotes) */
-        char escaped_ssid[65] = {0};
-        const char *src = (const char *)s_scan_results[i].ssid;
-        size_t j = 0;
-        for (size_t k = 0; src[k] != '\0' && j < sizeof(escaped_ssid) - 2; k++) {
-            if (src[k] == '"' || src[k] == '\\') {
-                escaped_ssid[j++] = '\\';
-            }
-            escaped_ssid[j++] = src[k];
-        }
-        escaped_ssid[j] = '\0';
-
-        /* Auth mode: 0=open, others=secured */
-        int auth = (s_scan_results[i].authmode == WIFI_AUTH_OPEN) ? 0 : 1;
-
-        offset += (size_t)snprintf(json_buf + offset, buf_size - offset,
-                                    "{\"ssid\":\"%s\",\"rssi\":%d,\"auth\":%d}",
-                                    escaped_ssid,
-                                    s_scan_results[i].rssi,
-                                    auth);
+    /* Copy the published list; retry if a scan finished meanwhile */
+    char list[PROV_SCAN_JSON_SIZE];
+    unsigned seq;
+    do {
+        seq = atomic_load_explicit(&s_scan_seq, memory_order_acquire);
+        memcpy(list, s_scan_json[seq & 1U], sizeof(list));
+        list[sizeof(list) - 1] = '\0';
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&s_scan_seq, memory_order_relaxed) != seq);
+
+    bool scanning = atomic_load_explicit(&s_scanning, memory_order_acquire);
+    int64_t done_us = atomic_load_explicit(&s_scan_done_us, memory_order_relaxed);
+    int64_t age_s = (done_us > 0) ? (esp_timer_get_time() - done_us) / 1000000 : -1;
+
+    int n = snprintf(json_buf, buf_size, "{\"scanning\":%s,\"age_s\":%lld,\"networks\":%s}",
+                     scanning ? "true" : "false", (long long)age_s, list);
+    if (n < 0 || (size_t)n >= buf_size) {
+        snprintf(json_buf, buf_size, "{\"scanning\":%s,\"age_s\":-1,\"networks\":[]}",
+                 scanning ? "true" : "false");
     }
-
-    offset += (size_t)snprintf(json_buf + offset, buf_size - offset, "]");
-
-    return (int)s_scan_count;
+    return 0;
 }
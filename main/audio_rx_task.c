@@ -0,0 +1,87 @@
+/**
+ * @file audio_rx_task.c
+ * @brief Off-air CW decoder task (Core 1)
+ *
+ * Reads receiver audio from the codec ADC (I2S RX DMA) in 32 ms chunks and
+ * runs the audio_rx pipeline on it: Goertzel tone detector, private key
+ * edge ring, decoder channel. The I2S read is the only wait; DMA keeps
+ * filling while the chunk is processed, so the task never drops audio as
+ * long as processing stays within its budget (console `decoder rx`).
+ *
+ * Each chunk also goes to the latency probe, which looks for the sidetone
+ * coming back in `latency loopback` mode (codec output wired to its input).
+ * The probe sees the codec rate (audio.sample_rate); the decoder gets the
+ * chunk decimated to 8 kHz.
+ *
+ * Deletes itself unless audio.rx_decode is set and the input path opened.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include <inttypes.h>
+
+#include "audio_rx.h"
+#include "key_latency.h"
+#include "hal_audio.h"
+#include "audio_rate.h"
+#include "config.h"
+#include "rt_log.h"
+
+/** Decoder samples per read (32 ms at 8 kHz: four detector blocks) */
+#define AUDIO_RX_READ_SAMPLES 256
+
+/** Codec samples per read buffer (32 ms at the highest rate) */
+#define AUDIO_RX_BUF_SAMPLES (AUDIO_RX_READ_SAMPLES * (AUDIO_RATE_MAX_HZ / AUDIO_STREAM_RATE_HZ))
+
+/** Read timeout; longer means the input stalled */
+#define AUDIO_RX_READ_TIMEOUT_MS 100
+
+extern keying_stream_t g_keying_stream;
+
+/** Off-air decoding pipeline (console reads its decoder and stats) */
+audio_rx_t g_audio_rx;
+
+void audio_rx_task(void *arg) {
+    (void)arg;
+
+    if (!CONFIG_GET_RX_DECODE() || !hal_audio_input_available()) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    tone_detector_config_t cfg = TONE_DETECTOR_CONFIG_DEFAULT;
+    cfg.low_hz = CONFIG_GET_RX_TONE_LOW_HZ();
+    cfg.high_hz = CONFIG_GET_RX_TONE_HIGH_HZ();
+    if (cfg.high_hz < cfg.low_hz) {
+        cfg.high_hz = cfg.low_hz;
+    }
+    audio_rx_init(&g_audio_rx, &g_keying_stream, &cfg, esp_timer_get_time());
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(), "RX decode: %u-%u Hz, %u bins",
+            (unsigned)cfg.low_hz, (unsigned)cfg.high_hz, (unsigned)g_audio_rx.detector.bins);
+
+    const uint32_t sample_rate = audio_rate_from_index(CONFIG_GET_SAMPLE_RATE());
+    const size_t read_samples = AUDIO_RX_READ_SAMPLES * audio_rate_factor(sample_rate);
+    audio_decimator_t decim;
+    audio_decimator_init(&decim, audio_rate_factor(sample_rate));
+
+    static int16_t samples[AUDIO_RX_BUF_SAMPLES];
+    uint32_t reported_over = 0;
+    for (;;) {
+        size_t n = hal_audio_read(samples, read_samples, AUDIO_RX_READ_TIMEOUT_MS);
+        if (n == 0) {
+            continue;
+        }
+        key_latency_loopback(&g_key_latency, samples, n, esp_timer_get_time(), sample_rate);
+        n = audio_decimate(&decim, samples, n, samples);
+        audio_rx_process(&g_audio_rx, samples, n);
+
+        uint32_t over = g_audio_rx.stats.over_budget;
+        if (over != reported_over && (over & 0xFFU) == 1U) {
+            RT_WARN(&g_bg_log_stream, esp_timer_get_time(),
+                    "RX decode over budget: %" PRIu32 " us > %" PRIu32 " us (%" PRIu32 " times)",
+                    g_audio_rx.stats.block_us_last, g_audio_rx.stats.budget_us, over);
+        }
+        reported_over = over;
+    }
+}
@@ -1,53 +1,122 @@
 /**
  * @file bg_task.c
- * @brief Background task (Core 1)
+ * @brief Background services (Core 1)
  *
- * Best-effort processing:
- * - LED status feedback
- * - WiFi connectivity
- * - Remote CW forwarder
- * - Morse decoder
- * - Diagnostics
+ * Best-effort processing, one task per service (service.h) so slow work
+ * cannot delay the rest:
+ * - decoder:      stream archive, key edges, timeline history, keying
+ *                 statistics, decoder, text keyer
+ * - net:          WiFi/VPN state, modem sleep, boot timing
+ * - ui_push:      WebUI timeline, decoded text and pattern, keying statistics
+ * - housekeeping: LED, flight recorder, periodic stats, heap budget,
+ *                 metrics history, OTA self-test, load shedding (load_shed.h),
+ *                 keyer.preset selection (iambic_preset.h)
+ * - recorder:     keying stream to the flash recorder partition (recorder.h)
+ * - telemetry:    MQTT metrics batches, fault events, link state
+ *                 (mqtt_telemetry.h)
+ * - feed:         decoded text and TX/RX state to loggers over UDP
+ *                 broadcast (logger_feed_udp.h)
  *
- * Runs on Core 1 with normal priority.
+ * Services share data only through the stream, the key edge ring and the
+ * decoder transcript, as before. Priorities sit below cwnet (IDLE+3).
  */
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <stdatomic.h>
 #include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
 #include <inttypes.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "keyer_core.h"
+#include "service.h"
+#include "task_stats.h"
+#include "mem_budget.h"
+#include "load_shed.h"
+#include "metrics.h"
+#include "metrics_history.h"
 #include "consumer.h"
+#include "key_edge.h"
+#include "stream_index.h"
+#include "key_stats.h"
 #include "rt_log.h"
 #include "decoder.h"
+#include "decoder_transcript.h"
 #include "text_keyer.h"
 #include "text_memory.h"
+#include "iambic_preset.h"
 #include "led.h"
 #include "wifi.h"
 #include "vpn.h"
 #include "hal_gpio.h"
+#include "hal_tick.h"
 #include "config.h"
 #include "webui.h"
+#include "ws_timeline.h"
 #include "cwnet_socket.h"
+#include "recorder.h"
+#include "mqtt_telemetry.h"
+#include "logger_feed.h"
+#include "logger_feed_udp.h"
 
 #include <stdio.h>
 
 /* External globals */
 extern keying_stream_t g_keying_stream;
 extern fault_state_t g_fault_state;
+extern void ota_check_poll(int64_t now_us);
 
 /* ============================================================================
- * Timeline Consumer (best-effort, for WebUI visualization)
+ * Edge Extraction (WebUI timeline, decoder; CWNet reads the stream itself)
  * ============================================================================ */
 
-static best_effort_consumer_t s_timeline_consumer;
-static bool s_timeline_initialized = false;
+/** Key edges extracted once from the stream; readers subscribe to it */
+key_edge_ring_t g_key_edge_ring;
 
-/* Previous state for edge detection */
-static gpio_state_t s_tl_prev_gpio = {0};
-static uint8_t s_tl_prev_local_key = 0;
+/** Time index over stream history, fed by the edge stage (seek by tick) */
+EXT_RAM_BSS_ATTR stream_index_t g_stream_index;
+
+/** Decoded text history with sequence numbers (GET /api/decoder/text) */
+EXT_RAM_BSS_ATTR transcript_t g_decoder_transcript;
+
+/** Core 1 services and their pass timing (stats svc) */
+service_table_t g_services;
+
+/** Per-task CPU and stack history, one sample a second (stats tasks, /api/system/tasks) */
+EXT_RAM_BSS_ATTR task_stats_t g_task_stats;
+
+/** Heap per capability with one-minute low-water marks (stats heap) */
+EXT_RAM_BSS_ATTR mem_budget_t g_mem_budget;
+
+/** Every metric at 1 s / 1 min / 15 min, fed by housekeeping (/api/metrics/history) */
+EXT_RAM_BSS_ATTR metrics_history_t g_metrics_history;
+
+/** Overload supervisor, fed by housekeeping (stats shed) */
+load_shed_t g_load_shed;
+
+/** Key history at 10 ms / 100 ms / 1 s, fed by the decoder service (/api/timeline/range) */
+EXT_RAM_BSS_ATTR timeline_pyramid_t g_timeline_pyramid;
+
+/** Speed, weight, spacing and duty over 1 s / 10 s / 60 s, fed by the decoder service */
+EXT_RAM_BSS_ATTR key_stats_t g_key_stats;
+
+static key_edge_stage_t s_edge_stage;
+static key_edge_reader_t s_pyramid_edges;
+static key_edge_reader_t s_stats_edges;
+
+/*
+ * Timeline join handshake: the levels a new client starts from can only be
+ * read in the stage's task, so ui_push asks (a new join number) and the
+ * decoder service hands over the levels together with a reader at the same
+ * ring position. ui_push only touches them once its own number is served.
+ */
+static key_edge_reader_t s_timeline_edges;
+static key_edge_t s_join_levels[KEY_EDGE_CH_COUNT];
+static atomic_uint s_join_request = 0;   /**< Join number ui_push waits for */
+static atomic_uint s_join_served = 0;    /**< Join number the handover is for */
 
 /**
  * @brief Map WiFi state to LED state
@@ -69,204 +138,714 @@ static led_state_t wifi_to_led_state(wifi_state_t ws) {
     }
 }
 
-void bg_task(void *arg) {
-    (void)arg;
+/**
+ * @brief Send every new key edge to the WebUI timeline
+ *
+ * One binary frame per pass carries all edges (ws_timeline.h); a burst
+ * longer than a frame, or a gap wider than its tick delta, starts another.
+ *
+ * @return true if anything was sent
+ */
+static bool timeline_push_edges(bool joined) {
+    static ws_timeline_frame_t frame;
+    key_edge_t edge;
+
+    ws_timeline_reset(&frame, stream_tick_period_us(&g_keying_stream));
+    if (joined) {
+        /* First client: start from the current levels, not from idle */
+        for (int ch = 0; ch < KEY_EDGE_CH_REMOTE; ch++) {
+            ws_timeline_add(&frame, s_join_levels[ch].tick,
+                            key_edge_time_us(&g_key_edge_ring, s_join_levels[ch].tick),
+                            s_join_levels[ch].channel, s_join_levels[ch].level);
+        }
+    }
+    while (key_edge_reader_next(&s_timeline_edges, &edge)) {
+        if (edge.channel == KEY_EDGE_CH_REMOTE) {
+            continue;  /* Play ticks run ahead of LOCAL: not a timeline channel */
+        }
+        int64_t time_us = key_edge_time_us(&g_key_edge_ring, edge.tick);
+        if (!ws_timeline_add(&frame, edge.tick, time_us, edge.channel, edge.level)) {
+            webui_timeline_push_edges(frame.buf, frame.len);
+            ws_timeline_reset(&frame, frame.tick_period_us);
+            ws_timeline_add(&frame, edge.tick, time_us, edge.channel, edge.level);
+        }
+    }
+    if (ws_timeline_is_empty(&frame)) {
+        return false;
+    }
+    webui_timeline_push_edges(frame.buf, frame.len);
+    return true;
+}
+
+/**
+ * @brief Log the boot-to-CWNet-READY breakdown once
+ *
+ * WiFi reports its own timeline; the VPN step is timed here since it is
+ * only visible as a state.
+ */
+static void boot_timing_check(int64_t now_us) {
+    static bool done = false;
+    static uint32_t vpn_ms = 0;
 
-    /* Note: All initialization (LED, WiFi, decoder, text_keyer) is done in main.c */
+    if (done) {
+        return;
+    }
+    uint32_t now_ms = (uint32_t)(now_us / 1000);
+    if (vpn_ms == 0 && vpn_get_state() == VPN_STATE_CONNECTED) {
+        vpn_ms = now_ms;
+    }
+    if (!cwnet_socket_is_ready()) {
+        return;
+    }
+    done = true;
+
+    wifi_connect_timing_t wt;
+    wifi_get_connect_timing(&wt);
+    uint32_t net_ms = (vpn_ms != 0) ? vpn_ms : wt.ip_ms;
+    RT_INFO(&g_bg_log_stream, now_us,
+            "CWNet READY %lums after boot: wifi@%lu assoc+%lu(%s) ip+%lu vpn+%lu cwnet+%lu",
+            (unsigned long)now_ms, (unsigned long)wt.start_ms,
+            (unsigned long)(wt.assoc_ms - wt.start_ms), wt.fast ? "fast" : "scan",
+            (unsigned long)(wt.ip_ms - wt.assoc_ms),
+            (unsigned long)((vpn_ms != 0) ? vpn_ms - wt.ip_ms : 0),
+            (unsigned long)(now_ms - net_ms));
+}
 
-    /* Initialize timeline consumer (skip_threshold=0: never auto-skip) */
-    best_effort_consumer_init(&s_timeline_consumer, &g_keying_stream, 0);
-    s_timeline_initialized = true;
+/* ============================================================================
+ * decoder: stream archive, key edges, timeline history, decoder, text keyer
+ * ============================================================================ */
 
-    /* Initialize CWNet client (reads config, connects if enabled) */
-    cwnet_socket_init();
+static bool decoder_service_run(int64_t now_us) {
+    /* Work waiting in the stream keeps the poll fast (best-effort lag) */
+    bool busy = best_effort_consumer_lag(&s_edge_stage.source.base) > 0;
 
-    /* Log startup */
-    int64_t now_us = esp_timer_get_time();
-    RT_INFO(&g_bg_log_stream, now_us, "BG task started (text keyer ready)");
+    /* Copy new stream slots to the PSRAM history before the hot ring laps */
+    stream_archive_spill(&g_keying_stream, SIZE_MAX);
 
-    uint32_t stats_counter = 0;
-    wifi_state_t prev_wifi_state = WIFI_STATE_DISABLED;
-    vpn_state_t prev_vpn_state = VPN_STATE_DISABLED;
-    bool wifi_connected_flash_done = false;
+    /* Extract key edges once, then fan out to subscribers */
+    busy |= key_edge_stage_run(&s_edge_stage) > 0;
 
-    for (;;) {
-        now_us = esp_timer_get_time();
-
-        /* Update LED state from WiFi */
-        if (led_is_initialized()) {
-            wifi_state_t ws = wifi_get_state();
-
-            /* Detect state changes */
-            if (ws != prev_wifi_state) {
-                led_state_t new_led_state = wifi_to_led_state(ws);
-                led_set_state(new_led_state);
-
-                /* Log state change */
-                if (ws == WIFI_STATE_CONNECTED) {
-                    char ip_buf[16];
-                    if (wifi_get_ip(ip_buf, sizeof(ip_buf))) {
-                        RT_INFO(&g_bg_log_stream, now_us, "WiFi connected: %s", ip_buf);
-                    }
-                    wifi_connected_flash_done = false;
-                } else if (ws == WIFI_STATE_AP_MODE) {
-                    RT_INFO(&g_bg_log_stream, now_us, "WiFi AP mode active");
-                } else if (ws == WIFI_STATE_FAILED) {
-                    RT_WARN(&g_bg_log_stream, now_us, "WiFi connection failed");
-                }
+    /* Summarise the new edges, then close buckets up to the stage position */
+    key_edge_t edge;
+    while (key_edge_reader_next(&s_pyramid_edges, &edge)) {
+        if (edge.channel != KEY_EDGE_CH_REMOTE) {
+            timeline_pyramid_edge(&g_timeline_pyramid,
+                                  key_edge_time_us(&g_key_edge_ring, edge.tick),
+                                  edge.channel, edge.level);
+        }
+    }
+    timeline_pyramid_advance(&g_timeline_pyramid,
+                             key_edge_time_us(&g_key_edge_ring, s_edge_stage.source.tick));
 
-                prev_wifi_state = ws;
+    /* Keying statistics: every channel, REMOTE at its play time */
+    while (key_edge_reader_next(&s_stats_edges, &edge)) {
+        key_stats_edge(&g_key_stats, key_edge_time_us(&g_key_edge_ring, edge.tick),
+                       edge.channel, edge.level, edge.tag);
+    }
+    key_stats_advance(&g_key_stats,
+                      key_edge_time_us(&g_key_edge_ring, s_edge_stage.source.tick));
+
+    /* A timeline client joined: hand ui_push the levels at this position */
+    unsigned join = atomic_load_explicit(&s_join_request, memory_order_acquire);
+    if (join != atomic_load_explicit(&s_join_served, memory_order_relaxed)) {
+        key_edge_stage_levels(&s_edge_stage, s_join_levels);
+        key_edge_reader_init(&s_timeline_edges, &g_key_edge_ring);
+        atomic_store_explicit(&s_join_served, join, memory_order_release);
+    }
+
+    /* Process decoder (reads the key edge ring), record decoded characters.
+     * Suspended under overload: it catches up from the ring afterwards */
+    if (!load_shed_active(&g_load_shed, LOAD_SHED_DECODER)) {
+        decoder_process();
+        decoded_char_t ch;
+        while ((ch = decoder_pop_char()).character != '\0') {
+            transcript_append(&g_decoder_transcript, ch.character, (uint8_t)decoder_get_wpm());
+            busy = true;
+        }
+    }
+
+    /* Tick text keyer */
+    text_keyer_tick(now_us);
+    return busy || text_keyer_get_state() == TEXT_KEYER_SENDING;
+}
+
+/* ============================================================================
+ * net: WiFi/VPN state, modem sleep, boot timing
+ * ============================================================================ */
+
+static bool net_service_run(int64_t now_us) {
+    static wifi_state_t prev_wifi_state = WIFI_STATE_DISABLED;
+    static vpn_state_t prev_vpn_state = VPN_STATE_DISABLED;
+
+    /* Log WiFi state changes (housekeeping follows them on the LED) */
+    wifi_state_t ws = wifi_get_state();
+    if (ws != prev_wifi_state) {
+        if (ws == WIFI_STATE_CONNECTED) {
+            char ip_buf[16];
+            if (wifi_get_ip(ip_buf, sizeof(ip_buf))) {
+                RT_INFO(&g_bg_log_stream, now_us, "WiFi connected: %s", ip_buf);
             }
+        } else if (ws == WIFI_STATE_AP_MODE) {
+            RT_INFO(&g_bg_log_stream, now_us, "WiFi AP mode active");
+        } else if (ws == WIFI_STATE_FAILED) {
+            RT_WARN(&g_bg_log_stream, now_us, "WiFi connection failed");
+        }
+        prev_wifi_state = ws;
+    }
 
-            /* Monitor VPN state changes */
-            vpn_state_t vs = vpn_get_state();
-            if (vs != prev_vpn_state) {
-                switch (vs) {
-                    case VPN_STATE_WAITING_WIFI:
-                        RT_INFO(&g_bg_log_stream, now_us, "VPN: waiting for WiFi");
-                        break;
-                    case VPN_STATE_WAITING_TIME:
-                        RT_INFO(&g_bg_log_stream, now_us, "VPN: syncing time (NTP)");
-                        break;
-                    case VPN_STATE_CONNECTING:
-                        RT_INFO(&g_bg_log_stream, now_us, "VPN: WireGuard handshake");
-                        break;
-                    case VPN_STATE_CONNECTED:
-                        RT_INFO(&g_bg_log_stream, now_us, "VPN: tunnel established");
-                        break;
-                    case VPN_STATE_FAILED:
-                        RT_WARN(&g_bg_log_stream, now_us, "VPN: connection failed");
-                        break;
-                    default:
-                        break;
-                }
-                prev_vpn_state = vs;
+    /* Monitor VPN state changes */
+    vpn_state_t vs = vpn_get_state();
+    if (vs != prev_vpn_state) {
+        switch (vs) {
+            case VPN_STATE_WAITING_WIFI:
+                RT_INFO(&g_bg_log_stream, now_us, "VPN: waiting for WiFi");
+                break;
+            case VPN_STATE_WAITING_TIME:
+                RT_INFO(&g_bg_log_stream, now_us, "VPN: syncing time (NTP)");
+                break;
+            case VPN_STATE_CONNECTING:
+                RT_INFO(&g_bg_log_stream, now_us, "VPN: WireGuard handshake");
+                break;
+            case VPN_STATE_CONNECTED:
+                RT_INFO(&g_bg_log_stream, now_us, "VPN: tunnel established");
+                break;
+            case VPN_STATE_FAILED:
+                RT_WARN(&g_bg_log_stream, now_us, "VPN: connection failed");
+                break;
+            default:
+                break;
+        }
+        prev_vpn_state = vs;
+    }
+
+    boot_timing_check(now_us);
+
+    /* Modem sleep off while keying or linked (wifi_ps.h) */
+    bool cwnet_ready = cwnet_socket_is_ready();
+    int32_t jitter_ms = -1;
+    if (cwnet_ready) {
+        cwnet_sync_stats_t sync;
+        cwnet_socket_get_sync_stats(&sync);
+        jitter_ms = (sync.rtt_ms >= 0) ? sync.rtt_jitter_ms : -1;
+    }
+    wifi_power_save_tick((wifi_ps_policy_t)CONFIG_GET_POWER_SAVE(),
+                         CONFIG_GET_PS_IDLE_S(), now_us,
+                         stream_write_position(&g_keying_stream),
+                         cwnet_ready || cwnet_socket_get_peer(NULL, NULL),
+                         jitter_ms);
+    return false;
+}
+
+/* ============================================================================
+ * ui_push: WebUI timeline, decoded text, pattern, text keyer state, logs, stats
+ * ============================================================================ */
+
+static bool ui_push_service_run(int64_t now_us) {
+    static bool timeline_active = false;
+    static unsigned join = 0;
+    static bool join_pending = false;
+    static uint32_t text_seq = 0;
+    static char prev_pattern[16] = "";
+    static size_t prev_text[4];
+    static int64_t next_stats_us = 0;
+    static int64_t next_timeline_us = 0;
+    bool busy = false;
+
+    /* Each topic only while a WebSocket client is subscribed to it */
+    if (webui_topic_active(WS_TOPIC_TIMELINE)) {
+        if (timeline_active) {
+            /* Under overload, batched: the edge ring holds a few hundred ms easily */
+            if (!load_shed_active(&g_load_shed, LOAD_SHED_TIMELINE) || now_us >= next_timeline_us) {
+                next_timeline_us = now_us + (int64_t)LOAD_SHED_TIMELINE_MS * 1000;
+                busy = timeline_push_edges(false);
             }
+        } else if (!join_pending) {
+            join_pending = true;
+            atomic_store_explicit(&s_join_request, ++join, memory_order_release);
+        } else if (atomic_load_explicit(&s_join_served, memory_order_acquire) == join) {
+            /* Reader and levels are ours now: no request left outstanding */
+            join_pending = false;
+            timeline_active = true;
+            busy = timeline_push_edges(true);
+        }
+    } else {
+        /* The next client asks again; an older handover never matches */
+        join_pending = false;
+        timeline_active = false;
+    }
 
-            /* After connected flash sequence, transition to idle */
-            led_state_t current_led = led_get_state();
-            if (current_led == LED_STATE_IDLE && !wifi_connected_flash_done) {
-                wifi_connected_flash_done = true;
+    /* Decoded characters, from the transcript the decoder service writes.
+     * Unwatched, it is skipped: a new viewer fetches the history over REST */
+    if (webui_topic_active(WS_TOPIC_DECODER)) {
+        char text[32];
+        transcript_slice_t slice;
+        size_t n;
+        while ((n = transcript_read(&g_decoder_transcript, text_seq, text, sizeof(text),
+                                    &slice)) > 0) {
+            uint8_t wpm = (uint8_t)decoder_get_wpm();
+            for (size_t i = 0; i < n; i++) {
+                webui_decoder_push_char(text[i], wpm, slice.first_seq + (uint32_t)i);
+                if (text[i] == ' ') {
+                    webui_decoder_push_word();
+                }
             }
+            text_seq = slice.next_seq;
+            busy = true;
+        }
 
-            /* Read paddle state for keying overlay */
-            gpio_state_t paddles = hal_gpio_read_paddles();
-            led_tick(now_us, gpio_dit(paddles), gpio_dah(paddles));
+        /* Push current pattern if changed (a 16-bit code, read like the REST API does) */
+        char pattern[16];
+        decoder_get_current_pattern(pattern, sizeof(pattern));
+        if (strcmp(pattern, prev_pattern) != 0) {
+            webui_decoder_push_pattern(pattern);
+            strncpy(prev_pattern, pattern, sizeof(prev_pattern) - 1);
+            prev_pattern[sizeof(prev_pattern) - 1] = '\0';
+            busy = true;
+        }
+    } else {
+        text_seq = transcript_head(&g_decoder_transcript);
+        prev_pattern[0] = '\x01';   /* Matches no pattern: the next subscriber gets it */
+    }
+
+    /* Text keyer state and progress, instead of clients polling /api/text/status */
+    if (webui_topic_active(WS_TOPIC_TEXT)) {
+        size_t cur[4];
+        text_keyer_buffer_t buffer;
+        text_keyer_get_progress(&cur[0], &cur[1]);
+        text_keyer_get_buffer(&buffer);
+        cur[2] = buffer.queued;
+        cur[3] = (size_t)text_keyer_get_state();
+        if (memcmp(cur, prev_text, sizeof(cur)) != 0) {
+            memcpy(prev_text, cur, sizeof(cur));
+            webui_text_status_push();
         }
+    } else {
+        prev_text[3] = (size_t)-1;   /* The next subscriber gets the state at once */
+    }
+    if (webui_topic_active(WS_TOPIC_LOGS)) {
+        busy |= webui_log_push();
+    }
 
-        /* Process CWNet socket (connection, send/receive) */
-        cwnet_socket_process();
+    /* Keying statistics once a second (the windows move no faster to the eye) */
+    if (webui_topic_active(WS_TOPIC_STATS) && now_us >= next_stats_us) {
+        next_stats_us = now_us + 1000000;
+        webui_key_stats_push();
+    }
 
-        /* Process decoder (reads from keying_stream) */
-        decoder_process();
+    /* Config and status deltas, instead of clients polling /api/config and /api/status */
+    busy |= webui_state_push();
+    return busy;
+}
 
-        /* Push decoded characters to WebUI */
-        decoded_char_t ch;
-        while ((ch = decoder_pop_char()).character != '\0') {
-            webui_decoder_push_char(ch.character, (uint8_t)decoder_get_wpm());
-            if (ch.character == ' ') {
-                webui_decoder_push_word();
+/* ============================================================================
+ * housekeeping: LED, flight recorder, periodic stats
+ * ============================================================================ */
+
+/**
+ * @brief Add one second of FreeRTOS run-time stats to the task history
+ *
+ * uxTaskGetSystemState() briefly holds the scheduler lock on both cores;
+ * once a second is well within what the console and REST snapshots
+ * already did on demand.
+ */
+static void task_stats_collect(int64_t now_us) {
+    static TaskStatus_t status[TASK_STATS_MAX_TASKS + 8];
+    static task_stats_input_t in[TASK_STATS_MAX_TASKS + 8];
+    configRUN_TIME_COUNTER_TYPE total = 0;
+
+    UBaseType_t n = uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), &total);
+    uint32_t idle_id[TASK_STATS_CORES] = { UINT32_MAX, UINT32_MAX };
+    for (UBaseType_t i = 0; i < n; i++) {
+        BaseType_t core = xTaskGetCoreID(status[i].xHandle);
+        in[i].id = (uint32_t)status[i].xTaskNumber;
+        in[i].name = status[i].pcTaskName;
+        in[i].core = (core == 0 || core == 1) ? (uint8_t)core : TASK_STATS_CORE_ANY;
+        in[i].runtime = (uint32_t)status[i].ulRunTimeCounter;
+        in[i].stack_free = (uint32_t)status[i].usStackHighWaterMark;
+        for (BaseType_t c = 0; c < (BaseType_t)TASK_STATS_CORES; c++) {
+            if (status[i].xHandle == xTaskGetIdleTaskHandleForCore(c)) {
+                idle_id[c] = in[i].id;
             }
         }
+    }
+    task_stats_record(&g_task_stats, (uint32_t)(now_us / 1000000), (uint32_t)total,
+                      in, (size_t)n, idle_id);
+}
 
-        /* Push current pattern if changed */
-        {
-            static char prev_pattern[16] = "";
-            char pattern[16];
-            decoder_get_current_pattern(pattern, sizeof(pattern));
-            if (strcmp(pattern, prev_pattern) != 0) {
-                webui_decoder_push_pattern(pattern);
-                strncpy(prev_pattern, pattern, sizeof(prev_pattern) - 1);
-                prev_pattern[sizeof(prev_pattern) - 1] = '\0';
-            }
+/**
+ * @brief Add one reading of each heap capability to the budget
+ */
+static void mem_budget_collect(int64_t now_us) {
+    static const uint32_t k_caps[MEM_CAP_COUNT] = {
+        [MEM_CAP_INTERNAL] = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+        [MEM_CAP_DMA] = MALLOC_CAP_DMA,
+        [MEM_CAP_PSRAM] = MALLOC_CAP_SPIRAM,
+    };
+    mem_cap_sample_t caps[MEM_CAP_COUNT];
+    for (int c = 0; c < MEM_CAP_COUNT; c++) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, k_caps[c]);
+        caps[c].total = (uint32_t)heap_caps_get_total_size(k_caps[c]);
+        caps[c].free = (uint32_t)info.total_free_bytes;
+        caps[c].largest = (uint32_t)info.largest_free_block;
+        caps[c].min_free = (uint32_t)info.minimum_free_bytes;
+    }
+    mem_budget_record(&g_mem_budget, (uint32_t)(now_us / 1000000), caps);
+}
+
+/**
+ * @brief Feed the overload supervisor, log what it sheds or restores
+ */
+static void load_shed_collect(int64_t now_us) {
+    static stream_consumer_info_t cons[STREAM_REGISTRY_MAX];
+    hal_tick_stats_t ts;
+    hal_tick_get_stats(&ts);
+    load_shed_input_t in = {
+        .missed_ticks = ts.missed_ticks,
+        .stalls = ts.timeouts + fault_get_count(&g_fault_state),
+        .lag = 0,
+    };
+    size_t n = stream_registry_snapshot(&g_keying_stream, cons, STREAM_REGISTRY_MAX);
+    for (size_t i = 0; i < n; i++) {
+        if (cons[i].lag > in.lag) {
+            in.lag = (uint32_t)cons[i].lag;
         }
+    }
+    load_shed_limits_t limits = {
+        .enabled = CONFIG_GET_LOAD_SHED(),
+        .max_missed_per_s = CONFIG_GET_SHED_MISSES(),
+        .max_lag = CONFIG_GET_SHED_LAG(),
+    };
+
+    load_shed_event_t ev = load_shed_update(&g_load_shed, now_us, &in, &limits);
+    if (ev.action == LOAD_SHED_SHED) {
+        char why[24];
+        RT_WARN(&g_bg_log_stream, now_us, "Overload (%s, lag %lu): %s shed",
+                load_shed_why_str(ev.why, why, sizeof(why)), (unsigned long)in.lag,
+                load_shed_step_str(ev.step));
+    } else if (ev.action == LOAD_SHED_RESTORE) {
+        RT_INFO(&g_bg_log_stream, now_us, "Load back to normal: %s restored",
+                load_shed_step_str(ev.step));
+    }
+}
 
-        /* Process timeline events (only if WebSocket clients connected) */
-        if (s_timeline_initialized && webui_get_ws_client_count() > 0) {
-            stream_sample_t sample;
-            while (best_effort_consumer_tick(&s_timeline_consumer, &sample)) {
-                /* Skip silence markers */
-                if (sample_is_silence(&sample)) {
-                    continue;
-                }
+/**
+ * @brief Follow keyer.preset: 1-10 puts that preset in use, 0 releases it
+ *
+ * The RT task takes the change through the preset handoff (iambic.h) and
+ * latches it at the next element boundary.
+ */
+static void preset_follow_config(void) {
+    static uint32_t applied = UINT32_MAX;
+    uint32_t want = CONFIG_GET_PRESET();
+    if (want == applied) {
+        return;
+    }
+    applied = want;
+    if (want == 0U) {
+        iambic_preset_deactivate();
+    } else {
+        (void)iambic_preset_activate(want - 1U);
+    }
+}
 
-                char json[80];
+static bool housekeeping_run(int64_t now_us) {
+    static wifi_state_t prev_wifi_state = WIFI_STATE_DISABLED;
+    static int64_t next_stats_us = 0;
+    static int64_t next_tasks_us = 0;
+    static int64_t next_shed_us = 0;
 
-                /* Check for DIT paddle edge */
-                if (gpio_dit(sample.gpio) != gpio_dit(s_tl_prev_gpio)) {
-                    snprintf(json, sizeof(json),
-                        "{\"ts\":%lld,\"paddle\":0,\"state\":%d}",
-                        (long long)(now_us / 1000),  /* Convert to ms */
-                        gpio_dit(sample.gpio) ? 1 : 0);
-                    webui_timeline_push("paddle", json);
-                }
+    /* Overload check first: it decides what else runs */
+    if (now_us >= next_shed_us) {
+        next_shed_us = now_us + (int64_t)LOAD_SHED_PERIOD_MS * 1000;
+        load_shed_collect(now_us);
+    }
 
-                /* Check for DAH paddle edge */
-                if (gpio_dah(sample.gpio) != gpio_dah(s_tl_prev_gpio)) {
-                    snprintf(json, sizeof(json),
-                        "{\"ts\":%lld,\"paddle\":1,\"state\":%d}",
-                        (long long)(now_us / 1000),
-                        gpio_dah(sample.gpio) ? 1 : 0);
-                    webui_timeline_push("paddle", json);
-                }
+    preset_follow_config();
 
-                /* Check for keying output edge */
-                if (sample.local_key != s_tl_prev_local_key) {
-                    snprintf(json, sizeof(json),
-                        "{\"ts\":%lld,\"state\":%d}",
-                        (long long)(now_us / 1000),
-                        sample.local_key ? 1 : 0);
-                    webui_timeline_push("keying", json);
+    /* Update LED state from WiFi */
+    if (led_is_initialized()) {
+        wifi_state_t ws = wifi_get_state();
+        if (ws != prev_wifi_state) {
+            led_set_state(wifi_to_led_state(ws));
+            prev_wifi_state = ws;
+        }
 
-                    /* Forward key event to CWNet */
-                    cwnet_socket_send_key_event(sample.local_key != 0);
-                }
+        /* Read paddle state for keying overlay; no frames while shed */
+        if (!load_shed_active(&g_load_shed, LOAD_SHED_LED)) {
+            gpio_state_t paddles = hal_gpio_read_paddles();
+            led_tick(now_us, gpio_dit(paddles), gpio_dah(paddles));
+        }
+    }
 
-                /* Update previous state */
-                s_tl_prev_gpio = sample.gpio;
-                s_tl_prev_local_key = sample.local_key;
-            }
+    /* New worst RT stage timings go to the flight recorder (BG lane) */
+    for (int st = 0; st < RT_PROF_STAGE_COUNT; st++) {
+        rt_prof_snapshot_t ps;
+        rt_prof_get(&g_rt_prof, (rt_prof_stage_t)st, &ps);
+        flight_rec_note_stage(&g_flight_rec, now_us, (rt_prof_stage_t)st, ps.max_cycles);
+    }
+
+    /* Task CPU and stack history, heap budget, metrics history, OTA self-test (every second) */
+    if (now_us >= next_tasks_us) {
+        next_tasks_us = now_us + 1000000;
+        task_stats_collect(now_us);
+        mem_budget_collect(now_us);
+        metrics_history_sample(&g_metrics_history, &g_metrics, (uint32_t)(now_us / 1000000));
+        ota_check_poll(now_us);
+    }
+
+    /* Periodic stats logging (every ~10 seconds) */
+    if (now_us < next_stats_us) {
+        return false;
+    }
+    next_stats_us = now_us + 10000000;
+
+    /* Log decoder stats if active */
+    if (decoder_is_enabled()) {
+        decoder_stats_t stats;
+        decoder_get_stats(&stats);
+        if (stats.edges_dropped > 0) {
+            RT_WARN(&g_bg_log_stream, now_us, "Decoder dropped: %u edges",
+                    (unsigned)stats.edges_dropped);
         }
+    }
 
-        /* Tick text keyer */
-        text_keyer_tick(now_us);
-
-        /* Periodic stats logging */
-        stats_counter++;
-        if (stats_counter >= 1000) {  /* Every ~10 seconds at 10ms tick */
-            /* Log decoder stats if active */
-            if (decoder_is_enabled()) {
-                decoder_stats_t stats;
-                decoder_get_stats(&stats);
-                if (stats.samples_dropped > 0) {
-                    RT_WARN(&g_bg_log_stream, now_us, "Decoder dropped: %u samples",
-                            (unsigned)stats.samples_dropped);
-                }
-            }
+    /* Check fault state */
+    if (fault_is_active(&g_fault_state)) {
+        RT_ERROR(&g_bg_log_stream, now_us, "FAULT active: %s (count=%" PRIu32 ")",
+                 fault_code_str(fault_get_code(&g_fault_state)),
+                 fault_get_count(&g_fault_state));
+    }
 
-            /* Check fault state */
-            if (fault_is_active(&g_fault_state)) {
-                RT_ERROR(&g_bg_log_stream, now_us, "FAULT active: %s (count=%" PRIu32 ")",
-                         fault_code_str(fault_get_code(&g_fault_state)),
-                         fault_get_count(&g_fault_state));
-            }
+    /* Log CWNet status if enabled */
+    cwnet_socket_state_t cwnet_state = cwnet_socket_get_state();
+    if (cwnet_state != CWNET_SOCK_DISABLED) {
+        int32_t latency = cwnet_socket_get_latency_ms();
+        cwnet_latency_snapshot_t ls;
+        cwnet_socket_get_edge_latency(&ls);
+        if (latency >= 0) {
+            RT_INFO(&g_bg_log_stream, now_us,
+                    "CWNet: %s, latency=%"PRId32"ms, send p50=%luus p99=%luus",
+                    cwnet_socket_state_str(cwnet_state), latency,
+                    (unsigned long)cwnet_latency_percentile_us(&ls, 50),
+                    (unsigned long)cwnet_latency_percentile_us(&ls, 99));
+        } else {
+            RT_INFO(&g_bg_log_stream, now_us, "CWNet: %s",
+                    cwnet_socket_state_str(cwnet_state));
+        }
+    }
 
-            /* Log CWNet status if enabled */
-            cwnet_socket_state_t cwnet_state = cwnet_socket_get_state();
-            if (cwnet_state != CWNET_SOCK_DISABLED) {
-                int32_t latency = cwnet_socket_get_latency_ms();
-                if (latency >= 0) {
-                    RT_INFO(&g_bg_log_stream, now_us, "CWNet: %s, latency=%"PRId32"ms",
-                            cwnet_socket_state_str(cwnet_state), latency);
-                } else {
-                    RT_INFO(&g_bg_log_stream, now_us, "CWNet: %s",
-                            cwnet_socket_state_str(cwnet_state));
-                }
-            }
+    /* Services that overran their period since the last report */
+    static uint32_t prev_overruns[SERVICE_MAX];
+    service_info_t svcs[SERVICE_MAX];
+    size_t n = service_snapshot(&g_services, svcs, SERVICE_MAX);
+    for (size_t i = 0; i < n; i++) {
+        if (svcs[i].overruns != prev_overruns[i]) {
+            RT_WARN(&g_bg_log_stream, now_us, "Service %s: %lu overruns, max pass %luus",
+                    svcs[i].name, (unsigned long)(svcs[i].overruns - prev_overruns[i]),
+                    (unsigned long)svcs[i].max_us);
+            prev_overruns[i] = svcs[i].overruns;
+        }
+    }
+    return false;
+}
+
+/* ============================================================================
+ * Service tasks
+ * ============================================================================ */
 
-            stats_counter = 0;
+/*
+ * decoder and ui_push poll adaptively: 1-2ms while keying (edge latency),
+ * backing off to their period after 500ms of silence. 10ms is adequate for
+ * LED animations; the LED must stay single-writer.
+ */
+static const service_desc_t k_services[] = {
+    { .name = "decoder",  .run = decoder_service_run, .period_ms = 40,
+      .min_period_ms = 1, .hold_ms = 500,
+      .priority = tskIDLE_PRIORITY + 2, .stack_bytes = 4096 },
+    { .name = "net",      .run = net_service_run,     .period_ms = 50,
+      .priority = tskIDLE_PRIORITY + 2, .stack_bytes = 3072 },
+    { .name = "ui_push",  .run = ui_push_service_run, .period_ms = 40,
+      .min_period_ms = 2, .hold_ms = 500,
+      .priority = tskIDLE_PRIORITY + 1, .stack_bytes = 4096 },
+    { .name = "housekeep", .run = housekeeping_run,   .period_ms = 10,
+      .priority = tskIDLE_PRIORITY + 1, .stack_bytes = 3072 },
+    { .name = "recorder", .init = recorder_service_init, .run = recorder_service_run,
+      .period_ms = 100, .min_period_ms = 10, .hold_ms = 200,
+      .priority = tskIDLE_PRIORITY + 1, .stack_bytes = 3072 },
+    { .name = "telemetry", .run = mqtt_telemetry_run, .period_ms = 500,
+      .priority = tskIDLE_PRIORITY + 1, .stack_bytes = 3072 },
+    { .name = "feed", .init = logger_feed_init, .run = logger_feed_run,
+      .period_ms = LOGGER_FEED_BATCH_MS,
+      .priority = tskIDLE_PRIORITY + 1, .stack_bytes = 3072 },
+};
+
+/* Service stacks, carved in k_services order from one static arena
+ * (internal RAM: housekeeping writes flash when it marks an OTA image valid,
+ * the recorder on every chunk) */
+#define SERVICE_STACK_ARENA (4096 + 3072 + 4096 + 3072 + 3072 + 3072 + 3072)
+static StackType_t s_service_stacks[SERVICE_STACK_ARENA];
+static StaticTask_t s_service_tcbs[sizeof(k_services) / sizeof(k_services[0])];
+
+/**
+ * @brief Run one service at its period
+ *
+ * Fixed services keep their schedule, but a pass that overruns does not
+ * make the next ones run back to back: the schedule restarts from now.
+ * Adaptive services sleep the delay service_next_delay_ms() picks.
+ */
+static void service_task(void *arg) {
+    service_t *svc = (service_t *)arg;
+    const service_desc_t *desc = atomic_load_explicit(&svc->desc, memory_order_relaxed);
+    const TickType_t period = pdMS_TO_TICKS(desc->period_ms);
+
+    if (desc->init != NULL) {
+        desc->init(esp_timer_get_time());
+    }
+
+    TickType_t last_wake = xTaskGetTickCount();
+    for (;;) {
+        int64_t start_us = esp_timer_get_time();
+        bool busy = desc->run(start_us);
+        int64_t end_us = esp_timer_get_time();
+        service_record(svc, start_us, end_us);
+
+        if (desc->min_period_ms != 0) {
+            TickType_t delay = pdMS_TO_TICKS(service_next_delay_ms(svc, end_us, busy));
+            vTaskDelay(delay > 0 ? delay : 1);
+        } else if (xTaskDelayUntil(&last_wake, period) == pdFALSE) {
+            last_wake = xTaskGetTickCount();
         }
+    }
+}
+
+static int64_t metric_decoder(const void *ctx) {
+    decoder_stats_t stats;
+    decoder_get_stats(&stats);
+    switch ((uintptr_t)ctx) {
+        case 0:  return stats.chars_decoded;
+        case 1:  return stats.words_decoded;
+        case 2:  return stats.errors;
+        default: return stats.edges_dropped;
+    }
+}
+
+static int64_t metric_load_shed(const void *ctx) {
+    uint32_t sheds = 0;
+    uint32_t restores = 0;
+    load_shed_totals(&g_load_shed, &sheds, &restores);
+    switch ((uintptr_t)ctx) {
+        case 0:  return load_shed_level(&g_load_shed);
+        case 1:  return sheds;
+        default: return restores;
+    }
+}
+
+static int64_t metric_consumer_dropped(const void *ctx) {
+    return (int64_t)best_effort_consumer_dropped((const best_effort_consumer_t *)ctx);
+}
+
+static int64_t metric_consumer_overruns(const void *ctx) {
+    return (int64_t)best_effort_consumer_overwritten((const best_effort_consumer_t *)ctx);
+}
+
+/** Keyer output figures: ctx is window * 8 + figure */
+static int64_t metric_key_stats(const void *ctx) {
+    key_stats_view_t v[KEY_STATS_WINDOWS];
+    key_stats_get(&g_key_stats, KEY_EDGE_CH_KEY, v);
+    const key_stats_view_t *w = &v[((uintptr_t)ctx / 8U) % KEY_STATS_WINDOWS];
+    switch ((uintptr_t)ctx % 8U) {
+        case 0:  return w->wpm_x10;
+        case 1:  return w->weight_pm;
+        case 2:  return w->dah_ratio_x100;
+        case 3:  return w->char_gap_x100;
+        case 4:  return w->word_gap_x100;
+        default: return w->duty_pm;
+    }
+}
+
+#define KEY_STAT(window, figure) ((const void *)(uintptr_t)((window) * 8U + (figure)))
+
+static const metric_desc_t k_bg_metrics[] = {
+    { "keyer_decoder_chars_total", "Characters decoded", METRIC_COUNTER,
+      metric_decoder, (const void *)0 },
+    { "keyer_decoder_words_total", "Word spaces decoded", METRIC_COUNTER,
+      metric_decoder, (const void *)1 },
+    { "keyer_decoder_errors_total", "Unrecognized patterns", METRIC_COUNTER,
+      metric_decoder, (const void *)2 },
+    { "keyer_decoder_edges_dropped_total", "Key edges lost to ring overwrite", METRIC_COUNTER,
+      metric_decoder, (const void *)3 },
+    { "keyer_load_shed_level", "Optional work steps shed (led, timeline, decoder, nvs)",
+      METRIC_GAUGE, metric_load_shed, (const void *)0 },
+    { "keyer_load_shed_total", "Steps shed under overload", METRIC_COUNTER,
+      metric_load_shed, (const void *)1 },
+    { "keyer_load_restore_total", "Shed steps restored", METRIC_COUNTER,
+      metric_load_shed, (const void *)2 },
+    { "keyer_stream_dropped_total{consumer=\"edges\"}", "Samples a consumer skipped",
+      METRIC_COUNTER, metric_consumer_dropped, &s_edge_stage.source.base },
+    { "keyer_stream_overruns_total{consumer=\"edges\"}", "Reads the producer overwrote",
+      METRIC_COUNTER, metric_consumer_overruns, &s_edge_stage.source.base },
+    { "keyer_keying_wpm_tenths{window=\"10s\"}", "Sent speed (PARIS), tenths of WPM",
+      METRIC_GAUGE, metric_key_stats, KEY_STAT(KEY_STATS_10S, 0) },
+    { "keyer_keying_weight_permille{window=\"10s\"}", "Dit / (dit + element gap)",
+      METRIC_GAUGE, metric_key_stats, KEY_STAT(KEY_STATS_10S, 1) },
+    { "keyer_keying_dah_ratio_percent{window=\"10s\"}", "Mean dah / mean dit",
+      METRIC_GAUGE, metric_key_stats, KEY_STAT(KEY_STATS_10S, 2) },
+    { "keyer_keying_char_gap_percent{window=\"60s\"}", "Mean character gap, units",
+      METRIC_GAUGE, metric_key_stats, KEY_STAT(KEY_STATS_60S, 3) },
+    { "keyer_keying_word_gap_percent{window=\"60s\"}", "Mean word gap, units",
+      METRIC_GAUGE, metric_key_stats, KEY_STAT(KEY_STATS_60S, 4) },
+    { "keyer_keying_duty_permille{window=\"1s\"}", "Key-down time",
+      METRIC_GAUGE, metric_key_stats, KEY_STAT(KEY_STATS_1S, 5) },
+    { "keyer_keying_duty_permille{window=\"10s\"}", "Key-down time",
+      METRIC_GAUGE, metric_key_stats, KEY_STAT(KEY_STATS_10S, 5) },
+    { "keyer_keying_duty_permille{window=\"60s\"}", "Key-down time",
+      METRIC_GAUGE, metric_key_stats, KEY_STAT(KEY_STATS_60S, 5) },
+};
+
+void bg_services_start(void) {
+    /* Note: All initialization (LED, WiFi, decoder, text_keyer) is done in main.c */
 
-        vTaskDelay(pdMS_TO_TICKS(10));  /* 100Hz - adequate for LED animations */
+    /* Initialize edge extraction and its subscribers before any service runs */
+    key_edge_ring_init(&g_key_edge_ring, &g_keying_stream);
+    key_edge_stage_init(&s_edge_stage, &g_keying_stream, &g_key_edge_ring);
+    best_effort_consumer_register(&s_edge_stage.source.base, "edges");
+    stream_index_init(&g_stream_index, &g_keying_stream);
+    key_edge_stage_attach_index(&s_edge_stage, &g_stream_index);
+    key_edge_reader_init(&s_timeline_edges, &g_key_edge_ring);
+    key_edge_reader_init(&s_pyramid_edges, &g_key_edge_ring);
+    key_edge_reader_init(&s_stats_edges, &g_key_edge_ring);
+    timeline_pyramid_init(&g_timeline_pyramid);
+    key_stats_init(&g_key_stats);
+    transcript_init(&g_decoder_transcript);
+    service_table_init(&g_services);
+    task_stats_init(&g_task_stats);
+    mem_budget_init(&g_mem_budget);
+    metrics_history_init(&g_metrics_history);
+    load_shed_init(&g_load_shed);
+    metrics_register_all(&g_metrics, k_bg_metrics, sizeof(k_bg_metrics) / sizeof(k_bg_metrics[0]));
+
+    size_t started = 0;
+    size_t stack_used = 0;
+    for (size_t i = 0; i < sizeof(k_services) / sizeof(k_services[0]); i++) {
+        uint32_t stack_bytes = k_services[i].stack_bytes;
+        if (stack_used + stack_bytes > SERVICE_STACK_ARENA) {
+            RT_ERROR(&g_bg_log_stream, esp_timer_get_time(),
+                     "Service %s: stack arena full", k_services[i].name);
+            break;
+        }
+        service_t *svc = service_register(&g_services, &k_services[i]);
+        if (svc == NULL) {
+            break;
+        }
+        if (xTaskCreateStaticPinnedToCore(service_task, k_services[i].name, stack_bytes, svc,
+                                          k_services[i].priority, &s_service_stacks[stack_used],
+                                          &s_service_tcbs[i], 1) != NULL) {
+            started++;
+        }
+        stack_used += stack_bytes;
     }
+
+    RT_INFO(&g_bg_log_stream, esp_timer_get_time(),
+            "BG services started: %u (text keyer ready)", (unsigned)started);
 }
@@ -2,7 +2,12 @@
  * @file main.c
  * @brief ESP-IDF entry point for keyer_c
  *
- * Initializes all components and spawns FreeRTOS tasks.
+ * Initializes all components and spawns FreeRTOS tasks. Boot order:
+ * 1. Config, GPIO, stream, then rt_task: paddles key as early as possible
+ * 2. Audio codec and networking (WiFi, VPN, WebUI, CWNet) come up
+ *    concurrently in init tasks on Core 1
+ * 3. app_main carries on with USB, LED, console, decoder and bg tasks
+ * Every step is a phase in g_boot_timeline (console "stats boot").
  */
 
 #include <stdio.h>
@@ -10,6 +15,10 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_pm.h"
 #include "esp_netif.h"
 #include "esp_event.h"
 #include "nvs_flash.h"
@@ -21,10 +30,19 @@
 #include "console.h"
 #include "config.h"
 #include "config_nvs.h"
+#include "config_persist.h"
+#include "load_shed.h"
 #include "hal_gpio.h"
 #include "hal_audio.h"
+#include "hal_target.h"
 #include "usb_cdc.h"
 #include "usb_log.h"
+#include "usb_winkeyer.h"
+#include "usb_audio.h"
+#include "usb_paddle.h"
+#include "winkeyer_tcp.h"
+#include "console_tcp.h"
+#include "syslog_sink.h"
 #include "wifi.h"
 #include "vpn.h"
 #include "webui.h"
@@ -33,6 +51,10 @@
 #include "text_keyer.h"
 #include "text_memory.h"
 #include "provisioning.h"
+#include "cwnet_socket.h"
+#include "espnow_link.h"
+#include "recorder.h"
+#include "mqtt_telemetry.h"
 
 static const char *TAG = "main";
 
@@ -43,125 +65,209 @@ static const char *TAG = "main";
 
 /* External task functions */
 extern void rt_task(void *arg);
-extern void bg_task(void *arg);
+extern void bg_services_start(void);
+extern void ota_check_init(void);
+extern void audio_rx_task(void *arg);
 extern void start_audio_test(void);  /* Audio test task */
 
 /* Paddle state for text keyer abort (from rt_task.c) */
 extern atomic_bool g_paddle_active;
 
-/* UART logger task handle (for stopping after USB CDC ready) */
-static TaskHandle_t s_uart_log_task_handle = NULL;
+/**
+ * @brief Idle probe for the NVS persistence worker and the recorder
+ */
+static bool keyer_is_idle(void) {
+    return !atomic_load_explicit(&g_paddle_active, memory_order_acquire) &&
+           text_keyer_get_state() == TEXT_KEYER_IDLE;
+}
+
+/**
+ * @brief Idle probe for NVS commits: also busy while they are shed (load_shed.h)
+ */
+static bool nvs_may_commit(void) {
+    return keyer_is_idle() && !load_shed_active(&g_load_shed, LOAD_SHED_NVS);
+}
+
+/* Buffers read by rt_task: PSRAM, or internal RAM when the RT path must
+ * survive flash cache stalls (CONFIG_KEYER_RT_IRAM) */
+#ifdef CONFIG_KEYER_RT_IRAM
+#define RT_BUFFER_ATTR
+#else
+#define RT_BUFFER_ATTR EXT_RAM_BSS_ATTR
+#endif
+
+/* Hot stream ring: always internal SRAM; history spills to the PSRAM archive */
+#define STREAM_BUFFER_SIZE CONFIG_KEYER_STREAM_HOT_SAMPLES
+_Static_assert((STREAM_BUFFER_SIZE & (STREAM_BUFFER_SIZE - 1)) == 0,
+               "STREAM_BUFFER_SIZE must be a power of 2");
 
-/* Stream buffer in PSRAM */
-#define STREAM_BUFFER_SIZE 4096
-static EXT_RAM_BSS_ATTR stream_sample_t s_stream_buffer[STREAM_BUFFER_SIZE];
+/* Stream buffer */
+static stream_slot_t s_stream_buffer[STREAM_BUFFER_SIZE];
+#ifdef CONFIG_SPIRAM
+static stream_archive_t s_stream_archive;
+#endif
+
+/* Per-consumer lag telemetry (console "stats stream", /api/system/stats) */
+static stream_registry_t s_stream_registry;
 
 /* Global keying stream */
 keying_stream_t g_keying_stream;
 
+/* Foreign lane handoffs (CWNet, ESP-NOW), drained into the stream by rt_task */
+stream_handoffs_t g_stream_handoffs;
+
+/* Rig audio from the CWNet server, decoded by cwnet_task for rt_task (512ms) */
+#define RIG_AUDIO_BUFFER_SIZE 4096
+static RT_BUFFER_ATTR int16_t s_rig_audio_buffer[RIG_AUDIO_BUFFER_SIZE];
+audio_ring_buffer_t g_rig_audio;
+
+/* Keyer audio mix for the USB audio function, filled by rt_task (32ms) */
+static int16_t s_usb_audio_buffer[USB_AUDIO_RING_SAMPLES];
+audio_ring_buffer_t g_usb_audio;
+
 /* Global fault state */
 fault_state_t g_fault_state = FAULT_STATE_INIT;
 
-void app_main(void) {
-    /* Minimal early debug - use printf since ESP_LOG may not be ready */
-    printf("\n\n=== app_main() START ===\n");
+/* Recent faults and recoveries with timestamps (written by rt_task) */
+fault_log_t g_fault_log;
 
-    ESP_LOGI(TAG, "keyer_c starting...");
+/* Flight recorder: RTC slow memory, survives panics and soft resets */
+RTC_NOINIT_ATTR flight_rec_t g_flight_rec;
 
-    printf(">>> log_stream_init...\n");
-    /* Initialize log streams FIRST (before any RT_* logging) */
-    log_stream_init(&g_rt_log_stream);
-    log_stream_init(&g_bg_log_stream);
-    printf(">>> log_stream_init OK\n");
+/* Boot-phase timeline (console "stats boot") */
+boot_timeline_t g_boot_timeline;
 
-    /* Enable RT diagnostics for boot debugging */
-    atomic_store_explicit(&g_rt_diag_enabled, true, memory_order_relaxed);
+/* Counters scraped at GET /metrics, registered by each component at init */
+metrics_t g_metrics;
 
-    /* Initialize UART logger early for boot logs (GPIO6, 115200) */
-    uart_logger_init();
+static int64_t metric_uptime_s(const void *ctx) {
+    (void)ctx;
+    return esp_timer_get_time() / 1000000;
+}
 
-    /* Initialize NVS */
-    printf(">>> NVS init...\n");
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        ret = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(ret);
-    printf(">>> NVS init OK\n");
+static int64_t metric_heap_free(const void *ctx) {
+    return (int64_t)heap_caps_get_free_size(*(const uint32_t *)ctx);
+}
 
-    /* ===== PROVISIONING CHECK (before normal boot) ===== */
+static int64_t metric_heap_min_free(const void *ctx) {
+    return (int64_t)heap_caps_get_minimum_free_size(*(const uint32_t *)ctx);
+}
 
-    /* Check for factory reset request (both paddles held 5s) */
-    printf(">>> Checking factory reset...\n");
-    if (provisioning_check_factory_reset(DEFAULT_GPIO_DIT, DEFAULT_GPIO_DAH, FACTORY_RESET_HOLD_MS)) {
-        ESP_LOGW(TAG, "Factory reset triggered - rebooting to provisioning mode");
-        esp_restart();
-    }
+static int64_t metric_heap_largest(const void *ctx) {
+    return (int64_t)heap_caps_get_largest_free_block(*(const uint32_t *)ctx);
+}
 
-    /* Check if provisioning is needed (WiFi not configured) */
-    if (provisioning_is_needed()) {
-        ESP_LOGI(TAG, "WiFi not configured - entering provisioning mode");
-        provisioning_start();  /* Does not return - reboots after config */
-    }
+static int64_t metric_faults(const void *ctx) {
+    return (int64_t)fault_get_count((const fault_state_t *)ctx);
+}
 
-    printf(">>> Provisioning check passed - normal boot\n");
+static int64_t metric_fault_active(const void *ctx) {
+    return fault_is_active((const fault_state_t *)ctx) ? 1 : 0;
+}
 
-    /* ===== NORMAL BOOT CONTINUES ===== */
+static const uint32_t k_heap_internal = MALLOC_CAP_INTERNAL;
+static const uint32_t k_heap_psram = MALLOC_CAP_SPIRAM;
+
+static const metric_desc_t k_system_metrics[] = {
+    { "keyer_uptime_seconds", "Time since boot", METRIC_GAUGE, metric_uptime_s, NULL },
+    { "keyer_heap_free_bytes{heap=\"internal\"}", "Free heap", METRIC_GAUGE,
+      metric_heap_free, &k_heap_internal },
+    { "keyer_heap_free_bytes{heap=\"psram\"}", NULL, METRIC_GAUGE,
+      metric_heap_free, &k_heap_psram },
+    { "keyer_heap_min_free_bytes{heap=\"internal\"}", "Lowest free heap since boot", METRIC_GAUGE,
+      metric_heap_min_free, &k_heap_internal },
+    { "keyer_heap_largest_free_bytes{heap=\"internal\"}", "Largest free block", METRIC_GAUGE,
+      metric_heap_largest, &k_heap_internal },
+    { "keyer_faults_total", "RT faults raised", METRIC_COUNTER, metric_faults, &g_fault_state },
+    { "keyer_fault_active", "1 while an RT fault is latched", METRIC_GAUGE,
+      metric_fault_active, &g_fault_state },
+};
+
+static boot_heap_t boot_heap(void) {
+    boot_heap_t heap = {
+        .internal = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        .psram = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+    };
+    return heap;
+}
 
-    /* Initialize config with defaults, then load from NVS */
-    printf(">>> config_init_defaults...\n");
-    config_init_defaults(&g_config);
-    printf(">>> config_init_defaults OK\n");
+static int boot_begin(const char *name) {
+    boot_heap_t heap = boot_heap();
+    return boot_phase_begin(&g_boot_timeline, name, (uint8_t)xPortGetCoreID(),
+                            esp_timer_get_time(), &heap);
+}
 
-    printf(">>> config_load_from_nvs...\n");
-    int loaded = config_load_from_nvs();
-    printf(">>> config_load_from_nvs OK (loaded=%d)\n", loaded);
-    if (loaded > 0) {
-        ESP_LOGI(TAG, "Loaded %d parameters from NVS", loaded);
-    } else {
-        ESP_LOGI(TAG, "Using default configuration");
-    }
+static void boot_end(int phase) {
+    boot_heap_t heap = boot_heap();
+    boot_phase_end(&g_boot_timeline, phase, esp_timer_get_time(), &heap);
+}
 
-    /* Initialize TCP/IP stack unconditionally (required for HTTP server even without WiFi) */
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
+/*
+ * Tasks that run for the whole uptime get static stacks and TCBs: boot
+ * takes no heap for them and nothing is freed to fragment it. Stacks stay
+ * in internal RAM unless the task never touches flash and is not
+ * latency-critical (a PSRAM stack stalls while flash is written).
+ * Tasks that delete themselves unless their feature is on stay dynamic,
+ * so a feature that is off holds no RAM.
+ */
+static StackType_t s_rt_stack[4096];
+static StaticTask_t s_rt_tcb;
+static StackType_t s_cwnet_stack[4096];
+static StaticTask_t s_cwnet_tcb;
+static EXT_RAM_BSS_ATTR StackType_t s_usb_log_stack[4096];
+static StaticTask_t s_usb_log_tcb;
+static EXT_RAM_BSS_ATTR StackType_t s_uart_log_stack[2048];
+static StaticTask_t s_uart_log_tcb;
 
-    /* Initialize HAL GPIO using values from g_config (loaded from NVS or defaults) */
-    printf(">>> hal_gpio_init...\n");
-    hal_gpio_config_t gpio_cfg = {
-        .dit_pin = CONFIG_GET_GPIO_DIT(),
-        .dah_pin = CONFIG_GET_GPIO_DAH(),
-        .tx_pin = CONFIG_GET_GPIO_TX(),
-        .active_low = true,        /* Paddles are active low (internal pull-up) */
-        .tx_active_high = true,    /* TX output is active high */
-        .isr_blanking_us = 1500,   /* ISR blanking period for debounce (0 = polling only) */
-    };
-    ESP_LOGI(TAG, "GPIO config from g_config: DIT=%d, DAH=%d, TX=%d",
-             gpio_cfg.dit_pin, gpio_cfg.dah_pin, gpio_cfg.tx_pin);
-    hal_gpio_init(&gpio_cfg);
-    printf(">>> hal_gpio_init OK\n");
+/**
+ * @brief Audio init task (Core 1): codec bring-up takes I2C round trips
+ *
+ * rt_task is already running and discards audio until the codec is up.
+ */
+static void init_audio_task(void *arg) {
+    (void)arg;
+    int phase = boot_begin("audio");
+
+    hal_audio_config_t audio_cfg;
+    hal_target_audio_defaults(&audio_cfg);
+    audio_cfg.output_mode = (hal_audio_output_mode_t)CONFIG_GET_AUDIO_OUTPUT();
+    audio_cfg.sample_rate = audio_rate_from_index(CONFIG_GET_SAMPLE_RATE());
+    audio_cfg.input_enable = CONFIG_GET_RX_DECODE();
+    hal_audio_init(&audio_cfg);
 
-    /* Initialize USB CDC (before console) */
-    printf(">>> usb_cdc_init...\n");
-    ESP_ERROR_CHECK(usb_cdc_init());
-    printf(">>> usb_cdc_init OK\n");
+    /* Enable PA for sidetone output (TODO: integrate with PTT for proper control) */
+    hal_audio_set_pa(true);
+    boot_end(phase);
 
-    /* Initialize LED strip */
-    led_config_t led_cfg = {
-        .gpio_data = atomic_load_explicit(&g_config.leds.gpio_data, memory_order_relaxed),
-        .led_count = atomic_load_explicit(&g_config.leds.count, memory_order_relaxed),
-        .brightness = atomic_load_explicit(&g_config.leds.brightness, memory_order_relaxed),
-        .brightness_dim = atomic_load_explicit(&g_config.leds.brightness_dim, memory_order_relaxed),
-    };
-    ret = led_init(&led_cfg);
-    if (ret == ESP_OK) {
-        led_set_state(LED_STATE_BOOT);
-    } else {
-        ESP_LOGW(TAG, "LED init failed (non-fatal): %s", esp_err_to_name(ret));
-    }
+    /* Create off-air decoder task on Core 1 (deletes itself unless rx_decode) */
+    xTaskCreatePinnedToCore(
+        audio_rx_task,
+        "audio_rx",
+        4096,
+        NULL,
+        tskIDLE_PRIORITY + 2,
+        NULL,
+        1  /* Core 1 */
+    );
+
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Network init task (Core 1): TCP/IP, WiFi, VPN, WebUI and the
+ * tasks that need sockets
+ */
+static void init_net_task(void *arg) {
+    (void)arg;
+    int phase = boot_begin("tcpip");
+
+    /* Initialize TCP/IP stack unconditionally (required for HTTP server even without WiFi) */
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    boot_end(phase);
 
     /* Initialize WiFi if enabled */
+    phase = boot_begin("wifi");
     if (atomic_load_explicit(&g_config.wifi.enabled, memory_order_relaxed)) {
         ESP_LOGI(TAG, "WiFi enabled, initializing...");
         wifi_config_app_t wifi_cfg = {
@@ -176,7 +282,7 @@ void app_main(void) {
         strncpy(wifi_cfg.gateway, g_config.wifi.gateway, sizeof(wifi_cfg.gateway) - 1);
         strncpy(wifi_cfg.dns, g_config.wifi.dns, sizeof(wifi_cfg.dns) - 1);
 
-        ret = wifi_app_init(&wifi_cfg);
+        esp_err_t ret = wifi_app_init(&wifi_cfg);
         if (ret == ESP_OK) {
             led_set_state(LED_STATE_WIFI_CONNECTING);
             wifi_app_start();
@@ -188,9 +294,11 @@ void app_main(void) {
         ESP_LOGI(TAG, "WiFi disabled");
         led_set_state(LED_STATE_IDLE);
     }
+    boot_end(phase);
 
     /* Initialize VPN if enabled (requires WiFi) */
     if (atomic_load_explicit(&g_config.vpn.enabled, memory_order_relaxed)) {
+        phase = boot_begin("vpn");
         ESP_LOGI(TAG, "VPN enabled, initializing...");
         vpn_config_app_t vpn_cfg = {
             .enabled = true,
@@ -203,103 +311,359 @@ void app_main(void) {
         strncpy(vpn_cfg.client_address, g_config.vpn.client_address, sizeof(vpn_cfg.client_address) - 1);
         strncpy(vpn_cfg.allowed_ips, g_config.vpn.allowed_ips, sizeof(vpn_cfg.allowed_ips) - 1);
 
-        ret = vpn_app_init(&vpn_cfg);
+        esp_err_t ret = vpn_app_init(&vpn_cfg);
         if (ret == ESP_OK) {
             vpn_app_start();  /* Non-blocking, spawns task on Core 1 */
         } else {
             ESP_LOGE(TAG, "VPN init failed: %s", esp_err_to_name(ret));
         }
+        boot_end(phase);
     } else {
         ESP_LOGI(TAG, "VPN disabled");
     }
 
+    /* MQTT telemetry if a broker is set (connects once an interface is up) */
+    if (CONFIG_GET_MQTT_URL()[0] != '\0') {
+        phase = boot_begin("mqtt");
+        mqtt_telemetry_init();
+        boot_end(phase);
+    }
+
+    /* Initialize WebUI (HTTP server; serves as soon as an interface is up) */
+    phase = boot_begin("webui");
+    ESP_LOGI(TAG, "Initializing WebUI...");
+    webui_init();
+    webui_start();
+    boot_end(phase);
+
+    /* Create CWNet network I/O task on Core 1 (above the BG services: sends are latency-critical) */
+    xTaskCreateStaticPinnedToCore(
+        cwnet_task,
+        "cwnet",
+        sizeof(s_cwnet_stack),
+        NULL,
+        tskIDLE_PRIORITY + 3,
+        s_cwnet_stack,
+        &s_cwnet_tcb,
+        1  /* Core 1 */
+    );
+
+    /* Create ESP-NOW link task on Core 1 (deletes itself unless enabled) */
+    xTaskCreatePinnedToCore(
+        espnow_task,
+        "espnow",
+        3072,
+        NULL,
+        tskIDLE_PRIORITY + 3,
+        NULL,
+        1  /* Core 1 */
+    );
+
+    /* Create WinKeyer TCP port task on Core 1 (deletes itself unless winkeyer.wk_tcp_port) */
+    xTaskCreatePinnedToCore(
+        winkeyer_tcp_task,
+        "wk_tcp",
+        4096,
+        NULL,
+        tskIDLE_PRIORITY + 3,
+        NULL,
+        1  /* Core 1 */
+    );
+
+    /* Create telnet console task on Core 1, lowest priority (deletes itself unless system.console_tcp_port) */
+    xTaskCreatePinnedToCore(
+        console_tcp_task,
+        "con_tcp",
+        4096,
+        NULL,
+        tskIDLE_PRIORITY + 1,
+        NULL,
+        1  /* Core 1 */
+    );
+
+    /* Create remote syslog task on Core 1, lowest priority (deletes itself unless system.syslog_host) */
+    xTaskCreatePinnedToCore(
+        syslog_sink_task,
+        "syslog",
+        4096,
+        NULL,
+        tskIDLE_PRIORITY + 1,
+        NULL,
+        1  /* Core 1 */
+    );
+
+    vTaskDelete(NULL);
+}
+
+void app_main(void) {
+    /* Timeline first: every later step records a phase */
+    boot_heap_t heap = boot_heap();
+    boot_timeline_init(&g_boot_timeline, &heap);
+    int phase = boot_begin("early");
+    metrics_init(&g_metrics);
+
+    ESP_LOGI(TAG, "keyer_c starting on %s (%s), %d MHz...", hal_target()->name,
+             hal_target()->board, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+
+    /* Initialize log streams FIRST (before any RT_* logging) */
+    log_stream_init(&g_rt_log_stream);
+    log_stream_init(&g_bg_log_stream);
+
+    /* Flight recorder: keep what the previous boot left, log this one */
+    esp_reset_reason_t reset_reason = esp_reset_reason();
+    bool fdr_kept = flight_rec_boot(&g_flight_rec, (uint8_t)reset_reason, esp_timer_get_time());
+    ESP_LOGI(TAG, "Flight recorder: boot %lu, reset reason %d%s",
+             (unsigned long)g_flight_rec.boot_count, (int)reset_reason,
+             fdr_kept ? "" : " (cleared)");
+
+    /* Enable RT diagnostics for boot debugging */
+    atomic_store_explicit(&g_rt_diag_enabled, true, memory_order_relaxed);
+
+    /* Initialize UART logger early for boot logs (GPIO6, 115200 until config loads) */
+    uart_logger_init();
+    boot_end(phase);
+
+    /* Initialize NVS */
+    phase = boot_begin("nvs");
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+    boot_end(phase);
+
+    /* ===== PROVISIONING CHECK (before normal boot) ===== */
+
+    /* Check for factory reset request (both paddles held 5s) */
+    phase = boot_begin("provisioning");
+    if (provisioning_check_factory_reset(DEFAULT_GPIO_DIT, DEFAULT_GPIO_DAH, FACTORY_RESET_HOLD_MS)) {
+        ESP_LOGW(TAG, "Factory reset triggered - rebooting to provisioning mode");
+        esp_restart();
+    }
+
+    /* Check if provisioning is needed (WiFi not configured) */
+    if (provisioning_is_needed()) {
+        ESP_LOGI(TAG, "WiFi not configured - entering provisioning mode");
+        provisioning_start();  /* Does not return - reboots after config */
+    }
+    boot_end(phase);
+
+    /* ===== NORMAL BOOT CONTINUES ===== */
+
+    /* Initialize config with defaults, then load from NVS */
+    phase = boot_begin("config");
+    config_init_defaults(&g_config);
+    int loaded = config_load_from_nvs();
+    if (loaded > 0) {
+        ESP_LOGI(TAG, "Loaded %d parameters from NVS", loaded);
+    } else {
+        ESP_LOGI(TAG, "Using default configuration");
+    }
+    boot_end(phase);
+
+    /* ===== RT KEYING PATH FIRST ===== */
+
+    /* Initialize HAL GPIO using values from g_config (loaded from NVS or defaults) */
+    phase = boot_begin("rt_path");
+    hal_gpio_config_t gpio_cfg = {
+        .dit_pin = CONFIG_GET_GPIO_DIT(),
+        .dah_pin = CONFIG_GET_GPIO_DAH(),
+        .tx_pin = CONFIG_GET_GPIO_TX(),
+        .tx2_pin = CONFIG_GET_GPIO_TX2(),   /* SO2R radio 2 (0 = single radio) */
+        .active_low = true,        /* Paddles are active low (internal pull-up) */
+        .tx_active_high = true,    /* TX output is active high */
+        .isr_blanking_us = 1500,   /* ISR blanking period for debounce (0 = polling only) */
+        .touch_threshold_pct = CONFIG_GET_TOUCH_THRESHOLD_PCT(),
+        .touch_latency_us = 1000000U / CONFIG_GET_TICK_RATE_HZ(),  /* Sensed within one RT tick */
+    };
+    ESP_LOGI(TAG, "GPIO config from g_config: DIT=%d, DAH=%d, TX=%d, TX2=%d",
+             gpio_cfg.dit_pin, gpio_cfg.dah_pin, gpio_cfg.tx_pin, gpio_cfg.tx2_pin);
+    hal_gpio_init(&gpio_cfg);
+
+#ifdef CONFIG_PM_ENABLE
+    /* timing.idle_sleep_s: automatic light sleep once the RT task blocks.
+     * CPU frequency stays fixed so keying timing never depends on DFS. */
+    if (CONFIG_GET_IDLE_SLEEP_S() > 0) {
+        esp_pm_config_t pm_cfg = {
+            .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+            .min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+            .light_sleep_enable = true,
+        };
+        esp_err_t pm_err = esp_pm_configure(&pm_cfg);
+        ESP_LOGI(TAG, "Idle light sleep after %us: %s",
+                 (unsigned)CONFIG_GET_IDLE_SLEEP_S(), esp_err_to_name(pm_err));
+    }
+#endif
+
+    /* USB audio ring before rt_task fills it and TinyUSB drains it */
+    audio_buffer_init(&g_usb_audio, s_usb_audio_buffer, USB_AUDIO_RING_SAMPLES);
+
     /* Initialize stream */
     ESP_LOGI(TAG, "Initializing keying stream (%d samples)", STREAM_BUFFER_SIZE);
     stream_init(&g_keying_stream, s_stream_buffer, STREAM_BUFFER_SIZE);
+    stream_registry_init(&s_stream_registry);
+    stream_attach_registry(&g_keying_stream, &s_stream_registry);
+    stream_handoffs_init(&g_stream_handoffs);
+
+    /* History archive in PSRAM, allocated once (size needs a reboot);
+     * without PSRAM the hot ring is all the history there is */
+#ifdef CONFIG_SPIRAM
+    size_t history = CONFIG_GET_STREAM_HISTORY_SLOTS();
+    while ((history & (history - 1)) != 0) {
+        history &= history - 1;  /* Round down to a power of 2 */
+    }
+    if (history >= STREAM_BUFFER_SIZE) {
+        bool compact = CONFIG_GET_STREAM_HISTORY_COMPACT();
+        size_t bytes = compact ? sizeof(stream_compact_t) : sizeof(stream_slot_t);
+        void *archive = heap_caps_calloc(history, bytes, MALLOC_CAP_SPIRAM);
+        if (archive == NULL) {
+            ESP_LOGW(TAG, "Stream history archive: %u samples unavailable, hot ring only",
+                     (unsigned)history);
+        } else if (compact) {
+            stream_attach_compact_archive(&g_keying_stream, &s_stream_archive, archive, history);
+        } else {
+            stream_attach_archive(&g_keying_stream, &s_stream_archive, archive, history);
+        }
+        if (archive != NULL) {
+            ESP_LOGI(TAG, "Stream history archive: %u %s samples in PSRAM",
+                     (unsigned)history, compact ? "compact" : "full");
+        }
+    }
+#else
+    ESP_LOGI(TAG, "Stream history: hot ring only (no PSRAM)");
+#endif
+    audio_buffer_init(&g_rig_audio, s_rig_audio_buffer, RIG_AUDIO_BUFFER_SIZE);
 
     /* Initialize fault state */
     fault_init(&g_fault_state);
+    fault_log_init(&g_fault_log);
+    metrics_register_all(&g_metrics, k_system_metrics,
+                         sizeof(k_system_metrics) / sizeof(k_system_metrics[0]));
 
-    hal_audio_config_t audio_cfg = HAL_AUDIO_CONFIG_DEFAULT;
-    hal_audio_init(&audio_cfg);
+    /* Initialize text keyer (rt_task ticks it) */
+    text_keyer_config_t text_cfg = {
+        .paddle_abort = &g_paddle_active,
+    };
+    text_keyer_init(&text_cfg);
 
-    /* Enable PA for sidetone output (TODO: integrate with PTT for proper control) */
-    hal_audio_set_pa(true);
+    /* Create RT task on Core 0 (highest priority) */
+    xTaskCreateStaticPinnedToCore(
+        rt_task,
+        "rt_task",
+        sizeof(s_rt_stack),
+        NULL,
+        configMAX_PRIORITIES - 1,
+        s_rt_stack,
+        &s_rt_tcb,
+        0  /* Core 0 */
+    );
+    boot_end(phase);
+    ESP_LOGI(TAG, "RT keying path up at %lld us", (long long)esp_timer_get_time());
+
+    /* ===== CONCURRENT BRING-UP ===== */
+
+    /* LED strip before init_net reports WiFi progress on it */
+    phase = boot_begin("led");
+    led_config_t led_cfg = {
+        .gpio_data = atomic_load_explicit(&g_config.leds.gpio_data, memory_order_relaxed),
+        .led_count = atomic_load_explicit(&g_config.leds.count, memory_order_relaxed),
+        .brightness = atomic_load_explicit(&g_config.leds.brightness, memory_order_relaxed),
+        .brightness_dim = atomic_load_explicit(&g_config.leds.brightness_dim, memory_order_relaxed),
+    };
+    ret = led_init(&led_cfg);
+    if (ret == ESP_OK) {
+        led_set_state(LED_STATE_BOOT);
+    } else {
+        ESP_LOGW(TAG, "LED init failed (non-fatal): %s", esp_err_to_name(ret));
+    }
+    boot_end(phase);
+
+    /* Audio codec and networking in their own init tasks on Core 1 */
+    xTaskCreatePinnedToCore(init_audio_task, "init_audio", 4096, NULL,
+                            tskIDLE_PRIORITY + 2, NULL, 1);
+    xTaskCreatePinnedToCore(init_net_task, "init_net", 6144, NULL,
+                            tskIDLE_PRIORITY + 2, NULL, 1);
+
+    /* Initialize USB CDC (before console) */
+    phase = boot_begin("usb");
+    ESP_ERROR_CHECK(usb_cdc_init());
+    boot_end(phase);
 
     /* Initialize console */
+    phase = boot_begin("ui");
     console_init();
 
-    /* Initialize WebUI (requires WiFi to be connected) */
-    ESP_LOGI(TAG, "Initializing WebUI...");
-    webui_init();
-    webui_start();
-
     /* Initialize decoder (creates its own stream consumer) */
     decoder_init();
 
-    /* Initialize text keyer */
-    text_keyer_config_t text_cfg = {
-        .paddle_abort = &g_paddle_active,
-    };
-    text_keyer_init(&text_cfg);
+    /* Text memories from NVS (the keyer itself is already up) */
     text_memory_init();
 
+    /* Iambic presets and their plans, saved ones from NVS */
+    iambic_preset_init();
+    iambic_preset_load();
+    boot_end(phase);
+
     ESP_LOGI(TAG, "Creating tasks...");
 
-    /* Create RT task on Core 0 (highest priority) */
-    xTaskCreatePinnedToCore(
-        rt_task,
-        "rt_task",
-        4096,
-        NULL,
-        configMAX_PRIORITIES - 1,
+    /* A freshly updated image must pass its self-test (housekeeping) */
+    ota_check_init();
+
+    /* Flash recorder partition; it writes only while idle, like the NVS worker */
+    recorder_init(keyer_is_idle);
+
+    /* Create BG service tasks on Core 1 (decoder, net, ui_push, housekeeping, recorder) */
+    bg_services_start();
+
+    /* Create deferred NVS persistence task on Core 1 (saves only while idle, not shed) */
+    config_persist_start(nvs_may_commit);
+
+    /* Create USB log drain task on Core 1 */
+    xTaskCreateStaticPinnedToCore(
+        usb_log_task,
+        "usb_log",
+        sizeof(s_usb_log_stack),
         NULL,
-        0  /* Core 0 */
+        tskIDLE_PRIORITY + 1,
+        s_usb_log_stack,
+        &s_usb_log_tcb,
+        1  /* Core 1 */
     );
 
-    /* Create BG task on Core 1 */
+    /* Create WinKeyer USB port task on Core 1 (deletes itself unless winkeyer.wk_usb) */
     xTaskCreatePinnedToCore(
-        bg_task,
-        "bg_task",
-        4096,
+        usb_winkeyer_task,
+        "usb_wk",
+        3072,
         NULL,
-        tskIDLE_PRIORITY + 2,
+        tskIDLE_PRIORITY + 3,
         NULL,
         1  /* Core 1 */
     );
 
-    /* Create USB log drain task on Core 1 */
+    /* Create USB paddle output task on Core 1 (deletes itself unless usb.usb_midi / usb.usb_hid) */
     xTaskCreatePinnedToCore(
-        usb_log_task,
-        "usb_log",
-        4096,
+        usb_paddle_task,
+        "usb_paddle",
+        3072,
         NULL,
-        tskIDLE_PRIORITY + 1,
+        tskIDLE_PRIORITY + 3,
         NULL,
         1  /* Core 1 */
     );
 
-    /* Create UART log drain task on Core 1 (for boot logs, stopped after USB ready) */
-    xTaskCreatePinnedToCore(
+    /* Create UART log drain task on Core 1 (own log readers: runs alongside USB) */
+    xTaskCreateStaticPinnedToCore(
         uart_logger_task,
         "uart_log",
-        2048,
+        sizeof(s_uart_log_stack),
         NULL,
         tskIDLE_PRIORITY + 1,
-        &s_uart_log_task_handle,
+        s_uart_log_stack,
+        &s_uart_log_tcb,
         1  /* Core 1 */
     );
 
-    /* Wait for USB CDC to be ready, then stop UART logger */
-    ESP_LOGI(TAG, "Waiting for USB CDC...");
-    while (!usb_cdc_connected(CDC_ITF_CONSOLE)) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-    }
-    ESP_LOGI(TAG, "USB CDC connected, stopping UART logger");
-    if (s_uart_log_task_handle != NULL) {
-        vTaskDelete(s_uart_log_task_handle);
-        s_uart_log_task_handle = NULL;
-    }
-
     ESP_LOGI(TAG, "keyer_c started successfully");
 }
@@ -0,0 +1,71 @@
+/**
+ * @file ota_check.c
+ * @brief Confirm or roll back the first boot of an updated image
+ *
+ * With CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE an image written by POST
+ * /api/ota boots as "pending verify". The housekeeping service polls
+ * ota_check_poll() once a second; once ota_self_test_judge() passes
+ * (OTA_SELF_TEST_MS without a fault, enough heap, network up so the next
+ * update can reach it) the image is marked valid. If it fails, or the
+ * image crashes before then, the bootloader returns to the previous one.
+ */
+
+#include "esp_ota_ops.h"
+#include "esp_heap_caps.h"
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "keyer_core.h"
+#include "rt_log.h"
+#include "wifi.h"
+
+extern fault_state_t g_fault_state;
+
+static bool s_pending = false;
+
+/**
+ * @brief Note whether the running image still needs its self-test
+ */
+void ota_check_init(void) {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (running != NULL && esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        s_pending = true;
+    }
+}
+
+/**
+ * @brief Run the self-test step (housekeeping, once a second)
+ */
+void ota_check_poll(int64_t now_us) {
+    if (!s_pending) {
+        return;
+    }
+
+    wifi_state_t ws = wifi_get_state();
+    ota_health_t health = {
+        .uptime_ms = (uint32_t)(now_us / 1000),
+        .fault_active = fault_is_active(&g_fault_state),
+        .heap_free = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        .reachable = (ws == WIFI_STATE_CONNECTED || ws == WIFI_STATE_AP_MODE ||
+                      ws == WIFI_STATE_DISABLED),
+    };
+
+    switch (ota_self_test_judge(&health)) {
+        case OTA_VERDICT_PASS:
+            s_pending = false;
+            esp_ota_mark_app_valid_cancel_rollback();
+            RT_INFO(&g_bg_log_stream, now_us, "OTA self-test passed, image confirmed");
+            break;
+        case OTA_VERDICT_FAIL:
+            s_pending = false;
+            RT_ERROR(&g_bg_log_stream, now_us,
+                     "OTA self-test failed (fault=%d heap=%" PRIu32 " net=%d), rolling back",
+                     (int)health.fault_active, health.heap_free, (int)health.reachable);
+            esp_ota_mark_app_invalid_rollback_and_reboot();
+            break;
+        default:
+            break;
+    }
+}
@@ -3,7 +3,34 @@
  * @brief Real-time task (Core 0)
  *
  * Hard real-time keying loop:
- * GPIO Poll → Iambic FSM → Stream Push → Audio/TX Consume
+ * GPIO Poll + ISR Edges → Iambic FSM → Stream Push → Audio/TX Consume
+ *
+ * Paced by hal_tick: FreeRTOS tick (1ms) or gptimer ISR notification
+ * (timing.rt_pacing, period from timing.tick_rate_hz). One stream sample is
+ * pushed per tick, so the stream tick rate equals the loop rate.
+ *
+ * Idle sleep (timing.idle_sleep_s): after that long with nothing keying,
+ * sounding or queued the loop stops ticking and sleeps until a paddle
+ * press (hal_sleep). The ticks slept through are added to the LOCAL idle
+ * run, so the stream records the gap as silence and its timebase holds.
+ *
+ * Remote TX (remote.remote_tx): received keying is played on its own tick
+ * (remote_tx.h) and joins the local key on TX and PTT, with a key-down
+ * watchdog (remote.tx_watchdog_ms) against a lost link.
+ *
+ * PTT lead: text schedules are known ahead, so PTT is raised
+ * timing.ptt_lead_ms before their first element (playback waits for it
+ * if the text was queued later than that). Paddle keying can not be
+ * foreseen: it reaches TX timing.ptt_paddle_lead_ms after PTT instead.
+ *
+ * SO2R (keyer.radio, hardware.gpio_tx2): the one keying path drives the
+ * TX output of the radio in focus. A new focus is taken on a tick with
+ * nothing half sent (radio_focus.h); PTT restarts and the sidetone moves
+ * to that radio's pitch, so the ear tells the radios apart.
+ *
+ * Presets (keyer.preset): Core 1 hands the plan of the preset in use over
+ * a seqlock (iambic_preset_read_handoff()); while one is in use it stands
+ * in for the keyer.* timing parameters, latched like them between elements.
  *
  * ARCHITECTURE.md compliance:
  * - Runs on Core 0 with highest priority
@@ -19,22 +46,55 @@
 #include "keyer_core.h"
 #include "iambic.h"
 #include "sidetone.h"
+#include "audio_source.h"
+#include "audio_playout.h"
+#include "audio_rate.h"
+#include "audio_mixer.h"
 #include "ptt.h"
 #include "rt_log.h"
 #include "hal_gpio.h"
 #include "hal_audio.h"
+#include "hal_tick.h"
+#include "hal_sleep.h"
 #include "config.h"
 #include "text_keyer.h"
 
 /* Drift threshold: 5% */
 #define DIAG_DRIFT_THRESHOLD_PCT 5
 
-/* Audio samples per RT tick: 8000 Hz sample rate / 1000 Hz tick rate = 8 */
-#define SAMPLES_PER_TICK 8
+/*
+ * Audio is rendered at the codec rate (audio.sample_rate) in blocks sized
+ * to the tick and written to the codec once at least 1ms of samples is
+ * pending. At 1 kHz that is one write per tick (8-48 samples); at 10 kHz
+ * 0-5 samples per tick are rendered and written every ~1ms, bounding codec
+ * write overhead at high tick rates.
+ */
+#define MAX_SAMPLES_PER_MS   (AUDIO_RATE_MAX_HZ / 1000U)
+
+/* Rig, USB and decoder audio run at the stream rate */
+#define STREAM_SAMPLES_PER_MS (AUDIO_STREAM_RATE_HZ / 1000U)
+
+/* Mixer gain ramp (volume, ducking) */
+#define MIX_RAMP_MS          4U
+
+/* Rig audio level above audio.rig_latency_ms that triggers a trim
+ * (arrival jitter of a few 32ms blocks is normal) */
+#define RIG_AUDIO_TRIM_MS    128
+
+/* Idle sleep wakes this often to look for text, remote CW and config
+ * changes, which have no wake source of their own */
+#define IDLE_POLL_MS         100
 
 /* External globals */
 extern keying_stream_t g_keying_stream;
+extern stream_handoffs_t g_stream_handoffs;
 extern fault_state_t g_fault_state;
+extern fault_log_t g_fault_log;
+extern audio_ring_buffer_t g_rig_audio;
+extern audio_ring_buffer_t g_usb_audio;
+
+/* Rig audio playout (written here, read by `stats audio`) */
+audio_playout_t g_rig_playout;
 
 /* Paddle state for text keyer abort (Core 1 reads this) */
 atomic_bool g_paddle_active = ATOMIC_VAR_INIT(false);
@@ -62,9 +122,9 @@ static rt_diag_state_t s_diag = {0};
 static int64_t get_expected_duration(const iambic_processor_t *iambic) {
     switch (iambic->state) {
         case IAMBIC_STATE_SEND_DIT:
-            return iambic_dit_duration_us(&iambic->config);
+            return iambic->timing.dit_us;
         case IAMBIC_STATE_SEND_DAH:
-            return iambic_dah_duration_us(&iambic->config);
+            return iambic->timing.dah_us;
         default:
             return 0;
     }
@@ -139,163 +199,512 @@ static void rt_diag_log(rt_diag_state_t *diag,
     diag->prev_iambic_state = iambic->state;
 }
 
+/**
+ * @brief Delayed TX edge without the timer (set on the first tick due)
+ */
+typedef struct {
+    bool armed;
+    bool on;
+    int64_t at_us;
+} tx_pending_t;
+
+static tx_pending_t s_tx_pending = {0};
+
+/**
+ * @brief Set TX now, or hand the edge to the timer for edge_us + lead + delay_us
+ */
+static void set_tx_output(bool tx_timed, bool on, int64_t edge_us, uint32_t delay_us,
+                          int64_t now_us) {
+    if (!tx_timed && delay_us == 0 && !s_tx_pending.armed) {
+        (void)tx_sched_plan(&g_tx_sched, on, now_us, now_us);  /* Level only */
+        hal_gpio_set_tx(on);
+        key_latency_tx(&g_key_latency, on, esp_timer_get_time());
+        return;
+    }
+
+    int64_t tx_at = tx_sched_plan_delayed(&g_tx_sched, on, edge_us, delay_us, now_us);
+    if (tx_at != 0) {
+        if (tx_timed) {
+            hal_gpio_set_tx_at(on, tx_at);
+        } else {
+            /* One edge held at a time: an earlier one still waiting goes out now */
+            if (s_tx_pending.armed) {
+                hal_gpio_set_tx(s_tx_pending.on);
+            }
+            s_tx_pending = (tx_pending_t){ .armed = true, .on = on, .at_us = tx_at };
+        }
+    }
+    key_latency_tx(&g_key_latency, on, (tx_at != 0) ? tx_at : esp_timer_get_time());
+}
+
+/**
+ * @brief Set a held TX edge once due (untimed TX only)
+ */
+static void tx_pending_tick(int64_t now_us) {
+    if (s_tx_pending.armed && now_us >= s_tx_pending.at_us) {
+        hal_gpio_set_tx(s_tx_pending.on);
+        s_tx_pending.armed = false;
+    }
+}
+
+/**
+ * @brief Sidetone pitch of a radio (0-based)
+ */
+static uint32_t radio_tone_hz(const rt_config_snapshot_t *snap, uint8_t radio) {
+    return (radio == 0U) ? snap->sidetone_freq_hz : snap->sidetone2_freq_hz;
+}
+
+/**
+ * @brief Fill iambic config from the RT config snapshot
+ */
+static void iambic_config_from_snapshot(iambic_config_t *cfg, const rt_config_snapshot_t *snap) {
+    cfg->wpm = snap->wpm;
+    cfg->mode = (iambic_mode_t)snap->iambic_mode;
+    cfg->memory_mode = (memory_mode_t)snap->memory_mode;
+    cfg->squeeze_mode = (squeeze_mode_t)snap->squeeze_mode;
+    cfg->mem_window_start_pct = snap->mem_window_start_pct;
+    cfg->mem_window_end_pct = snap->mem_window_end_pct;
+}
+
 void rt_task(void *arg) {
     (void)arg;
 
-    /* Initialize iambic processor from g_config */
+    /* RT parameters come from the seqlock snapshot, copied once per change.
+     * Writers are on Core 1, so waiting out one in progress here is bounded. */
+    rt_config_snapshot_t snap;
+    unsigned snap_seq;
+    while (!config_read_rt_snapshot(&snap, &snap_seq)) {
+    }
+
+    /* Initialize iambic processor from the snapshot */
     iambic_config_t iambic_cfg;
-    iambic_cfg.wpm = (uint32_t)CONFIG_GET_WPM();
-    iambic_cfg.mode = (iambic_mode_t)CONFIG_GET_IAMBIC_MODE();
-    iambic_cfg.memory_mode = (memory_mode_t)CONFIG_GET_MEMORY_MODE();
-    iambic_cfg.squeeze_mode = (squeeze_mode_t)CONFIG_GET_SQUEEZE_MODE();
-    iambic_cfg.mem_window_start_pct = CONFIG_GET_MEM_WINDOW_START_PCT();
-    iambic_cfg.mem_window_end_pct = CONFIG_GET_MEM_WINDOW_END_PCT();
+    iambic_config_from_snapshot(&iambic_cfg, &snap);
     iambic_processor_t iambic;
     iambic_init(&iambic, &iambic_cfg);
 
-    /* Initialize hard RT consumer */
+    /* Preset handoff (iambic.h): this copy is the plan the FSM latches, so
+     * only this task writes it. Odd seq: the first tick reads it */
+    iambic_preset_handoff_t preset = { .in_use = false };
+    unsigned preset_seq = 1U;
+
+    /* Initialize hard RT consumer (headroom for REMOTE slots between LOCAL ones) */
     hard_rt_consumer_t consumer;
-    hard_rt_consumer_init(&consumer, &g_keying_stream, &g_fault_state, 2);
+    hard_rt_consumer_init(&consumer, &g_keying_stream, &g_fault_state,
+                          2 + HARD_RT_MAX_FOREIGN_PER_TICK);
+    hard_rt_consumer_register(&consumer, "rt_tx");
+
+    /* Sidetone plays local keying, or the remote station while we are idle */
+    audio_source_selector_t audio_src;
+    audio_source_init(&audio_src);
 
     /* Initialize sidetone generator from config */
     sidetone_gen_t sidetone;
-    uint32_t sidetone_freq = CONFIG_GET_SIDETONE_FREQ_HZ();
-    uint32_t fade_ms = CONFIG_GET_FADE_DURATION_MS();
-    if (fade_ms > UINT16_MAX / SAMPLES_PER_TICK) {
-        fade_ms = UINT16_MAX / SAMPLES_PER_TICK;
+    uint32_t sidetone_freq = snap.sidetone_freq_hz;
+    const uint32_t sample_rate = audio_rate_from_index(CONFIG_GET_SAMPLE_RATE());
+    const uint32_t samples_per_ms = sample_rate / 1000U;
+    const uint32_t rate_factor = audio_rate_factor(sample_rate);
+    uint32_t fade_ms = snap.fade_duration_ms;
+    if (fade_ms > UINT16_MAX / samples_per_ms) {
+        fade_ms = UINT16_MAX / samples_per_ms;
     }
-    uint16_t fade_samples = (uint16_t)(fade_ms * SAMPLES_PER_TICK);
-    if (fade_samples < SAMPLES_PER_TICK) fade_samples = SAMPLES_PER_TICK;  /* Minimum 1ms fade */
-    sidetone_init(&sidetone, sidetone_freq, 8000, fade_samples);
+    uint16_t fade_samples = (uint16_t)(fade_ms * samples_per_ms);
+    if (fade_samples < samples_per_ms) fade_samples = (uint16_t)samples_per_ms;  /* Minimum 1ms fade */
+    if (fade_samples > FADE_ENV_MAX_LEN) fade_samples = (uint16_t)FADE_ENV_MAX_LEN;
+    sidetone_init(&sidetone, sidetone_freq, sample_rate, fade_samples);
+
+    /* Shaped ramp: built once here, one table read per ramp sample after */
+    static fade_env_t fade_env;
+    fade_env_build(&fade_env, (fade_shape_t)CONFIG_GET_FADE_SHAPE(), fade_samples);
+    sidetone_set_envelope(&sidetone, &fade_env);
+
+    /* Rig audio from CWNet plays a fixed delay behind its arrival */
+    size_t rig_target = (size_t)snap.rig_latency_ms * STREAM_SAMPLES_PER_MS;
+    audio_playout_init(&g_rig_playout, &g_rig_audio, rig_target,
+                       rig_target + RIG_AUDIO_TRIM_MS * STREAM_SAMPLES_PER_MS);
+    audio_playout_set_upsample(&g_rig_playout, (uint8_t)rate_factor);
+
+    /* Sidetone and rig audio are summed under their own gains; volume and
+     * ducking changes ramp over MIX_RAMP_MS */
+    audio_mixer_t mixer;
+    audio_mixer_init(&mixer, MIX_RAMP_MS * samples_per_ms);
+    int16_t tone_block[MAX_SAMPLES_PER_MS];
+    int16_t rig_block[MAX_SAMPLES_PER_MS];
 
     /* Initialize PTT controller from config */
     ptt_controller_t ptt;
-    ptt_init(&ptt, CONFIG_GET_PTT_TAIL_MS());
+    ptt_init(&ptt, snap.ptt_tail_ms);
+
+    /* Every codec block is copied for the USB audio function (audio.usb_audio) */
+    bool usb_audio = CONFIG_GET_USB_AUDIO();
+    audio_decimator_t usb_decim;
+    audio_decimator_init(&usb_decim, rate_factor);
+
+    /* Initialize loop pacing (HW timer or FreeRTOS tick fallback) */
+    uint32_t tick_rate_hz = CONFIG_GET_TICK_RATE_HZ();
+    hal_tick_config_t tick_cfg = {
+        .mode = (hal_tick_mode_t)CONFIG_GET_RT_PACING(),
+        .period_us = (tick_rate_hz > 0) ? (1000000U / tick_rate_hz) : HAL_TICK_MAX_PERIOD_US,
+    };
+    hal_tick_init(&tick_cfg);
+    const uint32_t tick_period_us = hal_tick_get_period_us();
+
+    /* Fault recovery policy (timing.fault_*), converted to ticks */
+    const uint32_t ticks_per_s = 1000000U / tick_period_us;
+    hard_rt_recovery_t recovery = {
+        .clean_ticks = (uint32_t)(((uint64_t)CONFIG_GET_FAULT_RECOVER_MS() * 1000U +
+                                   tick_period_us - 1U) / tick_period_us),
+        .latch_after = CONFIG_GET_FAULT_LATCH_COUNT(),
+        .latch_window = (uint32_t)CONFIG_GET_FAULT_LATCH_WINDOW_S() * ticks_per_s,
+    };
+    hard_rt_consumer_set_recovery(&consumer, &recovery);
+
+    /* Stream samples are time-aligned at the (possibly fallback) tick rate */
+    stream_set_tick_period_us(&g_keying_stream, tick_period_us);
+
+    /* Idle sleep needs the paddle ISR: a polled press could not wake us */
+    uint32_t idle_sleep_s = CONFIG_GET_IDLE_SLEEP_S();
+    if (!hal_gpio_isr_enabled()) {
+        idle_sleep_s = 0;
+    }
+
+    /* Received keying is played tick-exact for the monitor, and keys TX in
+     * remote TX mode. A remote shack never sleeps: the first element after
+     * a nap would go out up to IDLE_POLL_MS late */
+    const bool remote_tx_mode = CONFIG_GET_REMOTE_TX();
+    remote_tx_init(&g_remote_tx, (uint32_t)(((uint64_t)CONFIG_GET_TX_WATCHDOG_MS() * 1000U) /
+                                            tick_period_us));
+    hard_rt_consumer_set_remote(&consumer, &g_remote_tx);
+    if (remote_tx_mode) {
+        idle_sleep_s = 0;
+    }
+    rt_idle_init(&g_rt_idle, idle_sleep_s * ticks_per_s);
+    bool idle_sleeping = false;
+    int64_t idle_since_us = 0;
+
+    /* Audio samples per tick may be fractional (e.g. 0.8 at 10 kHz): accumulate */
+    uint32_t audio_acc = 0;
+    int16_t audio_block[2U * MAX_SAMPLES_PER_MS];
+    size_t audio_pending = 0;
+
+    /* Per-stage cycle profiling (written only by this task) */
+    rt_prof_init(&g_rt_prof);
+
+    /* Paddle-to-output latency probe (console `latency`, off until asked) */
+    key_latency_init(&g_key_latency);
+
+    /* Timed TX: each edge goes out one tick (+ guard) after the FSM made it */
+    const bool tx_timed = hal_gpio_tx_timed();
+    tx_sched_init(&g_tx_sched, tx_timed ? tick_period_us + TX_SCHED_GUARD_US : 0,
+                  tx_timed ? TX_SCHED_GUARD_US : 0U);
+    bool iambic_key = false;
+    bool text_key = false;
 
-    TickType_t last_wake = xTaskGetTickCount();
-    const TickType_t period = pdMS_TO_TICKS(1);  /* 1ms tick */
+    /* SO2R: radio 1 first, keyer.radio is taken on the first quiet tick */
+    radio_focus_init(&g_radio_focus, hal_gpio_tx_count());
+    radio_focus_request(&g_radio_focus, (uint8_t)(snap.radio - 1U));
+
+    /* PTT lead for text, TX delay behind PTT for paddles */
+    uint32_t text_lead_us = snap.ptt_lead_ms * 1000U;
+    uint32_t paddle_lead_us = snap.ptt_paddle_lead_ms * 1000U;
+    bool remote_key = false;
 
     /* Log startup */
     int64_t now_us = esp_timer_get_time();
-    RT_INFO(&g_rt_log_stream, now_us, "RT task started");
+    RT_INFO(&g_rt_log_stream, now_us, "RT task started (%s, %luus)",
+            hal_tick_mode_str(hal_tick_get_mode()), (unsigned long)tick_period_us);
+
+    /* Sidetone volume as Q15 gain, refreshed whenever a new snapshot arrives */
+    uint16_t gain_q15 = sidetone_gain_from_pct(snap.sidetone_volume);
+    uint16_t rig_gain_q15 = sidetone_gain_from_pct(snap.rig_volume);
+
+    /* LOCAL tick 0 of the stream timebase starts now */
+    const int64_t epoch_us = esp_timer_get_time();
+    stream_set_epoch_us(&g_keying_stream, epoch_us);
 
-    /* Track config generation for hot-reload */
-    uint16_t last_config_gen = atomic_load_explicit(&g_config.generation, memory_order_acquire);
+    /* Flight recorder: key edges and new faults (RT lane) */
+    bool fdr_key = false;
+    int64_t fdr_edge_us = now_us;
+    uint32_t fdr_faults = fault_get_count(&g_fault_state);
+    bool fault_latched = false;
 
     for (;;) {
         now_us = esp_timer_get_time();
 
-        /* Check for config changes and hot-reload during IDLE */
-        uint16_t current_gen = atomic_load_explicit(&g_config.generation, memory_order_acquire);
-        if (current_gen != last_config_gen && iambic.state == IAMBIC_STATE_IDLE) {
-            /* Reload iambic config from g_config (safe during IDLE only) */
-            iambic_cfg.wpm = (uint32_t)CONFIG_GET_WPM();
-            iambic_cfg.mode = (iambic_mode_t)CONFIG_GET_IAMBIC_MODE();
-            iambic_cfg.memory_mode = (memory_mode_t)CONFIG_GET_MEMORY_MODE();
-            iambic_cfg.squeeze_mode = (squeeze_mode_t)CONFIG_GET_SQUEEZE_MODE();
-            iambic_cfg.mem_window_start_pct = CONFIG_GET_MEM_WINDOW_START_PCT();
-            iambic_cfg.mem_window_end_pct = CONFIG_GET_MEM_WINDOW_END_PCT();
-
-            /* Verify generation didn't change mid-read (optimistic read) */
-            uint16_t gen_after = atomic_load_explicit(&g_config.generation, memory_order_acquire);
-            if (gen_after != current_gen) {
-                continue;  /* Torn read - retry next tick */
+        /* New snapshot published? One atomic load per tick when unchanged;
+         * a copy racing a writer keeps the old snapshot until next tick */
+        if (config_rt_snapshot_seq() != snap_seq &&
+            config_read_rt_snapshot(&snap, &snap_seq)) {
+            /* Iambic config is latched by the FSM at the next element
+             * boundary; a preset in use takes precedence */
+            iambic_config_from_snapshot(&iambic_cfg, &snap);
+            if (!preset.in_use) {
+                iambic_queue_config(&iambic, &iambic_cfg);
             }
 
-            iambic_set_config(&iambic, &iambic_cfg);
+            /* Volume is live; convert once per change */
+            gain_q15 = sidetone_gain_from_pct(snap.sidetone_volume);
+            rig_gain_q15 = sidetone_gain_from_pct(snap.rig_volume);
 
-            /* Reload sidetone frequency */
-            uint32_t new_freq = CONFIG_GET_SIDETONE_FREQ_HZ();
-            if (new_freq != sidetone_freq) {
-                sidetone_set_frequency(&sidetone, new_freq);
-                sidetone_freq = new_freq;
+            /* Reload sidetone frequency (of the radio in focus) */
+            uint32_t freq = radio_tone_hz(&snap, radio_focus_active(&g_radio_focus));
+            if (freq != sidetone_freq) {
+                sidetone_freq = freq;
+                sidetone_set_frequency(&sidetone, sidetone_freq);
             }
+            radio_focus_request(&g_radio_focus, (uint8_t)(snap.radio - 1U));
 
-            /* Reload PTT tail */
-            ptt_set_tail(&ptt, CONFIG_GET_PTT_TAIL_MS());
+            /* Reload PTT tail and leads */
+            ptt_set_tail(&ptt, snap.ptt_tail_ms);
+            text_lead_us = snap.ptt_lead_ms * 1000U;
+            paddle_lead_us = snap.ptt_paddle_lead_ms * 1000U;
 
             RT_INFO(&g_rt_log_stream, now_us, "Config updated: WPM=%lu freq=%lu",
                     (unsigned long)iambic_cfg.wpm, (unsigned long)sidetone_freq);
-            last_config_gen = current_gen;
         }
 
-        /* 1. Poll GPIO paddles */
+        /* Preset put in use, edited or released on Core 1: same check, and
+         * the FSM latches it at the next element boundary too */
+        if (iambic_preset_handoff_seq() != preset_seq &&
+            iambic_preset_read_handoff(&preset, &preset_seq)) {
+            if (preset.in_use) {
+                iambic_queue_plan(&iambic, &preset.plan);
+            } else {
+                iambic_queue_config(&iambic, &iambic_cfg);
+            }
+        }
+
+        /* Per-stage cycle counts (CONFIG_KEYER_RT_PROFILE) */
+        RT_PROF_START(prof_loop);
+        RT_PROF_START(prof_lap);
+
+        /* 0. Foreign lanes (CWNet, ESP-NOW) handed over from Core 1: this
+         * task writes their slots, so none is ever left claimed but
+         * uncommitted in front of the consumer (stream_handoff.h) */
+        (void)stream_handoffs_drain(&g_stream_handoffs, HARD_RT_MAX_FOREIGN_PER_TICK);
+
+        /* 1. Poll GPIO paddles (captured edges are debounced into the
+         * edge queue first, capture backend only) */
+        hal_gpio_collect_edges(now_us);
         gpio_state_t gpio = hal_gpio_read_paddles();
 
-        /* 1b. Override with ISR-detected presses (low latency path) */
-        if (hal_gpio_consume_dit_press()) {
-            gpio.bits |= GPIO_DIT_BIT;
-        }
-        if (hal_gpio_consume_dah_press()) {
-            gpio.bits |= GPIO_DAH_BIT;
+        /* 1b. ISR-detected presses are replayed at their edge time (step 2);
+         * the pending flags are redundant with the edge queue, just clear them */
+        (void)hal_gpio_consume_dit_press();
+        (void)hal_gpio_consume_dah_press();
+        paddle_edge_queue_t *edges = hal_gpio_edge_queue();
+
+        /* Latency probe: the oldest queued press carries its ISR time */
+        paddle_edge_t first_edge;
+        if (paddle_edge_peek(edges, &first_edge) && first_edge.level != 0) {
+            key_latency_edge(&g_key_latency, first_edge.timestamp_us);
         }
 
         /* Update paddle active flag for text keyer abort (Core 1) */
-        bool paddle_active = !gpio_is_idle(gpio);
+        bool paddle_active = !gpio_is_idle(gpio) || !paddle_edge_queue_empty(edges);
         atomic_store_explicit(&g_paddle_active, paddle_active, memory_order_release);
+        RT_PROF_LAP(RT_PROF_STAGE_GPIO, prof_lap);
+
+        /* 2. Tick iambic FSM (queued ISR edges first, then polled state) */
+        stream_sample_t sample = iambic_tick_edges(&iambic, now_us, gpio, edges);
+        RT_PROF_LAP(RT_PROF_STAGE_IAMBIC, prof_lap);
+
+        /* 2a. A key edge on this tick happened at the FSM element boundary:
+         * key down starts the element, key up starts the gap */
+        int64_t key_edge_us = now_us;
+        if ((sample.local_key != 0) != iambic_key) {
+            iambic_key = (sample.local_key != 0);
+            key_edge_us = iambic.element_start_us;
+        }
 
-        /* 2. Tick iambic FSM */
-        stream_sample_t sample = iambic_tick(&iambic, now_us, gpio);
+        /* 2b. Text coming up within the PTT lead raises PTT now; playback
+         * holds until PTT has led by that much */
+        bool text_hold = false;
+        if (text_lead_us > 0) {
+            uint32_t until_us = text_keyer_rt_until_key_us(text_lead_us);
+            text_hold = !ptt_lead(&ptt, (uint64_t)now_us, until_us, text_lead_us);
+        }
+        text_keyer_rt_hold(text_hold);
 
-        /* 2b. Override with text keyer state if active (mutually exclusive with paddle) */
-        if (text_keyer_is_key_down()) {
+        /* 2c. Play the text keyer schedule on this tick (a paddle stops it here too) */
+        bool text_on = text_keyer_rt_tick(tick_period_us, paddle_active);
+        bool text_edge = (text_on != text_key);
+        text_key = text_on;
+        if (text_on) {
             sample.local_key = 1;
+            key_edge_us = now_us;
         }
 
+        /* 2d. Remote key channel: the level played on the previous tick
+         * (step 4a runs after the push); the push flags its edges */
+        sample = sample_with_remote_channel(sample, remote_key);
+
         /* 3. Push to stream */
         if (!stream_push(&g_keying_stream, sample)) {
             fault_set(&g_fault_state, FAULT_PRODUCER_OVERRUN, 0);
         }
+        RT_PROF_LAP(RT_PROF_STAGE_STREAM_PUSH, prof_lap);
 
         /* 4. Consume for audio/TX (co-located, no context switch) */
         stream_sample_t out;
         hard_rt_result_t result = hard_rt_consumer_tick(&consumer, &out);
 
+        /* 4a. Received keying due on this tick (queued by the consumer) */
+        uint64_t now_tick = (uint64_t)((now_us - epoch_us) / (int64_t)tick_period_us);
+        bool remote_edge = (remote_tx_tick(&g_remote_tx, now_tick) != remote_key);
+        remote_key = g_remote_tx.key_down;
+        bool remote_on = remote_tx_mode && remote_key;
+
         /* Handle consumer result */
         switch (result) {
-            case HARD_RT_OK:
-                /* Update TX output */
-                hal_gpio_set_tx(out.local_key != 0);
+            case HARD_RT_OK: {
+                /* Update TX output (edge time is only known for this tick's
+                 * own sample, or the remote edge's tick) */
+                int64_t edge_us = (out.local_key == sample.local_key) ? key_edge_us : now_us;
+                uint32_t delay_us = (text_on || text_edge) ? 0U : paddle_lead_us;
+                if (remote_tx_mode && remote_edge) {
+                    edge_us = epoch_us + (int64_t)(g_remote_tx.edge_tick * tick_period_us);
+                    delay_us = 0;
+                }
+                set_tx_output(tx_timed, out.local_key != 0 || remote_on, edge_us, delay_us,
+                              now_us);
                 break;
+            }
 
             case HARD_RT_FAULT:
                 /* FAULT - stop TX/audio immediately */
                 hal_gpio_set_tx(false);
+                tx_sched_reset_level(&g_tx_sched);
+                s_tx_pending.armed = false;
+                key_latency_tx(&g_key_latency, false, now_us);
                 sidetone_reset(&sidetone);
                 ptt_force_off(&ptt);
-                RT_ERROR(&g_rt_log_stream, now_us, "FAULT: %s",
-                         fault_code_str(fault_get_code(&g_fault_state)));
+                remote_tx_release(&g_remote_tx);
+                remote_key = false;
+                remote_on = false;
+                break;
+
+            case HARD_RT_RECOVERED:
+                /* Clean long enough: resume from the head, key still up */
+                fault_log_record(&g_fault_log, now_us, FAULT_EV_RECOVERED, FAULT_NONE,
+                                 (uint32_t)consumer.recoveries);
+                RT_WARN(&g_rt_log_stream, now_us, "FAULT recovered (%lu)",
+                        (unsigned long)consumer.recoveries);
                 break;
 
             case HARD_RT_NO_DATA:
-                /* No new data - use previous state (out is unchanged) */
+                /* No new data - use previous state (out is unchanged),
+                 * but a remote edge still lands on its tick */
+                if (remote_tx_mode && remote_edge) {
+                    set_tx_output(tx_timed, out.local_key != 0 || remote_on,
+                                  epoch_us + (int64_t)(g_remote_tx.edge_tick * tick_period_us),
+                                  0, now_us);
+                }
                 break;
         }
+        tx_pending_tick(now_us);
+
+        /* 4b. SO2R focus change, only between characters: no element,
+         * paddle memory, text, remote keying or TX edge in flight */
+        bool focus_idle = out.local_key == 0 && !iambic_key && !text_key && !remote_on &&
+                          iambic.state == IAMBIC_STATE_IDLE &&
+                          !iambic.dit_memory && !iambic.dah_memory &&
+                          !hal_gpio_get_tx() && !s_tx_pending.armed &&
+                          hard_rt_consumer_lag(&consumer) == 0 &&
+                          text_keyer_get_state() == TEXT_KEYER_IDLE;
+        if (radio_focus_tick(&g_radio_focus, focus_idle)) {
+            uint8_t radio = radio_focus_active(&g_radio_focus);
+            hal_gpio_select_tx(radio);
+            tx_sched_reset_level(&g_tx_sched);
+            ptt_force_off(&ptt);
+            sidetone_freq = radio_tone_hz(&snap, radio);
+            sidetone_set_frequency(&sidetone, sidetone_freq);
+            RT_INFO(&g_rt_log_stream, now_us, "Radio %u", (unsigned)radio + 1U);
+        }
+
+        RT_PROF_LAP(RT_PROF_STAGE_CONSUMER, prof_lap);
 
         /* Generate and write audio ALWAYS (even when stream empty) to maintain I2S sync */
         bool key_down = (out.local_key != 0);
-        int16_t audio_samples[SAMPLES_PER_TICK];
-        uint8_t volume = CONFIG_GET_SIDETONE_VOLUME();  /* 1-100 */
-        for (int i = 0; i < SAMPLES_PER_TICK; i++) {
-            int32_t sample = sidetone_next_sample(&sidetone, key_down);
-            audio_samples[i] = (int16_t)((sample * volume) / 100);
+        audio_source_set_sidetone(&audio_src, key_down);
+        audio_source_set_remote(&audio_src, remote_key);
+        bool tone_on = (audio_source_update(&audio_src) != AUDIO_SOURCE_NONE);
+        int16_t *audio_samples = &audio_block[audio_pending];
+        audio_acc += sample_rate * tick_period_us;
+        size_t n_samples = audio_acc / 1000000U;
+        audio_acc -= (uint32_t)n_samples * 1000000U;
+        if (n_samples > samples_per_ms) {
+            n_samples = samples_per_ms;
+        }
+        bool tone_sounding = tone_on || sidetone_is_active(&sidetone);   /* Incl. fade tail */
+        sidetone_render(&sidetone, tone_block, n_samples, tone_on, SIDETONE_GAIN_UNITY);
+        for (size_t i = 0; i < n_samples; i++) {
+            rig_block[i] = 0;
+        }
+        size_t rig_n = audio_playout_mix(&g_rig_playout, rig_block, n_samples,
+                                         SIDETONE_GAIN_UNITY);
+        audio_mixer_set_gain(&mixer, AUDIO_MIX_SIDETONE, gain_q15);
+        audio_mixer_set_gain(&mixer, AUDIO_MIX_RIG,
+                             audio_source_rig_gain(&audio_src, rig_gain_q15, snap.rig_duck_pct));
+        const int16_t *const mix_src[AUDIO_MIX_COUNT] = {
+            [AUDIO_MIX_SIDETONE] = tone_sounding ? tone_block : NULL,
+            [AUDIO_MIX_RIG] = (rig_n > 0) ? rig_block : NULL,
+        };
+        audio_mixer_render(&mixer, audio_samples, mix_src, n_samples);
+        RT_PROF_LAP(RT_PROF_STAGE_SIDETONE, prof_lap);
+
+        /* Flight recorder and fault timeline (a few plain stores per record) */
+        if (key_down != fdr_key) {
+            flight_rec_rt(&g_flight_rec, now_us, FLIGHT_EV_EDGE, key_down ? 1U : 0U,
+                          (uint32_t)(now_us - fdr_edge_us));
+            fdr_key = key_down;
+            fdr_edge_us = now_us;
+        }
+        uint32_t faults = fault_get_count(&g_fault_state);
+        if (faults != fdr_faults) {
+            fault_code_t code = fault_get_code(&g_fault_state);
+            uint32_t data = fault_get_data(&g_fault_state);
+            flight_rec_rt(&g_flight_rec, now_us, FLIGHT_EV_FAULT, (uint8_t)code, data);
+            fault_log_record(&g_fault_log, now_us, FAULT_EV_RAISED, code, data);
+            RT_ERROR(&g_rt_log_stream, now_us, "FAULT: %s (lag %lu)",
+                     fault_code_str(code), (unsigned long)data);
+            fdr_faults = faults;
+        }
+        if (hard_rt_consumer_latched(&consumer) != fault_latched) {
+            fault_latched = hard_rt_consumer_latched(&consumer);
+            if (fault_latched) {
+                fault_log_record(&g_fault_log, now_us, FAULT_EV_LATCHED,
+                                 fault_get_code(&g_fault_state), consumer.window_faults);
+                RT_ERROR(&g_rt_log_stream, now_us, "FAULT latched after %lu faults",
+                         (unsigned long)consumer.window_faults);
+            }
         }
 
-        /* DEBUG: Log when key goes down and check ALL audio samples */
+        /* DEBUG: Log when key goes down with first audio sample of the block */
         static bool prev_key = false;
         if (key_down && !prev_key) {
-            RT_INFO(&g_rt_log_stream, now_us, "KEY - s:%d %d %d %d %d %d %d %d f=%d p=%d",
-                    audio_samples[0], audio_samples[1], audio_samples[2], audio_samples[3],
-                    audio_samples[4], audio_samples[5], audio_samples[6], audio_samples[7],
+            RT_INFO(&g_rt_log_stream, now_us, "KEY - s0:%d n=%u f=%d p=%d",
+                    (n_samples > 0) ? audio_samples[0] : 0, (unsigned)n_samples,
                     sidetone.fade_state, sidetone.fade_pos);
         }
         prev_key = key_down;
 
         /* ALWAYS write to I2S (even silence) to keep codec/I2S synchronized */
-        hal_audio_write(audio_samples, SAMPLES_PER_TICK);
+        audio_pending += n_samples;
+        if (audio_pending >= samples_per_ms) {
+            key_latency_audio(&g_key_latency, audio_block, audio_pending, esp_timer_get_time());
+            hal_audio_write(audio_block, audio_pending);
+            if (usb_audio) {
+                /* Never blocks: a ring nobody drains just stays full */
+                /* In place: the block is done with once written */
+                size_t n_usb = audio_decimate(&usb_decim, audio_block, audio_pending, audio_block);
+                (void)audio_buffer_write(&g_usb_audio, audio_block, n_usb);
+            }
+            audio_pending = 0;
+            RT_PROF_LAP(RT_PROF_STAGE_AUDIO_WRITE, prof_lap);
+        }
 
-        /* Update PTT on key down */
-        if (key_down) {
+        /* Update PTT on key down (local, or remote in remote TX mode) */
+        if (key_down || remote_on) {
             ptt_audio_sample(&ptt, (uint64_t)now_us);
         }
 
@@ -308,8 +717,47 @@ void rt_task(void *arg) {
 
         /* 7. ISR blanking timer management (must be in task context) */
         hal_gpio_isr_tick(now_us);
+        RT_PROF_SINCE(RT_PROF_STAGE_TOTAL, prof_loop);
+
+        /* 8. Idle sleep: nothing keying, sounding or waiting to be played */
+        bool quiet = idle_sleep_s > 0 && !paddle_active && !key_down &&
+                     remote_tx_idle(&g_remote_tx) && !tone_sounding && rig_n == 0 &&
+                     !ptt_is_on(&ptt) && !hal_gpio_get_tx() && !s_tx_pending.armed &&
+                     audio_buffer_len(&g_rig_audio) == 0 &&
+                     hard_rt_consumer_lag(&consumer) == 0 &&
+                     !stream_handoffs_pending(&g_stream_handoffs) &&
+                     text_keyer_get_state() == TEXT_KEYER_IDLE;
+        if (!quiet && idle_sleeping) {
+            idle_sleeping = false;
+            RT_INFO(&g_rt_log_stream, now_us, "Idle sleep: awake after %lums",
+                    (unsigned long)((now_us - idle_since_us) / 1000));
+        }
+        if (rt_idle_tick(&g_rt_idle, quiet)) {
+            if (!idle_sleeping) {
+                idle_sleeping = true;
+                idle_since_us = now_us;
+                RT_INFO(&g_rt_log_stream, now_us, "Idle sleep after %lus",
+                        (unsigned long)idle_sleep_s);
+            }
+            int64_t sleep_us = esp_timer_get_time();
+            bool pressed = hal_sleep_until_press(IDLE_POLL_MS);
+            int64_t resume_us = esp_timer_get_time();
+
+            /* The waking press is queued with its ISR time and replayed
+             * from there on the next tick */
+            int64_t edge_us = 0;
+            if (pressed && paddle_edge_peek(edges, &first_edge)) {
+                edge_us = first_edge.timestamp_us;
+            }
+            uint32_t slept = rt_idle_wake(&g_rt_idle, resume_us - sleep_us, tick_period_us,
+                                          edge_us, resume_us);
+            stream_skip(&g_keying_stream, slept);
+            audio_acc = 0;
+            audio_pending = 0;
+            continue;
+        }
 
-        /* Wait for next tick */
-        vTaskDelayUntil(&last_wake, period);
+        /* Wait for next tick (timer notification or FreeRTOS delay) */
+        hal_tick_wait();
     }
 }
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""
+Size/speed report of firmware build variants (profiles/README.md).
+
+For each variant, reads the section sizes of the build's ELF and the
+on-device "bench" output captured from that image, and prints two
+Markdown tables: sizes and ns per operation, each figure with its change
+from the first variant.
+
+Usage:
+    bench_report.py NAME BUILD_DIR[:BENCH_FILE] [NAME BUILD_DIR[:BENCH_FILE] ...]
+
+BENCH_FILE is a console log of "bench" or a saved GET /api/bench body: the
+first line that holds a {"schema":...} object is used. BUILD_DIR is an
+idf.py build directory; its project_description.json names the ELF and
+the app image. Without bench files (all variants) only the size table is
+printed, e.g. for CI builds of the profiles.
+"""
+
+import json
+import os
+import struct
+import sys
+
+# ELF sections summed per column (ESP32-S3 and ESP32-P4 linker script names)
+SIZE_GROUPS = [
+    ("app.bin", None),
+    ("flash code", (".flash.text",)),
+    ("flash rodata", (".flash.rodata", ".flash.appdesc")),
+    ("IRAM", (".iram0.vectors", ".iram0.text", ".iram0.data", ".iram0.bss")),
+    ("DRAM", (".dram0.data", ".dram0.bss")),
+    ("PSRAM bss", (".ext_ram.bss",)),
+]
+
+SHT_NOBITS = 8
+
+
+def elf_sections(path: str) -> dict:
+    """Return {section name: size} of a 32-bit little-endian ELF"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError(f"{path}: not a 32-bit little-endian ELF")
+
+    e_shoff, = struct.unpack_from("<I", data, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    headers = []
+    for i in range(e_shnum):
+        name, sh_type, _, _, offset, size = struct.unpack_from(
+            "<IIIIII", data, e_shoff + i * e_shentsize)
+        headers.append((name, sh_type, offset, size))
+
+    strtab_off = headers[e_shstrndx][2]
+    sections = {}
+    for name, _, _, size in headers:
+        end = data.index(b"\0", strtab_off + name)
+        sections[data[strtab_off + name:end].decode()] = size
+    return sections
+
+
+def build_sizes(build_dir: str) -> dict:
+    with open(os.path.join(build_dir, "project_description.json")) as f:
+        desc = json.load(f)
+    elf = os.path.join(build_dir, desc["app_elf"])
+    app_bin = os.path.join(build_dir, desc["app_bin"])
+
+    sections = elf_sections(elf)
+    sizes = {}
+    for col, names in SIZE_GROUPS:
+        if names is None:
+            sizes[col] = os.path.getsize(app_bin)
+        else:
+            sizes[col] = sum(sections.get(n, 0) for n in names)
+    return sizes
+
+
+def load_bench(path: str) -> dict:
+    with open(path, errors="replace") as f:
+        for line in f:
+            start = line.find('{"schema"')
+            if start >= 0:
+                return json.loads(line[start:].strip())
+    raise ValueError(f"{path}: no bench JSON found")
+
+
+def change(value: float, base: float) -> str:
+    if not base:
+        return ""
+    return f" ({(value - base) * 100.0 / base:+.1f}%)"
+
+
+def report(variants: list) -> str:
+    out = []
+    names = [v["name"] for v in variants]
+    benched = all(v["bench"] is not None for v in variants)
+
+    if benched:
+        out.append("| Variant | target | MHz | opt | hot | LTO | RT IRAM |")
+        out.append("|---------|--------|-----|-----|-----|-----|---------|")
+        for v in variants:
+            b = v["bench"]
+            out.append(f"| {v['name']} | {b.get('target', 'esp32s3')} | {b.get('cpu_mhz', '?')} | "
+                       f"{b.get('opt', '?')} | {b.get('hot_opt', '?')} | "
+                       f"{'yes' if b.get('lto') else 'no'} | "
+                       f"{'yes' if b.get('rt_iram') else 'no'} |")
+        out.append("")
+
+    out.append("| Size (bytes) | " + " | ".join(names) + " |")
+    out.append("|---|" + "---|" * len(names))
+    base = variants[0]["sizes"]
+    for col, _ in SIZE_GROUPS:
+        cells = [f"{v['sizes'][col]}{change(v['sizes'][col], base[col]) if i else ''}"
+                 for i, v in enumerate(variants)]
+        out.append(f"| {col} | " + " | ".join(cells) + " |")
+    if not benched:
+        return "\n".join(out)
+    out.append("")
+
+    out.append("| Kernel (ns/op) | " + " | ".join(names) + " |")
+    out.append("|---|" + "---|" * len(names))
+    per_variant = [{k["name"]: k["ns_per_op"] for k in v["bench"]["kernels"]} for v in variants]
+    kernels = [k["name"] for k in variants[0]["bench"]["kernels"]]
+    for k in kernels:
+        base_ns = per_variant[0][k]
+        cells = []
+        for i, ns in enumerate(per_variant):
+            if k not in ns:
+                cells.append("-")
+            else:
+                cells.append(f"{ns[k]:.2f}{change(ns[k], base_ns) if i else ''}")
+        out.append(f"| {k} | " + " | ".join(cells) + " |")
+    return "\n".join(out)
+
+
+def main() -> int:
+    args = sys.argv[1:]
+    if not args or len(args) % 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    variants = []
+    for name, spec in zip(args[0::2], args[1::2]):
+        build_dir, sep, bench_file = spec.rpartition(":")
+        if not sep:
+            build_dir, bench_file = spec, None
+        try:
+            variants.append({
+                "name": name,
+                "sizes": build_sizes(build_dir),
+                "bench": load_bench(bench_file) if bench_file else None,
+            })
+        except (OSError, ValueError, KeyError) as e:
+            print(f"bench_report: {name}: {e}", file=sys.stderr)
+            return 1
+
+    print(report(variants))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
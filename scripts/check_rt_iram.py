@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+Check that the RT hot path of a linked firmware never touches flash.
+
+Walks the direct call graph of the ELF disassembly starting at rt_task and
+fails if any reachable function lives in the flash-mapped instruction bus
+(IROM). Also checks that the RT data objects are not in flash-mapped or
+PSRAM address space. Run after link when CONFIG_KEYER_RT_IRAM is enabled.
+
+Usage:
+    check_rt_iram.py --objdump <objdump> --nm <nm> <firmware.elf>
+
+Indirect calls (callx through function pointers) cannot be followed; they
+are listed so that new ones get reviewed. Functions in COLD are only called
+with the keyer idle and are not followed either.
+"""
+
+import argparse
+import bisect
+import re
+import subprocess
+import sys
+from collections import deque
+
+# ESP32-S3 address map
+IROM_RANGE = (0x42000000, 0x44000000)     # Flash-mapped instructions
+DROM_PSRAM_RANGE = (0x3C000000, 0x3E000000)  # Flash rodata and PSRAM data
+
+ROOTS = ["rt_task"]
+
+# Cold paths rt_task calls with nothing keying (idle sleep: drivers, I2C)
+COLD = ["hal_sleep_until_press"]
+
+# Data rt_task reads every tick
+RT_DATA = [
+    "s_stream_buffer",
+    "g_keying_stream",
+    "s_rig_audio_buffer",
+    "g_rig_audio",
+    "g_rt_log_stream",
+    "SINE_LUT",
+]
+
+FUNC_RE = re.compile(r"^([0-9a-f]+) <([^>]+)>:$")
+INSN_RE = re.compile(r"^\s*([0-9a-f]+):\s+(\S+)\s*(.*)$")
+TARGET_RE = re.compile(r"\b([0-9a-f]+) <([^>+]+)(?:\+0x[0-9a-f]+)?>")
+
+# Xtensa control transfers with an immediate target
+DIRECT_OPS = re.compile(r"^(call(0|4|8|12)|j|b[a-z]*)(\.n)?$")
+INDIRECT_OPS = re.compile(r"^callx(0|4|8|12)$")
+
+
+def in_range(addr: int, rng: tuple) -> bool:
+    return rng[0] <= addr < rng[1]
+
+
+def parse_disassembly(text: str):
+    """Return (funcs {addr: name}, edges {addr: set(target)}, indirect {addr: [site]})"""
+    funcs = {}
+    edges = {}
+    indirect = {}
+    current = None
+
+    for line in text.splitlines():
+        m = FUNC_RE.match(line)
+        if m:
+            current = int(m.group(1), 16)
+            funcs[current] = m.group(2)
+            edges.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        m = INSN_RE.match(line)
+        if not m:
+            continue
+        op, args = m.group(2), m.group(3)
+        if INDIRECT_OPS.match(op):
+            indirect.setdefault(current, []).append(int(m.group(1), 16))
+        elif DIRECT_OPS.match(op):
+            t = TARGET_RE.search(args)
+            if t:
+                edges[current].add(int(t.group(1), 16))
+
+    return funcs, edges, indirect
+
+
+def containing_func(starts: list, addr: int):
+    i = bisect.bisect_right(starts, addr) - 1
+    return starts[i] if i >= 0 else None
+
+
+def walk(roots: list, funcs: dict, edges: dict, cold: set = frozenset()):
+    """BFS over the call graph; returns {func_addr: parent_addr}"""
+    starts = sorted(funcs)
+    parent = {}
+    queue = deque()
+    for r in roots:
+        parent[r] = None
+        queue.append(r)
+
+    while queue:
+        f = queue.popleft()
+        if in_range(f, IROM_RANGE) and parent[f] is not None:
+            continue  # Report the first flash call on each path only
+        for target in edges.get(f, ()):
+            callee = target if target in funcs else containing_func(starts, target)
+            if callee is None or callee == f or callee in cold:
+                continue
+            if target not in funcs and not in_range(target, IROM_RANGE):
+                # Outside the disassembly (ROM): leaf
+                continue
+            if callee not in parent:
+                parent[callee] = f
+                queue.append(callee)
+    return parent
+
+
+def chain(addr: int, parent: dict, funcs: dict) -> str:
+    names = []
+    while addr is not None:
+        names.append(funcs.get(addr, hex(addr)))
+        addr = parent[addr]
+    return " <- ".join(names)
+
+
+def read_symbols(nm: str, elf: str) -> dict:
+    out = subprocess.run([nm, elf], check=True, capture_output=True, text=True).stdout
+    syms = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 3:
+            syms.setdefault(parts[2], int(parts[0], 16))
+    return syms
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--objdump", required=True)
+    ap.add_argument("--nm", required=True)
+    ap.add_argument("elf")
+    args = ap.parse_args()
+
+    text = subprocess.run([args.objdump, "-d", "--no-show-raw-insn", args.elf],
+                          check=True, capture_output=True, text=True).stdout
+    funcs, edges, indirect = parse_disassembly(text)
+
+    by_name = {}
+    for addr, name in funcs.items():
+        by_name.setdefault(name, []).append(addr)
+
+    roots = [a for r in ROOTS for a in by_name.get(r, [])]
+    if not roots:
+        print(f"check_rt_iram: root {ROOTS} not found in {args.elf}", file=sys.stderr)
+        return 1
+
+    errors = []
+    cold = {a for c in COLD for a in by_name.get(c, [])}
+    parent = walk(roots, funcs, edges, cold)
+    for addr in sorted(parent):
+        if in_range(addr, IROM_RANGE):
+            errors.append(f"flash function reachable: {chain(addr, parent, funcs)}")
+
+    syms = read_symbols(args.nm, args.elf)
+    for name in RT_DATA:
+        addr = syms.get(name)
+        if addr is not None and in_range(addr, DROM_PSRAM_RANGE):
+            errors.append(f"RT data in flash/PSRAM: {name} @ 0x{addr:08x}")
+
+    for f in sorted(a for a in parent if a in indirect):
+        sites = ", ".join(f"0x{s:08x}" for s in indirect[f])
+        print(f"check_rt_iram: note: indirect call in {funcs[f]} not followed ({sites})")
+
+    if errors:
+        for e in errors:
+            print(f"check_rt_iram: error: {e}", file=sys.stderr)
+        return 1
+
+    print(f"check_rt_iram: {len(parent)} functions reachable from rt_task, all in IRAM/ROM")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
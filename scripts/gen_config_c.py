@@ -66,6 +66,8 @@ def parse_v2_schema(schema: Dict) -> tuple:
 
 def generate_config_schema_json(params, families, output_dir: Path):
     """Generate JSON schema for WebUI."""
+    import gzip
+    import hashlib
     import json
 
     schema = {"parameters": []}
@@ -93,16 +95,33 @@ def generate_config_schema_json(params, families, output_dir: Path):
 
         schema['parameters'].append(p)
 
-    json_str = json.dumps(schema, indent=2)
+    # Compact and gzipped: served as-is like the embedded web assets
+    json_bytes = json.dumps(schema, separators=(',', ':')).encode('utf-8')
+    gz = gzip.compress(json_bytes, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(json_bytes).hexdigest()[:16]
 
-    # Generate C header with embedded JSON
+    lines = []
+    for i in range(0, len(gz), 16):
+        lines.append('    ' + ', '.join(f'0x{b:02x}' for b in gz[i:i + 16]) + ',')
+    gz_body = '\n'.join(lines)
+
+    # Generate C header with embedded gzipped JSON
     header_content = f'''/* Auto-generated - DO NOT EDIT */
 #ifndef CONFIG_SCHEMA_JSON_H
 #define CONFIG_SCHEMA_JSON_H
 
-static const char CONFIG_SCHEMA_JSON[] = R"JSON(
-{json_str}
-)JSON";
+#include <stddef.h>
+#include <stdint.h>
+
+/** Schema JSON, gzip-compressed ({len(json_bytes)} bytes uncompressed) */
+static const uint8_t CONFIG_SCHEMA_JSON_GZ[] = {{
+{gz_body}
+}};
+
+static const size_t CONFIG_SCHEMA_JSON_GZ_LEN = {len(gz)};
+
+/** Strong ETag: changes whenever the schema content changes */
+#define CONFIG_SCHEMA_ETAG "\\"{etag}\\""
 
 #endif
 '''
@@ -164,6 +183,9 @@ def main():
     print("Generating config_schema.h...")
     generate_config_schema_json(params, families, output_dir)
 
+    print("Generating config_persist.h/.c...")
+    generate_config_persist(output_dir)
+
     print(f"✓ Code generation complete: {output_dir}")
 
 
@@ -240,6 +262,20 @@ def get_field_comment(param: Dict) -> str:
     return f"{label}{range_str}"
 
 
+def get_rt_snapshot_params(params: List[Dict]) -> List[Dict]:
+    """Parameters copied into rt_config_snapshot_t, widest first for packing"""
+    rt = [p for p in params if p.get('rt_snapshot') and not is_string_type(p)]
+    width = {'u32': 4, 'u16': 2}
+    return sorted(rt, key=lambda p: -width.get(p['type'], 1))
+
+
+def get_config_path(param: Dict, families) -> str:
+    """Field path inside keyer_config_t"""
+    if families and param.get('family'):
+        return f"{param['family']}.{param['name']}"
+    return param['name']
+
+
 def generate_config_h(params: List[Dict], families: List[Dict], output_dir: Path):
     """Generate config.h with per-family structs (v2) or flat struct (v1)"""
 
@@ -332,11 +368,123 @@ void config_init_defaults(keyer_config_t *cfg);
 
 /**
  * @brief Increment generation counter to signal config change
+ *
+ * Also republishes the RT snapshot (g_rt_config).
+ *
  * @param cfg Configuration
  */
 void config_bump_generation(keyer_config_t *cfg);
 
+"""
+
+    rt_params = get_rt_snapshot_params(params)
+    code += """/* ============================================================================
+ * RT Snapshot
+ *
+ * Compact copy of the parameters marked `rt_snapshot: true`, so the RT task
+ * reads one contiguous struct per config change instead of CONFIG_GET_*
+ * loads spread across the family structs every tick.
+ *
+ * Published by config_bump_generation() with a seqlock: seq is odd while a
+ * writer is copying. Writers run on Core 1 only; the RT reader never spins,
+ * a torn read is reported and simply retried on the next tick.
+ * ============================================================================ */
+
+/** Snapshot alignment (ESP32-S3 cache line) */
+#define RT_CONFIG_SNAPSHOT_ALIGN 32
+
+/** @brief RT-relevant parameters, plain (non-atomic) copy */
+typedef struct {
+"""
+    for p in rt_params:
+        comment = get_field_comment(p)
+        code += f"    {get_c_storage_type(p)} {p['name']};  /**< {comment} */\n"
+    code += """    uint16_t generation;  /**< g_config.generation this copy reflects */
+} __attribute__((aligned(RT_CONFIG_SNAPSHOT_ALIGN))) rt_config_snapshot_t;
+
+/** @brief Seqlock-published RT snapshot */
+typedef struct {
+    atomic_uint seq;              /**< Even = stable, odd = write in progress */
+    rt_config_snapshot_t data;    /**< Guarded by seq */
+} rt_config_seqlock_t;
+
+/** Global RT snapshot (written by config_bump_generation) */
+extern rt_config_seqlock_t g_rt_config;
+
+/**
+ * @brief Copy the RT parameters of cfg into g_rt_config
+ * @param cfg Configuration
+ * @note NOT RT-safe; called by config_bump_generation() and after NVS load
+ */
+void config_publish_rt_snapshot(keyer_config_t *cfg);
+
+/**
+ * @brief Current snapshot sequence (cheap change check, one atomic load)
+ */
+static inline unsigned config_rt_snapshot_seq(void) {
+    return atomic_load_explicit(&g_rt_config.seq, memory_order_acquire);
+}
+
+/**
+ * @brief Read the RT snapshot without blocking (RT-safe)
+ *
+ * @param out Destination (left untouched on failure)
+ * @param seq_out Sequence the copy was taken at (compare with config_rt_snapshot_seq())
+ * @return true on a consistent copy, false if a writer was active
+ */
+static inline bool config_read_rt_snapshot(rt_config_snapshot_t *out, unsigned *seq_out) {
+    unsigned s1 = atomic_load_explicit(&g_rt_config.seq, memory_order_acquire);
+    if (s1 & 1U) {
+        return false;
+    }
+    rt_config_snapshot_t tmp = g_rt_config.data;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&g_rt_config.seq, memory_order_relaxed) != s1) {
+        return false;
+    }
+    *out = tmp;
+    *seq_out = s1;
+    return true;
+}
+
 /* ============================================================================
+ * Dirty Tracking
+ *
+ * One bit per parameter (index = order in parameters.yaml), set by every
+ * setter and taken by config_save_dirty_to_nvs(), so a save only writes
+ * the keys that changed since the last one.
+ * ============================================================================ */
+
+"""
+    code += f"#define CONFIG_PARAM_COUNT {len(params)}\n"
+    code += """#define CONFIG_DIRTY_WORDS ((CONFIG_PARAM_COUNT + 31) / 32)
+
+/** Dirty bitmap (bit i = parameter i) */
+extern atomic_uint g_config_dirty[CONFIG_DIRTY_WORDS];
+
+/**
+ * @brief Mark parameter idx as changed since the last save
+ */
+static inline void config_mark_dirty(unsigned idx) {
+    atomic_fetch_or_explicit(&g_config_dirty[idx / 32U], 1U << (idx % 32U),
+                             memory_order_release);
+}
+
+/**
+ * @brief Check if any parameter awaits saving
+ */
+static inline bool config_any_dirty(void) {
+    for (unsigned w = 0; w < CONFIG_DIRTY_WORDS; w++) {
+        if (atomic_load_explicit(&g_config_dirty[w], memory_order_acquire) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+"""
+
+    code += """/* ============================================================================
  * Parameter Access Macros
  * ============================================================================ */
 
@@ -349,7 +497,7 @@ void config_bump_generation(keyer_config_t *cfg);
         name_counts[n] = name_counts.get(n, 0) + 1
 
     # Add accessor macros with family path for v2
-    for p in params:
+    for idx, p in enumerate(params):
         name = p['name']
         family = p.get('family', None)
         upper = name.upper()
@@ -359,6 +507,8 @@ void config_bump_generation(keyer_config_t *cfg);
         else:
             macro_upper = upper
 
+        code += f"#define CONFIG_IDX_{macro_upper} {idx}\n\n"
+
         if is_string_type(p):
             max_len = get_string_max_length(p)
             if families and family:
@@ -368,6 +518,7 @@ void config_bump_generation(keyer_config_t *cfg);
                 code += f"#define CONFIG_SET_{macro_upper}(v) do {{ \\\n"
                 code += f"    strncpy(g_config.{family}.{name}, (v), {max_len}); \\\n"
                 code += f"    g_config.{family}.{name}[{max_len}] = '\\0'; \\\n"
+                code += f"    config_mark_dirty(CONFIG_IDX_{macro_upper}); \\\n"
                 code += f"    config_bump_generation(&g_config); \\\n"
                 code += f"}} while(0)\n\n"
             else:
@@ -377,6 +528,7 @@ void config_bump_generation(keyer_config_t *cfg);
                 code += f"#define CONFIG_SET_{macro_upper}(v) do {{ \\\n"
                 code += f"    strncpy(g_config.{name}, (v), {max_len}); \\\n"
                 code += f"    g_config.{name}[{max_len}] = '\\0'; \\\n"
+                code += f"    config_mark_dirty(CONFIG_IDX_{macro_upper}); \\\n"
                 code += f"    config_bump_generation(&g_config); \\\n"
                 code += f"}} while(0)\n\n"
         else:
@@ -386,6 +538,7 @@ void config_bump_generation(keyer_config_t *cfg);
                 code += f"    atomic_load_explicit(&g_config.{family}.{name}, memory_order_relaxed)\n\n"
                 code += f"#define CONFIG_SET_{macro_upper}(v) do {{ \\\n"
                 code += f"    atomic_store_explicit(&g_config.{family}.{name}, (v), memory_order_relaxed); \\\n"
+                code += f"    config_mark_dirty(CONFIG_IDX_{macro_upper}); \\\n"
                 code += f"    config_bump_generation(&g_config); \\\n"
                 code += f"}} while(0)\n\n"
             else:
@@ -394,6 +547,7 @@ void config_bump_generation(keyer_config_t *cfg);
                 code += f"    atomic_load_explicit(&g_config.{name}, memory_order_relaxed)\n\n"
                 code += f"#define CONFIG_SET_{macro_upper}(v) do {{ \\\n"
                 code += f"    atomic_store_explicit(&g_config.{name}, (v), memory_order_relaxed); \\\n"
+                code += f"    config_mark_dirty(CONFIG_IDX_{macro_upper}); \\\n"
                 code += f"    config_bump_generation(&g_config); \\\n"
                 code += f"}} while(0)\n\n"
 
@@ -429,6 +583,8 @@ def generate_config_c(params: List[Dict], families: List[Dict], output_dir: Path
 
 keyer_config_t g_config;
 
+atomic_uint g_config_dirty[CONFIG_DIRTY_WORDS];
+
 void config_init_defaults(keyer_config_t *cfg) {
 """
 
@@ -458,10 +614,47 @@ void config_init_defaults(keyer_config_t *cfg) {
                 code += f"    atomic_init(&cfg->{path}, {default_val});\n"
 
     code += """    atomic_init(&cfg->generation, 0);
+    for (unsigned w = 0; w < CONFIG_DIRTY_WORDS; w++) {
+        atomic_store_explicit(&g_config_dirty[w], 0, memory_order_relaxed);
+    }
+    config_publish_rt_snapshot(cfg);
 }
 
 void config_bump_generation(keyer_config_t *cfg) {
     atomic_fetch_add_explicit(&cfg->generation, 1, memory_order_release);
+    config_publish_rt_snapshot(cfg);
+}
+
+rt_config_seqlock_t g_rt_config;
+
+/* Set while a writer owns g_rt_config; a concurrent writer leaves its change
+ * to the owner, which re-copies until the generation stops moving */
+static atomic_bool s_rt_publishing;
+
+void config_publish_rt_snapshot(keyer_config_t *cfg) {
+    for (;;) {
+        if (atomic_exchange(&s_rt_publishing, true)) {
+            return;
+        }
+        uint16_t gen = atomic_load(&cfg->generation);
+
+        unsigned seq = atomic_load_explicit(&g_rt_config.seq, memory_order_relaxed);
+        atomic_store_explicit(&g_rt_config.seq, seq + 1U, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+"""
+    for p in get_rt_snapshot_params(params):
+        path = get_config_path(p, families)
+        code += f"        g_rt_config.data.{p['name']} = atomic_load_explicit(&cfg->{path}, memory_order_relaxed);\n"
+    code += """        g_rt_config.data.generation = gen;
+
+        atomic_store_explicit(&g_rt_config.seq, seq + 2U, memory_order_release);
+        atomic_store(&s_rt_publishing, false);
+
+        if (atomic_load(&cfg->generation) == gen) {
+            return;
+        }
+    }
 }
 """
 
@@ -558,6 +751,14 @@ extern "C" {
 /** NVS namespace for keyer configuration */
 #define CONFIG_NVS_NAMESPACE "keyer_cfg"
 
+/**
+ * NVS key of the packed config blob. Boot loads it in one read; it is
+ * rewritten with every save. The per-parameter keys stay written too and
+ * serve as the migration path when the blob's schema id no longer matches
+ * parameters.yaml (or its CRC fails).
+ */
+#define CONFIG_NVS_BLOB_KEY "cfg_blob"
+
 /**
  * @brief Load all parameters from NVS
  * @return Number of parameters loaded, or negative on error
@@ -570,6 +771,15 @@ int config_load_from_nvs(void);
  */
 int config_save_to_nvs(void);
 
+/**
+ * @brief Save only parameters changed since the last save (one commit)
+ *
+ * Takes the dirty bits; keys that fail to write stay dirty.
+ *
+ * @return Number of parameters saved (0 if none dirty), or negative on error
+ */
+int config_save_dirty_to_nvs(void);
+
 /* NVS key definitions */
 """
 
@@ -593,10 +803,141 @@ int config_save_to_nvs(void);
         f.write(code)
 
 
+def generate_config_blob_c(params: List[Dict], families: List[Dict]) -> str:
+    """Packed config blob: header + every parameter in parameters.yaml order.
+
+    Layout (little-endian):
+      [0..3]  magic "KCFG"
+      [4..7]  schema id (hash of path/type/size of every parameter)
+      [8..11] CRC-32 of the payload
+      [12..]  payload: u8/bool/enum 1 byte, u16 2, u32 4, strings max_length + 1
+    """
+    import hashlib
+
+    layout = []
+    offset = 0
+    for p in params:
+        ptype = p['type']
+        if is_string_type(p):
+            size = get_string_max_length(p) + 1
+        elif ptype in ('u8', 'enum', 'bool'):
+            size = 1
+        elif ptype == 'u16':
+            size = 2
+        else:
+            size = 4
+        layout.append((p, offset, size))
+        offset += size
+
+    sig = ';'.join(f"{p.get('family', '')}.{p['name']}:{p['type']}:{size}"
+                   for p, _, size in layout)
+    schema_id = int(hashlib.sha1(sig.encode('utf-8')).hexdigest()[:8], 16)
+
+    code = f"""/* ============================================================================
+ * Packed config blob (one NVS read at boot)
+ * ============================================================================ */
+
+#define CONFIG_BLOB_MAGIC   0x4746434BU  /* "KCFG" */
+#define CONFIG_BLOB_SCHEMA  0x{schema_id:08X}U
+#define CONFIG_BLOB_HEADER  12
+#define CONFIG_BLOB_PAYLOAD {offset}
+#define CONFIG_BLOB_SIZE    (CONFIG_BLOB_HEADER + CONFIG_BLOB_PAYLOAD)
+
+"""
+    code += """static void put_u32(uint8_t *b, uint32_t v) {
+    b[0] = (uint8_t)v;
+    b[1] = (uint8_t)(v >> 8);
+    b[2] = (uint8_t)(v >> 16);
+    b[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *b) {
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+           ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+/* CRC-32 (IEEE, reflected), bitwise: runs once per boot/save */
+static uint32_t blob_crc32(const uint8_t *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static bool blob_valid(const uint8_t *b, size_t len) {
+    return len == CONFIG_BLOB_SIZE &&
+           get_u32(&b[0]) == CONFIG_BLOB_MAGIC &&
+           get_u32(&b[4]) == CONFIG_BLOB_SCHEMA &&
+           get_u32(&b[8]) == blob_crc32(&b[CONFIG_BLOB_HEADER], CONFIG_BLOB_PAYLOAD);
+}
+
+static void blob_pack(uint8_t *b) {
+    uint8_t *d = &b[CONFIG_BLOB_HEADER];
+"""
+    if any(size == 2 and not is_string_type(p) for p, _, size in layout):
+        code += "    uint32_t v;\n"
+    code += "\n"
+    for p, off, size in layout:
+        path = "g_config." + get_config_path(p, families)
+        ptype = p['type']
+        if is_string_type(p):
+            code += f"    memcpy(&d[{off}], {path}, {size});\n"
+        elif ptype == 'bool':
+            code += f"    d[{off}] = atomic_load_explicit(&{path}, memory_order_relaxed) ? 1 : 0;\n"
+        elif size == 1:
+            code += f"    d[{off}] = atomic_load_explicit(&{path}, memory_order_relaxed);\n"
+        elif size == 2:
+            code += f"    v = atomic_load_explicit(&{path}, memory_order_relaxed);\n"
+            code += f"    d[{off}] = (uint8_t)v;\n"
+            code += f"    d[{off + 1}] = (uint8_t)(v >> 8);\n"
+        else:
+            code += f"    put_u32(&d[{off}], atomic_load_explicit(&{path}, memory_order_relaxed));\n"
+
+    code += """
+    put_u32(&b[0], CONFIG_BLOB_MAGIC);
+    put_u32(&b[4], CONFIG_BLOB_SCHEMA);
+    put_u32(&b[8], blob_crc32(d, CONFIG_BLOB_PAYLOAD));
+}
+
+static void blob_unpack(const uint8_t *b) {
+    const uint8_t *d = &b[CONFIG_BLOB_HEADER];
+
+"""
+    for p, off, size in layout:
+        path = "g_config." + get_config_path(p, families)
+        ptype = p['type']
+        if is_string_type(p):
+            code += f"    memcpy({path}, &d[{off}], {size});\n"
+            code += f"    {path}[{size - 1}] = '\\0';\n"
+        elif ptype == 'bool':
+            code += f"    atomic_store_explicit(&{path}, d[{off}] != 0, memory_order_relaxed);\n"
+        elif size == 1:
+            code += f"    atomic_store_explicit(&{path}, d[{off}], memory_order_relaxed);\n"
+        elif size == 2:
+            code += f"    atomic_store_explicit(&{path}, (uint16_t)(d[{off}] | (d[{off + 1}] << 8)), memory_order_relaxed);\n"
+        else:
+            code += f"    atomic_store_explicit(&{path}, get_u32(&d[{off}]), memory_order_relaxed);\n"
+
+    code += """}
+
+static esp_err_t blob_write(nvs_handle_t handle) {
+    uint8_t blob[CONFIG_BLOB_SIZE];
+    blob_pack(blob);
+    return nvs_set_blob(handle, CONFIG_NVS_BLOB_KEY, blob, sizeof(blob));
+}
+
+"""
+    return code
+
+
 def generate_config_nvs_c(params: List[Dict], families: List[Dict], output_dir: Path):
     """Generate config_nvs.c - NVS persistence implementation"""
 
-    src_dir = output_dir / "src"
+    src_dir = output_dir.parent / "src"
     src_dir.mkdir(parents=True, exist_ok=True)
 
     code = """/* Auto-generated from parameters.yaml - DO NOT EDIT MANUALLY */
@@ -611,16 +952,12 @@ def generate_config_nvs_c(params: List[Dict], families: List[Dict], output_dir:
 #include "nvs.h"
 #include <string.h>
 
-int config_load_from_nvs(void) {
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READONLY, &handle);
-    if (err == ESP_ERR_NVS_NOT_FOUND) {
-        return 0;  /* Namespace doesn't exist yet, use defaults */
-    }
-    if (err != ESP_OK) {
-        return -1;
-    }
+"""
 
+    code += generate_config_blob_c(params, families)
+
+    code += """/* Legacy / migration path: one lookup per key */
+static int load_per_key(nvs_handle_t handle) {
     int loaded = 0;
     uint8_t u8_val;
     uint16_t u16_val;
@@ -685,23 +1022,51 @@ int config_load_from_nvs(void) {
 
 """
 
-    code += """    nvs_close(handle);
-    return loaded;
+    code += """    return loaded;
 }
 
-int config_save_to_nvs(void) {
+int config_load_from_nvs(void) {
     nvs_handle_t handle;
-    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return 0;  /* Namespace doesn't exist yet, use defaults */
+    }
     if (err != ESP_OK) {
         return -1;
     }
 
-    int saved = 0;
+    /* Fast path: whole config in one read */
+    uint8_t blob[CONFIG_BLOB_SIZE];
+    size_t blob_len = sizeof(blob);
+    if (nvs_get_blob(handle, CONFIG_NVS_BLOB_KEY, blob, &blob_len) == ESP_OK &&
+        blob_valid(blob, blob_len)) {
+        nvs_close(handle);
+        blob_unpack(blob);
+        config_publish_rt_snapshot(&g_config);
+        return CONFIG_PARAM_COUNT;
+    }
+
+    /* Missing, corrupt or older schema: per-key load, then rewrite the blob */
+    int loaded = load_per_key(handle);
+    nvs_close(handle);
+    config_publish_rt_snapshot(&g_config);
+
+    if (loaded > 0 && nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        if (blob_write(handle) == ESP_OK) {
+            nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    return loaded;
+}
 
+/* Write one parameter (index = order in parameters.yaml) */
+static esp_err_t save_param(nvs_handle_t handle, unsigned idx) {
+    switch (idx) {
 """
 
     # Generate save code for each parameter
-    for p in params:
+    for idx, p in enumerate(params):
         family = p.get('family', '')
         ptype = p['type']
         pname = p['name']
@@ -714,50 +1079,90 @@ int config_save_to_nvs(void) {
             nvs_key = f"NVS_{pname.upper()}"
             config_path = f"g_config.{pname}"
 
+        code += f"        case {idx}:  /* {family}.{pname} */\n"
         if ptype == 'u8' or ptype == 'enum':
-            code += f"""    /* Save {family}.{pname} */
-    if (nvs_set_u8(handle, {nvs_key},
-            atomic_load_explicit(&{config_path}, memory_order_relaxed)) == ESP_OK) {{
-        saved++;
-    }}
-
-"""
+            code += f"            return nvs_set_u8(handle, {nvs_key},\n"
+            code += f"                    atomic_load_explicit(&{config_path}, memory_order_relaxed));\n"
         elif ptype == 'u16':
-            code += f"""    /* Save {family}.{pname} */
-    if (nvs_set_u16(handle, {nvs_key},
-            atomic_load_explicit(&{config_path}, memory_order_relaxed)) == ESP_OK) {{
-        saved++;
-    }}
-
-"""
+            code += f"            return nvs_set_u16(handle, {nvs_key},\n"
+            code += f"                    atomic_load_explicit(&{config_path}, memory_order_relaxed));\n"
         elif ptype == 'u32':
-            code += f"""    /* Save {family}.{pname} */
-    if (nvs_set_u32(handle, {nvs_key},
-            atomic_load_explicit(&{config_path}, memory_order_relaxed)) == ESP_OK) {{
-        saved++;
-    }}
-
-"""
+            code += f"            return nvs_set_u32(handle, {nvs_key},\n"
+            code += f"                    atomic_load_explicit(&{config_path}, memory_order_relaxed));\n"
         elif ptype == 'bool':
-            code += f"""    /* Save {family}.{pname} */
-    if (nvs_set_u8(handle, {nvs_key},
-            atomic_load_explicit(&{config_path}, memory_order_relaxed) ? 1 : 0) == ESP_OK) {{
-        saved++;
-    }}
-
-"""
+            code += f"            return nvs_set_u8(handle, {nvs_key},\n"
+            code += f"                    atomic_load_explicit(&{config_path}, memory_order_relaxed) ? 1 : 0);\n"
         elif ptype == 'string':
-            code += f"""    /* Save {family}.{pname} */
-    if (nvs_set_str(handle, {nvs_key}, {config_path}) == ESP_OK) {{
-        saved++;
-    }}
+            code += f"            return nvs_set_str(handle, {nvs_key}, {config_path});\n"
+        else:
+            code += "            return ESP_ERR_NOT_SUPPORTED;\n"
 
-"""
+    code += """        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+}
 
-    code += """    err = nvs_commit(handle);
+/* Write the parameters whose bits are set in bits[], commit once.
+ * Bits of keys that failed to write go back into g_config_dirty. */
+static int save_params(uint32_t bits[CONFIG_DIRTY_WORDS]) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        for (unsigned w = 0; w < CONFIG_DIRTY_WORDS; w++) {
+            atomic_fetch_or_explicit(&g_config_dirty[w], bits[w], memory_order_release);
+        }
+        return -1;
+    }
+
+    int saved = 0;
+    for (unsigned idx = 0; idx < CONFIG_PARAM_COUNT; idx++) {
+        uint32_t mask = 1U << (idx % 32U);
+        if ((bits[idx / 32U] & mask) == 0) {
+            continue;
+        }
+        if (save_param(handle, idx) == ESP_OK) {
+            saved++;
+        } else {
+            config_mark_dirty(idx);
+            bits[idx / 32U] &= ~mask;
+        }
+    }
+
+    /* Boot reads the blob alone: keep it in step with the keys */
+    err = blob_write(handle);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
     nvs_close(handle);
+    if (err != ESP_OK) {
+        for (unsigned w = 0; w < CONFIG_DIRTY_WORDS; w++) {
+            atomic_fetch_or_explicit(&g_config_dirty[w], bits[w], memory_order_release);
+        }
+        return -1;
+    }
+    return saved;
+}
+
+int config_save_to_nvs(void) {
+    uint32_t bits[CONFIG_DIRTY_WORDS];
+    for (unsigned w = 0; w < CONFIG_DIRTY_WORDS; w++) {
+        atomic_store_explicit(&g_config_dirty[w], 0, memory_order_relaxed);
+        bits[w] = 0xFFFFFFFFU;
+    }
+    if (CONFIG_PARAM_COUNT % 32U != 0) {
+        bits[CONFIG_DIRTY_WORDS - 1] = (1U << (CONFIG_PARAM_COUNT % 32U)) - 1U;
+    }
+    return save_params(bits);
+}
 
-    return (err == ESP_OK) ? saved : -1;
+int config_save_dirty_to_nvs(void) {
+    uint32_t bits[CONFIG_DIRTY_WORDS];
+    bool any = false;
+    for (unsigned w = 0; w < CONFIG_DIRTY_WORDS; w++) {
+        bits[w] = atomic_exchange_explicit(&g_config_dirty[w], 0, memory_order_acq_rel);
+        any = any || (bits[w] != 0);
+    }
+    return any ? save_params(bits) : 0;
 }
 
 """
@@ -766,6 +1171,295 @@ int config_save_to_nvs(void) {
         f.write(code)
 
 
+def generate_config_persist(output_dir: Path):
+    """Generate config_persist.h/.c - deferred NVS save worker (schema independent)"""
+
+    src_dir = output_dir.parent / "src"
+    src_dir.mkdir(parents=True, exist_ok=True)
+
+    header = r"""/* Auto-generated from parameters.yaml - DO NOT EDIT MANUALLY */
+/**
+ * @file config_persist.h
+ * @brief Deferred NVS persistence worker
+ *
+ * NVS writes disable the flash cache, stalling anything not in IRAM on
+ * both cores. Saves are therefore requested, not performed: a low
+ * priority task on Core 1 waits for the requests to settle (debounce)
+ * and for the keyer to go idle, then writes only the dirty parameters
+ * in one commit (config_save_dirty_to_nvs()).
+ *
+ * Other modules with NVS data of their own (text memories) register a
+ * store: the worker calls it on the same schedule, and it writes only
+ * what it has marked changed.
+ *
+ * NOT RT-safe (runs its own task); the request side is one atomic store.
+ */
+
+#ifndef KEYER_CONFIG_PERSIST_H
+#define KEYER_CONFIG_PERSIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Wait this long after the last request before saving */
+#define CONFIG_PERSIST_DEBOUNCE_MS   1000
+
+/** Keyer must have been idle this long */
+#define CONFIG_PERSIST_IDLE_MS       2000
+
+/** Save anyway once a request is this old (keyer never idle) */
+#define CONFIG_PERSIST_MAX_DEFER_MS  60000
+
+/** Worker poll period */
+#define CONFIG_PERSIST_POLL_MS       100
+
+/** Stores config_persist_add_store() takes */
+#define CONFIG_PERSIST_MAX_STORES    4
+
+/**
+ * @brief Idle probe: true while nothing is keying
+ */
+typedef bool (*config_persist_idle_fn)(void);
+
+/**
+ * @brief Store save: writes its changed entries, returns how many, -1 on error
+ *
+ * On error the store keeps its entries changed for the next request.
+ */
+typedef int (*config_persist_store_fn)(void);
+
+/**
+ * @brief Commit statistics
+ */
+typedef struct {
+    uint32_t saves;           /**< Commits performed */
+    uint32_t keys_written;    /**< Parameters and store entries written, all commits */
+    uint32_t failures;        /**< Commits that failed (keys stay dirty) */
+    uint32_t deferred_max;    /**< Saves forced by CONFIG_PERSIST_MAX_DEFER_MS */
+    uint32_t last_commit_us;  /**< Duration of the last commit */
+    uint32_t max_commit_us;   /**< Longest commit */
+    uint32_t last_keys;       /**< Parameters and store entries of the last commit */
+    bool pending;             /**< A request is waiting */
+    bool dirty;               /**< Parameters changed since the last save */
+} config_persist_stats_t;
+
+/**
+ * @brief Start the persistence task (Core 1, idle + 1 priority)
+ *
+ * @param is_idle Idle probe (NULL = always idle)
+ */
+void config_persist_start(config_persist_idle_fn is_idle);
+
+/**
+ * @brief Save a store with every commit
+ *
+ * Call before config_persist_start(). The store asks for a commit with
+ * config_persist_request() when it has changes.
+ *
+ * @return false if CONFIG_PERSIST_MAX_STORES are registered already
+ */
+bool config_persist_add_store(config_persist_store_fn save);
+
+/**
+ * @brief Ask for the dirty parameters to be saved
+ *
+ * Returns immediately; repeated requests within the debounce collapse
+ * into one commit.
+ */
+void config_persist_request(void);
+
+/**
+ * @brief Perform a pending request now (before a reboot)
+ *
+ * No-op when nothing was requested: unsaved changes are not persisted.
+ */
+void config_persist_flush(void);
+
+/**
+ * @brief Copy the commit statistics
+ */
+void config_persist_get_stats(config_persist_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYER_CONFIG_PERSIST_H */
+"""
+
+    source = r"""/* Auto-generated from parameters.yaml - DO NOT EDIT MANUALLY */
+/**
+ * @file config_persist.c
+ * @brief Deferred NVS persistence worker
+ */
+
+#include "config_persist.h"
+#include "config.h"
+#include "config_nvs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+
+static const char *TAG = "config_persist";
+
+static config_persist_idle_fn s_is_idle;
+
+/* Registered before the worker starts, read by it only */
+static config_persist_store_fn s_stores[CONFIG_PERSIST_MAX_STORES];
+static unsigned s_store_count;
+
+/* Request side (any task) */
+static atomic_bool s_requested;
+static atomic_uint s_last_request_ms;     /* Wraps; compared by difference */
+
+/* Statistics (written by the worker only) */
+static atomic_uint s_saves;
+static atomic_uint s_keys_written;
+static atomic_uint s_failures;
+static atomic_uint s_deferred_max;
+static atomic_uint s_last_commit_us;
+static atomic_uint s_max_commit_us;
+static atomic_uint s_last_keys;
+
+static void persist_commit(bool forced) {
+    int64_t t0 = esp_timer_get_time();
+    int saved = config_save_dirty_to_nvs();
+    bool failed = (saved < 0);
+    for (unsigned i = 0; i < s_store_count; i++) {
+        int n = s_stores[i]();
+        if (n < 0) {
+            failed = true;
+        } else if (saved >= 0) {
+            saved += n;
+        }
+    }
+    uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+
+    if (failed) {
+        /* Keys stay dirty; retry on the next request */
+        atomic_fetch_add_explicit(&s_failures, 1, memory_order_relaxed);
+        ESP_LOGW(TAG, "NVS commit failed after %lu us", (unsigned long)dt);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&s_saves, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_keys_written, (unsigned)saved, memory_order_relaxed);
+    atomic_store_explicit(&s_last_keys, (unsigned)saved, memory_order_relaxed);
+    atomic_store_explicit(&s_last_commit_us, dt, memory_order_relaxed);
+    if (dt > atomic_load_explicit(&s_max_commit_us, memory_order_relaxed)) {
+        atomic_store_explicit(&s_max_commit_us, dt, memory_order_relaxed);
+    }
+    if (forced) {
+        atomic_fetch_add_explicit(&s_deferred_max, 1, memory_order_relaxed);
+    }
+    ESP_LOGI(TAG, "Saved %d entries in %lu us%s", saved, (unsigned long)dt,
+             forced ? " (keyer busy, forced)" : "");
+}
+
+static void persist_task(void *arg) {
+    (void)arg;
+    int64_t idle_since_us = esp_timer_get_time();
+    int64_t pending_since_us = 0;   /* First poll that saw the request, 0 = none */
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_PERSIST_POLL_MS));
+        int64_t now_us = esp_timer_get_time();
+
+        if (s_is_idle != NULL && !s_is_idle()) {
+            idle_since_us = now_us;
+        }
+
+        if (!atomic_load_explicit(&s_requested, memory_order_acquire)) {
+            pending_since_us = 0;
+            continue;
+        }
+        if (pending_since_us == 0) {
+            pending_since_us = now_us;
+        }
+
+        uint32_t now_ms = (uint32_t)(now_us / 1000);
+        uint32_t last_ms = atomic_load_explicit(&s_last_request_ms, memory_order_relaxed);
+        if (now_ms - last_ms < CONFIG_PERSIST_DEBOUNCE_MS) {
+            continue;
+        }
+
+        bool idle = (now_us - idle_since_us) >= (int64_t)CONFIG_PERSIST_IDLE_MS * 1000;
+        bool overdue = (now_us - pending_since_us) >= (int64_t)CONFIG_PERSIST_MAX_DEFER_MS * 1000;
+        if (!idle && !overdue) {
+            continue;
+        }
+
+        /* Clear before writing: a request during the commit schedules another */
+        atomic_store_explicit(&s_requested, false, memory_order_release);
+        pending_since_us = 0;
+        persist_commit(!idle);
+    }
+}
+
+/* Static, internal RAM: the task writes flash. 4096: the save path packs
+ * the config blob on the stack */
+static StackType_t s_persist_stack[4096];
+static StaticTask_t s_persist_tcb;
+
+void config_persist_start(config_persist_idle_fn is_idle) {
+    s_is_idle = is_idle;
+    xTaskCreateStaticPinnedToCore(
+        persist_task,
+        "cfg_persist",
+        sizeof(s_persist_stack),
+        NULL,
+        tskIDLE_PRIORITY + 1,
+        s_persist_stack,
+        &s_persist_tcb,
+        1  /* Core 1 */
+    );
+}
+
+bool config_persist_add_store(config_persist_store_fn save) {
+    if (save == NULL || s_store_count >= CONFIG_PERSIST_MAX_STORES) {
+        return false;
+    }
+    s_stores[s_store_count++] = save;
+    return true;
+}
+
+void config_persist_request(void) {
+    atomic_store_explicit(&s_last_request_ms, (uint32_t)(esp_timer_get_time() / 1000),
+                          memory_order_relaxed);
+    atomic_store_explicit(&s_requested, true, memory_order_release);
+}
+
+void config_persist_flush(void) {
+    if (atomic_exchange_explicit(&s_requested, false, memory_order_acq_rel)) {
+        persist_commit(false);
+    }
+}
+
+void config_persist_get_stats(config_persist_stats_t *out) {
+    out->saves = atomic_load_explicit(&s_saves, memory_order_relaxed);
+    out->keys_written = atomic_load_explicit(&s_keys_written, memory_order_relaxed);
+    out->failures = atomic_load_explicit(&s_failures, memory_order_relaxed);
+    out->deferred_max = atomic_load_explicit(&s_deferred_max, memory_order_relaxed);
+    out->last_commit_us = atomic_load_explicit(&s_last_commit_us, memory_order_relaxed);
+    out->max_commit_us = atomic_load_explicit(&s_max_commit_us, memory_order_relaxed);
+    out->last_keys = atomic_load_explicit(&s_last_keys, memory_order_relaxed);
+    out->pending = atomic_load_explicit(&s_requested, memory_order_relaxed);
+    out->dirty = config_any_dirty();
+}
+"""
+
+    with open(output_dir / "config_persist.h", "w") as f:
+        f.write(header)
+    with open(src_dir / "config_persist.c", "w") as f:
+        f.write(source)
+
+
 def generate_config_console_h(params: List[Dict], families: List[Dict], output_dir: Path):
     """Generate config_console.h with family metadata for v2"""
 
@@ -831,7 +1525,7 @@ typedef struct {
     uint32_t min;
     uint32_t max;
     param_value_t (*get_fn)(void);
-    void (*set_fn)(param_value_t);
+    void (*set_fn)(param_value_t);  /**< Stores and marks dirty: caller bumps generation */
 } param_descriptor_t;
 
 """
@@ -850,15 +1544,57 @@ typedef struct {
 /** Find family by name or alias */
 const family_descriptor_t *config_find_family(const char *name);
 
-/** Find parameter by name or full path */
+/**
+ * @brief Find parameter by full path, family alias path or bare name
+ *
+ * "keyer.wpm", "k.wpm" and "wpm" all resolve through a minimal perfect
+ * hash generated with the tables: two hashes and one strcmp.
+ */
 const param_descriptor_t *config_find_param(const char *name);
 
+/**
+ * @brief FNV-1a over a NUL-terminated name, seed folded into the basis
+ *
+ * The hash the generated lookup tables were built with; also usable for
+ * other name tables.
+ */
+uint32_t config_name_hash(const char *s, uint32_t seed);
+
 /** Get parameter value as string */
 int config_get_param_str(const char *name, char *buf, size_t len);
 
+/** Format a parameter's value, no lookup (e.g. from a visitor) */
+int config_format_param(const param_descriptor_t *p, char *buf, size_t len);
+
 /** Set parameter from string */
 int config_set_param_str(const char *name, const char *value);
 
+/** Most parameters accepted by one config_set_params_batch() call */
+#define CONFIG_BATCH_MAX 32
+
+/**
+ * @brief Validate a string value for a parameter
+ * @return 0 on success, -2 out of range, -3 invalid boolean
+ */
+int config_parse_param_value(const param_descriptor_t *p, const char *value,
+                             param_value_t *out);
+
+/**
+ * @brief Set several parameters under one generation bump
+ *
+ * All values are validated first; nothing is applied unless every one
+ * is valid, so a profile lands on the RT side as a single change.
+ *
+ * @param names Parameter names or full paths
+ * @param values String values, same order
+ * @param count Entries (<= CONFIG_BATCH_MAX)
+ * @param bad_index Index of the rejected entry on error (may be NULL)
+ * @return 0 on success, -1 unknown parameter, -2/-3 as config_parse_param_value,
+ *         -5 too many entries
+ */
+int config_set_params_batch(const char *const *names, const char *const *values,
+                            size_t count, size_t *bad_index);
+
 /** Pattern matching visitor callback */
 typedef void (*param_visitor_fn)(const param_descriptor_t *param, void *ctx);
 
@@ -884,6 +1620,91 @@ void config_foreach_matching(const char *pattern, param_visitor_fn visitor, void
         f.write(code)
 
 
+
+# ----------------------------------------------------------------------------
+# Minimal perfect hash for name lookups (config_console.c)
+#
+# Hash-and-displace: keys fall into buckets by hash(key, 0); each bucket gets
+# the first seed that moves all its keys to free slots with hash(key, seed).
+# The table has exactly one slot per key, so a lookup is two hashes and one
+# strcmp. config_name_hash() in the generated C must match name_hash().
+# ----------------------------------------------------------------------------
+
+HASH_KEYS_PER_BUCKET = 4
+HASH_MAX_SEED = 0xFFFF
+
+
+def name_hash(key: str, seed: int) -> int:
+    """FNV-1a, 32 bit, with the seed folded into the offset basis."""
+    h = (2166136261 ^ seed) & 0xFFFFFFFF
+    for b in key.encode():
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def build_perfect_hash(keys: List[str]) -> tuple:
+    """Return (seeds per bucket, keys in slot order) for distinct keys."""
+    n = len(keys)
+    nbuckets = max(1, (n + HASH_KEYS_PER_BUCKET - 1) // HASH_KEYS_PER_BUCKET)
+    buckets = [[] for _ in range(nbuckets)]
+    for k in keys:
+        buckets[name_hash(k, 0) % nbuckets].append(k)
+
+    seeds = [0] * nbuckets
+    slots = [None] * n
+    for b in sorted(range(nbuckets), key=lambda i: -len(buckets[i])):
+        if not buckets[b]:
+            continue
+        for seed in range(1, HASH_MAX_SEED + 1):
+            pos = [name_hash(k, seed) % n for k in buckets[b]]
+            if len(set(pos)) == len(pos) and all(slots[i] is None for i in pos):
+                for k, i in zip(buckets[b], pos):
+                    slots[i] = k
+                seeds[b] = seed
+                break
+        else:
+            raise RuntimeError(f"no perfect hash seed for bucket {buckets[b]}")
+    return seeds, slots
+
+
+def param_lookup_keys(params: List[Dict], families) -> Dict[str, int]:
+    """Every name config_find_param() accepts, mapped to a CONSOLE_PARAMS index.
+
+    Full paths ("keyer.wpm"), paths under a family alias ("k.wpm") and bare
+    names ("wpm"); a bare name shared by several families resolves to the
+    first parameter that has it, as the linear scan used to.
+    """
+    aliases = {f['name']: f.get('aliases', []) for f in (families or [])}
+    keys = {}
+    for idx, p in enumerate(params):
+        family = p.get('family', '')
+        full_path = f"{family}.{p['name']}" if family else p['name']
+        keys.setdefault(full_path, idx)
+        for alias in aliases.get(family, []):
+            keys.setdefault(f"{alias}.{p['name']}", idx)
+    for idx, p in enumerate(params):
+        keys.setdefault(p['name'], idx)
+    return keys
+
+
+def emit_hash_table(prefix: str, keymap: Dict[str, int]) -> str:
+    """C tables for one perfect hash: <prefix>_SEEDS[] and <prefix>_SLOTS[]."""
+    seeds, slots = build_perfect_hash(list(keymap))
+    index_type = "uint8_t" if max(keymap.values()) < 256 else "uint16_t"
+    code = f"#define {prefix}_BUCKETS {len(seeds)}\n"
+    code += f"#define {prefix}_KEYS {len(slots)}\n\n"
+    code += f"static const uint16_t {prefix}_SEEDS[{prefix}_BUCKETS] = {{\n"
+    for i in range(0, len(seeds), 12):
+        code += "    " + ", ".join(str(v) for v in seeds[i:i + 12]) + ",\n"
+    code += "};\n\n"
+    code += f"static const struct {{ const char *key; {index_type} index; }} {prefix}_SLOTS[{prefix}_KEYS] = {{\n"
+    for k in slots:
+        code += f'    {{ "{k}", {keymap[k]} }},\n'
+    code += "};\n\n"
+    return code
+
+
 def generate_config_console_c(params: List[Dict], families: List[Dict], output_dir: Path):
     """Generate config_console.c - Console parameter registry implementation"""
 
@@ -922,7 +1743,7 @@ def generate_config_console_c(params: List[Dict], families: List[Dict], output_d
     code += " * Parameter Accessors\n"
     code += " * ============================================================================ */\n\n"
 
-    for p in params:
+    for idx, p in enumerate(params):
         pname = p['name']
         family = p.get('family', '')
         ptype = p['type']
@@ -973,7 +1794,7 @@ def generate_config_console_c(params: List[Dict], families: List[Dict], output_d
         elif ptype == 'u32':
             code += f"    atomic_store_explicit(&{config_path}, v.u32, memory_order_relaxed);\n"
 
-        code += "    config_bump_generation(&g_config);\n"
+        code += f"    config_mark_dirty({idx});\n"
         code += "}\n\n"
 
     # Generate CONSOLE_PARAMS array
@@ -1027,33 +1848,40 @@ def generate_config_console_c(params: List[Dict], families: List[Dict], output_d
 
     code += "};\n\n"
 
+    # Perfect hashes over every accepted parameter and family name
+    code += "/* ============================================================================\n"
+    code += " * Name Lookup (minimal perfect hash, see config_name_hash)\n"
+    code += " * ============================================================================ */\n\n"
+    code += emit_hash_table("PARAM_HASH", param_lookup_keys(params, families))
+    family_keys = {}
+    for idx, f in enumerate(families or []):
+        family_keys.setdefault(f['name'], idx)
+        for alias in f.get('aliases', []):
+            family_keys.setdefault(alias, idx)
+    if family_keys:
+        code += emit_hash_table("FAMILY_HASH", family_keys)
+
     # Generate helper functions
     code += """/* ============================================================================
  * Helper Functions
  * ============================================================================ */
 
+uint32_t config_name_hash(const char *s, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    while (*s != '\\0') {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
 const family_descriptor_t *config_find_family(const char *name) {
     if (name == NULL) return NULL;
 
-    for (int i = 0; i < FAMILY_COUNT; i++) {
-        const family_descriptor_t *f = &CONSOLE_FAMILIES[i];
-        /* Check exact name match */
-        if (strcmp(f->name, name) == 0) {
-            return f;
-        }
-        /* Check aliases */
-        if (f->aliases && f->aliases[0] != '\\0') {
-            char aliases_copy[64];
-            strncpy(aliases_copy, f->aliases, sizeof(aliases_copy) - 1);
-            aliases_copy[sizeof(aliases_copy) - 1] = '\\0';
-            char *alias = strtok(aliases_copy, ",");
-            while (alias) {
-                if (strcmp(alias, name) == 0) {
-                    return f;
-                }
-                alias = strtok(NULL, ",");
-            }
-        }
+    uint32_t bucket = config_name_hash(name, 0) % FAMILY_HASH_BUCKETS;
+    uint32_t slot = config_name_hash(name, FAMILY_HASH_SEEDS[bucket]) % FAMILY_HASH_KEYS;
+    if (strcmp(FAMILY_HASH_SLOTS[slot].key, name) == 0) {
+        return &CONSOLE_FAMILIES[FAMILY_HASH_SLOTS[slot].index];
     }
     return NULL;
 }
@@ -1061,22 +1889,19 @@ const family_descriptor_t *config_find_family(const char *name) {
 const param_descriptor_t *config_find_param(const char *name) {
     if (name == NULL) return NULL;
 
-    for (int i = 0; i < CONSOLE_PARAM_COUNT; i++) {
-        const param_descriptor_t *p = &CONSOLE_PARAMS[i];
-        /* Check full path (e.g., "keyer.wpm") */
-        if (strcmp(p->full_path, name) == 0) {
-            return p;
-        }
-        /* Check short name (e.g., "wpm") */
-        if (strcmp(p->name, name) == 0) {
-            return p;
-        }
+    uint32_t bucket = config_name_hash(name, 0) % PARAM_HASH_BUCKETS;
+    uint32_t slot = config_name_hash(name, PARAM_HASH_SEEDS[bucket]) % PARAM_HASH_KEYS;
+    if (strcmp(PARAM_HASH_SLOTS[slot].key, name) == 0) {
+        return &CONSOLE_PARAMS[PARAM_HASH_SLOTS[slot].index];
     }
     return NULL;
 }
 
 int config_get_param_str(const char *name, char *buf, size_t len) {
-    const param_descriptor_t *p = config_find_param(name);
+    return config_format_param(config_find_param(name), buf, len);
+}
+
+int config_format_param(const param_descriptor_t *p, char *buf, size_t len) {
     if (p == NULL || buf == NULL || len == 0) {
         return -1;
     }
@@ -1106,9 +1931,9 @@ int config_get_param_str(const char *name, char *buf, size_t len) {
     return 0;
 }
 
-int config_set_param_str(const char *name, const char *value) {
-    const param_descriptor_t *p = config_find_param(name);
-    if (p == NULL || value == NULL) {
+int config_parse_param_value(const param_descriptor_t *p, const char *value,
+                             param_value_t *out) {
+    if (p == NULL || value == NULL || out == NULL) {
         return -1;
     }
 
@@ -1156,7 +1981,55 @@ int config_set_param_str(const char *name, const char *value) {
             return -1;
     }
 
+    *out = v;
+    return 0;
+}
+
+int config_set_param_str(const char *name, const char *value) {
+    const param_descriptor_t *p = config_find_param(name);
+    if (p == NULL || value == NULL) {
+        return -1;
+    }
+
+    param_value_t v;
+    int ret = config_parse_param_value(p, value, &v);
+    if (ret != 0) {
+        return ret;
+    }
+
     p->set_fn(v);
+    config_bump_generation(&g_config);
+    return 0;
+}
+
+int config_set_params_batch(const char *const *names, const char *const *values,
+                            size_t count, size_t *bad_index) {
+    if (count > CONFIG_BATCH_MAX) {
+        return -5;
+    }
+
+    const param_descriptor_t *descs[CONFIG_BATCH_MAX];
+    param_value_t parsed[CONFIG_BATCH_MAX];
+
+    /* Validate everything before touching g_config */
+    for (size_t i = 0; i < count; i++) {
+        const param_descriptor_t *p = config_find_param(names[i]);
+        int ret = (p == NULL) ? -1 : config_parse_param_value(p, values[i], &parsed[i]);
+        if (ret != 0) {
+            if (bad_index != NULL) {
+                *bad_index = i;
+            }
+            return ret;
+        }
+        descs[i] = p;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        descs[i]->set_fn(parsed[i]);
+    }
+    if (count > 0) {
+        config_bump_generation(&g_config);
+    }
     return 0;
 }
 
@@ -1190,6 +2063,15 @@ void config_foreach_matching(const char *pattern, param_visitor_fn visitor, void
         prefix_len--;
     }
 
+    /* Family alias ("hw.*" is "hardware.*") */
+    if (prefix_len > 0 && strchr(prefix, '.') == NULL) {
+        const family_descriptor_t *f = config_find_family(prefix);
+        if (f != NULL && strlen(f->name) < sizeof(prefix)) {
+            strcpy(prefix, f->name);
+            prefix_len = strlen(prefix);
+        }
+    }
+
     /* Check if double-star (recursive) */
     bool recursive = (star[1] == '*');
 
@@ -116,6 +116,9 @@ def main():
     common_tags = {"wifi", "esp_netif", "esp_tls", "mqtt", "http_client"}
     tags.update(common_tags)
 
+    # Log stream names: usb_log filter tags and binary log tag IDs
+    tags.update({"RT", "BG"})
+
     generate_header(tags, output_path)
 
 
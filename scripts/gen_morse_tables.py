@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""
+Morse Table Generator
+
+Reads the Morse alphabet (components/keyer_decoder/morse_alphabet.yaml) and
+generates morse_tables.h: const direct-mapped tables for decode
+(morse_code_t -> char), encode (char -> morse_code_t and pattern string)
+and the prosign tags. morse_table.c is the only includer; keyer_decoder
+and keyer_text use the tables through morse_table.h.
+
+Usage:
+    python3 scripts/gen_morse_tables.py <morse_alphabet.yaml> <output.h>
+
+Example:
+    python3 scripts/gen_morse_tables.py components/keyer_decoder/morse_alphabet.yaml build/morse_tables.h
+"""
+
+import sys
+from pathlib import Path
+
+import yaml
+
+MAX_ELEMENTS = 8  # Must match MORSE_MAX_ELEMENTS in morse_table.h
+
+
+def pattern_code(pattern: str) -> int:
+    """Start bit, then one bit per element (dit 0, dah 1), first element highest"""
+    code = 1
+    for e in pattern:
+        code = (code << 1) | (1 if e == '-' else 0)
+    return code
+
+
+def c_char(ch: str) -> str:
+    if ch in ("'", "\\"):
+        return f"'\\{ch}'"
+    return f"'{ch}'"
+
+
+def c_string(s: str) -> str:
+    return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def fail(msg: str) -> None:
+    print(f"gen_morse_tables: error: {msg}", file=sys.stderr)
+    sys.exit(1)
+
+
+def load(path: Path) -> tuple:
+    data = yaml.safe_load(path.read_text())
+    chars = data.get('characters', [])
+    prosigns = data.get('prosigns', [])
+
+    seen_chars = {}
+    seen_codes = {}
+    for entry in chars:
+        ch = str(entry['char'])
+        pattern = str(entry['pattern'])
+        if len(ch) != 1 or not (0x20 < ord(ch) < 0x7F):
+            fail(f"character {ch!r} must be one printable ASCII char")
+        if ch.islower():
+            fail(f"character {ch!r}: list uppercase, lowercase is folded")
+        if not pattern or set(pattern) - {'.', '-'} or len(pattern) > MAX_ELEMENTS:
+            fail(f"{ch!r}: pattern {pattern!r} must be 1-{MAX_ELEMENTS} of '.' and '-'")
+        code = pattern_code(pattern)
+        if ch in seen_chars:
+            fail(f"character {ch!r} listed twice")
+        if code in seen_codes:
+            fail(f"pattern {pattern!r} used by {seen_codes[code]!r} and {ch!r}")
+        seen_chars[ch] = code
+        seen_codes[code] = ch
+
+    for entry in prosigns:
+        tag = str(entry['tag'])
+        pattern = str(entry['pattern'])
+        if not (tag.startswith('<') and tag.endswith('>')):
+            fail(f"prosign tag {tag!r} must look like <XX>")
+        if not pattern or set(pattern) - {'.', '-'} or len(pattern) > MAX_ELEMENTS:
+            fail(f"{tag}: pattern {pattern!r} must be 1-{MAX_ELEMENTS} of '.' and '-'")
+
+    return chars, prosigns
+
+
+def generate(chars: list, prosigns: list, source: str) -> str:
+    out = []
+    out.append(f"""/**
+ * @file morse_tables.h
+ * @brief Morse encode/decode tables (GENERATED - DO NOT EDIT)
+ *
+ * Generated by scripts/gen_morse_tables.py from {source}.
+ * Included by morse_table.c only; use morse_table.h.
+ */
+
+#ifndef KEYER_MORSE_TABLES_H
+#define KEYER_MORSE_TABLES_H
+
+#include "morse_table.h"
+
+/** Characters in the alphabet */
+#define MORSE_ALPHABET_SIZE {len(chars)}U
+
+/** Prosign tags */
+#define MORSE_PROSIGN_COUNT {len(prosigns)}U
+
+_Static_assert(MORSE_MAX_ELEMENTS == {MAX_ELEMENTS}, "regenerate morse_tables.h");
+
+typedef struct {{
+    const char *tag;      /**< e.g. "<SK>" */
+    const char *pattern;  /**< e.g. "...-.-" */
+    morse_code_t code;    /**< Same pattern as a code */
+}} morse_prosign_t;
+""")
+
+    out.append("/** Code -> character ('\\0' = no character) */")
+    out.append("static const char MORSE_DECODE[MORSE_CODE_LIMIT] = {")
+    for entry in sorted(chars, key=lambda e: pattern_code(str(e['pattern']))):
+        p = str(entry['pattern'])
+        out.append(f"    [0x{pattern_code(p):03x}] = {c_char(str(entry['char']))},  /* {p} */")
+    out.append("};\n")
+
+    # Lowercase letters fold onto uppercase at generation time
+    by_ascii = {}
+    for entry in chars:
+        ch = str(entry['char'])
+        by_ascii[ch] = str(entry['pattern'])
+        if ch.isalpha():
+            by_ascii[ch.lower()] = str(entry['pattern'])
+
+    out.append("/** ASCII -> code (MORSE_CODE_INVALID = not sendable) */")
+    out.append("static const morse_code_t MORSE_ENCODE[128] = {")
+    for ch in sorted(by_ascii):
+        out.append(f"    [{c_char(ch)}] = 0x{pattern_code(by_ascii[ch]):03x},")
+    out.append("};\n")
+
+    out.append("/** ASCII -> pattern string (NULL = not sendable) */")
+    out.append("static const char *const MORSE_PATTERN[128] = {")
+    for ch in sorted(by_ascii):
+        out.append(f"    [{c_char(ch)}] = {c_string(by_ascii[ch])},")
+    out.append("};\n")
+
+    out.append("/** Prosign tags (text keyer input, decoder display) */")
+    out.append("static const morse_prosign_t MORSE_PROSIGNS[MORSE_PROSIGN_COUNT] = {")
+    for entry in prosigns:
+        p = str(entry['pattern'])
+        note = f"  /* {entry['note']} */" if entry.get('note') else ""
+        out.append(f"    {{ {c_string(str(entry['tag']))}, {c_string(p)}, 0x{pattern_code(p):03x} }},{note}")
+    out.append("};\n")
+
+    out.append("#endif /* KEYER_MORSE_TABLES_H */")
+    return "\n".join(out) + "\n"
+
+
+def main() -> int:
+    if len(sys.argv) != 3:
+        print(__doc__, file=sys.stderr)
+        return 1
+
+    src = Path(sys.argv[1])
+    dst = Path(sys.argv[2])
+    chars, prosigns = load(src)
+    text = generate(chars, prosigns, src.name)
+
+    dst.parent.mkdir(parents=True, exist_ok=True)
+    if not dst.exists() or dst.read_text() != text:
+        dst.write_text(text)
+    print(f"Generated {dst} ({len(chars)} characters, {len(prosigns)} prosigns)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
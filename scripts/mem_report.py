@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+Report static RAM use per component from the linker map file.
+
+Sums the input sections the linker placed in each RAM output section by
+the archive they came from (libkeyer_core.a -> keyer_core), so a buffer
+that grows or lands in internal DRAM instead of PSRAM shows up next to
+its component. Runtime heap use is on the console ("stats heap").
+
+Usage:
+    mem_report.py [--top N] [--objects COMPONENT] [--max-dram BYTES] <app.map>
+
+Columns are bytes: DRAM .data and .bss (internal), IRAM (code and data
+placed in internal RAM), PSRAM .bss (EXT_RAM_BSS_ATTR). --max-dram fails
+when the internal DRAM total is over the budget.
+"""
+
+import argparse
+import re
+import sys
+from collections import defaultdict
+
+# Output sections -> report column (ESP32-S3 linker script names)
+COLUMNS = [
+    ("dram.data", re.compile(r"^\.dram0\.data$")),
+    ("dram.bss", re.compile(r"^\.dram0\.(bss|noinit)$")),
+    ("iram", re.compile(r"^\.iram0\.(text|data|bss|vectors)$")),
+    ("psram.bss", re.compile(r"^\.ext_ram\.(bss|noinit)$")),
+]
+INTERNAL = ("dram.data", "dram.bss")
+
+OUTPUT_RE = re.compile(r"^(\.\S+)\s+0x[0-9a-f]+\s+0x[0-9a-f]+")
+OUTPUT_NAME_RE = re.compile(r"^(\.\S+)\s*$")
+INPUT_RE = re.compile(r"^ (\S+)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+ARCHIVE_RE = re.compile(r"lib([^/()]+)\.a\(([^)]+)\)$")
+
+
+def column_of(section: str):
+    for name, rx in COLUMNS:
+        if rx.match(section):
+            return name
+    return None
+
+
+def owner(path: str):
+    """(component, object) of an input file"""
+    m = ARCHIVE_RE.search(path)
+    if m:
+        return m.group(1), m.group(2)
+    base = path.rsplit("/", 1)[-1]
+    return base, base
+
+
+def parse_map(text: str):
+    """Return {component: {column: bytes}} and {component: {(column, symbol, obj): bytes}}"""
+    totals = defaultdict(lambda: defaultdict(int))
+    objects = defaultdict(lambda: defaultdict(int))
+
+    in_memory_map = False
+    column = None
+    pending = None          # Input section name on a line of its own
+
+    for line in text.splitlines():
+        if not in_memory_map:
+            in_memory_map = line.startswith("Linker script and memory map")
+            continue
+
+        m = OUTPUT_RE.match(line) or OUTPUT_NAME_RE.match(line)
+        if m:
+            column = column_of(m.group(1))
+            pending = None
+            continue
+        if column is None:
+            continue
+
+        if line.startswith(" .") and len(line.split()) == 1:
+            pending = line.strip()
+            continue
+        m = INPUT_RE.match(line)
+        if not m:
+            pending = None
+            continue
+        section = m.group(1) or pending
+        pending = None
+        size = int(m.group(3), 16)
+        if section is None or size == 0 or section.startswith("*"):
+            continue
+        comp, obj = owner(m.group(4).strip())
+        totals[comp][column] += size
+        symbol = section.rsplit(".", 1)[-1] if section.count(".") > 1 else section
+        objects[comp][(column, symbol, obj)] += size
+
+    return totals, objects
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--top", type=int, default=0, help="Show only the N largest components")
+    ap.add_argument("--objects", metavar="COMPONENT",
+                    help="List the largest sections of one component")
+    ap.add_argument("--max-dram", type=int, default=0, metavar="BYTES",
+                    help="Fail if static internal DRAM exceeds this")
+    ap.add_argument("map")
+    args = ap.parse_args()
+
+    with open(args.map, encoding="utf-8", errors="replace") as f:
+        totals, objects = parse_map(f.read())
+    if not totals:
+        print(f"mem_report: no RAM sections found in {args.map}", file=sys.stderr)
+        return 1
+
+    names = [c for c, _ in COLUMNS]
+    rows = sorted(totals.items(), key=lambda kv: -sum(kv[1][c] for c in INTERNAL))
+    shown = rows[:args.top] if args.top > 0 else rows
+
+    width = max(len("component"), max(len(c) for c, _ in shown))
+    print(f"{'component':<{width}} " + " ".join(f"{n:>10}" for n in names) + f" {'internal':>10}")
+    for comp, cols in shown:
+        internal = sum(cols[c] for c in INTERNAL)
+        print(f"{comp:<{width}} " + " ".join(f"{cols[n]:>10}" for n in names)
+              + f" {internal:>10}")
+    sums = {n: sum(cols[n] for _, cols in rows) for n in names}
+    dram = sum(sums[c] for c in INTERNAL)
+    print(f"{'total':<{width}} " + " ".join(f"{sums[n]:>10}" for n in names) + f" {dram:>10}")
+
+    if args.objects:
+        items = sorted(objects.get(args.objects, {}).items(), key=lambda kv: -kv[1])
+        if not items:
+            print(f"mem_report: no sections for component '{args.objects}'", file=sys.stderr)
+            return 1
+        print(f"\n{args.objects}:")
+        for (column, symbol, obj), size in items:
+            print(f"  {size:>8}  {column:<10} {symbol} ({obj})")
+
+    if args.max_dram and dram > args.max_dram:
+        print(f"mem_report: error: static internal DRAM {dram} bytes over budget "
+              f"{args.max_dram}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,841 @@
+/**
+ * @file bench_host.c
+ * @brief Host microbenchmarks for keyer_core, keyer_iambic, keyer_audio, keyer_cwnet,
+ *        keyer_decoder and the WireGuard crypto
+ *
+ * Measures ns/op of the hot-path kernels and prints stable JSON:
+ *   { "schema": 1, "kernels": [ {"name": ..., "ns_per_op": ..., "ops": ...}, ... ] }
+ *
+ * Each kernel runs BENCH_REPS times and reports the fastest run, which is
+ * the least noisy figure on a shared host.
+ *
+ * Usage:
+ *   bench_host                         Print results
+ *   bench_host --baseline FILE [--tolerance PCT]
+ *                                      Also fail (exit 1) if any kernel is more
+ *                                      than PCT percent (default 50) slower than
+ *                                      FILE, which is a previous bench_host output
+ *
+ * Refresh the stored baseline with: bench_host > bench/baseline.json
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stream.h"
+#include "consumer.h"
+#include "fault.h"
+#include "iambic.h"
+#include "iambic_preset.h"
+#include "sidetone.h"
+#include "audio_buffer.h"
+#include "cwnet_frame.h"
+#include "timing_classifier.h"
+#include "crypto/refc/chacha20poly1305.h"
+#include "crypto/xtensa/chacha20poly1305_xtensa.h"
+#include "crypto/refc/x25519.h"
+#include "crypto/refc/blake2s.h"
+#include "crypto/xtensa/blake2s_xtensa.h"
+#include "crypto/xtensa/x25519_xtensa.h"
+#include "nacl/crypto_scalarmult/curve25519/ref/crypto_scalarmult.h"
+
+#define BENCH_REPS          5
+#define BENCH_STREAM_CAP    4096
+#define BENCH_HOT_CAP       256
+#define BENCH_ARCHIVED      (BENCH_STREAM_CAP - BENCH_HOT_CAP)  /* Archive-only samples */
+#define BENCH_MAX_KERNELS   48
+#define BENCH_NAME_MAX      40
+
+/* ============================================================================
+ * Result Table
+ * ============================================================================ */
+
+typedef struct {
+    char name[BENCH_NAME_MAX];
+    double ns_per_op;
+    uint32_t ops;
+} bench_result_t;
+
+static bench_result_t s_results[BENCH_MAX_KERNELS];
+static size_t s_result_count;
+
+/* Sink so the compiler cannot drop kernel results */
+static volatile uint32_t s_sink;
+
+static stream_slot_t s_stream_buf[BENCH_STREAM_CAP];
+static stream_slot_t s_hot_buf[BENCH_HOT_CAP];
+static stream_archive_t s_archive;
+static uint32_t s_archive_words[BENCH_STREAM_CAP / 2];
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void record(const char *name, int64_t best_ns, uint32_t ops) {
+    if (s_result_count >= BENCH_MAX_KERNELS) {
+        return;
+    }
+    bench_result_t *r = &s_results[s_result_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->ns_per_op = (double)best_ns / (double)ops;
+    r->ops = ops;
+}
+
+/* ============================================================================
+ * Kernels (each returns elapsed ns for `ops` operations)
+ * ============================================================================ */
+
+/* changing: key toggles every push; channels: the extra input and remote
+ * channel bits toggle with it */
+static int64_t run_stream_push(uint32_t ops, bool changing, bool channels) {
+    keying_stream_t stream;
+    stream_init(&stream, s_stream_buf, BENCH_STREAM_CAP);
+
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    uint32_t acc = 0;
+
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < ops; i++) {
+        if (changing) {
+            sample.local_key = (uint8_t)(i & 1U);
+        }
+        if (channels) {
+            sample.gpio.bits = (i & 1U) ? (GPIO_STRAIGHT_BIT | SAMPLE_CH_REMOTE) : GPIO_DIT2_BIT;
+        }
+        acc += stream_push(&stream, sample) ? 1U : 0U;
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = acc;
+    return t1 - t0;
+}
+
+/* Fill the whole ring with changing samples (untimed) */
+static void fill_stream(keying_stream_t *stream) {
+    stream_init(stream, s_stream_buf, BENCH_STREAM_CAP);
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    for (uint32_t i = 0; i < BENCH_STREAM_CAP; i++) {
+        sample.local_key = (uint8_t)(i & 1U);
+        stream_push_raw(stream, sample);
+    }
+}
+
+static int64_t run_consumer_next(uint32_t ops) {
+    keying_stream_t stream;
+    stream_consumer_t consumer;
+    stream_sample_t out;
+    uint32_t acc = 0;
+    int64_t total = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_STREAM_CAP) {
+        fill_stream(&stream);
+        consumer_init_at(&consumer, &stream, 0);
+
+        int64_t t0 = now_ns();
+        while (consumer_next(&consumer, &out)) {
+            acc += out.local_key;
+        }
+        total += now_ns() - t0;
+    }
+
+    s_sink = acc;
+    return total;
+}
+
+/* Scan the ring for an edge that never comes (catch-up worst case) */
+static int64_t run_consumer_scan(uint32_t ops) {
+    keying_stream_t stream;
+    stream_consumer_t consumer;
+    uint64_t ticks = 0;
+    int64_t total = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_STREAM_CAP) {
+        fill_stream(&stream);
+        consumer_init_at(&consumer, &stream, 0);
+
+        int64_t t0 = now_ns();
+        (void)consumer_scan_until_edge(&consumer, FLAG_CONFIG_CHANGE, SIZE_MAX, &ticks);
+        total += now_ns() - t0;
+    }
+
+    s_sink = (uint32_t)ticks;
+    return total;
+}
+
+static int64_t run_consumer_span(uint32_t ops) {
+    keying_stream_t stream;
+    stream_consumer_t consumer;
+    uint32_t acc = 0;
+    int64_t total = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_STREAM_CAP) {
+        fill_stream(&stream);
+        consumer_init_at(&consumer, &stream, 0);
+
+        int64_t t0 = now_ns();
+        const stream_slot_t *a;
+        const stream_slot_t *b;
+        size_t na;
+        size_t nb;
+        while (consumer_next_span(&consumer, &a, &na, &b, &nb, BENCH_STREAM_CAP) > 0) {
+            for (size_t i = 0; i < na; i++) {
+                acc += a[i].sample.local_key;
+            }
+            for (size_t i = 0; i < nb; i++) {
+                acc += b[i].sample.local_key;
+            }
+            consumer_commit(&consumer, na + nb);
+        }
+        total += now_ns() - t0;
+    }
+
+    s_sink = acc;
+    return total;
+}
+
+/* Small hot ring spilled into a full or compact archive (untimed) */
+static void fill_archive(keying_stream_t *stream, bool compact) {
+    stream_init(stream, s_hot_buf, BENCH_HOT_CAP);
+    if (compact) {
+        stream_attach_compact_archive(stream, &s_archive, s_archive_words, BENCH_STREAM_CAP);
+    } else {
+        stream_attach_archive(stream, &s_archive, s_stream_buf, BENCH_STREAM_CAP);
+    }
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    for (uint32_t i = 0; i < BENCH_STREAM_CAP; i++) {
+        sample.local_key = (uint8_t)(i & 1U);
+        stream_push_raw(stream, sample);
+        if ((i & (BENCH_HOT_CAP / 2U - 1U)) == 0) {
+            stream_archive_spill(stream, SIZE_MAX);
+        }
+    }
+    stream_archive_spill(stream, SIZE_MAX);
+}
+
+/* Sequential history scan of the archive-only part, one sample at a time */
+static int64_t run_archive_next(uint32_t ops, bool compact) {
+    keying_stream_t stream;
+    stream_consumer_t consumer;
+    stream_sample_t out;
+    uint32_t acc = 0;
+    int64_t total = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_ARCHIVED) {
+        fill_archive(&stream, compact);
+        consumer_init_at(&consumer, &stream, 0);
+
+        int64_t t0 = now_ns();
+        for (uint32_t i = 0; i < BENCH_ARCHIVED && consumer_next(&consumer, &out); i++) {
+            acc += out.local_key;
+        }
+        total += now_ns() - t0;
+    }
+
+    s_sink = acc;
+    return total;
+}
+
+static int64_t run_archive_span(uint32_t ops, bool compact) {
+    keying_stream_t stream;
+    stream_consumer_t consumer;
+    uint32_t acc = 0;
+    int64_t total = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_ARCHIVED) {
+        fill_archive(&stream, compact);
+        consumer_init_at(&consumer, &stream, 0);
+
+        int64_t t0 = now_ns();
+        const stream_slot_t *a;
+        const stream_slot_t *b;
+        size_t na;
+        size_t nb;
+        while (consumer_position(&consumer) < BENCH_ARCHIVED &&
+               consumer_next_span(&consumer, &a, &na, &b, &nb,
+                                  BENCH_ARCHIVED - consumer_position(&consumer)) > 0) {
+            for (size_t i = 0; i < na; i++) {
+                acc += a[i].sample.local_key;
+            }
+            for (size_t i = 0; i < nb; i++) {
+                acc += b[i].sample.local_key;
+            }
+            consumer_commit(&consumer, na + nb);
+        }
+        total += now_ns() - t0;
+    }
+
+    s_sink = acc;
+    return total;
+}
+
+static int64_t run_best_effort_tick(uint32_t ops) {
+    keying_stream_t stream;
+    best_effort_consumer_t consumer;
+    stream_sample_t out;
+    uint32_t acc = 0;
+    int64_t total = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_STREAM_CAP) {
+        fill_stream(&stream);
+        best_effort_consumer_init(&consumer, &stream, 0);
+        consumer.read_idx = 0;
+
+        int64_t t0 = now_ns();
+        while (best_effort_consumer_tick(&consumer, &out)) {
+            acc += out.local_key;
+        }
+        total += now_ns() - t0;
+    }
+
+    s_sink = acc;
+    return total;
+}
+
+static int64_t run_hard_rt_tick(uint32_t ops) {
+    keying_stream_t stream;
+    hard_rt_consumer_t consumer;
+    fault_state_t fault;
+    stream_sample_t out;
+    uint32_t acc = 0;
+    int64_t total = 0;
+
+    for (uint32_t done = 0; done < ops; done += BENCH_STREAM_CAP) {
+        fill_stream(&stream);
+        fault_init(&fault);
+        hard_rt_consumer_init(&consumer, &stream, &fault, BENCH_STREAM_CAP);
+        consumer.read_idx = 0;
+
+        int64_t t0 = now_ns();
+        while (hard_rt_consumer_tick(&consumer, &out) == HARD_RT_OK) {
+            acc += out.local_key;
+        }
+        total += now_ns() - t0;
+    }
+
+    s_sink = acc;
+    return total;
+}
+
+/* Deterministic paddle pattern: squeezes, single paddles and idle gaps */
+static gpio_state_t paddle_pattern(uint32_t tick) {
+    switch ((tick / 700U) % 6U) {
+        case 0:  return GPIO_BOTH;
+        case 1:  return gpio_from_paddles(true, false);
+        case 2:  return GPIO_IDLE;
+        case 3:  return gpio_from_paddles(false, true);
+        case 4:  return GPIO_BOTH;
+        default: return GPIO_IDLE;
+    }
+}
+
+static int64_t run_iambic_preset(uint32_t ops, uint32_t preset_index) {
+    iambic_config_t config;
+    iambic_preset_activate(preset_index);
+    iambic_config_from_preset(&config);
+
+    iambic_processor_t proc;
+    iambic_init(&proc, &config);
+    uint32_t acc = 0;
+
+    /* 100us ticks, starting clear of the release debounce at t=0 */
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < ops; i++) {
+        stream_sample_t s = iambic_tick(&proc, 100000 + (int64_t)i * 100, paddle_pattern(i));
+        acc += s.local_key;
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = acc;
+    return t1 - t0;
+}
+
+static int64_t run_sidetone(uint32_t ops) {
+    sidetone_gen_t gen;
+    sidetone_init(&gen, 600, 8000, 40);
+    uint32_t acc = 0;
+
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < ops; i++) {
+        acc += (uint16_t)sidetone_next_sample(&gen, ((i / 400U) & 1U) != 0);
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = acc;
+    return t1 - t0;
+}
+
+/* Audio ring: one RT tick block (8 samples at 8 kHz) through, per sample */
+#define BENCH_AUDIO_RING  256U
+#define BENCH_AUDIO_BLOCK 8U
+
+typedef enum {
+    AUDIO_RING_SAMPLE, AUDIO_RING_BLOCK, AUDIO_RING_SPAN,
+} bench_audio_ring_t;
+
+static int16_t s_audio_ring_buf[BENCH_AUDIO_RING];
+
+static int64_t run_audio_ring(uint32_t ops, bench_audio_ring_t mode) {
+    audio_ring_buffer_t ring;
+    audio_buffer_init(&ring, s_audio_ring_buf, BENCH_AUDIO_RING);
+    int16_t block[BENCH_AUDIO_BLOCK];
+    uint32_t acc = 0;
+
+    /* Offset by 3 so one block in 32 straddles the wrap */
+    for (uint32_t i = 0; i < 3; i++) {
+        audio_buffer_push(&ring, 0);
+    }
+
+    int64_t t0 = now_ns();
+    for (uint32_t done = 0; done < ops; done += BENCH_AUDIO_BLOCK) {
+        switch (mode) {
+            case AUDIO_RING_SAMPLE:
+                for (uint32_t i = 0; i < BENCH_AUDIO_BLOCK; i++) {
+                    audio_buffer_push(&ring, (int16_t)(done + i));
+                }
+                for (uint32_t i = 0; i < BENCH_AUDIO_BLOCK; i++) {
+                    (void)audio_buffer_pop(&ring, &block[i]);
+                }
+                break;
+            case AUDIO_RING_BLOCK:
+                for (uint32_t i = 0; i < BENCH_AUDIO_BLOCK; i++) {
+                    block[i] = (int16_t)(done + i);
+                }
+                (void)audio_buffer_write(&ring, block, BENCH_AUDIO_BLOCK);
+                (void)audio_buffer_read(&ring, block, BENCH_AUDIO_BLOCK);
+                break;
+            case AUDIO_RING_SPAN: {
+                int16_t *wa;
+                int16_t *wb;
+                size_t na;
+                size_t nb;
+                size_t n = audio_buffer_write_acquire(&ring, &wa, &na, &wb, &nb, BENCH_AUDIO_BLOCK);
+                for (size_t i = 0; i < na; i++) {
+                    wa[i] = (int16_t)(done + i);
+                }
+                for (size_t i = 0; i < nb; i++) {
+                    wb[i] = (int16_t)(done + na + i);
+                }
+                audio_buffer_write_commit(&ring, n);
+
+                const int16_t *ra;
+                const int16_t *rb;
+                n = audio_buffer_read_acquire(&ring, &ra, &na, &rb, &nb, BENCH_AUDIO_BLOCK);
+                for (size_t i = 0; i < na; i++) {
+                    block[i] = ra[i];
+                }
+                for (size_t i = 0; i < nb; i++) {
+                    block[na + i] = rb[i];
+                }
+                audio_buffer_read_commit(&ring, n);
+                break;
+            }
+        }
+        acc += (uint16_t)block[BENCH_AUDIO_BLOCK - 1U];
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = acc;
+    return t1 - t0;
+}
+
+/* Mixed frame stream: no-payload, short payload and long payload frames */
+static size_t build_frames(uint8_t *buf, size_t cap, uint32_t *frames) {
+    size_t len = 0;
+    *frames = 0;
+    while (len + 80 <= cap) {
+        buf[len++] = 0x01;                      /* No payload */
+        buf[len++] = 0x40 | 0x03;               /* Short payload, 4 bytes */
+        buf[len++] = 4;
+        for (int i = 0; i < 4; i++) buf[len++] = (uint8_t)i;
+        buf[len++] = 0x80 | 0x05;               /* Long payload, 64 bytes (LE) */
+        buf[len++] = 64;
+        buf[len++] = 0;
+        for (int i = 0; i < 64; i++) buf[len++] = (uint8_t)i;
+        *frames += 3;
+    }
+    return len;
+}
+
+static int64_t run_cwnet_parse(uint32_t ops) {
+    static uint8_t buf[8192];
+    uint32_t frames_per_buf;
+    size_t len = build_frames(buf, sizeof(buf), &frames_per_buf);
+
+    cwnet_frame_parser_t parser;
+    cwnet_frame_parser_init(&parser);
+    uint32_t acc = 0;
+    uint32_t parsed = 0;
+
+    int64_t t0 = now_ns();
+    while (parsed < ops) {
+        size_t off = 0;
+        while (off < len) {
+            cwnet_parse_result_t r = cwnet_frame_parse(&parser, buf + off, len - off);
+            if (r.status != CWNET_PARSE_OK || r.bytes_consumed == 0) {
+                break;
+            }
+            off += r.bytes_consumed;
+            acc += r.payload_len;
+            parsed++;
+        }
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = acc;
+    return (int64_t)((double)(t1 - t0) * (double)ops / (double)parsed);
+}
+
+/* Element/gap durations at ~20 WPM with +/-12% jitter, marks and spaces
+ * alternating */
+#define BENCH_TIMING_EVENTS 1024
+static int64_t s_timing_us[BENCH_TIMING_EVENTS];
+
+static void build_timing(void) {
+    static const int64_t mark_units[] = { 1, 3, 1, 1, 3, 3, 1 };
+    static const int64_t space_units[] = { 1, 1, 3, 1, 1, 7, 1 };
+    uint32_t rng = 12345U;
+    for (uint32_t i = 0; i < BENCH_TIMING_EVENTS; i++) {
+        rng = rng * 1103515245U + 12345U;
+        int64_t jitter = (int64_t)((rng >> 16) % 15U) - 7;  /* +/-7 ms */
+        int64_t units = (i & 1U) ? space_units[(i / 2U) % 7U] : mark_units[(i / 2U) % 7U];
+        s_timing_us[i] = units * 60000 + jitter * 1000;
+    }
+}
+
+static int64_t run_timing_classify(uint32_t ops, timing_mode_t mode) {
+    timing_classifier_t tc;
+    timing_classifier_init(&tc, 20.0f);
+    timing_classifier_set_mode(&tc, mode);
+    uint32_t acc = 0;
+
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < ops; i++) {
+        uint32_t k = i % BENCH_TIMING_EVENTS;
+        acc += (uint32_t)timing_classifier_classify(&tc, s_timing_us[k], (k & 1U) == 0);
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = acc;
+    return t1 - t0;
+}
+
+/* One WireGuard data packet: a CWNet frame inside the tunnel is far smaller,
+ * a full one is the MTU. Sealed in place like wireguardif does. */
+#define BENCH_WG_SMALL  64U
+#define BENCH_WG_MTU    1420U
+#define BENCH_WG_TAG    16U
+static uint8_t s_wg_packet[BENCH_WG_MTU + BENCH_WG_TAG];
+static uint8_t s_wg_plain[BENCH_WG_MTU];
+static const uint8_t s_wg_key[32] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+typedef enum {
+    WG_REFC_SEAL, WG_XTENSA_SEAL, WG_REFC_OPEN, WG_XTENSA_OPEN,
+} bench_wg_op_t;
+
+static int64_t run_wg_aead(uint32_t ops, bench_wg_op_t op, size_t len) {
+    uint32_t acc = 0;
+
+    /* Open needs a valid packet: seal one first, open it out of place */
+    chacha20poly1305_encrypt(s_wg_packet, s_wg_plain, len, NULL, 0, 1, s_wg_key);
+
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < ops; i++) {
+        switch (op) {
+            case WG_REFC_SEAL:
+                chacha20poly1305_encrypt(s_wg_packet, s_wg_packet, len, NULL, 0, i, s_wg_key);
+                break;
+            case WG_XTENSA_SEAL:
+                chacha20poly1305_xtensa_encrypt(s_wg_packet, s_wg_packet, len, NULL, 0, i, s_wg_key);
+                break;
+            case WG_REFC_OPEN:
+                acc += chacha20poly1305_decrypt(s_wg_plain, s_wg_packet, len + BENCH_WG_TAG,
+                                                NULL, 0, 1, s_wg_key) ? 1U : 0U;
+                break;
+            case WG_XTENSA_OPEN:
+                acc += chacha20poly1305_xtensa_decrypt(s_wg_plain, s_wg_packet, len + BENCH_WG_TAG,
+                                                       NULL, 0, 1, s_wg_key) ? 1U : 0U;
+                break;
+        }
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = acc + s_wg_plain[0];
+    return t1 - t0;
+}
+
+/* BLAKE2s-256 of one 64-byte block (the handshake hashes and MACs), and
+ * Kdf3 of a 32-byte input (each handshake message runs several) */
+typedef enum {
+    HASH_BLAKE2S_REFC, HASH_BLAKE2S_XTENSA, HASH_KDF3_REFC, HASH_KDF3_XTENSA,
+} bench_hash_op_t;
+
+/* Kdf3 as wireguard.c computes it on the reference hash: one HMAC for
+ * tau0, then one per output, each paying for both pad blocks */
+static void ref_hmac(uint8_t digest[32], const uint8_t key[32], const uint8_t *text, size_t text_len) {
+    uint8_t pad[64];
+    blake2s_ctx ctx;
+
+    memset(pad, 0x36, sizeof(pad));
+    for (int i = 0; i < 32; i++) pad[i] ^= key[i];
+    blake2s_init(&ctx, 32, NULL, 0);
+    blake2s_update(&ctx, pad, sizeof(pad));
+    blake2s_update(&ctx, text, text_len);
+    blake2s_final(&ctx, digest);
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (int i = 0; i < 32; i++) pad[i] ^= key[i];
+    blake2s_init(&ctx, 32, NULL, 0);
+    blake2s_update(&ctx, pad, sizeof(pad));
+    blake2s_update(&ctx, digest, 32);
+    blake2s_final(&ctx, digest);
+}
+
+static void ref_kdf3(uint8_t t1[32], uint8_t t2[32], uint8_t t3[32], const uint8_t ck[32],
+                     const uint8_t *data, size_t data_len) {
+    uint8_t tau0[32];
+    uint8_t buf[33];
+
+    ref_hmac(tau0, ck, data, data_len);
+    buf[0] = 1;
+    ref_hmac(t1, tau0, buf, 1);
+    memcpy(buf, t1, 32);
+    buf[32] = 2;
+    ref_hmac(t2, tau0, buf, 33);
+    memcpy(buf, t2, 32);
+    buf[32] = 3;
+    ref_hmac(t3, tau0, buf, 33);
+}
+
+static int64_t run_wg_hash(uint32_t ops, bench_hash_op_t op) {
+    uint8_t ck[32] = { 0 };
+    uint8_t t2[32];
+    uint8_t t3[32];
+
+    /* Chain the results so no call can be skipped */
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < ops; i++) {
+        ck[1] = (uint8_t)i;
+        switch (op) {
+            case HASH_BLAKE2S_REFC:
+                memcpy(s_wg_plain, ck, sizeof(ck));
+                blake2s(ck, sizeof(ck), NULL, 0, s_wg_plain, 64);
+                break;
+            case HASH_BLAKE2S_XTENSA:
+                memcpy(s_wg_plain, ck, sizeof(ck));
+                blake2s_xtensa(ck, sizeof(ck), NULL, 0, s_wg_plain, 64);
+                break;
+            case HASH_KDF3_REFC:
+                ref_kdf3(ck, t2, t3, ck, s_wg_key, sizeof(s_wg_key));
+                break;
+            case HASH_KDF3_XTENSA:
+                blake2s_xtensa_hkdf(ck, t2, t3, ck, s_wg_key, sizeof(s_wg_key));
+                break;
+        }
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = ck[0];
+    return t1 - t0;
+}
+
+/* One X25519 scalar multiplication; a handshake does four (two per side
+ * with the static-static one cached) */
+typedef enum {
+    X25519_REFC, X25519_NACL, X25519_XTENSA,
+} bench_x25519_impl_t;
+
+static int64_t run_x25519(uint32_t ops, bench_x25519_impl_t impl) {
+    uint8_t k[32];
+    uint8_t u[32] = { 9 };
+    for (size_t i = 0; i < sizeof(k); i++) {
+        k[i] = (uint8_t)(i * 37U + 11U);
+    }
+
+    /* Chain the results so no call can be skipped */
+    int64_t t0 = now_ns();
+    for (uint32_t i = 0; i < ops; i++) {
+        switch (impl) {
+            case X25519_REFC:   (void)x25519(u, k, u, 1); break;
+            case X25519_NACL:   (void)crypto_scalarmult(u, k, u); break;
+            case X25519_XTENSA: (void)x25519_xtensa(u, k, u); break;
+        }
+    }
+    int64_t t1 = now_ns();
+
+    s_sink = u[0];
+    return t1 - t0;
+}
+
+/* ============================================================================
+ * Driver
+ * ============================================================================ */
+
+typedef int64_t (*bench_fn_t)(uint32_t ops, uint32_t arg);
+
+static int64_t best_of(bench_fn_t fn, uint32_t ops, uint32_t arg) {
+    int64_t best = INT64_MAX;
+    for (int r = 0; r < BENCH_REPS; r++) {
+        int64_t ns = fn(ops, arg);
+        if (ns < best) best = ns;
+    }
+    return best;
+}
+
+static int64_t k_push_changing(uint32_t ops, uint32_t arg) { (void)arg; return run_stream_push(ops, true, false); }
+static int64_t k_push_idle(uint32_t ops, uint32_t arg)     { (void)arg; return run_stream_push(ops, false, false); }
+static int64_t k_push_channels(uint32_t ops, uint32_t arg) { (void)arg; return run_stream_push(ops, true, true); }
+static int64_t k_consumer_next(uint32_t ops, uint32_t arg) { (void)arg; return run_consumer_next(ops); }
+static int64_t k_consumer_span(uint32_t ops, uint32_t arg) { (void)arg; return run_consumer_span(ops); }
+static int64_t k_consumer_scan(uint32_t ops, uint32_t arg) { (void)arg; return run_consumer_scan(ops); }
+static int64_t k_archive_next(uint32_t ops, uint32_t arg)  { return run_archive_next(ops, arg != 0); }
+static int64_t k_archive_span(uint32_t ops, uint32_t arg)  { return run_archive_span(ops, arg != 0); }
+static int64_t k_best_effort(uint32_t ops, uint32_t arg)   { (void)arg; return run_best_effort_tick(ops); }
+static int64_t k_hard_rt(uint32_t ops, uint32_t arg)       { (void)arg; return run_hard_rt_tick(ops); }
+static int64_t k_iambic(uint32_t ops, uint32_t arg)        { return run_iambic_preset(ops, arg); }
+static int64_t k_sidetone(uint32_t ops, uint32_t arg)      { (void)arg; return run_sidetone(ops); }
+static int64_t k_audio_ring(uint32_t ops, uint32_t arg)    { return run_audio_ring(ops, (bench_audio_ring_t)arg); }
+static int64_t k_cwnet(uint32_t ops, uint32_t arg)         { (void)arg; return run_cwnet_parse(ops); }
+static int64_t k_timing(uint32_t ops, uint32_t arg)        { return run_timing_classify(ops, (timing_mode_t)arg); }
+static int64_t k_wg_mtu(uint32_t ops, uint32_t arg)        { return run_wg_aead(ops, (bench_wg_op_t)arg, BENCH_WG_MTU); }
+static int64_t k_wg_small(uint32_t ops, uint32_t arg)      { return run_wg_aead(ops, (bench_wg_op_t)arg, BENCH_WG_SMALL); }
+static int64_t k_wg_hash(uint32_t ops, uint32_t arg)       { return run_wg_hash(ops, (bench_hash_op_t)arg); }
+static int64_t k_x25519(uint32_t ops, uint32_t arg)        { return run_x25519(ops, (bench_x25519_impl_t)arg); }
+
+static void run_all(void) {
+    const uint32_t ops = 1U << 20;
+    const uint32_t stream_ops = BENCH_STREAM_CAP * 256U;
+    const uint32_t archive_ops = BENCH_ARCHIVED * 256U;
+
+    record("stream_push_changing", best_of(k_push_changing, ops, 0), ops);
+    record("stream_push_idle", best_of(k_push_idle, ops, 0), ops);
+    record("stream_push_channels", best_of(k_push_channels, ops, 0), ops);
+    record("consumer_next", best_of(k_consumer_next, stream_ops, 0), stream_ops);
+    record("consumer_next_span", best_of(k_consumer_span, stream_ops, 0), stream_ops);
+    record("consumer_scan_until_edge", best_of(k_consumer_scan, stream_ops, 0), stream_ops);
+    record("archive_consumer_next", best_of(k_archive_next, archive_ops, 0), archive_ops);
+    record("archive_consumer_next_compact", best_of(k_archive_next, archive_ops, 1), archive_ops);
+    record("archive_consumer_span", best_of(k_archive_span, archive_ops, 0), archive_ops);
+    record("archive_consumer_span_compact", best_of(k_archive_span, archive_ops, 1), archive_ops);
+    record("best_effort_consumer_tick", best_of(k_best_effort, stream_ops, 0), stream_ops);
+    record("hard_rt_consumer_tick", best_of(k_hard_rt, stream_ops, 0), stream_ops);
+
+    iambic_preset_init();
+    for (uint32_t p = 0; p < IAMBIC_PRESET_COUNT; p++) {
+        char name[BENCH_NAME_MAX];
+        snprintf(name, sizeof(name), "iambic_tick_preset_%lu", (unsigned long)p);
+        record(name, best_of(k_iambic, ops, p), ops);
+    }
+    iambic_preset_activate(0);
+
+    record("sidetone_next_sample", best_of(k_sidetone, ops, 0), ops);
+    record("audio_ring_push_pop", best_of(k_audio_ring, ops, AUDIO_RING_SAMPLE), ops);
+    record("audio_ring_block", best_of(k_audio_ring, ops, AUDIO_RING_BLOCK), ops);
+    record("audio_ring_span", best_of(k_audio_ring, ops, AUDIO_RING_SPAN), ops);
+    record("cwnet_frame_parse", best_of(k_cwnet, ops / 4U, 0), ops / 4U);
+
+    build_timing();
+    record("timing_classify_ema", best_of(k_timing, ops / 4U, TIMING_MODE_EMA), ops / 4U);
+    record("timing_classify_cluster", best_of(k_timing, ops / 4U, TIMING_MODE_CLUSTER), ops / 4U);
+
+    /* ns per packet: refc is the vendored reference, xtensa the tuned backend */
+    const uint32_t wg_ops = ops / 256U;
+    record("wg_seal_1420_refc", best_of(k_wg_mtu, wg_ops, WG_REFC_SEAL), wg_ops);
+    record("wg_seal_1420_xtensa", best_of(k_wg_mtu, wg_ops, WG_XTENSA_SEAL), wg_ops);
+    record("wg_open_1420_refc", best_of(k_wg_mtu, wg_ops, WG_REFC_OPEN), wg_ops);
+    record("wg_open_1420_xtensa", best_of(k_wg_mtu, wg_ops, WG_XTENSA_OPEN), wg_ops);
+    record("wg_seal_64_refc", best_of(k_wg_small, wg_ops * 8U, WG_REFC_SEAL), wg_ops * 8U);
+    record("wg_seal_64_xtensa", best_of(k_wg_small, wg_ops * 8U, WG_XTENSA_SEAL), wg_ops * 8U);
+
+    /* ns per hash or per Kdf3 */
+    record("wg_blake2s_64_refc", best_of(k_wg_hash, wg_ops * 16U, HASH_BLAKE2S_REFC), wg_ops * 16U);
+    record("wg_blake2s_64_xtensa", best_of(k_wg_hash, wg_ops * 16U, HASH_BLAKE2S_XTENSA), wg_ops * 16U);
+    record("wg_kdf3_refc", best_of(k_wg_hash, wg_ops * 2U, HASH_KDF3_REFC), wg_ops * 2U);
+    record("wg_kdf3_xtensa", best_of(k_wg_hash, wg_ops * 2U, HASH_KDF3_XTENSA), wg_ops * 2U);
+
+    /* ns per scalar multiplication */
+    const uint32_t x25519_ops = 64U;
+    record("x25519_refc", best_of(k_x25519, x25519_ops, X25519_REFC), x25519_ops);
+    record("x25519_nacl", best_of(k_x25519, x25519_ops / 8U, X25519_NACL), x25519_ops / 8U);
+    record("x25519_xtensa", best_of(k_x25519, x25519_ops, X25519_XTENSA), x25519_ops);
+}
+
+static void print_json(void) {
+    printf("{\n  \"schema\": 1,\n  \"kernels\": [\n");
+    for (size_t i = 0; i < s_result_count; i++) {
+        printf("    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"ops\": %lu}%s\n",
+               s_results[i].name, s_results[i].ns_per_op,
+               (unsigned long)s_results[i].ops,
+               (i + 1 < s_result_count) ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+/**
+ * @brief Compare against a baseline file produced by print_json()
+ * @return Number of regressed kernels, or -1 if the file can't be read
+ */
+static int check_baseline(const char *path, double tolerance_pct) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "bench: cannot open baseline %s\n", path);
+        return -1;
+    }
+
+    int regressions = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[BENCH_NAME_MAX];
+        double base_ns;
+        const char *p = strstr(line, "\"name\": \"");
+        if (p == NULL || sscanf(p, "\"name\": \"%39[^\"]\", \"ns_per_op\": %lf", name, &base_ns) != 2) {
+            continue;
+        }
+        for (size_t i = 0; i < s_result_count; i++) {
+            if (strcmp(s_results[i].name, name) != 0) {
+                continue;
+            }
+            double limit = base_ns * (1.0 + tolerance_pct / 100.0);
+            if (s_results[i].ns_per_op > limit) {
+                fprintf(stderr, "bench: REGRESSION %s: %.2f ns/op > %.2f (baseline %.2f)\n",
+                        name, s_results[i].ns_per_op, limit, base_ns);
+                regressions++;
+            }
+        }
+    }
+
+    fclose(f);
+    return regressions;
+}
+
+int main(int argc, char **argv) {
+    const char *baseline = NULL;
+    double tolerance_pct = 50.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance_pct = strtod(argv[++i], NULL);
+        } else {
+            fprintf(stderr, "usage: %s [--baseline FILE] [--tolerance PCT]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    run_all();
+    print_json();
+
+    if (baseline != NULL) {
+        int regressions = check_baseline(baseline, tolerance_pct);
+        if (regressions != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
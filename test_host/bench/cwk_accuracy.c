@@ -0,0 +1,227 @@
+/**
+ * @file cwk_accuracy.c
+ * @brief Decoder accuracy report over .cwk keying recordings (host)
+ *
+ * Replays each recording through the real pipeline (stream producer, key
+ * edge stage, decoder channels on a virtual 1-tick clock) once per timing
+ * classifier mode and compares the decoded text with the sidecar
+ * NAME.txt. Reports the character error rate (edit distance / sent
+ * characters) per recording and mode, and the decoder time per key event
+ * (decoder_inst_process() time, idle polls included as on the keyer, over
+ * the edges it read), so a classifier change shows what it buys and what
+ * it costs.
+ *
+ * Recordings come from the keyer (GET /api/stream/export, console
+ * `export`) with a hand-written .txt, or from tools/cwk/cwk_synth.py,
+ * which the `accuracy` target runs to build its corpus.
+ *
+ * Usage:
+ *   cwk_accuracy [-v] FILE.cwk...      -v also prints the decoded text
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stream.h"
+#include "stream_export.h"
+#include "key_edge.h"
+#include "decoder.h"
+#include "cwk_util.h"
+
+#define ACC_STREAM_CAP      4096
+#define ACC_TEXT_MAX        4096
+#define ACC_PROCESS_TICKS   10      /* bg_task period at 1 ms ticks */
+#define ACC_TAIL_TICKS      5000    /* Idle after the recording: flush the last char */
+
+static const timing_mode_t MODES[] = { TIMING_MODE_EMA, TIMING_MODE_CLUSTER };
+#define ACC_MODES (sizeof(MODES) / sizeof(MODES[0]))
+
+static stream_slot_t s_buffer[ACC_STREAM_CAP];
+static keying_stream_t s_stream;
+static stream_producer_t s_remote;
+static key_edge_ring_t s_ring;
+static key_edge_stage_t s_stage;
+static decoder_t s_decoders[ACC_MODES];
+static char s_decoded[ACC_MODES][ACC_TEXT_MAX];
+static size_t s_decoded_len[ACC_MODES];
+static int64_t s_decode_ns[ACC_MODES];
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ============================================================================
+ * Replay
+ * ============================================================================ */
+
+static void drain(void) {
+    key_edge_stage_run(&s_stage);
+    for (size_t m = 0; m < ACC_MODES; m++) {
+        int64_t t0 = now_ns();
+        decoder_inst_process(&s_decoders[m]);
+        s_decode_ns[m] += now_ns() - t0;
+        decoded_char_t ch;
+        while ((ch = decoder_inst_pop_char(&s_decoders[m])).character != '\0') {
+            if (s_decoded_len[m] + 1U < ACC_TEXT_MAX) {
+                s_decoded[m][s_decoded_len[m]++] = ch.character;
+            }
+        }
+        s_decoded[m][s_decoded_len[m]] = '\0';
+    }
+}
+
+/** Push one idle/held LOCAL tick, draining like bg_task would */
+static void push_tick(stream_sample_t level, uint64_t *tick) {
+    stream_push(&s_stream, level);
+    if (++*tick % ACC_PROCESS_TICKS == 0) {
+        drain();
+    }
+}
+
+static bool replay(const uint8_t *data, size_t len) {
+    cwk_header_t h;
+    if (cwk_parse_header(data, len, &h) != NULL) {
+        return false;
+    }
+
+    stream_init(&s_stream, s_buffer, ACC_STREAM_CAP);
+    stream_set_tick_period_us(&s_stream, h.tick_us);
+    stream_producer_init(&s_remote, &s_stream, STREAM_LANE_REMOTE);
+    key_edge_ring_init(&s_ring, &s_stream);
+    key_edge_stage_init(&s_stage, &s_stream, &s_ring);
+    for (size_t m = 0; m < ACC_MODES; m++) {
+        decoder_inst_init(&s_decoders[m], &s_ring, DECODER_SOURCE_ANY);
+        decoder_inst_set_timing_mode(&s_decoders[m], MODES[m]);
+        s_decoded_len[m] = 0;
+        s_decoded[m][0] = '\0';
+        s_decode_ns[m] = 0;
+    }
+
+    size_t count = cwk_sample_count(&h, len);
+
+    /* LOCAL records are re-keyed tick by tick so the producer rebuilds
+     * edges and silence exactly as on the keyer */
+    stream_sample_t level = STREAM_SAMPLE_EMPTY;
+    uint64_t tick = 0;
+    for (size_t i = 0; i < count; i++) {
+        stream_sample_t s;
+        memcpy(&s, data + h.header_size + i * sizeof(s), sizeof(s));
+        switch (sample_lane(&s)) {
+            case STREAM_LANE_LOCAL:
+                if (sample_is_silence(&s)) {
+                    for (uint32_t t = sample_silence_ticks(&s); t > 0; t--) {
+                        push_tick(level, &tick);
+                    }
+                } else {
+                    level = STREAM_SAMPLE_EMPTY;
+                    level.gpio = s.gpio;
+                    level.local_key = s.local_key;
+                    level.audio_level = s.audio_level;
+                    push_tick(level, &tick);
+                }
+                break;
+            case STREAM_LANE_REMOTE:
+                /* Re-based: recordings start at tick first_tick */
+                if (!sample_is_silence(&s)) {
+                    uint64_t at = sample_resolve_tick(h.first_tick + tick, sample_event_tick32(&s));
+                    stream_producer_push(&s_remote, sample_remote_event(s.local_key != 0,
+                                                                        at - h.first_tick));
+                }
+                break;
+            default:
+                break;  /* TEXT/AUX: not keying */
+        }
+    }
+
+    stream_sample_t idle = STREAM_SAMPLE_EMPTY;
+    for (uint32_t t = 0; t < ACC_TAIL_TICKS; t++) {
+        push_tick(idle, &tick);
+    }
+    drain();
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bool verbose = false;
+    int first = 1;
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) {
+        verbose = true;
+        first = 2;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "usage: cwk_accuracy [-v] FILE.cwk...\n");
+        return 1;
+    }
+
+    size_t total_chars = 0;
+    size_t total_errors[ACC_MODES] = {0};
+    int64_t total_ns[ACC_MODES] = {0};
+    uint64_t total_events[ACC_MODES] = {0};
+
+    printf("%-24s %6s %6s", "recording", "chars", "wpm");
+    for (size_t m = 0; m < ACC_MODES; m++) {
+        printf("  %8s CER  us/ev", timing_mode_str(MODES[m]));
+    }
+    printf("\n");
+
+    for (int i = first; i < argc; i++) {
+        const char *path = argv[i];
+        size_t len = 0;
+        uint8_t *data = cwk_read_file(path, &len);
+
+        char txt_path[512];
+        snprintf(txt_path, sizeof(txt_path), "%s", path);
+        char *dot = strrchr(txt_path, '.');
+        if (dot != NULL) {
+            *dot = '\0';
+        }
+        strncat(txt_path, ".txt", sizeof(txt_path) - strlen(txt_path) - 1U);
+        size_t txt_len = 0;
+        char *truth = (char *)cwk_read_file(txt_path, &txt_len);
+
+        if (data == NULL || truth == NULL || !replay(data, len)) {
+            fprintf(stderr, "cwk_accuracy: %s: unreadable recording or missing %s\n", path, txt_path);
+            free(data);
+            free(truth);
+            return 1;
+        }
+
+        size_t n = cwk_normalize(truth);
+        const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+        printf("%-24s %6zu %6lu", name, n,
+               (unsigned long)decoder_inst_get_wpm(&s_decoders[ACC_MODES - 1U]));
+        for (size_t m = 0; m < ACC_MODES; m++) {
+            size_t d = cwk_edit_distance(truth, n, s_decoded[m], cwk_normalize(s_decoded[m]));
+            uint32_t events = s_decoders[m].stats.edges_processed;
+            total_errors[m] += d;
+            total_ns[m] += s_decode_ns[m];
+            total_events[m] += events;
+            printf("  %11.1f%% %6.3f", n ? 100.0 * (double)d / (double)n : 0.0,
+                   events ? (double)s_decode_ns[m] / 1000.0 / (double)events : 0.0);
+        }
+        printf("\n");
+        if (verbose) {
+            printf("  sent:    %s\n", truth);
+            for (size_t m = 0; m < ACC_MODES; m++) {
+                printf("  %-8s %s\n", timing_mode_str(MODES[m]), s_decoded[m]);
+            }
+        }
+        total_chars += n;
+
+        free(data);
+        free(truth);
+    }
+
+    printf("%-24s %6zu %6s", "total", total_chars, "");
+    for (size_t m = 0; m < ACC_MODES; m++) {
+        printf("  %11.1f%% %6.3f",
+               total_chars ? 100.0 * (double)total_errors[m] / (double)total_chars : 0.0,
+               total_events[m] ? (double)total_ns[m] / 1000.0 / (double)total_events[m] : 0.0);
+    }
+    printf("\n");
+    return 0;
+}
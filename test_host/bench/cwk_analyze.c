@@ -0,0 +1,722 @@
+/**
+ * @file cwk_analyze.c
+ * @brief Batch analysis of .cwk keying archives to JSON (host)
+ *
+ * Memory-maps every recording and replays it through the real pipeline
+ * (stream producer, key edge stage, decoder channels, keying statistics)
+ * like cwk_accuracy does, one recording per worker thread. For each one
+ * it reports the keying timing (speed, weight, dah/dit ratio, gaps and
+ * duty from key_stats taken over consecutive 10 s windows, per channel),
+ * the decoded character count and, when a NAME.txt sits beside it, the
+ * character error rate per timing classifier. A JSON summary goes to
+ * stdout or -o FILE.
+ *
+ * Each worker owns its whole pipeline, so recordings share nothing but
+ * the index of the next one to take; results land in their own slot and
+ * are printed in path order, whatever the thread count.
+ *
+ * Directories are searched recursively for *.cwk. Silences longer than a
+ * few seconds are skipped in bulk (stream_skip()) after the decoder had
+ * time to flush, so hours of idle archive cost little.
+ *
+ * Usage:
+ *   cwk_analyze [-j THREADS] [-o OUT.json] FILE.cwk|DIR...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stream.h"
+#include "stream_export.h"
+#include "key_edge.h"
+#include "key_stats.h"
+#include "decoder.h"
+#include "cwk_util.h"
+
+#define AN_STREAM_CAP       4096
+#define AN_PROCESS_TICKS    10       /* bg_task period at 1 ms ticks */
+#define AN_TAIL_TICKS       5000     /* Idle kept tick by tick: flushes the last char */
+#define AN_SKIP_CHUNK       65536    /* Longer silences: skipped this many ticks at a time */
+#define AN_STATS_US         10000000 /* Statistics taken once per KEY_STATS_10S window */
+#define AN_MAX_THREADS      64
+
+static const timing_mode_t MODES[] = { TIMING_MODE_EMA, TIMING_MODE_CLUSTER };
+#define AN_MODES (sizeof(MODES) / sizeof(MODES[0]))
+
+/** Channels reported: keyer output and remote RX */
+static const uint8_t CHANNELS[] = { KEY_EDGE_CH_KEY, KEY_EDGE_CH_REMOTE };
+static const char *const CHANNEL_NAMES[] = { "local", "remote" };
+#define AN_CHANNELS (sizeof(CHANNELS) / sizeof(CHANNELS[0]))
+
+/**
+ * @brief Timing figures of one channel over a whole recording
+ *
+ * Means over the 10 s windows that held marks, weighted by their marks.
+ */
+typedef struct {
+    uint64_t edges;             /**< Key-down edges */
+    uint64_t down_us;           /**< Time spent down */
+    uint32_t windows;           /**< 10 s windows with marks */
+    uint64_t marks;             /**< Marks in those windows */
+    double wpm_min;
+    double wpm_max;
+    double wpm_sum;             /**< Sum of wpm * marks */
+    double weight_sum;          /**< Sum of weight_pm * marks */
+    double dah_ratio_sum;       /**< Sum of dah_ratio * marks (windows with both) */
+    uint64_t dah_ratio_marks;
+    double char_gap_sum;        /**< Sum of char_gap * chars */
+    uint64_t char_gap_chars;
+    double word_gap_sum;        /**< Sum of word_gap * words */
+    uint64_t word_gap_words;
+    int64_t down_since_us;      /**< Current mark start, -1 while up */
+} an_timing_t;
+
+/**
+ * @brief Everything reported for one recording
+ */
+typedef struct {
+    const char *path;
+    const char *error;          /**< NULL = analyzed */
+    uint16_t version;
+    uint32_t tick_us;
+    uint64_t samples;
+    uint64_t ticks;             /**< LOCAL ticks replayed (tail excluded) */
+    an_timing_t timing[AN_CHANNELS];
+    uint32_t wpm;               /**< Decoder speed estimate at the end */
+    size_t decoded[AN_MODES];   /**< Characters decoded, normalized */
+    bool has_truth;
+    size_t sent;                /**< Characters in NAME.txt, normalized */
+    size_t errors[AN_MODES];    /**< Edit distance to NAME.txt */
+    uint32_t events[AN_MODES];
+    int64_t decode_ns[AN_MODES];
+} an_result_t;
+
+/**
+ * @brief One worker's pipeline (reused for each recording it takes)
+ */
+typedef struct {
+    stream_slot_t buffer[AN_STREAM_CAP];
+    keying_stream_t stream;
+    stream_producer_t remote;
+    key_edge_ring_t ring;
+    key_edge_stage_t stage;
+    key_edge_reader_t reader;
+    key_stats_t stats;
+    decoder_t decoders[AN_MODES];
+    char *text[AN_MODES];
+    size_t text_len[AN_MODES];
+    size_t text_cap[AN_MODES];
+    an_result_t *res;
+    uint64_t tick;
+    int64_t next_stats_us;
+} an_worker_t;
+
+typedef struct {
+    char **paths;
+    an_result_t *results;
+    size_t count;
+    atomic_size_t next;
+} an_job_t;
+
+static int64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ============================================================================
+ * Input
+ * ============================================================================ */
+
+/** Map a whole file read-only; NULL for empty or unreadable files */
+static const uint8_t *map_file(const char *path, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    *len = (size_t)st.st_size;
+    return map;
+}
+
+/** NAME.txt beside NAME.cwk, NUL-terminated; NULL if there is none */
+static char *read_truth(const char *path) {
+    char txt_path[4096];
+    snprintf(txt_path, sizeof(txt_path), "%s", path);
+    char *dot = strrchr(txt_path, '.');
+    char *slash = strrchr(txt_path, '/');
+    if (dot != NULL && (slash == NULL || dot > slash)) {
+        *dot = '\0';
+    }
+    strncat(txt_path, ".txt", sizeof(txt_path) - strlen(txt_path) - 1U);
+
+    size_t len = 0;
+    const uint8_t *map = map_file(txt_path, &len);
+    if (map == NULL) {
+        return NULL;
+    }
+    char *text = malloc(len + 1U);
+    if (text != NULL) {
+        memcpy(text, map, len);
+        text[len] = '\0';
+    }
+    munmap((void *)map, len);
+    return text;
+}
+
+static bool has_suffix(const char *s, const char *suffix) {
+    size_t n = strlen(s);
+    size_t m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static bool add_path(char ***paths, size_t *count, size_t *cap, const char *path) {
+    if (*count == *cap) {
+        size_t ncap = *cap ? *cap * 2U : 64U;
+        char **n = realloc(*paths, ncap * sizeof(char *));
+        if (n == NULL) {
+            return false;
+        }
+        *paths = n;
+        *cap = ncap;
+    }
+    char *copy = strdup(path);
+    if (copy == NULL) {
+        return false;
+    }
+    (*paths)[(*count)++] = copy;
+    return true;
+}
+
+/** Every *.cwk under dir, recursively */
+static void scan_dir(const char *dir, char ***paths, size_t *count, size_t *cap) {
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        fprintf(stderr, "cwk_analyze: %s: %s\n", dir, strerror(errno));
+        return;
+    }
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') {
+            continue;
+        }
+        char path[4096];
+        size_t n = strlen(dir);
+        snprintf(path, sizeof(path), "%s%s%s", dir, (n > 0 && dir[n - 1] == '/') ? "" : "/",
+                 e->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            scan_dir(path, paths, count, cap);
+        } else if (S_ISREG(st.st_mode) && has_suffix(e->d_name, ".cwk")) {
+            add_path(paths, count, cap, path);
+        }
+    }
+    closedir(d);
+}
+
+static int cmp_path(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* ============================================================================
+ * Timing statistics
+ * ============================================================================ */
+
+static void timing_edge(an_timing_t *t, int64_t time_us, uint8_t level) {
+    if (level != 0 && t->down_since_us < 0) {
+        t->edges++;
+        t->down_since_us = time_us;
+    } else if (level == 0 && t->down_since_us >= 0) {
+        if (time_us > t->down_since_us) {
+            t->down_us += (uint64_t)(time_us - t->down_since_us);
+        }
+        t->down_since_us = -1;
+    }
+}
+
+static void timing_window(an_timing_t *t, const key_stats_view_t *v) {
+    if (v->marks == 0) {
+        return;
+    }
+    double wpm = (double)v->wpm_x10 / 10.0;
+    if (t->windows == 0 || wpm < t->wpm_min) {
+        t->wpm_min = wpm;
+    }
+    if (t->windows == 0 || wpm > t->wpm_max) {
+        t->wpm_max = wpm;
+    }
+    t->windows++;
+    t->marks += v->marks;
+    t->wpm_sum += wpm * v->marks;
+    t->weight_sum += (double)v->weight_pm * v->marks;
+    if (v->dah_ratio_x100 > 0) {
+        t->dah_ratio_sum += (double)v->dah_ratio_x100 / 100.0 * v->marks;
+        t->dah_ratio_marks += v->marks;
+    }
+    uint16_t char_gaps = (uint16_t)(v->chars - v->words);
+    if (v->char_gap_x100 > 0 && char_gaps > 0) {
+        t->char_gap_sum += (double)v->char_gap_x100 / 100.0 * char_gaps;
+        t->char_gap_chars += char_gaps;
+    }
+    if (v->word_gap_x100 > 0 && v->words > 0) {
+        t->word_gap_sum += (double)v->word_gap_x100 / 100.0 * v->words;
+        t->word_gap_words += v->words;
+    }
+}
+
+/** Feed the edges the stage published, and take a window every 10 s */
+static void collect(an_worker_t *w) {
+    key_edge_t e;
+    while (key_edge_reader_next(&w->reader, &e)) {
+        int64_t at = key_edge_time_us(&w->ring, e.tick);
+        key_stats_edge(&w->stats, at, e.channel, e.level, e.tag);
+        for (size_t c = 0; c < AN_CHANNELS; c++) {
+            if (e.channel == CHANNELS[c]) {
+                timing_edge(&w->res->timing[c], at, e.level);
+            }
+        }
+    }
+
+    int64_t head = key_edge_time_us(&w->ring, key_edge_head_tick(&w->ring, w->tick));
+    while (head >= w->next_stats_us) {
+        key_stats_advance(&w->stats, w->next_stats_us);
+        for (size_t c = 0; c < AN_CHANNELS; c++) {
+            key_stats_view_t views[KEY_STATS_WINDOWS];
+            key_stats_get(&w->stats, CHANNELS[c], views);
+            timing_window(&w->res->timing[c], &views[KEY_STATS_10S]);
+        }
+        w->next_stats_us += AN_STATS_US;
+    }
+}
+
+/* ============================================================================
+ * Replay
+ * ============================================================================ */
+
+static void append_char(an_worker_t *w, size_t m, char c) {
+    if (w->text_len[m] + 2U > w->text_cap[m]) {
+        size_t ncap = w->text_cap[m] ? w->text_cap[m] * 2U : 4096U;
+        char *n = realloc(w->text[m], ncap);
+        if (n == NULL) {
+            return;
+        }
+        w->text[m] = n;
+        w->text_cap[m] = ncap;
+    }
+    w->text[m][w->text_len[m]++] = c;
+    w->text[m][w->text_len[m]] = '\0';
+}
+
+static void drain(an_worker_t *w) {
+    key_edge_stage_run(&w->stage);
+    for (size_t m = 0; m < AN_MODES; m++) {
+        int64_t t0 = now_ns(CLOCK_THREAD_CPUTIME_ID);
+        decoder_inst_process(&w->decoders[m]);
+        w->res->decode_ns[m] += now_ns(CLOCK_THREAD_CPUTIME_ID) - t0;
+        decoded_char_t ch;
+        while ((ch = decoder_inst_pop_char(&w->decoders[m])).character != '\0') {
+            append_char(w, m, ch.character);
+        }
+    }
+    collect(w);
+}
+
+/** Push one idle/held LOCAL tick, draining like bg_task would */
+static void push_tick(an_worker_t *w, stream_sample_t level) {
+    stream_push(&w->stream, level);
+    if (++w->tick % AN_PROCESS_TICKS == 0) {
+        drain(w);
+    }
+}
+
+/** A silence run: tick by tick while the decoder may still flush, then in bulk */
+static void push_silence(an_worker_t *w, stream_sample_t level, uint32_t ticks) {
+    uint32_t fine = (ticks < AN_TAIL_TICKS) ? ticks : AN_TAIL_TICKS;
+    for (uint32_t t = 0; t < fine; t++) {
+        push_tick(w, level);
+    }
+    ticks -= fine;
+    while (ticks > 0) {
+        uint32_t n = (ticks < AN_SKIP_CHUNK) ? ticks : AN_SKIP_CHUNK;
+        stream_skip(&w->stream, n);
+        w->tick += n;
+        ticks -= n;
+        drain(w);
+    }
+}
+
+static const char *replay(an_worker_t *w, const uint8_t *data, size_t len) {
+    an_result_t *r = w->res;
+    cwk_header_t h;
+    const char *error = cwk_parse_header(data, len, &h);
+    if (error != NULL) {
+        return error;
+    }
+    r->version = h.version;
+    r->tick_us = h.tick_us;
+
+    stream_init(&w->stream, w->buffer, AN_STREAM_CAP);
+    stream_set_tick_period_us(&w->stream, h.tick_us);
+    stream_producer_init(&w->remote, &w->stream, STREAM_LANE_REMOTE);
+    key_edge_ring_init(&w->ring, &w->stream);
+    key_edge_stage_init(&w->stage, &w->stream, &w->ring);
+    key_edge_reader_init(&w->reader, &w->ring);
+    key_stats_init(&w->stats);
+    for (size_t m = 0; m < AN_MODES; m++) {
+        decoder_inst_init(&w->decoders[m], &w->ring, DECODER_SOURCE_ANY);
+        decoder_inst_set_timing_mode(&w->decoders[m], MODES[m]);
+        w->text_len[m] = 0;
+    }
+    for (size_t c = 0; c < AN_CHANNELS; c++) {
+        r->timing[c].down_since_us = -1;
+    }
+    w->tick = 0;
+    w->next_stats_us = key_edge_time_us(&w->ring, 0) + AN_STATS_US;
+
+    size_t count = cwk_sample_count(&h, len);
+    r->samples = count;
+
+    /* LOCAL records are re-keyed tick by tick so the producer rebuilds
+     * edges and silence exactly as on the keyer */
+    stream_sample_t level = STREAM_SAMPLE_EMPTY;
+    for (size_t i = 0; i < count; i++) {
+        stream_sample_t s;
+        memcpy(&s, data + h.header_size + i * sizeof(s), sizeof(s));
+        switch (sample_lane(&s)) {
+            case STREAM_LANE_LOCAL:
+                if (sample_is_silence(&s)) {
+                    push_silence(w, level, sample_silence_ticks(&s));
+                } else {
+                    level = STREAM_SAMPLE_EMPTY;
+                    level.gpio = s.gpio;
+                    level.local_key = s.local_key;
+                    level.audio_level = s.audio_level;
+                    push_tick(w, level);
+                }
+                break;
+            case STREAM_LANE_REMOTE:
+                /* Re-based: recordings start at tick first_tick */
+                if (!sample_is_silence(&s)) {
+                    uint64_t at = sample_resolve_tick(h.first_tick + w->tick,
+                                                      sample_event_tick32(&s));
+                    stream_producer_push(&w->remote, sample_remote_event(s.local_key != 0,
+                                                                         at - h.first_tick));
+                }
+                break;
+            default:
+                break;  /* TEXT/AUX: not keying */
+        }
+    }
+    r->ticks = w->tick;
+
+    /* Close the last partial window and the marks still down */
+    stream_sample_t idle = STREAM_SAMPLE_EMPTY;
+    for (uint32_t t = 0; t < AN_TAIL_TICKS; t++) {
+        push_tick(w, idle);
+    }
+    drain(w);
+    int64_t end_us = key_edge_time_us(&w->ring, w->tick);
+    key_stats_advance(&w->stats, end_us);
+    for (size_t c = 0; c < AN_CHANNELS; c++) {
+        key_stats_view_t views[KEY_STATS_WINDOWS];
+        key_stats_get(&w->stats, CHANNELS[c], views);
+        if (r->timing[c].windows == 0) {
+            timing_window(&r->timing[c], &views[KEY_STATS_10S]);   /* Under 10 s */
+        }
+        timing_edge(&r->timing[c], end_us, 0);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Scoring
+ * ============================================================================ */
+
+static void analyze(an_worker_t *w, an_result_t *r) {
+    memset(r->timing, 0, sizeof(r->timing));
+    w->res = r;
+
+    size_t len = 0;
+    const uint8_t *data = map_file(r->path, &len);
+    if (data == NULL) {
+        r->error = "unreadable";
+        return;
+    }
+    r->error = replay(w, data, len);
+    munmap((void *)data, len);
+    if (r->error != NULL) {
+        return;
+    }
+
+    r->wpm = decoder_inst_get_wpm(&w->decoders[AN_MODES - 1U]);
+    char *truth = read_truth(r->path);
+    r->has_truth = (truth != NULL);
+    if (truth != NULL) {
+        r->sent = cwk_normalize(truth);
+    }
+    for (size_t m = 0; m < AN_MODES; m++) {
+        r->events[m] = w->decoders[m].stats.edges_processed;
+        r->decoded[m] = (w->text[m] != NULL) ? cwk_normalize(w->text[m]) : 0;
+        if (truth != NULL) {
+            r->errors[m] = cwk_edit_distance(truth, r->sent, w->text[m] ? w->text[m] : "",
+                                         r->decoded[m]);
+        }
+    }
+    free(truth);
+}
+
+static void *worker_main(void *arg) {
+    an_job_t *job = arg;
+    an_worker_t *w = calloc(1, sizeof(*w));
+    if (w == NULL) {
+        return NULL;
+    }
+    size_t i;
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->count) {
+        analyze(w, &job->results[i]);
+    }
+    for (size_t m = 0; m < AN_MODES; m++) {
+        free(w->text[m]);
+    }
+    free(w);
+    return NULL;
+}
+
+/* ============================================================================
+ * Output
+ * ============================================================================ */
+
+static void json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)s; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(out, "\\u%04x", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static double ratio(double sum, uint64_t n) {
+    return n ? sum / (double)n : 0.0;
+}
+
+static void json_timing(FILE *out, const an_timing_t *t, double duration_s) {
+    fprintf(out, "{\"marks\": %llu, \"key_down_s\": %.3f, \"duty_pct\": %.2f",
+            (unsigned long long)t->edges, (double)t->down_us / 1e6,
+            duration_s > 0 ? 100.0 * (double)t->down_us / 1e6 / duration_s : 0.0);
+    fprintf(out, ", \"windows\": %u, \"wpm_mean\": %.1f, \"wpm_min\": %.1f, \"wpm_max\": %.1f",
+            t->windows, ratio(t->wpm_sum, t->marks), t->wpm_min, t->wpm_max);
+    fprintf(out, ", \"weight_pm\": %.0f, \"dah_ratio\": %.2f, \"char_gap_units\": %.2f"
+            ", \"word_gap_units\": %.2f}",
+            ratio(t->weight_sum, t->marks), ratio(t->dah_ratio_sum, t->dah_ratio_marks),
+            ratio(t->char_gap_sum, t->char_gap_chars), ratio(t->word_gap_sum, t->word_gap_words));
+}
+
+static double us_per_event(int64_t ns, uint64_t events) {
+    return events ? (double)ns / 1000.0 / (double)events : 0.0;
+}
+
+static void json_result(FILE *out, const an_result_t *r) {
+    fprintf(out, "    {\"file\": ");
+    json_string(out, r->path);
+    if (r->error != NULL) {
+        fprintf(out, ", \"error\": ");
+        json_string(out, r->error);
+        fprintf(out, "}");
+        return;
+    }
+    double duration_s = (double)r->ticks * (double)r->tick_us / 1e6;
+    fprintf(out, ", \"version\": %u, \"tick_us\": %u, \"samples\": %llu, \"duration_s\": %.3f",
+            r->version, r->tick_us, (unsigned long long)r->samples, duration_s);
+    for (size_t c = 0; c < AN_CHANNELS; c++) {
+        fprintf(out, ",\n     \"%s\": ", CHANNEL_NAMES[c]);
+        json_timing(out, &r->timing[c], duration_s);
+    }
+    fprintf(out, ",\n     \"decoder_wpm\": %u, \"sent_chars\": ", r->wpm);
+    if (r->has_truth) {
+        fprintf(out, "%zu", r->sent);
+    } else {
+        fprintf(out, "null");
+    }
+    fprintf(out, ", \"modes\": {");
+    for (size_t m = 0; m < AN_MODES; m++) {
+        fprintf(out, "%s\"%s\": {\"decoded_chars\": %zu, \"cer_pct\": ", m ? ", " : "",
+                timing_mode_str(MODES[m]), r->decoded[m]);
+        if (r->has_truth && r->sent > 0) {
+            fprintf(out, "%.2f", 100.0 * (double)r->errors[m] / (double)r->sent);
+        } else {
+            fprintf(out, "null");
+        }
+        fprintf(out, ", \"us_per_event\": %.3f}", us_per_event(r->decode_ns[m], r->events[m]));
+    }
+    fprintf(out, "}}");
+}
+
+static void json_summary(FILE *out, const an_result_t *results, size_t count, unsigned threads,
+                         double wall_s) {
+    size_t failed = 0;
+    size_t scored = 0;
+    size_t sent = 0;
+    double duration_s = 0.0;
+    uint64_t marks = 0;
+    size_t errors[AN_MODES] = {0};
+    int64_t ns[AN_MODES] = {0};
+    uint64_t events[AN_MODES] = {0};
+
+    fprintf(out, "{\n  \"files\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        const an_result_t *r = &results[i];
+        json_result(out, r);
+        fprintf(out, "%s\n", (i + 1U < count) ? "," : "");
+        if (r->error != NULL) {
+            failed++;
+            continue;
+        }
+        duration_s += (double)r->ticks * (double)r->tick_us / 1e6;
+        marks += r->timing[0].edges;
+        if (r->has_truth) {
+            scored++;
+            sent += r->sent;
+        }
+        for (size_t m = 0; m < AN_MODES; m++) {
+            if (r->has_truth) {
+                errors[m] += r->errors[m];
+            }
+            ns[m] += r->decode_ns[m];
+            events[m] += r->events[m];
+        }
+    }
+    fprintf(out, "  ],\n  \"totals\": {\"files\": %zu, \"failed\": %zu, \"scored\": %zu"
+            ", \"duration_s\": %.3f, \"local_marks\": %llu, \"sent_chars\": %zu, \"modes\": {",
+            count, failed, scored, duration_s, (unsigned long long)marks, sent);
+    for (size_t m = 0; m < AN_MODES; m++) {
+        fprintf(out, "%s\"%s\": {\"cer_pct\": ", m ? ", " : "", timing_mode_str(MODES[m]));
+        if (sent > 0) {
+            fprintf(out, "%.2f", 100.0 * (double)errors[m] / (double)sent);
+        } else {
+            fprintf(out, "null");
+        }
+        fprintf(out, ", \"us_per_event\": %.3f}", us_per_event(ns[m], events[m]));
+    }
+    fprintf(out, "}},\n  \"threads\": %u,\n  \"wall_s\": %.3f\n}\n", threads, wall_s);
+}
+
+static int usage(void) {
+    fprintf(stderr, "usage: cwk_analyze [-j THREADS] [-o OUT.json] FILE.cwk|DIR...\n");
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned threads = (ncpu > 0) ? (unsigned)ncpu : 1U;
+    const char *out_path = NULL;
+    char **paths = NULL;
+    size_t count = 0;
+    size_t cap = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            struct stat st;
+            if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+                scan_dir(argv[i], &paths, &count, &cap);
+            } else {
+                add_path(&paths, &count, &cap, argv[i]);
+            }
+        }
+    }
+    if (count == 0) {
+        return usage();
+    }
+    qsort(paths, count, sizeof(char *), cmp_path);
+    if (threads == 0) {
+        threads = 1;
+    }
+    if (threads > AN_MAX_THREADS) {
+        threads = AN_MAX_THREADS;
+    }
+    if (threads > count) {
+        threads = (unsigned)count;
+    }
+
+    an_job_t job = { .paths = paths, .count = count };
+    job.results = calloc(count, sizeof(an_result_t));
+    if (job.results == NULL) {
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        job.results[i].path = paths[i];
+    }
+    atomic_init(&job.next, 0);
+
+    int64_t t0 = now_ns(CLOCK_MONOTONIC);
+    pthread_t tid[AN_MAX_THREADS];
+    unsigned started = 0;
+    for (unsigned t = 0; t < threads; t++) {
+        if (pthread_create(&tid[t], NULL, worker_main, &job) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        worker_main(&job);
+    }
+    for (unsigned t = 0; t < started; t++) {
+        pthread_join(tid[t], NULL);
+    }
+    double wall_s = (double)(now_ns(CLOCK_MONOTONIC) - t0) / 1e9;
+
+    FILE *out = stdout;
+    if (out_path != NULL && (out = fopen(out_path, "w")) == NULL) {
+        fprintf(stderr, "cwk_analyze: %s: %s\n", out_path, strerror(errno));
+        return 1;
+    }
+    json_summary(out, job.results, count, started ? started : 1U, wall_s);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (job.results[i].error != NULL) {
+            fprintf(stderr, "cwk_analyze: %s: %s\n", paths[i], job.results[i].error);
+            failed++;
+        }
+        free(paths[i]);
+    }
+    fprintf(stderr, "cwk_analyze: %zu recordings, %zu failed, %u threads, %.2f s\n",
+            count, failed, started ? started : 1U, wall_s);
+    free(paths);
+    free(job.results);
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file cwk_util.c
+ * @brief .cwk recording helpers shared by the host tools (host)
+ */
+
+#include "cwk_util.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint8_t *cwk_read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = (size > 0) ? malloc((size_t)size + 1U) : NULL;
+    if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    if (data != NULL) {
+        data[size] = '\0';
+        *len = (size_t)size;
+    }
+    return data;
+}
+
+const char *cwk_parse_header(const uint8_t *data, size_t len, cwk_header_t *h) {
+    if (len < sizeof(*h)) {
+        return "truncated header";
+    }
+    memcpy(h, data, sizeof(*h));
+    if (memcmp(h->magic, CWK_MAGIC, 4) != 0 || h->version == 0 || h->version > CWK_VERSION ||
+        h->sample_size != sizeof(stream_sample_t) || h->header_size > len || h->tick_us == 0) {
+        return "not a supported .cwk recording";
+    }
+    return NULL;
+}
+
+size_t cwk_sample_count(const cwk_header_t *h, size_t len) {
+    size_t count = (len - h->header_size) / sizeof(stream_sample_t);
+    return (count > h->sample_count) ? h->sample_count : count;
+}
+
+size_t cwk_normalize(char *text) {
+    size_t out = 0;
+    bool space = true;
+    for (const char *p = text; *p != '\0'; p++) {
+        if (isspace((unsigned char)*p)) {
+            space = true;
+            continue;
+        }
+        if (space && out > 0) {
+            text[out++] = ' ';
+        }
+        space = false;
+        text[out++] = (char)toupper((unsigned char)*p);
+    }
+    text[out] = '\0';
+    return out;
+}
+
+size_t cwk_edit_distance(const char *a, size_t na, const char *b, size_t nb) {
+    size_t *prev = malloc((nb + 1U) * sizeof(size_t));
+    size_t *cur = malloc((nb + 1U) * sizeof(size_t));
+    if (prev == NULL || cur == NULL) {
+        free(prev);
+        free(cur);
+        return na > nb ? na : nb;
+    }
+    for (size_t j = 0; j <= nb; j++) {
+        prev[j] = j;
+    }
+    for (size_t i = 1; i <= na; i++) {
+        cur[0] = i;
+        for (size_t j = 1; j <= nb; j++) {
+            size_t sub = prev[j - 1] + (a[i - 1] != b[j - 1] ? 1U : 0U);
+            size_t del = prev[j] + 1U;
+            size_t ins = cur[j - 1] + 1U;
+            cur[j] = sub < del ? (sub < ins ? sub : ins) : (del < ins ? del : ins);
+        }
+        size_t *t = prev;
+        prev = cur;
+        cur = t;
+    }
+    size_t d = prev[nb];
+    free(prev);
+    free(cur);
+    return d;
+}
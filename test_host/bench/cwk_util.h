@@ -0,0 +1,59 @@
+/**
+ * @file cwk_util.h
+ * @brief .cwk recording helpers shared by the host tools (host)
+ *
+ * File loading, header validation and text scoring for cwk_accuracy,
+ * cwk_analyze and sim_pipeline, so the three read and score recordings
+ * the same way.
+ */
+
+#ifndef CWK_UTIL_H
+#define CWK_UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "stream_export.h"
+
+/**
+ * @brief Read a whole file, NUL-terminated
+ *
+ * @param path File path
+ * @param len Bytes read, without the terminator
+ * @return Buffer to free(), NULL if unreadable or empty
+ */
+uint8_t *cwk_read_file(const char *path, size_t *len);
+
+/**
+ * @brief Validate and copy a recording's header
+ *
+ * @param data Recording
+ * @param len Bytes in data
+ * @param h Header out
+ * @return NULL if usable, else why not
+ */
+const char *cwk_parse_header(const uint8_t *data, size_t len, cwk_header_t *h);
+
+/**
+ * @brief Samples present, at most the header's sample_count
+ *
+ * @param h Header (cwk_parse_header())
+ * @param len Bytes in the recording
+ */
+size_t cwk_sample_count(const cwk_header_t *h, size_t len);
+
+/**
+ * @brief Uppercase, single spaces, no leading/trailing space (in place)
+ *
+ * @return Length of the normalized text
+ */
+size_t cwk_normalize(char *text);
+
+/**
+ * @brief Levenshtein distance, two rows
+ *
+ * @return Edits from a to b; max(na, nb) if out of memory
+ */
+size_t cwk_edit_distance(const char *a, size_t na, const char *b, size_t nb);
+
+#endif /* CWK_UTIL_H */
@@ -0,0 +1,413 @@
+/**
+ * @file stream_stress.c
+ * @brief Multi-threaded stream stress and throughput harness (host)
+ *
+ * One producer thread pushes LOCAL samples as fast as it can while N
+ * consumer threads read them back, one of each kind in turn:
+ *   hard_rt      hard_rt_consumer_tick() (faults and recovers when lapped)
+ *   best_effort  best_effort_consumer_tick() (never skips on its own)
+ *   span         consumer_next_span() / consumer_commit()
+ *   next         consumer_next()
+ *
+ * Every sample carries a 24-bit sequence number (config_gen, audio_level),
+ * its parity as local_key and a check byte derived from it in gpio, so a
+ * consumer detects:
+ *   torn   check byte or key does not match the sequence (mixed copy)
+ *   order  sequence not after the previous one
+ *   lost   a gap the consumer did not report (drop, fault, overrun)
+ * Gaps a consumer did report are fine: at full rate everyone gets lapped.
+ *
+ * The producer yields every STRESS_BATCH pushes and consumers yield when
+ * caught up, so the run still means something on a host with fewer cores
+ * than threads.
+ *
+ * For each consumer count from 1 to --consumers the tool prints producer
+ * throughput and samples read per second by each consumer kind, and exits
+ * 1 if any sample was torn, out of order or silently lost.
+ *
+ * Built with -DKEYER_TSAN=ON it runs under ThreadSanitizer; bench/tsan.supp
+ * silences the slot copies the commit tags validate (seqlock reads race
+ * with the producer by design).
+ *
+ * Usage:
+ *   stream_stress [--seconds S] [--consumers N] [--capacity C]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stream.h"
+#include "consumer.h"
+#include "fault.h"
+
+#define STRESS_MAX_CONSUMERS 8
+#define STRESS_MAX_CAPACITY  65536
+#define STRESS_SEQ_MASK      0xFFFFFFU
+#define STRESS_SPAN_MAX      256
+#define STRESS_BATCH         1024   /* Pushes between producer yields */
+
+typedef enum {
+    KIND_HARD_RT = 0,
+    KIND_BEST_EFFORT,
+    KIND_SPAN,
+    KIND_NEXT,
+    KIND_COUNT
+} consumer_kind_t;
+
+static const char *const k_kind_names[KIND_COUNT] = {
+    "hard_rt", "best_effort", "span", "next",
+};
+
+static struct {
+    double seconds;
+    unsigned consumers;
+    size_t capacity;
+} s_cfg = {
+    .seconds = 1.0,
+    .consumers = STRESS_MAX_CONSUMERS,
+    .capacity = 4096,
+};
+
+static stream_slot_t s_ring[STRESS_MAX_CAPACITY];
+static keying_stream_t s_stream;
+static atomic_bool s_start;
+static atomic_bool s_stop;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ============================================================================
+ * Sequence encoding
+ * ============================================================================ */
+
+static uint8_t seq_check(uint32_t seq) {
+    return (uint8_t)((seq * 167U + (seq >> 8) * 13U + (seq >> 16)) & 0xFFU);
+}
+
+static stream_sample_t seq_sample(uint32_t seq) {
+    seq &= STRESS_SEQ_MASK;
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    s.config_gen = (uint16_t)(seq & 0xFFFFU);
+    s.audio_level = (uint8_t)(seq >> 16);
+    s.local_key = (uint8_t)(seq & 1U);
+    s.gpio.bits = seq_check(seq);
+    return s;
+}
+
+/* ============================================================================
+ * Validation (per consumer thread)
+ * ============================================================================ */
+
+typedef struct {
+    consumer_kind_t kind;
+    uint64_t read;      /**< Samples validated */
+    uint64_t reported;  /**< Gaps the consumer reported (drop/fault/overrun) */
+    uint64_t torn;
+    uint64_t order;
+    uint64_t lost;
+    uint32_t last;      /**< Last sequence seen */
+    bool have_last;
+    bool excused;       /**< A reported gap may precede the next sample */
+} stress_consumer_t;
+
+static void check_sample(stress_consumer_t *c, const stream_sample_t *s) {
+    if (sample_is_silence(s)) {
+        return;  /* Idle run flushed ahead of the first sample */
+    }
+    uint32_t seq = (uint32_t)s->config_gen | ((uint32_t)s->audio_level << 16);
+    if (s->gpio.bits != seq_check(seq) || s->local_key != (seq & 1U)) {
+        c->torn++;
+        return;
+    }
+
+    if (c->have_last) {
+        uint32_t delta = (seq - c->last) & STRESS_SEQ_MASK;
+        if (delta == 0 || delta > STRESS_SEQ_MASK / 2U) {
+            c->order++;
+        } else if (delta > 1U && !c->excused) {
+            c->lost++;
+        }
+    }
+    c->last = seq;
+    c->have_last = true;
+    c->excused = false;
+    c->read++;
+}
+
+static void report_gap(stress_consumer_t *c) {
+    c->reported++;
+    c->excused = true;
+}
+
+/* ============================================================================
+ * Consumer threads
+ * ============================================================================ */
+
+static void wait_start(void) {
+    while (!atomic_load_explicit(&s_start, memory_order_acquire)) {
+    }
+}
+
+static bool running(void) {
+    return !atomic_load_explicit(&s_stop, memory_order_acquire);
+}
+
+/* Caught up: let the producer run (matters on hosts with few cores) */
+static void idle(void) {
+    sched_yield();
+}
+
+static void run_hard_rt(stress_consumer_t *c) {
+    fault_state_t fault;
+    hard_rt_consumer_t consumer;
+    stream_sample_t out;
+    const hard_rt_recovery_t recovery = { .clean_ticks = 1 };
+
+    fault_init(&fault);
+    hard_rt_consumer_init(&consumer, &s_stream, &fault, s_cfg.capacity / 2U);
+    hard_rt_consumer_set_recovery(&consumer, &recovery);
+    wait_start();
+
+    while (running()) {
+        switch (hard_rt_consumer_tick(&consumer, &out)) {
+        case HARD_RT_OK:
+            check_sample(c, &out);
+            break;
+        case HARD_RT_FAULT:
+        case HARD_RT_RECOVERED:
+            report_gap(c);
+            break;
+        case HARD_RT_NO_DATA:
+            idle();
+            break;
+        }
+    }
+}
+
+static void run_best_effort(stress_consumer_t *c) {
+    best_effort_consumer_t consumer;
+    stream_sample_t out;
+
+    best_effort_consumer_init(&consumer, &s_stream, 0);
+    wait_start();
+
+    while (running()) {
+        size_t dropped = best_effort_consumer_dropped(&consumer);
+        size_t overwritten = best_effort_consumer_overwritten(&consumer);
+        bool got = best_effort_consumer_tick(&consumer, &out);
+        if (best_effort_consumer_dropped(&consumer) != dropped ||
+            best_effort_consumer_overwritten(&consumer) != overwritten) {
+            report_gap(c);
+        }
+        if (got) {
+            check_sample(c, &out);
+        } else {
+            idle();
+        }
+    }
+}
+
+static void run_span(stress_consumer_t *c) {
+    stream_consumer_t consumer;
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+
+    consumer_init(&consumer, &s_stream);
+    wait_start();
+
+    while (running()) {
+        size_t n = consumer_next_span(&consumer, &a, &na, &b, &nb, STRESS_SPAN_MAX);
+        if (n == 0) {
+            if (consumer_is_overrun(&consumer)) {
+                (void)consumer_skip_to_latest(&consumer);
+                report_gap(c);
+            }
+            idle();
+            continue;
+        }
+
+        /* Validate a copy; it only counts if the span was intact */
+        stress_consumer_t trial = *c;
+        for (size_t i = 0; i < na; i++) {
+            check_sample(&trial, &a[i].sample);
+        }
+        for (size_t i = 0; i < nb; i++) {
+            check_sample(&trial, &b[i].sample);
+        }
+        if (consumer_commit(&consumer, n)) {
+            *c = trial;
+        } else {
+            (void)consumer_skip_to_latest(&consumer);
+            report_gap(c);
+        }
+    }
+}
+
+static void run_next(stress_consumer_t *c) {
+    stream_consumer_t consumer;
+    stream_sample_t out;
+
+    consumer_init(&consumer, &s_stream);
+    wait_start();
+
+    while (running()) {
+        if (consumer_next(&consumer, &out)) {
+            check_sample(c, &out);
+        } else if (consumer_is_overrun(&consumer)) {
+            (void)consumer_skip_to_latest(&consumer);
+            report_gap(c);
+        } else {
+            idle();
+        }
+    }
+}
+
+static void *consumer_main(void *arg) {
+    stress_consumer_t *c = arg;
+    switch (c->kind) {
+    case KIND_HARD_RT:     run_hard_rt(c);     break;
+    case KIND_BEST_EFFORT: run_best_effort(c); break;
+    case KIND_SPAN:        run_span(c);        break;
+    case KIND_NEXT:        run_next(c);        break;
+    case KIND_COUNT:       break;
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Runs
+ * ============================================================================ */
+
+typedef struct {
+    double push_per_s;
+    double read_per_s[KIND_COUNT];
+    unsigned kinds[KIND_COUNT];
+    uint64_t torn;
+    uint64_t order;
+    uint64_t lost;
+    uint64_t reported;
+} stress_result_t;
+
+static bool run_once(unsigned consumers, stress_result_t *r) {
+    static stress_consumer_t cs[STRESS_MAX_CONSUMERS];
+    pthread_t threads[STRESS_MAX_CONSUMERS];
+
+    stream_init(&s_stream, s_ring, s_cfg.capacity);
+    atomic_store(&s_start, false);
+    atomic_store(&s_stop, false);
+
+    for (unsigned i = 0; i < consumers; i++) {
+        memset(&cs[i], 0, sizeof(cs[i]));
+        cs[i].kind = (consumer_kind_t)(i % KIND_COUNT);
+        if (pthread_create(&threads[i], NULL, consumer_main, &cs[i]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            return false;
+        }
+    }
+
+    /* Producer: this thread, as fast as it can for the run time */
+    int64_t t0 = now_ns();
+    int64_t end = t0 + (int64_t)(s_cfg.seconds * 1e9);
+    atomic_store_explicit(&s_start, true, memory_order_release);
+    uint32_t seq = 0;
+    int64_t t1 = t0;
+    while (t1 < end) {
+        for (int i = 0; i < STRESS_BATCH; i++) {
+            (void)stream_push(&s_stream, seq_sample(seq));
+            seq++;
+        }
+        sched_yield();
+        t1 = now_ns();
+    }
+    atomic_store_explicit(&s_stop, true, memory_order_release);
+
+    memset(r, 0, sizeof(*r));
+    double secs = (double)(t1 - t0) / 1e9;
+    r->push_per_s = (double)seq / secs;
+    for (unsigned i = 0; i < consumers; i++) {
+        pthread_join(threads[i], NULL);
+        r->read_per_s[cs[i].kind] += (double)cs[i].read / secs;
+        r->kinds[cs[i].kind]++;
+        r->torn += cs[i].torn;
+        r->order += cs[i].order;
+        r->lost += cs[i].lost;
+        r->reported += cs[i].reported;
+    }
+    return true;
+}
+
+static bool parse_args(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *v = argv[++i];
+        if (strcmp(argv[i - 1], "--seconds") == 0) {
+            s_cfg.seconds = atof(v);
+        } else if (strcmp(argv[i - 1], "--consumers") == 0) {
+            s_cfg.consumers = (unsigned)strtoul(v, NULL, 10);
+        } else if (strcmp(argv[i - 1], "--capacity") == 0) {
+            s_cfg.capacity = (size_t)strtoul(v, NULL, 10);
+        } else {
+            return false;
+        }
+    }
+    bool pow2 = s_cfg.capacity >= 2U && (s_cfg.capacity & (s_cfg.capacity - 1U)) == 0;
+    return s_cfg.seconds > 0.0 && s_cfg.consumers >= 1U &&
+           s_cfg.consumers <= STRESS_MAX_CONSUMERS && pow2 &&
+           s_cfg.capacity <= STRESS_MAX_CAPACITY;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        fprintf(stderr, "usage: stream_stress [--seconds S] [--consumers 1-%u] "
+                        "[--capacity POW2<=%u]\n",
+                STRESS_MAX_CONSUMERS, STRESS_MAX_CAPACITY);
+        return 2;
+    }
+
+    printf("capacity %zu, %.2f s per run, Msamples/s per consumer\n",
+           s_cfg.capacity, s_cfg.seconds);
+    printf("%-3s %9s", "N", "push");
+    for (int k = 0; k < KIND_COUNT; k++) {
+        printf(" %11s", k_kind_names[k]);
+    }
+    printf(" %9s %5s %5s %5s\n", "gaps", "torn", "order", "lost");
+
+    bool ok = true;
+    for (unsigned n = 1; n <= s_cfg.consumers; n++) {
+        stress_result_t r;
+        if (!run_once(n, &r)) {
+            return 2;
+        }
+        printf("%-3u %9.2f", n, r.push_per_s / 1e6);
+        for (int k = 0; k < KIND_COUNT; k++) {
+            if (r.kinds[k] > 0) {
+                printf(" %11.2f", r.read_per_s[k] / 1e6 / (double)r.kinds[k]);
+            } else {
+                printf(" %11s", "-");
+            }
+        }
+        printf(" %9llu %5llu %5llu %5llu\n", (unsigned long long)r.reported,
+               (unsigned long long)r.torn, (unsigned long long)r.order,
+               (unsigned long long)r.lost);
+        if (r.torn != 0 || r.order != 0 || r.lost != 0) {
+            ok = false;
+        }
+    }
+
+    printf("%s\n", ok ? "PASS" : "FAIL: torn, out of order or unreported loss");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,406 @@
+/**
+ * @file sim_cwnet.c
+ * @brief CWNet end-to-end latency simulator (host)
+ *
+ * Runs two real cwnet_client instances (sender and listener keyer) against
+ * a simulated server on a virtual 1 ms clock. The server is two
+ * cwnet_peer sessions (WELCOME, PING REQUEST/RESPONSE_2) plus a relay that
+ * echoes the sender's CW events to the listener with their server
+ * timestamps, as the real server does. The listener maps them to its clock
+ * and plays them through cwnet_jitter_t exactly like cwnet_socket.c.
+ *
+ * Every link is a TCP byte stream: each send() is delivered after
+ *   delay + uniform(0, jitter) ms, plus an RTO if the segment was "lost",
+ * and never before the segment sent ahead of it (head-of-line blocking).
+ *
+ * For each WPM the sender keys "PARIS " for the run time and the tool
+ * reports, in ms:
+ *   edge->play  sender edge to listener playout (true time)
+ *   elem err    |played - sent| length of each element and gap
+ * at p50/p95/p99/max, plus late events and the final playout margin.
+ *
+ * Usage:
+ *   sim_cwnet [--delay MS] [--jitter MS] [--loss PCT] [--rto MS]
+ *             [--seconds S] [--seed N] [--wpm W[,W...]]
+ *
+ * Deterministic for a given seed, so buffer policy changes can be compared
+ * run to run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_stubs.h"
+#include "cwnet_client.h"
+#include "cwnet_peer.h"
+#include "cwnet_jitter.h"
+
+#define SIM_LINK_SLOTS      512     /* Segments in flight per link */
+#define SIM_SEG_MAX         128     /* Largest segment (CONNECT is 94 bytes) */
+#define SIM_MAX_EDGES       8192    /* Sent/played edges per run */
+#define SIM_MAX_WPM         8
+
+/* Unrelated clocks: nobody shares an epoch with the server */
+#define SIM_SERVER_OFFSET   1000000
+#define SIM_SENDER_OFFSET   12345
+#define SIM_LISTENER_OFFSET 777
+
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+static struct {
+    int32_t delay_ms;
+    int32_t jitter_ms;
+    uint32_t loss_pct;
+    int32_t rto_ms;
+    int32_t seconds;
+    uint32_t seed;
+    uint32_t wpm[SIM_MAX_WPM];
+    size_t wpm_count;
+} s_cfg = {
+    .delay_ms = 20,
+    .jitter_ms = 10,
+    .loss_pct = 0,
+    .rto_ms = 200,
+    .seconds = 60,
+    .seed = 1,
+    .wpm = {15, 25, 35},
+    .wpm_count = 3,
+};
+
+/** Virtual true time, ms */
+static int32_t s_now;
+
+static uint32_t s_rng;
+
+static uint32_t rng_next(void) {
+    /* xorshift32: deterministic across hosts */
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+/* ============================================================================
+ * Simulated TCP Links
+ * ============================================================================ */
+
+typedef struct {
+    uint8_t data[SIM_SEG_MAX];
+    size_t len;
+    int32_t due;
+} sim_seg_t;
+
+typedef struct {
+    sim_seg_t segs[SIM_LINK_SLOTS];
+    uint32_t head;
+    uint32_t tail;
+    int32_t last_due;   /* In-order delivery */
+} sim_link_t;
+
+static int link_send(sim_link_t *link, const uint8_t *data, size_t len) {
+    if (len > SIM_SEG_MAX || link->head - link->tail == SIM_LINK_SLOTS) {
+        return -1;
+    }
+
+    int32_t due = s_now + s_cfg.delay_ms;
+    if (s_cfg.jitter_ms > 0) {
+        due += (int32_t)(rng_next() % (uint32_t)(s_cfg.jitter_ms + 1));
+    }
+    if (s_cfg.loss_pct > 0 && rng_next() % 100U < s_cfg.loss_pct) {
+        due += s_cfg.rto_ms;    /* Retransmitted after one RTO */
+    }
+    if (due < link->last_due) {
+        due = link->last_due;   /* TCP never reorders */
+    }
+    link->last_due = due;
+
+    sim_seg_t *seg = &link->segs[link->head % SIM_LINK_SLOTS];
+    memcpy(seg->data, data, len);
+    seg->len = len;
+    seg->due = due;
+    link->head++;
+    return (int)len;
+}
+
+/** Take the next segment that has arrived */
+static const sim_seg_t *link_recv(sim_link_t *link) {
+    if (link->head == link->tail) {
+        return NULL;
+    }
+    const sim_seg_t *seg = &link->segs[link->tail % SIM_LINK_SLOTS];
+    if (seg->due > s_now) {
+        return NULL;
+    }
+    link->tail++;
+    return seg;
+}
+
+/* ============================================================================
+ * Nodes
+ * ============================================================================ */
+
+typedef struct {
+    int32_t offset;     /* Local clock = true time + offset */
+    sim_link_t *out;    /* Link this node sends on */
+} sim_node_t;
+
+static sim_link_t s_tx_to_srv, s_srv_to_tx, s_rx_to_srv, s_srv_to_rx;
+
+static sim_node_t s_sender = { SIM_SENDER_OFFSET, &s_tx_to_srv };
+static sim_node_t s_listener = { SIM_LISTENER_OFFSET, &s_rx_to_srv };
+static sim_node_t s_srv_tx = { SIM_SERVER_OFFSET, &s_srv_to_tx };
+static sim_node_t s_srv_rx = { SIM_SERVER_OFFSET, &s_srv_to_rx };
+
+static cwnet_client_t s_tx_client, s_rx_client;
+static cwnet_peer_t s_tx_session, s_rx_session;
+static cwnet_jitter_t s_jitter;
+
+static int node_send(const uint8_t *data, size_t len, void *user_data) {
+    return link_send(((sim_node_t *)user_data)->out, data, len);
+}
+
+static int32_t node_time(void *user_data) {
+    return s_now + ((sim_node_t *)user_data)->offset;
+}
+
+/** Server relay: sender's event goes to the listener with its server stamp */
+static void server_relay(bool key_down, int32_t timestamp_ms, void *user_data) {
+    (void)user_data;
+    (void)cwnet_peer_send_key_event_at(&s_rx_session, key_down, timestamp_ms);
+}
+
+/** Listener receive path, as in cwnet_socket.c cw_event_cb() */
+static void listener_event(bool key_down, int32_t timestamp_ms, void *user_data) {
+    (void)user_data;
+    int32_t event_ms = cwnet_timer_server_to_local_ms(&s_rx_client.timer, timestamp_ms);
+    cwnet_jitter_seed_rtt(&s_jitter, cwnet_client_get_latency_ms(&s_rx_client));
+    (void)cwnet_jitter_push(&s_jitter, key_down, event_ms, node_time(&s_listener));
+}
+
+static void setup_nodes(void) {
+    memset(&s_tx_to_srv, 0, sizeof(s_tx_to_srv));
+    memset(&s_srv_to_tx, 0, sizeof(s_srv_to_tx));
+    memset(&s_rx_to_srv, 0, sizeof(s_rx_to_srv));
+    memset(&s_srv_to_rx, 0, sizeof(s_srv_to_rx));
+
+    cwnet_client_config_t tx_cfg = {
+        .server_host = "sim", .server_port = 7373, .username = "TX",
+        .send_cb = node_send, .get_time_ms_cb = node_time, .user_data = &s_sender,
+    };
+    cwnet_client_config_t rx_cfg = tx_cfg;
+    rx_cfg.username = "RX";
+    rx_cfg.cw_event_cb = listener_event;
+    rx_cfg.user_data = &s_listener;
+    cwnet_client_init(&s_tx_client, &tx_cfg);
+    cwnet_client_init(&s_rx_client, &rx_cfg);
+
+    cwnet_peer_config_t tx_srv = {
+        .send_cb = node_send, .get_time_ms_cb = node_time,
+        .cw_event_cb = server_relay, .user_data = &s_srv_tx,
+    };
+    cwnet_peer_config_t rx_srv = {
+        .send_cb = node_send, .get_time_ms_cb = node_time, .user_data = &s_srv_rx,
+    };
+    cwnet_peer_init(&s_tx_session, &tx_srv);
+    cwnet_peer_init(&s_rx_session, &rx_srv);
+    cwnet_jitter_init(&s_jitter);
+
+    cwnet_peer_on_accepted(&s_tx_session);
+    cwnet_peer_on_accepted(&s_rx_session);
+    cwnet_client_on_connected(&s_tx_client);
+    cwnet_client_on_connected(&s_rx_client);
+}
+
+/** Deliver every segment that has arrived */
+static void deliver(void) {
+    const sim_seg_t *seg;
+    while ((seg = link_recv(&s_tx_to_srv)) != NULL) {
+        cwnet_peer_on_data(&s_tx_session, seg->data, seg->len);
+    }
+    while ((seg = link_recv(&s_rx_to_srv)) != NULL) {
+        cwnet_peer_on_data(&s_rx_session, seg->data, seg->len);
+    }
+    while ((seg = link_recv(&s_srv_to_tx)) != NULL) {
+        cwnet_client_on_data(&s_tx_client, seg->data, seg->len);
+    }
+    while ((seg = link_recv(&s_srv_to_rx)) != NULL) {
+        cwnet_client_on_data(&s_rx_client, seg->data, seg->len);
+    }
+}
+
+/* ============================================================================
+ * Keying Pattern
+ * ============================================================================ */
+
+/** Key levels of "PARIS " in dit units: edge times relative to start */
+static const char *const s_paris[] = { ".--.", ".-", ".-.", "..", "..." };
+
+typedef struct {
+    int32_t t[SIM_MAX_EDGES];   /* True time of each edge */
+    size_t count;
+} sim_edges_t;
+
+static sim_edges_t s_sent, s_played;
+
+/** Build the edge schedule for the run: 50 dit units per "PARIS " */
+static void build_schedule(uint32_t wpm, int32_t start, int32_t end) {
+    int32_t dit = (int32_t)(1200U / wpm);
+    int32_t t = start;
+
+    s_sent.count = 0;
+    while (t < end) {
+        for (size_t c = 0; c < sizeof(s_paris) / sizeof(s_paris[0]); c++) {
+            for (const char *e = s_paris[c]; *e != '\0'; e++) {
+                if (s_sent.count + 2 > SIM_MAX_EDGES) {
+                    return;
+                }
+                s_sent.t[s_sent.count++] = t;
+                t += (*e == '-') ? 3 * dit : dit;
+                s_sent.t[s_sent.count++] = t;
+                t += dit;
+            }
+            t += 2 * dit;               /* Letter gap: 3 units total */
+        }
+        t += 4 * dit;                   /* Word gap: 7 units total */
+    }
+}
+
+/* ============================================================================
+ * Statistics
+ * ============================================================================ */
+
+static int cmp_i32(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int32_t s_work[SIM_MAX_EDGES];
+
+static int32_t pct(const int32_t *sorted, size_t n, uint32_t p) {
+    if (n == 0) {
+        return -1;
+    }
+    size_t idx = (n * p) / 100U;
+    return sorted[idx < n ? idx : n - 1];
+}
+
+static void print_dist(const char *label, size_t n) {
+    qsort(s_work, n, sizeof(s_work[0]), cmp_i32);
+    printf("  %-11s p50 %4ld  p95 %4ld  p99 %4ld  max %4ld\n", label,
+           (long)pct(s_work, n, 50), (long)pct(s_work, n, 95),
+           (long)pct(s_work, n, 99), (long)(n > 0 ? s_work[n - 1] : -1));
+}
+
+/* ============================================================================
+ * Run
+ * ============================================================================ */
+
+static void run_wpm(uint32_t wpm) {
+    const int32_t warmup_ms = 3000;     /* Handshake + first PINGs */
+    int32_t end = warmup_ms + s_cfg.seconds * 1000;
+
+    s_now = 0;
+    s_rng = s_cfg.seed;
+    s_played.count = 0;
+    setup_nodes();
+    build_schedule(wpm, warmup_ms, end);
+
+    size_t next_edge = 0;
+    for (; s_now < end + 2000; s_now++) {
+        esp_timer_set_time((int64_t)s_now * 1000LL);
+
+        deliver();
+        (void)cwnet_peer_poll(&s_tx_session);
+        (void)cwnet_peer_poll(&s_rx_session);
+
+        while (next_edge < s_sent.count && s_sent.t[next_edge] <= s_now) {
+            bool down = (next_edge % 2U) == 0;
+            (void)cwnet_client_send_key_event_at(&s_tx_client, down,
+                                                 s_sent.t[next_edge] + s_sender.offset);
+            next_edge++;
+        }
+
+        cwnet_jitter_event_t ev;
+        while (cwnet_jitter_pop(&s_jitter, node_time(&s_listener), &ev)) {
+            if (s_played.count < SIM_MAX_EDGES) {
+                s_played.t[s_played.count++] = ev.play_ms - s_listener.offset;
+            }
+        }
+    }
+
+    size_t n = (s_played.count < s_sent.count) ? s_played.count : s_sent.count;
+    printf("%lu WPM (dit %lu ms): %lu edges sent, %lu played, %lu late, margin %ld ms, rtt %ld ms\n",
+           (unsigned long)wpm, (unsigned long)(1200U / wpm),
+           (unsigned long)s_sent.count, (unsigned long)s_played.count,
+           (unsigned long)s_jitter.late, (long)cwnet_jitter_margin_ms(&s_jitter),
+           (long)cwnet_client_get_latency_ms(&s_rx_client));
+
+    for (size_t i = 0; i < n; i++) {
+        s_work[i] = s_played.t[i] - s_sent.t[i];
+    }
+    print_dist("edge->play", n);
+
+    size_t m = 0;
+    for (size_t i = 1; i < n; i++) {
+        int32_t err = (s_played.t[i] - s_played.t[i - 1]) - (s_sent.t[i] - s_sent.t[i - 1]);
+        s_work[m++] = err < 0 ? -err : err;
+    }
+    print_dist("elem err", m);
+}
+
+static void parse_wpm(const char *arg) {
+    s_cfg.wpm_count = 0;
+    while (*arg != '\0' && s_cfg.wpm_count < SIM_MAX_WPM) {
+        char *end;
+        unsigned long w = strtoul(arg, &end, 10);
+        if (end == arg) {
+            break;
+        }
+        if (w >= 5 && w <= 60) {
+            s_cfg.wpm[s_cfg.wpm_count++] = (uint32_t)w;
+        }
+        arg = (*end == ',') ? end + 1 : end;
+    }
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (v != NULL && strcmp(argv[i], "--delay") == 0) {
+            s_cfg.delay_ms = (int32_t)atoi(v);
+        } else if (v != NULL && strcmp(argv[i], "--jitter") == 0) {
+            s_cfg.jitter_ms = (int32_t)atoi(v);
+        } else if (v != NULL && strcmp(argv[i], "--loss") == 0) {
+            s_cfg.loss_pct = (uint32_t)atoi(v);
+        } else if (v != NULL && strcmp(argv[i], "--rto") == 0) {
+            s_cfg.rto_ms = (int32_t)atoi(v);
+        } else if (v != NULL && strcmp(argv[i], "--seconds") == 0) {
+            s_cfg.seconds = (int32_t)atoi(v);
+        } else if (v != NULL && strcmp(argv[i], "--seed") == 0) {
+            s_cfg.seed = (uint32_t)strtoul(v, NULL, 10);
+        } else if (v != NULL && strcmp(argv[i], "--wpm") == 0) {
+            parse_wpm(v);
+        } else {
+            fprintf(stderr, "usage: %s [--delay MS] [--jitter MS] [--loss PCT] [--rto MS]\n"
+                            "       [--seconds S] [--seed N] [--wpm W[,W...]]\n", argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if (s_cfg.seed == 0) {
+        s_cfg.seed = 1;     /* xorshift needs a non-zero state */
+    }
+
+    printf("link: delay %ld ms, jitter 0..%ld ms, loss %lu%% (rto %ld ms), %ld s per run\n\n",
+           (long)s_cfg.delay_ms, (long)s_cfg.jitter_ms, (unsigned long)s_cfg.loss_pct,
+           (long)s_cfg.rto_ms, (long)s_cfg.seconds);
+    for (size_t i = 0; i < s_cfg.wpm_count; i++) {
+        run_wpm(s_cfg.wpm[i]);
+        printf("\n");
+    }
+    return 0;
+}
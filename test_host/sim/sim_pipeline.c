@@ -0,0 +1,749 @@
+/**
+ * @file sim_pipeline.c
+ * @brief Full keying pipeline simulator on a virtual clock (host)
+ *
+ * Links the real components the keyer runs, in the order it runs them:
+ *
+ *   operator -> paddle edges -> iambic FSM -> stream      (RT task, every tick)
+ *   stream -> key edge stage -> decoder                   (bg task, --bg-ms)
+ *   stream -> timed consumer -> cwnet_client              (CWNet task, --cwnet-ms)
+ *   cwnet_client -> link (--delay) -> cwnet_peer "server" (records events)
+ *
+ * esp_timer_get_time() is the virtual clock, stepped one tick at a time,
+ * so a minute of keying runs in milliseconds and every run is identical.
+ *
+ * Scripted runs key --text once per --wpm: a simulated operator presses
+ * the paddle of each element (ISR edge at its own µs time, as the RT task
+ * replays them), lets go half a dit into it and waits the letter or word
+ * gap before the next press. A recording (--cwk FILE, with FILE.txt as
+ * the sent text) instead replays the key level it carries, so the FSM is
+ * only in the loop for scripts.
+ *
+ * Reported per run:
+ *   CER          decoded vs sent text (edit distance / sent characters)
+ *   press->key   paddle edge to key down, µs
+ *   key err      |keyed - ideal| element and gap length, µs (scripts)
+ *   net err      |at server - keyed| element and gap length, ms
+ *   key->server  key edge to arrival at the server, ms
+ *   key->decode  last key up of a character to the decoder emitting it, ms
+ *
+ * Exits 1 when any run exceeds --max-cer, --max-net-err or --max-latency
+ * (key->server p99): the regression gate for pipeline changes.
+ *
+ * Usage:
+ *   sim_pipeline [--text STR] [--wpm W[,W...]] [--cwk FILE] [--delay MS]
+ *                [--bg-ms MS] [--cwnet-ms MS] [--timing ema|cluster]
+ *                [--max-cer PCT] [--max-net-err MS] [--max-latency MS] [-v]
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_stubs.h"
+#include "stream.h"
+#include "stream_export.h"
+#include "consumer.h"
+#include "key_edge.h"
+#include "decoder.h"
+#include "cwk_util.h"
+#include "morse_table.h"
+#include "iambic.h"
+#include "paddle_edge.h"
+#include "cwnet_client.h"
+#include "cwnet_peer.h"
+
+#define SIM_TICK_US         1000
+#define SIM_STREAM_CAP      4096
+#define SIM_MAX_ELEMS       8192    /* Script elements per run */
+#define SIM_MAX_EDGES       (2 * SIM_MAX_ELEMS)
+#define SIM_TEXT_MAX        4096
+#define SIM_MAX_WPM         8
+#define SIM_LINK_SLOTS      1024
+#define SIM_SEG_MAX         128
+
+#define SIM_START_US        1000000     /* Keyer uptime when the run starts */
+#define SIM_WARMUP_US       3000000     /* Handshake + first PINGs */
+#define SIM_TAIL_US         3000000     /* Idle after the text: flush the last word */
+#define SIM_SERVER_OFFSET   1000000     /* Server clock = keyer clock + offset (ms) */
+
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+static struct {
+    const char *text;
+    const char *cwk;
+    uint32_t wpm[SIM_MAX_WPM];
+    size_t wpm_count;
+    int32_t delay_ms;
+    int32_t bg_ms;
+    int32_t cwnet_ms;
+    timing_mode_t timing;
+    double max_cer;
+    int32_t max_net_err_ms;
+    int32_t max_latency_ms;
+    bool verbose;
+} s_cfg = {
+    .text = "CQ CQ TEST DE IU3QEZ IU3QEZ K PARIS 5NN TU 73",
+    .cwk = NULL,
+    .wpm = {15, 25, 35},
+    .wpm_count = 3,
+    .delay_ms = 5,
+    .bg_ms = 10,        /* bg_task poll period */
+    .cwnet_ms = 1,      /* CWNET_POLL_MS */
+    .timing = TIMING_MODE_EMA,
+    .max_cer = 0.0,
+    .max_net_err_ms = 2,
+    .max_latency_ms = 20,
+    .verbose = false,
+};
+
+/** Virtual true time (keyer esp_timer base), µs */
+static int64_t s_now_us;
+
+static int32_t now_ms(void) {
+    return (int32_t)(s_now_us / 1000);
+}
+
+/* ============================================================================
+ * Network: keyer client -> server peer over a fixed-delay TCP link
+ * ============================================================================ */
+
+typedef struct {
+    uint8_t data[SIM_SEG_MAX];
+    size_t len;
+    int32_t due;
+} sim_seg_t;
+
+typedef struct {
+    sim_seg_t segs[SIM_LINK_SLOTS];
+    uint32_t head;
+    uint32_t tail;
+} sim_link_t;
+
+static sim_link_t s_up, s_down;
+static cwnet_client_t s_client;
+static cwnet_peer_t s_server;
+
+typedef struct {
+    int32_t offset;     /* Node clock = keyer clock + offset, ms */
+    sim_link_t *out;
+} sim_node_t;
+
+static sim_node_t s_keyer_node = { 0, &s_up };
+static sim_node_t s_server_node = { SIM_SERVER_OFFSET, &s_down };
+
+static int node_send(const uint8_t *data, size_t len, void *user_data) {
+    sim_link_t *link = ((sim_node_t *)user_data)->out;
+    if (len > SIM_SEG_MAX || link->head - link->tail == SIM_LINK_SLOTS) {
+        return -1;
+    }
+    sim_seg_t *seg = &link->segs[link->head % SIM_LINK_SLOTS];
+    memcpy(seg->data, data, len);
+    seg->len = len;
+    seg->due = now_ms() + s_cfg.delay_ms;   /* Fixed delay keeps TCP order */
+    link->head++;
+    return (int)len;
+}
+
+static int32_t node_time(void *user_data) {
+    return now_ms() + ((sim_node_t *)user_data)->offset;
+}
+
+static const sim_seg_t *link_recv(sim_link_t *link) {
+    if (link->head == link->tail) {
+        return NULL;
+    }
+    const sim_seg_t *seg = &link->segs[link->tail % SIM_LINK_SLOTS];
+    if (seg->due > now_ms()) {
+        return NULL;
+    }
+    link->tail++;
+    return seg;
+}
+
+/* ============================================================================
+ * Pipeline
+ * ============================================================================ */
+
+static stream_slot_t s_buffer[SIM_STREAM_CAP];
+static keying_stream_t s_stream;
+static key_edge_ring_t s_ring;
+static key_edge_stage_t s_stage;
+static decoder_t s_decoder;
+static timed_consumer_t s_cwnet_edges;
+static iambic_processor_t s_iambic;
+static paddle_edge_queue_t s_paddle_edges;
+
+/** Edge times, true time */
+typedef struct {
+    int64_t t[SIM_MAX_EDGES];
+    size_t count;
+} sim_edges_t;
+
+static sim_edges_t s_keyed;     /* Key edges at the FSM, µs */
+static sim_edges_t s_server_ts; /* Event timestamps at the server, keyer ms */
+static sim_edges_t s_arrival;   /* Event arrival at the server, keyer ms */
+
+static char s_decoded[SIM_TEXT_MAX];
+static size_t s_decoded_len;
+static int64_t s_decoded_us[SIM_TEXT_MAX];   /* When each character came out */
+
+static void record(sim_edges_t *e, int64_t t) {
+    if (e->count < SIM_MAX_EDGES) {
+        e->t[e->count++] = t;
+    }
+}
+
+/** Server side: the event in the server clock maps back to the keyer's */
+static void server_event(bool key_down, int32_t timestamp_ms, void *user_data) {
+    (void)key_down;
+    (void)user_data;
+    record(&s_server_ts, (int64_t)timestamp_ms - SIM_SERVER_OFFSET);
+    record(&s_arrival, now_ms());
+}
+
+static void setup_pipeline(uint32_t tick_us) {
+    s_now_us = SIM_START_US;
+    esp_timer_set_time(s_now_us);
+
+    stream_init(&s_stream, s_buffer, SIM_STREAM_CAP);
+    stream_set_tick_period_us(&s_stream, tick_us);
+    stream_set_epoch_us(&s_stream, SIM_START_US);
+    key_edge_ring_init(&s_ring, &s_stream);
+    key_edge_stage_init(&s_stage, &s_stream, &s_ring);
+    decoder_inst_init(&s_decoder, &s_ring, DECODER_SOURCE_ANY);
+    decoder_inst_set_timing_mode(&s_decoder, s_cfg.timing);
+    timed_consumer_init(&s_cwnet_edges, &s_stream, 0);
+    paddle_edge_queue_init(&s_paddle_edges);
+
+    memset(&s_up, 0, sizeof(s_up));
+    memset(&s_down, 0, sizeof(s_down));
+    cwnet_client_config_t client_cfg = {
+        .server_host = "sim", .server_port = 7373, .username = "SIM",
+        .send_cb = node_send, .get_time_ms_cb = node_time, .user_data = &s_keyer_node,
+    };
+    cwnet_peer_config_t server_cfg = {
+        .send_cb = node_send, .get_time_ms_cb = node_time,
+        .cw_event_cb = server_event, .user_data = &s_server_node,
+    };
+    cwnet_client_init(&s_client, &client_cfg);
+    cwnet_peer_init(&s_server, &server_cfg);
+    cwnet_peer_on_accepted(&s_server);
+    cwnet_client_on_connected(&s_client);
+
+    s_keyed.count = 0;
+    s_server_ts.count = 0;
+    s_arrival.count = 0;
+    s_decoded_len = 0;
+    s_decoded[0] = '\0';
+}
+
+/** bg task: key edge stage, then the decoder */
+static void bg_step(void) {
+    key_edge_stage_run(&s_stage);
+    decoder_inst_process(&s_decoder);
+    decoded_char_t ch;
+    while ((ch = decoder_inst_pop_char(&s_decoder)).character != '\0') {
+        if (s_decoded_len + 1U < SIM_TEXT_MAX) {
+            s_decoded_us[s_decoded_len] = s_now_us;
+            s_decoded[s_decoded_len++] = ch.character;
+        }
+    }
+    s_decoded[s_decoded_len] = '\0';
+}
+
+/** CWNet task: forward LOCAL key edges stamped with their tick, as cwnet_socket.c */
+static void cwnet_step(void) {
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+
+    size_t n;
+    while ((n = timed_consumer_next_span(&s_cwnet_edges, &a, &na, &b, &nb, SIZE_MAX)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            const stream_sample_t *s = (i < na) ? &a[i].sample : &b[i - na].sample;
+            uint64_t tick = timed_consumer_step(&s_cwnet_edges, s);
+            if (sample_is_silence(s) || sample_lane(s) != STREAM_LANE_LOCAL ||
+                !sample_has_local_edge(s)) {
+                continue;
+            }
+            int64_t event_us = timed_consumer_time_us(&s_cwnet_edges, tick);
+            (void)cwnet_client_send_key_event_at(&s_client, s->local_key != 0,
+                                                 (int32_t)(event_us / 1000));
+        }
+        (void)timed_consumer_commit(&s_cwnet_edges, n);
+    }
+}
+
+/** Network and both task loops for the tick just pushed */
+static void service(uint64_t tick) {
+    const sim_seg_t *seg;
+    while ((seg = link_recv(&s_up)) != NULL) {
+        cwnet_peer_on_data(&s_server, seg->data, seg->len);
+    }
+    while ((seg = link_recv(&s_down)) != NULL) {
+        cwnet_client_on_data(&s_client, seg->data, seg->len);
+    }
+    (void)cwnet_peer_poll(&s_server);
+
+    uint64_t tick_ms = tick * stream_tick_period_us(&s_stream) / 1000U;
+    uint64_t prev_ms = (tick - 1U) * stream_tick_period_us(&s_stream) / 1000U;
+    if (tick == 0 || tick_ms / (uint64_t)s_cfg.cwnet_ms != prev_ms / (uint64_t)s_cfg.cwnet_ms) {
+        cwnet_step();
+    }
+    if (tick == 0 || tick_ms / (uint64_t)s_cfg.bg_ms != prev_ms / (uint64_t)s_cfg.bg_ms) {
+        bg_step();
+    }
+}
+
+/* ============================================================================
+ * Scripted Operator
+ * ============================================================================ */
+
+typedef struct {
+    bool dah;
+    uint8_t gap_units;  /* Silence before this element, dit units (0 = first) */
+} sim_elem_t;
+
+static sim_elem_t s_script[SIM_MAX_ELEMS];
+static size_t s_script_len;
+static char s_sent[SIM_TEXT_MAX];
+static size_t s_last_elem[SIM_TEXT_MAX];    /* Last element of each sent character */
+static size_t s_sent_chars;                 /* Characters in s_last_elem */
+
+/** Elements of --text; s_sent gets the text the decoder should print */
+static void build_script(const char *text) {
+    bool word_gap = false;
+    s_script_len = 0;
+    s_sent_chars = 0;
+    size_t sent = 0;
+
+    for (const char *p = text; *p != '\0'; p++) {
+        char c = (char)toupper((unsigned char)*p);
+        if (isspace((unsigned char)c)) {
+            word_gap = (s_script_len > 0);
+            continue;
+        }
+        const char *pattern = morse_table_reverse(c);
+        if (pattern == NULL || s_script_len + strlen(pattern) > SIM_MAX_ELEMS ||
+            sent + 3U > SIM_TEXT_MAX) {
+            continue;
+        }
+        if (word_gap && sent > 0) {
+            s_sent[sent++] = ' ';
+        }
+        for (const char *e = pattern; *e != '\0'; e++) {
+            uint8_t gap = 1;
+            if (e == pattern) {
+                gap = (s_script_len == 0) ? 0 : (word_gap ? 7 : 3);
+            }
+            s_script[s_script_len].dah = (*e == '-');
+            s_script[s_script_len].gap_units = gap;
+            s_script_len++;
+        }
+        s_last_elem[s_sent_chars++] = s_script_len - 1U;
+        s_sent[sent++] = c;
+        word_gap = false;
+    }
+    s_sent[sent] = '\0';
+}
+
+typedef struct {
+    size_t next;            /* Next script element to press */
+    bool held;              /* Paddle of element next - 1 is down */
+    bool dah;               /* Which paddle is held */
+    int64_t press_us;       /* Earliest time for the next press */
+    int64_t release_us;     /* Release time of the held paddle */
+    int64_t dit_us;
+    int64_t last_tick_us;
+    size_t pressed;         /* Presses waiting for their key down */
+} sim_operator_t;
+
+static int64_t s_press_us[SIM_MAX_ELEMS];
+
+static void operator_edge(sim_operator_t *op, bool dah, bool down, int64_t at_us) {
+    if (at_us <= op->last_tick_us) {
+        at_us = op->last_tick_us + 1;   /* Edges land after the last FSM step */
+    }
+    paddle_edge_t edge = {
+        .timestamp_us = at_us,
+        .paddle = dah ? PADDLE_EDGE_DAH : PADDLE_EDGE_DIT,
+        .level = down ? 1U : 0U,
+    };
+    (void)paddle_edge_push(&s_paddle_edges, &edge);
+}
+
+/** Paddle edges up to now, returns the polled paddle state */
+static gpio_state_t operator_tick(sim_operator_t *op) {
+    if (op->held && op->release_us <= s_now_us) {
+        operator_edge(op, op->dah, false, op->release_us);
+        op->held = false;
+    }
+    if (!op->held && op->next < s_script_len && op->press_us <= s_now_us) {
+        op->dah = s_script[op->next].dah;
+        operator_edge(op, op->dah, true, op->press_us);
+        s_press_us[op->next] = (op->press_us > op->last_tick_us) ? op->press_us
+                                                                 : op->last_tick_us + 1;
+        op->held = true;
+        op->release_us = INT64_MAX;    /* Until the element starts */
+        op->press_us = INT64_MAX;      /* Until it ends */
+        op->next++;
+    }
+    op->last_tick_us = s_now_us;
+    return op->held ? gpio_from_paddles(!op->dah, op->dah) : GPIO_IDLE;
+}
+
+/** React to the key: let go mid-element, plan the next press after it */
+static void operator_key(sim_operator_t *op, bool down, int64_t edge_us) {
+    if (down) {
+        op->release_us = edge_us + op->dit_us / 2;
+    } else if (op->next < s_script_len) {
+        /* Within a character press during the FSM's own gap; between
+         * characters wait out the whole gap, the FSM starts on the press */
+        uint8_t units = s_script[op->next].gap_units;
+        op->press_us = edge_us + ((units > 1U) ? (int64_t)units * op->dit_us : 0);
+    }
+}
+
+/* ============================================================================
+ * Runs
+ * ============================================================================ */
+
+static void push_tick(stream_sample_t sample, uint64_t tick) {
+    (void)stream_push(&s_stream, sample);
+    service(tick);
+}
+
+/** Key the script through the FSM at one speed */
+static void run_script(uint32_t wpm) {
+    iambic_config_t cfg = IAMBIC_CONFIG_DEFAULT;
+    cfg.wpm = wpm;
+    iambic_init(&s_iambic, &cfg);
+    setup_pipeline(SIM_TICK_US);
+
+    sim_operator_t op = {
+        .press_us = SIM_START_US + SIM_WARMUP_US,
+        .dit_us = iambic_dit_duration_us(&cfg),
+        .last_tick_us = SIM_START_US - SIM_TICK_US,
+    };
+    bool key = false;
+    int64_t idle_since = INT64_MAX;
+
+    for (uint64_t tick = 0;; tick++) {
+        s_now_us = SIM_START_US + (int64_t)tick * SIM_TICK_US;
+        esp_timer_set_time(s_now_us);
+
+        gpio_state_t gpio = operator_tick(&op);
+        stream_sample_t sample = iambic_tick_edges(&s_iambic, s_now_us, gpio, &s_paddle_edges);
+        if ((sample.local_key != 0) != key) {
+            key = (sample.local_key != 0);
+            int64_t edge_us = s_iambic.element_start_us;    /* Element or gap start */
+            record(&s_keyed, edge_us);
+            operator_key(&op, key, edge_us);
+        }
+        push_tick(sample, tick);
+
+        if (op.next == s_script_len && !op.held && !key && idle_since == INT64_MAX) {
+            idle_since = s_now_us;
+        }
+        if (idle_since != INT64_MAX && s_now_us >= idle_since + SIM_TAIL_US) {
+            break;
+        }
+    }
+}
+
+/** Replay the LOCAL key level of a recording, tick by tick */
+static bool run_recording(const uint8_t *data, size_t len) {
+    cwk_header_t h;
+    if (cwk_parse_header(data, len, &h) != NULL) {
+        return false;
+    }
+    setup_pipeline(h.tick_us);
+    s_script_len = 0;
+
+    size_t count = cwk_sample_count(&h, len);
+
+    uint64_t tick = 0;
+    uint64_t warmup_ticks = SIM_WARMUP_US / h.tick_us;
+    stream_sample_t level = STREAM_SAMPLE_EMPTY;
+    bool key = false;
+    for (size_t i = 0; i <= count; i++) {
+        uint32_t ticks = 1;
+        if (i == 0) {
+            ticks = (uint32_t)warmup_ticks;    /* Idle while the link comes up */
+        } else {
+            stream_sample_t s;
+            memcpy(&s, data + h.header_size + (i - 1U) * sizeof(s), sizeof(s));
+            if (sample_lane(&s) != STREAM_LANE_LOCAL) {
+                continue;
+            }
+            if (sample_is_silence(&s)) {
+                ticks = sample_silence_ticks(&s);
+            } else {
+                level = STREAM_SAMPLE_EMPTY;
+                level.gpio = s.gpio;
+                level.local_key = s.local_key;
+                level.audio_level = s.audio_level;
+            }
+        }
+        for (; ticks > 0; ticks--, tick++) {
+            s_now_us = SIM_START_US + (int64_t)(tick * h.tick_us);
+            esp_timer_set_time(s_now_us);
+            if ((level.local_key != 0) != key) {
+                key = (level.local_key != 0);
+                record(&s_keyed, s_now_us);
+            }
+            push_tick(level, tick);
+        }
+    }
+
+    stream_sample_t idle = STREAM_SAMPLE_EMPTY;
+    for (uint64_t end = tick + SIM_TAIL_US / h.tick_us; tick < end; tick++) {
+        s_now_us = SIM_START_US + (int64_t)(tick * h.tick_us);
+        esp_timer_set_time(s_now_us);
+        if (key) {
+            key = false;
+            record(&s_keyed, s_now_us);
+        }
+        push_tick(idle, tick);
+    }
+    return true;
+}
+
+/* ============================================================================
+ * Scoring
+ * ============================================================================ */
+
+static int cmp_i64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int64_t s_work[SIM_MAX_EDGES];
+
+static int64_t pct(size_t n, uint32_t p) {
+    size_t idx = (n * p) / 100U;
+    return s_work[idx < n ? idx : n - 1];
+}
+
+/** Print the distribution in s_work[0..n), return its p99 (-1 if empty) */
+static int64_t print_dist(const char *label, const char *unit, size_t n) {
+    if (n == 0) {
+        printf("  %-12s -\n", label);
+        return -1;
+    }
+    qsort(s_work, n, sizeof(s_work[0]), cmp_i64);
+    printf("  %-12s p50 %6lld  p95 %6lld  p99 %6lld  max %6lld %s\n", label,
+           (long long)pct(n, 50), (long long)pct(n, 95), (long long)pct(n, 99),
+           (long long)s_work[n - 1], unit);
+    return pct(n, 99);
+}
+
+static int64_t abs64(int64_t v) {
+    return v < 0 ? -v : v;
+}
+
+/** Report one run, return true if it is inside the gate limits */
+static bool report(const char *label, char *truth, int64_t dit_us) {
+    size_t n = cwk_normalize(truth);
+    cwk_normalize(s_decoded);
+    size_t errors = cwk_edit_distance(truth, n, s_decoded, strlen(s_decoded));
+    double cer = n ? 100.0 * (double)errors / (double)n : 0.0;
+
+    printf("%s: %zu chars, CER %.1f%%, %zu edges keyed, %zu at server, decoder %lu WPM\n",
+           label, n, cer, s_keyed.count, s_server_ts.count,
+           (unsigned long)decoder_inst_get_wpm(&s_decoder));
+    if (s_cfg.verbose) {
+        printf("  sent:    %s\n  decoded: %s\n", truth, s_decoded);
+    }
+
+    /* Paddle press to key down, for presses the FSM was idle for */
+    size_t m = 0;
+    for (size_t i = 0; i < s_script_len && 2U * i < s_keyed.count; i++) {
+        if (s_script[i].gap_units != 1U) {
+            s_work[m++] = s_keyed.t[2U * i] - s_press_us[i];
+        }
+    }
+    print_dist("press->key", "us", m);
+
+    /* Keyed element and gap lengths against the script */
+    m = 0;
+    for (size_t i = 1; i < s_keyed.count && s_script_len > 0 && i < 2U * s_script_len; i++) {
+        int64_t ideal = (i % 2U == 1U) ? (s_script[i / 2U].dah ? 3 : 1)
+                                        : s_script[i / 2U].gap_units;
+        s_work[m++] = abs64((s_keyed.t[i] - s_keyed.t[i - 1U]) - ideal * dit_us);
+    }
+    print_dist("key err", "us", m);
+
+    /* Lengths as the server sees them */
+    size_t edges = s_keyed.count < s_server_ts.count ? s_keyed.count : s_server_ts.count;
+    m = 0;
+    for (size_t i = 1; i < edges; i++) {
+        int64_t keyed_ms = (s_keyed.t[i] - s_keyed.t[i - 1U]) / 1000;
+        s_work[m++] = abs64((s_server_ts.t[i] - s_server_ts.t[i - 1U]) - keyed_ms);
+    }
+    int64_t net_err = -1;
+    if (m > 0) {
+        print_dist("net err", "ms", m);
+        net_err = s_work[m - 1];
+    } else {
+        print_dist("net err", "ms", 0);
+    }
+
+    for (size_t i = 0; i < edges; i++) {
+        s_work[i] = s_arrival.t[i] - s_keyed.t[i] / 1000;
+    }
+    int64_t latency = print_dist("key->server", "ms", edges);
+
+    /* Character k of the script came out as the k-th decoded letter */
+    m = 0;
+    size_t k = 0;
+    for (size_t i = 0; i < s_decoded_len && k < s_sent_chars; i++) {
+        if (s_decoded[i] == ' ') {
+            continue;
+        }
+        size_t up = 2U * s_last_elem[k] + 1U;
+        if (up < s_keyed.count) {
+            s_work[m++] = (s_decoded_us[i] - s_keyed.t[up]) / 1000;
+        }
+        k++;
+    }
+    print_dist("key->decode", "ms", m);
+
+    bool ok = true;
+    if (cer > s_cfg.max_cer) {
+        printf("  FAIL: CER %.1f%% > %.1f%%\n", cer, s_cfg.max_cer);
+        ok = false;
+    }
+    if (s_server_ts.count != s_keyed.count || net_err > s_cfg.max_net_err_ms) {
+        printf("  FAIL: %zu/%zu edges at server, net err max %lld ms (limit %ld)\n",
+               s_server_ts.count, s_keyed.count, (long long)net_err, (long)s_cfg.max_net_err_ms);
+        ok = false;
+    }
+    if (latency > s_cfg.max_latency_ms) {
+        printf("  FAIL: key->server p99 %lld ms > %ld ms\n", (long long)latency,
+               (long)s_cfg.max_latency_ms);
+        ok = false;
+    }
+    return ok;
+}
+
+static void parse_wpm(const char *arg) {
+    s_cfg.wpm_count = 0;
+    while (*arg != '\0' && s_cfg.wpm_count < SIM_MAX_WPM) {
+        char *end;
+        unsigned long w = strtoul(arg, &end, 10);
+        if (end == arg) {
+            break;
+        }
+        if (w >= 5 && w <= 60) {
+            s_cfg.wpm[s_cfg.wpm_count++] = (uint32_t)w;
+        }
+        arg = (*end == ',') ? end + 1 : end;
+    }
+}
+
+static int usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--text STR] [--wpm W[,W...]] [--cwk FILE] [--delay MS]\n"
+                    "       [--bg-ms MS] [--cwnet-ms MS] [--timing ema|cluster]\n"
+                    "       [--max-cer PCT] [--max-net-err MS] [--max-latency MS] [-v]\n",
+            argv0);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-v") == 0) {
+            s_cfg.verbose = true;
+            continue;
+        }
+        if (v == NULL) {
+            return usage(argv[0]);
+        } else if (strcmp(argv[i], "--text") == 0) {
+            s_cfg.text = v;
+        } else if (strcmp(argv[i], "--wpm") == 0) {
+            parse_wpm(v);
+        } else if (strcmp(argv[i], "--cwk") == 0) {
+            s_cfg.cwk = v;
+        } else if (strcmp(argv[i], "--delay") == 0) {
+            s_cfg.delay_ms = (int32_t)atoi(v);
+        } else if (strcmp(argv[i], "--bg-ms") == 0) {
+            s_cfg.bg_ms = (int32_t)atoi(v);
+        } else if (strcmp(argv[i], "--cwnet-ms") == 0) {
+            s_cfg.cwnet_ms = (int32_t)atoi(v);
+        } else if (strcmp(argv[i], "--timing") == 0) {
+            if (strcmp(v, timing_mode_str(TIMING_MODE_CLUSTER)) == 0) {
+                s_cfg.timing = TIMING_MODE_CLUSTER;
+            } else if (strcmp(v, timing_mode_str(TIMING_MODE_EMA)) == 0) {
+                s_cfg.timing = TIMING_MODE_EMA;
+            } else {
+                return usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "--max-cer") == 0) {
+            s_cfg.max_cer = atof(v);
+        } else if (strcmp(argv[i], "--max-net-err") == 0) {
+            s_cfg.max_net_err_ms = (int32_t)atoi(v);
+        } else if (strcmp(argv[i], "--max-latency") == 0) {
+            s_cfg.max_latency_ms = (int32_t)atoi(v);
+        } else {
+            return usage(argv[0]);
+        }
+        i++;
+    }
+    if (s_cfg.bg_ms < 1 || s_cfg.cwnet_ms < 1 || s_cfg.delay_ms < 0 || s_cfg.wpm_count == 0) {
+        return usage(argv[0]);
+    }
+
+    printf("pipeline: bg every %ld ms, cwnet every %ld ms, link delay %ld ms, %s timing\n\n",
+           (long)s_cfg.bg_ms, (long)s_cfg.cwnet_ms, (long)s_cfg.delay_ms,
+           timing_mode_str(s_cfg.timing));
+
+    bool ok = true;
+    if (s_cfg.cwk != NULL) {
+        size_t len = 0;
+        uint8_t *data = cwk_read_file(s_cfg.cwk, &len);
+        char txt_path[512];
+        snprintf(txt_path, sizeof(txt_path), "%s", s_cfg.cwk);
+        char *dot = strrchr(txt_path, '.');
+        if (dot != NULL) {
+            *dot = '\0';
+        }
+        strncat(txt_path, ".txt", sizeof(txt_path) - strlen(txt_path) - 1U);
+        size_t txt_len = 0;
+        char *truth = (char *)cwk_read_file(txt_path, &txt_len);
+
+        if (data == NULL || truth == NULL || !run_recording(data, len)) {
+            fprintf(stderr, "sim_pipeline: %s: unreadable recording or missing %s\n",
+                    s_cfg.cwk, txt_path);
+            free(data);
+            free(truth);
+            return 2;
+        }
+        s_sent_chars = 0;   /* No script: no per-character decode latency */
+        ok = report(s_cfg.cwk, truth, 0);
+        free(data);
+        free(truth);
+    } else {
+        for (size_t i = 0; i < s_cfg.wpm_count; i++) {
+            iambic_config_t cfg = IAMBIC_CONFIG_DEFAULT;
+            cfg.wpm = s_cfg.wpm[i];
+            build_script(s_cfg.text);
+            run_script(s_cfg.wpm[i]);
+
+            char label[32];
+            snprintf(label, sizeof(label), "%lu WPM", (unsigned long)s_cfg.wpm[i]);
+            ok &= report(label, s_sent, iambic_dit_duration_us(&cfg));
+            printf("\n");
+        }
+    }
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file test_asset_pack.c
+ * @brief Tests for the webui partition image parser
+ */
+
+#include "unity.h"
+#include "asset_pack.h"
+#include <string.h>
+
+static uint8_t s_image[256];
+
+static void wr16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void wr32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void put_entry(uint16_t i, uint32_t path, uint32_t type, uint32_t data,
+                      uint32_t len, uint32_t br, uint32_t br_len,
+                      const char *etag, uint8_t flags) {
+    uint8_t *e = s_image + ASSET_PACK_HEADER_SIZE + i * ASSET_PACK_ENTRY_SIZE;
+    wr32(e, path);
+    wr32(e + 4, type);
+    wr32(e + 8, data);
+    wr32(e + 12, len);
+    wr32(e + 16, br);
+    wr32(e + 20, br_len);
+    strcpy((char *)e + 24, etag);
+    e[24 + ASSET_PACK_ETAG_LEN] = flags;
+}
+
+/* Two entries as embed_assets.py --pack lays them out */
+static uint32_t build_image(void) {
+    memset(s_image, 0, sizeof(s_image));
+    const uint32_t strings = ASSET_PACK_HEADER_SIZE + 2 * ASSET_PACK_ENTRY_SIZE;   /* 112 */
+    static const char names[] = "/index.html\0text/html\0/assets/app-Ab12Cd34.js\0"
+                                "application/javascript";
+    memcpy(s_image + strings, names, sizeof(names));
+    memcpy(s_image + 184, "\x1f\x8b" "html", 6);
+    memcpy(s_image + 192, "\x1f\x8b" "script", 8);
+    memcpy(s_image + 200, "br", 2);
+    put_entry(0, strings, strings + 12, 184, 6, 0, 0,
+              "\"0123456789abcdef\"", ASSET_PACK_F_GZIP);
+    put_entry(1, strings + 22, strings + 46, 192, 8, 200, 2,
+              "\"fedcba9876543210\"", ASSET_PACK_F_GZIP | ASSET_PACK_F_IMMUTABLE);
+
+    wr32(s_image, ASSET_PACK_MAGIC);
+    wr16(s_image + 4, ASSET_PACK_VERSION);
+    wr16(s_image + 6, 2);
+    wr32(s_image + 8, 204);
+    return 204;
+}
+
+void test_asset_pack_find(void) {
+    uint32_t len = build_image();
+    TEST_ASSERT_EQUAL_UINT32(len, asset_pack_image_len(s_image));
+
+    asset_pack_t pack;
+    TEST_ASSERT_TRUE(asset_pack_open(&pack, s_image, sizeof(s_image)));
+    TEST_ASSERT_EQUAL(2, pack.count);
+
+    webui_asset_t a;
+    TEST_ASSERT_TRUE(asset_pack_find(&pack, "/index.html", &a));
+    TEST_ASSERT_EQUAL_STRING("text/html", a.content_type);
+    TEST_ASSERT_EQUAL_STRING("\"0123456789abcdef\"", a.etag);
+    TEST_ASSERT_EQUAL(6, a.length);
+    TEST_ASSERT_TRUE(a.data == s_image + 184);   /* served in place */
+    TEST_ASSERT_TRUE(a.gzipped);
+    TEST_ASSERT_NULL(a.br_data);
+    TEST_ASSERT_FALSE(a.immutable);
+
+    TEST_ASSERT_TRUE(asset_pack_find(&pack, "/assets/app-Ab12Cd34.js", &a));
+    TEST_ASSERT_EQUAL_STRING("application/javascript", a.content_type);
+    TEST_ASSERT_TRUE(a.immutable);
+    TEST_ASSERT_EQUAL_MEMORY("\x1f\x8b" "script", a.data, 8);
+    TEST_ASSERT_TRUE(a.br_data == s_image + 200);
+    TEST_ASSERT_EQUAL(2, a.br_length);
+
+    TEST_ASSERT_FALSE(asset_pack_find(&pack, "/assets/app.js", &a));
+}
+
+void test_asset_pack_rejects_corrupt(void) {
+    asset_pack_t pack;
+
+    /* Erased flash */
+    memset(s_image, 0xFF, sizeof(s_image));
+    TEST_ASSERT_EQUAL_UINT32(0, asset_pack_image_len(s_image));
+    TEST_ASSERT_FALSE(asset_pack_open(&pack, s_image, sizeof(s_image)));
+
+    /* Truncated: fewer bytes mapped than the header claims */
+    uint32_t len = build_image();
+    TEST_ASSERT_FALSE(asset_pack_open(&pack, s_image, len - 1));
+
+    /* Body past the end of the image */
+    build_image();
+    wr32(s_image + ASSET_PACK_HEADER_SIZE + 12, 100);
+    TEST_ASSERT_FALSE(asset_pack_open(&pack, s_image, sizeof(s_image)));
+
+    /* Brotli body past the end of the image */
+    build_image();
+    wr32(s_image + ASSET_PACK_HEADER_SIZE + ASSET_PACK_ENTRY_SIZE + 20, 8);
+    TEST_ASSERT_FALSE(asset_pack_open(&pack, s_image, sizeof(s_image)));
+
+    /* Unterminated ETag */
+    build_image();
+    memset(s_image + ASSET_PACK_HEADER_SIZE + 24, 'x', ASSET_PACK_ETAG_LEN);
+    TEST_ASSERT_FALSE(asset_pack_open(&pack, s_image, sizeof(s_image)));
+
+    /* Entry table larger than the image */
+    build_image();
+    wr16(s_image + 6, 5);
+    TEST_ASSERT_FALSE(asset_pack_open(&pack, s_image, sizeof(s_image)));
+    TEST_ASSERT_EQUAL(0, pack.count);
+}
+
+void test_asset_pack_accept_encoding(void) {
+    TEST_ASSERT_TRUE(asset_accepts_br("gzip, deflate, br, zstd"));
+    TEST_ASSERT_TRUE(asset_accepts_br("br"));
+    TEST_ASSERT_TRUE(asset_accepts_br("gzip;q=1.0, BR;q=0.5"));
+    TEST_ASSERT_TRUE(asset_accepts_br("br;q=0.01"));
+    TEST_ASSERT_FALSE(asset_accepts_br("gzip, deflate"));
+    TEST_ASSERT_FALSE(asset_accepts_br("gzip, br;q=0"));
+    TEST_ASSERT_FALSE(asset_accepts_br("br ; q=0.000"));
+    TEST_ASSERT_FALSE(asset_accepts_br("brotli, xbr, identity"));
+    TEST_ASSERT_FALSE(asset_accepts_br(""));
+}
@@ -0,0 +1,109 @@
+/**
+ * @file test_audio_buffer.c
+ * @brief Unit tests for lock-free audio ring buffer
+ */
+
+#include "unity.h"
+#include "audio_buffer.h"
+
+static int16_t s_storage[16];
+static audio_ring_buffer_t s_ring;
+
+void test_audio_buffer_block_write_read(void) {
+    audio_buffer_init(&s_ring, s_storage, 16);
+
+    int16_t in[10];
+    for (int16_t i = 0; i < 10; i++) {
+        in[i] = (int16_t)(i * 100);
+    }
+
+    TEST_ASSERT_EQUAL(10, audio_buffer_write(&s_ring, in, 10));
+    TEST_ASSERT_EQUAL(10, audio_buffer_len(&s_ring));
+
+    int16_t out[16];
+    TEST_ASSERT_EQUAL(4, audio_buffer_read(&s_ring, out, 4));
+    TEST_ASSERT_EQUAL(0, out[0]);
+    TEST_ASSERT_EQUAL(300, out[3]);
+
+    /* Wraps around the end of storage */
+    TEST_ASSERT_EQUAL(10, audio_buffer_write(&s_ring, in, 10));
+    TEST_ASSERT_EQUAL(16, audio_buffer_len(&s_ring));
+    TEST_ASSERT_EQUAL(16, audio_buffer_read(&s_ring, out, 16));
+    TEST_ASSERT_EQUAL(400, out[0]);
+    TEST_ASSERT_EQUAL(900, out[5]);
+    TEST_ASSERT_EQUAL(0, out[6]);
+    TEST_ASSERT_EQUAL(900, out[15]);
+}
+
+void test_audio_buffer_block_full_and_empty(void) {
+    audio_buffer_init(&s_ring, s_storage, 16);
+
+    int16_t in[20] = {0};
+    int16_t out[20];
+
+    /* Never overwrites: only the free space is written */
+    TEST_ASSERT_EQUAL(16, audio_buffer_write(&s_ring, in, 20));
+    TEST_ASSERT_TRUE(audio_buffer_is_full(&s_ring));
+    TEST_ASSERT_EQUAL(0, audio_buffer_write(&s_ring, in, 1));
+
+    /* Reads stop when the ring runs dry */
+    TEST_ASSERT_EQUAL(16, audio_buffer_read(&s_ring, out, 20));
+    TEST_ASSERT_EQUAL(0, audio_buffer_read(&s_ring, out, 1));
+    TEST_ASSERT_TRUE(audio_buffer_is_empty(&s_ring));
+}
+
+void test_audio_buffer_spans(void) {
+    audio_buffer_init(&s_ring, s_storage, 16);
+    int16_t *wa;
+    int16_t *wb;
+    const int16_t *ra;
+    const int16_t *rb;
+    size_t na;
+    size_t nb;
+
+    /* Nothing is visible before the commit */
+    TEST_ASSERT_EQUAL(12, audio_buffer_write_acquire(&s_ring, &wa, &na, &wb, &nb, 12));
+    TEST_ASSERT_EQUAL(12, na);
+    TEST_ASSERT_EQUAL(0, nb);
+    for (size_t i = 0; i < na; i++) {
+        wa[i] = (int16_t)i;
+    }
+    TEST_ASSERT_EQUAL(0, audio_buffer_len(&s_ring));
+    audio_buffer_write_commit(&s_ring, 10);
+    TEST_ASSERT_EQUAL(10, audio_buffer_len(&s_ring));
+
+    /* Partial consume */
+    TEST_ASSERT_EQUAL(10, audio_buffer_read_acquire(&s_ring, &ra, &na, &rb, &nb, 32));
+    TEST_ASSERT_EQUAL(10, na);
+    TEST_ASSERT_EQUAL(9, ra[9]);
+    audio_buffer_read_commit(&s_ring, 8);
+    TEST_ASSERT_EQUAL(2, audio_buffer_len(&s_ring));
+
+    /* Free space wraps: 6 to the end of storage, 8 from the start */
+    TEST_ASSERT_EQUAL(14, audio_buffer_write_acquire(&s_ring, &wa, &na, &wb, &nb, 20));
+    TEST_ASSERT_EQUAL(6, na);
+    TEST_ASSERT_EQUAL(8, nb);
+    TEST_ASSERT_EQUAL_PTR(&s_storage[10], wa);
+    TEST_ASSERT_EQUAL_PTR(&s_storage[0], wb);
+    for (size_t i = 0; i < na; i++) {
+        wa[i] = (int16_t)(100 + i);
+    }
+    for (size_t i = 0; i < nb; i++) {
+        wb[i] = (int16_t)(100 + na + i);
+    }
+    audio_buffer_write_commit(&s_ring, 14);
+    TEST_ASSERT_TRUE(audio_buffer_is_full(&s_ring));
+    TEST_ASSERT_EQUAL(0, audio_buffer_write_acquire(&s_ring, &wa, &na, &wb, &nb, 1));
+
+    /* Pending samples wrap the same way; block read sees them in order */
+    TEST_ASSERT_EQUAL(16, audio_buffer_read_acquire(&s_ring, &ra, &na, &rb, &nb, 16));
+    TEST_ASSERT_EQUAL(8, na);
+    TEST_ASSERT_EQUAL(8, nb);
+    int16_t out[16];
+    TEST_ASSERT_EQUAL(16, audio_buffer_read(&s_ring, out, 16));
+    TEST_ASSERT_EQUAL(8, out[0]);
+    TEST_ASSERT_EQUAL(9, out[1]);
+    TEST_ASSERT_EQUAL(100, out[2]);
+    TEST_ASSERT_EQUAL(113, out[15]);
+    TEST_ASSERT_TRUE(audio_buffer_is_empty(&s_ring));
+}
@@ -0,0 +1,89 @@
+/**
+ * @file test_audio_mixer.c
+ * @brief Unit tests for the fixed-point block mixer
+ */
+
+#include "unity.h"
+#include "audio_mixer.h"
+#include "sidetone.h"
+
+static audio_mixer_t s_mixer;
+
+static void fill(int16_t *b, size_t n, int16_t v) {
+    for (size_t i = 0; i < n; i++) {
+        b[i] = v;
+    }
+}
+
+void test_audio_mixer_ramps_and_sums(void) {
+    audio_mixer_init(&s_mixer, 8);   /* Full scale in 8 samples */
+    int16_t tone[16];
+    int16_t rig[16];
+    int16_t out[16];
+    fill(tone, 16, 8000);
+    fill(rig, 16, 4000);
+    const int16_t *const src[AUDIO_MIX_COUNT] = { tone, rig };
+
+    /* Gains start at 0 and ramp: no step at the first sample */
+    audio_mixer_set_gain(&s_mixer, AUDIO_MIX_SIDETONE, SIDETONE_GAIN_UNITY);
+    audio_mixer_set_gain(&s_mixer, AUDIO_MIX_RIG, SIDETONE_GAIN_UNITY / 2);
+    audio_mixer_render(&s_mixer, out, src, 16);
+    TEST_ASSERT_EQUAL_INT16(1000 + 500, out[0]);
+    for (size_t i = 1; i < 16; i++) {
+        TEST_ASSERT_TRUE(out[i] >= out[i - 1]);
+    }
+
+    /* Settled: 8000 * 1.0 + 4000 * 0.5 */
+    TEST_ASSERT_EQUAL_INT16(10000, out[15]);
+    TEST_ASSERT_EQUAL_UINT16(SIDETONE_GAIN_UNITY, s_mixer.gain_q15[AUDIO_MIX_SIDETONE]);
+
+    /* Ducking the rig ramps down over the block boundary */
+    audio_mixer_set_gain(&s_mixer, AUDIO_MIX_RIG, 0);
+    audio_mixer_render(&s_mixer, out, src, 2);
+    TEST_ASSERT_EQUAL_INT16(8000 + 1500, out[0]);
+    TEST_ASSERT_EQUAL_INT16(8000 + 1000, out[1]);
+    audio_mixer_render(&s_mixer, out, src, 16);
+    TEST_ASSERT_EQUAL_INT16(8000, out[15]);
+}
+
+void test_audio_mixer_saturates(void) {
+    audio_mixer_init(&s_mixer, 1);
+    int16_t a[4];
+    int16_t b[4];
+    int16_t out[4];
+    fill(a, 4, 30000);
+    fill(b, 4, 30000);
+    const int16_t *const src[AUDIO_MIX_COUNT] = { a, b };
+
+    audio_mixer_set_gain(&s_mixer, AUDIO_MIX_SIDETONE, SIDETONE_GAIN_UNITY);
+    audio_mixer_set_gain(&s_mixer, AUDIO_MIX_RIG, SIDETONE_GAIN_UNITY);
+    audio_mixer_render(&s_mixer, out, src, 4);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, out[3]);
+
+    fill(a, 4, -30000);
+    fill(b, 4, -30000);
+    audio_mixer_render(&s_mixer, out, src, 4);
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, out[0]);
+}
+
+void test_audio_mixer_silent_source_ramps(void) {
+    audio_mixer_init(&s_mixer, 8);
+    int16_t tone[100];
+    int16_t out[100];
+    fill(tone, 100, 1000);
+
+    /* A NULL source adds nothing but its gain keeps ramping, and blocks
+     * longer than one internal pass are mixed whole */
+    audio_mixer_set_gain(&s_mixer, AUDIO_MIX_SIDETONE, SIDETONE_GAIN_UNITY);
+    audio_mixer_set_gain(&s_mixer, AUDIO_MIX_RIG, SIDETONE_GAIN_UNITY);
+    const int16_t *const tone_only[AUDIO_MIX_COUNT] = { tone, NULL };
+    audio_mixer_render(&s_mixer, out, tone_only, 100);
+    TEST_ASSERT_EQUAL_INT16(1000, out[99]);
+    TEST_ASSERT_EQUAL_INT16(1000, out[60]);
+    TEST_ASSERT_EQUAL_UINT16(SIDETONE_GAIN_UNITY, s_mixer.gain_q15[AUDIO_MIX_RIG]);
+
+    /* Nothing at all: silence */
+    const int16_t *const none[AUDIO_MIX_COUNT] = { NULL, NULL };
+    audio_mixer_render(&s_mixer, out, none, 10);
+    TEST_ASSERT_EQUAL_INT16(0, out[9]);
+}
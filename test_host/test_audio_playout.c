@@ -0,0 +1,172 @@
+/**
+ * @file test_audio_playout.c
+ * @brief Unit tests for fixed-latency streamed audio playout
+ */
+
+#include "unity.h"
+#include "audio_playout.h"
+#include "audio_source.h"
+#include "sidetone.h"
+#include "audio_rate.h"
+#include <string.h>
+
+static int16_t s_storage[256];
+static audio_ring_buffer_t s_ring;
+static audio_playout_t s_playout;
+
+static void fill(size_t count, int16_t value) {
+    for (size_t i = 0; i < count; i++) {
+        audio_buffer_push(&s_ring, value);
+    }
+}
+
+void test_audio_playout_primes_to_target(void) {
+    audio_buffer_init(&s_ring, s_storage, 256);
+    audio_playout_init(&s_playout, &s_ring, 64, 160);
+    int16_t out[8];
+
+    /* Below target: nothing mixed, nothing consumed */
+    fill(40, 1000);
+    memset(out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL(0, audio_playout_mix(&s_playout, out, 8, SIDETONE_GAIN_UNITY));
+    TEST_ASSERT_EQUAL_INT16(0, out[0]);
+    TEST_ASSERT_EQUAL(40, audio_buffer_len(&s_ring));
+    TEST_ASSERT_FALSE(s_playout.playing);
+
+    /* Target reached: plays, fading in from zero gain */
+    fill(24, 1000);
+    TEST_ASSERT_EQUAL(8, audio_playout_mix(&s_playout, out, 8, SIDETONE_GAIN_UNITY));
+    TEST_ASSERT_TRUE(s_playout.playing);
+    TEST_ASSERT_TRUE(out[0] > 0 && out[0] < out[7]);
+    TEST_ASSERT_EQUAL_UINT32(56, s_playout.level);
+    TEST_ASSERT_EQUAL_UINT32(7, audio_playout_latency_ms(&s_playout, 8000));
+
+    /* Slewed up to unity after 32 samples */
+    for (int i = 0; i < 4; i++) {
+        memset(out, 0, sizeof(out));
+        audio_playout_mix(&s_playout, out, 8, SIDETONE_GAIN_UNITY);
+    }
+    TEST_ASSERT_EQUAL_INT16(1000, out[7]);
+}
+
+void test_audio_playout_underrun_reprimes(void) {
+    audio_buffer_init(&s_ring, s_storage, 256);
+    audio_playout_init(&s_playout, &s_ring, 16, 64);
+    int16_t out[32];
+
+    fill(20, 500);
+    memset(out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL(20, audio_playout_mix(&s_playout, out, 32, SIDETONE_GAIN_UNITY));
+    TEST_ASSERT_FALSE(s_playout.playing);
+    TEST_ASSERT_EQUAL_UINT32(1, s_playout.underruns);
+
+    /* Waits for the full target again instead of playing a trickle */
+    fill(8, 500);
+    TEST_ASSERT_EQUAL(0, audio_playout_mix(&s_playout, out, 4, SIDETONE_GAIN_UNITY));
+    fill(8, 500);
+    TEST_ASSERT_EQUAL(4, audio_playout_mix(&s_playout, out, 4, SIDETONE_GAIN_UNITY));
+    TEST_ASSERT_EQUAL_UINT32(1, s_playout.underruns);
+}
+
+void test_audio_playout_trims_drift(void) {
+    audio_buffer_init(&s_ring, s_storage, 256);
+    audio_playout_init(&s_playout, &s_ring, 32, 96);
+    int16_t out[4];
+
+    fill(40, 0);
+    audio_playout_mix(&s_playout, out, 4, SIDETONE_GAIN_UNITY);
+
+    /* Sender clock fast: level climbs past max, cut back to target */
+    fill(80, 0);
+    TEST_ASSERT_EQUAL(116, audio_buffer_len(&s_ring));
+    audio_playout_mix(&s_playout, out, 4, SIDETONE_GAIN_UNITY);
+    TEST_ASSERT_EQUAL_UINT32(84, s_playout.trimmed);
+    TEST_ASSERT_EQUAL_UINT32(28, s_playout.level);
+    TEST_ASSERT_EQUAL_UINT32(0, s_playout.underruns);
+}
+
+void test_audio_playout_mix_saturates_and_ducks(void) {
+    audio_buffer_init(&s_ring, s_storage, 256);
+    audio_playout_init(&s_playout, &s_ring, 4, 128);
+    s_playout.gain_q15 = SIDETONE_GAIN_UNITY;  /* Skip the fade-in */
+    int16_t out[4] = { 30000, -30000, 100, 0 };
+
+    audio_buffer_push(&s_ring, 10000);
+    audio_buffer_push(&s_ring, -10000);
+    audio_buffer_push(&s_ring, 50);
+    audio_buffer_push(&s_ring, 0);
+    audio_playout_mix(&s_playout, out, 4, SIDETONE_GAIN_UNITY);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, out[0]);
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, out[1]);
+    TEST_ASSERT_EQUAL_INT16(150, out[2]);
+
+    /* Selector: full gain with no tone, ducked share while one sounds */
+    audio_source_selector_t sel;
+    audio_source_init(&sel);
+    audio_source_update(&sel);
+    TEST_ASSERT_EQUAL_UINT16(20000, audio_source_rig_gain(&sel, 20000, 25));
+    audio_source_set_remote(&sel, true);
+    audio_source_update(&sel);
+    TEST_ASSERT_EQUAL_UINT16(5000, audio_source_rig_gain(&sel, 20000, 25));
+    TEST_ASSERT_EQUAL_UINT16(0, audio_source_rig_gain(&sel, 20000, 0));
+}
+
+void test_audio_playout_upsamples(void) {
+    audio_buffer_init(&s_ring, s_storage, 256);
+    audio_playout_init(&s_playout, &s_ring, 4, 64);
+    audio_playout_set_upsample(&s_playout, 4);
+    int16_t out[96];
+
+    /* 64 output samples read exactly 16 ring samples */
+    fill(40, 0);
+    memset(out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL(64, audio_playout_mix(&s_playout, out, 64, SIDETONE_GAIN_UNITY));
+    TEST_ASSERT_EQUAL(24, audio_buffer_len(&s_ring));
+    TEST_ASSERT_EQUAL(96, audio_playout_mix(&s_playout, out, 96, SIDETONE_GAIN_UNITY));
+    TEST_ASSERT_EQUAL(0, audio_buffer_len(&s_ring));
+    TEST_ASSERT_TRUE(s_playout.playing);
+
+    /* Gain at unity: ring steps of 400 become output steps of 100 */
+    for (int16_t v = 1; v <= 10; v++) {
+        audio_buffer_push(&s_ring, (int16_t)(v * 400));
+    }
+    memset(out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL(16, audio_playout_mix(&s_playout, out, 16, SIDETONE_GAIN_UNITY));
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL_INT16(i * 100, out[i]);
+    }
+    TEST_ASSERT_EQUAL(6, audio_buffer_len(&s_ring));
+
+    /* Six ring samples cover 24 outputs, then the ring runs dry */
+    memset(out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL(24, audio_playout_mix(&s_playout, out, 32, SIDETONE_GAIN_UNITY));
+    TEST_ASSERT_EQUAL_INT16(1600, out[0]);
+    TEST_ASSERT_FALSE(s_playout.playing);
+    TEST_ASSERT_EQUAL_UINT32(1, s_playout.underruns);
+}
+
+void test_audio_rate_decimate(void) {
+    TEST_ASSERT_EQUAL_UINT32(8000, audio_rate_from_index(0));
+    TEST_ASSERT_EQUAL_UINT32(16000, audio_rate_from_index(1));
+    TEST_ASSERT_EQUAL_UINT32(48000, audio_rate_from_index(2));
+    TEST_ASSERT_EQUAL_UINT32(8000, audio_rate_from_index(7));
+    TEST_ASSERT_EQUAL_UINT32(6, audio_rate_factor(48000));
+    TEST_ASSERT_EQUAL_UINT32(1, audio_rate_factor(8000));
+
+    /* Runs of 6 average to one sample, carried across calls, in place */
+    audio_decimator_t d;
+    audio_decimator_init(&d, 6);
+    int16_t buf[10] = { 6, 6, 6, 6, 6, 6, 0, 0, 12, 12 };
+    TEST_ASSERT_EQUAL(1, audio_decimate(&d, buf, 10, buf));
+    TEST_ASSERT_EQUAL_INT16(6, buf[0]);
+    int16_t tail[2] = { 12, 12 };
+    TEST_ASSERT_EQUAL(1, audio_decimate(&d, tail, 2, tail));
+    TEST_ASSERT_EQUAL_INT16(8, tail[0]);
+
+    /* Factor 1 copies */
+    audio_decimator_init(&d, 1);
+    int16_t one[3] = { 1, -2, 3 };
+    int16_t copy[3];
+    TEST_ASSERT_EQUAL(3, audio_decimate(&d, one, 3, copy));
+    TEST_ASSERT_EQUAL_INT16(-2, copy[1]);
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test_audio_rx.c
+ * @brief Unit tests for the tone detector and the off-air decoding pipeline
+ */
+
+#include "unity.h"
+#include "tone_detector.h"
+#include "audio_rx.h"
+#include "morse_table.h"
+#include "stream.h"
+#include <math.h>
+#include <string.h>
+
+#define RATE_HZ      8000
+#define AUDIO_MAX    (RATE_HZ * 12)   /* 12 s */
+
+static int16_t s_audio[AUDIO_MAX];
+static size_t s_audio_len;
+static double s_phase;
+static uint32_t s_noise_seed;
+
+static stream_slot_t s_stream_buffer[64];
+static keying_stream_t s_stream;
+static audio_rx_t s_rx;
+
+/** Append ms of tone (or silence) at freq_hz, plus uniform noise */
+static void synth(uint32_t ms, uint32_t freq_hz, double amplitude, double noise) {
+    size_t n = (size_t)ms * RATE_HZ / 1000U;
+    for (size_t i = 0; i < n && s_audio_len < AUDIO_MAX; i++) {
+        double x = 0.0;
+        if (freq_hz > 0U) {
+            x = amplitude * sin(s_phase);
+            s_phase += 2.0 * 3.14159265358979 * freq_hz / RATE_HZ;
+        }
+        s_noise_seed = s_noise_seed * 1664525U + 1013904223U;
+        x += noise * ((double)(s_noise_seed >> 8) / (double)(1U << 24) * 2.0 - 1.0);
+        s_audio[s_audio_len++] = (int16_t)(x * 32767.0);
+    }
+}
+
+static void synth_reset(void) {
+    s_audio_len = 0;
+    s_phase = 0.0;
+    s_noise_seed = 12345U;
+}
+
+/** Key text as tone at wpm (PARIS timing) */
+static void synth_text(const char *text, uint32_t wpm, uint32_t freq_hz) {
+    uint32_t dit = 1200U / wpm;
+    for (const char *p = text; *p != '\0'; p++) {
+        if (*p == ' ') {
+            synth(dit * 4U, 0, 0.0, 0.01);  /* 3 already after the char */
+            continue;
+        }
+        for (const char *e = morse_table_reverse(*p); *e != '\0'; e++) {
+            synth((*e == '-') ? dit * 3U : dit, freq_hz, 0.3, 0.01);
+            synth(dit, 0, 0.0, 0.01);
+        }
+        synth(dit * 2U, 0, 0.0, 0.01);
+    }
+}
+
+void test_tone_detector_keys_tone(void) {
+    tone_detector_config_t cfg = TONE_DETECTOR_CONFIG_DEFAULT;
+    tone_detector_t det;
+    tone_detector_init(&det, &cfg);
+    TEST_ASSERT_EQUAL(6, det.bins);  /* 400..1000 Hz at most 125 Hz apart */
+    TEST_ASSERT_EQUAL(400, det.bin_hz[0]);
+    TEST_ASSERT_EQUAL(1000, det.bin_hz[5]);
+
+    /* 700 Hz falls between bins: 100 ms off, 100 ms on, 100 ms off, 100 ms on */
+    synth_reset();
+    synth(100, 0, 0.0, 0.02);
+    synth(100, 700, 0.3, 0.02);
+    synth(100, 0, 0.0, 0.02);
+    synth(100, 700, 0.3, 0.02);
+    synth(100, 0, 0.0, 0.02);
+
+    tone_edge_t edges[8];
+    size_t n = tone_detector_process(&det, s_audio, s_audio_len, edges, 8);
+    TEST_ASSERT_EQUAL(4, n);
+    static const uint64_t expect[4] = { 800, 1600, 2400, 3200 };
+    for (size_t i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL(i % 2U == 0U ? 1 : 0, edges[i].level);
+        TEST_ASSERT_UINT32_WITHIN(cfg.block_samples, (uint32_t)expect[i], (uint32_t)edges[i].sample);
+    }
+    TEST_ASSERT_UINT_WITHIN(80, 700, det.stats.tone_hz);
+    TEST_ASSERT_FALSE(tone_detector_key_down(&det));
+
+    /* Out of band: 2 kHz does not key */
+    tone_detector_init(&det, &cfg);
+    synth_reset();
+    synth(100, 0, 0.0, 0.02);
+    synth(200, 2000, 0.3, 0.02);
+    TEST_ASSERT_EQUAL(0, tone_detector_process(&det, s_audio, s_audio_len, edges, 8));
+}
+
+void test_audio_rx_decodes_off_air(void) {
+    stream_init(&s_stream, s_stream_buffer, 64);
+    stream_set_tick_period_us(&s_stream, 1000);
+    stream_set_epoch_us(&s_stream, 0);
+
+    tone_detector_config_t cfg = TONE_DETECTOR_CONFIG_DEFAULT;
+    audio_rx_init(&s_rx, &s_stream, &cfg, 250000);
+
+    synth_reset();
+    synth(200, 0, 0.0, 0.01);
+    synth_text("PARIS PARIS", 20, 650);
+    synth(1000, 0, 0.0, 0.01);
+
+    /* 32 ms reads, like the I2S task */
+    for (size_t off = 0; off < s_audio_len; off += 256U) {
+        size_t n = (s_audio_len - off < 256U) ? s_audio_len - off : 256U;
+        audio_rx_process(&s_rx, &s_audio[off], n);
+    }
+
+    char text[64];
+    size_t len = decoder_inst_get_text(audio_rx_decoder(&s_rx), text, sizeof(text));
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_NOT_NULL(strstr(text, "PARIS PARIS"));
+    TEST_ASSERT_UINT_WITHIN(2, 20, decoder_inst_get_wpm(audio_rx_decoder(&s_rx)));  /* 8 ms blocks */
+
+    /* Stamped in stream time from the init moment */
+    decoded_char_t last = decoder_inst_get_last_char(audio_rx_decoder(&s_rx));
+    TEST_ASSERT_TRUE(last.timestamp_us > 250000);
+    TEST_ASSERT_EQUAL_UINT32(s_audio_len, s_rx.stats.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, s_rx.stats.over_budget);  /* Host clock stands still */
+}
@@ -0,0 +1,73 @@
+/**
+ * @file test_boot_timeline.c
+ * @brief Tests for the boot-phase timeline
+ */
+
+#include "unity.h"
+#include "boot_timeline.h"
+
+static boot_timeline_t s_tl;
+static boot_phase_t s_out[BOOT_TIMELINE_MAX];
+
+void test_boot_timeline_records_phases(void) {
+    boot_timeline_init(&s_tl, NULL);
+
+    int gpio = boot_phase_begin(&s_tl, "gpio", 0, 1000, NULL);
+    int net = boot_phase_begin(&s_tl, "net", 1, 1200, NULL);
+    boot_phase_end(&s_tl, gpio, 1500, NULL);
+
+    /* net still running: reported with end 0 */
+    TEST_ASSERT_EQUAL_size_t(2, boot_timeline_snapshot(&s_tl, s_out, BOOT_TIMELINE_MAX));
+    TEST_ASSERT_EQUAL_STRING("gpio", s_out[0].name);
+    TEST_ASSERT_EQUAL_INT64(1000, s_out[0].start_us);
+    TEST_ASSERT_EQUAL_INT64(1500, s_out[0].end_us);
+    TEST_ASSERT_EQUAL_STRING("net", s_out[1].name);
+    TEST_ASSERT_EQUAL_UINT8(1, s_out[1].core);
+    TEST_ASSERT_EQUAL_INT64(0, s_out[1].end_us);
+
+    boot_phase_end(&s_tl, net, 90000, NULL);
+    boot_timeline_snapshot(&s_tl, s_out, BOOT_TIMELINE_MAX);
+    TEST_ASSERT_EQUAL_INT64(90000, s_out[1].end_us);
+
+    /* Capacity of out is honored */
+    TEST_ASSERT_EQUAL_size_t(1, boot_timeline_snapshot(&s_tl, s_out, 1));
+}
+
+void test_boot_timeline_full_drops(void) {
+    boot_timeline_init(&s_tl, NULL);
+    for (unsigned i = 0; i < BOOT_TIMELINE_MAX; i++) {
+        TEST_ASSERT_EQUAL_INT((int)i, boot_phase_begin(&s_tl, "p", 0, (int64_t)i, NULL));
+    }
+
+    /* Full: dropped, and ending it is harmless */
+    int extra = boot_phase_begin(&s_tl, "extra", 0, 99, NULL);
+    TEST_ASSERT_EQUAL_INT(-1, extra);
+    boot_phase_end(&s_tl, extra, 100, NULL);
+    TEST_ASSERT_EQUAL_size_t(BOOT_TIMELINE_MAX,
+                             boot_timeline_snapshot(&s_tl, s_out, BOOT_TIMELINE_MAX));
+}
+
+void test_boot_timeline_heap_used(void) {
+    boot_heap_t heap = { .internal = 300000, .psram = 8000000 };
+    boot_timeline_init(&s_tl, &heap);
+
+    int net = boot_phase_begin(&s_tl, "net", 1, 100, &heap);
+    heap.internal -= 40000;             /* WiFi driver */
+    heap.psram -= 20000;
+    int ui = boot_phase_begin(&s_tl, "ui", 0, 200, &heap);
+    heap.internal -= 1000;
+    boot_phase_end(&s_tl, ui, 300, &heap);
+    heap.internal += 500;               /* A scratch buffer freed */
+    boot_phase_end(&s_tl, net, 400, &heap);
+
+    TEST_ASSERT_EQUAL_size_t(2, boot_timeline_snapshot(&s_tl, s_out, BOOT_TIMELINE_MAX));
+    TEST_ASSERT_EQUAL_INT32(40500, s_out[0].internal_used);    /* Overlaps ui */
+    TEST_ASSERT_EQUAL_INT32(20000, s_out[0].psram_used);
+    TEST_ASSERT_EQUAL_INT32(1000, s_out[1].internal_used);
+
+    int32_t internal_used;
+    int32_t psram_used;
+    boot_timeline_heap_used(&s_tl, &internal_used, &psram_used);
+    TEST_ASSERT_EQUAL_INT32(40500, internal_used);
+    TEST_ASSERT_EQUAL_INT32(20000, psram_used);
+}
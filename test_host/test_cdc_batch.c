@@ -0,0 +1,107 @@
+/**
+ * @file test_cdc_batch.c
+ * @brief Unit tests for the coalescing CDC output buffer
+ */
+
+#include "unity.h"
+#include "cdc_batch.h"
+#include <string.h>
+
+static uint8_t s_port[512];
+static size_t s_port_len;
+static size_t s_port_room;      /* Bytes the port still takes */
+static unsigned s_writes;
+static unsigned s_flushes;
+
+static size_t port_write(void *ctx, const uint8_t *data, size_t len) {
+    (void)ctx;
+    s_writes++;
+    size_t n = (len < s_port_room) ? len : s_port_room;
+    memcpy(&s_port[s_port_len], data, n);
+    s_port_len += n;
+    s_port_room -= n;
+    return n;
+}
+
+static void port_flush(void *ctx) {
+    (void)ctx;
+    s_flushes++;
+}
+
+static void setup(cdc_batch_t *b, size_t room) {
+    s_port_len = 0;
+    s_port_room = room;
+    s_writes = 0;
+    s_flushes = 0;
+    cdc_batch_init(b, port_write, port_flush, NULL);
+}
+
+void test_cdc_batch_coalesces_packets(void) {
+    cdc_batch_t b;
+    setup(&b, sizeof(s_port));
+
+    /* Short writes are held, not sent one by one */
+    for (int i = 0; i < 10; i++) {
+        cdc_batch_put(&b, "abcdef", 6, 1000);
+    }
+    TEST_ASSERT_EQUAL(0, s_writes);
+    TEST_ASSERT_TRUE(cdc_batch_pending(&b));
+
+    /* The 64th byte sends a full packet */
+    cdc_batch_put(&b, "0123456789", 10, 1100);
+    TEST_ASSERT_EQUAL(1, s_writes);
+    TEST_ASSERT_EQUAL(1, s_flushes);
+    TEST_ASSERT_EQUAL(CDC_BATCH_SIZE, s_port_len);
+    TEST_ASSERT_EQUAL_MEMORY("abcdefabcd", s_port, 10);
+    TEST_ASSERT_EQUAL(6, b.len);
+
+    /* A long write goes out in whole packets, the tail is held */
+    cdc_batch_put(&b, s_port, 200, 1200);
+    TEST_ASSERT_EQUAL(4, b.packets);
+    TEST_ASSERT_EQUAL(14, b.len);
+
+    /* Explicit flush (prompt) sends the tail */
+    cdc_batch_flush(&b);
+    TEST_ASSERT_FALSE(cdc_batch_pending(&b));
+    TEST_ASSERT_EQUAL(5, b.packets);
+    TEST_ASSERT_EQUAL(270, b.bytes);
+    TEST_ASSERT_EQUAL(0, b.dropped);
+
+    /* Nothing held: flush does not touch the port */
+    cdc_batch_flush(&b);
+    TEST_ASSERT_EQUAL(5, s_flushes);
+}
+
+void test_cdc_batch_hold_time(void) {
+    cdc_batch_t b;
+    setup(&b, sizeof(s_port));
+
+    cdc_batch_put(&b, "> ", 2, 10000);
+    TEST_ASSERT_TRUE(cdc_batch_poll(&b, 10000 + CDC_BATCH_HOLD_US - 1));
+    TEST_ASSERT_EQUAL(0, s_writes);
+    TEST_ASSERT_FALSE(cdc_batch_poll(&b, 10000 + CDC_BATCH_HOLD_US));
+    TEST_ASSERT_EQUAL(1, s_writes);
+
+    /* A late write sends the stale bytes first, then holds its own */
+    cdc_batch_put(&b, "ab", 2, 20000);
+    cdc_batch_put(&b, "cd", 2, 20000 + CDC_BATCH_HOLD_US);
+    TEST_ASSERT_EQUAL(2, s_writes);
+    TEST_ASSERT_EQUAL_MEMORY("> ab", s_port, 4);
+    TEST_ASSERT_EQUAL(2, b.len);
+    TEST_ASSERT_EQUAL_INT64(20000 + CDC_BATCH_HOLD_US, b.first_us);
+}
+
+void test_cdc_batch_drops_when_host_stalls(void) {
+    cdc_batch_t b;
+    setup(&b, 100);
+
+    /* Port takes 100 bytes, then nothing: the rest is dropped, never waited for */
+    static uint8_t big[300];
+    memset(big, 'x', sizeof(big));
+    cdc_batch_put(&b, big, sizeof(big), 0);
+    cdc_batch_flush(&b);
+    TEST_ASSERT_EQUAL(100, b.bytes);
+    TEST_ASSERT_EQUAL(200, b.dropped);
+    TEST_ASSERT_EQUAL(5, b.packets);
+    TEST_ASSERT_FALSE(cdc_batch_pending(&b));
+}
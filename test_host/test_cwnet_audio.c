@@ -0,0 +1,167 @@
+/**
+ * @file test_cwnet_audio.c
+ * @brief Unit tests for CWNet rig audio blocks (IMA ADPCM)
+ */
+
+#include "unity.h"
+#include "cwnet_audio.h"
+#include "cwnet_client.h"
+#include <string.h>
+
+static cwnet_audio_enc_t s_enc;
+static cwnet_audio_dec_t s_dec;
+
+/** Triangle wave, 500 Hz at 8 kHz, +-8000 */
+static int16_t tone(size_t n) {
+    int32_t phase = (int32_t)(n % 16U);
+    int32_t v = (phase < 8) ? phase * 2000 - 8000 : 24000 - phase * 2000;
+    return (int16_t)v;
+}
+
+void test_cwnet_audio_round_trip(void) {
+    cwnet_audio_enc_init(&s_enc);
+    cwnet_audio_dec_init(&s_dec);
+
+    int64_t signal = 0;
+    int64_t noise = 0;
+    size_t t = 0;
+    for (int block = 0; block < 4; block++) {
+        int16_t pcm[CWNET_AUDIO_BLOCK_SAMPLES];
+        for (size_t i = 0; i < CWNET_AUDIO_BLOCK_SAMPLES; i++) {
+            pcm[i] = tone(t + i);
+        }
+
+        uint8_t payload[CWNET_AUDIO_PAYLOAD_MAX];
+        size_t len = cwnet_audio_encode(&s_enc, pcm, CWNET_AUDIO_BLOCK_SAMPLES,
+                                        payload, sizeof(payload));
+        TEST_ASSERT_EQUAL(CWNET_AUDIO_PAYLOAD_MAX, len);
+        TEST_ASSERT_EQUAL_HEX8(block, payload[0]);
+        TEST_ASSERT_EQUAL_HEX8(CWNET_AUDIO_RATE_KHZ, payload[5]);
+
+        int16_t out[CWNET_AUDIO_BLOCK_SAMPLES];
+        TEST_ASSERT_EQUAL(CWNET_AUDIO_BLOCK_SAMPLES,
+                          cwnet_audio_decode(&s_dec, payload, len, out, CWNET_AUDIO_BLOCK_SAMPLES));
+
+        /* Skip the first block: the step size is still adapting */
+        for (size_t i = 0; block > 0 && i < CWNET_AUDIO_BLOCK_SAMPLES; i++) {
+            int32_t e = (int32_t)out[i] - pcm[i];
+            signal += (int64_t)pcm[i] * pcm[i];
+            noise += (int64_t)e * e;
+        }
+        t += CWNET_AUDIO_BLOCK_SAMPLES;
+    }
+
+    /* Better than 20 dB SNR */
+    TEST_ASSERT_TRUE(noise * 100 < signal);
+    TEST_ASSERT_EQUAL_UINT32(4, s_dec.blocks);
+    TEST_ASSERT_EQUAL_UINT32(0, s_dec.lost);
+}
+
+void test_cwnet_audio_blocks_independent(void) {
+    cwnet_audio_enc_init(&s_enc);
+    cwnet_audio_dec_init(&s_dec);
+
+    int16_t pcm[64];
+    for (size_t i = 0; i < 64; i++) {
+        pcm[i] = tone(i);
+    }
+    uint8_t first[CWNET_AUDIO_PAYLOAD_MAX];
+    uint8_t second[CWNET_AUDIO_PAYLOAD_MAX];
+    uint8_t third[CWNET_AUDIO_PAYLOAD_MAX];
+    cwnet_audio_encode(&s_enc, pcm, 64, first, sizeof(first));
+    cwnet_audio_encode(&s_enc, pcm, 64, second, sizeof(second));
+    size_t len = cwnet_audio_encode(&s_enc, pcm, 64, third, sizeof(third));
+    TEST_ASSERT_EQUAL(CWNET_AUDIO_HEADER + 32, len);
+
+    /* Decoding the third alone gives the same samples as in sequence */
+    int16_t in_seq[64];
+    int16_t alone[64];
+    cwnet_audio_decode(&s_dec, first, len, in_seq, 64);
+    cwnet_audio_decode(&s_dec, second, len, in_seq, 64);
+    cwnet_audio_decode(&s_dec, third, len, in_seq, 64);
+    cwnet_audio_dec_init(&s_dec);
+    cwnet_audio_decode(&s_dec, third, len, alone, 64);
+    TEST_ASSERT_EQUAL_MEMORY(in_seq, alone, sizeof(alone));
+
+    /* A skipped block is counted as lost */
+    cwnet_audio_dec_init(&s_dec);
+    cwnet_audio_decode(&s_dec, first, len, alone, 64);
+    cwnet_audio_decode(&s_dec, third, len, alone, 64);
+    TEST_ASSERT_EQUAL_UINT32(1, s_dec.lost);
+    TEST_ASSERT_EQUAL_UINT32(2, s_dec.blocks);
+}
+
+void test_cwnet_audio_rejects_malformed(void) {
+    cwnet_audio_enc_init(&s_enc);
+    cwnet_audio_dec_init(&s_dec);
+
+    int16_t pcm[16] = {0};
+    uint8_t payload[CWNET_AUDIO_PAYLOAD_MAX];
+    int16_t out[16];
+
+    /* Odd or oversize sample counts cannot be encoded */
+    TEST_ASSERT_EQUAL(0, cwnet_audio_encode(&s_enc, pcm, 15, payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL(0, cwnet_audio_encode(&s_enc, pcm, 16, payload, 8));
+
+    size_t len = cwnet_audio_encode(&s_enc, pcm, 16, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL(0, cwnet_audio_decode(&s_dec, payload, CWNET_AUDIO_HEADER, out, 16));
+    TEST_ASSERT_EQUAL(0, cwnet_audio_decode(&s_dec, payload, len, out, 8));
+    payload[5] = 16;  /* 16 kHz: not what the sidetone runs at */
+    TEST_ASSERT_EQUAL(0, cwnet_audio_decode(&s_dec, payload, len, out, 16));
+    payload[5] = CWNET_AUDIO_RATE_KHZ;
+    payload[4] = 89;  /* Step index out of range */
+    TEST_ASSERT_EQUAL(0, cwnet_audio_decode(&s_dec, payload, len, out, 16));
+    TEST_ASSERT_EQUAL_UINT32(4, s_dec.rejected);
+    TEST_ASSERT_EQUAL_UINT32(0, s_dec.blocks);
+}
+
+static size_t s_audio_len;
+static uint8_t s_audio_first;
+
+static void audio_cb(const uint8_t *payload, size_t len, void *user_data) {
+    (void)user_data;
+    s_audio_len = len;
+    s_audio_first = payload[0];
+}
+
+static int send_cb(const uint8_t *data, size_t len, void *user_data) {
+    (void)data;
+    (void)user_data;
+    return (int)len;
+}
+
+static int32_t time_cb(void *user_data) {
+    (void)user_data;
+    return 0;
+}
+
+void test_cwnet_audio_client_delivers_block(void) {
+    cwnet_client_t client;
+    cwnet_client_config_t config = {
+        .server_host = "test.server",
+        .server_port = 7355,
+        .send_cb = send_cb,
+        .get_time_ms_cb = time_cb,
+        .audio_cb = audio_cb,
+    };
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_init(&client, &config));
+    cwnet_client_on_connected(&client);
+
+    cwnet_audio_enc_init(&s_enc);
+    s_enc.seq = 0x42;
+    int16_t pcm[CWNET_AUDIO_BLOCK_SAMPLES] = {0};
+    uint8_t frame[3 + CWNET_AUDIO_PAYLOAD_MAX];
+    size_t len = cwnet_audio_encode(&s_enc, pcm, CWNET_AUDIO_BLOCK_SAMPLES,
+                                    &frame[3], CWNET_AUDIO_PAYLOAD_MAX);
+    frame[0] = (uint8_t)((CWNET_FRAME_CAT_LONG_PAYLOAD << 6) | CWNET_CMD_AUDIO);
+    frame[1] = (uint8_t)(len & 0xFFU);
+    frame[2] = (uint8_t)(len >> 8);
+
+    /* Arrives in two TCP segments */
+    s_audio_len = 0;
+    cwnet_client_on_data(&client, frame, 50);
+    TEST_ASSERT_EQUAL(0, s_audio_len);
+    cwnet_client_on_data(&client, &frame[50], 3 + len - 50);
+    TEST_ASSERT_EQUAL(len, s_audio_len);
+    TEST_ASSERT_EQUAL_HEX8(0x42, s_audio_first);
+}
@@ -0,0 +1,40 @@
+/**
+ * @file test_cwnet_backoff.c
+ * @brief Unit tests for CWNet jittered exponential reconnect backoff
+ */
+
+#include "unity.h"
+#include "cwnet_backoff.h"
+
+void test_cwnet_backoff_doubles_to_cap(void) {
+    /* rand chosen to land exactly on the nominal delay (offset == span) */
+    uint32_t d0 = cwnet_backoff_delay_ms(0, CWNET_BACKOFF_BASE_MS * CWNET_BACKOFF_JITTER_PCT / 100U);
+    TEST_ASSERT_EQUAL(CWNET_BACKOFF_BASE_MS, d0);
+
+    /* Nominal delay doubles each failure until the cap */
+    uint32_t nominal = CWNET_BACKOFF_BASE_MS;
+    for (uint32_t n = 0; n < 40; n++) {
+        uint32_t span = nominal * CWNET_BACKOFF_JITTER_PCT / 100U;
+        TEST_ASSERT_EQUAL(nominal, cwnet_backoff_delay_ms(n, span));
+        TEST_ASSERT_TRUE(cwnet_backoff_delay_ms(n, UINT32_MAX) < nominal + span);
+        nominal = (nominal * 2U > CWNET_BACKOFF_MAX_MS) ? CWNET_BACKOFF_MAX_MS : nominal * 2U;
+    }
+
+    /* Far past the cap, still bounded */
+    uint32_t late = cwnet_backoff_delay_ms(1000, 0);
+    TEST_ASSERT_EQUAL(CWNET_BACKOFF_MAX_MS - CWNET_BACKOFF_MAX_MS * CWNET_BACKOFF_JITTER_PCT / 100U,
+                      late);
+}
+
+void test_cwnet_backoff_jitter_range(void) {
+    /* First retry stays well under a second for any random word */
+    uint32_t words[] = {0, 1, 12345, 0x7FFFFFFFU, 0xDEADBEEFU, UINT32_MAX};
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        uint32_t d = cwnet_backoff_delay_ms(0, words[i]);
+        TEST_ASSERT_TRUE(d >= CWNET_BACKOFF_BASE_MS * 3U / 4U);
+        TEST_ASSERT_TRUE(d < CWNET_BACKOFF_BASE_MS * 5U / 4U);
+    }
+
+    /* Different words spread the delay */
+    TEST_ASSERT_TRUE(cwnet_backoff_delay_ms(2, 0) != cwnet_backoff_delay_ms(2, 333));
+}
@@ -0,0 +1,165 @@
+/**
+ * @file test_cwnet_capture.c
+ * @brief Unit tests for the CWNet capture ring and .pcap export
+ */
+
+#include "unity.h"
+#include "cwnet_capture.h"
+#include <string.h>
+
+static cwnet_capture_slot_t s_slots[8];
+static cwnet_capture_t s_cap;
+static uint8_t s_pcap[4096];
+
+static const cwnet_capture_endpoint_t k_tcp = {
+    .local_ip = 0xC0A80102U, .remote_ip = 0x0A000001U,
+    .local_port = 50000, .remote_port = 7355
+};
+static const cwnet_capture_endpoint_t k_udp = {
+    .local_ip = 0xC0A80102U, .remote_ip = 0x0A000001U,
+    .local_port = 50001, .remote_port = 7356
+};
+
+static uint32_t rd16be(const uint8_t *p) {
+    return ((uint32_t)p[0] << 8) | p[1];
+}
+
+static uint32_t rd32be(const uint8_t *p) {
+    return (rd16be(p) << 16) | rd16be(p + 2);
+}
+
+static uint32_t rd32le(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/** Export the whole file in deliberately odd chunk sizes */
+static size_t export_all(cwnet_capture_export_t *exp) {
+    size_t total = 0;
+    size_t n;
+    while ((n = cwnet_capture_export_read(exp, s_pcap + total, 7)) > 0) {
+        total += n;
+        TEST_ASSERT_TRUE(total <= sizeof(s_pcap));
+    }
+    return total;
+}
+
+/** IPv4 header checksum over a valid header folds to 0xFFFF */
+static bool ip_checksum_ok(const uint8_t *ip) {
+    uint32_t sum = 0;
+    for (int i = 0; i < 20; i += 2) {
+        sum += rd16be(ip + i);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFFU) + (sum >> 16);
+    }
+    return sum == 0xFFFFU;
+}
+
+void test_cwnet_capture_pcap_export(void) {
+    cwnet_capture_init(&s_cap, s_slots, 8);
+
+    uint8_t tx[10];
+    uint8_t rx[300];
+    uint8_t dgram[20];
+    memset(tx, 0x11, sizeof(tx));
+    memset(rx, 0x22, sizeof(rx));
+    memset(dgram, 0x33, sizeof(dgram));
+
+    /* Off: nothing recorded */
+    cwnet_capture_frame(&s_cap, CWNET_CAPTURE_TX, CWNET_CAPTURE_TCP, &k_tcp, tx, sizeof(tx), 5);
+    TEST_ASSERT_EQUAL_UINT32(0, atomic_load(&s_cap.write));
+
+    cwnet_capture_enable(&s_cap, true);
+    cwnet_capture_frame(&s_cap, CWNET_CAPTURE_TX, CWNET_CAPTURE_TCP, &k_tcp, tx, sizeof(tx),
+                        1500000);
+    cwnet_capture_frame(&s_cap, CWNET_CAPTURE_RX, CWNET_CAPTURE_TCP, &k_tcp, rx, sizeof(rx),
+                        1500250);
+    cwnet_capture_frame(&s_cap, CWNET_CAPTURE_TX, CWNET_CAPTURE_UDP, &k_udp, dgram,
+                        sizeof(dgram), 1500300);
+    /* A long chunk takes two slots */
+    TEST_ASSERT_EQUAL_UINT32(4, atomic_load(&s_cap.write));
+
+    cwnet_capture_export_t exp;
+    cwnet_capture_export_begin(&exp, &s_cap);
+    size_t total = export_all(&exp);
+    TEST_ASSERT_EQUAL_UINT32(4, exp.records);
+    TEST_ASSERT_EQUAL_UINT32(0, exp.lost);
+    TEST_ASSERT_EQUAL(24 + (16 + 40 + 10) + (16 + 40 + CWNET_CAPTURE_SNAP) +
+                      (16 + 40 + 300 - CWNET_CAPTURE_SNAP) + (16 + 28 + 20), total);
+
+    /* Global header: microsecond pcap, raw IPv4 */
+    TEST_ASSERT_EQUAL_HEX32(0xA1B2C3D4U, rd32le(s_pcap));
+    TEST_ASSERT_EQUAL_UINT32(CWNET_CAPTURE_LINKTYPE_RAW, rd32le(s_pcap + 20));
+
+    /* Keyer -> server segment */
+    const uint8_t *r = s_pcap + 24;
+    TEST_ASSERT_EQUAL_UINT32(1, rd32le(r));
+    TEST_ASSERT_EQUAL_UINT32(500000, rd32le(r + 4));
+    TEST_ASSERT_EQUAL_UINT32(50, rd32le(r + 8));
+    const uint8_t *ip = r + 16;
+    TEST_ASSERT_TRUE(ip_checksum_ok(ip));
+    TEST_ASSERT_EQUAL_UINT8(6, ip[9]);
+    TEST_ASSERT_EQUAL_HEX32(k_tcp.local_ip, rd32be(ip + 12));
+    TEST_ASSERT_EQUAL_HEX32(k_tcp.remote_ip, rd32be(ip + 16));
+    TEST_ASSERT_EQUAL_UINT32(50000, rd16be(ip + 20));
+    TEST_ASSERT_EQUAL_UINT32(7355, rd16be(ip + 22));
+    TEST_ASSERT_EQUAL_UINT32(1, rd32be(ip + 24));
+    TEST_ASSERT_EQUAL_UINT8(0x11, ip[40]);
+
+    /* Server -> keyer, two segments continuing the sequence */
+    r += 16 + 50;
+    ip = r + 16;
+    TEST_ASSERT_EQUAL_HEX32(k_tcp.remote_ip, rd32be(ip + 12));
+    TEST_ASSERT_EQUAL_UINT32(7355, rd16be(ip + 20));
+    TEST_ASSERT_EQUAL_UINT32(1, rd32be(ip + 24));
+    TEST_ASSERT_EQUAL_UINT32(11, rd32be(ip + 28));      /* Acks the 10 TX bytes */
+    r += 16 + 40 + CWNET_CAPTURE_SNAP;
+    ip = r + 16;
+    TEST_ASSERT_EQUAL_UINT32(1 + CWNET_CAPTURE_SNAP, rd32be(ip + 24));
+    TEST_ASSERT_EQUAL_UINT8(0x22, ip[40 + 300 - CWNET_CAPTURE_SNAP - 1]);
+
+    /* UDP edge datagram */
+    r += 16 + 40 + 300 - CWNET_CAPTURE_SNAP;
+    ip = r + 16;
+    TEST_ASSERT_TRUE(ip_checksum_ok(ip));
+    TEST_ASSERT_EQUAL_UINT8(17, ip[9]);
+    TEST_ASSERT_EQUAL_UINT32(48, rd16be(ip + 2));
+    TEST_ASSERT_EQUAL_UINT32(7356, rd16be(ip + 22));
+    TEST_ASSERT_EQUAL_UINT32(28, rd16be(ip + 24));
+    TEST_ASSERT_EQUAL_UINT8(0x33, ip[28]);
+}
+
+void test_cwnet_capture_wrap_and_lapped_reader(void) {
+    cwnet_capture_init(&s_cap, s_slots, 4);
+    cwnet_capture_enable(&s_cap, true);
+
+    for (uint8_t i = 0; i < 6; i++) {
+        cwnet_capture_frame(&s_cap, CWNET_CAPTURE_TX, CWNET_CAPTURE_TCP, &k_tcp, &i, 1, i);
+    }
+
+    /* Only the newest four survive, oldest first */
+    cwnet_capture_export_t exp;
+    cwnet_capture_export_begin(&exp, &s_cap);
+    size_t total = export_all(&exp);
+    TEST_ASSERT_EQUAL_UINT32(4, exp.records);
+    TEST_ASSERT_EQUAL(24 + 4 * (16 + 40 + 1), total);
+    TEST_ASSERT_EQUAL_UINT8(2, s_pcap[24 + 16 + 40]);
+    TEST_ASSERT_EQUAL_UINT8(5, s_pcap[24 + 3 * 57 + 16 + 40]);
+
+    /* Writer laps the snapshot mid-export: reused slots are skipped */
+    cwnet_capture_export_begin(&exp, &s_cap);
+    for (uint8_t i = 6; i < 8; i++) {
+        cwnet_capture_frame(&s_cap, CWNET_CAPTURE_TX, CWNET_CAPTURE_TCP, &k_tcp, &i, 1, i);
+    }
+    export_all(&exp);
+    TEST_ASSERT_EQUAL_UINT32(2, exp.records);
+    TEST_ASSERT_EQUAL_UINT32(2, exp.lost);
+    TEST_ASSERT_EQUAL_UINT8(4, s_pcap[24 + 16 + 40]);
+
+    /* No storage: an empty but valid file */
+    cwnet_capture_init(&s_cap, NULL, 0);
+    cwnet_capture_enable(&s_cap, true);
+    cwnet_capture_frame(&s_cap, CWNET_CAPTURE_TX, CWNET_CAPTURE_TCP, &k_tcp, s_pcap, 1, 0);
+    cwnet_capture_export_begin(&exp, &s_cap);
+    TEST_ASSERT_EQUAL(24, export_all(&exp));
+}
@@ -21,6 +21,8 @@ static cwnet_client_t client;
 /* Mock data for testing */
 static uint8_t mock_tx_buffer[256];
 static size_t mock_tx_len;
+static int mock_send_calls;
+static int mock_send_limit = -1;   /* Bytes one send() accepts, -1 = all */
 static bool mock_connected;
 static int32_t mock_time_ms;
 
@@ -30,6 +32,10 @@ static int mock_send(const uint8_t *data, size_t len, void *user_data) {
     if (len > sizeof(mock_tx_buffer)) {
         return -1;
     }
+    mock_send_calls++;
+    if (mock_send_limit >= 0 && len > (size_t)mock_send_limit) {
+        len = (size_t)mock_send_limit;
+    }
     memcpy(mock_tx_buffer, data, len);
     mock_tx_len = len;
     return (int)len;
@@ -45,6 +51,8 @@ static void test_setup(void) {
     memset(&client, 0, sizeof(client));
     memset(mock_tx_buffer, 0, sizeof(mock_tx_buffer));
     mock_tx_len = 0;
+    mock_send_calls = 0;
+    mock_send_limit = -1;
     mock_connected = false;
     mock_time_ms = 1000;
 }
@@ -301,6 +309,36 @@ void test_client_syncs_timer_on_ping_request(void) {
     TEST_ASSERT_EQUAL(5000, synced_after);
 }
 
+void test_client_on_frame_wrapped_payload(void) {
+    cwnet_client_config_t config = {
+        .server_host = "test.server.com",
+        .server_port = 7373,
+        .username = "TEST",
+        .send_cb = mock_send,
+        .get_time_ms_cb = mock_get_time_ms,
+        .user_data = NULL
+    };
+
+    cwnet_client_init(&client, &config);
+    cwnet_client_on_connected(&client);
+
+    /* PING REQUEST payload split by the receive ring wrap: 5 + 11 bytes */
+    const uint8_t head[] = { 0x00, 0x01, 0x00, 0x00, 0x88 };
+    const uint8_t tail[] = { 0x13, 0x00, 0x00,           /* t0 = 5000 */
+                             0x00, 0x00, 0x00, 0x00,
+                             0x00, 0x00, 0x00, 0x00 };
+    cwnet_frame_view_t frame = {
+        .command = 0x03,
+        .payload_len = CWNET_PING_PAYLOAD_SIZE,
+        .a = head, .na = sizeof(head),
+        .b = tail, .nb = sizeof(tail)
+    };
+
+    mock_time_ms = 100;
+    cwnet_client_on_frame(&client, &frame);
+    TEST_ASSERT_EQUAL(5000, cwnet_client_get_synced_time(&client));
+}
+
 void test_client_updates_latency_on_ping_response2(void) {
     cwnet_client_config_t config = {
         .server_host = "test.server.com",
@@ -569,3 +607,115 @@ void run_cwnet_client_tests(void) {
     RUN_TEST(test_client_handles_fragmented_frame);
     RUN_TEST(test_client_handles_ping_in_fragments);
 }
+
+void test_client_sends_key_event_at_edge_time(void) {
+    cwnet_client_config_t config = {
+        .server_host = "test.server.com",
+        .server_port = 7373,
+        .username = "TEST",
+        .send_cb = mock_send,
+        .get_time_ms_cb = mock_get_time_ms,
+        .user_data = NULL
+    };
+
+    cwnet_client_init(&client, &config);
+    cwnet_client_on_connected(&client);
+
+    uint8_t welcome[] = {0x00};
+    cwnet_client_on_data(&client, welcome, sizeof(welcome));
+    mock_tx_len = 0;
+
+    /* Edge happened 80ms before the drain */
+    mock_time_ms = 5080;
+    cwnet_client_err_t err = cwnet_client_send_key_event_at(&client, true, 5000);
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, err);
+    TEST_ASSERT_EQUAL(6, mock_tx_len);
+    TEST_ASSERT_EQUAL(0x55, mock_tx_buffer[0]);
+
+    /* Timestamp is the synced edge time, not now */
+    uint32_t expected = (uint32_t)cwnet_timer_read_synced_ms(&client.timer, 5000);
+    uint32_t ts = (uint32_t)mock_tx_buffer[2] | ((uint32_t)mock_tx_buffer[3] << 8) |
+                  ((uint32_t)mock_tx_buffer[4] << 16) | ((uint32_t)mock_tx_buffer[5] << 24);
+    TEST_ASSERT_EQUAL(expected, ts);
+    TEST_ASSERT_NOT_EQUAL((uint32_t)cwnet_timer_read_synced_ms(&client.timer, 5080), ts);
+}
+
+/*===========================================================================*/
+/* Send Coalescing Tests                                                     */
+/*===========================================================================*/
+
+/** Init in coalesce mode and reach READY (arena empty) */
+static void coalesce_setup(void) {
+    test_setup();
+    cwnet_client_config_t config = {
+        .server_host = "test.server.com",
+        .server_port = 7373,
+        .username = "TEST",
+        .send_cb = mock_send,
+        .get_time_ms_cb = mock_get_time_ms,
+        .user_data = NULL,
+        .coalesce = true
+    };
+    cwnet_client_init(&client, &config);
+    cwnet_client_on_connected(&client);
+    TEST_ASSERT_EQUAL(0, mock_send_calls);      /* CONNECT is queued too */
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_flush(&client));
+    TEST_ASSERT_EQUAL(1, mock_send_calls);
+
+    uint8_t welcome[] = {0x00};
+    cwnet_client_on_data(&client, welcome, sizeof(welcome));
+    TEST_ASSERT_EQUAL(CWNET_STATE_READY, cwnet_client_get_state(&client));
+    mock_send_calls = 0;
+}
+
+void test_client_coalesces_key_events(void) {
+    coalesce_setup();
+
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_send_key_event_at(&client, true, 1000));
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_send_key_event_at(&client, false, 1060));
+    TEST_ASSERT_EQUAL(0, mock_send_calls);
+    TEST_ASSERT_EQUAL(12, cwnet_client_tx_pending(&client));
+
+    /* Both frames in one send(), in order */
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_flush(&client));
+    TEST_ASSERT_EQUAL(1, mock_send_calls);
+    TEST_ASSERT_EQUAL(12, mock_tx_len);
+    TEST_ASSERT_EQUAL_HEX8(0x55, mock_tx_buffer[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x54, mock_tx_buffer[6]);
+    TEST_ASSERT_EQUAL(0, cwnet_client_tx_pending(&client));
+
+    /* Nothing queued: flush does not call send */
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_flush(&client));
+    TEST_ASSERT_EQUAL(1, mock_send_calls);
+}
+
+void test_client_coalesce_partial_send(void) {
+    coalesce_setup();
+
+    cwnet_client_send_key_event_at(&client, true, 1000);
+    cwnet_client_send_key_event_at(&client, false, 1060);
+
+    /* Socket takes 8 of 12 bytes: the rest stays queued, in order */
+    mock_send_limit = 8;
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_flush(&client));
+    TEST_ASSERT_EQUAL(4, cwnet_client_tx_pending(&client));
+
+    mock_send_limit = -1;
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_flush(&client));
+    TEST_ASSERT_EQUAL(4, mock_tx_len);
+    TEST_ASSERT_EQUAL(0, cwnet_client_tx_pending(&client));
+}
+
+void test_client_coalesce_arena_full_flushes(void) {
+    coalesce_setup();
+
+    /* 42 events * 6 bytes = 252 fit; the 43rd forces a flush first */
+    for (int i = 0; i < 42; i++) {
+        cwnet_client_send_key_event_at(&client, (i & 1) == 0, 1000 + i);
+    }
+    TEST_ASSERT_EQUAL(0, mock_send_calls);
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_send_key_event_at(&client, false, 2000));
+    TEST_ASSERT_EQUAL(1, mock_send_calls);
+    TEST_ASSERT_EQUAL(252, mock_tx_len);
+    TEST_ASSERT_EQUAL(6, cwnet_client_tx_pending(&client));
+}
@@ -0,0 +1,118 @@
+/**
+ * @file test_cwnet_jitter.c
+ * @brief Unit tests for the CWNet receive jitter buffer
+ */
+
+#include "unity.h"
+#include "cwnet_jitter.h"
+
+static cwnet_jitter_t s_jb;
+
+void test_cwnet_jitter_preserves_timing(void) {
+    cwnet_jitter_init(&s_jb);
+    cwnet_jitter_seed_rtt(&s_jb, 60);   /* Seed margin 30ms */
+
+    /* Dit (60ms) sent at 1000, arriving with varying delay */
+    TEST_ASSERT_TRUE(cwnet_jitter_push(&s_jb, true, 1000, 1020));
+    TEST_ASSERT_TRUE(cwnet_jitter_push(&s_jb, false, 1060, 1095));
+    TEST_ASSERT_EQUAL(2, cwnet_jitter_pending(&s_jb));
+    TEST_ASSERT_EQUAL(30, cwnet_jitter_margin_ms(&s_jb));
+
+    /* Anchored on the first event: play = event + 20 + 30 */
+    cwnet_jitter_event_t ev;
+    TEST_ASSERT_FALSE(cwnet_jitter_pop(&s_jb, 1049, &ev));
+    TEST_ASSERT_TRUE(cwnet_jitter_pop(&s_jb, 1050, &ev));
+    TEST_ASSERT_TRUE(ev.key_down);
+    TEST_ASSERT_EQUAL(1050, ev.play_ms);
+
+    /* Same offset inside the element: mark length is exactly 60ms */
+    TEST_ASSERT_FALSE(cwnet_jitter_pop(&s_jb, 1109, &ev));
+    TEST_ASSERT_TRUE(cwnet_jitter_pop(&s_jb, 1110, &ev));
+    TEST_ASSERT_FALSE(ev.key_down);
+    TEST_ASSERT_EQUAL(1110, ev.play_ms);
+    TEST_ASSERT_EQUAL(0, s_jb.late);
+}
+
+void test_cwnet_jitter_adapts_margin(void) {
+    cwnet_jitter_init(&s_jb);
+    cwnet_jitter_seed_rtt(&s_jb, 400);  /* Pessimistic seed: 200ms */
+
+    /* Steady link: 40ms transit, +/-1ms */
+    int32_t t = 0;
+    cwnet_jitter_event_t ev;
+    for (int i = 0; i < 40; i++) {
+        bool down = (i & 1) == 0;
+        int32_t arrival = t + 40 + (i % 3 == 0 ? 1 : 0);
+        cwnet_jitter_push(&s_jb, down, t, arrival);
+        while (cwnet_jitter_pop(&s_jb, arrival + 1000, &ev)) {
+        }
+        t += 60;
+    }
+    /* Quiet link shrinks the margin to the floor at the next key-down */
+    cwnet_jitter_push(&s_jb, true, t, t + 40);
+    TEST_ASSERT_EQUAL(CWNET_JITTER_MIN_MS, cwnet_jitter_margin_ms(&s_jb));
+    while (cwnet_jitter_pop(&s_jb, t + 1000, &ev)) {
+    }
+    cwnet_jitter_push(&s_jb, false, t + 60, t + 100);
+    while (cwnet_jitter_pop(&s_jb, t + 2000, &ev)) {
+    }
+    t += 120;
+
+    /* Jittery link (0..80ms extra) grows it */
+    for (int i = 0; i < 40; i++) {
+        bool down = (i & 1) == 0;
+        int32_t arrival = t + 40 + ((i * 37) % 80);
+        cwnet_jitter_push(&s_jb, down, t, arrival);
+        while (cwnet_jitter_pop(&s_jb, arrival + 1000, &ev)) {
+        }
+        t += 60;
+    }
+    cwnet_jitter_push(&s_jb, true, t, t + 40);
+    TEST_ASSERT_TRUE(cwnet_jitter_margin_ms(&s_jb) > 40);
+    TEST_ASSERT_TRUE(cwnet_jitter_margin_ms(&s_jb) <= CWNET_JITTER_MAX_MS);
+}
+
+void test_cwnet_jitter_late_event_keeps_order(void) {
+    cwnet_jitter_init(&s_jb);
+
+    TEST_ASSERT_TRUE(cwnet_jitter_push(&s_jb, true, 0, 10));
+    /* Key-up delayed far beyond the margin: due immediately, never before key-down */
+    TEST_ASSERT_TRUE(cwnet_jitter_push(&s_jb, false, 60, 300));
+    TEST_ASSERT_EQUAL(1, s_jb.late);
+
+    cwnet_jitter_event_t ev;
+    TEST_ASSERT_TRUE(cwnet_jitter_pop(&s_jb, 300, &ev));
+    TEST_ASSERT_TRUE(ev.key_down);
+    TEST_ASSERT_TRUE(cwnet_jitter_pop(&s_jb, 300, &ev));
+    TEST_ASSERT_FALSE(ev.key_down);
+    TEST_ASSERT_FALSE(cwnet_jitter_pop(&s_jb, 300, &ev));
+}
+
+void test_cwnet_jitter_overflow(void) {
+    cwnet_jitter_init(&s_jb);
+    for (int i = 0; i < CWNET_JITTER_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(cwnet_jitter_push(&s_jb, (i & 1) == 0, i * 10, i * 10));
+    }
+    TEST_ASSERT_FALSE(cwnet_jitter_push(&s_jb, true, 10000, 10000));
+    TEST_ASSERT_EQUAL(1, s_jb.overflow);
+    TEST_ASSERT_EQUAL(CWNET_JITTER_CAPACITY, cwnet_jitter_pending(&s_jb));
+}
+
+void test_cwnet_jitter_floor(void) {
+    cwnet_jitter_init(&s_jb);
+    cwnet_jitter_set_floor(&s_jb, 80);
+    cwnet_jitter_seed_rtt(&s_jb, 20);   /* Seed 10ms, below the floor */
+
+    TEST_ASSERT_TRUE(cwnet_jitter_push(&s_jb, true, 1000, 1015));
+    TEST_ASSERT_EQUAL(80, cwnet_jitter_margin_ms(&s_jb));
+    TEST_ASSERT_EQUAL(95, cwnet_jitter_delay_ms(&s_jb));
+
+    cwnet_jitter_event_t ev;
+    TEST_ASSERT_FALSE(cwnet_jitter_pop(&s_jb, 1094, &ev));
+    TEST_ASSERT_TRUE(cwnet_jitter_pop(&s_jb, 1095, &ev));
+
+    /* Re-init drops the floor */
+    cwnet_jitter_init(&s_jb);
+    cwnet_jitter_push(&s_jb, true, 1000, 1015);
+    TEST_ASSERT_EQUAL(CWNET_JITTER_MIN_MS, cwnet_jitter_margin_ms(&s_jb));
+}
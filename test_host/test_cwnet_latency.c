@@ -0,0 +1,62 @@
+/**
+ * @file test_cwnet_latency.c
+ * @brief Unit tests for the CWNet edge-to-send latency histogram
+ */
+
+#include "unity.h"
+#include "cwnet_latency.h"
+
+void test_cwnet_latency_bins(void) {
+    TEST_ASSERT_EQUAL(0, cwnet_latency_bin(0));
+    TEST_ASSERT_EQUAL(1, cwnet_latency_bin(1));
+    TEST_ASSERT_EQUAL(2, cwnet_latency_bin(2));
+    TEST_ASSERT_EQUAL(2, cwnet_latency_bin(3));
+    TEST_ASSERT_EQUAL(11, cwnet_latency_bin(1500));
+    TEST_ASSERT_EQUAL(CWNET_LATENCY_HIST_BINS - 1, cwnet_latency_bin(UINT32_MAX));
+}
+
+void test_cwnet_latency_record(void) {
+    cwnet_latency_t lat;
+    cwnet_latency_init(&lat);
+
+    cwnet_latency_record(&lat, 1500);
+    cwnet_latency_record(&lat, 200);
+    cwnet_latency_record(&lat, -5);   /* Clock skew: counts as 0 */
+    cwnet_latency_record(&lat, 9000);
+
+    cwnet_latency_snapshot_t snap;
+    cwnet_latency_get(&lat, &snap);
+    TEST_ASSERT_EQUAL(4, snap.count);
+    TEST_ASSERT_EQUAL(0, snap.min_us);
+    TEST_ASSERT_EQUAL(9000, snap.max_us);
+    TEST_ASSERT_EQUAL(1, snap.hist[0]);
+    TEST_ASSERT_EQUAL(1, snap.hist[cwnet_latency_bin(200)]);
+    TEST_ASSERT_EQUAL(1, snap.hist[cwnet_latency_bin(1500)]);
+    TEST_ASSERT_EQUAL(1, snap.hist[cwnet_latency_bin(9000)]);
+
+    cwnet_latency_init(&lat);
+    cwnet_latency_get(&lat, &snap);
+    TEST_ASSERT_EQUAL(0, snap.count);
+}
+
+void test_cwnet_latency_percentiles(void) {
+    cwnet_latency_t lat;
+    cwnet_latency_init(&lat);
+
+    cwnet_latency_snapshot_t snap;
+    cwnet_latency_get(&lat, &snap);
+    TEST_ASSERT_EQUAL(0, cwnet_latency_percentile_us(&snap, 50));
+
+    /* 98 edges at ~300us, one at 5ms, one at 40ms */
+    for (int i = 0; i < 98; i++) {
+        cwnet_latency_record(&lat, 300);
+    }
+    cwnet_latency_record(&lat, 5000);
+    cwnet_latency_record(&lat, 40000);
+    cwnet_latency_get(&lat, &snap);
+
+    /* 300us lands in [256, 512): reported as the bin's upper edge */
+    TEST_ASSERT_EQUAL(511, cwnet_latency_percentile_us(&snap, 50));
+    TEST_ASSERT_EQUAL(8191, cwnet_latency_percentile_us(&snap, 99));
+    TEST_ASSERT_EQUAL(40000, cwnet_latency_percentile_us(&snap, 100));
+}
@@ -0,0 +1,206 @@
+/**
+ * @file test_cwnet_peer.c
+ * @brief Unit tests for the CWNet peer-to-peer listener session
+ *
+ * A real cwnet_client is wired to a cwnet_peer through two byte queues,
+ * each side on its own clock, so the handshake and time mastering are
+ * exercised exactly as two keyers on a LAN would run them.
+ */
+
+#include "unity.h"
+#include "cwnet_peer.h"
+#include <string.h>
+
+typedef struct {
+    uint8_t data[512];
+    size_t len;
+} pipe_t;
+
+static pipe_t s_to_peer;
+static pipe_t s_to_client;
+static int32_t s_peer_ms;
+static int32_t s_client_ms;
+
+static cwnet_client_t s_client;
+static cwnet_peer_t s_peer;
+
+static bool s_peer_ev_down;
+static int32_t s_peer_ev_ts;
+static int s_peer_ev_count;
+static bool s_client_ev_down;
+static int32_t s_client_ev_ts;
+static int s_client_ev_count;
+
+static int pipe_write(pipe_t *p, const uint8_t *data, size_t len) {
+    if (p->len + len > sizeof(p->data)) {
+        return -1;
+    }
+    memcpy(&p->data[p->len], data, len);
+    p->len += len;
+    return (int)len;
+}
+
+static int client_send(const uint8_t *data, size_t len, void *user_data) {
+    (void)user_data;
+    return pipe_write(&s_to_peer, data, len);
+}
+
+static int peer_send(const uint8_t *data, size_t len, void *user_data) {
+    (void)user_data;
+    return pipe_write(&s_to_client, data, len);
+}
+
+static int32_t client_time(void *user_data) {
+    (void)user_data;
+    return s_client_ms;
+}
+
+static int32_t peer_time(void *user_data) {
+    (void)user_data;
+    return s_peer_ms;
+}
+
+static void client_event(bool key_down, int32_t timestamp_ms, void *user_data) {
+    (void)user_data;
+    s_client_ev_down = key_down;
+    s_client_ev_ts = timestamp_ms;
+    s_client_ev_count++;
+}
+
+static void peer_event(bool key_down, int32_t timestamp_ms, void *user_data) {
+    (void)user_data;
+    s_peer_ev_down = key_down;
+    s_peer_ev_ts = timestamp_ms;
+    s_peer_ev_count++;
+}
+
+/** Deliver queued bytes both ways until the link is quiet */
+static void pump(void) {
+    while (s_to_peer.len > 0 || s_to_client.len > 0) {
+        uint8_t buf[512];
+        size_t n = s_to_peer.len;
+        memcpy(buf, s_to_peer.data, n);
+        s_to_peer.len = 0;
+        cwnet_peer_on_data(&s_peer, buf, n);
+
+        n = s_to_client.len;
+        memcpy(buf, s_to_client.data, n);
+        s_to_client.len = 0;
+        cwnet_client_on_data(&s_client, buf, n);
+    }
+}
+
+static void setup_link(void) {
+    memset(&s_to_peer, 0, sizeof(s_to_peer));
+    memset(&s_to_client, 0, sizeof(s_to_client));
+    s_peer_ms = 50000;
+    s_client_ms = 1200;     /* Booted much later than the listener */
+    s_peer_ev_count = 0;
+    s_client_ev_count = 0;
+
+    cwnet_client_config_t ccfg = {
+        .server_host = "keyer-a.local",
+        .server_port = 7355,
+        .username = "IU3QEZ",
+        .send_cb = client_send,
+        .get_time_ms_cb = client_time,
+        .cw_event_cb = client_event,
+    };
+    cwnet_peer_config_t pcfg = {
+        .send_cb = peer_send,
+        .get_time_ms_cb = peer_time,
+        .cw_event_cb = peer_event,
+    };
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_client_init(&s_client, &ccfg));
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_peer_init(&s_peer, &pcfg));
+}
+
+static void connect_link(void) {
+    cwnet_peer_on_accepted(&s_peer);
+    cwnet_client_on_connected(&s_client);
+    pump();
+}
+
+void test_cwnet_peer_handshake(void) {
+    setup_link();
+    TEST_ASSERT_EQUAL(CWNET_PEER_IDLE, cwnet_peer_get_state(&s_peer));
+
+    connect_link();
+
+    TEST_ASSERT_EQUAL(CWNET_PEER_READY, cwnet_peer_get_state(&s_peer));
+    TEST_ASSERT_EQUAL_STRING("IU3QEZ", s_peer.name);
+    TEST_ASSERT_EQUAL(CWNET_STATE_READY, cwnet_client_get_state(&s_client));
+
+    /* The client synced to the listener's clock on the first REQUEST */
+    TEST_ASSERT_EQUAL_INT32(s_peer_ms, cwnet_client_get_synced_time(&s_client));
+
+    /* Instant link: both ends measured a zero RTT */
+    TEST_ASSERT_EQUAL_INT32(0, cwnet_peer_get_latency_ms(&s_peer));
+    TEST_ASSERT_EQUAL_INT32(0, cwnet_client_get_latency_ms(&s_client));
+}
+
+void test_cwnet_peer_keying_both_ways(void) {
+    setup_link();
+    connect_link();
+
+    /* Client edge 5 ms in the past arrives on the listener's clock */
+    s_client_ms += 100;
+    s_peer_ms += 100;
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK,
+                      cwnet_client_send_key_event_at(&s_client, true, s_client_ms - 5));
+    pump();
+    TEST_ASSERT_EQUAL(1, s_peer_ev_count);
+    TEST_ASSERT_TRUE(s_peer_ev_down);
+    TEST_ASSERT_EQUAL_INT32(s_peer_ms - 5, s_peer_ev_ts);
+
+    /* Listener edge goes out unconverted and maps back to client time */
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK,
+                      cwnet_peer_send_key_event_at(&s_peer, false, s_peer_ms));
+    pump();
+    TEST_ASSERT_EQUAL(1, s_client_ev_count);
+    TEST_ASSERT_FALSE(s_client_ev_down);
+    TEST_ASSERT_EQUAL_INT32(s_peer_ms, s_client_ev_ts);
+    TEST_ASSERT_EQUAL_INT32(s_client_ms,
+                            cwnet_timer_server_to_local_ms(&s_client.timer, s_client_ev_ts));
+}
+
+void test_cwnet_peer_ping_period(void) {
+    setup_link();
+    connect_link();
+    uint8_t first_id = s_peer.ping_id;
+
+    /* Not due yet: nothing is sent */
+    s_peer_ms += CWNET_PEER_PING_MS - 1;
+    s_client_ms += CWNET_PEER_PING_MS - 1;
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_peer_poll(&s_peer));
+    TEST_ASSERT_EQUAL(0, s_to_client.len);
+
+    /* Due: the REQUEST resyncs the client, RTT follows */
+    s_peer_ms += 1;
+    s_client_ms += 1;
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_OK, cwnet_peer_poll(&s_peer));
+    TEST_ASSERT_EQUAL(18, s_to_client.len);
+    pump();
+    TEST_ASSERT_EQUAL_UINT8(first_id + 1, s_peer.ping_id);
+    TEST_ASSERT_EQUAL_INT32(0, cwnet_peer_get_latency_ms(&s_peer));
+    TEST_ASSERT_EQUAL_INT32(s_peer_ms, cwnet_client_get_synced_time(&s_client));
+}
+
+void test_cwnet_peer_ignores_events_before_connect(void) {
+    setup_link();
+    cwnet_peer_on_accepted(&s_peer);
+
+    /* CW_DOWN without a CONNECT first is dropped, and nothing is keyed back */
+    const uint8_t down[] = {0x55, 0x04, 0x10, 0x00, 0x00, 0x00};
+    cwnet_peer_on_data(&s_peer, down, sizeof(down));
+    TEST_ASSERT_EQUAL(0, s_peer_ev_count);
+    TEST_ASSERT_EQUAL(CWNET_PEER_WAIT_CONNECT, cwnet_peer_get_state(&s_peer));
+    TEST_ASSERT_EQUAL(CWNET_CLIENT_ERR_NOT_READY,
+                      cwnet_peer_send_key_event_at(&s_peer, true, s_peer_ms));
+
+    /* DISCONNECT ends the session */
+    connect_link();
+    const uint8_t bye[] = {0x02};
+    cwnet_peer_on_data(&s_peer, bye, sizeof(bye));
+    TEST_ASSERT_EQUAL(CWNET_PEER_IDLE, cwnet_peer_get_state(&s_peer));
+}
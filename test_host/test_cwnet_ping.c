@@ -113,6 +113,129 @@ void test_timer_null_safety(void) {
     TEST_ASSERT_EQUAL_INT32(0, synced);
 }
 
+void test_timer_server_to_local(void) {
+    cwnet_timer_t timer;
+    cwnet_timer_init(&timer);
+    cwnet_timer_sync_to_server(&timer, 5000, 1000);
+
+    /* Synced and local round-trip */
+    int32_t synced = cwnet_timer_read_synced_ms(&timer, 1500);
+    TEST_ASSERT_EQUAL_INT32(5500, synced);
+    TEST_ASSERT_EQUAL_INT32(1500, cwnet_timer_server_to_local_ms(&timer, synced));
+    TEST_ASSERT_EQUAL_INT32(777, cwnet_timer_server_to_local_ms(NULL, 777));
+}
+
+void test_timer_synced_us(void) {
+    cwnet_timer_t timer;
+    cwnet_timer_init(&timer);
+    cwnet_timer_sync_to_server(&timer, 5000, 1000);
+
+    /* Same estimate as the ms read, microseconds kept, no 2^31 wrap */
+    TEST_ASSERT_EQUAL_INT64(5500250, cwnet_timer_synced_us(&timer, 1500250));
+    timer.offset_ms = 2147483000LL;
+    TEST_ASSERT_EQUAL_INT64(2147483000000LL + 2000000, cwnet_timer_synced_us(&timer, 2000000));
+
+    /* Drift runs from the reference like the ms read: +100 ppm over 10 s */
+    timer.offset_ms = 4000;
+    timer.drift_ppm = 100;
+    TEST_ASSERT_EQUAL_INT64(11000000 + 4001000, cwnet_timer_synced_us(&timer, 11000000));
+    TEST_ASSERT_EQUAL_INT64(1234, cwnet_timer_synced_us(NULL, 1234));
+}
+
+/*===========================================================================*/
+/* Sync Filter Tests                                                         */
+/*===========================================================================*/
+
+/** Feed one REQUEST/RESPONSE_2 exchange into the filter */
+static void sync_exchange(cwnet_sync_t *sync, cwnet_timer_t *timer, uint8_t id,
+                          int32_t local_ms, int32_t server_ms, int32_t rtt_ms) {
+    cwnet_ping_t req = { .type = CWNET_PING_REQUEST, .id = id, .t0_ms = server_ms };
+    cwnet_sync_on_request(sync, timer, &req, local_ms);
+    cwnet_sync_on_rtt(sync, id, rtt_ms);
+}
+
+void test_sync_ignores_delayed_ping(void) {
+    cwnet_sync_t sync;
+    cwnet_timer_t timer;
+    cwnet_sync_init(&sync);
+    cwnet_timer_init(&timer);
+
+    for (uint8_t i = 0; i < 4; i++) {
+        int32_t local = 1000 * (int32_t)i;
+        sync_exchange(&sync, &timer, i, local, local + 5000, 20);
+    }
+    TEST_ASSERT_EQUAL_INT32(8000, cwnet_timer_read_synced_ms(&timer, 3000));
+
+    /* Queued 80 ms behind: single-shot sync would jump, the filter holds */
+    sync_exchange(&sync, &timer, 4, 4000, 4000 + 4920, 180);
+    TEST_ASSERT_EQUAL_INT32(9000, cwnet_timer_read_synced_ms(&timer, 4000));
+
+    cwnet_sync_stats_t st;
+    cwnet_sync_get_stats(&sync, &timer, 4000, &st);
+    TEST_ASSERT_EQUAL_INT64(5000, st.offset_ms);
+    TEST_ASSERT_EQUAL_INT32(-80, st.residual_ms);
+    TEST_ASSERT_EQUAL_INT32(20, st.rtt_min_ms);
+    TEST_ASSERT_EQUAL_INT32(180, st.rtt_ms);
+    TEST_ASSERT_TRUE(st.rtt_jitter_ms > 0);
+    TEST_ASSERT_EQUAL_UINT32(5, st.samples);
+}
+
+void test_sync_first_ping_is_raw(void) {
+    cwnet_sync_t sync;
+    cwnet_timer_t timer;
+    cwnet_sync_init(&sync);
+    cwnet_timer_init(&timer);
+
+    /* No RTT known yet: same result as cwnet_timer_sync_to_server() */
+    cwnet_ping_t req = { .type = CWNET_PING_REQUEST, .id = 1, .t0_ms = 10000 };
+    cwnet_sync_on_request(&sync, &timer, &req, 10020);
+    TEST_ASSERT_EQUAL_INT32(10000, cwnet_timer_read_synced_ms(&timer, 10020));
+
+    cwnet_sync_stats_t st;
+    cwnet_sync_get_stats(&sync, &timer, 10020, &st);
+    TEST_ASSERT_EQUAL_INT32(-1, st.rtt_min_ms);
+}
+
+void test_sync_estimates_drift(void) {
+    cwnet_sync_t sync;
+    cwnet_timer_t timer;
+    cwnet_sync_init(&sync);
+    cwnet_timer_init(&timer);
+
+    /* Server clock 250 ppm fast: offset grows 1 ms every 4 s */
+    for (uint8_t i = 0; i < 8; i++) {
+        int32_t local = 4000 * (int32_t)i;
+        sync_exchange(&sync, &timer, i, local, local + 1000 + local / 4000, 30);
+    }
+    cwnet_ping_t req = { .type = CWNET_PING_REQUEST, .id = 8, .t0_ms = 32000 + 1008 };
+    cwnet_sync_on_request(&sync, &timer, &req, 32000);
+    TEST_ASSERT_EQUAL_INT32(250, timer.drift_ppm);
+
+    /* Interpolated between PINGs: 40 s later the offset has moved 10 ms */
+    TEST_ASSERT_EQUAL_INT32(72000 + 1018, cwnet_timer_read_synced_ms(&timer, 72000));
+    TEST_ASSERT_EQUAL_INT32(72000, cwnet_timer_server_to_local_ms(&timer, 72000 + 1018));
+}
+
+void test_sync_resets_on_clock_step(void) {
+    cwnet_sync_t sync;
+    cwnet_timer_t timer;
+    cwnet_sync_init(&sync);
+    cwnet_timer_init(&timer);
+
+    sync_exchange(&sync, &timer, 0, 0, 5000, 20);
+    sync_exchange(&sync, &timer, 1, 1000, 6000, 20);
+
+    /* Server restarted with a new epoch: follow it at once */
+    cwnet_ping_t req = { .type = CWNET_PING_REQUEST, .id = 0, .t0_ms = 200 };
+    cwnet_sync_on_request(&sync, &timer, &req, 2000);
+    TEST_ASSERT_EQUAL_INT32(200, cwnet_timer_read_synced_ms(&timer, 2000));
+
+    cwnet_sync_stats_t st;
+    cwnet_sync_get_stats(&sync, &timer, 2000, &st);
+    TEST_ASSERT_EQUAL_UINT32(1, st.resets);
+    TEST_ASSERT_EQUAL_UINT32(1, st.samples);
+}
+
 /*===========================================================================*/
 /* PING Payload Parsing Tests                                                */
 /*===========================================================================*/
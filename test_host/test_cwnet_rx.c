@@ -0,0 +1,108 @@
+/**
+ * @file test_cwnet_rx.c
+ * @brief Unit tests for the zero-copy CWNet receive ring
+ */
+
+#include "unity.h"
+#include "cwnet_rx.h"
+#include <string.h>
+
+static cwnet_rx_ring_t s_rx;
+
+/** Simulate recv(): copy bytes in through the write spans */
+static void rx_feed(const uint8_t *data, size_t len) {
+    while (len > 0) {
+        uint8_t *dst;
+        size_t space = cwnet_rx_write_span(&s_rx, &dst);
+        TEST_ASSERT_TRUE(space > 0);
+        size_t n = (len < space) ? len : space;
+        memcpy(dst, data, n);
+        cwnet_rx_commit(&s_rx, n);
+        data += n;
+        len -= n;
+    }
+}
+
+void test_cwnet_rx_frames_in_place(void) {
+    cwnet_rx_init(&s_rx);
+
+    /* WELCOME (no payload), then CW_DOWN with a 4-byte short payload */
+    const uint8_t bytes[] = { 0x01, 0x55, 0x04, 0x10, 0x27, 0x00, 0x00 };
+    rx_feed(bytes, sizeof(bytes));
+
+    cwnet_frame_view_t f;
+    TEST_ASSERT_EQUAL(CWNET_RX_FRAME, cwnet_rx_next_frame(&s_rx, &f));
+    TEST_ASSERT_EQUAL_HEX8(0x01, f.command);
+    TEST_ASSERT_EQUAL(0, f.payload_len);
+    TEST_ASSERT_NULL(f.a);
+
+    TEST_ASSERT_EQUAL(CWNET_RX_FRAME, cwnet_rx_next_frame(&s_rx, &f));
+    TEST_ASSERT_EQUAL_HEX8(0x15, f.command);
+    TEST_ASSERT_EQUAL(4, f.payload_len);
+    TEST_ASSERT_EQUAL(4, f.na);
+    TEST_ASSERT_EQUAL(0, f.nb);
+    /* The view points into the ring itself: nothing was copied */
+    TEST_ASSERT_EQUAL_PTR(&s_rx.buf[3], f.a);
+    TEST_ASSERT_EQUAL_HEX8(0x10, f.a[0]);
+
+    TEST_ASSERT_EQUAL(CWNET_RX_NEED_MORE, cwnet_rx_next_frame(&s_rx, &f));
+    TEST_ASSERT_EQUAL(0, cwnet_rx_pending(&s_rx));
+}
+
+void test_cwnet_rx_fragmented_and_wrapped(void) {
+    cwnet_rx_init(&s_rx);
+
+    /* Move the read position to 6 bytes before the end of the ring */
+    static uint8_t filler[CWNET_RX_RING_SIZE - 6];
+    memset(filler, 0x01, sizeof(filler));
+    rx_feed(filler, sizeof(filler));
+    cwnet_frame_view_t f;
+    while (cwnet_rx_next_frame(&s_rx, &f) == CWNET_RX_FRAME) {
+    }
+
+    /* Long-block frame, 8-byte payload, arriving in two pieces */
+    const uint8_t frame[] = { 0x81, 0x08, 0x00, 1, 2, 3, 4, 5, 6, 7, 8 };
+    rx_feed(frame, 4);
+    TEST_ASSERT_EQUAL(CWNET_RX_NEED_MORE, cwnet_rx_next_frame(&s_rx, &f));
+    rx_feed(&frame[4], sizeof(frame) - 4);
+
+    /* Header fills the last 3 bytes; payload is 3 + 5 across the wrap */
+    TEST_ASSERT_EQUAL(CWNET_RX_FRAME, cwnet_rx_next_frame(&s_rx, &f));
+    TEST_ASSERT_EQUAL_HEX8(0x01, f.command);
+    TEST_ASSERT_EQUAL(8, f.payload_len);
+    TEST_ASSERT_EQUAL(3, f.na);
+    TEST_ASSERT_EQUAL(5, f.nb);
+    TEST_ASSERT_EQUAL_HEX8(1, f.a[0]);
+    TEST_ASSERT_EQUAL_PTR(s_rx.buf, f.b);
+    TEST_ASSERT_EQUAL_HEX8(4, f.b[0]);
+    TEST_ASSERT_EQUAL_HEX8(8, f.b[4]);
+}
+
+void test_cwnet_rx_skips_reserved_and_oversize(void) {
+    cwnet_rx_init(&s_rx);
+
+    /* Reserved category byte is skipped on its own */
+    const uint8_t bad[] = { 0xC0, 0x01 };
+    rx_feed(bad, sizeof(bad));
+    cwnet_frame_view_t f;
+    TEST_ASSERT_EQUAL(CWNET_RX_SKIPPED, cwnet_rx_next_frame(&s_rx, &f));
+    TEST_ASSERT_EQUAL(CWNET_RX_FRAME, cwnet_rx_next_frame(&s_rx, &f));
+    TEST_ASSERT_EQUAL_HEX8(0x01, f.command);
+
+    /* A payload larger than the ring is dropped as it streams in */
+    const uint8_t big[] = { 0x90, 0x00, 0x10 };   /* 4096 bytes */
+    rx_feed(big, sizeof(big));
+    static uint8_t body[1000];
+    uint32_t left = 4096;
+    while (left > 0) {
+        uint32_t n = (left < sizeof(body)) ? left : (uint32_t)sizeof(body);
+        rx_feed(body, n);
+        left -= n;
+        TEST_ASSERT_NOT_EQUAL(CWNET_RX_FRAME, cwnet_rx_next_frame(&s_rx, &f));
+    }
+    const uint8_t next[] = { 0x02 };
+    rx_feed(next, sizeof(next));
+    TEST_ASSERT_EQUAL(CWNET_RX_FRAME, cwnet_rx_next_frame(&s_rx, &f));
+    TEST_ASSERT_EQUAL_HEX8(0x02, f.command);
+    TEST_ASSERT_EQUAL(2, s_rx.skipped);
+}
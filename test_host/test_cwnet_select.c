@@ -0,0 +1,164 @@
+/**
+ * @file test_cwnet_select.c
+ * @brief Unit tests for failover server selection
+ */
+
+#include "unity.h"
+#include "cwnet_select.h"
+#include <string.h>
+
+/** Feed PING REQUESTs every interval_ms from start_ms, each with an RTT */
+static void feed_pings(cwnet_sync_t *sync, cwnet_timer_t *timer, int32_t start_ms,
+                       int32_t interval_ms, int count, int32_t rtt_ms) {
+    for (int i = 0; i < count; i++) {
+        /* Wrapping like the millisecond clock does; the server clock runs level */
+        int32_t local = (int32_t)((uint32_t)start_ms + (uint32_t)(i * interval_ms));
+        cwnet_ping_t req = {
+            .type = CWNET_PING_REQUEST,
+            .id = (uint8_t)i,
+            .t0_ms = local,
+        };
+        cwnet_sync_on_request(sync, timer, &req, local);
+        cwnet_sync_on_rtt(sync, (uint8_t)i, rtt_ms);
+    }
+}
+
+void test_cwnet_select_parse_list(void) {
+    cwnet_select_host_t out[3];
+
+    size_t n = cwnet_select_parse_list("a.example.org, 10.0.0.2:7400;;b:0  c:99999 d",
+                                       7373, out, 3);
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL_STRING("a.example.org", out[0].host);
+    TEST_ASSERT_EQUAL(7373, out[0].port);
+    TEST_ASSERT_EQUAL_STRING("10.0.0.2", out[1].host);
+    TEST_ASSERT_EQUAL(7400, out[1].port);
+    TEST_ASSERT_EQUAL_STRING("b", out[2].host);
+    TEST_ASSERT_EQUAL(7373, out[2].port);    /* Port 0 is not a port */
+
+    TEST_ASSERT_EQUAL(0, cwnet_select_parse_list(NULL, 7373, out, 3));
+    TEST_ASSERT_EQUAL(0, cwnet_select_parse_list(" , :7400 ", 7373, out, 3));
+
+    char longhost[CWNET_MAX_HOST_LEN + 10];
+    memset(longhost, 'x', sizeof(longhost) - 1);
+    longhost[sizeof(longhost) - 1] = '\0';
+    TEST_ASSERT_EQUAL(1, cwnet_select_parse_list(longhost, 7373, out, 3));
+    TEST_ASSERT_EQUAL(CWNET_MAX_HOST_LEN - 1, strlen(out[0].host));
+}
+
+void test_cwnet_select_score_needs_samples(void) {
+    cwnet_sync_t sync;
+    cwnet_timer_t timer;
+    cwnet_sync_stats_t st;
+
+    cwnet_sync_init(&sync);
+    cwnet_timer_init(&timer);
+    feed_pings(&sync, &timer, 0, 1000, CWNET_SELECT_PROBE_SAMPLES - 1, 40);
+    cwnet_sync_get_stats(&sync, &timer, 0, &st);
+    TEST_ASSERT_EQUAL(-1, cwnet_select_score(&st));
+
+    feed_pings(&sync, &timer, 2000, 1000, 1, 40);
+    cwnet_sync_get_stats(&sync, &timer, 0, &st);
+    TEST_ASSERT_EQUAL(40 + CWNET_SELECT_JITTER_WEIGHT * st.rtt_jitter_ms,
+                      cwnet_select_score(&st));
+
+    /* Jitter counts against a link with the same minimum RTT */
+    cwnet_sync_stats_t jittery = st;
+    jittery.rtt_jitter_ms = st.rtt_jitter_ms + 10;
+    TEST_ASSERT_TRUE(cwnet_select_score(&jittery) > cwnet_select_score(&st));
+}
+
+void test_cwnet_select_probe_then_park(void) {
+    cwnet_select_t sel;
+    cwnet_select_init(&sel, 4);
+
+    /* Active on 0: the standby walks 1, 2, 3 */
+    uint8_t c = cwnet_select_next(&sel, 0);
+    TEST_ASSERT_EQUAL(1, c);
+    cwnet_select_report(&sel, c, 80);
+    c = cwnet_select_next(&sel, 0);
+    TEST_ASSERT_EQUAL(2, c);
+    cwnet_select_fail(&sel, c);
+    c = cwnet_select_next(&sel, 0);
+    TEST_ASSERT_EQUAL(3, c);
+    cwnet_select_report(&sel, c, 50);
+
+    /* All probed: parks on the best, and stays there */
+    TEST_ASSERT_EQUAL(3, cwnet_select_next(&sel, 0));
+    TEST_ASSERT_EQUAL(3, cwnet_select_next(&sel, 0));
+
+    /* 3 took over: the old active was never probed, so it is tried first */
+    TEST_ASSERT_EQUAL(0, cwnet_select_next(&sel, 3));
+    cwnet_select_report(&sel, 0, 30);
+    TEST_ASSERT_EQUAL(0, cwnet_select_next(&sel, 3));
+
+    /* A new round probes again, round-robin, then parks on the best */
+    cwnet_select_new_round(&sel);
+    TEST_ASSERT_EQUAL(1, cwnet_select_next(&sel, 3));
+    cwnet_select_report(&sel, 1, 80);
+    TEST_ASSERT_EQUAL(2, cwnet_select_next(&sel, 3));
+    cwnet_select_fail(&sel, 2);
+    TEST_ASSERT_EQUAL(0, cwnet_select_next(&sel, 3));
+    cwnet_select_report(&sel, 0, 30);
+    TEST_ASSERT_EQUAL(0, cwnet_select_next(&sel, 3));
+}
+
+void test_cwnet_select_unreachable_and_small_groups(void) {
+    cwnet_select_t sel;
+
+    cwnet_select_init(&sel, 1);
+    TEST_ASSERT_EQUAL(CWNET_SELECT_NONE, cwnet_select_next(&sel, 0));
+
+    /* Nothing reachable: the standby keeps walking the others */
+    cwnet_select_init(&sel, 3);
+    cwnet_select_fail(&sel, 1);
+    cwnet_select_fail(&sel, 2);
+    uint8_t a = cwnet_select_next(&sel, 0);
+    uint8_t b = cwnet_select_next(&sel, 0);
+    TEST_ASSERT_TRUE(a != 0 && b != 0 && a != b);
+    TEST_ASSERT_EQUAL(2, sel.cand[1].failures + sel.cand[2].failures);
+
+    /* A score clears the failure count; a negative one is no score */
+    cwnet_select_report(&sel, 1, 20);
+    TEST_ASSERT_EQUAL(0, sel.cand[1].failures);
+    cwnet_select_report(&sel, 1, -1);
+    TEST_ASSERT_EQUAL(20, sel.cand[1].score_ms);
+}
+
+void test_cwnet_select_better_hysteresis(void) {
+    TEST_ASSERT_FALSE(cwnet_select_better(-1, 20));
+    TEST_ASSERT_FALSE(cwnet_select_better(60, -1));
+    TEST_ASSERT_FALSE(cwnet_select_better(60, 60 - CWNET_SELECT_HYSTERESIS_MS));
+    TEST_ASSERT_TRUE(cwnet_select_better(60, 60 - CWNET_SELECT_HYSTERESIS_MS - 1));
+}
+
+void test_cwnet_select_stale_after_missed_ping(void) {
+    cwnet_sync_t sync;
+    cwnet_timer_t timer;
+
+    cwnet_sync_init(&sync);
+    cwnet_timer_init(&timer);
+    TEST_ASSERT_EQUAL(0, cwnet_select_ping_interval_ms(&sync));
+    TEST_ASSERT_FALSE(cwnet_select_stale(&sync, 100000));
+
+    /* One PING: the interval is not known yet */
+    feed_pings(&sync, &timer, 10000, 2000, 1, 30);
+    TEST_ASSERT_FALSE(cwnet_select_stale(&sync, 100000));
+
+    /* PINGs at 10 s, then every 2 s (one 2.5 s gap) */
+    feed_pings(&sync, &timer, 12000, 2000, 3, 30);
+    feed_pings(&sync, &timer, 18500, 2000, 1, 30);
+    TEST_ASSERT_EQUAL(2500, cwnet_select_ping_interval_ms(&sync));
+
+    /* Stale once the next one is half an interval overdue */
+    TEST_ASSERT_FALSE(cwnet_select_stale(&sync, 18500 + 3750));
+    TEST_ASSERT_TRUE(cwnet_select_stale(&sync, 18500 + 3751));
+
+    /* Across the 32-bit millisecond wrap */
+    cwnet_sync_init(&sync);
+    feed_pings(&sync, &timer, INT32_MAX - 1500, 1000, 3, 30);
+    TEST_ASSERT_EQUAL(1000, cwnet_select_ping_interval_ms(&sync));
+    int32_t last = (int32_t)((uint32_t)INT32_MAX - 1500U + 2000U);
+    TEST_ASSERT_FALSE(cwnet_select_stale(&sync, (int32_t)((uint32_t)last + 1500U)));
+    TEST_ASSERT_TRUE(cwnet_select_stale(&sync, (int32_t)((uint32_t)last + 1501U)));
+}
@@ -0,0 +1,116 @@
+/**
+ * @file test_cwnet_udp.c
+ * @brief Unit tests for CWNet key edge datagrams
+ */
+
+#include "unity.h"
+#include "cwnet_udp.h"
+#include <string.h>
+
+static cwnet_udp_tx_t s_tx;
+static cwnet_udp_rx_t s_rx;
+
+typedef struct {
+    uint8_t data[CWNET_UDP_MAX_DATAGRAM];
+    size_t len;
+} datagram_t;
+
+/** Send edge n (alternating levels, 50 ms apart) */
+static datagram_t send_edge(uint32_t n) {
+    datagram_t d;
+    d.len = cwnet_udp_tx_build(&s_tx, (n & 1U) == 0, (int32_t)(1000 + 50 * n),
+                               d.data, sizeof(d.data));
+    return d;
+}
+
+void test_cwnet_udp_redundancy(void) {
+    cwnet_udp_tx_init(&s_tx);
+
+    datagram_t d0 = send_edge(0);
+    TEST_ASSERT_EQUAL(12, d0.len);              /* SEQ + one edge */
+    TEST_ASSERT_EQUAL_HEX8(0x70, d0.data[0]);   /* SEQ, short payload */
+    TEST_ASSERT_EQUAL_HEX8(0x55, d0.data[6]);   /* CW_DOWN */
+
+    send_edge(1);
+    send_edge(2);
+    send_edge(3);
+    datagram_t d4 = send_edge(4);
+    TEST_ASSERT_EQUAL(CWNET_UDP_MAX_DATAGRAM, d4.len);
+    TEST_ASSERT_EQUAL_HEX8(4, d4.data[2]);      /* Newest seq */
+
+    /* Too small a buffer builds nothing and records nothing */
+    uint8_t small[8];
+    TEST_ASSERT_EQUAL(0, cwnet_udp_tx_build(&s_tx, true, 0, small, sizeof(small)));
+    TEST_ASSERT_EQUAL(5, s_tx.seq);
+}
+
+void test_cwnet_udp_loss_repaired_by_next_datagram(void) {
+    cwnet_udp_tx_init(&s_tx);
+    cwnet_udp_rx_init(&s_rx);
+
+    datagram_t d0 = send_edge(0);
+    send_edge(1);                               /* Lost */
+    datagram_t d2 = send_edge(2);
+
+    cwnet_udp_edge_t e;
+    TEST_ASSERT_TRUE(cwnet_udp_rx_push(&s_rx, d0.data, d0.len, 0));
+    TEST_ASSERT_TRUE(cwnet_udp_rx_push(&s_rx, d2.data, d2.len, 10));
+
+    /* Edges 0, 1, 2 in order, no waiting; the repeat of 0 is a duplicate */
+    for (uint32_t n = 0; n < 3; n++) {
+        TEST_ASSERT_TRUE(cwnet_udp_rx_pop(&s_rx, 10, &e));
+        TEST_ASSERT_EQUAL_INT32(1000 + 50 * (int32_t)n, e.timestamp_ms);
+        TEST_ASSERT_EQUAL((n & 1U) == 0, e.key_down);
+    }
+    TEST_ASSERT_FALSE(cwnet_udp_rx_pop(&s_rx, 10, &e));
+    TEST_ASSERT_EQUAL(1, s_rx.duplicates);
+    TEST_ASSERT_EQUAL(0, s_rx.lost);
+}
+
+void test_cwnet_udp_reorder_and_hold(void) {
+    cwnet_udp_tx_init(&s_tx);
+    cwnet_udp_rx_init(&s_rx);
+
+    /* Burst loss longer than the redundancy: edges 1..4 never arrive */
+    datagram_t d[6];
+    for (uint32_t n = 0; n < 6; n++) {
+        d[n] = send_edge(n);
+    }
+
+    cwnet_udp_edge_t e;
+    TEST_ASSERT_TRUE(cwnet_udp_rx_push(&s_rx, d[0].data, d[0].len, 0));
+    TEST_ASSERT_TRUE(cwnet_udp_rx_pop(&s_rx, 0, &e));
+
+    /* d5 repeats 2..5: 1 is missing, so 2 waits */
+    TEST_ASSERT_TRUE(cwnet_udp_rx_push(&s_rx, d[5].data, d[5].len, 100));
+    TEST_ASSERT_FALSE(cwnet_udp_rx_pop(&s_rx, 100, &e));
+    TEST_ASSERT_FALSE(cwnet_udp_rx_pop(&s_rx, 100 + CWNET_UDP_HOLD_MS - 1, &e));
+
+    /* Hold expired: skip 1, deliver 2..5 */
+    TEST_ASSERT_TRUE(cwnet_udp_rx_pop(&s_rx, 100 + CWNET_UDP_HOLD_MS, &e));
+    TEST_ASSERT_EQUAL_INT32(1100, e.timestamp_ms);
+    TEST_ASSERT_EQUAL(1, s_rx.lost);
+    for (uint32_t n = 3; n < 6; n++) {
+        TEST_ASSERT_TRUE(cwnet_udp_rx_pop(&s_rx, 200, &e));
+        TEST_ASSERT_EQUAL_INT32(1000 + 50 * (int32_t)n, e.timestamp_ms);
+    }
+
+    /* A late, reordered datagram only produces duplicates */
+    TEST_ASSERT_TRUE(cwnet_udp_rx_push(&s_rx, d[3].data, d[3].len, 210));
+    TEST_ASSERT_FALSE(cwnet_udp_rx_pop(&s_rx, 210, &e));
+    TEST_ASSERT_EQUAL(5, s_rx.delivered);
+}
+
+void test_cwnet_udp_rejects_malformed(void) {
+    cwnet_udp_rx_init(&s_rx);
+
+    /* Edge without SEQ, truncated frame, and a TCP control frame */
+    const uint8_t no_seq[] = { 0x55, 0x04, 0, 0, 0, 0 };
+    const uint8_t truncated[] = { 0x70, 0x04, 0, 0, 0, 0, 0x55, 0x04, 0 };
+    const uint8_t control[] = { 0x70, 0x04, 0, 0, 0, 0, 0x01 };
+    TEST_ASSERT_FALSE(cwnet_udp_rx_push(&s_rx, no_seq, sizeof(no_seq), 0));
+    TEST_ASSERT_FALSE(cwnet_udp_rx_push(&s_rx, truncated, sizeof(truncated), 0));
+    TEST_ASSERT_FALSE(cwnet_udp_rx_push(&s_rx, control, sizeof(control), 0));
+    TEST_ASSERT_EQUAL(3, s_rx.malformed);
+    TEST_ASSERT_FALSE(s_rx.started);
+}
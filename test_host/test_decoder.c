@@ -6,6 +6,10 @@
 #include "unity.h"
 #include "decoder.h"
 #include "timing_classifier.h"
+#include "stream.h"
+
+/* Host-only hook in decoder.c */
+void decoder_set_test_stream(keying_stream_t *stream);
 
 void test_decoder_init(void) {
     decoder_init();
@@ -249,3 +253,193 @@ void test_decoder_get_text_with_timestamps(void) {
     TEST_ASSERT_EQUAL_CHAR('T', chars[1].character);
     TEST_ASSERT_EQUAL(4000, chars[1].timestamp_us);
 }
+
+/* Push `ticks` identical ticks of the given key state */
+static void push_key_ticks(keying_stream_t *stream, uint8_t key, uint32_t ticks) {
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    sample.local_key = key;
+    for (uint32_t i = 0; i < ticks; i++) {
+        stream_push(stream, sample);
+    }
+}
+
+void test_decoder_stream_sub_ms_ticks(void) {
+    static stream_slot_t buffer[64];
+    static keying_stream_t stream;
+    stream_init(&stream, buffer, 64);
+    stream_set_tick_period_us(&stream, 100);  /* 10 kHz stream */
+
+    decoder_set_test_stream(&stream);
+    decoder_init();
+    decoder_reset();
+
+    /* 'A' at 20 WPM: dit = 60ms = 600 ticks of 100us */
+    push_key_ticks(&stream, 0, 100);
+    push_key_ticks(&stream, 1, 600);   /* dit */
+    push_key_ticks(&stream, 0, 600);   /* intra-char gap */
+    push_key_ticks(&stream, 1, 1800);  /* dah */
+    push_key_ticks(&stream, 0, 1800);  /* char gap */
+    push_key_ticks(&stream, 1, 1);     /* next key down ends the gap */
+
+    decoder_process();
+
+    decoded_char_t last = decoder_get_last_char();
+    TEST_ASSERT_EQUAL_CHAR('A', last.character);
+
+    /* Timestamps are the edge tick in stream time: 100 + 600 + 600 + 1800 + 1800 */
+    TEST_ASSERT_EQUAL(490000, last.timestamp_us);
+
+    decoder_set_test_stream(NULL);
+}
+
+/* Push `ticks` key-down ticks carrying an iambic key tag */
+static void push_tagged_ticks(keying_stream_t *stream, uint8_t tag, uint32_t ticks) {
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    sample.local_key = 1;
+    sample = sample_with_key_tag(sample, tag);
+    for (uint32_t i = 0; i < ticks; i++) {
+        stream_push(stream, sample);
+    }
+}
+
+void test_decoder_stream_iambic_tags(void) {
+    static stream_slot_t buffer[64];
+    static keying_stream_t stream;
+    stream_init(&stream, buffer, 64);
+    stream_set_tick_period_us(&stream, 1000);
+
+    decoder_set_test_stream(&stream);
+    decoder_init();
+    decoder_reset();
+
+    /* 'A' with a dah far too light for the 20 WPM threshold: classified,
+     * it would read as 'I'; the keyer tags say dit, element gap, dah */
+    push_key_ticks(&stream, 0, 10);
+    push_tagged_ticks(&stream, KEY_TAG_ELEMENT, 60);
+    push_key_ticks(&stream, 0, 60);
+    push_tagged_ticks(&stream, KEY_TAG_ELEMENT | KEY_TAG_DAH | KEY_TAG_IN_CHAR, 100);
+    push_key_ticks(&stream, 0, 180);   /* char gap: still classified */
+    push_key_ticks(&stream, 1, 1);     /* untagged key down ends it */
+
+    decoder_process();
+
+    TEST_ASSERT_EQUAL_CHAR('A', decoder_get_last_char().character);
+    decoder_stats_t stats;
+    decoder_get_stats(&stats);
+    TEST_ASSERT_EQUAL(3, stats.tagged_events);
+
+    decoder_set_test_stream(NULL);
+}
+
+void test_decoder_stream_remote_lane(void) {
+    static stream_slot_t buffer[64];
+    static keying_stream_t stream;
+    static stream_producer_t remote;
+    stream_init(&stream, buffer, 64);
+    stream_set_tick_period_us(&stream, 1000);
+    stream_producer_init(&remote, &stream, STREAM_LANE_REMOTE);
+
+    decoder_set_test_stream(&stream);
+    decoder_init();
+    decoder_reset();
+
+    /* LOCAL key stays up: its silence is still pending when the REMOTE
+     * events land, so only their stamped ticks give the timing */
+    push_key_ticks(&stream, 0, 10);
+
+    /* TEXT lane samples are not keying and must be ignored */
+    stream_sample_t text = sample_with_lane(STREAM_SAMPLE_EMPTY, STREAM_LANE_TEXT);
+    text.local_key = 1;
+    stream_push_raw(&stream, text);
+
+    stream_producer_push(&remote, sample_remote_event(true, 100));   /* dit */
+    stream_producer_push(&remote, sample_remote_event(false, 160));
+    stream_producer_push(&remote, sample_remote_event(true, 220));   /* dah */
+    stream_producer_push(&remote, sample_remote_event(false, 400));
+    stream_producer_push(&remote, sample_remote_event(true, 580));   /* ends gap */
+
+    decoder_process();
+
+    decoded_char_t last = decoder_get_last_char();
+    TEST_ASSERT_EQUAL_CHAR('A', last.character);
+    TEST_ASSERT_EQUAL(580000, last.timestamp_us);
+
+    decoder_set_test_stream(NULL);
+}
+
+void test_decoder_instances_per_source(void) {
+    static stream_slot_t buffer[64];
+    static keying_stream_t stream;
+    static stream_producer_t remote;
+    static key_edge_ring_t ring;
+    static key_edge_stage_t stage;
+    static decoder_t local_dec;
+    static decoder_t remote_dec;
+    stream_init(&stream, buffer, 64);
+    stream_set_tick_period_us(&stream, 1000);
+    stream_producer_init(&remote, &stream, STREAM_LANE_REMOTE);
+
+    /* Both channels subscribe to one edge stage */
+    key_edge_ring_init(&ring, &stream);
+    key_edge_stage_init(&stage, &stream, &ring);
+    decoder_inst_init(&local_dec, &ring, DECODER_SOURCE_LOCAL_KEY);
+    decoder_inst_init(&remote_dec, &ring, DECODER_SOURCE_REMOTE);
+
+    /* LOCAL keys 'E' */
+    push_key_ticks(&stream, 0, 10);
+    push_key_ticks(&stream, 1, 60);    /* dit */
+    push_key_ticks(&stream, 0, 200);   /* char gap */
+    push_key_ticks(&stream, 1, 1);     /* ends gap */
+
+    /* REMOTE keys 'T' on the same stream */
+    stream_producer_push(&remote, sample_remote_event(true, 300));
+    stream_producer_push(&remote, sample_remote_event(false, 480));  /* dah */
+    stream_producer_push(&remote, sample_remote_event(true, 700));   /* ends gap */
+
+    key_edge_stage_run(&stage);
+    decoder_inst_process(&local_dec);
+    decoder_inst_process(&remote_dec);
+
+    char text[8];
+    TEST_ASSERT_EQUAL(1, decoder_inst_get_text(&local_dec, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("E", text);
+    TEST_ASSERT_EQUAL(1, decoder_inst_get_text(&remote_dec, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("T", text);
+    TEST_ASSERT_EQUAL(700000, decoder_inst_get_last_char(&remote_dec).timestamp_us);
+
+    /* Channels are independent of each other and of the default decoder */
+    decoder_inst_set_enabled(&local_dec, false);
+    TEST_ASSERT_TRUE(decoder_inst_is_enabled(&remote_dec));
+    decoder_inst_reset(&remote_dec);
+    TEST_ASSERT_EQUAL(0, decoder_inst_get_buffer_count(&remote_dec));
+    TEST_ASSERT_EQUAL(1, decoder_inst_get_buffer_count(&local_dec));
+}
+
+void test_decoder_inactivity_stream_time(void) {
+    static stream_slot_t buffer[64];
+    static keying_stream_t stream;
+    stream_init(&stream, buffer, 64);
+    stream_set_tick_period_us(&stream, 1000);
+
+    decoder_set_test_stream(&stream);
+    decoder_init();
+    decoder_reset();
+
+    /* 'E' with no key down after it: only elapsed stream time ends it */
+    push_key_ticks(&stream, 0, 10);
+    push_key_ticks(&stream, 1, 60);    /* dit */
+    push_key_ticks(&stream, 0, 300);   /* under 7 dits */
+
+    decoder_process();
+    TEST_ASSERT_EQUAL(0, decoder_get_buffer_count());
+    TEST_ASSERT_EQUAL(DECODER_STATE_RECEIVING, decoder_get_state());
+
+    push_key_ticks(&stream, 0, 200);   /* past 7 dits, still unwritten */
+    decoder_process();
+
+    decoded_char_t last = decoder_get_last_char();
+    TEST_ASSERT_EQUAL_CHAR('E', last.character);
+    TEST_ASSERT_EQUAL(570000, last.timestamp_us);
+
+    decoder_set_test_stream(NULL);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file test_espnow_frame.c
+ * @brief Unit tests for ESP-NOW key edge frames
+ */
+
+#include "unity.h"
+#include "espnow_frame.h"
+#include <string.h>
+
+static espnow_tx_t s_tx;
+static espnow_rx_t s_rx;
+
+typedef struct {
+    uint8_t data[ESPNOW_FRAME_MAX];
+    size_t len;
+} frame_t;
+
+/** Edge n: alternating levels 40 ms apart, sent 300 us after it happened */
+static frame_t send_edge(uint32_t n) {
+    frame_t f;
+    espnow_edge_t e = {
+        .time_us = 1000000U + 40000U * n,
+        .channel = 0,
+        .level = (uint8_t)((n & 1U) == 0),
+    };
+    f.len = espnow_tx_build(&s_tx, &e, e.time_us + 300U, f.data, sizeof(f.data));
+    return f;
+}
+
+void test_espnow_frame_redundancy(void) {
+    espnow_tx_init(&s_tx, 0x1234);
+
+    frame_t f0 = send_edge(0);
+    TEST_ASSERT_EQUAL(ESPNOW_FRAME_HEADER + ESPNOW_FRAME_EDGE_SIZE, f0.len);
+    TEST_ASSERT_EQUAL_HEX8('K', f0.data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x34, f0.data[3]);   /* Session LE */
+    TEST_ASSERT_EQUAL_HEX8(1, f0.data[5]);      /* Newest seq */
+
+    for (uint32_t n = 1; n < 6; n++) {
+        send_edge(n);
+    }
+    frame_t f6 = send_edge(6);
+    TEST_ASSERT_EQUAL(ESPNOW_FRAME_MAX, f6.len);
+    TEST_ASSERT_EQUAL_HEX8(7, f6.data[5]);
+    TEST_ASSERT_EQUAL_HEX8(ESPNOW_FRAME_REDUNDANCY, f6.data[11]);
+}
+
+void test_espnow_frame_receiver_clock(void) {
+    espnow_tx_init(&s_tx, 1);
+    espnow_rx_init(&s_rx);
+    espnow_edge_t out[ESPNOW_FRAME_REDUNDANCY];
+
+    /* Sender edge 300 us before the frame; arrival on an unrelated clock */
+    frame_t f = send_edge(0);
+    size_t n = espnow_rx_parse(&s_rx, f.data, f.len, 5000U, out, ESPNOW_FRAME_REDUNDANCY);
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL_UINT32(4700U, out[0].time_us);
+    TEST_ASSERT_EQUAL_UINT8(1, out[0].level);
+
+    /* Wraps of the 32-bit clocks cancel out */
+    f = send_edge(1);
+    n = espnow_rx_parse(&s_rx, f.data, f.len, 100U, out, ESPNOW_FRAME_REDUNDANCY);
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(100U - 300U), out[0].time_us);
+
+    /* Duplicates deliver nothing */
+    n = espnow_rx_parse(&s_rx, f.data, f.len, 200U, out, ESPNOW_FRAME_REDUNDANCY);
+    TEST_ASSERT_EQUAL(0, n);
+}
+
+void test_espnow_frame_loss_repaired(void) {
+    espnow_tx_init(&s_tx, 7);
+    espnow_rx_init(&s_rx);
+    espnow_edge_t out[ESPNOW_FRAME_REDUNDANCY];
+
+    frame_t f = send_edge(0);
+    espnow_rx_parse(&s_rx, f.data, f.len, 0U, out, ESPNOW_FRAME_REDUNDANCY);
+
+    /* Two frames lost: the third carries all three edges, oldest first */
+    send_edge(1);
+    send_edge(2);
+    f = send_edge(3);
+    size_t n = espnow_rx_parse(&s_rx, f.data, f.len, 200000U, out, ESPNOW_FRAME_REDUNDANCY);
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL_UINT8(0, out[0].level);   /* Edge 1 */
+    TEST_ASSERT_EQUAL_UINT8(1, out[1].level);   /* Edge 2 */
+    TEST_ASSERT_EQUAL_UINT32(out[1].time_us + 40000U, out[2].time_us);
+    TEST_ASSERT_EQUAL_UINT32(2, s_rx.repaired);
+    TEST_ASSERT_EQUAL_UINT32(0, s_rx.lost);
+
+    /* A gap wider than the redundancy is counted as lost */
+    for (uint32_t i = 4; i < 10; i++) {
+        f = send_edge(i);
+    }
+    n = espnow_rx_parse(&s_rx, f.data, f.len, 500000U, out, ESPNOW_FRAME_REDUNDANCY);
+    TEST_ASSERT_EQUAL(ESPNOW_FRAME_REDUNDANCY, n);
+    TEST_ASSERT_EQUAL_UINT32(2, s_rx.lost);
+}
+
+void test_espnow_frame_session_and_malformed(void) {
+    espnow_rx_init(&s_rx);
+    espnow_edge_t out[ESPNOW_FRAME_REDUNDANCY];
+
+    espnow_tx_init(&s_tx, 1);
+    for (uint32_t i = 0; i < 20; i++) {
+        send_edge(i);
+    }
+    frame_t f = send_edge(20);
+    espnow_rx_parse(&s_rx, f.data, f.len, 0U, out, ESPNOW_FRAME_REDUNDANCY);
+
+    /* Sender rebooted: new session, low seq, accepted without loss counts */
+    espnow_tx_init(&s_tx, 2);
+    send_edge(0);
+    f = send_edge(1);
+    TEST_ASSERT_EQUAL(1, espnow_rx_parse(&s_rx, f.data, f.len, 0U, out, ESPNOW_FRAME_REDUNDANCY));
+    TEST_ASSERT_EQUAL_UINT32(0, s_rx.lost);
+
+    /* Bad magic and truncated frames are rejected */
+    f.data[0] = 'X';
+    TEST_ASSERT_EQUAL(0, espnow_rx_parse(&s_rx, f.data, f.len, 0U, out, ESPNOW_FRAME_REDUNDANCY));
+    f.data[0] = 'K';
+    TEST_ASSERT_EQUAL(0, espnow_rx_parse(&s_rx, f.data, f.len - 1, 0U, out, ESPNOW_FRAME_REDUNDANCY));
+    TEST_ASSERT_EQUAL_UINT32(2, s_rx.rejected);
+}
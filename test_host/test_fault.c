@@ -55,3 +55,64 @@ void test_fault_count(void) {
     fault_set(&s_fault, FAULT_OVERRUN, 100);
     TEST_ASSERT_EQUAL(1, fault_get_count(&s_fault));
 }
+
+void test_fault_log_keeps_newest(void) {
+    static fault_log_t log;
+    fault_event_t out[FAULT_LOG_SIZE];
+
+    fault_log_init(&log);
+    TEST_ASSERT_EQUAL(0, fault_log_snapshot(&log, out, FAULT_LOG_SIZE));
+
+    fault_log_record(&log, 10, FAULT_EV_RAISED, FAULT_LATENCY_EXCEEDED, 12);
+    fault_log_record(&log, 20, FAULT_EV_RECOVERED, FAULT_NONE, 1);
+    TEST_ASSERT_EQUAL(2, fault_log_snapshot(&log, out, FAULT_LOG_SIZE));
+    TEST_ASSERT_EQUAL(10, out[0].time_us);
+    TEST_ASSERT_EQUAL(FAULT_LATENCY_EXCEEDED, out[0].code);
+    TEST_ASSERT_EQUAL(12, out[0].data);
+    TEST_ASSERT_EQUAL(FAULT_EV_RECOVERED, out[1].kind);
+
+    /* Wrapped: the oldest are gone, and max limits to the newest */
+    for (uint32_t i = 0; i < 2 * FAULT_LOG_SIZE; i++) {
+        fault_log_record(&log, 100 + i, FAULT_EV_RAISED, FAULT_OVERRUN, i);
+    }
+    size_t n = fault_log_snapshot(&log, out, FAULT_LOG_SIZE);
+    TEST_ASSERT_EQUAL(FAULT_LOG_SIZE - 1, n);
+    TEST_ASSERT_EQUAL(2 * FAULT_LOG_SIZE - 1, out[n - 1].data);
+    TEST_ASSERT_EQUAL(2, fault_log_snapshot(&log, out, 2));
+    TEST_ASSERT_EQUAL(2 * FAULT_LOG_SIZE - 2, out[0].data);
+}
+
+void test_fault_log_read_follows(void) {
+    static fault_log_t log;
+    fault_event_t out[FAULT_LOG_SIZE];
+    unsigned next = 0;
+
+    fault_log_init(&log);
+    TEST_ASSERT_EQUAL(0, fault_log_read(&log, &next, out, FAULT_LOG_SIZE));
+
+    fault_log_record(&log, 10, FAULT_EV_RAISED, FAULT_OVERRUN, 1);
+    fault_log_record(&log, 20, FAULT_EV_RECOVERED, FAULT_NONE, 2);
+    fault_log_record(&log, 30, FAULT_EV_RAISED, FAULT_OVERRUN, 3);
+    TEST_ASSERT_EQUAL(2, fault_log_read(&log, &next, out, 2));
+    TEST_ASSERT_EQUAL(1, out[0].data);
+    TEST_ASSERT_EQUAL(2, next);
+    TEST_ASSERT_EQUAL(1, fault_log_read(&log, &next, out, FAULT_LOG_SIZE));
+    TEST_ASSERT_EQUAL(3, out[0].data);
+    TEST_ASSERT_EQUAL(0, fault_log_read(&log, &next, out, FAULT_LOG_SIZE));
+
+    /* Fell behind the ring: skips to what is left, the position says how far */
+    for (uint32_t i = 0; i < 2 * FAULT_LOG_SIZE; i++) {
+        fault_log_record(&log, 100 + i, FAULT_EV_RAISED, FAULT_OVERRUN, 100 + i);
+    }
+    size_t n = fault_log_read(&log, &next, out, FAULT_LOG_SIZE);
+    TEST_ASSERT_EQUAL(FAULT_LOG_SIZE - 1, n);
+    TEST_ASSERT_EQUAL(3 + 2 * FAULT_LOG_SIZE, next);
+    TEST_ASSERT_EQUAL(100 + 2 * FAULT_LOG_SIZE - 1, out[n - 1].data);
+
+    /* Ahead of a log that was reset: starts again from its first event */
+    fault_log_init(&log);
+    fault_log_record(&log, 5, FAULT_EV_RAISED, FAULT_HARDWARE, 7);
+    TEST_ASSERT_EQUAL(1, fault_log_read(&log, &next, out, FAULT_LOG_SIZE));
+    TEST_ASSERT_EQUAL(7, out[0].data);
+    TEST_ASSERT_EQUAL(1, next);
+}
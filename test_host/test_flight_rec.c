@@ -0,0 +1,93 @@
+/**
+ * @file test_flight_rec.c
+ * @brief Unit tests for the RTC flight recorder
+ */
+
+#include "unity.h"
+#include "flight_rec.h"
+#include <string.h>
+
+static flight_rec_t s_rec;
+static flight_rec_event_t s_out[FLIGHT_REC_MAX_EVENTS];
+
+void test_flight_rec_wipes_noise_and_keeps_valid(void) {
+    /* Power-on: RTC memory holds garbage */
+    memset(&s_rec, 0x5A, sizeof(s_rec));
+    TEST_ASSERT_FALSE(flight_rec_boot(&s_rec, 1, 10));
+    TEST_ASSERT_EQUAL_UINT32(1, s_rec.boot_count);
+
+    size_t n = flight_rec_snapshot(&s_rec, s_out, FLIGHT_REC_MAX_EVENTS);
+    TEST_ASSERT_EQUAL_size_t(1, n);
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_EV_BOOT, s_out[0].type);
+    TEST_ASSERT_EQUAL_UINT8(1, s_out[0].code);
+
+    flight_rec_rt(&s_rec, 500, FLIGHT_EV_FAULT, 2, 37);
+
+    /* Soft reset (e.g. panic): contents survive, boot logged after them */
+    TEST_ASSERT_TRUE(flight_rec_boot(&s_rec, 4, 20));
+    n = flight_rec_snapshot(&s_rec, s_out, FLIGHT_REC_MAX_EVENTS);
+    TEST_ASSERT_EQUAL_size_t(3, n);
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_EV_FAULT, s_out[1].type);
+    TEST_ASSERT_EQUAL_UINT32(37, s_out[1].value);
+    TEST_ASSERT_EQUAL_UINT16(1, s_out[1].boot);
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_EV_BOOT, s_out[2].type);
+    TEST_ASSERT_EQUAL_UINT8(4, s_out[2].code);
+    TEST_ASSERT_EQUAL_UINT16(2, s_out[2].boot);
+}
+
+void test_flight_rec_merges_lanes_in_order(void) {
+    memset(&s_rec, 0, sizeof(s_rec));
+    flight_rec_boot(&s_rec, 1, 0);
+
+    flight_rec_rt(&s_rec, 100, FLIGHT_EV_EDGE, 1, 0);
+    flight_rec_bg(&s_rec, 150, FLIGHT_EV_STAGE, 0, 900);
+    flight_rec_rt(&s_rec, 200, FLIGHT_EV_EDGE, 0, 100);
+    flight_rec_rt(&s_rec, 300, FLIGHT_EV_FAULT, 2, 12);
+
+    size_t n = flight_rec_snapshot(&s_rec, s_out, FLIGHT_REC_MAX_EVENTS);
+    TEST_ASSERT_EQUAL_size_t(5, n);
+    for (size_t i = 1; i < n; i++) {
+        TEST_ASSERT_TRUE(s_out[i - 1].time_us <= s_out[i].time_us);
+    }
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_EV_STAGE, s_out[2].type);
+
+    /* A short buffer gets the newest events */
+    n = flight_rec_snapshot(&s_rec, s_out, 2);
+    TEST_ASSERT_EQUAL_size_t(2, n);
+    TEST_ASSERT_EQUAL_INT64(200, s_out[0].time_us);
+    TEST_ASSERT_EQUAL_INT64(300, s_out[1].time_us);
+}
+
+void test_flight_rec_ring_keeps_newest(void) {
+    memset(&s_rec, 0, sizeof(s_rec));
+    flight_rec_boot(&s_rec, 1, 0);
+
+    for (uint32_t i = 0; i < 3U * FLIGHT_REC_RT_EVENTS; i++) {
+        flight_rec_rt(&s_rec, 1000 + (int64_t)i, FLIGHT_EV_EDGE, (uint8_t)(i & 1U), i);
+    }
+
+    size_t n = flight_rec_snapshot(&s_rec, s_out, FLIGHT_REC_MAX_EVENTS);
+    /* Boot event, and the full RT lane less the slot a writer could be in */
+    TEST_ASSERT_EQUAL_size_t(1 + FLIGHT_REC_RT_EVENTS - 1, n);
+    TEST_ASSERT_EQUAL_UINT8(FLIGHT_EV_BOOT, s_out[0].type);
+    TEST_ASSERT_EQUAL_UINT32(3U * FLIGHT_REC_RT_EVENTS - 1U, s_out[n - 1].value);
+    TEST_ASSERT_EQUAL_UINT32(s_out[n - 1].value - 1U, s_out[n - 2].value);
+}
+
+void test_flight_rec_stage_peaks_only(void) {
+    memset(&s_rec, 0, sizeof(s_rec));
+    flight_rec_boot(&s_rec, 1, 0);
+
+    TEST_ASSERT_TRUE(flight_rec_note_stage(&s_rec, 1, RT_PROF_STAGE_TOTAL, 500));
+    TEST_ASSERT_FALSE(flight_rec_note_stage(&s_rec, 2, RT_PROF_STAGE_TOTAL, 400));
+    TEST_ASSERT_FALSE(flight_rec_note_stage(&s_rec, 3, RT_PROF_STAGE_TOTAL, 500));
+    TEST_ASSERT_TRUE(flight_rec_note_stage(&s_rec, 4, RT_PROF_STAGE_TOTAL, 800));
+    TEST_ASSERT_TRUE(flight_rec_note_stage(&s_rec, 5, RT_PROF_STAGE_GPIO, 10));
+
+    TEST_ASSERT_EQUAL_size_t(4, flight_rec_snapshot(&s_rec, s_out, FLIGHT_REC_MAX_EVENTS));
+    TEST_ASSERT_EQUAL_UINT32(800, s_out[2].value);
+
+    /* Peaks are per boot */
+    flight_rec_boot(&s_rec, 3, 0);
+    TEST_ASSERT_TRUE(flight_rec_note_stage(&s_rec, 1, RT_PROF_STAGE_TOTAL, 100));
+}
@@ -7,24 +7,26 @@
 #include "console.h"
 #include <string.h>
 
+static console_history_t s_h;
+
 /**
  * @brief Test basic push and prev navigation
  */
 void test_history_push_and_prev(void) {
-    console_history_init();
-    console_history_push("help");
-    console_history_push("show");
+    console_history_init(&s_h);
+    console_history_push(&s_h, "help");
+    console_history_push(&s_h, "show");
 
-    const char *line = console_history_prev();
+    const char *line = console_history_prev(&s_h);
     TEST_ASSERT_NOT_NULL(line);
     TEST_ASSERT_EQUAL_STRING("show", line);
 
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_NOT_NULL(line);
     TEST_ASSERT_EQUAL_STRING("help", line);
 
     /* Should stop at oldest */
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_NULL(line);
 }
 
@@ -32,23 +34,23 @@ void test_history_push_and_prev(void) {
  * @brief Test navigating forward with next
  */
 void test_history_next(void) {
-    console_history_init();
-    console_history_push("cmd1");
-    console_history_push("cmd2");
+    console_history_init(&s_h);
+    console_history_push(&s_h, "cmd1");
+    console_history_push(&s_h, "cmd2");
 
     /* Navigate backward */
-    const char *line = console_history_prev();
+    const char *line = console_history_prev(&s_h);
     TEST_ASSERT_EQUAL_STRING("cmd2", line);
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_EQUAL_STRING("cmd1", line);
 
     /* Navigate forward */
-    line = console_history_next();
+    line = console_history_next(&s_h);
     TEST_ASSERT_NOT_NULL(line);
     TEST_ASSERT_EQUAL_STRING("cmd2", line);
 
     /* Navigate past newest returns NULL */
-    line = console_history_next();
+    line = console_history_next(&s_h);
     TEST_ASSERT_NULL(line);
 }
 
@@ -56,32 +58,32 @@ void test_history_next(void) {
  * @brief Test ring buffer wrapping at HISTORY_SIZE
  */
 void test_history_wrap_at_depth(void) {
-    console_history_init();
-    console_history_push("old1");
-    console_history_push("old2");
-    console_history_push("old3");
-    console_history_push("old4");
-    console_history_push("new");  /* Should overwrite old1 */
+    console_history_init(&s_h);
+    console_history_push(&s_h, "old1");
+    console_history_push(&s_h, "old2");
+    console_history_push(&s_h, "old3");
+    console_history_push(&s_h, "old4");
+    console_history_push(&s_h, "new");  /* Should overwrite old1 */
 
     /* Navigate back - should only find 4 entries (CONSOLE_HISTORY_SIZE) */
-    const char *line = console_history_prev();
+    const char *line = console_history_prev(&s_h);
     TEST_ASSERT_NOT_NULL(line);
     TEST_ASSERT_EQUAL_STRING("new", line);
 
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_NOT_NULL(line);
     TEST_ASSERT_EQUAL_STRING("old4", line);
 
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_NOT_NULL(line);
     TEST_ASSERT_EQUAL_STRING("old3", line);
 
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_NOT_NULL(line);
     TEST_ASSERT_EQUAL_STRING("old2", line);
 
     /* Should stop here - old1 was overwritten */
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_NULL(line);
 }
 
@@ -89,18 +91,18 @@ void test_history_wrap_at_depth(void) {
  * @brief Test skipping duplicate consecutive entries
  */
 void test_history_skip_duplicates(void) {
-    console_history_init();
-    console_history_push("help");
-    console_history_push("help");  /* Should be skipped */
-    console_history_push("show");
+    console_history_init(&s_h);
+    console_history_push(&s_h, "help");
+    console_history_push(&s_h, "help");  /* Should be skipped */
+    console_history_push(&s_h, "show");
 
-    const char *line = console_history_prev();
+    const char *line = console_history_prev(&s_h);
     TEST_ASSERT_EQUAL_STRING("show", line);
 
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_EQUAL_STRING("help", line);
 
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_NULL(line);
 }
 
@@ -108,19 +110,19 @@ void test_history_skip_duplicates(void) {
  * @brief Test empty line is not added to history
  */
 void test_history_skip_empty(void) {
-    console_history_init();
-    console_history_push("cmd1");
-    console_history_push("");  /* Should be skipped */
-    console_history_push(NULL);  /* Should be skipped */
-    console_history_push("cmd2");
+    console_history_init(&s_h);
+    console_history_push(&s_h, "cmd1");
+    console_history_push(&s_h, "");  /* Should be skipped */
+    console_history_push(&s_h, NULL);  /* Should be skipped */
+    console_history_push(&s_h, "cmd2");
 
-    const char *line = console_history_prev();
+    const char *line = console_history_prev(&s_h);
     TEST_ASSERT_EQUAL_STRING("cmd2", line);
 
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_EQUAL_STRING("cmd1", line);
 
-    line = console_history_prev();
+    line = console_history_prev(&s_h);
     TEST_ASSERT_NULL(line);
 }
 
@@ -128,18 +130,18 @@ void test_history_skip_empty(void) {
  * @brief Test reset navigation
  */
 void test_history_reset_nav(void) {
-    console_history_init();
-    console_history_push("cmd1");
-    console_history_push("cmd2");
+    console_history_init(&s_h);
+    console_history_push(&s_h, "cmd1");
+    console_history_push(&s_h, "cmd2");
 
     /* Start navigating */
-    console_history_prev();
+    console_history_prev(&s_h);
 
     /* Reset navigation */
-    console_history_reset_nav();
+    console_history_reset_nav(&s_h);
 
     /* Next call to prev should start from beginning */
-    const char *line = console_history_prev();
+    const char *line = console_history_prev(&s_h);
     TEST_ASSERT_EQUAL_STRING("cmd2", line);
 }
 
@@ -147,10 +149,10 @@ void test_history_reset_nav(void) {
  * @brief Test navigation on empty history
  */
 void test_history_empty(void) {
-    console_history_init();
-    const char *line = console_history_prev();
+    console_history_init(&s_h);
+    const char *line = console_history_prev(&s_h);
     TEST_ASSERT_NULL(line);
 
-    line = console_history_next();
+    line = console_history_next(&s_h);
     TEST_ASSERT_NULL(line);
 }
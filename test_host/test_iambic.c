@@ -7,6 +7,9 @@
 #include "iambic.h"
 #include "sample.h"
 #include "stubs/esp_stubs.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 static iambic_processor_t s_iambic;
 static const int64_t DIT_DURATION_20WPM = 60000;  /* 60ms at 20 WPM */
@@ -252,3 +255,378 @@ void test_iambic_squeeze_prolonged(void) {
 
     (void)sample;
 }
+
+/* ============================================================================
+ * Paddle Edge Queue Tests
+ * ============================================================================ */
+
+/* Start edge tests past the initial release-debounce window */
+static const int64_t T0 = 100000;
+
+static void push_edge(paddle_edge_queue_t *q, paddle_edge_paddle_t paddle,
+                      bool pressed, int64_t timestamp_us) {
+    paddle_edge_t edge = {
+        .timestamp_us = timestamp_us,
+        .paddle = (uint8_t)paddle,
+        .level = pressed ? 1 : 0,
+    };
+    paddle_edge_push(q, &edge);
+}
+
+void test_paddle_edge_queue_overflow(void) {
+    paddle_edge_queue_t q;
+    paddle_edge_queue_init(&q);
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+
+    for (int64_t i = 0; i < PADDLE_EDGE_QUEUE_CAPACITY; i++) {
+        paddle_edge_t edge = { .timestamp_us = i, .paddle = PADDLE_EDGE_DIT, .level = 1 };
+        TEST_ASSERT_TRUE(paddle_edge_push(&q, &edge));
+    }
+
+    /* Full: next edge is dropped and counted */
+    paddle_edge_t extra = { .timestamp_us = 99, .paddle = PADDLE_EDGE_DAH, .level = 1 };
+    TEST_ASSERT_FALSE(paddle_edge_push(&q, &extra));
+    TEST_ASSERT_EQUAL(1, paddle_edge_dropped(&q));
+
+    /* FIFO order preserved */
+    paddle_edge_t out;
+    for (int64_t i = 0; i < PADDLE_EDGE_QUEUE_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(paddle_edge_pop(&q, &out));
+        TEST_ASSERT_EQUAL_INT64(i, out.timestamp_us);
+    }
+    TEST_ASSERT_FALSE(paddle_edge_pop(&q, &out));
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+}
+
+void test_iambic_edge_memory_window(void) {
+    /* Memory window 0-50%: DIT is 60ms, so window closes at 30ms */
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+    config.wpm = 20;
+    config.mode = IAMBIC_MODE_A;
+    config.mem_window_start_pct = 0;
+    config.mem_window_end_pct = 50;
+
+    paddle_edge_queue_t q;
+    paddle_edge_queue_init(&q);
+
+    gpio_state_t dit = gpio_from_paddles(true, false);
+    gpio_state_t dah = gpio_from_paddles(false, true);
+
+    /* Tick time only: DAH seen at 40ms (66%) is too late to memorize */
+    iambic_init(&s_iambic, &config);
+    iambic_tick(&s_iambic, T0, dit);
+    iambic_tick(&s_iambic, T0 + 10000, GPIO_IDLE);
+    iambic_tick(&s_iambic, T0 + 40000, dah);
+    TEST_ASSERT_FALSE(s_iambic.dah_memory);
+
+    /* Same tick, but the ISR saw the DAH press at 25ms (41%) */
+    iambic_init(&s_iambic, &config);
+    iambic_tick_edges(&s_iambic, T0, dit, &q);
+    iambic_tick_edges(&s_iambic, T0 + 10000, GPIO_IDLE, &q);
+    push_edge(&q, PADDLE_EDGE_DAH, true, T0 + 25000);
+    iambic_tick_edges(&s_iambic, T0 + 40000, dah, &q);
+    TEST_ASSERT_TRUE(s_iambic.dah_memory);
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+}
+
+void test_iambic_edge_tap_within_tick(void) {
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+    config.wpm = 20;
+    iambic_init(&s_iambic, &config);
+
+    paddle_edge_queue_t q;
+    paddle_edge_queue_init(&q);
+
+    iambic_tick_edges(&s_iambic, T0 + 1000, GPIO_IDLE, &q);
+
+    /* Press and release both between two ticks: polled state shows idle */
+    push_edge(&q, PADDLE_EDGE_DIT, true, T0 + 1200);
+    push_edge(&q, PADDLE_EDGE_DIT, false, T0 + 1700);
+    iambic_tick_edges(&s_iambic, T0 + 2000, GPIO_IDLE, &q);
+
+    /* Element started at the true press time, not the tick time */
+    TEST_ASSERT_EQUAL(IAMBIC_STATE_SEND_DIT, s_iambic.state);
+    TEST_ASSERT_TRUE(s_iambic.key_down);
+    TEST_ASSERT_EQUAL_INT64(T0 + 1200, s_iambic.element_start_us);
+    TEST_ASSERT_EQUAL_INT64(T0 + 1200 + DIT_DURATION_20WPM, s_iambic.element_end_us);
+
+    /* Stale edge (before last step) is clamped, FSM time stays monotonic */
+    push_edge(&q, PADDLE_EDGE_DAH, true, T0 + 500);
+    iambic_tick_edges(&s_iambic, T0 + 3000, GPIO_IDLE, &q);
+    TEST_ASSERT_EQUAL_INT64(T0 + 3000, s_iambic.last_tick_us);
+}
+
+void test_iambic_queue_config_latches_at_boundary(void) {
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+    config.wpm = 20;
+    iambic_init(&s_iambic, &config);
+
+    iambic_config_t faster = config;
+    faster.wpm = 40;
+
+    /* IDLE: applied at once */
+    iambic_queue_config(&s_iambic, &faster);
+    TEST_ASSERT_EQUAL(40, s_iambic.config.wpm);
+    TEST_ASSERT_FALSE(s_iambic.config_pending);
+    iambic_set_config(&s_iambic, &config);
+
+    /* Mid-element: the running DIT keeps its 20 WPM length */
+    gpio_state_t dit = gpio_from_paddles(true, false);
+    iambic_tick(&s_iambic, T0, dit);
+    iambic_queue_config(&s_iambic, &faster);
+    iambic_tick(&s_iambic, T0 + 10000, dit);
+    TEST_ASSERT_EQUAL(20, s_iambic.config.wpm);
+    TEST_ASSERT_TRUE(s_iambic.config_pending);
+    TEST_ASSERT_EQUAL_INT64(T0 + DIT_DURATION_20WPM, s_iambic.element_end_us);
+
+    /* Gap entry latches: gap is already at 40 WPM */
+    iambic_tick(&s_iambic, T0 + DIT_DURATION_20WPM, dit);
+    TEST_ASSERT_EQUAL(IAMBIC_STATE_GAP, s_iambic.state);
+    TEST_ASSERT_EQUAL(40, s_iambic.config.wpm);
+    TEST_ASSERT_FALSE(s_iambic.config_pending);
+    TEST_ASSERT_EQUAL_INT64(T0 + DIT_DURATION_20WPM + DIT_DURATION_20WPM / 2,
+                            s_iambic.element_end_us);
+}
+
+void test_iambic_queue_plan_latches_at_boundary(void) {
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+    config.wpm = 20;
+    iambic_init(&s_iambic, &config);
+
+    iambic_config_t faster = config;
+    faster.wpm = 40;
+    faster.mode = IAMBIC_MODE_A;
+    iambic_plan_t plan;
+    iambic_plan_build(&plan, &faster);
+
+    /* Mid-element: staged, the running DIT keeps its length */
+    gpio_state_t dit = gpio_from_paddles(true, false);
+    iambic_tick(&s_iambic, T0, dit);
+    iambic_queue_plan(&s_iambic, &plan);
+    TEST_ASSERT_TRUE(s_iambic.config_pending);
+    TEST_ASSERT_EQUAL(20, s_iambic.config.wpm);
+    TEST_ASSERT_EQUAL(IAMBIC_MODE_B, s_iambic.config.mode);
+
+    /* Gap entry copies the plan: timing and step variant together */
+    iambic_tick(&s_iambic, T0 + DIT_DURATION_20WPM, dit);
+    TEST_ASSERT_FALSE(s_iambic.config_pending);
+    TEST_ASSERT_EQUAL(IAMBIC_MODE_A, s_iambic.config.mode);
+    TEST_ASSERT_EQUAL_INT64(plan.timing.gap_us, s_iambic.timing.gap_us);
+    TEST_ASSERT_TRUE(s_iambic.step == plan.step);
+    TEST_ASSERT_EQUAL_INT64(T0 + DIT_DURATION_20WPM + DIT_DURATION_20WPM / 2,
+                            s_iambic.element_end_us);
+
+    /* IDLE: applied at once */
+    iambic_init(&s_iambic, &config);
+    iambic_queue_plan(&s_iambic, &plan);
+    TEST_ASSERT_FALSE(s_iambic.config_pending);
+    TEST_ASSERT_EQUAL(40, s_iambic.config.wpm);
+}
+
+void test_iambic_timing_window_matches_pct(void) {
+    /* Precomputed offsets must agree with the integer progress check */
+    static const uint32_t wpms[] = { 5, 13, 20, 37, 100 };
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+
+    for (size_t w = 0; w < sizeof(wpms) / sizeof(wpms[0]); w++) {
+        config.wpm = wpms[w];
+        for (uint8_t start = 0; start <= 100; start += 5) {
+            for (uint8_t end = start; end <= 100; end += 5) {
+                config.mem_window_start_pct = start;
+                config.mem_window_end_pct = end;
+                iambic_init(&s_iambic, &config);
+
+                int64_t dur = s_iambic.timing.dah_us;
+                for (int64_t t = 0; t <= dur + 10; t += 7) {
+                    uint8_t pct = (uint8_t)((t >= dur) ? 100 : (t * 100) / dur);
+                    bool expected = iambic_in_memory_window(pct, start, end);
+                    bool actual = t >= s_iambic.timing.dah_win_start_us &&
+                                  t < s_iambic.timing.dah_win_end_us;
+                    TEST_ASSERT_EQUAL(expected, actual);
+                }
+            }
+        }
+    }
+}
+
+void test_iambic_key_tags(void) {
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+    config.wpm = 20;
+    iambic_init(&s_iambic, &config);
+
+    gpio_state_t dah = gpio_from_paddles(false, true);
+    const int64_t DAH = DIT_DURATION_20WPM * 3;
+    const int64_t T0 = 100000;  /* Clear of the release blanking at t=0 */
+
+    /* First element of a character: type only */
+    stream_sample_t s = iambic_tick(&s_iambic, T0, dah);
+    TEST_ASSERT_EQUAL(1, s.local_key);
+    TEST_ASSERT_EQUAL_HEX8(KEY_TAG_ELEMENT | KEY_TAG_DAH, sample_key_tag(&s));
+
+    /* Key up during the gap: untagged */
+    s = iambic_tick(&s_iambic, T0 + DAH, dah);
+    TEST_ASSERT_EQUAL(0, s.local_key);
+    TEST_ASSERT_EQUAL_HEX8(0, sample_key_tag(&s));
+
+    /* Paddle still held: next dah follows the inter-element gap */
+    s = iambic_tick(&s_iambic, T0 + DAH + DIT_DURATION_20WPM, dah);
+    TEST_ASSERT_EQUAL(1, s.local_key);
+    TEST_ASSERT_EQUAL_HEX8(KEY_TAG_ELEMENT | KEY_TAG_DAH | KEY_TAG_IN_CHAR, sample_key_tag(&s));
+
+    /* Release, let the FSM go idle, then a dit starts a new character */
+    int64_t t = T0 + 2 * DAH + DIT_DURATION_20WPM;
+    (void)iambic_tick(&s_iambic, t, GPIO_IDLE);
+    t += DIT_DURATION_20WPM;
+    s = iambic_tick(&s_iambic, t, GPIO_IDLE);
+    TEST_ASSERT_EQUAL(IAMBIC_STATE_IDLE, s_iambic.state);
+    s = iambic_tick(&s_iambic, t + 5 * DIT_DURATION_20WPM, gpio_from_paddles(true, false));
+    TEST_ASSERT_EQUAL(1, s.local_key);
+    TEST_ASSERT_EQUAL_HEX8(KEY_TAG_ELEMENT, sample_key_tag(&s));
+}
+
+/* Paddle script step: from at_ms on, the paddles read dit/dah */
+typedef struct {
+    uint16_t at_ms;
+    bool dit;
+    bool dah;
+} paddle_step_t;
+
+#define SCRIPT_END { UINT16_MAX, false, false }
+
+static const paddle_step_t SCRIPT_SQUEEZE[] = {
+    { 0, true, false }, { 10, true, true }, { 400, false, false }, SCRIPT_END };
+static const paddle_step_t SCRIPT_DIT_TAP_DAH[] = {
+    { 0, true, false }, { 30, true, true }, { 45, true, false }, { 150, false, false }, SCRIPT_END };
+static const paddle_step_t SCRIPT_DAH_TAP_DIT[] = {
+    { 0, false, true }, { 50, true, true }, { 90, false, true }, { 200, false, false }, SCRIPT_END };
+static const paddle_step_t SCRIPT_SHORT_SQUEEZE[] = {
+    { 0, true, true }, { 100, false, false }, SCRIPT_END };
+static const paddle_step_t SCRIPT_EARLY_RELEASE[] = {
+    { 0, true, true }, { 20, false, false }, SCRIPT_END };
+static const paddle_step_t SCRIPT_MIXED[] = {
+    { 0, false, true }, { 120, true, false }, { 135, false, false }, { 300, true, true },
+    { 520, false, true }, { 700, false, false }, SCRIPT_END };
+
+#define MATRIX_SCRIPTS 6
+
+static const paddle_step_t *const MATRIX_SCRIPT[MATRIX_SCRIPTS] = {
+    SCRIPT_SQUEEZE, SCRIPT_DIT_TAP_DAH, SCRIPT_DAH_TAP_DIT,
+    SCRIPT_SHORT_SQUEEZE, SCRIPT_EARLY_RELEASE, SCRIPT_MIXED,
+};
+
+/* Elements each script keys at 20 WPM with a 1 ms tick, per config */
+static const struct {
+    iambic_mode_t mode;
+    memory_mode_t memory;
+    squeeze_mode_t squeeze;
+    uint8_t win_start;
+    uint8_t win_end;
+    const char *expect[MATRIX_SCRIPTS];
+} MODE_MATRIX[] = {
+    { IAMBIC_MODE_A, MEMORY_MODE_NONE, SQUEEZE_MODE_LATCH_OFF,   0, 100, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_NONE, SQUEEZE_MODE_LATCH_OFF, 40,  80, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_NONE, SQUEEZE_MODE_LATCH_ON,   0, 100, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_NONE, SQUEEZE_MODE_LATCH_ON, 40,  80, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DOT_ONLY, SQUEEZE_MODE_LATCH_OFF,   0, 100, { ".-.", "..", "-.", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DOT_ONLY, SQUEEZE_MODE_LATCH_OFF, 40,  80, { ".-.", "..", "-.", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DOT_ONLY, SQUEEZE_MODE_LATCH_ON,   0, 100, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DOT_ONLY, SQUEEZE_MODE_LATCH_ON, 40,  80, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DAH_ONLY, SQUEEZE_MODE_LATCH_OFF,   0, 100, { ".-.", ".-", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DAH_ONLY, SQUEEZE_MODE_LATCH_OFF, 40,  80, { ".-.", ".-", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DAH_ONLY, SQUEEZE_MODE_LATCH_ON,   0, 100, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DAH_ONLY, SQUEEZE_MODE_LATCH_ON, 40,  80, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DOT_AND_DAH, SQUEEZE_MODE_LATCH_OFF,   0, 100, { ".-.", ".-", "-.", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DOT_AND_DAH, SQUEEZE_MODE_LATCH_OFF, 40,  80, { ".-.", ".-", "-.", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DOT_AND_DAH, SQUEEZE_MODE_LATCH_ON,   0, 100, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_A, MEMORY_MODE_DOT_AND_DAH, SQUEEZE_MODE_LATCH_ON, 40,  80, { ".-.", "..", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_B, MEMORY_MODE_NONE, SQUEEZE_MODE_LATCH_OFF,   0, 100, { ".-.-", ".-", "-.", ".-", ".-", "-.-." } },
+    { IAMBIC_MODE_B, MEMORY_MODE_NONE, SQUEEZE_MODE_LATCH_OFF, 40,  80, { ".-.-", ".-", "-.", ".-", ".", "-.-." } },
+    { IAMBIC_MODE_B, MEMORY_MODE_NONE, SQUEEZE_MODE_LATCH_ON,   0, 100, { ".-.", ".-", "-.", ".", ".", "-.--" } },
+    { IAMBIC_MODE_B, MEMORY_MODE_NONE, SQUEEZE_MODE_LATCH_ON, 40,  80, { ".-.", ".-", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DOT_ONLY, SQUEEZE_MODE_LATCH_OFF,   0, 100, { ".-.-", ".-", "-.", ".-", ".-", "-.-." } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DOT_ONLY, SQUEEZE_MODE_LATCH_OFF, 40,  80, { ".-.-", ".-", "-.", ".-", ".", "-.-." } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DOT_ONLY, SQUEEZE_MODE_LATCH_ON,   0, 100, { ".-.", ".-", "-.", ".", ".", "-.--" } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DOT_ONLY, SQUEEZE_MODE_LATCH_ON, 40,  80, { ".-.", ".-", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DAH_ONLY, SQUEEZE_MODE_LATCH_OFF,   0, 100, { ".-.-", ".-", "-.", ".-", ".-", "-.-." } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DAH_ONLY, SQUEEZE_MODE_LATCH_OFF, 40,  80, { ".-.-", ".-", "-.", ".-", ".", "-.-." } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DAH_ONLY, SQUEEZE_MODE_LATCH_ON,   0, 100, { ".-.", ".-", "-.", ".", ".", "-.--" } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DAH_ONLY, SQUEEZE_MODE_LATCH_ON, 40,  80, { ".-.", ".-", "-", ".", ".", "-.--" } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DOT_AND_DAH, SQUEEZE_MODE_LATCH_OFF,   0, 100, { ".-.-", ".-", "-.", ".-", ".-", "-.-." } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DOT_AND_DAH, SQUEEZE_MODE_LATCH_OFF, 40,  80, { ".-.-", ".-", "-.", ".-", ".", "-.-." } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DOT_AND_DAH, SQUEEZE_MODE_LATCH_ON,   0, 100, { ".-.", ".-", "-.", ".", ".", "-.--" } },
+    { IAMBIC_MODE_B, MEMORY_MODE_DOT_AND_DAH, SQUEEZE_MODE_LATCH_ON, 40,  80, { ".-.", ".-", "-", ".", ".", "-.--" } },
+};
+
+/* Run a script and spell the elements keyed ('.' dit, '-' dah) */
+static void run_script(iambic_processor_t *proc, const paddle_step_t *step,
+                       char *out, size_t out_len) {
+    bool dit = false;
+    bool dah = false;
+    bool was_down = false;
+    size_t n = 0;
+
+    for (uint16_t ms = 0; ms < 1500; ms++) {
+        while (step->at_ms == ms) {
+            dit = step->dit;
+            dah = step->dah;
+            step++;
+        }
+        (void)iambic_tick(proc, T0 + (int64_t)ms * 1000, gpio_from_paddles(dit, dah));
+        if (proc->key_down && !was_down && n + 1 < out_len) {
+            out[n++] = (proc->state == IAMBIC_STATE_SEND_DIT) ? '.' : '-';
+        }
+        was_down = proc->key_down;
+    }
+    out[n] = '\0';
+}
+
+void test_iambic_mode_matrix(void) {
+    /* Pins every mode combination, so each specialized step variant
+     * keys exactly what the others would for its config */
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+
+    for (size_t i = 0; i < sizeof(MODE_MATRIX) / sizeof(MODE_MATRIX[0]); i++) {
+        config.wpm = 20;
+        config.mode = MODE_MATRIX[i].mode;
+        config.memory_mode = MODE_MATRIX[i].memory;
+        config.squeeze_mode = MODE_MATRIX[i].squeeze;
+        config.mem_window_start_pct = MODE_MATRIX[i].win_start;
+        config.mem_window_end_pct = MODE_MATRIX[i].win_end;
+
+        for (size_t k = 0; k < MATRIX_SCRIPTS; k++) {
+            char got[32];
+            char msg[96];
+            iambic_init(&s_iambic, &config);
+            run_script(&s_iambic, MATRIX_SCRIPT[k], got, sizeof(got));
+            snprintf(msg, sizeof(msg), "row %zu script %zu: expected \"%s\", keyed \"%s\"",
+                     i, k, MODE_MATRIX[i].expect[k], got);
+            TEST_ASSERT_MESSAGE(strcmp(MODE_MATRIX[i].expect[k], got) == 0, msg);
+        }
+    }
+}
+
+void test_iambic_tick_benchmark(void) {
+    /* Prolonged squeeze at 25 WPM with a 100us tick: every tick runs the
+     * memory window check. Reports host ns/tick, asserts only sanity. */
+    iambic_config_t config = IAMBIC_CONFIG_DEFAULT;
+    config.wpm = 25;
+    iambic_init(&s_iambic, &config);
+
+    const int32_t ticks = 2000000;
+    gpio_state_t squeeze = gpio_from_paddles(true, true);
+    uint32_t key_ticks = 0;
+
+    clock_t start = clock();
+    for (int32_t i = 0; i < ticks; i++) {
+        stream_sample_t s = iambic_tick(&s_iambic, T0 + (int64_t)i * 100, squeeze);
+        key_ticks += s.local_key;
+    }
+    clock_t elapsed = clock() - start;
+
+    double ns_per_tick = (double)elapsed * 1e9 / (double)CLOCKS_PER_SEC / (double)ticks;
+    printf("  iambic_tick: %.1f ns/tick\n", ns_per_tick);
+
+    /* Squeeze alternates DIT/DAH: key is down for 4 of every 6 dit units */
+    TEST_ASSERT_GREATER_THAN(ticks / 2, key_ticks);
+    TEST_ASSERT_TRUE(key_ticks < (uint32_t)ticks);
+}
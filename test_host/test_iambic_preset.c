@@ -5,6 +5,7 @@
 
 #include "unity.h"
 #include "iambic_preset.h"
+#include "iambic.h"
 #include <string.h>
 
 void test_preset_init(void) {
@@ -185,3 +186,152 @@ void test_preset_null_safety(void) {
     /* Active preset should never be NULL */
     TEST_ASSERT_NOT_NULL(iambic_preset_active());
 }
+
+void test_preset_plan_follows_edits(void) {
+    iambic_preset_init();
+
+    /* Built at init from the default values */
+    const iambic_plan_t *plan = iambic_preset_plan(1);
+    TEST_ASSERT_NOT_NULL(plan);
+    TEST_ASSERT_EQUAL(35, plan->config.wpm);
+    TEST_ASSERT_EQUAL_INT64(1200000 / 35, plan->timing.dit_us);
+    TEST_ASSERT_NULL(iambic_preset_plan(10));
+
+    /* An edit publishes a fresh plan, the old one stays as it was */
+    iambic_preset_set_wpm(iambic_preset_get_mut(1), 40);
+    const iambic_plan_t *edited = iambic_preset_plan(1);
+    TEST_ASSERT_TRUE(edited != plan);
+    TEST_ASSERT_EQUAL_INT64(30000, edited->timing.dit_us);
+    TEST_ASSERT_EQUAL_INT64(1200000 / 35, plan->timing.dit_us);
+
+    /* Memory mode lands in the arming flags */
+    iambic_preset_set_memory_mode(iambic_preset_get_mut(1), MEMORY_MODE_DAH_ONLY);
+    TEST_ASSERT_FALSE(iambic_preset_plan(1)->timing.dit_memory_enabled);
+    TEST_ASSERT_TRUE(iambic_preset_plan(1)->timing.dah_memory_enabled);
+
+    /* Copy and reset rebuild the destination */
+    TEST_ASSERT_TRUE(iambic_preset_copy(1, 6));
+    TEST_ASSERT_EQUAL(40, iambic_preset_plan(6)->config.wpm);
+    TEST_ASSERT_TRUE(iambic_preset_reset(6));
+    TEST_ASSERT_EQUAL(25, iambic_preset_plan(6)->config.wpm);
+
+    /* Active plan follows activation */
+    TEST_ASSERT_TRUE(iambic_preset_activate(1));
+    TEST_ASSERT_TRUE(iambic_preset_active_plan() == iambic_preset_plan(1));
+}
+
+void test_preset_blob_roundtrip(void) {
+    uint8_t blob[IAMBIC_PRESET_BLOB_SIZE];
+
+    iambic_preset_init();
+    iambic_preset_t *p3 = iambic_preset_get_mut(3);
+    iambic_preset_set_wpm(p3, 18);
+    iambic_preset_set_mode(p3, IAMBIC_MODE_A);
+    iambic_preset_set_squeeze_mode(p3, SQUEEZE_MODE_LATCH_ON);
+    iambic_preset_set_mem_start(p3, 40);
+    iambic_preset_set_mem_end(p3, 80);
+    iambic_preset_set_name(3, "Rag chew");
+    iambic_preset_activate(3);
+    TEST_ASSERT_EQUAL(IAMBIC_PRESET_BLOB_SIZE, iambic_preset_pack(blob));
+
+    /* Back to defaults, then restore from the blob */
+    iambic_preset_init();
+    TEST_ASSERT_TRUE(iambic_preset_unpack(blob, sizeof(blob)));
+    TEST_ASSERT_EQUAL(3, iambic_preset_active_index());
+    TEST_ASSERT_EQUAL_STRING("Rag chew", p3->name);
+    TEST_ASSERT_EQUAL(18, iambic_preset_get_wpm(p3));
+    TEST_ASSERT_EQUAL(SQUEEZE_MODE_LATCH_ON, iambic_preset_get_squeeze_mode(p3));
+    TEST_ASSERT_EQUAL(80, iambic_preset_get_mem_end(p3));
+    TEST_ASSERT_EQUAL(18, iambic_preset_active_plan()->config.wpm);
+    TEST_ASSERT_EQUAL(IAMBIC_MODE_A, iambic_preset_active_plan()->config.mode);
+
+    /* A bad value anywhere rejects the whole blob */
+    iambic_preset_init();
+    blob[4 + 9 * IAMBIC_PRESET_BLOB_ENTRY + IAMBIC_PRESET_NAME_MAX] = 101;
+    TEST_ASSERT_FALSE(iambic_preset_unpack(blob, sizeof(blob)));
+    TEST_ASSERT_EQUAL(0, iambic_preset_active_index());
+    TEST_ASSERT_EQUAL(10, iambic_preset_get_wpm(p3));
+
+    /* Wrong size or schema version */
+    TEST_ASSERT_FALSE(iambic_preset_unpack(blob, sizeof(blob) - 1));
+    blob[0] = IAMBIC_PRESET_SCHEMA_VERSION + 1;
+    TEST_ASSERT_FALSE(iambic_preset_unpack(blob, sizeof(blob)));
+}
+
+/* The RT task's side of the preset handoff, as in main/rt_task.c */
+static iambic_processor_t s_proc;
+static iambic_preset_handoff_t s_rt_preset;
+static unsigned s_rt_seq;
+
+static void rt_poll(const iambic_config_t *params) {
+    if (iambic_preset_handoff_seq() != s_rt_seq &&
+        iambic_preset_read_handoff(&s_rt_preset, &s_rt_seq)) {
+        if (s_rt_preset.in_use) {
+            iambic_queue_plan(&s_proc, &s_rt_preset.plan);
+        } else {
+            iambic_queue_config(&s_proc, params);
+        }
+    }
+}
+
+void test_preset_handoff_drives_fsm(void) {
+    const int64_t t0 = 1000000;
+    const int64_t dit_20 = 1200000 / 20;
+    const int64_t dit_35 = 1200000 / 35;
+    const gpio_state_t dit = gpio_from_paddles(true, false);
+    iambic_config_t params = IAMBIC_CONFIG_DEFAULT;
+    params.wpm = 20;
+
+    iambic_preset_init();
+    iambic_init(&s_proc, &params);
+    s_rt_preset.in_use = false;
+    s_rt_seq = 1U;
+
+    /* Nothing in use: the RT keeps the parameters */
+    rt_poll(&params);
+    TEST_ASSERT_FALSE(s_rt_preset.in_use);
+    TEST_ASSERT_EQUAL(20, s_proc.config.wpm);
+
+    /* Keying at 20 WPM; "Contest" (35 WPM) is put in use mid-element */
+    iambic_tick(&s_proc, t0, dit);
+    TEST_ASSERT_EQUAL_INT64(t0 + dit_20, s_proc.element_end_us);
+    TEST_ASSERT_TRUE(iambic_preset_activate(1));
+    TEST_ASSERT_TRUE(iambic_preset_in_use());
+    rt_poll(&params);
+    TEST_ASSERT_TRUE(s_rt_preset.in_use);
+    TEST_ASSERT_TRUE(s_proc.config_pending);
+    TEST_ASSERT_EQUAL_INT64(t0 + dit_20, s_proc.element_end_us);
+
+    /* Gap entry latches it: the gap and the next DIT run at 35 WPM */
+    iambic_tick(&s_proc, t0 + dit_20, dit);
+    TEST_ASSERT_FALSE(s_proc.config_pending);
+    TEST_ASSERT_EQUAL(35, s_proc.config.wpm);
+    TEST_ASSERT_EQUAL_INT64(dit_35, s_proc.timing.dit_us);
+    TEST_ASSERT_EQUAL_INT64(t0 + dit_20 + dit_35, s_proc.element_end_us);
+    int64_t next = s_proc.element_end_us;
+    iambic_tick(&s_proc, next, dit);
+    TEST_ASSERT_EQUAL_INT64(next + dit_35, s_proc.element_end_us);
+
+    /* Edits of the preset in use follow; unchanged handoff, nothing queued */
+    iambic_preset_set_wpm(iambic_preset_get_mut(1), 40);
+    iambic_preset_set_wpm(iambic_preset_get_mut(1), 30);
+    rt_poll(&params);
+    TEST_ASSERT_EQUAL(30, s_rt_preset.plan.config.wpm);
+    iambic_preset_set_wpm(iambic_preset_get_mut(2), 12);
+    unsigned seq = s_rt_seq;
+    rt_poll(&params);
+    TEST_ASSERT_EQUAL(seq, s_rt_seq);
+    next = s_proc.element_end_us;
+    iambic_tick(&s_proc, next, dit);
+    TEST_ASSERT_EQUAL(30, s_proc.config.wpm);
+    TEST_ASSERT_EQUAL_INT64(1200000 / 30, s_proc.timing.dit_us);
+
+    /* Released: back to the parameters at the next boundary */
+    iambic_preset_deactivate();
+    rt_poll(&params);
+    TEST_ASSERT_FALSE(s_rt_preset.in_use);
+    next = s_proc.element_end_us;
+    iambic_tick(&s_proc, next, dit);
+    TEST_ASSERT_EQUAL(20, s_proc.config.wpm);
+    TEST_ASSERT_EQUAL_INT64(dit_20, s_proc.timing.dit_us);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file test_json_scan.c
+ * @brief Tests for the in-place JSON tokenizer
+ */
+
+#include "unity.h"
+#include "json_scan.h"
+#include <string.h>
+#include <limits.h>
+
+static json_tok_t s_toks[32];
+
+static int scan(const char *js) {
+    return json_scan(js, strlen(js), s_toks, sizeof(s_toks) / sizeof(s_toks[0]));
+}
+
+void test_json_scan_fields(void) {
+    const char *js = " {\"param\": \"keyer.wpm\", \"nested\": {\"a\": [1, 2, {\"b\": null}]},"
+                     " \"value\": 25.7, \"neg\": -1e12, \"save\": true, \"off\": false} ";
+    int n = scan(js);
+    TEST_ASSERT_TRUE(n > 0);
+    TEST_ASSERT_EQUAL(JSON_TOK_OBJECT, s_toks[0].type);
+    TEST_ASSERT_EQUAL(n, s_toks[0].next);
+
+    char buf[32];
+    int param = json_scan_get(js, s_toks, 0, "param");
+    TEST_ASSERT_TRUE(json_scan_string(js, &s_toks[param], buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("keyer.wpm", buf);
+
+    /* Members after a nested subtree are still found */
+    int v;
+    TEST_ASSERT_TRUE(json_scan_int(js, &s_toks[json_scan_get(js, s_toks, 0, "value")], &v));
+    TEST_ASSERT_EQUAL(25, v);
+    TEST_ASSERT_TRUE(json_scan_int(js, &s_toks[json_scan_get(js, s_toks, 0, "neg")], &v));
+    TEST_ASSERT_EQUAL(INT_MIN, v);
+    TEST_ASSERT_TRUE(json_scan_is_true(s_toks, json_scan_get(js, s_toks, 0, "save")));
+    TEST_ASSERT_FALSE(json_scan_is_true(s_toks, json_scan_get(js, s_toks, 0, "off")));
+    TEST_ASSERT_FALSE(json_scan_is_true(s_toks, json_scan_get(js, s_toks, 0, "missing")));
+
+    /* Keys inside the nested object are not members of the root */
+    TEST_ASSERT_EQUAL(-1, json_scan_get(js, s_toks, 0, "a"));
+    int nested = json_scan_get(js, s_toks, 0, "nested");
+    TEST_ASSERT_EQUAL(JSON_TOK_ARRAY, s_toks[json_scan_get(js, s_toks, nested, "a")].type);
+
+    /* Wrong types are refused */
+    TEST_ASSERT_FALSE(json_scan_string(js, &s_toks[json_scan_get(js, s_toks, 0, "value")],
+                                       buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(json_scan_int(js, &s_toks[param], &v));
+
+    /* Scalars in config_set_param_str form */
+    TEST_ASSERT_TRUE(json_scan_value_str(js, &s_toks[json_scan_get(js, s_toks, 0, "value")],
+                                         buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("25", buf);
+    TEST_ASSERT_TRUE(json_scan_value_str(js, &s_toks[json_scan_get(js, s_toks, 0, "off")],
+                                         buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("false", buf);
+    TEST_ASSERT_TRUE(json_scan_value_str(js, &s_toks[param], buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("keyer.wpm", buf);
+    TEST_ASSERT_FALSE(json_scan_value_str(js, &s_toks[nested], buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(json_scan_value_str(js, &s_toks[json_scan_get(js, s_toks, 0, "save")],
+                                          buf, 4));   /* "true" needs 5 */
+}
+
+void test_json_scan_strings_and_errors(void) {
+    const char *js = "{\"text\":\"CQ \\\"DE\\\"\\n\\u00e8\\ud83d\\ude00\\/\"}";
+    TEST_ASSERT_TRUE(scan(js) > 0);
+    char buf[32];
+    int text = json_scan_get(js, s_toks, 0, "text");
+    TEST_ASSERT_TRUE(json_scan_string(js, &s_toks[text], buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("CQ \"DE\"\n\xC3\xA8\xF0\x9F\x98\x80/", buf);
+
+    /* Does not fit */
+    char small[4];
+    TEST_ASSERT_FALSE(json_scan_string(js, &s_toks[text], small, sizeof(small)));
+
+    /* Malformed bodies */
+    TEST_ASSERT_EQUAL(-1, scan(""));
+    TEST_ASSERT_EQUAL(-1, scan("{\"a\":1,}"));
+    TEST_ASSERT_EQUAL(-1, scan("{\"a\" 1}"));
+    TEST_ASSERT_EQUAL(-1, scan("{\"a\":01}"));
+    TEST_ASSERT_EQUAL(-1, scan("{\"a\":tru}"));
+    TEST_ASSERT_EQUAL(-1, scan("{\"a\":\"x\\q\"}"));
+    TEST_ASSERT_EQUAL(-1, scan("{\"a\":\"unterminated}"));
+    TEST_ASSERT_EQUAL(-1, scan("{} trailing"));
+    TEST_ASSERT_EQUAL(-1, scan("[[[[[[[[[1]]]]]]]]]"));
+
+    /* Token budget */
+    json_tok_t few[3];
+    const char *three = "[1,2,3]";
+    TEST_ASSERT_EQUAL(-1, json_scan(three, strlen(three), few, 3));
+    TEST_ASSERT_EQUAL(3, json_scan("[1,2]", 5, few, 3));
+}
@@ -0,0 +1,110 @@
+/**
+ * @file test_json_writer.c
+ * @brief Tests for the streaming JSON writer
+ */
+
+#include "unity.h"
+#include "json_writer.h"
+#include <string.h>
+
+static char s_out[512];
+static size_t s_out_len;
+static unsigned s_flushes;
+
+static bool collect(void *ctx, const char *data, size_t len) {
+    (void)ctx;
+    TEST_ASSERT_TRUE(s_out_len + len < sizeof(s_out));
+    memcpy(s_out + s_out_len, data, len);
+    s_out_len += len;
+    s_out[s_out_len] = '\0';
+    s_flushes++;
+    return true;
+}
+
+static bool refuse(void *ctx, const char *data, size_t len) {
+    (void)ctx;
+    (void)data;
+    (void)len;
+    return false;
+}
+
+static void reset(void) {
+    s_out[0] = '\0';
+    s_out_len = 0;
+    s_flushes = 0;
+}
+
+static void write_status(json_writer_t *w) {
+    json_object_begin(w, NULL);
+    json_string(w, "mode", "CONNECTED");
+    json_bool(w, "ready", true);
+    json_int(w, "latency_ms", -1);
+    json_uint(w, "tx_bytes", 4294967296ULL);
+    json_double(w, "ratio", 0.25);
+    json_null(w, "peer");
+    json_array_begin(w, "hist");
+    json_uint(w, NULL, 1);
+    json_uint(w, NULL, 2);
+    json_object_begin(w, NULL);
+    json_object_end(w);
+    json_array_end(w);
+    json_array_begin(w, "empty");
+    json_array_end(w);
+    json_object_end(w);
+}
+
+void test_json_writer_document(void) {
+    char buf[256];
+    json_writer_t w;
+    reset();
+    json_writer_init(&w, buf, sizeof(buf), collect, NULL);
+    write_status(&w);
+    TEST_ASSERT_TRUE(json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"mode\":\"CONNECTED\",\"ready\":true,\"latency_ms\":-1,"
+        "\"tx_bytes\":4294967296,\"ratio\":0.25,\"peer\":null,"
+        "\"hist\":[1,2,{}],\"empty\":[]}",
+        s_out);
+    TEST_ASSERT_EQUAL(1, s_flushes);
+    TEST_ASSERT_EQUAL(s_out_len, w.total);
+
+    /* Unbalanced close is reported */
+    reset();
+    json_writer_init(&w, buf, sizeof(buf), collect, NULL);
+    json_object_begin(&w, NULL);
+    TEST_ASSERT_FALSE(json_writer_finish(&w));
+}
+
+void test_json_writer_chunks_and_escapes(void) {
+    /* Same document through a 7-byte buffer */
+    char big[256];
+    json_writer_t w;
+    reset();
+    json_writer_init(&w, big, sizeof(big), collect, NULL);
+    write_status(&w);
+    json_writer_finish(&w);
+    char expect[512];
+    strcpy(expect, s_out);
+
+    char small[7];
+    reset();
+    json_writer_init(&w, small, sizeof(small), collect, NULL);
+    write_status(&w);
+    TEST_ASSERT_TRUE(json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING(expect, s_out);
+    TEST_ASSERT_TRUE(s_flushes > 10);
+
+    /* Quotes, backslashes and control characters */
+    reset();
+    json_writer_init(&w, big, sizeof(big), collect, NULL);
+    json_object_begin(&w, NULL);
+    json_string(&w, "text", "CQ \"DE\" a\\b\n\x01");
+    json_object_end(&w);
+    TEST_ASSERT_TRUE(json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("{\"text\":\"CQ \\\"DE\\\" a\\\\b\\n\\u0001\"}", s_out);
+
+    /* A failed flush stops the writer */
+    json_writer_init(&w, small, sizeof(small), refuse, NULL);
+    write_status(&w);
+    TEST_ASSERT_FALSE(json_writer_finish(&w));
+}
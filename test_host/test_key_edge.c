@@ -0,0 +1,206 @@
+/**
+ * @file test_key_edge.c
+ * @brief Unit tests for the edge-extraction stage and key edge ring
+ */
+
+#include "unity.h"
+#include "stream.h"
+#include "sample.h"
+#include "key_edge.h"
+#include "stubs/esp_stubs.h"
+
+#define TEST_BUFFER_SIZE 64
+static stream_slot_t s_buffer[TEST_BUFFER_SIZE];
+static keying_stream_t s_stream;
+static key_edge_ring_t s_ring;
+static key_edge_stage_t s_stage;
+
+void test_key_edge_stage_extracts_channels(void) {
+    stream_init(&s_stream, s_buffer, TEST_BUFFER_SIZE);
+    stream_set_tick_period_us(&s_stream, 100);
+    stream_set_epoch_us(&s_stream, 2000000);
+    key_edge_ring_init(&s_ring, &s_stream);
+    key_edge_stage_init(&s_stage, &s_stream, &s_ring);
+
+    key_edge_reader_t reader;
+    key_edge_reader_init(&reader, &s_ring);
+
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+
+    /* Ticks 0-2 idle */
+    for (int i = 0; i < 3; i++) {
+        stream_push(&s_stream, s);
+    }
+    /* Tick 3: DIT pressed, key down */
+    s.gpio = gpio_from_paddles(true, false);
+    s.local_key = 1;
+    stream_push(&s_stream, s);
+    /* Ticks 4-5 held */
+    stream_push(&s_stream, s);
+    stream_push(&s_stream, s);
+    /* Tick 6: DIT released, DAH pressed (key stays down) */
+    s.gpio = gpio_from_paddles(false, true);
+    stream_push(&s_stream, s);
+    /* Tick 7: key up */
+    s.local_key = 0;
+    stream_push(&s_stream, s);
+
+    TEST_ASSERT_EQUAL(5, key_edge_stage_run(&s_stage));
+    TEST_ASSERT_EQUAL(0, key_edge_stage_run(&s_stage));
+
+    key_edge_t e;
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_DIT, e.channel);
+    TEST_ASSERT_EQUAL(1, e.level);
+    TEST_ASSERT_TRUE(e.tick == 3);
+    TEST_ASSERT_TRUE(key_edge_time_us(&s_ring, e.tick) == 2000300);
+
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_KEY, e.channel);
+    TEST_ASSERT_EQUAL(1, e.level);
+    TEST_ASSERT_TRUE(e.tick == 3);
+
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_DIT, e.channel);
+    TEST_ASSERT_EQUAL(0, e.level);
+    TEST_ASSERT_TRUE(e.tick == 6);
+
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_DAH, e.channel);
+    TEST_ASSERT_EQUAL(1, e.level);
+    TEST_ASSERT_TRUE(e.tick == 6);
+
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_KEY, e.channel);
+    TEST_ASSERT_EQUAL(0, e.level);
+    TEST_ASSERT_TRUE(e.tick == 7);
+
+    TEST_ASSERT_FALSE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(0, reader.dropped);
+}
+
+void test_key_edge_reader_overrun(void) {
+    /* Large stream so only the edge ring overflows */
+    static stream_slot_t big[1024];
+    stream_init(&s_stream, big, 1024);
+    key_edge_ring_init(&s_ring, &s_stream);
+    key_edge_stage_init(&s_stage, &s_stream, &s_ring);
+
+    key_edge_reader_t slow;
+    key_edge_reader_t fast;
+    key_edge_reader_init(&slow, &s_ring);
+    key_edge_reader_init(&fast, &s_ring);
+
+    /* Toggle the key every tick: one KEY edge per sample */
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    const size_t total = KEY_EDGE_RING_CAPACITY + 40;
+    for (size_t i = 0; i < total; i++) {
+        s.local_key = (uint8_t)(s.local_key ^ 1U);
+        stream_push(&s_stream, s);
+    }
+    TEST_ASSERT_EQUAL(total, key_edge_stage_run(&s_stage));
+
+    /* Slow reader lost the oldest 40 edges and resumes at the oldest left */
+    key_edge_t e;
+    TEST_ASSERT_TRUE(key_edge_reader_next(&slow, &e));
+    TEST_ASSERT_EQUAL(40, slow.dropped);
+    TEST_ASSERT_TRUE(e.tick == 40);
+
+    size_t n = 1;
+    while (key_edge_reader_next(&slow, &e)) {
+        n++;
+    }
+    TEST_ASSERT_EQUAL(KEY_EDGE_RING_CAPACITY, n);
+    TEST_ASSERT_TRUE(e.tick == total - 1);
+
+    /* Readers are independent */
+    TEST_ASSERT_TRUE(key_edge_reader_next(&fast, &e));
+    TEST_ASSERT_EQUAL(40, fast.dropped);
+}
+
+void test_key_edge_stage_joins_with_state(void) {
+    stream_init(&s_stream, s_buffer, TEST_BUFFER_SIZE);
+    key_edge_ring_init(&s_ring, &s_stream);
+
+    /* DIT held and key down before the stage exists */
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    stream_push(&s_stream, s);
+    s.gpio = gpio_from_paddles(true, false);
+    s.local_key = 1;
+    for (int i = 0; i < 4; i++) {
+        stream_push(&s_stream, s);
+    }
+
+    key_edge_stage_init(&s_stage, &s_stream, &s_ring);
+    key_edge_reader_t reader;
+    key_edge_reader_init(&reader, &s_ring);
+
+    key_edge_t levels[KEY_EDGE_CH_COUNT];
+    key_edge_stage_levels(&s_stage, levels);
+    TEST_ASSERT_EQUAL(1, levels[KEY_EDGE_CH_KEY].level);
+    TEST_ASSERT_EQUAL(1, levels[KEY_EDGE_CH_DIT].level);
+    TEST_ASSERT_EQUAL(0, levels[KEY_EDGE_CH_DAH].level);
+    TEST_ASSERT_TRUE(levels[KEY_EDGE_CH_KEY].tick == 2);
+
+    /* Release: only the real changes come out, no replayed press */
+    s = STREAM_SAMPLE_EMPTY;
+    stream_push(&s_stream, s);
+    TEST_ASSERT_EQUAL(2, key_edge_stage_run(&s_stage));
+
+    key_edge_t e;
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_DIT, e.channel);
+    TEST_ASSERT_EQUAL(0, e.level);
+    TEST_ASSERT_TRUE(e.tick == 5);
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_KEY, e.channel);
+    TEST_ASSERT_EQUAL(0, e.level);
+    TEST_ASSERT_FALSE(key_edge_reader_next(&reader, &e));
+}
+
+void test_key_edge_stage_remote_and_head(void) {
+    stream_init(&s_stream, s_buffer, TEST_BUFFER_SIZE);
+    stream_set_tick_period_us(&s_stream, 1000);
+    key_edge_ring_init(&s_ring, &s_stream);
+    key_edge_stage_init(&s_stage, &s_stream, &s_ring);
+
+    static stream_producer_t remote;
+    stream_producer_init(&remote, &s_stream, STREAM_LANE_REMOTE);
+
+    key_edge_reader_t reader;
+    key_edge_reader_init(&reader, &s_ring);
+
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    for (int i = 0; i < 5; i++) {
+        stream_push(&s_stream, s);
+    }
+    s.local_key = 1;
+    stream_push(&s_stream, s);  /* Tick 5: flushes the idle run */
+
+    /* Remote key down, played ahead of the LOCAL position */
+    stream_producer_push(&remote, sample_remote_event(true, 40));
+
+    /* LOCAL held down, nothing written yet */
+    for (int i = 0; i < 10; i++) {
+        stream_push(&s_stream, s);
+    }
+
+    TEST_ASSERT_EQUAL(2, key_edge_stage_run(&s_stage));
+
+    key_edge_t e;
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_KEY, e.channel);
+    TEST_ASSERT_TRUE(e.tick == 5);
+    TEST_ASSERT_TRUE(key_edge_reader_next(&reader, &e));
+    TEST_ASSERT_EQUAL(KEY_EDGE_CH_REMOTE, e.channel);
+    TEST_ASSERT_EQUAL(1, e.level);
+    TEST_ASSERT_TRUE(e.tick == 40);
+
+    /* Head covers the pending idle run: 6 written ticks + 10 held */
+    TEST_ASSERT_TRUE(key_edge_head_tick(&s_ring, e.tick) == 16);
+
+    key_edge_t levels[KEY_EDGE_CH_COUNT];
+    key_edge_stage_levels(&s_stage, levels);
+    TEST_ASSERT_EQUAL(1, levels[KEY_EDGE_CH_KEY].level);
+    TEST_ASSERT_EQUAL(1, levels[KEY_EDGE_CH_REMOTE].level);
+}
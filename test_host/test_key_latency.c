@@ -0,0 +1,192 @@
+/**
+ * @file test_key_latency.c
+ * @brief Unit tests for the paddle-to-output latency probe
+ */
+
+#include "unity.h"
+#include "key_latency.h"
+
+static const int16_t k_silence[8] = { 0 };
+static const int16_t k_tone[8] = { 0, 12, -40, 300, -900, 1500, -1900, 2600 };
+
+void test_key_latency_bins(void) {
+    TEST_ASSERT_EQUAL(0, key_latency_bin(0));
+    TEST_ASSERT_EQUAL(3, key_latency_bin(3));
+    TEST_ASSERT_EQUAL(4, key_latency_bin(4));
+    TEST_ASSERT_EQUAL(7, key_latency_bin(7));
+    TEST_ASSERT_EQUAL(8, key_latency_bin(8));
+    TEST_ASSERT_EQUAL(8, key_latency_bin(9));
+    TEST_ASSERT_EQUAL(37, key_latency_bin(1500));   /* [1280, 1535] */
+    TEST_ASSERT_EQUAL(KEY_LATENCY_HIST_BINS - 1, key_latency_bin(UINT32_MAX));
+
+    /* Every value lands in the bin whose upper edge is the first >= it */
+    for (uint32_t us = 0; us < 200000; us += 7) {
+        uint32_t bin = key_latency_bin(us);
+        TEST_ASSERT_TRUE(us <= key_latency_bin_upper_us(bin));
+        if (bin > 0) {
+            TEST_ASSERT_TRUE(us > key_latency_bin_upper_us(bin - 1));
+        }
+    }
+    TEST_ASSERT_EQUAL(1535, key_latency_bin_upper_us(37));
+    TEST_ASSERT_EQUAL(UINT32_MAX, key_latency_bin_upper_us(KEY_LATENCY_HIST_BINS - 1));
+}
+
+void test_key_latency_tx_and_audio(void) {
+    key_latency_t lat;
+    key_latency_init(&lat);
+    key_latency_snapshot_t snap;
+
+    /* Off: nothing armed */
+    key_latency_edge(&lat, 1000);
+    key_latency_tx(&lat, true, 1400);
+    key_latency_get(&lat, KEY_LATENCY_PATH_TX, &snap);
+    TEST_ASSERT_EQUAL(0, snap.count);
+    key_latency_tx(&lat, false, 2000);
+
+    key_latency_set_mode(&lat, KEY_LATENCY_ON);
+    TEST_ASSERT_EQUAL(KEY_LATENCY_ON, key_latency_get_mode(&lat));
+
+    /* Press at 10000us: TX at 10450, first sounding block at 11200 */
+    key_latency_edge(&lat, 10000);
+    key_latency_edge(&lat, 10300);   /* Second press: already armed, ignored */
+    key_latency_tx(&lat, false, 10100);
+    key_latency_audio(&lat, k_silence, 8, 10200);
+    key_latency_tx(&lat, true, 10450);
+    key_latency_audio(&lat, k_tone, 8, 11200);
+
+    key_latency_get(&lat, KEY_LATENCY_PATH_TX, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+    TEST_ASSERT_EQUAL(450, snap.min_us);
+    TEST_ASSERT_EQUAL(450, snap.max_us);
+    TEST_ASSERT_EQUAL(1, snap.hist[key_latency_bin(450)]);
+    key_latency_get(&lat, KEY_LATENCY_PATH_AUDIO, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+    TEST_ASSERT_EQUAL(1200, snap.min_us);
+
+    /* A press while keyed or while the sidetone still sounds is not timed */
+    key_latency_edge(&lat, 12000);
+    key_latency_tx(&lat, false, 13000);
+    key_latency_edge(&lat, 13100);   /* Fade-out tail still in the last block */
+    key_latency_tx(&lat, true, 13500);
+    key_latency_get(&lat, KEY_LATENCY_PATH_TX, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+    TEST_ASSERT_EQUAL(0, lat.missed);
+}
+
+void test_key_latency_timeout(void) {
+    key_latency_t lat;
+    key_latency_init(&lat);
+    key_latency_set_mode(&lat, KEY_LATENCY_ON);
+
+    key_latency_edge(&lat, 5000);
+    key_latency_tx(&lat, false, 5000 + KEY_LATENCY_TIMEOUT_US);
+    TEST_ASSERT_EQUAL(0, lat.missed);
+    key_latency_tx(&lat, false, 5001 + KEY_LATENCY_TIMEOUT_US);
+    TEST_ASSERT_EQUAL(1, lat.missed);
+
+    /* Expired: late output is not recorded, the next press arms again */
+    key_latency_tx(&lat, true, 6000 + KEY_LATENCY_TIMEOUT_US);
+    key_latency_snapshot_t snap;
+    key_latency_get(&lat, KEY_LATENCY_PATH_TX, &snap);
+    TEST_ASSERT_EQUAL(0, snap.count);
+
+    key_latency_tx(&lat, false, 400000);
+    key_latency_edge(&lat, 500000);
+    key_latency_tx(&lat, true, 500900);
+    key_latency_get(&lat, KEY_LATENCY_PATH_TX, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+    TEST_ASSERT_EQUAL(900, snap.min_us);
+}
+
+void test_key_latency_loopback(void) {
+    key_latency_t lat;
+    key_latency_init(&lat);
+    key_latency_snapshot_t snap;
+
+    /* Mode on: the loopback path is not armed */
+    key_latency_set_mode(&lat, KEY_LATENCY_ON);
+    key_latency_edge(&lat, 1000);
+    key_latency_loopback(&lat, k_tone, 8, 2000, 8000);
+    key_latency_get(&lat, KEY_LATENCY_PATH_LOOPBACK, &snap);
+    TEST_ASSERT_EQUAL(0, snap.count);
+    key_latency_tx(&lat, true, 1200);
+    key_latency_audio(&lat, k_tone, 8, 1300);
+    key_latency_tx(&lat, false, 5000);
+    key_latency_audio(&lat, k_silence, 8, 5000);
+
+    key_latency_set_mode(&lat, KEY_LATENCY_LOOPBACK);
+    key_latency_edge(&lat, 100000);
+
+    /* Quiet chunk: still armed */
+    key_latency_loopback(&lat, k_silence, 8, 110000, 8000);
+    key_latency_get(&lat, KEY_LATENCY_PATH_LOOPBACK, &snap);
+    TEST_ASSERT_EQUAL(0, snap.count);
+
+    /* k_tone[7] is the first at threshold: the last sample, read at 130000 */
+    key_latency_loopback(&lat, k_tone, 8, 130000, 8000);
+    key_latency_get(&lat, KEY_LATENCY_PATH_LOOPBACK, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+    TEST_ASSERT_EQUAL(30000, snap.min_us);
+
+    /* Disarmed after one record */
+    key_latency_loopback(&lat, k_tone, 8, 140000, 8000);
+    key_latency_get(&lat, KEY_LATENCY_PATH_LOOPBACK, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+
+    /* Tone captured before the press (last element's tail) is skipped */
+    key_latency_tx(&lat, true, 100500);
+    key_latency_audio(&lat, k_tone, 8, 100600);
+    key_latency_tx(&lat, false, 200000);
+    key_latency_audio(&lat, k_silence, 8, 200000);
+    key_latency_edge(&lat, 300000);
+    key_latency_loopback(&lat, k_tone, 8, 299000, 8000);
+    key_latency_get(&lat, KEY_LATENCY_PATH_LOOPBACK, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+
+    /* No tone back at all: missed after the timeout */
+    key_latency_loopback(&lat, k_silence, 8, 300000 + KEY_LATENCY_TIMEOUT_US + 1000, 8000);
+    TEST_ASSERT_EQUAL(1, lat.missed);
+    TEST_ASSERT_FALSE(atomic_load(&lat.loop_armed));
+}
+
+void test_key_latency_percentiles_and_reset(void) {
+    key_latency_t lat;
+    key_latency_init(&lat);
+    key_latency_set_mode(&lat, KEY_LATENCY_ON);
+
+    /* 98 presses at 600us, one at 2500us, one at 9000us */
+    int64_t t = 1000000;
+    for (int i = 0; i < 100; i++) {
+        int64_t d = (i == 98) ? 2500 : (i == 99) ? 9000 : 600;
+        key_latency_edge(&lat, t);
+        key_latency_tx(&lat, true, t + d);
+        key_latency_audio(&lat, k_tone, 8, t + d);
+        key_latency_tx(&lat, false, t + 20000);
+        key_latency_audio(&lat, k_silence, 8, t + 20000);
+        t += 50000;
+    }
+
+    key_latency_snapshot_t snap;
+    key_latency_get(&lat, KEY_LATENCY_PATH_TX, &snap);
+    TEST_ASSERT_EQUAL(100, snap.count);
+    TEST_ASSERT_EQUAL(600, snap.min_us);
+    TEST_ASSERT_EQUAL(9000, snap.max_us);
+
+    /* 600us lands in [512, 639]; 2500us in [2048, 2559] */
+    TEST_ASSERT_EQUAL(639, key_latency_percentile_us(&snap, 50));
+    TEST_ASSERT_EQUAL(2559, key_latency_percentile_us(&snap, 99));
+    TEST_ASSERT_EQUAL(9000, key_latency_percentile_us(&snap, 100));
+
+    /* Reset shows empty at once, applied by the writer on its next record */
+    key_latency_reset(&lat);
+    key_latency_get(&lat, KEY_LATENCY_PATH_TX, &snap);
+    TEST_ASSERT_EQUAL(0, snap.count);
+    TEST_ASSERT_EQUAL(0, key_latency_percentile_us(&snap, 50));
+
+    key_latency_edge(&lat, t);
+    key_latency_tx(&lat, true, t + 700);
+    key_latency_get(&lat, KEY_LATENCY_PATH_TX, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+    TEST_ASSERT_EQUAL(700, snap.min_us);
+    TEST_ASSERT_EQUAL(1, snap.hist[key_latency_bin(700)]);
+}
@@ -0,0 +1,227 @@
+/**
+ * @file test_key_stats.c
+ * @brief Tests for the sliding-window keying statistics
+ */
+
+#include "unity.h"
+#include "key_stats.h"
+
+static key_stats_t s_ks;
+
+#define UNIT_20WPM 60000U
+
+/**
+ * @brief Key one word ("letters separated by spaces"), then a word gap
+ *
+ * Marks are weight_us longer and gaps weight_us shorter than the unit
+ * multiple; tagged marks carry the tags the iambic FSM would set.
+ *
+ * @return Time after the word gap (the next word starts there)
+ */
+static int64_t key_word(int64_t t, uint8_t ch, const char *word, uint32_t unit,
+                        uint32_t weight_us, bool tagged) {
+    uint32_t gap = 0;
+    bool in_char = false;
+
+    for (const char *p = word; *p != '\0'; p++) {
+        if (*p == ' ') {
+            gap = 3U * unit - weight_us;
+            in_char = false;
+            continue;
+        }
+        uint8_t tag = 0;
+        if (tagged) {
+            tag = (uint8_t)(KEY_TAG_ELEMENT | (*p == '-' ? KEY_TAG_DAH : 0) |
+                            (in_char ? KEY_TAG_IN_CHAR : 0));
+        }
+        t += gap;
+        key_stats_edge(&s_ks, t, ch, 1, tag);
+        t += (*p == '-' ? 3U * unit : unit) + weight_us;
+        key_stats_edge(&s_ks, t, ch, 0, 0);
+        key_stats_advance(&s_ks, t);
+        gap = unit - weight_us;
+        in_char = true;
+    }
+    return t + 7U * unit - weight_us;
+}
+
+static const char PARIS[] = ".--. .- .-. .. ...";
+
+void test_key_stats_paris_speed_and_spacing(void) {
+    key_stats_view_t v[KEY_STATS_WINDOWS];
+    int64_t t = 1000000;
+
+    key_stats_init(&s_ks);
+    TEST_ASSERT_EQUAL_INT64(0, key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v));
+    TEST_ASSERT_EQUAL_UINT32(10000000, key_stats_window_us(KEY_STATS_10S));
+
+    /* Untagged PARIS at 20 WPM: 3 s a word */
+    key_stats_advance(&s_ks, t);
+    for (int i = 0; i < 5; i++) {
+        t = key_word(t, KEY_EDGE_CH_KEY, PARIS, UNIT_20WPM, 0, false);
+    }
+    key_stats_advance(&s_ks, t);
+    TEST_ASSERT_EQUAL_INT64(t, key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v));
+
+    const key_stats_view_t *ten = &v[KEY_STATS_10S];
+    TEST_ASSERT_UINT32_WITHIN(1000000, 9500000, ten->span_us);
+    TEST_ASSERT_EQUAL_UINT16(200, ten->wpm_x10);
+    TEST_ASSERT_EQUAL_UINT16(500, ten->weight_pm);
+    TEST_ASSERT_EQUAL_UINT16(300, ten->dah_ratio_x100);
+    TEST_ASSERT_EQUAL_UINT16(300, ten->char_gap_x100);
+    TEST_ASSERT_EQUAL_UINT16(700, ten->word_gap_x100);
+    TEST_ASSERT_TRUE(ten->words >= 2);
+    TEST_ASSERT_TRUE(ten->chars > ten->words);
+
+    /* 22 of the 50 units are down */
+    TEST_ASSERT_UINT32_WITHIN(40, 440, ten->duty_pm);
+
+    /* The 60 s window still holds the whole 15 s: 5 words, the last gap not ended */
+    const key_stats_view_t *min = &v[KEY_STATS_60S];
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(t - 1000000), min->span_us);
+    TEST_ASSERT_EQUAL_UINT16(5 * 14, min->marks);
+    TEST_ASSERT_EQUAL_UINT16(4, min->words);
+    TEST_ASSERT_EQUAL_UINT16(5 * 4 + 4, min->chars);
+    TEST_ASSERT_EQUAL_UINT16(440, min->duty_pm);
+
+    /* Other channels saw nothing */
+    key_stats_get(&s_ks, KEY_EDGE_CH_DIT, v);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_10S].marks);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_10S].wpm_x10);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_10S].duty_pm);
+}
+
+void test_key_stats_tagged_weight(void) {
+    key_stats_view_t v[KEY_STATS_WINDOWS];
+    int64_t t = 0;
+
+    /* Weight 60%: dit 72 ms, element gap 48 ms, dah 192 ms */
+    key_stats_init(&s_ks);
+    key_stats_advance(&s_ks, t);
+    for (int i = 0; i < 4; i++) {
+        t = key_word(t, KEY_EDGE_CH_KEY, PARIS, UNIT_20WPM, 12000, true);
+    }
+    key_stats_advance(&s_ks, t);
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+
+    const key_stats_view_t *min = &v[KEY_STATS_60S];
+    TEST_ASSERT_EQUAL_UINT16(600, min->weight_pm);
+    TEST_ASSERT_EQUAL_UINT16(266, min->dah_ratio_x100);
+    TEST_ASSERT_EQUAL_UINT16(4 * 14, min->marks);
+    TEST_ASSERT_EQUAL_UINT16(3, min->words);
+    /* Marks borrow from the gaps: the unit comes out a little long */
+    TEST_ASSERT_UINT32_WITHIN(10, 195, min->wpm_x10);
+
+    /* A tag wins over the duration: a dah keyed as short as a dit */
+    key_stats_init(&s_ks);
+    key_stats_advance(&s_ks, 0);
+    key_stats_edge(&s_ks, 100000, KEY_EDGE_CH_KEY, 1, KEY_TAG_ELEMENT);
+    key_stats_edge(&s_ks, 160000, KEY_EDGE_CH_KEY, 0, 0);
+    key_stats_edge(&s_ks, 220000, KEY_EDGE_CH_KEY, 1, KEY_TAG_ELEMENT | KEY_TAG_DAH |
+                                                       KEY_TAG_IN_CHAR);
+    key_stats_edge(&s_ks, 280000, KEY_EDGE_CH_KEY, 0, 0);
+    key_stats_advance(&s_ks, 300000);
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+    TEST_ASSERT_EQUAL_UINT16(2, v[KEY_STATS_1S].marks);
+    TEST_ASSERT_EQUAL_UINT16(100, v[KEY_STATS_1S].dah_ratio_x100);
+    TEST_ASSERT_EQUAL_UINT32(300000, v[KEY_STATS_1S].span_us);
+    TEST_ASSERT_EQUAL_UINT16(400, v[KEY_STATS_1S].duty_pm);
+}
+
+void test_key_stats_windows_slide(void) {
+    key_stats_view_t v[KEY_STATS_WINDOWS];
+    int64_t t = 0;
+
+    key_stats_init(&s_ks);
+    key_stats_advance(&s_ks, t);
+    for (int i = 0; i < 4; i++) {
+        t = key_word(t, KEY_EDGE_CH_KEY, PARIS, UNIT_20WPM, 0, false);
+    }
+
+    /* 1.5 s of silence: gone from the 1 s window, still in the others */
+    key_stats_advance(&s_ks, t + 1500000);
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+    TEST_ASSERT_EQUAL_UINT32(1000000, key_stats_window_us(KEY_STATS_1S));
+    TEST_ASSERT_UINT32_WITHIN(100000, 950000, v[KEY_STATS_1S].span_us);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_1S].marks);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_1S].duty_pm);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_1S].wpm_x10);
+    TEST_ASSERT_TRUE(v[KEY_STATS_10S].marks > 0);
+    TEST_ASSERT_EQUAL_UINT16(4 * 14, v[KEY_STATS_60S].marks);
+
+    /* A minute later the 60 s window is empty too, and covers 54-60 s */
+    key_stats_advance(&s_ks, t + 61000000);
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_60S].marks);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_60S].duty_pm);
+    TEST_ASSERT_TRUE(v[KEY_STATS_60S].span_us >= 54000000);
+    TEST_ASSERT_TRUE(v[KEY_STATS_60S].span_us <= 60000000);
+
+    /* Held down for 3 s after an hour idle: 1 s and 10 s duty follow */
+    t += 3600000000LL;
+    key_stats_edge(&s_ks, t, KEY_EDGE_CH_KEY, 1, 0);
+    key_stats_advance(&s_ks, t + 3000000);
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+    TEST_ASSERT_EQUAL_UINT16(1000, v[KEY_STATS_1S].duty_pm);
+    TEST_ASSERT_EQUAL_UINT16(333, v[KEY_STATS_10S].duty_pm);   /* 3 s of the 9 s covered */
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_10S].marks);   /* Still down: no mark yet */
+
+    /* The long mark counts as a dah, the pause before it as nothing */
+    key_stats_edge(&s_ks, t + 3000000, KEY_EDGE_CH_KEY, 0, 0);
+    key_stats_advance(&s_ks, t + 3000000);
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+    TEST_ASSERT_EQUAL_UINT16(1, v[KEY_STATS_10S].marks);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_10S].chars);
+}
+
+void test_key_stats_untagged_learns_unit(void) {
+    key_stats_view_t v[KEY_STATS_WINDOWS];
+    int64_t t = 0;
+
+    /* "D" first: the dah seeds the unit, the next dit corrects it */
+    key_stats_init(&s_ks);
+    key_stats_advance(&s_ks, t);
+    t = key_word(t, KEY_EDGE_CH_KEY, "-..", UNIT_20WPM, 0, false);
+
+    /* Then 30 WPM (40 ms unit): speeding up is followed within a word */
+    t += 10000000;
+    for (int i = 0; i < 3; i++) {
+        t = key_word(t, KEY_EDGE_CH_KEY, PARIS, 40000, 0, false);
+    }
+    key_stats_advance(&s_ks, t);
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+    TEST_ASSERT_EQUAL_UINT16(300, v[KEY_STATS_10S].dah_ratio_x100);
+    TEST_ASSERT_EQUAL_UINT16(300, v[KEY_STATS_10S].wpm_x10);
+    TEST_ASSERT_EQUAL_UINT16(300, v[KEY_STATS_10S].char_gap_x100);
+
+    /* Contact bounce is not an element */
+    uint16_t marks = v[KEY_STATS_60S].marks;
+    key_stats_edge(&s_ks, t, KEY_EDGE_CH_KEY, 1, 0);
+    key_stats_edge(&s_ks, t + 2000, KEY_EDGE_CH_KEY, 0, 0);
+    key_stats_edge(&s_ks, t + 2000, KEY_EDGE_CH_KEY, 0, 0);   /* Repeated level */
+    key_stats_edge(&s_ks, t + 3000, KEY_EDGE_CH_KEY + KEY_STATS_CHANNELS, 1, 0);
+    key_stats_advance(&s_ks, t + 10000);
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+    TEST_ASSERT_EQUAL_UINT16(marks, v[KEY_STATS_60S].marks);
+}
+
+void test_key_stats_remote_ahead_of_local(void) {
+    key_stats_view_t v[KEY_STATS_WINDOWS];
+    int64_t t = 0;
+
+    /* REMOTE edges carry their play time, 150 ms ahead of the stage */
+    key_stats_init(&s_ks);
+    key_stats_advance(&s_ks, t);
+    for (int i = 0; i < 3; i++) {
+        int64_t end = key_word(t + 150000, KEY_EDGE_CH_REMOTE, PARIS, UNIT_20WPM, 0, false);
+        key_stats_advance(&s_ks, end - 150000);   /* Earlier than REMOTE's time: kept */
+        t = end - 150000;
+    }
+    key_stats_get(&s_ks, KEY_EDGE_CH_REMOTE, v);
+    TEST_ASSERT_EQUAL_UINT16(3 * 14, v[KEY_STATS_60S].marks);
+    TEST_ASSERT_EQUAL_UINT16(200, v[KEY_STATS_10S].wpm_x10);
+    TEST_ASSERT_EQUAL_UINT16(700, v[KEY_STATS_10S].word_gap_x100);
+
+    key_stats_get(&s_ks, KEY_EDGE_CH_KEY, v);
+    TEST_ASSERT_EQUAL_UINT16(0, v[KEY_STATS_60S].marks);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file test_led_anim.c
+ * @brief Tests for the precomputed LED animations
+ */
+
+#include "unity.h"
+#include "led_anim.h"
+#include <string.h>
+
+#define MS(x) ((int64_t)(x) * 1000)
+
+static led_anim_t s_anim;
+static uint8_t s_frame[LED_ANIM_FRAME_BYTES];
+
+static uint32_t pixel(size_t i) {
+    return ((uint32_t)s_frame[i * 3U] << 16) | ((uint32_t)s_frame[i * 3U + 1U] << 8) |
+           (uint32_t)s_frame[i * 3U + 2U];
+}
+
+void test_led_anim_breathing_lut(void) {
+    led_anim_init(&s_anim, 50, 10);
+    TEST_ASSERT_EQUAL_UINT8(0, s_anim.breath[0]);
+    TEST_ASSERT_EQUAL_UINT8(50, s_anim.breath[LED_ANIM_BREATH_STEPS / 2U]);
+    TEST_ASSERT_EQUAL_UINT8(25, s_anim.breath[LED_ANIM_BREATH_STEPS / 4U]);
+    TEST_ASSERT_EQUAL_HEX32(0x7F0000U, s_anim.full[LED_COLOR_RED]);
+    TEST_ASSERT_EQUAL_HEX32(0x001900U, s_anim.dim[LED_COLOR_GREEN]);
+
+    /* Peak of the breath: orange at full brightness on every LED */
+    TEST_ASSERT_EQUAL(LED_STATE_BOOT,
+                      led_anim_render(&s_anim, LED_STATE_BOOT, MS(1000), false, false, s_frame, 7));
+    for (size_t i = 0; i < 7; i++) {
+        TEST_ASSERT_EQUAL_HEX32(0x7F4000U, pixel(i));
+    }
+
+    /* Consecutive 10ms ticks on the same step render the same frame */
+    uint8_t first[LED_ANIM_FRAME_BYTES];
+    led_anim_render(&s_anim, LED_STATE_PROVISIONING, MS(500) + 1000, false, false, s_frame, 7);
+    memcpy(first, s_frame, sizeof(first));
+    led_anim_render(&s_anim, LED_STATE_PROVISIONING, MS(500) + 9000, false, false, s_frame, 7);
+    TEST_ASSERT_EQUAL_MEMORY(first, s_frame, 21);
+}
+
+void test_led_anim_flash_sequences(void) {
+    led_anim_init(&s_anim, 100, 10);
+
+    /* Three green flashes, then IDLE */
+    led_anim_render(&s_anim, LED_STATE_CONNECTED, MS(50), false, false, s_frame, 3);
+    TEST_ASSERT_EQUAL_HEX32(0x00FF00U, pixel(0));
+    led_anim_render(&s_anim, LED_STATE_CONNECTED, MS(150), false, false, s_frame, 3);
+    TEST_ASSERT_EQUAL_HEX32(0, pixel(0));
+    led_anim_render(&s_anim, LED_STATE_CONNECTED, MS(450), false, false, s_frame, 3);
+    TEST_ASSERT_EQUAL_HEX32(0x00FF00U, pixel(2));
+    TEST_ASSERT_EQUAL(LED_STATE_IDLE,
+                      led_anim_render(&s_anim, LED_STATE_CONNECTED, MS(600), false, false, s_frame, 3));
+
+    /* Red flash, then DEGRADED */
+    led_anim_render(&s_anim, LED_STATE_WIFI_FAILED, MS(499), false, false, s_frame, 3);
+    TEST_ASSERT_EQUAL_HEX32(0xFF0000U, pixel(1));
+    TEST_ASSERT_EQUAL(LED_STATE_DEGRADED,
+                      led_anim_render(&s_anim, LED_STATE_WIFI_FAILED, MS(500), false, false, s_frame, 3));
+}
+
+void test_led_anim_keying_overlay(void) {
+    led_anim_init(&s_anim, 100, 10);
+    uint32_t dim = s_anim.dim[LED_COLOR_GREEN];
+
+    led_anim_render(&s_anim, LED_STATE_IDLE, 0, true, false, s_frame, 7);
+    TEST_ASSERT_EQUAL_HEX32(0x00FF00U, pixel(0));
+    TEST_ASSERT_EQUAL_HEX32(0x00FF00U, pixel(2));
+    TEST_ASSERT_EQUAL_HEX32(dim, pixel(3));
+    TEST_ASSERT_EQUAL_HEX32(dim, pixel(6));
+
+    led_anim_render(&s_anim, LED_STATE_IDLE, 0, false, true, s_frame, 7);
+    TEST_ASSERT_EQUAL_HEX32(dim, pixel(3));
+    TEST_ASSERT_EQUAL_HEX32(0x00FF00U, pixel(4));
+    TEST_ASSERT_EQUAL_HEX32(0x00FF00U, pixel(6));
+
+    led_anim_render(&s_anim, LED_STATE_IDLE, 0, true, true, s_frame, 7);
+    TEST_ASSERT_EQUAL_HEX32(0xFF00FFU, pixel(3));
+    TEST_ASSERT_EQUAL_HEX32(dim, pixel(2));
+
+    /* Released: back to the steady frame */
+    led_anim_render(&s_anim, LED_STATE_IDLE, 0, false, false, s_frame, 7);
+    for (size_t i = 0; i < 7; i++) {
+        TEST_ASSERT_EQUAL_HEX32(dim, pixel(i));
+    }
+}
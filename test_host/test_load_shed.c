@@ -0,0 +1,155 @@
+/**
+ * @file test_load_shed.c
+ * @brief Tests for the overload supervisor
+ */
+
+#include "unity.h"
+#include "load_shed.h"
+
+#define PERIOD_US ((int64_t)LOAD_SHED_PERIOD_MS * 1000)
+
+static load_shed_t s_ls;
+static const load_shed_limits_t k_limits = {
+    .enabled = true, .max_missed_per_s = 4, .max_lag = 256,
+};
+
+/** Evaluations every period from *now_us, the counters advancing by the given steps */
+static load_shed_event_t run(int64_t *now_us, load_shed_input_t *in, int evals,
+                             uint32_t missed_step, uint32_t lag) {
+    load_shed_event_t ev = { .action = LOAD_SHED_NONE };
+    for (int i = 0; i < evals; i++) {
+        *now_us += PERIOD_US;
+        in->missed_ticks += missed_step;
+        in->lag = lag;
+        ev = load_shed_update(&s_ls, *now_us, in, &k_limits);
+    }
+    return ev;
+}
+
+void test_load_shed_thresholds(void) {
+    load_shed_input_t in = {0};
+    int64_t now = 0;
+    load_shed_init(&s_ls);
+    load_shed_update(&s_ls, now, &in, &k_limits);   /* Base */
+
+    /* 1 miss per 250 ms = 4/s: at the limit, not over it */
+    load_shed_event_t ev = run(&now, &in, 10, 1, 256);
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, ev.action);
+    TEST_ASSERT_EQUAL_UINT(0, load_shed_level(&s_ls));
+
+    /* One hot evaluation is not enough */
+    ev = run(&now, &in, 1, 2, 0);
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, ev.action);
+    TEST_ASSERT_EQUAL_UINT(LOAD_SHED_WHY_MISSED, ev.why);
+    ev = run(&now, &in, 1, 0, 0);
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, ev.action);
+
+    /* Two in a row shed the first step */
+    ev = run(&now, &in, 1, 0, 300);
+    TEST_ASSERT_EQUAL_UINT(LOAD_SHED_WHY_LAG, ev.why);
+    ev = run(&now, &in, 1, 0, 300);
+    TEST_ASSERT_EQUAL(LOAD_SHED_SHED, ev.action);
+    TEST_ASSERT_EQUAL(LOAD_SHED_LED, ev.step);
+    TEST_ASSERT_TRUE(load_shed_active(&s_ls, LOAD_SHED_LED));
+    TEST_ASSERT_FALSE(load_shed_active(&s_ls, LOAD_SHED_TIMELINE));
+
+    /* A stall or fault counts at once */
+    in.stalls++;
+    ev = run(&now, &in, 1, 0, 0);
+    TEST_ASSERT_EQUAL_UINT(LOAD_SHED_WHY_STALL, ev.why);
+
+    char buf[24];
+    TEST_ASSERT_EQUAL_STRING("missed+lag",
+                             load_shed_why_str(LOAD_SHED_WHY_MISSED | LOAD_SHED_WHY_LAG,
+                                               buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("none", load_shed_why_str(0, buf, sizeof(buf)));
+}
+
+void test_load_shed_order_and_pacing(void) {
+    load_shed_input_t in = {0};
+    int64_t now = 0;
+    load_shed_init(&s_ls);
+    load_shed_update(&s_ls, now, &in, &k_limits);
+
+    /* Sustained overload: one more step per LOAD_SHED_STEP_MS, in order */
+    static const load_shed_step_t k_order[] = {
+        LOAD_SHED_LED, LOAD_SHED_TIMELINE, LOAD_SHED_DECODER, LOAD_SHED_NVS,
+    };
+    int evals = 0;
+    unsigned shed = 0;
+    while (shed < LOAD_SHED_STEPS && evals < 100) {
+        load_shed_event_t ev = run(&now, &in, 1, 10, 0);
+        evals++;
+        if (ev.action == LOAD_SHED_SHED) {
+            TEST_ASSERT_EQUAL(k_order[shed], ev.step);
+            shed++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(LOAD_SHED_STEPS, load_shed_level(&s_ls));
+    TEST_ASSERT_EQUAL(LOAD_SHED_HOT_EVALS +
+                      (LOAD_SHED_STEPS - 1) * (LOAD_SHED_STEP_MS / LOAD_SHED_PERIOD_MS), evals);
+
+    /* Still overloaded: nothing more to shed */
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, run(&now, &in, 20, 10, 0).action);
+
+    uint32_t sheds = 0;
+    uint32_t restores = 0;
+    load_shed_totals(&s_ls, &sheds, &restores);
+    TEST_ASSERT_EQUAL_UINT32(LOAD_SHED_STEPS, sheds);
+    TEST_ASSERT_EQUAL_UINT32(0, restores);
+}
+
+void test_load_shed_restore_after_calm(void) {
+    load_shed_input_t in = {0};
+    int64_t now = 0;
+    load_shed_init(&s_ls);
+    load_shed_update(&s_ls, now, &in, &k_limits);
+    run(&now, &in, 2 + LOAD_SHED_STEP_MS / LOAD_SHED_PERIOD_MS, 10, 0);
+    TEST_ASSERT_EQUAL_UINT(2, load_shed_level(&s_ls));
+
+    /* Calm, but not for long enough */
+    int calm = LOAD_SHED_RESTORE_MS / LOAD_SHED_PERIOD_MS;
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, run(&now, &in, calm - 1, 0, 0).action);
+
+    /* A blip restarts the calm period */
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, run(&now, &in, 1, 10, 0).action);
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, run(&now, &in, calm - 1, 0, 0).action);
+    TEST_ASSERT_EQUAL_UINT(2, load_shed_level(&s_ls));
+
+    /* Last shed comes back first, one per calm period */
+    load_shed_event_t ev = run(&now, &in, 1, 0, 0);
+    TEST_ASSERT_EQUAL(LOAD_SHED_RESTORE, ev.action);
+    TEST_ASSERT_EQUAL(LOAD_SHED_TIMELINE, ev.step);
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, run(&now, &in, calm - 1, 0, 0).action);
+    ev = run(&now, &in, 1, 0, 0);
+    TEST_ASSERT_EQUAL(LOAD_SHED_RESTORE, ev.action);
+    TEST_ASSERT_EQUAL(LOAD_SHED_LED, ev.step);
+    TEST_ASSERT_EQUAL_UINT(0, load_shed_level(&s_ls));
+    TEST_ASSERT_EQUAL_UINT32(1, atomic_load(&s_ls.restores[LOAD_SHED_LED]));
+    TEST_ASSERT_EQUAL_UINT32(1, atomic_load(&s_ls.restores[LOAD_SHED_TIMELINE]));
+}
+
+void test_load_shed_disabled_and_counter_reset(void) {
+    load_shed_input_t in = { .missed_ticks = 1000 };
+    int64_t now = 0;
+    load_shed_init(&s_ls);
+    load_shed_update(&s_ls, now, &in, &k_limits);
+    run(&now, &in, 2 + LOAD_SHED_STEP_MS / LOAD_SHED_PERIOD_MS, 10, 0);
+    TEST_ASSERT_EQUAL_UINT(2, load_shed_level(&s_ls));
+
+    /* Switched off: everything back within one evaluation per step, and stays */
+    load_shed_limits_t off = k_limits;
+    off.enabled = false;
+    in.missed_ticks += 100;
+    TEST_ASSERT_EQUAL(LOAD_SHED_RESTORE, load_shed_update(&s_ls, now += PERIOD_US, &in, &off).action);
+    TEST_ASSERT_EQUAL(LOAD_SHED_RESTORE, load_shed_update(&s_ls, now += PERIOD_US, &in, &off).action);
+    in.missed_ticks += 100;
+    TEST_ASSERT_EQUAL(LOAD_SHED_NONE, load_shed_update(&s_ls, now += PERIOD_US, &in, &off).action);
+    TEST_ASSERT_EQUAL_UINT(0, load_shed_level(&s_ls));
+
+    /* Counters reset under the supervisor (stats rt reset): not an overload */
+    in.missed_ticks = 0;
+    load_shed_event_t ev = load_shed_update(&s_ls, now += PERIOD_US, &in, &k_limits);
+    TEST_ASSERT_EQUAL_UINT(0, ev.why);
+    TEST_ASSERT_EQUAL_STRING("decoder", load_shed_step_str(LOAD_SHED_DECODER));
+}
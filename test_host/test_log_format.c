@@ -0,0 +1,132 @@
+/**
+ * @file test_log_format.c
+ * @brief Tests for the RT log formatter (snprintf subset) and argument packer
+ */
+
+#include "unity.h"
+#include "rt_log.h"
+#include <string.h>
+#include <stdarg.h>
+
+#define CHECK_FORMAT(fmt, ...) do { \
+    char expect[64]; \
+    char got[64]; \
+    int n_expect = snprintf(expect, sizeof(expect), fmt, ##__VA_ARGS__); \
+    int n_got = log_format(got, sizeof(got), fmt, ##__VA_ARGS__); \
+    TEST_ASSERT_EQUAL_STRING(expect, got); \
+    TEST_ASSERT_EQUAL_INT(n_expect, n_got); \
+} while (0)
+
+static log_stream_t s_stream;
+
+/** Pack as RT_LOG does, then expand as the drain side does */
+static int pack_then_format(char *buf, size_t size, const char *fmt, ...) {
+    uint8_t args[LOG_MAX_MSG_LEN];
+    va_list ap;
+    va_start(ap, fmt);
+    size_t len = log_vpack(args, sizeof(args), fmt, ap);
+    va_end(ap);
+    return log_format_packed(buf, size, fmt, args, len);
+}
+
+#define CHECK_PACKED(fmt, ...) do { \
+    char expect[64]; \
+    char got[64]; \
+    int n_expect = snprintf(expect, sizeof(expect), fmt, ##__VA_ARGS__); \
+    int n_got = pack_then_format(got, sizeof(got), fmt, ##__VA_ARGS__); \
+    TEST_ASSERT_EQUAL_STRING(expect, got); \
+    TEST_ASSERT_EQUAL_INT(n_expect, n_got); \
+} while (0)
+
+void test_log_format_matches_snprintf(void) {
+    CHECK_FORMAT("plain text");
+    CHECK_FORMAT("100%%");
+    CHECK_FORMAT("KEY up %lldus", (long long)-123456789012LL);
+    CHECK_FORMAT("WPM=%lu freq=%lu", 25UL, 600UL);
+    CHECK_FORMAT("%d %i %u", -42, 0, 4000000000U);
+    CHECK_FORMAT("[%5d|%-5d|%05d]", -7, 7, -7);
+    CHECK_FORMAT("%02x:%02X %x", 0x0a, 0xBE, 0xdeadbeefU);
+    CHECK_FORMAT("%zu bytes", (size_t)597);
+    CHECK_FORMAT("%hhu %hd", 300, 70000);
+    CHECK_FORMAT("%.3d %.2s", 5, "abc");
+    CHECK_FORMAT("FAULT: %s [%-6s] %c", "OVERRUN", "ok", 'x');
+}
+
+void test_log_format_truncates(void) {
+    char buf[8];
+    int n = log_format(buf, sizeof(buf), "tick %u of %u", 12345U, 67890U);
+
+    /* Returns the untruncated length and always terminates */
+    TEST_ASSERT_EQUAL_INT((int)strlen("tick 12345 of 67890"), n);
+    TEST_ASSERT_EQUAL_STRING("tick 12", buf);
+
+    /* size 0 writes nothing */
+    buf[0] = 'Z';
+    TEST_ASSERT_EQUAL_INT(3, log_format(buf, 0, "%s", "abc"));
+    TEST_ASSERT_EQUAL_HEX8('Z', buf[0]);
+}
+
+void test_log_format_packed_matches_snprintf(void) {
+    CHECK_PACKED("plain text");
+    CHECK_PACKED("100%%");
+    CHECK_PACKED("KEY up %lldus", (long long)-123456789012LL);
+    CHECK_PACKED("WPM=%lu freq=%lu", 25UL, 600UL);
+    CHECK_PACKED("%d %i %u", -42, 0, 4000000000U);
+    CHECK_PACKED("[%5d|%-5d|%05d]", -7, 7, -7);
+    CHECK_PACKED("%02x:%02X %x", 0x0a, 0xBE, 0xdeadbeefU);
+    CHECK_PACKED("%zu bytes", (size_t)597);
+    CHECK_PACKED("%hhu %hd", 300, 70000);
+    CHECK_PACKED("%.3d %.2s", 5, "abc");
+    CHECK_PACKED("FAULT: %s [%-6s] %c", "OVERRUN", "ok", 'x');
+}
+
+void test_log_pack_copies_strings(void) {
+    char name[8] = "before";
+    log_stream_init(&s_stream);
+
+    TEST_ASSERT_TRUE(log_stream_pushf(&s_stream, 1, LOG_LEVEL_INFO, "peer %s up %d", name, 3));
+    strcpy(name, "after");
+
+    log_entry_t entry;
+    char msg[LOG_MAX_MSG_LEN];
+    log_reader_t reader;
+    log_reader_init(&reader, &s_stream, LOG_LEVEL_TRACE);
+    TEST_ASSERT_TRUE(log_reader_next(&reader, &entry));
+    log_entry_format(&entry, msg, sizeof(msg));
+    TEST_ASSERT_EQUAL_STRING("peer before up 3", msg);
+}
+
+void test_log_pack_overflow_formats_missing_as_zero(void) {
+    char big[LOG_MAX_MSG_LEN + 16];
+    char msg[2 * LOG_MAX_MSG_LEN];
+    memset(big, 'a', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+
+    log_stream_init(&s_stream);
+    TEST_ASSERT_TRUE(log_stream_pushf(&s_stream, 1, LOG_LEVEL_INFO, "%s|%d", big, 42));
+
+    log_entry_t entry;
+    log_reader_t reader;
+    log_reader_init(&reader, &s_stream, LOG_LEVEL_TRACE);
+    TEST_ASSERT_TRUE(log_reader_next(&reader, &entry));
+    TEST_ASSERT_EQUAL_UINT(LOG_MAX_MSG_LEN, entry.len);
+    log_entry_format(&entry, msg, sizeof(msg));
+
+    /* String cut to what fits, the int that did not fit reads as 0 */
+    TEST_ASSERT_EQUAL_size_t(LOG_MAX_MSG_LEN - 1 + 2, strlen(msg));
+    TEST_ASSERT_EQUAL_STRING("|0", msg + LOG_MAX_MSG_LEN - 1);
+}
+
+void test_log_entry_format_text(void) {
+    log_stream_init(&s_stream);
+    TEST_ASSERT_TRUE(log_stream_push(&s_stream, 5, LOG_LEVEL_WARN, "raw %d text", 10));
+
+    log_entry_t entry;
+    char msg[LOG_MAX_MSG_LEN];
+    log_reader_t reader;
+    log_reader_init(&reader, &s_stream, LOG_LEVEL_TRACE);
+    TEST_ASSERT_TRUE(log_reader_next(&reader, &entry));
+    TEST_ASSERT_NULL(entry.fmt);
+    TEST_ASSERT_EQUAL_INT(10, log_entry_format(&entry, msg, sizeof(msg)));
+    TEST_ASSERT_EQUAL_STRING("raw %d tex", msg);
+}
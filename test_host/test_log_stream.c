@@ -0,0 +1,135 @@
+/**
+ * @file test_log_stream.c
+ * @brief Tests for the variable-length log ring and its readers
+ */
+
+#include "unity.h"
+#include "rt_log.h"
+#include <string.h>
+
+static log_stream_t s_stream;
+
+/** Ring bytes one pushf("n %u") record takes */
+static uint32_t record_size(void) {
+    return (uint32_t)(sizeof(log_record_t) + sizeof(unsigned int));
+}
+
+static unsigned int arg_u(const log_entry_t *entry) {
+    unsigned int v;
+    memcpy(&v, entry->args, sizeof(v));
+    return v;
+}
+
+void test_log_stream_counts_entries_and_bytes(void) {
+    log_entry_t entry;
+    log_reader_t reader;
+    log_stream_init(&s_stream);
+    log_reader_init(&reader, &s_stream, LOG_LEVEL_TRACE);
+
+    TEST_ASSERT_TRUE(log_stream_pushf(&s_stream, 1, LOG_LEVEL_INFO, "n %u", 1U));
+    TEST_ASSERT_TRUE(log_stream_push(&s_stream, 2, LOG_LEVEL_WARN, "hello", 5));
+    TEST_ASSERT_EQUAL_UINT32(2, log_stream_count(&s_stream));
+    TEST_ASSERT_EQUAL_UINT32(2, log_reader_pending(&reader));
+    TEST_ASSERT_EQUAL_UINT32(record_size() + sizeof(log_record_t) + 5,
+                             log_stream_bytes(&s_stream));
+
+    TEST_ASSERT_TRUE(log_reader_next(&reader, &entry));
+    TEST_ASSERT_EQUAL_INT64(1, entry.timestamp_us);
+    TEST_ASSERT_EQUAL_UINT8(sizeof(unsigned int), entry.len);
+
+    TEST_ASSERT_TRUE(log_reader_next(&reader, &entry));
+    TEST_ASSERT_NULL(entry.fmt);
+    TEST_ASSERT_EQUAL(LOG_LEVEL_WARN, entry.level);
+    TEST_ASSERT_EQUAL_MEMORY("hello", entry.args, 5);
+
+    TEST_ASSERT_FALSE(log_reader_next(&reader, &entry));
+    TEST_ASSERT_EQUAL_UINT32(0, log_reader_pending(&reader));
+    /* Records stay in the ring for other readers */
+    TEST_ASSERT_EQUAL_UINT32(2, log_stream_count(&s_stream));
+}
+
+void test_log_stream_wraps(void) {
+    log_entry_t entry;
+    log_reader_t reader;
+    char msg[LOG_MAX_MSG_LEN];
+    log_stream_init(&s_stream);
+    log_reader_init(&reader, &s_stream, LOG_LEVEL_TRACE);
+
+    /* Several laps of the ring with records that straddle the end */
+    for (unsigned int i = 0; i < 4U * LOG_RING_BYTES / 32U; i++) {
+        TEST_ASSERT_TRUE(log_stream_pushf(&s_stream, (int64_t)i, LOG_LEVEL_INFO,
+                                          "n %u %s", i, "wrap"));
+        TEST_ASSERT_TRUE(log_reader_next(&reader, &entry));
+        TEST_ASSERT_EQUAL_INT64(i, entry.timestamp_us);
+
+        char expect[LOG_MAX_MSG_LEN];
+        snprintf(expect, sizeof(expect), "n %u wrap", i);
+        log_entry_format(&entry, msg, sizeof(msg));
+        TEST_ASSERT_EQUAL_STRING(expect, msg);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, log_reader_dropped(&reader));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LOG_RING_BYTES, log_stream_bytes(&s_stream));
+}
+
+void test_log_stream_overwrites_oldest(void) {
+    log_entry_t entry;
+    log_reader_t reader;
+    log_stream_init(&s_stream);
+    log_reader_init(&reader, &s_stream, LOG_LEVEL_TRACE);
+
+    /* Never blocks: a full ring evicts its oldest records */
+    uint32_t fits = LOG_RING_BYTES / record_size();
+    uint32_t pushed = fits + 10U;
+    for (unsigned int i = 0; i < pushed; i++) {
+        TEST_ASSERT_TRUE(log_stream_pushf(&s_stream, 0, LOG_LEVEL_INFO, "n %u", i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(fits, log_stream_count(&s_stream));
+    TEST_ASSERT_EQUAL_UINT32(fits, log_reader_pending(&reader));
+
+    /* The lapped reader resumes at the oldest intact record */
+    TEST_ASSERT_TRUE(log_reader_next(&reader, &entry));
+    TEST_ASSERT_EQUAL_UINT32(pushed - fits, arg_u(&entry));
+    TEST_ASSERT_EQUAL_UINT32(pushed - fits, log_reader_dropped(&reader));
+
+    uint32_t n = 1;
+    while (log_reader_next(&reader, &entry)) {
+        TEST_ASSERT_EQUAL_UINT32(pushed - fits + n, arg_u(&entry));
+        n++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(fits, n);
+
+    log_reader_reset_dropped(&reader);
+    TEST_ASSERT_EQUAL_UINT32(0, log_reader_dropped(&reader));
+}
+
+void test_log_stream_readers_are_independent(void) {
+    log_entry_t entry;
+    log_reader_t all;
+    log_reader_t warn;
+    log_stream_init(&s_stream);
+    log_reader_init(&all, &s_stream, LOG_LEVEL_TRACE);
+    log_reader_init(&warn, &s_stream, LOG_LEVEL_WARN);
+
+    log_stream_pushf(&s_stream, 1, LOG_LEVEL_INFO, "n %u", 1U);
+    log_stream_pushf(&s_stream, 2, LOG_LEVEL_ERROR, "n %u", 2U);
+    log_stream_pushf(&s_stream, 3, LOG_LEVEL_DEBUG, "n %u", 3U);
+
+    /* Draining one sink leaves the others their records */
+    uint32_t n = 0;
+    while (log_reader_next(&all, &entry)) {
+        n++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, n);
+
+    /* Level filter at the cursor; filtered records are not drops */
+    TEST_ASSERT_TRUE(log_reader_next(&warn, &entry));
+    TEST_ASSERT_EQUAL_UINT32(2, arg_u(&entry));
+    TEST_ASSERT_FALSE(log_reader_next(&warn, &entry));
+    TEST_ASSERT_EQUAL_UINT32(0, log_reader_dropped(&warn));
+
+    /* A reader attached late still finds what the ring holds */
+    log_reader_t late;
+    log_reader_init(&late, &s_stream, LOG_LEVEL_TRACE);
+    TEST_ASSERT_TRUE(log_reader_next(&late, &entry));
+    TEST_ASSERT_EQUAL_INT64(1, entry.timestamp_us);
+}
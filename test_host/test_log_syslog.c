@@ -0,0 +1,117 @@
+/**
+ * @file test_log_syslog.c
+ * @brief Tests for the remote syslog datagrams
+ */
+
+#include "unity.h"
+#include "log_syslog.h"
+#include <string.h>
+
+static log_stream_t s_stream;
+static log_reader_t s_reader;
+static log_syslog_batch_t s_batch;
+
+static const char FMT_KEY[] = "key %s %d";
+
+static log_entry_t push_and_drain(int64_t ts, log_level_t level, const char *state, int n) {
+    log_entry_t entry;
+    log_stream_pushf(&s_stream, ts, level, FMT_KEY, state, n);
+    TEST_ASSERT_TRUE(log_reader_next(&s_reader, &entry));
+    return entry;
+}
+
+void test_log_syslog_rfc5424(void) {
+    char buf[256];
+    log_stream_init(&s_stream);
+    log_reader_init(&s_reader, &s_stream, LOG_LEVEL_TRACE);
+
+    /* No wall clock: NILVALUE timestamp, uptime in hundredths */
+    log_entry_t entry = push_and_drain(12345678, LOG_LEVEL_INFO, "down", 7);
+    size_t n = log_syslog_rfc5424(&entry, "N0CALL", "BG", 42, 0, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(
+        "<134>1 - N0CALL keyer - BG [meta sequenceId=\"42\" sysUpTime=\"1234\"] key down 7", buf);
+    TEST_ASSERT_EQUAL(strlen(buf), n);
+
+    /* Wall clock set: the record's own time; errors are severity 3, spaces in the host go */
+    entry = push_and_drain(250000, LOG_LEVEL_ERROR, "up", 1);
+    log_syslog_rfc5424(&entry, "IU3QEZ /P", "RT", 1, 1791969123LL * 1000000LL, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(
+        "<131>1 2026-10-14T09:12:03.250000Z IU3QEZ_/P keyer - RT "
+        "[meta sequenceId=\"1\" sysUpTime=\"25\"] key up 1", buf);
+
+    /* Cut to fit, still terminated */
+    n = log_syslog_rfc5424(&entry, "", "RT", 1, 0, buf, 24);
+    TEST_ASSERT_EQUAL(23, n);
+    TEST_ASSERT_EQUAL_STRING("<131>1 - - keyer - RT [", buf);
+
+    TEST_ASSERT_EQUAL(7, log_syslog_severity(LOG_LEVEL_TRACE));
+    TEST_ASSERT_EQUAL(4, log_syslog_severity(LOG_LEVEL_WARN));
+}
+
+void test_log_syslog_binary_packs(void) {
+    log_stream_init(&s_stream);
+    log_reader_init(&s_reader, &s_stream, LOG_LEVEL_TRACE);
+
+    log_syslog_batch_begin(&s_batch);
+    TEST_ASSERT_EQUAL_HEX8(LOG_WIRE_SYNC, s_batch.buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(LOG_WIRE_HELLO, s_batch.buf[1]);
+    size_t hello = s_batch.len;
+
+    /* The format goes out once per datagram, then only records */
+    log_entry_t down = push_and_drain(1000, LOG_LEVEL_INFO, "down", 1);
+    TEST_ASSERT_TRUE(log_syslog_batch_add(&s_batch, &down, 2));
+    size_t first = s_batch.len - hello;
+    TEST_ASSERT_EQUAL_HEX8(LOG_WIRE_FMT, s_batch.buf[hello + 1]);
+    log_entry_t entry = push_and_drain(2000, LOG_LEVEL_INFO, "up", 2);
+    TEST_ASSERT_TRUE(log_syslog_batch_add(&s_batch, &entry, 2));
+    size_t record = s_batch.len - hello - first;
+    TEST_ASSERT_TRUE(record < first);
+    TEST_ASSERT_EQUAL_HEX8(LOG_WIRE_RECORD, s_batch.buf[hello + first + 1]);
+
+    /* Fill to the datagram size */
+    uint32_t records = s_batch.records;
+    while (log_syslog_batch_add(&s_batch, &entry, 2)) {
+        records++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(records, s_batch.records);
+    TEST_ASSERT_TRUE(records > 20);
+    TEST_ASSERT_TRUE(s_batch.len <= LOG_SYSLOG_DATAGRAM_MAX);
+    TEST_ASSERT_TRUE(s_batch.len + record > LOG_SYSLOG_DATAGRAM_MAX);
+
+    /* Next datagram stands alone: HELLO and the format again */
+    log_syslog_batch_begin(&s_batch);
+    TEST_ASSERT_EQUAL(0, s_batch.records);
+    TEST_ASSERT_TRUE(log_syslog_batch_add(&s_batch, &down, 2));
+    TEST_ASSERT_EQUAL(hello + first, s_batch.len);
+    TEST_ASSERT_TRUE(log_syslog_batch_dropped(&s_batch, 2, 9));
+    TEST_ASSERT_EQUAL_HEX8(LOG_WIRE_DROPPED, s_batch.buf[hello + first + 1]);
+}
+
+void test_log_syslog_rate_limit(void) {
+    log_syslog_rate_t rate;
+    log_syslog_rate_init(&rate, 0, 10);
+
+    /* One second's worth at once, then per_s a second */
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE(log_syslog_rate_take(&rate, 0, 10));
+    }
+    TEST_ASSERT_FALSE(log_syslog_rate_take(&rate, 0, 10));
+    TEST_ASSERT_FALSE(log_syslog_rate_take(&rate, 99000, 10));
+    TEST_ASSERT_TRUE(log_syslog_rate_take(&rate, 100000, 10));
+    TEST_ASSERT_FALSE(log_syslog_rate_take(&rate, 100000, 10));
+
+    /* Idle time fills no more than the burst */
+    int sent = 0;
+    while (log_syslog_rate_take(&rate, 60000000, 10)) {
+        sent++;
+    }
+    TEST_ASSERT_EQUAL(10, sent);
+
+    /* Lowered at run time: the burst shrinks with it */
+    log_syslog_rate_init(&rate, 0, 10);
+    sent = 0;
+    while (log_syslog_rate_take(&rate, 0, 2)) {
+        sent++;
+    }
+    TEST_ASSERT_EQUAL(2, sent);
+}
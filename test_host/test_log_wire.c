@@ -0,0 +1,111 @@
+/**
+ * @file test_log_wire.c
+ * @brief Tests for the binary log wire format
+ */
+
+#include "unity.h"
+#include "log_wire.h"
+#include <string.h>
+
+static log_stream_t s_stream;
+static log_reader_t s_reader;
+static log_wire_dict_t s_dict;
+static uint8_t s_buf[2 * LOG_WIRE_FRAME_MAX];
+
+static const char FMT_A[] = "key %s %d";
+static const char FMT_B[] = "lag %u";
+
+/** Validate one frame at p; returns its length */
+static size_t check_frame(const uint8_t *p, uint8_t type) {
+    TEST_ASSERT_EQUAL_HEX8(LOG_WIRE_SYNC, p[0]);
+    TEST_ASSERT_EQUAL_HEX8(type, p[1]);
+    uint8_t sum = (uint8_t)(p[1] + p[2]);
+    for (size_t i = 0; i < p[2]; i++) {
+        sum = (uint8_t)(sum + p[3 + i]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(sum, p[3 + p[2]]);
+    return LOG_WIRE_OVERHEAD + p[2];
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static log_entry_t drain_one(void) {
+    log_entry_t entry;
+    TEST_ASSERT_TRUE(log_reader_next(&s_reader, &entry));
+    return entry;
+}
+
+void test_log_wire_hello(void) {
+    size_t n = log_wire_hello(s_buf);
+    TEST_ASSERT_EQUAL_size_t(n, check_frame(s_buf, LOG_WIRE_HELLO));
+    TEST_ASSERT_EQUAL_UINT8(LOG_WIRE_VERSION, s_buf[3]);
+    TEST_ASSERT_EQUAL_UINT8(sizeof(long), s_buf[5]);
+}
+
+void test_log_wire_defines_format_once(void) {
+    log_wire_dict_reset(&s_dict);
+    log_stream_init(&s_stream);
+    log_reader_init(&s_reader, &s_stream, LOG_LEVEL_TRACE);
+    log_stream_pushf(&s_stream, 0x0102030405LL, LOG_LEVEL_WARN, FMT_A, "down", 7);
+    log_entry_t entry = drain_one();
+
+    /* First use: FMT then RECORD */
+    size_t n = log_wire_encode(&s_dict, &entry, 3, s_buf);
+    size_t f = check_frame(s_buf, LOG_WIRE_FMT);
+    uint16_t id = get16(s_buf + 3);
+    TEST_ASSERT_EQUAL_size_t(2 + strlen(FMT_A), s_buf[2]);
+    TEST_ASSERT_EQUAL_MEMORY(FMT_A, s_buf + 5, strlen(FMT_A));
+
+    const uint8_t *r = s_buf + f;
+    TEST_ASSERT_EQUAL_size_t(n - f, check_frame(r, LOG_WIRE_RECORD));
+    TEST_ASSERT_EQUAL_HEX8(0x05, r[3]);                 /* ts LE */
+    TEST_ASSERT_EQUAL_HEX8(0x01, r[7]);
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_WARN, r[11]);
+    TEST_ASSERT_EQUAL_UINT8(3, r[12]);
+    TEST_ASSERT_EQUAL_UINT16(id, get16(r + 13));
+    TEST_ASSERT_EQUAL_size_t(12 + entry.len, r[2]);
+    TEST_ASSERT_EQUAL_MEMORY(entry.args, r + 15, entry.len);
+
+    /* Again: RECORD only, same ID */
+    n = log_wire_encode(&s_dict, &entry, 3, s_buf);
+    TEST_ASSERT_EQUAL_size_t(n, check_frame(s_buf, LOG_WIRE_RECORD));
+    TEST_ASSERT_EQUAL_UINT16(id, get16(s_buf + 13));
+
+    /* Another format gets another ID */
+    log_stream_pushf(&s_stream, 2, LOG_LEVEL_WARN, FMT_B, 5U);
+    entry = drain_one();
+    log_wire_encode(&s_dict, &entry, 3, s_buf);
+    check_frame(s_buf, LOG_WIRE_FMT);
+    TEST_ASSERT_NOT_EQUAL(id, get16(s_buf + 3));
+
+    /* New session: defined again */
+    log_wire_dict_reset(&s_dict);
+    log_stream_pushf(&s_stream, 3, LOG_LEVEL_WARN, FMT_A, "up", 0);
+    entry = drain_one();
+    log_wire_encode(&s_dict, &entry, 3, s_buf);
+    check_frame(s_buf, LOG_WIRE_FMT);
+}
+
+void test_log_wire_text_entry(void) {
+    log_entry_t entry;
+    log_wire_dict_reset(&s_dict);
+    log_stream_init(&s_stream);
+    log_reader_init(&s_reader, &s_stream, LOG_LEVEL_TRACE);
+    log_stream_push(&s_stream, 1, LOG_LEVEL_INFO, "hello", 5);
+    TEST_ASSERT_TRUE(log_reader_next(&s_reader, &entry));
+
+    size_t n = log_wire_encode(&s_dict, &entry, 0, s_buf);
+    TEST_ASSERT_EQUAL_size_t(n, check_frame(s_buf, LOG_WIRE_RECORD));
+    TEST_ASSERT_EQUAL_UINT16(LOG_WIRE_TEXT_ID, get16(s_buf + 13));
+    TEST_ASSERT_EQUAL_MEMORY("hello", s_buf + 15, 5);
+}
+
+void test_log_wire_dropped(void) {
+    size_t n = log_wire_dropped(s_buf, 9, 0x01020304U);
+    TEST_ASSERT_EQUAL_size_t(n, check_frame(s_buf, LOG_WIRE_DROPPED));
+    TEST_ASSERT_EQUAL_UINT8(9, s_buf[3]);
+    TEST_ASSERT_EQUAL_HEX8(0x04, s_buf[4]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, s_buf[7]);
+}
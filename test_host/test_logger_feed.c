@@ -0,0 +1,136 @@
+/**
+ * @file test_logger_feed.c
+ * @brief Tests for the logger feed datagrams
+ */
+
+#include "unity.h"
+#include "logger_feed.h"
+#include <string.h>
+
+static logger_feed_batch_t s_batch;
+static logger_feed_words_t s_words;
+
+static const logger_feed_header_t k_hdr = {
+    .callsign = "IU3QEZ", .seq = 7, .keyer_wpm = 25, .rx_wpm = 18, .tx = true, .rx = false,
+};
+
+/** The batch as a C string */
+static const char *text(void) {
+    static char buf[LOGGER_FEED_DATAGRAM_MAX + 1];
+    memcpy(buf, s_batch.buf, s_batch.len);
+    buf[s_batch.len] = '\0';
+    return buf;
+}
+
+void test_logger_feed_batch_format(void) {
+    logger_feed_batch_begin(&s_batch, &k_hdr);
+    TEST_ASSERT_EQUAL_STRING("CWKF 1 IU3QEZ 7 wpm=25 dec=18 tx=1 rx=0\n", text());
+    TEST_ASSERT_EQUAL_UINT32(0, s_batch.events);
+
+    logger_feed_words_init(&s_words);
+    TEST_ASSERT_TRUE(logger_feed_batch_dropped(&s_batch, 3));
+    TEST_ASSERT_TRUE(logger_feed_batch_state(&s_batch, 'T', 1700000000123LL, true));
+    TEST_ASSERT_TRUE(logger_feed_batch_text(&s_batch, &s_words, 1700000000200LL, 'K'));
+    TEST_ASSERT_TRUE(logger_feed_batch_text(&s_batch, &s_words, 1700000000250LL, '\n'));
+    TEST_ASSERT_TRUE(logger_feed_batch_state(&s_batch, 'R', 42, false));
+    TEST_ASSERT_EQUAL_STRING("CWKF 1 IU3QEZ 7 wpm=25 dec=18 tx=1 rx=0\n"
+                             "D 3\n"
+                             "T 1700000000123 1\n"
+                             "C 1700000000200 K\n"
+                             "C 1700000000250 ?\n"
+                             "R 42 0\n", text());
+    TEST_ASSERT_EQUAL_UINT32(5, s_batch.events);
+
+    /* No callsign set */
+    logger_feed_header_t anon = k_hdr;
+    anon.callsign = "";
+    logger_feed_batch_begin(&s_batch, &anon);
+    TEST_ASSERT_EQUAL_STRING("CWKF 1 - 7 wpm=25 dec=18 tx=1 rx=0\n", text());
+}
+
+void test_logger_feed_batch_full(void) {
+    logger_feed_batch_begin(&s_batch, &k_hdr);
+    logger_feed_words_init(&s_words);
+
+    int added = 0;
+    while (logger_feed_batch_text(&s_batch, &s_words, 1700000000000LL + added, 'E')) {
+        added++;
+    }
+    TEST_ASSERT_TRUE(added > 0);
+    TEST_ASSERT_TRUE(s_batch.len <= LOGGER_FEED_DATAGRAM_MAX);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)added, s_batch.events);
+    TEST_ASSERT_EQUAL_CHAR('\n', s_batch.buf[s_batch.len - 1]);
+
+    /* A refused line leaves the batch and the word as they were */
+    size_t len = s_batch.len;
+    size_t word_len = s_words.len;
+    TEST_ASSERT_FALSE(logger_feed_batch_state(&s_batch, 'T', 1700000000000LL, false));
+    TEST_ASSERT_FALSE(logger_feed_batch_text(&s_batch, &s_words, 1700000000000LL, ' '));
+    TEST_ASSERT_EQUAL(len, s_batch.len);
+    TEST_ASSERT_EQUAL(word_len, s_words.len);
+
+    /* Next datagram: the word goes out there, cut to LOGGER_FEED_WORD_MAX */
+    logger_feed_batch_begin(&s_batch, &k_hdr);
+    TEST_ASSERT_TRUE(logger_feed_batch_text(&s_batch, &s_words, 1700000000000LL, ' '));
+    TEST_ASSERT_EQUAL(0, s_words.len);
+    const char *w = strstr(text(), "W 1700000000000 ");
+    TEST_ASSERT_NOT_NULL(w);
+    TEST_ASSERT_EQUAL(strlen("W 1700000000000 ") + LOGGER_FEED_WORD_MAX + 1, strlen(w));
+}
+
+void test_logger_feed_words(void) {
+    logger_feed_batch_begin(&s_batch, &k_hdr);
+    logger_feed_words_init(&s_words);
+    size_t header = s_batch.len;
+
+    /* Leading and repeated spaces send nothing */
+    TEST_ASSERT_TRUE(logger_feed_batch_text(&s_batch, &s_words, 100, ' '));
+    TEST_ASSERT_EQUAL(header, s_batch.len);
+
+    const char *in = "CQ  DE";
+    for (int i = 0; in[i] != '\0'; i++) {
+        TEST_ASSERT_TRUE(logger_feed_batch_text(&s_batch, &s_words, 200 + i * 100, in[i]));
+    }
+    TEST_ASSERT_TRUE(logger_feed_batch_text(&s_batch, &s_words, 900, ' '));
+    TEST_ASSERT_EQUAL_STRING("C 200 C\n"
+                             "C 300 Q\n"
+                             "W 200 CQ\n"
+                             "C 600 D\n"
+                             "C 700 E\n"
+                             "W 600 DE\n", text() + header);
+
+    /* Unfinished word stays pending */
+    TEST_ASSERT_TRUE(logger_feed_batch_text(&s_batch, &s_words, 1000, 'K'));
+    TEST_ASSERT_EQUAL(1, s_words.len);
+    TEST_ASSERT_EQUAL_INT64(1000, s_words.first_ms);
+}
+
+void test_logger_feed_activity(void) {
+    logger_feed_activity_t a;
+    int64_t stop_us = 0;
+    const int64_t hold_us = 100000;
+    logger_feed_activity_init(&a);
+
+    /* Nothing to stop before anything started */
+    TEST_ASSERT_FALSE(logger_feed_activity_poll(&a, 5000000, hold_us, &stop_us));
+
+    /* First key-down starts, later ones do not */
+    TEST_ASSERT_TRUE(logger_feed_activity_edge(&a, 1000000, true));
+    TEST_ASSERT_FALSE(logger_feed_activity_edge(&a, 1060000, false));
+    TEST_ASSERT_FALSE(logger_feed_activity_edge(&a, 1120000, true));
+    TEST_ASSERT_TRUE(a.on);
+
+    /* Held down: never stops */
+    TEST_ASSERT_FALSE(logger_feed_activity_poll(&a, 9000000, hold_us, &stop_us));
+
+    /* Up for less than the hold, then for the hold: stopped at the key-up */
+    TEST_ASSERT_FALSE(logger_feed_activity_edge(&a, 1180000, false));
+    TEST_ASSERT_FALSE(logger_feed_activity_poll(&a, 1279999, hold_us, &stop_us));
+    TEST_ASSERT_TRUE(logger_feed_activity_poll(&a, 1280000, hold_us, &stop_us));
+    TEST_ASSERT_EQUAL_INT64(1180000, stop_us);
+    TEST_ASSERT_FALSE(a.on);
+    TEST_ASSERT_FALSE(logger_feed_activity_poll(&a, 2000000, hold_us, &stop_us));
+
+    /* And starts again */
+    TEST_ASSERT_TRUE(logger_feed_activity_edge(&a, 3000000, true));
+}
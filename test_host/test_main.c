@@ -12,6 +12,59 @@ void test_stream_push_pop(void);
 void test_stream_wrap_around(void);
 void test_stream_overrun_detection(void);
 void test_stream_multiple_consumers(void);
+void test_stream_tick_period(void);
+void test_stream_producer_lanes(void);
+void test_stream_uncommitted_slot(void);
+void test_stream_read_slot_result(void);
+void test_stream_consumer_span_wrap(void);
+void test_stream_consumer_span_overwritten(void);
+void test_stream_silence_extended(void);
+void test_stream_silence_chained(void);
+void test_stream_skip_ticks(void);
+void test_timed_consumer_ticks(void);
+void test_timed_consumer_late_join_and_skip(void);
+void test_best_effort_catch_up_keeps_edges(void);
+void test_stream_registry_telemetry(void);
+void test_stream_remote_event_tick(void);
+void test_hard_rt_skips_remote_lane(void);
+void test_hard_rt_recovers_after_clean_ticks(void);
+void test_hard_rt_latches_repeated_faults(void);
+void test_stream_archive_spill_and_read(void);
+void test_stream_archive_wrap_and_resync(void);
+void test_stream_archive_spill_gap(void);
+void test_sample_compact_roundtrip(void);
+void test_sample_channels(void);
+void test_stream_compact_archive(void);
+void test_stream_compact_archive_remote_tick(void);
+void test_stream_key_state_checkpoint(void);
+void test_stream_position_wrap(void);
+void test_consumer_scan_until_edge(void);
+void test_consumer_next_write_snapshot(void);
+
+void test_stream_handoff_put_drain(void);
+void test_stream_handoffs_budget(void);
+void test_stream_handoff_never_stalls_hard_rt(void);
+
+void test_key_edge_stage_extracts_channels(void);
+void test_key_edge_reader_overrun(void);
+void test_key_edge_stage_joins_with_state(void);
+void test_key_edge_stage_remote_and_head(void);
+
+void test_stream_index_checkpoints(void);
+void test_consumer_seek_time_matches_linear_scan(void);
+void test_consumer_seek_time_out_of_history(void);
+
+/* Stream export tests */
+void test_stream_export_recording(void);
+void test_stream_export_window_and_lapped(void);
+void test_stream_export_net_clock(void);
+void test_stream_rec_chunk_fill_and_check(void);
+void test_stream_rec_mount_rebuilds_sessions(void);
+void test_stream_rec_wraps_and_drops_oldest(void);
+void test_stream_rec_pacer_bounds_write_calls(void);
+void test_stream_rec_export_session(void);
+void test_stream_rec_export_remote_and_long_silence(void);
+void test_stream_rec_export_net_clock(void);
 
 void test_iambic_init(void);
 void test_iambic_dit(void);
@@ -20,6 +73,20 @@ void test_iambic_mode_a_squeeze(void);
 void test_iambic_mode_b_squeeze(void);
 void test_iambic_memory(void);
 void test_iambic_squeeze_prolonged(void);
+void test_paddle_edge_queue_overflow(void);
+void test_paddle_capture_clock(void);
+void test_paddle_touch_scan_plan(void);
+void test_paddle_touch_pads_and_threshold(void);
+void test_paddle_debounce_bounce(void);
+void test_paddle_debounce_short_tap(void);
+void test_iambic_edge_memory_window(void);
+void test_iambic_edge_tap_within_tick(void);
+void test_iambic_queue_config_latches_at_boundary(void);
+void test_iambic_queue_plan_latches_at_boundary(void);
+void test_iambic_timing_window_matches_pct(void);
+void test_iambic_key_tags(void);
+void test_iambic_mode_matrix(void);
+void test_iambic_tick_benchmark(void);
 
 void test_preset_init(void);
 void test_preset_activate(void);
@@ -29,14 +96,72 @@ void test_preset_reset(void);
 void test_preset_set_name(void);
 void test_preset_timing_helpers(void);
 void test_preset_null_safety(void);
+void test_preset_plan_follows_edits(void);
+void test_preset_blob_roundtrip(void);
+void test_preset_handoff_drives_fsm(void);
 
 void test_sidetone_init(void);
 void test_sidetone_keying(void);
 void test_sidetone_fade(void);
+void test_sidetone_render_matches_per_sample(void);
+void test_sidetone_render_stereo(void);
+void test_sidetone_interpolated_lut(void);
+void test_sidetone_envelope_tables(void);
+void test_sidetone_render_with_envelope(void);
+
+/* Audio buffer tests */
+void test_audio_buffer_block_write_read(void);
+void test_audio_buffer_block_full_and_empty(void);
+void test_audio_buffer_spans(void);
+
+/* Audio playout tests */
+void test_audio_playout_primes_to_target(void);
+void test_audio_playout_underrun_reprimes(void);
+void test_audio_playout_trims_drift(void);
+void test_audio_playout_mix_saturates_and_ducks(void);
+void test_audio_playout_upsamples(void);
+void test_audio_rate_decimate(void);
+void test_audio_mixer_ramps_and_sums(void);
+void test_audio_mixer_saturates(void);
+void test_audio_mixer_silent_source_ramps(void);
 
 void test_fault_init(void);
 void test_fault_set_clear(void);
 void test_fault_count(void);
+void test_fault_log_keeps_newest(void);
+void test_fault_log_read_follows(void);
+
+/* RT profiling tests */
+void test_rt_prof_min_max_mean(void);
+void test_rt_prof_histogram(void);
+void test_rt_prof_overflow_and_reset(void);
+void test_key_latency_bins(void);
+void test_key_latency_tx_and_audio(void);
+void test_key_latency_timeout(void);
+void test_key_latency_loopback(void);
+void test_key_latency_percentiles_and_reset(void);
+void test_rt_idle_threshold(void);
+void test_rt_idle_wake_ticks_carry(void);
+void test_rt_idle_stats(void);
+void test_radio_focus_waits_for_idle(void);
+void test_radio_focus_single_output(void);
+void test_tx_sched_lead(void);
+void test_tx_sched_late_and_order(void);
+void test_tx_sched_delayed(void);
+void test_remote_tx_plays_on_tick(void);
+void test_remote_tx_watchdog(void);
+void test_remote_tx_overflow(void);
+
+/* Flight recorder tests */
+void test_flight_rec_wipes_noise_and_keeps_valid(void);
+void test_flight_rec_merges_lanes_in_order(void);
+void test_flight_rec_ring_keeps_newest(void);
+void test_flight_rec_stage_peaks_only(void);
+
+/* Boot timeline tests */
+void test_boot_timeline_records_phases(void);
+void test_boot_timeline_full_drops(void);
+void test_boot_timeline_heap_used(void);
 
 void test_parse_empty_line(void);
 void test_parse_simple_command(void);
@@ -62,6 +187,41 @@ void test_history_skip_empty(void);
 void test_history_reset_nav(void);
 void test_history_empty(void);
 
+/* Telnet filter tests */
+void test_telnet_plain_text_passes(void);
+void test_telnet_negotiation_stripped(void);
+void test_telnet_subnegotiation_stripped(void);
+void test_telnet_split_sequence(void);
+void test_telnet_line_ends_become_one_cr(void);
+void test_telnet_escaped_iac_is_data(void);
+
+/* Stats watch tests */
+void test_stats_watch_first_sample_is_base(void);
+void test_stats_watch_min_max_between_lines(void);
+void test_stats_watch_counters_are_deltas(void);
+void test_stats_watch_ring_overflow_keeps_deltas(void);
+void test_stats_watch_line_truncates(void);
+void test_stats_watch_hist_peak(void);
+void test_stats_watch_parse_groups(void);
+void test_mem_budget_latest_reading(void);
+void test_mem_budget_window_keeps_dip(void);
+void test_mem_budget_history_ring(void);
+
+/* Load shedding tests */
+void test_load_shed_thresholds(void);
+void test_load_shed_order_and_pacing(void);
+void test_load_shed_restore_after_calm(void);
+void test_load_shed_disabled_and_counter_reset(void);
+void test_logger_feed_batch_format(void);
+void test_logger_feed_batch_full(void);
+void test_logger_feed_words(void);
+void test_logger_feed_activity(void);
+
+void test_metrics_history_gauge_levels(void);
+void test_metrics_history_counter_rate(void);
+void test_metrics_history_wrap_and_from(void);
+void test_metrics_history_encode(void);
+
 void test_complete_command_help(void);
 void test_complete_param_after_set(void);
 void test_complete_param_after_show(void);
@@ -79,6 +239,27 @@ void test_diag_enable_disable(void);
 void test_diag_macro_does_not_crash_when_disabled(void);
 void test_diag_macro_logs_when_enabled(void);
 
+/* RT log formatter tests */
+void test_log_format_matches_snprintf(void);
+void test_log_format_truncates(void);
+void test_log_format_packed_matches_snprintf(void);
+void test_log_pack_copies_strings(void);
+void test_log_pack_overflow_formats_missing_as_zero(void);
+void test_log_entry_format_text(void);
+
+/* Log wire tests */
+void test_log_stream_counts_entries_and_bytes(void);
+void test_log_stream_wraps(void);
+void test_log_stream_overwrites_oldest(void);
+void test_log_stream_readers_are_independent(void);
+void test_log_wire_hello(void);
+void test_log_wire_defines_format_once(void);
+void test_log_wire_text_entry(void);
+void test_log_wire_dropped(void);
+void test_log_syslog_rfc5424(void);
+void test_log_syslog_binary_packs(void);
+void test_log_syslog_rate_limit(void);
+
 /* Morse table tests */
 void test_morse_lookup_letters(void);
 void test_morse_lookup_numbers(void);
@@ -89,6 +270,8 @@ void test_morse_reverse_lookup(void);
 void test_morse_table_count(void);
 void test_morse_match_prosign(void);
 void test_morse_get_prosign_tag(void);
+void test_morse_code_building(void);
+void test_morse_code_tables_agree(void);
 
 /* Timing classifier tests */
 void test_timing_init(void);
@@ -102,6 +285,9 @@ void test_timing_ignore_short_durations(void);
 void test_timing_ignore_long_durations(void);
 void test_timing_reset(void);
 void test_timing_null_safety(void);
+void test_timing_cluster_classifies(void);
+void test_timing_cluster_speed_change(void);
+void test_timing_cluster_heavy_weighting(void);
 void test_key_event_str(void);
 
 /* Decoder tests */
@@ -120,6 +306,44 @@ void test_decoder_timing_access(void);
 void test_decoder_state_str(void);
 void test_decoder_buffer_circular(void);
 void test_decoder_get_text_with_timestamps(void);
+void test_decoder_stream_sub_ms_ticks(void);
+void test_decoder_stream_iambic_tags(void);
+void test_decoder_stream_remote_lane(void);
+void test_decoder_instances_per_source(void);
+void test_decoder_inactivity_stream_time(void);
+
+/* Transcript tests */
+void test_transcript_incremental_read(void);
+void test_transcript_lapped_reader(void);
+
+/* Audio RX tests */
+void test_tone_detector_keys_tone(void);
+void test_audio_rx_decodes_off_air(void);
+
+/* Text schedule tests */
+void test_text_schedule_tick_accurate(void);
+void test_text_schedule_paddle_stop_and_flush(void);
+void test_text_schedule_pause_keeps_run(void);
+void test_text_schedule_ptt_lead(void);
+
+/* Text type-ahead tests */
+void test_text_typeahead_append_in_order(void);
+void test_text_typeahead_full_rejects_whole_append(void);
+void test_text_typeahead_cancel_last(void);
+
+/* Text macro tests */
+void test_text_macro_compile_tokens(void);
+void test_text_macro_expand_fields(void);
+void test_text_macro_render_and_fields(void);
+
+/* WinKeyer tests */
+void test_winkeyer_host_open_and_queries(void);
+void test_winkeyer_text_and_commands_in_order(void);
+void test_winkeyer_status_and_pot_push(void);
+void test_winkeyer_pin_config_selects_radio(void);
+void test_cdc_batch_coalesces_packets(void);
+void test_cdc_batch_hold_time(void);
+void test_cdc_batch_drops_when_host_stalls(void);
 
 /* CWNet Timestamp tests */
 void test_timestamp_encode_zero(void);
@@ -204,6 +428,12 @@ void test_timer_sync_client_behind(void);
 void test_timer_sync_cumulative(void);
 void test_timer_sync_drift_correction(void);
 void test_timer_null_safety(void);
+void test_timer_server_to_local(void);
+void test_timer_synced_us(void);
+void test_sync_ignores_delayed_ping(void);
+void test_sync_first_ping_is_raw(void);
+void test_sync_estimates_drift(void);
+void test_sync_resets_on_clock_step(void);
 void test_ping_parse_request(void);
 void test_ping_parse_response_1(void);
 void test_ping_parse_response_2(void);
@@ -234,14 +464,176 @@ void test_client_sends_ident_on_connect(void);
 void test_client_receives_welcome_transitions_to_ready(void);
 void test_client_responds_to_ping_request(void);
 void test_client_syncs_timer_on_ping_request(void);
+void test_client_on_frame_wrapped_payload(void);
 void test_client_updates_latency_on_ping_response2(void);
 void test_client_sends_key_down_event(void);
 void test_client_sends_key_up_event(void);
 void test_client_rejects_events_when_not_ready(void);
+void test_client_sends_key_event_at_edge_time(void);
 void test_client_handles_invalid_frame(void);
 void test_client_handles_disconnect_during_operation(void);
 void test_client_handles_fragmented_frame(void);
 void test_client_handles_ping_in_fragments(void);
+void test_client_coalesces_key_events(void);
+void test_client_coalesce_partial_send(void);
+void test_client_coalesce_arena_full_flushes(void);
+
+/* CWNet latency tests */
+void test_cwnet_latency_bins(void);
+void test_cwnet_latency_record(void);
+void test_cwnet_latency_percentiles(void);
+
+/* CWNet reconnect backoff tests */
+void test_cwnet_backoff_doubles_to_cap(void);
+void test_cwnet_backoff_jitter_range(void);
+
+/* CWNet receive jitter buffer tests */
+void test_cwnet_jitter_preserves_timing(void);
+void test_cwnet_jitter_adapts_margin(void);
+void test_cwnet_jitter_late_event_keeps_order(void);
+void test_cwnet_jitter_overflow(void);
+void test_cwnet_jitter_floor(void);
+
+/* CWNet receive ring tests */
+void test_cwnet_rx_frames_in_place(void);
+void test_cwnet_rx_fragmented_and_wrapped(void);
+void test_cwnet_rx_skips_reserved_and_oversize(void);
+
+/* CWNet UDP datagram tests */
+void test_cwnet_udp_redundancy(void);
+void test_cwnet_udp_loss_repaired_by_next_datagram(void);
+void test_cwnet_udp_reorder_and_hold(void);
+void test_cwnet_udp_rejects_malformed(void);
+
+/* CWNet peer-to-peer listener tests */
+void test_cwnet_peer_handshake(void);
+void test_cwnet_peer_keying_both_ways(void);
+void test_cwnet_peer_ping_period(void);
+void test_cwnet_peer_ignores_events_before_connect(void);
+
+/* CWNet audio tests */
+void test_cwnet_audio_round_trip(void);
+void test_cwnet_audio_blocks_independent(void);
+void test_cwnet_audio_rejects_malformed(void);
+void test_cwnet_audio_client_delivers_block(void);
+
+/* CWNet capture tests */
+void test_cwnet_capture_pcap_export(void);
+void test_cwnet_capture_wrap_and_lapped_reader(void);
+
+/* CWNet failover selection tests */
+void test_cwnet_select_parse_list(void);
+void test_cwnet_select_score_needs_samples(void);
+void test_cwnet_select_probe_then_park(void);
+void test_cwnet_select_unreachable_and_small_groups(void);
+void test_cwnet_select_better_hysteresis(void);
+void test_cwnet_select_stale_after_missed_ping(void);
+
+/* ESP-NOW frame tests */
+void test_espnow_frame_redundancy(void);
+void test_espnow_frame_receiver_clock(void);
+void test_espnow_frame_loss_repaired(void);
+void test_espnow_frame_session_and_malformed(void);
+
+/* WebSocket timeline frame tests */
+void test_ws_timeline_layout(void);
+void test_ws_timeline_full_frame(void);
+void test_ws_timeline_wide_gap_starts_new_frame(void);
+
+/* WebSocket send queue tests */
+void test_ws_queue_fifo_and_scheduling(void);
+void test_ws_queue_overflow_policies(void);
+void test_ws_queue_pattern_coalesces(void);
+
+/* WiFi power-save policy tests */
+void test_wifi_ps_auto_follows_activity(void);
+void test_wifi_ps_link_keeps_awake(void);
+void test_wifi_ps_fixed_policies(void);
+void test_wifi_ps_jitter_per_mode(void);
+
+/* VPN wall clock tests */
+void test_vpn_clock_estimate_from_rtc(void);
+void test_vpn_clock_never_goes_back(void);
+void test_vpn_clock_calibrate_learns_drift(void);
+
+/* LED animation tests */
+void test_led_anim_breathing_lut(void);
+void test_led_anim_flash_sequences(void);
+void test_led_anim_keying_overlay(void);
+
+/* Background service tests */
+void test_service_register_and_snapshot(void);
+void test_service_cpu_accounting(void);
+void test_service_adaptive_delay(void);
+
+/* Task stats tests */
+void test_task_stats_cpu_shares(void);
+void test_task_stats_history_ring(void);
+
+/* Metrics tests */
+void test_metrics_render_families(void);
+void test_metrics_render_chunks(void);
+void test_metrics_render_json(void);
+
+/* OTA update tests */
+void test_ota_sha_and_progress(void);
+void test_ota_self_test_verdict(void);
+
+/* OTA delta tests */
+void test_ota_delta_apply_ops(void);
+void test_ota_delta_rejects_bad_patches(void);
+
+/* Timeline pyramid tests */
+void test_timeline_pyramid_buckets(void);
+void test_timeline_pyramid_levels_and_retention(void);
+
+/* Keying statistics tests */
+void test_key_stats_paris_speed_and_spacing(void);
+void test_key_stats_tagged_weight(void);
+void test_key_stats_windows_slide(void);
+void test_key_stats_untagged_learns_unit(void);
+void test_key_stats_remote_ahead_of_local(void);
+void test_telemetry_batch_interval(void);
+void test_telemetry_faults_once(void);
+void test_telemetry_link_on_change(void);
+
+/* JSON writer tests */
+void test_json_writer_document(void);
+void test_json_writer_chunks_and_escapes(void);
+
+/* JSON scan tests */
+void test_json_scan_fields(void);
+void test_json_scan_strings_and_errors(void);
+
+/* WebSocket log tests */
+void test_ws_log_merges_and_filters(void);
+void test_ws_log_batches_and_reports_drops(void);
+
+/* WebSocket delta tests */
+void test_ws_delta_frames_members(void);
+void test_ws_delta_splits_large_sets(void);
+void test_ws_delta_strings_and_sig(void);
+
+/* WebSocket topic tests */
+void test_ws_topic_names(void);
+void test_ws_topic_mask_parse(void);
+void test_ws_topic_mask_rejects(void);
+
+/* Asset pack tests */
+void test_asset_pack_find(void);
+void test_asset_pack_rejects_corrupt(void);
+void test_asset_pack_accept_encoding(void);
+
+/* WireGuard crypto tests */
+void test_wg_aead_vector(void);
+void test_wg_aead_matches_refc(void);
+void test_wg_aead_rejects_tampering(void);
+void test_wg_xaead_matches_refc(void);
+void test_wg_x25519_vectors(void);
+void test_wg_x25519_matches_refc(void);
+void test_wg_blake2s_vectors(void);
+void test_wg_blake2s_matches_refc(void);
+void test_wg_hkdf(void);
 
 void setUp(void) {
     /* Called before each test */
@@ -261,6 +653,64 @@ int main(void) {
     RUN_TEST(test_stream_wrap_around);
     RUN_TEST(test_stream_overrun_detection);
     RUN_TEST(test_stream_multiple_consumers);
+    RUN_TEST(test_stream_tick_period);
+    RUN_TEST(test_stream_producer_lanes);
+    RUN_TEST(test_stream_uncommitted_slot);
+    RUN_TEST(test_stream_read_slot_result);
+    RUN_TEST(test_stream_consumer_span_wrap);
+    RUN_TEST(test_stream_consumer_span_overwritten);
+    RUN_TEST(test_stream_silence_extended);
+    RUN_TEST(test_stream_silence_chained);
+    RUN_TEST(test_stream_skip_ticks);
+    RUN_TEST(test_timed_consumer_ticks);
+    RUN_TEST(test_timed_consumer_late_join_and_skip);
+    RUN_TEST(test_best_effort_catch_up_keeps_edges);
+    RUN_TEST(test_stream_registry_telemetry);
+    RUN_TEST(test_stream_remote_event_tick);
+    RUN_TEST(test_hard_rt_skips_remote_lane);
+    RUN_TEST(test_hard_rt_recovers_after_clean_ticks);
+    RUN_TEST(test_hard_rt_latches_repeated_faults);
+    RUN_TEST(test_stream_archive_spill_and_read);
+    RUN_TEST(test_stream_archive_wrap_and_resync);
+    RUN_TEST(test_stream_archive_spill_gap);
+    RUN_TEST(test_sample_compact_roundtrip);
+    RUN_TEST(test_sample_channels);
+    RUN_TEST(test_stream_compact_archive);
+    RUN_TEST(test_stream_compact_archive_remote_tick);
+    RUN_TEST(test_stream_key_state_checkpoint);
+    RUN_TEST(test_stream_position_wrap);
+    RUN_TEST(test_consumer_scan_until_edge);
+    RUN_TEST(test_consumer_next_write_snapshot);
+
+    printf("\n=== Stream Handoff Tests ===\n");
+    RUN_TEST(test_stream_handoff_put_drain);
+    RUN_TEST(test_stream_handoffs_budget);
+    RUN_TEST(test_stream_handoff_never_stalls_hard_rt);
+
+    printf("\n=== Key Edge Tests ===\n");
+    RUN_TEST(test_key_edge_stage_extracts_channels);
+    RUN_TEST(test_key_edge_reader_overrun);
+    RUN_TEST(test_key_edge_stage_joins_with_state);
+    RUN_TEST(test_key_edge_stage_remote_and_head);
+
+    printf("\n=== Stream Index Tests ===\n");
+    RUN_TEST(test_stream_index_checkpoints);
+    RUN_TEST(test_consumer_seek_time_matches_linear_scan);
+    RUN_TEST(test_consumer_seek_time_out_of_history);
+
+    printf("\n=== Stream Export Tests ===\n");
+    RUN_TEST(test_stream_export_recording);
+    RUN_TEST(test_stream_export_window_and_lapped);
+    RUN_TEST(test_stream_export_net_clock);
+
+    printf("\n=== Stream Recorder Tests ===\n");
+    RUN_TEST(test_stream_rec_chunk_fill_and_check);
+    RUN_TEST(test_stream_rec_mount_rebuilds_sessions);
+    RUN_TEST(test_stream_rec_wraps_and_drops_oldest);
+    RUN_TEST(test_stream_rec_pacer_bounds_write_calls);
+    RUN_TEST(test_stream_rec_export_session);
+    RUN_TEST(test_stream_rec_export_remote_and_long_silence);
+    RUN_TEST(test_stream_rec_export_net_clock);
 
     /* Iambic tests */
     printf("\n=== Iambic Tests ===\n");
@@ -271,6 +721,20 @@ int main(void) {
     RUN_TEST(test_iambic_mode_b_squeeze);
     RUN_TEST(test_iambic_memory);
     RUN_TEST(test_iambic_squeeze_prolonged);
+    RUN_TEST(test_paddle_edge_queue_overflow);
+    RUN_TEST(test_paddle_capture_clock);
+    RUN_TEST(test_paddle_touch_scan_plan);
+    RUN_TEST(test_paddle_touch_pads_and_threshold);
+    RUN_TEST(test_paddle_debounce_bounce);
+    RUN_TEST(test_paddle_debounce_short_tap);
+    RUN_TEST(test_iambic_edge_memory_window);
+    RUN_TEST(test_iambic_edge_tap_within_tick);
+    RUN_TEST(test_iambic_queue_config_latches_at_boundary);
+    RUN_TEST(test_iambic_queue_plan_latches_at_boundary);
+    RUN_TEST(test_iambic_timing_window_matches_pct);
+    RUN_TEST(test_iambic_key_tags);
+    RUN_TEST(test_iambic_mode_matrix);
+    RUN_TEST(test_iambic_tick_benchmark);
 
     /* Iambic Preset tests */
     printf("\n=== Iambic Preset Tests ===\n");
@@ -282,18 +746,82 @@ int main(void) {
     RUN_TEST(test_preset_set_name);
     RUN_TEST(test_preset_timing_helpers);
     RUN_TEST(test_preset_null_safety);
+    RUN_TEST(test_preset_plan_follows_edits);
+    RUN_TEST(test_preset_blob_roundtrip);
+    RUN_TEST(test_preset_handoff_drives_fsm);
 
     /* Sidetone tests */
     printf("\n=== Sidetone Tests ===\n");
     RUN_TEST(test_sidetone_init);
     RUN_TEST(test_sidetone_keying);
     RUN_TEST(test_sidetone_fade);
+    RUN_TEST(test_sidetone_render_matches_per_sample);
+    RUN_TEST(test_sidetone_render_stereo);
+    RUN_TEST(test_sidetone_interpolated_lut);
+    RUN_TEST(test_sidetone_envelope_tables);
+    RUN_TEST(test_sidetone_render_with_envelope);
+
+    /* Audio buffer tests */
+    printf("\n=== Audio Buffer Tests ===\n");
+    RUN_TEST(test_audio_buffer_block_write_read);
+    RUN_TEST(test_audio_buffer_block_full_and_empty);
+    RUN_TEST(test_audio_buffer_spans);
+
+    printf("\n=== Audio Playout Tests ===\n");
+    RUN_TEST(test_audio_playout_primes_to_target);
+    RUN_TEST(test_audio_playout_underrun_reprimes);
+    RUN_TEST(test_audio_playout_trims_drift);
+    RUN_TEST(test_audio_playout_mix_saturates_and_ducks);
+    RUN_TEST(test_audio_playout_upsamples);
+    RUN_TEST(test_audio_rate_decimate);
+
+    printf("\n=== Audio Mixer Tests ===\n");
+    RUN_TEST(test_audio_mixer_ramps_and_sums);
+    RUN_TEST(test_audio_mixer_saturates);
+    RUN_TEST(test_audio_mixer_silent_source_ramps);
 
     /* Fault tests */
     printf("\n=== Fault Tests ===\n");
     RUN_TEST(test_fault_init);
     RUN_TEST(test_fault_set_clear);
     RUN_TEST(test_fault_count);
+    RUN_TEST(test_fault_log_keeps_newest);
+    RUN_TEST(test_fault_log_read_follows);
+
+    /* RT profiling tests */
+    printf("\n=== RT Profiling Tests ===\n");
+    RUN_TEST(test_rt_prof_min_max_mean);
+    RUN_TEST(test_rt_prof_histogram);
+    RUN_TEST(test_rt_prof_overflow_and_reset);
+    RUN_TEST(test_key_latency_bins);
+    RUN_TEST(test_key_latency_tx_and_audio);
+    RUN_TEST(test_key_latency_timeout);
+    RUN_TEST(test_key_latency_loopback);
+    RUN_TEST(test_key_latency_percentiles_and_reset);
+    RUN_TEST(test_rt_idle_threshold);
+    RUN_TEST(test_rt_idle_wake_ticks_carry);
+    RUN_TEST(test_rt_idle_stats);
+    RUN_TEST(test_radio_focus_waits_for_idle);
+    RUN_TEST(test_radio_focus_single_output);
+    RUN_TEST(test_tx_sched_lead);
+    RUN_TEST(test_tx_sched_late_and_order);
+    RUN_TEST(test_tx_sched_delayed);
+    RUN_TEST(test_remote_tx_plays_on_tick);
+    RUN_TEST(test_remote_tx_watchdog);
+    RUN_TEST(test_remote_tx_overflow);
+
+    /* Flight recorder tests */
+    printf("\n=== Flight Recorder Tests ===\n");
+    RUN_TEST(test_flight_rec_wipes_noise_and_keeps_valid);
+    RUN_TEST(test_flight_rec_merges_lanes_in_order);
+    RUN_TEST(test_flight_rec_ring_keeps_newest);
+    RUN_TEST(test_flight_rec_stage_peaks_only);
+
+    /* Boot timeline tests */
+    printf("\n=== Boot Timeline Tests ===\n");
+    RUN_TEST(test_boot_timeline_records_phases);
+    RUN_TEST(test_boot_timeline_full_drops);
+    RUN_TEST(test_boot_timeline_heap_used);
 
     /* Console parser tests */
     printf("\n=== Console Parser Tests ===\n");
@@ -315,15 +843,54 @@ int main(void) {
     RUN_TEST(test_config_set_param_str_wpm);
     RUN_TEST(test_config_set_param_str_out_of_range); */
 
-    /* History tests - TEMPORARILY DISABLED (requires console system) */
-    /* printf("\n=== History Tests ===\n");
+    printf("\n=== History Tests ===\n");
     RUN_TEST(test_history_push_and_prev);
     RUN_TEST(test_history_next);
     RUN_TEST(test_history_wrap_at_depth);
     RUN_TEST(test_history_skip_duplicates);
     RUN_TEST(test_history_skip_empty);
     RUN_TEST(test_history_reset_nav);
-    RUN_TEST(test_history_empty); */
+    RUN_TEST(test_history_empty);
+
+    printf("\n=== Telnet Filter Tests ===\n");
+    RUN_TEST(test_telnet_plain_text_passes);
+    RUN_TEST(test_telnet_negotiation_stripped);
+    RUN_TEST(test_telnet_subnegotiation_stripped);
+    RUN_TEST(test_telnet_split_sequence);
+    RUN_TEST(test_telnet_line_ends_become_one_cr);
+    RUN_TEST(test_telnet_escaped_iac_is_data);
+
+    printf("\n=== Stats Watch Tests ===\n");
+    RUN_TEST(test_stats_watch_first_sample_is_base);
+    RUN_TEST(test_stats_watch_min_max_between_lines);
+    RUN_TEST(test_stats_watch_counters_are_deltas);
+    RUN_TEST(test_stats_watch_ring_overflow_keeps_deltas);
+    RUN_TEST(test_stats_watch_line_truncates);
+    RUN_TEST(test_stats_watch_hist_peak);
+    RUN_TEST(test_stats_watch_parse_groups);
+
+    printf("\n=== Memory Budget Tests ===\n");
+    RUN_TEST(test_mem_budget_latest_reading);
+    RUN_TEST(test_mem_budget_window_keeps_dip);
+    RUN_TEST(test_mem_budget_history_ring);
+
+    printf("\n=== Load Shedding Tests ===\n");
+    RUN_TEST(test_load_shed_thresholds);
+    RUN_TEST(test_load_shed_order_and_pacing);
+    RUN_TEST(test_load_shed_restore_after_calm);
+    RUN_TEST(test_load_shed_disabled_and_counter_reset);
+
+    printf("\n=== Logger Feed Tests ===\n");
+    RUN_TEST(test_logger_feed_batch_format);
+    RUN_TEST(test_logger_feed_batch_full);
+    RUN_TEST(test_logger_feed_words);
+    RUN_TEST(test_logger_feed_activity);
+
+    printf("\n=== Metrics History Tests ===\n");
+    RUN_TEST(test_metrics_history_gauge_levels);
+    RUN_TEST(test_metrics_history_counter_rate);
+    RUN_TEST(test_metrics_history_wrap_and_from);
+    RUN_TEST(test_metrics_history_encode);
 
     /* Completion tests - TEMPORARILY DISABLED (requires commands.c) */
     /* printf("\n=== Completion Tests ===\n");
@@ -346,6 +913,33 @@ int main(void) {
     RUN_TEST(test_diag_macro_does_not_crash_when_disabled);
     RUN_TEST(test_diag_macro_logs_when_enabled);
 
+    /* RT log formatter tests */
+    printf("\n=== RT Log Format Tests ===\n");
+    RUN_TEST(test_log_format_matches_snprintf);
+    RUN_TEST(test_log_format_truncates);
+    RUN_TEST(test_log_format_packed_matches_snprintf);
+    RUN_TEST(test_log_pack_copies_strings);
+    RUN_TEST(test_log_pack_overflow_formats_missing_as_zero);
+    RUN_TEST(test_log_entry_format_text);
+
+    /* Log ring tests */
+    printf("\n=== Log Stream Tests ===\n");
+    RUN_TEST(test_log_stream_counts_entries_and_bytes);
+    RUN_TEST(test_log_stream_wraps);
+    RUN_TEST(test_log_stream_overwrites_oldest);
+    RUN_TEST(test_log_stream_readers_are_independent);
+
+    /* Log wire tests */
+    RUN_TEST(test_log_wire_hello);
+    RUN_TEST(test_log_wire_defines_format_once);
+    RUN_TEST(test_log_wire_text_entry);
+    RUN_TEST(test_log_wire_dropped);
+
+    /* Log syslog tests */
+    RUN_TEST(test_log_syslog_rfc5424);
+    RUN_TEST(test_log_syslog_binary_packs);
+    RUN_TEST(test_log_syslog_rate_limit);
+
     /* Morse table tests */
     printf("\n=== Morse Table Tests ===\n");
     RUN_TEST(test_morse_lookup_letters);
@@ -357,6 +951,8 @@ int main(void) {
     RUN_TEST(test_morse_table_count);
     RUN_TEST(test_morse_match_prosign);
     RUN_TEST(test_morse_get_prosign_tag);
+    RUN_TEST(test_morse_code_building);
+    RUN_TEST(test_morse_code_tables_agree);
 
     /* Timing classifier tests */
     printf("\n=== Timing Classifier Tests ===\n");
@@ -371,6 +967,9 @@ int main(void) {
     RUN_TEST(test_timing_ignore_long_durations);
     RUN_TEST(test_timing_reset);
     RUN_TEST(test_timing_null_safety);
+    RUN_TEST(test_timing_cluster_classifies);
+    RUN_TEST(test_timing_cluster_speed_change);
+    RUN_TEST(test_timing_cluster_heavy_weighting);
     RUN_TEST(test_key_event_str);
 
     /* Decoder tests */
@@ -390,6 +989,49 @@ int main(void) {
     RUN_TEST(test_decoder_state_str);
     RUN_TEST(test_decoder_buffer_circular);
     RUN_TEST(test_decoder_get_text_with_timestamps);
+    RUN_TEST(test_decoder_stream_sub_ms_ticks);
+    RUN_TEST(test_decoder_stream_iambic_tags);
+    RUN_TEST(test_decoder_stream_remote_lane);
+    RUN_TEST(test_decoder_instances_per_source);
+    RUN_TEST(test_decoder_inactivity_stream_time);
+
+    /* Transcript tests */
+    printf("\n=== Transcript Tests ===\n");
+    RUN_TEST(test_transcript_incremental_read);
+    RUN_TEST(test_transcript_lapped_reader);
+
+    /* Audio RX tests */
+    printf("\n=== Audio RX Tests ===\n");
+    RUN_TEST(test_tone_detector_keys_tone);
+    RUN_TEST(test_audio_rx_decodes_off_air);
+
+    /* Text schedule tests */
+    printf("\n=== Text Schedule Tests ===\n");
+    RUN_TEST(test_text_schedule_tick_accurate);
+    RUN_TEST(test_text_schedule_paddle_stop_and_flush);
+    RUN_TEST(test_text_schedule_pause_keeps_run);
+    RUN_TEST(test_text_schedule_ptt_lead);
+
+    printf("\n=== Text Type-ahead Tests ===\n");
+    RUN_TEST(test_text_typeahead_append_in_order);
+    RUN_TEST(test_text_typeahead_full_rejects_whole_append);
+    RUN_TEST(test_text_typeahead_cancel_last);
+
+    printf("\n=== Text Macro Tests ===\n");
+    RUN_TEST(test_text_macro_compile_tokens);
+    RUN_TEST(test_text_macro_expand_fields);
+    RUN_TEST(test_text_macro_render_and_fields);
+
+    printf("\n=== WinKeyer Tests ===\n");
+    RUN_TEST(test_winkeyer_host_open_and_queries);
+    RUN_TEST(test_winkeyer_text_and_commands_in_order);
+    RUN_TEST(test_winkeyer_status_and_pot_push);
+    RUN_TEST(test_winkeyer_pin_config_selects_radio);
+
+    printf("\n=== USB CDC Batch Tests ===\n");
+    RUN_TEST(test_cdc_batch_coalesces_packets);
+    RUN_TEST(test_cdc_batch_hold_time);
+    RUN_TEST(test_cdc_batch_drops_when_host_stalls);
 
     /* CWNet Timestamp tests */
     printf("\n=== CWNet Timestamp Tests ===\n");
@@ -493,6 +1135,12 @@ int main(void) {
     RUN_TEST(test_timer_sync_cumulative);
     RUN_TEST(test_timer_sync_drift_correction);
     RUN_TEST(test_timer_null_safety);
+    RUN_TEST(test_timer_server_to_local);
+    RUN_TEST(test_timer_synced_us);
+    RUN_TEST(test_sync_ignores_delayed_ping);
+    RUN_TEST(test_sync_first_ping_is_raw);
+    RUN_TEST(test_sync_estimates_drift);
+    RUN_TEST(test_sync_resets_on_clock_step);
     /* PING parsing */
     RUN_TEST(test_ping_parse_request);
     RUN_TEST(test_ping_parse_response_1);
@@ -532,17 +1180,182 @@ int main(void) {
     /* PING Handling */
     RUN_TEST(test_client_responds_to_ping_request);
     RUN_TEST(test_client_syncs_timer_on_ping_request);
+    RUN_TEST(test_client_on_frame_wrapped_payload);
     RUN_TEST(test_client_updates_latency_on_ping_response2);
     /* CW Events */
     RUN_TEST(test_client_sends_key_down_event);
     RUN_TEST(test_client_sends_key_up_event);
     RUN_TEST(test_client_rejects_events_when_not_ready);
+    RUN_TEST(test_client_sends_key_event_at_edge_time);
     /* Error Handling */
     RUN_TEST(test_client_handles_invalid_frame);
     RUN_TEST(test_client_handles_disconnect_during_operation);
     /* Fragmentation */
     RUN_TEST(test_client_handles_fragmented_frame);
     RUN_TEST(test_client_handles_ping_in_fragments);
+    /* Send coalescing */
+    RUN_TEST(test_client_coalesces_key_events);
+    RUN_TEST(test_client_coalesce_partial_send);
+    RUN_TEST(test_client_coalesce_arena_full_flushes);
+
+    printf("\n=== CWNet Latency Tests ===\n");
+    RUN_TEST(test_cwnet_latency_bins);
+    RUN_TEST(test_cwnet_latency_record);
+    RUN_TEST(test_cwnet_latency_percentiles);
+
+    printf("\n=== CWNet Backoff Tests ===\n");
+    RUN_TEST(test_cwnet_backoff_doubles_to_cap);
+    RUN_TEST(test_cwnet_backoff_jitter_range);
+
+    printf("\n=== CWNet Jitter Buffer Tests ===\n");
+    RUN_TEST(test_cwnet_jitter_preserves_timing);
+    RUN_TEST(test_cwnet_jitter_adapts_margin);
+    RUN_TEST(test_cwnet_jitter_late_event_keeps_order);
+    RUN_TEST(test_cwnet_jitter_overflow);
+    RUN_TEST(test_cwnet_jitter_floor);
+
+    printf("\n=== CWNet Receive Ring Tests ===\n");
+    RUN_TEST(test_cwnet_rx_frames_in_place);
+    RUN_TEST(test_cwnet_rx_fragmented_and_wrapped);
+    RUN_TEST(test_cwnet_rx_skips_reserved_and_oversize);
+
+    printf("\n=== CWNet UDP Tests ===\n");
+    RUN_TEST(test_cwnet_udp_redundancy);
+    RUN_TEST(test_cwnet_udp_loss_repaired_by_next_datagram);
+    RUN_TEST(test_cwnet_udp_reorder_and_hold);
+    RUN_TEST(test_cwnet_udp_rejects_malformed);
+
+    printf("\n=== CWNet Peer Tests ===\n");
+    RUN_TEST(test_cwnet_peer_handshake);
+    RUN_TEST(test_cwnet_peer_keying_both_ways);
+    RUN_TEST(test_cwnet_peer_ping_period);
+    RUN_TEST(test_cwnet_peer_ignores_events_before_connect);
+
+    printf("\n=== CWNet Audio Tests ===\n");
+    RUN_TEST(test_cwnet_audio_round_trip);
+    RUN_TEST(test_cwnet_audio_blocks_independent);
+    RUN_TEST(test_cwnet_audio_rejects_malformed);
+    RUN_TEST(test_cwnet_audio_client_delivers_block);
+
+    printf("\n=== CWNet Capture Tests ===\n");
+    RUN_TEST(test_cwnet_capture_pcap_export);
+    RUN_TEST(test_cwnet_capture_wrap_and_lapped_reader);
+
+    printf("\n=== CWNet Failover Selection Tests ===\n");
+    RUN_TEST(test_cwnet_select_parse_list);
+    RUN_TEST(test_cwnet_select_score_needs_samples);
+    RUN_TEST(test_cwnet_select_probe_then_park);
+    RUN_TEST(test_cwnet_select_unreachable_and_small_groups);
+    RUN_TEST(test_cwnet_select_better_hysteresis);
+    RUN_TEST(test_cwnet_select_stale_after_missed_ping);
+
+    printf("\n=== ESP-NOW Frame Tests ===\n");
+    RUN_TEST(test_espnow_frame_redundancy);
+    RUN_TEST(test_espnow_frame_receiver_clock);
+    RUN_TEST(test_espnow_frame_loss_repaired);
+    RUN_TEST(test_espnow_frame_session_and_malformed);
+
+    printf("\n=== WebSocket Timeline Tests ===\n");
+    RUN_TEST(test_ws_timeline_layout);
+    RUN_TEST(test_ws_timeline_full_frame);
+    RUN_TEST(test_ws_timeline_wide_gap_starts_new_frame);
+
+    printf("\n=== WebSocket Queue Tests ===\n");
+    RUN_TEST(test_ws_queue_fifo_and_scheduling);
+    RUN_TEST(test_ws_queue_overflow_policies);
+    RUN_TEST(test_ws_queue_pattern_coalesces);
+
+    printf("\n=== WiFi Power Save Tests ===\n");
+    RUN_TEST(test_wifi_ps_auto_follows_activity);
+    RUN_TEST(test_wifi_ps_link_keeps_awake);
+    RUN_TEST(test_wifi_ps_fixed_policies);
+    RUN_TEST(test_wifi_ps_jitter_per_mode);
+
+    printf("\n=== VPN Wall Clock Tests ===\n");
+    RUN_TEST(test_vpn_clock_estimate_from_rtc);
+    RUN_TEST(test_vpn_clock_never_goes_back);
+    RUN_TEST(test_vpn_clock_calibrate_learns_drift);
+
+    printf("\n=== LED Animation Tests ===\n");
+    RUN_TEST(test_led_anim_breathing_lut);
+    RUN_TEST(test_led_anim_flash_sequences);
+    RUN_TEST(test_led_anim_keying_overlay);
+
+    printf("\n=== Background Service Tests ===\n");
+    RUN_TEST(test_service_register_and_snapshot);
+    RUN_TEST(test_service_cpu_accounting);
+    RUN_TEST(test_service_adaptive_delay);
+
+    printf("\n=== Task Stats Tests ===\n");
+    RUN_TEST(test_task_stats_cpu_shares);
+    RUN_TEST(test_task_stats_history_ring);
+
+    printf("\n=== Metrics Tests ===\n");
+    RUN_TEST(test_metrics_render_families);
+    RUN_TEST(test_metrics_render_chunks);
+    RUN_TEST(test_metrics_render_json);
+
+    printf("\n=== OTA Update Tests ===\n");
+    RUN_TEST(test_ota_sha_and_progress);
+    RUN_TEST(test_ota_self_test_verdict);
+
+    printf("\n=== OTA Delta Tests ===\n");
+    RUN_TEST(test_ota_delta_apply_ops);
+    RUN_TEST(test_ota_delta_rejects_bad_patches);
+
+    printf("\n=== Timeline Pyramid Tests ===\n");
+    RUN_TEST(test_timeline_pyramid_buckets);
+    RUN_TEST(test_timeline_pyramid_levels_and_retention);
+
+    printf("\n=== Keying Stats Tests ===\n");
+    RUN_TEST(test_key_stats_paris_speed_and_spacing);
+    RUN_TEST(test_key_stats_tagged_weight);
+    RUN_TEST(test_key_stats_windows_slide);
+    RUN_TEST(test_key_stats_untagged_learns_unit);
+    RUN_TEST(test_key_stats_remote_ahead_of_local);
+
+    printf("\n=== Telemetry Tests ===\n");
+    RUN_TEST(test_telemetry_batch_interval);
+    RUN_TEST(test_telemetry_faults_once);
+    RUN_TEST(test_telemetry_link_on_change);
+
+    printf("\n=== JSON Writer Tests ===\n");
+    RUN_TEST(test_json_writer_document);
+    RUN_TEST(test_json_writer_chunks_and_escapes);
+
+    printf("\n=== JSON Scan Tests ===\n");
+    RUN_TEST(test_json_scan_fields);
+    RUN_TEST(test_json_scan_strings_and_errors);
+
+    printf("\n=== WebSocket Log Tests ===\n");
+    RUN_TEST(test_ws_log_merges_and_filters);
+    RUN_TEST(test_ws_log_batches_and_reports_drops);
+
+    printf("\n=== WebSocket Delta Tests ===\n");
+    RUN_TEST(test_ws_delta_frames_members);
+    RUN_TEST(test_ws_delta_splits_large_sets);
+    RUN_TEST(test_ws_delta_strings_and_sig);
+
+    printf("\n=== WebSocket Topic Tests ===\n");
+    RUN_TEST(test_ws_topic_names);
+    RUN_TEST(test_ws_topic_mask_parse);
+    RUN_TEST(test_ws_topic_mask_rejects);
+
+    printf("\n=== Asset Pack Tests ===\n");
+    RUN_TEST(test_asset_pack_find);
+    RUN_TEST(test_asset_pack_rejects_corrupt);
+    RUN_TEST(test_asset_pack_accept_encoding);
+
+    printf("\n=== WireGuard Crypto Tests ===\n");
+    RUN_TEST(test_wg_aead_vector);
+    RUN_TEST(test_wg_aead_matches_refc);
+    RUN_TEST(test_wg_aead_rejects_tampering);
+    RUN_TEST(test_wg_xaead_matches_refc);
+    RUN_TEST(test_wg_x25519_vectors);
+    RUN_TEST(test_wg_x25519_matches_refc);
+    RUN_TEST(test_wg_blake2s_vectors);
+    RUN_TEST(test_wg_blake2s_matches_refc);
+    RUN_TEST(test_wg_hkdf);
 
     return UNITY_END();
 }
@@ -0,0 +1,80 @@
+/**
+ * @file test_mem_budget.c
+ * @brief Tests for the heap budget and its low-water windows
+ */
+
+#include "unity.h"
+#include "mem_budget.h"
+
+static mem_budget_t s_mb;
+
+static void record_internal(uint32_t now_s, uint32_t free) {
+    mem_cap_sample_t caps[MEM_CAP_COUNT] = {
+        [MEM_CAP_INTERNAL] = { .total = 300000, .free = free, .largest = free / 2,
+                               .min_free = 90000 },
+        [MEM_CAP_DMA] = { .total = 250000, .free = free - 10000 },
+        [MEM_CAP_PSRAM] = { .total = 8000000, .free = 7000000 },
+    };
+    mem_budget_record(&s_mb, now_s, caps);
+}
+
+void test_mem_budget_latest_reading(void) {
+    mem_budget_init(&s_mb);
+    record_internal(1, 120000);
+    record_internal(2, 110000);
+
+    mem_cap_sample_t s;
+    mem_budget_get(&s_mb, MEM_CAP_INTERNAL, &s);
+    TEST_ASSERT_EQUAL_UINT32(300000, s.total);
+    TEST_ASSERT_EQUAL_UINT32(110000, s.free);
+    TEST_ASSERT_EQUAL_UINT32(55000, s.largest);
+    TEST_ASSERT_EQUAL_UINT32(90000, s.min_free);
+    mem_budget_get(&s_mb, MEM_CAP_PSRAM, &s);
+    TEST_ASSERT_EQUAL_UINT32(7000000, s.free);
+
+    /* No window closed yet; the open one holds the dip */
+    uint32_t hist[MEM_BUDGET_HISTORY];
+    TEST_ASSERT_EQUAL_size_t(0, mem_budget_history(&s_mb, MEM_CAP_INTERNAL, hist,
+                                                   MEM_BUDGET_HISTORY));
+    TEST_ASSERT_EQUAL_UINT32(110000, mem_budget_window_low(&s_mb, MEM_CAP_INTERNAL));
+    TEST_ASSERT_EQUAL_STRING("psram", mem_cap_str(MEM_CAP_PSRAM));
+}
+
+void test_mem_budget_window_keeps_dip(void) {
+    mem_budget_init(&s_mb);
+    record_internal(0, 120000);
+    record_internal(10, 80000);             /* Startup burst */
+    record_internal(20, 119000);
+    record_internal(MEM_BUDGET_WINDOW_S, 118000);   /* Opens window 2 */
+    record_internal(MEM_BUDGET_WINDOW_S + 30, 117000);
+
+    uint32_t hist[MEM_BUDGET_HISTORY];
+    TEST_ASSERT_EQUAL_size_t(1, mem_budget_history(&s_mb, MEM_CAP_INTERNAL, hist,
+                                                   MEM_BUDGET_HISTORY));
+    TEST_ASSERT_EQUAL_UINT32(80000, hist[0]);
+    TEST_ASSERT_EQUAL_size_t(1, mem_budget_history(&s_mb, MEM_CAP_DMA, hist,
+                                                   MEM_BUDGET_HISTORY));
+    TEST_ASSERT_EQUAL_UINT32(70000, hist[0]);
+    TEST_ASSERT_EQUAL_UINT32(117000, mem_budget_window_low(&s_mb, MEM_CAP_INTERNAL));
+}
+
+void test_mem_budget_history_ring(void) {
+    mem_budget_init(&s_mb);
+    uint32_t n = MEM_BUDGET_HISTORY + 5U;
+    for (uint32_t w = 0; w <= n; w++) {
+        record_internal(w * MEM_BUDGET_WINDOW_S, 100000U + w);
+    }
+
+    /* Oldest first; the first five windows were overwritten */
+    uint32_t hist[MEM_BUDGET_HISTORY];
+    TEST_ASSERT_EQUAL_size_t(MEM_BUDGET_HISTORY,
+                             mem_budget_history(&s_mb, MEM_CAP_INTERNAL, hist,
+                                                MEM_BUDGET_HISTORY));
+    TEST_ASSERT_EQUAL_UINT32(100005, hist[0]);
+    TEST_ASSERT_EQUAL_UINT32(100000U + n - 1U, hist[MEM_BUDGET_HISTORY - 1U]);
+
+    /* A short buffer gets the newest windows */
+    TEST_ASSERT_EQUAL_size_t(2, mem_budget_history(&s_mb, MEM_CAP_INTERNAL, hist, 2));
+    TEST_ASSERT_EQUAL_UINT32(100000U + n - 2U, hist[0]);
+    TEST_ASSERT_EQUAL_UINT32(100000U + n - 1U, hist[1]);
+}
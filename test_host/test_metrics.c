@@ -0,0 +1,122 @@
+/**
+ * @file test_metrics.c
+ * @brief Tests for the metrics registry and text renderer
+ */
+
+#include "unity.h"
+#include "metrics.h"
+#include <string.h>
+
+static metrics_t s_metrics;
+static char s_text[1024];
+static size_t s_text_len;
+static unsigned s_writes;
+
+static bool append(void *ctx, const char *data, size_t len) {
+    (void)ctx;
+    TEST_ASSERT_TRUE(s_text_len + len < sizeof(s_text));
+    memcpy(s_text + s_text_len, data, len);
+    s_text_len += len;
+    s_text[s_text_len] = '\0';
+    s_writes++;
+    return true;
+}
+
+static int64_t read_negative(const void *ctx) {
+    (void)ctx;
+    return -1;
+}
+
+static atomic_uint s_edges_dropped;
+static atomic_uint s_cwnet_dropped;
+
+/* Registered out of family order, as components do at init */
+static const metric_desc_t k_descs[] = {
+    { "keyer_stream_dropped_total{consumer=\"edges\"}", "Samples skipped by a consumer",
+      METRIC_COUNTER, NULL, &s_edges_dropped },
+    { "keyer_cwnet_latency_ms", "Server round trip, -1 if unknown",
+      METRIC_GAUGE, read_negative, NULL },
+    { "keyer_stream_dropped_total{consumer=\"cwnet\"}", "Samples skipped by a consumer",
+      METRIC_COUNTER, NULL, &s_cwnet_dropped },
+};
+
+static void render_reset(void) {
+    s_text[0] = '\0';
+    s_text_len = 0;
+    s_writes = 0;
+}
+
+void test_metrics_render_families(void) {
+    metrics_init(&s_metrics);
+    atomic_store(&s_edges_dropped, 3U);
+    atomic_store(&s_cwnet_dropped, 0U);
+    TEST_ASSERT_EQUAL(3, metrics_register_all(&s_metrics, k_descs, 3));
+
+    char buf[512];
+    render_reset();
+    TEST_ASSERT_TRUE(metrics_render(&s_metrics, buf, sizeof(buf), append, NULL));
+    TEST_ASSERT_EQUAL_STRING(
+        "# HELP keyer_stream_dropped_total Samples skipped by a consumer\n"
+        "# TYPE keyer_stream_dropped_total counter\n"
+        "keyer_stream_dropped_total{consumer=\"edges\"} 3\n"
+        "keyer_stream_dropped_total{consumer=\"cwnet\"} 0\n"
+        "# HELP keyer_cwnet_latency_ms Server round trip, -1 if unknown\n"
+        "# TYPE keyer_cwnet_latency_ms gauge\n"
+        "keyer_cwnet_latency_ms -1\n",
+        s_text);
+    TEST_ASSERT_EQUAL(1, s_writes);
+
+    /* Values are read at scrape time */
+    atomic_store(&s_cwnet_dropped, 12U);
+    render_reset();
+    metrics_render(&s_metrics, buf, sizeof(buf), append, NULL);
+    TEST_ASSERT_NOT_NULL(strstr(s_text, "{consumer=\"cwnet\"} 12\n"));
+}
+
+void test_metrics_render_chunks(void) {
+    metrics_init(&s_metrics);
+    metrics_register_all(&s_metrics, k_descs, 3);
+
+    /* Whole lines per chunk, same text as one big buffer */
+    char big[512];
+    render_reset();
+    metrics_render(&s_metrics, big, sizeof(big), append, NULL);
+    char expect[1024];
+    strcpy(expect, s_text);
+
+    char small[72];
+    render_reset();
+    TEST_ASSERT_TRUE(metrics_render(&s_metrics, small, sizeof(small), append, NULL));
+    TEST_ASSERT_EQUAL_STRING(expect, s_text);
+    TEST_ASSERT_TRUE(s_writes > 1);
+
+    /* Full table refuses further metrics */
+    metrics_init(&s_metrics);
+    for (unsigned i = 0; i < METRICS_MAX; i++) {
+        TEST_ASSERT_TRUE(metrics_register(&s_metrics, &k_descs[1]));
+    }
+    TEST_ASSERT_FALSE(metrics_register(&s_metrics, &k_descs[1]));
+}
+
+void test_metrics_render_json(void) {
+    metrics_init(&s_metrics);
+    atomic_store(&s_edges_dropped, 3U);
+    atomic_store(&s_cwnet_dropped, 0U);
+    metrics_register_all(&s_metrics, k_descs, 3);
+
+    /* Registration order, no prefix, label values unquoted */
+    char buf[128];
+    const char *expect =
+        "{\"stream_dropped_total{consumer=edges}\":3,\"cwnet_latency_ms\":-1,"
+        "\"stream_dropped_total{consumer=cwnet}\":0}";
+    TEST_ASSERT_EQUAL(strlen(expect), metrics_render_json(&s_metrics, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING(expect, buf);
+
+    /* All or nothing */
+    TEST_ASSERT_EQUAL(0, metrics_render_json(&s_metrics, buf, strlen(expect)));
+    TEST_ASSERT_EQUAL(strlen(expect), metrics_render_json(&s_metrics, buf, strlen(expect) + 1));
+
+    metrics_init(&s_metrics);
+    TEST_ASSERT_EQUAL(2, metrics_render_json(&s_metrics, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("{}", buf);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file test_metrics_history.c
+ * @brief Tests for the metrics history store
+ */
+
+#include "unity.h"
+#include "metrics_history.h"
+#include <string.h>
+
+static metrics_t s_metrics;
+static metrics_history_t s_hist;
+static metrics_history_point_t s_pts[METRICS_HISTORY_CAPACITY];
+
+static atomic_uint s_gauge;
+static atomic_uint s_counter;
+
+static const metric_desc_t k_descs[] = {
+    { "keyer_heap_free_bytes", "Free heap", METRIC_GAUGE, NULL, &s_gauge },
+    { "keyer_faults_total", "Faults", METRIC_COUNTER, NULL, &s_counter },
+};
+
+static void setup(void) {
+    metrics_init(&s_metrics);
+    metrics_register_all(&s_metrics, k_descs, sizeof(k_descs) / sizeof(k_descs[0]));
+    metrics_history_init(&s_hist);
+    atomic_store(&s_gauge, 0U);
+    atomic_store(&s_counter, 0U);
+}
+
+void test_metrics_history_gauge_levels(void) {
+    setup();
+    TEST_ASSERT_EQUAL_UINT32(900, metrics_history_step_s(2));
+    TEST_ASSERT_EQUAL(1, metrics_history_level_from_str("1m"));
+    TEST_ASSERT_EQUAL(-1, metrics_history_level_from_str("1h"));
+
+    /* 0..119 s: two full minutes, bucket 120 still open */
+    for (uint32_t t = 0; t <= 120; t++) {
+        atomic_store(&s_gauge, 1000U + t);
+        metrics_history_sample(&s_hist, &s_metrics, t);
+    }
+
+    /* 1 s level: one reading per bucket, the open one (120) not published */
+    size_t n = metrics_history_read(&s_hist, 0, 0, 0, s_pts, METRICS_HISTORY_CAPACITY);
+    TEST_ASSERT_EQUAL(120, n);
+    TEST_ASSERT_EQUAL_UINT32(0, s_pts[0].time_s);
+    TEST_ASSERT_EQUAL_UINT32(119, s_pts[n - 1].time_s);
+    TEST_ASSERT_EQUAL_INT32(1119, s_pts[n - 1].avg);
+
+    /* 1 min level: min/max/avg of each minute */
+    n = metrics_history_read(&s_hist, 1, 0, 0, s_pts, METRICS_HISTORY_CAPACITY);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL_UINT32(60, s_pts[1].time_s);
+    TEST_ASSERT_EQUAL_INT32(1060, s_pts[1].min);
+    TEST_ASSERT_EQUAL_INT32(1119, s_pts[1].max);
+    TEST_ASSERT_EQUAL_INT32(1089, s_pts[1].avg);
+
+    /* 15 min level: nothing closed yet; unknown level or series: nothing */
+    TEST_ASSERT_EQUAL(0, metrics_history_read(&s_hist, 2, 0, 0, s_pts, METRICS_HISTORY_CAPACITY));
+    TEST_ASSERT_EQUAL(0, metrics_history_read(&s_hist, 3, 0, 0, s_pts, METRICS_HISTORY_CAPACITY));
+    TEST_ASSERT_EQUAL(0, metrics_history_read(&s_hist, 0, 5, 0, s_pts, METRICS_HISTORY_CAPACITY));
+}
+
+void test_metrics_history_counter_rate(void) {
+    setup();
+
+    /* +3 per second, a 2 s gap, then a reset */
+    static const uint32_t k_t[] = { 10, 11, 12, 14, 15 };
+    static const uint32_t k_v[] = { 100, 103, 106, 112, 5 };
+    for (size_t i = 0; i < 5; i++) {
+        atomic_store(&s_counter, k_v[i]);
+        metrics_history_sample(&s_hist, &s_metrics, k_t[i]);
+    }
+    metrics_history_sample(&s_hist, &s_metrics, 16);
+
+    /* The first reading only sets the base: its bucket has no point */
+    size_t n = metrics_history_read(&s_hist, 0, 1, 0, s_pts, METRICS_HISTORY_CAPACITY);
+    TEST_ASSERT_EQUAL(4, n);
+    TEST_ASSERT_EQUAL_UINT32(11, s_pts[0].time_s);
+    TEST_ASSERT_EQUAL_INT32(3, s_pts[0].avg);
+    TEST_ASSERT_EQUAL_INT32(3, s_pts[1].avg);
+    TEST_ASSERT_EQUAL_UINT32(14, s_pts[2].time_s);
+    TEST_ASSERT_EQUAL_INT32(3, s_pts[2].avg);
+    TEST_ASSERT_EQUAL_UINT32(15, s_pts[3].time_s);
+    TEST_ASSERT_EQUAL_INT32(0, s_pts[3].avg);
+
+    /* The gauge has a point in every bucket */
+    TEST_ASSERT_EQUAL(5, metrics_history_read(&s_hist, 0, 0, 0, s_pts, METRICS_HISTORY_CAPACITY));
+}
+
+void test_metrics_history_wrap_and_from(void) {
+    setup();
+
+    uint32_t last = 3 * METRICS_HISTORY_CAPACITY;
+    for (uint32_t t = 0; t <= last; t++) {
+        atomic_store(&s_gauge, t);
+        metrics_history_sample(&s_hist, &s_metrics, t);
+    }
+
+    /* Only the last CAPACITY - 1 buckets are readable, oldest first */
+    size_t n = metrics_history_read(&s_hist, 0, 0, 0, s_pts, METRICS_HISTORY_CAPACITY);
+    TEST_ASSERT_EQUAL(METRICS_HISTORY_CAPACITY - 1U, n);
+    TEST_ASSERT_EQUAL_UINT32(last - n, s_pts[0].time_s);
+    TEST_ASSERT_EQUAL_UINT32(last - 1U, s_pts[n - 1].time_s);
+    TEST_ASSERT_EQUAL_INT32((int32_t)(last - 1U), s_pts[n - 1].max);
+
+    /* from_s skips earlier buckets; max caps the copy */
+    n = metrics_history_read(&s_hist, 0, 0, last - 5U, s_pts, METRICS_HISTORY_CAPACITY);
+    TEST_ASSERT_EQUAL(5, n);
+    TEST_ASSERT_EQUAL_UINT32(last - 5U, s_pts[0].time_s);
+    TEST_ASSERT_EQUAL(2, metrics_history_read(&s_hist, 0, 0, last - 5U, s_pts, 2));
+}
+
+void test_metrics_history_encode(void) {
+    static const metrics_history_point_t k_pts[] = {
+        { .time_s = 60, .min = -1, .max = 258, .avg = 7 },
+    };
+    uint8_t buf[METRICS_HISTORY_BIN_HEADER + METRICS_HISTORY_BIN_RECORD];
+    static const uint8_t k_expect[] = {
+        'M', 'H', 1, 1,  60, 0, 0, 0,  1, 0, 0, 0,
+        60, 0, 0, 0,  0xFF, 0xFF, 0xFF, 0xFF,  2, 1, 0, 0,  7, 0, 0, 0,
+    };
+
+    TEST_ASSERT_EQUAL(sizeof(buf), metrics_history_encode(1, k_pts, 1, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(k_expect, buf, sizeof(k_expect));
+    TEST_ASSERT_EQUAL(0, metrics_history_encode(1, k_pts, 1, buf, sizeof(buf) - 1));
+    TEST_ASSERT_EQUAL(METRICS_HISTORY_BIN_HEADER, metrics_history_encode(0, k_pts, 0, buf, sizeof(buf)));
+}
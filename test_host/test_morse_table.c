@@ -98,3 +98,54 @@ void test_morse_get_prosign_tag(void) {
     /* NULL input */
     TEST_ASSERT_NULL(morse_get_prosign_tag(NULL));
 }
+
+void test_morse_code_building(void) {
+    /* Shift-and-or from the empty code */
+    morse_code_t code = MORSE_CODE_EMPTY;
+    TEST_ASSERT_EQUAL(0, morse_code_len(code));
+    code = morse_code_push(code, true);
+    code = morse_code_push(code, false);
+    code = morse_code_push(code, false);
+    code = morse_code_push(code, false);
+    TEST_ASSERT_EQUAL(4, morse_code_len(code));
+    TEST_ASSERT_EQUAL_HEX16(0x018, code);
+    TEST_ASSERT_EQUAL_CHAR('B', morse_code_decode(code));
+
+    char buf[MORSE_MAX_ELEMENTS + 1];
+    TEST_ASSERT_EQUAL(4, morse_code_to_string(code, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("-...", buf);
+    TEST_ASSERT_EQUAL(2, morse_code_to_string(code, buf, 3));
+    TEST_ASSERT_EQUAL_STRING("-.", buf);
+
+    /* Parsing limits */
+    TEST_ASSERT_EQUAL_HEX16(MORSE_CODE_EMPTY, morse_code_from_string(""));
+    TEST_ASSERT_EQUAL_HEX16(0x100, morse_code_from_string("........"));
+    TEST_ASSERT_EQUAL_HEX16(MORSE_CODE_INVALID, morse_code_from_string("........."));
+    TEST_ASSERT_EQUAL_HEX16(MORSE_CODE_INVALID, morse_code_from_string(".x"));
+    TEST_ASSERT_EQUAL_CHAR('\0', morse_code_decode(MORSE_CODE_INVALID));
+    TEST_ASSERT_EQUAL_CHAR('\0', morse_code_decode(MORSE_CODE_EMPTY));
+    TEST_ASSERT_EQUAL_CHAR('\0', morse_code_decode(0xFFFF));
+
+    TEST_ASSERT_EQUAL_STRING("<SK>", morse_code_prosign_tag(0x045));
+    TEST_ASSERT_NULL(morse_code_prosign_tag(0x005));
+}
+
+void test_morse_code_tables_agree(void) {
+    /* Direct decode/encode maps match the pattern strings for every char */
+    unsigned found = 0;
+    for (int c = 1; c < 128; c++) {
+        const char *pattern = morse_table_reverse((char)c);
+        morse_code_t code = morse_code_encode((char)c);
+        if (pattern == NULL) {
+            TEST_ASSERT_EQUAL_HEX16(MORSE_CODE_INVALID, code);
+            continue;
+        }
+        TEST_ASSERT_EQUAL_HEX16(morse_code_from_string(pattern), code);
+        if (c >= 'a' && c <= 'z') {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_CHAR((char)c, morse_code_decode(code));
+        found++;
+    }
+    TEST_ASSERT_EQUAL(morse_table_count(), found);
+}
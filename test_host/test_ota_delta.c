@@ -0,0 +1,142 @@
+/**
+ * @file test_ota_delta.c
+ * @brief Tests for the delta patch header and op decoder
+ */
+
+#include "unity.h"
+#include "ota_delta.h"
+#include <string.h>
+
+static uint8_t s_old[1500];
+static uint8_t s_out[2000];
+static size_t s_out_len;
+
+static bool old_read(void *ctx, uint32_t off, uint8_t *buf, size_t len) {
+    (void)ctx;
+    if (off + len > sizeof(s_old)) {
+        return false;
+    }
+    memcpy(buf, s_old + off, len);
+    return true;
+}
+
+static bool out_write(void *ctx, const uint8_t *buf, size_t len) {
+    (void)ctx;
+    if (s_out_len + len > sizeof(s_out)) {
+        return false;
+    }
+    memcpy(s_out + s_out_len, buf, len);
+    s_out_len += len;
+    return true;
+}
+
+static size_t put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return 4;
+}
+
+static void start(ota_delta_t *d, uint32_t new_size) {
+    ota_delta_header_t hdr = { .old_size = sizeof(s_old), .new_size = new_size };
+    for (size_t i = 0; i < sizeof(s_old); i++) {
+        s_old[i] = (uint8_t)(i * 7U);
+    }
+    s_out_len = 0;
+    ota_delta_init(d, &hdr, old_read, out_write, NULL);
+}
+
+void test_ota_delta_apply_ops(void) {
+    /* new = old[100..1300) + (old[10..14) + 1) + "CW" */
+    uint8_t ops[64];
+    size_t n = 0;
+    ops[n++] = OTA_DELTA_OP_COPY;
+    n += put32(ops + n, 100);
+    n += put32(ops + n, 1200);
+    ops[n++] = OTA_DELTA_OP_ADD;
+    n += put32(ops + n, 10);
+    n += put32(ops + n, 4);
+    memset(ops + n, 1, 4);
+    n += 4;
+    ops[n++] = OTA_DELTA_OP_INSERT;
+    n += put32(ops + n, 2);
+    ops[n++] = 'C';
+    ops[n++] = 'W';
+    ops[n++] = OTA_DELTA_OP_END;
+
+    /* One byte at a time: every state boundary gets split */
+    ota_delta_t d;
+    start(&d, 1206);
+    ota_delta_status_t st = OTA_DELTA_MORE;
+    for (size_t i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL(OTA_DELTA_MORE, st);
+        st = ota_delta_feed(&d, ops + i, 1);
+    }
+    TEST_ASSERT_EQUAL(OTA_DELTA_DONE, st);
+    TEST_ASSERT_EQUAL(1206, s_out_len);
+    TEST_ASSERT_EQUAL_MEMORY(s_old + 100, s_out, 1200);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)(s_old[10] + 1), s_out[1200]);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)(s_old[13] + 1), s_out[1203]);
+    TEST_ASSERT_EQUAL_MEMORY("CW", s_out + 1204, 2);
+
+    /* Whole stream at once gives the same result; nothing may follow END */
+    start(&d, 1206);
+    TEST_ASSERT_EQUAL(OTA_DELTA_DONE, ota_delta_feed(&d, ops, n));
+    TEST_ASSERT_EQUAL(1206, s_out_len);
+    TEST_ASSERT_EQUAL(OTA_DELTA_ERROR, ota_delta_feed(&d, ops, 1));
+}
+
+void test_ota_delta_rejects_bad_patches(void) {
+    uint8_t hdr_buf[OTA_DELTA_HEADER_SIZE] = { 0 };
+    ota_delta_header_t hdr;
+    put32(hdr_buf, OTA_DELTA_MAGIC);
+    hdr_buf[4] = OTA_DELTA_VERSION;
+    put32(hdr_buf + 8, 1000);
+    put32(hdr_buf + 12, 2000);
+    hdr_buf[16] = 0xAA;
+    hdr_buf[16 + OTA_SHA256_LEN] = 0xBB;
+    TEST_ASSERT_TRUE(ota_delta_parse_header(hdr_buf, &hdr));
+    TEST_ASSERT_EQUAL(1000, hdr.old_size);
+    TEST_ASSERT_EQUAL(2000, hdr.new_size);
+    TEST_ASSERT_EQUAL_HEX8(0xAA, hdr.old_sha[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xBB, hdr.new_sha[0]);
+    hdr_buf[4] = OTA_DELTA_VERSION + 1;
+    TEST_ASSERT_FALSE(ota_delta_parse_header(hdr_buf, &hdr));
+    hdr_buf[4] = OTA_DELTA_VERSION;
+    hdr_buf[0] ^= 1;
+    TEST_ASSERT_FALSE(ota_delta_parse_header(hdr_buf, &hdr));
+
+    uint8_t ops[16];
+    ota_delta_t d;
+
+    /* COPY past the end of the old image */
+    start(&d, 100);
+    ops[0] = OTA_DELTA_OP_COPY;
+    put32(ops + 1, 1490);
+    put32(ops + 5, 20);
+    TEST_ASSERT_EQUAL(OTA_DELTA_ERROR, ota_delta_feed(&d, ops, 9));
+    TEST_ASSERT_EQUAL(0, s_out_len);
+
+    /* INSERT more than the new image holds */
+    start(&d, 100);
+    ops[0] = OTA_DELTA_OP_INSERT;
+    put32(ops + 1, 101);
+    TEST_ASSERT_EQUAL(OTA_DELTA_ERROR, ota_delta_feed(&d, ops, 5));
+
+    /* Unknown op, and the error sticks */
+    start(&d, 100);
+    ops[0] = 0x7F;
+    TEST_ASSERT_EQUAL(OTA_DELTA_ERROR, ota_delta_feed(&d, ops, 1));
+    ops[0] = OTA_DELTA_OP_END;
+    TEST_ASSERT_EQUAL(OTA_DELTA_ERROR, ota_delta_feed(&d, ops, 1));
+
+    /* END before new_size bytes were produced */
+    start(&d, 100);
+    ops[0] = OTA_DELTA_OP_COPY;
+    put32(ops + 1, 0);
+    put32(ops + 5, 50);
+    ops[9] = OTA_DELTA_OP_END;
+    TEST_ASSERT_EQUAL(OTA_DELTA_MORE, ota_delta_feed(&d, ops, 9));
+    TEST_ASSERT_EQUAL(OTA_DELTA_ERROR, ota_delta_feed(&d, ops + 9, 1));
+}
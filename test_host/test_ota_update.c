@@ -0,0 +1,67 @@
+/**
+ * @file test_ota_update.c
+ * @brief Tests for the OTA digest parser, progress throttle and self-test verdict
+ */
+
+#include "unity.h"
+#include "ota_update.h"
+#include <string.h>
+
+void test_ota_sha_and_progress(void) {
+    uint8_t d[OTA_SHA256_LEN];
+    const char *hex = "00ff10Ab9c0000000000000000000000000000000000000000000000000000ee";
+    TEST_ASSERT_TRUE(ota_parse_sha256(hex, d));
+    TEST_ASSERT_EQUAL_HEX8(0x00, d[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, d[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xAB, d[3]);
+    TEST_ASSERT_EQUAL_HEX8(0xEE, d[31]);
+    TEST_ASSERT_FALSE(ota_parse_sha256("00ff", d));                          /* short */
+    TEST_ASSERT_FALSE(ota_parse_sha256("0", d));                             /* odd */
+    char longer[70];
+    strcpy(longer, hex);
+    strcat(longer, "00");
+    TEST_ASSERT_FALSE(ota_parse_sha256(longer, d));
+    char bad[65];
+    strcpy(bad, hex);
+    bad[10] = 'g';
+    TEST_ASSERT_FALSE(ota_parse_sha256(bad, d));
+
+    ota_progress_t p;
+    uint32_t pct = 0;
+    ota_progress_init(&p, 1000000);
+    TEST_ASSERT_TRUE(ota_progress_step(&p, 4096, 0, &pct));          /* first */
+    TEST_ASSERT_EQUAL(0, pct);
+    TEST_ASSERT_FALSE(ota_progress_step(&p, 15000, 1000000, &pct));  /* 1%, step not reached */
+    TEST_ASSERT_FALSE(ota_progress_step(&p, 500000, 100000, &pct));  /* too soon */
+    TEST_ASSERT_TRUE(ota_progress_step(&p, 500000, 300000, &pct));
+    TEST_ASSERT_EQUAL(50, pct);
+    TEST_ASSERT_TRUE(ota_progress_step(&p, 1000000, 300001, &pct));  /* last byte, always */
+    TEST_ASSERT_EQUAL(100, pct);
+    TEST_ASSERT_FALSE(ota_progress_step(&p, 1000000, 900000, &pct)); /* only once */
+}
+
+void test_ota_self_test_verdict(void) {
+    ota_health_t h = { .uptime_ms = 5000, .fault_active = false,
+                       .heap_free = 64000, .reachable = true };
+    TEST_ASSERT_EQUAL(OTA_VERDICT_PENDING, ota_self_test_judge(&h));
+
+    h.uptime_ms = OTA_SELF_TEST_MS;
+    TEST_ASSERT_EQUAL(OTA_VERDICT_PASS, ota_self_test_judge(&h));
+
+    /* Unhealthy: keep waiting, then roll back */
+    h.fault_active = true;
+    TEST_ASSERT_EQUAL(OTA_VERDICT_PENDING, ota_self_test_judge(&h));
+    h.fault_active = false;
+    h.reachable = false;
+    TEST_ASSERT_EQUAL(OTA_VERDICT_PENDING, ota_self_test_judge(&h));
+    h.uptime_ms = OTA_SELF_TEST_DEADLINE_MS;
+    TEST_ASSERT_EQUAL(OTA_VERDICT_FAIL, ota_self_test_judge(&h));
+
+    /* Recovered in time */
+    h.reachable = true;
+    h.heap_free = OTA_SELF_TEST_MIN_HEAP - 1;
+    TEST_ASSERT_EQUAL(OTA_VERDICT_FAIL, ota_self_test_judge(&h));
+    h.heap_free = OTA_SELF_TEST_MIN_HEAP;
+    h.uptime_ms = OTA_SELF_TEST_MS + 1;
+    TEST_ASSERT_EQUAL(OTA_VERDICT_PASS, ota_self_test_judge(&h));
+}
@@ -0,0 +1,114 @@
+/**
+ * @file test_paddle_capture.c
+ * @brief Unit tests for the captured paddle edge timebase and debouncer
+ */
+
+#include "unity.h"
+#include "paddle_capture.h"
+
+static void feed(paddle_debounce_t *d, paddle_edge_queue_t *out,
+                 paddle_edge_paddle_t paddle, uint8_t level, int64_t t) {
+    paddle_edge_t raw = { .timestamp_us = t, .paddle = (uint8_t)paddle, .level = level };
+    paddle_debounce_feed(d, &raw, out);
+}
+
+static void expect_edge(paddle_edge_queue_t *q, paddle_edge_paddle_t paddle, uint8_t level,
+                        int64_t t) {
+    paddle_edge_t e;
+    TEST_ASSERT_TRUE(paddle_edge_pop(q, &e));
+    TEST_ASSERT_EQUAL(paddle, e.paddle);
+    TEST_ASSERT_EQUAL(level, e.level);
+    TEST_ASSERT_EQUAL_INT64(t, e.timestamp_us);
+}
+
+void test_paddle_capture_clock(void) {
+    paddle_capture_clock_t c;
+    paddle_capture_clock_init(&c, 80000000U);
+    TEST_ASSERT_EQUAL(80, c.ticks_per_us);
+
+    /* First edge anchors at the ISR time */
+    TEST_ASSERT_EQUAL_INT64(10000, paddle_capture_clock_us(&c, 1000, 10000));
+
+    /* Later ones follow the counter, whatever the ISR latency */
+    TEST_ASSERT_EQUAL_INT64(10500, paddle_capture_clock_us(&c, 1000 + 80 * 500, 10530));
+    TEST_ASSERT_EQUAL_INT64(10750, paddle_capture_clock_us(&c, 1000 + 80 * 750 + 40, 10760));
+    /* The half-µs remainder is carried, not lost */
+    TEST_ASSERT_EQUAL_INT64(10751, paddle_capture_clock_us(&c, 1000 + 80 * 751, 10790));
+
+    /* An ISR earlier than the chain proves the anchor was late */
+    TEST_ASSERT_EQUAL_INT64(10800, paddle_capture_clock_us(&c, 1000 + 80 * 900, 10800));
+    TEST_ASSERT_EQUAL_INT64(10900, paddle_capture_clock_us(&c, 1000 + 80 * 1000, 10950));
+
+    /* Counter wrap inside a burst */
+    paddle_capture_clock_init(&c, 80000000U);
+    TEST_ASSERT_EQUAL_INT64(500000, paddle_capture_clock_us(&c, UINT32_MAX - 79, 500000));
+    TEST_ASSERT_EQUAL_INT64(500002, paddle_capture_clock_us(&c, 80, 500010));
+
+    /* Long silence: re-anchor, the counter difference is not trusted */
+    int64_t later = 500010 + PADDLE_CAPTURE_REANCHOR_US + 1;
+    TEST_ASSERT_EQUAL_INT64(later, paddle_capture_clock_us(&c, 12345, later));
+}
+
+void test_paddle_debounce_bounce(void) {
+    paddle_debounce_t d;
+    paddle_edge_queue_t q;
+    paddle_debounce_init(&d, 1500);
+    paddle_edge_queue_init(&q);
+
+    /* Press with bounce: accepted at the first edge */
+    feed(&d, &q, PADDLE_EDGE_DIT, 1, 1000);
+    feed(&d, &q, PADDLE_EDGE_DIT, 0, 1100);
+    feed(&d, &q, PADDLE_EDGE_DIT, 1, 1200);
+    feed(&d, &q, PADDLE_EDGE_DIT, 0, 1300);
+    feed(&d, &q, PADDLE_EDGE_DIT, 1, 1400);
+    expect_edge(&q, PADDLE_EDGE_DIT, 1, 1000);
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+    TEST_ASSERT_EQUAL(4, d.rejected);
+
+    /* Bounce ended pressed: nothing to settle */
+    TEST_ASSERT_FALSE(paddle_debounce_settled(&d, PADDLE_EDGE_DIT, 2499));
+    paddle_debounce_settle(&d, 2600, &q);
+    TEST_ASSERT_TRUE(paddle_debounce_settled(&d, PADDLE_EDGE_DIT, 2600));
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+    TEST_ASSERT_EQUAL(1, paddle_debounce_level(&d, PADDLE_EDGE_DIT));
+
+    /* Release with bounce, DAH pressed inside the DIT window */
+    feed(&d, &q, PADDLE_EDGE_DIT, 0, 50000);
+    feed(&d, &q, PADDLE_EDGE_DIT, 1, 50080);
+    feed(&d, &q, PADDLE_EDGE_DIT, 0, 50150);
+    feed(&d, &q, PADDLE_EDGE_DAH, 1, 50500);
+    paddle_debounce_settle(&d, 52000, &q);
+    expect_edge(&q, PADDLE_EDGE_DIT, 0, 50000);
+    expect_edge(&q, PADDLE_EDGE_DAH, 1, 50500);
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+    TEST_ASSERT_EQUAL(3, d.accepted);
+
+    /* Same level again after the window (edge lost in between): ignored */
+    feed(&d, &q, PADDLE_EDGE_DAH, 1, 60000);
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+}
+
+void test_paddle_debounce_short_tap(void) {
+    paddle_debounce_t d;
+    paddle_edge_queue_t q;
+    paddle_debounce_init(&d, 1500);
+    paddle_edge_queue_init(&q);
+
+    /* Tap shorter than the window: the release is kept for its end */
+    feed(&d, &q, PADDLE_EDGE_DIT, 1, 1000);
+    feed(&d, &q, PADDLE_EDGE_DIT, 0, 1800);
+    paddle_debounce_settle(&d, 2000, &q);
+    expect_edge(&q, PADDLE_EDGE_DIT, 1, 1000);
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+    paddle_debounce_settle(&d, 2600, &q);
+    expect_edge(&q, PADDLE_EDGE_DIT, 0, 2500);
+
+    /* A later edge settles a closed window first, so output stays in order */
+    feed(&d, &q, PADDLE_EDGE_DIT, 1, 10000);
+    feed(&d, &q, PADDLE_EDGE_DIT, 0, 10400);
+    feed(&d, &q, PADDLE_EDGE_DAH, 1, 13000);
+    expect_edge(&q, PADDLE_EDGE_DIT, 1, 10000);
+    expect_edge(&q, PADDLE_EDGE_DIT, 0, 11500);
+    expect_edge(&q, PADDLE_EDGE_DAH, 1, 13000);
+    TEST_ASSERT_TRUE(paddle_edge_queue_empty(&q));
+}
@@ -0,0 +1,48 @@
+/**
+ * @file test_paddle_touch.c
+ * @brief Unit tests for the touch paddle scan plan and thresholds
+ */
+
+#include "unity.h"
+#include "paddle_touch.h"
+
+void test_paddle_touch_scan_plan(void) {
+    paddle_touch_scan_t plan;
+
+    /* 1 kHz tick: full measurement, sleep takes the rest of a third */
+    paddle_touch_scan_plan(&plan, 1000, 2);
+    TEST_ASSERT_EQUAL(PADDLE_TOUCH_MEAS_DEFAULT, plan.meas_cycles);
+    TEST_ASSERT_EQUAL(11, plan.sleep_cycles);
+    TEST_ASSERT_EQUAL(331, plan.scan_us);
+    TEST_ASSERT_EQUAL(993, plan.latency_us);
+
+    /* Slow budget: longer sleep, never over the budget */
+    paddle_touch_scan_plan(&plan, 10000, 2);
+    TEST_ASSERT_EQUAL(PADDLE_TOUCH_MEAS_DEFAULT, plan.meas_cycles);
+    TEST_ASSERT_EQUAL(419, plan.sleep_cycles);
+    TEST_ASSERT_LESS_OR_EQUAL(10000, plan.latency_us);
+
+    /* 10 kHz tick: shorter measurement, one sleep cycle; latency says
+     * how far over the budget the minimum is */
+    paddle_touch_scan_plan(&plan, 100, 2);
+    TEST_ASSERT_EQUAL(66, plan.meas_cycles);
+    TEST_ASSERT_EQUAL(1, plan.sleep_cycles);
+    TEST_ASSERT_EQUAL(122, plan.latency_us);
+
+    /* Impossible budget: floors */
+    paddle_touch_scan_plan(&plan, 0, 0);
+    TEST_ASSERT_EQUAL(PADDLE_TOUCH_MEAS_MIN, plan.meas_cycles);
+    TEST_ASSERT_EQUAL(1, plan.sleep_cycles);
+    TEST_ASSERT_GREATER_THAN(0, plan.latency_us);
+}
+
+void test_paddle_touch_pads_and_threshold(void) {
+    TEST_ASSERT_EQUAL(PADDLE_TOUCH_PAD_NONE, paddle_touch_pad(0));
+    TEST_ASSERT_EQUAL(1, paddle_touch_pad(1));
+    TEST_ASSERT_EQUAL(14, paddle_touch_pad(14));
+    TEST_ASSERT_EQUAL(PADDLE_TOUCH_PAD_NONE, paddle_touch_pad(15));
+
+    TEST_ASSERT_EQUAL(2000, paddle_touch_threshold(10000, 20));
+    TEST_ASSERT_EQUAL(1, paddle_touch_threshold(3, 20));
+    TEST_ASSERT_EQUAL(429496729U, paddle_touch_threshold(0xFFFFFFFFU, 10));
+}
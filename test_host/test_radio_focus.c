@@ -0,0 +1,63 @@
+/**
+ * @file test_radio_focus.c
+ * @brief Unit tests for the SO2R radio focus
+ */
+
+#include "unity.h"
+#include "radio_focus.h"
+
+void test_radio_focus_waits_for_idle(void) {
+    radio_focus_t rf;
+    radio_focus_init(&rf, 2);
+    TEST_ASSERT_EQUAL_UINT8(0, radio_focus_active(&rf));
+
+    /* Nothing asked: never moves */
+    TEST_ASSERT_FALSE(radio_focus_tick(&rf, true));
+
+    /* Asked while keying: held until the first idle tick, taken once */
+    radio_focus_request(&rf, 1);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_FALSE(radio_focus_tick(&rf, false));
+        TEST_ASSERT_EQUAL_UINT8(0, radio_focus_active(&rf));
+    }
+    TEST_ASSERT_TRUE(radio_focus_tick(&rf, true));
+    TEST_ASSERT_EQUAL_UINT8(1, radio_focus_active(&rf));
+    TEST_ASSERT_FALSE(radio_focus_tick(&rf, true));
+
+    /* Asked back before it was taken: no switch at all */
+    radio_focus_request(&rf, 0);
+    TEST_ASSERT_FALSE(radio_focus_tick(&rf, false));
+    radio_focus_request(&rf, 1);
+    TEST_ASSERT_FALSE(radio_focus_tick(&rf, true));
+
+    radio_focus_stats_t st;
+    radio_focus_get(&rf, &st);
+    TEST_ASSERT_EQUAL_UINT32(1, st.switches);
+    TEST_ASSERT_EQUAL_UINT8(1, st.active);
+    TEST_ASSERT_TRUE(st.available);
+}
+
+void test_radio_focus_single_output(void) {
+    radio_focus_t rf;
+
+    /* No second TX pin: radio 2 is remembered but never keyed */
+    radio_focus_init(&rf, 1);
+    radio_focus_request(&rf, 1);
+    TEST_ASSERT_FALSE(radio_focus_tick(&rf, true));
+    TEST_ASSERT_EQUAL_UINT8(0, radio_focus_active(&rf));
+
+    radio_focus_stats_t st;
+    radio_focus_get(&rf, &st);
+    TEST_ASSERT_EQUAL_UINT8(1, st.requested);
+    TEST_ASSERT_FALSE(st.available);
+    TEST_ASSERT_EQUAL_UINT32(0, st.switches);
+
+    /* Out of range requests are ignored; counts are clamped */
+    radio_focus_request(&rf, RADIO_FOCUS_MAX);
+    radio_focus_get(&rf, &st);
+    TEST_ASSERT_EQUAL_UINT8(1, st.requested);
+    radio_focus_init(&rf, 0);
+    TEST_ASSERT_EQUAL_UINT8(1, rf.count);
+    radio_focus_init(&rf, 9);
+    TEST_ASSERT_EQUAL_UINT8(RADIO_FOCUS_MAX, rf.count);
+}
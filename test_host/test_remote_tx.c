@@ -0,0 +1,87 @@
+/**
+ * @file test_remote_tx.c
+ * @brief Unit tests for tick-exact playout of received keying
+ */
+
+#include "unity.h"
+#include "remote_tx.h"
+
+void test_remote_tx_plays_on_tick(void) {
+    remote_tx_t rt;
+    remote_tx_init(&rt, 0);
+    TEST_ASSERT_FALSE(remote_tx_tick(&rt, 1000));
+
+    /* Dit queued 5 ticks ahead: keyed on exactly its ticks */
+    remote_tx_event(&rt, true, 1005);
+    remote_tx_event(&rt, false, 1065);
+    TEST_ASSERT_FALSE(remote_tx_tick(&rt, 1004));
+    TEST_ASSERT_TRUE(remote_tx_tick(&rt, 1005));
+    TEST_ASSERT_EQUAL_UINT64(1005, rt.edge_tick);
+    TEST_ASSERT_TRUE(remote_tx_tick(&rt, 1064));
+    TEST_ASSERT_FALSE(remote_tx_tick(&rt, 1065));
+    TEST_ASSERT_TRUE(remote_tx_idle(&rt));
+
+    /* An event behind its tick plays at once and is counted */
+    remote_tx_event(&rt, true, 1070);
+    TEST_ASSERT_TRUE(remote_tx_tick(&rt, 1073));
+    TEST_ASSERT_EQUAL_UINT64(1073, rt.edge_tick);
+
+    remote_tx_stats_t st;
+    remote_tx_get(&rt, &st);
+    TEST_ASSERT_EQUAL(3, st.events);
+    TEST_ASSERT_EQUAL(1, st.late);
+    TEST_ASSERT_EQUAL(3, st.late_max_ticks);
+    TEST_ASSERT_EQUAL(5, st.lead_min_ticks);
+}
+
+void test_remote_tx_watchdog(void) {
+    remote_tx_t rt;
+    remote_tx_init(&rt, 100);
+    remote_tx_tick(&rt, 0);
+
+    remote_tx_event(&rt, true, 10);
+    TEST_ASSERT_TRUE(remote_tx_tick(&rt, 10));
+    TEST_ASSERT_TRUE(remote_tx_tick(&rt, 109));
+
+    /* Link lost with the key down: released after 100 ticks */
+    TEST_ASSERT_FALSE(remote_tx_tick(&rt, 110));
+
+    /* A stale key down can not key it again before a key up */
+    remote_tx_event(&rt, true, 120);
+    TEST_ASSERT_FALSE(remote_tx_tick(&rt, 120));
+    remote_tx_event(&rt, false, 130);
+    remote_tx_event(&rt, true, 140);
+    TEST_ASSERT_FALSE(remote_tx_tick(&rt, 130));
+    TEST_ASSERT_TRUE(remote_tx_tick(&rt, 140));
+
+    /* Release (fault) drops what is queued */
+    remote_tx_event(&rt, false, 150);
+    remote_tx_release(&rt);
+    TEST_ASSERT_TRUE(remote_tx_idle(&rt));
+
+    remote_tx_stats_t st;
+    remote_tx_get(&rt, &st);
+    TEST_ASSERT_EQUAL(1, st.watchdog);
+    TEST_ASSERT_EQUAL(100, st.watchdog_ticks);
+}
+
+void test_remote_tx_overflow(void) {
+    remote_tx_t rt;
+    remote_tx_init(&rt, 0);
+    remote_tx_tick(&rt, 0);
+
+    remote_tx_event(&rt, true, 1);
+    TEST_ASSERT_TRUE(remote_tx_tick(&rt, 1));
+    for (uint32_t i = 0; i < REMOTE_TX_QUEUE; i++) {
+        remote_tx_event(&rt, (i & 1U) != 0, 100U + i);
+    }
+
+    /* One more than fits: backlog dropped, key released */
+    remote_tx_event(&rt, false, 200);
+    TEST_ASSERT_TRUE(remote_tx_idle(&rt));
+    TEST_ASSERT_FALSE(remote_tx_tick(&rt, 300));
+
+    remote_tx_stats_t st;
+    remote_tx_get(&rt, &st);
+    TEST_ASSERT_EQUAL(1, st.overflow);
+}
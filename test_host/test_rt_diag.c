@@ -46,10 +46,14 @@ void test_diag_macro_logs_when_enabled(void) {
 
     /* Verify entry was logged */
     log_entry_t entry;
-    TEST_ASSERT_TRUE(log_stream_drain(&g_rt_log_stream, &entry));
+    log_reader_t reader;
+    log_reader_init(&reader, &g_rt_log_stream, LOG_LEVEL_TRACE);
+    TEST_ASSERT_TRUE(log_reader_next(&reader, &entry));
     TEST_ASSERT_EQUAL(LOG_LEVEL_INFO, entry.level);
     TEST_ASSERT_EQUAL(ts, entry.timestamp_us);
-    TEST_ASSERT_EQUAL_STRING("hello world", entry.msg);
+    char msg[LOG_MAX_MSG_LEN];
+    log_entry_format(&entry, msg, sizeof(msg));
+    TEST_ASSERT_EQUAL_STRING("hello world", msg);
 
     /* Clean up */
     atomic_store(&g_rt_diag_enabled, false);
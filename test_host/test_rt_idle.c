@@ -0,0 +1,77 @@
+/**
+ * @file test_rt_idle.c
+ * @brief Unit tests for RT idle sleep tracking
+ */
+
+#include "unity.h"
+#include "rt_idle.h"
+
+void test_rt_idle_threshold(void) {
+    rt_idle_t idle;
+
+    /* Off: never sleeps */
+    rt_idle_init(&idle, 0);
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_FALSE(rt_idle_tick(&idle, true));
+    }
+
+    /* Sleeps on the 5th consecutive quiet tick, a busy tick restarts */
+    rt_idle_init(&idle, 5);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FALSE(rt_idle_tick(&idle, true));
+    }
+    TEST_ASSERT_FALSE(rt_idle_tick(&idle, false));
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FALSE(rt_idle_tick(&idle, true));
+    }
+    TEST_ASSERT_TRUE(rt_idle_tick(&idle, true));
+
+    /* Timeout wake: still quiet, sleeps again at once */
+    (void)rt_idle_wake(&idle, 100000, 1000, 0, 0);
+    TEST_ASSERT_TRUE(rt_idle_tick(&idle, true));
+
+    /* Press wake: the busy tick restarts the count */
+    (void)rt_idle_wake(&idle, 100000, 1000, 5000, 5400);
+    TEST_ASSERT_FALSE(rt_idle_tick(&idle, false));
+    TEST_ASSERT_FALSE(rt_idle_tick(&idle, true));
+}
+
+void test_rt_idle_wake_ticks_carry(void) {
+    rt_idle_t idle;
+    rt_idle_init(&idle, 10);
+
+    /* 250us ticks: 100100us is 400 ticks plus 100us carried */
+    TEST_ASSERT_EQUAL_UINT32(400, rt_idle_wake(&idle, 100100, 250, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(400, rt_idle_wake(&idle, 100100, 250, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(401, rt_idle_wake(&idle, 100100, 250, 0, 0));
+
+    /* Many sleeps of a non-multiple never drift: 1000 x 1003us at 100us */
+    rt_idle_init(&idle, 10);
+    uint64_t total = 0;
+    for (int i = 0; i < 1000; i++) {
+        total += rt_idle_wake(&idle, 1003, 100, 0, 0);
+    }
+    TEST_ASSERT_TRUE(total == 10030);
+
+    /* Negative (clock step) counts as nothing */
+    TEST_ASSERT_EQUAL_UINT32(0, rt_idle_wake(&idle, -5000, 100, 0, 0));
+}
+
+void test_rt_idle_stats(void) {
+    rt_idle_t idle;
+    rt_idle_init(&idle, 1);
+
+    (void)rt_idle_wake(&idle, 700000, 1000, 0, 0);
+    (void)rt_idle_wake(&idle, 800000, 1000, 2000000, 2000350);
+    (void)rt_idle_wake(&idle, 50000, 1000, 3000000, 3000120);
+
+    rt_idle_stats_t st;
+    rt_idle_get(&idle, &st);
+    TEST_ASSERT_EQUAL_UINT32(1, st.threshold_ticks);
+    TEST_ASSERT_EQUAL_UINT32(3, st.sleeps);
+    TEST_ASSERT_TRUE(st.slept_us == 1550000);
+    TEST_ASSERT_EQUAL_UINT32(50, st.last_sleep_ms);
+    TEST_ASSERT_EQUAL_UINT32(2, st.paddle_wakes);
+    TEST_ASSERT_EQUAL_UINT32(120, st.wake_latency_us);
+    TEST_ASSERT_EQUAL_UINT32(350, st.wake_latency_max_us);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file test_rt_prof.c
+ * @brief Unit tests for RT hot path cycle accumulators
+ */
+
+#include "unity.h"
+#include "rt_prof.h"
+
+static rt_prof_t s_prof;
+
+void test_rt_prof_min_max_mean(void) {
+    rt_prof_init(&s_prof);
+
+    rt_prof_record(&s_prof, RT_PROF_STAGE_IAMBIC, 100);
+    rt_prof_record(&s_prof, RT_PROF_STAGE_IAMBIC, 300);
+    rt_prof_record(&s_prof, RT_PROF_STAGE_IAMBIC, 200);
+
+    rt_prof_snapshot_t snap;
+    rt_prof_get(&s_prof, RT_PROF_STAGE_IAMBIC, &snap);
+    TEST_ASSERT_EQUAL(3, snap.count);
+    TEST_ASSERT_EQUAL(100, snap.min_cycles);
+    TEST_ASSERT_EQUAL(300, snap.max_cycles);
+    TEST_ASSERT_EQUAL(200, snap.mean_cycles);
+
+    /* Other stages untouched */
+    rt_prof_get(&s_prof, RT_PROF_STAGE_GPIO, &snap);
+    TEST_ASSERT_EQUAL(0, snap.count);
+}
+
+void test_rt_prof_histogram(void) {
+    rt_prof_init(&s_prof);
+
+    TEST_ASSERT_EQUAL(0, rt_prof_hist_bin(0));
+    TEST_ASSERT_EQUAL(1, rt_prof_hist_bin(1));
+    TEST_ASSERT_EQUAL(2, rt_prof_hist_bin(3));
+    TEST_ASSERT_EQUAL(3, rt_prof_hist_bin(4));
+    TEST_ASSERT_EQUAL(RT_PROF_HIST_BINS - 1, rt_prof_hist_bin(UINT32_MAX));
+
+    rt_prof_record(&s_prof, RT_PROF_STAGE_SIDETONE, 5);     /* bin 3 */
+    rt_prof_record(&s_prof, RT_PROF_STAGE_SIDETONE, 7);     /* bin 3 */
+    rt_prof_record(&s_prof, RT_PROF_STAGE_SIDETONE, 1000);  /* bin 10 */
+
+    rt_prof_snapshot_t snap;
+    rt_prof_get(&s_prof, RT_PROF_STAGE_SIDETONE, &snap);
+    TEST_ASSERT_EQUAL(2, snap.hist[3]);
+    TEST_ASSERT_EQUAL(1, snap.hist[10]);
+}
+
+void test_rt_prof_overflow_and_reset(void) {
+    rt_prof_init(&s_prof);
+
+    /* Sum would wrap: accumulators halve, mean stays meaningful */
+    for (int i = 0; i < 8; i++) {
+        rt_prof_record(&s_prof, RT_PROF_STAGE_AUDIO_WRITE, 1000000000U);
+    }
+    rt_prof_snapshot_t snap;
+    rt_prof_get(&s_prof, RT_PROF_STAGE_AUDIO_WRITE, &snap);
+    TEST_ASSERT_EQUAL(1000000000U, snap.mean_cycles);
+
+    /* Reset is deferred to the writer's next record */
+    rt_prof_reset(&s_prof);
+    rt_prof_get(&s_prof, RT_PROF_STAGE_AUDIO_WRITE, &snap);
+    TEST_ASSERT_TRUE(snap.count > 0);
+
+    rt_prof_record(&s_prof, RT_PROF_STAGE_GPIO, 10);
+    rt_prof_get(&s_prof, RT_PROF_STAGE_AUDIO_WRITE, &snap);
+    TEST_ASSERT_EQUAL(0, snap.count);
+    rt_prof_get(&s_prof, RT_PROF_STAGE_GPIO, &snap);
+    TEST_ASSERT_EQUAL(1, snap.count);
+    TEST_ASSERT_EQUAL(10, snap.min_cycles);
+
+    /* Out-of-range stage is ignored */
+    rt_prof_record(&s_prof, RT_PROF_STAGE_COUNT, 10);
+}
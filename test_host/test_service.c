@@ -0,0 +1,112 @@
+/**
+ * @file test_service.c
+ * @brief Tests for the background service table
+ */
+
+#include "unity.h"
+#include "service.h"
+
+static service_table_t s_table;
+
+static bool noop(int64_t now_us) {
+    (void)now_us;
+    return false;
+}
+
+static const service_desc_t k_net = {
+    .name = "svc_net", .run = noop, .period_ms = 50, .priority = 3, .stack_bytes = 4096,
+};
+static const service_desc_t k_ui = {
+    .name = "svc_ui", .run = noop, .period_ms = 20, .priority = 2, .stack_bytes = 4096,
+};
+
+void test_service_register_and_snapshot(void) {
+    service_info_t info[SERVICE_MAX];
+    service_table_init(&s_table);
+    TEST_ASSERT_EQUAL_size_t(0, service_snapshot(&s_table, info, SERVICE_MAX));
+
+    service_t *net = service_register(&s_table, &k_net);
+    service_t *ui = service_register(&s_table, &k_ui);
+    TEST_ASSERT_NOT_NULL(net);
+    TEST_ASSERT_NOT_NULL(ui);
+
+    TEST_ASSERT_EQUAL_size_t(2, service_snapshot(&s_table, info, SERVICE_MAX));
+    TEST_ASSERT_EQUAL_STRING("svc_net", info[0].name);
+    TEST_ASSERT_EQUAL_UINT32(50, info[0].period_ms);
+    TEST_ASSERT_EQUAL_STRING("svc_ui", info[1].name);
+    TEST_ASSERT_EQUAL_UINT8(2, info[1].priority);
+
+    /* Capacity respected, full table refuses more */
+    TEST_ASSERT_EQUAL_size_t(1, service_snapshot(&s_table, info, 1));
+    for (unsigned i = 2; i < SERVICE_MAX; i++) {
+        TEST_ASSERT_NOT_NULL(service_register(&s_table, &k_ui));
+    }
+    TEST_ASSERT_NULL(service_register(&s_table, &k_ui));
+    TEST_ASSERT_EQUAL_size_t(SERVICE_MAX, service_snapshot(&s_table, info, SERVICE_MAX));
+}
+
+void test_service_cpu_accounting(void) {
+    service_info_t info;
+    service_table_init(&s_table);
+    service_t *ui = service_register(&s_table, &k_ui);
+
+    /* Sub-millisecond passes still add up */
+    for (int i = 0; i < 10; i++) {
+        service_record(ui, 1000 * i, 1000 * i + 300);
+    }
+    service_snapshot(&s_table, &info, 1);
+    TEST_ASSERT_EQUAL_UINT32(10, info.runs);
+    TEST_ASSERT_EQUAL_UINT32(3, info.busy_ms);
+    TEST_ASSERT_EQUAL_UINT32(300, info.max_us);
+    TEST_ASSERT_EQUAL_UINT32(0, info.overruns);
+
+    /* A pass longer than the 20 ms period is an overrun */
+    service_record(ui, 0, 25000);
+    service_record(ui, 0, 700);
+    service_snapshot(&s_table, &info, 1);
+    TEST_ASSERT_EQUAL_UINT32(12, info.runs);
+    TEST_ASSERT_EQUAL_UINT32(1, info.overruns);
+    TEST_ASSERT_EQUAL_UINT32(25000, info.max_us);
+    TEST_ASSERT_EQUAL_UINT32(700, info.last_us);
+    TEST_ASSERT_EQUAL_UINT32(3 + 25 + 0, info.busy_ms);   /* 700 us still pending */
+
+    /* A clock going back counts as zero */
+    service_record(ui, 5000, 4000);
+    service_snapshot(&s_table, &info, 1);
+    TEST_ASSERT_EQUAL_UINT32(0, info.last_us);
+}
+
+void test_service_adaptive_delay(void) {
+    static const service_desc_t k_adaptive = {
+        .name = "svc_dec", .run = noop, .period_ms = 40, .min_period_ms = 1, .hold_ms = 100,
+        .priority = 2, .stack_bytes = 4096,
+    };
+    service_table_init(&s_table);
+    service_t *fixed = service_register(&s_table, &k_net);
+    service_t *dec = service_register(&s_table, &k_adaptive);
+
+    /* Fixed period whatever the pass found */
+    TEST_ASSERT_EQUAL_UINT32(50, service_next_delay_ms(fixed, 1000000, true));
+    TEST_ASSERT_EQUAL_UINT32(50, service_next_delay_ms(fixed, 1000000, false));
+
+    /* Busy, then held fast for hold_ms */
+    TEST_ASSERT_EQUAL_UINT32(1, service_next_delay_ms(dec, 1000000, true));
+    TEST_ASSERT_EQUAL_UINT32(1, service_next_delay_ms(dec, 1099000, false));
+
+    /* Silence: 2, 4, ... up to the period */
+    TEST_ASSERT_EQUAL_UINT32(2, service_next_delay_ms(dec, 1100000, false));
+    TEST_ASSERT_EQUAL_UINT32(4, service_next_delay_ms(dec, 1102000, false));
+    TEST_ASSERT_EQUAL_UINT32(8, service_next_delay_ms(dec, 1106000, false));
+    TEST_ASSERT_EQUAL_UINT32(16, service_next_delay_ms(dec, 1114000, false));
+    TEST_ASSERT_EQUAL_UINT32(32, service_next_delay_ms(dec, 1130000, false));
+    TEST_ASSERT_EQUAL_UINT32(40, service_next_delay_ms(dec, 1162000, false));
+    TEST_ASSERT_EQUAL_UINT32(40, service_next_delay_ms(dec, 1202000, false));
+
+    /* Work again: straight back to the fast poll */
+    TEST_ASSERT_EQUAL_UINT32(1, service_next_delay_ms(dec, 1242000, true));
+
+    service_info_t info[2];
+    service_snapshot(&s_table, info, 2);
+    TEST_ASSERT_EQUAL_UINT32(1, info[1].delay_ms);
+    TEST_ASSERT_EQUAL_UINT32(1, info[1].min_period_ms);
+}
@@ -6,6 +6,8 @@
 #include "unity.h"
 #include "sidetone.h"
 #include "stubs/esp_stubs.h"
+#include <math.h>
+#include <stdlib.h>
 
 static sidetone_gen_t s_sidetone;
 
@@ -72,3 +74,137 @@ void test_sidetone_fade(void) {
     sample = sidetone_next_sample(&s_sidetone, false);
     TEST_ASSERT_EQUAL(0, sample);
 }
+
+void test_sidetone_render_matches_per_sample(void) {
+    /* Key pattern exercising every fade transition, including re-keying mid-ramp */
+    static const struct { bool key; size_t n; } pattern[] = {
+        { false, 5 }, { true, 3 }, { true, 50 }, { false, 7 }, { true, 4 },
+        { true, 8 }, { false, 60 }, { true, 100 }, { false, 1 }, { false, 45 },
+    };
+    const uint16_t gains[] = { SIDETONE_GAIN_UNITY, sidetone_gain_from_pct(37), 0 };
+    const uint16_t fades[] = { 40, 7, 1 };
+
+    for (size_t f = 0; f < sizeof(fades) / sizeof(fades[0]); f++) {
+        for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+            sidetone_gen_t ref;
+            sidetone_init(&ref, 700, 8000, fades[f]);
+            sidetone_init(&s_sidetone, 700, 8000, fades[f]);
+
+            for (size_t p = 0; p < sizeof(pattern) / sizeof(pattern[0]); p++) {
+                int16_t block[128];
+                sidetone_render(&s_sidetone, block, pattern[p].n, pattern[p].key, gains[g]);
+                for (size_t i = 0; i < pattern[p].n; i++) {
+                    int32_t expected = sidetone_next_sample(&ref, pattern[p].key);
+                    expected = (expected * (int32_t)gains[g]) >> 15;
+                    TEST_ASSERT_EQUAL(expected, block[i]);
+                }
+                TEST_ASSERT_EQUAL(ref.fade_state, s_sidetone.fade_state);
+                TEST_ASSERT_EQUAL(ref.fade_pos, s_sidetone.fade_pos);
+                TEST_ASSERT_EQUAL(ref.phase, s_sidetone.phase);
+            }
+        }
+    }
+}
+
+void test_sidetone_render_stereo(void) {
+    sidetone_gen_t mono;
+    sidetone_init(&mono, 600, 8000, 40);
+    sidetone_init(&s_sidetone, 600, 8000, 40);
+
+    int16_t m[64];
+    int16_t st[128];
+    sidetone_render(&mono, m, 64, true, sidetone_gain_from_pct(80));
+    sidetone_render_stereo(&s_sidetone, st, 64, true, sidetone_gain_from_pct(80));
+
+    for (size_t i = 0; i < 64; i++) {
+        TEST_ASSERT_EQUAL(m[i], st[2 * i]);
+        TEST_ASSERT_EQUAL(m[i], st[2 * i + 1]);
+    }
+    TEST_ASSERT_EQUAL(SIDETONE_GAIN_UNITY, sidetone_gain_from_pct(100));
+    TEST_ASSERT_EQUAL(SIDETONE_GAIN_UNITY, sidetone_gain_from_pct(200));
+}
+
+void test_sidetone_interpolated_lut(void) {
+    /* 48 kHz, a pitch that walks every LUT position */
+    sidetone_init(&s_sidetone, 733, 48000, 8);
+    for (int i = 0; i < 16; i++) {
+        sidetone_next_sample(&s_sidetone, true);
+    }
+    TEST_ASSERT_EQUAL(FADE_SUSTAIN, s_sidetone.fade_state);
+
+    /* Interpolation error ~2.5 LSB plus rounding (truncated LUT: up to ~800) */
+    int max_err = 0;
+    for (int i = 0; i < 4800; i++) {
+        double phase = (double)s_sidetone.phase / 4294967296.0;
+        int expected = (int)lround(sin(2.0 * M_PI * phase) * 32767.0);
+        int err = abs((int)sidetone_next_sample(&s_sidetone, true) - expected);
+        if (err > max_err) {
+            max_err = err;
+        }
+    }
+    TEST_ASSERT_TRUE(max_err <= 6);
+}
+
+void test_sidetone_envelope_tables(void) {
+    static fade_env_t env;
+
+    /* Linear table equals the computed ramp: same output with or without it */
+    fade_env_build(&env, FADE_SHAPE_LINEAR, 40);
+    sidetone_gen_t ref;
+    sidetone_init(&ref, 700, 8000, 40);
+    sidetone_init(&s_sidetone, 700, 8000, 40);
+    sidetone_set_envelope(&s_sidetone, &env);
+    for (int i = 0; i < 120; i++) {
+        bool key = (i % 50) < 30;
+        TEST_ASSERT_EQUAL(sidetone_next_sample(&ref, key), sidetone_next_sample(&s_sidetone, key));
+    }
+
+    /* Shaped ramps: 0 to full, monotonic, smooth start far below linear */
+    const fade_shape_t shapes[] = { FADE_SHAPE_RAISED_COSINE, FADE_SHAPE_BLACKMAN_HARRIS };
+    for (size_t s = 0; s < 2; s++) {
+        fade_env_build(&env, shapes[s], 240);
+        TEST_ASSERT_EQUAL(240, env.len);
+        TEST_ASSERT_EQUAL_INT16(0, env.table[0]);
+        TEST_ASSERT_EQUAL_INT16(FADE_ENV_FULL, env.table[240]);
+        for (uint32_t k = 1; k <= 240; k++) {
+            TEST_ASSERT_TRUE(env.table[k] >= env.table[k - 1]);
+        }
+        TEST_ASSERT_TRUE(env.table[12] < 32767 * 12 / 240 / 4);
+    }
+
+    /* Raised cosine is symmetric: rise and fall cross at half level */
+    fade_env_build(&env, FADE_SHAPE_RAISED_COSINE, 240);
+    TEST_ASSERT_INT_WITHIN(1, 16384, env.table[120]);
+    for (uint32_t k = 0; k <= 240; k++) {
+        TEST_ASSERT_INT_WITHIN(1, FADE_ENV_FULL, env.table[k] + env.table[240 - k]);
+    }
+
+    fade_env_build(&env, FADE_SHAPE_RAISED_COSINE, 9999);
+    TEST_ASSERT_EQUAL(FADE_ENV_MAX_LEN, env.len);
+    TEST_ASSERT_EQUAL_STRING("blackman_harris", fade_shape_str(FADE_SHAPE_BLACKMAN_HARRIS));
+}
+
+void test_sidetone_render_with_envelope(void) {
+    /* Block renderer reads the table like the per-sample path */
+    static const struct { bool key; size_t n; } pattern[] = {
+        { true, 3 }, { true, 50 }, { false, 7 }, { true, 4 }, { false, 60 }, { true, 30 },
+    };
+    static fade_env_t env;
+    fade_env_build(&env, FADE_SHAPE_BLACKMAN_HARRIS, 40);
+
+    sidetone_gen_t ref;
+    sidetone_init(&ref, 700, 16000, 40);
+    sidetone_init(&s_sidetone, 700, 16000, 40);
+    sidetone_set_envelope(&ref, &env);
+    sidetone_set_envelope(&s_sidetone, &env);
+
+    for (size_t p = 0; p < sizeof(pattern) / sizeof(pattern[0]); p++) {
+        int16_t block[64];
+        sidetone_render(&s_sidetone, block, pattern[p].n, pattern[p].key, SIDETONE_GAIN_UNITY);
+        for (size_t i = 0; i < pattern[p].n; i++) {
+            TEST_ASSERT_EQUAL(sidetone_next_sample(&ref, pattern[p].key), block[i]);
+        }
+        TEST_ASSERT_EQUAL(ref.fade_state, s_sidetone.fade_state);
+        TEST_ASSERT_EQUAL(ref.fade_pos, s_sidetone.fade_pos);
+    }
+}
@@ -0,0 +1,136 @@
+/**
+ * @file test_stats_watch.c
+ * @brief Unit tests for the console stats watch lines
+ */
+
+#include "unity.h"
+#include "stats_watch.h"
+#include <string.h>
+
+static stats_watch_t s_w;
+static char s_line[160];
+
+static stats_watch_sample_t sample(int64_t t_ms, uint32_t lag, uint32_t heap) {
+    stats_watch_sample_t s;
+    memset(&s, 0, sizeof(s));
+    s.time_us = t_ms * 1000;
+    s.lag = lag;
+    s.heap_free = heap;
+    return s;
+}
+
+void test_stats_watch_first_sample_is_base(void) {
+    stats_watch_init(&s_w, 0);
+    stats_watch_sample_t s = sample(1000, 5, 100);
+    s.rt_peak_us = 4096;    /* Covers the time before the watch: not shown */
+    stats_watch_push(&s_w, &s);
+    TEST_ASSERT_EQUAL(0, stats_watch_line(&s_w, s_line, sizeof(s_line)));
+    TEST_ASSERT_EQUAL_STRING("", s_line);
+}
+
+void test_stats_watch_min_max_between_lines(void) {
+    unsigned groups = (1U << STATS_WATCH_LAG) | (1U << STATS_WATCH_HEAP);
+    stats_watch_init(&s_w, groups);
+    stats_watch_sample_t s = sample(0, 0, 0);
+    stats_watch_push(&s_w, &s);
+
+    /* A one-sample lag spike between lines */
+    s = sample(250, 1, 900);  stats_watch_push(&s_w, &s);
+    s = sample(500, 37, 880); stats_watch_push(&s_w, &s);
+    s = sample(750, 0, 950);  stats_watch_push(&s_w, &s);
+    s = sample(1000, 2, 940); stats_watch_push(&s_w, &s);
+
+    size_t n = stats_watch_line(&s_w, s_line, sizeof(s_line));
+    TEST_ASSERT_EQUAL_STRING("1.0s lag 2 [0-37] drop +0 | heap 940 [880-950]\r\n", s_line);
+    TEST_ASSERT_EQUAL(strlen(s_line), n);
+
+    /* Nothing new: no line */
+    TEST_ASSERT_EQUAL(0, stats_watch_line(&s_w, s_line, sizeof(s_line)));
+
+    /* The next line starts over */
+    s = sample(2000, 3, 930);
+    stats_watch_push(&s_w, &s);
+    stats_watch_line(&s_w, s_line, sizeof(s_line));
+    TEST_ASSERT_EQUAL_STRING("2.0s lag 3 [3-3] drop +0 | heap 930 [930-930]\r\n", s_line);
+}
+
+void test_stats_watch_counters_are_deltas(void) {
+    unsigned groups = (1U << STATS_WATCH_RT) | (1U << STATS_WATCH_CWNET) |
+                      (1U << STATS_WATCH_VPN);
+    stats_watch_init(&s_w, groups);
+    stats_watch_sample_t s = sample(10000, 0, 0);
+    s.rt_missed = 7;
+    s.cwnet_edges = 100;
+    s.vpn_tx = 50;
+    s.vpn_rx = 40;
+    stats_watch_push(&s_w, &s);
+
+    s.time_us = 10500000;
+    s.rt_peak_us = 64;
+    s.cwnet_peak_us = 2048;
+    s.cwnet_edges = 130;
+    s.vpn_tx = 62;
+    stats_watch_push(&s_w, &s);
+    s.time_us = 11000000;
+    s.rt_peak_us = 32;
+    s.cwnet_peak_us = 0;
+    s.rt_missed = 8;
+    s.cwnet_edges = 142;
+    s.vpn_tx = 75;
+    s.vpn_rx = 52;
+    stats_watch_push(&s_w, &s);
+
+    stats_watch_line(&s_w, s_line, sizeof(s_line));
+    TEST_ASSERT_EQUAL_STRING("11.0s rt 64us miss +1 | cwnet +42 2048us | vpn tx +25 rx +12\r\n",
+                             s_line);
+}
+
+void test_stats_watch_ring_overflow_keeps_deltas(void) {
+    stats_watch_init(&s_w, 1U << STATS_WATCH_LAG);
+    stats_watch_sample_t s = sample(0, 0, 0);
+    stats_watch_push(&s_w, &s);
+
+    /* The spike falls out of the ring; the drop count still adds up */
+    s = sample(1, 99, 0);
+    stats_watch_push(&s_w, &s);
+    for (uint32_t i = 0; i < STATS_WATCH_RING; i++) {
+        s = sample(2 + (int64_t)i, 1, 0);
+        s.lag_dropped = i + 1U;
+        stats_watch_push(&s_w, &s);
+    }
+    stats_watch_line(&s_w, s_line, sizeof(s_line));
+    TEST_ASSERT_EQUAL_STRING("0.0s lag 1 [1-1] drop +32\r\n", s_line);
+}
+
+void test_stats_watch_line_truncates(void) {
+    stats_watch_init(&s_w, 0);
+    stats_watch_sample_t s = sample(0, 0, 0);
+    stats_watch_push(&s_w, &s);
+    stats_watch_push(&s_w, &s);
+    char small[12];
+    size_t n = stats_watch_line(&s_w, small, sizeof(small));
+    TEST_ASSERT_EQUAL(sizeof(small) - 1U, n);
+    TEST_ASSERT_EQUAL(sizeof(small) - 1U, strlen(small));
+}
+
+void test_stats_watch_hist_peak(void) {
+    uint32_t prev[8] = {0, 5, 3, 0, 0, 0, 0, 0};
+    uint32_t now[8] = {0, 6, 3, 0, 1, 0, 0, 0};
+    TEST_ASSERT_EQUAL_UINT32(16, stats_watch_hist_peak(now, prev, 8));
+    TEST_ASSERT_EQUAL_UINT32(1, prev[4]);
+    /* Nothing added since */
+    TEST_ASSERT_EQUAL_UINT32(0, stats_watch_hist_peak(now, prev, 8));
+}
+
+void test_stats_watch_parse_groups(void) {
+    unsigned g = 0;
+    TEST_ASSERT_TRUE(stats_watch_parse_groups("rt,heap", &g));
+    TEST_ASSERT_EQUAL_UINT((1U << STATS_WATCH_RT) | (1U << STATS_WATCH_HEAP), g);
+    TEST_ASSERT_TRUE(stats_watch_parse_groups("all", &g));
+    TEST_ASSERT_EQUAL_UINT(STATS_WATCH_ALL, g);
+    TEST_ASSERT_TRUE(stats_watch_parse_groups("lag,", &g));
+    TEST_ASSERT_EQUAL_UINT(1U << STATS_WATCH_LAG, g);
+    TEST_ASSERT_FALSE(stats_watch_parse_groups("rt,bogus", &g));
+    TEST_ASSERT_FALSE(stats_watch_parse_groups("", &g));
+    TEST_ASSERT_FALSE(stats_watch_parse_groups("r", &g));
+}
@@ -11,7 +11,7 @@
 
 /* Test buffer */
 #define TEST_BUFFER_SIZE 64
-static stream_sample_t s_test_buffer[TEST_BUFFER_SIZE];
+static stream_slot_t s_test_buffer[TEST_BUFFER_SIZE];
 static keying_stream_t s_stream;
 
 void test_stream_init(void) {
@@ -116,3 +116,1072 @@ void test_stream_multiple_consumers(void) {
     TEST_ASSERT_TRUE(ok);
     TEST_ASSERT_EQUAL(0, sample3.local_key);
 }
+
+void test_stream_tick_period(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    /* Default is the 1 kHz stream */
+    TEST_ASSERT_EQUAL(STREAM_DEFAULT_TICK_US, stream_tick_period_us(&s_stream));
+
+    /* Producer configures 10 kHz */
+    stream_set_tick_period_us(&s_stream, 100);
+    TEST_ASSERT_EQUAL(100, stream_tick_period_us(&s_stream));
+
+    /* Zero is rejected, previous period kept */
+    stream_set_tick_period_us(&s_stream, 0);
+    TEST_ASSERT_EQUAL(100, stream_tick_period_us(&s_stream));
+
+    /* Re-init restores default */
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    TEST_ASSERT_EQUAL(STREAM_DEFAULT_TICK_US, stream_tick_period_us(&s_stream));
+}
+
+void test_stream_producer_lanes(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    stream_producer_t text;
+    stream_producer_init(&text, &s_stream, STREAM_LANE_TEXT);
+
+    stream_sample_t up = STREAM_SAMPLE_EMPTY;
+    stream_sample_t down = STREAM_SAMPLE_EMPTY;
+    down.local_key = 1;
+
+    /* LOCAL: 3 idle ticks; TEXT: key down, 2 idle ticks */
+    stream_push(&s_stream, up);           /* no change from EMPTY */
+    stream_producer_push(&text, down);    /* slot 0: TEXT key down */
+    stream_push(&s_stream, up);
+    stream_producer_push(&text, down);
+    stream_push(&s_stream, up);
+    stream_producer_push(&text, down);
+    stream_push(&s_stream, down);         /* slot 1: LOCAL silence(3), slot 2: key down */
+    stream_producer_flush(&text);         /* slot 3: TEXT silence(2) */
+
+    TEST_ASSERT_EQUAL(4, stream_write_position(&s_stream));
+
+    stream_sample_t s;
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 0, &s));
+    TEST_ASSERT_EQUAL(STREAM_LANE_TEXT, sample_lane(&s));
+    TEST_ASSERT_EQUAL(1, s.local_key);
+    TEST_ASSERT_TRUE(s.flags & FLAG_LOCAL_EDGE);
+
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 1, &s));
+    TEST_ASSERT_EQUAL(STREAM_LANE_LOCAL, sample_lane(&s));
+    TEST_ASSERT_TRUE(sample_is_silence(&s));
+    TEST_ASSERT_EQUAL(3, sample_silence_ticks(&s));
+
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 2, &s));
+    TEST_ASSERT_EQUAL(STREAM_LANE_LOCAL, sample_lane(&s));
+    TEST_ASSERT_EQUAL(1, s.local_key);
+
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 3, &s));
+    TEST_ASSERT_EQUAL(STREAM_LANE_TEXT, sample_lane(&s));
+    TEST_ASSERT_TRUE(sample_is_silence(&s));
+    TEST_ASSERT_EQUAL(2, sample_silence_ticks(&s));
+}
+
+void test_stream_uncommitted_slot(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    best_effort_consumer_t consumer;
+    best_effort_consumer_init(&consumer, &s_stream, 0);
+
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    sample.audio_level = 1;
+    stream_push_raw(&s_stream, sample);
+    sample.audio_level = 2;
+    stream_push_raw(&s_stream, sample);
+
+    /* Simulate a producer that claimed slot 0 but has not committed yet */
+    atomic_store(&s_test_buffer[0].commit, 0);
+
+    stream_sample_t s;
+    TEST_ASSERT_FALSE(stream_read(&s_stream, 0, &s));
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 1, &s));
+
+    /* Consumer stops at the gap instead of skipping or dropping */
+    TEST_ASSERT_FALSE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_EQUAL(0, consumer.read_idx);
+    TEST_ASSERT_EQUAL(0, best_effort_consumer_dropped(&consumer));
+
+    /* Commit lands: both samples come out in order */
+    atomic_store(&s_test_buffer[0].commit, 1);
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_EQUAL(1, s.audio_level);
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_EQUAL(2, s.audio_level);
+}
+
+void test_best_effort_catch_up_keeps_edges(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    best_effort_consumer_t consumer;
+    best_effort_consumer_init(&consumer, &s_stream, 8);
+
+    /* 40 LOCAL ticks, key down at 10 and up at 25 */
+    for (int i = 0; i < 40; i++) {
+        stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+        if (i == 10 || i == 25) {
+            sample.flags = FLAG_LOCAL_EDGE;
+            sample.local_key = (i == 10) ? 1U : 0U;
+        }
+        stream_push_raw(&s_stream, sample);
+    }
+
+    /* Far past the threshold: edges come through, idle ticks fold */
+    stream_sample_t s;
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_TRUE(sample_is_silence(&s));
+    TEST_ASSERT_EQUAL_UINT32(10, sample_silence_ticks(&s));
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_TRUE(sample_has_local_edge(&s));
+    TEST_ASSERT_EQUAL(1, s.local_key);
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_EQUAL_UINT32(14, sample_silence_ticks(&s));
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_TRUE(sample_has_local_edge(&s));
+    TEST_ASSERT_EQUAL(0, s.local_key);
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_EQUAL_UINT32(12, sample_silence_ticks(&s));
+
+    /* Near-latest: the last 2 samples read normally */
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_FALSE(sample_is_silence(&s));
+    TEST_ASSERT_TRUE(best_effort_consumer_tick(&consumer, &s));
+    TEST_ASSERT_FALSE(best_effort_consumer_tick(&consumer, &s));
+
+    TEST_ASSERT_EQUAL(0, best_effort_consumer_dropped(&consumer));
+    TEST_ASSERT_EQUAL(36, best_effort_consumer_condensed(&consumer));
+}
+
+void test_stream_registry_telemetry(void) {
+    static stream_registry_t reg;
+    stream_consumer_info_t info[STREAM_REGISTRY_MAX];
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    /* No registry: registering is a no-op */
+    best_effort_consumer_t be;
+    best_effort_consumer_init(&be, &s_stream, 0);
+    best_effort_consumer_register(&be, "none");
+    TEST_ASSERT_NULL(be.entry);
+    TEST_ASSERT_EQUAL_size_t(0, stream_registry_snapshot(&s_stream, info, STREAM_REGISTRY_MAX));
+
+    stream_registry_init(&reg);
+    stream_attach_registry(&s_stream, &reg);
+    best_effort_consumer_register(&be, "decoder");
+    fault_state_t fault = FAULT_STATE_INIT;
+    hard_rt_consumer_t rt;
+    hard_rt_consumer_init(&rt, &s_stream, &fault, 16);
+    hard_rt_consumer_register(&rt, "rt_tx");
+
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+    for (int i = 0; i < 5; i++) {
+        sample.audio_level = (uint8_t)i;
+        stream_push_raw(&s_stream, sample);
+    }
+
+    /* Lag 5, 4, ... 1, then 0 when caught up */
+    stream_sample_t s;
+    while (best_effort_consumer_tick(&be, &s)) {
+    }
+    TEST_ASSERT_EQUAL(HARD_RT_OK, hard_rt_consumer_tick(&rt, &s));
+
+    TEST_ASSERT_EQUAL_size_t(2, stream_registry_snapshot(&s_stream, info, STREAM_REGISTRY_MAX));
+    TEST_ASSERT_EQUAL_STRING("decoder", info[0].name);
+    TEST_ASSERT_EQUAL_size_t(5, info[0].read_idx);
+    TEST_ASSERT_EQUAL_size_t(0, info[0].lag);
+    TEST_ASSERT_EQUAL_UINT32(5, info[0].max_lag);
+    TEST_ASSERT_EQUAL_UINT32(6, info[0].reads);
+    TEST_ASSERT_EQUAL_UINT32(1, info[0].hist[0]);   /* 0 */
+    TEST_ASSERT_EQUAL_UINT32(1, info[0].hist[1]);   /* 1 */
+    TEST_ASSERT_EQUAL_UINT32(2, info[0].hist[2]);   /* 2-3 */
+    TEST_ASSERT_EQUAL_UINT32(2, info[0].hist[3]);   /* 4-7 */
+
+    TEST_ASSERT_EQUAL_STRING("rt_tx", info[1].name);
+    TEST_ASSERT_EQUAL_size_t(5, info[1].lag);       /* Position before that read */
+    TEST_ASSERT_EQUAL_UINT32(5, info[1].max_lag);
+
+    /* Hard RT latency fault counts as an overrun */
+    for (int i = 0; i < 20; i++) {
+        stream_push_raw(&s_stream, sample);
+    }
+    TEST_ASSERT_EQUAL(HARD_RT_FAULT, hard_rt_consumer_tick(&rt, &s));
+    stream_registry_snapshot(&s_stream, info, STREAM_REGISTRY_MAX);
+    TEST_ASSERT_EQUAL_UINT32(1, info[1].overruns);
+    TEST_ASSERT_EQUAL_UINT32(24, info[1].max_lag);
+
+    TEST_ASSERT_EQUAL(0, stream_lag_bin(0));
+    TEST_ASSERT_EQUAL(STREAM_LAG_HIST_BINS - 1U, stream_lag_bin(SIZE_MAX));
+}
+
+void test_stream_read_slot_result(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    stream_sample_t s;
+    TEST_ASSERT_EQUAL(STREAM_READ_EMPTY, stream_read_slot(&s_stream, 0, &s));
+
+    /* Fill more than one lap: index 0 was overwritten by index 64 */
+    for (size_t i = 0; i < TEST_BUFFER_SIZE + 4; i++) {
+        stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+        sample.audio_level = (uint8_t)i;
+        stream_push_raw(&s_stream, sample);
+    }
+    TEST_ASSERT_EQUAL(STREAM_READ_OVERWRITTEN, stream_read_slot(&s_stream, 0, &s));
+    TEST_ASSERT_EQUAL(STREAM_READ_OVERWRITTEN, stream_read_slot(&s_stream, 3, &s));
+    TEST_ASSERT_EQUAL(STREAM_READ_OK, stream_read_slot(&s_stream, 4, &s));
+    TEST_ASSERT_EQUAL(4, s.audio_level);
+    TEST_ASSERT_EQUAL(STREAM_READ_OK, stream_read_slot(&s_stream, TEST_BUFFER_SIZE, &s));
+    TEST_ASSERT_EQUAL(TEST_BUFFER_SIZE, s.audio_level);
+
+    /* Slot being rewritten by its own (latest) writer: not ready, not lost */
+    atomic_store(&s_test_buffer[(TEST_BUFFER_SIZE + 3) & (TEST_BUFFER_SIZE - 1)].commit, 0);
+    TEST_ASSERT_EQUAL(STREAM_READ_EMPTY, stream_read_slot(&s_stream, TEST_BUFFER_SIZE + 3, &s));
+    TEST_ASSERT_FALSE(stream_read(&s_stream, TEST_BUFFER_SIZE + 3, &s));
+}
+
+void test_stream_consumer_span_wrap(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    /* Start 4 slots before the end of the ring, 10 samples pending */
+    for (size_t i = 0; i < TEST_BUFFER_SIZE - 4; i++) {
+        stream_push_raw(&s_stream, STREAM_SAMPLE_EMPTY);
+    }
+    stream_consumer_t consumer;
+    consumer_init(&consumer, &s_stream);
+    for (size_t i = 0; i < 10; i++) {
+        stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+        sample.audio_level = (uint8_t)i;
+        stream_push_raw(&s_stream, sample);
+    }
+
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+    TEST_ASSERT_EQUAL(10, consumer_next_span(&consumer, &a, &na, &b, &nb, 64));
+    TEST_ASSERT_EQUAL(4, na);
+    TEST_ASSERT_EQUAL(6, nb);
+    TEST_ASSERT_EQUAL(0, a[0].sample.audio_level);
+    TEST_ASSERT_EQUAL(3, a[3].sample.audio_level);
+    TEST_ASSERT_EQUAL(4, b[0].sample.audio_level);
+    TEST_ASSERT_EQUAL(9, b[5].sample.audio_level);
+
+    /* max limits the batch; nothing moves until commit */
+    TEST_ASSERT_EQUAL(3, consumer_next_span(&consumer, &a, &na, &b, &nb, 3));
+    TEST_ASSERT_EQUAL(3, na);
+    TEST_ASSERT_EQUAL(0, nb);
+    TEST_ASSERT_NULL(b);
+    TEST_ASSERT_TRUE(consumer_commit(&consumer, 3));
+    TEST_ASSERT_EQUAL(7, consumer_lag(&consumer));
+
+    /* Span stops at a slot that is claimed but not committed */
+    atomic_store(&s_test_buffer[2].commit, 0);
+    TEST_ASSERT_EQUAL(3, consumer_next_span(&consumer, &a, &na, &b, &nb, 64));
+    TEST_ASSERT_EQUAL(1, na);
+    TEST_ASSERT_EQUAL(2, nb);
+    TEST_ASSERT_TRUE(consumer_commit(&consumer, 3));
+    TEST_ASSERT_EQUAL(0, consumer_next_span(&consumer, &a, &na, &b, &nb, 64));
+}
+
+void test_stream_consumer_span_overwritten(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    best_effort_consumer_t consumer;
+    best_effort_consumer_init(&consumer, &s_stream, 0);
+    for (size_t i = 0; i < 8; i++) {
+        stream_push_raw(&s_stream, STREAM_SAMPLE_EMPTY);
+    }
+
+    const stream_slot_t *a;
+    const stream_slot_t *b;
+    size_t na;
+    size_t nb;
+    TEST_ASSERT_EQUAL(8, best_effort_consumer_next_span(&consumer, &a, &na, &b, &nb, 64));
+
+    /* Producer laps the span while it is being processed */
+    for (size_t i = 0; i < TEST_BUFFER_SIZE; i++) {
+        stream_push_raw(&s_stream, STREAM_SAMPLE_EMPTY);
+    }
+    TEST_ASSERT_FALSE(best_effort_consumer_commit(&consumer, 8));
+    TEST_ASSERT_EQUAL(1, best_effort_consumer_overwritten(&consumer));
+    TEST_ASSERT_EQUAL(TEST_BUFFER_SIZE, best_effort_consumer_dropped(&consumer));
+    TEST_ASSERT_EQUAL(0, best_effort_consumer_lag(&consumer));
+}
+
+void test_stream_silence_extended(void) {
+    /* Counts above 16 bits survive the round trip */
+    stream_sample_t m = sample_silence(70000);
+    TEST_ASSERT_TRUE(sample_is_silence(&m));
+    TEST_ASSERT_EQUAL(0, m.local_key);
+    TEST_ASSERT_EQUAL(70000, sample_silence_ticks(&m));
+
+    m = sample_silence(SAMPLE_SILENCE_MAX_TICKS);
+    TEST_ASSERT_EQUAL(SAMPLE_SILENCE_MAX_TICKS, sample_silence_ticks(&m));
+
+    /* Lane bits do not disturb the count */
+    m = sample_with_lane(sample_silence(0x12345678U), STREAM_LANE_REMOTE);
+    TEST_ASSERT_EQUAL(0x12345678U, sample_silence_ticks(&m));
+
+    /* 100000 idle ticks flush as one marker */
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_sample_t down = STREAM_SAMPLE_EMPTY;
+    down.local_key = 1;
+    for (uint32_t i = 0; i < 100000U; i++) {
+        stream_push(&s_stream, STREAM_SAMPLE_EMPTY);
+    }
+    stream_push(&s_stream, down);
+    TEST_ASSERT_EQUAL(2, stream_write_position(&s_stream));
+
+    stream_sample_t s;
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 0, &s));
+    TEST_ASSERT_EQUAL(100000U, sample_silence_ticks(&s));
+}
+
+void test_stream_silence_chained(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    /* Idle run about to fill a marker */
+    atomic_store(&s_stream.local.idle_ticks, SAMPLE_SILENCE_MAX_TICKS - 1U);
+    stream_push(&s_stream, STREAM_SAMPLE_EMPTY);
+    TEST_ASSERT_EQUAL(1, stream_write_position(&s_stream));
+
+    stream_push(&s_stream, STREAM_SAMPLE_EMPTY);
+    stream_push(&s_stream, STREAM_SAMPLE_EMPTY);
+    stream_flush(&s_stream);
+    TEST_ASSERT_EQUAL(2, stream_write_position(&s_stream));
+
+    /* Consumers sum the chain to recover the full idle time */
+    stream_sample_t s;
+    uint64_t total = 0;
+    for (size_t i = 0; i < 2; i++) {
+        TEST_ASSERT_TRUE(stream_read(&s_stream, i, &s));
+        TEST_ASSERT_TRUE(sample_is_silence(&s));
+        total += sample_silence_ticks(&s);
+    }
+    TEST_ASSERT_TRUE(total == (uint64_t)SAMPLE_SILENCE_MAX_TICKS + 2U);
+}
+
+void test_stream_skip_ticks(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    stream_sample_t down = STREAM_SAMPLE_EMPTY;
+    down.local_key = 1;
+
+    /* 3 pushed idle ticks, 5000 slept through, then a press */
+    for (int i = 0; i < 3; i++) {
+        stream_push(&s_stream, STREAM_SAMPLE_EMPTY);
+    }
+    stream_skip(&s_stream, 5000);
+    TEST_ASSERT_EQUAL(0, stream_write_position(&s_stream));
+    TEST_ASSERT_EQUAL_UINT32(5003, stream_pending_idle_ticks(&s_stream));
+    stream_push(&s_stream, down);
+
+    /* One marker covers the whole gap; the press lands on tick 5003 */
+    stream_sample_t s;
+    TEST_ASSERT_EQUAL(2, stream_write_position(&s_stream));
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 0, &s));
+    TEST_ASSERT_TRUE(sample_is_silence(&s));
+    TEST_ASSERT_EQUAL_UINT32(5003, sample_silence_ticks(&s));
+    size_t idx;
+    uint64_t tick;
+    stream_read_anchor(&s_stream, &idx, &tick);
+    TEST_ASSERT_EQUAL(1, idx);
+    TEST_ASSERT_TRUE(tick == 5003);
+
+    /* A skip that overfills a marker chains it */
+    atomic_store(&s_stream.local.idle_ticks, SAMPLE_SILENCE_MAX_TICKS - 10U);
+    stream_skip(&s_stream, 25);
+    TEST_ASSERT_EQUAL(3, stream_write_position(&s_stream));
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 2, &s));
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_SILENCE_MAX_TICKS, sample_silence_ticks(&s));
+    TEST_ASSERT_EQUAL_UINT32(15, stream_pending_idle_ticks(&s_stream));
+}
+
+void test_timed_consumer_ticks(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_set_tick_period_us(&s_stream, 100);
+    stream_set_epoch_us(&s_stream, 1000000);
+
+    timed_consumer_t tc;
+    timed_consumer_init(&tc, &s_stream, 0);
+
+    stream_sample_t up = STREAM_SAMPLE_EMPTY;
+    stream_sample_t down = STREAM_SAMPLE_EMPTY;
+    down.local_key = 1;
+
+    /* Ticks 0-4 idle, 5 down, 6-7 held, 8 up */
+    for (int i = 0; i < 5; i++) {
+        stream_push(&s_stream, up);
+    }
+    stream_push(&s_stream, down);
+    stream_push(&s_stream, down);
+    stream_push(&s_stream, down);
+    stream_push(&s_stream, up);
+
+    stream_sample_t s;
+    uint64_t tick;
+    TEST_ASSERT_TRUE(timed_consumer_next(&tc, &s, &tick));
+    TEST_ASSERT_TRUE(sample_is_silence(&s));
+    TEST_ASSERT_TRUE(tick == 0);
+
+    TEST_ASSERT_TRUE(timed_consumer_next(&tc, &s, &tick));
+    TEST_ASSERT_EQUAL(1, s.local_key);
+    TEST_ASSERT_TRUE(tick == 5);
+    TEST_ASSERT_TRUE(timed_consumer_time_us(&tc, tick) == 1000500);
+
+    TEST_ASSERT_TRUE(timed_consumer_next(&tc, &s, &tick));
+    TEST_ASSERT_TRUE(sample_is_silence(&s));
+    TEST_ASSERT_TRUE(tick == 6);
+
+    TEST_ASSERT_TRUE(timed_consumer_next(&tc, &s, &tick));
+    TEST_ASSERT_EQUAL(0, s.local_key);
+    TEST_ASSERT_TRUE(tick == 8);
+    TEST_ASSERT_FALSE(timed_consumer_next(&tc, &s, &tick));
+}
+
+void test_timed_consumer_late_join_and_skip(void) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+
+    stream_sample_t sample = STREAM_SAMPLE_EMPTY;
+
+    /* 3 idle ticks, then alternate level every tick for 20 ticks */
+    for (int i = 0; i < 3; i++) {
+        stream_push(&s_stream, sample);
+    }
+    for (int i = 0; i < 20; i++) {
+        sample.local_key = (uint8_t)((i & 1) == 0);
+        stream_push(&s_stream, sample);
+    }
+
+    /* Joins at the latest LOCAL slot (tick 22), not at tick 0 */
+    timed_consumer_t tc;
+    timed_consumer_init(&tc, &s_stream, 0);
+    stream_sample_t s;
+    uint64_t tick;
+    TEST_ASSERT_TRUE(timed_consumer_next(&tc, &s, &tick));
+    TEST_ASSERT_TRUE(tick == 22);
+    TEST_ASSERT_FALSE(timed_consumer_next(&tc, &s, &tick));
+
+    /* Fall a full lap behind: the skip re-anchors instead of miscounting */
+    for (int i = 0; i < TEST_BUFFER_SIZE + 10; i++) {
+        sample.local_key = (uint8_t)(sample.local_key ^ 1U);
+        stream_push(&s_stream, sample);
+    }
+    TEST_ASSERT_TRUE(timed_consumer_next(&tc, &s, &tick));
+    TEST_ASSERT_TRUE(tick == 23 + TEST_BUFFER_SIZE + 10 - 1);
+    TEST_ASSERT_EQUAL(1, tc.resyncs);
+}
+
+void test_stream_remote_event_tick(void) {
+    /* The play tick survives the round trip, including above 32 bits */
+    stream_sample_t e = sample_remote_event(true, 0x123456789ULL);
+    TEST_ASSERT_EQUAL(STREAM_LANE_REMOTE, sample_lane(&e));
+    TEST_ASSERT_FALSE(sample_is_silence(&e));
+    TEST_ASSERT_EQUAL(1, e.local_key);
+    TEST_ASSERT_EQUAL(0x23456789U, sample_event_tick32(&e));
+    TEST_ASSERT_EQUAL(0x123456789ULL,
+                      sample_resolve_tick(0x123456000ULL, sample_event_tick32(&e)));
+
+    /* Resolves slightly behind the reference and across a 32-bit wrap */
+    TEST_ASSERT_EQUAL(0xFFFFFFF0ULL, sample_resolve_tick(0x100000010ULL, 0xFFFFFFF0U));
+    TEST_ASSERT_EQUAL(0x100000010ULL, sample_resolve_tick(0xFFFFFFF0ULL, 0x00000010U));
+}
+
+void test_hard_rt_skips_remote_lane(void) {
+    static fault_state_t fault;
+    stream_producer_t remote;
+    hard_rt_consumer_t rt;
+    stream_sample_t out;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_producer_init(&remote, &s_stream, STREAM_LANE_REMOTE);
+    fault_init(&fault);
+    hard_rt_consumer_init(&rt, &s_stream, &fault, 2 + HARD_RT_MAX_FOREIGN_PER_TICK);
+
+    stream_producer_push(&remote, sample_remote_event(true, 5));
+    stream_push_raw(&s_stream, STREAM_SAMPLE_EMPTY);
+
+    /* The REMOTE slot is stepped over: only the LOCAL sample comes out */
+    TEST_ASSERT_EQUAL(HARD_RT_OK, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_EQUAL(STREAM_LANE_LOCAL, sample_lane(&out));
+    TEST_ASSERT_EQUAL(0, out.local_key);
+    TEST_ASSERT_EQUAL(1, rt.remote_key);
+
+    /* A lone REMOTE slot never yields a sample, but still updates the monitor */
+    stream_producer_push(&remote, sample_remote_event(false, 9));
+    TEST_ASSERT_EQUAL(HARD_RT_NO_DATA, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_EQUAL(0, rt.remote_key);
+    TEST_ASSERT_FALSE(fault_is_active(&fault));
+}
+
+static void push_local(size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        stream_push_raw(&s_stream, STREAM_SAMPLE_EMPTY);
+    }
+}
+
+void test_hard_rt_recovers_after_clean_ticks(void) {
+    static fault_state_t fault;
+    hard_rt_consumer_t rt;
+    stream_sample_t out;
+    const hard_rt_recovery_t policy = { .clean_ticks = 3, .latch_after = 3, .latch_window = 100 };
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    fault_init(&fault);
+    hard_rt_consumer_init(&rt, &s_stream, &fault, 2);
+    hard_rt_consumer_set_recovery(&rt, &policy);
+
+    push_local(4);
+    TEST_ASSERT_EQUAL(HARD_RT_FAULT, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_EQUAL(FAULT_LATENCY_EXCEEDED, fault_get_code(&fault));
+
+    /* Silent while clean ticks accumulate; what arrives meanwhile is dropped */
+    TEST_ASSERT_EQUAL(HARD_RT_FAULT, hard_rt_consumer_tick(&rt, &out));
+    push_local(1);
+    TEST_ASSERT_EQUAL(HARD_RT_FAULT, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_EQUAL(HARD_RT_RECOVERED, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_FALSE(fault_is_active(&fault));
+    TEST_ASSERT_EQUAL(1, rt.recoveries);
+    TEST_ASSERT_EQUAL(0, hard_rt_consumer_lag(&rt));
+
+    push_local(1);
+    TEST_ASSERT_EQUAL(HARD_RT_OK, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_FALSE(hard_rt_consumer_latched(&rt));
+}
+
+void test_hard_rt_latches_repeated_faults(void) {
+    static fault_state_t fault;
+    hard_rt_consumer_t rt;
+    stream_sample_t out;
+    const hard_rt_recovery_t policy = { .clean_ticks = 1, .latch_after = 2, .latch_window = 10 };
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    fault_init(&fault);
+    hard_rt_consumer_init(&rt, &s_stream, &fault, 2);
+    hard_rt_consumer_set_recovery(&rt, &policy);
+
+    /* A second fault after the window closed starts a new count */
+    push_local(4);
+    TEST_ASSERT_EQUAL(HARD_RT_FAULT, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_EQUAL(HARD_RT_RECOVERED, hard_rt_consumer_tick(&rt, &out));
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(HARD_RT_NO_DATA, hard_rt_consumer_tick(&rt, &out));
+    }
+    push_local(4);
+    TEST_ASSERT_EQUAL(HARD_RT_FAULT, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_EQUAL(HARD_RT_RECOVERED, hard_rt_consumer_tick(&rt, &out));
+
+    /* Two within the window latch */
+    push_local(4);
+    TEST_ASSERT_EQUAL(HARD_RT_FAULT, hard_rt_consumer_tick(&rt, &out));
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL(HARD_RT_FAULT, hard_rt_consumer_tick(&rt, &out));
+    }
+    TEST_ASSERT_TRUE(hard_rt_consumer_latched(&rt));
+    TEST_ASSERT_EQUAL(2, rt.recoveries);
+
+    /* Cleared elsewhere: resumes from the head */
+    push_local(4);
+    fault_clear(&fault);
+    TEST_ASSERT_EQUAL(HARD_RT_NO_DATA, hard_rt_consumer_tick(&rt, &out));
+    TEST_ASSERT_FALSE(hard_rt_consumer_latched(&rt));
+    push_local(1);
+    TEST_ASSERT_EQUAL(HARD_RT_OK, hard_rt_consumer_tick(&rt, &out));
+}
+
+/* History archive: 4 hot rings of PSRAM tier behind the 64-slot hot ring */
+#define TEST_ARCHIVE_SIZE 256
+static stream_slot_t s_archive_buffer[TEST_ARCHIVE_SIZE];
+static stream_archive_t s_archive;
+
+static void push_numbered(size_t from, size_t count) {
+    for (size_t i = from; i < from + count; i++) {
+        stream_sample_t s = STREAM_SAMPLE_EMPTY;
+        s.audio_level = (uint8_t)i;
+        s.config_gen = (uint16_t)i;
+        stream_push_raw(&s_stream, s);
+    }
+}
+
+void test_stream_archive_spill_and_read(void) {
+    stream_consumer_t c;
+    stream_sample_t out;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_attach_archive(&s_stream, &s_archive, s_archive_buffer, TEST_ARCHIVE_SIZE);
+    consumer_init_at(&c, &s_stream, 0);
+
+    push_numbered(0, 40);
+    TEST_ASSERT_EQUAL(40, stream_archive_spill(&s_stream, SIZE_MAX));
+    TEST_ASSERT_EQUAL(0, stream_archive_spill(&s_stream, SIZE_MAX));
+    push_numbered(40, 60);
+    TEST_ASSERT_EQUAL(60, stream_archive_spill(&s_stream, SIZE_MAX));
+    TEST_ASSERT_EQUAL_UINT32(100, s_archive.spilled);
+
+    /* Index 0 left the hot ring: hard-RT sees overrun, history reads still work */
+    TEST_ASSERT_TRUE(stream_is_overrun(&s_stream, 0));
+    TEST_ASSERT_FALSE(consumer_is_overrun(&c));
+    TEST_ASSERT_EQUAL(0, stream_oldest_position(&s_stream));
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(0, out.config_gen);
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(1, out.config_gen);
+
+    /* Spans come from the archive until the consumer is back in the hot ring */
+    const stream_slot_t *a, *b;
+    size_t na, nb;
+    size_t n = consumer_next_span(&c, &a, &na, &b, &nb, 16);
+    TEST_ASSERT_EQUAL(16, n);
+    TEST_ASSERT_EQUAL(STREAM_TIER_ARCHIVE, c.span_tier);
+    TEST_ASSERT_EQUAL(2, a[0].sample.config_gen);
+    TEST_ASSERT_TRUE(consumer_commit(&c, n));
+
+    consumer_init_at(&c, &s_stream, 90);
+    n = consumer_next_span(&c, &a, &na, &b, &nb, 16);
+    TEST_ASSERT_EQUAL(10, n);
+    TEST_ASSERT_EQUAL(STREAM_TIER_HOT, c.span_tier);
+    TEST_ASSERT_EQUAL(90, a[0].sample.config_gen);
+}
+
+void test_stream_archive_wrap_and_resync(void) {
+    stream_consumer_t c;
+    stream_sample_t out;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_attach_archive(&s_stream, &s_archive, s_archive_buffer, TEST_ARCHIVE_SIZE);
+    for (size_t i = 0; i < 300; i += 50) {
+        push_numbered(i, 50);
+        stream_archive_spill(&s_stream, SIZE_MAX);
+    }
+
+    /* The archive itself laps: oldest is one archive capacity behind */
+    TEST_ASSERT_EQUAL(300 - TEST_ARCHIVE_SIZE, stream_oldest_position(&s_stream));
+    TEST_ASSERT_FALSE(stream_read(&s_stream, 43, &out));
+    consumer_init_at(&c, &s_stream, 43);
+    TEST_ASSERT_TRUE(consumer_is_overrun(&c));
+    consumer_resync(&c);
+    TEST_ASSERT_EQUAL(44, c.read_idx);
+    TEST_ASSERT_FALSE(consumer_is_overrun(&c));
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(44, out.config_gen);
+
+    /* Archive spans split at the end of the archive ring */
+    const stream_slot_t *a, *b;
+    size_t na, nb;
+    stream_tier_t tier;
+    TEST_ASSERT_EQUAL(30, stream_read_tiered_span(&s_stream, 230, 30, &a, &na, &b, &nb, &tier));
+    TEST_ASSERT_EQUAL(STREAM_TIER_ARCHIVE, tier);
+    TEST_ASSERT_EQUAL(26, na);
+    TEST_ASSERT_EQUAL(4, nb);
+    TEST_ASSERT_EQUAL(230, a[0].sample.config_gen);
+    TEST_ASSERT_EQUAL(256, b[0].sample.config_gen);
+    TEST_ASSERT_TRUE(stream_tier_intact(&s_stream, 230, tier));
+
+    /* Spilling far enough reclaims slots under a reader's archive span */
+    push_numbered(300, 50);
+    stream_archive_spill(&s_stream, SIZE_MAX);
+    TEST_ASSERT_FALSE(stream_tier_intact(&s_stream, 60, STREAM_TIER_ARCHIVE));
+}
+
+void test_stream_archive_spill_gap(void) {
+    stream_sample_t out;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_attach_archive(&s_stream, &s_archive, s_archive_buffer, TEST_ARCHIVE_SIZE);
+    push_numbered(0, 10);
+    stream_archive_spill(&s_stream, SIZE_MAX);
+
+    /* Spill fell a whole hot ring behind: history is not contiguous any more */
+    push_numbered(10, 100);
+    TEST_ASSERT_EQUAL(110 - TEST_BUFFER_SIZE, stream_oldest_position(&s_stream));
+    TEST_ASSERT_EQUAL(TEST_BUFFER_SIZE, stream_archive_spill(&s_stream, SIZE_MAX));
+    TEST_ASSERT_EQUAL_UINT32(1, s_archive.gaps);
+    TEST_ASSERT_EQUAL(110 - TEST_BUFFER_SIZE, stream_oldest_position(&s_stream));
+
+    /* Samples from the lost stretch are gone */
+    TEST_ASSERT_FALSE(stream_read(&s_stream, 20, &out));
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 46, &out));
+    TEST_ASSERT_EQUAL(46, out.config_gen);
+}
+
+void test_sample_compact_roundtrip(void) {
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    s.gpio = GPIO_BOTH;
+    s.local_key = 1;
+    s.audio_level = 255;
+    s.flags = FLAG_GPIO_EDGE | FLAG_LOCAL_EDGE | FLAG_TX_START;
+    s.config_gen = 7;
+    s = sample_with_lane(s, STREAM_LANE_TEXT);
+
+    stream_sample_t d = sample_compact_decode(sample_compact_encode(&s));
+    TEST_ASSERT_EQUAL_HEX8(GPIO_DIT_BIT | GPIO_DAH_BIT, d.gpio.bits);
+    TEST_ASSERT_EQUAL(1, d.local_key);
+    TEST_ASSERT_EQUAL(255, d.audio_level);
+    TEST_ASSERT_EQUAL_HEX8(s.flags, d.flags);
+    TEST_ASSERT_EQUAL(0, d.config_gen);  /* Not kept */
+
+    /* Audio level keeps its top 5 bits */
+    s.audio_level = 100;
+    d = sample_compact_decode(sample_compact_encode(&s));
+    TEST_ASSERT_EQUAL(100 & 0xF8, d.audio_level & 0xF8);
+
+    /* Short silences are exact, long ones round to 1024 ticks */
+    s = sample_with_lane(sample_silence(4095), STREAM_LANE_TEXT);
+    d = sample_compact_decode(sample_compact_encode(&s));
+    TEST_ASSERT_TRUE(sample_is_silence(&d));
+    TEST_ASSERT_EQUAL(STREAM_LANE_TEXT, sample_lane(&d));
+    TEST_ASSERT_EQUAL(4095, sample_silence_ticks(&d));
+    s = sample_silence(100000);
+    d = sample_compact_decode(sample_compact_encode(&s));
+    TEST_ASSERT_EQUAL(98U * 1024U, sample_silence_ticks(&d));
+    s = sample_silence(SAMPLE_SILENCE_MAX_TICKS);
+    d = sample_compact_decode(sample_compact_encode(&s));
+    TEST_ASSERT_EQUAL(4095U * 1024U, sample_silence_ticks(&d));
+
+    /* REMOTE events resolve near the reference tick */
+    s = sample_remote_event(true, 123456);
+    d = sample_compact_decode(sample_compact_encode(&s));
+    TEST_ASSERT_EQUAL(STREAM_LANE_REMOTE, sample_lane(&d));
+    TEST_ASSERT_EQUAL(1, d.local_key);
+    TEST_ASSERT_EQUAL(123456, sample_resolve_tick(123000, sample_event_tick32(&d) |
+                                                  (123000U & ~0xFFFU)));
+
+    /* Unwrapped against the reader's LOCAL tick, on either side of it */
+    s = sample_remote_event(true, 1000500);
+    d = sample_compact_decode(sample_compact_encode(&s));
+    TEST_ASSERT_EQUAL_UINT32(1000500U & 0xFFFU, sample_event_tick32(&d));
+    d = sample_compact_decode_at(sample_compact_encode(&s), 1000000);
+    TEST_ASSERT_EQUAL(STREAM_LANE_REMOTE, sample_lane(&d));
+    TEST_ASSERT_EQUAL(1, d.local_key);
+    TEST_ASSERT_EQUAL_UINT32(1000500, sample_event_tick32(&d));
+    d = sample_compact_decode_at(sample_compact_encode(&s), 1002000);
+    TEST_ASSERT_EQUAL_UINT32(1000500, sample_event_tick32(&d));
+    s = sample_remote_event(false, 4100);
+    d = sample_compact_decode_at(sample_compact_encode(&s), 4090);
+    TEST_ASSERT_EQUAL(0, d.local_key);
+    TEST_ASSERT_EQUAL_UINT32(4100, sample_event_tick32(&d));
+    TEST_ASSERT_EQUAL(4090, sample_compact_resolve_tick(4100, 4090U & 0xFFFU));
+    TEST_ASSERT_EQUAL(4095, sample_compact_resolve_tick(5, 4095));  /* Never below 0 */
+
+    /* Other records ignore the reference */
+    s = sample_silence(100);
+    d = sample_compact_decode_at(sample_compact_encode(&s), 1000000);
+    TEST_ASSERT_EQUAL(100, sample_silence_ticks(&d));
+}
+
+void test_sample_channels(void) {
+    stream_sample_t prev = STREAM_SAMPLE_EMPTY;
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+
+    /* Straight key and secondary paddle are inputs: change and GPIO edge */
+    s.gpio.bits = GPIO_STRAIGHT_BIT;
+    TEST_ASSERT_TRUE(gpio_straight(s.gpio));
+    TEST_ASSERT_FALSE(gpio_is_idle(s.gpio));
+    TEST_ASSERT_TRUE(sample_has_change_from(&s, &prev));
+    TEST_ASSERT_EQUAL_HEX8(FLAG_GPIO_EDGE, sample_with_edges_from(s, &prev).flags);
+
+    s.gpio.bits = GPIO_DIT2_BIT | GPIO_DAH2_BIT;
+    TEST_ASSERT_TRUE(gpio_dit2(s.gpio));
+    TEST_ASSERT_TRUE(gpio_dah2(s.gpio));
+    TEST_ASSERT_FALSE(gpio_dit(s.gpio));
+    TEST_ASSERT_EQUAL_HEX8(FLAG_GPIO_EDGE, sample_with_edges_from(s, &prev).flags);
+
+    /* Remote channel: a change with its own edge flag, not an input */
+    s = sample_with_remote_channel(STREAM_SAMPLE_EMPTY, true);
+    TEST_ASSERT_TRUE(sample_remote_channel(&s));
+    TEST_ASSERT_TRUE(gpio_is_idle(s.gpio));
+    TEST_ASSERT_TRUE(sample_has_change_from(&s, &prev));
+    TEST_ASSERT_EQUAL_HEX8(FLAG_REMOTE_EDGE, sample_with_edges_from(s, &prev).flags);
+    s = sample_with_remote_channel(s, false);
+    TEST_ASSERT_FALSE(sample_has_change_from(&s, &prev));
+
+    /* Held channels compress like any steady sample */
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    s = sample_with_remote_channel(STREAM_SAMPLE_EMPTY, true);
+    s.gpio.bits |= GPIO_STRAIGHT_BIT;
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE(stream_push(&s_stream, s));
+    }
+    TEST_ASSERT_TRUE(stream_push(&s_stream, STREAM_SAMPLE_EMPTY));
+    stream_sample_t out;
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 0, &out));
+    TEST_ASSERT_EQUAL_HEX8(FLAG_GPIO_EDGE | FLAG_REMOTE_EDGE, out.flags);
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 1, &out));
+    TEST_ASSERT_TRUE(sample_is_silence(&out));
+    TEST_ASSERT_EQUAL(9, sample_silence_ticks(&out));
+
+    /* Compact records keep the primary paddle and the remote edge only */
+    s.gpio.bits = GPIO_DIT_BIT | GPIO_DIT2_BIT | SAMPLE_CH_REMOTE;
+    s.flags = FLAG_REMOTE_EDGE;
+    stream_sample_t d = sample_compact_decode(sample_compact_encode(&s));
+    TEST_ASSERT_EQUAL_HEX8(GPIO_DIT_BIT, d.gpio.bits);
+    TEST_ASSERT_EQUAL_HEX8(FLAG_REMOTE_EDGE, d.flags);
+}
+
+void test_stream_compact_archive(void) {
+    static uint32_t words[TEST_ARCHIVE_SIZE / 2];
+    stream_consumer_t c;
+    stream_sample_t out;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_attach_compact_archive(&s_stream, &s_archive, words, TEST_ARCHIVE_SIZE);
+    for (size_t i = 0; i < 300; i += 50) {
+        push_numbered(i, 50);
+        stream_archive_spill(&s_stream, SIZE_MAX);
+    }
+    TEST_ASSERT_EQUAL(300 - TEST_ARCHIVE_SIZE, stream_oldest_position(&s_stream));
+
+    /* Single reads decode the record (audio_level keeps its top 5 bits) */
+    consumer_init_at(&c, &s_stream, 45);
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(45 & 0xF8, out.audio_level & 0xF8);
+    TEST_ASSERT_FALSE(stream_read(&s_stream, 43, &out));
+
+    /* Spans are decoded into the consumer, a window at a time */
+    const stream_slot_t *a, *b;
+    size_t na, nb;
+    size_t total = 0;
+    size_t n;
+    consumer_init_at(&c, &s_stream, 100);
+    while ((n = consumer_next_span(&c, &a, &na, &b, &nb, SIZE_MAX)) > 0 &&
+           c.span_tier == STREAM_TIER_ARCHIVE) {
+        TEST_ASSERT_TRUE(n <= STREAM_CONSUMER_DECODE_SLOTS);
+        TEST_ASSERT_EQUAL((100 + total) & 0xF8, a[0].sample.audio_level & 0xF8);
+        TEST_ASSERT_TRUE(consumer_commit(&c, n));
+        total += n;
+    }
+    TEST_ASSERT_TRUE(100 + total >= 300 - TEST_BUFFER_SIZE);
+    TEST_ASSERT_EQUAL(STREAM_TIER_HOT, c.span_tier);
+
+    /* After a gap only the new run is readable */
+    push_numbered(300, 100);
+    stream_archive_spill(&s_stream, SIZE_MAX);
+    TEST_ASSERT_EQUAL_UINT32(1, s_archive.gaps);
+    TEST_ASSERT_FALSE(stream_read(&s_stream, 290, &out));
+    TEST_ASSERT_EQUAL(400 - TEST_BUFFER_SIZE, stream_oldest_position(&s_stream));
+}
+
+void test_stream_compact_archive_remote_tick(void) {
+    static uint32_t words[TEST_ARCHIVE_SIZE / 2];
+    stream_producer_t remote;
+    stream_slot_t decoded[2];
+    stream_sample_t out;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_attach_compact_archive(&s_stream, &s_archive, words, TEST_ARCHIVE_SIZE);
+    stream_producer_init(&remote, &s_stream, STREAM_LANE_REMOTE);
+
+    /* A REMOTE event far from tick 0, then enough LOCAL to archive it */
+    stream_skip(&s_stream, 1000000);
+    stream_flush(&s_stream);
+    TEST_ASSERT_TRUE(stream_producer_push(&remote, sample_remote_event(true, 1000500)));
+    for (size_t i = 2; i < 2 + 2 * TEST_BUFFER_SIZE; i += 16) {
+        push_numbered(i, 16);
+        stream_archive_spill(&s_stream, SIZE_MAX);
+    }
+    TEST_ASSERT_EQUAL(0, stream_oldest_position(&s_stream));
+
+    /* Without a reference only the low 12 bits survive */
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 1, &out));
+    TEST_ASSERT_EQUAL(STREAM_LANE_REMOTE, sample_lane(&out));
+    TEST_ASSERT_EQUAL_UINT32(1076, sample_event_tick32(&out));
+
+    /* The reader's LOCAL tick puts it back */
+    TEST_ASSERT_EQUAL(STREAM_READ_OK, stream_read_slot_at(&s_stream, 1, 1000000, &out));
+    TEST_ASSERT_EQUAL(1, out.local_key);
+    TEST_ASSERT_EQUAL_UINT32(1000500, sample_event_tick32(&out));
+
+    /* Span decode advances the reference over the LOCAL silence */
+    TEST_ASSERT_EQUAL(2, stream_archive_decode(&s_stream, 0, 0, decoded, 2));
+    TEST_ASSERT_TRUE(sample_is_silence(&decoded[0].sample));
+    TEST_ASSERT_EQUAL(STREAM_LANE_REMOTE, sample_lane(&decoded[1].sample));
+    TEST_ASSERT_EQUAL_UINT32(1000500, sample_event_tick32(&decoded[1].sample));
+}
+
+void test_stream_key_state_checkpoint(void) {
+    stream_consumer_t c;
+    stream_key_state_t st;
+    stream_sample_t out;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    stream_read_key_state(&s_stream, &st);
+    TEST_ASSERT_EQUAL(0, st.idx);
+    TEST_ASSERT_TRUE(gpio_is_idle(st.gpio));
+    TEST_ASSERT_EQUAL(0, st.local_key);
+
+    /* Key down, then held: the held ticks are still pending as silence */
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    s.gpio = gpio_from_paddles(false, true);
+    s.local_key = 1;
+    for (int i = 0; i < 6; i++) {
+        stream_push(&s_stream, s);
+    }
+    consumer_init_with_state(&c, &s_stream, &st);
+    TEST_ASSERT_EQUAL(1, st.idx);
+    TEST_ASSERT_TRUE(st.tick == 1);
+    TEST_ASSERT_TRUE(gpio_dah(st.gpio));
+    TEST_ASSERT_EQUAL(1, st.local_key);
+    TEST_ASSERT_EQUAL(1, consumer_position(&c));
+    TEST_ASSERT_FALSE(consumer_next(&c, &out));
+
+    /* Release: silence marker keeps the state, the edge slot changes it */
+    stream_push(&s_stream, STREAM_SAMPLE_EMPTY);
+    stream_read_key_state(&s_stream, &st);
+    TEST_ASSERT_EQUAL(3, st.idx);
+    TEST_ASSERT_TRUE(st.tick == 7);
+    TEST_ASSERT_TRUE(gpio_is_idle(st.gpio));
+    TEST_ASSERT_EQUAL(0, st.local_key);
+
+    /* The consumer that joined earlier sees exactly those two slots */
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_TRUE(sample_is_silence(&out));
+    TEST_ASSERT_EQUAL(5, sample_silence_ticks(&out));
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(0, out.local_key);
+    TEST_ASSERT_FALSE(consumer_next(&c, &out));
+}
+
+/* Start the stream as if it had already written low32 samples with the
+ * given epoch (for the wrap tests) */
+static void stream_start_at(size_t idx, unsigned epoch) {
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    atomic_store(&s_stream.write_idx, idx);
+    atomic_store(&s_stream.write_epoch, epoch);
+}
+
+void test_stream_position_wrap(void) {
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    stream_sample_t out;
+
+    /* Half lap: the epoch steps when the index crosses 2^31 */
+    stream_start_at(0x7FFFFFFEU, 0);
+    for (int i = 0; i < 4; i++) {
+        s.local_key = (uint8_t)(i & 1);
+        TEST_ASSERT_TRUE(stream_push(&s_stream, s));
+    }
+    TEST_ASSERT_EQUAL(1, atomic_load(&s_stream.write_epoch));
+    TEST_ASSERT_TRUE(stream_write_position_abs(&s_stream) == 0x80000002ULL);
+
+    /* Epoch not yet published by the writer: widened from the index */
+    stream_start_at(0x80000001U, 0);
+    TEST_ASSERT_TRUE(stream_write_position_abs(&s_stream) == 0x80000001ULL);
+    stream_start_at(5, 1);
+    TEST_ASSERT_TRUE(stream_write_position_abs(&s_stream) == 0x100000005ULL);
+
+    /* The index itself wraps (size_t here, 32 bits on target) */
+    stream_start_at((size_t)0 - 5U, 1);
+    for (int i = 0; i < 10; i++) {
+        s.local_key = (uint8_t)(i & 1);
+        TEST_ASSERT_TRUE(stream_push(&s_stream, s));
+    }
+    TEST_ASSERT_EQUAL(5, stream_write_position(&s_stream));
+    TEST_ASSERT_EQUAL(2, atomic_load(&s_stream.write_epoch));
+    TEST_ASSERT_TRUE(stream_write_position_abs(&s_stream) == 0x100000005ULL);
+    TEST_ASSERT_TRUE(stream_position_abs(&s_stream, (size_t)0 - 2U) == 0xFFFFFFFEULL);
+    TEST_ASSERT_EQUAL((size_t)0 - 2U, stream_position_index(&s_stream, 0xFFFFFFFEULL));
+
+    /* History across the wrap reads in order */
+    stream_consumer_t c;
+    consumer_init_at_abs(&c, &s_stream, 0xFFFFFFFBULL);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE(consumer_next(&c, &out));
+        TEST_ASSERT_EQUAL(i & 1, out.local_key);
+    }
+    TEST_ASSERT_FALSE(consumer_next(&c, &out));
+    TEST_ASSERT_TRUE(consumer_position_abs(&c) == 0x100000005ULL);
+
+    /* Oldest position is a full ring back, not clamped at index 0 */
+    consumer_resync(&c);
+    TEST_ASSERT_EQUAL(TEST_BUFFER_SIZE, consumer_lag(&c));
+    TEST_ASSERT_FALSE(consumer_is_overrun(&c));
+
+    /* Checkpoints carry the absolute position */
+    stream_key_state_t st;
+    stream_read_key_state(&s_stream, &st);
+    TEST_ASSERT_EQUAL(5, st.idx);
+    TEST_ASSERT_TRUE(st.pos == 0x100000005ULL);
+}
+
+void test_consumer_scan_until_edge(void) {
+    stream_consumer_t c;
+    stream_sample_t out;
+    uint64_t ticks = 0;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    consumer_init(&c, &s_stream);
+
+    /* Paddle held 5 ticks, key down 8 ticks, key up */
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    s.gpio = gpio_from_paddles(true, false);
+    for (int i = 0; i < 5; i++) {
+        stream_push(&s_stream, s);
+    }
+    s.local_key = 1;
+    for (int i = 0; i < 8; i++) {
+        stream_push(&s_stream, s);
+    }
+    stream_push(&s_stream, STREAM_SAMPLE_EMPTY);
+
+    /* GPIO edge first: nothing before it */
+    TEST_ASSERT_EQUAL(STREAM_SCAN_EDGE, consumer_scan_until_edge(&c, FLAG_GPIO_EDGE, 64, &ticks));
+    TEST_ASSERT_EQUAL(0, ticks);
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_TRUE(gpio_dit(out.gpio));
+
+    /* Key down: the paddle hold (silence marker of 4) is skipped */
+    ticks = 1;
+    TEST_ASSERT_EQUAL(STREAM_SCAN_EDGE, consumer_scan_until_edge(&c, FLAG_LOCAL_EDGE, 64, &ticks));
+    TEST_ASSERT_EQUAL(5, ticks);
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(1, out.local_key);
+    ticks++;
+
+    /* Key up after the 7 held ticks */
+    TEST_ASSERT_EQUAL(STREAM_SCAN_EDGE, consumer_scan_until_edge(&c, FLAG_LOCAL_EDGE, 64, &ticks));
+    TEST_ASSERT_EQUAL(13, ticks);
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(0, out.local_key);
+
+    /* Another lane's edge stops the scan too */
+    stream_producer_t text;
+    stream_producer_init(&text, &s_stream, STREAM_LANE_TEXT);
+    stream_producer_push(&text, s);
+    stream_push(&s_stream, s);
+    ticks = 0;
+    TEST_ASSERT_EQUAL(STREAM_SCAN_EDGE, consumer_scan_until_edge(&c, FLAG_LOCAL_EDGE, 64, &ticks));
+    TEST_ASSERT_EQUAL(0, ticks);
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(STREAM_LANE_TEXT, sample_lane(&out));
+
+    /* Nothing requested: runs to the write position */
+    TEST_ASSERT_EQUAL(STREAM_SCAN_IDLE, consumer_scan_until_edge(&c, 0, 64, &ticks));
+    TEST_ASSERT_EQUAL(1, ticks);
+    TEST_ASSERT_EQUAL(0, consumer_lag(&c));
+}
+
+void test_consumer_next_write_snapshot(void) {
+    stream_consumer_t c;
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    stream_sample_t out;
+
+    stream_init(&s_stream, s_test_buffer, TEST_BUFFER_SIZE);
+    consumer_init(&c, &s_stream);
+    for (int i = 0; i < 10; i++) {
+        s.local_key = (uint8_t)(i & 1);
+        stream_push(&s_stream, s);
+    }
+
+    /* Caught up with the snapshot: reloads and sees the new slots */
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(10, c.write_seen);
+    TEST_ASSERT_TRUE(consumer_next(&c, &out));
+    TEST_ASSERT_EQUAL(1, out.local_key);
+
+    /* Lapped behind a stale snapshot: the tag catches it */
+    for (int i = 0; i < TEST_BUFFER_SIZE; i++) {
+        s.local_key = (uint8_t)(i & 1);
+        stream_push(&s_stream, s);
+    }
+    TEST_ASSERT_FALSE(consumer_next(&c, &out));
+    TEST_ASSERT_TRUE(consumer_is_overrun(&c));
+    TEST_ASSERT_EQUAL(10 + TEST_BUFFER_SIZE, c.write_seen);
+}
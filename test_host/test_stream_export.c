@@ -0,0 +1,159 @@
+/**
+ * @file test_stream_export.c
+ * @brief Unit tests for the .cwk history export
+ */
+
+#include "unity.h"
+#include "stream.h"
+#include "sample.h"
+#include "stream_export.h"
+#include <string.h>
+
+#define TEST_BUFFER_SIZE 64
+#define TEST_ARCHIVE_SIZE 1024
+static stream_slot_t s_buffer[TEST_BUFFER_SIZE];
+static stream_slot_t s_archive_buffer[TEST_ARCHIVE_SIZE];
+static stream_archive_t s_archive;
+static keying_stream_t s_stream;
+static uint8_t s_out[8192];
+
+/* Key toggles every 3 ticks; history spills every 16 ticks */
+static void run_keying(uint32_t ticks) {
+    stream_init(&s_stream, s_buffer, TEST_BUFFER_SIZE);
+    stream_set_tick_period_us(&s_stream, 1000);
+    stream_attach_archive(&s_stream, &s_archive, s_archive_buffer, TEST_ARCHIVE_SIZE);
+
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    for (uint32_t t = 0; t < ticks; t++) {
+        s.local_key = (uint8_t)((t / 3U) & 1U);
+        stream_push(&s_stream, s);
+        if ((t & 15U) == 15U) {
+            stream_archive_spill(&s_stream, 0);
+        }
+    }
+    stream_push(&s_stream, STREAM_SAMPLE_EMPTY);
+    stream_archive_spill(&s_stream, 0);
+}
+
+static size_t export_all(stream_export_t *exp, size_t chunk) {
+    size_t total = 0;
+    size_t n;
+    while ((n = stream_export_read(exp, s_out + total, chunk)) > 0) {
+        total += n;
+        TEST_ASSERT_TRUE(total + chunk <= sizeof(s_out));
+    }
+    return total;
+}
+
+void test_stream_export_recording(void) {
+    run_keying(600);
+
+    stream_export_t exp;
+    stream_export_begin(&exp, &s_stream, 0, 123456);
+    size_t total = export_all(&exp, 512);
+    TEST_ASSERT_FALSE(exp.lost);
+    TEST_ASSERT_EQUAL(stream_export_size(&exp), total);
+
+    cwk_header_t h;
+    memcpy(&h, s_out, sizeof(h));
+    TEST_ASSERT_EQUAL_MEMORY(CWK_MAGIC, h.magic, 4);
+    TEST_ASSERT_EQUAL(CWK_VERSION, h.version);
+    TEST_ASSERT_EQUAL(sizeof(cwk_header_t), h.header_size);
+    TEST_ASSERT_EQUAL(sizeof(stream_sample_t), h.sample_size);
+    TEST_ASSERT_EQUAL_UINT32(1000, h.tick_us);
+    TEST_ASSERT_TRUE(h.captured_us == 123456);
+
+    /* Whole history, both tiers, ending at the last LOCAL slot */
+    stream_key_state_t st;
+    stream_read_key_state(&s_stream, &st);
+    TEST_ASSERT_EQUAL_UINT32(stream_oldest_position(&s_stream), h.first_idx);
+    TEST_ASSERT_EQUAL_UINT32(st.idx - stream_oldest_position(&s_stream), h.sample_count);
+    TEST_ASSERT_TRUE(h.captured_tick == st.tick);
+
+    /* Records are the stream samples; their ticks sum to the epoch gap */
+    uint64_t ticks = 0;
+    for (uint32_t i = 0; i < h.sample_count; i++) {
+        stream_sample_t rec;
+        stream_sample_t ref;
+        memcpy(&rec, s_out + sizeof(h) + i * sizeof(rec), sizeof(rec));
+        TEST_ASSERT_TRUE(stream_read(&s_stream, h.first_idx + i, &ref));
+        TEST_ASSERT_EQUAL_MEMORY(&ref, &rec, sizeof(rec));
+        ticks += sample_is_silence(&rec) ? sample_silence_ticks(&rec) : 1U;
+    }
+    TEST_ASSERT_TRUE(h.first_tick + ticks == h.captured_tick);
+
+    /* Odd chunk sizes produce the same bytes */
+    static uint8_t ref_out[sizeof(s_out)];
+    memcpy(ref_out, s_out, total);
+    stream_export_begin(&exp, &s_stream, 0, 123456);
+    TEST_ASSERT_EQUAL(total, export_all(&exp, 7));
+    TEST_ASSERT_EQUAL_MEMORY(ref_out, s_out, total);
+}
+
+void test_stream_export_window_and_lapped(void) {
+    run_keying(600);
+
+    /* Window: just enough records to cover 30 ticks */
+    stream_export_t exp;
+    stream_export_begin(&exp, &s_stream, 30, 0);
+    TEST_ASSERT_TRUE(exp.header.captured_tick - exp.header.first_tick >= 30);
+    TEST_ASSERT_TRUE(exp.header.captured_tick - exp.header.first_tick < 30 + 6);
+    TEST_ASSERT_TRUE(exp.header.sample_count < 30);
+
+    /* Window longer than history: clamped to the oldest sample */
+    stream_export_begin(&exp, &s_stream, 1000000, 0);
+    TEST_ASSERT_EQUAL_UINT32(stream_oldest_position(&s_stream), exp.header.first_idx);
+
+    /* Producer laps a hot-only snapshot before it is read */
+    stream_init(&s_stream, s_buffer, TEST_BUFFER_SIZE);
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    for (uint32_t t = 0; t < 40; t++) {
+        s.local_key = (uint8_t)(t & 1U);
+        stream_push(&s_stream, s);
+    }
+    stream_export_begin(&exp, &s_stream, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(40, exp.header.sample_count);
+    for (uint32_t t = 0; t < 2 * TEST_BUFFER_SIZE; t++) {
+        s.local_key = (uint8_t)(t & 1U);
+        stream_push(&s_stream, s);
+    }
+    size_t total = export_all(&exp, 512);
+    TEST_ASSERT_TRUE(exp.lost);
+    TEST_ASSERT_EQUAL(sizeof(cwk_header_t), total);
+}
+
+void test_stream_export_net_clock(void) {
+    run_keying(600);
+
+    /* Not synced: no network clock in the recording */
+    stream_net_time_t clock;
+    TEST_ASSERT_FALSE(stream_read_net_clock(&s_stream, &clock));
+    TEST_ASSERT_EQUAL_UINT32(0, clock.updates);
+    stream_export_t exp;
+    stream_export_begin(&exp, &s_stream, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, exp.header.flags);
+
+    /* Tick 500 at network time 9000 s, network clock 100 ppm fast */
+    stream_set_net_clock(&s_stream, 500, 9000000000LL, 100);
+    TEST_ASSERT_TRUE(stream_read_net_clock(&s_stream, &clock));
+    TEST_ASSERT_EQUAL_UINT32(1, clock.updates);
+    TEST_ASSERT_EQUAL_INT64(9000000000LL + 1000000 + 100, stream_net_time_us(&clock, 1500, 1000));
+    TEST_ASSERT_EQUAL_INT64(9000000000LL - 100000 - 10, stream_net_time_us(&clock, 400, 1000));
+
+    /* The recording carries it to its first tick */
+    stream_export_begin(&exp, &s_stream, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(CWK_FLAG_NET_CLOCK, exp.header.flags);
+    TEST_ASSERT_EQUAL_INT32(100, exp.header.net_drift_ppm);
+    TEST_ASSERT_EQUAL_INT64(stream_net_time_us(&clock, exp.header.first_tick, 1000),
+                            exp.header.net_first_us);
+
+    /* A new estimate is a new mapping; withdrawn, exports go without */
+    stream_set_net_clock(&s_stream, 600, 9000100000LL, 0);
+    TEST_ASSERT_TRUE(stream_read_net_clock(&s_stream, &clock));
+    TEST_ASSERT_EQUAL_UINT32(2, clock.updates);
+    stream_clear_net_clock(&s_stream);
+    TEST_ASSERT_FALSE(stream_read_net_clock(&s_stream, &clock));
+    stream_export_begin(&exp, &s_stream, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, exp.header.flags);
+    TEST_ASSERT_EQUAL_INT64(0, exp.header.net_first_us);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file test_stream_handoff.c
+ * @brief Tests for the foreign lane handoff
+ */
+
+#include "unity.h"
+#include "stream_handoff.h"
+#include "consumer.h"
+#include "remote_tx.h"
+
+#define TEST_BUFFER_SIZE 64
+static stream_slot_t s_buffer[TEST_BUFFER_SIZE];
+static keying_stream_t s_stream;
+static stream_handoffs_t s_table;
+static stream_handoff_t s_cwnet;
+static stream_handoff_t s_espnow;
+
+static void setup(void) {
+    stream_init(&s_stream, s_buffer, TEST_BUFFER_SIZE);
+    stream_handoffs_init(&s_table);
+    stream_handoff_init(&s_cwnet, &s_stream, STREAM_LANE_REMOTE);
+    stream_handoff_init(&s_espnow, &s_stream, STREAM_LANE_REMOTE);
+}
+
+void test_stream_handoff_put_drain(void) {
+    setup();
+
+    /* Handed over, not written: the hot ring is untouched until the drain */
+    TEST_ASSERT_TRUE(stream_handoff_put(&s_cwnet, sample_remote_event(true, 10)));
+    TEST_ASSERT_TRUE(stream_handoff_put(&s_cwnet, sample_remote_event(false, 20)));
+    TEST_ASSERT_EQUAL(0, stream_write_position(&s_stream));
+    TEST_ASSERT_EQUAL(2, stream_handoff_pending(&s_cwnet));
+
+    TEST_ASSERT_EQUAL(2, stream_handoff_drain(&s_cwnet, 8));
+    TEST_ASSERT_EQUAL(0, stream_handoff_pending(&s_cwnet));
+    TEST_ASSERT_EQUAL(2, stream_write_position(&s_stream));
+
+    stream_sample_t s;
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 0, &s));
+    TEST_ASSERT_EQUAL(STREAM_LANE_REMOTE, sample_lane(&s));
+    TEST_ASSERT_EQUAL(1, s.local_key);
+    TEST_ASSERT_EQUAL_UINT32(10, sample_event_tick32(&s));
+    TEST_ASSERT_TRUE(stream_read(&s_stream, 1, &s));
+    TEST_ASSERT_EQUAL(0, s.local_key);
+    TEST_ASSERT_EQUAL_UINT32(20, sample_event_tick32(&s));
+
+    /* A full ring refuses and counts, keeping what it holds */
+    for (uint32_t i = 0; i < STREAM_HANDOFF_SIZE; i++) {
+        TEST_ASSERT_TRUE(stream_handoff_put(&s_cwnet, sample_remote_event((i & 1U) == 0, 30 + i)));
+    }
+    TEST_ASSERT_FALSE(stream_handoff_put(&s_cwnet, sample_remote_event(true, 999)));
+    TEST_ASSERT_EQUAL_UINT32(1, atomic_load(&s_cwnet.dropped));
+    TEST_ASSERT_EQUAL(STREAM_HANDOFF_SIZE, stream_handoff_pending(&s_cwnet));
+}
+
+void test_stream_handoffs_budget(void) {
+    setup();
+    TEST_ASSERT_TRUE(stream_handoffs_attach(&s_table, &s_cwnet));
+    TEST_ASSERT_TRUE(stream_handoffs_attach(&s_table, &s_espnow));
+    TEST_ASSERT_FALSE(stream_handoffs_pending(&s_table));
+    TEST_ASSERT_EQUAL(0, stream_handoffs_drain(&s_table, 8));
+
+    for (uint32_t i = 0; i < 6; i++) {
+        (void)stream_handoff_put(&s_cwnet, sample_remote_event((i & 1U) == 0, i));
+        (void)stream_handoff_put(&s_espnow, sample_remote_event((i & 1U) == 0, 100 + i));
+    }
+    TEST_ASSERT_TRUE(stream_handoffs_pending(&s_table));
+
+    /* At most max per call across all handoffs; the rest waits */
+    TEST_ASSERT_EQUAL(8, stream_handoffs_drain(&s_table, 8));
+    TEST_ASSERT_EQUAL(8, stream_write_position(&s_stream));
+    TEST_ASSERT_EQUAL(4, stream_handoffs_drain(&s_table, 8));
+    TEST_ASSERT_FALSE(stream_handoffs_pending(&s_table));
+
+    /* The table is fixed size */
+    static stream_handoff_t extra[STREAM_HANDOFF_MAX];
+    size_t attached = 2;
+    for (size_t i = 0; i < STREAM_HANDOFF_MAX; i++) {
+        attached += stream_handoffs_attach(&s_table, &extra[i]) ? 1U : 0U;
+    }
+    TEST_ASSERT_EQUAL(STREAM_HANDOFF_MAX, attached);
+}
+
+void test_stream_handoff_never_stalls_hard_rt(void) {
+    static fault_state_t fault;
+    static remote_tx_t remote;
+    hard_rt_consumer_t rt;
+    stream_sample_t out;
+
+    setup();
+    TEST_ASSERT_TRUE(stream_handoffs_attach(&s_table, &s_cwnet));
+    fault_init(&fault);
+    remote_tx_init(&remote, 0);
+    hard_rt_consumer_init(&rt, &s_stream, &fault, 2 + HARD_RT_MAX_FOREIGN_PER_TICK);
+    hard_rt_consumer_set_remote(&rt, &remote);
+
+    /* A burst larger than one tick's budget, handed over between ticks
+     * (the Core 1 task may be preempted anywhere: nothing it does is in
+     * the ring yet) */
+    const uint32_t burst = 3U * HARD_RT_MAX_FOREIGN_PER_TICK;
+    for (uint32_t i = 0; i < burst; i++) {
+        TEST_ASSERT_TRUE(stream_handoff_put(&s_cwnet, sample_remote_event((i & 1U) == 0, 1000 + i)));
+    }
+
+    /* RT ticks: drain, push LOCAL, consume. Never starved, never faulted */
+    for (int tick = 0; tick < 10; tick++) {
+        (void)stream_handoffs_drain(&s_table, HARD_RT_MAX_FOREIGN_PER_TICK);
+        stream_sample_t local = STREAM_SAMPLE_EMPTY;
+        local.audio_level = (uint8_t)tick;
+        stream_push_raw(&s_stream, local);
+        TEST_ASSERT_EQUAL(HARD_RT_OK, hard_rt_consumer_tick(&rt, &out));
+        TEST_ASSERT_EQUAL(STREAM_LANE_LOCAL, sample_lane(&out));
+        TEST_ASSERT_EQUAL(tick, out.audio_level);
+        TEST_ASSERT_EQUAL(0, hard_rt_consumer_lag(&rt));
+    }
+    TEST_ASSERT_FALSE(fault_is_active(&fault));
+
+    /* Every handed-over event reached the playout queue (capped by its depth) */
+    remote_tx_stats_t st;
+    remote_tx_get(&remote, &st);
+    TEST_ASSERT_EQUAL_UINT32(burst, st.events + st.overflow);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file test_stream_index.c
+ * @brief Unit tests for the stream time index and consumer_seek_time()
+ */
+
+#include "unity.h"
+#include "stream.h"
+#include "sample.h"
+#include "key_edge.h"
+#include "stream_index.h"
+#include "stubs/esp_stubs.h"
+
+#define TEST_BUFFER_SIZE 64
+#define TEST_ARCHIVE_SIZE 4096
+static stream_slot_t s_buffer[TEST_BUFFER_SIZE];
+static stream_slot_t s_archive_buffer[TEST_ARCHIVE_SIZE];
+static stream_archive_t s_archive;
+static keying_stream_t s_stream;
+static key_edge_ring_t s_ring;
+static key_edge_stage_t s_stage;
+static stream_index_t s_index;
+
+/* Key toggles every 3 ticks; the stage and spill run every 16 ticks */
+static void run_keying(uint32_t ticks, bool archive) {
+    stream_init(&s_stream, s_buffer, TEST_BUFFER_SIZE);
+    stream_set_tick_period_us(&s_stream, 1000);
+    if (archive) {
+        stream_attach_archive(&s_stream, &s_archive, s_archive_buffer, TEST_ARCHIVE_SIZE);
+    }
+    key_edge_ring_init(&s_ring, &s_stream);
+    key_edge_stage_init(&s_stage, &s_stream, &s_ring);
+    stream_index_init(&s_index, &s_stream);
+    key_edge_stage_attach_index(&s_stage, &s_index);
+
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    for (uint32_t t = 0; t < ticks; t++) {
+        s.local_key = (uint8_t)((t / 3U) & 1U);
+        stream_push(&s_stream, s);
+        if ((t & 15U) == 15U) {
+            key_edge_stage_run(&s_stage);
+            stream_archive_spill(&s_stream, SIZE_MAX);
+        }
+    }
+    key_edge_stage_run(&s_stage);
+    stream_archive_spill(&s_stream, SIZE_MAX);
+}
+
+/* Reference: linear walk from index 0 */
+static size_t linear_seek(uint64_t tick, uint64_t *start) {
+    stream_sample_t s;
+    uint64_t at = 0;
+    size_t idx = 0;
+    while (stream_read(&s_stream, idx, &s)) {
+        uint64_t len = sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+        if (at + len > tick) {
+            break;
+        }
+        at += len;
+        idx++;
+    }
+    *start = at;
+    return idx;
+}
+
+void test_stream_index_checkpoints(void) {
+    stream_checkpoint_t cp;
+
+    run_keying(3000, true);
+
+    /* 1000 key edges: one checkpoint per 16 edges, well within 1 s each */
+    size_t count = stream_index_count(&s_index);
+    TEST_ASSERT_TRUE(count >= 1000 / STREAM_INDEX_EVERY_EDGES);
+    TEST_ASSERT_TRUE(count <= 1000 / STREAM_INDEX_EVERY_EDGES + 2);
+
+    TEST_ASSERT_TRUE(stream_index_find(&s_index, 0, &cp));
+    TEST_ASSERT_EQUAL(0, cp.tick);
+    TEST_ASSERT_TRUE(stream_index_find(&s_index, 2000, &cp));
+    TEST_ASSERT_TRUE(cp.tick <= 2000);
+    TEST_ASSERT_TRUE(2000 - cp.tick < 3 * STREAM_INDEX_EVERY_EDGES);
+}
+
+void test_consumer_seek_time_matches_linear_scan(void) {
+    stream_consumer_t c;
+    uint64_t start;
+    uint64_t ref_start;
+
+    run_keying(3000, true);
+    consumer_init(&c, &s_stream);
+
+    const uint64_t targets[] = {0, 1, 2, 3, 1234, 1999, 2500, 2999};
+    for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+        TEST_ASSERT_TRUE(consumer_seek_time(&c, &s_index, targets[i], &start));
+        TEST_ASSERT_EQUAL(linear_seek(targets[i], &ref_start), consumer_position(&c));
+        TEST_ASSERT_EQUAL(ref_start, start);
+        TEST_ASSERT_TRUE(start <= targets[i]);
+    }
+
+    /* Ahead of the stream: parked at the write position */
+    TEST_ASSERT_TRUE(consumer_seek_time(&c, &s_index, 1000000, &start));
+    TEST_ASSERT_EQUAL(stream_write_position(&s_stream), consumer_position(&c));
+}
+
+void test_consumer_seek_time_out_of_history(void) {
+    stream_consumer_t c;
+    uint64_t start;
+
+    /* Hot ring only: early ticks are gone, the consumer stays put */
+    run_keying(3000, false);
+    consumer_init_at(&c, &s_stream, 7);
+    TEST_ASSERT_FALSE(consumer_seek_time(&c, &s_index, 10, &start));
+    TEST_ASSERT_EQUAL(7, consumer_position(&c));
+
+    /* Recent ticks still in the hot ring are found */
+    TEST_ASSERT_TRUE(consumer_seek_time(&c, &s_index, 2990, &start));
+    TEST_ASSERT_TRUE(start <= 2990 && 2990 - start < 3);
+}
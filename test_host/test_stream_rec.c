@@ -0,0 +1,406 @@
+/**
+ * @file test_stream_rec.c
+ * @brief Unit tests for the flash keying log (stream_rec.h)
+ */
+
+#include "unity.h"
+#include "sample.h"
+#include "stream_rec.h"
+#include <string.h>
+
+/* 16 sectors of NOR flash in RAM: writes only clear bits */
+#define TEST_CHUNKS 16U
+static uint8_t s_flash[TEST_CHUNKS * STREAM_REC_CHUNK_BYTES];
+static int64_t s_now_us;
+static uint32_t s_us_per_byte;
+
+static bool flash_read(void *ctx, size_t offset, void *buf, size_t len) {
+    (void)ctx;
+    memcpy(buf, &s_flash[offset], len);
+    return true;
+}
+
+static bool flash_write(void *ctx, size_t offset, const void *buf, size_t len) {
+    (void)ctx;
+    const uint8_t *p = (const uint8_t *)buf;
+    for (size_t i = 0; i < len; i++) {
+        s_flash[offset + i] &= p[i];
+    }
+    s_now_us += (int64_t)(len * s_us_per_byte);
+    return true;
+}
+
+static bool flash_erase(void *ctx, size_t offset) {
+    (void)ctx;
+    memset(&s_flash[offset], 0xFF, STREAM_REC_CHUNK_BYTES);
+    s_now_us += 40000;
+    return true;
+}
+
+static int64_t flash_now(void *ctx) {
+    (void)ctx;
+    return s_now_us;
+}
+
+static const stream_rec_flash_t k_flash = {
+    .read = flash_read,
+    .write = flash_write,
+    .erase = flash_erase,
+    .now_us = flash_now,
+    .chunks = TEST_CHUNKS,
+};
+
+static stream_rec_log_t s_log;
+static stream_rec_chunk_t s_chunk;
+
+static void flash_reset(void) {
+    memset(s_flash, 0xFF, sizeof(s_flash));
+    s_now_us = 0;
+    s_us_per_byte = 1;
+}
+
+/* Chunk of n records: key toggles every 5 ticks as 1-tick samples and silences */
+static void fill_chunk(uint32_t session, uint64_t tick, size_t n) {
+    stream_rec_chunk_begin(&s_chunk, session, 1000, tick, 0);
+    for (size_t i = 0; i < n; i++) {
+        stream_sample_t s;
+        if ((i & 1U) == 0U) {
+            s = STREAM_SAMPLE_EMPTY;
+            s.local_key = (uint8_t)((i >> 1) & 1U);
+            s.flags = FLAG_LOCAL_EDGE;
+            TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, tick));
+            tick += 1;
+        } else {
+            s = sample_silence(4);
+            TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, tick));
+            tick += 4;
+        }
+    }
+}
+
+/* Erase if needed, then write the chunk through to its header */
+static void write_chunk(void) {
+    if (stream_rec_erased_ahead(&s_log) == 0) {
+        TEST_ASSERT_TRUE(stream_rec_erase_next(&s_log));
+    }
+    TEST_ASSERT_TRUE(stream_rec_write_begin(&s_log, &s_chunk));
+    stream_rec_step_t step;
+    int calls = 0;
+    while ((step = stream_rec_write_step(&s_log)) == STREAM_REC_STEP_MORE) {
+        calls++;
+        TEST_ASSERT_LESS_THAN(64, calls);
+    }
+    TEST_ASSERT_EQUAL(STREAM_REC_STEP_DONE, step);
+}
+
+void test_stream_rec_chunk_fill_and_check(void) {
+    fill_chunk(1, 100, 10);
+    TEST_ASSERT_EQUAL_UINT16(10, s_chunk.header.count);
+    TEST_ASSERT_EQUAL_UINT64(100, s_chunk.header.first_tick);
+    TEST_ASSERT_EQUAL_UINT64(125, s_chunk.header.end_tick);
+
+    /* A REMOTE sample adds a record but no LOCAL time */
+    stream_sample_t r = sample_remote_event(true, 5000);
+    TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &r, 125));
+    TEST_ASSERT_EQUAL_UINT64(125, s_chunk.header.end_tick);
+
+    /* Full at STREAM_REC_RECORDS */
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    while (s_chunk.header.count < STREAM_REC_RECORDS) {
+        TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, s_chunk.header.end_tick));
+    }
+    TEST_ASSERT_FALSE(stream_rec_chunk_add(&s_chunk, &s, s_chunk.header.end_tick));
+
+    /* Sealed by write_begin; any changed record fails the CRC */
+    flash_reset();
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    TEST_ASSERT_TRUE(stream_rec_erase_next(&s_log));
+    TEST_ASSERT_TRUE(stream_rec_write_begin(&s_log, &s_chunk));
+    TEST_ASSERT_TRUE(stream_rec_chunk_check(&s_chunk));
+    s_chunk.records[7] ^= 1U;
+    TEST_ASSERT_FALSE(stream_rec_chunk_check(&s_chunk));
+}
+
+void test_stream_rec_mount_rebuilds_sessions(void) {
+    flash_reset();
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    TEST_ASSERT_EQUAL_UINT32(0, s_log.head_seq);
+    TEST_ASSERT_EQUAL(0, s_log.session_count);
+
+    /* Session 1: two chunks, session 2: one */
+    uint32_t a = stream_rec_new_session(&s_log);
+    fill_chunk(a, 0, 100);
+    write_chunk();
+    fill_chunk(a, 250, 100);
+    write_chunk();
+    uint32_t b = stream_rec_new_session(&s_log);
+    fill_chunk(b, 10000, 40);
+    write_chunk();
+    TEST_ASSERT_EQUAL(2, s_log.session_count);
+    TEST_ASSERT_EQUAL_UINT32(2, s_log.sessions[0].chunks);
+    TEST_ASSERT_EQUAL_UINT64(500, s_log.sessions[0].end_tick);
+
+    /* Cut a fourth chunk short after its first slice: it never existed */
+    fill_chunk(b, 10100, 1000);
+    TEST_ASSERT_TRUE(stream_rec_erase_next(&s_log));
+    TEST_ASSERT_TRUE(stream_rec_write_begin(&s_log, &s_chunk));
+    TEST_ASSERT_EQUAL(STREAM_REC_STEP_MORE, stream_rec_write_step(&s_log));
+
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    TEST_ASSERT_EQUAL_UINT32(3, s_log.head_seq);
+    TEST_ASSERT_EQUAL_UINT32(0, stream_rec_erased_ahead(&s_log));
+    TEST_ASSERT_EQUAL(2, s_log.session_count);
+    TEST_ASSERT_EQUAL_UINT32(a, s_log.sessions[0].id);
+    TEST_ASSERT_EQUAL_UINT32(2, s_log.sessions[0].chunks);
+    TEST_ASSERT_EQUAL_UINT64(0, s_log.sessions[0].first_tick);
+    TEST_ASSERT_EQUAL_UINT64(500, s_log.sessions[0].end_tick);
+    TEST_ASSERT_EQUAL_UINT32(b, s_log.sessions[1].id);
+    TEST_ASSERT_EQUAL_UINT32(b + 1U, stream_rec_new_session(&s_log));
+
+    /* The torn sector is erased again before use */
+    fill_chunk(b, 10100, 40);
+    TEST_ASSERT_FALSE(stream_rec_write_begin(&s_log, &s_chunk));
+    write_chunk();
+    TEST_ASSERT_EQUAL_UINT32(2, s_log.sessions[1].chunks);
+}
+
+void test_stream_rec_wraps_and_drops_oldest(void) {
+    flash_reset();
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+
+    /* 10 sessions of 3 chunks: 30 chunks through 16 sectors */
+    uint64_t tick = 0;
+    for (int i = 0; i < 10; i++) {
+        uint32_t id = stream_rec_new_session(&s_log);
+        for (int c = 0; c < 3; c++) {
+            fill_chunk(id, tick, 64);
+            tick = s_chunk.header.end_tick;
+            write_chunk();
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(30, s_log.head_seq);
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNKS - stream_rec_erased_ahead(&s_log),
+                             stream_rec_used(&s_log));
+
+    /* Keep the erase-ahead full: the oldest chunks leave the index */
+    while (stream_rec_erase_next(&s_log)) {
+    }
+    TEST_ASSERT_EQUAL_UINT32(STREAM_REC_ERASE_AHEAD, stream_rec_erased_ahead(&s_log));
+    uint32_t oldest = s_log.head_seq + STREAM_REC_ERASE_AHEAD - TEST_CHUNKS;
+    TEST_ASSERT_EQUAL_UINT32(oldest, s_log.sessions[0].first_seq);
+    TEST_ASSERT_EQUAL_UINT32(3U - oldest % 3U, s_log.sessions[0].chunks);
+    TEST_ASSERT_EQUAL_UINT32(oldest / 3U + 1U, s_log.sessions[0].id);
+    TEST_ASSERT_NULL(stream_rec_find_session(&s_log, 1));
+
+    /* The first tick of a trimmed session is that of its oldest chunk */
+    stream_rec_header_t h;
+    TEST_ASSERT_TRUE(flash_read(NULL, (oldest % TEST_CHUNKS) * STREAM_REC_CHUNK_BYTES,
+                                &h, sizeof(h)));
+    TEST_ASSERT_EQUAL_UINT64(h.first_tick, s_log.sessions[0].first_tick);
+
+    /* Mount finds the same sessions */
+    stream_rec_session_t before[STREAM_REC_MAX_SESSIONS];
+    size_t count = s_log.session_count;
+    memcpy(before, s_log.sessions, sizeof(before));
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    TEST_ASSERT_EQUAL(count, s_log.session_count);
+    TEST_ASSERT_EQUAL_MEMORY(before, s_log.sessions, count * sizeof(before[0]));
+    TEST_ASSERT_EQUAL_UINT32(11, stream_rec_new_session(&s_log));
+}
+
+void test_stream_rec_pacer_bounds_write_calls(void) {
+    stream_rec_pacer_t p;
+    stream_rec_pacer_init(&p, 1000);
+    TEST_ASSERT_EQUAL_UINT32(1024, p.slice);
+
+    /* 2us per byte: the first slice (960 B after the header) and 512 B overrun, 256 B fits */
+    flash_reset();
+    s_us_per_byte = 2;
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    fill_chunk(1, 0, STREAM_REC_RECORDS);
+    write_chunk();
+    TEST_ASSERT_EQUAL_UINT32(STREAM_REC_PAGE_BYTES, s_log.pacer.slice);
+    TEST_ASSERT_EQUAL_UINT32(2, s_log.pacer.over);
+    TEST_ASSERT_EQUAL_UINT32(1920, s_log.pacer.worst_us);
+
+    /* A faster flash lets the slice grow back, never past a sector */
+    for (int i = 0; i < 8; i++) {
+        stream_rec_pacer_record(&s_log.pacer, s_log.pacer.slice, 100);
+    }
+    TEST_ASSERT_EQUAL_UINT32(STREAM_REC_CHUNK_BYTES, s_log.pacer.slice);
+
+    /* Short writes (the header) say nothing about the rate */
+    stream_rec_pacer_init(&p, 1000);
+    stream_rec_pacer_record(&p, sizeof(stream_rec_header_t), 10);
+    TEST_ASSERT_EQUAL_UINT32(1024, p.slice);
+}
+
+/* Export a whole session into buf, small reads */
+static size_t export_all(stream_rec_export_t *exp, uint8_t *buf, size_t cap) {
+    size_t total = 0;
+    size_t n;
+    while ((n = stream_rec_export_read(exp, buf + total, (cap - total) < 100 ? cap - total : 100)) > 0) {
+        total += n;
+    }
+    return total;
+}
+
+void test_stream_rec_export_session(void) {
+    static uint8_t buf[sizeof(cwk_header_t) + 400 * sizeof(stream_sample_t)];
+
+    flash_reset();
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    uint32_t id = stream_rec_new_session(&s_log);
+    fill_chunk(id, 1000, 100);
+    write_chunk();
+    /* The recorder lost 300 ticks between the two chunks */
+    fill_chunk(id, s_chunk.header.end_tick + 300, 100);
+    write_chunk();
+    uint64_t end_tick = s_chunk.header.end_tick;
+
+    stream_rec_export_t exp;
+    TEST_ASSERT_FALSE(stream_rec_export_begin(&exp, &s_log, id + 1U));
+    TEST_ASSERT_TRUE(stream_rec_export_begin(&exp, &s_log, id));
+    TEST_ASSERT_EQUAL_UINT32(201, exp.header.sample_count);
+    TEST_ASSERT_EQUAL_UINT64(1000, exp.header.first_tick);
+    TEST_ASSERT_EQUAL_UINT64(end_tick, exp.header.captured_tick);
+    TEST_ASSERT_EQUAL_UINT64((end_tick - 1000) * 1000U, exp.header.captured_us);
+
+    size_t total = export_all(&exp, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(stream_rec_export_size(&exp), total);
+    TEST_ASSERT_FALSE(exp.lost);
+    TEST_ASSERT_EQUAL_UINT32(0, exp.corrupt);
+
+    /* LOCAL ticks sum to the recorded span; record 100 is the gap marker */
+    uint64_t ticks = 0;
+    for (size_t i = 0; i < exp.header.sample_count; i++) {
+        stream_sample_t s;
+        memcpy(&s, &buf[sizeof(cwk_header_t) + i * sizeof(s)], sizeof(s));
+        if (i == 100) {
+            TEST_ASSERT_TRUE(sample_is_silence(&s));
+            TEST_ASSERT_EQUAL_UINT32(300, sample_silence_ticks(&s));
+        }
+        ticks += sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+    }
+    TEST_ASSERT_EQUAL_UINT64(end_tick - 1000, ticks);
+
+    /* A record changed in flash is reported, one chunk */
+    s_flash[sizeof(stream_rec_header_t) + 11] &= 0x7FU;   /* Silence bit of record 5 */
+    TEST_ASSERT_TRUE(stream_rec_export_begin(&exp, &s_log, id));
+    (void)export_all(&exp, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_UINT32(1, exp.corrupt);
+
+    /* An export the writer laps stops short */
+    TEST_ASSERT_TRUE(stream_rec_export_begin(&exp, &s_log, id));
+    TEST_ASSERT_GREATER_THAN(0, stream_rec_export_read(&exp, buf, 100));
+    memset(&s_flash[STREAM_REC_CHUNK_BYTES], 0xFF, STREAM_REC_CHUNK_BYTES);
+    (void)export_all(&exp, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(exp.lost);
+}
+
+void test_stream_rec_export_remote_and_long_silence(void) {
+    static uint8_t buf[sizeof(cwk_header_t) + 16 * sizeof(stream_sample_t)];
+
+    flash_reset();
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    uint32_t id = stream_rec_new_session(&s_log);
+    uint64_t tick = 1000000;
+    stream_rec_chunk_begin(&s_chunk, id, 1000, tick, 0);
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    s.local_key = 1;
+    s.flags = FLAG_LOCAL_EDGE;
+    TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, tick++));
+    /* Past the scaled range: stored as exact chained records */
+    s = sample_silence(6143);
+    TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, tick));
+    TEST_ASSERT_EQUAL_UINT32(3, s_chunk.header.count);
+    tick += 6143;
+    s = sample_remote_event(true, tick + 500);
+    TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, tick));
+    s = STREAM_SAMPLE_EMPTY;
+    s.flags = FLAG_LOCAL_EDGE;
+    TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, tick++));
+    TEST_ASSERT_EQUAL_UINT64(tick, s_chunk.header.end_tick);
+    write_chunk();
+
+    stream_rec_export_t exp;
+    TEST_ASSERT_TRUE(stream_rec_export_begin(&exp, &s_log, id));
+    size_t total = export_all(&exp, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(stream_rec_export_size(&exp), total);
+    TEST_ASSERT_EQUAL_UINT32(0, exp.corrupt);
+
+    /* Exact silence, and the REMOTE tick against the session's LOCAL ticks */
+    uint64_t ticks = 0;
+    uint32_t silence = 0;
+    bool remote = false;
+    for (size_t i = 0; i < exp.header.sample_count; i++) {
+        memcpy(&s, &buf[sizeof(cwk_header_t) + i * sizeof(s)], sizeof(s));
+        if (sample_lane(&s) == STREAM_LANE_REMOTE) {
+            TEST_ASSERT_EQUAL_UINT32((uint32_t)(1000000 + 1 + 6143 + 500), sample_event_tick32(&s));
+            remote = true;
+            continue;
+        }
+        if (sample_is_silence(&s)) {
+            silence += sample_silence_ticks(&s);
+        }
+        ticks += sample_is_silence(&s) ? sample_silence_ticks(&s) : 1U;
+    }
+    TEST_ASSERT_TRUE(remote);
+    TEST_ASSERT_EQUAL_UINT32(6143, silence);
+    TEST_ASSERT_EQUAL_UINT64(exp.header.captured_tick - exp.header.first_tick, ticks);
+
+    /* A silence the chunk cannot hold spills its rest into the next one */
+    fill_chunk(id, tick, STREAM_REC_RECORDS - 1U);
+    tick = s_chunk.header.end_tick;
+    s = sample_silence(5000);
+    TEST_ASSERT_FALSE(stream_rec_chunk_add(&s_chunk, &s, tick));
+    TEST_ASSERT_EQUAL_UINT64(tick + COMPACT_COUNT_MASK, s_chunk.header.end_tick);
+    stream_rec_chunk_begin(&s_chunk, id, 1000, s_chunk.header.end_tick, 0);
+    TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, tick));
+    TEST_ASSERT_EQUAL_UINT32(1, s_chunk.header.count);
+    TEST_ASSERT_EQUAL_UINT64(tick + 5000, s_chunk.header.end_tick);
+
+    /* A key sample retried on a chunk begun past it moves the start back */
+    stream_rec_chunk_begin(&s_chunk, id, 1000, tick + 1, 2000000);
+    s = STREAM_SAMPLE_EMPTY;
+    TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, tick));
+    TEST_ASSERT_EQUAL_UINT64(tick, s_chunk.header.first_tick);
+    TEST_ASSERT_EQUAL_UINT64(tick + 1, s_chunk.header.end_tick);
+    TEST_ASSERT_EQUAL_INT64(2000000 - 1000, s_chunk.header.unix_us);
+}
+
+void test_stream_rec_export_net_clock(void) {
+    flash_reset();
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    uint32_t id = stream_rec_new_session(&s_log);
+
+    /* Synced only from the second chunk on */
+    fill_chunk(id, 1000, 100);
+    TEST_ASSERT_EQUAL_UINT32(0, s_chunk.header.flags);
+    write_chunk();
+    uint64_t second = s_chunk.header.end_tick;
+    stream_rec_chunk_begin(&s_chunk, id, 1000, second, 0);
+    const stream_net_time_t clock = {
+        .ref_tick = second + 50, .net_us = 7000000000LL, .drift_ppm = 0, .updates = 3,
+    };
+    stream_rec_chunk_set_net_clock(&s_chunk, &clock);
+    TEST_ASSERT_EQUAL_UINT32(STREAM_REC_FLAG_NET_CLOCK, s_chunk.header.flags);
+    TEST_ASSERT_EQUAL_INT64(7000000000LL - 50000, s_chunk.header.net_us);
+    stream_sample_t s = STREAM_SAMPLE_EMPTY;
+    TEST_ASSERT_TRUE(stream_rec_chunk_add(&s_chunk, &s, second));
+    write_chunk();
+
+    /* Survives a mount; the export carries it back to the session's first tick */
+    TEST_ASSERT_TRUE(stream_rec_mount(&s_log, &k_flash, 1000));
+    stream_rec_export_t exp;
+    TEST_ASSERT_TRUE(stream_rec_export_begin(&exp, &s_log, id));
+    TEST_ASSERT_EQUAL_UINT32(CWK_FLAG_NET_CLOCK, exp.header.flags);
+    TEST_ASSERT_EQUAL_INT64(7000000000LL - (int64_t)(second + 50 - 1000) * 1000,
+                            exp.header.net_first_us);
+
+    /* An unsynced clock leaves a chunk clear */
+    const stream_net_time_t none = {0};
+    fill_chunk(id, 5000, 1);
+    stream_rec_chunk_set_net_clock(&s_chunk, &none);
+    TEST_ASSERT_EQUAL_UINT32(0, s_chunk.header.flags);
+}
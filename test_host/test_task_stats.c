@@ -0,0 +1,83 @@
+/**
+ * @file test_task_stats.c
+ * @brief Tests for the per-task CPU and stack history
+ */
+
+#include "unity.h"
+#include "task_stats.h"
+
+static task_stats_t s_ts;
+static task_stats_sample_t s_out[TASK_STATS_HISTORY];
+
+static const uint32_t k_idle[TASK_STATS_CORES] = { 1, 2 };
+
+void test_task_stats_cpu_shares(void) {
+    task_stats_init(&s_ts);
+
+    task_stats_input_t in[3] = {
+        { .id = 1, .name = "IDLE0", .core = 0, .runtime = 0, .stack_free = 900 },
+        { .id = 2, .name = "IDLE1", .core = 1, .runtime = 0, .stack_free = 900 },
+        { .id = 7, .name = "rt_task", .core = 0, .runtime = 0, .stack_free = 70000 },
+    };
+
+    /* First call primes the counters: no sample yet */
+    task_stats_record(&s_ts, 1, 1000000, in, 3, k_idle);
+    TEST_ASSERT_EQUAL_UINT32(0, task_stats_head(&s_ts));
+
+    /* One second: rt_task 25% of core 0, core 1 half idle */
+    in[0].runtime = 750000;
+    in[1].runtime = 500000;
+    in[2].runtime = 250000;
+    task_stats_record(&s_ts, 2, 2000000, in, 3, k_idle);
+    TEST_ASSERT_EQUAL_UINT32(1, task_stats_head(&s_ts));
+
+    TEST_ASSERT_EQUAL_size_t(1, task_stats_read(&s_ts, 0, s_out, TASK_STATS_HISTORY));
+    TEST_ASSERT_EQUAL_UINT32(2, s_out[0].time_s);
+    TEST_ASSERT_EQUAL_UINT16(750, s_out[0].idle_pm[0]);
+    TEST_ASSERT_EQUAL_UINT16(500, s_out[0].idle_pm[1]);
+    TEST_ASSERT_EQUAL_UINT16(250, s_out[0].cpu_pm[2]);
+    TEST_ASSERT_EQUAL_UINT16(65534, s_out[0].stack_free[2]);    /* Clamped */
+    TEST_ASSERT_EQUAL_UINT16(TASK_STATS_ABSENT, s_out[0].cpu_pm[3]);
+
+    task_stats_task_t tasks[TASK_STATS_MAX_TASKS];
+    TEST_ASSERT_EQUAL_size_t(3, task_stats_tasks(&s_ts, tasks, TASK_STATS_MAX_TASKS));
+    TEST_ASSERT_EQUAL_STRING("rt_task", tasks[2].name);
+    TEST_ASSERT_EQUAL_UINT8(0, tasks[2].core);
+
+    /* Counters wrap: deltas still right; a new task shows 0 until its second sample */
+    in[0].runtime = 750000U + 900000U;
+    in[1].runtime = 500000U + 1000000U;
+    in[2].runtime = 250000U + 100000U;
+    task_stats_input_t more[4] = { in[0], in[1], in[2],
+        { .id = 9, .name = "httpd", .core = TASK_STATS_CORE_ANY, .runtime = 5, .stack_free = 1200 } };
+    task_stats_record(&s_ts, 3, 2000000U + 1000000U, more, 4, k_idle);
+    TEST_ASSERT_EQUAL_size_t(1, task_stats_read(&s_ts, 1, s_out, TASK_STATS_HISTORY));
+    TEST_ASSERT_EQUAL_UINT16(900, s_out[0].idle_pm[0]);
+    TEST_ASSERT_EQUAL_UINT16(1000, s_out[0].idle_pm[1]);
+    TEST_ASSERT_EQUAL_UINT16(100, s_out[0].cpu_pm[2]);
+    TEST_ASSERT_EQUAL_UINT16(0, s_out[0].cpu_pm[3]);
+    TEST_ASSERT_EQUAL_UINT16(1200, s_out[0].stack_free[3]);
+}
+
+void test_task_stats_history_ring(void) {
+    task_stats_init(&s_ts);
+    task_stats_input_t in = { .id = 5, .name = "net", .core = 1, .runtime = 0, .stack_free = 100 };
+
+    for (uint32_t t = 0; t <= TASK_STATS_HISTORY + 10U; t++) {
+        in.runtime = t * 1000U;
+        task_stats_record(&s_ts, t, 0xFFFFF000U + t * 10000U, &in, 1, k_idle);
+    }
+    TEST_ASSERT_EQUAL_UINT32(TASK_STATS_HISTORY + 10U, task_stats_head(&s_ts));
+
+    /* Overwritten start: from the oldest retained (the next slot to write is not), in order */
+    size_t n = task_stats_read(&s_ts, 0, s_out, TASK_STATS_HISTORY);
+    TEST_ASSERT_EQUAL_size_t(TASK_STATS_HISTORY - 1U, n);
+    TEST_ASSERT_EQUAL_UINT32(11, s_out[0].seq);
+    TEST_ASSERT_EQUAL_UINT32(TASK_STATS_HISTORY + 9U, s_out[n - 1].seq);
+    TEST_ASSERT_EQUAL_UINT16(100, s_out[n - 1].cpu_pm[0]);
+
+    /* Caught up, and ahead of the head (restart) */
+    TEST_ASSERT_EQUAL_size_t(0, task_stats_read(&s_ts, TASK_STATS_HISTORY + 10U, s_out, 4));
+    TEST_ASSERT_EQUAL_size_t(4, task_stats_read(&s_ts, 100000, s_out, 4));
+    TEST_ASSERT_EQUAL_UINT32(11, s_out[0].seq);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file test_telemetry.c
+ * @brief Tests for the fleet telemetry payloads
+ */
+
+#include "unity.h"
+#include "telemetry.h"
+#include <string.h>
+
+static metrics_t s_metrics;
+static atomic_uint s_faults;
+
+static const metric_desc_t k_descs[] = {
+    { "keyer_faults_total", "RT faults raised", METRIC_COUNTER, NULL, &s_faults },
+};
+
+void test_telemetry_batch_interval(void) {
+    static telemetry_t t;
+    char buf[160];
+
+    telemetry_init(&t);
+    metrics_init(&s_metrics);
+    metrics_register_all(&s_metrics, k_descs, 1);
+    atomic_store(&s_faults, 2U);
+
+    /* First check at once, then one per interval */
+    TEST_ASSERT_TRUE(telemetry_batch_due(&t, 5000000, 30));
+    TEST_ASSERT_FALSE(telemetry_batch_due(&t, 34999999, 30));
+    TEST_ASSERT_TRUE(telemetry_batch_due(&t, 35000000, 30));
+    TEST_ASSERT_FALSE(telemetry_batch_due(&t, 40000000, 30));
+
+    /* Intervals under the minimum are raised to it */
+    TEST_ASSERT_TRUE(telemetry_batch_due(&t, 65000000, 1));
+    TEST_ASSERT_FALSE(telemetry_batch_due(&t, 66000000, 1));
+    TEST_ASSERT_TRUE(telemetry_batch_due(&t, 65000000 + TELEMETRY_INTERVAL_MIN_S * 1000000LL, 1));
+
+    /* A reconnect sends one at once */
+    telemetry_resync(&t);
+    TEST_ASSERT_TRUE(telemetry_batch_due(&t, 71000000, 30));
+
+    const char *expect = "{\"seq\":1,\"up\":71,\"faults_lost\":0,\"m\":{\"faults_total\":2}}";
+    TEST_ASSERT_EQUAL(strlen(expect), telemetry_render_batch(&t, &s_metrics, 71000000,
+                                                              buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING(expect, buf);
+
+    /* Too small: nothing sent, but the number is used (the collector sees the gap) */
+    TEST_ASSERT_EQUAL(0, telemetry_render_batch(&t, &s_metrics, 72000000, buf, 40));
+    telemetry_render_batch(&t, &s_metrics, 73000000, buf, sizeof(buf));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "\"seq\":3,"));
+}
+
+void test_telemetry_faults_once(void) {
+    static telemetry_t t;
+    static fault_log_t log;
+    fault_event_t out[4];
+    char buf[128];
+
+    telemetry_init(&t);
+    fault_log_init(&log);
+
+    /* Raised before the broker was reached: still pending */
+    fault_log_record(&log, 1500000, FAULT_EV_RAISED, FAULT_LATENCY_EXCEEDED, 9);
+    TEST_ASSERT_EQUAL(1, telemetry_take_faults(&t, &log, out, 4));
+    TEST_ASSERT_EQUAL(0, telemetry_take_faults(&t, &log, out, 4));
+    TEST_ASSERT_TRUE(telemetry_render_fault(&out[0], buf, sizeof(buf)) > 0);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"up_ms\":1500,\"event\":\"raised\",\"code\":\"LATENCY_EXCEEDED\",\"data\":9}", buf);
+    TEST_ASSERT_EQUAL(0, telemetry_render_fault(&out[0], buf, 20));
+
+    /* More than the ring between checks: the overwritten ones are counted */
+    for (uint32_t i = 0; i < FAULT_LOG_SIZE + 4; i++) {
+        fault_log_record(&log, 2000000 + i, FAULT_EV_RAISED, FAULT_OVERRUN, i);
+    }
+    size_t taken = 0;
+    size_t n;
+    while ((n = telemetry_take_faults(&t, &log, out, 4)) > 0) {
+        taken += n;
+    }
+    TEST_ASSERT_EQUAL(FAULT_LOG_SIZE - 1, taken);
+    TEST_ASSERT_EQUAL(5, t.faults_lost);
+}
+
+void test_telemetry_link_on_change(void) {
+    static telemetry_t t;
+    char buf[96];
+    telemetry_link_t link = {
+        .wifi = 2, .vpn = 0, .cwnet = 0,
+        .wifi_str = "connected", .vpn_str = "disabled", .cwnet_str = "disabled",
+    };
+
+    telemetry_init(&t);
+    TEST_ASSERT_TRUE(telemetry_link_changed(&t, &link));
+    TEST_ASSERT_FALSE(telemetry_link_changed(&t, &link));
+    link.cwnet = 3;
+    link.cwnet_str = "ready";
+    TEST_ASSERT_TRUE(telemetry_link_changed(&t, &link));
+    TEST_ASSERT_FALSE(telemetry_link_changed(&t, &link));
+
+    /* Republished (retained) after a reconnect */
+    telemetry_resync(&t);
+    TEST_ASSERT_TRUE(telemetry_link_changed(&t, &link));
+
+    TEST_ASSERT_TRUE(telemetry_render_link(&link, buf, sizeof(buf)) > 0);
+    TEST_ASSERT_EQUAL_STRING("{\"wifi\":\"connected\",\"vpn\":\"disabled\",\"cwnet\":\"ready\"}",
+                             buf);
+    TEST_ASSERT_EQUAL(0, telemetry_render_link(&link, buf, 16));
+}
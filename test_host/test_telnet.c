@@ -0,0 +1,65 @@
+/**
+ * @file test_telnet.c
+ * @brief Unit tests for the TCP console telnet filter
+ */
+
+#include "unity.h"
+#include "telnet.h"
+#include <string.h>
+
+static telnet_rx_t s_rx;
+static uint8_t s_buf[64];
+
+static size_t filter(const char *bytes, size_t len) {
+    memcpy(s_buf, bytes, len);
+    return telnet_rx_filter(&s_rx, s_buf, len);
+}
+
+void test_telnet_plain_text_passes(void) {
+    telnet_rx_init(&s_rx);
+    size_t n = filter("show wpm", 8);
+    TEST_ASSERT_EQUAL(8, n);
+    TEST_ASSERT_EQUAL_MEMORY("show wpm", s_buf, 8);
+}
+
+void test_telnet_negotiation_stripped(void) {
+    telnet_rx_init(&s_rx);
+    /* IAC DO ECHO, IAC WONT LINEMODE, IAC NOP, then text */
+    size_t n = filter("\xFF\xFD\x01\xFF\xFC\x22" "\xFF\xF1" "ab", 10);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL_MEMORY("ab", s_buf, 2);
+}
+
+void test_telnet_subnegotiation_stripped(void) {
+    telnet_rx_init(&s_rx);
+    /* IAC SB NAWS 0 80 0 24 IAC SE; a doubled IAC inside is data of the SB */
+    size_t n = filter("x\xFF\xFA\x1F\x00\x50\xFF\xFF\x18\xFF\xF0y", 12);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL_MEMORY("xy", s_buf, 2);
+}
+
+void test_telnet_split_sequence(void) {
+    telnet_rx_init(&s_rx);
+    TEST_ASSERT_EQUAL(1, filter("a\xFF", 2));
+    TEST_ASSERT_EQUAL(0, filter("\xFB", 1));
+    size_t n = filter("\x03" "b", 2);
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL('b', s_buf[0]);
+}
+
+void test_telnet_line_ends_become_one_cr(void) {
+    telnet_rx_init(&s_rx);
+    size_t n = filter("a\r\nb\r\000c\nd\r", 10);
+    TEST_ASSERT_EQUAL(8, n);
+    TEST_ASSERT_EQUAL_MEMORY("a\rb\rc\rd\r", s_buf, 8);
+
+    /* LF of a CR LF split across reads */
+    TEST_ASSERT_EQUAL(0, filter("\n", 1));
+}
+
+void test_telnet_escaped_iac_is_data(void) {
+    telnet_rx_init(&s_rx);
+    size_t n = filter("\xFF\xFF", 2);
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, s_buf[0]);
+}
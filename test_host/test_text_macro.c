@@ -0,0 +1,89 @@
+/**
+ * @file test_text_macro.c
+ * @brief Unit tests for contest macro compilation and expansion
+ */
+
+#include "unity.h"
+#include "text_macro.h"
+#include "morse_table.h"
+#include <string.h>
+
+static text_macro_t s_macro;
+
+static void values(text_macro_values_t *v, uint32_t serial, const char *call) {
+    memset(v, 0, sizeof(*v));
+    v->serial = serial;
+    strcpy(v->call, call);
+    strcpy(v->mycall, "IU3QEZ");
+    strcpy(v->rst, "5NN");
+}
+
+void test_text_macro_compile_tokens(void) {
+    text_macro_compile(&s_macro, "tu {call} <AR>");
+    TEST_ASSERT_EQUAL_UINT32(6, s_macro.len);
+    TEST_ASSERT_EQUAL_UINT32(morse_code_encode('T'), s_macro.tok[0]);
+    TEST_ASSERT_EQUAL_UINT32(morse_code_encode('U'), s_macro.tok[1]);
+    TEST_ASSERT_EQUAL_UINT32(TEXT_MACRO_WORD_GAP, s_macro.tok[2]);
+    TEST_ASSERT_EQUAL_INT(TEXT_MACRO_CALL, text_macro_token_field(s_macro.tok[3]));
+    TEST_ASSERT_TRUE(text_macro_has_field(&s_macro, TEXT_MACRO_CALL));
+    TEST_ASSERT_FALSE(text_macro_has_field(&s_macro, TEXT_MACRO_SERIAL));
+    TEST_ASSERT_EQUAL_INT(-1, text_macro_token_field(s_macro.tok[5]));
+    TEST_ASSERT_EQUAL_INT(-1, text_macro_token_field(TEXT_MACRO_WORD_GAP));
+
+    /* Unknown braces are not fields: the text between them is sent */
+    text_macro_compile(&s_macro, "{X}");
+    TEST_ASSERT_EQUAL_UINT32(1, s_macro.len);
+    TEST_ASSERT_EQUAL_UINT32(morse_code_encode('X'), s_macro.tok[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, s_macro.fields);
+
+    text_macro_compile(&s_macro, NULL);
+    TEST_ASSERT_EQUAL_UINT32(0, s_macro.len);
+}
+
+void test_text_macro_expand_fields(void) {
+    text_macro_values_t v;
+    values(&v, 7, "K1ABC");
+    text_macro_token_t out[TEXT_MACRO_MAX_EXPANDED];
+
+    text_macro_compile(&s_macro, "{RST}{SERIAL}");
+    size_t n = text_macro_expand(&s_macro, &v, out, TEXT_MACRO_MAX_EXPANDED);
+    const char *want = "5NN007";
+    TEST_ASSERT_EQUAL_UINT32(strlen(want), n);
+    for (size_t i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_UINT32(morse_code_encode(want[i]), out[i]);
+    }
+
+    /* Cut at the capacity, never past it */
+    text_macro_compile(&s_macro, "{MYCALL} {CALL}");
+    n = text_macro_expand(&s_macro, &v, out, 4);
+    TEST_ASSERT_EQUAL_UINT32(4, n);
+    TEST_ASSERT_EQUAL_UINT32(morse_code_encode('Q'), out[3]);
+}
+
+void test_text_macro_render_and_fields(void) {
+    text_macro_values_t v;
+    char buf[64];
+    values(&v, 1234, "");
+    text_macro_render("{call} de {MyCall} {serial}", &v, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(" de IU3QEZ 1234", buf);
+    text_macro_render("{SERIAL}", &v, buf, 3);
+    TEST_ASSERT_EQUAL_STRING("12", buf);
+
+    text_macro_set_serial(41);
+    text_macro_next_serial();
+    TEST_ASSERT_TRUE(text_macro_set_field(TEXT_MACRO_CALL, "DL1ABCDEFGHIJKLMNOP"));
+    TEST_ASSERT_TRUE(text_macro_set_field(TEXT_MACRO_RST, "5NN"));
+    TEST_ASSERT_FALSE(text_macro_set_field(TEXT_MACRO_MYCALL, "X"));
+    text_macro_get_values(&v);
+    TEST_ASSERT_EQUAL_UINT32(42, v.serial);
+    TEST_ASSERT_EQUAL_UINT32(TEXT_MACRO_FIELD_LEN - 1, strlen(v.call));
+    TEST_ASSERT_EQUAL_STRING("5NN", v.rst);
+
+    /* Clearing RST goes back to the default report */
+    text_macro_set_field(TEXT_MACRO_RST, NULL);
+    text_macro_set_field(TEXT_MACRO_CALL, "");
+    text_macro_get_values(&v);
+    TEST_ASSERT_EQUAL_STRING("599", v.rst);
+    TEST_ASSERT_EQUAL_STRING("", v.call);
+    text_macro_set_serial(1);
+}
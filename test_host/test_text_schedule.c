@@ -0,0 +1,156 @@
+/**
+ * @file test_text_schedule.c
+ * @brief Unit tests for the text keyer run-length schedule
+ */
+
+#include "unity.h"
+#include "text_schedule.h"
+#include "ptt.h"
+
+static text_schedule_t s_sched;
+
+/** Play until idle, recording the tick of every level change */
+static size_t play_edges(uint32_t tick_us, uint32_t *edges, size_t max_edges) {
+    size_t n = 0;
+    bool level = false;
+    for (uint32_t tick = 0; tick < 100000U; tick++) {
+        bool now = text_schedule_play(&s_sched, tick_us, false);
+        if (now != level && n < max_edges) {
+            edges[n++] = tick;
+        }
+        level = now;
+        if (text_schedule_idle(&s_sched) && !now) {
+            break;
+        }
+    }
+    return n;
+}
+
+void test_text_schedule_tick_accurate(void) {
+    /* 'A' at 30 WPM: dit 40 ms, gap 40 ms, dah 120 ms */
+    text_schedule_init(&s_sched);
+    TEST_ASSERT_TRUE(text_schedule_push(&s_sched, text_run_make(true, 40000, 1)));
+    TEST_ASSERT_TRUE(text_schedule_push(&s_sched, text_run_make(false, 40000, 1)));
+    TEST_ASSERT_TRUE(text_schedule_push(&s_sched, text_run_make(true, 120000, 1)));
+
+    uint32_t edges[8];
+    TEST_ASSERT_EQUAL(4, play_edges(1000, edges, 8));
+    TEST_ASSERT_EQUAL_UINT32(0, edges[0]);
+    TEST_ASSERT_EQUAL_UINT32(40, edges[1]);
+    TEST_ASSERT_EQUAL_UINT32(80, edges[2]);
+    TEST_ASSERT_EQUAL_UINT32(200, edges[3]);
+
+    /* Tick not dividing the runs: edges stay within a tick, no drift */
+    text_schedule_init(&s_sched);
+    for (int i = 0; i < 20; i++) {
+        (void)text_schedule_push(&s_sched, text_run_make((i & 1) == 0, 40000, 0));
+    }
+    uint32_t many[24];
+    TEST_ASSERT_EQUAL(20, play_edges(300, many, 24));
+    for (uint32_t i = 0; i < 20; i++) {
+        uint32_t ideal_us = i * 40000U;
+        TEST_ASSERT_UINT32_WITHIN(300, ideal_us, many[i] * 300U);
+    }
+}
+
+void test_text_schedule_paddle_stop_and_flush(void) {
+    text_schedule_init(&s_sched);
+    (void)text_schedule_push(&s_sched, text_run_make(true, 40000, 1));
+    (void)text_schedule_push(&s_sched, text_run_make(false, 40000, 1));
+
+    TEST_ASSERT_TRUE(text_schedule_play(&s_sched, 1000, false));
+
+    /* Paddle: key up on the same tick, everything queued is dropped */
+    TEST_ASSERT_FALSE(text_schedule_play(&s_sched, 1000, true));
+    TEST_ASSERT_TRUE(text_schedule_stop_pending(&s_sched));
+    TEST_ASSERT_TRUE(text_schedule_idle(&s_sched));
+
+    /* Runs the producer queued before it noticed never play */
+    (void)text_schedule_push(&s_sched, text_run_make(true, 40000, 2));
+    TEST_ASSERT_FALSE(text_schedule_play(&s_sched, 1000, false));
+    (void)text_schedule_push(&s_sched, text_run_make(true, 40000, 3));
+    text_schedule_flush(&s_sched);
+    TEST_ASSERT_FALSE(text_schedule_stop_pending(&s_sched));
+    TEST_ASSERT_FALSE(text_schedule_play(&s_sched, 1000, false));
+    TEST_ASSERT_TRUE(text_schedule_idle(&s_sched));
+
+    /* Next text plays normally, paddle idle */
+    (void)text_schedule_push(&s_sched, text_run_make(true, 2000, 4));
+    TEST_ASSERT_TRUE(text_schedule_play(&s_sched, 1000, false));
+    TEST_ASSERT_EQUAL_UINT32(4, text_schedule_pos(&s_sched));
+    TEST_ASSERT_TRUE(text_schedule_play(&s_sched, 1000, false));
+    TEST_ASSERT_FALSE(text_schedule_play(&s_sched, 1000, false));
+
+    /* Paddle while idle is just keying, not an abort */
+    TEST_ASSERT_FALSE(text_schedule_play(&s_sched, 1000, true));
+    TEST_ASSERT_FALSE(text_schedule_stop_pending(&s_sched));
+}
+
+void test_text_schedule_pause_keeps_run(void) {
+    text_schedule_init(&s_sched);
+    (void)text_schedule_push(&s_sched, text_run_make(true, 5000, 0));
+
+    TEST_ASSERT_TRUE(text_schedule_play(&s_sched, 1000, false));
+    TEST_ASSERT_TRUE(text_schedule_play(&s_sched, 1000, false));
+
+    text_schedule_set_paused(&s_sched, true);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_FALSE(text_schedule_play(&s_sched, 1000, true));  /* No paddle abort either */
+    }
+    TEST_ASSERT_FALSE(text_schedule_stop_pending(&s_sched));
+
+    /* The remaining 3 ms of the run play after resume */
+    text_schedule_set_paused(&s_sched, false);
+    int down = 0;
+    while (text_schedule_play(&s_sched, 1000, false)) {
+        down++;
+    }
+    TEST_ASSERT_EQUAL(3, down);
+    TEST_ASSERT_TRUE(text_schedule_idle(&s_sched));
+}
+
+/** Play with a 30 ms PTT lead; report the PTT-on and first key-down ticks */
+static void play_with_lead(ptt_controller_t *ptt, uint32_t *ptt_tick_out, uint32_t *key_tick) {
+    *ptt_tick_out = UINT32_MAX;
+    *key_tick = UINT32_MAX;
+    for (uint32_t tick = 0; tick < 200U && *key_tick == UINT32_MAX; tick++) {
+        uint64_t now_us = (uint64_t)tick * 1000U;
+        uint32_t until = text_schedule_until_key_us(&s_sched, 30000);
+        text_schedule_hold(&s_sched, !ptt_lead(ptt, now_us, until, 30000));
+        if (ptt_is_on(ptt) && *ptt_tick_out == UINT32_MAX) {
+            *ptt_tick_out = tick;
+        }
+        if (text_schedule_play(&s_sched, 1000, false)) {
+            *key_tick = tick;
+        }
+        ptt_tick(ptt, now_us);
+    }
+}
+
+void test_text_schedule_ptt_lead(void) {
+    ptt_controller_t ptt;
+    uint32_t ptt_at;
+    uint32_t key_at;
+
+    /* Queued 10 ms before its first element: playback waits for the lead */
+    ptt_init(&ptt, 100);
+    text_schedule_init(&s_sched);
+    (void)text_schedule_push(&s_sched, text_run_make(false, 10000, 0));
+    (void)text_schedule_push(&s_sched, text_run_make(true, 40000, 0));
+    play_with_lead(&ptt, &ptt_at, &key_at);
+    TEST_ASSERT_EQUAL_UINT32(0, ptt_at);
+    TEST_ASSERT_EQUAL_UINT32(30, key_at);
+
+    /* Queued well ahead: PTT rises 30 ms before, nothing is delayed */
+    ptt_init(&ptt, 100);
+    text_schedule_init(&s_sched);
+    (void)text_schedule_push(&s_sched, text_run_make(false, 50000, 0));
+    (void)text_schedule_push(&s_sched, text_run_make(true, 120000, 0));
+    play_with_lead(&ptt, &ptt_at, &key_at);
+    TEST_ASSERT_EQUAL_UINT32(20, ptt_at);
+    TEST_ASSERT_EQUAL_UINT32(50, key_at);
+
+    /* Paused text never holds PTT */
+    text_schedule_set_paused(&s_sched, true);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, text_schedule_until_key_us(&s_sched, 30000));
+}
@@ -0,0 +1,92 @@
+/**
+ * @file test_text_typeahead.c
+ * @brief Unit tests for the text keyer type-ahead queue
+ */
+
+#include "unity.h"
+#include "text_typeahead.h"
+#include <string.h>
+
+static text_typeahead_t s_queue;
+
+/** Pop everything ready into buf (NUL-terminated) */
+static size_t pop_all(char *buf, size_t max) {
+    size_t n = 0;
+    char c;
+    while (n + 1 < max && text_typeahead_pop(&s_queue, &c)) {
+        buf[n++] = c;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+void test_text_typeahead_append_in_order(void) {
+    text_typeahead_init(&s_queue);
+    TEST_ASSERT_TRUE(text_typeahead_empty(&s_queue));
+    TEST_ASSERT_FALSE(text_typeahead_append(&s_queue, "", 0));
+
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, "CQ ", 3));
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, "D", 1));
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, "E", 1));
+
+    text_typeahead_status_t st;
+    text_typeahead_get_status(&s_queue, &st);
+    TEST_ASSERT_EQUAL(5, st.queued);
+    TEST_ASSERT_EQUAL(TEXT_TYPEAHEAD_CAPACITY - 5, st.free);
+
+    char buf[16];
+    TEST_ASSERT_EQUAL(5, pop_all(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("CQ DE", buf);
+    TEST_ASSERT_TRUE(text_typeahead_empty(&s_queue));
+}
+
+void test_text_typeahead_full_rejects_whole_append(void) {
+    static char block[TEXT_TYPEAHEAD_CAPACITY];
+    memset(block, 'E', sizeof(block));
+    text_typeahead_init(&s_queue);
+
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, block, TEXT_TYPEAHEAD_CAPACITY - 2));
+    TEST_ASSERT_FALSE(text_typeahead_append(&s_queue, "TTT", 3));  /* All or nothing */
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, "TT", 2));
+
+    text_typeahead_status_t st;
+    text_typeahead_get_status(&s_queue, &st);
+    TEST_ASSERT_EQUAL(TEXT_TYPEAHEAD_CAPACITY, st.queued);
+    TEST_ASSERT_EQUAL(0, st.free);
+    TEST_ASSERT_EQUAL_UINT32(1, st.rejected);
+
+    /* Room comes back as the consumer pops, across the wrap */
+    char c;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(text_typeahead_pop(&s_queue, &c));
+    }
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, "AR", 2));
+    text_typeahead_clear(&s_queue);
+    TEST_ASSERT_TRUE(text_typeahead_empty(&s_queue));
+}
+
+void test_text_typeahead_cancel_last(void) {
+    text_typeahead_init(&s_queue);
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, "CQ CQ", 5));
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, "DE XX", 5));
+
+    /* Backspace twice, then drop what is left of the newest message */
+    TEST_ASSERT_EQUAL(1, text_typeahead_cancel_last(&s_queue, TEXT_TYPEAHEAD_CANCEL_CHAR));
+    TEST_ASSERT_EQUAL(1, text_typeahead_cancel_last(&s_queue, TEXT_TYPEAHEAD_CANCEL_CHAR));
+    TEST_ASSERT_EQUAL(3, text_typeahead_cancel_last(&s_queue, TEXT_TYPEAHEAD_CANCEL_MESSAGE));
+
+    /* Partly popped message: only the part still queued goes */
+    char c;
+    TEST_ASSERT_TRUE(text_typeahead_pop(&s_queue, &c));
+    TEST_ASSERT_EQUAL('C', c);
+    TEST_ASSERT_TRUE(text_typeahead_pop(&s_queue, &c));
+    TEST_ASSERT_EQUAL(3, text_typeahead_cancel_last(&s_queue, TEXT_TYPEAHEAD_CANCEL_MESSAGE));
+    TEST_ASSERT_EQUAL(0, text_typeahead_cancel_last(&s_queue, TEXT_TYPEAHEAD_CANCEL_CHAR));
+
+    /* Cancelled characters are skipped, later text still comes out */
+    TEST_ASSERT_TRUE(text_typeahead_append(&s_queue, "K", 1));
+    char buf[16];
+    TEST_ASSERT_EQUAL(1, pop_all(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("K", buf);
+    TEST_ASSERT_TRUE(text_typeahead_empty(&s_queue));
+}
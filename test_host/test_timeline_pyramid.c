@@ -0,0 +1,112 @@
+/**
+ * @file test_timeline_pyramid.c
+ * @brief Tests for the multi-resolution timeline history
+ */
+
+#include "unity.h"
+#include "timeline_pyramid.h"
+
+static timeline_pyramid_t s_p;
+
+void test_timeline_pyramid_buckets(void) {
+    timeline_pyramid_t *p = &s_p;
+    timeline_range_t it;
+    timeline_column_t col;
+
+    timeline_pyramid_init(p);
+    TEST_ASSERT_EQUAL_UINT32(0, timeline_pyramid_range_begin(p, 0, 1000000, 100, &it));
+
+    timeline_pyramid_advance(p, 0);
+    timeline_pyramid_edge(p, 5000, 1, 1);     /* Dit 5..15 ms, across a 10 ms bucket */
+    timeline_pyramid_edge(p, 15000, 1, 0);
+    timeline_pyramid_edge(p, 15000, 1, 0);    /* Repeated level: not an edge */
+    timeline_pyramid_edge(p, 20000, 5, 1);    /* Not a summarised channel */
+    timeline_pyramid_advance(p, 1000500);
+    TEST_ASSERT_EQUAL_INT64(1000000, timeline_pyramid_end_us(p));
+
+    /* 10 buckets for 100 px: finest level */
+    TEST_ASSERT_EQUAL_UINT32(10, timeline_pyramid_range_begin(p, 0, 100000, 100, &it));
+    TEST_ASSERT_EQUAL_UINT8(0, it.level);
+    TEST_ASSERT_TRUE(timeline_pyramid_range_next(p, &it, &col));
+    TEST_ASSERT_TRUE(col.valid);
+    TEST_ASSERT_EQUAL_INT64(0, col.start_us);
+    TEST_ASSERT_EQUAL_UINT16(500, col.duty_pm[1]);
+    TEST_ASSERT_EQUAL_UINT16(0, col.duty_pm[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, col.edges[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, col.hi);
+    TEST_ASSERT_EQUAL_HEX8(0x00, col.lo);
+    TEST_ASSERT_TRUE(timeline_pyramid_range_next(p, &it, &col));
+    TEST_ASSERT_EQUAL_INT64(10000, col.start_us);
+    TEST_ASSERT_EQUAL_UINT16(500, col.duty_pm[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, col.edges[1]);
+    TEST_ASSERT_TRUE(timeline_pyramid_range_next(p, &it, &col));
+    TEST_ASSERT_EQUAL_UINT16(0, col.duty_pm[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, col.hi);
+
+    /* 1 s in 10 px: 100 ms level, both edges in its first bucket */
+    TEST_ASSERT_EQUAL_UINT32(10, timeline_pyramid_range_begin(p, 0, 1000000, 10, &it));
+    TEST_ASSERT_EQUAL_UINT8(1, it.level);
+    TEST_ASSERT_EQUAL_UINT32(100000, it.res_us);
+    TEST_ASSERT_TRUE(timeline_pyramid_range_next(p, &it, &col));
+    TEST_ASSERT_EQUAL_UINT16(100, col.duty_pm[1]);
+    TEST_ASSERT_EQUAL_UINT32(2, col.edges[1]);
+
+    /* Only closed buckets are published: the range ends at the open one */
+    TEST_ASSERT_EQUAL_UINT32(2, timeline_pyramid_range_begin(p, 980000, 2000000, 100, &it));
+    int n = 0;
+    while (timeline_pyramid_range_next(p, &it, &col)) {
+        n++;
+    }
+    TEST_ASSERT_EQUAL_INT(2, n);
+}
+
+void test_timeline_pyramid_levels_and_retention(void) {
+    timeline_pyramid_t *p = &s_p;
+    timeline_range_t it;
+    timeline_column_t col;
+
+    timeline_pyramid_init(p);
+    timeline_pyramid_advance(p, 0);
+    timeline_pyramid_edge(p, 50000000, 0, 1);   /* Key down 50..51 s */
+    timeline_pyramid_edge(p, 51000000, 0, 0);
+    timeline_pyramid_advance(p, 100000000);
+
+    /* The 10 ms level no longer reaches 0 s: 100 ms level, bucket per column */
+    TEST_ASSERT_EQUAL_UINT32(1000, timeline_pyramid_range_begin(p, 0, 100000000, 2000, &it));
+    TEST_ASSERT_EQUAL_UINT8(1, it.level);
+    for (int i = 0; i <= 501; i++) {
+        TEST_ASSERT_TRUE(timeline_pyramid_range_next(p, &it, &col));
+    }
+    TEST_ASSERT_EQUAL_INT64(50100000, col.start_us);
+    TEST_ASSERT_EQUAL_UINT16(1000, col.duty_pm[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, col.edges[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, col.lo);      /* Down throughout */
+
+    /* 100 s in 10 px: 1 s level, ten buckets merged per column */
+    TEST_ASSERT_EQUAL_UINT32(10, timeline_pyramid_range_begin(p, 0, 100000000, 10, &it));
+    TEST_ASSERT_EQUAL_UINT8(2, it.level);
+    TEST_ASSERT_EQUAL_UINT32(10, it.per_column);
+    for (int i = 0; i <= 5; i++) {
+        TEST_ASSERT_TRUE(timeline_pyramid_range_next(p, &it, &col));
+    }
+    TEST_ASSERT_TRUE(col.valid);
+    TEST_ASSERT_EQUAL_INT64(50000000, col.start_us);
+    TEST_ASSERT_EQUAL_UINT16(100, col.duty_pm[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, col.edges[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, col.hi);
+    TEST_ASSERT_EQUAL_HEX8(0x00, col.lo);
+
+    /* Long idle gap: everything before the coarsest ring is gone */
+    timeline_pyramid_advance(p, 10000000000LL);
+    TEST_ASSERT_EQUAL_INT64(10000000000LL, timeline_pyramid_end_us(p));
+    TEST_ASSERT_EQUAL_UINT32(0, timeline_pyramid_range_begin(p, 0, 60000000, 60, &it));
+    TEST_ASSERT_FALSE(timeline_pyramid_range_next(p, &it, &col));
+
+    /* ...while the last seconds are still there at full resolution */
+    TEST_ASSERT_EQUAL_UINT32(100, timeline_pyramid_range_begin(p, 9999000000LL,
+                                                               10000000000LL, 500, &it));
+    TEST_ASSERT_EQUAL_UINT8(0, it.level);
+    TEST_ASSERT_TRUE(timeline_pyramid_range_next(p, &it, &col));
+    TEST_ASSERT_TRUE(col.valid);
+    TEST_ASSERT_EQUAL_UINT16(0, col.duty_pm[0]);
+}
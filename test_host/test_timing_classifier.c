@@ -168,3 +168,77 @@ void test_key_event_str(void) {
     TEST_ASSERT_EQUAL_STRING("WORD_GAP", key_event_str(KEY_EVENT_WORD_GAP));
     TEST_ASSERT_EQUAL_STRING("UNKNOWN", key_event_str(KEY_EVENT_UNKNOWN));
 }
+
+/* "CQ DE IU3QEZ" as patterns; "" marks a word gap */
+static const char *const QSO[] = {
+    "-.-.", "--.-", "", "-..", ".", "", "..", "..-", "...--", "--.-", ".", "--..", ""
+};
+#define QSO_LEN (sizeof(QSO) / sizeof(QSO[0]))
+
+/**
+ * Key QSO[] at dit_us; weight_us lengthens marks and shortens spaces.
+ * Returns events classified as something else than sent.
+ */
+static uint32_t key_qso(int64_t dit_us, int64_t weight_us) {
+    uint32_t errors = 0;
+    for (size_t c = 0; c < QSO_LEN; c++) {
+        const char *p = QSO[c];
+        if (*p == '\0') {
+            continue;
+        }
+        for (; *p != '\0'; p++) {
+            bool dah = (*p == '-');
+            key_event_t e = timing_classifier_classify(&s_tc, (dah ? 3 : 1) * dit_us + weight_us, true);
+            errors += (e != (dah ? KEY_EVENT_DAH : KEY_EVENT_DIT)) ? 1U : 0U;
+
+            bool word = (p[1] == '\0' && QSO[c + 1][0] == '\0');
+            int64_t units = (p[1] != '\0') ? 1 : (word ? 7 : 3);
+            key_event_t want = (p[1] != '\0') ? KEY_EVENT_INTRA_GAP
+                             : (word ? KEY_EVENT_WORD_GAP : KEY_EVENT_CHAR_GAP);
+            e = timing_classifier_classify(&s_tc, units * dit_us - weight_us, false);
+            errors += (e != want) ? 1U : 0U;
+        }
+    }
+    return errors;
+}
+
+void test_timing_cluster_classifies(void) {
+    timing_classifier_init(&s_tc, 20.0f);
+    timing_classifier_set_mode(&s_tc, TIMING_MODE_CLUSTER);
+    TEST_ASSERT_EQUAL_STRING("cluster", timing_mode_str(s_tc.mode));
+
+    /* Nominal timing decodes from the first event */
+    TEST_ASSERT_EQUAL(0, key_qso(DIT_20WPM_US, 0));
+    TEST_ASSERT_TRUE(timing_classifier_is_calibrated(&s_tc));
+    TEST_ASSERT_INT_WITHIN(2, 20, (int)timing_classifier_get_wpm(&s_tc));
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, 3.0f, timing_classifier_get_ratio(&s_tc));
+
+    /* Reset keeps the mode */
+    timing_classifier_reset(&s_tc, 20.0f);
+    TEST_ASSERT_EQUAL(TIMING_MODE_CLUSTER, s_tc.mode);
+    TEST_ASSERT_EQUAL(0, s_tc.marks.filled);
+}
+
+void test_timing_cluster_speed_change(void) {
+    timing_classifier_init(&s_tc, 15.0f);
+    timing_classifier_set_mode(&s_tc, TIMING_MODE_CLUSTER);
+    TEST_ASSERT_EQUAL(0, key_qso(80000, 0));  /* 15 WPM */
+
+    /* Operator speeds up to 30 WPM mid-QSO: a short settling burst,
+     * then clean again */
+    key_qso(40000, 0);
+    TEST_ASSERT_EQUAL(0, key_qso(40000, 0));
+    TEST_ASSERT_INT_WITHIN(2, 30, (int)timing_classifier_get_wpm(&s_tc));
+}
+
+void test_timing_cluster_heavy_weighting(void) {
+    /* Marks +24ms, spaces -24ms at 20 WPM: char gaps fall under the
+     * fixed 2-dit EMA threshold */
+    timing_classifier_init(&s_tc, 20.0f);
+    TEST_ASSERT_GREATER_THAN(0, key_qso(DIT_20WPM_US, 24000));
+
+    timing_classifier_init(&s_tc, 20.0f);
+    timing_classifier_set_mode(&s_tc, TIMING_MODE_CLUSTER);
+    key_qso(DIT_20WPM_US, 24000);
+    TEST_ASSERT_EQUAL(0, key_qso(DIT_20WPM_US, 24000));
+}
@@ -0,0 +1,79 @@
+/**
+ * @file test_transcript.c
+ * @brief Unit tests for the sequence-numbered decoded text history
+ */
+
+#include "unity.h"
+#include "decoder_transcript.h"
+#include <string.h>
+
+static transcript_t s_transcript;
+
+static void append_text(const char *text) {
+    for (const char *p = text; *p != '\0'; p++) {
+        transcript_append(&s_transcript, *p, 20);
+    }
+}
+
+void test_transcript_incremental_read(void) {
+    transcript_init(&s_transcript);
+    TEST_ASSERT_EQUAL_UINT32(0, transcript_append(&s_transcript, 'C', 20));
+    append_text("Q CQ");
+    TEST_ASSERT_EQUAL_UINT32(5, transcript_head(&s_transcript));
+    TEST_ASSERT_EQUAL_UINT32(1, transcript_words(&s_transcript));
+
+    char buf[16];
+    transcript_slice_t slice;
+    size_t n = transcript_read(&s_transcript, 0, buf, sizeof(buf), &slice);
+    TEST_ASSERT_EQUAL(5, n);
+    TEST_ASSERT_EQUAL_MEMORY("CQ CQ", buf, 5);
+    TEST_ASSERT_EQUAL_UINT32(0, slice.first_seq);
+    TEST_ASSERT_EQUAL_UINT32(5, slice.next_seq);
+    TEST_ASSERT_EQUAL_UINT32(0, slice.first_word);
+
+    /* Resume: only what follows, with its word number */
+    append_text(" DE");
+    n = transcript_read(&s_transcript, slice.next_seq, buf, sizeof(buf), &slice);
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL_MEMORY(" DE", buf, 3);
+    TEST_ASSERT_EQUAL_UINT32(5, slice.first_seq);
+    TEST_ASSERT_EQUAL_UINT32(1, slice.first_word);
+
+    /* Caught up */
+    n = transcript_read(&s_transcript, slice.next_seq, buf, sizeof(buf), &slice);
+    TEST_ASSERT_EQUAL(0, n);
+    TEST_ASSERT_EQUAL_UINT32(8, slice.next_seq);
+    TEST_ASSERT_EQUAL_UINT32(8, slice.head_seq);
+    TEST_ASSERT_EQUAL_UINT32(2, slice.first_word);
+
+    /* Capped reads continue where they stopped */
+    n = transcript_read(&s_transcript, 2, buf, 4, &slice);
+    TEST_ASSERT_EQUAL(4, n);
+    TEST_ASSERT_EQUAL_MEMORY(" CQ ", buf, 4);
+    TEST_ASSERT_EQUAL_UINT32(6, slice.next_seq);
+    TEST_ASSERT_EQUAL_UINT32(0, slice.first_word);
+}
+
+void test_transcript_lapped_reader(void) {
+    transcript_init(&s_transcript);
+    for (uint32_t i = 0; i < TRANSCRIPT_CAPACITY + 100U; i++) {
+        transcript_append(&s_transcript, (i % 10U == 9U) ? ' ' : 'E', 20);
+    }
+
+    static char buf[TRANSCRIPT_CAPACITY];
+    transcript_slice_t slice;
+    size_t n = transcript_read(&s_transcript, 5, buf, sizeof(buf), &slice);
+
+    /* Oldest retained instead of the overwritten ones */
+    TEST_ASSERT_EQUAL(TRANSCRIPT_CAPACITY - 1U, n);
+    TEST_ASSERT_EQUAL_UINT32(101, slice.first_seq);
+    TEST_ASSERT_EQUAL_UINT32(TRANSCRIPT_CAPACITY + 100U, slice.next_seq);
+    TEST_ASSERT_EQUAL_UINT32(10, slice.first_word);  /* Nine spaces before seq 101 */
+
+    /* A client from before a restart (ahead of head) starts over */
+    transcript_init(&s_transcript);
+    append_text("TEST");
+    n = transcript_read(&s_transcript, 500, buf, sizeof(buf), &slice);
+    TEST_ASSERT_EQUAL(4, n);
+    TEST_ASSERT_EQUAL_UINT32(0, slice.first_seq);
+}
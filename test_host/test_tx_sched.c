@@ -0,0 +1,65 @@
+/**
+ * @file test_tx_sched.c
+ * @brief Unit tests for the timed TX edge planner
+ */
+
+#include "unity.h"
+#include "tx_sched.h"
+
+void test_tx_sched_lead(void) {
+    tx_sched_t s;
+    tx_sched_init(&s, 1000 + TX_SCHED_GUARD_US, TX_SCHED_GUARD_US);
+
+    /* Key down at 10300, seen on the 11000 tick: out one lead later */
+    TEST_ASSERT_EQUAL_INT64(10300 + 1250, tx_sched_plan(&s, true, 10300, 11000));
+
+    /* Level unchanged: nothing planned, edge time ignored */
+    TEST_ASSERT_EQUAL_INT64(0, tx_sched_plan(&s, true, 11000, 12000));
+
+    /* 60ms dit later: TX element length is exactly the FSM's */
+    TEST_ASSERT_EQUAL_INT64(70300 + 1250, tx_sched_plan(&s, false, 70300, 71000));
+
+    tx_sched_stats_t st;
+    tx_sched_get(&s, &st);
+    TEST_ASSERT_EQUAL(1250, st.lead_us);
+    TEST_ASSERT_EQUAL(2, st.edges);
+    TEST_ASSERT_EQUAL(0, st.late);
+}
+
+void test_tx_sched_late_and_order(void) {
+    tx_sched_t s;
+    tx_sched_init(&s, 1250, 250);
+
+    /* Tick 2ms late: edge would be in the past, pushed to now + guard */
+    TEST_ASSERT_EQUAL_INT64(13250, tx_sched_plan(&s, true, 10000, 13000));
+    tx_sched_stats_t st;
+    tx_sched_get(&s, &st);
+    TEST_ASSERT_EQUAL(1, st.late);
+    TEST_ASSERT_EQUAL(2000, st.late_max_us);
+
+    /* An edge time before the previous output still goes out after it */
+    TEST_ASSERT_EQUAL_INT64(13251, tx_sched_plan(&s, false, 11900, 12999));
+
+    /* An edge time after the tick is clamped to the tick */
+    TEST_ASSERT_EQUAL_INT64(21250, tx_sched_plan(&s, true, 25000, 20000));
+
+    /* Forced off (fault): the next key down is planned again */
+    tx_sched_reset_level(&s);
+    TEST_ASSERT_TRUE(tx_sched_plan(&s, true, 30000, 30500) != 0);
+    tx_sched_get(&s, &st);
+    TEST_ASSERT_EQUAL(4, st.edges);
+    TEST_ASSERT_EQUAL(2, st.late);
+}
+
+void test_tx_sched_delayed(void) {
+    tx_sched_t s;
+    tx_sched_init(&s, 1250, 250);
+
+    /* Paddle edge 5 ms behind PTT, text edge right after with none */
+    TEST_ASSERT_EQUAL_INT64(10000 + 1250 + 5000, tx_sched_plan_delayed(&s, true, 10000, 5000, 10500));
+    TEST_ASSERT_EQUAL_INT64(16251, tx_sched_plan_delayed(&s, false, 11000, 0, 11500));
+
+    tx_sched_stats_t st;
+    tx_sched_get(&s, &st);
+    TEST_ASSERT_EQUAL(0, st.late);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file test_vpn_clock.c
+ * @brief Tests for the persisted VPN wall clock
+ */
+
+#include "unity.h"
+#include "vpn_clock.h"
+#include <string.h>
+
+#define S(x) ((int64_t)(x) * 1000000)
+
+/* 2026-01-01 00:00:00 */
+#define T0 S(1767225600LL)
+
+static vpn_clock_rec_t s_rec;
+
+void test_vpn_clock_estimate_from_rtc(void) {
+    memset(&s_rec, 0xA5, sizeof(s_rec));   /* RTC_NOINIT after power-on */
+    TEST_ASSERT_FALSE(vpn_clock_valid(&s_rec));
+    TEST_ASSERT_EQUAL_INT64(0, vpn_clock_estimate(&s_rec, S(10)));
+
+    /* Implausible wall time is not saved */
+    vpn_clock_save(&s_rec, S(5), S(1));
+    TEST_ASSERT_FALSE(vpn_clock_valid(&s_rec));
+
+    vpn_clock_save(&s_rec, T0, S(100));
+    TEST_ASSERT_TRUE(vpn_clock_valid(&s_rec));
+    TEST_ASSERT_EQUAL_INT32(0, s_rec.drift_ppm);
+
+    /* Reset 30 s later: saved time + RTC elapsed */
+    TEST_ASSERT_EQUAL_INT64(T0 + S(30), vpn_clock_estimate(&s_rec, S(130)));
+
+    /* Drift corrects the elapsed part: +1000 ppm = RTC runs slow */
+    s_rec.drift_ppm = 1000;
+    TEST_ASSERT_EQUAL_INT64(T0 + S(1000) + S(1), vpn_clock_estimate(&s_rec, S(1100)));
+}
+
+void test_vpn_clock_never_goes_back(void) {
+    memset(&s_rec, 0, sizeof(s_rec));
+    vpn_clock_save(&s_rec, T0, S(500));
+
+    /* RTC timer rewound (power-on): the saved time itself */
+    TEST_ASSERT_EQUAL_INT64(T0, vpn_clock_estimate(&s_rec, S(2)));
+
+    /* NVS copy carries no RTC save point */
+    vpn_clock_save(&s_rec, T0 + S(60), -1);
+    TEST_ASSERT_EQUAL_INT64(T0 + S(60), vpn_clock_estimate(&s_rec, S(900)));
+
+    /* Even the fastest learnt drift never moves the estimate back */
+    vpn_clock_save(&s_rec, T0, S(0));
+    s_rec.drift_ppm = -VPN_CLOCK_MAX_DRIFT_PPM;
+    TEST_ASSERT_TRUE(vpn_clock_estimate(&s_rec, S(100)) > T0);
+}
+
+void test_vpn_clock_calibrate_learns_drift(void) {
+    memset(&s_rec, 0, sizeof(s_rec));
+
+    /* First sync: nothing to compare with */
+    vpn_clock_calibrate(&s_rec, T0, S(1000));
+    TEST_ASSERT_TRUE(vpn_clock_valid(&s_rec));
+    TEST_ASSERT_EQUAL_INT32(0, s_rec.drift_ppm);
+    TEST_ASSERT_EQUAL_INT64(T0, s_rec.sync_unix_us);
+
+    /* Periodic saves move the save point, not the sync point */
+    vpn_clock_save(&s_rec, T0 + S(5), S(1005));
+    TEST_ASSERT_EQUAL_INT64(S(1000), s_rec.sync_rtc_us);
+
+    /* Too soon to learn from */
+    vpn_clock_calibrate(&s_rec, T0 + S(61), S(1060));
+    TEST_ASSERT_EQUAL_INT32(0, s_rec.drift_ppm);
+
+    /* One hour of RTC time, NTP says 3600.36 s: RTC is 100 ppm slow */
+    vpn_clock_calibrate(&s_rec, T0 + S(61) + S(3600) + 360000, S(1060) + S(3600));
+    TEST_ASSERT_EQUAL_INT32(100, s_rec.drift_ppm);
+    TEST_ASSERT_EQUAL_INT64(S(1060) + S(3600), s_rec.rtc_us);
+
+    /* A stepped clock clamps instead of overflowing */
+    vpn_clock_calibrate(&s_rec, T0 + S(100000000LL), S(1060) + S(7200));
+    TEST_ASSERT_EQUAL_INT32(VPN_CLOCK_MAX_DRIFT_PPM, s_rec.drift_ppm);
+    TEST_ASSERT_TRUE(vpn_clock_valid(&s_rec));
+}
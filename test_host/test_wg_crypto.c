@@ -0,0 +1,453 @@
+/**
+ * @file test_wg_crypto.c
+ * @brief WireGuard ChaCha20-Poly1305, X25519 and BLAKE2s: reference and Xtensa-tuned variants
+ *
+ * The AEAD vectors are RFC 8439 2.8.2 inputs with the WireGuard nonce layout
+ * (32 zero bits, then the 64-bit counter), computed with OpenSSL. The X25519
+ * ones are from RFC 7748, cross-checked with OpenSSL. The BLAKE2s ones are
+ * RFC 7693 and the BLAKE2 keyed KAT; the HKDF outputs were computed with
+ * Python's hmac and hashlib.blake2s.
+ */
+
+#include "unity.h"
+#include "crypto/refc/chacha20poly1305.h"
+#include "crypto/xtensa/chacha20poly1305_xtensa.h"
+#include "crypto/refc/x25519.h"
+#include "crypto/refc/blake2s.h"
+#include "crypto/xtensa/blake2s_xtensa.h"
+#include "crypto/xtensa/x25519_xtensa.h"
+#include "nacl/crypto_scalarmult/curve25519/ref/crypto_scalarmult.h"
+#include <string.h>
+
+#define WG_MAC_SIZE 16
+#define WG_MAX_LEN  320
+
+static const char PLAIN[] =
+    "Ladies and Gentlemen of the class of '99: If I could offer you only one tip "
+    "for the future, sunscreen would be it.";
+
+static const uint8_t AAD[] = {
+    0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+};
+
+static const uint64_t NONCE = 0x4746454443424140ULL;
+
+/* Ciphertext and tag of PLAIN under key 80..9f */
+static const uint8_t SEALED[] = {
+    0xa4, 0x79, 0xcb, 0x54, 0x62, 0x89, 0x46, 0xd6, 0xf4, 0x04, 0x2a, 0x8e,
+    0x38, 0x4e, 0xf4, 0xbd, 0x2f, 0xbc, 0x73, 0x30, 0xb8, 0xbe, 0x55, 0xeb,
+    0x2d, 0x8d, 0xc1, 0x8a, 0xaa, 0x51, 0xd6, 0x6a, 0x8e, 0xc1, 0xf8, 0xd3,
+    0x61, 0x9a, 0x25, 0x8d, 0xb0, 0xac, 0x56, 0x95, 0x60, 0x15, 0xb7, 0xb4,
+    0x93, 0x7e, 0x9b, 0x8e, 0x6a, 0xa9, 0x57, 0xb3, 0xdc, 0x02, 0x14, 0xd8,
+    0x03, 0xd7, 0x76, 0x60, 0xaa, 0xbc, 0x91, 0x30, 0x92, 0x97, 0x1d, 0xa8,
+    0xf2, 0x07, 0x17, 0x1c, 0xe7, 0x84, 0x36, 0x08, 0x16, 0x2e, 0x2e, 0x75,
+    0x9d, 0x8e, 0xfc, 0x25, 0xd8, 0xd0, 0x93, 0x69, 0x90, 0xaf, 0x63, 0xc8,
+    0x20, 0xba, 0x87, 0xe8, 0xa9, 0x55, 0xb5, 0xc8, 0x27, 0x4e, 0xf7, 0xd1,
+    0x0f, 0x6f, 0xaf, 0xd0, 0x46, 0x47, 0x2d, 0xbf, 0x18, 0x9b, 0x66, 0x8b,
+    0xd4, 0x30, 0xae, 0xf9, 0x14, 0x7e, 0x99, 0xcb, 0x6c, 0x89,
+};
+
+/* Tag alone: empty message and AAD, counter 1 (a keepalive) */
+static const uint8_t EMPTY_TAG[] = {
+    0x2c, 0x8b, 0xcc, 0x02, 0x34, 0x98, 0xfb, 0x47, 0x95, 0xf0, 0x09, 0xbc,
+    0x2b, 0x0b, 0xd4, 0x9a,
+};
+
+/* RFC 7748 5.2, first vector */
+static const uint8_t X_SCALAR[32] = {
+    0xa5, 0x46, 0xe3, 0x6b, 0xf0, 0x52, 0x7c, 0x9d, 0x3b, 0x16, 0x15, 0x4b,
+    0x82, 0x46, 0x5e, 0xdd, 0x62, 0x14, 0x4c, 0x0a, 0xc1, 0xfc, 0x5a, 0x18,
+    0x50, 0x6a, 0x22, 0x44, 0xba, 0x44, 0x9a, 0xc4,
+};
+
+static const uint8_t X_U[32] = {
+    0xe6, 0xdb, 0x68, 0x67, 0x58, 0x30, 0x30, 0xdb, 0x35, 0x94, 0xc1, 0xa4,
+    0x24, 0xb1, 0x5f, 0x7c, 0x72, 0x66, 0x24, 0xec, 0x26, 0xb3, 0x35, 0x3b,
+    0x10, 0xa9, 0x03, 0xa6, 0xd0, 0xab, 0x1c, 0x4c,
+};
+
+static const uint8_t X_OUT[32] = {
+    0xc3, 0xda, 0x55, 0x37, 0x9d, 0xe9, 0xc6, 0x90, 0x8e, 0x94, 0xea, 0x4d,
+    0xf2, 0x8d, 0x08, 0x4f, 0x32, 0xec, 0xcf, 0x03, 0x49, 0x1c, 0x71, 0xf7,
+    0x54, 0xb4, 0x07, 0x55, 0x77, 0xa2, 0x85, 0x52,
+};
+
+/* RFC 7748 6.1: Alice's key, Bob's public key, their shared secret */
+static const uint8_t X_ALICE[32] = {
+    0x77, 0x07, 0x6d, 0x0a, 0x73, 0x18, 0xa5, 0x7d, 0x3c, 0x16, 0xc1, 0x72,
+    0x51, 0xb2, 0x66, 0x45, 0xdf, 0x4c, 0x2f, 0x87, 0xeb, 0xc0, 0x99, 0x2a,
+    0xb1, 0x77, 0xfb, 0xa5, 0x1d, 0xb9, 0x2c, 0x2a,
+};
+
+static const uint8_t X_ALICE_PUB[32] = {
+    0x85, 0x20, 0xf0, 0x09, 0x89, 0x30, 0xa7, 0x54, 0x74, 0x8b, 0x7d, 0xdc,
+    0xb4, 0x3e, 0xf7, 0x5a, 0x0d, 0xbf, 0x3a, 0x0d, 0x26, 0x38, 0x1a, 0xf4,
+    0xeb, 0xa4, 0xa9, 0x8e, 0xaa, 0x9b, 0x4e, 0x6a,
+};
+
+static const uint8_t X_BOB_PUB[32] = {
+    0xde, 0x9e, 0xdb, 0x7d, 0x7b, 0x7d, 0xc1, 0xb4, 0xd3, 0x5b, 0x61, 0xc2,
+    0xec, 0xe4, 0x35, 0x37, 0x3f, 0x83, 0x43, 0xc8, 0x5b, 0x78, 0x67, 0x4d,
+    0xad, 0xfc, 0x7e, 0x14, 0x6f, 0x88, 0x2b, 0x4f,
+};
+
+static const uint8_t X_SHARED[32] = {
+    0x4a, 0x5d, 0x9d, 0x5b, 0xa4, 0xce, 0x2d, 0xe1, 0x72, 0x8e, 0x3b, 0xf4,
+    0x80, 0x35, 0x0f, 0x25, 0xe0, 0x7e, 0x21, 0xc9, 0x47, 0xd1, 0x9e, 0x33,
+    0x76, 0xf0, 0x9b, 0x3c, 0x1e, 0x16, 0x17, 0x42,
+};
+
+/* 2^255 - 10, i.e. 9 not reduced mod p, and X_SCALAR times 9 (OpenSSL) */
+static const uint8_t X_P_PLUS_9[32] = {
+    0xf6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f,
+};
+
+static const uint8_t X_SCALAR_BASE[32] = {
+    0x1c, 0x9f, 0xd8, 0x8f, 0x45, 0x60, 0x6d, 0x93, 0x2a, 0x80, 0xc7, 0x18,
+    0x24, 0xae, 0x15, 0x1d, 0x15, 0xd7, 0x3e, 0x77, 0xde, 0x38, 0xe8, 0xe0,
+    0x00, 0x85, 0x2e, 0x61, 0x4f, 0xae, 0x70, 0x19,
+};
+
+static uint8_t s_key[32];
+static uint8_t s_plain[WG_MAX_LEN];
+static uint8_t s_a[WG_MAX_LEN + WG_MAC_SIZE + 4];
+static uint8_t s_b[WG_MAX_LEN + WG_MAC_SIZE + 4];
+static uint8_t s_out[WG_MAX_LEN + 4];
+
+static void setup_key(void) {
+    for (size_t i = 0; i < sizeof(s_key); i++) {
+        s_key[i] = (uint8_t)(0x80U + i);
+    }
+}
+
+void test_wg_aead_vector(void) {
+    const size_t len = sizeof(PLAIN) - 1;
+    setup_key();
+    TEST_ASSERT_EQUAL_size_t(len + WG_MAC_SIZE, sizeof(SEALED));
+
+    chacha20poly1305_encrypt(s_a, (const uint8_t *)PLAIN, len, AAD, sizeof(AAD), NONCE, s_key);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(SEALED, s_a, sizeof(SEALED));
+
+    chacha20poly1305_xtensa_encrypt(s_b, (const uint8_t *)PLAIN, len, AAD, sizeof(AAD), NONCE, s_key);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(SEALED, s_b, sizeof(SEALED));
+
+    TEST_ASSERT_TRUE(chacha20poly1305_xtensa_decrypt(s_out, SEALED, sizeof(SEALED), AAD,
+                                                     sizeof(AAD), NONCE, s_key));
+    TEST_ASSERT_EQUAL_MEMORY(PLAIN, s_out, len);
+
+    /* Keepalive: no payload, no AAD, NULL buffers */
+    chacha20poly1305_xtensa_encrypt(s_b, NULL, 0, NULL, 0, 1, s_key);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(EMPTY_TAG, s_b, WG_MAC_SIZE);
+    TEST_ASSERT_TRUE(chacha20poly1305_xtensa_decrypt(NULL, EMPTY_TAG, WG_MAC_SIZE, NULL, 0, 1, s_key));
+    TEST_ASSERT_FALSE(chacha20poly1305_xtensa_decrypt(NULL, EMPTY_TAG, WG_MAC_SIZE - 1, NULL, 0, 1, s_key));
+}
+
+void test_wg_aead_matches_refc(void) {
+    setup_key();
+    for (size_t i = 0; i < WG_MAX_LEN; i++) {
+        s_plain[i] = (uint8_t)(i * 7U + 3U);
+    }
+
+    /* Every length around the block sizes, aligned and not */
+    for (size_t len = 0; len <= WG_MAX_LEN; len += (len < 140) ? 1 : 37) {
+        for (size_t off = 0; off < 4; off += 3) {
+            uint64_t nonce = 1000U + len;
+            size_t ad_len = len % 29;
+            chacha20poly1305_encrypt(s_a, s_plain, len, s_plain, ad_len, nonce, s_key);
+            chacha20poly1305_xtensa_encrypt(s_b + off, s_plain, len, s_plain, ad_len, nonce, s_key);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(s_a, s_b + off, len + WG_MAC_SIZE);
+
+            TEST_ASSERT_TRUE(chacha20poly1305_xtensa_decrypt(s_out + off, s_b + off, len + WG_MAC_SIZE,
+                                                             s_plain, ad_len, nonce, s_key));
+            if (len > 0) {
+                TEST_ASSERT_EQUAL_MEMORY(s_plain, s_out + off, len);
+            }
+        }
+    }
+
+    /* In place, as wireguardif does */
+    memcpy(s_b, s_plain, 200);
+    chacha20poly1305_xtensa_encrypt(s_b, s_b, 200, NULL, 0, 7, s_key);
+    chacha20poly1305_encrypt(s_a, s_plain, 200, NULL, 0, 7, s_key);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_a, s_b, 200 + WG_MAC_SIZE);
+    TEST_ASSERT_TRUE(chacha20poly1305_xtensa_decrypt(s_b, s_b, 200 + WG_MAC_SIZE, NULL, 0, 7, s_key));
+    TEST_ASSERT_EQUAL_MEMORY(s_plain, s_b, 200);
+}
+
+void test_wg_aead_rejects_tampering(void) {
+    const size_t len = 100;
+    setup_key();
+    chacha20poly1305_xtensa_encrypt(s_a, s_plain, len, AAD, sizeof(AAD), 5, s_key);
+    memset(s_out, 0xEE, sizeof(s_out));
+
+    s_a[17] ^= 0x01;
+    TEST_ASSERT_FALSE(chacha20poly1305_xtensa_decrypt(s_out, s_a, len + WG_MAC_SIZE, AAD,
+                                                      sizeof(AAD), 5, s_key));
+    s_a[17] ^= 0x01;
+    TEST_ASSERT_FALSE(chacha20poly1305_xtensa_decrypt(s_out, s_a, len + WG_MAC_SIZE, AAD,
+                                                      sizeof(AAD), 6, s_key));
+    TEST_ASSERT_FALSE(chacha20poly1305_xtensa_decrypt(s_out, s_a, len + WG_MAC_SIZE, AAD,
+                                                      sizeof(AAD) - 1, 5, s_key));
+
+    /* Nothing written before the tag checks out */
+    for (size_t i = 0; i < len; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0xEE, s_out[i]);
+    }
+}
+
+void test_wg_xaead_matches_refc(void) {
+    uint8_t nonce[24];
+    setup_key();
+    for (size_t i = 0; i < sizeof(nonce); i++) {
+        nonce[i] = (uint8_t)(0x40U + i);
+    }
+
+    /* Cookie reply size: a 16-byte cookie */
+    xchacha20poly1305_encrypt(s_a, s_plain, 16, AAD, 12, nonce, s_key);
+    xchacha20poly1305_xtensa_encrypt(s_b, s_plain, 16, AAD, 12, nonce, s_key);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_a, s_b, 16 + WG_MAC_SIZE);
+    TEST_ASSERT_TRUE(xchacha20poly1305_xtensa_decrypt(s_out, s_b, 16 + WG_MAC_SIZE, AAD, 12, nonce, s_key));
+    TEST_ASSERT_EQUAL_MEMORY(s_plain, s_out, 16);
+}
+
+void test_wg_x25519_vectors(void) {
+    static const uint8_t base[32] = { 9 };
+    uint8_t out[32];
+
+    TEST_ASSERT_EQUAL_INT(0, x25519_xtensa(out, X_SCALAR, X_U));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(X_OUT, out, 32);
+
+    /* Public key, then the shared secret */
+    TEST_ASSERT_EQUAL_INT(0, x25519_xtensa(out, X_ALICE, base));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(X_ALICE_PUB, out, 32);
+    TEST_ASSERT_EQUAL_INT(0, x25519_xtensa(out, X_ALICE, X_BOB_PUB));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(X_SHARED, out, 32);
+
+    /* Non-canonical u, and the top bit of u is ignored */
+    TEST_ASSERT_EQUAL_INT(0, x25519_xtensa(out, X_SCALAR, X_P_PLUS_9));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(X_SCALAR_BASE, out, 32);
+    uint8_t u[32];
+    memcpy(u, X_U, sizeof(u));
+    u[31] |= 0x80;
+    TEST_ASSERT_EQUAL_INT(0, x25519_xtensa(out, X_SCALAR, u));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(X_OUT, out, 32);
+
+    /* Small-order point: all-zero result, reported like refc does */
+    memset(u, 0, sizeof(u));
+    TEST_ASSERT_NOT_EQUAL(0, x25519_xtensa(out, X_SCALAR, u));
+    TEST_ASSERT_NOT_EQUAL(0, x25519(s_a, X_SCALAR, u, 1));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_a, out, 32);
+}
+
+void test_wg_x25519_matches_refc(void) {
+    uint8_t k[32];
+    uint8_t u[32] = { 9 };
+    uint8_t ref[32];
+    uint8_t nacl[32];
+    uint8_t out[32];
+
+    /* Feed each result back as the next point, as a handshake chain would */
+    for (uint32_t i = 0; i < 64; i++) {
+        for (size_t j = 0; j < sizeof(k); j++) {
+            k[j] = (uint8_t)(i * 131U + j * 29U + 1U);
+        }
+        TEST_ASSERT_EQUAL_INT(0, x25519(ref, k, u, 1));
+        TEST_ASSERT_EQUAL_INT(0, crypto_scalarmult(nacl, k, u));
+        TEST_ASSERT_EQUAL_INT(0, x25519_xtensa(out, k, u));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, out, 32);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(nacl, out, 32);
+        memcpy(u, out, sizeof(u));
+    }
+
+    /* Extreme limbs: u = p - 2 and u with every bit set below 255 */
+    memset(u, 0xFF, sizeof(u));
+    u[0] = 0xEB;
+    u[31] = 0x7F;
+    TEST_ASSERT_EQUAL_INT(0, x25519(ref, X_SCALAR, u, 1));
+    x25519_xtensa(out, X_SCALAR, u);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, out, 32);
+    u[0] = 0xFF;
+    crypto_scalarmult(nacl, X_SCALAR, u);
+    x25519_xtensa(out, X_SCALAR, u);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(nacl, out, 32);
+}
+
+/* ============================================================================
+ * BLAKE2s, HMAC, HKDF
+ * ============================================================================ */
+
+/* RFC 7693 Appendix B: BLAKE2s-256("abc") */
+static const uint8_t B2S_ABC[32] = {
+    0x50, 0x8c, 0x5e, 0x8c, 0x32, 0x7c, 0x14, 0xe2, 0xe1, 0xa7, 0x2b, 0xa3,
+    0x4e, 0xeb, 0x45, 0x2f, 0x37, 0x45, 0x8b, 0x20, 0x9e, 0xd6, 0x3a, 0x29,
+    0x4d, 0x99, 0x9b, 0x4c, 0x86, 0x67, 0x59, 0x82,
+};
+
+/* BLAKE2 KAT: key 00..1f, message 00..fe (255 bytes) */
+static const uint8_t B2S_KEYED_255[32] = {
+    0x3f, 0xb7, 0x35, 0x06, 0x1a, 0xbc, 0x51, 0x9d, 0xfe, 0x97, 0x9e, 0x54,
+    0xc1, 0xee, 0x5b, 0xfa, 0xd0, 0xa9, 0xd8, 0x58, 0xb3, 0x31, 0x5b, 0xad,
+    0x34, 0xbd, 0xe9, 0x99, 0xef, 0xd7, 0x24, 0xdd,
+};
+
+/* Kdf3(chaining key 40..5f, data a0..bf) */
+static const uint8_t KDF_T1[32] = {
+    0x6a, 0x40, 0x86, 0x31, 0x25, 0x7f, 0x7b, 0x4f, 0x6c, 0x11, 0x74, 0x42,
+    0x31, 0x9e, 0x83, 0x97, 0x8c, 0x60, 0x08, 0x57, 0xaa, 0x8e, 0xb0, 0xb6,
+    0x91, 0x68, 0x5b, 0x87, 0x4a, 0x46, 0x43, 0x43,
+};
+
+static const uint8_t KDF_T2[32] = {
+    0xe4, 0x90, 0x94, 0x5c, 0xe1, 0x59, 0x90, 0x4b, 0xb8, 0x90, 0x22, 0x3f,
+    0x0d, 0xa3, 0x06, 0x0e, 0xe1, 0x78, 0xd7, 0x22, 0xf2, 0xfc, 0xd9, 0x31,
+    0x83, 0x73, 0xfa, 0x30, 0x56, 0x1f, 0x8c, 0x77,
+};
+
+static const uint8_t KDF_T3[32] = {
+    0x64, 0x90, 0xc6, 0x1e, 0x97, 0x83, 0x59, 0x0c, 0xb4, 0x5c, 0xac, 0x38,
+    0xe6, 0x43, 0x4a, 0x4f, 0x30, 0x8f, 0xac, 0x1e, 0xf9, 0x04, 0xa6, 0xe0,
+    0x99, 0xe1, 0x8f, 0xe2, 0xcc, 0x57, 0x97, 0xdb,
+};
+
+/* Kdf2(chaining key 40..5f, no data): the transport keys of a handshake */
+static const uint8_t KDF_EMPTY_T1[32] = {
+    0x78, 0xee, 0xa5, 0xe4, 0xbf, 0xed, 0xc2, 0xe7, 0x92, 0xdc, 0x08, 0x62,
+    0x03, 0x03, 0xca, 0x62, 0x66, 0xf1, 0xfd, 0x18, 0xfa, 0xb3, 0x7c, 0x84,
+    0x8a, 0xb8, 0xe9, 0x7d, 0x65, 0x66, 0x5f, 0x68,
+};
+
+static const uint8_t KDF_EMPTY_T2[32] = {
+    0xb4, 0x58, 0x12, 0x1c, 0xc4, 0xfa, 0xa0, 0xa6, 0xc9, 0x55, 0x26, 0x80,
+    0xd7, 0x83, 0xa1, 0xf7, 0xcc, 0xea, 0x37, 0xe4, 0x83, 0xbf, 0x5a, 0x88,
+    0xb9, 0x90, 0xf5, 0xeb, 0xe2, 0x60, 0x57, 0xcc,
+};
+
+void test_wg_blake2s_vectors(void) {
+    uint8_t out[32];
+
+    TEST_ASSERT_EQUAL_INT(0, blake2s_xtensa(out, 32, NULL, 0, "abc", 3));
+    TEST_ASSERT_EQUAL_MEMORY(B2S_ABC, out, 32);
+
+    for (size_t i = 0; i < 255; i++) {
+        s_plain[i] = (uint8_t)i;
+    }
+    for (size_t i = 0; i < sizeof(s_key); i++) {
+        s_key[i] = (uint8_t)i;
+    }
+    TEST_ASSERT_EQUAL_INT(0, blake2s_xtensa(out, 32, s_key, 32, s_plain, 255));
+    TEST_ASSERT_EQUAL_MEMORY(B2S_KEYED_255, out, 32);
+
+    /* Unaligned input, fed in uneven pieces */
+    blake2s_xtensa_ctx ctx;
+    memcpy(s_a + 1, s_plain, 255);
+    TEST_ASSERT_EQUAL_INT(0, blake2s_xtensa_init(&ctx, 32, s_key, 32));
+    blake2s_xtensa_update(&ctx, s_a + 1, 63);
+    blake2s_xtensa_update(&ctx, s_a + 64, 1);
+    blake2s_xtensa_update(&ctx, s_a + 65, 0);
+    blake2s_xtensa_update(&ctx, s_a + 65, 191);
+    blake2s_xtensa_final(&ctx, out);
+    TEST_ASSERT_EQUAL_MEMORY(B2S_KEYED_255, out, 32);
+
+    TEST_ASSERT_NOT_EQUAL(0, blake2s_xtensa_init(&ctx, 0, NULL, 0));
+    TEST_ASSERT_NOT_EQUAL(0, blake2s_xtensa_init(&ctx, 33, NULL, 0));
+    TEST_ASSERT_NOT_EQUAL(0, blake2s_xtensa_init(&ctx, 32, s_key, 33));
+}
+
+void test_wg_blake2s_matches_refc(void) {
+    static const size_t KEY_LENS[] = { 0, 16, 32 };
+    static const size_t OUT_LENS[] = { 16, 32, 7 };
+    uint8_t ref[32];
+    uint8_t out[32];
+
+    for (size_t i = 0; i < WG_MAX_LEN; i++) {
+        s_plain[i] = (uint8_t)(i * 131U + 7U);
+    }
+    setup_key();
+    for (size_t k = 0; k < 3; k++) {
+        for (size_t len = 0; len <= 200; len++) {
+            size_t outlen = OUT_LENS[(len + k) % 3];
+            blake2s(ref, outlen, s_key, KEY_LENS[k], s_plain, len);
+
+            /* In one call, and split at every block edge and off it */
+            blake2s_xtensa(out, outlen, s_key, KEY_LENS[k], s_plain, len);
+            TEST_ASSERT_EQUAL_MEMORY(ref, out, outlen);
+
+            blake2s_xtensa_ctx ctx;
+            size_t cut = (len * 7U) % (len + 1U);
+            blake2s_xtensa_init(&ctx, outlen, s_key, KEY_LENS[k]);
+            blake2s_xtensa_update(&ctx, s_plain, cut);
+            blake2s_xtensa_update(&ctx, s_plain + cut, len - cut);
+            blake2s_xtensa_final(&ctx, out);
+            TEST_ASSERT_EQUAL_MEMORY(ref, out, outlen);
+        }
+    }
+}
+
+/* Kdf as wireguard.c computes it with the reference hash */
+static void ref_hmac(uint8_t *digest, const uint8_t *key, size_t key_len,
+                     const uint8_t *text, size_t text_len) {
+    uint8_t ipad[64] = { 0 };
+    uint8_t opad[64] = { 0 };
+    memcpy(ipad, key, key_len);
+    memcpy(opad, key, key_len);
+    for (int i = 0; i < 64; i++) {
+        ipad[i] ^= 0x36;
+        opad[i] ^= 0x5c;
+    }
+    blake2s_ctx ctx;
+    blake2s_init(&ctx, 32, NULL, 0);
+    blake2s_update(&ctx, ipad, 64);
+    blake2s_update(&ctx, text, text_len);
+    blake2s_final(&ctx, digest);
+    blake2s_init(&ctx, 32, NULL, 0);
+    blake2s_update(&ctx, opad, 64);
+    blake2s_update(&ctx, digest, 32);
+    blake2s_final(&ctx, digest);
+}
+
+void test_wg_hkdf(void) {
+    uint8_t ck[32];
+    uint8_t data[32];
+    uint8_t t1[32], t2[32], t3[32];
+    for (size_t i = 0; i < 32; i++) {
+        ck[i] = (uint8_t)(0x40U + i);
+        data[i] = (uint8_t)(0xa0U + i);
+    }
+
+    blake2s_xtensa_hkdf(t1, t2, t3, ck, data, sizeof(data));
+    TEST_ASSERT_EQUAL_MEMORY(KDF_T1, t1, 32);
+    TEST_ASSERT_EQUAL_MEMORY(KDF_T2, t2, 32);
+    TEST_ASSERT_EQUAL_MEMORY(KDF_T3, t3, 32);
+
+    blake2s_xtensa_hkdf(t1, t2, NULL, ck, NULL, 0);
+    TEST_ASSERT_EQUAL_MEMORY(KDF_EMPTY_T1, t1, 32);
+    TEST_ASSERT_EQUAL_MEMORY(KDF_EMPTY_T2, t2, 32);
+
+    /* The handshake writes the new chaining key over the old one */
+    memcpy(t3, ck, 32);
+    blake2s_xtensa_hkdf(t3, t2, NULL, t3, data, sizeof(data));
+    TEST_ASSERT_EQUAL_MEMORY(KDF_T1, t3, 32);
+    TEST_ASSERT_EQUAL_MEMORY(KDF_T2, t2, 32);
+
+    /* A cached HMAC key against the reference, keys longer than a block included */
+    blake2s_xtensa_hmac_key hk;
+    uint8_t ref[32];
+    for (size_t i = 0; i < WG_MAX_LEN; i++) {
+        s_plain[i] = (uint8_t)(i * 29U + 3U);
+    }
+    for (size_t key_len = 16; key_len <= 64; key_len += 16) {
+        blake2s_xtensa_hmac_setkey(&hk, s_plain, key_len);
+        for (size_t len = 1; len <= 130; len += 43) {
+            ref_hmac(ref, s_plain, key_len, s_plain + 100, len);
+            blake2s_xtensa_hmac(&hk, t1, s_plain + 100, len);
+            TEST_ASSERT_EQUAL_MEMORY(ref, t1, 32);
+        }
+    }
+    blake2s(ref, 32, NULL, 0, s_plain, 100);
+    ref_hmac(ref, ref, 32, data, sizeof(data));
+    blake2s_xtensa_hmac_setkey(&hk, s_plain, 100);
+    blake2s_xtensa_hmac(&hk, t1, data, sizeof(data));
+    TEST_ASSERT_EQUAL_MEMORY(ref, t1, 32);
+}
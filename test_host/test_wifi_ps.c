@@ -0,0 +1,79 @@
+/**
+ * @file test_wifi_ps.c
+ * @brief Tests for the WiFi power-save policy
+ */
+
+#include "unity.h"
+#include "wifi_ps.h"
+
+#define S(x) ((int64_t)(x) * 1000000)
+
+static wifi_ps_t s_ps;
+
+void test_wifi_ps_auto_follows_activity(void) {
+    wifi_ps_init(&s_ps, true);
+
+    /* The first position is a baseline: stays asleep */
+    TEST_ASSERT_FALSE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(0), 100, false));
+    TEST_ASSERT_TRUE(s_ps.saving);
+
+    /* Stream moves: wake at once */
+    TEST_ASSERT_TRUE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(1), 101, false));
+    TEST_ASSERT_FALSE(s_ps.saving);
+
+    /* More keying restarts the idle timer */
+    TEST_ASSERT_FALSE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(20), 105, false));
+    TEST_ASSERT_FALSE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(49), 105, false));
+    TEST_ASSERT_FALSE(s_ps.saving);
+
+    /* idle_s after the last activity: sleep again */
+    TEST_ASSERT_TRUE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(50), 105, false));
+    TEST_ASSERT_TRUE(s_ps.saving);
+    TEST_ASSERT_EQUAL_UINT32(2, s_ps.switches);
+}
+
+void test_wifi_ps_link_keeps_awake(void) {
+    wifi_ps_init(&s_ps, true);
+    wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(0), 7, false);
+
+    /* CWNet READY: awake without any keying */
+    TEST_ASSERT_TRUE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(1), 7, true));
+    TEST_ASSERT_FALSE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(500), 7, true));
+    TEST_ASSERT_FALSE(s_ps.saving);
+
+    /* Link down, long idle: sleep */
+    TEST_ASSERT_TRUE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(501), 7, false));
+    TEST_ASSERT_TRUE(s_ps.saving);
+}
+
+void test_wifi_ps_fixed_policies(void) {
+    wifi_ps_init(&s_ps, true);
+    wifi_ps_update(&s_ps, WIFI_PS_POLICY_ALWAYS, 30, S(0), 0, false);
+
+    /* ALWAYS ignores keying and links */
+    TEST_ASSERT_FALSE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_ALWAYS, 30, S(1), 9, true));
+    TEST_ASSERT_TRUE(s_ps.saving);
+
+    /* NEVER wakes with no activity at all */
+    TEST_ASSERT_TRUE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_NEVER, 30, S(100), 9, false));
+    TEST_ASSERT_FALSE(s_ps.saving);
+
+    /* Back to AUTO: the keying at 1s is long past */
+    TEST_ASSERT_TRUE(wifi_ps_update(&s_ps, WIFI_PS_POLICY_AUTO, 30, S(101), 9, false));
+    TEST_ASSERT_TRUE(s_ps.saving);
+    TEST_ASSERT_EQUAL_STRING("auto", wifi_ps_policy_str(WIFI_PS_POLICY_AUTO));
+}
+
+void test_wifi_ps_jitter_per_mode(void) {
+    wifi_ps_init(&s_ps, true);
+    TEST_ASSERT_EQUAL_INT32(-1, s_ps.jitter_ms[0]);
+    TEST_ASSERT_EQUAL_INT32(-1, s_ps.jitter_ms[1]);
+
+    wifi_ps_note_jitter(&s_ps, 40);
+    wifi_ps_update(&s_ps, WIFI_PS_POLICY_NEVER, 30, S(0), 0, false);
+    wifi_ps_note_jitter(&s_ps, 3);
+    wifi_ps_note_jitter(&s_ps, -1);       /* Unknown: keeps the last value */
+
+    TEST_ASSERT_EQUAL_INT32(3, s_ps.jitter_ms[0]);
+    TEST_ASSERT_EQUAL_INT32(40, s_ps.jitter_ms[1]);
+}
@@ -0,0 +1,155 @@
+/**
+ * @file test_winkeyer.c
+ * @brief Unit tests for the WinKeyer 2 protocol engine
+ */
+
+#include "unity.h"
+#include "winkeyer.h"
+#include <stdio.h>
+#include <string.h>
+
+static winkeyer_t s_wk;
+
+/* Bytes sent to the host */
+static uint8_t s_tx[64];
+static size_t s_tx_len;
+
+/* Actions, flattened: "T:CQ" text, "B" backspace, "S:20" speed, ... */
+static char s_log[256];
+
+static void on_send(const uint8_t *data, size_t len, void *user_data) {
+    (void)user_data;
+    for (size_t i = 0; i < len && s_tx_len < sizeof(s_tx); i++) {
+        s_tx[s_tx_len++] = data[i];
+    }
+}
+
+static void on_action(const winkeyer_action_t *action, void *user_data) {
+    (void)user_data;
+    char item[80];
+    switch (action->type) {
+        case WINKEYER_ACTION_TEXT:
+            snprintf(item, sizeof(item), "T:%.*s ", (int)action->len, action->text);
+            break;
+        case WINKEYER_ACTION_BACKSPACE: snprintf(item, sizeof(item), "B "); break;
+        case WINKEYER_ACTION_CLEAR:     snprintf(item, sizeof(item), "C "); break;
+        case WINKEYER_ACTION_SPEED:     snprintf(item, sizeof(item), "S:%u ", action->value); break;
+        case WINKEYER_ACTION_WEIGHT:    snprintf(item, sizeof(item), "W:%u ", action->value); break;
+        case WINKEYER_ACTION_SIDETONE:  snprintf(item, sizeof(item), "F:%u ", action->value); break;
+        case WINKEYER_ACTION_PAUSE:     snprintf(item, sizeof(item), "P:%u ", action->value); break;
+        case WINKEYER_ACTION_MESSAGE:   snprintf(item, sizeof(item), "M:%u ", action->value); break;
+        case WINKEYER_ACTION_HOST:      snprintf(item, sizeof(item), "H:%u ", action->value); break;
+        case WINKEYER_ACTION_RADIO:     snprintf(item, sizeof(item), "R:%u ", action->value); break;
+        default:                        snprintf(item, sizeof(item), "? "); break;
+    }
+    strncat(s_log, item, sizeof(s_log) - strlen(s_log) - 1);
+}
+
+static void setup(void) {
+    winkeyer_config_t cfg = { .send_cb = on_send, .action_cb = on_action, .user_data = NULL };
+    winkeyer_init(&s_wk, &cfg);
+    s_tx_len = 0;
+    s_log[0] = '\0';
+}
+
+static void feed(const uint8_t *data, size_t len) {
+    winkeyer_feed(&s_wk, data, len);
+}
+
+void test_winkeyer_host_open_and_queries(void) {
+    setup();
+    static const uint8_t open[] = { 0x00, 0x02 };
+    feed(open, sizeof(open));
+    TEST_ASSERT_TRUE(winkeyer_host_open(&s_wk));
+    TEST_ASSERT_EQUAL(1, s_tx_len);
+    TEST_ASSERT_EQUAL_HEX8(WINKEYER_VERSION, s_tx[0]);
+    TEST_ASSERT_EQUAL_STRING("H:1 ", s_log);
+
+    /* Echo test, status request, get values: answered in the same feed */
+    s_tx_len = 0;
+    static const uint8_t queries[] = { 0x00, 0x04, 0x5A, 0x15, 0x00, 0x07 };
+    feed(queries, sizeof(queries));
+    TEST_ASSERT_EQUAL(2 + WINKEYER_REG_COUNT, s_tx_len);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, s_tx[0]);
+    TEST_ASSERT_EQUAL_HEX8(WINKEYER_STATUS_TAG, s_tx[1]);
+    TEST_ASSERT_EQUAL(50, s_tx[2 + WINKEYER_REG_WEIGHT]);
+}
+
+void test_winkeyer_text_and_commands_in_order(void) {
+    setup();
+    /* Text, backspace, speed, merged letters, sidetone, more text */
+    static const uint8_t bytes[] = {
+        'C', 'Q', ' ', 'T', 'E', 0x08, 0x02, 20, 'D', 'E', 0x1B, 'A', 'R', 0x01, 5, 'K',
+    };
+    feed(bytes, sizeof(bytes));
+    TEST_ASSERT_EQUAL_STRING("T:CQ TE B S:20 T:DE T:<AR> F:800 T:K ", s_log);
+
+    /* Same bytes one at a time: same actions (text batches per feed) */
+    setup();
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        feed(&bytes[i], 1);
+    }
+    TEST_ASSERT_EQUAL_STRING("T:C T:Q T:  T:T T:E B S:20 T:D T:E T:<AR> F:800 T:K ", s_log);
+
+    /* EEPROM load swallows its 256 data bytes, even text-looking ones */
+    setup();
+    static uint8_t eeprom[2 + 256 + 1];
+    eeprom[0] = 0x00;
+    eeprom[1] = 13;
+    memset(&eeprom[2], 'E', 256);
+    eeprom[2 + 256] = 'K';
+    feed(eeprom, sizeof(eeprom));
+    TEST_ASSERT_EQUAL_STRING("T:K ", s_log);
+}
+
+void test_winkeyer_pin_config_selects_radio(void) {
+    setup();
+    /* KeyOut2 only, KeyOut1 only, both (no change), neither (no change) */
+    static const uint8_t pins[] = { 0x09, 0x09, 0x09, 0x05, 0x09, 0x0D, 0x09, 0x01 };
+    feed(pins, sizeof(pins));
+    TEST_ASSERT_EQUAL_STRING("R:2 R:1 ", s_log);
+    TEST_ASSERT_EQUAL_HEX8(0x01, s_wk.regs[WINKEYER_REG_PIN_CONFIG]);
+}
+
+void test_winkeyer_status_and_pot_push(void) {
+    setup();
+    winkeyer_status_t st = { .busy = false, .breakin = false, .key_down = false,
+                             .xoff = false, .wpm = 25 };
+
+    /* Nothing is pushed while the host port is closed */
+    winkeyer_update(&s_wk, &st);
+    TEST_ASSERT_EQUAL(0, s_tx_len);
+
+    static const uint8_t open[] = { 0x00, 0x02 };
+    feed(open, sizeof(open));
+    s_tx_len = 0;
+
+    /* First update after open: status and pot (25 - MinWPM 10) */
+    winkeyer_update(&s_wk, &st);
+    TEST_ASSERT_EQUAL(2, s_tx_len);
+    TEST_ASSERT_EQUAL_HEX8(WINKEYER_STATUS_TAG, s_tx[0]);
+    TEST_ASSERT_EQUAL_HEX8(WINKEYER_POT_TAG | 15, s_tx[1]);
+
+    /* Unchanged: silent; busy: one status byte */
+    s_tx_len = 0;
+    winkeyer_update(&s_wk, &st);
+    TEST_ASSERT_EQUAL(0, s_tx_len);
+    st.busy = true;
+    winkeyer_update(&s_wk, &st);
+    TEST_ASSERT_EQUAL(1, s_tx_len);
+    TEST_ASSERT_EQUAL_HEX8(WINKEYER_STATUS_TAG | WINKEYER_STATUS_BUSY, s_tx[0]);
+
+    /* Speed changed elsewhere: pot byte; speed set by the host: none */
+    s_tx_len = 0;
+    st.wpm = 30;
+    winkeyer_update(&s_wk, &st);
+    TEST_ASSERT_EQUAL(1, s_tx_len);
+    TEST_ASSERT_EQUAL_HEX8(WINKEYER_POT_TAG | 20, s_tx[0]);
+
+    s_tx_len = 0;
+    static const uint8_t speed[] = { 0x02, 22 };
+    feed(speed, sizeof(speed));
+    st.wpm = 22;
+    winkeyer_update(&s_wk, &st);
+    TEST_ASSERT_EQUAL(0, s_tx_len);
+}
@@ -0,0 +1,126 @@
+/**
+ * @file test_ws_delta.c
+ * @brief Tests for WebSocket config/status delta frames
+ */
+
+#include "unity.h"
+#include "ws_delta.h"
+#include "json_scan.h"
+#include <string.h>
+#include <stdio.h>
+
+#define MAX_FRAMES 8
+
+static char s_frames[MAX_FRAMES][WS_DELTA_FRAME_MAX + 1];
+static unsigned s_count;
+
+static void capture(const char *frame, size_t len, void *ctx) {
+    (void)ctx;
+    TEST_ASSERT_EQUAL_UINT32(strlen(frame), len);
+    TEST_ASSERT_TRUE(len <= WS_DELTA_FRAME_MAX);
+    if (s_count < MAX_FRAMES) {
+        memcpy(s_frames[s_count], frame, len + 1);
+    }
+    s_count++;
+}
+
+/** Sequence number of a captured frame, after checking it parses */
+static int frame_seq(unsigned n, int *members) {
+    json_tok_t toks[64];
+    const char *f = s_frames[n];
+    TEST_ASSERT_TRUE(json_scan(f, strlen(f), toks, 64) >= 0);
+    int seq = -1;
+    int idx = json_scan_get(f, toks, 0, "seq");
+    TEST_ASSERT_TRUE(idx >= 0 && json_scan_int(f, &toks[idx], &seq));
+    int set = json_scan_get(f, toks, 0, "set");
+    TEST_ASSERT_TRUE(set >= 0 && toks[set].type == JSON_TOK_OBJECT);
+    *members = 0;
+    for (int i = set + 1; i < (int)toks[set].next; i = (int)toks[i + 1].next) {
+        (*members)++;
+    }
+    return seq;
+}
+
+void test_ws_delta_frames_members(void) {
+    uint32_t seq = 0;
+    ws_delta_t d;
+    s_count = 0;
+
+    /* Nothing changed: no frame, no number used */
+    ws_delta_begin(&d, "config", &seq, capture, NULL);
+    TEST_ASSERT_EQUAL_UINT32(0, ws_delta_end(&d));
+    TEST_ASSERT_EQUAL_UINT32(0, s_count);
+    TEST_ASSERT_EQUAL_UINT32(0, seq);
+
+    char value[32];
+    ws_delta_begin(&d, "config", &seq, capture, NULL);
+    ws_delta_put(&d, "keyer.wpm", "25");
+    ws_delta_json_string(value, sizeof(value), "IU3QEZ");
+    ws_delta_put(&d, "system.callsign", value);
+    TEST_ASSERT_EQUAL_UINT32(1, ws_delta_end(&d));
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"config\",\"seq\":1,\"set\":{\"keyer.wpm\":25,\"system.callsign\":\"IU3QEZ\"}}",
+        s_frames[0]);
+
+    /* The counter is shared: the next change set goes on from it */
+    ws_delta_begin(&d, "status", &seq, capture, NULL);
+    ws_delta_put(&d, "ready", "true");
+    ws_delta_end(&d);
+    int members;
+    TEST_ASSERT_EQUAL_INT(2, frame_seq(1, &members));
+    TEST_ASSERT_EQUAL_INT(1, members);
+}
+
+void test_ws_delta_splits_large_sets(void) {
+    uint32_t seq = 10;
+    ws_delta_t d;
+    char key[32];
+    char value[64];
+    s_count = 0;
+
+    ws_delta_begin(&d, "config", &seq, capture, NULL);
+    for (int i = 0; i < 20; i++) {
+        snprintf(key, sizeof(key), "family.param_%02d", i);
+        ws_delta_json_string(value, sizeof(value), "a value of some length");
+        ws_delta_put(&d, key, value);
+    }
+    unsigned frames = ws_delta_end(&d);
+    TEST_ASSERT_TRUE(frames > 1 && frames <= MAX_FRAMES);
+    TEST_ASSERT_EQUAL_UINT32(frames, s_count);
+    TEST_ASSERT_EQUAL_UINT32(0, d.dropped);
+
+    /* Consecutive numbers, every member in exactly one frame */
+    int total = 0;
+    for (unsigned n = 0; n < frames; n++) {
+        int members;
+        TEST_ASSERT_EQUAL_INT(11 + (int)n, frame_seq(n, &members));
+        TEST_ASSERT_TRUE(members > 0);
+        total += members;
+    }
+    TEST_ASSERT_EQUAL_INT(20, total);
+    TEST_ASSERT_EQUAL_UINT32(10 + frames, seq);
+
+    /* A member no frame can hold is dropped and counted, not sent cut */
+    static char big[WS_DELTA_FRAME_MAX + 8];
+    memset(big, '1', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    s_count = 0;
+    ws_delta_begin(&d, "config", &seq, capture, NULL);
+    ws_delta_put(&d, "x.y", big);
+    TEST_ASSERT_EQUAL_UINT32(0, ws_delta_end(&d));
+    TEST_ASSERT_EQUAL_UINT32(1, d.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, s_count);
+    TEST_ASSERT_EQUAL_UINT32(10 + frames, seq);
+}
+
+void test_ws_delta_strings_and_sig(void) {
+    char out[32];
+    TEST_ASSERT_EQUAL_UINT32(15, ws_delta_json_string(out, sizeof(out), "a\"b\\c\n"));
+    TEST_ASSERT_EQUAL_STRING("\"a\\\"b\\\\c\\u000a\"", out);
+    TEST_ASSERT_EQUAL_UINT32(0, ws_delta_json_string(out, 6, "abcdef"));
+    TEST_ASSERT_EQUAL_STRING("", out);
+    TEST_ASSERT_EQUAL_UINT32(2, ws_delta_json_string(out, 3, ""));
+
+    TEST_ASSERT_TRUE(ws_delta_sig("25") != ws_delta_sig("26"));
+    TEST_ASSERT_TRUE(ws_delta_sig("\"A\"") == ws_delta_sig("\"A\""));
+}
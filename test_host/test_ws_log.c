@@ -0,0 +1,144 @@
+/**
+ * @file test_ws_log.c
+ * @brief Tests for WebSocket log subscription frames
+ */
+
+#include "unity.h"
+#include "ws_log.h"
+#include "json_scan.h"
+#include <string.h>
+#include <stdio.h>
+
+static log_stream_t s_rt;
+static log_stream_t s_bg;
+static char s_frame[256];
+
+/** Parse a frame and return the entries array token, or -1 */
+static int frame_entries(json_tok_t *toks, size_t max, size_t len) {
+    if (json_scan(s_frame, len, toks, max) < 0) {
+        return -1;
+    }
+    return json_scan_get(s_frame, toks, 0, "entries");
+}
+
+/** Index of element n of an array token, -1 past the end */
+static int elem(const json_tok_t *toks, int arr, int n) {
+    int i = arr + 1;
+    while (i < (int)toks[arr].next) {
+        if (n-- == 0) {
+            return i;
+        }
+        i = (int)toks[i].next;
+    }
+    return -1;
+}
+
+static int count(const json_tok_t *toks, int arr) {
+    int n = 0;
+    while (elem(toks, arr, n) >= 0) {
+        n++;
+    }
+    return n;
+}
+
+/** String field f of entry e */
+static void field(const json_tok_t *toks, int arr, int e, int f, char *out, size_t cap) {
+    int i = elem(toks, elem(toks, arr, e), f);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, i);
+    TEST_ASSERT_TRUE(json_scan_string(s_frame, &toks[i], out, cap));
+}
+
+void test_ws_log_merges_and_filters(void) {
+    json_tok_t toks[64];
+    ws_log_cursor_t cur;
+    char text[32];
+    unsigned level;
+
+    log_stream_init(&s_rt);
+    log_stream_init(&s_bg);
+    TEST_ASSERT_TRUE(ws_log_parse_level("WARN", &level));
+    TEST_ASSERT_EQUAL_UINT(LOG_LEVEL_WARN, level);
+    TEST_ASSERT_TRUE(ws_log_parse_level("OFF", &level));
+    TEST_ASSERT_FALSE(ws_log_parse_level("LOUD", &level));
+
+    log_stream_pushf(&s_bg, 10, LOG_LEVEL_INFO, "bg %u", 1U);
+    log_stream_pushf(&s_rt, 20, LOG_LEVEL_DEBUG, "rt debug");
+    log_stream_pushf(&s_rt, 30, LOG_LEVEL_WARN, "rt \"%s\"", "late");
+    log_stream_pushf(&s_bg, 25, LOG_LEVEL_INFO, "bg %u", 2U);
+
+    /* RT at WARN: the DEBUG record is filtered, the rest comes in time order */
+    ws_log_cursor_init(&cur, &s_rt, &s_bg, ws_log_filter_make(LOG_LEVEL_WARN, LOG_LEVEL_INFO));
+    size_t len = ws_log_batch(&cur, s_frame, sizeof(s_frame));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    int arr = frame_entries(toks, 64, len);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, arr);
+    TEST_ASSERT_EQUAL_INT(3, count(toks, arr));
+
+    field(toks, arr, 0, 3, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("bg 1", text);
+    field(toks, arr, 2, 1, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("RT", text);
+    field(toks, arr, 2, 3, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("rt \"late\"", text);
+    TEST_ASSERT_EQUAL_size_t(0, ws_log_batch(&cur, s_frame, sizeof(s_frame)));
+
+    /* A muted stream is not read at all */
+    ws_log_cursor_init(&cur, &s_rt, &s_bg,
+                       ws_log_filter_make(WS_LOG_LEVEL_OFF, LOG_LEVEL_TRACE));
+    len = ws_log_batch(&cur, s_frame, sizeof(s_frame));
+    arr = frame_entries(toks, 64, len);
+    TEST_ASSERT_EQUAL_INT(2, count(toks, arr));
+}
+
+void test_ws_log_batches_and_reports_drops(void) {
+    json_tok_t toks[64];
+    ws_log_cursor_t cur;
+    char text[32];
+
+    log_stream_init(&s_rt);
+    log_stream_init(&s_bg);
+    ws_log_cursor_init(&cur, &s_rt, &s_bg, ws_log_filter_make(LOG_LEVEL_TRACE, LOG_LEVEL_TRACE));
+    TEST_ASSERT_EQUAL_size_t(0, ws_log_batch(&cur, s_frame, sizeof(s_frame)));
+
+    /* Several records per frame; what does not fit waits for the next */
+    for (unsigned i = 0; i < 12U; i++) {
+        log_stream_pushf(&s_bg, (int64_t)i, LOG_LEVEL_INFO, "entry %u", i);
+    }
+    unsigned total = 0;
+    unsigned frames = 0;
+    size_t len;
+    while ((len = ws_log_batch(&cur, s_frame, sizeof(s_frame))) > 0) {
+        TEST_ASSERT_LESS_OR_EQUAL(sizeof(s_frame), len);
+        int arr = frame_entries(toks, 64, len);
+        TEST_ASSERT_GREATER_OR_EQUAL(0, arr);
+        TEST_ASSERT_GREATER_THAN(1, count(toks, arr));
+        total += (unsigned)count(toks, arr);
+        frames++;
+    }
+    TEST_ASSERT_EQUAL_UINT(12, total);
+    TEST_ASSERT_GREATER_THAN(1, frames);
+
+    /* A record too long for a frame on its own is cut, not stuck */
+    char big[LOG_MAX_MSG_LEN];
+    memset(big, '"', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    log_stream_pushf(&s_rt, 100, LOG_LEVEL_INFO, "%s", big);
+    len = ws_log_batch(&cur, s_frame, sizeof(s_frame));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, frame_entries(toks, 64, len));
+    TEST_ASSERT_EQUAL_size_t(0, ws_log_batch(&cur, s_frame, sizeof(s_frame)));
+
+    /* A cursor the producer laps gets one summary entry, then carries on */
+    for (unsigned i = 0; i < LOG_RING_BYTES / 8U; i++) {
+        log_stream_pushf(&s_bg, 200 + (int64_t)i, LOG_LEVEL_INFO, "flood %u", i);
+    }
+    len = ws_log_batch(&cur, s_frame, sizeof(s_frame));
+    int arr = frame_entries(toks, 64, len);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, arr);
+    field(toks, arr, 0, 2, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("WARN", text);
+    field(toks, arr, 0, 3, text, sizeof(text));
+    TEST_ASSERT_NOT_NULL(strstr(text, "records dropped"));
+    field(toks, arr, 1, 3, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING_LEN("flood ", text, 6);
+}
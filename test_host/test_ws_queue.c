@@ -0,0 +1,97 @@
+/**
+ * @file test_ws_queue.c
+ * @brief Unit tests for per-client WebSocket send queues
+ */
+
+#include "unity.h"
+#include "ws_queue.h"
+#include <string.h>
+
+static ws_queue_t s_queue;
+static ws_msg_t s_msg;
+
+static void push_byte(ws_msg_kind_t kind, uint8_t value) {
+    ws_queue_push(&s_queue, kind, kind == WS_MSG_TIMELINE, &value, 1);
+}
+
+void test_ws_queue_fifo_and_scheduling(void) {
+    ws_queue_init(&s_queue);
+    TEST_ASSERT_FALSE(ws_queue_pop(&s_queue, &s_msg));
+
+    /* Only the first producer schedules the worker */
+    push_byte(WS_MSG_DECODED, 'A');
+    TEST_ASSERT_TRUE(ws_queue_schedule(&s_queue));
+    push_byte(WS_MSG_TIMELINE, 1);
+    TEST_ASSERT_FALSE(ws_queue_schedule(&s_queue));
+
+    TEST_ASSERT_TRUE(ws_queue_pop(&s_queue, &s_msg));
+    TEST_ASSERT_EQUAL_HEX8('A', s_msg.data[0]);
+    TEST_ASSERT_FALSE(s_msg.binary);
+    TEST_ASSERT_TRUE(ws_queue_pop(&s_queue, &s_msg));
+    TEST_ASSERT_EQUAL(WS_MSG_TIMELINE, s_msg.kind);
+    TEST_ASSERT_TRUE(s_msg.binary);
+    TEST_ASSERT_FALSE(ws_queue_pop(&s_queue, &s_msg));
+    TEST_ASSERT_EQUAL_UINT32(2, s_queue.sent);
+
+    /* Message arriving while the worker was busy keeps it running */
+    push_byte(WS_MSG_DECODED, 'B');
+    TEST_ASSERT_FALSE(ws_queue_schedule(&s_queue));
+    TEST_ASSERT_TRUE(ws_queue_worker_done(&s_queue));
+    TEST_ASSERT_TRUE(ws_queue_pop(&s_queue, &s_msg));
+    TEST_ASSERT_FALSE(ws_queue_worker_done(&s_queue));
+    TEST_ASSERT_TRUE(ws_queue_schedule(&s_queue));
+}
+
+void test_ws_queue_overflow_policies(void) {
+    ws_queue_init(&s_queue);
+
+    for (uint8_t i = 0; i < WS_QUEUE_SLOTS; i++) {
+        push_byte(WS_MSG_TIMELINE, i);
+    }
+
+    /* Timeline drops the oldest frame */
+    push_byte(WS_MSG_TIMELINE, 100);
+    TEST_ASSERT_EQUAL_UINT32(WS_QUEUE_SLOTS, ws_queue_len(&s_queue));
+    TEST_ASSERT_EQUAL_UINT32(1, s_queue.dropped[WS_MSG_TIMELINE]);
+
+    /* Decoder text is refused instead of breaking the text already queued */
+    uint8_t c = 'X';
+    TEST_ASSERT_FALSE(ws_queue_push(&s_queue, WS_MSG_DECODED, false, &c, 1));
+    TEST_ASSERT_EQUAL_UINT32(1, s_queue.dropped[WS_MSG_DECODED]);
+
+    TEST_ASSERT_TRUE(ws_queue_pop(&s_queue, &s_msg));
+    TEST_ASSERT_EQUAL_HEX8(1, s_msg.data[0]);
+    for (int i = 1; i < WS_QUEUE_SLOTS; i++) {
+        TEST_ASSERT_TRUE(ws_queue_pop(&s_queue, &s_msg));
+    }
+    TEST_ASSERT_EQUAL_HEX8(100, s_msg.data[0]);
+
+    /* Too long for a slot */
+    static uint8_t big[WS_QUEUE_MSG_MAX + 1];
+    TEST_ASSERT_FALSE(ws_queue_push(&s_queue, WS_MSG_TIMELINE, true, big, sizeof(big)));
+}
+
+void test_ws_queue_pattern_coalesces(void) {
+    ws_queue_init(&s_queue);
+
+    ws_queue_push(&s_queue, WS_MSG_PATTERN, false, (const uint8_t *)".", 1);
+    ws_queue_push(&s_queue, WS_MSG_PATTERN, false, (const uint8_t *)".-", 2);
+    ws_queue_push(&s_queue, WS_MSG_PATTERN, false, (const uint8_t *)".-.", 3);
+    push_byte(WS_MSG_DECODED, 'E');
+    TEST_ASSERT_EQUAL_UINT32(2, s_queue.coalesced);
+
+    /* Queued text first, then only the latest pattern */
+    TEST_ASSERT_TRUE(ws_queue_pop(&s_queue, &s_msg));
+    TEST_ASSERT_EQUAL(WS_MSG_DECODED, s_msg.kind);
+    TEST_ASSERT_TRUE(ws_queue_pop(&s_queue, &s_msg));
+    TEST_ASSERT_EQUAL(WS_MSG_PATTERN, s_msg.kind);
+    TEST_ASSERT_EQUAL(3, s_msg.len);
+    TEST_ASSERT_EQUAL_MEMORY(".-.", s_msg.data, 3);
+    TEST_ASSERT_FALSE(ws_queue_pop(&s_queue, &s_msg));
+
+    /* A sent value is not counted as coalesced */
+    ws_queue_push(&s_queue, WS_MSG_PATTERN, false, (const uint8_t *)"", 0);
+    TEST_ASSERT_EQUAL_UINT32(2, s_queue.coalesced);
+    TEST_ASSERT_TRUE(ws_queue_pop(&s_queue, &s_msg));
+    TEST_ASSERT_EQUAL(0, s_msg.len);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file test_ws_timeline.c
+ * @brief Unit tests for binary WebSocket timeline frames
+ */
+
+#include "unity.h"
+#include "ws_timeline.h"
+
+static ws_timeline_frame_t s_frame;
+
+void test_ws_timeline_layout(void) {
+    ws_timeline_reset(&s_frame, 100);
+    TEST_ASSERT_TRUE(ws_timeline_is_empty(&s_frame));
+
+    /* First edge: base time in the header, delta 0 */
+    TEST_ASSERT_TRUE(ws_timeline_add(&s_frame, 5000, 0x0102030405LL, 1, 1));
+    TEST_ASSERT_TRUE(ws_timeline_add(&s_frame, 5600, 0, 0, 1));
+    TEST_ASSERT_TRUE(ws_timeline_add(&s_frame, 5601, 0, 1, 0));
+
+    TEST_ASSERT_EQUAL(WS_TIMELINE_HEADER + 3 * WS_TIMELINE_RECORD, s_frame.len);
+    TEST_ASSERT_EQUAL_HEX8(WS_TIMELINE_VERSION, s_frame.buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(3, s_frame.buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(100, s_frame.buf[2]);
+    TEST_ASSERT_EQUAL_HEX8(0, s_frame.buf[3]);
+    TEST_ASSERT_EQUAL_HEX8(0x05, s_frame.buf[4]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, s_frame.buf[8]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, s_frame.buf[11]);
+
+    const uint8_t *rec = &s_frame.buf[WS_TIMELINE_HEADER];
+    TEST_ASSERT_EQUAL_HEX8(0, rec[0]);
+    TEST_ASSERT_EQUAL_HEX8(1, rec[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x58, rec[4]);   /* 600 ticks LE */
+    TEST_ASSERT_EQUAL_HEX8(0x02, rec[5]);
+    TEST_ASSERT_EQUAL_HEX8(0, rec[6]);      /* Key channel */
+    TEST_ASSERT_EQUAL_HEX8(1, rec[8]);      /* One tick later */
+    TEST_ASSERT_EQUAL_HEX8(0, rec[11]);     /* Released */
+}
+
+void test_ws_timeline_full_frame(void) {
+    ws_timeline_reset(&s_frame, 100);
+
+    for (uint32_t i = 0; i < WS_TIMELINE_MAX_RECORDS; i++) {
+        TEST_ASSERT_TRUE(ws_timeline_add(&s_frame, 10U * i, 0, 0, (uint8_t)(i & 1U)));
+    }
+    TEST_ASSERT_EQUAL(WS_TIMELINE_FRAME_MAX, s_frame.len);
+    TEST_ASSERT_TRUE(s_frame.len <= 256);
+
+    /* Rejected without touching the frame */
+    TEST_ASSERT_FALSE(ws_timeline_add(&s_frame, 1000, 0, 0, 1));
+    TEST_ASSERT_EQUAL(WS_TIMELINE_FRAME_MAX, s_frame.len);
+    TEST_ASSERT_EQUAL_HEX8(WS_TIMELINE_MAX_RECORDS, s_frame.buf[1]);
+}
+
+void test_ws_timeline_wide_gap_starts_new_frame(void) {
+    ws_timeline_reset(&s_frame, 100);
+
+    TEST_ASSERT_TRUE(ws_timeline_add(&s_frame, 0, 1000, 0, 1));
+    TEST_ASSERT_TRUE(ws_timeline_add(&s_frame, 65535, 0, 0, 0));
+    TEST_ASSERT_FALSE(ws_timeline_add(&s_frame, 65535 + 65536, 0, 0, 1));
+    TEST_ASSERT_FALSE(ws_timeline_add(&s_frame, 10, 0, 0, 1));  /* Backwards */
+    TEST_ASSERT_EQUAL(2, s_frame.count);
+
+    /* After a reset the same edge becomes the new base */
+    ws_timeline_reset(&s_frame, 100);
+    TEST_ASSERT_TRUE(ws_timeline_add(&s_frame, 65535 + 65536, 13108700, 0, 1));
+    TEST_ASSERT_EQUAL(WS_TIMELINE_HEADER + WS_TIMELINE_RECORD, s_frame.len);
+}
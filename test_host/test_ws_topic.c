@@ -0,0 +1,57 @@
+/**
+ * @file test_ws_topic.c
+ * @brief Tests for WebSocket subscription topics
+ */
+
+#include "unity.h"
+#include "ws_topic.h"
+#include "json_scan.h"
+#include <string.h>
+
+/** Parse the "topics" member of a subscribe command */
+static bool parse(const char *js, unsigned *mask) {
+    json_tok_t toks[16];
+    TEST_ASSERT_TRUE(json_scan(js, strlen(js), toks, 16) >= 0);
+    return ws_topic_mask_parse(js, toks, json_scan_get(js, toks, 0, "topics"), mask);
+}
+
+void test_ws_topic_names(void) {
+    for (unsigned t = 0; t < WS_TOPIC_COUNT; t++) {
+        const char *name = ws_topic_name((ws_topic_t)t);
+        TEST_ASSERT_NOT_NULL(name);
+        TEST_ASSERT_EQUAL_INT((int)t, ws_topic_parse(name));
+    }
+    TEST_ASSERT_NULL(ws_topic_name(WS_TOPIC_COUNT));
+    TEST_ASSERT_EQUAL_INT(-1, ws_topic_parse("metrics"));
+    TEST_ASSERT_EQUAL_INT(-1, ws_topic_parse("Timeline"));
+
+    /* Old clients never subscribe: they keep everything but the logs */
+    TEST_ASSERT_EQUAL_UINT32(0, WS_TOPICS_DEFAULT & WS_TOPIC_BIT(WS_TOPIC_LOGS));
+    TEST_ASSERT_EQUAL_UINT32(0, WS_TOPICS_DEFAULT & WS_TOPIC_BIT(WS_TOPIC_STATS));
+    TEST_ASSERT_TRUE((WS_TOPICS_DEFAULT & WS_TOPIC_BIT(WS_TOPIC_TIMELINE)) != 0);
+    TEST_ASSERT_TRUE((WS_TOPICS_DEFAULT & WS_TOPIC_BIT(WS_TOPIC_STATUS)) != 0);
+}
+
+void test_ws_topic_mask_parse(void) {
+    unsigned mask = 0xFFU;
+
+    TEST_ASSERT_TRUE(parse("{\"type\":\"subscribe\",\"topics\":[\"decoder\",\"logs\"]}", &mask));
+    TEST_ASSERT_EQUAL_UINT32(WS_TOPIC_BIT(WS_TOPIC_DECODER) | WS_TOPIC_BIT(WS_TOPIC_LOGS), mask);
+
+    /* Unknown and overlong names are ignored, repeats are harmless */
+    TEST_ASSERT_TRUE(parse("{\"topics\":[\"metrics\",\"status\",\"status\","
+                           "\"a-very-long-topic-name\"]}", &mask));
+    TEST_ASSERT_EQUAL_UINT32(WS_TOPIC_BIT(WS_TOPIC_STATUS), mask);
+
+    TEST_ASSERT_TRUE(parse("{\"topics\":[]}", &mask));
+    TEST_ASSERT_EQUAL_UINT32(0, mask);
+}
+
+void test_ws_topic_mask_rejects(void) {
+    unsigned mask = 0x5U;
+
+    TEST_ASSERT_FALSE(parse("{\"type\":\"subscribe\"}", &mask));
+    TEST_ASSERT_FALSE(parse("{\"topics\":\"timeline\"}", &mask));
+    TEST_ASSERT_FALSE(parse("{\"topics\":[\"timeline\",3]}", &mask));
+    TEST_ASSERT_EQUAL_UINT32(0x5U, mask);   /* Left as it was */
+}
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""
+Convert a .cwk keying history recording to CSV or VCD.
+
+Recordings come from GET /api/stream/export[?seconds=N | ?session=N] (raw
+binary) or the `export [seconds]` console command (hex lines between
+"cwk begin" and "cwk end"; paste the captured terminal text as-is).
+
+Usage:
+    cwk_convert.py keying.cwk --csv > keying.csv
+    cwk_convert.py capture.txt --vcd > keying.vcd
+
+Layout (little-endian), see components/keyer_core/include/stream_export.h:
+    64-byte header (48 bytes in version 1), then raw 6-byte stream_sample_t
+    records, oldest first. Version 2 adds the CWNet network clock.
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct("<4sHHHHIIIQQQ")
+NET = struct.Struct("<qiI")          # Version 2: net_first_us, net_drift_ppm, flags
+SAMPLE = struct.Struct("<BBBBH")
+
+CWK_FLAG_NET_CLOCK = 0x0001
+
+FLAG_GPIO_EDGE = 0x01
+FLAG_CONFIG_CHANGE = 0x02
+FLAG_TX_START = 0x04
+FLAG_RX_START = 0x08
+FLAG_SILENCE = 0x10
+FLAG_LOCAL_EDGE = 0x20
+FLAG_LANE_SHIFT = 6
+
+LANES = ["local", "text", "remote", "aux"]
+LANE_LOCAL, LANE_TEXT, LANE_REMOTE = 0, 1, 2
+
+
+def load(path: str) -> bytes:
+    """Return the recording bytes from a binary file or a console capture"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] == b"CWK1":
+        return data
+
+    out = bytearray()
+    inside = False
+    for line in data.decode("ascii", errors="replace").splitlines():
+        line = line.strip()
+        if line.startswith("cwk begin"):
+            inside, out = True, bytearray()
+        elif line.startswith("cwk end"):
+            if "truncated" in line:
+                print("cwk_convert: warning: export was truncated", file=sys.stderr)
+            break
+        elif inside and line:
+            out += bytes.fromhex(line)
+    if not out:
+        sys.exit(f"cwk_convert: {path}: no recording found")
+    return bytes(out)
+
+
+def resolve_tick(ref: int, tick32: int) -> int:
+    """Widen a 32-bit REMOTE event tick to the absolute tick nearest ref"""
+    delta = (tick32 - ref) & 0xFFFFFFFF
+    if delta >= 0x80000000:
+        delta -= 0x100000000
+    return ref + delta
+
+
+def parse(data: bytes):
+    """Return (header dict, [event dict]) with absolute ticks resolved"""
+    if len(data) < HEADER.size:
+        sys.exit("cwk_convert: recording too short")
+    (magic, version, header_size, sample_size, _reserved, tick_us, count,
+     first_idx, first_tick, captured_tick, captured_us) = HEADER.unpack_from(data)
+    if magic != b"CWK1" or version not in (1, 2) or sample_size != SAMPLE.size:
+        sys.exit(f"cwk_convert: unsupported recording (magic {magic!r}, version {version})")
+
+    hdr = {
+        "tick_us": tick_us, "count": count, "first_idx": first_idx,
+        "first_tick": first_tick, "captured_tick": captured_tick, "captured_us": captured_us,
+        "net_first_us": None, "net_drift_ppm": 0,
+    }
+    if version >= 2 and header_size >= HEADER.size + NET.size:
+        net_first_us, drift_ppm, flags = NET.unpack_from(data, HEADER.size)
+        if flags & CWK_FLAG_NET_CLOCK:
+            hdr["net_first_us"] = net_first_us
+            hdr["net_drift_ppm"] = drift_ppm
+
+    body = data[header_size:]
+    have = len(body) // sample_size
+    if have < count:
+        print(f"cwk_convert: warning: {have} of {count} samples present", file=sys.stderr)
+
+    events = []
+    tick = first_tick
+    for i in range(min(have, count)):
+        gpio, key, audio, flags, gen = SAMPLE.unpack_from(body, i * sample_size)
+        lane = flags >> FLAG_LANE_SHIFT
+        ev = {
+            "idx": (first_idx + i) & 0xFFFFFFFF, "tick": tick, "lane": lane,
+            "flags": flags, "gpio": gpio, "key": key, "audio": audio, "gen": gen,
+            "silence": 0,
+        }
+        if lane == LANE_LOCAL:
+            if flags & FLAG_SILENCE:
+                ev["silence"] = gen | (audio << 16) | (gpio << 24)
+                tick += ev["silence"]
+            else:
+                tick += 1
+        elif lane == LANE_REMOTE:
+            ev["tick"] = resolve_tick(tick, gen | (audio << 16) | (gpio << 24))
+        events.append(ev)
+    return hdr, events
+
+
+def uptime_us(hdr: dict, tick: int) -> int:
+    return hdr["captured_us"] - (hdr["captured_tick"] - tick) * hdr["tick_us"]
+
+
+def net_us(hdr: dict, tick: int):
+    """CWNet synced time at which tick starts, None if the recording has no network clock"""
+    if hdr["net_first_us"] is None:
+        return None
+    local = (tick - hdr["first_tick"]) * hdr["tick_us"]
+    return hdr["net_first_us"] + local + int(local * hdr["net_drift_ppm"] / 1000000)
+
+
+def write_csv(hdr: dict, events: list, out) -> None:
+    out.write("idx,tick,uptime_us,net_us,lane,silence_ticks,dit,dah,key,audio,flags\n")
+    for ev in events:
+        silent = ev["silence"] != 0
+        net = net_us(hdr, ev["tick"])
+        out.write("{},{},{},{},{},{},{},{},{},{},0x{:02x}\n".format(
+            ev["idx"], ev["tick"], uptime_us(hdr, ev["tick"]), "" if net is None else net,
+            LANES[ev["lane"]],
+            ev["silence"],
+            "" if silent or ev["lane"] != LANE_LOCAL else ev["gpio"] & 1,
+            "" if silent or ev["lane"] != LANE_LOCAL else (ev["gpio"] >> 1) & 1,
+            "" if silent else ev["key"],
+            "" if silent or ev["lane"] == LANE_REMOTE else ev["audio"],
+            ev["flags"]))
+
+
+def write_vcd(hdr: dict, events: list, out) -> None:
+    signals = [("dit", "!"), ("dah", '"'), ("key", "#"), ("text_key", "$"), ("remote_key", "%")]
+    out.write("$comment RemoteCWKeyer .cwk export $end\n")
+    out.write("$timescale 1us $end\n")
+    out.write("$scope module keyer $end\n")
+    for name, ident in signals:
+        out.write(f"$var wire 1 {ident} {name} $end\n")
+    out.write("$upscope $end\n$enddefinitions $end\n")
+
+    # Levels before the first key event are assumed idle
+    level = {ident: 0 for _, ident in signals}
+    changes = []
+    for ev in events:
+        if ev["silence"]:
+            continue
+        if ev["lane"] == LANE_LOCAL:
+            new = {"!": ev["gpio"] & 1, '"': (ev["gpio"] >> 1) & 1, "#": ev["key"] & 1}
+        elif ev["lane"] == LANE_TEXT:
+            new = {"$": ev["key"] & 1}
+        elif ev["lane"] == LANE_REMOTE:
+            new = {"%": ev["key"] & 1}
+        else:
+            continue
+        for ident, value in new.items():
+            if level[ident] != value:
+                level[ident] = value
+                changes.append((ev["tick"], ident, value))
+
+    # REMOTE events play at their own tick, which may be ahead of the stream
+    changes.sort(key=lambda c: c[0])
+    base = hdr["first_tick"]
+    us = hdr["tick_us"]
+    out.write("#0\n$dumpvars\n")
+    for _, ident in signals:
+        out.write(f"0{ident}\n")
+    out.write("$end\n")
+    last = 0
+    for tick, ident, value in changes:
+        t = max(tick - base, 0) * us
+        if t != last:
+            out.write(f"#{t}\n")
+            last = t
+        out.write(f"{value}{ident}\n")
+    end = (hdr["captured_tick"] - base) * us
+    if end > last:
+        out.write(f"#{end}\n")
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("recording", help=".cwk file or console capture")
+    fmt = ap.add_mutually_exclusive_group(required=True)
+    fmt.add_argument("--csv", action="store_true", help="one row per sample")
+    fmt.add_argument("--vcd", action="store_true", help="value change dump (GTKWave, PulseView)")
+    args = ap.parse_args()
+
+    hdr, events = parse(load(args.recording))
+    if args.csv:
+        write_csv(hdr, events, sys.stdout)
+    else:
+        write_vcd(hdr, events, sys.stdout)
+    print(f"cwk_convert: {len(events)} samples, {hdr['captured_tick'] - hdr['first_tick']} ticks "
+          f"of {hdr['tick_us']}us", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
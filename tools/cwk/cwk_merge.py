@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""
+Line up two .cwk recordings on the CWNet network clock and measure the
+one-way keying latency between the stations.
+
+Both recordings must have been exported while the keyers were synced to
+the same CWNet server (header version 2, network clock set). Every LOCAL
+key edge of one station is paired with the first REMOTE key edge of the
+same level on the other that follows it: the difference in network time
+is what the link, the server and the playout buffer added.
+
+Usage:
+    cwk_merge.py iu3qez.cwk n0call.cwk
+    cwk_merge.py iu3qez.cwk n0call.cwk --csv > edges.csv
+"""
+
+import argparse
+import statistics
+import sys
+
+from cwk_convert import LANE_LOCAL, LANE_REMOTE, load, net_us, parse
+
+# A REMOTE edge this long after the LOCAL one is not its echo
+MAX_LATENCY_US = 5000000
+
+
+def key_edges(hdr: dict, events: list, lane: int) -> list:
+    """[(net_us, level)] for every key level change on a lane"""
+    edges = []
+    level = 0
+    for ev in events:
+        if ev["lane"] != lane or ev["silence"]:
+            continue
+        key = ev["key"] & 1
+        if key != level:
+            level = key
+            edges.append((net_us(hdr, ev["tick"]), key))
+    return sorted(edges)
+
+
+def pair(sent: list, heard: list) -> list:
+    """[(sent_us, latency_us, level)] matching edges in order"""
+    pairs = []
+    j = 0
+    for t, level in sent:
+        while j < len(heard) and (heard[j][0] < t or heard[j][1] != level):
+            j += 1
+        if j == len(heard):
+            break
+        if heard[j][0] - t <= MAX_LATENCY_US:
+            pairs.append((t, heard[j][0] - t, level))
+            j += 1
+    return pairs
+
+
+def summary(name: str, pairs: list) -> str:
+    if not pairs:
+        return f"{name}: no matching edges"
+    lat = [p[1] / 1000 for p in pairs]
+    return (f"{name}: {len(lat)} edges, latency ms min {min(lat):.1f} "
+            f"median {statistics.median(lat):.1f} max {max(lat):.1f}")
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("a", help="recording of station A")
+    ap.add_argument("b", help="recording of station B")
+    ap.add_argument("--csv", action="store_true", help="one row per matched edge")
+    args = ap.parse_args()
+
+    recs = []
+    for path in (args.a, args.b):
+        hdr, events = parse(load(path))
+        if hdr["net_first_us"] is None:
+            sys.exit(f"cwk_merge: {path}: no network clock (not synced to a CWNet server)")
+        recs.append((hdr, events))
+    (ha, ea), (hb, eb) = recs
+
+    a_to_b = pair(key_edges(ha, ea, LANE_LOCAL), key_edges(hb, eb, LANE_REMOTE))
+    b_to_a = pair(key_edges(hb, eb, LANE_LOCAL), key_edges(ha, ea, LANE_REMOTE))
+
+    if args.csv:
+        print("direction,net_us,level,latency_us")
+        for name, pairs in (("a_to_b", a_to_b), ("b_to_a", b_to_a)):
+            for t, lat, level in pairs:
+                print(f"{name},{t},{level},{lat}")
+
+    span = (max(net_us(ha, ha["captured_tick"]), net_us(hb, hb["captured_tick"])) -
+            min(ha["net_first_us"], hb["net_first_us"])) / 1e6
+    print(f"cwk_merge: {span:.1f}s of network time", file=sys.stderr)
+    print(summary("A -> B", a_to_b), file=sys.stderr)
+    print(summary("B -> A", b_to_a), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+Synthesize .cwk keying recordings of known text, for decoder accuracy runs.
+
+Each recording is a LOCAL-lane keying history like a real export, with a
+.txt sidecar holding the text that was sent. test_host/bench/cwk_accuracy.c
+decodes them (or real exports with a hand-written .txt) and reports the
+character error rate per timing classifier.
+
+Usage:
+    cwk_synth.py --corpus DIR          Write the standard corpus into DIR
+    cwk_synth.py OUT.cwk "TEXT" [--wpm 20] [--wpm-end 20] [--weight 0]
+                 [--ratio 3] [--char-gap 3] [--word-gap 7] [--jitter 0.05] [--seed 1]
+
+--weight is in dit units, added to every mark and taken from every space;
+--wpm-end ramps the speed linearly across the text. Timing is 1 tick = 1 ms.
+Prosigns are written as their text keyer tags (<AR>, <BT>, <SK>, ...); the
+.txt holds the character the decoder prints for each.
+"""
+
+import argparse
+import random
+import re
+import struct
+import sys
+from pathlib import Path
+
+import yaml
+
+HEADER = struct.Struct("<4sHHHHIIIQQQqiI")   # Version 2, no network clock
+SAMPLE = struct.Struct("<BBBBH")
+FLAG_SILENCE = 0x10
+FLAG_LOCAL_EDGE = 0x20
+TICK_US = 1000
+
+ALPHABET = Path(__file__).resolve().parents[2] / "components/keyer_decoder/morse_alphabet.yaml"
+
+QSO = ("CQ CQ DE IU3QEZ IU3QEZ K "
+       "IU3QEZ DE DL1ABC GM UR RST 599 NAME HANS QTH BERLIN HW? "
+       "R TNX FER CALL RIG IS HOMEBREW 5W ANT DIPOLE 73 SK")
+
+PROSIGN_QSO = ("CQ CQ DE IU3QEZ <KA> IU3QEZ DE DL1ABC <BT> UR RST 599 <BT> "
+               "QTH BERLIN <AR> IU3QEZ DE DL1ABC <KN> TNX QSO 73 <SK>")
+
+# name: (text, options)
+CORPUS = {
+    "steady_20wpm": (QSO, dict(wpm=20, jitter=0.05, seed=1)),
+    "speed_change": (QSO, dict(wpm=16, wpm_end=32, jitter=0.05, seed=2)),
+    "heavy_weight": (QSO, dict(wpm=22, weight=0.4, ratio=3.6, jitter=0.05, seed=3)),
+    "light_weight": (QSO, dict(wpm=25, weight=-0.25, jitter=0.05, seed=4)),
+    "human_fist": (QSO, dict(wpm=18, ratio=3.8, char_gap=4.5, word_gap=9, jitter=0.15, seed=5)),
+    "slow_12wpm": (QSO, dict(wpm=12, jitter=0.08, seed=6)),
+    "fast_35wpm": (QSO, dict(wpm=35, jitter=0.04, seed=7)),
+    "prosigns": (PROSIGN_QSO, dict(wpm=22, jitter=0.06, seed=8)),
+}
+
+
+def load_alphabet() -> dict:
+    """Symbol (character or prosign tag) -> (pattern, character the decoder prints)"""
+    data = yaml.safe_load(ALPHABET.read_text())
+    chars = {str(e["char"]): str(e["pattern"]) for e in data["characters"]}
+    printed = {pattern: char for char, pattern in chars.items()}
+    alphabet = {char: (pattern, char) for char, pattern in chars.items()}
+    for e in data.get("prosigns", []):
+        pattern = str(e["pattern"])
+        alphabet[str(e["tag"])] = (pattern, printed.get(pattern, str(e["tag"])))
+    return alphabet
+
+
+def symbols(word: str) -> list:
+    """Characters of a word, prosign tags kept whole"""
+    return re.findall(r"<[A-Z]+>|.", word)
+
+
+def key_runs(text: str, alphabet: dict, wpm: float, wpm_end: float = None, weight: float = 0.0,
+             ratio: float = 3.0, char_gap: float = 3.0, word_gap: float = 7.0,
+             jitter: float = 0.05, seed: int = 1):
+    """Yield (key_down, ticks) runs for text"""
+    rng = random.Random(seed)
+    wpm_end = wpm if wpm_end is None else wpm_end
+    words = [symbols(w) for w in text.upper().split()]
+    total = max(1, sum(len(w) for w in words) - 1)
+    sent = 0
+
+    def ticks(units: float, dit_ms: float) -> int:
+        return max(1, round(units * dit_ms * (1.0 + rng.uniform(-jitter, jitter))))
+
+    for wi, word in enumerate(words):
+        for ci, ch in enumerate(word):
+            dit_ms = 1200.0 / (wpm + (wpm_end - wpm) * sent / total)
+            sent += 1
+            pattern = alphabet[ch][0]
+            for ei, element in enumerate(pattern):
+                yield True, ticks((ratio if element == "-" else 1.0) + weight, dit_ms)
+                if ei + 1 < len(pattern):
+                    yield False, ticks(1.0 - weight, dit_ms)
+            if ci + 1 < len(word):
+                yield False, ticks(char_gap - weight, dit_ms)
+        if wi + 1 < len(words):
+            yield False, ticks(word_gap - weight, dit_ms)
+
+
+def silence(ticks: int) -> bytes:
+    return SAMPLE.pack((ticks >> 24) & 0xFF, 0, (ticks >> 16) & 0xFF, FLAG_SILENCE, ticks & 0xFFFF)
+
+
+def encode(runs) -> bytes:
+    """LOCAL samples as the producer writes them: edge sample, then silence"""
+    body = bytearray(silence(500))
+    tick = 500
+    for down, n in runs:
+        body += SAMPLE.pack(0, 1 if down else 0, 0, FLAG_LOCAL_EDGE, 0)
+        if n > 1:
+            body += silence(n - 1)
+        tick += n
+    body += SAMPLE.pack(0, 0, 0, FLAG_LOCAL_EDGE, 0)
+    body += silence(2999)
+    tick += 3000
+
+    count = len(body) // SAMPLE.size
+    header = HEADER.pack(b"CWK1", 2, HEADER.size, SAMPLE.size, 0, TICK_US, count,
+                         0, 0, tick, tick * TICK_US, 0, 0, 0)
+    return header + bytes(body)
+
+
+def write(path: Path, text: str, alphabet: dict, **opts) -> None:
+    path.write_bytes(encode(key_runs(text, alphabet, **opts)))
+    words = ("".join(alphabet[ch][1] for ch in symbols(w)) for w in text.upper().split())
+    path.with_suffix(".txt").write_text(" ".join(words) + "\n")
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--corpus", metavar="DIR", help="write the standard corpus into DIR")
+    ap.add_argument("out", nargs="?")
+    ap.add_argument("text", nargs="?")
+    ap.add_argument("--wpm", type=float, default=20.0)
+    ap.add_argument("--wpm-end", type=float)
+    ap.add_argument("--weight", type=float, default=0.0)
+    ap.add_argument("--ratio", type=float, default=3.0)
+    ap.add_argument("--char-gap", type=float, default=3.0)
+    ap.add_argument("--word-gap", type=float, default=7.0)
+    ap.add_argument("--jitter", type=float, default=0.05)
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    alphabet = load_alphabet()
+    if args.corpus:
+        out = Path(args.corpus)
+        out.mkdir(parents=True, exist_ok=True)
+        for name, (text, opts) in CORPUS.items():
+            write(out / f"{name}.cwk", text, alphabet, **opts)
+        return 0
+
+    if not args.out or not args.text:
+        ap.error("give OUT.cwk and TEXT, or --corpus DIR")
+    write(Path(args.out), args.text, alphabet, wpm=args.wpm, wpm_end=args.wpm_end,
+          weight=args.weight, ratio=args.ratio, char_gap=args.char_gap,
+          word_gap=args.word_gap, jitter=args.jitter, seed=args.seed)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""
+Decode the keyer's binary USB log (usb.usb_log_binary) into text lines.
+
+The device sends format IDs, tag IDs and raw printf arguments instead of
+formatted text; this expands them the way log_format() would.
+
+Usage:
+    logdec.py /dev/ttyACM1                 # live (needs pyserial)
+    logdec.py capture.bin                  # raw capture of the port
+    cat /dev/ttyACM1 | logdec.py -         # stdin
+    logdec.py --udp 5140                   # syslog datagrams (system.syslog_format BINARY)
+
+Frame layout, see components/keyer_logging/include/log_wire.h:
+    0xA5 | type | len | payload[len] | sum (type + len + payload, mod 256)
+Tag IDs index LOG_TAGS in components/keyer_console/include/log_tags.h,
+which scripts/gen_log_tags.py generates at configure time.
+"""
+
+import argparse
+import os
+import re
+import socket
+import struct
+import sys
+from pathlib import Path
+
+SYNC = 0xA5
+HELLO, FMT, RECORD, DROPPED = 0x00, 0x01, 0x02, 0x03
+TEXT_ID = 0xFFFF
+
+LEVELS = ["ERROR", "WARN", "INFO", "DEBUG", "TRACE"]
+
+ROOT = Path(__file__).resolve().parent.parent.parent
+DEFAULT_TAGS = ROOT / "components" / "keyer_console" / "include" / "log_tags.h"
+
+# Same conversions as log_format(): flags - 0, width, precision, hh h l ll z
+SPEC = re.compile(r"%([-0]*)(\d*)(?:\.(\d*))?(hh|h|ll|l|z)?(.)", re.S)
+
+
+def load_tags(path: Path) -> list:
+    """LOG_TAGS entries in order (tag ID = index)"""
+    text = path.read_text()
+    body = text[text.index("LOG_TAGS[]"):]
+    body = body[body.index("{") + 1:body.index("};")]
+    return re.findall(r'"([^"]*)"', body)
+
+
+class Session:
+    """Decoder state for one HELLO ... session"""
+
+    def __init__(self):
+        # ESP32 widths until a HELLO says otherwise
+        self.sizes = {"int": 4, "long": 4, "llong": 8, "size": 4, "ptr": 4}
+        self.fmts = {}
+
+    def hello(self, payload: bytes):
+        if len(payload) >= 6:
+            _, i, l, ll, z, p = payload[:6]
+            self.sizes = {"int": i, "long": l, "llong": ll, "size": z, "ptr": p}
+        self.fmts = {}
+
+    def take(self, args: bytes, pos: int, n: int, signed: bool):
+        """Integer of n bytes at pos; past the end reads as 0 (as the device)"""
+        if pos + n > len(args):
+            return 0, len(args)
+        return int.from_bytes(args[pos:pos + n], "little", signed=signed), pos + n
+
+    def expand(self, fmt: str, args: bytes) -> str:
+        out = []
+        pos = 0
+        last = 0
+        for m in SPEC.finditer(fmt):
+            out.append(fmt[last:m.start()])
+            last = m.end()
+            flags, width, prec, length, conv = m.groups()
+            spec = "%" + flags + width + ("." + prec if prec is not None else "")
+
+            if conv == "%":
+                out.append("%")
+            elif conv in "diuxXc":
+                kind = {"l": "long", "ll": "llong", "z": "size"}.get(length, "int")
+                signed = conv in "dic"
+                v, pos = self.take(args, pos, self.sizes[kind], signed)
+                if length == "h":
+                    v = (v & 0xFFFF) if not signed else ((v + 0x8000) & 0xFFFF) - 0x8000
+                elif length == "hh":
+                    v = (v & 0xFF) if not signed else ((v + 0x80) & 0xFF) - 0x80
+                if conv == "c":
+                    out.append((spec + "c") % chr(v & 0xFF))
+                else:
+                    out.append((spec + ("d" if conv == "u" else conv)) % v)
+            elif conv == "p":
+                v, pos = self.take(args, pos, self.sizes["ptr"], False)
+                out.append("0x%x" % v)
+            elif conv == "s":
+                end = args.find(b"\0", pos)
+                end = len(args) if end < 0 else end
+                s = args[pos:end].decode("utf-8", "replace")
+                pos = min(end + 1, len(args))
+                out.append((spec + "s") % s)
+            else:
+                out.append(m.group(0))
+        out.append(fmt[last:])
+        return "".join(out)
+
+
+def tag_name(tags: list, tag: int) -> str:
+    return tags[tag] if tag < len(tags) else "#%d" % tag
+
+
+def frames(stream):
+    """Yield (type, payload) from a byte stream, resyncing on bad frames"""
+    buf = bytearray()
+    live = hasattr(stream, "in_waiting")
+    while True:
+        chunk = stream.read(max(1, stream.in_waiting)) if live else stream.read(4096)
+        if not chunk:
+            if live:
+                continue  # Read timeout
+            return
+        buf += chunk
+        while True:
+            start = buf.find(SYNC)
+            if start < 0:
+                buf.clear()
+                break
+            del buf[:start]
+            if len(buf) < 4:
+                break
+            ftype, n = buf[1], buf[2]
+            if len(buf) < 4 + n:
+                break
+            if (ftype + n + sum(buf[3:3 + n])) & 0xFF != buf[3 + n] or ftype > DROPPED:
+                del buf[:1]  # Not a frame start: keep looking
+                continue
+            payload = bytes(buf[3:3 + n])
+            del buf[:4 + n]
+            yield ftype, payload
+
+
+class UdpInput:
+    """One read per datagram: each starts with HELLO, so each decodes alone"""
+
+    def __init__(self, port: int):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(("", port))
+
+    def read(self, _n: int) -> bytes:
+        while True:
+            data = self.sock.recv(65535)
+            if data:
+                return data
+
+
+def open_input(path: str):
+    if path == "-":
+        return sys.stdin.buffer
+    if os.path.exists(path) and not os.path.isfile(path):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("logdec: reading a serial port needs pyserial (pip install pyserial)")
+        # Opening raises DTR: the keyer starts a session (HELLO + formats)
+        return serial.Serial(path, timeout=0.1)
+    return open(path, "rb")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("input", nargs="?", help="serial port, capture file or - for stdin")
+    ap.add_argument("--udp", type=int, metavar="PORT",
+                    help="receive syslog datagrams on PORT instead")
+    ap.add_argument("--tags", type=Path, default=DEFAULT_TAGS,
+                    help="generated log_tags.h (default: %(default)s)")
+    args = ap.parse_args()
+    if (args.input is None) == (args.udp is None):
+        ap.error("give an input or --udp PORT")
+
+    tags = load_tags(args.tags) if args.tags.exists() else []
+    if not tags:
+        print("logdec: %s not found, tags shown as IDs" % args.tags, file=sys.stderr)
+
+    session = Session()
+    src = UdpInput(args.udp) if args.udp is not None else open_input(args.input)
+    try:
+        for ftype, payload in frames(src):
+            if ftype == HELLO:
+                session.hello(payload)
+            elif ftype == FMT and len(payload) >= 2:
+                fid = struct.unpack_from("<H", payload)[0]
+                session.fmts[fid] = payload[2:].decode("utf-8", "replace")
+            elif ftype == RECORD and len(payload) >= 12:
+                ts, level, tag, fid = struct.unpack_from("<qBBH", payload)
+                raw = payload[12:]
+                if fid == TEXT_ID:
+                    msg = raw.decode("utf-8", "replace")
+                elif fid in session.fmts:
+                    msg = session.expand(session.fmts[fid], raw)
+                else:
+                    msg = "<format %d not defined: started mid-session?> %s" % (fid, raw.hex())
+                lvl = LEVELS[level] if level < len(LEVELS) else "?"
+                print("[%d] %s %s: %s" % (ts, lvl, tag_name(tags, tag), msg), flush=True)
+            elif ftype == DROPPED and len(payload) >= 5:
+                tag, count = struct.unpack_from("<BI", payload)
+                print("-- %s: %d entries dropped --" % (tag_name(tags, tag), count), flush=True)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+Build a delta OTA patch between two firmware images, or apply one.
+
+The patch rebuilds NEW from OLD, the image the device is running, and is
+uploaded to POST /api/ota/delta instead of the full image. Format: see
+components/keyer_core/include/ota_delta.h.
+
+Usage:
+    mkdelta.py old.bin new.bin patch.kdl      # build (checks it by applying)
+    mkdelta.py --apply old.bin patch.kdl out.bin
+
+Upload (the device must be running old.bin):
+    curl --data-binary @patch.kdl -H "X-OTA-SHA256: $(sha256sum new.bin | cut -c1-64)" \\
+         http://keyer.local/api/ota/delta
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import zlib
+from pathlib import Path
+
+MAGIC = 0x314C444B  # "KDL1"
+VERSION = 1
+HEADER = struct.Struct('<IHHII32s32s')
+
+OP_END, OP_COPY, OP_ADD, OP_INSERT = 0, 1, 2, 3
+
+KEY = 16          # Bytes hashed to find a match
+STRIDE = 4        # Old image positions indexed (every STRIDE-th)
+MIN_COPY = 24     # Shorter exact matches are left to the gap encoder
+ADD_MIN_EQUAL = 0.5  # Gap bytes equal to the aligned old bytes for ADD to win
+
+
+def build_index(old: bytes) -> dict:
+    index = {}
+    for i in range(0, len(old) - KEY + 1, STRIDE):
+        index.setdefault(old[i:i + KEY], i)
+    return index
+
+
+def encode_gap(ops: bytearray, old: bytes, new: bytes, start: int, end: int, align):
+    """Bytes between two copies: ADD against the last alignment, else INSERT."""
+    if end <= start:
+        return
+    n = end - start
+    if align is not None and 0 <= start + align and start + align + n <= len(old):
+        base = start + align
+        equal = sum(1 for k in range(n) if old[base + k] == new[start + k])
+        if equal >= n * ADD_MIN_EQUAL:
+            ops += struct.pack('<BII', OP_ADD, base, n)
+            ops += bytes((new[start + k] - old[base + k]) & 0xFF for k in range(n))
+            return
+    ops += struct.pack('<BI', OP_INSERT, n)
+    ops += new[start:end]
+
+
+def diff(old: bytes, new: bytes) -> bytes:
+    index = build_index(old)
+    ops = bytearray()
+    j = 0            # Scan position in new
+    gap = 0          # First new byte not yet encoded
+    align = None     # old offset - new offset of the last copy
+    stats = {'copy': 0, 'add': 0, 'insert': 0}
+
+    while j + KEY <= len(new):
+        i = index.get(new[j:j + KEY])
+        if i is None:
+            j += 1
+            continue
+        # Extend backwards into the gap (the index only holds every STRIDE-th offset)
+        back = 0
+        while back < j - gap and i - back > 0 and old[i - back - 1] == new[j - back - 1]:
+            back += 1
+        start_new, start_old = j - back, i - back
+        length = back + KEY
+        while (start_new + length < len(new) and start_old + length < len(old) and
+               new[start_new + length] == old[start_old + length]):
+            length += 1
+        if length < MIN_COPY:
+            j += 1
+            continue
+        encode_gap(ops, old, new, gap, start_new, align)
+        ops += struct.pack('<BII', OP_COPY, start_old, length)
+        stats['copy'] += length
+        align = start_old - start_new
+        j = gap = start_new + length
+
+    encode_gap(ops, old, new, gap, len(new), align)
+    ops.append(OP_END)
+    return bytes(ops)
+
+
+def build(old: bytes, new: bytes) -> bytes:
+    header = HEADER.pack(MAGIC, VERSION, 0, len(old), len(new),
+                         hashlib.sha256(old).digest(), hashlib.sha256(new).digest())
+    return header + zlib.compress(diff(old, new), 9)
+
+
+def apply(old: bytes, patch: bytes) -> bytes:
+    """Reference applier, same checks as ota_delta.c."""
+    magic, version, _, old_size, new_size, old_sha, new_sha = HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('not a delta patch')
+    if len(old) < old_size or hashlib.sha256(old[:old_size]).digest() != old_sha:
+        raise ValueError('patch is for a different base image')
+    ops = zlib.decompress(patch[HEADER.size:])
+    out = bytearray()
+    p = 0
+    while True:
+        op = ops[p]
+        p += 1
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            off, n = struct.unpack_from('<II', ops, p)
+            p += 8
+            out += old[off:off + n]
+        elif op == OP_ADD:
+            off, n = struct.unpack_from('<II', ops, p)
+            p += 8
+            out += bytes((old[off + k] + ops[p + k]) & 0xFF for k in range(n))
+            p += n
+        elif op == OP_INSERT:
+            (n,) = struct.unpack_from('<I', ops, p)
+            p += 4
+            out += ops[p:p + n]
+            p += n
+        else:
+            raise ValueError('bad op %d' % op)
+    if len(out) != new_size or hashlib.sha256(out).digest() != new_sha:
+        raise ValueError('patch produced a different image')
+    return bytes(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    ap.add_argument('--apply', action='store_true', help='apply PATCH to OLD, write OUT')
+    ap.add_argument('old', type=Path)
+    ap.add_argument('new_or_patch', type=Path)
+    ap.add_argument('out', type=Path)
+    args = ap.parse_args()
+
+    old = args.old.read_bytes()
+    if args.apply:
+        try:
+            args.out.write_bytes(apply(old, args.new_or_patch.read_bytes()))
+        except ValueError as e:
+            print('ERROR: %s' % e, file=sys.stderr)
+            sys.exit(1)
+        return
+
+    new = args.new_or_patch.read_bytes()
+    patch = build(old, new)
+    if apply(old, patch) != new:
+        print('ERROR: patch does not reproduce the new image', file=sys.stderr)
+        sys.exit(1)
+    args.out.write_bytes(patch)
+    full_gz = len(zlib.compress(new, 9))
+    print('%s: %d bytes (new image %d, gzipped %d: %.1f%% of full upload)' %
+          (args.out, len(patch), len(new), full_gz, 100.0 * len(patch) / len(new)))
+
+
+if __name__ == '__main__':
+    main()